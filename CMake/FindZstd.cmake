@@ -0,0 +1,26 @@
+# - Find Zstandard
+# Find the Zstandard compression library (libzstd).
+#
+# This module sets the following variables:
+#  ZSTD_FOUND - set to true if the library is found
+#  ZSTD_INCLUDE_DIRS - list of required include directories
+#  ZSTD_LIBRARIES - list of libraries to be linked
+
+find_path(ZSTD_INCLUDE_DIR
+  NAMES zstd.h
+)
+
+find_library(ZSTD_LIBRARY
+  NAMES zstd libzstd
+)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Zstd DEFAULT_MSG ZSTD_LIBRARY
+    ZSTD_INCLUDE_DIR)
+
+if (ZSTD_FOUND)
+  set(ZSTD_INCLUDE_DIRS ${ZSTD_INCLUDE_DIR})
+  set(ZSTD_LIBRARIES ${ZSTD_LIBRARY})
+endif (ZSTD_FOUND)
+
+mark_as_advanced(ZSTD_INCLUDE_DIR ZSTD_LIBRARY)
@@ -35,6 +35,35 @@ otherwise a std::runtime_error exception will be thrown.
 
 A "total_time" timer is run by default for each MLPACK program.
 
+A timer can also be run for a scope, with the mlpack::ScopedTimer class; the
+timer is stopped when the object is destroyed:
+
+@code
+{
+  ScopedTimer t("tree_building");
+  // Build the tree...
+}
+@endcode
+
+Timers are thread-safe.  Each thread keeps its own running timers, so the same
+timer may be run by several threads at once (inside a parallel loop, for
+instance), and its value is then the total over all of the threads.
+
+A timer that is started while another timer is running is nested inside it.
+When the --timers_file option is given, every program writes its timers to
+that file as JSON.  The file holds two things:
+
+ - the tree of nested timers, with the total time, the number of runs and the
+   number of threads of each one;
+ - every run of every timer, in the Chrome trace event format.
+
+So, the file can be opened with chrome://tracing or Perfetto, to see the runs of
+the timers of each thread over time:
+
+@code
+$ allknn -r dataset.csv -n neighbors_out.csv -k 5 --timers_file timers.json
+@endcode
+
 @section example Timer Example
 
 Below is a very simple example of timer usage in code.
@@ -887,14 +887,15 @@ TreeType policy API:
  - mlpack::tree::MeanSplitKDTree
  - mlpack::tree::BallTree
  - mlpack::tree::MeanSplitBallTree
+ - mlpack::tree::VPTree
  - mlpack::tree::RTree
  - mlpack::tree::RStarTree
  - mlpack::tree::StandardCoverTree
 
 Often, these are template typedefs of more flexible tree classes:
 
- - mlpack::tree::BinarySpaceTree -- binary trees, such as the KD-tree and ball
-   tree
+ - mlpack::tree::BinarySpaceTree -- binary trees, such as the KD-tree, ball
+   tree, and vantage-point tree
  - mlpack::tree::RectangleTree -- the R tree and variants
  - mlpack::tree::CoverTree -- the cover tree and variants
 
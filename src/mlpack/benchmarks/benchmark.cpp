@@ -0,0 +1,276 @@
+/**
+ * @file benchmark.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the benchmark State, the registry of benchmarks, and
+ * RunBenchmarks().
+ */
+#include "benchmark.hpp"
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric_simd.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
+#include <algorithm>
+#include <ctime>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+using namespace mlpack;
+using namespace mlpack::benchmark;
+
+State::State(const std::vector<size_t>& args,
+             const double minTime,
+             const size_t maxIterations) :
+    args(args),
+    minTime(minTime),
+    maxIterations(maxIterations),
+    iterations(0),
+    started(false),
+    running(false),
+    elapsed(Clock::duration::zero())
+{
+  // Nothing to do.
+}
+
+bool State::KeepRunning()
+{
+  if (!started)
+  {
+    started = true;
+    ResumeTiming();
+    return true;
+  }
+
+  ++iterations;
+  if (iterations >= maxIterations || Seconds() >= minTime)
+  {
+    PauseTiming();
+    return false;
+  }
+
+  return true;
+}
+
+void State::PauseTiming()
+{
+  if (running)
+  {
+    elapsed += Clock::now() - start;
+    running = false;
+  }
+}
+
+void State::ResumeTiming()
+{
+  if (!running)
+  {
+    start = Clock::now();
+    running = true;
+  }
+}
+
+size_t State::Arg(const size_t i) const
+{
+  if (i >= args.size())
+  {
+    std::ostringstream oss;
+    oss << "State::Arg(): benchmark has " << args.size() << " arguments, but "
+        << "argument " << i << " was requested";
+    throw std::invalid_argument(oss.str());
+  }
+
+  return args[i];
+}
+
+double State::Seconds() const
+{
+  Clock::duration total = elapsed;
+  if (running)
+    total += Clock::now() - start;
+
+  return std::chrono::duration<double>(total).count();
+}
+
+Benchmark::Benchmark(const std::string& name, BenchmarkFunction function) :
+    name(name),
+    function(function)
+{
+  // Nothing to do.
+}
+
+Benchmark* Benchmark::Args(const std::vector<size_t>& args)
+{
+  argLists.push_back(args);
+  return this;
+}
+
+std::string Benchmark::RunName(const std::vector<size_t>& args) const
+{
+  std::ostringstream oss;
+  oss << name;
+  for (size_t i = 0; i < args.size(); ++i)
+    oss << "/" << args[i];
+
+  return oss.str();
+}
+
+namespace {
+
+//! The registered benchmarks.  This is a function-static object, because
+//! benchmarks are registered during static initialization.
+std::vector<std::unique_ptr<Benchmark>>& Registry()
+{
+  static std::vector<std::unique_ptr<Benchmark>> registry;
+  return registry;
+}
+
+//! Write a string as a JSON string.
+void StringToJSON(std::ostream& stream, const std::string& str)
+{
+  stream << '"';
+  for (size_t i = 0; i < str.size(); ++i)
+  {
+    if (str[i] == '"' || str[i] == '\\')
+      stream << '\\' << str[i];
+    else if ((unsigned char) str[i] < 0x20)
+      stream << ' ';
+    else
+      stream << str[i];
+  }
+  stream << '"';
+}
+
+//! Write the given counter to the JSON results.
+void CounterToJSON(std::ostream& stream,
+                   const std::string& name,
+                   const double value)
+{
+  stream << ",\n      \"" << name << "\": " << value;
+}
+
+} // anonymous namespace
+
+Benchmark* mlpack::benchmark::Register(const std::string& name,
+                                       BenchmarkFunction function)
+{
+  Registry().push_back(std::unique_ptr<Benchmark>(
+      new Benchmark(name, function)));
+  return Registry().back().get();
+}
+
+std::vector<Benchmark*> mlpack::benchmark::Benchmarks()
+{
+  std::vector<Benchmark*> benchmarks;
+  for (size_t i = 0; i < Registry().size(); ++i)
+    benchmarks.push_back(Registry()[i].get());
+
+  // The order of static initialization across files isn't defined, so sort
+  // the benchmarks to get the same order every time.
+  std::stable_sort(benchmarks.begin(), benchmarks.end(),
+      [](const Benchmark* a, const Benchmark* b)
+      { return a->Name() < b->Name(); });
+
+  return benchmarks;
+}
+
+size_t mlpack::benchmark::RunBenchmarks(const std::string& filter,
+                                        const double minTime,
+                                        const size_t maxIterations,
+                                        std::ostream& stream)
+{
+  const std::time_t now = std::time(NULL);
+  char date[32];
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+  // Large counters should not be rounded.
+  const std::streamsize precision = stream.precision(15);
+
+  stream << "{\n  \"context\": {\n    \"date\": \"" << date << "\",\n"
+      << "    \"mlpack_version\": \"" << util::GetVersion() << "\",\n"
+      << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+      << "    \"min_time\": " << minTime << ",\n"
+      << "    \"lmetric_simd\": \"" << metric::simd::InstructionSet() << "\",\n"
+#ifdef MLPACK_TRAVERSAL_STATISTICS
+      << "    \"traversal_statistics\": true\n"
+#else
+      << "    \"traversal_statistics\": false\n"
+#endif
+      << "  },\n  \"benchmarks\": [";
+
+  size_t runs = 0;
+  const std::vector<Benchmark*> benchmarks = Benchmarks();
+  for (size_t b = 0; b < benchmarks.size(); ++b)
+  {
+    const Benchmark& benchmark = *benchmarks[b];
+    for (size_t a = 0; a < benchmark.ArgLists().size(); ++a)
+    {
+      const std::vector<size_t>& args = benchmark.ArgLists()[a];
+      const std::string name = benchmark.RunName(args);
+      if (name.find(filter) == std::string::npos)
+        continue;
+
+      // Run every benchmark with the same random seed, so that the datasets
+      // (and so the counters) are the same every time.
+      math::RandomSeed(42);
+#ifdef MLPACK_TRAVERSAL_STATISTICS
+      tree::TraversalStatistics::Global().Reset();
+#endif
+
+      State state(args, minTime, maxIterations);
+      std::string error;
+      try
+      {
+        benchmark.Function()(state);
+      }
+      catch (std::exception& e)
+      {
+        error = e.what();
+        Log::Warn << name << " failed: " << error << std::endl;
+      }
+
+      const size_t iterations = std::max(state.Iterations(), (size_t) 1);
+      const double nanoseconds = 1e9 * state.Seconds() / iterations;
+
+      stream << ((runs == 0) ? "\n" : ",\n") << "    {\n      \"name\": \""
+          << name << "\",\n      \"iterations\": " << state.Iterations()
+          << ",\n      \"real_time\": " << nanoseconds
+          << ",\n      \"time_unit\": \"ns\"";
+      if (!error.empty())
+      {
+        stream << ",\n      \"error_message\": ";
+        StringToJSON(stream, error);
+      }
+
+      std::map<std::string, double>::const_iterator it;
+      for (it = state.Counters().begin(); it != state.Counters().end(); ++it)
+        CounterToJSON(stream, it->first, it->second);
+
+#ifdef MLPACK_TRAVERSAL_STATISTICS
+      const tree::TraversalStatistics::Counters& total =
+          tree::TraversalStatistics::Global().Total();
+      CounterToJSON(stream, "traversal_scores",
+          (double) total.scores / iterations);
+      CounterToJSON(stream, "traversal_prunes",
+          (double) total.prunes / iterations);
+      CounterToJSON(stream, "traversal_rescores",
+          (double) total.rescores / iterations);
+      CounterToJSON(stream, "traversal_base_cases",
+          (double) total.baseCases / iterations);
+#endif
+
+      stream << "\n    }";
+      ++runs;
+
+      if (error.empty())
+        Log::Info << name << ": " << (nanoseconds / 1e6) << "ms per iteration ("
+            << state.Iterations() << " iterations)." << std::endl;
+    }
+  }
+
+  stream << ((runs == 0) ? "]\n}\n" : "\n  ]\n}\n");
+  stream.precision(precision);
+  return runs;
+}
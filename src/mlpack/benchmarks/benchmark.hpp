@@ -0,0 +1,185 @@
+/**
+ * @file benchmark.hpp
+ * @author Ryan Curtin
+ *
+ * A small framework for the microbenchmarks of mlpack_benchmark, in the style
+ * of Google Benchmark: each benchmark is a function that runs its workload in a
+ * State::KeepRunning() loop, registered with a name and any number of argument
+ * lists (such as the number of points and the dimensionality).
+ */
+#ifndef __MLPACK_BENCHMARKS_BENCHMARK_HPP
+#define __MLPACK_BENCHMARKS_BENCHMARK_HPP
+
+#include <chrono>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace mlpack {
+namespace benchmark {
+
+/**
+ * The State of a benchmark run holds the arguments of the run, decides how
+ * many iterations to time, and holds the counters (such as the number of base
+ * cases) that the benchmark reports.  A benchmark looks like this:
+ *
+ * @code
+ * void KNNBenchmark(State& state)
+ * {
+ *   arma::mat dataset = RandomDataset(state.Arg(1), state.Arg(0));
+ *   while (state.KeepRunning())
+ *   {
+ *     NeighborSearch<> knn(dataset);
+ *     knn.Search(5, neighbors, distances);
+ *     state.Counter("base_cases", knn.BaseCases());
+ *   }
+ * }
+ * @endcode
+ *
+ * Everything outside the loop (or between PauseTiming() and ResumeTiming()) is
+ * not timed.  Counters should hold the value for one iteration.
+ */
+class State
+{
+ public:
+  /**
+   * Create the state for one run of a benchmark.
+   *
+   * @param args Arguments of the run.
+   * @param minTime Iterations are run until they have taken at least this many
+   *      seconds...
+   * @param maxIterations ...or until this many iterations have been run.
+   */
+  State(const std::vector<size_t>& args,
+        const double minTime,
+        const size_t maxIterations);
+
+  /**
+   * Return true if another iteration should be run.  The timing starts with the
+   * first call and stops when false is returned.
+   */
+  bool KeepRunning();
+
+  //! Stop timing (for setup inside the loop that should not be timed).
+  void PauseTiming();
+  //! Start timing again.
+  void ResumeTiming();
+
+  //! Get the i'th argument of the run.
+  size_t Arg(const size_t i) const;
+  //! Get the arguments of the run.
+  const std::vector<size_t>& Args() const { return args; }
+
+  //! Set the value of the given counter (for one iteration).
+  void Counter(const std::string& name, const double value)
+  { counters[name] = value; }
+  //! Get the counters.
+  const std::map<std::string, double>& Counters() const { return counters; }
+
+  //! Get the number of iterations that have been timed.
+  size_t Iterations() const { return iterations; }
+  //! Get the total time of the timed iterations, in seconds.
+  double Seconds() const;
+
+ private:
+  typedef std::chrono::steady_clock Clock;
+
+  //! The arguments of the run.
+  std::vector<size_t> args;
+  //! The minimum time to run iterations for.
+  double minTime;
+  //! The maximum number of iterations.
+  size_t maxIterations;
+  //! The number of finished iterations.
+  size_t iterations;
+  //! Whether KeepRunning() has been called yet.
+  bool started;
+  //! Whether the timer is running.
+  bool running;
+  //! The time when the timer was last started.
+  Clock::time_point start;
+  //! The time accumulated while the timer was running.
+  Clock::duration elapsed;
+  //! The counters.
+  std::map<std::string, double> counters;
+};
+
+//! The type of a benchmark function.
+typedef void (*BenchmarkFunction)(State& state);
+
+/**
+ * A registered benchmark: its name, its function, and the argument lists to run
+ * it with.  The name of each run is the name of the benchmark followed by its
+ * arguments, such as "knn/kd/dual/10000/10".
+ */
+class Benchmark
+{
+ public:
+  //! Create the benchmark (use Register() instead).
+  Benchmark(const std::string& name, BenchmarkFunction function);
+
+  //! Add a list of arguments to run the benchmark with; returns this, so that
+  //! calls can be chained.
+  Benchmark* Args(const std::vector<size_t>& args);
+
+  //! Get the name of the benchmark.
+  const std::string& Name() const { return name; }
+  //! Get the function of the benchmark.
+  BenchmarkFunction Function() const { return function; }
+  //! Get the argument lists of the benchmark.
+  const std::vector<std::vector<size_t>>& ArgLists() const { return argLists; }
+
+  //! Get the name of a run of the benchmark with the given arguments.
+  std::string RunName(const std::vector<size_t>& args) const;
+
+ private:
+  //! The name of the benchmark.
+  std::string name;
+  //! The benchmark function.
+  BenchmarkFunction function;
+  //! The argument lists.
+  std::vector<std::vector<size_t>> argLists;
+};
+
+/**
+ * Register a benchmark; this is meant to be called when a static variable is
+ * initialized, so that each benchmark file only has to be linked in:
+ *
+ * @code
+ * static Benchmark* knn = Register("knn/kd/dual", KNNBenchmark)->
+ *     Args({ 10000, 10 })->Args({ 100000, 3 });
+ * @endcode
+ *
+ * The returned object is owned by the registry.
+ */
+Benchmark* Register(const std::string& name, BenchmarkFunction function);
+
+//! Get all of the registered benchmarks, sorted by name.
+std::vector<Benchmark*> Benchmarks();
+
+/**
+ * Run every benchmark run whose name contains the given filter, printing its
+ * results to the log as it finishes, and write the results of all of the runs
+ * as a JSON object to the given stream.
+ *
+ * If mlpack was built with TRAVERSAL_STATISTICS, the scores, prunes, rescores,
+ * and base cases of every tree traversal during a run are added as counters
+ * (named "traversal_*", per iteration).
+ *
+ * @param filter Only runs whose names contain this are run (all runs, if it is
+ *      empty).
+ * @param minTime Minimum time to run each benchmark for, in seconds.
+ * @param maxIterations Maximum number of iterations for each benchmark.
+ * @param stream Stream to write the JSON results to.
+ * @return The number of runs.
+ */
+size_t RunBenchmarks(const std::string& filter,
+                     const double minTime,
+                     const size_t maxIterations,
+                     std::ostream& stream);
+
+} // namespace benchmark
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,102 @@
+/**
+ * @file benchmark_main.cpp
+ * @author Ryan Curtin
+ *
+ * The mlpack_benchmark program, which runs the registered microbenchmarks and
+ * writes their times and counters as JSON.
+ */
+#include <mlpack/core.hpp>
+
+#include <fstream>
+#include <iostream>
+
+#include "benchmark.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::benchmark;
+
+PROGRAM_INFO("mlpack Benchmarks",
+    "This program runs microbenchmarks of mlpack: tree building, the tree "
+    "traversals of k-nearest-neighbor search, range search, and FastMKS, the "
+    "Lloyd iterations of k-means, the EM step of GMMs, building and querying "
+    "LSH models, steps of the SGD and L-BFGS optimizers, and data::Load().  "
+    "Each benchmark is run with a few sets of arguments (such as the number "
+    "of points and the dimensionality), and each run has a name like "
+    "'knn/kd/dual/10000/3'; the benchmarks are all run on random data with the "
+    "same seed."
+    "\n\n"
+    "Each run is repeated until it has taken at least --min_time seconds (or "
+    "--max_iterations iterations have been run).  The results are written as "
+    "JSON (in the style of Google Benchmark) to --output_file, or to standard "
+    "output if it isn't given: for each run, the number of iterations, the "
+    "time of each iteration in nanoseconds, and counters such as the number of "
+    "base cases.  If mlpack was built with -DTRAVERSAL_STATISTICS=ON, the "
+    "scores, prunes, rescores, and base cases of all tree traversals are also "
+    "given for each run."
+    "\n\n"
+    "For example, the following runs only the k-nearest-neighbor benchmarks, "
+    "printing the time of each run as it finishes:"
+    "\n\n"
+    "$ mlpack_benchmark --filter knn/ --output_file knn.json -v");
+
+PARAM_STRING("filter", "Only run the benchmarks whose names contain this "
+    "string.", "f", "");
+PARAM_STRING("output_file", "File to write the JSON results to (standard "
+    "output if not given).", "o", "");
+PARAM_DOUBLE("min_time", "Minimum time to repeat each benchmark for (in "
+    "seconds).", "t", 0.5);
+PARAM_INT("max_iterations", "Maximum number of iterations of each benchmark.",
+    "n", 1000000);
+PARAM_FLAG("list", "List the names of the benchmark runs and exit.", "l");
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  const string filter = CLI::GetParam<string>("filter");
+  const double minTime = CLI::GetParam<double>("min_time");
+  const int maxIterations = CLI::GetParam<int>("max_iterations");
+
+  if (minTime < 0.0)
+    Log::Fatal << "--min_time (-t) must be nonnegative!" << endl;
+  if (maxIterations <= 0)
+    Log::Fatal << "--max_iterations (-n) must be positive!" << endl;
+
+  if (CLI::HasParam("list"))
+  {
+    const vector<Benchmark*> benchmarks = Benchmarks();
+    for (size_t i = 0; i < benchmarks.size(); ++i)
+    {
+      for (size_t j = 0; j < benchmarks[i]->ArgLists().size(); ++j)
+      {
+        const string name = benchmarks[i]->RunName(
+            benchmarks[i]->ArgLists()[j]);
+        if (name.find(filter) != string::npos)
+          cout << name << endl;
+      }
+    }
+
+    return 0;
+  }
+
+  size_t runs;
+  if (CLI::HasParam("output_file"))
+  {
+    const string filename = CLI::GetParam<string>("output_file");
+    ofstream stream(filename.c_str());
+    if (!stream.is_open())
+      Log::Fatal << "Cannot open '" << filename << "' for writing!" << endl;
+
+    runs = RunBenchmarks(filter, minTime, (size_t) maxIterations, stream);
+  }
+  else
+  {
+    runs = RunBenchmarks(filter, minTime, (size_t) maxIterations, cout);
+  }
+
+  if (runs == 0)
+    Log::Warn << "No benchmarks match '" << filter << "'." << endl;
+
+  return 0;
+}
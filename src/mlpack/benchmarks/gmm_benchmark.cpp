@@ -0,0 +1,50 @@
+/**
+ * @file gmm_benchmark.cpp
+ * @author Ryan Curtin
+ *
+ * Benchmarks of the EM algorithm for Gaussian mixture models.  The arguments
+ * are the number of points, the dimensionality, and the number of Gaussians.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/gmm/em_fit.hpp>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::benchmark;
+using namespace mlpack::gmm;
+using namespace mlpack::distribution;
+
+/**
+ * Run one step of EM, starting from the same model each time: Gaussians with
+ * identity covariances centered on the first points of the dataset, with equal
+ * weights.
+ */
+void GMMEMStep(State& state)
+{
+  const size_t dimensionality = state.Arg(1);
+  const size_t gaussians = state.Arg(2);
+  const arma::mat dataset = arma::randu<arma::mat>(dimensionality,
+      state.Arg(0));
+
+  std::vector<GaussianDistribution> initialDists;
+  for (size_t i = 0; i < gaussians; ++i)
+    initialDists.push_back(GaussianDistribution(arma::vec(dataset.col(i)),
+        arma::eye<arma::mat>(dimensionality, dimensionality)));
+  const arma::vec initialWeights = arma::ones<arma::vec>(gaussians) /
+      gaussians;
+
+  EMFit<> em(1);
+  while (state.KeepRunning())
+  {
+    state.PauseTiming();
+    std::vector<GaussianDistribution> dists(initialDists);
+    arma::vec weights(initialWeights);
+    state.ResumeTiming();
+
+    em.Estimate(dataset, dists, weights, true);
+  }
+}
+
+static Benchmark* gmmEMStep = Register("gmm/em_step", GMMEMStep)->
+    Args({ 10000, 5, 10 })->Args({ 100000, 3, 5 })->Args({ 10000, 20, 10 });
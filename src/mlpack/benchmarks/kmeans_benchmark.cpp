@@ -0,0 +1,72 @@
+/**
+ * @file kmeans_benchmark.cpp
+ * @author Ryan Curtin
+ *
+ * Benchmarks of the Lloyd iteration implementations of k-means.  The arguments
+ * are the number of points, the dimensionality, and the number of clusters.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/kmeans/naive_kmeans.hpp>
+#include <mlpack/methods/kmeans/elkan_kmeans.hpp>
+#include <mlpack/methods/kmeans/hamerly_kmeans.hpp>
+#include <mlpack/methods/kmeans/pelleg_moore_kmeans.hpp>
+#include <mlpack/methods/kmeans/dual_tree_kmeans.hpp>
+#include <mlpack/methods/kmeans/yinyang_kmeans.hpp>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::benchmark;
+using namespace mlpack::kmeans;
+using namespace mlpack::metric;
+
+/**
+ * Run five Lloyd iterations with the given implementation, starting from the
+ * same centroids each time.  The implementations keep bounds from one iteration
+ * to the next (and some build trees), so each timed iteration constructs the
+ * LloydStepType object again.  The number of distance calculations is
+ * reported.
+ */
+template<template<typename, typename> class LloydStepType>
+void KMeansIterations(State& state)
+{
+  const arma::mat dataset = arma::randu<arma::mat>(state.Arg(1),
+      state.Arg(0));
+  const arma::mat initialCentroids = dataset.cols(0, state.Arg(2) - 1);
+
+  while (state.KeepRunning())
+  {
+    EuclideanDistance metric;
+    LloydStepType<EuclideanDistance, arma::mat> step(dataset, metric);
+
+    arma::mat centroids(initialCentroids);
+    arma::mat newCentroids;
+    arma::Col<size_t> counts;
+    for (size_t i = 0; i < 5; ++i)
+    {
+      step.Iterate(centroids, newCentroids, counts);
+      centroids.swap(newCentroids);
+    }
+
+    state.Counter("distance_calculations", step.DistanceCalculations());
+  }
+}
+
+static Benchmark* naive = Register("kmeans/naive",
+    KMeansIterations<NaiveKMeans>)->Args({ 10000, 10, 20 })->
+    Args({ 100000, 3, 100 });
+static Benchmark* elkan = Register("kmeans/elkan",
+    KMeansIterations<ElkanKMeans>)->Args({ 10000, 10, 20 })->
+    Args({ 100000, 3, 100 });
+static Benchmark* hamerly = Register("kmeans/hamerly",
+    KMeansIterations<HamerlyKMeans>)->Args({ 10000, 10, 20 })->
+    Args({ 100000, 3, 100 });
+static Benchmark* pellegMoore = Register("kmeans/pelleg_moore",
+    KMeansIterations<PellegMooreKMeans>)->Args({ 10000, 10, 20 })->
+    Args({ 100000, 3, 100 });
+static Benchmark* dualTree = Register("kmeans/dual_tree",
+    KMeansIterations<DefaultDualTreeKMeans>)->Args({ 10000, 10, 20 })->
+    Args({ 100000, 3, 100 });
+static Benchmark* yinyang = Register("kmeans/yinyang",
+    KMeansIterations<YinyangKMeans>)->Args({ 10000, 10, 20 })->
+    Args({ 100000, 3, 100 });
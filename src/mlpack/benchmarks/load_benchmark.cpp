@@ -0,0 +1,53 @@
+/**
+ * @file load_benchmark.cpp
+ * @author Ryan Curtin
+ *
+ * Benchmarks of data::Load().  A random dataset is saved to a file in the
+ * working directory (which is removed afterwards), and then loaded.  The
+ * arguments are the number of points and the dimensionality.
+ */
+#include <mlpack/core.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::benchmark;
+
+/**
+ * Save a random dataset with the given extension and time loading it.  The size
+ * of the file is reported.
+ */
+static void LoadFile(State& state, const std::string& extension)
+{
+  std::ostringstream filename;
+  filename << "mlpack_benchmark_" << state.Arg(0) << "_" << state.Arg(1) << "."
+      << extension;
+
+  const arma::mat dataset = arma::randu<arma::mat>(state.Arg(1),
+      state.Arg(0));
+  data::Save(filename.str(), dataset, true);
+
+  std::ifstream file(filename.str().c_str(), std::ios::binary | std::ios::ate);
+  state.Counter("bytes", (double) file.tellg());
+  file.close();
+
+  arma::mat loaded;
+  while (state.KeepRunning())
+    data::Load(filename.str(), loaded, true);
+
+  std::remove(filename.str().c_str());
+}
+
+//! Load a CSV file.
+void LoadCSV(State& state) { LoadFile(state, "csv"); }
+//! Load an Armadillo binary file.
+void LoadArmaBinary(State& state) { LoadFile(state, "bin"); }
+
+static Benchmark* loadCSV = Register("load/csv", LoadCSV)->
+    Args({ 100000, 10 })->Args({ 10000, 100 });
+static Benchmark* loadArmaBinary = Register("load/arma_binary",
+    LoadArmaBinary)->Args({ 100000, 10 })->Args({ 10000, 100 });
@@ -0,0 +1,66 @@
+/**
+ * @file lsh_benchmark.cpp
+ * @author Ryan Curtin
+ *
+ * Benchmarks of building and querying LSH models.  The arguments are the number
+ * of points, the dimensionality, the number of projections, and the number of
+ * tables.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/lsh/lsh_search.hpp>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::benchmark;
+using namespace mlpack::neighbor;
+
+/**
+ * Build the hash tables of an LSH model (with a hash width of 1).  The memory
+ * used by the model is reported.
+ */
+void LSHBuild(State& state)
+{
+  const arma::mat dataset = arma::randu<arma::mat>(state.Arg(1),
+      state.Arg(0));
+
+  while (state.KeepRunning())
+  {
+    LSHSearch<> lsh(dataset, state.Arg(2), state.Arg(3), 1.0);
+
+    state.Counter("bytes", lsh.MemoryUsage());
+  }
+}
+
+static Benchmark* lshBuild = Register("lsh/build", LSHBuild)->
+    Args({ 10000, 10, 10, 30 })->Args({ 100000, 10, 10, 30 });
+
+/**
+ * Find the 5 approximate nearest neighbors of each of 1000 query points, with
+ * one additional probe in each table if Probes is 1.  The number of distance
+ * evaluations is reported.
+ */
+template<size_t Probes>
+void LSHQuery(State& state)
+{
+  const arma::mat dataset = arma::randu<arma::mat>(state.Arg(1),
+      state.Arg(0));
+  const arma::mat queries = arma::randu<arma::mat>(state.Arg(1), 1000);
+  LSHSearch<> lsh(dataset, state.Arg(2), state.Arg(3), 1.0);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  while (state.KeepRunning())
+  {
+    // The count of distance evaluations accumulates over searches.
+    lsh.DistanceEvaluations() = 0;
+    lsh.Search(queries, 5, neighbors, distances, 0, Probes);
+
+    state.Counter("distance_evaluations", lsh.DistanceEvaluations());
+  }
+}
+
+static Benchmark* lshQuery = Register("lsh/query", LSHQuery<0>)->
+    Args({ 10000, 10, 10, 30 })->Args({ 100000, 10, 10, 30 });
+static Benchmark* lshMultiprobeQuery = Register("lsh/query_multiprobe",
+    LSHQuery<1>)->Args({ 10000, 10, 10, 30 })->Args({ 100000, 10, 10, 30 });
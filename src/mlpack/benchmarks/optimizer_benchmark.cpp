@@ -0,0 +1,95 @@
+/**
+ * @file optimizer_benchmark.cpp
+ * @author Ryan Curtin
+ *
+ * Benchmarks of the SGD and L-BFGS optimizers.  The logistic regression
+ * benchmarks take the number of points and the dimensionality as arguments; the
+ * labels are 1 for the points whose coordinates sum to more than half of the
+ * dimensionality.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/sgd/sgd.hpp>
+#include <mlpack/core/optimizers/lbfgs/lbfgs.hpp>
+#include <mlpack/core/optimizers/lbfgs/test_functions.hpp>
+#include <mlpack/methods/logistic_regression/logistic_regression_function.hpp>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::benchmark;
+using namespace mlpack::optimization;
+using namespace mlpack::optimization::test;
+using namespace mlpack::regression;
+
+//! Get the labels of the logistic regression benchmarks.
+static arma::Row<size_t> Labels(const arma::mat& dataset)
+{
+  arma::Row<size_t> labels(dataset.n_cols);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    labels[i] = (arma::accu(dataset.col(i)) > dataset.n_rows / 2.0) ? 1 : 0;
+
+  return labels;
+}
+
+/**
+ * Run one epoch (one step for each point, in shuffled order) of SGD on the
+ * logistic regression objective.  The final objective is reported.
+ */
+void SGDLogisticRegression(State& state)
+{
+  const arma::mat dataset = arma::randu<arma::mat>(state.Arg(1),
+      state.Arg(0));
+  const arma::Row<size_t> labels = Labels(dataset);
+  LogisticRegressionFunction<> function(dataset, labels, 0.001);
+
+  SGD<LogisticRegressionFunction<>> sgd(function, 0.01, dataset.n_cols, 0.0);
+  while (state.KeepRunning())
+  {
+    arma::mat iterate(function.GetInitialPoint());
+    state.Counter("objective", sgd.Optimize(iterate));
+  }
+}
+
+static Benchmark* sgdLR = Register("sgd/logistic_regression",
+    SGDLogisticRegression)->Args({ 100000, 10 })->Args({ 10000, 100 });
+
+/**
+ * Run 10 iterations of L-BFGS on the logistic regression objective.  The final
+ * objective is reported.
+ */
+void LBFGSLogisticRegression(State& state)
+{
+  const arma::mat dataset = arma::randu<arma::mat>(state.Arg(1),
+      state.Arg(0));
+  const arma::Row<size_t> labels = Labels(dataset);
+  LogisticRegressionFunction<> function(dataset, labels, 0.001);
+
+  L_BFGS<LogisticRegressionFunction<>> lbfgs(function);
+  while (state.KeepRunning())
+  {
+    arma::mat iterate(function.GetInitialPoint());
+    state.Counter("objective", lbfgs.Optimize(iterate, 10));
+  }
+}
+
+static Benchmark* lbfgsLR = Register("lbfgs/logistic_regression",
+    LBFGSLogisticRegression)->Args({ 100000, 10 })->Args({ 10000, 100 });
+
+/**
+ * Run 100 iterations of L-BFGS on the generalized Rosenbrock function of the
+ * given dimensionality (the only argument).  The final objective is reported.
+ */
+void LBFGSRosenbrock(State& state)
+{
+  GeneralizedRosenbrockFunction function((int) state.Arg(0));
+
+  L_BFGS<GeneralizedRosenbrockFunction> lbfgs(function);
+  while (state.KeepRunning())
+  {
+    arma::mat iterate(function.GetInitialPoint());
+    state.Counter("objective", lbfgs.Optimize(iterate, 100));
+  }
+}
+
+static Benchmark* lbfgsRosenbrock = Register("lbfgs/rosenbrock",
+    LBFGSRosenbrock)->Args({ 100 })->Args({ 1000 });
@@ -0,0 +1,123 @@
+/**
+ * @file search_benchmark.cpp
+ * @author Ryan Curtin
+ *
+ * Benchmarks of the tree traversals of k-nearest-neighbor search, range search,
+ * and FastMKS.  The reference trees are built outside of the timed loop, and
+ * each search is monochromatic (the reference set is also the query set).  The
+ * arguments are the number of points and the dimensionality.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/kernels/linear_kernel.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <mlpack/methods/range_search/range_search.hpp>
+#include <mlpack/methods/fastmks/fastmks.hpp>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::benchmark;
+using namespace mlpack::tree;
+using namespace mlpack::metric;
+using namespace mlpack::neighbor;
+using namespace mlpack::range;
+using namespace mlpack::fastmks;
+
+/**
+ * Find the 5 nearest neighbors of each point with the given tree type, with
+ * dual-tree search (or single-tree search, if SingleMode is true).  The base
+ * cases and scores of each search are reported.
+ */
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         bool SingleMode>
+void KNN(State& state)
+{
+  typedef NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat,
+      TreeType> KNNType;
+  arma::mat dataset = arma::randu<arma::mat>(state.Arg(1), state.Arg(0));
+  KNNType knn(std::move(dataset), false, SingleMode);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  while (state.KeepRunning())
+  {
+    knn.Search(5, neighbors, distances);
+
+    state.Counter("base_cases", knn.BaseCases());
+    state.Counter("scores", knn.Scores());
+  }
+}
+
+static Benchmark* knnKDDual = Register("knn/kd/dual", KNN<KDTree, false>)->
+    Args({ 10000, 3 })->Args({ 100000, 3 })->Args({ 10000, 10 });
+static Benchmark* knnKDSingle = Register("knn/kd/single",
+    KNN<KDTree, true>)->Args({ 10000, 3 })->Args({ 100000, 3 })->
+    Args({ 10000, 10 });
+static Benchmark* knnBallDual = Register("knn/ball/dual",
+    KNN<BallTree, false>)->Args({ 10000, 3 })->Args({ 10000, 10 });
+static Benchmark* knnCoverDual = Register("knn/cover/dual",
+    KNN<StandardCoverTree, false>)->Args({ 10000, 3 })->Args({ 10000, 10 });
+static Benchmark* knnCoverSingle = Register("knn/cover/single",
+    KNN<StandardCoverTree, true>)->Args({ 10000, 3 });
+
+/**
+ * Find the points within a distance of 0.05 of each point with the given tree
+ * type and dual-tree search.  The base cases and scores of each search, and the
+ * number of results, are reported.
+ */
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void Range(State& state)
+{
+  typedef RangeSearch<EuclideanDistance, arma::mat, TreeType> RangeType;
+  arma::mat dataset = arma::randu<arma::mat>(state.Arg(1), state.Arg(0));
+  RangeType rs(std::move(dataset));
+
+  std::vector<std::vector<size_t>> neighbors;
+  std::vector<std::vector<double>> distances;
+  while (state.KeepRunning())
+  {
+    rs.Search(math::Range(0.0, 0.05), neighbors, distances);
+
+    state.PauseTiming();
+    size_t results = 0;
+    for (size_t i = 0; i < neighbors.size(); ++i)
+      results += neighbors[i].size();
+    state.Counter("results", results);
+    state.Counter("base_cases", rs.BaseCases());
+    state.Counter("scores", rs.Scores());
+    state.ResumeTiming();
+  }
+}
+
+static Benchmark* rangeKD = Register("range/kd/dual", Range<KDTree>)->
+    Args({ 10000, 3 })->Args({ 100000, 3 });
+static Benchmark* rangeBall = Register("range/ball/dual", Range<BallTree>)->
+    Args({ 10000, 3 });
+
+/**
+ * Find the 5 largest linear kernel evaluations for each point with cover trees,
+ * with dual-tree search (or single-tree search, if SingleMode is true).
+ */
+template<bool SingleMode>
+void FastMKSLinear(State& state)
+{
+  const arma::mat dataset = arma::randu<arma::mat>(state.Arg(1),
+      state.Arg(0));
+  FastMKS<kernel::LinearKernel> fastmks(dataset, SingleMode);
+
+  arma::Mat<size_t> indices;
+  arma::mat kernels;
+  while (state.KeepRunning())
+    fastmks.Search(5, indices, kernels);
+}
+
+static Benchmark* fastmksDual = Register("fastmks/linear/dual",
+    FastMKSLinear<false>)->Args({ 5000, 3 })->Args({ 5000, 10 });
+static Benchmark* fastmksSingle = Register("fastmks/linear/single",
+    FastMKSLinear<true>)->Args({ 5000, 3 });
@@ -0,0 +1,58 @@
+/**
+ * @file tree_benchmark.cpp
+ * @author Ryan Curtin
+ *
+ * Benchmarks of tree building.  The arguments are the number of points and the
+ * dimensionality.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/tree/rectangle_tree.hpp>
+#include <mlpack/core/tree/tree_memory_usage.hpp>
+
+#include "benchmark.hpp"
+
+using namespace mlpack;
+using namespace mlpack::benchmark;
+using namespace mlpack::tree;
+using namespace mlpack::metric;
+
+/**
+ * Build a tree of the given type on a uniformly random dataset; the copy of the
+ * dataset the tree takes is not timed.  The number of nodes and the memory used
+ * by the tree are reported.
+ */
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void TreeBuild(State& state)
+{
+  typedef TreeType<EuclideanDistance, EmptyStatistic, arma::mat> Tree;
+  const arma::mat dataset = arma::randu<arma::mat>(state.Arg(1), state.Arg(0));
+
+  while (state.KeepRunning())
+  {
+    state.PauseTiming();
+    arma::mat copy(dataset);
+    state.ResumeTiming();
+
+    Tree tree(std::move(copy));
+
+    state.PauseTiming();
+    state.Counter("nodes", NumNodes(tree));
+    state.Counter("bytes", TreeMemoryUsage(tree));
+    state.ResumeTiming();
+  }
+}
+
+static Benchmark* kdTreeBuild = Register("tree_build/kd", TreeBuild<KDTree>)->
+    Args({ 10000, 3 })->Args({ 100000, 3 })->Args({ 10000, 30 });
+static Benchmark* ballTreeBuild = Register("tree_build/ball",
+    TreeBuild<BallTree>)->Args({ 10000, 3 })->Args({ 100000, 3 })->
+    Args({ 10000, 30 });
+static Benchmark* coverTreeBuild = Register("tree_build/cover",
+    TreeBuild<StandardCoverTree>)->Args({ 10000, 3 })->Args({ 100000, 3 })->
+    Args({ 10000, 30 });
+static Benchmark* rTreeBuild = Register("tree_build/r", TreeBuild<RTree>)->
+    Args({ 10000, 3 })->Args({ 100000, 3 });
@@ -2,18 +2,21 @@
  * @file allknn.cpp
  * @author Patrick Mason
  *
- * MEX function for MATLAB All-kNN binding.
+ * MEX function for MATLAB All-kNN binding.  The input points are copied once
+ * (building a tree reorders them), and the distances are written directly into
+ * the output mxArray.
  */
 #include "mex.h"
 
 #include <mlpack/core.hpp>
-#include <mlpack/core/tree/cover_tree.hpp>
-#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <mlpack/methods/neighbor_search/ns_model.hpp>
+
+#include "../mex_util.hpp"
 
 using namespace std;
 using namespace mlpack;
+using namespace mlpack::matlab;
 using namespace mlpack::neighbor;
-using namespace mlpack::tree;
 
 // the gateway, required by all mex functions
 void mexFunction(int nlhs, mxArray *plhs[],
@@ -30,18 +33,9 @@ void mexFunction(int nlhs, mxArray *plhs[],
     mexErrMsgTxt("Two outputs required.");
   }
 
-  // getting the dimensions of the reference matrix
-  size_t numPoints = mxGetN(prhs[0]);
-  size_t numDimensions = mxGetM(prhs[0]);
-
-  // feeding the referenceData matrix
-  arma::mat referenceData(numDimensions, numPoints);
-  // setting the values.
-  double * mexDataPoints = mxGetPr(prhs[0]);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-  {
-    referenceData(i) = mexDataPoints[i];
-  }
+  // The model takes this copy of the reference points, since the tree
+  // reorders them.
+  arma::mat referenceData = CopyMatrix(prhs[0]);
 
   // getting the leafsize
   int lsInt = (int) mxGetScalar(prhs[3]);
@@ -56,8 +50,6 @@ void mexFunction(int nlhs, mxArray *plhs[],
   bool singleMode = (mxGetScalar(prhs[5]) == 1.0);
 
   // the query matrix
-  double * mexQueryPoints = mxGetPr(prhs[2]);
-  arma::mat queryData;
   bool hasQueryData = ((mxGetM(prhs[2]) != 0) && (mxGetN(prhs[2]) != 0));
 
   // cover-tree?
@@ -90,190 +82,36 @@ void mexFunction(int nlhs, mxArray *plhs[],
      mexWarnMsgTxt("single_mode ignored because naive is present.");
   }
 
-  if (naive)
-    leafSize = referenceData.n_cols;
+  const size_t numQueries = hasQueryData ? mxGetN(prhs[2]) :
+      referenceData.n_cols;
 
+  // The distances are written directly into the output; only the indices of
+  // the neighbors need to be converted to doubles.
+  arma::mat distances = OutputMatrix(plhs[0], k, numQueries);
   arma::Mat<size_t> neighbors;
-  arma::mat distances;
 
-  //if (!CLI::HasParam("cover_tree"))
-  if (usesCoverTree)
+  try
   {
-    // Because we may construct it differently, we need a pointer.
-    AllkNN* allknn = NULL;
-
-    // Mappings for when we build the tree.
-    std::vector<size_t> oldFromNewRefs;
-
-    // Build trees by hand, so we can save memory: if we pass a tree to
-    // NeighborSearch, it does not copy the matrix.
+    NSModel<NearestNeighborSort> allknn(usesCoverTree ?
+        NSModel<NearestNeighborSort>::COVER_TREE :
+        NSModel<NearestNeighborSort>::KD_TREE);
 
-    BinarySpaceTree<bound::HRectBound<2>, QueryStat<NearestNeighborSort> >
-      refTree(referenceData, oldFromNewRefs, leafSize);
-    BinarySpaceTree<bound::HRectBound<2>, QueryStat<NearestNeighborSort> >*
-      queryTree = NULL; // Empty for now.
-
-    std::vector<size_t> oldFromNewQueries;
+    allknn.BuildModel(std::move(referenceData), leafSize, naive, singleMode);
 
     if (hasQueryData)
     {
-      // setting the values.
-      mexDataPoints = mxGetPr(prhs[2]);
-      numPoints = mxGetN(prhs[2]);
-      numDimensions = mxGetM(prhs[2]);
-      queryData = arma::mat(numDimensions, numPoints);
-      for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-      {
-        queryData(i) = mexDataPoints[i];
-      }
-
-      if (naive && leafSize < queryData.n_cols)
-        leafSize = queryData.n_cols;
-
-      // Build trees by hand, so we can save memory: if we pass a tree to
-      // NeighborSearch, it does not copy the matrix.
-      if (!singleMode)
-      {
-        queryTree = new BinarySpaceTree<bound::HRectBound<2>,
-            QueryStat<NearestNeighborSort> >(queryData, oldFromNewQueries,
-            leafSize);
-      }
-
-      allknn = new AllkNN(&refTree, queryTree, referenceData, queryData,
-          singleMode);
+      arma::mat queryData = CopyMatrix(prhs[2]);
+      allknn.Search(std::move(queryData), k, neighbors, distances);
     }
     else
     {
-      allknn = new AllkNN(&refTree, referenceData, singleMode);
+      allknn.Search(k, neighbors, distances);
     }
-
-    arma::mat distancesOut;
-    arma::Mat<size_t> neighborsOut;
-
-    allknn->Search(k, neighborsOut, distancesOut);
-
-    // We have to map back to the original indices from before the tree
-    // construction.
-    neighbors.set_size(neighborsOut.n_rows, neighborsOut.n_cols);
-    distances.set_size(distancesOut.n_rows, distancesOut.n_cols);
-
-    // Do the actual remapping.
-    if ((hasQueryData) && !singleMode)
-    {
-      for (size_t i = 0; i < distancesOut.n_cols; ++i)
-      {
-        // Map distances (copy a column) and square root.
-        distances.col(oldFromNewQueries[i]) = sqrt(distancesOut.col(i));
-
-        // Map indices of neighbors.
-        for (size_t j = 0; j < distancesOut.n_rows; ++j)
-        {
-          neighbors(j, oldFromNewQueries[i]) =
-              oldFromNewRefs[neighborsOut(j, i)];
-        }
-      }
-    }
-    else if ((hasQueryData) && singleMode)
-    {
-      // No remapping of queries is necessary.  So distances are the same.
-      distances = sqrt(distancesOut);
-
-      // The neighbor indices must be mapped.
-      for (size_t j = 0; j < neighborsOut.n_elem; ++j)
-      {
-        neighbors[j] = oldFromNewRefs[neighborsOut[j]];
-      }
-    }
-    else
-    {
-      for (size_t i = 0; i < distancesOut.n_cols; ++i)
-      {
-        // Map distances (copy a column).
-        distances.col(oldFromNewRefs[i]) = sqrt(distancesOut.col(i));
-
-        // Map indices of neighbors.
-        for (size_t j = 0; j < distancesOut.n_rows; ++j)
-        {
-          neighbors(j, oldFromNewRefs[i]) = oldFromNewRefs[neighborsOut(j, i)];
-        }
-      }
-    }
-
-    // Clean up.
-    if (queryTree)
-      delete queryTree;
-
-    delete allknn;
-  }
-  else // Cover trees.
-  {
-    // Build our reference tree.
-    CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
-        QueryStat<NearestNeighborSort> > referenceTree(referenceData, 1.3);
-    CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
-        QueryStat<NearestNeighborSort> >* queryTree = NULL;
-
-    NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>,
-        CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
-        QueryStat<NearestNeighborSort> > >* allknn = NULL;
-
-    // See if we have query data.
-    if (hasQueryData)
-    {
-      // setting the values.
-      mexDataPoints = mxGetPr(prhs[2]);
-      numPoints = mxGetN(prhs[2]);
-      numDimensions = mxGetM(prhs[2]);
-      queryData = arma::mat(numDimensions, numPoints);
-      for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-      {
-        queryData(i) = mexDataPoints[i];
-      }
-
-      // Build query tree.
-      if (!singleMode)
-      {
-        queryTree = new CoverTree<metric::LMetric<2, true>,
-            tree::FirstPointIsRoot, QueryStat<NearestNeighborSort> >(queryData,
-            1.3);
-      }
-
-      allknn = new NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>,
-          CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
-          QueryStat<NearestNeighborSort> > >(&referenceTree, queryTree,
-          referenceData, queryData, singleMode);
-    }
-    else
-    {
-      allknn = new NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>,
-          CoverTree<metric::LMetric<2, true>, tree::FirstPointIsRoot,
-          QueryStat<NearestNeighborSort> > >(&referenceTree, referenceData,
-          singleMode);
-    }
-
-    allknn->Search(k, neighbors, distances);
-
-    delete allknn;
-
-    if (queryTree)
-      delete queryTree;
-  }
-
-  // writing back to matlab
-  // constructing matrix to return to matlab
-  plhs[0] = mxCreateDoubleMatrix(distances.n_rows, distances.n_cols, mxREAL);
-  plhs[1] = mxCreateDoubleMatrix(neighbors.n_rows, neighbors.n_cols, mxREAL);
-
-  // setting the values
-  double * out = mxGetPr(plhs[0]);
-  for (int i = 0, n = distances.n_rows * distances.n_cols; i < n; ++i)
-  {
-    out[i] = distances(i);
   }
-  out = mxGetPr(plhs[1]);
-  for (int i = 0, n = neighbors.n_rows * neighbors.n_cols; i < n; ++i)
+  catch (std::exception& e)
   {
-    out[i] = neighbors(i);
+    mexErrMsgTxt(e.what());
   }
 
+  plhs[1] = ToMxArray(neighbors);
 }
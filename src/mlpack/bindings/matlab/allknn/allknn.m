@@ -49,7 +49,7 @@ parsed = p.Results;
 parsed
 
 % interfacing with mlpack
-[distances neighbors] = mex_allknn(dataPoints', k, parsed.queryPoints', ...
+[distances neighbors] = allknn_mex(dataPoints', k, parsed.queryPoints', ...
 	parsed.leafSize, parsed.naive, parsed.singleMode, parsed.coverTree);
 
 % transposing results
@@ -9,8 +9,11 @@
 #include <mlpack/core.hpp>
 #include <mlpack/methods/gmm/gmm.hpp>
 
+#include "../mex_util.hpp"
+
 using namespace mlpack;
 using namespace mlpack::gmm;
+using namespace mlpack::matlab;
 using namespace mlpack::util;
 
 void mexFunction(int nlhs, mxArray *plhs[],
@@ -34,15 +37,9 @@ void mexFunction(int nlhs, mxArray *plhs[],
   else
     math::RandomSeed((size_t) std::time(NULL));
 
-  // loading the data
-  double * mexDataPoints = mxGetPr(prhs[0]);
-  size_t numPoints = mxGetN(prhs[0]);
-  size_t numDimensions = mxGetM(prhs[0]);
-  arma::mat dataPoints(numDimensions, numPoints);
-  for (int i = 0, n = numPoints * numDimensions; i < n; ++i)
-  {
-    dataPoints(i) = mexDataPoints[i];
-  }
+  // Use the data without copying it; GMM::Estimate() does not modify it.
+  const arma::mat dataPoints = AliasMatrix(prhs[0]);
+  size_t numDimensions = dataPoints.n_rows;
 
   int gaussians = (int) mxGetScalar(prhs[1]);
   if (gaussians <= 0)
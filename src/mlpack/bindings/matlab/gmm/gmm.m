@@ -21,7 +21,7 @@ p.parse(varargin{:});
 parsed = p.Results;
 
 % interfacing with mlpack
-result = mex_gmm(dataPoints', parsed.gaussians, parsed.seed);
+result = gmm_mex(dataPoints', parsed.gaussians, parsed.seed);
 
 
 
@@ -0,0 +1,131 @@
+/**
+ * @file gmm_model.cpp
+ * @author Ryan Curtin
+ *
+ * MEX function for the MATLAB Gaussian mixture model binding.  The model stays
+ * in memory between calls, so it can be used many times after it is trained
+ * once:
+ *
+ *   handle = gmm_model_mex('train', dataPoints, gaussians, trials)
+ *   labels = gmm_model_mex('classify', handle, points)
+ *   logProbabilities = gmm_model_mex('log_probability', handle, points)
+ *   gmm_model_mex('delete', handle)
+ *
+ * The points are used in place, and the log-probabilities are written directly
+ * into the output.
+ */
+#include "mex.h"
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/gmm/gmm.hpp>
+
+#include "../mex_util.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::gmm;
+using namespace mlpack::matlab;
+
+typedef ModelHandles<GMM<> > Handles;
+
+void Train(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  if (nrhs != 4 || nlhs != 1)
+    mexErrMsgTxt("Usage: handle = gmm_model_mex('train', dataPoints, "
+        "gaussians, trials).");
+
+  const int gaussians = (int) mxGetScalar(prhs[2]);
+  const int trials = (int) mxGetScalar(prhs[3]);
+  if (gaussians <= 0 || trials <= 0)
+    mexErrMsgTxt("Invalid number of Gaussians or trials; both must be greater "
+        "than 0.");
+
+  const arma::mat dataPoints = AliasMatrix(prhs[1]);
+  GMM<>* gmm = new GMM<>(size_t(gaussians), dataPoints.n_rows);
+  try
+  {
+    gmm->Estimate(dataPoints, size_t(trials));
+  }
+  catch (std::exception& e)
+  {
+    delete gmm;
+    mexErrMsgTxt(e.what());
+  }
+
+  plhs[0] = Handles::Create(gmm);
+}
+
+//! Check that the points have the dimensionality of the model.
+void CheckDimensionality(const GMM<>& gmm, const arma::mat& points)
+{
+  if (points.n_rows != gmm.Dimensionality())
+  {
+    stringstream ss;
+    ss << "Points have dimensionality " << points.n_rows << ", but the model "
+        << "has dimensionality " << gmm.Dimensionality() << ".";
+    mexErrMsgTxt(ss.str().c_str());
+  }
+}
+
+void Classify(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  if (nrhs != 3 || nlhs != 1)
+    mexErrMsgTxt("Usage: labels = gmm_model_mex('classify', handle, points).");
+
+  const GMM<>& gmm = Handles::Get(prhs[1]);
+  const arma::mat points = AliasMatrix(prhs[2]);
+  CheckDimensionality(gmm, points);
+
+  arma::Col<size_t> labels;
+  gmm.Classify(points, labels);
+  plhs[0] = ToMxArray(labels);
+}
+
+void LogProbability(int nlhs, mxArray *plhs[], int nrhs,
+                    const mxArray *prhs[])
+{
+  if (nrhs != 3 || nlhs != 1)
+    mexErrMsgTxt("Usage: logProbabilities = gmm_model_mex('log_probability', "
+        "handle, points).");
+
+  const GMM<>& gmm = Handles::Get(prhs[1]);
+  const arma::mat points = AliasMatrix(prhs[2]);
+  CheckDimensionality(gmm, points);
+
+  arma::vec logProbabilities = OutputVector(plhs[0], points.n_cols);
+  gmm.LogProbability(points, logProbabilities);
+}
+
+// the gateway, required by all mex functions
+void mexFunction(int nlhs, mxArray *plhs[],
+                 int nrhs, const mxArray *prhs[])
+{
+  if (nrhs < 1)
+    mexErrMsgTxt("Expecting a command: 'train', 'classify', "
+        "'log_probability', or 'delete'.");
+
+  const string command = GetString(prhs[0]);
+  if (command == "train")
+  {
+    Train(nlhs, plhs, nrhs, prhs);
+  }
+  else if (command == "classify")
+  {
+    Classify(nlhs, plhs, nrhs, prhs);
+  }
+  else if (command == "log_probability")
+  {
+    LogProbability(nlhs, plhs, nrhs, prhs);
+  }
+  else if (command == "delete")
+  {
+    if (nrhs != 2)
+      mexErrMsgTxt("Usage: gmm_model_mex('delete', handle).");
+    Handles::Destroy(prhs[1]);
+  }
+  else
+  {
+    mexErrMsgTxt("Unknown command; must be 'train', 'classify', "
+        "'log_probability', or 'delete'.");
+  }
+}
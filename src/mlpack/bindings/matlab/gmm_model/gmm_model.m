@@ -0,0 +1,49 @@
+function varargout = gmm_model(command, varargin)
+%Gaussian Mixture Model (GMM)
+%
+%  This trains a Gaussian mixture model with the EM algorithm once, and keeps it
+%  in memory so that it can classify many sets of points or give their
+%  log-probabilities.  The model must be deleted when it is no longer needed.
+%
+%Usage:
+% model = gmm_model('train', dataPoints, 'gaussians', 1, 'trials', 1);
+% labels = gmm_model('classify', model, points);
+% logProbabilities = gmm_model('log_probability', model, points);
+% gmm_model('delete', model);
+%
+%Parameters:
+% dataPoints - the matrix of data points.  Columns are assumed to represent
+%              dimensions, with rows representing separate points.
+% gaussians  - (optional) Number of gaussians in the GMM.  Default value is 1.
+% trials     - (optional) Number of times to run EM; the best model is kept.
+%              Default value is 1.
+% points     - the matrix of points to classify, organized like the data
+%              points.
+
+switch command
+  case 'train'
+    p = inputParser;
+    p.addParamValue('gaussians', 1, @isscalar);
+    p.addParamValue('trials', 1, @isscalar);
+    p.parse(varargin{2:end});
+    parsed = p.Results;
+
+    varargout{1} = gmm_model_mex('train', varargin{1}', parsed.gaussians, ...
+        parsed.trials);
+
+  case 'classify'
+    labels = gmm_model_mex('classify', varargin{1}, varargin{2}');
+    varargout{1} = labels + 1; % matlab indices began at 1, not zero
+
+  case 'log_probability'
+    varargout{1} = gmm_model_mex('log_probability', varargin{1}, ...
+        varargin{2}');
+
+  case 'delete'
+    gmm_model_mex('delete', varargin{1});
+
+  otherwise
+    error('Unknown command ''%s''.', command);
+end
+
+return;
@@ -0,0 +1,145 @@
+/**
+ * @file kmeans_model.cpp
+ * @author Ryan Curtin
+ *
+ * MEX function for the MATLAB k-means model binding.  The centroids stay in
+ * memory between calls, so new points can be assigned to clusters many times
+ * after the clustering is done once:
+ *
+ *   [handle assignments] = kmeans_model_mex('train', dataPoints, clusters,
+ *                                           maxIterations)
+ *   assignments = kmeans_model_mex('assign', handle, points)
+ *   centroids = kmeans_model_mex('centroids', handle)
+ *   kmeans_model_mex('delete', handle)
+ *
+ * The points are used in place, and the centroids are written directly into
+ * the output.
+ */
+#include "mex.h"
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/kmeans/kmeans.hpp>
+
+#include "../mex_util.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::kmeans;
+using namespace mlpack::matlab;
+
+//! The state of a k-means model: the centroids of its clusters.
+struct KMeansModel
+{
+  arma::mat centroids;
+};
+
+typedef ModelHandles<KMeansModel> Handles;
+
+void Train(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  if (nrhs != 4 || nlhs < 1 || nlhs > 2)
+    mexErrMsgTxt("Usage: [handle assignments] = kmeans_model_mex('train', "
+        "dataPoints, clusters, maxIterations).");
+
+  const int clusters = (int) mxGetScalar(prhs[2]);
+  const int maxIterations = (int) mxGetScalar(prhs[3]);
+  if (clusters <= 0 || maxIterations < 0)
+    mexErrMsgTxt("Invalid number of clusters or maximum iterations; clusters "
+        "must be greater than 0, and iterations must not be negative.");
+
+  const arma::mat dataPoints = AliasMatrix(prhs[1]);
+  KMeansModel* model = new KMeansModel();
+  arma::Col<size_t> assignments;
+  try
+  {
+    KMeans<> k(size_t(maxIterations));
+    k.Cluster(dataPoints, size_t(clusters), assignments, model->centroids);
+  }
+  catch (std::exception& e)
+  {
+    delete model;
+    mexErrMsgTxt(e.what());
+  }
+
+  plhs[0] = Handles::Create(model);
+  if (nlhs == 2)
+    plhs[1] = ToMxArray(assignments);
+}
+
+void Assign(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  if (nrhs != 3 || nlhs != 1)
+    mexErrMsgTxt("Usage: assignments = kmeans_model_mex('assign', handle, "
+        "points).");
+
+  const KMeansModel& model = Handles::Get(prhs[1]);
+  const arma::mat points = AliasMatrix(prhs[2]);
+  if (points.n_rows != model.centroids.n_rows)
+    mexErrMsgTxt("Points do not have the dimensionality of the centroids.");
+
+  // Each point is assigned to the cluster of its nearest centroid.
+  arma::vec assignments = OutputVector(plhs[0], points.n_cols);
+  metric::SquaredEuclideanDistance metric;
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    double minDistance = DBL_MAX;
+    size_t closest = 0;
+    for (size_t j = 0; j < model.centroids.n_cols; ++j)
+    {
+      const double distance = metric.Evaluate(points.col(i),
+          model.centroids.col(j));
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closest = j;
+      }
+    }
+
+    assignments[i] = (double) closest;
+  }
+}
+
+void Centroids(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  if (nrhs != 2 || nlhs != 1)
+    mexErrMsgTxt("Usage: centroids = kmeans_model_mex('centroids', handle).");
+
+  const KMeansModel& model = Handles::Get(prhs[1]);
+  arma::mat centroids = OutputMatrix(plhs[0], model.centroids.n_rows,
+      model.centroids.n_cols);
+  centroids = model.centroids;
+}
+
+// the gateway, required by all mex functions
+void mexFunction(int nlhs, mxArray *plhs[],
+                 int nrhs, const mxArray *prhs[])
+{
+  if (nrhs < 1)
+    mexErrMsgTxt("Expecting a command: 'train', 'assign', 'centroids', or "
+        "'delete'.");
+
+  const string command = GetString(prhs[0]);
+  if (command == "train")
+  {
+    Train(nlhs, plhs, nrhs, prhs);
+  }
+  else if (command == "assign")
+  {
+    Assign(nlhs, plhs, nrhs, prhs);
+  }
+  else if (command == "centroids")
+  {
+    Centroids(nlhs, plhs, nrhs, prhs);
+  }
+  else if (command == "delete")
+  {
+    if (nrhs != 2)
+      mexErrMsgTxt("Usage: kmeans_model_mex('delete', handle).");
+    Handles::Destroy(prhs[1]);
+  }
+  else
+  {
+    mexErrMsgTxt("Unknown command; must be 'train', 'assign', 'centroids', "
+        "or 'delete'.");
+  }
+}
@@ -0,0 +1,52 @@
+function varargout = kmeans_model(command, varargin)
+%K-Means Clustering Model
+%
+%  This clusters a set of points with k-means once, and keeps the centroids in
+%  memory so that many sets of points can be assigned to the clusters.  The
+%  model must be deleted when it is no longer needed.
+%
+%Usage:
+% [model assignments] = kmeans_model('train', dataPoints, clusters, ...
+%                                    'maxIterations', 1000);
+% assignments = kmeans_model('assign', model, points);
+% centroids = kmeans_model('centroids', model);
+% kmeans_model('delete', model);
+%
+%Parameters:
+% dataPoints    - the matrix of data points.  Columns are assumed to represent
+%                 dimensions, with rows representing separate points.
+% clusters      - the number of clusters.
+% maxIterations - (optional) Maximum number of iterations; 0 means there is no
+%                 limit.  Default value is 1000.
+% points        - the matrix of points to assign, organized like the data
+%                 points.
+%
+% Row i of centroids is the centroid of cluster i.
+
+switch command
+  case 'train'
+    p = inputParser;
+    p.addParamValue('maxIterations', 1000, @isscalar);
+    p.parse(varargin{3:end});
+    parsed = p.Results;
+
+    [model assignments] = kmeans_model_mex('train', varargin{1}', ...
+        varargin{2}, parsed.maxIterations);
+    varargout{1} = model;
+    varargout{2} = assignments + 1; % matlab indices began at 1, not zero
+
+  case 'assign'
+    assignments = kmeans_model_mex('assign', varargin{1}, varargin{2}');
+    varargout{1} = assignments + 1; % matlab indices began at 1, not zero
+
+  case 'centroids'
+    varargout{1} = kmeans_model_mex('centroids', varargin{1})';
+
+  case 'delete'
+    kmeans_model_mex('delete', varargin{1});
+
+  otherwise
+    error('Unknown command ''%s''.', command);
+end
+
+return;
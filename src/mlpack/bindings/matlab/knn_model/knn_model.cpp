@@ -0,0 +1,146 @@
+/**
+ * @file knn_model.cpp
+ * @author Ryan Curtin
+ *
+ * MEX function for the MATLAB k-nearest-neighbor model binding.  The model (and
+ * its tree) stays in memory between calls, so it can be searched many times
+ * after it is built once:
+ *
+ *   handle = knn_model_mex('train', referencePoints, treeType, leafSize,
+ *                          naive, singleMode)
+ *   [distances neighbors] = knn_model_mex('search', handle, queryPoints, k)
+ *   knn_model_mex('delete', handle)
+ *
+ * Empty query points search the reference points themselves.
+ */
+#include "mex.h"
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/neighbor_search/ns_model.hpp>
+
+#include "../mex_util.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::matlab;
+using namespace mlpack::neighbor;
+
+typedef NSModel<NearestNeighborSort> KNNModel;
+typedef ModelHandles<KNNModel> Handles;
+
+//! Get the NSModel tree type with the given name.
+int TreeType(const string& name)
+{
+  if (name == "kd")
+    return KNNModel::KD_TREE;
+  else if (name == "cover")
+    return KNNModel::COVER_TREE;
+  else if (name == "r")
+    return KNNModel::R_TREE;
+  else if (name == "r-star")
+    return KNNModel::R_STAR_TREE;
+  else if (name == "ball")
+    return KNNModel::BALL_TREE;
+  else if (name == "vp")
+    return KNNModel::VP_TREE;
+  else if (name == "spill")
+    return KNNModel::SPILL_TREE;
+
+  mexErrMsgTxt("Invalid tree type; must be 'kd', 'cover', 'r', 'r-star', "
+      "'ball', 'vp', or 'spill'.");
+  return KNNModel::KD_TREE;
+}
+
+void Train(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  if (nrhs != 6 || nlhs != 1)
+    mexErrMsgTxt("Usage: handle = knn_model_mex('train', referencePoints, "
+        "treeType, leafSize, naive, singleMode).");
+
+  const int leafSize = (int) mxGetScalar(prhs[3]);
+  if (leafSize <= 0)
+    mexErrMsgTxt("Invalid leaf size; must be greater than 0.");
+
+  KNNModel* model = new KNNModel(TreeType(GetString(prhs[2])));
+  try
+  {
+    // The tree reorders the points, so the model takes one copy of them.
+    arma::mat referenceData = CopyMatrix(prhs[1]);
+    model->BuildModel(std::move(referenceData), size_t(leafSize),
+        mxGetScalar(prhs[4]) == 1.0, mxGetScalar(prhs[5]) == 1.0);
+  }
+  catch (std::exception& e)
+  {
+    delete model;
+    mexErrMsgTxt(e.what());
+  }
+
+  plhs[0] = Handles::Create(model);
+}
+
+void Search(int nlhs, mxArray *plhs[], int nrhs, const mxArray *prhs[])
+{
+  if (nrhs != 4 || nlhs != 2)
+    mexErrMsgTxt("Usage: [distances neighbors] = knn_model_mex('search', "
+        "handle, queryPoints, k).");
+
+  KNNModel& model = Handles::Get(prhs[1]);
+  const int k = (int) mxGetScalar(prhs[3]);
+  if (k <= 0)
+    mexErrMsgTxt("Invalid k; must be greater than 0.");
+
+  const bool hasQueryData = (mxGetNumberOfElements(prhs[2]) != 0);
+  const size_t numQueries = hasQueryData ? mxGetN(prhs[2]) :
+      model.Dataset().n_cols;
+
+  // The distances are written directly into the output.
+  arma::mat distances = OutputMatrix(plhs[0], k, numQueries);
+  arma::Mat<size_t> neighbors;
+  try
+  {
+    if (hasQueryData)
+    {
+      // The query tree reorders the points too.
+      arma::mat queryData = CopyMatrix(prhs[2]);
+      model.Search(std::move(queryData), size_t(k), neighbors, distances);
+    }
+    else
+    {
+      model.Search(size_t(k), neighbors, distances);
+    }
+  }
+  catch (std::exception& e)
+  {
+    mexErrMsgTxt(e.what());
+  }
+
+  plhs[1] = ToMxArray(neighbors);
+}
+
+// the gateway, required by all mex functions
+void mexFunction(int nlhs, mxArray *plhs[],
+                 int nrhs, const mxArray *prhs[])
+{
+  if (nrhs < 1)
+    mexErrMsgTxt("Expecting a command: 'train', 'search', or 'delete'.");
+
+  const string command = GetString(prhs[0]);
+  if (command == "train")
+  {
+    Train(nlhs, plhs, nrhs, prhs);
+  }
+  else if (command == "search")
+  {
+    Search(nlhs, plhs, nrhs, prhs);
+  }
+  else if (command == "delete")
+  {
+    if (nrhs != 2)
+      mexErrMsgTxt("Usage: knn_model_mex('delete', handle).");
+    Handles::Destroy(prhs[1]);
+  }
+  else
+  {
+    mexErrMsgTxt("Unknown command; must be 'train', 'search', or 'delete'.");
+  }
+}
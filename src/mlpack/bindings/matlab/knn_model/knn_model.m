@@ -0,0 +1,57 @@
+function varargout = knn_model(command, varargin)
+%K-Nearest-Neighbor Model
+%
+%  This builds a tree on a set of reference points once, and keeps it in
+%  memory so that it can be searched for the k nearest neighbors of many sets
+%  of query points.  The model must be deleted when it is no longer needed.
+%
+%Usage:
+% model = knn_model('train', referencePoints, 'treeType', 'kd', ...
+%                   'leafSize', 20, 'naive', false, 'singleMode', false);
+% [distances neighbors] = knn_model('search', model, queryPoints, k);
+% knn_model('delete', model);
+%
+%Parameters:
+% referencePoints - the matrix of reference points.  Columns are assumed to
+%                   represent dimensions, with rows representing separate
+%                   points.
+% treeType        - (optional) 'kd', 'cover', 'r', 'r-star', 'ball', 'vp', or
+%                   'spill'.  Default value is 'kd'.
+% leafSize        - (optional) Leaf size in the tree.  Default value is 20.
+% naive           - (optional) Use brute-force search.  Default is false.
+% singleMode      - (optional) Use single-tree search.  Default is false.
+% queryPoints     - the matrix of query points, organized like the reference
+%                   points; [] searches the reference points themselves.
+%
+% Row i of the results corresponds to query point i; column j of neighbors is
+% the index of its j'th nearest neighbor, and column j of distances is the
+% distance to that neighbor.
+
+switch command
+  case 'train'
+    p = inputParser;
+    p.addParamValue('treeType', 'kd', @ischar);
+    p.addParamValue('leafSize', 20, @isscalar);
+    p.addParamValue('naive', false, @(x) (x == true) || (x == false));
+    p.addParamValue('singleMode', false, @(x) (x == true) || (x == false));
+    p.parse(varargin{2:end});
+    parsed = p.Results;
+
+    varargout{1} = knn_model_mex('train', varargin{1}', parsed.treeType, ...
+        parsed.leafSize, parsed.naive, parsed.singleMode);
+
+  case 'search'
+    [distances neighbors] = knn_model_mex('search', varargin{1}, ...
+        varargin{2}', varargin{3});
+
+    varargout{1} = distances';
+    varargout{2} = neighbors' + 1; % matlab indices began at 1, not zero
+
+  case 'delete'
+    knn_model_mex('delete', varargin{1});
+
+  otherwise
+    error('Unknown command ''%s''.', command);
+end
+
+return;
@@ -0,0 +1,177 @@
+/**
+ * @file mex_util.hpp
+ * @author Ryan Curtin
+ *
+ * Utilities shared by the MATLAB bindings: Armadillo matrices that use the
+ * memory of mxArrays directly (instead of copying it element by element), and
+ * handles to models that stay in memory between calls to a MEX function.
+ */
+#ifndef __MLPACK_BINDINGS_MATLAB_MEX_UTIL_HPP
+#define __MLPACK_BINDINGS_MATLAB_MEX_UTIL_HPP
+
+#include "mex.h"
+
+#include <mlpack/core.hpp>
+#include <set>
+#include <stdint.h>
+
+namespace mlpack {
+namespace matlab {
+
+//! Check that the given mxArray is a real, dense matrix of doubles.
+inline void CheckMatrix(const mxArray* array)
+{
+  if (!mxIsDouble(array) || mxIsComplex(array) || mxIsSparse(array))
+    mexErrMsgTxt("Expected a real, dense matrix of doubles.");
+}
+
+/**
+ * Get an Armadillo matrix that uses the memory of the given mxArray, which must
+ * be a real, dense matrix of doubles.  Nothing is copied, so this is only for
+ * methods that take the matrix by const reference; the matrix must not be
+ * modified (MATLAB may share the memory with other variables) or moved (the
+ * memory would move with it).  Use CopyMatrix() for methods that take
+ * ownership of the matrix, such as those that build trees.
+ */
+inline arma::mat AliasMatrix(const mxArray* array)
+{
+  CheckMatrix(array);
+  return arma::mat(mxGetPr(array), mxGetM(array), mxGetN(array), false, true);
+}
+
+/**
+ * Get a copy of the given mxArray, which must be a real, dense matrix of
+ * doubles, for methods that take ownership of (and may modify) the matrix.
+ * Building a tree reorders the points, so this one copy cannot be avoided
+ * there; it is a single copy of the memory.
+ */
+inline arma::mat CopyMatrix(const mxArray* array)
+{
+  CheckMatrix(array);
+  return arma::mat(mxGetPr(array), mxGetM(array), mxGetN(array));
+}
+
+/**
+ * Create a real matrix of doubles of the given size to be returned to MATLAB,
+ * and get an Armadillo matrix that uses its memory, so that results can be
+ * written into it directly.  The Armadillo matrix cannot be resized.
+ */
+inline arma::mat OutputMatrix(mxArray*& array,
+                              const size_t rows,
+                              const size_t cols)
+{
+  array = mxCreateDoubleMatrix(rows, cols, mxREAL);
+  return arma::mat(mxGetPr(array), rows, cols, false, true);
+}
+
+//! Create a column vector of doubles of the given length to be returned to
+//! MATLAB, and get an Armadillo vector that uses its memory.
+inline arma::vec OutputVector(mxArray*& array, const size_t length)
+{
+  array = mxCreateDoubleMatrix(length, 1, mxREAL);
+  return arma::vec(mxGetPr(array), length, false, true);
+}
+
+//! Create a matrix of doubles to be returned to MATLAB that holds the given
+//! matrix (for element types other than double, such as indices).
+template<typename eT>
+mxArray* ToMxArray(const arma::Mat<eT>& matrix)
+{
+  mxArray* array = mxCreateDoubleMatrix(matrix.n_rows, matrix.n_cols, mxREAL);
+  double* out = mxGetPr(array);
+  for (size_t i = 0; i < matrix.n_elem; ++i)
+    out[i] = (double) matrix[i];
+
+  return array;
+}
+
+//! Get the string held by the given mxArray (such as the command given to a
+//! MEX function).
+inline std::string GetString(const mxArray* array)
+{
+  if (!mxIsChar(array))
+    mexErrMsgTxt("Expected a string.");
+
+  char* str = mxArrayToString(array);
+  const std::string result(str);
+  mxFree(str);
+  return result;
+}
+
+/**
+ * Handles to models of type ModelType that stay in memory between calls to a
+ * MEX function, so that (for instance) a tree can be built once and then
+ * searched many times.  A handle is a uint64 scalar holding the address of the
+ * model.  Only the addresses of live models are accepted, so a stale or made-up
+ * handle gives an error instead of a crash.  The MEX file is locked in memory
+ * while any models are alive, so "clear functions" cannot leak them.
+ */
+template<typename ModelType>
+class ModelHandles
+{
+ public:
+  //! Take ownership of the given model, and get a handle to it.
+  static mxArray* Create(ModelType* model)
+  {
+    if (Models().empty())
+    {
+      mexLock();
+      mexAtExit(&Clear);
+    }
+    Models().insert(model);
+
+    mxArray* handle = mxCreateNumericMatrix(1, 1, mxUINT64_CLASS, mxREAL);
+    *((uint64_t*) mxGetData(handle)) = (uint64_t) (uintptr_t) model;
+    return handle;
+  }
+
+  //! Get the model with the given handle.
+  static ModelType& Get(const mxArray* handle) { return *Find(handle); }
+
+  //! Delete the model with the given handle.
+  static void Destroy(const mxArray* handle)
+  {
+    ModelType* model = Find(handle);
+    Models().erase(model);
+    delete model;
+
+    if (Models().empty())
+      mexUnlock();
+  }
+
+ private:
+  //! Get the model with the given handle, or give an error if it is not live.
+  static ModelType* Find(const mxArray* handle)
+  {
+    if (!mxIsUint64(handle) || mxGetNumberOfElements(handle) != 1)
+      mexErrMsgTxt("Expected a model handle.");
+
+    ModelType* model = (ModelType*) (uintptr_t)
+        *((uint64_t*) mxGetData(handle));
+    if (Models().count(model) == 0)
+      mexErrMsgTxt("Invalid model handle (has the model been deleted?).");
+
+    return model;
+  }
+
+  //! The live models.
+  static std::set<ModelType*>& Models()
+  {
+    static std::set<ModelType*> models;
+    return models;
+  }
+
+  //! Delete every live model (when MATLAB exits).
+  static void Clear()
+  {
+    typename std::set<ModelType*>::iterator it;
+    for (it = Models().begin(); it != Models().end(); ++it)
+      delete *it;
+    Models().clear();
+  }
+};
+
+}; // namespace matlab
+}; // namespace mlpack
+
+#endif
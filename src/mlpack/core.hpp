@@ -158,19 +158,25 @@
 #include <mlpack/core/util/arma_traits.hpp>
 #include <mlpack/core/util/log.hpp>
 #include <mlpack/core/util/cli.hpp>
+#include <mlpack/core/util/memory.hpp>
 #include <mlpack/core/util/ostream_extra.hpp>
+#include <mlpack/core/util/parallel.hpp>
 #include <mlpack/core/data/load.hpp>
 #include <mlpack/core/data/save.hpp>
 #include <mlpack/core/data/normalize_labels.hpp>
 #include <mlpack/core/math/clamp.hpp>
+#include <mlpack/core/math/covariance.hpp>
 #include <mlpack/core/math/random.hpp>
 #include <mlpack/core/math/random_basis.hpp>
 #include <mlpack/core/math/lin_alg.hpp>
 #include <mlpack/core/math/range.hpp>
+#include <mlpack/core/math/reducer.hpp>
 #include <mlpack/core/math/round.hpp>
+#include <mlpack/core/dists/diagonal_gaussian_distribution.hpp>
 #include <mlpack/core/dists/discrete_distribution.hpp>
 #include <mlpack/core/dists/gaussian_distribution.hpp>
 #include <mlpack/core/dists/laplace_distribution.hpp>
+#include <mlpack/core/dists/batch_log_probability.hpp>
 
 // Include kernel traits.
 #include <mlpack/core/kernels/kernel_traits.hpp>
@@ -184,6 +190,7 @@
 #include <mlpack/core/kernels/pspectrum_string_kernel.hpp>
 #include <mlpack/core/kernels/spherical_kernel.hpp>
 #include <mlpack/core/kernels/triangular_kernel.hpp>
+#include <mlpack/core/kernels/batch_evaluate.hpp>
 
 // Use Armadillo's C++ version detection.
 #ifdef ARMA_USE_CXX11
@@ -3,11 +3,19 @@
  * @author Ryan Curtin
  *
  * Add a batch constructor for SpMat, if the version is older than 3.810.0, and
- * also a serialize() function for Armadillo.
+ * also a serialize() function and a reorder_cols() function for Armadillo.
  */
 template<typename Archive>
 void serialize(Archive& ar, const unsigned int version);
 
+/*
+ * Reorder the columns in_first, ..., in_first + order.n_elem - 1, so that
+ * column in_first + i holds what column in_first + order[i] held.  This takes
+ * time linear in the number of nonzero elements of those columns, while each
+ * call to swap_cols() may rebuild the whole matrix.
+ */
+inline void reorder_cols(const uword in_first, const Col<uword>& order);
+
 #if ARMA_VERSION_MAJOR == 3 && ARMA_VERSION_MINOR < 810
 template<typename T1, typename T2>
 inline SpMat(
@@ -4,7 +4,7 @@
  *
  * Take the Armadillo batch sparse matrix constructor function from newer
  * Armadillo versions and port it to versions earlier than 3.810.0, and also add
- * a serialization function.
+ * a serialization function and a reorder_cols() function.
  */
 template<typename eT>
 template<typename Archive>
@@ -37,6 +37,49 @@ void SpMat<eT>::serialize(Archive& ar, const unsigned int /* version */)
   ar & make_array(access::rwp(col_ptrs), n_cols + 1);
 }
 
+template<typename eT>
+inline void SpMat<eT>::reorder_cols(const uword in_first,
+                                    const Col<uword>& order)
+  {
+  const uword count = order.n_elem;
+
+  arma_debug_check( (in_first + count > n_cols), "SpMat::reorder_cols(): index out of bounds" );
+
+  #if ARMA_VERSION_MAJOR >= 8
+  // The elements are changed directly, so the element cache must not be used
+  // afterwards.
+  sync_csc();
+  invalidate_cache();
+  #endif
+
+  // The nonzero elements of the columns stay in the same part of the storage;
+  // only their order changes.
+  const uword start = col_ptrs[in_first];
+  const uword length = col_ptrs[in_first + count] - start;
+
+  podarray<eT>    new_values(length);
+  podarray<uword> new_row_indices(length);
+  podarray<uword> new_col_ptrs(count);
+
+  uword pos = 0;
+  for (uword i = 0; i < count; ++i)
+    {
+    const uword col = in_first + order[i];
+    arma_debug_check( (order[i] >= count), "SpMat::reorder_cols(): invalid column order" );
+
+    new_col_ptrs[i] = start + pos;
+    for (uword j = col_ptrs[col]; j < col_ptrs[col + 1]; ++j, ++pos)
+      {
+      new_values[pos]      = values[j];
+      new_row_indices[pos] = row_indices[j];
+      }
+    }
+
+  arrayops::copy(access::rwp(values) + start, new_values.memptr(), length);
+  arrayops::copy(access::rwp(row_indices) + start, new_row_indices.memptr(), length);
+  arrayops::copy(access::rwp(col_ptrs) + in_first, new_col_ptrs.memptr(), count);
+  }
+
 #if ARMA_VERSION_MAJOR == 3 && ARMA_VERSION_MINOR < 810
 
 //! Insert a large number of values at once.
@@ -0,0 +1,147 @@
+/**
+ * @file k_fold_cv.hpp
+ * @author Ryan Curtin
+ *
+ * Definition of the KFoldCV class, which runs k-fold cross-validation of any
+ * learner, over a grid of parameters, with the folds and grid points in
+ * parallel.
+ */
+#ifndef __MLPACK_CORE_CV_K_FOLD_CV_HPP
+#define __MLPACK_CORE_CV_K_FOLD_CV_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace cv /** Cross-validation. */ {
+
+/**
+ * K-fold cross-validation over a dense dataset and its responses (labels for
+ * a classifier, or targets for a regressor).  The points are shuffled once and
+ * split into k folds of nearly equal size; for each fold, the learner is
+ * trained on the other k - 1 folds and evaluated on the fold.
+ *
+ * The folds are not copied.  The shuffled dataset is stored twice in a row, so
+ * that the training set of every fold (which wraps around the end of the
+ * dataset) is a contiguous block of columns.  The training and test sets given
+ * to the learner are then matrices that alias that memory, and the whole
+ * cross-validation takes the memory of two copies of the dataset, however many
+ * folds are run at the same time.
+ *
+ * Evaluate() trains and evaluates the learner for every combination of a fold
+ * and a point of a parameter grid, in parallel (see parallel::For()).  Any
+ * learner can be used: the given function trains it on the training set with
+ * the given parameter and returns its score on the test set.  The parallel
+ * loops of the learner itself run serially, since they are nested in the loop
+ * over the folds.
+ *
+ * @code
+ * KFoldCV<> cv(data, labels, 10);
+ * std::vector<double> lambdas = { 0.0, 0.01, 0.1, 1.0 };
+ * arma::mat scores = cv.Evaluate(lambdas, [](const double lambda,
+ *     const arma::mat& trainData, const arma::Row<size_t>& trainLabels,
+ *     const arma::mat& testData, const arma::Row<size_t>& testLabels)
+ * {
+ *   LogisticRegression<> lr(trainData, trainLabels, lambda);
+ *   return lr.ComputeAccuracy(testData, testLabels);
+ * });
+ * const double bestLambda = lambdas[KFoldCV<>::Best(scores)];
+ * @endcode
+ *
+ * @tparam MatType Type of the dataset (a dense matrix).
+ * @tparam ResponsesType Type of the responses (a row or column vector).
+ */
+template<typename MatType = arma::mat,
+         typename ResponsesType = arma::Row<size_t>>
+class KFoldCV
+{
+ public:
+  /**
+   * Split the given dataset and responses into k folds.  The dataset and the
+   * responses are copied (once), so they may be destroyed afterwards.
+   *
+   * @param data Dataset, with one point per column.
+   * @param responses Responses, one for each point.
+   * @param k Number of folds; this must be at least 2, and at most the number
+   *     of points.
+   * @param shuffle If false, the points are not shuffled, and fold i holds the
+   *     i'th block of consecutive points.
+   */
+  KFoldCV(const MatType& data,
+          const ResponsesType& responses,
+          const size_t k,
+          const bool shuffle = true);
+
+  //! Get the number of folds.
+  size_t K() const { return k; }
+
+  //! Get the number of points.
+  size_t NumPoints() const { return numPoints; }
+
+  //! Get the index (in the original dataset) of the i'th shuffled point; fold
+  //! f holds the shuffled points in [TestBegin(f), TestBegin(f + 1)).
+  size_t Index(const size_t i) const { return order[i]; }
+
+  //! Get the first shuffled point of the given fold.
+  size_t TestBegin(const size_t fold) const { return fold * numPoints / k; }
+
+  /**
+   * Call f(trainData, trainResponses, testData, testResponses) with the
+   * training and test sets of the given fold.  These alias the memory of this
+   * object, so they are only valid during the call, and must not be modified.
+   *
+   * @param fold Index of the fold.
+   * @param f Function to call.
+   */
+  template<typename FunctionType>
+  void Fold(const size_t fold, FunctionType f) const;
+
+  /**
+   * Train and evaluate the learner for every fold and every point of the given
+   * grid: scores(i, j) is the score returned by
+   *
+   * @code
+   * f(grid[i], trainData, trainResponses, testData, testResponses)
+   * @endcode
+   *
+   * for fold j.  The combinations are run in parallel, with each thread taking
+   * one combination at a time, so f must not modify anything that the other
+   * calls use.
+   *
+   * @param grid Parameters to evaluate the learner with.
+   * @param f Function that trains the learner and returns its score.
+   * @return Matrix of scores, with one row per parameter and one column per
+   *     fold.
+   */
+  template<typename ParameterType, typename FunctionType>
+  arma::mat Evaluate(const std::vector<ParameterType>& grid,
+                     FunctionType f) const;
+
+  /**
+   * Get the index of the parameter (row) with the highest mean score over the
+   * folds; ties are broken by the lowest index.  To minimize an error, return
+   * the negated error from the function given to Evaluate().
+   *
+   * @param scores Scores returned by Evaluate().
+   */
+  static size_t Best(const arma::mat& scores);
+
+ private:
+  //! The number of folds.
+  size_t k;
+  //! The number of points.
+  size_t numPoints;
+  //! The original index of each shuffled point.
+  arma::uvec order;
+  //! The shuffled dataset, twice in a row.
+  MatType data;
+  //! The shuffled responses, twice in a row.
+  ResponsesType responses;
+};
+
+} // namespace cv
+} // namespace mlpack
+
+// Include implementation.
+#include "k_fold_cv_impl.hpp"
+
+#endif
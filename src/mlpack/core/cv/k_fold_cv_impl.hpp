@@ -0,0 +1,142 @@
+/**
+ * @file k_fold_cv_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the KFoldCV class.
+ */
+#ifndef __MLPACK_CORE_CV_K_FOLD_CV_IMPL_HPP
+#define __MLPACK_CORE_CV_K_FOLD_CV_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "k_fold_cv.hpp"
+
+namespace mlpack {
+namespace cv {
+
+template<typename MatType, typename ResponsesType>
+KFoldCV<MatType, ResponsesType>::KFoldCV(const MatType& data,
+                                         const ResponsesType& responses,
+                                         const size_t k,
+                                         const bool shuffle) :
+    k(k),
+    numPoints(data.n_cols)
+{
+  if (responses.n_elem != data.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "KFoldCV::KFoldCV(): number of responses (" << responses.n_elem
+        << ") does not match number of points (" << data.n_cols << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (k < 2 || k > data.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "KFoldCV::KFoldCV(): number of folds (" << k << ") must be at "
+        << "least 2 and at most the number of points (" << data.n_cols << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Shuffle the points with a Fisher-Yates shuffle.
+  order.set_size(numPoints);
+  for (size_t i = 0; i < numPoints; ++i)
+    order[i] = i;
+  if (shuffle)
+  {
+    for (size_t i = numPoints - 1; i > 0; --i)
+      std::swap(order[i], order[(size_t) math::RandInt((int) i + 1)]);
+  }
+
+  // Store the shuffled points twice, so that the training set of each fold is
+  // contiguous.
+  this->data.set_size(data.n_rows, 2 * numPoints);
+  this->responses.set_size(2 * numPoints);
+  for (size_t i = 0; i < numPoints; ++i)
+  {
+    this->data.col(i) = data.col(order[i]);
+    this->data.col(numPoints + i) = data.col(order[i]);
+    this->responses[i] = responses[order[i]];
+    this->responses[numPoints + i] = responses[order[i]];
+  }
+}
+
+template<typename MatType, typename ResponsesType>
+template<typename FunctionType>
+void KFoldCV<MatType, ResponsesType>::Fold(const size_t fold,
+                                           FunctionType f) const
+{
+  typedef typename MatType::elem_type ElemType;
+  typedef typename ResponsesType::elem_type ResponseType;
+
+  if (fold >= k)
+  {
+    std::ostringstream oss;
+    oss << "KFoldCV::Fold(): fold " << fold << " does not exist (there are "
+        << k << " folds)";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // The test set is the fold itself, and the training set is every point after
+  // it, wrapping around to the points before it.
+  const size_t testBegin = TestBegin(fold);
+  const size_t testEnd = TestBegin(fold + 1);
+  const size_t trainSize = numPoints - (testEnd - testBegin);
+
+  const MatType trainData(const_cast<ElemType*>(data.colptr(testEnd)),
+      data.n_rows, trainSize, false, true);
+  const ResponsesType trainResponses(const_cast<ResponseType*>(
+      responses.memptr() + testEnd), trainSize, false, true);
+  const MatType testData(const_cast<ElemType*>(data.colptr(testBegin)),
+      data.n_rows, testEnd - testBegin, false, true);
+  const ResponsesType testResponses(const_cast<ResponseType*>(
+      responses.memptr() + testBegin), testEnd - testBegin, false, true);
+
+  f(trainData, trainResponses, testData, testResponses);
+}
+
+template<typename MatType, typename ResponsesType>
+template<typename ParameterType, typename FunctionType>
+arma::mat KFoldCV<MatType, ResponsesType>::Evaluate(
+    const std::vector<ParameterType>& grid,
+    FunctionType f) const
+{
+  arma::mat scores(grid.size(), k);
+
+  // Training times differ between parameters, so the threads take one
+  // combination at a time.  Each combination writes only its own score.
+  parallel::For(0, grid.size() * k, [&](const size_t task)
+  {
+    const size_t parameter = task / k;
+    const size_t fold = task % k;
+    Fold(fold, [&](const MatType& trainData,
+                   const ResponsesType& trainResponses,
+                   const MatType& testData,
+                   const ResponsesType& testResponses)
+    {
+      scores(parameter, fold) = f(grid[parameter], trainData, trainResponses,
+          testData, testResponses);
+    });
+  }, 1);
+
+  return scores;
+}
+
+template<typename MatType, typename ResponsesType>
+size_t KFoldCV<MatType, ResponsesType>::Best(const arma::mat& scores)
+{
+  if (scores.n_rows == 0)
+    throw std::invalid_argument("KFoldCV::Best(): no scores given");
+
+  const arma::vec means = arma::mean(scores, 1);
+  size_t best = 0;
+  for (size_t i = 1; i < means.n_elem; ++i)
+    if (means[i] > means[best])
+      best = i;
+
+  return best;
+}
+
+} // namespace cv
+} // namespace mlpack
+
+#endif
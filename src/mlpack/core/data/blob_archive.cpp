@@ -0,0 +1,189 @@
+/**
+ * @file blob_archive.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the boost archives for the blob model format.
+ */
+#include "blob_archive.hpp"
+
+#include <boost/archive/archive_exception.hpp>
+#include <boost/archive/detail/archive_serializer_map.hpp>
+#include <boost/archive/impl/archive_serializer_map.ipp>
+#include <boost/archive/impl/basic_binary_iarchive.ipp>
+#include <boost/archive/impl/basic_binary_iprimitive.ipp>
+#include <boost/archive/impl/basic_binary_oarchive.ipp>
+#include <boost/archive/impl/basic_binary_oprimitive.ipp>
+
+#include <cstring>
+
+using namespace mlpack;
+using namespace mlpack::data;
+
+namespace {
+
+//! The magic string at the start of each blob file.
+const char BlobMagic[16] = "MLPACK_BLOB_001";
+
+//! Throw the archive exception for a corrupt file.
+inline void BlobError()
+{
+  throw boost::archive::archive_exception(
+      boost::archive::archive_exception::input_stream_error);
+}
+
+//! Write zeros to the stream until its position (from start) is aligned.
+inline void Pad(std::ostream& stream, const std::streampos start)
+{
+  static const char zeros[BlobAlignment] = { 0 };
+  const size_t position = (size_t) (stream.tellp() - start);
+  if (position % BlobAlignment != 0)
+    stream.write(zeros, BlobAlignment - (position % BlobAlignment));
+}
+
+} // anonymous namespace
+
+BlobOArchiveBuffer::BlobOArchiveBuffer(std::ostream& stream) :
+    stream(stream),
+    start(stream.tellp())
+{
+  // Leave room for the header, which is written by Finish(); it is padded so
+  // that the first blob is aligned.
+  static const char zeros[BlobAlignment] = { 0 };
+  stream.write(zeros, BlobAlignment);
+  if (start == std::streampos(std::streamoff(-1)) || !stream.good())
+    throw boost::archive::archive_exception(
+        boost::archive::archive_exception::output_stream_error);
+}
+
+unsigned long long BlobOArchiveBuffer::WriteBlob(const void* address,
+                                                 const size_t length)
+{
+  Pad(stream, start);
+
+  BlobEntry entry;
+  entry.offset = (unsigned long long) (stream.tellp() - start);
+  entry.length = length;
+  stream.write((const char*) address, length);
+  if (!stream.good())
+    throw boost::archive::archive_exception(
+        boost::archive::archive_exception::output_stream_error);
+
+  blobs.push_back(entry);
+  return blobs.size() - 1;
+}
+
+void BlobOArchiveBuffer::Finish()
+{
+  BlobHeader header;
+  std::memcpy(header.magic, BlobMagic, sizeof(BlobMagic));
+  header.threshold = BlobOArchive::Threshold;
+
+  const std::string contents = metadata.str();
+  header.metadataOffset = (unsigned long long) (stream.tellp() - start);
+  header.metadataLength = contents.size();
+  stream.write(contents.data(), contents.size());
+
+  header.tableOffset = (unsigned long long) (stream.tellp() - start);
+  header.numBlobs = blobs.size();
+  if (!blobs.empty())
+    stream.write((const char*) &blobs[0], blobs.size() * sizeof(BlobEntry));
+
+  // Go back to write the header, and leave the stream at the end of the file.
+  const std::streampos end = stream.tellp();
+  stream.seekp(start);
+  stream.write((const char*) &header, sizeof(header));
+  stream.seekp(end);
+}
+
+BlobOArchive::BlobOArchive(std::ostream& stream, unsigned int flags) :
+    BlobOArchiveBuffer(stream),
+    Base(metadata, flags)
+{
+  init(flags);
+}
+
+BlobOArchive::~BlobOArchive()
+{
+  // Errors cannot be thrown from a destructor, so a failed write is left for
+  // the caller to find in the state of the stream.
+  Finish();
+}
+
+BlobIArchiveBuffer::BlobIArchiveBuffer(std::istream& stream) :
+    stream(stream),
+    start(stream.tellg())
+{
+  if (!stream.read((char*) &header, sizeof(header)) ||
+      std::memcmp(header.magic, BlobMagic, sizeof(BlobMagic)) != 0)
+  {
+    throw boost::archive::archive_exception(
+        boost::archive::archive_exception::invalid_signature);
+  }
+
+  // Read the blob table, making sure that the file is long enough to hold it
+  // before allocating anything.
+  stream.seekg(0, std::ios::end);
+  const unsigned long long length =
+      (unsigned long long) (stream.tellg() - start);
+  if (header.tableOffset > length || header.metadataOffset > length ||
+      header.metadataLength > length - header.metadataOffset ||
+      header.numBlobs > (length - header.tableOffset) / sizeof(BlobEntry))
+    BlobError();
+
+  blobs.resize(header.numBlobs);
+  stream.seekg(start + std::streamoff(header.tableOffset));
+  if (!blobs.empty() &&
+      !stream.read((char*) &blobs[0], blobs.size() * sizeof(BlobEntry)))
+    BlobError();
+
+  for (size_t i = 0; i < blobs.size(); ++i)
+    if (blobs[i].offset > length || blobs[i].length > length - blobs[i].offset)
+      BlobError();
+
+  std::string contents(header.metadataLength, '\0');
+  stream.seekg(start + std::streamoff(header.metadataOffset));
+  if (!contents.empty() && !stream.read(&contents[0], contents.size()))
+    BlobError();
+  metadata.str(contents);
+}
+
+void BlobIArchiveBuffer::ReadBlob(const unsigned long long index,
+                                  void* address,
+                                  const size_t length)
+{
+  if (index >= blobs.size() || blobs[index].length != length)
+    BlobError();
+
+  stream.seekg(start + std::streamoff(blobs[index].offset));
+  if (!stream.read((char*) address, length))
+    BlobError();
+}
+
+BlobIArchive::BlobIArchive(std::istream& stream, unsigned int flags) :
+    BlobIArchiveBuffer(stream),
+    Base(metadata, flags)
+{
+  init(flags);
+}
+
+// Instantiate the boost archive templates for the blob archives, as the boost
+// library itself does for its own archives.
+namespace boost {
+namespace archive {
+
+template class detail::archive_serializer_map<BlobOArchive>;
+template class basic_binary_oprimitive<BlobOArchive, std::ostream::char_type,
+    std::ostream::traits_type>;
+template class basic_binary_oarchive<BlobOArchive>;
+template class binary_oarchive_impl<BlobOArchive, std::ostream::char_type,
+    std::ostream::traits_type>;
+
+template class detail::archive_serializer_map<BlobIArchive>;
+template class basic_binary_iprimitive<BlobIArchive, std::istream::char_type,
+    std::istream::traits_type>;
+template class basic_binary_iarchive<BlobIArchive>;
+template class binary_iarchive_impl<BlobIArchive, std::istream::char_type,
+    std::istream::traits_type>;
+
+} // namespace archive
+} // namespace boost
@@ -0,0 +1,199 @@
+/**
+ * @file blob_archive.hpp
+ * @author Ryan Curtin
+ *
+ * Boost archives for the blob model format (format::blob), which stores the
+ * contents of large arrays (such as the memory of Armadillo matrices) as
+ * aligned raw blocks, apart from the rest of the model.
+ */
+#ifndef __MLPACK_CORE_DATA_BLOB_ARCHIVE_HPP
+#define __MLPACK_CORE_DATA_BLOB_ARCHIVE_HPP
+
+#include <boost/archive/binary_iarchive_impl.hpp>
+#include <boost/archive/binary_oarchive_impl.hpp>
+#include <boost/archive/detail/register_archive.hpp>
+#include <boost/serialization/array.hpp>
+
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <vector>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * The layout of a blob file.  A file starts with a header, which gives the
+ * location of the metadata and of the blob table.  The blobs follow the header,
+ * each aligned to BlobAlignment bytes; after them come the metadata (a boost
+ * binary archive of everything but the blobs) and then the blob table, which
+ * holds the offset and length (in bytes) of each blob.  All of the numbers are
+ * 64-bit and in the byte order of the machine that saved the file.
+ */
+struct BlobHeader
+{
+  //! The magic string, "MLPACK_BLOB_001" (with its terminator).
+  char magic[16];
+  //! Arrays of at least this many bytes are stored as blobs.
+  unsigned long long threshold;
+  //! The offset of the metadata (from the start of the file).
+  unsigned long long metadataOffset;
+  //! The length of the metadata.
+  unsigned long long metadataLength;
+  //! The offset of the blob table.
+  unsigned long long tableOffset;
+  //! The number of blobs.
+  unsigned long long numBlobs;
+};
+
+//! The alignment of each blob (and the length of the padded header).
+const size_t BlobAlignment = 64;
+
+//! The offset and length of a blob.
+struct BlobEntry
+{
+  unsigned long long offset;
+  unsigned long long length;
+};
+
+/**
+ * Holds the metadata stream of a BlobOArchive, which has to exist before the
+ * boost archive base class is constructed.
+ */
+class BlobOArchiveBuffer
+{
+ protected:
+  //! Start writing the file to the given stream.
+  BlobOArchiveBuffer(std::ostream& stream);
+
+  //! Write the array at address (of length bytes) to the file as a blob, and
+  //! return its index.
+  unsigned long long WriteBlob(const void* address, const size_t length);
+
+  //! Write the metadata, the blob table, and the header.
+  void Finish();
+
+  //! The stream being written to.
+  std::ostream& stream;
+  //! The position of the start of the file in the stream.
+  std::streampos start;
+  //! The metadata, which is written at the end.
+  std::ostringstream metadata;
+  //! The blob table.
+  std::vector<BlobEntry> blobs;
+};
+
+/**
+ * A boost output archive for the blob format.  It is a binary archive, except
+ * that arrays of bitwise serializable values that take at least
+ * BlobOArchive::Threshold bytes (such as the memory of Armadillo matrices) are
+ * written to the file as aligned raw blobs, apart from the rest of the model;
+ * so, loading them back is one read() per array, straight into its memory.
+ * Like the other boost archives, the file is complete once the archive is
+ * destroyed.
+ */
+class BlobOArchive :
+    private BlobOArchiveBuffer,
+    public boost::archive::binary_oarchive_impl<BlobOArchive,
+        std::ostream::char_type, std::ostream::traits_type>
+{
+ public:
+  //! Arrays of at least this many bytes are written as blobs.
+  static const size_t Threshold = 4096;
+
+  //! Start writing the archive to the given stream, which must be seekable.
+  BlobOArchive(std::ostream& stream, unsigned int flags = 0);
+
+  //! Finish writing the archive.
+  ~BlobOArchive();
+
+  //! Write an array, as a blob if it is large enough.
+  template<typename ArrayType>
+  void save_array(const ArrayType& a, unsigned int version)
+  {
+    const size_t length = a.count() * sizeof(*a.address());
+    if (length < Threshold)
+    {
+      Base::save_array(a, version);
+      return;
+    }
+
+    const unsigned long long index = WriteBlob(a.address(), length);
+    this->save_binary(&index, sizeof(index));
+  }
+
+ private:
+  typedef boost::archive::binary_oarchive_impl<BlobOArchive,
+      std::ostream::char_type, std::ostream::traits_type> Base;
+};
+
+/**
+ * Holds the metadata and blob table of a BlobIArchive, which have to be read
+ * before the boost archive base class is constructed.
+ */
+class BlobIArchiveBuffer
+{
+ protected:
+  //! Read the header, metadata, and blob table of the file in the stream.
+  BlobIArchiveBuffer(std::istream& stream);
+
+  //! Read the blob with the given index (of length bytes) into address.
+  void ReadBlob(const unsigned long long index,
+                void* address,
+                const size_t length);
+
+  //! The stream being read from.
+  std::istream& stream;
+  //! The position of the start of the file in the stream.
+  std::streampos start;
+  //! The header of the file.
+  BlobHeader header;
+  //! The metadata.
+  std::istringstream metadata;
+  //! The blob table.
+  std::vector<BlobEntry> blobs;
+};
+
+/**
+ * A boost input archive for the blob format; see BlobOArchive.  An
+ * archive_exception is thrown if the file is not a blob file or is corrupt.
+ */
+class BlobIArchive :
+    private BlobIArchiveBuffer,
+    public boost::archive::binary_iarchive_impl<BlobIArchive,
+        std::istream::char_type, std::istream::traits_type>
+{
+ public:
+  //! Start reading the archive from the given stream, which must be seekable.
+  BlobIArchive(std::istream& stream, unsigned int flags = 0);
+
+  //! Read an array, from its blob if it is large enough.
+  template<typename ArrayType>
+  void load_array(ArrayType& a, unsigned int version)
+  {
+    const size_t length = a.count() * sizeof(*a.address());
+    if (length < header.threshold)
+    {
+      Base::load_array(a, version);
+      return;
+    }
+
+    unsigned long long index;
+    this->load_binary(&index, sizeof(index));
+    ReadBlob(index, a.address(), length);
+  }
+
+ private:
+  typedef boost::archive::binary_iarchive_impl<BlobIArchive,
+      std::istream::char_type, std::istream::traits_type> Base;
+};
+
+} // namespace data
+} // namespace mlpack
+
+BOOST_SERIALIZATION_REGISTER_ARCHIVE(mlpack::data::BlobOArchive);
+BOOST_SERIALIZATION_USE_ARRAY_OPTIMIZATION(mlpack::data::BlobOArchive);
+BOOST_SERIALIZATION_REGISTER_ARCHIVE(mlpack::data::BlobIArchive);
+BOOST_SERIALIZATION_USE_ARRAY_OPTIMIZATION(mlpack::data::BlobIArchive);
+
+#endif
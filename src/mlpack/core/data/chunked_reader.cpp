@@ -0,0 +1,377 @@
+/**
+ * @file chunked_reader.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of ChunkedReader, which reads datasets in chunks of points.
+ */
+#include "chunked_reader.hpp"
+#include "extension.hpp"
+#include "compressed_file.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef ARMA_USE_HDF5
+  #include <hdf5.h>
+#endif
+
+using namespace mlpack;
+using namespace mlpack::data;
+
+namespace {
+
+//! Skip the separators (spaces, tabs, commas, and carriage returns) at p.
+inline const char* SkipSeparators(const char* p)
+{
+  while (*p == ' ' || *p == '\t' || *p == ',' || *p == '\r')
+    ++p;
+  return p;
+}
+
+//! Return whether or not a line holds no values.
+inline bool BlankLine(const std::string& line)
+{
+  return *SkipSeparators(line.c_str()) == '\0';
+}
+
+} // anonymous namespace
+
+ChunkedReader::ChunkedReader(const std::string& filename,
+                             const size_t chunkSize,
+                             const bool prefetch) :
+    filename(filename),
+    binary(false),
+    hdf5(false),
+    prefetch(prefetch),
+    dimensionality(0),
+    numPoints(0),
+    chunkSize(chunkSize),
+    pointsRead(0)
+{
+  if (chunkSize == 0)
+    throw std::invalid_argument("ChunkedReader: chunk size must be positive");
+
+  if (IsCompressed(filename))
+    throw std::runtime_error("ChunkedReader: '" + filename + "' is compressed, "
+        "so it cannot be read in chunks");
+
+  const std::string extension = Extension(filename);
+  if (extension == "bin")
+    binary = true;
+  else if (extension == "h5" || extension == "hdf5" || extension == "hdf" ||
+      extension == "he5")
+    hdf5 = true;
+  else if (extension != "csv" && extension != "txt" && extension != "tsv")
+    throw std::runtime_error("ChunkedReader: '" + filename + "' is not a "
+        "supported file type (use .bin, .csv, .txt, .tsv, or .h5)");
+
+  if (hdf5)
+  {
+    OpenHDF5();
+  }
+  else
+  {
+    stream.open(filename.c_str(), binary ? (std::ios::in | std::ios::binary) :
+        std::ios::in);
+    if (!stream.is_open())
+      throw std::runtime_error("ChunkedReader: cannot open '" + filename + "'");
+
+    if (binary)
+    {
+      // The header is "ARMA_MAT_BIN_FN008\n<rows> <cols>\n" for a matrix of
+      // doubles.
+      std::string magic;
+      bool valid = (bool) (stream >> magic >> dimensionality >> numPoints) &&
+          (magic == "ARMA_MAT_BIN_FN008");
+
+      // Skip the single whitespace character after the number of columns.
+      if (valid)
+      {
+        stream.get();
+        dataStart = stream.tellg();
+
+        stream.seekg(0, std::ios::end);
+        const size_t length = (size_t) (stream.tellg() - dataStart);
+        valid = (length >= dimensionality * numPoints * sizeof(double));
+        stream.seekg(dataStart);
+      }
+
+      if (!valid)
+        throw std::runtime_error("ChunkedReader: '" + filename + "' is not an "
+            "arma_binary file holding a matrix of doubles");
+    }
+    else
+    {
+      // Count the points, and take the dimensionality from the first one.  This
+      // is one quick pass over the file, without any parsing.
+      dataStart = stream.tellg();
+      std::string line;
+      while (std::getline(stream, line))
+      {
+        if (BlankLine(line))
+          continue;
+
+        if (numPoints == 0)
+        {
+          const char* p = SkipSeparators(line.c_str());
+          while (*p != '\0')
+          {
+            char* end;
+            std::strtod(p, &end);
+            if (end == p)
+              throw std::runtime_error("ChunkedReader: cannot parse the first "
+                  "point of '" + filename + "'");
+
+            ++dimensionality;
+            p = SkipSeparators(end);
+          }
+        }
+
+        ++numPoints;
+      }
+
+      stream.clear();
+      stream.seekg(dataStart);
+    }
+  }
+
+  Log::Info << "ChunkedReader: '" << filename << "' holds " << numPoints
+      << " points of dimensionality " << dimensionality << ".\n";
+
+  StartRead();
+}
+
+ChunkedReader::~ChunkedReader()
+{
+  // Don't let an exception from the read escape the destructor.  A read that
+  // was not prefetched hasn't started, and never has to.
+  if (prefetch && pending.valid())
+    pending.wait();
+}
+
+bool ChunkedReader::NextChunk(arma::mat& chunk)
+{
+  // If there is no read in progress, the pass is over.
+  if (!pending.valid())
+    return false;
+
+  // Wait for the read in progress; get() throws if the read threw.
+  pending.get();
+
+  if (buffer.n_cols == 0)
+    return false;
+
+  chunk.swap(buffer);
+  StartRead();
+  return true;
+}
+
+void ChunkedReader::Reset()
+{
+  if (prefetch && pending.valid())
+    pending.wait();
+
+  if (!hdf5)
+  {
+    stream.clear();
+    stream.seekg(dataStart);
+  }
+  pointsRead = 0;
+  StartRead();
+}
+
+void ChunkedReader::StartRead()
+{
+  // Without prefetching, the read is deferred until NextChunk() asks for it.
+  pending = std::async(prefetch ? std::launch::async : std::launch::deferred,
+      &ChunkedReader::ReadChunk, this);
+}
+
+void ChunkedReader::ReadChunk()
+{
+  const size_t count = std::min(chunkSize, numPoints - pointsRead);
+  buffer.set_size(dimensionality, count);
+
+  if (hdf5)
+  {
+    if (count > 0)
+      ReadHDF5(pointsRead, count);
+  }
+  else if (binary)
+  {
+    stream.read((char*) buffer.memptr(), count * dimensionality *
+        sizeof(double));
+    if ((size_t) stream.gcount() != count * dimensionality * sizeof(double))
+      throw std::runtime_error("ChunkedReader: unexpected end of '" + filename
+          + "'");
+  }
+  else
+  {
+    std::string line;
+    size_t col = 0;
+    while (col < count && std::getline(stream, line))
+    {
+      if (BlankLine(line))
+        continue;
+
+      ParseLine(line, col++);
+    }
+
+    if (col != count)
+      throw std::runtime_error("ChunkedReader: unexpected end of '" + filename
+          + "'");
+  }
+
+  pointsRead += count;
+}
+
+void ChunkedReader::ParseLine(const std::string& line, const size_t col)
+{
+  const char* p = SkipSeparators(line.c_str());
+  size_t row = 0;
+  while (*p != '\0')
+  {
+    char* end;
+    const double value = std::strtod(p, &end);
+    if (end == p || row == dimensionality)
+      break;
+
+    buffer(row++, col) = value;
+    p = SkipSeparators(end);
+  }
+
+  if (row != dimensionality || *p != '\0')
+  {
+    std::ostringstream oss;
+    oss << "ChunkedReader: point " << pointsRead + col << " of '" << filename
+        << "' does not hold " << dimensionality << " numeric values";
+    throw std::runtime_error(oss.str());
+  }
+}
+
+#ifdef ARMA_USE_HDF5
+
+namespace {
+
+//! Open the dataset of an HDF5 file, as Armadillo names it.
+hid_t OpenDataset(const hid_t file)
+{
+  // Don't let HDF5 print errors for the names that aren't there.
+  H5E_auto2_t oldHandler;
+  void* oldData;
+  H5Eget_auto2(H5E_DEFAULT, &oldHandler, &oldData);
+  H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+
+  hid_t dataset = H5Dopen2(file, "dataset", H5P_DEFAULT);
+  if (dataset < 0)
+    dataset = H5Dopen2(file, "value", H5P_DEFAULT);
+
+  H5Eset_auto2(H5E_DEFAULT, oldHandler, oldData);
+  return dataset;
+}
+
+} // anonymous namespace
+
+void ChunkedReader::OpenHDF5()
+{
+  const hid_t file = H5Fopen(filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  if (file < 0)
+    throw std::runtime_error("ChunkedReader: cannot open '" + filename + "'");
+
+  const hid_t dataset = OpenDataset(file);
+  if (dataset < 0)
+  {
+    H5Fclose(file);
+    throw std::runtime_error("ChunkedReader: '" + filename + "' holds no "
+        "dataset named 'dataset' or 'value'");
+  }
+
+  // Armadillo stores an n_rows x n_cols matrix with the dimensions
+  // { n_cols, n_rows }; the points are the rows of that matrix, so the first
+  // dimension is the dimensionality of the points.
+  const hid_t space = H5Dget_space(dataset);
+  const int rank = H5Sget_simple_extent_ndims(space);
+  hsize_t dims[2] = { 1, 1 };
+  if (rank == 1 || rank == 2)
+    H5Sget_simple_extent_dims(space, dims, NULL);
+
+  H5Sclose(space);
+  H5Dclose(dataset);
+  H5Fclose(file);
+
+  if (rank == 1)
+  {
+    // A vector is a column; so each element is a point.
+    dimensionality = 1;
+    numPoints = (size_t) dims[0];
+  }
+  else if (rank == 2)
+  {
+    dimensionality = (size_t) dims[0];
+    numPoints = (size_t) dims[1];
+  }
+  else
+  {
+    throw std::runtime_error("ChunkedReader: the dataset of '" + filename +
+        "' is not a matrix");
+  }
+}
+
+void ChunkedReader::ReadHDF5(const size_t begin, const size_t count)
+{
+  // The file is opened for each chunk, so that no HDF5 handles have to be kept
+  // between chunks; this is cheap next to reading a chunk.
+  const hid_t file = H5Fopen(filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  if (file < 0)
+    throw std::runtime_error("ChunkedReader: cannot open '" + filename + "'");
+
+  const hid_t dataset = OpenDataset(file);
+  const hid_t fileSpace = H5Dget_space(dataset);
+  const int rank = H5Sget_simple_extent_ndims(fileSpace);
+
+  // Select the columns [begin, begin + count) of the dataset.
+  hsize_t start[2] = { 0, (hsize_t) begin };
+  hsize_t counts[2] = { (hsize_t) dimensionality, (hsize_t) count };
+  if (rank == 1)
+  {
+    start[0] = (hsize_t) begin;
+    counts[0] = (hsize_t) count;
+  }
+
+  H5Sselect_hyperslab(fileSpace, H5S_SELECT_SET, start, NULL, counts, NULL);
+  const hid_t memSpace = H5Screate_simple(rank, counts, NULL);
+
+  // The selection is read in row-major order, which makes it the transpose of
+  // the chunk.
+  arma::mat transposed(count, dimensionality);
+  const herr_t status = H5Dread(dataset, H5T_NATIVE_DOUBLE, memSpace,
+      fileSpace, H5P_DEFAULT, transposed.memptr());
+
+  H5Sclose(memSpace);
+  H5Sclose(fileSpace);
+  H5Dclose(dataset);
+  H5Fclose(file);
+
+  if (status < 0)
+    throw std::runtime_error("ChunkedReader: cannot read '" + filename + "'");
+
+  buffer = arma::trans(transposed);
+}
+
+#else
+
+void ChunkedReader::OpenHDF5()
+{
+  throw std::runtime_error("ChunkedReader: cannot read '" + filename + "' "
+      "because Armadillo was compiled without HDF5 support");
+}
+
+void ChunkedReader::ReadHDF5(const size_t /* begin */,
+                             const size_t /* count */)
+{
+  // OpenHDF5() will already have thrown.
+}
+
+#endif
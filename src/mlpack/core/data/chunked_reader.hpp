@@ -0,0 +1,146 @@
+/**
+ * @file chunked_reader.hpp
+ * @author Ryan Curtin
+ *
+ * Read a dataset from disk in chunks of points, so that it never has to fit in
+ * memory all at once.
+ */
+#ifndef __MLPACK_CORE_DATA_CHUNKED_READER_HPP
+#define __MLPACK_CORE_DATA_CHUNKED_READER_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <fstream>
+#include <future>
+#include <string>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * A ChunkedReader reads a dataset one chunk of points at a time, for
+ * algorithms that make passes over datasets too large to load.  Each chunk is
+ * an arma::mat with one point per column and at most ChunkSize() columns.
+ * By default, while the caller works on one chunk, the next chunk is read in
+ * the background, so that I/O and computation overlap; this prefetching can be
+ * turned off, in which case each chunk is read when it is asked for.
+ *
+ * Three kinds of files are supported, chosen by extension:
+ *
+ *  - '.bin' files in Armadillo binary format (arma_binary, holding doubles).
+ *    Like MappedMatrix, the matrix is not transposed, so the file must hold
+ *    one point per column; this is what arma::Mat::save() or data::Save() with
+ *    transpose = false will write.
+ *  - '.csv', '.txt', and '.tsv' text files with one point per line (which is
+ *    what data::Load() expects by default), with values separated by commas,
+ *    spaces, or tabs.
+ *  - '.h5', '.hdf5', '.hdf', and '.he5' files in HDF5 format, holding a
+ *    dataset named 'dataset' or 'value' (as Armadillo writes them).  As with
+ *    text files, and as data::Load() expects, the file holds one point per row
+ *    of the Armadillo matrix it was saved from (which is what data::Save()
+ *    writes by default).  Only one chunk of the file is read at a time (with a
+ *    hyperslab selection).  This is only available if Armadillo was compiled
+ *    with HDF5 support, and the HDF5 library must be thread-safe if several
+ *    readers are used from different threads at once.
+ *
+ * @code
+ * ChunkedReader reader("dataset.bin", 100000);
+ * arma::mat chunk;
+ * while (reader.NextChunk(chunk))
+ * {
+ *   // Use the points in chunk...
+ * }
+ * reader.Reset(); // Start another pass.
+ * @endcode
+ */
+class ChunkedReader
+{
+ public:
+  /**
+   * Open the given file and start reading the first chunk.  A
+   * std::runtime_error is thrown if the file cannot be opened or is not in a
+   * supported format, and a std::invalid_argument if chunkSize is 0.
+   *
+   * @param filename Name of the file to read.
+   * @param chunkSize Maximum number of points in each chunk.
+   * @param prefetch If true, each chunk is read in the background while the
+   *      previous one is used.
+   */
+  ChunkedReader(const std::string& filename,
+                const size_t chunkSize,
+                const bool prefetch = true);
+
+  //! Wait for any read in progress and close the file.
+  ~ChunkedReader();
+
+  /**
+   * Get the next chunk of points.  If a parse error happened while the chunk
+   * was read, a std::runtime_error is thrown.
+   *
+   * @param chunk Matrix to store the chunk in.
+   * @return false if there are no points left in this pass.
+   */
+  bool NextChunk(arma::mat& chunk);
+
+  //! Go back to the first point of the dataset, to start a new pass.
+  void Reset();
+
+  //! Get the dimensionality of the points.
+  size_t Dimensionality() const { return dimensionality; }
+  //! Get the number of points in the dataset.
+  size_t NumPoints() const { return numPoints; }
+  //! Get the maximum number of points in each chunk.
+  size_t ChunkSize() const { return chunkSize; }
+  //! Get the name of the file.
+  const std::string& Filename() const { return filename; }
+  //! Get whether or not chunks are read in the background.
+  bool Prefetch() const { return prefetch; }
+
+ private:
+  // Readers cannot be copied.
+  ChunkedReader(const ChunkedReader& other);
+  ChunkedReader& operator=(const ChunkedReader& other);
+
+  //! Start reading the next chunk into the buffer, in the background.
+  void StartRead();
+  //! Read the next chunk into the buffer.
+  void ReadChunk();
+  //! Parse one line of a text file into the given column of the buffer.
+  void ParseLine(const std::string& line, const size_t col);
+  //! Read the dimensions of an HDF5 file.
+  void OpenHDF5();
+  //! Read the given points of an HDF5 file into the buffer.
+  void ReadHDF5(const size_t begin, const size_t count);
+
+  //! The name of the file.
+  std::string filename;
+  //! Whether the file is in arma_binary format (otherwise it is text).
+  bool binary;
+  //! Whether the file is in HDF5 format.
+  bool hdf5;
+  //! Whether chunks are read in the background.
+  bool prefetch;
+  //! The open file.
+  std::ifstream stream;
+  //! The position of the first point in the file.
+  std::streampos dataStart;
+
+  //! The dimensionality of the points.
+  size_t dimensionality;
+  //! The number of points in the dataset.
+  size_t numPoints;
+  //! The maximum number of points in each chunk.
+  size_t chunkSize;
+  //! The number of points read from the file in this pass.
+  size_t pointsRead;
+
+  //! The chunk being read in the background.
+  arma::mat buffer;
+  //! The read in progress.
+  std::future<void> pending;
+};
+
+} // namespace data
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,354 @@
+/**
+ * @file compressed_file.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of compressed file support for data::Load() and data::Save().
+ */
+#include "compressed_file.hpp"
+#include "extension.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef MLPACK_USE_ZLIB
+  #include <zlib.h>
+#endif
+
+#ifdef MLPACK_USE_ZSTD
+  #include <zstd.h>
+#endif
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+using namespace mlpack;
+using namespace mlpack::data;
+
+bool mlpack::data::IsCompressed(const std::string& filename)
+{
+  const std::string extension = Extension(filename);
+  return (extension == "gz" || extension == "zst");
+}
+
+std::string mlpack::data::StripCompression(const std::string& filename)
+{
+  if (!IsCompressed(filename))
+    return filename;
+
+  return filename.substr(0, filename.rfind('.'));
+}
+
+namespace {
+
+//! Make sure there is room for at least count more bytes after used.
+inline void Reserve(std::vector<char>& contents,
+                    const size_t used,
+                    const size_t count)
+{
+  if (contents.size() - used < count)
+    contents.resize(std::max(2 * contents.size(), used + count));
+}
+
+} // anonymous namespace
+
+void mlpack::data::Decompress(const std::string& filename,
+                              std::vector<char>& contents)
+{
+  const std::string extension = Extension(filename);
+  size_t used = 0;
+  contents.clear();
+
+  if (extension == "gz")
+  {
+#ifdef MLPACK_USE_ZLIB
+    gzFile file = gzopen(filename.c_str(), "rb");
+    if (file == NULL)
+      throw std::runtime_error("cannot open '" + filename + "': " +
+          std::strerror(errno));
+
+    // gzread() carries on through concatenated gzip members.
+    const size_t chunkSize = 1 << 20;
+    int read;
+    do
+    {
+      Reserve(contents, used, chunkSize);
+      read = gzread(file, contents.data() + used, (unsigned) chunkSize);
+      if (read < 0)
+      {
+        int error;
+        const std::string message = gzerror(file, &error);
+        gzclose(file);
+        throw std::runtime_error("cannot decompress '" + filename + "': " +
+            message);
+      }
+
+      used += (size_t) read;
+    } while (read > 0);
+
+    gzclose(file);
+#else
+    throw std::runtime_error("cannot decompress '" + filename + "': mlpack "
+        "was compiled without zlib");
+#endif
+  }
+  else if (extension == "zst")
+  {
+#ifdef MLPACK_USE_ZSTD
+    std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!file.is_open())
+      throw std::runtime_error("cannot open '" + filename + "': " +
+          std::strerror(errno));
+
+    ZSTD_DStream* stream = ZSTD_createDStream();
+    ZSTD_initDStream(stream);
+
+    // The stream carries on through concatenated frames; the last return value
+    // of ZSTD_decompressStream() is zero only at the end of a frame.
+    std::vector<char> in(ZSTD_DStreamInSize());
+    const size_t outSize = ZSTD_DStreamOutSize();
+    size_t result = 0;
+    while (file.read(in.data(), in.size()) || file.gcount() > 0)
+    {
+      ZSTD_inBuffer input = { in.data(), (size_t) file.gcount(), 0 };
+      ZSTD_outBuffer output;
+      do
+      {
+        Reserve(contents, used, outSize);
+        output.dst = contents.data() + used;
+        output.size = contents.size() - used;
+        output.pos = 0;
+
+        result = ZSTD_decompressStream(stream, &output, &input);
+        if (ZSTD_isError(result))
+        {
+          ZSTD_freeDStream(stream);
+          throw std::runtime_error("cannot decompress '" + filename + "': " +
+              ZSTD_getErrorName(result));
+        }
+
+        used += output.pos;
+      } while (input.pos < input.size || output.pos == output.size);
+    }
+
+    ZSTD_freeDStream(stream);
+    if (result != 0)
+      throw std::runtime_error("cannot decompress '" + filename + "': the "
+          "file is truncated");
+#else
+    throw std::runtime_error("cannot decompress '" + filename + "': mlpack "
+        "was compiled without libzstd");
+#endif
+  }
+  else
+  {
+    throw std::runtime_error("'" + filename + "' is not compressed");
+  }
+
+  contents.resize(used);
+}
+
+void mlpack::data::Compress(const std::string& filename,
+                            const char* data,
+                            const size_t length)
+{
+  const std::string extension = Extension(filename);
+
+  if (extension == "gz")
+  {
+#ifdef MLPACK_USE_ZLIB
+    gzFile file = gzopen(filename.c_str(), "wb");
+    if (file == NULL)
+      throw std::runtime_error("cannot open '" + filename + "' for writing: " +
+          std::strerror(errno));
+
+    // gzwrite() takes an unsigned length, so write in chunks.
+    const size_t chunkSize = 1 << 30;
+    for (size_t written = 0; written < length; )
+    {
+      const size_t count = std::min(chunkSize, length - written);
+      if (gzwrite(file, data + written, (unsigned) count) != (int) count)
+      {
+        int error;
+        const std::string message = gzerror(file, &error);
+        gzclose(file);
+        throw std::runtime_error("cannot compress to '" + filename + "': " +
+            message);
+      }
+
+      written += count;
+    }
+
+    if (gzclose(file) != Z_OK)
+      throw std::runtime_error("cannot write '" + filename + "'");
+#else
+    throw std::runtime_error("cannot compress to '" + filename + "': mlpack "
+        "was compiled without zlib");
+#endif
+  }
+  else if (extension == "zst")
+  {
+#ifdef MLPACK_USE_ZSTD
+    std::ofstream file(filename.c_str(), std::ios::out | std::ios::binary);
+    if (!file.is_open())
+      throw std::runtime_error("cannot open '" + filename + "' for writing: " +
+          std::strerror(errno));
+
+  #if ZSTD_VERSION_NUMBER >= 10400
+    ZSTD_CCtx* context = ZSTD_createCCtx();
+    ZSTD_CCtx_setPledgedSrcSize(context, length);
+    #ifdef _OPENMP
+    // This fails (and compression stays single-threaded) if libzstd was built
+    // without multithreading.
+    if (omp_get_max_threads() > 1)
+      ZSTD_CCtx_setParameter(context, ZSTD_c_nbWorkers, omp_get_max_threads());
+    #endif
+
+    std::vector<char> out(ZSTD_CStreamOutSize());
+    ZSTD_inBuffer input = { data, length, 0 };
+    size_t remaining;
+    do
+    {
+      ZSTD_outBuffer output = { out.data(), out.size(), 0 };
+      remaining = ZSTD_compressStream2(context, &output, &input, ZSTD_e_end);
+      if (ZSTD_isError(remaining))
+      {
+        ZSTD_freeCCtx(context);
+        throw std::runtime_error("cannot compress to '" + filename + "': " +
+            ZSTD_getErrorName(remaining));
+      }
+
+      file.write(out.data(), output.pos);
+    } while (remaining != 0);
+
+    ZSTD_freeCCtx(context);
+  #else
+    std::vector<char> out(ZSTD_compressBound(length));
+    const size_t size = ZSTD_compress(out.data(), out.size(), data, length, 3);
+    if (ZSTD_isError(size))
+      throw std::runtime_error("cannot compress to '" + filename + "': " +
+          ZSTD_getErrorName(size));
+
+    file.write(out.data(), size);
+  #endif
+
+    file.close();
+    if (file.fail())
+      throw std::runtime_error("cannot write '" + filename + "'");
+#else
+    throw std::runtime_error("cannot compress to '" + filename + "': mlpack "
+        "was compiled without libzstd");
+#endif
+  }
+  else
+  {
+    throw std::runtime_error("'" + filename + "' is not a compressed file");
+  }
+}
+
+void MemoryStreamBuffer::Reset(const char* begin, const char* end)
+{
+  // The buffer is only ever read, so the const_cast is safe.
+  setg(const_cast<char*>(begin), const_cast<char*>(begin),
+      const_cast<char*>(end));
+}
+
+std::streampos MemoryStreamBuffer::seekoff(std::streamoff offset,
+                                           std::ios_base::seekdir direction,
+                                           std::ios_base::openmode which)
+{
+  if (!(which & std::ios_base::in))
+    return std::streampos(std::streamoff(-1));
+
+  char* target;
+  if (direction == std::ios_base::beg)
+    target = eback() + offset;
+  else if (direction == std::ios_base::cur)
+    target = gptr() + offset;
+  else
+    target = egptr() + offset;
+
+  if (target < eback() || target > egptr())
+    return std::streampos(std::streamoff(-1));
+
+  setg(eback(), target, egptr());
+  return std::streampos(target - eback());
+}
+
+std::streampos MemoryStreamBuffer::seekpos(std::streampos position,
+                                           std::ios_base::openmode which)
+{
+  return seekoff(std::streamoff(position), std::ios_base::beg, which);
+}
+
+InputFile::InputFile(const std::string& filename, const bool binary) :
+    compressed(IsCompressed(filename)),
+    open(false),
+    memoryStream(&buffer),
+    stream(&file)
+{
+  if (compressed)
+  {
+    try
+    {
+      Decompress(filename, contents);
+    }
+    catch (std::runtime_error& e)
+    {
+      error = e.what();
+      return;
+    }
+
+    buffer.Reset(contents.data(), contents.data() + contents.size());
+    stream = &memoryStream;
+    open = true;
+  }
+  else
+  {
+    file.open(filename.c_str(), binary ? (std::ios::in | std::ios::binary) :
+        std::ios::in);
+    open = file.is_open();
+    if (!open)
+      error = std::strerror(errno);
+  }
+}
+
+OutputFile::OutputFile(const std::string& filename, const bool binary) :
+    filename(filename),
+    compressed(IsCompressed(filename)),
+    open(false)
+{
+  file.open(filename.c_str(), binary ? (std::ios::out | std::ios::binary) :
+      std::ios::out);
+  open = file.is_open();
+
+  // A compressed file is written all at once by Close(); opening it now just
+  // makes sure that it can be written.
+  if (compressed)
+    file.close();
+}
+
+std::ostream& OutputFile::Stream()
+{
+  if (compressed)
+    return memory;
+  else
+    return file;
+}
+
+void OutputFile::Close()
+{
+  if (compressed)
+  {
+    const std::string contents = memory.str();
+    Compress(filename, contents.data(), contents.size());
+  }
+  else
+  {
+    file.close();
+    if (file.fail())
+      throw std::runtime_error("cannot write '" + filename + "'");
+  }
+}
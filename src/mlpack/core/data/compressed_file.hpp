@@ -0,0 +1,184 @@
+/**
+ * @file compressed_file.hpp
+ * @author Ryan Curtin
+ *
+ * Read and write gzip (.gz) and Zstandard (.zst) compressed files, so that
+ * data::Load() and data::Save() can handle them transparently.
+ */
+#ifndef __MLPACK_CORE_DATA_COMPRESSED_FILE_HPP
+#define __MLPACK_CORE_DATA_COMPRESSED_FILE_HPP
+
+#include <fstream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Return whether or not the given file is compressed; this is decided by its
+ * suffix, which is .gz for gzip and .zst for Zstandard.
+ */
+bool IsCompressed(const std::string& filename);
+
+/**
+ * Return the filename without its compression suffix, if it has one (so
+ * "data.csv.gz" gives "data.csv").  The extension of the result is the format
+ * of the contents.
+ */
+std::string StripCompression(const std::string& filename);
+
+/**
+ * Decompress the whole of the given file into memory.  gzip files are read
+ * with zlib and Zstandard files with libzstd; files made of several
+ * concatenated streams (as written by pigz or zstd -T) are supported.  A
+ * std::runtime_error is thrown if the file cannot be read or is corrupt, or if
+ * mlpack was built without support for its compression.
+ *
+ * @param filename Name of the compressed file.
+ * @param contents Vector to store the decompressed contents in.
+ */
+void Decompress(const std::string& filename, std::vector<char>& contents);
+
+/**
+ * Compress the given data into the given file, with the compression given by
+ * its suffix.  Zstandard compression uses one worker per OpenMP thread if
+ * libzstd was built with multithreading.  A std::runtime_error is thrown if
+ * the file cannot be written, or if mlpack was built without support for its
+ * compression.
+ *
+ * @param filename Name of the compressed file to write.
+ * @param data Start of the data to compress.
+ * @param length Length of the data to compress.
+ */
+void Compress(const std::string& filename,
+              const char* data,
+              const size_t length);
+
+/**
+ * A stream buffer that reads a block of memory, which it does not own.
+ */
+class MemoryStreamBuffer : public std::streambuf
+{
+ public:
+  //! Read an empty block.
+  MemoryStreamBuffer() { }
+
+  //! Read the block [begin, end), from its start.
+  void Reset(const char* begin, const char* end);
+
+ protected:
+  //! Seek relative to the start, the current position, or the end.
+  std::streampos seekoff(std::streamoff offset,
+                         std::ios_base::seekdir direction,
+                         std::ios_base::openmode which);
+
+  //! Seek to the given position.
+  std::streampos seekpos(std::streampos position,
+                         std::ios_base::openmode which);
+};
+
+/**
+ * A file opened for reading.  If the file is compressed, its contents are
+ * decompressed into memory when it is opened, and the stream reads them;
+ * otherwise the stream reads the file itself.
+ */
+class InputFile
+{
+ public:
+  /**
+   * Open the given file.
+   *
+   * @param filename Name of the file to open.
+   * @param binary If true, the file is opened in binary mode.
+   */
+  InputFile(const std::string& filename, const bool binary = false);
+
+  //! Return whether or not the file was opened (and decompressed).
+  bool IsOpen() const { return open; }
+  //! Get the reason the file could not be opened.
+  const std::string& Error() const { return error; }
+
+  //! Get the stream that reads the contents.
+  std::istream& Stream() { return *stream; }
+
+  //! Return whether or not the file is compressed.
+  bool Compressed() const { return compressed; }
+  //! Get the start of the decompressed contents, if the file is compressed.
+  const char* Data() const { return contents.data(); }
+  //! Get the length of the decompressed contents, if the file is compressed.
+  size_t Length() const { return contents.size(); }
+
+ private:
+  //! If true, the file is compressed.
+  bool compressed;
+  //! If true, the file was opened.
+  bool open;
+  //! The reason the file could not be opened.
+  std::string error;
+  //! The file, if it is not compressed.
+  std::ifstream file;
+  //! The decompressed contents, if the file is compressed.
+  std::vector<char> contents;
+  //! The buffer that reads the decompressed contents.
+  MemoryStreamBuffer buffer;
+  //! The stream that reads the decompressed contents.
+  std::istream memoryStream;
+  //! The stream that reads the contents.
+  std::istream* stream;
+
+  // The streams cannot be copied.
+  InputFile(const InputFile& other);
+  InputFile& operator=(const InputFile& other);
+};
+
+/**
+ * A file opened for writing.  If the file is compressed, what is written to the
+ * stream is held in memory, and compressed into the file by Close().
+ */
+class OutputFile
+{
+ public:
+  /**
+   * Open the given file.
+   *
+   * @param filename Name of the file to open.
+   * @param binary If true, the file is opened in binary mode.
+   */
+  OutputFile(const std::string& filename, const bool binary = false);
+
+  //! Return whether or not the file was opened.
+  bool IsOpen() const { return open; }
+
+  //! Get the stream to write the contents to.
+  std::ostream& Stream();
+
+  /**
+   * Finish writing the file (compressing it, if it is compressed).  A
+   * std::runtime_error is thrown if the file cannot be written.
+   */
+  void Close();
+
+ private:
+  //! Name of the file.
+  std::string filename;
+  //! If true, the file is compressed.
+  bool compressed;
+  //! If true, the file was opened.
+  bool open;
+  //! The file, if it is not compressed.
+  std::ofstream file;
+  //! The uncompressed contents, if the file is compressed.
+  std::ostringstream memory;
+
+  // The streams cannot be copied.
+  OutputFile(const OutputFile& other);
+  OutputFile& operator=(const OutputFile& other);
+};
+
+} // namespace data
+} // namespace mlpack
+
+#endif
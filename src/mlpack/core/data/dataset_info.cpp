@@ -0,0 +1,73 @@
+/**
+ * @file dataset_info.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of DatasetInfo.
+ */
+#include "dataset_info.hpp"
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+using namespace mlpack;
+using namespace mlpack::data;
+
+namespace {
+
+//! Hash a string (with 64-bit FNV-1a).
+inline size_t HashString(const char* string, const size_t length)
+{
+  unsigned long long hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < length; ++i)
+  {
+    hash ^= (unsigned char) string[i];
+    hash *= 1099511628211ULL;
+  }
+
+  return (size_t) hash;
+}
+
+} // anonymous namespace
+
+DatasetInfo::DatasetInfo(const size_t dimensionality) :
+    types(dimensionality, numeric),
+    strings(dimensionality),
+    tables(dimensionality)
+{
+  // Nothing else to do.
+}
+
+size_t DatasetInfo::MapString(const char* string,
+                              const size_t length,
+                              const size_t dimension)
+{
+  types[dimension] = categorical;
+
+  std::vector<std::string>& dimensionStrings = strings[dimension];
+  const size_t index = tables[dimension].Insert(HashString(string, length),
+      dimensionStrings.size(), [&](const size_t i)
+      {
+        return dimensionStrings[i].size() == length &&
+            std::memcmp(dimensionStrings[i].data(), string, length) == 0;
+      });
+
+  if (index == dimensionStrings.size())
+    dimensionStrings.push_back(std::string(string, length));
+
+  return index;
+}
+
+const std::string& DatasetInfo::UnmapString(const size_t value,
+                                            const size_t dimension) const
+{
+  if (value >= strings[dimension].size())
+  {
+    std::ostringstream oss;
+    oss << "DatasetInfo::UnmapString(): no string of dimension " << dimension
+        << " maps to " << value;
+    throw std::invalid_argument(oss.str());
+  }
+
+  return strings[dimension][value];
+}
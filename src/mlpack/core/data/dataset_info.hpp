@@ -0,0 +1,98 @@
+/**
+ * @file dataset_info.hpp
+ * @author Ryan Curtin
+ *
+ * Information about the dimensions of a dataset that holds categorical
+ * (string) features, and the mappings of their strings to integers.
+ */
+#ifndef __MLPACK_CORE_DATA_DATASET_INFO_HPP
+#define __MLPACK_CORE_DATA_DATASET_INFO_HPP
+
+#include "index_table.hpp"
+
+#include <string>
+#include <vector>
+
+namespace mlpack {
+namespace data {
+
+//! The type of a dimension of a dataset.
+enum Datatype
+{
+  numeric,
+  categorical
+};
+
+/**
+ * The types of the dimensions of a dataset, and, for each categorical
+ * dimension, the mapping of its strings to the integers 0, 1, 2, ... (in the
+ * order the strings are first seen) that are stored in the matrix.  This is
+ * filled in by the data::Load() overload that takes a DatasetInfo.  Each
+ * dimension has its own hash table of strings, so different dimensions may be
+ * mapped from different threads at once.
+ */
+class DatasetInfo
+{
+ public:
+  /**
+   * Create the information for a dataset with the given dimensionality, each
+   * dimension of which is numeric.
+   */
+  DatasetInfo(const size_t dimensionality = 0);
+
+  /**
+   * Get the integer that the given string of the given dimension maps to,
+   * adding a mapping for it if it has none.  This makes the dimension
+   * categorical.
+   *
+   * @param string String to map.
+   * @param dimension Dimension the string is a value of.
+   */
+  size_t MapString(const std::string& string, const size_t dimension)
+  {
+    return MapString(string.data(), string.size(), dimension);
+  }
+
+  /**
+   * Get the integer that the string [string, string + length) of the given
+   * dimension maps to, adding a mapping for it if it has none.  This makes the
+   * dimension categorical.
+   */
+  size_t MapString(const char* string,
+                   const size_t length,
+                   const size_t dimension);
+
+  /**
+   * Get the string that the given integer of the given dimension was mapped
+   * from.  A std::invalid_argument is thrown if there is no such string.
+   */
+  const std::string& UnmapString(const size_t value,
+                                 const size_t dimension) const;
+
+  //! Get the type of the given dimension.
+  Datatype Type(const size_t dimension) const { return types[dimension]; }
+  //! Modify the type of the given dimension.
+  Datatype& Type(const size_t dimension) { return types[dimension]; }
+
+  //! Get the number of strings mapped in the given dimension.
+  size_t NumMappings(const size_t dimension) const
+  {
+    return strings[dimension].size();
+  }
+
+  //! Get the dimensionality of the dataset.
+  size_t Dimensionality() const { return types.size(); }
+
+ private:
+  //! The type of each dimension.
+  std::vector<Datatype> types;
+  //! The strings of each dimension, in the order they were mapped.
+  std::vector<std::vector<std::string> > strings;
+  //! The hash table of the strings of each dimension.
+  std::vector<IndexTable> tables;
+};
+
+} // namespace data
+} // namespace mlpack
+
+#endif
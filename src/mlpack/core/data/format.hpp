@@ -17,7 +17,8 @@ enum format
   autodetect,
   text,
   xml,
-  binary
+  binary,
+  blob
 };
 
 } // namespace data
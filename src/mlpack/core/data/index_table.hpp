@@ -0,0 +1,155 @@
+/**
+ * @file index_table.hpp
+ * @author Ryan Curtin
+ *
+ * An open-addressing hash table of indices, for mapping values (such as labels
+ * or strings) to the order they were first seen in.
+ */
+#ifndef __MLPACK_CORE_DATA_INDEX_TABLE_HPP
+#define __MLPACK_CORE_DATA_INDEX_TABLE_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * An open-addressing (linear probing) hash table that maps keys to indices
+ * 0, 1, 2, ..., in the order the keys were inserted.  The keys themselves are
+ * not held by the table, but by the caller (usually in a vector, at their
+ * index); the table holds only the hash and index of each key, so a lookup is
+ * one probe sequence in a flat array, which is kept at most half full.
+ *
+ * @code
+ * std::vector<double> keys;
+ * IndexTable table;
+ * const size_t index = table.Insert(hash, keys.size(),
+ *     [&](const size_t i) { return keys[i] == key; });
+ * if (index == keys.size())
+ *   keys.push_back(key); // The key was not there, and has been added.
+ * @endcode
+ */
+class IndexTable
+{
+ public:
+  //! Create an empty table.
+  IndexTable() : size(0), mask(0), shift(64) { }
+
+  /**
+   * Find the key with the given hash for which equal(index) is true, and
+   * return its index; if there is no such key, add it with the given index and
+   * return that.
+   *
+   * @param hash Hash of the key.
+   * @param newIndex Index to give the key if it is not in the table.
+   * @param equal Function that returns whether the key at an index is the key.
+   */
+  template<typename EqualType>
+  size_t Insert(const size_t hash, const size_t newIndex, EqualType equal)
+  {
+    if (2 * (size + 1) > slots.size())
+      Grow();
+
+    for (size_t slot = Slot(hash); ; slot = (slot + 1) & mask)
+    {
+      if (slots[slot].second == 0)
+      {
+        slots[slot] = std::make_pair(hash, newIndex + 1);
+        ++size;
+        return newIndex;
+      }
+
+      if (slots[slot].first == hash && equal(slots[slot].second - 1))
+        return slots[slot].second - 1;
+    }
+  }
+
+  /**
+   * Find the key with the given hash for which equal(index) is true, and
+   * return its index, or size_t(-1) if it is not in the table.
+   */
+  template<typename EqualType>
+  size_t Find(const size_t hash, EqualType equal) const
+  {
+    if (size == 0)
+      return size_t(-1);
+
+    for (size_t slot = Slot(hash); ; slot = (slot + 1) & mask)
+    {
+      if (slots[slot].second == 0)
+        return size_t(-1);
+
+      if (slots[slot].first == hash && equal(slots[slot].second - 1))
+        return slots[slot].second - 1;
+    }
+  }
+
+  /**
+   * Make room for the given number of keys, so that the table does not have to
+   * grow until it holds more than that.
+   */
+  void Reserve(const size_t keys)
+  {
+    while (slots.size() < 2 * keys)
+      Grow();
+  }
+
+  //! Get the number of keys in the table.
+  size_t Size() const { return size; }
+
+  //! Remove all of the keys.
+  void Clear()
+  {
+    slots.clear();
+    size = 0;
+    mask = 0;
+    shift = 64;
+  }
+
+ private:
+  //! Get the first slot to probe for the given hash.  This is the top bits of
+  //! the hash times a large odd constant (Fibonacci hashing), since hashes of
+  //! integers are often the integers themselves.
+  size_t Slot(const size_t hash) const
+  {
+    return (size_t) (((unsigned long long) hash * 0x9E3779B97F4A7C15ULL) >>
+        shift);
+  }
+
+  //! Double the number of slots, and put each key in its new place.
+  void Grow()
+  {
+    std::vector<std::pair<size_t, size_t> > old;
+    old.swap(slots);
+    slots.resize(old.empty() ? 16 : 2 * old.size(), std::make_pair(0, 0));
+    mask = slots.size() - 1;
+    shift = old.empty() ? 60 : shift - 1;
+
+    for (size_t i = 0; i < old.size(); ++i)
+    {
+      if (old[i].second == 0)
+        continue;
+
+      size_t slot = Slot(old[i].first);
+      while (slots[slot].second != 0)
+        slot = (slot + 1) & mask;
+      slots[slot] = old[i];
+    }
+  }
+
+  //! The hash and index + 1 of the key in each slot (0 if it is empty).
+  std::vector<std::pair<size_t, size_t> > slots;
+  //! The number of keys in the table.
+  size_t size;
+  //! The number of slots, minus one.
+  size_t mask;
+  //! 64 minus the base-2 logarithm of the number of slots.
+  size_t shift;
+};
+
+} // namespace data
+} // namespace mlpack
+
+#endif
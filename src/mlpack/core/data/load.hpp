@@ -14,6 +14,8 @@
 #include <string>
 
 #include "format.hpp"
+#include "subset_loader.hpp"
+#include "dataset_info.hpp"
 
 namespace mlpack {
 namespace data /** Functions to load and save matrices and models. */ {
@@ -39,6 +41,11 @@ namespace data /** Functions to load and save matrices and models. */ {
  * This is preferable to Armadillo's default behavior of loading an unknown
  * filetype as raw_binary, which can have very confusing effects.
  *
+ * A file compressed with gzip or Zstandard, denoted by a further .gz or .zst
+ * (as in "data.csv.gz"), is decompressed into memory as it is loaded, if
+ * mlpack was built with zlib or libzstd; so, it need not be decompressed on
+ * disk first.
+ *
  * If the parameter 'fatal' is set to true, a std::runtime_error exception will
  * be thrown if the matrix does not load successfully.  The parameter
  * 'transpose' controls whether or not the matrix is transposed after loading.
@@ -46,6 +53,11 @@ namespace data /** Functions to load and save matrices and models. */ {
  * mlpack requires column-major matrices, this should be left at its default
  * value of 'true'.
  *
+ * A .bin file (arma_binary or raw_binary) that holds one point per column can
+ * also be memory-mapped with MappedMatrix instead of being loaded; then no copy
+ * of it is made, and processes on the same host share one copy in the page
+ * cache.
+ *
  * @param filename Name of file to load.
  * @param matrix Matrix to load contents of file into.
  * @param fatal If an error should be reported as fatal (default false).
@@ -58,6 +70,116 @@ bool Load(const std::string& filename,
           const bool fatal = false,
           bool transpose = true);
 
+/**
+ * Loads a subset of a dataset from file, guessing the filetype from the
+ * extension, as Load() does; as for the default of Load(), the points of the
+ * dataset are the rows of the file, and are the columns of the loaded matrix.
+ * The subset (see Subset) is a range of the points, optionally with a stride
+ * between them, and a selection of their dimensions; so, for instance, each of
+ * several workers can load only its own shard of the dataset.
+ *
+ * For HDF5 files and Armadillo binary files, only the subset is read from the
+ * file (for HDF5, with a hyperslab selection; for Armadillo binary, with one
+ * read of the range of the points for each dimension), so the dataset never
+ * has to fit in memory.  Files of the other types are loaded whole, and the
+ * subset is taken from them.
+ *
+ * @param filename Name of file to load.
+ * @param matrix Matrix to load the subset into.
+ * @param subset The subset of the dataset to load.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @return Boolean value indicating success or failure of load.
+ */
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::Mat<eT>& matrix,
+          const Subset& subset,
+          const bool fatal = false);
+
+/**
+ * Loads a sparse matrix from file, guessing the filetype from the extension.
+ * The file is parsed in parallel if mlpack is compiled with OpenMP, and the
+ * matrix is never held in dense form.  The supported types of files are:
+ *
+ *  - Coordinate list, denoted by .csv, .tsv, or .txt: one "row column value"
+ *    entry per line, with 0-based indices (the coord_ascii format Armadillo
+ *    saves sparse matrices in)
+ *  - Matrix Market coordinate format, denoted by .mtx
+ *  - LibSVM, denoted by .svm or .libsvm: one "label index:value ..." point per
+ *    line, which is a row of the file matrix (the labels are dropped; use
+ *    LoadLibSVM() to keep them)
+ *
+ * Each of these can also be compressed, as for dense matrices.
+ *
+ * As for dense matrices, the parameter 'transpose' controls whether or not the
+ * matrix is transposed, and the parameter 'fatal' controls whether a
+ * std::runtime_error is thrown if the matrix does not load successfully.  So,
+ * a "user item rating" coordinate list loads by default as an items-by-users
+ * matrix, which is the layout that CF expects.
+ *
+ * @param filename Name of file to load.
+ * @param matrix Sparse matrix to load contents of file into.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @param transpose If true, transpose the matrix after loading.
+ * @return Boolean value indicating success or failure of load.
+ */
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::SpMat<eT>& matrix,
+          const bool fatal = false,
+          const bool transpose = true);
+
+/**
+ * Load a LibSVM (or SVMlight) file, as "label index:value index:value ..." with
+ * one point per line and 1-based feature indices, into a sparse matrix with
+ * one point per column, keeping the labels.  The number of dimensions is the
+ * largest feature index in the file.
+ *
+ * @param filename Name of file to load.
+ * @param matrix Sparse matrix to load the points into.
+ * @param labels Vector to load the label of each point into.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @return Boolean value indicating success or failure of load.
+ */
+template<typename eT>
+bool LoadLibSVM(const std::string& filename,
+                arma::SpMat<eT>& matrix,
+                arma::rowvec& labels,
+                const bool fatal = false);
+
+/**
+ * Loads a matrix that may have categorical (string) features from file, and
+ * fills in the given DatasetInfo with the type of each dimension and the
+ * mapping of the strings of each categorical dimension to the integers stored
+ * in the matrix.  A dimension is categorical if it holds any value that is not
+ * a number.  The strings are mapped while the file is parsed (in parallel,
+ * with a hash table for each dimension), so no separate pass like
+ * NormalizeLabels() is needed.
+ *
+ * CSV, TSV, and ASCII files (denoted by .csv, .tsv, and .txt, and optionally
+ * compressed) may have categorical features; in a file whose first line has a
+ * comma, the values are separated by commas (so they may hold spaces),
+ * otherwise by whitespace.  Files of the other types are loaded as by Load(),
+ * with every dimension numeric.
+ *
+ * If info is empty, it is set to the dimensionality of the file; otherwise, it
+ * must match it, and the strings that are already mapped keep their integers
+ * (so a test set can be loaded with the DatasetInfo of its training set).
+ *
+ * @param filename Name of file to load.
+ * @param matrix Matrix to load contents of file into.
+ * @param info Information about the dimensions of the dataset.
+ * @param fatal If an error should be reported as fatal (default false).
+ * @param transpose If true, transpose the matrix after loading.
+ * @return Boolean value indicating success or failure of load.
+ */
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::Mat<eT>& matrix,
+          DatasetInfo& info,
+          const bool fatal = false,
+          const bool transpose = true);
+
 /**
  * Load a model from a file, guessing the filetype from the extension, or,
  * optionally, loading the specified format.  If automatic extension detection
@@ -69,11 +191,21 @@ bool Load(const std::string& filename,
  *  - text, denoted by .txt
  *  - xml, denoted by .xml
  *  - binary, denoted by .bin
+ *  - blob, denoted by .blob (see below)
  *
  * The format parameter can take any of the values in the 'format' enum:
- * 'format::autodetect', 'format::text', 'format::xml', and 'format::binary'.
+ * 'format::autodetect', 'format::text', 'format::xml', 'format::binary', and
+ * 'format::blob'.
  * The autodetect functionality operates on the file extension (so, "file.txt"
- * would be autodetected as text).
+ * would be autodetected as text).  As for matrices, a file whose name ends in
+ * .gz or .zst is decompressed first (so, "file.bin.zst" would be compressed
+ * binary).
+ *
+ * The blob format is the binary format, except that large arrays (such as the
+ * contents of matrices in the model) are stored as aligned raw blocks, so they
+ * are loaded with one read each, straight into the memory of the matrix.  This
+ * makes it the fastest format for large models; like the binary format, it is
+ * not portable between machines of different byte order.
  *
  * The name parameter should be specified to indicate the name of the structure
  * to be loaded.  This should be the same as the name that was used to save the
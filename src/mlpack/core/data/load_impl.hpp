@@ -10,6 +10,10 @@
 // In case it hasn't already been included.
 #include "load.hpp"
 #include "extension.hpp"
+#include "text_loader.hpp"
+#include "sparse_loader.hpp"
+#include "compressed_file.hpp"
+#include "blob_archive.hpp"
 
 #include <algorithm>
 #include <mlpack/core/util/timers.hpp>
@@ -56,21 +60,23 @@ bool Load(const std::string& filename,
 {
   Timer::Start("loading_data");
 
-  // Get the extension.
-  std::string extension = Extension(filename);
+  // Get the extension (of the contents, if the file is compressed).
+  std::string extension = Extension(StripCompression(filename));
 
-  // Catch nonexistent files by opening the stream ourselves.
-  std::fstream stream;
-  stream.open(filename.c_str(), std::fstream::in);
+  // Catch nonexistent files by opening the stream ourselves.  A compressed file
+  // is decompressed into memory, and the stream reads that.
+  InputFile input(filename);
+  std::istream& stream = input.Stream();
 
-  if (!stream.is_open())
+  if (!input.IsOpen())
   {
     Timer::Stop("loading_data");
     if (fatal)
-      Log::Fatal << "Cannot open file '" << filename << "'. " << std::endl;
+      Log::Fatal << "Cannot open file '" << filename << "': " << input.Error()
+          << ". " << std::endl;
     else
-      Log::Warn << "Cannot open file '" << filename << "'; load failed."
-          << std::endl;
+      Log::Warn << "Cannot open file '" << filename << "'; load failed: "
+          << input.Error() << "." << std::endl;
 
     return false;
   }
@@ -254,7 +260,19 @@ bool Load(const std::string& filename,
     Log::Info << "Loading '" << filename << "' as " << stringType << ".  "
         << std::flush;
 
-  const bool success = matrix.load(stream, loadType);
+  // Text files are loaded with our own parallel parser, which also writes the
+  // matrix in its transposed layout directly; if it can't handle the file, we
+  // fall back to Armadillo.
+  bool loadedText = false;
+  if ((loadType == arma::csv_ascii || loadType == arma::raw_ascii) &&
+      input.Compressed())
+    loadedText = LoadText(input.Data(), input.Data() + input.Length(), matrix,
+        transpose);
+  else if (loadType == arma::csv_ascii || loadType == arma::raw_ascii)
+    loadedText = LoadText(filename, matrix, transpose);
+
+  const bool success = loadedText || matrix.load(stream, loadType);
+  const bool transposeAfter = transpose && !loadedText;
 
   if (!success)
   {
@@ -268,11 +286,12 @@ bool Load(const std::string& filename,
     return false;
   }
   else
-    Log::Info << "Size is " << (transpose ? matrix.n_cols : matrix.n_rows)
-        << " x " << (transpose ? matrix.n_rows : matrix.n_cols) << ".\n";
+    Log::Info << "Size is " << (transposeAfter ? matrix.n_cols :
+        matrix.n_rows) << " x " << (transposeAfter ? matrix.n_rows :
+        matrix.n_cols) << ".\n";
 
   // Now transpose the matrix, if necessary.
-  if (transpose)
+  if (transposeAfter)
   {
     inplace_transpose(matrix);
   }
@@ -283,6 +302,228 @@ bool Load(const std::string& filename,
   return success;
 }
 
+// Load a sparse matrix from file.
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::Mat<eT>& matrix,
+          const Subset& subset,
+          const bool fatal)
+{
+  Timer::Start("loading_data");
+
+  arma::mat points;
+  bool loaded;
+  try
+  {
+    loaded = LoadSubset(filename, subset, points);
+  }
+  catch (std::exception& e)
+  {
+    Timer::Stop("loading_data");
+    if (fatal)
+      Log::Fatal << "Loading from '" << filename << "' failed: " << e.what()
+          << "." << std::endl;
+    else
+      Log::Warn << "Loading from '" << filename << "' failed: " << e.what()
+          << "." << std::endl;
+
+    return false;
+  }
+
+  Timer::Stop("loading_data");
+  if (loaded)
+  {
+    Log::Info << "Loaded " << points.n_cols << " points of dimensionality "
+        << points.n_rows << " from '" << filename << "'." << std::endl;
+    matrix = arma::conv_to<arma::Mat<eT> >::from(points);
+    return true;
+  }
+
+  // Subsets cannot be read from this type of file, so load the whole file.
+  arma::Mat<eT> dataset;
+  if (!Load(filename, dataset, fatal, true))
+    return false;
+
+  try
+  {
+    SelectSubset(dataset, subset, matrix);
+  }
+  catch (std::exception& e)
+  {
+    if (fatal)
+      Log::Fatal << "Loading from '" << filename << "' failed: " << e.what()
+          << "." << std::endl;
+    else
+      Log::Warn << "Loading from '" << filename << "' failed: " << e.what()
+          << "." << std::endl;
+
+    return false;
+  }
+
+  return true;
+}
+
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::SpMat<eT>& matrix,
+          const bool fatal,
+          const bool transpose)
+{
+  Timer::Start("loading_data");
+
+  const std::string extension = Extension(StripCompression(filename));
+  std::string stringType;
+  if (extension == "csv" || extension == "tsv" || extension == "txt")
+    stringType = "coordinate list";
+  else if (extension == "mtx")
+    stringType = "Matrix Market data";
+  else if (extension == "svm" || extension == "libsvm")
+    stringType = "LibSVM data";
+  else
+  {
+    Timer::Stop("loading_data");
+    if (fatal)
+      Log::Fatal << "Unable to detect type of '" << filename << "'; "
+          << "incorrect extension?" << std::endl;
+    else
+      Log::Warn << "Unable to detect type of '" << filename << "'; load failed."
+          << " Incorrect extension?" << std::endl;
+
+    return false;
+  }
+
+  Log::Info << "Loading '" << filename << "' as " << stringType << ".  "
+      << std::flush;
+
+  try
+  {
+    if (extension == "mtx")
+    {
+      LoadMatrixMarketText(filename, matrix, transpose);
+    }
+    else if (extension == "svm" || extension == "libsvm")
+    {
+      arma::rowvec labels;
+      LoadLibSVMText(filename, matrix, labels, transpose);
+    }
+    else
+    {
+      LoadCoordinateText(filename, matrix, transpose);
+    }
+  }
+  catch (std::exception& e)
+  {
+    Log::Info << std::endl;
+    Timer::Stop("loading_data");
+    if (fatal)
+      Log::Fatal << "Loading from '" << filename << "' failed: " << e.what()
+          << "." << std::endl;
+    else
+      Log::Warn << "Loading from '" << filename << "' failed: " << e.what()
+          << "." << std::endl;
+
+    return false;
+  }
+
+  Log::Info << "Size is " << matrix.n_rows << " x " << matrix.n_cols << ", "
+      << "with " << matrix.n_nonzero << " nonzero elements.\n";
+
+  Timer::Stop("loading_data");
+  return true;
+}
+
+// Load a LibSVM file into a sparse matrix, with its labels.
+template<typename eT>
+bool LoadLibSVM(const std::string& filename,
+                arma::SpMat<eT>& matrix,
+                arma::rowvec& labels,
+                const bool fatal)
+{
+  Timer::Start("loading_data");
+  Log::Info << "Loading '" << filename << "' as LibSVM data.  " << std::flush;
+
+  try
+  {
+    LoadLibSVMText(filename, matrix, labels, true);
+  }
+  catch (std::exception& e)
+  {
+    Log::Info << std::endl;
+    Timer::Stop("loading_data");
+    if (fatal)
+      Log::Fatal << "Loading from '" << filename << "' failed: " << e.what()
+          << "." << std::endl;
+    else
+      Log::Warn << "Loading from '" << filename << "' failed: " << e.what()
+          << "." << std::endl;
+
+    return false;
+  }
+
+  Log::Info << "Size is " << matrix.n_rows << " x " << matrix.n_cols << ", "
+      << "with " << matrix.n_nonzero << " nonzero elements.\n";
+
+  Timer::Stop("loading_data");
+  return true;
+}
+
+template<typename eT>
+bool Load(const std::string& filename,
+          arma::Mat<eT>& matrix,
+          DatasetInfo& info,
+          const bool fatal,
+          const bool transpose)
+{
+  // Only text files can hold strings.
+  const std::string extension = Extension(StripCompression(filename));
+  if (extension != "csv" && extension != "tsv" && extension != "txt")
+  {
+    if (!Load(filename, matrix, fatal, transpose))
+      return false;
+
+    if (info.Dimensionality() == 0)
+      info = DatasetInfo(transpose ? matrix.n_rows : matrix.n_cols);
+    return true;
+  }
+
+  Timer::Start("loading_data");
+  Log::Info << "Loading '" << filename << "' as text data with categorical "
+      << "features.  " << std::flush;
+
+  arma::mat values;
+  try
+  {
+    const MappedTextFile file(filename);
+    LoadCategoricalText(file.Data(), file.Data() + file.Length(), values, info,
+        transpose);
+  }
+  catch (std::exception& e)
+  {
+    Log::Info << std::endl;
+    Timer::Stop("loading_data");
+    if (fatal)
+      Log::Fatal << "Loading from '" << filename << "' failed: " << e.what()
+          << "." << std::endl;
+    else
+      Log::Warn << "Loading from '" << filename << "' failed: " << e.what()
+          << "." << std::endl;
+
+    return false;
+  }
+
+  size_t categoricalDimensions = 0;
+  for (size_t i = 0; i < info.Dimensionality(); ++i)
+    if (info.Type(i) == categorical)
+      ++categoricalDimensions;
+
+  Log::Info << "Size is " << values.n_rows << " x " << values.n_cols << ", "
+      << "with " << categoricalDimensions << " categorical dimensions.\n";
+
+  matrix = arma::conv_to<arma::Mat<eT> >::from(values);
+  Timer::Stop("loading_data");
+  return true;
+}
+
 // Load a model from file.
 template<typename T>
 bool Load(const std::string& filename,
@@ -293,7 +534,7 @@ bool Load(const std::string& filename,
 {
   if (f == format::autodetect)
   {
-    std::string extension = Extension(filename);
+    std::string extension = Extension(StripCompression(filename));
 
     if (extension == "xml")
       f = format::xml;
@@ -301,6 +542,8 @@ bool Load(const std::string& filename,
       f = format::binary;
     else if (extension == "txt")
       f = format::text;
+    else if (extension == "blob")
+      f = format::blob;
     else
     {
       if (fatal)
@@ -314,14 +557,17 @@ bool Load(const std::string& filename,
     }
   }
 
-  // Now load the given format.
-  std::ifstream ifs(filename);
-  if (!ifs.is_open())
+  // Now load the given format.  A compressed file is decompressed first.
+  InputFile input(filename, f == format::blob);
+  std::istream& ifs = input.Stream();
+  if (!input.IsOpen())
   {
     if (fatal)
-      Log::Fatal << "Unable to open file '" << filename << "'." << std::endl;
+      Log::Fatal << "Unable to open file '" << filename << "': "
+          << input.Error() << "." << std::endl;
     else
-      Log::Warn << "Unable to open file '" << filename << "'." << std::endl;
+      Log::Warn << "Unable to open file '" << filename << "': "
+          << input.Error() << "." << std::endl;
 
     return false;
   }
@@ -343,6 +589,11 @@ bool Load(const std::string& filename,
       boost::archive::binary_iarchive ar(ifs);
       ar >> CreateNVP(t, name);
     }
+    else if (f == format::blob)
+    {
+      BlobIArchive ar(ifs);
+      ar >> CreateNVP(t, name);
+    }
 
     return true;
   }
@@ -0,0 +1,166 @@
+/**
+ * @file mapped_matrix.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of MappedMatrix, which memory-maps arma_binary and raw_binary
+ * files.
+ */
+#include "mapped_matrix.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+using namespace mlpack;
+using namespace mlpack::data;
+
+MappedMatrix::MappedMatrix(const std::string& filename,
+                           const bool writeBack,
+                           const size_t rawRows) :
+    filename(filename),
+    mapping(NULL),
+    length(0),
+    matrix(NULL)
+{
+#ifdef _WIN32
+  (void) writeBack;
+  (void) rawRows;
+  throw std::runtime_error("MappedMatrix: memory mapping is not supported on "
+      "this platform");
+#else
+  const int fd = open(filename.c_str(), writeBack ? O_RDWR : O_RDONLY);
+  if (fd == -1)
+  {
+    std::ostringstream oss;
+    oss << "MappedMatrix: cannot open '" << filename << "': "
+        << std::strerror(errno);
+    throw std::runtime_error(oss.str());
+  }
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) == -1)
+  {
+    close(fd);
+    std::ostringstream oss;
+    oss << "MappedMatrix: cannot stat '" << filename << "': "
+        << std::strerror(errno);
+    throw std::runtime_error(oss.str());
+  }
+  length = (size_t) fileStat.st_size;
+
+  // The mapping is always writable, so that (for instance) a tree can rearrange
+  // the points; a private mapping keeps those modifications out of the file.
+  mapping = mmap(NULL, length, PROT_READ | PROT_WRITE,
+      writeBack ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+  close(fd); // The mapping holds its own reference to the file.
+  if (mapping == MAP_FAILED)
+  {
+    mapping = NULL;
+    std::ostringstream oss;
+    oss << "MappedMatrix: cannot map '" << filename << "': "
+        << std::strerror(errno);
+    throw std::runtime_error(oss.str());
+  }
+
+  const char* header = (const char*) mapping;
+  size_t rows = 0, cols = 0;
+  size_t offset = 0;
+
+  if (rawRows != 0)
+  {
+    // A raw_binary file is only the elements, in column-major order.
+    const size_t columnLength = rawRows * sizeof(double);
+    if (length % columnLength != 0)
+    {
+      munmap(mapping, length);
+      mapping = NULL;
+      std::ostringstream oss;
+      oss << "MappedMatrix: the length of '" << filename << "' is not a "
+          << "multiple of " << rawRows << " doubles";
+      throw std::runtime_error(oss.str());
+    }
+
+    matrix = new arma::mat((double*) header, rawRows, length / columnLength,
+        false, false);
+    return;
+  }
+
+  // Parse the header, which is "ARMA_MAT_BIN_FN008\n<rows> <cols>\n" for a
+  // matrix of doubles.
+  const std::string magic = "ARMA_MAT_BIN_FN008";
+  offset = magic.size();
+  bool valid = (length > offset) &&
+      (std::strncmp(header, magic.c_str(), magic.size()) == 0);
+
+  // Read the dimensions.  The header is short, so we don't need to be clever
+  // about this.
+  if (valid)
+  {
+    const size_t headerEnd = std::min(length, offset + 64);
+    std::istringstream dims(std::string(header + offset, headerEnd - offset));
+    valid = (bool) (dims >> rows >> cols);
+    if (valid)
+    {
+      // Skip the single whitespace character after the number of columns.
+      offset += (size_t) dims.tellg() + 1;
+      valid = (offset + rows * cols * sizeof(double) <= length);
+    }
+  }
+
+  if (!valid)
+  {
+    munmap(mapping, length);
+    mapping = NULL;
+    throw std::runtime_error("MappedMatrix: '" + filename + "' is not an "
+        "arma_binary file holding a matrix of doubles");
+  }
+
+  // The elements can only be used in place if they are aligned.  Armadillo
+  // does not pad the header, so a file it saved usually is not (data::Save()
+  // with transpose = false pads the header); then the elements are copied,
+  // which cannot be done if modifications must be written back.
+  if (offset % alignof(double) != 0)
+  {
+    if (writeBack)
+    {
+      munmap(mapping, length);
+      mapping = NULL;
+      throw std::runtime_error("MappedMatrix: the elements of '" + filename +
+          "' are not aligned, so modifications cannot be written back; save "
+          "it with data::Save() and transpose = false");
+    }
+
+    matrix = new arma::mat(rows, cols);
+    std::memcpy(matrix->memptr(), header + offset,
+        rows * cols * sizeof(double));
+    munmap(mapping, length);
+    mapping = NULL;
+    return;
+  }
+
+  // Now use the mapped memory directly as the memory of the matrix.  The
+  // matrix is not strict, so that it can be moved into another matrix without
+  // its memory being copied.
+  matrix = new arma::mat((double*) (header + offset), rows, cols, false,
+      false);
+#endif
+}
+
+MappedMatrix::~MappedMatrix()
+{
+  delete matrix;
+
+#ifndef _WIN32
+  if (mapping != NULL)
+    munmap(mapping, length);
+#endif
+}
@@ -0,0 +1,99 @@
+/**
+ * @file mapped_matrix.hpp
+ * @author Ryan Curtin
+ *
+ * Memory-map a binary matrix file, so that the matrix can be used
+ * without reading it into memory (and so that processes on the same host can
+ * share the page cache of one file).
+ */
+#ifndef __MLPACK_CORE_DATA_MAPPED_MATRIX_HPP
+#define __MLPACK_CORE_DATA_MAPPED_MATRIX_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <string>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * A MappedMatrix memory-maps a file in Armadillo binary format (arma_binary,
+ * holding doubles) or in raw binary format (raw_binary, also holding doubles)
+ * and exposes its contents as an arma::mat that uses the mapping as its
+ * memory, via Armadillo's advanced constructor.  No copy of the data is made,
+ * and the pages of the file are only read as they are used.  Unlike
+ * data::Load(), the matrix is not transposed, so the file must hold one point
+ * per column; this is what arma::Mat::save() or data::Save() with transpose =
+ * false will write.  A raw_binary file has no header, so the number of rows
+ * must be given.
+ *
+ * The mapping is writable; by default it is private, so that modifications are
+ * not written back to the file (pages that are modified are copied on write).
+ * If writeBack is true, the mapping is shared, so modifications are written
+ * back to the file and are visible to other processes mapping the same file.
+ *
+ * The matrix can be moved into an object that would otherwise copy it (for
+ * instance, with the NeighborSearch or BinarySpaceTree constructors that take
+ * MatType&&); Armadillo will then keep using the mapped memory, and a tree will
+ * rearrange the points in place.  In that case the MappedMatrix must outlive
+ * that object, and with writeBack = true the file will hold the rearranged
+ * dataset afterwards.
+ *
+ * The elements of an arma_binary file can only be used in place if the header
+ * leaves them aligned, as it does when the file is saved with data::Save() and
+ * transpose = false.  Otherwise they are copied into the matrix (which then
+ * does not use the mapping), or, if writeBack is true, std::runtime_error is
+ * thrown.
+ *
+ * Memory mapping is only available on POSIX systems; on other systems, the
+ * constructor throws std::runtime_error.
+ */
+class MappedMatrix
+{
+ public:
+  /**
+   * Map the given file.  A std::runtime_error is thrown if the file cannot be
+   * opened or mapped, or if it is not an arma_binary file holding doubles (or,
+   * if rawRows is given, if its length is not a multiple of a column), or if
+   * writeBack is true and the elements in the file are not aligned.
+   *
+   * @param filename Name of arma_binary or raw_binary file to map.
+   * @param writeBack If true, modifications to the matrix are written back to
+   *      the file.
+   * @param rawRows If nonzero, the file is raw_binary and each column has this
+   *      many rows; otherwise, the file is arma_binary.
+   */
+  MappedMatrix(const std::string& filename,
+               const bool writeBack = false,
+               const size_t rawRows = 0);
+
+  //! Unmap the file.
+  ~MappedMatrix();
+
+  //! Get the mapped matrix.
+  const arma::mat& Matrix() const { return *matrix; }
+  //! Modify the mapped matrix.
+  arma::mat& Matrix() { return *matrix; }
+
+  //! Get the name of the mapped file.
+  const std::string& Filename() const { return filename; }
+
+ private:
+  // Mappings cannot be copied.
+  MappedMatrix(const MappedMatrix& other);
+  MappedMatrix& operator=(const MappedMatrix& other);
+
+  //! The name of the mapped file.
+  std::string filename;
+  //! The start of the mapping.
+  void* mapping;
+  //! The length of the mapping.
+  size_t length;
+  //! The matrix that uses the mapping as its memory.
+  arma::mat* matrix;
+};
+
+} // namespace data
+} // namespace mlpack
+
+#endif
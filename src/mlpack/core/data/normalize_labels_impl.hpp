@@ -10,10 +10,21 @@
 
 // In case it hasn't been included yet.
 #include "normalize_labels.hpp"
+#include "index_table.hpp"
+
+#include <functional>
+#include <vector>
 
 namespace mlpack {
 namespace data {
 
+//! Hash a label.  0 and -0 are equal, so they must have the same hash.
+template<typename eT>
+inline size_t HashLabel(const eT& label)
+{
+  return std::hash<eT>()((label == eT(0)) ? eT(0) : label);
+}
+
 /**
  * Given a set of labels of a particular datatype, convert them to unsigned
  * labels in the range [0, n) where n is the number of different labels.  Also,
@@ -29,37 +40,29 @@ void NormalizeLabels(const arma::Col<eT>& labelsIn,
                      arma::Col<size_t>& labels,
                      arma::Col<eT>& mapping)
 {
-  // Loop over the input labels, and develop the mapping.  We'll first naively
-  // resize the mapping to the maximum possible size, and then when we fill it,
-  // we'll resize it back down to its actual size.
-  mapping.set_size(labelsIn.n_elem);
+  // Loop over the input labels, and develop the mapping.  Each label is looked
+  // up in a hash table of the labels seen so far, which gives its index in the
+  // list of those labels, so this takes linear time however many labels there
+  // are.
   labels.set_size(labelsIn.n_elem);
-  size_t curLabel = 0;
+  std::vector<eT> unique;
+  IndexTable table;
   for (size_t i = 0; i < labelsIn.n_elem; ++i)
   {
-    bool found = false;
-    for (size_t j = 0; j < curLabel; ++j)
-    {
-      // Is the label already in the list of labels we have seen?
-      if (labelsIn[i] == mapping[j])
-      {
-        labels[i] = j;
-        found = true;
-        break;
-      }
-    }
+    const eT label = labelsIn[i];
+    const size_t index = table.Insert(HashLabel(label), unique.size(),
+        [&unique, &label](const size_t j) { return unique[j] == label; });
 
     // Do we need to add this new label?
-    if (!found)
-    {
-      mapping[curLabel] = labelsIn[i];
-      labels[i] = curLabel;
-      ++curLabel;
-    }
+    if (index == unique.size())
+      unique.push_back(label);
+
+    labels[i] = index;
   }
 
-  // Resize mapping back down to necessary size.
-  mapping.resize(curLabel);
+  mapping.set_size(unique.size());
+  for (size_t i = 0; i < unique.size(); ++i)
+    mapping[i] = unique[i];
 }
 
 /**
@@ -34,12 +34,25 @@ namespace data /** Functions to load and save matrices. */ {
  *  - Armadillo binary (arma_binary), denoted by .bin
  *  - HDF5 (hdf5_binary), denoted by .hdf5, .hdf, .h5, or .he5
  *
+ * Any of these (except HDF5) can be compressed by adding .gz (gzip) or .zst
+ * (Zstandard) to the filename, as in "data.csv.zst", if mlpack was built with
+ * zlib or libzstd; Zstandard compression uses all of the OpenMP threads.
+ *
+ * CSV and ASCII files of numbers are written in parallel (if mlpack is compiled
+ * with OpenMP), with the same format as Armadillo, and without a transposed
+ * copy of the matrix being made.
+ *
  * If the file extension is not one of those types, an error will be given.  If
  * the 'fatal' parameter is set to true, a std::runtime_error exception will be
  * thrown upon failure.  If the 'transpose' parameter is set to true, the matrix
  * will be transposed before saving.  Generally, because mlpack stores matrices
  * in a column-major format and most datasets are stored on disk as row-major,
- * this parameter should be left at its default value of 'true'.
+ * this parameter should be left at its default value of 'true'.  The exception
+ * is a .bin file that will be memory-mapped with MappedMatrix: saved with
+ * 'transpose' set to false, it holds one point per column, which is what
+ * MappedMatrix expects, and (for a matrix of doubles) its header is padded so
+ * that the elements are aligned and it can then be used without being read,
+ * copied or transposed.
  *
  * @param filename Name of file to save to.
  * @param matrix Matrix to save into file.
@@ -64,11 +77,19 @@ bool Save(const std::string& filename,
  *  - text, denoted by .txt
  *  - xml, denoted by .xml
  *  - binary, denoted by .bin
+ *  - blob, denoted by .blob (see below)
  *
  * The format parameter can take any of the values in the 'format' enum:
- * 'format::autodetect', 'format::text', 'format::xml', and 'format::binary'.
+ * 'format::autodetect', 'format::text', 'format::xml', 'format::binary', and
+ * 'format::blob'.
  * The autodetect functionality operates on the file extension (so, "file.txt"
- * would be autodetected as text).
+ * would be autodetected as text).  As for matrices, the file is compressed if
+ * its name ends in .gz or .zst (so, "file.xml.gz" would be compressed xml).
+ *
+ * The blob format is the binary format, except that large arrays (such as the
+ * contents of matrices in the model) are stored as aligned raw blocks apart
+ * from the rest of the model, which makes it the fastest format to load large
+ * models from.
  *
  * The name parameter should be specified to indicate the name of the structure
  * to be saved.  If Load() is later called on the generated file, the name used
@@ -10,6 +10,9 @@
 // In case it hasn't already been included.
 #include "save.hpp"
 #include "extension.hpp"
+#include "compressed_file.hpp"
+#include "blob_archive.hpp"
+#include "text_saver.hpp"
 
 #include <boost/serialization/serialization.hpp>
 #include <boost/archive/xml_oarchive.hpp>
@@ -29,8 +32,9 @@ bool Save(const std::string& filename,
 {
   Timer::Start("saving_data");
 
-  // First we will try to discriminate by file extension.
-  std::string extension = Extension(filename);
+  // First we will try to discriminate by file extension (of the contents, if
+  // the file is to be compressed).
+  std::string extension = Extension(StripCompression(filename));
   if (extension == "")
   {
     Timer::Stop("saving_data");
@@ -44,11 +48,12 @@ bool Save(const std::string& filename,
     return false;
   }
 
-  // Catch errors opening the file.
-  std::fstream stream;
-  stream.open(filename.c_str(), std::fstream::out);
+  // Catch errors opening the file.  If the file is to be compressed, the
+  // stream writes to memory, and the file is written by output.Close().
+  OutputFile output(filename);
+  std::ostream& stream = output.Stream();
 
-  if (!stream.is_open())
+  if (!output.IsOpen())
   {
     Timer::Stop("saving_data");
     if (fatal)
@@ -130,8 +135,49 @@ bool Save(const std::string& filename,
   Log::Info << "Saving " << stringType << " to '" << filename << "'."
       << std::endl;
 
-  // Transpose the matrix.
-  if (transpose)
+  // Text files of numbers are written by our own parallel writer, which does
+  // not need a transposed copy of the matrix.
+  if ((saveType == arma::csv_ascii || saveType == arma::raw_ascii) &&
+      std::is_arithmetic<eT>::value)
+  {
+    if (!SaveText(stream, matrix, transpose, saveType == arma::csv_ascii))
+    {
+      Timer::Stop("saving_data");
+      if (fatal)
+        Log::Fatal << "Save to '" << filename << "' failed." << std::endl;
+      else
+        Log::Warn << "Save to '" << filename << "' failed." << std::endl;
+
+      return false;
+    }
+  }
+  else if (saveType == arma::arma_binary && !transpose &&
+           std::is_same<eT, double>::value)
+  {
+    // Write the header ourselves, so that it can be padded until the elements
+    // are aligned and MappedMatrix can use them in place.  Armadillo skips the
+    // extra whitespace between the dimensions when it loads the file.
+    std::ostringstream rows, cols;
+    rows << "ARMA_MAT_BIN_FN008\n" << matrix.n_rows << " ";
+    cols << matrix.n_cols << "\n";
+    const size_t headerLength = rows.str().size() + cols.str().size();
+    const size_t padding = (alignof(double) - headerLength % alignof(double)) %
+        alignof(double);
+    stream << rows.str() << std::string(padding, ' ') << cols.str();
+    stream.write((const char*) matrix.memptr(), matrix.n_elem * sizeof(eT));
+
+    if (!stream.good())
+    {
+      Timer::Stop("saving_data");
+      if (fatal)
+        Log::Fatal << "Save to '" << filename << "' failed." << std::endl;
+      else
+        Log::Warn << "Save to '" << filename << "' failed." << std::endl;
+
+      return false;
+    }
+  }
+  else if (transpose)
   {
     arma::Mat<eT> tmp = trans(matrix);
 
@@ -160,6 +206,23 @@ bool Save(const std::string& filename,
     }
   }
 
+  try
+  {
+    output.Close();
+  }
+  catch (std::runtime_error& e)
+  {
+    Timer::Stop("saving_data");
+    if (fatal)
+      Log::Fatal << "Save to '" << filename << "' failed: " << e.what() << "."
+          << std::endl;
+    else
+      Log::Warn << "Save to '" << filename << "' failed: " << e.what() << "."
+          << std::endl;
+
+    return false;
+  }
+
   Timer::Stop("saving_data");
 
   // Finally return success.
@@ -176,7 +239,7 @@ bool Save(const std::string& filename,
 {
   if (f == format::autodetect)
   {
-    std::string extension = Extension(filename);
+    std::string extension = Extension(StripCompression(filename));
 
     if (extension == "xml")
       f = format::xml;
@@ -184,6 +247,8 @@ bool Save(const std::string& filename,
       f = format::binary;
     else if (extension == "txt")
       f = format::text;
+    else if (extension == "blob")
+      f = format::blob;
     else
     {
       if (fatal)
@@ -197,9 +262,11 @@ bool Save(const std::string& filename,
     }
   }
 
-  // Open the file to save to.
-  std::ofstream ofs(filename);
-  if (!ofs.is_open())
+  // Open the file to save to.  If it is to be compressed, the archive is
+  // written to memory, and compressed into the file by output.Close().
+  OutputFile output(filename, f == format::blob);
+  std::ostream& ofs = output.Stream();
+  if (!output.IsOpen())
   {
     if (fatal)
       Log::Fatal << "Unable to open file '" << filename << "'." << std::endl;
@@ -226,7 +293,14 @@ bool Save(const std::string& filename,
       boost::archive::binary_oarchive ar(ofs);
       ar << CreateNVP(t, name);
     }
+    else if (f == format::blob)
+    {
+      BlobOArchive ar(ofs);
+      ar << CreateNVP(t, name);
+    }
 
+    // The archive has to be finished (destroyed) before the file is closed.
+    output.Close();
     return true;
   }
   catch (boost::archive::archive_exception& e)
@@ -238,6 +312,15 @@ bool Save(const std::string& filename,
 
     return false;
   }
+  catch (std::runtime_error& e)
+  {
+    if (fatal)
+      Log::Fatal << e.what() << std::endl;
+    else
+      Log::Warn << e.what() << std::endl;
+
+    return false;
+  }
 }
 
 } // namespace data
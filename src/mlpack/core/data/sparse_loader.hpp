@@ -0,0 +1,84 @@
+/**
+ * @file sparse_loader.hpp
+ * @author Ryan Curtin
+ *
+ * Parallel loaders for sparse matrices stored as coordinate lists, Matrix
+ * Market files, and LibSVM files, used by data::Load() and data::LoadLibSVM().
+ */
+#ifndef __MLPACK_CORE_DATA_SPARSE_LOADER_HPP
+#define __MLPACK_CORE_DATA_SPARSE_LOADER_HPP
+
+#include "text_loader.hpp"
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Load a coordinate list into the given sparse matrix.  Each line of the file
+ * holds one nonzero entry, as "row column value" with 0-based indices (this is
+ * the coord_ascii format that Armadillo saves sparse matrices in); the values
+ * may be separated by commas or whitespace.  Blank lines and lines that start
+ * with '%' or '#' are skipped.  The size of the matrix is one more than the
+ * largest row and column index.
+ *
+ * A std::runtime_error is thrown if the file cannot be read or is malformed,
+ * or if it holds the same location twice.
+ *
+ * @param filename Name of the file to load.
+ * @param matrix Matrix to load the file into.
+ * @param transpose If true, the matrix is the transpose of the one in the file.
+ */
+template<typename eT>
+void LoadCoordinateText(const std::string& filename,
+                        arma::SpMat<eT>& matrix,
+                        const bool transpose);
+
+/**
+ * Load a Matrix Market file in the coordinate format into the given sparse
+ * matrix.  Real, integer, and pattern (all values are one) files are
+ * supported, as are general, symmetric, and skew-symmetric ones; for the
+ * latter two, the entries above the diagonal are filled in from the entries
+ * below it.  Complex and dense (array) files are not supported.
+ *
+ * A std::runtime_error is thrown if the file cannot be read or is malformed,
+ * if it holds the same location twice, or if it is not a supported kind of
+ * Matrix Market file.
+ *
+ * @param filename Name of the file to load.
+ * @param matrix Matrix to load the file into.
+ * @param transpose If true, the matrix is the transpose of the one in the file.
+ */
+template<typename eT>
+void LoadMatrixMarketText(const std::string& filename,
+                          arma::SpMat<eT>& matrix,
+                          const bool transpose);
+
+/**
+ * Load a LibSVM (or SVMlight) file into the given sparse matrix.  Each line of
+ * the file is a point, written as "label index:value index:value ...", with
+ * 1-based feature indices.  "qid:" tokens are skipped, as is anything after a
+ * '#'.  The file matrix has one row per point and one column per feature (up
+ * to the largest index in the file); so, with transpose, each point is a
+ * column.
+ *
+ * A std::runtime_error is thrown if the file cannot be read or is malformed,
+ * or if a point holds the same feature twice.
+ *
+ * @param filename Name of the file to load.
+ * @param matrix Matrix to load the file into.
+ * @param labels Vector to store the label of each point in.
+ * @param transpose If true, the matrix is the transpose of the one in the file.
+ */
+template<typename eT>
+void LoadLibSVMText(const std::string& filename,
+                    arma::SpMat<eT>& matrix,
+                    arma::rowvec& labels,
+                    const bool transpose);
+
+} // namespace data
+} // namespace mlpack
+
+// Include implementation.
+#include "sparse_loader_impl.hpp"
+
+#endif
@@ -0,0 +1,544 @@
+/**
+ * @file sparse_loader_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the parallel sparse matrix loaders.
+ */
+#ifndef __MLPACK_CORE_DATA_SPARSE_LOADER_IMPL_HPP
+#define __MLPACK_CORE_DATA_SPARSE_LOADER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "sparse_loader.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+namespace mlpack {
+namespace data {
+
+//! Return the end of the line that starts at p.
+inline const char* LineEnd(const char* p, const char* end)
+{
+  const char* newline = (const char*) std::memchr(p, '\n', end - p);
+  return (newline == NULL) ? end : newline;
+}
+
+//! Return whether or not the line [p, end) is blank or starts with a comment.
+inline bool IsBlankLine(const char* p, const char* end, const char* comments)
+{
+  p = SkipWhitespace(p, end);
+  return (p == end) || (*p != '\0' && std::strchr(comments, *p) != NULL);
+}
+
+//! Return whether or not value is a valid index, when indices start at base.
+inline bool IsIndex(const double value, const double base)
+{
+  return (value >= base) && (value == std::floor(value)) &&
+      (value < (double) std::numeric_limits<arma::uword>::max());
+}
+
+/**
+ * Parse lines of "row column value" (or just "row column", for patterns) for
+ * LoadCoordinateText() and LoadMatrixMarketText().  Each line is one entry.
+ */
+template<typename eT>
+class CoordinateLineParser
+{
+ public:
+  /**
+   * Create the parser.
+   *
+   * @param pattern If true, lines have no values, and every value is one.
+   * @param base Index of the first row and column (0 or 1).
+   */
+  CoordinateLineParser(const bool pattern, const arma::uword base) :
+      pattern(pattern), base(base) { }
+
+  //! Return whether or not the line holds no entries.
+  bool Blank(const char* line, const char* end) const
+  {
+    return IsBlankLine(line, end, "%#");
+  }
+
+  //! Return the number of entries of a line that isn't blank.
+  size_t Entries(const char* /* line */, const char* /* end */) const
+  {
+    return 1;
+  }
+
+  //! Parse the entries of the line; return their number or size_t(-1).
+  size_t Parse(const char* line,
+               const char* end,
+               const size_t /* point */,
+               arma::uword* locations,
+               eT* values,
+               double& /* label */) const
+  {
+    double entry[3];
+    const size_t numValues = pattern ? 2 : 3;
+    if (ParseLine<double>(line, end, entry, 1, numValues) != numValues)
+      return size_t(-1);
+
+    for (size_t i = 0; i < 2; ++i)
+    {
+      if (!IsIndex(entry[i], (double) base))
+        return size_t(-1);
+      locations[i] = arma::uword(entry[i]) - base;
+    }
+    values[0] = pattern ? eT(1) : eT(entry[2]);
+
+    return 1;
+  }
+
+ private:
+  //! If true, lines have no values.
+  bool pattern;
+  //! Index of the first row and column.
+  arma::uword base;
+};
+
+/**
+ * Parse lines of "label index:value index:value ..." for LoadLibSVMText().
+ * Each line is one point (the row of its entries).
+ */
+template<typename eT>
+class LibSVMLineParser
+{
+ public:
+  //! Return whether or not the line holds no point.
+  bool Blank(const char* line, const char* end) const
+  {
+    end = StripComment(line, end);
+    return SkipWhitespace(line, end) == end;
+  }
+
+  //! Return the number of entries of a line that isn't blank.
+  size_t Entries(const char* line, const char* end) const
+  {
+    end = StripComment(line, end);
+    size_t count = 0;
+    for (const char* p = line; p < end; ++p)
+      if (*p == ':' && !IsQid(line, p))
+        ++count;
+    return count;
+  }
+
+  //! Parse the entries of the line; return their number or size_t(-1).
+  size_t Parse(const char* line,
+               const char* end,
+               const size_t point,
+               arma::uword* locations,
+               eT* values,
+               double& label) const
+  {
+    end = StripComment(line, end);
+    const char* p = SkipWhitespace(line, end);
+    const char* next;
+    if (!ParseNumber(p, end, label, next) || (next < end && !IsSpace(*next)))
+      return size_t(-1);
+
+    size_t count = 0;
+    p = SkipWhitespace(next, end);
+    while (p < end)
+    {
+      const char* tokenEnd = p;
+      while (tokenEnd < end && !IsSpace(*tokenEnd))
+        ++tokenEnd;
+
+      if (tokenEnd - p > 4 && std::memcmp(p, "qid:", 4) == 0)
+      {
+        p = SkipWhitespace(tokenEnd, end);
+        continue;
+      }
+
+      double index, value;
+      if (!ParseNumber(p, tokenEnd, index, next) || next == tokenEnd ||
+          *next != ':' || !IsIndex(index, 1.0))
+        return size_t(-1);
+      if (!ParseNumber(next + 1, tokenEnd, value, next) || next != tokenEnd)
+        return size_t(-1);
+
+      locations[2 * count] = point;
+      locations[2 * count + 1] = arma::uword(index) - 1;
+      values[count] = eT(value);
+      ++count;
+
+      p = SkipWhitespace(tokenEnd, end);
+    }
+
+    return count;
+  }
+
+ private:
+  //! Return the start of the comment of the line, or its end.
+  static const char* StripComment(const char* line, const char* end)
+  {
+    const char* hash = (const char*) std::memchr(line, '#', end - line);
+    return (hash == NULL) ? end : hash;
+  }
+
+  //! Return whether or not c separates tokens.
+  static bool IsSpace(const char c)
+  {
+    return (c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f');
+  }
+
+  //! Return whether or not the colon at p ends a "qid" token.
+  static bool IsQid(const char* line, const char* p)
+  {
+    return (p - line >= 3) && (std::memcmp(p - 3, "qid", 3) == 0) &&
+        (p - 3 == line || IsSpace(*(p - 4)));
+  }
+};
+
+/**
+ * Parse the lines of [begin, end) with the given line parser, with one thread
+ * per part of the text (see SplitLines()).  Each thread first counts the
+ * entries and points of its part, and then parses them straight into their
+ * place.  The entries are stored as (row, column) pairs in locations and in
+ * values, in the order of the file, and the label of each point in labels.  A
+ * std::runtime_error is thrown if a line cannot be parsed.
+ *
+ * @param filename Name of the file (for errors).
+ * @param file Start of the file (for the line numbers of errors).
+ * @param begin Start of the text to parse.
+ * @param end End of the text to parse.
+ * @return The number of points.
+ */
+template<typename eT, typename LineParser>
+size_t ParseSparseText(const std::string& filename,
+                       const char* file,
+                       const char* begin,
+                       const char* end,
+                       const LineParser& parser,
+                       arma::umat& locations,
+                       arma::Col<eT>& values,
+                       arma::rowvec& labels)
+{
+  const std::vector<const char*> parts = SplitLines(begin, end);
+  const size_t numParts = parts.size() - 1;
+
+  // Count the entries and points of each part.
+  std::vector<size_t> partEntries(numParts + 1, 0);
+  std::vector<size_t> partPoints(numParts + 1, 0);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < numParts; ++i)
+  {
+    size_t entries = 0;
+    size_t points = 0;
+    for (const char* line = parts[i]; line < parts[i + 1]; )
+    {
+      const char* lineEnd = LineEnd(line, parts[i + 1]);
+      if (!parser.Blank(line, lineEnd))
+      {
+        entries += parser.Entries(line, lineEnd);
+        ++points;
+      }
+      line = lineEnd + 1;
+    }
+
+    partEntries[i + 1] = entries;
+    partPoints[i + 1] = points;
+  }
+
+  // Now partEntries[i] and partPoints[i] are the indices of the first entry
+  // and point of the i'th part.
+  for (size_t i = 1; i <= numParts; ++i)
+  {
+    partEntries[i] += partEntries[i - 1];
+    partPoints[i] += partPoints[i - 1];
+  }
+
+  locations.set_size(2, partEntries[numParts]);
+  values.set_size(partEntries[numParts]);
+  labels.set_size(partPoints[numParts]);
+
+  // Parse each part straight into its place.
+  std::vector<const char*> badLines(numParts, (const char*) NULL);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < numParts; ++i)
+  {
+    size_t entry = partEntries[i];
+    size_t point = partPoints[i];
+    for (const char* line = parts[i]; line < parts[i + 1]; )
+    {
+      const char* lineEnd = LineEnd(line, parts[i + 1]);
+      if (!parser.Blank(line, lineEnd))
+      {
+        const size_t entries = parser.Entries(line, lineEnd);
+        double label = 0.0;
+        if (parser.Parse(line, lineEnd, point, locations.memptr() + 2 * entry,
+            values.memptr() + entry, label) != entries)
+        {
+          badLines[i] = line;
+          break;
+        }
+
+        labels[point] = label;
+        entry += entries;
+        ++point;
+      }
+      line = lineEnd + 1;
+    }
+  }
+
+  for (size_t i = 0; i < numParts; ++i)
+  {
+    if (badLines[i] != NULL)
+    {
+      std::ostringstream oss;
+      oss << "line " << (std::count(file, badLines[i], '\n') + 1) << " of '"
+          << filename << "' is malformed";
+      throw std::runtime_error(oss.str());
+    }
+  }
+
+  return partPoints[numParts];
+}
+
+/**
+ * Fill the matrix with the given entries, which may be in any order; entries
+ * whose value is zero are left out.  If transpose is true, the rows and columns
+ * of the entries (and the matrix) are swapped.  A std::runtime_error is thrown
+ * if a location is given twice.
+ */
+template<typename eT>
+void BuildSparseMatrix(const std::string& filename,
+                       const arma::umat& locations,
+                       const arma::Col<eT>& values,
+                       const size_t nRows,
+                       const size_t nCols,
+                       const bool transpose,
+                       arma::SpMat<eT>& matrix)
+{
+  // The row of each entry is locations(r, i), and its column is
+  // locations(c, i).
+  const size_t r = transpose ? 1 : 0;
+  const size_t c = 1 - r;
+
+  // The compressed sparse columns need the entries in order of column and then
+  // row; files written by a program are often in that order already.
+  const size_t n = locations.n_cols;
+  std::vector<arma::uword> order(n);
+  for (size_t i = 0; i < n; ++i)
+    order[i] = i;
+
+  bool sorted = true;
+  for (size_t i = 1; i < n && sorted; ++i)
+    sorted = (locations(c, i - 1) < locations(c, i)) ||
+        (locations(c, i - 1) == locations(c, i) &&
+         locations(r, i - 1) < locations(r, i));
+
+  if (!sorted)
+  {
+    std::sort(order.begin(), order.end(),
+        [&](const arma::uword a, const arma::uword b)
+        {
+          return (locations(c, a) < locations(c, b)) ||
+              (locations(c, a) == locations(c, b) &&
+               locations(r, a) < locations(r, b));
+        });
+  }
+
+  size_t nonzeros = 0;
+  for (size_t i = 0; i < n; ++i)
+  {
+    if (i > 0 && locations(r, order[i]) == locations(r, order[i - 1]) &&
+        locations(c, order[i]) == locations(c, order[i - 1]))
+    {
+      std::ostringstream oss;
+      oss << "'" << filename << "' holds location (" << locations(0, order[i])
+          << ", " << locations(1, order[i]) << ") more than once";
+      throw std::runtime_error(oss.str());
+    }
+
+    if (values[order[i]] != eT(0))
+      ++nonzeros;
+  }
+
+  arma::umat sortedLocations(2, nonzeros);
+  arma::Col<eT> sortedValues(nonzeros);
+  for (size_t i = 0, j = 0; i < n; ++i)
+  {
+    if (values[order[i]] == eT(0))
+      continue;
+
+    sortedLocations(0, j) = locations(r, order[i]);
+    sortedLocations(1, j) = locations(c, order[i]);
+    sortedValues[j] = values[order[i]];
+    ++j;
+  }
+
+  matrix = arma::SpMat<eT>(sortedLocations, sortedValues,
+      transpose ? nCols : nRows, transpose ? nRows : nCols, false);
+}
+
+template<typename eT>
+void LoadCoordinateText(const std::string& filename,
+                        arma::SpMat<eT>& matrix,
+                        const bool transpose)
+{
+  const MappedTextFile file(filename);
+  const char* begin = file.Data();
+  const char* end = begin + file.Length();
+
+  arma::umat locations;
+  arma::Col<eT> values;
+  arma::rowvec labels;
+  ParseSparseText(filename, begin, begin, end,
+      CoordinateLineParser<eT>(false, 0), locations, values, labels);
+
+  size_t nRows = 0;
+  size_t nCols = 0;
+  if (locations.n_cols > 0)
+  {
+    nRows = (size_t) arma::max(locations.row(0)) + 1;
+    nCols = (size_t) arma::max(locations.row(1)) + 1;
+  }
+
+  BuildSparseMatrix(filename, locations, values, nRows, nCols, transpose,
+      matrix);
+}
+
+template<typename eT>
+void LoadMatrixMarketText(const std::string& filename,
+                          arma::SpMat<eT>& matrix,
+                          const bool transpose)
+{
+  const MappedTextFile file(filename);
+  const char* begin = file.Data();
+  const char* end = begin + file.Length();
+
+  // The banner is "%%MatrixMarket matrix <format> <field> <symmetry>"; all but
+  // the first word are case-insensitive.
+  const char* lineEnd = LineEnd(begin, end);
+  std::istringstream bannerStream(std::string(begin, lineEnd));
+  std::string banner, object, format, field, symmetry;
+  bannerStream >> banner >> object >> format >> field >> symmetry;
+  std::transform(object.begin(), object.end(), object.begin(), ::tolower);
+  std::transform(format.begin(), format.end(), format.begin(), ::tolower);
+  std::transform(field.begin(), field.end(), field.begin(), ::tolower);
+  std::transform(symmetry.begin(), symmetry.end(), symmetry.begin(),
+      ::tolower);
+
+  if (banner != "%%MatrixMarket" || object != "matrix")
+    throw std::runtime_error("'" + filename + "' is not a Matrix Market file");
+  if (format != "coordinate")
+    throw std::runtime_error("'" + filename + "' is a dense (" + format +
+        ") Matrix Market file; only the coordinate format is supported");
+  if (field != "real" && field != "double" && field != "integer" &&
+      field != "pattern")
+    throw std::runtime_error("'" + filename + "' holds " + field + " values;"
+        " only real, integer, and pattern files are supported");
+  if (symmetry != "general" && symmetry != "symmetric" &&
+      symmetry != "skew-symmetric")
+    throw std::runtime_error("'" + filename + "' is " + symmetry + "; only "
+        "general, symmetric, and skew-symmetric files are supported");
+
+  // After the comments comes the size line, "rows columns entries".
+  const char* p = lineEnd + 1;
+  while (p < end && IsBlankLine(p, LineEnd(p, end), "%"))
+    p = LineEnd(p, end) + 1;
+
+  double size[3];
+  if (p >= end || ParseLine<double>(p, LineEnd(p, end), size, 1, 3) != 3 ||
+      !IsIndex(size[0], 0.0) || !IsIndex(size[1], 0.0) ||
+      !IsIndex(size[2], 0.0))
+    throw std::runtime_error("'" + filename + "' has no valid size line");
+
+  const size_t nRows = (size_t) size[0];
+  const size_t nCols = (size_t) size[1];
+  const size_t numEntries = (size_t) size[2];
+  const bool symmetric = (symmetry != "general");
+  if (symmetric && nRows != nCols)
+    throw std::runtime_error("'" + filename + "' is " + symmetry + " but not "
+        "square");
+
+  arma::umat locations;
+  arma::Col<eT> values;
+  arma::rowvec labels;
+  const char* entries = std::min(LineEnd(p, end) + 1, end);
+  ParseSparseText(filename, begin, entries, end,
+      CoordinateLineParser<eT>(field == "pattern", 1), locations, values,
+      labels);
+
+  if (locations.n_cols != numEntries)
+  {
+    std::ostringstream oss;
+    oss << "'" << filename << "' holds " << locations.n_cols << " entries, "
+        << "but its size line gives " << numEntries;
+    throw std::runtime_error(oss.str());
+  }
+
+  size_t offDiagonal = 0;
+  for (size_t i = 0; i < numEntries; ++i)
+  {
+    if (locations(0, i) >= nRows || locations(1, i) >= nCols)
+    {
+      std::ostringstream oss;
+      oss << "entry (" << (locations(0, i) + 1) << ", "
+          << (locations(1, i) + 1) << ") of '" << filename << "' is outside "
+          << "of the " << nRows << "x" << nCols << " matrix";
+      throw std::runtime_error(oss.str());
+    }
+
+    if (locations(0, i) != locations(1, i))
+      ++offDiagonal;
+  }
+
+  // Only one triangle of a symmetric matrix is stored, so mirror the entries
+  // off the diagonal to the other one.
+  if (symmetric && offDiagonal > 0)
+  {
+    const bool skew = (symmetry == "skew-symmetric");
+    locations.resize(2, numEntries + offDiagonal);
+    values.resize(numEntries + offDiagonal);
+    for (size_t i = 0, j = numEntries; i < numEntries; ++i)
+    {
+      if (locations(0, i) == locations(1, i))
+        continue;
+
+      locations(0, j) = locations(1, i);
+      locations(1, j) = locations(0, i);
+      values[j] = skew ? eT(-values[i]) : values[i];
+      ++j;
+    }
+  }
+
+  BuildSparseMatrix(filename, locations, values, nRows, nCols, transpose,
+      matrix);
+}
+
+template<typename eT>
+void LoadLibSVMText(const std::string& filename,
+                    arma::SpMat<eT>& matrix,
+                    arma::rowvec& labels,
+                    const bool transpose)
+{
+  const MappedTextFile file(filename);
+  const char* begin = file.Data();
+  const char* end = begin + file.Length();
+
+  arma::umat locations;
+  arma::Col<eT> values;
+  const size_t numPoints = ParseSparseText(filename, begin, begin, end,
+      LibSVMLineParser<eT>(), locations, values, labels);
+
+  const size_t numFeatures = (locations.n_cols == 0) ? 0 :
+      (size_t) arma::max(locations.row(1)) + 1;
+
+  BuildSparseMatrix(filename, locations, values, numPoints, numFeatures,
+      transpose, matrix);
+}
+
+} // namespace data
+} // namespace mlpack
+
+#endif
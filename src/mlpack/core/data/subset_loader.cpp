@@ -0,0 +1,357 @@
+/**
+ * @file subset_loader.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of LoadSubset(), which reads only a subset of a dataset.
+ */
+#include "subset_loader.hpp"
+#include "extension.hpp"
+#include "compressed_file.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifdef ARMA_USE_HDF5
+  #include <hdf5.h>
+#endif
+
+using namespace mlpack;
+using namespace mlpack::data;
+
+size_t Subset::NumPoints(const size_t numPoints) const
+{
+  if (stride == 0)
+    throw std::invalid_argument("Subset: stride must be positive");
+
+  if (first > numPoints)
+  {
+    std::ostringstream oss;
+    oss << "Subset: the first point (" << first << ") is past the end of the "
+        << "dataset, which holds " << numPoints << " points";
+    throw std::runtime_error(oss.str());
+  }
+
+  const size_t available = (numPoints - first + stride - 1) / stride;
+  return std::min(count, available);
+}
+
+std::vector<size_t> Subset::Dimensions(const size_t dimensionality) const
+{
+  if (dimensions.empty())
+  {
+    std::vector<size_t> all(dimensionality);
+    for (size_t i = 0; i < dimensionality; ++i)
+      all[i] = i;
+    return all;
+  }
+
+  for (size_t i = 0; i < dimensions.size(); ++i)
+  {
+    if (dimensions[i] >= dimensionality)
+    {
+      std::ostringstream oss;
+      oss << "Subset: dimension " << dimensions[i] << " is out of range for "
+          << "points of dimensionality " << dimensionality;
+      throw std::runtime_error(oss.str());
+    }
+  }
+
+  return dimensions;
+}
+
+namespace {
+
+/**
+ * Read the given dimension of the points in the subset from an arma_binary
+ * file holding elements of type T, into the given row of the matrix.  The file
+ * matrix holds one point per row, so each dimension is a contiguous column of
+ * the file.
+ */
+template<typename T>
+void ReadDimension(std::ifstream& stream,
+                   const std::string& filename,
+                   const std::streampos dataStart,
+                   const size_t filePoints,
+                   const size_t dimension,
+                   const Subset& subset,
+                   const size_t row,
+                   arma::mat& matrix)
+{
+  // Points that are close together are read in blocks of about a megabyte, and
+  // picked out of the block; points that are far apart are read one at a time.
+  const size_t distance = subset.stride * sizeof(T);
+  const size_t perBlock = (distance > 4096) ? 1 :
+      std::max((size_t) 1, (size_t) (1 << 20) / distance);
+
+  std::vector<T> block;
+  for (size_t i = 0; i < matrix.n_cols; i += perBlock)
+  {
+    const size_t points = std::min(perBlock, (size_t) matrix.n_cols - i);
+    const size_t length = (points - 1) * subset.stride + 1;
+    const size_t element = dimension * filePoints + subset.first +
+        i * subset.stride;
+
+    block.resize(length);
+    stream.seekg(dataStart + std::streamoff(element * sizeof(T)));
+    stream.read((char*) &block[0], length * sizeof(T));
+    if ((size_t) stream.gcount() != length * sizeof(T))
+      throw std::runtime_error("unexpected end of '" + filename + "'");
+
+    for (size_t k = 0; k < points; ++k)
+      matrix(row, i + k) = (double) block[k * subset.stride];
+  }
+}
+
+//! Read the subset of an arma_binary file holding elements of type T.
+template<typename T>
+void LoadArmaBinarySubset(std::ifstream& stream,
+                          const std::string& filename,
+                          const size_t filePoints,
+                          const size_t dimensionality,
+                          const Subset& subset,
+                          arma::mat& matrix)
+{
+  const std::streampos dataStart = stream.tellg();
+  stream.seekg(0, std::ios::end);
+  const size_t length = (size_t) (stream.tellg() - dataStart);
+  if (length < filePoints * dimensionality * sizeof(T))
+    throw std::runtime_error("unexpected end of '" + filename + "'");
+
+  const size_t numPoints = subset.NumPoints(filePoints);
+  const std::vector<size_t> dimensions = subset.Dimensions(dimensionality);
+
+  matrix.set_size(dimensions.size(), numPoints);
+  if (numPoints == 0)
+    return;
+
+  for (size_t j = 0; j < dimensions.size(); ++j)
+    ReadDimension<T>(stream, filename, dataStart, filePoints, dimensions[j],
+        subset, j, matrix);
+}
+
+//! Read the subset of an arma_binary file.  Return false if the file is not in
+//! arma_binary format.
+bool LoadArmaBinary(const std::string& filename,
+                    const Subset& subset,
+                    arma::mat& matrix)
+{
+  std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    throw std::runtime_error("cannot open '" + filename + "'");
+
+  // The header is "ARMA_MAT_BIN_<type>\n<rows> <cols>\n".
+  std::string magic;
+  size_t rows, cols;
+  if (!(stream >> magic) || magic.compare(0, 13, "ARMA_MAT_BIN_") != 0)
+    return false;
+  if (!(stream >> rows >> cols))
+    throw std::runtime_error("'" + filename + "' has a malformed arma_binary "
+        "header");
+
+  // Skip the single whitespace character after the number of columns.
+  stream.get();
+
+  const std::string type = magic.substr(13);
+  if (type == "FN008")
+    LoadArmaBinarySubset<double>(stream, filename, rows, cols, subset, matrix);
+  else if (type == "FN004")
+    LoadArmaBinarySubset<float>(stream, filename, rows, cols, subset, matrix);
+  else if (type == "IU008")
+    LoadArmaBinarySubset<arma::u64>(stream, filename, rows, cols, subset,
+        matrix);
+  else if (type == "IS008")
+    LoadArmaBinarySubset<arma::s64>(stream, filename, rows, cols, subset,
+        matrix);
+  else if (type == "IU004")
+    LoadArmaBinarySubset<arma::u32>(stream, filename, rows, cols, subset,
+        matrix);
+  else if (type == "IS004")
+    LoadArmaBinarySubset<arma::s32>(stream, filename, rows, cols, subset,
+        matrix);
+  else if (type == "IU002")
+    LoadArmaBinarySubset<arma::u16>(stream, filename, rows, cols, subset,
+        matrix);
+  else if (type == "IS002")
+    LoadArmaBinarySubset<arma::s16>(stream, filename, rows, cols, subset,
+        matrix);
+  else if (type == "IU001")
+    LoadArmaBinarySubset<arma::u8>(stream, filename, rows, cols, subset,
+        matrix);
+  else if (type == "IS001")
+    LoadArmaBinarySubset<arma::s8>(stream, filename, rows, cols, subset,
+        matrix);
+  else
+    throw std::runtime_error("'" + filename + "' holds arma_binary elements "
+        "of unsupported type " + type);
+
+  return true;
+}
+
+#ifdef ARMA_USE_HDF5
+
+//! Open the dataset of an HDF5 file, as Armadillo names it.
+hid_t OpenDataset(const hid_t file)
+{
+  // Don't let HDF5 print errors for the names that aren't there.
+  H5E_auto2_t oldHandler;
+  void* oldData;
+  H5Eget_auto2(H5E_DEFAULT, &oldHandler, &oldData);
+  H5Eset_auto2(H5E_DEFAULT, NULL, NULL);
+
+  hid_t dataset = H5Dopen2(file, "dataset", H5P_DEFAULT);
+  if (dataset < 0)
+    dataset = H5Dopen2(file, "value", H5P_DEFAULT);
+
+  H5Eset_auto2(H5E_DEFAULT, oldHandler, oldData);
+  return dataset;
+}
+
+//! Read the subset of an HDF5 file with a hyperslab selection.
+void LoadHDF5(const std::string& filename,
+              const Subset& subset,
+              arma::mat& matrix)
+{
+  const hid_t file = H5Fopen(filename.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  if (file < 0)
+    throw std::runtime_error("cannot open '" + filename + "'");
+
+  const hid_t dataset = OpenDataset(file);
+  if (dataset < 0)
+  {
+    H5Fclose(file);
+    throw std::runtime_error("'" + filename + "' holds no dataset named "
+        "'dataset' or 'value'");
+  }
+
+  // Armadillo stores an n_rows x n_cols matrix with the dimensions
+  // { n_cols, n_rows }; the points are the rows of that matrix, so the first
+  // dimension is the dimensionality of the points, and a vector (of rank 1)
+  // holds one point of dimensionality 1 per element.
+  const hid_t fileSpace = H5Dget_space(dataset);
+  const int rank = H5Sget_simple_extent_ndims(fileSpace);
+  hsize_t dims[2] = { 1, 1 };
+  if (rank == 1 || rank == 2)
+    H5Sget_simple_extent_dims(fileSpace, dims, NULL);
+
+  size_t numPoints = 0;
+  std::vector<size_t> dimensions;
+  try
+  {
+    if (rank != 1 && rank != 2)
+      throw std::runtime_error("the dataset of '" + filename + "' is not a "
+          "matrix");
+
+    const size_t filePoints = (rank == 1) ? dims[0] : dims[1];
+    numPoints = subset.NumPoints(filePoints);
+    dimensions = subset.Dimensions((rank == 1) ? 1 : dims[0]);
+  }
+  catch (...)
+  {
+    H5Sclose(fileSpace);
+    H5Dclose(dataset);
+    H5Fclose(file);
+    throw;
+  }
+
+  matrix.set_size(dimensions.size(), numPoints);
+  if (numPoints == 0 || dimensions.empty())
+  {
+    H5Sclose(fileSpace);
+    H5Dclose(dataset);
+    H5Fclose(file);
+    return;
+  }
+
+  // A hyperslab is read in the order of the file, not in the order it was
+  // selected in; so, select each of the (sorted and unique) dimensions, and
+  // then put them in the requested order.
+  std::vector<size_t> sorted(dimensions);
+  std::sort(sorted.begin(), sorted.end());
+  sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+  hsize_t counts[2];
+  if (rank == 1)
+  {
+    hsize_t start[1] = { (hsize_t) subset.first };
+    hsize_t stride[1] = { (hsize_t) subset.stride };
+    counts[0] = (hsize_t) numPoints;
+    H5Sselect_hyperslab(fileSpace, H5S_SELECT_SET, start, stride, counts,
+        NULL);
+  }
+  else
+  {
+    hsize_t stride[2] = { 1, (hsize_t) subset.stride };
+    hsize_t count[2] = { 1, (hsize_t) numPoints };
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+      hsize_t start[2] = { (hsize_t) sorted[i], (hsize_t) subset.first };
+      H5Sselect_hyperslab(fileSpace, (i == 0) ? H5S_SELECT_SET : H5S_SELECT_OR,
+          start, stride, count, NULL);
+    }
+
+    counts[0] = (hsize_t) sorted.size();
+    counts[1] = (hsize_t) numPoints;
+  }
+
+  // The selection is read in row-major order, which makes it the transpose of
+  // the points.
+  const hid_t memSpace = H5Screate_simple(rank, counts, NULL);
+  arma::mat transposed(numPoints, sorted.size());
+  const herr_t status = H5Dread(dataset, H5T_NATIVE_DOUBLE, memSpace,
+      fileSpace, H5P_DEFAULT, transposed.memptr());
+
+  H5Sclose(memSpace);
+  H5Sclose(fileSpace);
+  H5Dclose(dataset);
+  H5Fclose(file);
+
+  if (status < 0)
+    throw std::runtime_error("cannot read '" + filename + "'");
+
+  for (size_t j = 0; j < dimensions.size(); ++j)
+  {
+    const size_t col = std::lower_bound(sorted.begin(), sorted.end(),
+        dimensions[j]) - sorted.begin();
+    matrix.row(j) = arma::trans(transposed.col(col));
+  }
+}
+
+#else
+
+void LoadHDF5(const std::string& filename,
+              const Subset& /* subset */,
+              arma::mat& /* matrix */)
+{
+  throw std::runtime_error("cannot read '" + filename + "' because Armadillo "
+      "was compiled without HDF5 support");
+}
+
+#endif
+
+} // anonymous namespace
+
+bool mlpack::data::LoadSubset(const std::string& filename,
+                              const Subset& subset,
+                              arma::mat& matrix)
+{
+  // A compressed file has to be decompressed whole anyway.
+  if (IsCompressed(filename))
+    return false;
+
+  const std::string extension = Extension(filename);
+  if (extension == "h5" || extension == "hdf5" || extension == "hdf" ||
+      extension == "he5")
+  {
+    LoadHDF5(filename, subset, matrix);
+    return true;
+  }
+  else if (extension == "bin")
+  {
+    // A raw_binary file does not hold its size, so it is loaded whole.
+    return LoadArmaBinary(filename, subset, matrix);
+  }
+
+  return false;
+}
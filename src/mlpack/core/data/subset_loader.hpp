@@ -0,0 +1,121 @@
+/**
+ * @file subset_loader.hpp
+ * @author Ryan Curtin
+ *
+ * Load only a subset of the points and dimensions of a dataset, for
+ * data::Load() with a Subset.
+ */
+#ifndef __MLPACK_CORE_DATA_SUBSET_LOADER_HPP
+#define __MLPACK_CORE_DATA_SUBSET_LOADER_HPP
+
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * A subset of a dataset to load with data::Load().  The points (the rows of
+ * the file, which are the columns of the loaded matrix) that are loaded are
+ * first, first + stride, first + 2 * stride, ..., up to count points or the
+ * end of the dataset; of each point, only the given dimensions (the columns of
+ * the file) are loaded, in the given order.  So, with the defaults, the whole
+ * dataset is loaded.
+ *
+ * @code
+ * // Load the second of four shards of the dataset, with three of its
+ * // features.
+ * data::Subset subset;
+ * subset.first = 1;
+ * subset.stride = 4;
+ * subset.dimensions.push_back(0);
+ * subset.dimensions.push_back(5);
+ * subset.dimensions.push_back(2);
+ * arma::mat shard;
+ * data::Load("dataset.h5", shard, subset);
+ * @endcode
+ */
+struct Subset
+{
+  //! Load the whole dataset.
+  Subset() :
+      first(0),
+      count(std::numeric_limits<size_t>::max()),
+      stride(1)
+  { }
+
+  //! The index of the first point to load.
+  size_t first;
+  //! The maximum number of points to load.
+  size_t count;
+  //! The distance between consecutive points to load (1 loads a range).
+  size_t stride;
+  //! The dimensions to load, in order; if empty, all of them are loaded.
+  std::vector<size_t> dimensions;
+
+  /**
+   * Get the number of points of a dataset with numPoints points that are in
+   * the subset.  A std::invalid_argument is thrown if the stride is 0, and a
+   * std::runtime_error if the first point is past the end of the dataset.
+   */
+  size_t NumPoints(const size_t numPoints) const;
+
+  /**
+   * Get the dimensions of a dataset with the given dimensionality that are in
+   * the subset.  A std::runtime_error is thrown if a dimension is out of range.
+   */
+  std::vector<size_t> Dimensions(const size_t dimensionality) const;
+};
+
+/**
+ * Load the given subset of a dataset, reading only the parts of the file that
+ * hold it, if the file supports that.  This is the case for HDF5 files, which
+ * are read with a hyperslab selection, and for arma_binary files, which are
+ * read with one seek (and one read of the range of the points) per dimension.
+ * As for data::Load(), the points are the rows of the file, and the columns of
+ * the loaded matrix.
+ *
+ * A std::runtime_error (or std::invalid_argument) is thrown if the file cannot
+ * be read or the subset is invalid for it.
+ *
+ * @param filename Name of the file to load.
+ * @param subset The subset of the dataset to load.
+ * @param matrix Matrix to load the subset into.
+ * @return false if the file is not one that subsets can be read from (so it has
+ *     to be loaded whole).
+ */
+bool LoadSubset(const std::string& filename,
+                const Subset& subset,
+                arma::mat& matrix);
+
+/**
+ * Copy the given subset of a loaded dataset, which holds one point per column,
+ * into the given matrix.
+ *
+ * @param dataset The whole dataset.
+ * @param subset The subset of the dataset to copy.
+ * @param matrix Matrix to copy the subset into.
+ */
+template<typename eT>
+void SelectSubset(const arma::Mat<eT>& dataset,
+                  const Subset& subset,
+                  arma::Mat<eT>& matrix)
+{
+  const size_t numPoints = subset.NumPoints(dataset.n_cols);
+  const std::vector<size_t> dimensions = subset.Dimensions(dataset.n_rows);
+
+  matrix.set_size(dimensions.size(), numPoints);
+  for (size_t i = 0; i < numPoints; ++i)
+  {
+    const eT* point = dataset.colptr(subset.first + i * subset.stride);
+    for (size_t j = 0; j < dimensions.size(); ++j)
+      matrix(j, i) = point[dimensions[j]];
+  }
+}
+
+} // namespace data
+} // namespace mlpack
+
+#endif
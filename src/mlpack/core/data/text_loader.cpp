@@ -0,0 +1,510 @@
+/**
+ * @file text_loader.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of MappedTextFile and ParseNumber(), for the parallel text
+ * loader.
+ */
+#include "text_loader.hpp"
+#include "compressed_file.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+using namespace mlpack;
+using namespace mlpack::data;
+
+MappedTextFile::MappedTextFile(const std::string& filename) :
+    data(NULL),
+    length(0),
+    mapped(false)
+{
+  // A compressed file is decompressed into memory instead.
+  if (IsCompressed(filename))
+  {
+    Decompress(filename, buffer);
+    length = buffer.size();
+    data = (length > 0) ? &buffer[0] : NULL;
+    return;
+  }
+
+#ifndef _WIN32
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd == -1)
+  {
+    std::ostringstream oss;
+    oss << "MappedTextFile: cannot open '" << filename << "': "
+        << std::strerror(errno);
+    throw std::runtime_error(oss.str());
+  }
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) == -1)
+  {
+    close(fd);
+    std::ostringstream oss;
+    oss << "MappedTextFile: cannot stat '" << filename << "': "
+        << std::strerror(errno);
+    throw std::runtime_error(oss.str());
+  }
+  length = (size_t) fileStat.st_size;
+
+  // An empty file can't be mapped, but there is nothing to parse anyway.
+  if (length == 0)
+  {
+    close(fd);
+    return;
+  }
+
+  void* mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd); // The mapping holds its own reference to the file.
+  if (mapping == MAP_FAILED)
+  {
+    std::ostringstream oss;
+    oss << "MappedTextFile: cannot map '" << filename << "': "
+        << std::strerror(errno);
+    throw std::runtime_error(oss.str());
+  }
+
+  // The file is read front to back.
+  madvise(mapping, length, MADV_SEQUENTIAL);
+
+  data = (const char*) mapping;
+  mapped = true;
+#else
+  std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+  if (!stream.is_open())
+    throw std::runtime_error("MappedTextFile: cannot open '" + filename + "'");
+
+  stream.seekg(0, std::ios::end);
+  length = (size_t) stream.tellg();
+  stream.seekg(0, std::ios::beg);
+
+  buffer.resize(length);
+  if (length > 0 && !stream.read(&buffer[0], length))
+    throw std::runtime_error("MappedTextFile: cannot read '" + filename + "'");
+
+  data = (length > 0) ? &buffer[0] : NULL;
+#endif
+}
+
+MappedTextFile::~MappedTextFile()
+{
+#ifndef _WIN32
+  if (mapped)
+    munmap((void*) data, length);
+#endif
+}
+
+std::vector<const char*> mlpack::data::SplitLines(const char* begin,
+                                                 const char* end)
+{
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+  const size_t minPartLength = 1 << 20;
+  const size_t numParts = std::max((size_t) 1, std::min(4 * numThreads,
+      (size_t) (end - begin) / minPartLength));
+
+  std::vector<const char*> parts(numParts + 1);
+  parts[0] = begin;
+  parts[numParts] = end;
+  for (size_t i = 1; i < numParts; ++i)
+  {
+    const char* p = std::max(parts[i - 1], begin + (i * (end - begin)) /
+        numParts);
+    const char* newline = (const char*) std::memchr(p, '\n', end - p);
+    parts[i] = (newline == NULL) ? end : newline + 1;
+  }
+
+  return parts;
+}
+
+namespace {
+
+//! Return whether or not c ends a value.
+inline bool EndsValue(const char c)
+{
+  return (c == ',' || c == ' ' || c == '\t' || c == '\r' || c == '\n' ||
+      c == '\v' || c == '\f');
+}
+
+//! Parse the number at p with std::strtod().
+bool ParseWithStrtod(const char* p,
+                     const char* end,
+                     double& value,
+                     const char*& next)
+{
+  // The contents of the file are not null-terminated, so the value is copied
+  // first.  No number that anyone writes is longer than this.
+  char token[128];
+  size_t length = 0;
+  while (p + length < end && length < sizeof(token) - 1 &&
+      !EndsValue(p[length]))
+  {
+    token[length] = p[length];
+    ++length;
+  }
+  token[length] = '\0';
+
+  char* tokenEnd;
+  value = std::strtod(token, &tokenEnd);
+  if (tokenEnd == token)
+    return false;
+
+  next = p + (tokenEnd - token);
+  return true;
+}
+
+} // anonymous namespace
+
+bool mlpack::data::ParseNumber(const char* p,
+                               const char* end,
+                               double& value,
+                               const char*& next)
+{
+  // The powers of ten that are exact as doubles.
+  static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+      1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+      1e20, 1e21, 1e22 };
+
+  const char* start = p;
+  bool negative = false;
+  if (p < end && (*p == '-' || *p == '+'))
+  {
+    negative = (*p == '-');
+    ++p;
+  }
+
+  // Read the digits into an integer mantissa, keeping track of the decimal
+  // exponent.  Leading zeros are not significant.
+  unsigned long long mantissa = 0;
+  int significantDigits = 0;
+  int exponent = 0;
+  bool anyDigits = false;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p)
+  {
+    anyDigits = true;
+    if (mantissa != 0 || *p != '0')
+    {
+      mantissa = 10 * mantissa + (*p - '0');
+      ++significantDigits;
+    }
+  }
+
+  if (p < end && *p == '.')
+  {
+    for (++p; p < end && *p >= '0' && *p <= '9'; ++p)
+    {
+      anyDigits = true;
+      if (mantissa != 0 || *p != '0')
+      {
+        mantissa = 10 * mantissa + (*p - '0');
+        ++significantDigits;
+      }
+      --exponent;
+    }
+  }
+
+  // Anything without digits (like "nan" or "inf") goes to strtod().
+  if (!anyDigits || significantDigits > 15)
+    return ParseWithStrtod(start, end, value, next);
+
+  if (p < end && (*p == 'e' || *p == 'E'))
+  {
+    const char* q = p + 1;
+    bool negativeExponent = false;
+    if (q < end && (*q == '-' || *q == '+'))
+    {
+      negativeExponent = (*q == '-');
+      ++q;
+    }
+
+    if (q == end || *q < '0' || *q > '9')
+      return ParseWithStrtod(start, end, value, next);
+
+    int e = 0;
+    for (; q < end && *q >= '0' && *q <= '9'; ++q)
+    {
+      if (e > 10000)
+        return ParseWithStrtod(start, end, value, next);
+      e = 10 * e + (*q - '0');
+    }
+
+    exponent += negativeExponent ? -e : e;
+    p = q;
+  }
+
+  // A mantissa of at most 15 digits is exact as a double, and so are the
+  // powers of ten up to 1e22; one multiplication or division of exact values is
+  // correctly rounded.  Anything else goes to strtod().
+  if (mantissa == 0)
+  {
+    value = 0.0;
+  }
+  else if (exponent >= 0 && exponent <= 22)
+  {
+    value = double(mantissa) * powers[exponent];
+  }
+  else if (exponent < 0 && exponent >= -22)
+  {
+    value = double(mantissa) / powers[-exponent];
+  }
+  else
+  {
+    return ParseWithStrtod(start, end, value, next);
+  }
+
+  if (negative)
+    value = -value;
+  next = p;
+  return true;
+}
+
+namespace {
+
+//! A value of a line of text, as its start and its length.
+typedef std::pair<const char*, size_t> Token;
+
+//! Return whether or not c is whitespace (other than a newline).
+inline bool IsWhitespace(const char c)
+{
+  return (c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f');
+}
+
+/**
+ * Split the line [p, end) into its values.  If commas is true, the values are
+ * separated by commas, and the whitespace around each is dropped; otherwise,
+ * they are separated by runs of whitespace.
+ */
+void SplitTokens(const char* p,
+                 const char* end,
+                 const bool commas,
+                 std::vector<Token>& tokens)
+{
+  tokens.clear();
+  if (commas)
+  {
+    while (true)
+    {
+      p = SkipWhitespace(p, end);
+      const char* comma = (const char*) std::memchr(p, ',', end - p);
+      const char* tokenEnd = (comma == NULL) ? end : comma;
+      const char* last = tokenEnd;
+      while (last > p && IsWhitespace(*(last - 1)))
+        --last;
+
+      tokens.push_back(Token(p, last - p));
+      if (comma == NULL)
+        break;
+      p = comma + 1;
+    }
+  }
+  else
+  {
+    for (p = SkipWhitespace(p, end); p < end; p = SkipWhitespace(p, end))
+    {
+      const char* start = p;
+      while (p < end && !IsWhitespace(*p))
+        ++p;
+      tokens.push_back(Token(start, p - start));
+    }
+  }
+}
+
+//! Return whether the token is a number, and if it is, store it in value.
+inline bool ParseToken(const Token& token, double& value)
+{
+  const char* next;
+  return token.second > 0 &&
+      ParseNumber(token.first, token.first + token.second, value, next) &&
+      next == token.first + token.second;
+}
+
+} // anonymous namespace
+
+void mlpack::data::LoadCategoricalText(const char* begin,
+                                       const char* end,
+                                       arma::mat& matrix,
+                                       DatasetInfo& info,
+                                       const bool transpose)
+{
+  // The first line that holds anything decides the separator and the number
+  // of values per line.
+  std::vector<Token> tokens;
+  bool commas = false;
+  for (const char* line = begin; line < end && tokens.empty(); )
+  {
+    const char* newline = (const char*) std::memchr(line, '\n', end - line);
+    const char* lineEnd = (newline == NULL) ? end : newline;
+    if (SkipWhitespace(line, lineEnd) != lineEnd)
+    {
+      commas = (std::memchr(line, ',', lineEnd - line) != NULL);
+      SplitTokens(line, lineEnd, commas, tokens);
+    }
+    line = lineEnd + 1;
+  }
+
+  const size_t numValues = tokens.size();
+  if (info.Dimensionality() == 0)
+  {
+    info = DatasetInfo(numValues);
+  }
+  else if (info.Dimensionality() != numValues && numValues != 0)
+  {
+    std::ostringstream oss;
+    oss << "the lines hold " << numValues << " values, but the dataset "
+        << "information has " << info.Dimensionality() << " dimensions";
+    throw std::runtime_error(oss.str());
+  }
+
+  // Split the text into parts that end at newlines, and count the lines that
+  // hold values in each part.
+  const std::vector<const char*> parts = SplitLines(begin, end);
+  const size_t numParts = parts.size() - 1;
+  std::vector<size_t> partLines(numParts + 1, 0);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < numParts; ++i)
+  {
+    size_t lines = 0;
+    for (const char* line = parts[i]; line < parts[i + 1]; )
+    {
+      const char* newline = (const char*) std::memchr(line, '\n',
+          parts[i + 1] - line);
+      const char* lineEnd = (newline == NULL) ? parts[i + 1] : newline;
+      if (SkipWhitespace(line, lineEnd) != lineEnd)
+        ++lines;
+      line = lineEnd + 1;
+    }
+
+    partLines[i + 1] = lines;
+  }
+
+  // Now partLines[i] is the index of the first line of the i'th part.
+  for (size_t i = 1; i <= numParts; ++i)
+    partLines[i] += partLines[i - 1];
+  const size_t numLines = partLines[numParts];
+
+  // Parse the numbers into their places, with each line as a column, and find
+  // the dimensions that hold strings.  badLine[i] is the first malformed line
+  // of the i'th part, if it has one.
+  arma::mat values(numValues, numLines);
+  std::vector<std::vector<char> > partStrings(numParts,
+      std::vector<char>(numValues, 0));
+  std::vector<size_t> badLine(numParts, size_t(-1));
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < numParts; ++i)
+  {
+    std::vector<Token> lineTokens;
+    size_t j = partLines[i];
+    for (const char* line = parts[i]; line < parts[i + 1]; )
+    {
+      const char* newline = (const char*) std::memchr(line, '\n',
+          parts[i + 1] - line);
+      const char* lineEnd = (newline == NULL) ? parts[i + 1] : newline;
+      if (SkipWhitespace(line, lineEnd) != lineEnd)
+      {
+        SplitTokens(line, lineEnd, commas, lineTokens);
+        if (lineTokens.size() != numValues)
+        {
+          badLine[i] = j;
+          break;
+        }
+
+        double* out = values.colptr(j);
+        for (size_t d = 0; d < numValues; ++d)
+        {
+          if (info.Type(d) == categorical || !ParseToken(lineTokens[d], out[d]))
+            partStrings[i][d] = 1;
+        }
+
+        ++j;
+      }
+      line = lineEnd + 1;
+    }
+  }
+
+  for (size_t i = 0; i < numParts; ++i)
+  {
+    if (badLine[i] != size_t(-1))
+    {
+      std::ostringstream oss;
+      oss << "line " << badLine[i] << " (not counting blank lines) does not "
+          << "hold " << numValues << " values";
+      throw std::runtime_error(oss.str());
+    }
+  }
+
+  std::vector<size_t> dimensions;
+  for (size_t d = 0; d < numValues; ++d)
+  {
+    bool strings = (info.Type(d) == categorical);
+    for (size_t i = 0; i < numParts && !strings; ++i)
+      strings = (partStrings[i][d] == 1);
+    if (strings)
+      dimensions.push_back(d);
+  }
+
+  if (!dimensions.empty())
+  {
+    // Collect the values of the categorical dimensions, in order, and then map
+    // each dimension (in parallel, since each has its own hash table).
+    std::vector<std::vector<Token> > strings(dimensions.size(),
+        std::vector<Token>(numLines));
+
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < numParts; ++i)
+    {
+      std::vector<Token> lineTokens;
+      size_t j = partLines[i];
+      for (const char* line = parts[i]; line < parts[i + 1]; )
+      {
+        const char* newline = (const char*) std::memchr(line, '\n',
+            parts[i + 1] - line);
+        const char* lineEnd = (newline == NULL) ? parts[i + 1] : newline;
+        if (SkipWhitespace(line, lineEnd) != lineEnd)
+        {
+          SplitTokens(line, lineEnd, commas, lineTokens);
+          for (size_t k = 0; k < dimensions.size(); ++k)
+            strings[k][j] = lineTokens[dimensions[k]];
+          ++j;
+        }
+        line = lineEnd + 1;
+      }
+    }
+
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t k = 0; k < dimensions.size(); ++k)
+    {
+      const size_t d = dimensions[k];
+      for (size_t j = 0; j < numLines; ++j)
+        values(d, j) = (double) info.MapString(strings[k][j].first,
+            strings[k][j].second, d);
+    }
+  }
+
+  if (transpose)
+    matrix.swap(values);
+  else
+    matrix = arma::trans(values);
+}
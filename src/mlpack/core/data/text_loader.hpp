@@ -0,0 +1,163 @@
+/**
+ * @file text_loader.hpp
+ * @author Ryan Curtin
+ *
+ * A parallel loader for CSV, TSV, and raw ASCII text files, used by
+ * data::Load().
+ */
+#ifndef __MLPACK_CORE_DATA_TEXT_LOADER_HPP
+#define __MLPACK_CORE_DATA_TEXT_LOADER_HPP
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include "dataset_info.hpp"
+
+#include <string>
+#include <vector>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * A read-only view of the whole contents of a file.  On POSIX systems the file
+ * is memory-mapped, so that its pages are only read when they are parsed; on
+ * other systems, it is read into memory.  A compressed file (see
+ * IsCompressed()) is decompressed into memory.  A std::runtime_error is thrown
+ * if the file cannot be opened, mapped, read, or decompressed.
+ */
+class MappedTextFile
+{
+ public:
+  //! Map the given file.
+  MappedTextFile(const std::string& filename);
+
+  //! Unmap the file.
+  ~MappedTextFile();
+
+  //! Get the start of the contents of the file.
+  const char* Data() const { return data; }
+  //! Get the length of the file.
+  size_t Length() const { return length; }
+
+ private:
+  // Mappings cannot be copied.
+  MappedTextFile(const MappedTextFile& other);
+  MappedTextFile& operator=(const MappedTextFile& other);
+
+  //! The start of the contents.
+  const char* data;
+  //! The length of the contents.
+  size_t length;
+  //! If true, the contents are a mapping (and not held in buffer).
+  bool mapped;
+  //! The contents of the file, if it could not be mapped.
+  std::vector<char> buffer;
+};
+
+/**
+ * Parse the number that starts at p (and ends before end) into value, and set
+ * next to the character after it.  Numbers with at most 15 significant digits
+ * and small exponents (which is nearly every number written by a program) are
+ * parsed directly, with the same correctly-rounded result that std::strtod()
+ * gives; everything else (including "nan" and "inf") is handed to
+ * std::strtod().  Returns false if there is no number at p.
+ */
+bool ParseNumber(const char* p,
+                 const char* end,
+                 double& value,
+                 const char*& next);
+
+/**
+ * Split the text [begin, end) into parts that end at newlines, for parsing in
+ * parallel.  There are a few parts per OpenMP thread, so that the load is
+ * balanced even if the lines are not all the same length; short texts are not
+ * split at all.  The i'th part is [parts[i], parts[i + 1]).
+ *
+ * @param begin Start of the text.
+ * @param end End of the text.
+ * @return The numParts + 1 boundaries of the parts.
+ */
+std::vector<const char*> SplitLines(const char* begin, const char* end);
+
+/**
+ * Load a CSV, TSV, or raw ASCII file into the given matrix, with one thread per
+ * part of the file if mlpack is compiled with OpenMP.  The file is mapped (see
+ * MappedTextFile) and split at line boundaries; each thread first counts the
+ * lines of its part, and then parses them straight into their place in the
+ * matrix.  If transpose is true, which is what data::Load() does by default,
+ * each line of the file is a column of the matrix, so each line is written to
+ * contiguous memory and no separate transposition is needed.
+ *
+ * Values may be separated by commas or by runs of spaces and tabs.  Lines that
+ * hold only whitespace are skipped, and carriage returns are ignored.  If the
+ * file cannot be read, or a line has a different number of values than the
+ * first line, or a value cannot be parsed, false is returned and the contents
+ * of the matrix are unspecified; data::Load() then falls back to the parser of
+ * Armadillo (and its errors).
+ *
+ * @param filename Name of the file to load.
+ * @param matrix Matrix to load the file into.
+ * @param transpose If true, each line of the file is a column of the matrix.
+ * @return Whether or not the file was loaded.
+ */
+template<typename eT>
+bool LoadText(const std::string& filename,
+              arma::Mat<eT>& matrix,
+              const bool transpose);
+
+/**
+ * Load the text [begin, end), which holds a CSV, TSV, or raw ASCII file, into
+ * the given matrix, in the same way as LoadText() above.  This is for text that
+ * is already in memory, such as the contents of a decompressed file.
+ *
+ * @param begin Start of the text.
+ * @param end End of the text.
+ * @param matrix Matrix to load the text into.
+ * @param transpose If true, each line of the text is a column of the matrix.
+ * @return Whether or not the text was loaded.
+ */
+template<typename eT>
+bool LoadText(const char* begin,
+              const char* end,
+              arma::Mat<eT>& matrix,
+              const bool transpose);
+
+/**
+ * Load the text [begin, end), which holds a CSV, TSV, or raw ASCII file that
+ * may have categorical (string) values, into the given matrix, with one thread
+ * per part of the text if mlpack is compiled with OpenMP.  If the first line
+ * holds a comma, the values are separated by commas (and the whitespace around
+ * each one is dropped); otherwise they are separated by runs of whitespace.
+ * Quotes are not interpreted.
+ *
+ * A dimension (column of the file) is categorical if it holds any value that
+ * is not a number, or if info already says it is.  The numbers of the other
+ * dimensions are parsed in parallel, as by LoadText(); then each categorical
+ * dimension has its values mapped to integers with its own hash table in info,
+ * in the order of the lines, with the dimensions mapped in parallel.  If info
+ * is empty, it is set to the dimensionality of the file; otherwise it must
+ * match it, and its mappings are extended (so a test set can be loaded with
+ * the mappings of its training set).
+ *
+ * A std::runtime_error is thrown if the text is malformed (if its lines do not
+ * all have the same number of values).
+ *
+ * @param begin Start of the text.
+ * @param end End of the text.
+ * @param matrix Matrix to load the text into.
+ * @param info Information about the dimensions, to fill in.
+ * @param transpose If true, each line of the text is a column of the matrix.
+ */
+void LoadCategoricalText(const char* begin,
+                         const char* end,
+                         arma::mat& matrix,
+                         DatasetInfo& info,
+                         const bool transpose);
+
+} // namespace data
+} // namespace mlpack
+
+// Include implementation.
+#include "text_loader_impl.hpp"
+
+#endif
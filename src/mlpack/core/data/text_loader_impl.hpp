@@ -0,0 +1,187 @@
+/**
+ * @file text_loader_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the parallel text loader.
+ */
+#ifndef __MLPACK_CORE_DATA_TEXT_LOADER_IMPL_HPP
+#define __MLPACK_CORE_DATA_TEXT_LOADER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "text_loader.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace mlpack {
+namespace data {
+
+//! Skip the whitespace (other than newlines) at p.
+inline const char* SkipWhitespace(const char* p, const char* end)
+{
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\v' ||
+      *p == '\f'))
+    ++p;
+  return p;
+}
+
+/**
+ * Parse the values of the line [p, end), storing the i'th one at
+ * out[i * stride] (unless out is NULL).  Returns the number of values, or
+ * size_t(-1) if the line is malformed or holds more than maxValues values.
+ */
+template<typename eT>
+size_t ParseLine(const char* p,
+                 const char* end,
+                 eT* out,
+                 const size_t stride,
+                 const size_t maxValues)
+{
+  size_t count = 0;
+  p = SkipWhitespace(p, end);
+  while (p < end)
+  {
+    double value;
+    const char* next;
+    if (count == maxValues || !ParseNumber(p, end, value, next))
+      return size_t(-1);
+
+    if (out != NULL)
+      out[count * stride] = eT(value);
+    ++count;
+
+    // The next value must be separated from this one by a comma, whitespace, or
+    // both.
+    p = SkipWhitespace(next, end);
+    if (p < end && *p == ',')
+    {
+      p = SkipWhitespace(p + 1, end);
+      if (p == end)
+        return size_t(-1); // A trailing comma.
+    }
+    else if (p < end && p == next)
+    {
+      return size_t(-1); // Something that isn't part of the number.
+    }
+  }
+
+  return count;
+}
+
+template<typename eT>
+bool LoadText(const std::string& filename,
+              arma::Mat<eT>& matrix,
+              const bool transpose)
+{
+  try
+  {
+    const MappedTextFile file(filename);
+    return LoadText(file.Data(), file.Data() + file.Length(), matrix,
+        transpose);
+  }
+  catch (std::runtime_error& e)
+  {
+    Log::Info << e.what() << std::endl;
+    return false;
+  }
+}
+
+template<typename eT>
+bool LoadText(const char* begin,
+              const char* end,
+              arma::Mat<eT>& matrix,
+              const bool transpose)
+{
+  // The first line that holds values decides the number of values per line.
+  size_t numValues = 0;
+  for (const char* line = begin; line < end && numValues == 0; )
+  {
+    const char* newline = (const char*) std::memchr(line, '\n', end - line);
+    const char* lineEnd = (newline == NULL) ? end : newline;
+    numValues = ParseLine<eT>(line, lineEnd, NULL, 0, size_t(-2));
+    if (numValues == size_t(-1))
+      return false;
+    line = lineEnd + 1;
+  }
+
+  if (numValues == 0)
+  {
+    matrix.set_size(0, 0);
+    return true;
+  }
+
+  // Split the file into parts that end at newlines.
+  const std::vector<const char*> parts = SplitLines(begin, end);
+  const size_t numParts = parts.size() - 1;
+
+  // Count the lines that hold values in each part.
+  std::vector<size_t> partLines(numParts + 1, 0);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < numParts; ++i)
+  {
+    size_t lines = 0;
+    for (const char* line = parts[i]; line < parts[i + 1]; )
+    {
+      const char* newline = (const char*) std::memchr(line, '\n',
+          parts[i + 1] - line);
+      const char* lineEnd = (newline == NULL) ? parts[i + 1] : newline;
+      if (SkipWhitespace(line, lineEnd) != lineEnd)
+        ++lines;
+      line = lineEnd + 1;
+    }
+
+    partLines[i + 1] = lines;
+  }
+
+  // Now partLines[i] is the index of the first line of the i'th part.
+  for (size_t i = 1; i <= numParts; ++i)
+    partLines[i] += partLines[i - 1];
+  const size_t numLines = partLines[numParts];
+
+  if (transpose)
+    matrix.set_size(numValues, numLines);
+  else
+    matrix.set_size(numLines, numValues);
+
+  // Parse each part straight into the matrix.  With transpose, line j is
+  // column j, which is contiguous; otherwise it is row j.
+  const size_t stride = transpose ? 1 : numLines;
+  std::vector<char> partFailed(numParts, 0);
+
+  #pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < numParts; ++i)
+  {
+    size_t j = partLines[i];
+    for (const char* line = parts[i]; line < parts[i + 1]; )
+    {
+      const char* newline = (const char*) std::memchr(line, '\n',
+          parts[i + 1] - line);
+      const char* lineEnd = (newline == NULL) ? parts[i + 1] : newline;
+      if (SkipWhitespace(line, lineEnd) != lineEnd)
+      {
+        eT* out = transpose ? matrix.colptr(j) : (matrix.memptr() + j);
+        if (ParseLine<eT>(line, lineEnd, out, stride, numValues) !=
+            numValues)
+        {
+          partFailed[i] = 1;
+          break;
+        }
+
+        ++j;
+      }
+      line = lineEnd + 1;
+    }
+  }
+
+  for (size_t i = 0; i < numParts; ++i)
+    if (partFailed[i])
+      return false;
+
+  return true;
+}
+
+} // namespace data
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,77 @@
+/**
+ * @file text_saver.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the number formatting for the parallel text writer.
+ */
+#include "text_saver.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+using namespace mlpack;
+using namespace mlpack::data;
+
+size_t mlpack::data::FormatNumber(const double value,
+                                  char* out,
+                                  const bool padded)
+{
+  // printf() would write "-nan" for some NaNs, but Armadillo always writes
+  // "nan".
+  if (std::isnan(value))
+  {
+    const size_t length = padded ? 20 : 3;
+    std::memset(out, ' ', length - 3);
+    std::memcpy(out + length - 3, "nan", 3);
+    return length;
+  }
+
+  // The longest result is "-1.234567890123e-308", so 32 characters is plenty.
+  const int length = std::snprintf(out, 32, padded ? "%20.12e" : "%.12e",
+      value);
+  return (size_t) length;
+}
+
+size_t mlpack::data::FormatNumber(const long long value, char* out)
+{
+  if (value < 0)
+  {
+    *out = '-';
+    // Negate in unsigned arithmetic, so that the smallest value works too.
+    return 1 + FormatNumber(0ULL - (unsigned long long) value, out + 1);
+  }
+
+  return FormatNumber((unsigned long long) value, out);
+}
+
+size_t mlpack::data::FormatNumber(const unsigned long long value, char* out)
+{
+  // Write the digits backwards, and then copy them into place.
+  char digits[24];
+  size_t length = 0;
+  unsigned long long remaining = value;
+  do
+  {
+    digits[length++] = (char) ('0' + remaining % 10);
+    remaining /= 10;
+  } while (remaining > 0);
+
+  for (size_t i = 0; i < length; ++i)
+    out[i] = digits[length - 1 - i];
+
+  return length;
+}
+
+size_t mlpack::data::SaveTextParts()
+{
+#ifdef _OPENMP
+  return 4 * (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
@@ -0,0 +1,83 @@
+/**
+ * @file text_saver.hpp
+ * @author Ryan Curtin
+ *
+ * A parallel writer for CSV and raw ASCII text files, used by data::Save().
+ */
+#ifndef __MLPACK_CORE_DATA_TEXT_SAVER_HPP
+#define __MLPACK_CORE_DATA_TEXT_SAVER_HPP
+
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <ostream>
+#include <type_traits>
+
+namespace mlpack {
+namespace data {
+
+/**
+ * Write the given floating-point number to out, as Armadillo writes it in a
+ * text file: in scientific notation with 12 digits after the point (and "inf",
+ * "-inf", or "nan" if it is not finite), right-aligned in 20 characters if
+ * padded is true.  out must have room for 32 characters; no terminator is
+ * written.
+ *
+ * @return The number of characters written.
+ */
+size_t FormatNumber(const double value, char* out, const bool padded);
+
+/**
+ * Write the given integer to out in decimal.  out must have room for 32
+ * characters; no terminator is written.
+ *
+ * @return The number of characters written.
+ */
+size_t FormatNumber(const long long value, char* out);
+
+/**
+ * Write the given unsigned integer to out in decimal.  out must have room for
+ * 32 characters; no terminator is written.
+ *
+ * @return The number of characters written.
+ */
+size_t FormatNumber(const unsigned long long value, char* out);
+
+/**
+ * Get the number of parts that each batch of lines is split into by
+ * SaveText(), which is a few per OpenMP thread.
+ */
+size_t SaveTextParts();
+
+/**
+ * Save the given matrix to the stream as a CSV (if csv is true) or raw ASCII
+ * file, in the same format as Armadillo's csv_ascii and raw_ascii.  The lines
+ * are written in batches: each batch is split into parts, which are formatted
+ * into buffers in parallel (with one thread per part if mlpack is compiled with
+ * OpenMP), and the buffers are then written to the stream in order, each with
+ * one call to write().  If transpose is true, which is what data::Save() does
+ * by default, each column of the matrix is a line of the file; the columns are
+ * formatted in place, so no transposed copy of the matrix is made.
+ *
+ * Only matrices of integer and floating-point types are supported; data::Save()
+ * uses Armadillo for other types (such as complex numbers).  For them, nothing
+ * is written and false is returned.
+ *
+ * @param stream Stream to write the file to.
+ * @param matrix Matrix to save.
+ * @param transpose If true, each column of the matrix is a line of the file.
+ * @param csv If true, the values are separated by commas; otherwise, they are
+ *      separated by spaces.
+ * @return false if the type is not supported or the stream failed.
+ */
+template<typename eT>
+bool SaveText(std::ostream& stream,
+              const arma::Mat<eT>& matrix,
+              const bool transpose,
+              const bool csv);
+
+} // namespace data
+} // namespace mlpack
+
+// Include implementation.
+#include "text_saver_impl.hpp"
+
+#endif
@@ -0,0 +1,133 @@
+/**
+ * @file text_saver_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the parallel text writer.
+ */
+#ifndef __MLPACK_CORE_DATA_TEXT_SAVER_IMPL_HPP
+#define __MLPACK_CORE_DATA_TEXT_SAVER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "text_saver.hpp"
+
+#include <algorithm>
+#include <vector>
+
+namespace mlpack {
+namespace data {
+
+//! Write a floating-point value (padded, for raw ASCII files).
+template<typename eT>
+inline typename std::enable_if<std::is_floating_point<eT>::value, size_t>::type
+FormatValue(const eT value, char* out, const bool csv)
+{
+  return FormatNumber((double) value, out, !csv);
+}
+
+//! Write an integer value (which Armadillo never pads).
+template<typename eT>
+inline typename std::enable_if<std::is_integral<eT>::value, size_t>::type
+FormatValue(const eT value, char* out, const bool /* csv */)
+{
+  if (std::is_signed<eT>::value)
+    return FormatNumber((long long) value, out);
+  else
+    return FormatNumber((unsigned long long) value, out);
+}
+
+//! Format the given lines of the matrix into the buffer.
+template<typename eT>
+void FormatLines(const arma::Mat<eT>& matrix,
+                 const bool transpose,
+                 const bool csv,
+                 const size_t begin,
+                 const size_t end,
+                 std::vector<char>& buffer)
+{
+  const size_t numValues = transpose ? matrix.n_rows : matrix.n_cols;
+  const size_t elementStride = transpose ? 1 : matrix.n_rows;
+
+  // Each value takes at most 32 characters, with its separator.
+  buffer.resize((end - begin) * (32 * numValues + 1));
+  char* out = buffer.empty() ? NULL : &buffer[0];
+  for (size_t line = begin; line < end; ++line)
+  {
+    const eT* values = transpose ? matrix.colptr(line) : matrix.memptr() + line;
+    for (size_t i = 0; i < numValues; ++i)
+    {
+      if (!csv)
+        *out++ = ' ';
+      else if (i > 0)
+        *out++ = ',';
+
+      out += FormatValue(values[i * elementStride], out, csv);
+    }
+
+    *out++ = '\n';
+  }
+
+  buffer.resize(out - (buffer.empty() ? NULL : &buffer[0]));
+}
+
+template<typename eT>
+typename std::enable_if<std::is_arithmetic<eT>::value, bool>::type
+SaveTextImpl(std::ostream& stream,
+             const arma::Mat<eT>& matrix,
+             const bool transpose,
+             const bool csv)
+{
+  const size_t numLines = transpose ? matrix.n_cols : matrix.n_rows;
+  const size_t numValues = transpose ? matrix.n_rows : matrix.n_cols;
+
+  // Each part is about a megabyte of text, so each batch needs a few megabytes
+  // per thread.
+  const size_t partLines = std::max((size_t) 1,
+      (size_t) (1 << 20) / (21 * numValues + 1));
+  const size_t numParts = SaveTextParts();
+  std::vector<std::vector<char> > buffers(numParts);
+
+  for (size_t batch = 0; batch < numLines; batch += numParts * partLines)
+  {
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < numParts; ++i)
+    {
+      const size_t begin = std::min(numLines, batch + i * partLines);
+      const size_t end = std::min(numLines, begin + partLines);
+      FormatLines(matrix, transpose, csv, begin, end, buffers[i]);
+    }
+
+    for (size_t i = 0; i < numParts; ++i)
+      if (!buffers[i].empty())
+        stream.write(&buffers[i][0], buffers[i].size());
+
+    if (!stream.good())
+      return false;
+  }
+
+  return stream.good();
+}
+
+//! Types that are not numbers are not supported.
+template<typename eT>
+typename std::enable_if<!std::is_arithmetic<eT>::value, bool>::type
+SaveTextImpl(std::ostream& /* stream */,
+             const arma::Mat<eT>& /* matrix */,
+             const bool /* transpose */,
+             const bool /* csv */)
+{
+  return false;
+}
+
+template<typename eT>
+bool SaveText(std::ostream& stream,
+              const arma::Mat<eT>& matrix,
+              const bool transpose,
+              const bool csv)
+{
+  return SaveTextImpl(stream, matrix, transpose, csv);
+}
+
+} // namespace data
+} // namespace mlpack
+
+#endif
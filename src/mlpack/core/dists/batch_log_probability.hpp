@@ -0,0 +1,84 @@
+/**
+ * @file batch_log_probability.hpp
+ * @author Ryan Curtin
+ *
+ * BatchLogProbability(), which evaluates the log-probability of every point of
+ * a set under a distribution at once.  Distributions which can do this faster
+ * than one point at a time (like GaussianDistribution, where the whole set is
+ * one triangular solve) provide their own batch LogProbability() overload; for
+ * every other distribution, the points are evaluated one at a time.
+ */
+#ifndef __MLPACK_CORE_DISTRIBUTIONS_BATCH_LOG_PROBABILITY_HPP
+#define __MLPACK_CORE_DISTRIBUTIONS_BATCH_LOG_PROBABILITY_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
+
+namespace mlpack {
+namespace distribution {
+
+// This gives us a HasLogProbabilityCheck<T, U> type (where U is a function
+// pointer) we can use with SFINAE to catch when a distribution has a
+// LogProbability(...) function of a given signature.
+HAS_MEM_FUNC(LogProbability, HasLogProbabilityCheck);
+
+/**
+ * HasBatchLogProbability<DistributionType>::value is true if the distribution
+ * provides a batch evaluation, which has the signature
+ *
+ * @code
+ * void LogProbability(const arma::mat& x, arma::vec& logProbabilities) const;
+ * @endcode
+ *
+ * and sets logProbabilities to the log-probability of each column of x.
+ */
+template<typename DistributionType>
+struct HasBatchLogProbability
+{
+  static const bool value = HasLogProbabilityCheck<DistributionType,
+      void(DistributionType::*)(const arma::mat&, arma::vec&) const>::value;
+};
+
+/**
+ * Evaluate the log-probability of every column of x, using the batch
+ * evaluation of the distribution.
+ *
+ * @param distribution Distribution to evaluate.
+ * @param x Points to evaluate.
+ * @param logProbabilities Vector to store the log-probabilities in.
+ */
+template<typename DistributionType>
+typename std::enable_if<HasBatchLogProbability<DistributionType>::value,
+    void>::type
+BatchLogProbability(const DistributionType& distribution,
+                    const arma::mat& x,
+                    arma::vec& logProbabilities)
+{
+  distribution.LogProbability(x, logProbabilities);
+}
+
+/**
+ * Evaluate the log-probability of every column of x, one point at a time (for
+ * distributions without a batch evaluation).  Only Probability() is required
+ * of the distribution.
+ *
+ * @param distribution Distribution to evaluate.
+ * @param x Points to evaluate.
+ * @param logProbabilities Vector to store the log-probabilities in.
+ */
+template<typename DistributionType>
+typename std::enable_if<!HasBatchLogProbability<DistributionType>::value,
+    void>::type
+BatchLogProbability(const DistributionType& distribution,
+                    const arma::mat& x,
+                    arma::vec& logProbabilities)
+{
+  logProbabilities.set_size(x.n_cols);
+  for (size_t i = 0; i < x.n_cols; ++i)
+    logProbabilities[i] = std::log(distribution.Probability(x.unsafe_col(i)));
+}
+
+}; // namespace distribution
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,173 @@
+/**
+ * @file diagonal_gaussian_distribution.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the DiagonalGaussianDistribution class.
+ */
+#include "diagonal_gaussian_distribution.hpp"
+
+using namespace mlpack;
+using namespace mlpack::distribution;
+
+DiagonalGaussianDistribution::DiagonalGaussianDistribution(
+    const arma::vec& mean,
+    const arma::vec& covariance) :
+    mean(mean)
+{
+  Covariance(covariance);
+}
+
+void DiagonalGaussianDistribution::Covariance(const arma::vec& covariance)
+{
+  this->covariance = covariance;
+  FactorCovariance();
+}
+
+void DiagonalGaussianDistribution::Covariance(arma::vec&& covariance)
+{
+  this->covariance = std::move(covariance);
+  FactorCovariance();
+}
+
+void DiagonalGaussianDistribution::FactorCovariance()
+{
+  if (covariance.n_elem > 0 && covariance.min() <= 0.0)
+  {
+    std::ostringstream oss;
+    oss << "DiagonalGaussianDistribution::Covariance(): covariance is not "
+        << "positive definite (smallest element " << covariance.min() << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  invCov = 1.0 / covariance;
+  logDetCov = arma::accu(arma::log(covariance));
+}
+
+double DiagonalGaussianDistribution::LogProbability(
+    const arma::vec& observation) const
+{
+  const size_t k = observation.n_elem;
+  const arma::vec diff = mean - observation;
+  return -0.5 * k * log2pi - 0.5 * logDetCov -
+      0.5 * arma::dot(arma::square(diff), invCov);
+}
+
+arma::vec DiagonalGaussianDistribution::Random() const
+{
+  return arma::sqrt(covariance) % arma::randn<arma::vec>(mean.n_elem) + mean;
+}
+
+/**
+ * Estimate the Gaussian distribution directly from the given observations.
+ *
+ * @param observations List of observations.
+ */
+void DiagonalGaussianDistribution::Estimate(const arma::mat& observations)
+{
+  if (observations.n_cols == 0)
+  {
+    // This will end up just being empty.
+    mean.zeros(0);
+    covariance.zeros(0);
+    FactorCovariance();
+    return;
+  }
+
+  mean = arma::mean(observations, 1);
+
+  // Calculate the variance of each dimension, with the (1 / (n - 1)) so that it
+  // is the unbiased estimator.
+  arma::mat obsNoMean(observations);
+  obsNoMean.each_col() -= mean;
+  covariance = arma::sum(arma::square(obsNoMean), 1);
+  covariance /= (observations.n_cols - 1);
+
+  // Ensure that the covariance is positive definite.  For a diagonal matrix,
+  // that is each variance, not the determinant; the determinant of a
+  // high-dimensional covariance can underflow even when no variance is small.
+  if (covariance.min() <= 1e-50)
+  {
+    Log::Debug << "DiagonalGaussianDistribution::Estimate(): Covariance matrix "
+        << "is not positive definite. Adding perturbation." << std::endl;
+
+    double perturbation = 1e-30;
+    while (covariance.min() <= 1e-50)
+    {
+      covariance += perturbation;
+      perturbation *= 10; // Slow, but we don't want to add too much.
+    }
+  }
+
+  FactorCovariance();
+}
+
+/**
+ * Estimate the Gaussian distribution from the given observations, taking into
+ * account the probability of each observation actually being from this
+ * distribution.
+ */
+void DiagonalGaussianDistribution::Estimate(const arma::mat& observations,
+                                            const arma::vec& probabilities)
+{
+  if (observations.n_cols == 0)
+  {
+    // This will end up just being empty.
+    mean.zeros(0);
+    covariance.zeros(0);
+    FactorCovariance();
+    return;
+  }
+
+  const double sumProb = arma::accu(probabilities);
+  if (sumProb == 0)
+  {
+    // Nothing in this Gaussian!  At least set the covariance so that it's
+    // invertible.
+    mean.zeros(observations.n_rows);
+    covariance.zeros(observations.n_rows);
+    covariance += 1e-50;
+    FactorCovariance();
+    return;
+  }
+
+  mean = (observations * probabilities) / sumProb;
+
+  // Now find the covariance.  This is probably biased, as it is for
+  // GaussianDistribution.
+  arma::mat obsNoMean(observations);
+  obsNoMean.each_col() -= mean;
+  covariance = (arma::square(obsNoMean) * probabilities) / sumProb;
+
+  // Ensure that the covariance is positive definite.
+  if (covariance.min() <= 1e-50)
+  {
+    Log::Debug << "DiagonalGaussianDistribution::Estimate(): Covariance matrix "
+        << "is not positive definite. Adding perturbation." << std::endl;
+
+    double perturbation = 1e-30;
+    while (covariance.min() <= 1e-50)
+    {
+      covariance += perturbation;
+      perturbation *= 10; // Slow, but we don't want to add too much.
+    }
+  }
+
+  FactorCovariance();
+}
+
+/**
+ * Returns a string representation of this object.
+ */
+std::string DiagonalGaussianDistribution::ToString() const
+{
+  std::ostringstream convert;
+  convert << "DiagonalGaussianDistribution [" << this << "]" << std::endl;
+
+  // Secondary ostringstream so things can be indented right.
+  std::ostringstream data;
+  data << "Mean: " << std::endl << mean;
+  data << "Covariance: " << std::endl << covariance;
+
+  convert << util::Indent(data.str());
+  return convert.str();
+}
@@ -0,0 +1,193 @@
+/**
+ * @file diagonal_gaussian_distribution.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of a multivariate Gaussian distribution with a diagonal
+ * covariance matrix.
+ */
+#ifndef __MLPACK_CORE_DISTRIBUTIONS_DIAGONAL_GAUSSIAN_DISTRIBUTION_HPP
+#define __MLPACK_CORE_DISTRIBUTIONS_DIAGONAL_GAUSSIAN_DISTRIBUTION_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace distribution {
+
+/**
+ * A single multivariate Gaussian distribution with a diagonal covariance
+ * matrix.  Only the diagonal of the covariance is stored, so evaluating the
+ * distribution takes O(d) time and memory for each point, instead of the O(d^2)
+ * of GaussianDistribution, and setting the covariance takes O(d) time instead
+ * of the O(d^3) of a Cholesky decomposition.
+ *
+ * The interface is the same as GaussianDistribution's, except that the
+ * covariance is a vector holding the diagonal of the covariance matrix.
+ */
+class DiagonalGaussianDistribution
+{
+ private:
+  //! Mean of the distribution.
+  arma::vec mean;
+  //! Diagonal of the (positive definite) covariance of the distribution.
+  arma::vec covariance;
+  //! Cached inverse of each element of the covariance.
+  arma::vec invCov;
+  //! Cached logdet(cov).
+  double logDetCov;
+
+  //! log(2pi)
+  static const constexpr double log2pi = 1.83787706640934533908193770912475883;
+
+ public:
+  /**
+   * Default constructor, which creates a Gaussian with zero dimension.
+   */
+  DiagonalGaussianDistribution() : logDetCov(0) { /* Nothing to do. */ }
+
+  /**
+   * Create a Gaussian distribution with zero mean and identity covariance with
+   * the given dimensionality.
+   */
+  DiagonalGaussianDistribution(const size_t dimension) :
+      mean(arma::zeros<arma::vec>(dimension)),
+      covariance(arma::ones<arma::vec>(dimension)),
+      invCov(arma::ones<arma::vec>(dimension)),
+      logDetCov(0)
+  { /* Nothing to do. */ }
+
+  /**
+   * Create a Gaussian distribution with the given mean and the given diagonal
+   * of the covariance.  Each element of the covariance must be positive.
+   */
+  DiagonalGaussianDistribution(const arma::vec& mean,
+                               const arma::vec& covariance);
+
+  //! Return the dimensionality of this distribution.
+  size_t Dimensionality() const { return mean.n_elem; }
+
+  /**
+   * Return the probability of the given observation.
+   */
+  double Probability(const arma::vec& observation) const
+  {
+    return exp(LogProbability(observation));
+  }
+
+  /**
+   * Return the log probability of the given observation.
+   */
+  double LogProbability(const arma::vec& observation) const;
+
+  /**
+   * Calculates the multivariate Gaussian probability density function for each
+   * data point (column) in the given matrix.
+   *
+   * @param x List of observations.
+   * @param probabilities Output probabilities for each input observation.
+   */
+  void Probability(const arma::mat& x, arma::vec& probabilities) const
+  {
+    arma::vec logProbabilities;
+    LogProbability(x, logProbabilities);
+    probabilities = arma::exp(logProbabilities);
+  }
+
+  void LogProbability(const arma::mat& x, arma::vec& logProbabilities) const;
+
+  /**
+   * Return a randomly generated observation according to the probability
+   * distribution defined by this object.
+   *
+   * @return Random observation from this Gaussian distribution.
+   */
+  arma::vec Random() const;
+
+  /**
+   * Estimate the Gaussian distribution directly from the given observations.
+   *
+   * @param observations List of observations.
+   */
+  void Estimate(const arma::mat& observations);
+
+  /**
+   * Estimate the Gaussian distribution from the given observations, taking into
+   * account the probability of each observation actually being from this
+   * distribution.
+   */
+  void Estimate(const arma::mat& observations,
+                const arma::vec& probabilities);
+
+  /**
+   * Return the mean.
+   */
+  const arma::vec& Mean() const { return mean; }
+
+  /**
+   * Return a modifiable copy of the mean.
+   */
+  arma::vec& Mean() { return mean; }
+
+  /**
+   * Return the diagonal of the covariance matrix.
+   */
+  const arma::vec& Covariance() const { return covariance; }
+
+  /**
+   * Set the diagonal of the covariance.  A std::invalid_argument is thrown if
+   * any element is not positive.
+   */
+  void Covariance(const arma::vec& covariance);
+
+  void Covariance(arma::vec&& covariance);
+
+  /**
+   * Serialize the distribution.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    using data::CreateNVP;
+
+    // We just need to serialize each of the members.
+    ar & CreateNVP(mean, "mean");
+    ar & CreateNVP(covariance, "covariance");
+    ar & CreateNVP(invCov, "invCov");
+    ar & CreateNVP(logDetCov, "logDetCov");
+  }
+
+  /**
+   * Returns a string representation of this object.
+   */
+  std::string ToString() const;
+
+ private:
+  //! Compute the cached inverse and log-determinant of the covariance.
+  void FactorCovariance();
+};
+
+/**
+ * Calculates the multivariate Gaussian log probability density function for
+ * each data point (column) in the given matrix.
+ *
+ * @param x List of observations.
+ * @param probabilities Output log probabilities for each input observation.
+ */
+inline void DiagonalGaussianDistribution::LogProbability(
+    const arma::mat& x,
+    arma::vec& logProbabilities) const
+{
+  // Column i of 'diffs' is the difference between x.col(i) and the mean.
+  arma::mat diffs(x);
+  diffs.each_col() -= mean;
+
+  // The exponent for each point is a weighted sum of its squared differences,
+  // so all of them are one matrix-vector product.
+  const size_t k = x.n_rows;
+  logProbabilities = -0.5 * (trans(arma::square(diffs)) * invCov);
+  logProbabilities += -0.5 * k * log2pi - 0.5 * logDetCov;
+}
+
+}; // namespace distribution
+}; // namespace mlpack
+
+#endif
@@ -9,6 +9,63 @@
 using namespace mlpack;
 using namespace mlpack::distribution;
 
+namespace {
+
+//! Look up each observation (column of x) in the given table.
+void Gather(const arma::vec& table, const arma::mat& x, arma::vec& values)
+{
+  values.set_size(x.n_cols);
+  for (size_t i = 0; i < x.n_cols; ++i)
+  {
+    // Adding 0.5 helps ensure that we cast the floating point to a size_t
+    // correctly.
+    const size_t obs = size_t(x(0, i) + 0.5);
+
+    // Ensure that the observation is within the bounds.
+    if (obs >= table.n_elem)
+    {
+      Log::Debug << "DiscreteDistribution::Probability(): received observation "
+          << obs << "; observation must be in [0, " << table.n_elem
+          << "] for this distribution." << std::endl;
+    }
+
+    values[i] = table(obs);
+  }
+}
+
+} // anonymous namespace
+
+/**
+ * Return the probability of each of the given observations.
+ */
+void DiscreteDistribution::Probability(const arma::mat& x,
+                                       arma::vec& probabilities) const
+{
+  Gather(this->probabilities, x, probabilities);
+}
+
+/**
+ * Return the log probability of each of the given observations.
+ */
+void DiscreteDistribution::LogProbability(const arma::mat& x,
+                                          arma::vec& logProbabilities) const
+{
+  // The probabilities can be modified through Probabilities(), so the table of
+  // log probabilities is built here instead of being stored.  If there are
+  // fewer observations than entries in the table, it is cheaper to take the
+  // logarithm of each observation's probability instead.
+  if (x.n_cols < probabilities.n_elem)
+  {
+    Gather(probabilities, x, logProbabilities);
+    logProbabilities = arma::log(logProbabilities);
+  }
+  else
+  {
+    const arma::vec logTable = arma::log(probabilities);
+    Gather(logTable, x, logProbabilities);
+  }
+}
+
 /**
  * Return a randomly generated observation according to the probability
  * distribution defined by this object.
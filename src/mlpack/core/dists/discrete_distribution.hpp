@@ -118,6 +118,27 @@ class DiscreteDistribution
     return log(Probability(observation));
   }
 
+  /**
+   * Return the probability of each of the given observations (columns of x).
+   * The observations are looked up in the vector of probabilities all at once.
+   *
+   * @param x List of observations.
+   * @param probabilities Output probabilities for each input observation.
+   */
+  void Probability(const arma::mat& x, arma::vec& probabilities) const;
+
+  /**
+   * Return the log probability of each of the given observations (columns of
+   * x).  The observations are looked up in a table of the log probabilities,
+   * when it is cheaper to build that table than to take a logarithm for each
+   * observation.
+   *
+   * @param x List of observations.
+   * @param logProbabilities Output log probabilities for each input
+   *     observation.
+   */
+  void LogProbability(const arma::mat& x, arma::vec& logProbabilities) const;
+
   /**
    * Return a randomly generated observation (one-dimensional vector; one
    * observation) according to the probability distribution defined by this
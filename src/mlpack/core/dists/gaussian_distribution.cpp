@@ -66,10 +66,13 @@ void GaussianDistribution::FactorCovariance()
 
 double GaussianDistribution::LogProbability(const arma::vec& observation) const
 {
+  // Like the batch version: the exponent is the squared norm of L^-1 * diff,
+  // where L is the cached Cholesky factor of the covariance.
   const size_t k = observation.n_elem;
-  const arma::vec diff = mean - observation;
-  const arma::vec v = (diff.t() * invCov * diff);
-  return -0.5 * k * log2pi - 0.5 * logDetCov - 0.5 * v(0);
+  const arma::vec whitened = arma::solve(arma::trimatl(covLower),
+      observation - mean);
+  return -0.5 * k * log2pi - 0.5 * logDetCov -
+      0.5 * arma::dot(whitened, whitened);
 }
 
 arma::vec GaussianDistribution::Random() const
@@ -97,23 +100,12 @@ void GaussianDistribution::Estimate(const arma::mat& observations)
     return;
   }
 
-  // Calculate the mean.
-  for (size_t i = 0; i < observations.n_cols; i++)
-    mean += observations.col(i);
-
-  // Normalize the mean.
-  mean /= observations.n_cols;
-
-  // Now calculate the covariance.
-  for (size_t i = 0; i < observations.n_cols; i++)
-  {
-    arma::vec obsNoMean = observations.col(i) - mean;
-    covariance += obsNoMean * trans(obsNoMean);
-  }
-
-  // Finish estimating the covariance by normalizing, with the (1 / (n - 1)) so
-  // that it is the unbiased estimator.
-  covariance /= (observations.n_cols - 1);
+  // Calculate the mean and the covariance in one blocked pass.  The covariance
+  // is normalized with (1 / (n - 1)), so that it is the unbiased estimator.
+  math::CovarianceAccumulator accumulator(observations.n_rows);
+  accumulator.Add(observations);
+  mean = accumulator.Mean();
+  covariance = accumulator.Covariance();
 
   // Ensure that the covariance is positive definite.
   if (det(covariance) <= 1e-50)
@@ -153,17 +145,11 @@ void GaussianDistribution::Estimate(const arma::mat& observations,
     return;
   }
 
-  double sumProb = 0;
-
-  // First calculate the mean, and save the sum of all the probabilities for
-  // later normalization.
-  for (size_t i = 0; i < observations.n_cols; i++)
-  {
-    mean += probabilities[i] * observations.col(i);
-    sumProb += probabilities[i];
-  }
+  // Calculate the weighted mean and covariance in one blocked pass.
+  math::CovarianceAccumulator accumulator(observations.n_rows);
+  accumulator.Add(observations, probabilities);
 
-  if (sumProb == 0)
+  if (accumulator.Weight() == 0)
   {
     // Nothing in this Gaussian!  At least set the covariance so that it's
     // invertible.
@@ -172,18 +158,9 @@ void GaussianDistribution::Estimate(const arma::mat& observations,
     return;
   }
 
-  // Normalize.
-  mean /= sumProb;
-
-  // Now find the covariance.
-  for (size_t i = 0; i < observations.n_cols; i++)
-  {
-    arma::vec obsNoMean = observations.col(i) - mean;
-    covariance += probabilities[i] * (obsNoMean * trans(obsNoMean));
-  }
-
   // This is probably biased, but I don't know how to unbias it.
-  covariance /= sumProb;
+  mean = accumulator.Mean();
+  covariance = accumulator.Covariance(1);
 
   // Ensure that the covariance is positive definite.
   if (det(covariance) <= 1e-50)
@@ -174,20 +174,19 @@ inline void GaussianDistribution::LogProbability(const arma::mat& x,
                                                  arma::vec& logProbabilities) const
 {
   // Column i of 'diffs' is the difference between x.col(i) and the mean.
-  arma::mat diffs = x - (mean * arma::ones<arma::rowvec>(x.n_cols));
+  arma::mat diffs(x);
+  diffs.each_col() -= mean;
 
-  // Now, we only want to calculate the diagonal elements of (diffs' * cov^-1 *
-  // diffs).  We just don't need any of the other elements.  We can calculate
-  // the right hand part of the equation (instead of the left side) so that
-  // later we are referencing columns, not rows -- that is faster.
-  const arma::mat rhs = -0.5 * invCov * diffs;
-  arma::vec logExponents(diffs.n_cols); // We will now fill this.
-  for (size_t i = 0; i < diffs.n_cols; i++)
-    logExponents(i) = accu(diffs.unsafe_col(i) % rhs.unsafe_col(i));
+  // With cov = LL^T, the exponent diff^T * cov^-1 * diff is the squared norm of
+  // L^-1 * diff.  So one triangular solve with the cached Cholesky factor gives
+  // the exponents of the whole block; this takes half the work of multiplying
+  // by the inverse, and it is more accurate.
+  const arma::mat whitened = arma::solve(arma::trimatl(covLower), diffs);
 
   const size_t k = x.n_rows;
 
-  logProbabilities = -0.5 * k * log2pi - 0.5 * logDetCov + logExponents;
+  logProbabilities = -0.5 * trans(arma::sum(arma::square(whitened), 0));
+  logProbabilities += -0.5 * k * log2pi - 0.5 * logDetCov;
 }
 
 
@@ -20,6 +20,20 @@ double LaplaceDistribution::LogProbability(const arma::vec& observation) const
   return -log(2. * scale) - arma::norm(observation - mean, 2) / scale;
 }
 
+/**
+ * Return the log probability of each of the given observations.
+ */
+void LaplaceDistribution::LogProbability(const arma::mat& x,
+                                         arma::vec& logProbabilities) const
+{
+  // Column i of 'diffs' is the difference between x.col(i) and the mean.
+  arma::mat diffs(x);
+  diffs.each_col() -= mean;
+
+  logProbabilities = trans(arma::sqrt(arma::sum(arma::square(diffs), 0)));
+  logProbabilities = -log(2. * scale) - logProbabilities / scale;
+}
+
 /**
  * Estimate the Laplace distribution directly from the given observations.
  *
@@ -0,0 +1,190 @@
+/**
+ * @file batch_evaluate.hpp
+ * @author Ryan Curtin
+ *
+ * BatchEvaluate(), which evaluates a kernel between every pair of points of two
+ * sets at once.  Kernels which can do this faster than one pair at a time (like
+ * LinearKernel and PolynomialKernel, where the inner products of two sets are
+ * one matrix multiplication) provide their own batch Evaluate() overload; for
+ * every other kernel, the pairs are evaluated one at a time.
+ *
+ * KernelMatrix() builds a whole kernel matrix from cache-sized tiles, each of
+ * which is one call to BatchEvaluate(); if mlpack is compiled with OpenMP, the
+ * tiles are computed in parallel.
+ */
+#ifndef __MLPACK_CORE_KERNELS_BATCH_EVALUATE_HPP
+#define __MLPACK_CORE_KERNELS_BATCH_EVALUATE_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
+
+namespace mlpack {
+namespace kernel {
+
+// This gives us a HasEvaluateCheck<T, U> type (where U is a function pointer)
+// we can use with SFINAE to catch when a kernel has an Evaluate(...) function
+// of a given signature.
+HAS_MEM_FUNC(Evaluate, HasEvaluateCheck);
+
+/**
+ * HasBatchEvaluate<KernelType>::value is true if the kernel provides a batch
+ * evaluation, which has the signature
+ *
+ * @code
+ * void Evaluate(const arma::mat& a, const arma::mat& b, arma::mat& k) const;
+ * @endcode
+ *
+ * and sets k to the (a.n_cols x b.n_cols) matrix of kernel values between the
+ * columns of a and the columns of b.
+ */
+template<typename KernelType>
+struct HasBatchEvaluate
+{
+  static const bool value = HasEvaluateCheck<KernelType,
+      void(KernelType::*)(const arma::mat&, const arma::mat&, arma::mat&)
+      const>::value;
+};
+
+/**
+ * Evaluate the kernel between every column of a and every column of b, using
+ * the batch evaluation of the kernel.  Element (i, j) of k is set to K(a_i,
+ * b_j).
+ *
+ * @param kernel Kernel to evaluate.
+ * @param a First set of points.
+ * @param b Second set of points.
+ * @param k Matrix to store the kernel values in (a.n_cols x b.n_cols).
+ */
+template<typename KernelType>
+typename std::enable_if<HasBatchEvaluate<KernelType>::value, void>::type
+BatchEvaluate(const KernelType& kernel,
+              const arma::mat& a,
+              const arma::mat& b,
+              arma::mat& k)
+{
+  kernel.Evaluate(a, b, k);
+}
+
+/**
+ * Evaluate the kernel between every column of a and every column of b, one
+ * pair at a time (for kernels without a batch evaluation).  Element (i, j) of k
+ * is set to K(a_i, b_j).
+ *
+ * @param kernel Kernel to evaluate.
+ * @param a First set of points.
+ * @param b Second set of points.
+ * @param k Matrix to store the kernel values in (a.n_cols x b.n_cols).
+ */
+template<typename KernelType>
+typename std::enable_if<!HasBatchEvaluate<KernelType>::value, void>::type
+BatchEvaluate(KernelType& kernel,
+              const arma::mat& a,
+              const arma::mat& b,
+              arma::mat& k)
+{
+  k.set_size(a.n_cols, b.n_cols);
+  for (size_t j = 0; j < b.n_cols; ++j)
+    for (size_t i = 0; i < a.n_cols; ++i)
+      k(i, j) = kernel.Evaluate(a.col(i), b.col(j));
+}
+
+/**
+ * The number of points in each side of a tile of the kernel matrix built by
+ * KernelMatrix().
+ */
+const size_t kernelMatrixTileSize = 256;
+
+/**
+ * Evaluate the kernel between every column of a and every column of b, tile by
+ * tile.  Each tile of kernelMatrixTileSize columns of b is one call to
+ * BatchEvaluate(), and the tiles are computed in parallel if mlpack is compiled
+ * with OpenMP.  Element (i, j) of k is set to K(a_i, b_j).
+ *
+ * @param kernel Kernel to evaluate.
+ * @param a First set of points.
+ * @param b Second set of points.
+ * @param k Matrix to store the kernel values in (a.n_cols x b.n_cols).
+ */
+template<typename KernelType>
+void KernelMatrix(KernelType& kernel,
+                  const arma::mat& a,
+                  const arma::mat& b,
+                  arma::mat& k)
+{
+  k.set_size(a.n_cols, b.n_cols);
+  const size_t tiles = (b.n_cols + kernelMatrixTileSize - 1) /
+      kernelMatrixTileSize;
+
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t t = 0; t < tiles; ++t)
+  {
+    const size_t begin = t * kernelMatrixTileSize;
+    const size_t count = std::min(kernelMatrixTileSize, b.n_cols - begin);
+
+    // Alias the columns of the tile instead of copying them.
+    const arma::mat bTile(const_cast<double*>(b.colptr(begin)), b.n_rows,
+        count, false, true);
+    arma::mat tile;
+    BatchEvaluate(kernel, a, bTile, tile);
+    k.cols(begin, begin + count - 1) = tile;
+  }
+}
+
+/**
+ * Build the (symmetric) kernel matrix of the columns of data.  Only the tiles
+ * on and above the diagonal are evaluated, each one with a single call to
+ * BatchEvaluate(); the tiles below the diagonal are copied from them.  The
+ * tiles are computed in parallel if mlpack is compiled with OpenMP.
+ *
+ * @param kernel Kernel to evaluate.
+ * @param data Set of points.
+ * @param k Matrix to store the kernel values in (data.n_cols x data.n_cols).
+ */
+template<typename KernelType>
+void KernelMatrix(KernelType& kernel, const arma::mat& data, arma::mat& k)
+{
+  k.set_size(data.n_cols, data.n_cols);
+  const size_t tiles = (data.n_cols + kernelMatrixTileSize - 1) /
+      kernelMatrixTileSize;
+
+  // Enumerate the tiles (i, j) with i <= j in a single loop, so that the work
+  // can be shared evenly between the threads.
+  const size_t numTiles = tiles * (tiles + 1) / 2;
+
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t t = 0; t < numTiles; ++t)
+  {
+    size_t j = 0;
+    while ((j + 1) * (j + 2) / 2 <= t)
+      ++j;
+    const size_t i = t - j * (j + 1) / 2;
+
+    const size_t rowBegin = i * kernelMatrixTileSize;
+    const size_t rowCount = std::min(kernelMatrixTileSize,
+        data.n_cols - rowBegin);
+    const size_t colBegin = j * kernelMatrixTileSize;
+    const size_t colCount = std::min(kernelMatrixTileSize,
+        data.n_cols - colBegin);
+
+    // Alias the columns of the tile instead of copying them.
+    const arma::mat a(const_cast<double*>(data.colptr(rowBegin)), data.n_rows,
+        rowCount, false, true);
+    const arma::mat b(const_cast<double*>(data.colptr(colBegin)), data.n_rows,
+        colCount, false, true);
+
+    arma::mat tile;
+    BatchEvaluate(kernel, a, b, tile);
+    k.submat(rowBegin, colBegin, rowBegin + rowCount - 1,
+        colBegin + colCount - 1) = tile;
+    if (i != j)
+    {
+      k.submat(colBegin, rowBegin, colBegin + colCount - 1,
+          rowBegin + rowCount - 1) = trans(tile);
+    }
+  }
+}
+
+}; // namespace kernel
+}; // namespace mlpack
+
+#endif
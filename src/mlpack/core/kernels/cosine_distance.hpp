@@ -21,6 +21,15 @@ namespace kernel {
  * @f]
  *
  * and this class assumes the standard L2 inner product.
+ *
+ * Evaluating the cosine distance computes the norms of both vectors; when many
+ * evaluations are done with the points of one dataset, the norms can be
+ * computed once with Norms() and given to Evaluate().  For searches, it is
+ * better still to scale each point to unit norm with Normalize(): for unit
+ * vectors, || a - b ||^2 = 2 - 2 d(a, b), so the points with the largest cosine
+ * similarity are the nearest neighbors with the Euclidean distance, and trees
+ * with tight Euclidean bounds (like kd-trees) can be used.  The
+ * neighbor::CosineNeighborSearch class does this.
  */
 class CosineDistance
 {
@@ -35,6 +44,39 @@ class CosineDistance
   template<typename VecTypeA, typename VecTypeB>
   static double Evaluate(const VecTypeA& a, const VecTypeB& b);
 
+  /**
+   * Computes the cosine distance between two points whose norms are already
+   * known (see Norms()).
+   *
+   * @param a First vector.
+   * @param b Second vector.
+   * @param normA L2 norm of a.
+   * @param normB L2 norm of b.
+   * @return d(a, b).
+   */
+  template<typename VecTypeA, typename VecTypeB>
+  static double Evaluate(const VecTypeA& a,
+                         const VecTypeB& b,
+                         const double normA,
+                         const double normB);
+
+  /**
+   * Compute the L2 norm of each point in the given dataset.
+   *
+   * @param data Dataset (one point per column).
+   * @return The norm of each point.
+   */
+  template<typename eT>
+  static arma::vec Norms(const arma::Mat<eT>& data);
+
+  /**
+   * Scale each point in the given dataset to unit L2 norm.  Points with norm 0
+   * are left as they are.
+   *
+   * @param data Dataset (one point per column) to normalize.
+   */
+  static void Normalize(arma::mat& data);
+
   /**
    * Returns a string representation of this object.
    */
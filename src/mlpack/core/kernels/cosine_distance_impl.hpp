@@ -15,18 +15,47 @@ namespace kernel {
 template<typename VecTypeA, typename VecTypeB>
 double CosineDistance::Evaluate(const VecTypeA& a, const VecTypeB& b)
 {
-  // Since we are using the L2 inner product, this is easy.  But we have to make
-  // sure we aren't dividing by zero (if we are, then the cosine similarity is
-  // 0: we reason this value because the cosine distance is just a normalized
-  // dot product; take away the normalization, and if ||a|| or ||b|| is equal to
-  // 0, then a^T b is zero too).
-  const double denominator = norm(a, 2) * norm(b, 2);
+  // Since we are using the L2 inner product, this is easy.
+  return Evaluate(a, b, norm(a, 2), norm(b, 2));
+}
+
+template<typename VecTypeA, typename VecTypeB>
+double CosineDistance::Evaluate(const VecTypeA& a,
+                                const VecTypeB& b,
+                                const double normA,
+                                const double normB)
+{
+  // We have to make sure we aren't dividing by zero (if we are, then the cosine
+  // similarity is 0: we reason this value because the cosine distance is just a
+  // normalized dot product; take away the normalization, and if ||a|| or ||b||
+  // is equal to 0, then a^T b is zero too).
+  const double denominator = normA * normB;
   if (denominator == 0.0)
     return 0;
   else
     return dot(a, b) / denominator;
 }
 
+template<typename eT>
+arma::vec CosineDistance::Norms(const arma::Mat<eT>& data)
+{
+  arma::vec norms(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+    norms[i] = norm(data.col(i), 2);
+
+  return norms;
+}
+
+inline void CosineDistance::Normalize(arma::mat& data)
+{
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    const double pointNorm = norm(data.col(i), 2);
+    if (pointNorm > 0.0)
+      data.col(i) /= pointNorm;
+  }
+}
+
 }; // namespace kernel
 }; // namespace mlpack
 
@@ -109,6 +109,8 @@ class KernelTraits<EpanechnikovKernel>
   static const bool IsNormalized = true;
   //! The Epanechnikov kernel includes a squared distance.
   static const bool UsesSquaredDistance = true;
+  //! The Epanechnikov kernel decreases with the distance between its inputs.
+  static const bool DecreasesWithDistance = true;
 };
 
 }; // namespace kernel
@@ -62,6 +62,33 @@ class GaussianKernel
     return exp(gamma * metric::SquaredEuclideanDistance::Evaluate(a, b));
   }
 
+  /**
+   * Evaluate the kernel between every column of a and every column of b.  The
+   * squared distances are computed from the inner products of the two sets
+   * (||a_i||^2 + ||b_j||^2 - 2 <a_i, b_j>), which are a single matrix
+   * multiplication.
+   *
+   * @param a First set of points.
+   * @param b Second set of points.
+   * @param k Matrix to store K(a_i, b_j) in, as element (i, j).
+   */
+  void Evaluate(const arma::mat& a, const arma::mat& b, arma::mat& k) const
+  {
+    const arma::rowvec aNorms = arma::sum(arma::square(a), 0);
+    const arma::rowvec bNorms = arma::sum(arma::square(b), 0);
+
+    k = -2.0 * (a.t() * b);
+    for (size_t j = 0; j < k.n_cols; ++j)
+    {
+      for (size_t i = 0; i < k.n_rows; ++i)
+      {
+        // Rounding can make the squared distance slightly negative.
+        const double distance = std::max(k(i, j) + aNorms[i] + bNorms[j], 0.0);
+        k(i, j) = exp(gamma * distance);
+      }
+    }
+  }
+
   /**
    * Evaluation of the Gaussian kernel given the distance between two points.
    *
@@ -174,6 +201,8 @@ class KernelTraits<GaussianKernel>
   static const bool IsNormalized = true;
   //! The Gaussian kernel includes a squared distance.
   static const bool UsesSquaredDistance = true;
+  //! The Gaussian kernel decreases with the distance between its inputs.
+  static const bool DecreasesWithDistance = true;
 };
 
 }; // namespace kernel
@@ -57,6 +57,19 @@ class HyperbolicTangentKernel
     return tanh(scale * arma::dot(a, b) + offset);
   }
 
+  /**
+   * Evaluate the kernel between every column of a and every column of b.  All
+   * of the dot products are computed with a single matrix multiplication.
+   *
+   * @param a First set of points.
+   * @param b Second set of points.
+   * @param k Matrix to store K(a_i, b_j) in, as element (i, j).
+   */
+  void Evaluate(const arma::mat& a, const arma::mat& b, arma::mat& k) const
+  {
+    k = arma::tanh(scale * (a.t() * b) + offset);
+  }
+
   //! Get scale factor.
   double Scale() const { return scale; }
   //! Modify scale factor.
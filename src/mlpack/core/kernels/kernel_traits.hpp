@@ -31,6 +31,14 @@ class KernelTraits
    * If true, then the kernel include a squared distance, ||x - y||^2 .
    */
   static const bool UsesSquaredDistance = false;
+
+  /**
+   * If true, then the kernel value only depends on the distance between its
+   * inputs, it can be computed from that distance with Evaluate(distance), and
+   * it never increases as the distance grows.  Then bounds on the distance
+   * between two sets of points give bounds on the kernel values between them.
+   */
+  static const bool DecreasesWithDistance = false;
 };
 
 }; // namespace kernel
@@ -121,6 +121,8 @@ class KernelTraits<LaplacianKernel>
   static const bool IsNormalized = true;
   //! The Laplacian kernel doesn't include a squared distance.
   static const bool UsesSquaredDistance = false;
+  //! The Laplacian kernel decreases with the distance between its inputs.
+  static const bool DecreasesWithDistance = true;
 };
 
 }; // namespace kernel
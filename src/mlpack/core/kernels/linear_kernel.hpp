@@ -50,6 +50,19 @@ class LinearKernel
     return arma::dot(a, b);
   }
 
+  /**
+   * Evaluate the kernel between every column of a and every column of b, as a
+   * single matrix multiplication.
+   *
+   * @param a First set of points.
+   * @param b Second set of points.
+   * @param k Matrix to store K(a_i, b_j) in, as element (i, j).
+   */
+  void Evaluate(const arma::mat& a, const arma::mat& b, arma::mat& k) const
+  {
+    k = a.t() * b;
+  }
+
   //! Serialize the kernel (it has no members... do nothing).
   template<typename Archive>
   void Serialize(Archive& /* ar */, const unsigned int /* version */) const { }
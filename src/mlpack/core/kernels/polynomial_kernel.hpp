@@ -52,6 +52,19 @@ class PolynomialKernel
     return pow((arma::dot(a, b) + offset), degree);
   }
 
+  /**
+   * Evaluate the kernel between every column of a and every column of b.  All
+   * of the dot products are computed with a single matrix multiplication.
+   *
+   * @param a First set of points.
+   * @param b Second set of points.
+   * @param k Matrix to store K(a_i, b_j) in, as element (i, j).
+   */
+  void Evaluate(const arma::mat& a, const arma::mat& b, arma::mat& k) const
+  {
+    k = arma::pow(a.t() * b + offset, degree);
+  }
+
   //! Get the degree of the polynomial.
   const double& Degree() const { return degree; }
   //! Modify the degree of the polynomial.
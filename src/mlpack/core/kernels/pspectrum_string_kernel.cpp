@@ -10,6 +10,9 @@
  */
 #include "pspectrum_string_kernel.hpp"
 
+#include <algorithm>
+#include <unordered_map>
+
 using namespace std;
 using namespace mlpack;
 using namespace mlpack::kernel;
@@ -32,22 +35,24 @@ mlpack::kernel::PSpectrumStringKernel::PSpectrumStringKernel(
   Log::Info << "Assembling counts of substrings of length " << p << "."
       << std::endl;
 
-  // Resize for number of datasets.
-  counts.resize(datasets.size());
+  // First, give every distinct substring a temporary index, and list the
+  // temporary indices of the substrings of each string, one string after
+  // another.
+  unordered_map<string, size_t> indices;
+  vector<size_t> stringSubstrings;
+  offsets.resize(datasets.size());
 
   for (size_t dataset = 0; dataset < datasets.size(); ++dataset)
   {
     const std::vector<std::string>& set = datasets[dataset];
-
-    // Resize for number of strings in dataset.
-    counts[dataset].resize(set.size());
+    offsets[dataset].resize(set.size() + 1);
 
     // Inspect each string in the dataset.
     for (size_t index = 0; index < set.size(); ++index)
     {
-      // Convenience references.
+      // Convenience reference.
       const std::string& str = set[index];
-      std::map<std::string, int>& mapping = counts[dataset][index];
+      offsets[dataset][index] = stringSubstrings.size();
 
       size_t start = 0;
       while ((start + p) <= str.length())
@@ -72,12 +77,119 @@ mlpack::kernel::PSpectrumStringKernel::PSpectrumStringKernel(
 
         if (!invalid)
         {
-          // Add to the map.
-          ++mapping[sub];
+          // Find the index of the substring, or give it the next one.
+          const size_t next = indices.size();
+          stringSubstrings.push_back(indices.insert(make_pair(sub,
+              next)).first->second);
         }
       }
     }
+
+    offsets[dataset][set.size()] = stringSubstrings.size();
   }
 
-  Log::Info << "Substring extraction complete." << std::endl;
+  // Renumber the substrings in alphabetical order.
+  substrings.resize(indices.size());
+  for (unordered_map<string, size_t>::const_iterator it = indices.begin();
+       it != indices.end(); ++it)
+    substrings[it->second] = it->first;
+  indices.clear();
+
+  vector<size_t> order(substrings.size());
+  for (size_t i = 0; i < order.size(); ++i)
+    order[i] = i;
+  sort(order.begin(), order.end(), [this](const size_t a, const size_t b)
+      { return substrings[a] < substrings[b]; });
+
+  vector<size_t> newIndices(substrings.size());
+  vector<string> sortedSubstrings(substrings.size());
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    newIndices[order[i]] = i;
+    sortedSubstrings[i].swap(substrings[order[i]]);
+  }
+  substrings.swap(sortedSubstrings);
+
+  // Now the spectrum of each string is its sorted substring indices, with the
+  // repeated ones counted.  The offsets change to positions in the spectra.
+  for (size_t dataset = 0; dataset < offsets.size(); ++dataset)
+  {
+    std::vector<size_t>& setOffsets = offsets[dataset];
+    size_t begin = setOffsets[0];
+    for (size_t index = 0; index + 1 < setOffsets.size(); ++index)
+    {
+      const size_t end = setOffsets[index + 1];
+      setOffsets[index] = spectra.size();
+
+      for (size_t i = begin; i < end; ++i)
+        stringSubstrings[i] = newIndices[stringSubstrings[i]];
+      sort(stringSubstrings.begin() + begin, stringSubstrings.begin() + end);
+
+      for (size_t i = begin; i < end; ++i)
+      {
+        if ((i != begin) && (stringSubstrings[i] == stringSubstrings[i - 1]))
+          ++spectra.back().second;
+        else
+          spectra.push_back(make_pair(stringSubstrings[i], (size_t) 1));
+      }
+
+      begin = end;
+    }
+
+    setOffsets.back() = spectra.size();
+  }
+
+  Log::Info << "Substring extraction complete (" << substrings.size()
+      << " distinct substrings)." << std::endl;
+}
+
+void mlpack::kernel::PSpectrumStringKernel::Evaluate(const arma::mat& a,
+                                                     const arma::mat& b,
+                                                     arma::mat& k) const
+{
+  // Find the spectrum of each string once, instead of once for each pair.
+  vector<const pair<size_t, size_t>*> aBegins(a.n_cols), aEnds(a.n_cols);
+  for (size_t i = 0; i < a.n_cols; ++i)
+  {
+    const std::vector<size_t>& aOffsets = offsets[(size_t) a(0, i)];
+    const size_t aIndex = (size_t) a(1, i);
+    aBegins[i] = spectra.data() + aOffsets[aIndex];
+    aEnds[i] = spectra.data() + aOffsets[aIndex + 1];
+  }
+
+  k.set_size(a.n_cols, b.n_cols);
+  for (size_t j = 0; j < b.n_cols; ++j)
+  {
+    const std::vector<size_t>& bOffsets = offsets[(size_t) b(0, j)];
+    const size_t bIndex = (size_t) b(1, j);
+    const pair<size_t, size_t>* bBegin = spectra.data() + bOffsets[bIndex];
+    const pair<size_t, size_t>* bEnd = spectra.data() + bOffsets[bIndex + 1];
+
+    for (size_t i = 0; i < a.n_cols; ++i)
+      k(i, j) = Product(aBegins[i], aEnds[i], bBegin, bEnd);
+  }
+}
+
+size_t mlpack::kernel::PSpectrumStringKernel::Count(
+    const size_t dataset,
+    const size_t index,
+    const std::string& substring) const
+{
+  // Find the index of the substring.
+  vector<string>::const_iterator it = lower_bound(substrings.begin(),
+      substrings.end(), substring);
+  if ((it == substrings.end()) || (*it != substring))
+    return 0;
+  const size_t substringIndex = it - substrings.begin();
+
+  // Then find it in the spectrum of the string.
+  const pair<size_t, size_t>* begin = spectra.data() +
+      offsets[dataset][index];
+  const pair<size_t, size_t>* end = spectra.data() +
+      offsets[dataset][index + 1];
+  const pair<size_t, size_t>* entry = lower_bound(begin, end,
+      make_pair(substringIndex, (size_t) 0));
+
+  return ((entry != end) && (entry->first == substringIndex)) ?
+      entry->second : 0;
 }
@@ -11,7 +11,6 @@
 #ifndef __MLPACK_CORE_KERNELS_PSPECTRUM_STRING_KERNEL_HPP
 #define __MLPACK_CORE_KERNELS_PSPECTRUM_STRING_KERNEL_HPP
 
-#include <map>
 #include <string>
 #include <vector>
 
@@ -55,6 +54,11 @@ namespace kernel {
  * the data according to the fake data matrix -- resulting in a meaningless
  * tree.  This kernel was originally written for the FastMKS method; so, at the
  * very least, it will work with that.
+ *
+ * At construction time, every distinct substring of length p in the datasets
+ * is given an index (in alphabetical order), and each string is stored as the
+ * sorted list of the indices of its substrings and their counts.  Then each
+ * kernel evaluation is a linear merge of two sorted arrays.
  */
 class PSpectrumStringKernel
 {
@@ -83,12 +87,41 @@ class PSpectrumStringKernel
   template<typename VecType>
   double Evaluate(const VecType& a, const VecType& b) const;
 
-  //! Access the lists of substrings.
-  const std::vector<std::vector<std::map<std::string, int> > >& Counts() const
-  { return counts; }
-  //! Modify the lists of substrings.
-  std::vector<std::vector<std::map<std::string, int> > >& Counts()
-  { return counts; }
+  /**
+   * Evaluate the kernel between every column of a and every column of b, where
+   * each column holds the index of a dataset and the index of a string (as for
+   * the other Evaluate()).  The substrings of each string are only looked up
+   * once.
+   *
+   * @param a First set of string indices.
+   * @param b Second set of string indices.
+   * @param k Matrix to store K(a_i, b_j) in, as element (i, j).
+   */
+  void Evaluate(const arma::mat& a, const arma::mat& b, arma::mat& k) const;
+
+  //! Get the number of datasets.
+  size_t NumDatasets() const { return offsets.size(); }
+  //! Get the number of strings in the given dataset.
+  size_t NumStrings(const size_t dataset) const
+  { return offsets[dataset].size() - 1; }
+
+  //! Get the distinct substrings of all of the strings, in alphabetical order.
+  const std::vector<std::string>& Substrings() const { return substrings; }
+
+  //! Get the number of distinct substrings of the given string.
+  size_t SpectrumSize(const size_t dataset, const size_t index) const
+  { return offsets[dataset][index + 1] - offsets[dataset][index]; }
+
+  /**
+   * Get the number of times the given substring appears in the given string.
+   *
+   * @param dataset Index of the dataset of the string.
+   * @param index Index of the string in the dataset.
+   * @param substring Substring to count (in lowercase).
+   */
+  size_t Count(const size_t dataset,
+               const size_t index,
+               const std::string& substring) const;
 
   //! Access the value of p.
   size_t P() const { return p; }
@@ -113,9 +146,22 @@ class PSpectrumStringKernel
   //! The datasets.
   const std::vector<std::vector<std::string> >& datasets;
 
-  //! Mappings of the datasets to counts of substrings.  Such a huge structure
-  //! is not wonderful...
-  std::vector<std::vector<std::map<std::string, int> > > counts;
+  //! The distinct substrings of length p, in alphabetical order.
+  std::vector<std::string> substrings;
+
+  //! For every string, the (sorted) indices of its substrings and their
+  //! counts, one string after another.
+  std::vector<std::pair<size_t, size_t> > spectra;
+
+  //! For each dataset, the position in spectra where each string begins (and,
+  //! as the last element, where the last string ends).
+  std::vector<std::vector<size_t> > offsets;
+
+  //! Compute the kernel from two spectra (each a sorted range of spectra).
+  static double Product(const std::pair<size_t, size_t>* aBegin,
+                        const std::pair<size_t, size_t>* aEnd,
+                        const std::pair<size_t, size_t>* bBegin,
+                        const std::pair<size_t, size_t>* bEnd);
 
   //! The value of p to use in calculation.
   size_t p;
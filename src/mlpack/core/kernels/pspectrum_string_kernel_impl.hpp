@@ -31,44 +31,52 @@ template<typename VecType>
 double PSpectrumStringKernel::Evaluate(const VecType& a,
                                        const VecType& b) const
 {
-  // Get the map of substrings for the two strings we are interested in.
-  const std::map<std::string, int>& aMap = counts[a[0]][a[1]];
-  const std::map<std::string, int>& bMap = counts[b[0]][b[1]];
+  // Get the spectra of the two strings we are interested in.
+  const std::vector<size_t>& aOffsets = offsets[(size_t) a[0]];
+  const std::vector<size_t>& bOffsets = offsets[(size_t) b[0]];
+  const size_t aIndex = (size_t) a[1];
+  const size_t bIndex = (size_t) b[1];
 
-  double eval = 0;
+  return Product(spectra.data() + aOffsets[aIndex],
+                 spectra.data() + aOffsets[aIndex + 1],
+                 spectra.data() + bOffsets[bIndex],
+                 spectra.data() + bOffsets[bIndex + 1]);
+}
 
-  // Loop through the two maps (which, when iterated through, are sorted
-  // alphabetically).
-  std::map<std::string, int>::const_iterator aIt = aMap.begin();
-  std::map<std::string, int>::const_iterator bIt = bMap.begin();
+inline double PSpectrumStringKernel::Product(
+    const std::pair<size_t, size_t>* aBegin,
+    const std::pair<size_t, size_t>* aEnd,
+    const std::pair<size_t, size_t>* bBegin,
+    const std::pair<size_t, size_t>* bEnd)
+{
+  double eval = 0;
 
-  while ((aIt != aMap.end()) && (bIt != bMap.end()))
+  // Loop through the two spectra, which are sorted by substring index.
+  while ((aBegin != aEnd) && (bBegin != bEnd))
   {
-    // Compare alphabetically (this is how std::map is ordered).
-    int result = (*aIt).first.compare((*bIt).first);
-
-    if (result == 0) // The same substring.
+    if (aBegin->first == bBegin->first) // The same substring.
     {
-      eval += ((*aIt).second * (*bIt).second);
+      eval += (double) (aBegin->second * bBegin->second);
 
       // Now increment both.
-      ++aIt;
-      ++bIt;
+      ++aBegin;
+      ++bBegin;
     }
-    else if (result > 0)
+    else if (aBegin->first > bBegin->first)
     {
-      // aIt is "ahead" of bIt (alphabetically); so increment bIt to "catch up".
-      ++bIt;
+      // aBegin is "ahead" of bBegin; so increment bBegin to "catch up".
+      ++bBegin;
     }
     else
     {
-      // bIt is "ahead" of aIt (alphabetically); so increment aIt to "catch up".
-      ++aIt;
+      // bBegin is "ahead" of aBegin; so increment aBegin to "catch up".
+      ++aBegin;
     }
   }
 
   return eval;
 }
+
 }; // namespace kernel
 }; // namespace mlpack
 
@@ -130,6 +130,8 @@ class KernelTraits<SphericalKernel>
   static const bool IsNormalized = true;
   //! The spherical kernel doesn't include a squared distance.
   static const bool UsesSquaredDistance = false;
+  //! The spherical kernel decreases with the distance between its inputs.
+  static const bool DecreasesWithDistance = true;
 };
 
 }; // namespace kernel
@@ -110,6 +110,8 @@ class KernelTraits<TriangularKernel>
   static const bool IsNormalized = true;
   //! The triangular kernel doesn't include a squared distance.
   static const bool UsesSquaredDistance = false;
+  //! The triangular kernel decreases with the distance between its inputs.
+  static const bool DecreasesWithDistance = true;
 };
 
 }; // namespace kernel
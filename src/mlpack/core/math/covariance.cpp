@@ -0,0 +1,176 @@
+/**
+ * @file covariance.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the blocked covariance accumulator.
+ */
+#include "covariance.hpp"
+
+#include <mlpack/core/util/parallel.hpp>
+
+using namespace mlpack;
+using namespace mlpack::math;
+
+CovarianceAccumulator::CovarianceAccumulator(const size_t dimensionality) :
+    weight(0.0),
+    mean(arma::zeros<arma::vec>(dimensionality)),
+    scatter(arma::zeros<arma::mat>(dimensionality, dimensionality))
+{ }
+
+void CovarianceAccumulator::Add(const arma::mat& observations)
+{
+  Add(observations, NULL);
+}
+
+void CovarianceAccumulator::Add(const arma::mat& observations,
+                                const arma::vec& weights)
+{
+  if (weights.n_elem != observations.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "CovarianceAccumulator::Add(): " << weights.n_elem << " weights "
+        << "given for " << observations.n_cols << " observations";
+    throw std::invalid_argument(oss.str());
+  }
+
+  Add(observations, &weights);
+}
+
+void CovarianceAccumulator::Merge(const CovarianceAccumulator& other)
+{
+  if (other.weight == 0.0)
+    return;
+
+  if (weight == 0.0 && mean.n_elem != other.mean.n_elem)
+  {
+    *this = other;
+    return;
+  }
+
+  if (other.mean.n_elem != mean.n_elem)
+  {
+    std::ostringstream oss;
+    oss << "CovarianceAccumulator::Merge(): dimensionality of other "
+        << "accumulator (" << other.mean.n_elem << ") does not match "
+        << "dimensionality of this accumulator (" << mean.n_elem << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  Merge(other.weight, other.mean, other.scatter);
+}
+
+arma::mat CovarianceAccumulator::Covariance(const size_t normType) const
+{
+  if (weight == 0.0)
+    return arma::zeros<arma::mat>(mean.n_elem, mean.n_elem);
+
+  // The same normalization as ccov(): N - 1 (or 1, if there is only one
+  // observation) for normType 0, and N for normType 1.
+  const double norm = (normType == 0) ? ((weight > 1.0) ? weight - 1.0 : 1.0)
+      : weight;
+  return scatter / norm;
+}
+
+void CovarianceAccumulator::Add(const arma::mat& observations,
+                                const arma::vec* weights)
+{
+  if (observations.n_cols == 0)
+    return;
+
+  // The first observations set the dimensionality, if it was not given.
+  if (weight == 0.0 && mean.n_elem != observations.n_rows)
+  {
+    mean.zeros(observations.n_rows);
+    scatter.zeros(observations.n_rows, observations.n_rows);
+  }
+
+  if (observations.n_rows != mean.n_elem)
+  {
+    std::ostringstream oss;
+    oss << "CovarianceAccumulator::Add(): dimensionality of observations ("
+        << observations.n_rows << ") does not match dimensionality of "
+        << "accumulator (" << mean.n_elem << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Each thread merges the statistics of its own blocks, and then those of the
+  // threads are merged in order.
+  const CovarianceAccumulator blocks = parallel::BlockReduce(
+      observations.n_cols, BlockSize,
+      CovarianceAccumulator(observations.n_rows),
+      [&](CovarianceAccumulator& accumulator, const size_t begin,
+          const size_t end)
+      {
+        const size_t count = end - begin;
+        const arma::mat blockObservations(const_cast<double*>(
+            observations.colptr(begin)), observations.n_rows, count, false,
+            true);
+
+        // The first pass over the block finds its mean, and the second its
+        // scatter matrix.
+        double blockWeight;
+        arma::vec blockMean;
+        if (weights == NULL)
+        {
+          blockWeight = (double) count;
+          blockMean = arma::sum(blockObservations, 1) / blockWeight;
+        }
+        else
+        {
+          const arma::vec blockWeights = weights->subvec(begin, end - 1);
+          blockWeight = arma::accu(blockWeights);
+          if (blockWeight == 0.0)
+            return;
+
+          blockMean = (blockObservations * blockWeights) / blockWeight;
+        }
+
+        arma::mat centered = blockObservations;
+        centered.each_col() -= blockMean;
+        arma::mat blockScatter;
+        if (weights == NULL)
+        {
+          blockScatter = centered * arma::trans(centered);
+        }
+        else
+        {
+          arma::mat weighted = centered;
+          for (size_t j = 0; j < count; ++j)
+            weighted.col(j) *= (*weights)[begin + j];
+          blockScatter = centered * arma::trans(weighted);
+        }
+
+        accumulator.Merge(blockWeight, blockMean, blockScatter);
+      },
+      [](CovarianceAccumulator& total, const CovarianceAccumulator& other)
+      {
+        total.Merge(other);
+      });
+
+  Merge(blocks);
+}
+
+void CovarianceAccumulator::Merge(const double otherWeight,
+                                  const arma::vec& otherMean,
+                                  const arma::mat& otherScatter)
+{
+  if (otherWeight == 0.0)
+    return;
+
+  if (weight == 0.0)
+  {
+    weight = otherWeight;
+    mean = otherMean;
+    scatter = otherScatter;
+    return;
+  }
+
+  // The scatter of the union is the sum of the scatters, plus the scatter of
+  // the two means about the mean of the union.
+  const double total = weight + otherWeight;
+  const arma::vec delta = otherMean - mean;
+  mean += (otherWeight / total) * delta;
+  scatter += otherScatter + ((weight * otherWeight / total) * delta) *
+      arma::trans(delta);
+  weight = total;
+}
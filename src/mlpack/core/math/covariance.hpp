@@ -0,0 +1,119 @@
+/**
+ * @file covariance.hpp
+ * @author Ryan Curtin
+ *
+ * Blocked, parallel, single-pass computation of the mean and covariance of a
+ * set of (possibly weighted) observations, which may be given in chunks.
+ */
+#ifndef __MLPACK_CORE_MATH_COVARIANCE_HPP
+#define __MLPACK_CORE_MATH_COVARIANCE_HPP
+
+#include <mlpack/prereqs.hpp>
+
+namespace mlpack {
+namespace math {
+
+/**
+ * Accumulate the mean and covariance of observations (one per column), which
+ * may be weighted, without making a centered copy of them.  The observations
+ * are split into blocks of BlockSize columns; the mean and scatter matrix (the
+ * sum of the weighted outer products of the centered observations) of each
+ * block are computed with two passes over the block, so they are as accurate
+ * as a centered copy would give, and the statistics of the blocks are merged
+ * with the update of Chan, Golub, and LeVeque ("Updating formulae and a
+ * pairwise algorithm for computing sample variances", 1979).  If mlpack is
+ * compiled with OpenMP, the blocks are split across threads, with a static
+ * schedule, so the result is the same for a fixed number of threads.
+ *
+ * Add() can be called any number of times, with a chunk of the observations
+ * each time, and Merge() combines accumulators of different chunks, so the
+ * observations never have to be in memory at once.
+ *
+ * @code
+ * math::CovarianceAccumulator accumulator;
+ * while (reader.Read(chunk))
+ *   accumulator.Add(chunk);
+ * const arma::mat covariance = accumulator.Covariance();
+ * @endcode
+ */
+class CovarianceAccumulator
+{
+ public:
+  //! The number of observations processed together.
+  static const size_t BlockSize = 1024;
+
+  /**
+   * Create an accumulator with no observations.  The dimensionality is set by
+   * the first call to Add(), if it is not given.
+   *
+   * @param dimensionality Dimensionality of the observations.
+   */
+  CovarianceAccumulator(const size_t dimensionality = 0);
+
+  /**
+   * Add the given observations.
+   *
+   * @param observations Observations to add, one per column.
+   */
+  void Add(const arma::mat& observations);
+
+  /**
+   * Add the given weighted observations.  The weights must not be negative; an
+   * integer weight counts as that many copies of its observation.
+   *
+   * @param observations Observations to add, one per column.
+   * @param weights Weight of each observation.
+   */
+  void Add(const arma::mat& observations, const arma::vec& weights);
+
+  /**
+   * Add the observations of the given accumulator, as if they had been given
+   * to this one.
+   *
+   * @param other Accumulator to merge into this one.
+   */
+  void Merge(const CovarianceAccumulator& other);
+
+  /**
+   * Get the covariance of the observations.  With normType 0, the scatter
+   * matrix is divided by the total weight minus one (for unweighted
+   * observations, N - 1, which gives the unbiased estimator, as ccov() does);
+   * with normType 1, it is divided by the total weight (as EM does).
+   *
+   * @param normType How to normalize the scatter matrix (0 or 1).
+   */
+  arma::mat Covariance(const size_t normType = 0) const;
+
+  //! Get the dimensionality of the observations.
+  size_t Dimensionality() const { return mean.n_elem; }
+  //! Get the total weight of the observations (their number, if unweighted).
+  double Weight() const { return weight; }
+  //! Get the weighted mean of the observations.
+  const arma::vec& Mean() const { return mean; }
+  //! Get the weighted sum of the outer products of the centered observations.
+  const arma::mat& Scatter() const { return scatter; }
+
+ private:
+  //! The total weight of the observations.
+  double weight;
+  //! The weighted mean of the observations.
+  arma::vec mean;
+  //! The weighted sum of the outer products of the centered observations.
+  arma::mat scatter;
+
+  /**
+   * Add the given observations, weighted with the given weights if they are
+   * not NULL.
+   */
+  void Add(const arma::mat& observations, const arma::vec* weights);
+
+  //! Merge the statistics of a block of observations into this accumulator.
+  void Merge(const double otherWeight,
+             const arma::vec& otherMean,
+             const arma::mat& otherScatter);
+};
+
+}; // namespace math
+}; // namespace mlpack
+
+#endif
@@ -10,6 +10,15 @@
 using namespace mlpack;
 using namespace math;
 
+// Get the covariance of the columns of x with a blocked, parallel pass (see
+// CovarianceAccumulator), instead of ccov().
+static arma::mat ColumnCovariance(const arma::mat& x)
+{
+  CovarianceAccumulator accumulator(x.n_rows);
+  accumulator.Add(x);
+  return accumulator.Covariance();
+}
+
 /**
  * Auxiliary function to raise vector elements to a specific power.  The sign
  * is ignored in the power operation and then re-added.  Useful for
@@ -27,6 +36,46 @@ void mlpack::math::VectorPower(arma::vec& vec, const double power)
   }
 }
 
+// The number of columns that TransformInPlace() multiplies at once.
+static const size_t transformBlockSize = 1024;
+
+// Get the whitening matrix of x from the singular value decomposition of its
+// covariance matrix.
+static void SVDWhiteningMatrix(const arma::mat& x, arma::mat& whiteningMatrix)
+{
+  arma::mat covX, u, v, invSMatrix;
+  arma::vec sVector;
+
+  covX = ColumnCovariance(x);
+
+  svd(u, sVector, v, covX);
+
+  size_t d = sVector.n_elem;
+  invSMatrix.zeros(d, d);
+  invSMatrix.diag() = 1 / sqrt(sVector);
+
+  whiteningMatrix = v * invSMatrix * trans(u);
+}
+
+// Get the whitening matrix of x from the eigendecomposition of its covariance
+// matrix.
+static void EigWhiteningMatrix(const arma::mat& x, arma::mat& whiteningMatrix)
+{
+  arma::mat diag, eigenvectors;
+  arma::vec eigenvalues;
+
+  // Get eigenvectors of covariance of input matrix.
+  eig_sym(eigenvalues, eigenvectors, ColumnCovariance(x));
+
+  // Generate diagonal matrix using 1 / sqrt(eigenvalues) for each value.
+  VectorPower(eigenvalues, -0.5);
+  diag.zeros(eigenvalues.n_elem, eigenvalues.n_elem);
+  diag.diag() = eigenvalues;
+
+  // Our whitening matrix is diag(1 / sqrt(eigenvectors)) * eigenvalues.
+  whiteningMatrix = diag * trans(eigenvectors);
+}
+
 /**
  * Creates a centered matrix, where centering is done by subtracting
  * the sum over the columns (a column vector) from each column of the matrix.
@@ -35,11 +84,66 @@ void mlpack::math::VectorPower(arma::vec& vec, const double power)
  * @param xCentered Matrix to write centered output into
  */
 void mlpack::math::Center(const arma::mat& x, arma::mat& xCentered)
+{
+  // Copy the matrix (unless it is the output already) and center the copy in
+  // place, so that no other full-size temporary is needed.
+  if (&x != &xCentered)
+    xCentered = x;
+
+  Center(xCentered);
+}
+
+/**
+ * Center a matrix in place, by subtracting the mean of the columns from each
+ * column.
+ */
+void mlpack::math::Center(arma::mat& x)
 {
   // Get the mean of the elements in each row.
-  arma::vec rowMean = arma::sum(x, 1) / x.n_cols;
+  const arma::vec rowMean = arma::sum(x, 1) / x.n_cols;
 
-  xCentered = x - arma::repmat(rowMean, 1, x.n_cols);
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < x.n_cols; ++i)
+    x.col(i) -= rowMean;
+}
+
+/**
+ * Multiply a matrix by a square transformation in place, one block of columns
+ * at a time.
+ */
+void mlpack::math::TransformInPlace(const arma::mat& transformation,
+                                   arma::mat& x)
+{
+  if (transformation.n_rows != transformation.n_cols ||
+      transformation.n_cols != x.n_rows)
+  {
+    std::ostringstream oss;
+    oss << "TransformInPlace(): transformation must be square with the "
+        << "dimensionality of the matrix (" << x.n_rows << "), but it is "
+        << transformation.n_rows << " x " << transformation.n_cols;
+    throw std::invalid_argument(oss.str());
+  }
+
+  const size_t numBlocks = (x.n_cols + transformBlockSize - 1) /
+      transformBlockSize;
+
+  #pragma omp parallel
+  {
+    // Each thread only needs room for the product of one block.
+    arma::mat product;
+
+    #pragma omp for schedule(static)
+    for (size_t block = 0; block < numBlocks; ++block)
+    {
+      const size_t begin = block * transformBlockSize;
+      const size_t count = std::min(transformBlockSize,
+          (size_t) x.n_cols - begin);
+      const arma::mat columns(x.colptr(begin), x.n_rows, count, false, true);
+
+      product = transformation * columns;
+      x.cols(begin, begin + count - 1) = product;
+    }
+  }
 }
 
 /**
@@ -51,22 +155,20 @@ void mlpack::math::WhitenUsingSVD(const arma::mat& x,
                                   arma::mat& xWhitened,
                                   arma::mat& whiteningMatrix)
 {
-  arma::mat covX, u, v, invSMatrix, temp1;
-  arma::vec sVector;
-
-  covX = ccov(x);
-
-  svd(u, sVector, v, covX);
-
-  size_t d = sVector.n_elem;
-  invSMatrix.zeros(d, d);
-  invSMatrix.diag() = 1 / sqrt(sVector);
-
-  whiteningMatrix = v * invSMatrix * trans(u);
-
+  SVDWhiteningMatrix(x, whiteningMatrix);
   xWhitened = whiteningMatrix * x;
 }
 
+/**
+ * Whitens a matrix in place using the singular value decomposition of the
+ * covariance matrix.
+ */
+void mlpack::math::WhitenUsingSVD(arma::mat& x, arma::mat& whiteningMatrix)
+{
+  SVDWhiteningMatrix(x, whiteningMatrix);
+  TransformInPlace(whiteningMatrix, x);
+}
+
 /**
  * Whitens a matrix using the eigendecomposition of the covariance matrix.
  * Whitening means the covariance matrix of the result is the identity matrix.
@@ -75,24 +177,22 @@ void mlpack::math::WhitenUsingEig(const arma::mat& x,
                                   arma::mat& xWhitened,
                                   arma::mat& whiteningMatrix)
 {
-  arma::mat diag, eigenvectors;
-  arma::vec eigenvalues;
-
-  // Get eigenvectors of covariance of input matrix.
-  eig_sym(eigenvalues, eigenvectors, ccov(x));
-
-  // Generate diagonal matrix using 1 / sqrt(eigenvalues) for each value.
-  VectorPower(eigenvalues, -0.5);
-  diag.zeros(eigenvalues.n_elem, eigenvalues.n_elem);
-  diag.diag() = eigenvalues;
-
-  // Our whitening matrix is diag(1 / sqrt(eigenvectors)) * eigenvalues.
-  whiteningMatrix = diag * trans(eigenvectors);
+  EigWhiteningMatrix(x, whiteningMatrix);
 
   // Now apply the whitening matrix.
   xWhitened = whiteningMatrix * x;
 }
 
+/**
+ * Whitens a matrix in place using the eigendecomposition of the covariance
+ * matrix.
+ */
+void mlpack::math::WhitenUsingEig(arma::mat& x, arma::mat& whiteningMatrix)
+{
+  EigWhiteningMatrix(x, whiteningMatrix);
+  TransformInPlace(whiteningMatrix, x);
+}
+
 /**
  * Overwrites a dimension-N vector to a random vector on the unit sphere in R^N.
  */
@@ -129,7 +229,7 @@ void mlpack::math::Orthogonalize(const arma::mat& x, arma::mat& W)
   // eigendecomposition of the matrix A.
   arma::mat eigenvalues, eigenvectors;
   arma::vec egval;
-  eig_sym(egval, eigenvectors, ccov(x));
+  eig_sym(egval, eigenvectors, ColumnCovariance(x));
   VectorPower(egval, -0.5);
 
   eigenvalues.zeros(egval.n_elem, egval.n_elem);
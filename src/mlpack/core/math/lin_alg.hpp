@@ -31,6 +31,28 @@ void VectorPower(arma::vec& vec, const double power);
  */
 void Center(const arma::mat& x, arma::mat& xCentered);
 
+/**
+ * Centers the given matrix in place, by subtracting the mean of the columns
+ * from each column.  No full-size temporary is made, and the columns are
+ * updated in parallel if mlpack is compiled with OpenMP.
+ *
+ * @param x Matrix to center.
+ */
+void Center(arma::mat& x);
+
+/**
+ * Multiplies the given matrix by the given square transformation in place
+ * (x = transformation * x), one block of columns at a time, so that only a
+ * workspace of one block per thread is needed instead of a full-size copy.
+ * The blocks are transformed in parallel if mlpack is compiled with OpenMP.
+ * std::invalid_argument is thrown if the transformation is not square with the
+ * dimensionality of x.
+ *
+ * @param transformation Square matrix to multiply by.
+ * @param x Matrix to transform.
+ */
+void TransformInPlace(const arma::mat& transformation, arma::mat& x);
+
 /**
  * Whitens a matrix using the singular value decomposition of the covariance
  * matrix. Whitening means the covariance matrix of the result is the identity
@@ -40,6 +62,12 @@ void WhitenUsingSVD(const arma::mat& x,
                     arma::mat& xWhitened,
                     arma::mat& whiteningMatrix);
 
+/**
+ * Whitens a matrix in place using the singular value decomposition of the
+ * covariance matrix (see TransformInPlace()).
+ */
+void WhitenUsingSVD(arma::mat& x, arma::mat& whiteningMatrix);
+
 /**
  * Whitens a matrix using the eigendecomposition of the covariance matrix.
  * Whitening means the covariance matrix of the result is the identity matrix.
@@ -48,6 +76,12 @@ void WhitenUsingEig(const arma::mat& x,
                     arma::mat& xWhitened,
                     arma::mat& whiteningMatrix);
 
+/**
+ * Whitens a matrix in place using the eigendecomposition of the covariance
+ * matrix (see TransformInPlace()).
+ */
+void WhitenUsingEig(arma::mat& x, arma::mat& whiteningMatrix);
+
 /**
  * Overwrites a dimension-N vector to a random vector on the unit sphere in R^N.
  */
@@ -0,0 +1,127 @@
+/**
+ * @file mpi_reducer.hpp
+ * @author Ryan Curtin
+ *
+ * A Reducer that adds up statistics over the ranks of an MPI job.  This header
+ * is not included by mlpack/core.hpp, since it needs MPI; programs that include
+ * it must be compiled and linked with MPI.
+ */
+#ifndef __MLPACK_CORE_MATH_MPI_REDUCER_HPP
+#define __MLPACK_CORE_MATH_MPI_REDUCER_HPP
+
+#include <mpi.h>
+
+#include <mlpack/prereqs.hpp>
+#include <climits>
+#include <exception>
+#include "reducer.hpp"
+
+namespace mlpack {
+namespace math {
+
+/**
+ * Initialize MPI when constructed and finalize it when destroyed.  While it
+ * exists, an uncaught exception (such as the one thrown by Log::Fatal) on any
+ * rank aborts the whole job, since the other ranks would otherwise wait for
+ * that rank forever.
+ */
+class MPISession
+{
+ public:
+  MPISession()
+  {
+    MPI_Init(NULL, NULL);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+    std::set_terminate(Abort);
+  }
+
+  ~MPISession() { MPI_Finalize(); }
+
+  //! Get the rank of this process.
+  int Rank() const { return rank; }
+  //! Get the number of ranks.
+  int Ranks() const { return ranks; }
+  //! Return whether this is the root rank (rank 0).
+  bool Root() const { return rank == 0; }
+
+  /**
+   * Get the name of the file of this rank: each "%r" in the given file name is
+   * replaced with the rank, so that every rank can load its own shard.
+   */
+  std::string RankFileName(const std::string& filename) const
+  {
+    std::ostringstream rankString;
+    rankString << rank;
+
+    std::string result = filename;
+    size_t position = 0;
+    while ((position = result.find("%r", position)) != std::string::npos)
+    {
+      result.replace(position, 2, rankString.str());
+      position += rankString.str().size();
+    }
+
+    return result;
+  }
+
+ private:
+  //! The rank of this process.
+  int rank;
+  //! The number of ranks.
+  int ranks;
+
+  //! Abort the whole job.
+  static void Abort()
+  {
+    MPI_Abort(MPI_COMM_WORLD, 1);
+    std::abort();
+  }
+
+  // MPI can only be initialized once.
+  MPISession(const MPISession& other);
+  MPISession& operator=(const MPISession& other);
+};
+
+/**
+ * A Reducer that adds up values over the ranks of an MPI communicator with
+ * MPI_Allreduce(), and broadcasts them from rank 0 with MPI_Bcast().  MPI must
+ * be initialized (for instance, by an MPISession) while it is used.
+ */
+class MPIReducer : public Reducer
+{
+ public:
+  /**
+   * Reduce over the ranks of the given communicator.
+   *
+   * @param communicator Communicator of the ranks that hold the shards.
+   */
+  MPIReducer(MPI_Comm communicator = MPI_COMM_WORLD) :
+      communicator(communicator)
+  { }
+
+  void Sum(double* values, const size_t n)
+  {
+    // MPI counts are ints, so large arrays are reduced in pieces.
+    for (size_t begin = 0; begin < n; begin += (size_t) INT_MAX)
+      MPI_Allreduce(MPI_IN_PLACE, values + begin,
+          (int) std::min((size_t) INT_MAX, n - begin), MPI_DOUBLE, MPI_SUM,
+          communicator);
+  }
+
+  void Broadcast(double* values, const size_t n)
+  {
+    for (size_t begin = 0; begin < n; begin += (size_t) INT_MAX)
+      MPI_Bcast(values + begin, (int) std::min((size_t) INT_MAX, n - begin),
+          MPI_DOUBLE, 0, communicator);
+  }
+
+ private:
+  //! The communicator of the ranks.
+  MPI_Comm communicator;
+};
+
+}; // namespace math
+}; // namespace mlpack
+
+#endif
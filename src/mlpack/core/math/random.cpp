@@ -3,7 +3,11 @@
  *
  * Declarations of global random number generators.
  */
-#include <random>
+#include "random.hpp"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
 
 namespace mlpack {
 namespace math {
@@ -14,6 +18,50 @@ std::mt19937 randGen;
 std::uniform_real_distribution<> randUniformDist(0.0, 1.0);
 // Global normal distribution.
 std::normal_distribution<> randNormalDist(0.0, 1.0);
+// The seed of the random streams.
+uint64_t randSeed = 0;
+// The number of times the seed has been set.
+std::atomic<size_t> randGeneration(0);
+// The number of streams given out since the seed was set.
+std::atomic<uint64_t> randStreams(0);
+// The thread that uses randGen is the one that initializes the library.
+std::thread::id randMainThread = std::this_thread::get_id();
+// No thread overrides its stream until it makes a ScopedRandomStream.
+thread_local RandomStream* randStreamOverride = NULL;
+
+// Get the index of the stream of the calling thread.  The streams of threads
+// are far from the ones given out by NewRandomStream(); the threads of an
+// OpenMP parallel region are numbered by the region, and any other threads in
+// the order they first ask for a random number.
+static uint64_t ThreadStreamIndex()
+{
+  const uint64_t threadStreams = ((uint64_t) 1) << 63;
+#ifdef _OPENMP
+  if (omp_in_parallel())
+    return threadStreams + (uint64_t) omp_get_thread_num();
+#endif
+
+  static std::atomic<uint64_t> otherThreads(0);
+  return threadStreams + (((uint64_t) 1) << 62) + otherThreads++;
+}
+
+RandomStream& ThreadRandomStream()
+{
+  thread_local const uint64_t index = ThreadStreamIndex();
+  thread_local RandomStream stream;
+  thread_local size_t generation = 0;
+
+  // Derive the stream from the current seed, if it has not been yet.  The
+  // generation is never 0 once the stream has been derived.
+  const size_t current = randGeneration + 1;
+  if (generation != current)
+  {
+    stream = RandomStream(randSeed, index);
+    generation = current;
+  }
+
+  return stream;
+}
 
 }; // namespace math
 }; // namespace mlpack
@@ -7,7 +7,11 @@
 #define __MLPACK_CORE_MATH_RANDOM_HPP
 
 #include <mlpack/prereqs.hpp>
+#include <atomic>
 #include <random>
+#include <thread>
+
+#include "random_stream.hpp"
 
 namespace mlpack {
 namespace math /** Miscellaneous math routines. */ {
@@ -18,17 +22,113 @@ extern std::mt19937 randGen;
 extern std::uniform_real_distribution<> randUniformDist;
 // Global normal distribution.
 extern std::normal_distribution<> randNormalDist;
+// The seed given to RandomSeed(), which the random streams are derived from.
+extern uint64_t randSeed;
+// The number of times the seed has been set, so that the stream of each thread
+// is derived from the current seed.
+extern std::atomic<size_t> randGeneration;
+// The number of streams given out by NewRandomStream() since the seed was set.
+extern std::atomic<uint64_t> randStreams;
+// The thread that uses randGen; every other thread uses its own stream.
+extern std::thread::id randMainThread;
+// The stream that the random functions of the calling thread use instead, if
+// one has been given with a ScopedRandomStream.
+extern thread_local RandomStream* randStreamOverride;
+
+/**
+ * Get the random stream of the calling thread.  The random functions (Random(),
+ * RandInt(), and RandNormal()) use it on every thread but the main thread
+ * (which uses randGen), so that they can be called from parallel code.  The
+ * stream is derived from the seed given to RandomSeed() and, for the threads
+ * of an OpenMP parallel region, from the number of the thread; so, a parallel
+ * run with a static schedule and the same number of threads gets the same
+ * random numbers.
+ */
+RandomStream& ThreadRandomStream();
+
+/**
+ * Get a new random stream for a component to use, independent of all of the
+ * other streams derived from the seed given to RandomSeed().  The n'th stream
+ * requested after the seed is set is always the same.
+ */
+inline RandomStream NewRandomStream()
+{
+  return RandomStream(randSeed, randStreams++);
+}
+
+//! Check whether the calling thread uses randGen (see ThreadRandomStream()).
+inline bool OnMainRandomThread()
+{
+  return std::this_thread::get_id() == randMainThread;
+}
+
+/**
+ * Make the random functions (Random(), RandInt(), and RandNormal()) of the
+ * calling thread draw from the given stream for as long as this object lives,
+ * on the main thread too.  This gives each task of a parallel loop its own
+ * stream even when the task calls code that uses the random functions, so the
+ * results of each task do not depend on which thread runs it.
+ *
+ * @code
+ * math::RandomStream stream = math::NewRandomStream();
+ * #pragma omp parallel for
+ * for (size_t i = 0; i < tasks; ++i)
+ * {
+ *   math::RandomStream taskStream = stream.Split(i);
+ *   math::ScopedRandomStream scope(taskStream);
+ *   // Any math::Random() call in here draws from taskStream.
+ * }
+ * @endcode
+ */
+class ScopedRandomStream
+{
+ public:
+  //! Make the random functions of this thread use the given stream.
+  ScopedRandomStream(RandomStream& stream) : previous(randStreamOverride)
+  {
+    randStreamOverride = &stream;
+  }
+
+  //! Go back to the stream that was used before.
+  ~ScopedRandomStream() { randStreamOverride = previous; }
+
+ private:
+  //! The stream that was used before.
+  RandomStream* previous;
+
+  // Scopes must be nested, so they cannot be copied.
+  ScopedRandomStream(const ScopedRandomStream& other);
+  ScopedRandomStream& operator=(const ScopedRandomStream& other);
+};
+
+/**
+ * Get the stream that the random functions of the calling thread use, or NULL
+ * if they use randGen: that is the stream of a ScopedRandomStream if there is
+ * one, and otherwise ThreadRandomStream() on every thread but the main thread.
+ */
+inline RandomStream* CallerRandomStream()
+{
+  if (randStreamOverride != NULL)
+    return randStreamOverride;
+
+  return OnMainRandomThread() ? NULL : &ThreadRandomStream();
+}
 
 /**
  * Set the random seed used by the random functions (Random() and RandInt()).
  * The seed is casted to a 32-bit integer before being given to the random
  * number generator, but a size_t is taken as a parameter for API consistency.
+ * The random streams (see NewRandomStream() and ThreadRandomStream()) are
+ * derived from the whole seed.
  *
  * @param seed Seed for the random number generator.
  */
 inline void RandomSeed(const size_t seed)
 {
   randGen.seed((uint32_t) seed);
+  randSeed = (uint64_t) seed;
+  randStreams = 0;
+  ++randGeneration;
   srand((unsigned int) seed);
 #if ARMA_VERSION_MAJOR > 3 || \
     (ARMA_VERSION_MAJOR == 3 && ARMA_VERSION_MINOR >= 930)
@@ -43,6 +143,10 @@ inline void RandomSeed(const size_t seed)
  */
 inline double Random()
 {
+  RandomStream* stream = CallerRandomStream();
+  if (stream != NULL)
+    return stream->Random();
+
   return randUniformDist(randGen);
 }
 
@@ -51,6 +155,10 @@ inline double Random()
  */
 inline double Random(const double lo, const double hi)
 {
+  RandomStream* stream = CallerRandomStream();
+  if (stream != NULL)
+    return stream->Random(lo, hi);
+
   return lo + (hi - lo) * randUniformDist(randGen);
 }
 
@@ -59,6 +167,10 @@ inline double Random(const double lo, const double hi)
  */
 inline int RandInt(const int hiExclusive)
 {
+  RandomStream* stream = CallerRandomStream();
+  if (stream != NULL)
+    return stream->RandInt(hiExclusive);
+
   return (int) std::floor((double) hiExclusive * randUniformDist(randGen));
 }
 
@@ -67,6 +179,10 @@ inline int RandInt(const int hiExclusive)
  */
 inline int RandInt(const int lo, const int hiExclusive)
 {
+  RandomStream* stream = CallerRandomStream();
+  if (stream != NULL)
+    return stream->RandInt(lo, hiExclusive);
+
   return lo + (int) std::floor((double) (hiExclusive - lo)
                                * randUniformDist(randGen));
 }
@@ -76,6 +192,10 @@ inline int RandInt(const int lo, const int hiExclusive)
  */
 inline double RandNormal()
 {
+  RandomStream* stream = CallerRandomStream();
+  if (stream != NULL)
+    return stream->RandNormal();
+
   return randNormalDist(randGen);
 }
 
@@ -88,6 +208,10 @@ inline double RandNormal()
  */
 inline double RandNormal(const double mean, const double variance)
 {
+  RandomStream* stream = CallerRandomStream();
+  if (stream != NULL)
+    return stream->RandNormal(mean, variance);
+
   return variance * randNormalDist(randGen) + mean;
 }
 
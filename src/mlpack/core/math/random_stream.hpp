@@ -0,0 +1,279 @@
+/**
+ * @file random_stream.hpp
+ * @author Ryan Curtin
+ *
+ * A counter-based random number generator (Philox4x32-10), which gives any
+ * number of independent streams of random numbers from one seed.
+ */
+#ifndef __MLPACK_CORE_MATH_RANDOM_STREAM_HPP
+#define __MLPACK_CORE_MATH_RANDOM_STREAM_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <stdint.h>
+
+namespace mlpack {
+namespace math {
+
+/**
+ * A stream of random numbers from the Philox4x32-10 counter-based generator
+ * (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", 2011).  The
+ * n'th block of four 32-bit numbers of a stream is a function of only the
+ * seed, the index of the stream, and n; so, there are 2^64 independent streams
+ * for each seed, skipping ahead in a stream takes constant time, and the
+ * blocks of a stream can be computed in any order (and in parallel).
+ *
+ * This makes it possible for each thread, or each task of a parallel loop, to
+ * have its own stream, and to get the same random numbers no matter how many
+ * threads there are or how the work is scheduled.  NewRandomStream() gives a
+ * component a stream of its own, derived from the seed given to RandomSeed(),
+ * and ThreadRandomStream() is the stream of the calling thread.
+ *
+ * A RandomStream satisfies the requirements of a uniform random number
+ * generator, so it can be used with std::shuffle() and the distributions of
+ * <random>.
+ *
+ * @code
+ * math::RandomStream stream = math::NewRandomStream();
+ * #pragma omp parallel for
+ * for (size_t i = 0; i < tasks; ++i)
+ * {
+ *   // Task i gets the same numbers however the loop is scheduled.
+ *   math::RandomStream taskStream = stream.Split(i);
+ *   const double u = taskStream.Random();
+ *   // ...
+ * }
+ * @endcode
+ */
+class RandomStream
+{
+ public:
+  //! The type of the random numbers.
+  typedef uint32_t result_type;
+
+  /**
+   * Create the given stream of random numbers for the given seed.
+   *
+   * @param seed Seed of the generator.
+   * @param stream Index of the stream.
+   */
+  RandomStream(const uint64_t seed = 0, const uint64_t stream = 0) :
+      seed(seed),
+      stream(stream),
+      counter(0),
+      position(4),
+      hasNormal(false)
+  { }
+
+  //! Get the smallest random number.
+  static constexpr result_type min() { return 0; }
+  //! Get the largest random number.
+  static constexpr result_type max() { return 0xFFFFFFFF; }
+
+  //! Get the next random 32-bit number.
+  result_type operator()()
+  {
+    if (position == 4)
+    {
+      Block(counter++, buffer);
+      position = 0;
+    }
+
+    return buffer[position++];
+  }
+
+  //! Skip the next n random 32-bit numbers, in constant time.
+  void discard(unsigned long long n)
+  {
+    const unsigned long long left = 4 - position;
+    if (n < left)
+    {
+      position += n;
+      return;
+    }
+
+    n -= left;
+    counter += n / 4;
+    position = 4;
+    if (n % 4 != 0)
+    {
+      Block(counter++, buffer);
+      position = n % 4;
+    }
+  }
+
+  /**
+   * Get a stream that is independent of this one and of each of its other
+   * splits, for the given index.  The split depends only on this stream's seed
+   * and index, and not on how many numbers have been drawn from it.
+   */
+  RandomStream Split(const uint64_t index) const
+  {
+    // The seed of the splits is the last block of this stream, which is never
+    // drawn.
+    uint32_t words[4];
+    Block(~((uint64_t) 0), words);
+    return RandomStream(((uint64_t) words[1] << 32) | words[0], index);
+  }
+
+  //! Generate a uniform random number between 0 and 1.
+  double Random()
+  {
+    const uint32_t a = (*this)();
+    const uint32_t b = (*this)();
+    return ToDouble(a, b);
+  }
+
+  //! Generate a uniform random number in the specified range.
+  double Random(const double lo, const double hi)
+  {
+    return lo + (hi - lo) * Random();
+  }
+
+  //! Generate a uniform random integer.
+  int RandInt(const int hiExclusive)
+  {
+    return (int) std::floor((double) hiExclusive * Random());
+  }
+
+  //! Generate a uniform random integer.
+  int RandInt(const int lo, const int hiExclusive)
+  {
+    return lo + (int) std::floor((double) (hiExclusive - lo) * Random());
+  }
+
+  //! Generate a normally distributed random number with mean 0 and variance 1.
+  double RandNormal()
+  {
+    if (hasNormal)
+    {
+      hasNormal = false;
+      return normal;
+    }
+
+    // The Box-Muller transform gives two numbers; the second is kept for the
+    // next call.
+    const double u = Random();
+    const double v = Random();
+    double first;
+    BoxMuller(u, v, first, normal);
+    hasNormal = true;
+    return first;
+  }
+
+  /**
+   * Generate a normally distributed random number with the specified mean and
+   * variance, as math::RandNormal() does.
+   */
+  double RandNormal(const double mean, const double variance)
+  {
+    return variance * RandNormal() + mean;
+  }
+
+  /**
+   * Fill the given matrix with uniform random numbers between 0 and 1.  Each
+   * pair of elements is computed from its own block of the stream, so large
+   * matrices are filled in parallel, and the result (and the state of the
+   * stream afterwards) depends only on the state of the stream before.
+   */
+  template<typename eT>
+  void Randu(arma::Mat<eT>& matrix);
+
+  /**
+   * Fill the given matrix with normally distributed random numbers with mean 0
+   * and variance 1.  As with Randu(), large matrices are filled in parallel.
+   */
+  template<typename eT>
+  void Randn(arma::Mat<eT>& matrix);
+
+  /**
+   * Draw n random bits, each of which is set with probability p, packed into
+   * 64-bit words (bit i is bit i % 64 of word i / 64; the bits past n of the
+   * last word are zero).  Bit i is set if the i'th 32-bit number of the
+   * stream is less than p * 2^32.  As with Randu(), large masks are drawn in
+   * parallel.
+   *
+   * @param n Number of bits to draw.
+   * @param p Probability of each bit being set.
+   * @param bits Vector to store the words in.
+   */
+  void Bernoulli(const size_t n, const double p, std::vector<uint64_t>& bits);
+
+  //! Get the seed of the stream.
+  uint64_t Seed() const { return seed; }
+  //! Get the index of the stream.
+  uint64_t Stream() const { return stream; }
+
+ private:
+  /**
+   * Compute the given block of the stream, with the ten rounds of Philox4x32.
+   * The counter of the block is the index of the block followed by the index
+   * of the stream, and the key is the seed.
+   */
+  void Block(const uint64_t block, uint32_t* words) const
+  {
+    uint32_t c0 = (uint32_t) block;
+    uint32_t c1 = (uint32_t) (block >> 32);
+    uint32_t c2 = (uint32_t) stream;
+    uint32_t c3 = (uint32_t) (stream >> 32);
+    uint32_t k0 = (uint32_t) seed;
+    uint32_t k1 = (uint32_t) (seed >> 32);
+
+    for (size_t round = 0; round < 10; ++round)
+    {
+      const uint64_t p0 = (uint64_t) 0xD2511F53 * c0;
+      const uint64_t p1 = (uint64_t) 0xCD9E8D57 * c2;
+      c0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+      c1 = (uint32_t) p1;
+      c2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+      c3 = (uint32_t) p0;
+
+      k0 += 0x9E3779B9;
+      k1 += 0xBB67AE85;
+    }
+
+    words[0] = c0;
+    words[1] = c1;
+    words[2] = c2;
+    words[3] = c3;
+  }
+
+  //! Make a uniform random number in [0, 1) out of 53 of the bits of a and b.
+  static double ToDouble(const uint32_t a, const uint32_t b)
+  {
+    return ((double) (a >> 5) * 67108864.0 + (double) (b >> 6)) *
+        (1.0 / 9007199254740992.0);
+  }
+
+  //! Turn two uniform random numbers into two normal random numbers.
+  static void BoxMuller(const double u, const double v, double& a, double& b)
+  {
+    // 1 - u is in (0, 1], so the logarithm is finite.
+    const double r = std::sqrt(-2.0 * std::log(1.0 - u));
+    const double theta = 2.0 * M_PI * v;
+    a = r * std::cos(theta);
+    b = r * std::sin(theta);
+  }
+
+  //! The seed.
+  uint64_t seed;
+  //! The index of the stream.
+  uint64_t stream;
+  //! The index of the next block.
+  uint64_t counter;
+  //! The current block.
+  uint32_t buffer[4];
+  //! The position of the next number in the current block.
+  size_t position;
+  //! The second number of the last Box-Muller transform.
+  double normal;
+  //! Whether that number has not been given out yet.
+  bool hasNormal;
+};
+
+} // namespace math
+} // namespace mlpack
+
+// Include implementation.
+#include "random_stream_impl.hpp"
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * @file random_stream_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the matrix fills and bit masks of RandomStream.
+ */
+#ifndef __MLPACK_CORE_MATH_RANDOM_STREAM_IMPL_HPP
+#define __MLPACK_CORE_MATH_RANDOM_STREAM_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "random_stream.hpp"
+
+namespace mlpack {
+namespace math {
+
+template<typename eT>
+void RandomStream::Randu(arma::Mat<eT>& matrix)
+{
+  const size_t n = matrix.n_elem;
+  const size_t blocks = (n + 1) / 2;
+  const uint64_t first = counter;
+  eT* values = matrix.memptr();
+
+  #pragma omp parallel for schedule(static) if (blocks > 16384)
+  for (size_t i = 0; i < blocks; ++i)
+  {
+    uint32_t words[4];
+    Block(first + i, words);
+    values[2 * i] = (eT) ToDouble(words[0], words[1]);
+    if (2 * i + 1 < n)
+      values[2 * i + 1] = (eT) ToDouble(words[2], words[3]);
+  }
+
+  counter += blocks;
+}
+
+template<typename eT>
+void RandomStream::Randn(arma::Mat<eT>& matrix)
+{
+  const size_t n = matrix.n_elem;
+  const size_t blocks = (n + 1) / 2;
+  const uint64_t first = counter;
+  eT* values = matrix.memptr();
+
+  #pragma omp parallel for schedule(static) if (blocks > 16384)
+  for (size_t i = 0; i < blocks; ++i)
+  {
+    uint32_t words[4];
+    Block(first + i, words);
+    double a, b;
+    BoxMuller(ToDouble(words[0], words[1]), ToDouble(words[2], words[3]), a,
+        b);
+    values[2 * i] = (eT) a;
+    if (2 * i + 1 < n)
+      values[2 * i + 1] = (eT) b;
+  }
+
+  counter += blocks;
+}
+
+inline void RandomStream::Bernoulli(const size_t n,
+                                    const double p,
+                                    std::vector<uint64_t>& bits)
+{
+  // Each word takes 16 blocks of four 32-bit numbers.  The threshold is 2^32
+  // for p = 1, so that every bit is set.
+  const size_t words = (n + 63) / 64;
+  const uint64_t threshold = (uint64_t) (std::min(std::max(p, 0.0), 1.0) *
+      4294967296.0);
+  const uint64_t first = counter;
+  bits.resize(words);
+
+  #pragma omp parallel for schedule(static) if (words > 1024)
+  for (size_t w = 0; w < words; ++w)
+  {
+    uint64_t word = 0;
+    for (size_t b = 0; b < 16; ++b)
+    {
+      uint32_t numbers[4];
+      Block(first + 16 * w + b, numbers);
+      for (size_t k = 0; k < 4; ++k)
+        word |= (uint64_t) (numbers[k] < threshold) << (4 * b + k);
+    }
+
+    bits[w] = word;
+  }
+
+  if (n % 64 != 0)
+    bits[words - 1] &= ((uint64_t) 1 << (n % 64)) - 1;
+
+  counter += 16 * words;
+}
+
+} // namespace math
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,50 @@
+/**
+ * @file reducer.hpp
+ * @author Ryan Curtin
+ *
+ * An interface for adding up statistics over the processes that each hold a
+ * shard of a dataset.
+ */
+#ifndef __MLPACK_CORE_MATH_REDUCER_HPP
+#define __MLPACK_CORE_MATH_REDUCER_HPP
+
+#include <mlpack/prereqs.hpp>
+
+namespace mlpack {
+namespace math {
+
+/**
+ * The interface of objects that combine the statistics computed by processes
+ * that each hold a shard of a dataset, so that an algorithm that sums
+ * statistics over the points (like the Lloyd step of k-means, or the M-step of
+ * EM) can run on the whole dataset.  Both functions are collective: every
+ * process must call them in the same order, with the same number of values.
+ * See MPIReducer for an implementation with MPI.
+ */
+class Reducer
+{
+ public:
+  virtual ~Reducer() { }
+
+  /**
+   * Replace each of the given values with its sum over all the processes.
+   *
+   * @param values Values to add up.
+   * @param n Number of values.
+   */
+  virtual void Sum(double* values, const size_t n) = 0;
+
+  /**
+   * Replace each of the given values with the value of the root process, so
+   * that every process has the same values.
+   *
+   * @param values Values to replace.
+   * @param n Number of values.
+   */
+  virtual void Broadcast(double* values, const size_t n) = 0;
+};
+
+}; // namespace math
+}; // namespace mlpack
+
+#endif
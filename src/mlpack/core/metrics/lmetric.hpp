@@ -77,6 +77,23 @@ class LMetric
   template<typename VecTypeA, typename VecTypeB>
   static double Evaluate(const VecTypeA& a, const VecTypeB& b);
 
+  /**
+   * Computes the distance between two points, but stops once the distance is
+   * known to be greater than the given bound.  In that case the returned value
+   * is greater than the bound, but it may be less than the distance.  Only the
+   * L1, L2, and L-infinity metrics stop early; for other powers, this is the
+   * same as Evaluate(a, b).
+   *
+   * @param a First vector.
+   * @param b Second vector.
+   * @param bound Upper bound on the distances that are of interest.
+   * @return Distance between vectors a and b, or a value greater than bound.
+   */
+  template<typename VecTypeA, typename VecTypeB>
+  static double Evaluate(const VecTypeA& a,
+                         const VecTypeB& b,
+                         const double bound);
+
   //! Return a string representation of the object.
   std::string ToString() const;
 
@@ -113,6 +130,48 @@ typedef LMetric<2, true> EuclideanDistance;
  */
 typedef LMetric<INT_MAX, false> ChebyshevDistance;
 
+/**
+ * Utility struct to determine whether or not a metric is the Euclidean (or
+ * squared Euclidean) distance, for which blocks of distances can be computed
+ * with matrix multiplication.
+ */
+template<typename MetricType>
+struct IsEuclideanMetric
+{
+  static const bool Value = false;
+};
+
+//! Specialization for the L2 metric, with or without the square root.
+template<bool TakeRoot>
+struct IsEuclideanMetric<LMetric<2, TakeRoot>>
+{
+  static const bool Value = true;
+};
+
+/**
+ * Evaluate the given metric between two points, with an upper bound on the
+ * distances that are of interest: for LMetrics, the computation stops once the
+ * distance is known to be greater than the bound (see LMetric::Evaluate()).
+ * For other metrics, this is just metric.Evaluate(a, b).
+ */
+template<typename MetricType, typename VecTypeA, typename VecTypeB>
+inline double BoundedEvaluate(MetricType& metric,
+                              const VecTypeA& a,
+                              const VecTypeB& b,
+                              const double /* bound */)
+{
+  return metric.Evaluate(a, b);
+}
+
+//! Evaluate an LMetric with an upper bound on the distance.
+template<int Power, bool TakeRoot, typename VecTypeA, typename VecTypeB>
+inline double BoundedEvaluate(LMetric<Power, TakeRoot>& /* metric */,
+                              const VecTypeA& a,
+                              const VecTypeB& b,
+                              const double bound)
+{
+  return LMetric<Power, TakeRoot>::Evaluate(a, b, bound);
+}
 
 } // namespace metric
 } // namespace mlpack
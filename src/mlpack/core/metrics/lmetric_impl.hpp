@@ -10,9 +10,245 @@
 // In case it hasn't been included.
 #include "lmetric.hpp"
 
+#include "lmetric_simd.hpp"
+
 namespace mlpack {
 namespace metric {
 
+/**
+ * Whether a vector type keeps float or double elements in contiguous memory,
+ * so that the kernels in lmetric_simd.hpp can be used on it.  If so, Memory()
+ * gives a pointer to that memory.
+ */
+template<typename VecType>
+struct ContiguousVector
+{
+  static const bool Value = false;
+  typedef void ElemType;
+};
+
+//! Only float and double have kernels.
+template<typename eT>
+struct HasLMetricKernels
+{
+  static const bool Value = false;
+};
+
+template<>
+struct HasLMetricKernels<float>
+{
+  static const bool Value = true;
+};
+
+template<>
+struct HasLMetricKernels<double>
+{
+  static const bool Value = true;
+};
+
+template<typename eT>
+struct ContiguousVector<arma::Mat<eT>>
+{
+  static const bool Value = HasLMetricKernels<eT>::Value;
+  typedef eT ElemType;
+  static const eT* Memory(const arma::Mat<eT>& v) { return v.memptr(); }
+};
+
+template<typename eT>
+struct ContiguousVector<arma::Col<eT>>
+{
+  static const bool Value = HasLMetricKernels<eT>::Value;
+  typedef eT ElemType;
+  static const eT* Memory(const arma::Col<eT>& v) { return v.memptr(); }
+};
+
+template<typename eT>
+struct ContiguousVector<arma::Row<eT>>
+{
+  static const bool Value = HasLMetricKernels<eT>::Value;
+  typedef eT ElemType;
+  static const eT* Memory(const arma::Row<eT>& v) { return v.memptr(); }
+};
+
+//! A column of a matrix (such as dataset.col(i)) is contiguous too.
+template<typename eT>
+struct ContiguousVector<arma::subview_col<eT>>
+{
+  static const bool Value = HasLMetricKernels<eT>::Value;
+  typedef eT ElemType;
+  static const eT* Memory(const arma::subview_col<eT>& v)
+  { return v.colptr(0); }
+};
+
+/**
+ * The L1, squared L2, and L-infinity distances between two vectors with an
+ * upper bound, computed with Armadillo expressions (which ignore the bound).
+ * The first specialization below uses the SIMD kernels instead, when both
+ * vectors are contiguous and have the same element type; the second merges the
+ * nonzero elements of two sparse vectors.
+ */
+template<typename VecTypeA,
+         typename VecTypeB,
+         bool UseKernels = (ContiguousVector<VecTypeA>::Value &&
+             ContiguousVector<VecTypeB>::Value && std::is_same<
+                 typename ContiguousVector<VecTypeA>::ElemType,
+                 typename ContiguousVector<VecTypeB>::ElemType>::value),
+         bool Sparse = (IsSparseVector<VecTypeA>::value &&
+             IsSparseVector<VecTypeB>::value)>
+struct LMetricKernels
+{
+  static double L1(const VecTypeA& a, const VecTypeB& b, const double)
+  { return accu(abs(a - b)); }
+
+  static double SquaredL2(const VecTypeA& a, const VecTypeB& b, const double)
+  { return accu(square(a - b)); }
+
+  static double LInf(const VecTypeA& a, const VecTypeB& b, const double)
+  { return arma::as_scalar(max(abs(a - b))); }
+};
+
+template<typename VecTypeA, typename VecTypeB>
+struct LMetricKernels<VecTypeA, VecTypeB, true, false>
+{
+  // Vectors of different sizes are passed to Armadillo, which gives the usual
+  // error.
+  typedef LMetricKernels<VecTypeA, VecTypeB, false> ArmadilloKernels;
+
+  static double L1(const VecTypeA& a, const VecTypeB& b, const double bound)
+  {
+    if (a.n_elem != b.n_elem)
+      return ArmadilloKernels::L1(a, b, bound);
+
+    return simd::L1(ContiguousVector<VecTypeA>::Memory(a),
+        ContiguousVector<VecTypeB>::Memory(b), a.n_elem, bound);
+  }
+
+  static double SquaredL2(const VecTypeA& a,
+                          const VecTypeB& b,
+                          const double bound)
+  {
+    if (a.n_elem != b.n_elem)
+      return ArmadilloKernels::SquaredL2(a, b, bound);
+
+    return simd::SquaredL2(ContiguousVector<VecTypeA>::Memory(a),
+        ContiguousVector<VecTypeB>::Memory(b), a.n_elem, bound);
+  }
+
+  static double LInf(const VecTypeA& a, const VecTypeB& b, const double bound)
+  {
+    if (a.n_elem != b.n_elem)
+      return ArmadilloKernels::LInf(a, b, bound);
+
+    return simd::LInf(ContiguousVector<VecTypeA>::Memory(a),
+        ContiguousVector<VecTypeB>::Memory(b), a.n_elem, bound);
+  }
+};
+
+/**
+ * For two sparse vectors (such as columns of an arma::sp_mat), the nonzero
+ * elements are merged in order, so the distance costs time linear in the
+ * number of nonzero elements, not in the dimensionality.  As with the SIMD
+ * kernels, the computation stops once the partial distance is greater than the
+ * bound.
+ */
+template<typename VecTypeA, typename VecTypeB>
+struct LMetricKernels<VecTypeA, VecTypeB, false, true>
+{
+  typedef LMetricKernels<VecTypeA, VecTypeB, false, false> ArmadilloKernels;
+
+  static double L1(const VecTypeA& a, const VecTypeB& b, const double bound)
+  {
+    if (a.n_elem != b.n_elem)
+      return ArmadilloKernels::L1(a, b, bound);
+
+    return Merge<AbsoluteSum>(a, b, bound);
+  }
+
+  static double SquaredL2(const VecTypeA& a,
+                          const VecTypeB& b,
+                          const double bound)
+  {
+    if (a.n_elem != b.n_elem)
+      return ArmadilloKernels::SquaredL2(a, b, bound);
+
+    return Merge<SquaredSum>(a, b, bound);
+  }
+
+  static double LInf(const VecTypeA& a, const VecTypeB& b, const double bound)
+  {
+    if (a.n_elem != b.n_elem)
+      return ArmadilloKernels::LInf(a, b, bound);
+
+    return Merge<Maximum>(a, b, bound);
+  }
+
+ private:
+  //! Add the difference in one dimension to an L1 distance.
+  struct AbsoluteSum
+  {
+    static double Add(const double sum, const double diff)
+    { return sum + std::fabs(diff); }
+  };
+
+  //! Add the difference in one dimension to a squared L2 distance.
+  struct SquaredSum
+  {
+    static double Add(const double sum, const double diff)
+    { return sum + diff * diff; }
+  };
+
+  //! Add the difference in one dimension to an L-infinity distance.
+  struct Maximum
+  {
+    static double Add(const double sum, const double diff)
+    { return std::max(sum, std::fabs(diff)); }
+  };
+
+  //! Accumulate the differences in the dimensions where either vector is
+  //! nonzero; the other dimensions add nothing.
+  template<typename AccumulatorType>
+  static double Merge(const VecTypeA& a, const VecTypeB& b, const double bound)
+  {
+    typename VecTypeA::const_iterator itA = a.begin();
+    typename VecTypeB::const_iterator itB = b.begin();
+    const typename VecTypeA::const_iterator endA = a.end();
+    const typename VecTypeB::const_iterator endB = b.end();
+
+    double sum = 0.0;
+    while (itA != endA || itB != endB)
+    {
+      // The position of an element is its row in a column and its column in a
+      // row; the other index is 0.
+      const size_t posA = (itA != endA) ? (itA.row() + itA.col()) : a.n_elem;
+      const size_t posB = (itB != endB) ? (itB.row() + itB.col()) : b.n_elem;
+
+      double diff;
+      if (posA == posB)
+      {
+        diff = (double) (*itA) - (double) (*itB);
+        ++itA;
+        ++itB;
+      }
+      else if (posA < posB)
+      {
+        diff = (double) (*itA);
+        ++itA;
+      }
+      else
+      {
+        diff = (double) (*itB);
+        ++itB;
+      }
+
+      sum = AccumulatorType::Add(sum, diff);
+      if (sum > bound)
+        break;
+    }
+
+    return sum;
+  }
+};
+
 // Unspecialized implementation.  This should almost never be used...
 template<int Power, bool TakeRoot>
 template<typename VecTypeA, typename VecTypeB>
@@ -29,6 +265,16 @@ double LMetric<Power, TakeRoot>::Evaluate(const VecTypeA& a,
   return pow(sum, (1.0 / Power));
 }
 
+// Without a specialization, the bound is not used.
+template<int Power, bool TakeRoot>
+template<typename VecTypeA, typename VecTypeB>
+double LMetric<Power, TakeRoot>::Evaluate(const VecTypeA& a,
+                                          const VecTypeB& b,
+                                          const double /* bound */)
+{
+  return Evaluate(a, b);
+}
+
 // String conversion.
 template<int Power, bool TakeRoot>
 std::string LMetric<Power, TakeRoot>::ToString() const
@@ -45,14 +291,32 @@ template<>
 template<typename VecTypeA, typename VecTypeB>
 double LMetric<1, true>::Evaluate(const VecTypeA& a, const VecTypeB& b)
 {
-  return accu(abs(a - b));
+  return LMetricKernels<VecTypeA, VecTypeB>::L1(a, b, DBL_MAX);
+}
+
+template<>
+template<typename VecTypeA, typename VecTypeB>
+double LMetric<1, true>::Evaluate(const VecTypeA& a,
+                                  const VecTypeB& b,
+                                  const double bound)
+{
+  return LMetricKernels<VecTypeA, VecTypeB>::L1(a, b, bound);
 }
 
 template<>
 template<typename VecTypeA, typename VecTypeB>
 double LMetric<1, false>::Evaluate(const VecTypeA& a, const VecTypeB& b)
 {
-  return accu(abs(a - b));
+  return LMetricKernels<VecTypeA, VecTypeB>::L1(a, b, DBL_MAX);
+}
+
+template<>
+template<typename VecTypeA, typename VecTypeB>
+double LMetric<1, false>::Evaluate(const VecTypeA& a,
+                                   const VecTypeB& b,
+                                   const double bound)
+{
+  return LMetricKernels<VecTypeA, VecTypeB>::L1(a, b, bound);
 }
 
 // L2-metric specializations.
@@ -60,14 +324,34 @@ template<>
 template<typename VecTypeA, typename VecTypeB>
 double LMetric<2, true>::Evaluate(const VecTypeA& a, const VecTypeB& b)
 {
-  return sqrt(accu(square(a - b)));
+  return sqrt(LMetricKernels<VecTypeA, VecTypeB>::SquaredL2(a, b, DBL_MAX));
+}
+
+template<>
+template<typename VecTypeA, typename VecTypeB>
+double LMetric<2, true>::Evaluate(const VecTypeA& a,
+                                  const VecTypeB& b,
+                                  const double bound)
+{
+  // The square of DBL_MAX is infinite, which is still a valid bound.
+  return sqrt(LMetricKernels<VecTypeA, VecTypeB>::SquaredL2(a, b,
+      bound * bound));
 }
 
 template<>
 template<typename VecTypeA, typename VecTypeB>
 double LMetric<2, false>::Evaluate(const VecTypeA& a, const VecTypeB& b)
 {
-  return accu(square(a - b));
+  return LMetricKernels<VecTypeA, VecTypeB>::SquaredL2(a, b, DBL_MAX);
+}
+
+template<>
+template<typename VecTypeA, typename VecTypeB>
+double LMetric<2, false>::Evaluate(const VecTypeA& a,
+                                   const VecTypeB& b,
+                                   const double bound)
+{
+  return LMetricKernels<VecTypeA, VecTypeB>::SquaredL2(a, b, bound);
 }
 
 // L3-metric specialization (not very likely to be used, but just in case).
@@ -94,7 +378,16 @@ template<>
 template<typename VecTypeA, typename VecTypeB>
 double LMetric<INT_MAX, false>::Evaluate(const VecTypeA& a, const VecTypeB& b)
 {
-  return arma::as_scalar(max(abs(a - b)));
+  return LMetricKernels<VecTypeA, VecTypeB>::LInf(a, b, DBL_MAX);
+}
+
+template<>
+template<typename VecTypeA, typename VecTypeB>
+double LMetric<INT_MAX, false>::Evaluate(const VecTypeA& a,
+                                         const VecTypeB& b,
+                                         const double bound)
+{
+  return LMetricKernels<VecTypeA, VecTypeB>::LInf(a, b, bound);
 }
 
 }; // namespace metric
@@ -0,0 +1,110 @@
+/**
+ * @file lmetric_simd.cpp
+ * @author Ryan Curtin
+ *
+ * The scalar LMetric kernels, and the choice of the kernels to use for the CPU.
+ */
+#include "lmetric_simd.hpp"
+
+using namespace mlpack::metric::simd;
+
+namespace {
+
+//! Scalar "vector" operations, for CPUs without AVX2.
+template<typename eT>
+struct ScalarOps
+{
+  typedef eT ElemType;
+  typedef eT Vec;
+  static const size_t Width = 1;
+
+  static Vec Zero() { return 0; }
+  static Vec Load(const eT* p) { return *p; }
+  static Vec Add(const Vec a, const Vec b) { return a + b; }
+  static Vec Sub(const Vec a, const Vec b) { return a - b; }
+  static Vec Mul(const Vec a, const Vec b) { return a * b; }
+  static Vec Max(const Vec a, const Vec b) { return (a > b) ? a : b; }
+  static Vec Abs(const Vec a) { return (a < 0) ? -a : a; }
+  static eT Sum(const Vec a) { return a; }
+  static eT MaxElement(const Vec a) { return a; }
+};
+
+//! Set the scalar kernels for the given element type.
+template<typename eT>
+void ScalarKernels(KernelSet<eT>& kernels)
+{
+  kernels.l1 = &Kernel<1, ScalarOps<eT>>;
+  kernels.squaredL2 = &Kernel<2, ScalarOps<eT>>;
+  kernels.lInf = &Kernel<INT_MAX, ScalarOps<eT>>;
+}
+
+//! The kernels chosen for the CPU.
+struct ChosenKernels
+{
+  ChosenKernels() : instructionSet("scalar")
+  {
+    ScalarKernels(floatKernels);
+    ScalarKernels(doubleKernels);
+
+    // Only the instruction sets that the compiler could build kernels for are
+    // checked (see src/mlpack/CMakeLists.txt).
+#if defined(MLPACK_LMETRIC_AVX2) || defined(MLPACK_LMETRIC_AVX512F)
+    __builtin_cpu_init();
+#endif
+
+#ifdef MLPACK_LMETRIC_AVX512F
+    if (__builtin_cpu_supports("avx512f"))
+    {
+      AVX512Kernels(floatKernels, doubleKernels);
+      instructionSet = "avx512f";
+      return;
+    }
+#endif
+
+#ifdef MLPACK_LMETRIC_AVX2
+    if (__builtin_cpu_supports("avx2"))
+    {
+      AVX2Kernels(floatKernels, doubleKernels);
+      instructionSet = "avx2";
+    }
+#endif
+  }
+
+  KernelSet<float> floatKernels;
+  KernelSet<double> doubleKernels;
+  std::string instructionSet;
+};
+
+//! Get the chosen kernels; they are chosen the first time this is called.
+const ChosenKernels& Chosen()
+{
+  static const ChosenKernels chosen;
+  return chosen;
+}
+
+} // anonymous namespace
+
+namespace mlpack {
+namespace metric {
+namespace simd {
+
+template<>
+const KernelSet<float>& GetKernels<float>()
+{
+  return Chosen().floatKernels;
+}
+
+template<>
+const KernelSet<double>& GetKernels<double>()
+{
+  return Chosen().doubleKernels;
+}
+
+std::string InstructionSet()
+{
+  return Chosen().instructionSet;
+}
+
+}; // namespace simd
+}; // namespace metric
+}; // namespace mlpack
@@ -0,0 +1,136 @@
+/**
+ * @file lmetric_simd.hpp
+ * @author Ryan Curtin
+ *
+ * Vectorized L1, squared L2, and L-infinity distances between contiguous float
+ * or double vectors, which LMetric uses when it can.  The kernels are compiled
+ * for AVX2 and AVX-512 (if the compiler supports them), and the first time a
+ * kernel is needed the best one the CPU supports is chosen; otherwise, a scalar
+ * kernel is used.
+ *
+ * Each distance takes an upper bound.  Once the partial distance is known to be
+ * greater than the bound, the computation may stop, and the partial distance
+ * (which is greater than the bound, but less than the full distance) is
+ * returned.  With the default bound, the full distance is always returned.
+ */
+#ifndef __MLPACK_CORE_METRICS_LMETRIC_SIMD_HPP
+#define __MLPACK_CORE_METRICS_LMETRIC_SIMD_HPP
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <string>
+
+#include "lmetric_simd_kernels.hpp"
+
+namespace mlpack {
+namespace metric {
+namespace simd {
+
+//! Vectors shorter than this are handled inline, since a kernel call would
+//! cost more than it saves.
+const size_t MinKernelLength = 16;
+
+//! Get the kernels for the given element type (float or double); they are
+//! chosen the first time this is called.
+template<typename eT>
+const KernelSet<eT>& GetKernels();
+
+template<>
+const KernelSet<float>& GetKernels<float>();
+
+template<>
+const KernelSet<double>& GetKernels<double>();
+
+/**
+ * Get the name of the instruction set of the chosen kernels: "avx512f",
+ * "avx2", or "scalar".
+ */
+std::string InstructionSet();
+
+//! Convert a bound on a distance to the element type, without making it
+//! smaller.
+template<typename eT>
+inline eT ConvertBound(const double bound)
+{
+  if (bound >= (double) std::numeric_limits<eT>::max())
+    return std::numeric_limits<eT>::infinity();
+
+  eT converted = (eT) bound;
+  if ((double) converted < bound)
+    converted = std::nextafter(converted, std::numeric_limits<eT>::infinity());
+  return converted;
+}
+
+/**
+ * Compute the L1 (Manhattan) distance between a and b, each of length n.  If
+ * the distance is greater than the bound, a smaller value that is still greater
+ * than the bound may be returned.
+ */
+template<typename eT>
+inline double L1(const eT* a,
+                 const eT* b,
+                 const size_t n,
+                 const double bound = DBL_MAX)
+{
+  if (n < MinKernelLength)
+  {
+    eT sum = 0;
+    for (size_t i = 0; i < n; ++i)
+      sum += std::abs(a[i] - b[i]);
+    return sum;
+  }
+
+  return GetKernels<eT>().l1(a, b, n, ConvertBound<eT>(bound));
+}
+
+/**
+ * Compute the squared L2 (Euclidean) distance between a and b, each of length
+ * n.  If the distance is greater than the bound, a smaller value that is still
+ * greater than the bound may be returned.
+ */
+template<typename eT>
+inline double SquaredL2(const eT* a,
+                        const eT* b,
+                        const size_t n,
+                        const double bound = DBL_MAX)
+{
+  if (n < MinKernelLength)
+  {
+    eT sum = 0;
+    for (size_t i = 0; i < n; ++i)
+      sum += (a[i] - b[i]) * (a[i] - b[i]);
+    return sum;
+  }
+
+  return GetKernels<eT>().squaredL2(a, b, n, ConvertBound<eT>(bound));
+}
+
+/**
+ * Compute the L-infinity (Chebyshev) distance between a and b, each of length
+ * n.  If the distance is greater than the bound, a smaller value that is still
+ * greater than the bound may be returned.
+ */
+template<typename eT>
+inline double LInf(const eT* a,
+                   const eT* b,
+                   const size_t n,
+                   const double bound = DBL_MAX)
+{
+  if (n < MinKernelLength)
+  {
+    eT max = 0;
+    for (size_t i = 0; i < n; ++i)
+      max = std::max(max, (eT) std::abs(a[i] - b[i]));
+    return max;
+  }
+
+  return GetKernels<eT>().lInf(a, b, n, ConvertBound<eT>(bound));
+}
+
+}; // namespace simd
+}; // namespace metric
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * @file lmetric_simd_avx2.cpp
+ * @author Ryan Curtin
+ *
+ * The AVX2 LMetric kernels.  This file is compiled with -mavx2 (if the compiler
+ * supports it); it is empty otherwise.  See lmetric_simd_kernels.hpp for what
+ * may be included here.
+ */
+#ifdef __AVX2__
+
+#include <immintrin.h>
+
+#include "lmetric_simd_kernels.hpp"
+
+using namespace mlpack::metric::simd;
+
+namespace {
+
+//! AVX2 operations on four doubles.
+struct AVX2DoubleOps
+{
+  typedef double ElemType;
+  typedef __m256d Vec;
+  static const size_t Width = 4;
+
+  static Vec Zero() { return _mm256_setzero_pd(); }
+  static Vec Load(const double* p) { return _mm256_loadu_pd(p); }
+  static Vec Add(const Vec a, const Vec b) { return _mm256_add_pd(a, b); }
+  static Vec Sub(const Vec a, const Vec b) { return _mm256_sub_pd(a, b); }
+  static Vec Mul(const Vec a, const Vec b) { return _mm256_mul_pd(a, b); }
+  static Vec Max(const Vec a, const Vec b) { return _mm256_max_pd(a, b); }
+  static Vec Abs(const Vec a)
+  { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+
+  static double Sum(const Vec a)
+  {
+    __m128d s = _mm_add_pd(_mm256_castpd256_pd128(a),
+                           _mm256_extractf128_pd(a, 1));
+    s = _mm_add_sd(s, _mm_unpackhi_pd(s, s));
+    return _mm_cvtsd_f64(s);
+  }
+
+  static double MaxElement(const Vec a)
+  {
+    __m128d m = _mm_max_pd(_mm256_castpd256_pd128(a),
+                           _mm256_extractf128_pd(a, 1));
+    m = _mm_max_sd(m, _mm_unpackhi_pd(m, m));
+    return _mm_cvtsd_f64(m);
+  }
+};
+
+//! AVX2 operations on eight floats.
+struct AVX2FloatOps
+{
+  typedef float ElemType;
+  typedef __m256 Vec;
+  static const size_t Width = 8;
+
+  static Vec Zero() { return _mm256_setzero_ps(); }
+  static Vec Load(const float* p) { return _mm256_loadu_ps(p); }
+  static Vec Add(const Vec a, const Vec b) { return _mm256_add_ps(a, b); }
+  static Vec Sub(const Vec a, const Vec b) { return _mm256_sub_ps(a, b); }
+  static Vec Mul(const Vec a, const Vec b) { return _mm256_mul_ps(a, b); }
+  static Vec Max(const Vec a, const Vec b) { return _mm256_max_ps(a, b); }
+  static Vec Abs(const Vec a)
+  { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+
+  static float Sum(const Vec a)
+  {
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(a),
+                          _mm256_extractf128_ps(a, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+  }
+
+  static float MaxElement(const Vec a)
+  {
+    __m128 m = _mm_max_ps(_mm256_castps256_ps128(a),
+                          _mm256_extractf128_ps(a, 1));
+    m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+    m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+    return _mm_cvtss_f32(m);
+  }
+};
+
+} // anonymous namespace
+
+void mlpack::metric::simd::AVX2Kernels(KernelSet<float>& floatKernels,
+                                       KernelSet<double>& doubleKernels)
+{
+  floatKernels.l1 = &Kernel<1, AVX2FloatOps>;
+  floatKernels.squaredL2 = &Kernel<2, AVX2FloatOps>;
+  floatKernels.lInf = &Kernel<INT_MAX, AVX2FloatOps>;
+
+  doubleKernels.l1 = &Kernel<1, AVX2DoubleOps>;
+  doubleKernels.squaredL2 = &Kernel<2, AVX2DoubleOps>;
+  doubleKernels.lInf = &Kernel<INT_MAX, AVX2DoubleOps>;
+}
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * @file lmetric_simd_avx512.cpp
+ * @author Ryan Curtin
+ *
+ * The AVX-512 LMetric kernels.  This file is compiled with -mavx512f (if the
+ * compiler supports it); it is empty otherwise.  Only AVX-512F instructions are
+ * used.  See lmetric_simd_kernels.hpp for what may be included here.
+ */
+#ifdef __AVX512F__
+
+#include <immintrin.h>
+
+#include "lmetric_simd_kernels.hpp"
+
+using namespace mlpack::metric::simd;
+
+namespace {
+
+//! Sum the four doubles of an AVX vector.
+inline double Sum256(const __m256d a)
+{
+  __m128d s = _mm_add_pd(_mm256_castpd256_pd128(a),
+                         _mm256_extractf128_pd(a, 1));
+  s = _mm_add_sd(s, _mm_unpackhi_pd(s, s));
+  return _mm_cvtsd_f64(s);
+}
+
+//! Find the largest of the four doubles of an AVX vector.
+inline double Max256(const __m256d a)
+{
+  __m128d m = _mm_max_pd(_mm256_castpd256_pd128(a),
+                         _mm256_extractf128_pd(a, 1));
+  m = _mm_max_sd(m, _mm_unpackhi_pd(m, m));
+  return _mm_cvtsd_f64(m);
+}
+
+//! Sum the eight floats of an AVX vector.
+inline float Sum256(const __m256 a)
+{
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(a),
+                        _mm256_extractf128_ps(a, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+  return _mm_cvtss_f32(s);
+}
+
+//! Find the largest of the eight floats of an AVX vector.
+inline float Max256(const __m256 a)
+{
+  __m128 m = _mm_max_ps(_mm256_castps256_ps128(a),
+                        _mm256_extractf128_ps(a, 1));
+  m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+  m = _mm_max_ss(m, _mm_shuffle_ps(m, m, 1));
+  return _mm_cvtss_f32(m);
+}
+
+//! Get the upper half of an AVX-512 vector of floats (without AVX-512DQ).
+inline __m256 UpperHalf(const __m512 a)
+{
+  return _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a), 1));
+}
+
+//! AVX-512 operations on eight doubles.
+struct AVX512DoubleOps
+{
+  typedef double ElemType;
+  typedef __m512d Vec;
+  static const size_t Width = 8;
+
+  static Vec Zero() { return _mm512_setzero_pd(); }
+  static Vec Load(const double* p) { return _mm512_loadu_pd(p); }
+  static Vec Add(const Vec a, const Vec b) { return _mm512_add_pd(a, b); }
+  static Vec Sub(const Vec a, const Vec b) { return _mm512_sub_pd(a, b); }
+  static Vec Mul(const Vec a, const Vec b) { return _mm512_mul_pd(a, b); }
+  static Vec Max(const Vec a, const Vec b) { return _mm512_max_pd(a, b); }
+  static Vec Abs(const Vec a)
+  {
+    return _mm512_castsi512_pd(_mm512_and_si512(_mm512_castpd_si512(a),
+        _mm512_set1_epi64(0x7FFFFFFFFFFFFFFFLL)));
+  }
+
+  static double Sum(const Vec a)
+  {
+    return Sum256(_mm256_add_pd(_mm512_castpd512_pd256(a),
+                                _mm512_extractf64x4_pd(a, 1)));
+  }
+
+  static double MaxElement(const Vec a)
+  {
+    return Max256(_mm256_max_pd(_mm512_castpd512_pd256(a),
+                                _mm512_extractf64x4_pd(a, 1)));
+  }
+};
+
+//! AVX-512 operations on sixteen floats.
+struct AVX512FloatOps
+{
+  typedef float ElemType;
+  typedef __m512 Vec;
+  static const size_t Width = 16;
+
+  static Vec Zero() { return _mm512_setzero_ps(); }
+  static Vec Load(const float* p) { return _mm512_loadu_ps(p); }
+  static Vec Add(const Vec a, const Vec b) { return _mm512_add_ps(a, b); }
+  static Vec Sub(const Vec a, const Vec b) { return _mm512_sub_ps(a, b); }
+  static Vec Mul(const Vec a, const Vec b) { return _mm512_mul_ps(a, b); }
+  static Vec Max(const Vec a, const Vec b) { return _mm512_max_ps(a, b); }
+  static Vec Abs(const Vec a)
+  {
+    return _mm512_castsi512_ps(_mm512_and_si512(_mm512_castps_si512(a),
+        _mm512_set1_epi32(0x7FFFFFFF)));
+  }
+
+  static float Sum(const Vec a)
+  {
+    return Sum256(_mm256_add_ps(_mm512_castps512_ps256(a), UpperHalf(a)));
+  }
+
+  static float MaxElement(const Vec a)
+  {
+    return Max256(_mm256_max_ps(_mm512_castps512_ps256(a), UpperHalf(a)));
+  }
+};
+
+} // anonymous namespace
+
+void mlpack::metric::simd::AVX512Kernels(KernelSet<float>& floatKernels,
+                                         KernelSet<double>& doubleKernels)
+{
+  floatKernels.l1 = &Kernel<1, AVX512FloatOps>;
+  floatKernels.squaredL2 = &Kernel<2, AVX512FloatOps>;
+  floatKernels.lInf = &Kernel<INT_MAX, AVX512FloatOps>;
+
+  doubleKernels.l1 = &Kernel<1, AVX512DoubleOps>;
+  doubleKernels.squaredL2 = &Kernel<2, AVX512DoubleOps>;
+  doubleKernels.lInf = &Kernel<INT_MAX, AVX512DoubleOps>;
+}
+
+#endif
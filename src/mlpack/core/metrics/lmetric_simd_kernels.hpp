@@ -0,0 +1,159 @@
+/**
+ * @file lmetric_simd_kernels.hpp
+ * @author Ryan Curtin
+ *
+ * The vectorized L1, squared L2, and L-infinity kernels, written once for any
+ * set of vector operations.  Each instruction set has its own file that defines
+ * its vector operations and is compiled with its own flags; see
+ * lmetric_simd.hpp for the kernels that are chosen at runtime.
+ *
+ * This file must not include anything that defines inline functions (such as
+ * Armadillo or the standard library algorithms): any of those that are
+ * compiled in an AVX2 or AVX-512 file could be linked into code that runs on
+ * CPUs without those instructions.
+ */
+#ifndef __MLPACK_CORE_METRICS_LMETRIC_SIMD_KERNELS_HPP
+#define __MLPACK_CORE_METRICS_LMETRIC_SIMD_KERNELS_HPP
+
+#include <climits>
+#include <cstddef>
+
+namespace mlpack {
+namespace metric {
+namespace simd {
+
+/**
+ * The L1, squared L2, and L-infinity kernels for one element type.  Each
+ * kernel takes the two vectors, their length, and an upper bound; once the
+ * partial distance is greater than the bound, the kernel may stop and return
+ * the partial distance.
+ */
+template<typename eT>
+struct KernelSet
+{
+  //! The type of a kernel.
+  typedef eT (*Kernel)(const eT* a,
+                       const eT* b,
+                       const size_t n,
+                       const eT bound);
+
+  //! The L1 (Manhattan) distance.
+  Kernel l1;
+  //! The squared L2 (Euclidean) distance.
+  Kernel squaredL2;
+  //! The L-infinity (Chebyshev) distance.
+  Kernel lInf;
+};
+
+//! Set the AVX2 kernels (defined in lmetric_simd_avx2.cpp).
+void AVX2Kernels(KernelSet<float>& floatKernels,
+                 KernelSet<double>& doubleKernels);
+
+//! Set the AVX-512 kernels (defined in lmetric_simd_avx512.cpp).
+void AVX512Kernels(KernelSet<float>& floatKernels,
+                   KernelSet<double>& doubleKernels);
+
+//! The number of steps of the kernel loop between checks of the bound.
+const size_t BlockSteps = 8;
+
+//! Accumulate the difference between two vectors into the given accumulator,
+//! for the metric with the given power.
+template<int Power, typename Ops>
+inline typename Ops::Vec Accumulate(const typename Ops::Vec& accumulator,
+                                    const typename Ops::Vec& difference)
+{
+  if (Power == 1)
+    return Ops::Add(accumulator, Ops::Abs(difference));
+  else if (Power == 2)
+    return Ops::Add(accumulator, Ops::Mul(difference, difference));
+  else
+    return Ops::Max(accumulator, Ops::Abs(difference));
+}
+
+//! Reduce the two accumulators of a kernel to the (partial) distance.
+template<int Power, typename Ops>
+inline typename Ops::ElemType Reduce(const typename Ops::Vec& accumulator0,
+                                     const typename Ops::Vec& accumulator1)
+{
+  if (Power == INT_MAX)
+    return Ops::MaxElement(Ops::Max(accumulator0, accumulator1));
+  else
+    return Ops::Sum(Ops::Add(accumulator0, accumulator1));
+}
+
+/**
+ * The kernel for the L1 (Power = 1), squared L2 (Power = 2), or L-infinity
+ * (Power = INT_MAX) distance, with the given vector operations.  Ops must
+ * define its element type (ElemType), its vector type (Vec), the number of
+ * elements in a vector (Width), and these static functions:
+ *
+ *  - Vec Zero(), Vec Load(const ElemType*)
+ *  - Vec Add(Vec, Vec), Vec Sub(Vec, Vec), Vec Mul(Vec, Vec), Vec Max(Vec, Vec)
+ *  - Vec Abs(Vec), ElemType Sum(Vec), ElemType MaxElement(Vec)
+ *
+ * Ops should be declared in an anonymous namespace, so that each instantiation
+ * of the kernel is local to the file of its instruction set.
+ *
+ * The bound is checked every BlockSteps steps; a partial distance that is
+ * greater than the bound is returned as soon as it is found.  Otherwise the
+ * distance is accumulated in the same order as if there were no bound, so the
+ * bound does not change the result.
+ */
+template<int Power, typename Ops>
+typename Ops::ElemType Kernel(const typename Ops::ElemType* a,
+                              const typename Ops::ElemType* b,
+                              const size_t n,
+                              const typename Ops::ElemType bound)
+{
+  typedef typename Ops::ElemType eT;
+  typedef typename Ops::Vec Vec;
+
+  // Two accumulators hide the latency of the additions.
+  const size_t step = 2 * Ops::Width;
+  const size_t vectorEnd = n - (n % step);
+  Vec accumulator0 = Ops::Zero();
+  Vec accumulator1 = Ops::Zero();
+
+  size_t i = 0;
+  while (i < vectorEnd)
+  {
+    const size_t blockEnd = (vectorEnd - i > BlockSteps * step) ?
+        i + BlockSteps * step : vectorEnd;
+    for (; i < blockEnd; i += step)
+    {
+      accumulator0 = Accumulate<Power, Ops>(accumulator0,
+          Ops::Sub(Ops::Load(a + i), Ops::Load(b + i)));
+      accumulator1 = Accumulate<Power, Ops>(accumulator1,
+          Ops::Sub(Ops::Load(a + i + Ops::Width),
+                   Ops::Load(b + i + Ops::Width)));
+    }
+
+    if (i < vectorEnd)
+    {
+      const eT partial = Reduce<Power, Ops>(accumulator0, accumulator1);
+      if (partial > bound)
+        return partial;
+    }
+  }
+
+  eT result = Reduce<Power, Ops>(accumulator0, accumulator1);
+  for (; i < n; ++i)
+  {
+    const eT difference = a[i] - b[i];
+    const eT absDifference = (difference < 0) ? -difference : difference;
+    if (Power == 1)
+      result += absDifference;
+    else if (Power == 2)
+      result += difference * difference;
+    else if (absDifference > result)
+      result = absDifference;
+  }
+
+  return result;
+}
+
+}; // namespace simd
+}; // namespace metric
+}; // namespace mlpack
+
+#endif
@@ -27,8 +27,10 @@ namespace metric {
  *
  * Because each evaluation multiplies (x_1 - x_2) by the covariance matrix, it
  * may be much quicker to use an LMetric and simply stretch the actual dataset
- * itself before performing any evaluations.  However, this class is provided
- * for convenience.
+ * itself before performing any evaluations.  Transformation() gives the matrix
+ * to stretch the dataset with, and the MahalanobisNeighborSearch and
+ * MahalanobisRangeSearch classes do this, so that kd-trees can be used.
+ * However, this class is provided for convenience.
  *
  * Similar to the LMetric class, this offers a template parameter TakeRoot
  * which, when set to false, will instead evaluate the distance
@@ -97,6 +99,21 @@ class MahalanobisDistance
    */
   arma::mat& Covariance() { return covariance; }
 
+  /**
+   * Get a matrix W such that the distance between x and y is the Euclidean
+   * distance between W x and W y (or its square, if TakeRoot is false).  This
+   * is the upper triangular Cholesky factor R of the covariance matrix (with
+   * Q = R^T R), so transforming a dataset by W costs O(d^2) per point, once,
+   * and the transformed points can be used with any tree and the Euclidean
+   * distance.  A singular covariance matrix has no Cholesky factor, so in that
+   * case W = D^{1/2} V^T is given, where Q = V D V^T is the eigendecomposition
+   * of Q.  Only the symmetric part of Q is used, as in Evaluate().
+   *
+   * A std::invalid_argument is thrown if the covariance matrix is empty or
+   * not positive semidefinite.
+   */
+  arma::mat Transformation() const;
+
   //! Serialize the Mahalanobis distance.
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int version);
@@ -42,6 +42,51 @@ double MahalanobisDistance<true>::Evaluate(const VecTypeA& a,
   return sqrt(out[0]);
 }
 
+// Compute the matrix to transform points by.
+template<bool TakeRoot>
+arma::mat MahalanobisDistance<TakeRoot>::Transformation() const
+{
+  if (covariance.n_elem == 0)
+    throw std::invalid_argument("MahalanobisDistance::Transformation(): "
+        "covariance matrix has not been set");
+
+  // (x - y)^T Q (x - y) only depends on the symmetric part of Q.
+  const arma::mat symmetric = 0.5 * (covariance + trans(covariance));
+
+  // If Q = R^T R, then (x - y)^T Q (x - y) = || R x - R y ||^2.
+  arma::mat r;
+  if (arma::chol(r, symmetric))
+    return r;
+
+  // Q may still be positive semidefinite (just not positive definite).  If
+  // Q = V D V^T, we can take D^{1/2} V^T instead; eigenvalues that are
+  // negative only because of roundoff are taken to be 0.
+  arma::vec eigenvalues;
+  arma::mat eigenvectors;
+  if (!arma::eig_sym(eigenvalues, eigenvectors, symmetric))
+    throw std::invalid_argument("MahalanobisDistance::Transformation(): "
+        "eigendecomposition of covariance matrix failed");
+
+  const double tolerance = 1e-10 * arma::max(arma::abs(eigenvalues));
+  for (size_t i = 0; i < eigenvalues.n_elem; ++i)
+  {
+    if (eigenvalues[i] < -tolerance)
+    {
+      std::ostringstream oss;
+      oss << "MahalanobisDistance::Transformation(): covariance matrix is not "
+          << "positive semidefinite (it has eigenvalue " << eigenvalues[i]
+          << ")";
+      throw std::invalid_argument(oss.str());
+    }
+    else if (eigenvalues[i] < 0.0)
+    {
+      eigenvalues[i] = 0.0;
+    }
+  }
+
+  return arma::diagmat(arma::sqrt(eigenvalues)) * trans(eigenvectors);
+}
+
 // Serialize the Mahalanobis distance.
 template<bool TakeRoot>
 template<typename Archive>
@@ -38,6 +38,15 @@ namespace optimization {
  * the given coordinates.  Evaluate() should provide the objective function
  * value for the given coordinates.
  *
+ * The LagrangianFunction may also implement
+ *
+ * - double EvaluateWithGradient(const arma::mat& coordinates,
+ *        arma::mat& gradient);
+ *
+ * which computes the objective and the gradient at once (see
+ * HasEvaluateWithGradient).  Each L-BFGS step on the Augmented Lagrangian then
+ * uses it instead of separate calls to Evaluate() and Gradient().
+ *
  * @tparam LagrangianFunction Function which can be optimized by this class.
  */
 template<typename LagrangianFunction>
@@ -8,6 +8,7 @@
 #define __MLPACK_CORE_OPTIMIZERS_AUG_LAGRANGIAN_AUG_LAGRANGIAN_FUNCTION_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/function/evaluate_with_gradient.hpp>
 
 namespace mlpack {
 namespace optimization {
@@ -71,6 +72,19 @@ class AugLagrangianFunction
    */
   void Gradient(const arma::mat& coordinates, arma::mat& gradient) const;
 
+  /**
+   * Evaluate the objective function and the gradient of the Augmented
+   * Lagrangian function at once.  Each constraint is evaluated only once, and
+   * the LagrangianFunction's own EvaluateWithGradient() is used if it has one
+   * (see HasEvaluateWithGradient).
+   *
+   * @param coordinates Coordinates to evaluate function and gradient at.
+   * @param gradient Matrix to store gradient into.
+   * @return Objective function.
+   */
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              arma::mat& gradient) const;
+
   /**
    * Get the initial point of the optimization (supplied by the
    * LagrangianFunction).
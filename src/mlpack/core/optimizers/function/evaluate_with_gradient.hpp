@@ -0,0 +1,164 @@
+/**
+ * @file evaluate_with_gradient.hpp
+ * @author Ryan Curtin
+ *
+ * EvaluateWithGradient(), which computes the objective and the gradient of a
+ * function at the same point.  Many functions share most of the work between
+ * Evaluate() and Gradient() (for instance the product of the parameters and
+ * the dataset); these can provide their own EvaluateWithGradient(), which does
+ * that work only once.  For every other function, Evaluate() and Gradient()
+ * are called one after the other.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_FUNCTION_EVALUATE_WITH_GRADIENT_HPP
+#define __MLPACK_CORE_OPTIMIZERS_FUNCTION_EVALUATE_WITH_GRADIENT_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+// This gives us a HasEvaluateWithGradientCheck<T, U> type (where U is a
+// function pointer) we can use with SFINAE to catch when a function has an
+// EvaluateWithGradient(...) function of a given signature.
+HAS_MEM_FUNC(EvaluateWithGradient, HasEvaluateWithGradientCheck);
+
+/**
+ * HasEvaluateWithGradient<FunctionType>::value is true if the function
+ * provides a fused evaluation of its objective and gradient, which has the
+ * signature
+ *
+ * @code
+ * double EvaluateWithGradient(const arma::mat& coordinates,
+ *                             arma::mat& gradient);
+ * @endcode
+ *
+ * (it may also be const), stores the gradient in gradient, and returns the
+ * objective.
+ */
+template<typename FunctionType>
+struct HasEvaluateWithGradient
+{
+  static const bool value =
+      HasEvaluateWithGradientCheck<FunctionType,
+          double(FunctionType::*)(const arma::mat&, arma::mat&)>::value ||
+      HasEvaluateWithGradientCheck<FunctionType,
+          double(FunctionType::*)(const arma::mat&, arma::mat&) const>::value;
+};
+
+/**
+ * HasSeparableEvaluateWithGradient<FunctionType>::value is true if the
+ * function provides a fused evaluation of the objective and gradient of its
+ * separable functions, which has the signature
+ *
+ * @code
+ * double EvaluateWithGradient(const arma::mat& coordinates,
+ *                             const size_t i,
+ *                             arma::mat& gradient);
+ * @endcode
+ *
+ * (it may also be const), stores the gradient of the i'th separable function in
+ * gradient, and returns its objective.
+ */
+template<typename FunctionType>
+struct HasSeparableEvaluateWithGradient
+{
+  static const bool value =
+      HasEvaluateWithGradientCheck<FunctionType,
+          double(FunctionType::*)(const arma::mat&, const size_t,
+          arma::mat&)>::value ||
+      HasEvaluateWithGradientCheck<FunctionType,
+          double(FunctionType::*)(const arma::mat&, const size_t,
+          arma::mat&) const>::value;
+};
+
+/**
+ * Compute the objective and the gradient of the function at the given
+ * coordinates, with the fused evaluation of the function.
+ *
+ * @param function Function to evaluate.
+ * @param coordinates Point to evaluate at.
+ * @param gradient Matrix to store the gradient in.
+ * @return Objective at the given coordinates.
+ */
+template<typename FunctionType>
+typename std::enable_if<HasEvaluateWithGradient<FunctionType>::value,
+    double>::type
+EvaluateWithGradient(FunctionType& function,
+                     const arma::mat& coordinates,
+                     arma::mat& gradient)
+{
+  return function.EvaluateWithGradient(coordinates, gradient);
+}
+
+/**
+ * Compute the objective and the gradient of the function at the given
+ * coordinates, with separate calls to Evaluate() and Gradient() (for functions
+ * without a fused evaluation).
+ *
+ * @param function Function to evaluate.
+ * @param coordinates Point to evaluate at.
+ * @param gradient Matrix to store the gradient in.
+ * @return Objective at the given coordinates.
+ */
+template<typename FunctionType>
+typename std::enable_if<!HasEvaluateWithGradient<FunctionType>::value,
+    double>::type
+EvaluateWithGradient(FunctionType& function,
+                     const arma::mat& coordinates,
+                     arma::mat& gradient)
+{
+  const double objective = function.Evaluate(coordinates);
+  function.Gradient(coordinates, gradient);
+  return objective;
+}
+
+/**
+ * Compute the objective and the gradient of the i'th separable function at the
+ * given coordinates, with the fused evaluation of the function.
+ *
+ * @param function Function to evaluate.
+ * @param coordinates Point to evaluate at.
+ * @param i Index of the separable function.
+ * @param gradient Matrix to store the gradient in.
+ * @return Objective of the separable function at the given coordinates.
+ */
+template<typename FunctionType>
+typename std::enable_if<HasSeparableEvaluateWithGradient<FunctionType>::value,
+    double>::type
+EvaluateWithGradient(FunctionType& function,
+                     const arma::mat& coordinates,
+                     const size_t i,
+                     arma::mat& gradient)
+{
+  return function.EvaluateWithGradient(coordinates, i, gradient);
+}
+
+/**
+ * Compute the objective and the gradient of the i'th separable function at the
+ * given coordinates, with separate calls to Evaluate() and Gradient() (for
+ * functions without a fused evaluation).
+ *
+ * @param function Function to evaluate.
+ * @param coordinates Point to evaluate at.
+ * @param i Index of the separable function.
+ * @param gradient Matrix to store the gradient in.
+ * @return Objective of the separable function at the given coordinates.
+ */
+template<typename FunctionType>
+typename std::enable_if<!HasSeparableEvaluateWithGradient<FunctionType>::value,
+    double>::type
+EvaluateWithGradient(FunctionType& function,
+                     const arma::mat& coordinates,
+                     const size_t i,
+                     arma::mat& gradient)
+{
+  const double objective = function.Evaluate(coordinates, i);
+  function.Gradient(coordinates, i, gradient);
+  return objective;
+}
+
+} // namespace optimization
+} // namespace mlpack
+
+#endif
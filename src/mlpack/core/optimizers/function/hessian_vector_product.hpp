@@ -0,0 +1,113 @@
+/**
+ * @file hessian_vector_product.hpp
+ * @author Ryan Curtin
+ *
+ * HessianVectorProduct(), which computes the product of the Hessian of a
+ * function at a point and a direction.  Second-order optimizers like TRON only
+ * need the Hessian through such products, so functions can provide their own
+ * HessianVectorProduct(), which costs about as much as a gradient and never
+ * forms the Hessian.  For every other function, the product is approximated
+ * with a finite difference of two gradients.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_FUNCTION_HESSIAN_VECTOR_PRODUCT_HPP
+#define __MLPACK_CORE_OPTIMIZERS_FUNCTION_HESSIAN_VECTOR_PRODUCT_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+// This gives us a HasHessianVectorProductCheck<T, U> type (where U is a
+// function pointer) we can use with SFINAE to catch when a function has a
+// HessianVectorProduct(...) function of a given signature.
+HAS_MEM_FUNC(HessianVectorProduct, HasHessianVectorProductCheck);
+
+/**
+ * HasHessianVectorProduct<FunctionType>::value is true if the function
+ * provides the exact product of its Hessian and a direction, which has the
+ * signature
+ *
+ * @code
+ * void HessianVectorProduct(const arma::mat& coordinates,
+ *                           const arma::mat& v,
+ *                           arma::mat& hv);
+ * @endcode
+ *
+ * (it may also be const), and stores the product of the Hessian at coordinates
+ * and v (which has the shape of coordinates) in hv.
+ */
+template<typename FunctionType>
+struct HasHessianVectorProduct
+{
+  static const bool value =
+      HasHessianVectorProductCheck<FunctionType,
+          void(FunctionType::*)(const arma::mat&, const arma::mat&,
+          arma::mat&)>::value ||
+      HasHessianVectorProductCheck<FunctionType,
+          void(FunctionType::*)(const arma::mat&, const arma::mat&,
+          arma::mat&) const>::value;
+};
+
+/**
+ * Compute the product of the Hessian of the function at the given coordinates
+ * and the given direction, with the function's own HessianVectorProduct().
+ *
+ * @param function Function to use.
+ * @param coordinates Point the Hessian is taken at.
+ * @param gradient Gradient at coordinates (not used).
+ * @param v Direction to multiply the Hessian by.
+ * @param hv Matrix to store the product in.
+ */
+template<typename FunctionType>
+typename std::enable_if<HasHessianVectorProduct<FunctionType>::value,
+    void>::type
+HessianVectorProduct(FunctionType& function,
+                     const arma::mat& coordinates,
+                     const arma::mat& /* gradient */,
+                     const arma::mat& v,
+                     arma::mat& hv)
+{
+  function.HessianVectorProduct(coordinates, v, hv);
+}
+
+/**
+ * Approximate the product of the Hessian of the function at the given
+ * coordinates and the given direction with the forward difference
+ * (g(x + h v) - g(x)) / h of the gradient g, for functions without an exact
+ * product.  The step h is the square root of the machine epsilon, relative to
+ * the size of x and v.  This costs one gradient evaluation.
+ *
+ * @param function Function to use.
+ * @param coordinates Point the Hessian is taken at.
+ * @param gradient Gradient at coordinates.
+ * @param v Direction to multiply the Hessian by.
+ * @param hv Matrix to store the product in.
+ */
+template<typename FunctionType>
+typename std::enable_if<!HasHessianVectorProduct<FunctionType>::value,
+    void>::type
+HessianVectorProduct(FunctionType& function,
+                     const arma::mat& coordinates,
+                     const arma::mat& gradient,
+                     const arma::mat& v,
+                     arma::mat& hv)
+{
+  const double vNorm = arma::norm(v, "fro");
+  if (vNorm == 0.0)
+  {
+    hv.zeros(v.n_rows, v.n_cols);
+    return;
+  }
+
+  const double h = std::sqrt(std::numeric_limits<double>::epsilon()) *
+      (1.0 + arma::norm(coordinates, "fro")) / vNorm;
+  const arma::mat shifted = coordinates + h * v;
+  function.Gradient(shifted, hv);
+  hv = (hv - gradient) / h;
+}
+
+} // namespace optimization
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * @file separable_function.hpp
+ * @author Ryan Curtin
+ *
+ * A wrapper which computes the full objective and gradient of a separable
+ * function (a sum of NumFunctions() functions, like the ones SGD optimizes) in
+ * parallel, so that it can be optimized with batch optimizers like L-BFGS.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_FUNCTION_SEPARABLE_FUNCTION_HPP
+#define __MLPACK_CORE_OPTIMIZERS_FUNCTION_SEPARABLE_FUNCTION_HPP
+
+#include <mlpack/core.hpp>
+#include "evaluate_with_gradient.hpp"
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * SeparableFunction wraps a function which is a sum of separable functions,
+ *
+ *   f(x) = sum_i f_i(x),
+ *
+ * and provides the objective and gradient of the whole sum.  The separable
+ * functions are split into blocks, and if mlpack is compiled with OpenMP, the
+ * blocks are split across threads.  The objective of each block is summed in
+ * block order, so it does not depend on the number of threads; each thread sums
+ * the gradients of its own blocks into its own buffer, and the buffers are
+ * added up in order.
+ *
+ * The wrapped FunctionType must implement the same interface that SGD requires:
+ *
+ * @code
+ * size_t NumFunctions();
+ * double Evaluate(const arma::mat& coordinates, const size_t i);
+ * void Gradient(const arma::mat& coordinates,
+ *               const size_t i,
+ *               arma::mat& gradient);
+ * const arma::mat& GetInitialPoint();
+ * @endcode
+ *
+ * and the separable Evaluate() and Gradient() must be safe to call from several
+ * threads at once (for instance, because they are const and do not cache
+ * anything).  If the function also provides the separable
+ * EvaluateWithGradient(), it is used by EvaluateWithGradient() here.
+ *
+ * Since the separable overloads are forwarded too, a SeparableFunction can be
+ * given to both L_BFGS and SGD.  For example, to train on a function f with a
+ * multicore L-BFGS:
+ *
+ * @code
+ * SeparableFunction<FunctionType> parallelFunction(f);
+ * L_BFGS<SeparableFunction<FunctionType> > lbfgs(parallelFunction);
+ * arma::mat coordinates = parallelFunction.GetInitialPoint();
+ * lbfgs.Optimize(coordinates);
+ * @endcode
+ *
+ * Functions which compute their full objective in a vectorized way (for
+ * instance with a single matrix product over the whole dataset) may well be
+ * faster on their own; this wrapper helps most when the full objective is a
+ * loop over the points.
+ *
+ * @tparam FunctionType Type of the separable function to wrap.
+ */
+template<typename FunctionType>
+class SeparableFunction
+{
+ public:
+  /**
+   * Wrap the given separable function.  The function is held by reference, so
+   * it must outlive this object.
+   *
+   * @param function Separable function to wrap.
+   * @param blockSize Number of separable functions in each block (each block is
+   *     handled by a single thread).
+   */
+  SeparableFunction(FunctionType& function, const size_t blockSize = 256);
+
+  /**
+   * Evaluate the sum of all the separable functions at the given coordinates.
+   *
+   * @param coordinates Point to evaluate at.
+   */
+  double Evaluate(const arma::mat& coordinates) const;
+
+  /**
+   * Compute the gradient of the sum of all the separable functions at the
+   * given coordinates.
+   *
+   * @param coordinates Point to evaluate at.
+   * @param gradient Matrix to store the gradient in.
+   */
+  void Gradient(const arma::mat& coordinates, arma::mat& gradient) const;
+
+  /**
+   * Compute the objective and the gradient of the sum of all the separable
+   * functions at the given coordinates, in a single pass over the separable
+   * functions.
+   *
+   * @param coordinates Point to evaluate at.
+   * @param gradient Matrix to store the gradient in.
+   * @return Objective at the given coordinates.
+   */
+  double EvaluateWithGradient(const arma::mat& coordinates,
+                              arma::mat& gradient) const;
+
+  //! Return the number of separable functions.
+  size_t NumFunctions() const { return function.NumFunctions(); }
+
+  //! Evaluate the i'th separable function.
+  double Evaluate(const arma::mat& coordinates, const size_t i) const
+  { return function.Evaluate(coordinates, i); }
+
+  //! Compute the gradient of the i'th separable function.
+  void Gradient(const arma::mat& coordinates,
+                const size_t i,
+                arma::mat& gradient) const
+  { function.Gradient(coordinates, i, gradient); }
+
+  //! Return the initial point of the wrapped function.
+  arma::mat GetInitialPoint() const { return function.GetInitialPoint(); }
+
+  //! Get the wrapped function.
+  const FunctionType& Function() const { return function; }
+  //! Modify the wrapped function.
+  FunctionType& Function() { return function; }
+
+  //! Get the number of separable functions in each block.
+  size_t BlockSize() const { return blockSize; }
+  //! Modify the number of separable functions in each block.
+  size_t& BlockSize() { return blockSize; }
+
+ private:
+  /**
+   * Sum the objectives (if evaluate is true) and the gradients (if gradient is
+   * not NULL) of all the separable functions.  This is the shared
+   * implementation of Evaluate(), Gradient(), and EvaluateWithGradient().
+   *
+   * @param coordinates Point to evaluate at.
+   * @param evaluate Whether or not to sum the objectives.
+   * @param gradient Matrix to store the gradient in, or NULL.
+   * @return Objective at the given coordinates (0 if evaluate is false).
+   */
+  double Sum(const arma::mat& coordinates,
+             const bool evaluate,
+             arma::mat* gradient) const;
+
+  //! The wrapped separable function.
+  FunctionType& function;
+  //! The number of separable functions in each block.
+  size_t blockSize;
+};
+
+} // namespace optimization
+} // namespace mlpack
+
+// Include implementation.
+#include "separable_function_impl.hpp"
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * @file separable_function_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the SeparableFunction wrapper, which computes the full
+ * objective and gradient of a separable function in parallel.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_FUNCTION_SEPARABLE_FUNCTION_IMPL_HPP
+#define __MLPACK_CORE_OPTIMIZERS_FUNCTION_SEPARABLE_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "separable_function.hpp"
+
+namespace mlpack {
+namespace optimization {
+
+template<typename FunctionType>
+SeparableFunction<FunctionType>::SeparableFunction(FunctionType& function,
+                                                   const size_t blockSize) :
+    function(function),
+    blockSize(blockSize)
+{
+  if (blockSize == 0)
+    throw std::invalid_argument("SeparableFunction::SeparableFunction(): block "
+        "size must be greater than 0");
+}
+
+template<typename FunctionType>
+double SeparableFunction<FunctionType>::Evaluate(
+    const arma::mat& coordinates) const
+{
+  return Sum(coordinates, true, NULL);
+}
+
+template<typename FunctionType>
+void SeparableFunction<FunctionType>::Gradient(const arma::mat& coordinates,
+                                               arma::mat& gradient) const
+{
+  Sum(coordinates, false, &gradient);
+}
+
+template<typename FunctionType>
+double SeparableFunction<FunctionType>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const
+{
+  return Sum(coordinates, true, &gradient);
+}
+
+template<typename FunctionType>
+double SeparableFunction<FunctionType>::Sum(const arma::mat& coordinates,
+                                            const bool evaluate,
+                                            arma::mat* gradient) const
+{
+  const size_t numFunctions = function.NumFunctions();
+  const size_t numBlocks = (numFunctions + blockSize - 1) / blockSize;
+
+  // Each block has its own objective, and each thread its own gradient.
+  arma::vec blockObjectives(numBlocks);
+  arma::mat sumGradient = parallel::BlockReduce(numFunctions, blockSize,
+      (gradient == NULL) ? arma::mat() :
+          arma::mat(arma::zeros<arma::mat>(coordinates.n_rows,
+          coordinates.n_cols)),
+      [&](arma::mat& threadGradient, const size_t begin, const size_t end)
+      {
+        arma::mat functionGradient;
+        double objective = 0.0;
+        for (size_t i = begin; i < end; ++i)
+        {
+          if (gradient == NULL)
+          {
+            objective += function.Evaluate(coordinates, i);
+            continue;
+          }
+
+          if (evaluate)
+            objective += optimization::EvaluateWithGradient(function,
+                coordinates, i, functionGradient);
+          else
+            function.Gradient(coordinates, i, functionGradient);
+
+          threadGradient += functionGradient;
+        }
+
+        blockObjectives[begin / blockSize] = objective;
+      },
+      [](arma::mat& total, const arma::mat& threadGradient)
+      {
+        total += threadGradient;
+      });
+
+  if (gradient != NULL)
+    *gradient = std::move(sumGradient);
+
+  return accu(blockObjectives);
+}
+
+} // namespace optimization
+} // namespace mlpack
+
+#endif
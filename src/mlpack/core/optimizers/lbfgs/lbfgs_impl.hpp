@@ -65,17 +65,19 @@ L_BFGS<FunctionType>::L_BFGS(FunctionType& function,
 }
 
 /**
- * Evaluate the function at the given iterate point and store the result if
- * it is a new minimum.
+ * Evaluate the function and its gradient at the given iterate point and store
+ * the result if it is a new minimum.
  *
  * @return The value of the function
  */
 template<typename FunctionType>
-double L_BFGS<FunctionType>::Evaluate(const arma::mat& iterate)
+double L_BFGS<FunctionType>::EvaluateWithGradient(const arma::mat& iterate,
+                                                  arma::mat& gradient)
 {
   // Evaluate the function and keep track of the minimum function
   // value encountered during the optimization.
-  double functionValue = function.Evaluate(iterate);
+  double functionValue = optimization::EvaluateWithGradient(function, iterate,
+      gradient);
 
   if (functionValue < minPointIterate.second)
   {
@@ -182,8 +184,7 @@ bool L_BFGS<FunctionType>::LineSearch(double& functionValue,
     // point.
     newIterateTmp = iterate;
     newIterateTmp += stepSize * searchDirection;
-    functionValue = Evaluate(newIterateTmp);
-    function.Gradient(newIterateTmp, gradient);
+    functionValue = EvaluateWithGradient(newIterateTmp, gradient);
     numIterations++;
 
     if (functionValue > initialFunctionValue + stepSize *
@@ -363,10 +364,6 @@ double L_BFGS<FunctionType>::Optimize(arma::mat& iterate,
   // Whether to optimize until convergence.
   bool optimizeUntilConvergence = (maxIterations == 0);
 
-  // The initial function value.
-  double functionValue = Evaluate(iterate);
-  double prevFunctionValue = functionValue;
-
   // The gradient: the current and the old.
   arma::mat gradient;
   arma::mat oldGradient;
@@ -377,15 +374,16 @@ double L_BFGS<FunctionType>::Optimize(arma::mat& iterate,
   arma::mat searchDirection;
   searchDirection.zeros(iterate.n_rows, iterate.n_cols);
 
-  // The initial gradient value.
-  function.Gradient(iterate, gradient);
+  // The initial function value and gradient.
+  double functionValue = EvaluateWithGradient(iterate, gradient);
+  double prevFunctionValue = functionValue;
 
   // The main optimization loop.
   for (size_t itNum = 0; optimizeUntilConvergence || (itNum != maxIterations);
        ++itNum)
   {
-    Log::Debug << "L-BFGS iteration " << itNum << "; objective " <<
-        function.Evaluate(iterate) << ", gradient norm " <<
+    MLPACK_LOG_DEBUG << "L-BFGS iteration " << itNum << "; objective " <<
+        functionValue << ", gradient norm " <<
         arma::norm(gradient, 2) << ", " <<
         ((prevFunctionValue - functionValue) /
          std::max(std::max(fabs(prevFunctionValue), fabs(functionValue)), 1.0)) << "." << std::endl;
@@ -448,7 +446,8 @@ double L_BFGS<FunctionType>::Optimize(arma::mat& iterate,
 
   } // End of the optimization loop.
 
-  return function.Evaluate(iterate);
+  // The line search leaves functionValue at the value of the final iterate.
+  return functionValue;
 }
 
 // Convert the object to a string.
@@ -0,0 +1,197 @@
+/**
+ * @file batch_function.hpp
+ * @author Ryan Curtin
+ *
+ * BatchEvaluate() and BatchGradient(), which evaluate the objective and the
+ * gradient of a decomposable function over a batch of its separable functions.
+ * Functions which can do this faster than one function at a time provide their
+ * own batch Evaluate() and Gradient() overloads; for every other function, the
+ * separable functions are evaluated one at a time.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_MINIBATCH_SGD_BATCH_FUNCTION_HPP
+#define __MLPACK_CORE_OPTIMIZERS_MINIBATCH_SGD_BATCH_FUNCTION_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace optimization {
+
+// These give us HasEvaluateCheck<T, U> and HasGradientCheck<T, U> types (where
+// U is a function pointer) we can use with SFINAE to catch when a function has
+// Evaluate(...) and Gradient(...) functions of a given signature.
+HAS_MEM_FUNC(Evaluate, HasEvaluateCheck);
+HAS_MEM_FUNC(Gradient, HasGradientCheck);
+
+/**
+ * HasBatchGradient<FunctionType>::value is true if the function provides batch
+ * evaluations of its objective and gradient, which have the signatures
+ *
+ * @code
+ * double Evaluate(const arma::mat& coordinates,
+ *                 const size_t begin,
+ *                 const size_t batchSize) const;
+ * void Gradient(const arma::mat& coordinates,
+ *               const size_t begin,
+ *               const size_t batchSize,
+ *               arma::mat& gradient) const;
+ * @endcode
+ *
+ * and return the sum of the objectives and gradients of the separable
+ * functions begin, ..., begin + batchSize - 1.
+ */
+template<typename FunctionType>
+struct HasBatchGradient
+{
+  static const bool value =
+      HasEvaluateCheck<FunctionType, double(FunctionType::*)(const arma::mat&,
+          const size_t, const size_t) const>::value &&
+      HasGradientCheck<FunctionType, void(FunctionType::*)(const arma::mat&,
+          const size_t, const size_t, arma::mat&) const>::value;
+};
+
+/**
+ * HasConstGradient<FunctionType>::value is true if the separable Evaluate()
+ * and Gradient() of the function are const.  The separable functions of such a
+ * function are assumed to be safe to evaluate from several threads at once.
+ */
+template<typename FunctionType>
+struct HasConstGradient
+{
+  static const bool value =
+      HasEvaluateCheck<FunctionType, double(FunctionType::*)(const arma::mat&,
+          const size_t) const>::value &&
+      HasGradientCheck<FunctionType, void(FunctionType::*)(const arma::mat&,
+          const size_t, arma::mat&) const>::value;
+};
+
+//! The number of separable functions in a batch above which a batch is split
+//! across threads (if it is evaluated one separable function at a time).
+static const size_t ParallelBatchThreshold = 256;
+
+/**
+ * Evaluate the sum of the objectives of the separable functions
+ * order[begin], ..., order[begin + batchSize - 1], using the batch evaluation
+ * of the function.  The batch evaluation only works on contiguous separable
+ * functions, so order must hold contiguous indices in this range (the order of
+ * the batches can still be shuffled).
+ */
+template<typename FunctionType>
+typename std::enable_if<HasBatchGradient<FunctionType>::value, double>::type
+BatchEvaluate(FunctionType& function,
+              const arma::mat& coordinates,
+              const arma::Col<size_t>& order,
+              const size_t begin,
+              const size_t batchSize)
+{
+  return function.Evaluate(coordinates, order[begin], batchSize);
+}
+
+/**
+ * Evaluate the sum of the objectives of the separable functions
+ * order[begin], ..., order[begin + batchSize - 1] one at a time.  If the
+ * separable functions are const and there are many of them, they are split
+ * across threads (if mlpack is compiled with OpenMP); the sums of the threads
+ * are added up in order.
+ */
+template<typename FunctionType>
+typename std::enable_if<!HasBatchGradient<FunctionType>::value, double>::type
+BatchEvaluate(FunctionType& function,
+              const arma::mat& coordinates,
+              const arma::Col<size_t>& order,
+              const size_t begin,
+              const size_t batchSize)
+{
+  const bool parallel = HasConstGradient<FunctionType>::value &&
+      (batchSize >= ParallelBatchThreshold);
+
+  double objective = 0.0;
+  #pragma omp parallel for if(parallel) schedule(static) \
+      reduction(+:objective)
+  for (size_t i = begin; i < begin + batchSize; ++i)
+    objective += function.Evaluate(coordinates, order[i]);
+
+  return objective;
+}
+
+/**
+ * Evaluate the sum of the gradients of the separable functions
+ * order[begin], ..., order[begin + batchSize - 1], using the batch gradient of
+ * the function.  As with BatchEvaluate(), order must hold contiguous indices
+ * in this range.
+ */
+template<typename FunctionType>
+typename std::enable_if<HasBatchGradient<FunctionType>::value, void>::type
+BatchGradient(FunctionType& function,
+              const arma::mat& coordinates,
+              const arma::Col<size_t>& order,
+              const size_t begin,
+              const size_t batchSize,
+              arma::mat& gradient,
+              std::vector<arma::mat>& /* workspace */)
+{
+  function.Gradient(coordinates, order[begin], batchSize, gradient);
+}
+
+/**
+ * Evaluate the sum of the gradients of the separable functions
+ * order[begin], ..., order[begin + batchSize - 1] one at a time.  If the
+ * separable functions are const and there are many of them, they are split
+ * across threads (if mlpack is compiled with OpenMP), and the sums of the
+ * threads are added up in order.
+ *
+ * The workspace holds two matrices for each thread: the first half are the
+ * sums of the threads (the first thread sums into gradient directly), and the
+ * second half hold the gradient of one separable function.  Once they have the
+ * right size, no memory is allocated here.
+ */
+template<typename FunctionType>
+typename std::enable_if<!HasBatchGradient<FunctionType>::value, void>::type
+BatchGradient(FunctionType& function,
+              const arma::mat& coordinates,
+              const arma::Col<size_t>& order,
+              const size_t begin,
+              const size_t batchSize,
+              arma::mat& gradient,
+              std::vector<arma::mat>& workspace)
+{
+  const size_t maxThreads = workspace.size() / 2;
+  const bool parallel = HasConstGradient<FunctionType>::value &&
+      (batchSize >= ParallelBatchThreshold) && (maxThreads > 1);
+  const size_t numThreads = parallel ? maxThreads : 1;
+
+  #pragma omp parallel num_threads(numThreads) if(parallel)
+  {
+#ifdef _OPENMP
+    const size_t thread = (size_t) omp_get_thread_num();
+#else
+    const size_t thread = 0;
+#endif
+
+    arma::mat& sum = (thread == 0) ? gradient : workspace[thread];
+    arma::mat& pointGradient = workspace[maxThreads + thread];
+    sum.zeros(coordinates.n_rows, coordinates.n_cols);
+
+    // The static schedule gives each thread the same part of every batch, so
+    // the result is the same for a fixed number of threads.
+    #pragma omp for schedule(static)
+    for (size_t i = begin; i < begin + batchSize; ++i)
+    {
+      function.Gradient(coordinates, order[i], pointGradient);
+      sum += pointGradient;
+    }
+  }
+
+  // Add up the sums of each thread, in order.
+  for (size_t t = 1; t < numThreads; ++t)
+    gradient += workspace[t];
+}
+
+} // namespace optimization
+} // namespace mlpack
+
+#endif
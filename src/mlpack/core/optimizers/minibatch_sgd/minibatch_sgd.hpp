@@ -0,0 +1,174 @@
+/**
+ * @file minibatch_sgd.hpp
+ * @author Ryan Curtin
+ *
+ * Mini-batch stochastic gradient descent (mini-batch SGD), with optional
+ * momentum.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_MINIBATCH_SGD_MINIBATCH_SGD_HPP
+#define __MLPACK_CORE_OPTIMIZERS_MINIBATCH_SGD_MINIBATCH_SGD_HPP
+
+#include <mlpack/core.hpp>
+#include "batch_function.hpp"
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * Mini-batch stochastic gradient descent is a variant of stochastic gradient
+ * descent (see SGD) which, instead of the gradient of one separable function,
+ * uses the average gradient of a batch of them at each step:
+ *
+ * \f[
+ * A_{j + 1} = A_j - \alpha \frac{1}{b} \sum_{i \in B_j} \nabla f_i(A_j)
+ * \f]
+ *
+ * where \f$ B_j \f$ is the j'th batch, of \f$ b \f$ functions.  With momentum
+ * \f$ \mu \f$, a velocity is kept instead, and the update is
+ *
+ * \f[
+ * V_{j + 1} = \mu V_j - \alpha \frac{1}{b} \sum_{i \in B_j} \nabla f_i(A_j),
+ * \qquad A_{j + 1} = A_j + V_{j + 1}.
+ * \f]
+ *
+ * The optimization stops when the maximum number of batches has been visited,
+ * or when a full pass over the functions changes the sum of their objectives
+ * by less than the tolerance, as with SGD.
+ *
+ * The DecomposableFunctionType must provide the same functions that SGD
+ * requires:
+ *
+ *   size_t NumFunctions();
+ *   double Evaluate(const arma::mat& coordinates, const size_t i);
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t i,
+ *                 arma::mat& gradient);
+ *
+ * If it also provides batch versions (see HasBatchGradient), which return the
+ * sums over the functions begin, ..., begin + batchSize - 1,
+ *
+ *   double Evaluate(const arma::mat& coordinates,
+ *                   const size_t begin,
+ *                   const size_t batchSize) const;
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t begin,
+ *                 const size_t batchSize,
+ *                 arma::mat& gradient) const;
+ *
+ * then they are used for each batch; in that case, batches are contiguous
+ * ranges of functions, and shuffling changes the order in which the batches
+ * are visited.  Otherwise, the functions of each batch are evaluated one at a
+ * time, and shuffling changes the order of the functions themselves.  If
+ * mlpack is compiled with OpenMP and the separable Evaluate() and Gradient()
+ * are const, large batches are split across threads in that case.
+ *
+ * All of the memory used during the optimization is allocated before the first
+ * step, and the visitation order is shuffled in place.
+ *
+ * @tparam DecomposableFunctionType Decomposable objective function type to be
+ *     minimized.
+ */
+template<typename DecomposableFunctionType>
+class MiniBatchSGD
+{
+ public:
+  /**
+   * Construct the mini-batch SGD optimizer with the given function and
+   * parameters.
+   *
+   * @param function Function to be optimized (minimized).
+   * @param batchSize Number of separable functions in each batch.
+   * @param stepSize Step size for each batch.
+   * @param maxIterations Maximum number of batches to visit (0 means no
+   *     limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, the visitation order is shuffled at the start of
+   *     each pass; otherwise, it is linear.
+   * @param momentum Momentum of the updates, in [0, 1); 0 means no momentum.
+   */
+  MiniBatchSGD(DecomposableFunctionType& function,
+               const size_t batchSize = 32,
+               const double stepSize = 0.01,
+               const size_t maxIterations = 100000,
+               const double tolerance = 1e-5,
+               const bool shuffle = true,
+               const double momentum = 0.0);
+
+  /**
+   * Optimize the given function using mini-batch stochastic gradient descent.
+   * The given starting point will be modified to store the finishing point of
+   * the algorithm, and the final objective value is returned.
+   *
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  double Optimize(arma::mat& iterate);
+
+  //! Get the instantiated function to be optimized.
+  const DecomposableFunctionType& Function() const { return function; }
+  //! Modify the instantiated function.
+  DecomposableFunctionType& Function() { return function; }
+
+  //! Get the number of separable functions in each batch.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of separable functions in each batch.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the step size.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size.
+  double& StepSize() { return stepSize; }
+
+  //! Get the maximum number of batches (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of batches (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the visitation order is shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the visitation order is shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the momentum.
+  double Momentum() const { return momentum; }
+  //! Modify the momentum.
+  double& Momentum() { return momentum; }
+
+  //! Return a string representation of the object.
+  std::string ToString() const;
+
+ private:
+  //! The instantiated function.
+  DecomposableFunctionType& function;
+
+  //! The number of separable functions in each batch.
+  size_t batchSize;
+
+  //! The step size for each batch.
+  double stepSize;
+
+  //! The maximum number of batches to visit.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the visitation order is shuffled.
+  bool shuffle;
+
+  //! The momentum of the updates.
+  double momentum;
+};
+
+} // namespace optimization
+} // namespace mlpack
+
+// Include implementation.
+#include "minibatch_sgd_impl.hpp"
+
+#endif
@@ -0,0 +1,176 @@
+/**
+ * @file minibatch_sgd_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of mini-batch stochastic gradient descent.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_MINIBATCH_SGD_MINIBATCH_SGD_IMPL_HPP
+#define __MLPACK_CORE_OPTIMIZERS_MINIBATCH_SGD_MINIBATCH_SGD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "minibatch_sgd.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace optimization {
+
+template<typename DecomposableFunctionType>
+MiniBatchSGD<DecomposableFunctionType>::MiniBatchSGD(
+    DecomposableFunctionType& function,
+    const size_t batchSize,
+    const double stepSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool shuffle,
+    const double momentum) :
+    function(function),
+    batchSize(batchSize),
+    stepSize(stepSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    momentum(momentum)
+{
+  if (batchSize == 0)
+    throw std::invalid_argument("MiniBatchSGD::MiniBatchSGD(): batch size must "
+        "be greater than 0");
+
+  if (momentum < 0.0 || momentum >= 1.0)
+  {
+    std::ostringstream oss;
+    oss << "MiniBatchSGD::MiniBatchSGD(): momentum (" << momentum << ") must "
+        << "be in [0, 1)";
+    throw std::invalid_argument(oss.str());
+  }
+}
+
+//! Optimize the function (minimize).
+template<typename DecomposableFunctionType>
+double MiniBatchSGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
+{
+  // Find the number of functions to use, and the number of batches.
+  const size_t numFunctions = function.NumFunctions();
+  if (numFunctions == 0)
+    return 0.0; // Nothing to optimize.
+
+  const size_t effectiveBatchSize = std::min(batchSize, numFunctions);
+  const size_t numBatches = (numFunctions + effectiveBatchSize - 1) /
+      effectiveBatchSize;
+
+  // The order in which the functions are visited; batch b holds the functions
+  // order[b * effectiveBatchSize], ..., and the batches are visited in the
+  // order given by batchOrder.  Batch evaluations need contiguous functions, so
+  // in that case only the batches are shuffled.
+  const bool shuffleFunctions = shuffle &&
+      !HasBatchGradient<DecomposableFunctionType>::value;
+  arma::Col<size_t> order(numFunctions);
+  for (size_t i = 0; i < numFunctions; ++i)
+    order[i] = i;
+  arma::Col<size_t> batchOrder(numBatches);
+  for (size_t b = 0; b < numBatches; ++b)
+    batchOrder[b] = b;
+
+  // Allocate everything that is needed for the iterations now.
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+  std::vector<arma::mat> workspace(2 * numThreads);
+  arma::mat gradient(iterate.n_rows, iterate.n_cols);
+  arma::mat velocity;
+  if (momentum > 0.0)
+    velocity.zeros(iterate.n_rows, iterate.n_cols);
+
+  // To keep track of where we are and how things are going.
+  size_t currentBatch = 0;
+  double overallObjective = BatchEvaluate(function, iterate, order, 0,
+      numFunctions);
+  double lastObjective = DBL_MAX;
+
+  // Now iterate!
+  for (size_t i = 1; i != maxIterations; ++i, ++currentBatch)
+  {
+    // Is this iteration the start of a sequence?
+    if ((currentBatch % numBatches) == 0)
+    {
+      // Output current objective function.
+      MLPACK_LOG_INFO << "Mini-batch SGD: iteration " << i << ", objective "
+          << overallObjective << "." << std::endl;
+
+      if (std::isnan(overallObjective) || std::isinf(overallObjective))
+      {
+        Log::Warn << "Mini-batch SGD: converged to " << overallObjective
+            << "; terminating with failure.  Try a smaller step size?"
+            << std::endl;
+        return overallObjective;
+      }
+
+      if (std::abs(lastObjective - overallObjective) < tolerance)
+      {
+        Log::Info << "Mini-batch SGD: minimized within tolerance " << tolerance
+            << "; terminating optimization." << std::endl;
+        return overallObjective;
+      }
+
+      // Reset the counter variables.
+      lastObjective = overallObjective;
+      overallObjective = 0;
+      currentBatch = 0;
+
+      // Determine order of visitation (in place).
+      if (shuffle)
+        std::shuffle(batchOrder.begin(), batchOrder.end(), math::randGen);
+      if (shuffleFunctions)
+        std::shuffle(order.begin(), order.end(), math::randGen);
+    }
+
+    // Evaluate the gradient for this batch.
+    const size_t begin = batchOrder[currentBatch] * effectiveBatchSize;
+    const size_t count = std::min(effectiveBatchSize, numFunctions - begin);
+    BatchGradient(function, iterate, order, begin, count, gradient, workspace);
+
+    // And update the iterate, with the average gradient of the batch.
+    if (momentum > 0.0)
+    {
+      velocity *= momentum;
+      velocity -= (stepSize / count) * gradient;
+      iterate += velocity;
+    }
+    else
+    {
+      iterate -= (stepSize / count) * gradient;
+    }
+
+    // Now add that to the overall objective function.
+    overallObjective += BatchEvaluate(function, iterate, order, begin, count);
+  }
+
+  Log::Info << "Mini-batch SGD: maximum iterations (" << maxIterations << ") "
+      << "reached; terminating optimization." << std::endl;
+  // Calculate final objective.
+  return BatchEvaluate(function, iterate, order, 0, numFunctions);
+}
+
+// Convert the object to a string.
+template<typename DecomposableFunctionType>
+std::string MiniBatchSGD<DecomposableFunctionType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "MiniBatchSGD [" << this << "]" << std::endl;
+  convert << "  Function:" << std::endl;
+  convert << util::Indent(function.ToString(), 2);
+  convert << "  Batch size: " << batchSize << std::endl;
+  convert << "  Step size: " << stepSize << std::endl;
+  convert << "  Maximum iterations: " << maxIterations << std::endl;
+  convert << "  Tolerance: " << tolerance << std::endl;
+  convert << "  Shuffle: " << (shuffle ? "true" : "false") << std::endl;
+  convert << "  Momentum: " << momentum << std::endl;
+  return convert.str();
+}
+
+} // namespace optimization
+} // namespace mlpack
+
+#endif
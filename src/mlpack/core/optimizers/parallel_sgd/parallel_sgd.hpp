@@ -0,0 +1,165 @@
+/**
+ * @file parallel_sgd.hpp
+ * @author Ryan Curtin
+ *
+ * Parallel, lock-free stochastic gradient descent (Hogwild!).
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_PARALLEL_SGD_PARALLEL_SGD_HPP
+#define __MLPACK_CORE_OPTIMIZERS_PARALLEL_SGD_PARALLEL_SGD_HPP
+
+#include <mlpack/core.hpp>
+#include "sparse_update.hpp"
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * An implementation of parallel stochastic gradient descent without locks, as
+ * in the Hogwild! scheme.  Each pass over the separable functions is split
+ * across threads, and each thread steps along the gradient of its functions
+ * directly on the shared iterate, with no lock.  When each gradient touches
+ * only a few coordinates of the iterate (as for sparse logistic regression or
+ * regularized SVD), the threads rarely write to the same coordinates, and the
+ * speedup is almost linear in the number of threads.  For more information,
+ * see the following paper:
+ *
+ * @code
+ * @inproceedings{recht2011hogwild,
+ *   title={Hogwild!: A lock-free approach to parallelizing stochastic gradient
+ *       descent},
+ *   author={Recht, B. and Re, C. and Wright, S. and Niu, F.},
+ *   booktitle={Advances in Neural Information Processing Systems},
+ *   pages={693--701},
+ *   year={2011}
+ * }
+ * @endcode
+ *
+ * The step size is decayed after each pass: in the k'th pass (starting from 0)
+ * it is \f$ \alpha \gamma^k \f$, where \f$ \gamma \f$ is the decay parameter
+ * (1.0 keeps the step size constant).  The optimization stops when the maximum
+ * number of separable gradient steps has been taken, or when a full pass
+ * changes the objective by less than the tolerance.
+ *
+ * The DecomposableFunctionType must provide the following functions, which
+ * will be called from several threads at once:
+ *
+ *   size_t NumFunctions() const;
+ *   double Evaluate(const arma::mat& coordinates, const size_t i) const;
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t i,
+ *                 arma::mat& gradient) const;
+ *
+ * Instead of the dense Gradient(), the function may provide a sparse one (see
+ * HasSparseGradient), in which case only the nonzero coordinates of each
+ * gradient are updated:
+ *
+ *   void Gradient(const arma::mat& coordinates,
+ *                 const size_t i,
+ *                 arma::sp_mat& gradient) const;
+ *
+ * If mlpack is not compiled with OpenMP, this is plain SGD with a decaying step
+ * size.  With several threads, the result depends on the scheduling of the
+ * threads.
+ *
+ * @tparam DecomposableFunctionType Decomposable objective function type to be
+ *     minimized.
+ */
+template<typename DecomposableFunctionType>
+class ParallelSGD
+{
+ public:
+  /**
+   * Construct the parallel SGD optimizer with the given function and
+   * parameters.  The order of the first parameters is the same as for SGD.
+   *
+   * @param function Function to be optimized (minimized).
+   * @param stepSize Step size of the first pass.
+   * @param maxIterations Maximum number of separable gradient steps, in total
+   *     over all threads (0 means no limit).
+   * @param tolerance Maximum absolute tolerance to terminate algorithm.
+   * @param shuffle If true, the function order is shuffled before each pass;
+   *     otherwise, each thread visits its functions in linear order.
+   * @param decay Factor the step size is multiplied by after each pass, in
+   *     (0, 1].
+   */
+  ParallelSGD(DecomposableFunctionType& function,
+              const double stepSize = 0.01,
+              const size_t maxIterations = 100000,
+              const double tolerance = 1e-5,
+              const bool shuffle = true,
+              const double decay = 1.0);
+
+  /**
+   * Optimize the given function using parallel stochastic gradient descent.
+   * The given starting point will be modified to store the finishing point of
+   * the algorithm, and the final objective value is returned.
+   *
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  double Optimize(arma::mat& iterate);
+
+  //! Get the instantiated function to be optimized.
+  const DecomposableFunctionType& Function() const { return function; }
+  //! Modify the instantiated function.
+  DecomposableFunctionType& Function() { return function; }
+
+  //! Get the step size of the first pass.
+  double StepSize() const { return stepSize; }
+  //! Modify the step size of the first pass.
+  double& StepSize() { return stepSize; }
+
+  //! Get the maximum number of iterations (0 indicates no limit).
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations (0 indicates no limit).
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+  //! Get whether or not the individual functions are shuffled.
+  bool Shuffle() const { return shuffle; }
+  //! Modify whether or not the individual functions are shuffled.
+  bool& Shuffle() { return shuffle; }
+
+  //! Get the decay of the step size after each pass.
+  double Decay() const { return decay; }
+  //! Modify the decay of the step size after each pass.
+  double& Decay() { return decay; }
+
+  //! Return a string representation of the object.
+  std::string ToString() const;
+
+ private:
+  //! Evaluate the objective over all the separable functions, in parallel.
+  double FullEvaluate(const arma::mat& iterate) const;
+
+  //! The instantiated function.
+  DecomposableFunctionType& function;
+
+  //! The step size of the first pass.
+  double stepSize;
+
+  //! The maximum number of allowed iterations.
+  size_t maxIterations;
+
+  //! The tolerance for termination.
+  double tolerance;
+
+  //! Controls whether or not the individual functions are shuffled when
+  //! iterating.
+  bool shuffle;
+
+  //! The factor the step size is multiplied by after each pass.
+  double decay;
+};
+
+} // namespace optimization
+} // namespace mlpack
+
+// Include implementation.
+#include "parallel_sgd_impl.hpp"
+
+#endif
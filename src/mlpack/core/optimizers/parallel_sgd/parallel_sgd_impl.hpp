@@ -0,0 +1,152 @@
+/**
+ * @file parallel_sgd_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of parallel, lock-free stochastic gradient descent.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_PARALLEL_SGD_PARALLEL_SGD_IMPL_HPP
+#define __MLPACK_CORE_OPTIMIZERS_PARALLEL_SGD_PARALLEL_SGD_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "parallel_sgd.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace optimization {
+
+template<typename DecomposableFunctionType>
+ParallelSGD<DecomposableFunctionType>::ParallelSGD(
+    DecomposableFunctionType& function,
+    const double stepSize,
+    const size_t maxIterations,
+    const double tolerance,
+    const bool shuffle,
+    const double decay) :
+    function(function),
+    stepSize(stepSize),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    shuffle(shuffle),
+    decay(decay)
+{
+  if (decay <= 0.0 || decay > 1.0)
+  {
+    std::ostringstream oss;
+    oss << "ParallelSGD::ParallelSGD(): decay (" << decay << ") must be in "
+        << "(0, 1]";
+    throw std::invalid_argument(oss.str());
+  }
+}
+
+//! Optimize the function (minimize).
+template<typename DecomposableFunctionType>
+double ParallelSGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
+{
+  // Find the number of functions to use.
+  const size_t numFunctions = function.NumFunctions();
+  if (numFunctions == 0)
+    return 0.0; // Nothing to optimize.
+
+  // The order of visitation, which is shuffled in place before each pass.
+  arma::Col<size_t> order(numFunctions);
+  for (size_t i = 0; i < numFunctions; ++i)
+    order[i] = i;
+
+  // To keep track of where we are and how things are going.
+  size_t iterations = 0;
+  double currentStepSize = stepSize;
+  double overallObjective = FullEvaluate(iterate);
+  double lastObjective = DBL_MAX;
+
+  for (size_t pass = 0; ; ++pass)
+  {
+    // Output current objective function.
+    Log::Info << "Parallel SGD: pass " << pass << ", objective "
+        << overallObjective << "." << std::endl;
+
+    if (std::isnan(overallObjective) || std::isinf(overallObjective))
+    {
+      Log::Warn << "Parallel SGD: converged to " << overallObjective << "; "
+          << "terminating with failure.  Try a smaller step size?"
+          << std::endl;
+      return overallObjective;
+    }
+
+    if (std::abs(lastObjective - overallObjective) < tolerance)
+    {
+      Log::Info << "Parallel SGD: minimized within tolerance " << tolerance
+          << "; terminating optimization." << std::endl;
+      return overallObjective;
+    }
+
+    if (maxIterations != 0 && iterations >= maxIterations)
+    {
+      Log::Info << "Parallel SGD: maximum iterations (" << maxIterations
+          << ") reached; terminating optimization." << std::endl;
+      return overallObjective;
+    }
+
+    // Determine order of visitation (in place).
+    if (shuffle)
+      std::shuffle(order.begin(), order.end(), math::randGen);
+
+    // The last pass may be cut short by the maximum number of iterations.
+    const size_t passSize = (maxIterations == 0) ? numFunctions :
+        std::min(numFunctions, maxIterations - iterations);
+
+    // Each thread steps along the gradients of its share of the functions, on
+    // the shared iterate and without locks.
+    #pragma omp parallel
+    {
+      arma::sp_mat gradient;
+      arma::mat denseGradient;
+
+      #pragma omp for schedule(static)
+      for (size_t j = 0; j < passSize; ++j)
+        HogwildUpdate(function, iterate, order[j], currentStepSize, gradient,
+            denseGradient);
+    }
+
+    iterations += passSize;
+    currentStepSize *= decay;
+
+    lastObjective = overallObjective;
+    overallObjective = FullEvaluate(iterate);
+  }
+}
+
+template<typename DecomposableFunctionType>
+double ParallelSGD<DecomposableFunctionType>::FullEvaluate(
+    const arma::mat& iterate) const
+{
+  const size_t numFunctions = function.NumFunctions();
+
+  double objective = 0.0;
+  #pragma omp parallel for schedule(static) reduction(+:objective)
+  for (size_t i = 0; i < numFunctions; ++i)
+    objective += function.Evaluate(iterate, i);
+
+  return objective;
+}
+
+// Convert the object to a string.
+template<typename DecomposableFunctionType>
+std::string ParallelSGD<DecomposableFunctionType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "ParallelSGD [" << this << "]" << std::endl;
+  convert << "  Function:" << std::endl;
+  convert << util::Indent(function.ToString(), 2);
+  convert << "  Step size: " << stepSize << std::endl;
+  convert << "  Maximum iterations: " << maxIterations << std::endl;
+  convert << "  Tolerance: " << tolerance << std::endl;
+  convert << "  Shuffle points: " << (shuffle ? "true" : "false") << std::endl;
+  convert << "  Step size decay: " << decay << std::endl;
+  return convert.str();
+}
+
+} // namespace optimization
+} // namespace mlpack
+
+#endif
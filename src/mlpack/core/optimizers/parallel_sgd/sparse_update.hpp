@@ -0,0 +1,121 @@
+/**
+ * @file sparse_update.hpp
+ * @author Ryan Curtin
+ *
+ * HogwildUpdate(), which takes one lock-free step of ParallelSGD along the
+ * gradient of one separable function.  Functions whose separable gradients
+ * touch only a few coordinates can provide them as an arma::sp_mat, so that
+ * only those coordinates are read and written; for every other function, the
+ * dense gradient is used.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_PARALLEL_SGD_SPARSE_UPDATE_HPP
+#define __MLPACK_CORE_OPTIMIZERS_PARALLEL_SGD_SPARSE_UPDATE_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+// This gives us a HasSparseGradientCheck<T, U> type (where U is a function
+// pointer) we can use with SFINAE to catch when a function has a Gradient(...)
+// function of a given signature.
+HAS_MEM_FUNC(Gradient, HasSparseGradientCheck);
+
+/**
+ * HasSparseGradient<FunctionType>::value is true if the function provides a
+ * sparse separable gradient, which has the signature
+ *
+ * @code
+ * void Gradient(const arma::mat& coordinates,
+ *               const size_t i,
+ *               arma::sp_mat& gradient) const;
+ * @endcode
+ *
+ * and sets gradient to the gradient of the i'th separable function.
+ */
+template<typename FunctionType>
+struct HasSparseGradient
+{
+  static const bool value = HasSparseGradientCheck<FunctionType,
+      void(FunctionType::*)(const arma::mat&, const size_t, arma::sp_mat&)
+      const>::value;
+};
+
+/**
+ * Take a step of the given size along the sparse gradient of the i'th
+ * separable function.  Each nonzero coordinate of the gradient is updated
+ * atomically, without any lock on the iterate, so other threads may be
+ * stepping at the same time.
+ *
+ * @param function Function to optimize.
+ * @param iterate Shared iterate to update.
+ * @param i Index of the separable function.
+ * @param stepSize Step size.
+ * @param gradient Sparse gradient of the thread (overwritten).
+ * @param denseGradient Dense gradient of the thread (unused).
+ */
+template<typename FunctionType>
+typename std::enable_if<HasSparseGradient<FunctionType>::value, void>::type
+HogwildUpdate(const FunctionType& function,
+              arma::mat& iterate,
+              const size_t i,
+              const double stepSize,
+              arma::sp_mat& gradient,
+              arma::mat& /* denseGradient */)
+{
+  function.Gradient(iterate, i, gradient);
+
+  double* values = iterate.memptr();
+  for (arma::sp_mat::const_iterator it = gradient.begin(); it != gradient.end();
+       ++it)
+  {
+    const size_t index = it.row() + it.col() * iterate.n_rows;
+    const double step = stepSize * (*it);
+
+    #pragma omp atomic
+    values[index] -= step;
+  }
+}
+
+/**
+ * Take a step of the given size along the dense gradient of the i'th separable
+ * function.  Each nonzero coordinate of the gradient is updated atomically,
+ * without any lock on the iterate, so other threads may be stepping at the same
+ * time.
+ *
+ * @param function Function to optimize.
+ * @param iterate Shared iterate to update.
+ * @param i Index of the separable function.
+ * @param stepSize Step size.
+ * @param gradient Sparse gradient of the thread (unused).
+ * @param denseGradient Dense gradient of the thread (overwritten).
+ */
+template<typename FunctionType>
+typename std::enable_if<!HasSparseGradient<FunctionType>::value, void>::type
+HogwildUpdate(const FunctionType& function,
+              arma::mat& iterate,
+              const size_t i,
+              const double stepSize,
+              arma::sp_mat& /* gradient */,
+              arma::mat& denseGradient)
+{
+  function.Gradient(iterate, i, denseGradient);
+
+  double* values = iterate.memptr();
+  for (size_t index = 0; index < denseGradient.n_elem; ++index)
+  {
+    if (denseGradient[index] == 0.0)
+      continue;
+
+    const double step = stepSize * denseGradient[index];
+
+    #pragma omp atomic
+    values[index] -= step;
+  }
+}
+
+} // namespace optimization
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,213 @@
+/**
+ * @file parallel_tempering_sa.hpp
+ * @author Ryan Curtin
+ *
+ * Parallel tempering (replica exchange) simulated annealing, which runs several
+ * SA chains at different temperatures in parallel.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_SA_PARALLEL_TEMPERING_SA_HPP
+#define __MLPACK_CORE_OPTIMIZERS_SA_PARALLEL_TEMPERING_SA_HPP
+
+#include <mlpack/prereqs.hpp>
+
+#include "sa.hpp"
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * Parallel tempering simulated annealing runs numChains SA chains (replicas) at
+ * once.  Chain k starts at the temperature initT * temperatureRatio^k, so
+ * chain 0 is the coldest, and each chain is cooled with its own copy of the
+ * cooling schedule.  Each chain makes moves in the same way as SA does, with
+ * its own feedback move control and its own random number stream; if mlpack is
+ * compiled with OpenMP, the chains run in parallel.
+ *
+ * Every exchangeInterval moves, the states of neighbouring chains j and j + 1
+ * are swapped with probability
+ *
+ *   min{1, exp((1 / T_j - 1 / T_{j + 1}) (E_j - E_{j + 1}))},
+ *
+ * so good states found by the hot chains (which cross barriers easily) make
+ * their way down to the cold chains (which refine them).  The move sizes stay
+ * with the chains, since they are tuned to the temperature of the chain.  For
+ * more information, see the following paper:
+ *
+ * @code
+ * @article{earl2005parallel,
+ *   title={Parallel tempering: Theory, applications, and new perspectives},
+ *   author={Earl, D.J. and Deem, M.W.},
+ *   journal={Physical Chemistry Chemical Physics},
+ *   volume={7},
+ *   number={23},
+ *   pages={3910--3916},
+ *   year={2005}
+ * }
+ * @endcode
+ *
+ * The optimization terminates when the coldest chain is frozen (in the same
+ * sense as for SA), or when each chain has made maxIterations moves after the
+ * initial moves.  The best point seen by any chain is returned.
+ *
+ * The requirements on FunctionType and CoolingScheduleType are the same as for
+ * SA; in addition, the cooling schedule must be copyable, and, when OpenMP is
+ * used, FunctionType::Evaluate() must be safe to call from several threads at
+ * once.
+ *
+ * @tparam FunctionType objective function type to be minimized.
+ * @tparam CoolingScheduleType type for cooling schedule
+ */
+template<
+    typename FunctionType,
+    typename CoolingScheduleType = ExponentialSchedule
+>
+class ParallelTemperingSA
+{
+ public:
+  /**
+   * Construct the parallel tempering SA optimizer with the given function and
+   * parameters.  The parameters up to gain have the same meaning as for SA, and
+   * apply to every chain.
+   *
+   * @param function Function to be minimized.
+   * @param coolingSchedule Instantiated cooling schedule (copied for each
+   *      chain).
+   * @param maxIterations Maximum number of moves of each chain (0 indicates no
+   *      limit).
+   * @param initT Initial temperature of the coldest chain.
+   * @param initMoves Number of initial moves of each chain without changing
+   *      temperature.
+   * @param moveCtrlSweep Sweeps per feedback move control.
+   * @param tolerance Tolerance to consider system frozen.
+   * @param maxToleranceSweep Maximum sweeps below tolerance to consider system
+   *      frozen.
+   * @param maxMoveCoef Maximum move size.
+   * @param initMoveCoef Initial move size.
+   * @param gain Proportional control in feedback move control.
+   * @param numChains Number of chains.
+   * @param temperatureRatio Ratio between the temperatures of neighbouring
+   *      chains; must be at least 1.
+   * @param exchangeInterval Number of moves of each chain between exchange
+   *      attempts.
+   */
+  ParallelTemperingSA(FunctionType& function,
+                      CoolingScheduleType& coolingSchedule,
+                      const size_t maxIterations = 1000000,
+                      const double initT = 10000.,
+                      const size_t initMoves = 1000,
+                      const size_t moveCtrlSweep = 100,
+                      const double tolerance = 1e-5,
+                      const size_t maxToleranceSweep = 3,
+                      const double maxMoveCoef = 20,
+                      const double initMoveCoef = 0.3,
+                      const double gain = 0.3,
+                      const size_t numChains = 4,
+                      const double temperatureRatio = 2.0,
+                      const size_t exchangeInterval = 100);
+
+  /**
+   * Optimize the given function using parallel tempering simulated annealing.
+   * Every chain starts at the given point, which will be modified to store the
+   * best point found by any chain, and the objective value of that point is
+   * returned.
+   *
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the best point.
+   */
+  double Optimize(arma::mat& iterate);
+
+  //! Get the instantiated function to be optimized.
+  const FunctionType& Function() const { return function; }
+  //! Modify the instantiated function.
+  FunctionType& Function() { return function; }
+
+  //! Get the initial temperature of the coldest chain.
+  double Temperature() const { return temperature; }
+  //! Modify the initial temperature of the coldest chain.
+  double& Temperature() { return temperature; }
+
+  //! Get the initial moves.
+  size_t InitMoves() const { return initMoves; }
+  //! Modify the initial moves.
+  size_t& InitMoves() { return initMoves; }
+
+  //! Get sweeps per move control.
+  size_t MoveCtrlSweep() const { return moveCtrlSweep; }
+  //! Modify sweeps per move control.
+  size_t& MoveCtrlSweep() { return moveCtrlSweep; }
+
+  //! Get the tolerance.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the maxToleranceSweep.
+  size_t MaxToleranceSweep() const { return maxToleranceSweep; }
+  //! Modify the maxToleranceSweep.
+  size_t& MaxToleranceSweep() { return maxToleranceSweep; }
+
+  //! Get the gain.
+  double Gain() const { return gain; }
+  //! Modify the gain.
+  double& Gain() { return gain; }
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the number of chains.
+  size_t NumChains() const { return numChains; }
+  //! Modify the number of chains.
+  size_t& NumChains() { return numChains; }
+
+  //! Get the ratio between the temperatures of neighbouring chains.
+  double TemperatureRatio() const { return temperatureRatio; }
+  //! Modify the ratio between the temperatures of neighbouring chains.
+  double& TemperatureRatio() { return temperatureRatio; }
+
+  //! Get the number of moves between exchange attempts.
+  size_t ExchangeInterval() const { return exchangeInterval; }
+  //! Modify the number of moves between exchange attempts.
+  size_t& ExchangeInterval() { return exchangeInterval; }
+
+  //! Return a string representation of this object.
+  std::string ToString() const;
+
+ private:
+  //! The function to be optimized.
+  FunctionType& function;
+  //! The cooling schedule being used (copied for each chain).
+  CoolingScheduleType& coolingSchedule;
+  //! The maximum number of iterations.
+  size_t maxIterations;
+  //! The initial temperature of the coldest chain.
+  double temperature;
+  //! The number of initial moves before reducing the temperature.
+  size_t initMoves;
+  //! The number of sweeps before a MoveControl() call.
+  size_t moveCtrlSweep;
+  //! Tolerance for convergence.
+  double tolerance;
+  //! Number of sweeps in tolerance before system is considered frozen.
+  size_t maxToleranceSweep;
+  //! Maximum move size.
+  double maxMoveCoef;
+  //! Initial move size.
+  double initMoveCoef;
+  //! Proportional control in feedback move control.
+  double gain;
+  //! The number of chains.
+  size_t numChains;
+  //! The ratio between the temperatures of neighbouring chains.
+  double temperatureRatio;
+  //! The number of moves of each chain between exchange attempts.
+  size_t exchangeInterval;
+};
+
+}; // namespace optimization
+}; // namespace mlpack
+
+#include "parallel_tempering_sa_impl.hpp"
+
+#endif
@@ -0,0 +1,240 @@
+/**
+ * @file parallel_tempering_sa_impl.hpp
+ * @author Ryan Curtin
+ *
+ * The implementation of the parallel tempering SA optimizer.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_SA_PARALLEL_TEMPERING_SA_IMPL_HPP
+#define __MLPACK_CORE_OPTIMIZERS_SA_PARALLEL_TEMPERING_SA_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "parallel_tempering_sa.hpp"
+
+namespace mlpack {
+namespace optimization {
+
+template<
+    typename FunctionType,
+    typename CoolingScheduleType
+>
+ParallelTemperingSA<FunctionType, CoolingScheduleType>::ParallelTemperingSA(
+    FunctionType& function,
+    CoolingScheduleType& coolingSchedule,
+    const size_t maxIterations,
+    const double initT,
+    const size_t initMoves,
+    const size_t moveCtrlSweep,
+    const double tolerance,
+    const size_t maxToleranceSweep,
+    const double maxMoveCoef,
+    const double initMoveCoef,
+    const double gain,
+    const size_t numChains,
+    const double temperatureRatio,
+    const size_t exchangeInterval) :
+    function(function),
+    coolingSchedule(coolingSchedule),
+    maxIterations(maxIterations),
+    temperature(initT),
+    initMoves(initMoves),
+    moveCtrlSweep(moveCtrlSweep),
+    tolerance(tolerance),
+    maxToleranceSweep(maxToleranceSweep),
+    maxMoveCoef(maxMoveCoef),
+    initMoveCoef(initMoveCoef),
+    gain(gain),
+    numChains(numChains),
+    temperatureRatio(temperatureRatio),
+    exchangeInterval(exchangeInterval)
+{
+  if (numChains == 0)
+    throw std::invalid_argument("ParallelTemperingSA::ParallelTemperingSA(): "
+        "number of chains must be greater than 0");
+
+  if (temperatureRatio < 1.0)
+  {
+    std::ostringstream oss;
+    oss << "ParallelTemperingSA::ParallelTemperingSA(): temperature ratio ("
+        << temperatureRatio << ") must be at least 1";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (exchangeInterval == 0)
+    throw std::invalid_argument("ParallelTemperingSA::ParallelTemperingSA(): "
+        "exchange interval must be greater than 0");
+}
+
+//! Optimize the function (minimize).
+template<
+    typename FunctionType,
+    typename CoolingScheduleType
+>
+double ParallelTemperingSA<FunctionType, CoolingScheduleType>::Optimize(
+    arma::mat& iterate)
+{
+  typedef SA<FunctionType, CoolingScheduleType> ChainType;
+
+  // Each chain has its own cooling schedule; the chains hold references to
+  // them, so the schedules must not move once the chains are built.
+  std::vector<CoolingScheduleType> schedules(numChains, coolingSchedule);
+  std::vector<ChainType> chains;
+  chains.reserve(numChains);
+  for (size_t k = 0; k < numChains; ++k)
+    chains.push_back(ChainType(function, schedules[k], maxIterations,
+        temperature * std::pow(temperatureRatio, (double) k), initMoves,
+        moveCtrlSweep, tolerance, maxToleranceSweep, maxMoveCoef, initMoveCoef,
+        gain));
+
+  // The state of each chain.  The random number stream of each chain is
+  // seeded from the global generator, so a run is reproducible with
+  // math::RandomSeed().
+  std::vector<arma::mat> iterates(numChains, iterate);
+  std::vector<arma::mat> accepts(numChains,
+      arma::zeros<arma::mat>(iterate.n_rows, iterate.n_cols));
+  std::vector<size_t> idxs(numChains, 0);
+  std::vector<size_t> sweepCounters(numChains, 0);
+  std::vector<size_t> frozenCounts(numChains, 0);
+  std::vector<std::mt19937> rngs(numChains);
+  for (size_t k = 0; k < numChains; ++k)
+    rngs[k].seed((uint32_t) math::randGen());
+
+  const double initialEnergy = function.Evaluate(iterate);
+  arma::vec energies(numChains);
+  energies.fill(initialEnergy);
+
+  // The best point seen by each chain.
+  std::vector<arma::mat> bestIterates(numChains, iterate);
+  arma::vec bestEnergies(energies);
+
+  const size_t frozenLimit = maxToleranceSweep * moveCtrlSweep *
+      iterate.n_elem;
+  size_t exchanges = 0;
+  size_t attempts = 0;
+
+  // Initial moves to get rid of dependency of initial states.
+  #pragma omp parallel for schedule(static)
+  for (size_t k = 0; k < numChains; ++k)
+  {
+    for (size_t i = 0; i < initMoves; ++i)
+      chains[k].GenerateMove(iterates[k], accepts[k], energies[k], idxs[k],
+          sweepCounters[k], rngs[k]);
+
+    if (energies[k] < bestEnergies[k])
+    {
+      bestEnergies[k] = energies[k];
+      bestIterates[k] = iterates[k];
+    }
+  }
+
+  // Iterating and cooling, in rounds of exchangeInterval moves.
+  size_t iterations = 0;
+  while (iterations != maxIterations)
+  {
+    const size_t roundMoves = (maxIterations == 0) ? exchangeInterval :
+        std::min(exchangeInterval, maxIterations - iterations);
+
+    #pragma omp parallel for schedule(static)
+    for (size_t k = 0; k < numChains; ++k)
+    {
+      for (size_t i = 0; i < roundMoves; ++i)
+      {
+        const double oldEnergy = energies[k];
+        chains[k].GenerateMove(iterates[k], accepts[k], energies[k], idxs[k],
+            sweepCounters[k], rngs[k]);
+        chains[k].Temperature() = schedules[k].NextTemperature(
+            chains[k].Temperature(), energies[k]);
+
+        if (std::abs(energies[k] - oldEnergy) < tolerance)
+          ++frozenCounts[k];
+        else
+          frozenCounts[k] = 0;
+
+        if (energies[k] < bestEnergies[k])
+        {
+          bestEnergies[k] = energies[k];
+          bestIterates[k] = iterates[k];
+        }
+      }
+    }
+
+    iterations += roundMoves;
+
+    // Terminate, if the coldest chain is frozen.
+    if (frozenCounts[0] >= frozenLimit)
+    {
+      Log::Debug << "ParallelTemperingSA: minimized within tolerance "
+          << tolerance << " for " << maxToleranceSweep << " sweeps after "
+          << iterations << " iterations; terminating optimization."
+          << std::endl;
+      break;
+    }
+
+    // Attempt to exchange the states of neighbouring chains, from the hottest
+    // pair down, so a good state can travel down several chains at once.
+    for (size_t k = numChains - 1; k > 0; --k)
+    {
+      const double delta = (1.0 / chains[k - 1].Temperature() -
+          1.0 / chains[k].Temperature()) * (energies[k - 1] - energies[k]);
+      ++attempts;
+      if (delta >= 0.0 || math::Random() < std::exp(delta))
+      {
+        // Only an exchange that changes the energies counts as a change for
+        // the frozen test.
+        if (std::abs(energies[k - 1] - energies[k]) >= tolerance)
+        {
+          frozenCounts[k - 1] = 0;
+          frozenCounts[k] = 0;
+        }
+
+        iterates[k - 1].swap(iterates[k]);
+        std::swap(energies[k - 1], energies[k]);
+        ++exchanges;
+      }
+    }
+  }
+
+  if (iterations == maxIterations)
+    Log::Debug << "ParallelTemperingSA: maximum iterations (" << maxIterations
+        << ") reached; terminating optimization." << std::endl;
+
+  Log::Debug << "ParallelTemperingSA: " << exchanges << " of " << attempts
+      << " exchanges accepted." << std::endl;
+
+  // Return the best point seen by any chain.
+  arma::uword best;
+  const double bestEnergy = bestEnergies.min(best);
+  iterate = std::move(bestIterates[best]);
+  return bestEnergy;
+}
+
+template<
+    typename FunctionType,
+    typename CoolingScheduleType
+>
+std::string ParallelTemperingSA<FunctionType, CoolingScheduleType>::
+ToString() const
+{
+  std::ostringstream convert;
+  convert << "ParallelTemperingSA [" << this << "]" << std::endl;
+  convert << "  Function:" << std::endl;
+  convert << util::Indent(function.ToString(), 2);
+  convert << "  Cooling Schedule:" << std::endl;
+  convert << util::Indent(coolingSchedule.ToString(), 2);
+  convert << "  Initial temperature: " << temperature << std::endl;
+  convert << "  Initial moves: " << initMoves << std::endl;
+  convert << "  Sweeps per move control: " << moveCtrlSweep << std::endl;
+  convert << "  Tolerance: " << tolerance << std::endl;
+  convert << "  Maximum sweeps below tolerance: " << maxToleranceSweep
+      << std::endl;
+  convert << "  Move control gain: " << gain << std::endl;
+  convert << "  Maximum iterations: " << maxIterations << std::endl;
+  convert << "  Chains: " << numChains << std::endl;
+  convert << "  Temperature ratio: " << temperatureRatio << std::endl;
+  convert << "  Exchange interval: " << exchangeInterval << std::endl;
+  return convert.str();
+}
+
+}; // namespace optimization
+}; // namespace mlpack
+
+#endif
@@ -189,12 +189,15 @@ class SA
    * @param idx Current parameter to modify.
    * @param sweepCounter Current counter representing how many sweeps have been
    *      completed.
+   * @param rng Random number generator to draw the move from.
    */
+  template<typename RNGType>
   void GenerateMove(arma::mat& iterate,
                     arma::mat& accept,
                     double& energy,
                     size_t& idx,
-                    size_t& sweepCounter);
+                    size_t& sweepCounter,
+                    RNGType& rng);
 
   /**
    * MoveControl() uses a proportional feedback control to determine the size
@@ -215,6 +218,10 @@ class SA
    * @param accept Matrix representing which parameters have had accepted moves.
    */
   void MoveControl(const size_t nMoves, arma::mat& accept);
+
+  // ParallelTemperingSA runs several SA chains, and makes moves on each of them
+  // with GenerateMove().
+  template<typename, typename> friend class ParallelTemperingSA;
 };
 
 }; // namespace optimization
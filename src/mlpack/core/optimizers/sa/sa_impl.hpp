@@ -70,13 +70,13 @@ double SA<FunctionType, CoolingScheduleType>::Optimize(arma::mat &iterate)
 
   // Initial moves to get rid of dependency of initial states.
   for (size_t i = 0; i < initMoves; ++i)
-    GenerateMove(iterate, accept, energy, idx, sweepCounter);
+    GenerateMove(iterate, accept, energy, idx, sweepCounter, math::randGen);
 
   // Iterating and cooling.
   for (size_t i = 0; i != maxIterations; ++i)
   {
     oldEnergy = energy;
-    GenerateMove(iterate, accept, energy, idx, sweepCounter);
+    GenerateMove(iterate, accept, energy, idx, sweepCounter, math::randGen);
     temperature = coolingSchedule.NextTemperature(temperature, energy);
 
     // Determine if the optimization has entered (or continues to be in) a
@@ -113,13 +113,17 @@ template<
     typename FunctionType,
     typename CoolingScheduleType
 >
+template<typename RNGType>
 void SA<FunctionType, CoolingScheduleType>::GenerateMove(
     arma::mat& iterate,
     arma::mat& accept,
     double& energy,
     size_t& idx,
-    size_t& sweepCounter)
+    size_t& sweepCounter,
+    RNGType& rng)
 {
+  std::uniform_real_distribution<> uniform;
+
   const double prevEnergy = energy;
   const double prevValue = iterate(idx);
 
@@ -128,7 +132,7 @@ void SA<FunctionType, CoolingScheduleType>::GenerateMove(
   // MoveControl() is derived for the Laplace distribution.
 
   // Sample from a Laplace distribution with scale parameter moveSize(idx).
-  const double unif = 2.0 * math::Random() - 1.0;
+  const double unif = 2.0 * uniform(rng) - 1.0;
   const double move = (unif < 0) ? (moveSize(idx) * std::log(1 + unif)) :
       (-moveSize(idx) * std::log(1 - unif));
 
@@ -136,7 +140,7 @@ void SA<FunctionType, CoolingScheduleType>::GenerateMove(
   energy = function.Evaluate(iterate);
   // According to the Metropolis criterion, accept the move with probability
   // min{1, exp(-(E_new - E_old) / T)}.
-  const double xi = math::Random();
+  const double xi = uniform(rng);
   const double delta = energy - prevEnergy;
   const double criterion = std::exp(-delta / temperature);
   if (delta <= 0. || criterion > xi)
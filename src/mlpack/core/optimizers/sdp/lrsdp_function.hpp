@@ -115,6 +115,18 @@ inline void AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>>::Gradient(
     const arma::mat& coordinates,
     arma::mat& gradient) const;
 
+template <>
+inline double
+AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const;
+
+template <>
+inline double
+AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const;
+
 }; // namespace optimization
 }; // namespace mlpack
 
@@ -11,9 +11,56 @@
 
 #include "lrsdp_function.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace optimization {
 
+//! Utility function for calculating Tr(A R R^T) for a sparse A directly from
+//! the rows of R (the columns of rt = R^T), without forming R R^T: each
+//! nonzero A(i, j) contributes A(i, j) R_i R_j^T.
+static inline double
+ConstraintTrace(const arma::sp_mat& a, const arma::mat& rt)
+{
+  double trace = 0.;
+  for (arma::sp_mat::const_iterator it = a.begin(); it != a.end(); ++it)
+    trace += (*it) * arma::dot(rt.unsafe_col(it.row()),
+        rt.unsafe_col(it.col()));
+  return trace;
+}
+
+//! Utility function for calculating Tr(A R R^T) = Tr(R^T A R) for a dense A,
+//! without forming R R^T.
+static inline double
+ConstraintTrace(const arma::mat& a, const arma::mat& rt)
+{
+  return accu((rt * a) % rt);
+}
+
+//! Utility function for adding scale * R^T A to gt, for a sparse A, one
+//! nonzero of A at a time.
+static inline void
+AddConstraintGradient(arma::mat& gt,
+                      const arma::sp_mat& a,
+                      const arma::mat& rt,
+                      const double scale)
+{
+  for (arma::sp_mat::const_iterator it = a.begin(); it != a.end(); ++it)
+    gt.unsafe_col(it.col()) += (scale * (*it)) * rt.unsafe_col(it.row());
+}
+
+//! Utility function for adding scale * R^T A to gt, for a dense A.
+static inline void
+AddConstraintGradient(arma::mat& gt,
+                      const arma::mat& a,
+                      const arma::mat& rt,
+                      const double scale)
+{
+  gt += scale * (rt * a);
+}
+
 template <typename SDPType>
 LRSDPFunction<SDPType>::LRSDPFunction(const SDPType& sdp,
                                       const arma::mat& initialPoint):
@@ -42,8 +89,7 @@ LRSDPFunction<SDPType>::LRSDPFunction(const size_t numSparseConstraints,
 template <typename SDPType>
 double LRSDPFunction<SDPType>::Evaluate(const arma::mat& coordinates) const
 {
-  const arma::mat rrt = coordinates * trans(coordinates);
-  return accu(SDP().C() % rrt);
+  return ConstraintTrace(SDP().C(), trans(coordinates));
 }
 
 template <typename SDPType>
@@ -58,11 +104,12 @@ template <typename SDPType>
 double LRSDPFunction<SDPType>::EvaluateConstraint(const size_t index,
                                                   const arma::mat& coordinates) const
 {
-  const arma::mat rrt = coordinates * trans(coordinates);
+  const arma::mat rt = trans(coordinates);
   if (index < SDP().NumSparseConstraints())
-    return accu(SDP().SparseA()[index] % rrt) - SDP().SparseB()[index];
+    return ConstraintTrace(SDP().SparseA()[index], rt) -
+        SDP().SparseB()[index];
   const size_t index1 = index - SDP().NumSparseConstraints();
-  return accu(SDP().DenseA()[index1] % rrt) - SDP().DenseB()[index1];
+  return ConstraintTrace(SDP().DenseA()[index1], rt) - SDP().DenseB()[index1];
 }
 
 template <typename SDPType>
@@ -88,45 +135,101 @@ std::string LRSDPFunction<SDPType>::ToString() const
   return convert.str();
 }
 
-//! Utility function for calculating part of the objective when AugLagrangian is
-//! used with an LRSDPFunction.
-template <typename MatrixType>
-static inline void
-UpdateObjective(double& objective,
-                const arma::mat& rrt,
-                const std::vector<MatrixType>& ais,
-                const arma::vec& bis,
-                const arma::vec& lambda,
-                const size_t lambdaOffset,
-                const double sigma)
-{
-  for (size_t i = 0; i < ais.size(); ++i)
+/**
+ * Calculate the augmented Lagrangian of an LRSDPFunction and, if gradient is
+ * not NULL, its gradient:
+ *
+ *   L(R, y, s) = Tr(C * (R R^T)) -
+ *       sum_{i = 1}^{m} (y_i (Tr(A_i * (R R^T)) - b_i)) +
+ *       (sigma / 2) * sum_{i = 1}^{m} (Tr(A_i * (R R^T)) - b_i)^2
+ *
+ *   L'(R, y, s) = 2 * S' * R
+ *     with
+ *   S' = C - sum_{i = 1}^{m} y'_i A_i
+ *   y'_i = y_i - sigma * (Trace(A_i * (R R^T)) - b_i)
+ *
+ * R R^T and S' are never formed: each trace is computed from the rows of R
+ * (see ConstraintTrace()), and S' R is accumulated one constraint at a time,
+ * so that for sparse constraints (like the k-nearest-neighbor constraints of
+ * MVU) the memory used is O(n r) instead of O(n^2).  If mlpack is compiled
+ * with OpenMP, the constraints are evaluated in parallel; for the gradient,
+ * each thread sums into its own buffer, and the buffers are added up in order.
+ */
+template <typename SDPType>
+static inline double
+LagrangianImpl(const LRSDPFunction<SDPType>& function,
+               const arma::mat& coordinates,
+               const arma::vec& lambda,
+               const double sigma,
+               arma::mat* gradient)
+{
+  const SDPType& sdp = function.SDP();
+  const size_t numSparse = sdp.NumSparseConstraints();
+  const size_t numConstraints = sdp.NumConstraints();
+
+  // Each column of rt is a row of R, so the rows can be accessed directly.
+  const arma::mat rt = trans(coordinates);
+
+  // Evaluate each constraint, Tr(A_i * (R R^T)) - b_i.
+  arma::vec constraints(numConstraints);
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < numConstraints; ++i)
   {
-    // Take the trace subtracted by the b_i.
-    const double constraint = accu(ais[i] % rrt) - bis[i];
-    objective -= (lambda[lambdaOffset + i] * constraint);
-    objective += (sigma / 2.) * constraint * constraint;
+    if (i < numSparse)
+      constraints[i] = ConstraintTrace(sdp.SparseA()[i], rt) -
+          sdp.SparseB()[i];
+    else
+      constraints[i] = ConstraintTrace(sdp.DenseA()[i - numSparse], rt) -
+          sdp.DenseB()[i - numSparse];
   }
-}
 
-//! Utility function for calculating part of the gradient when AugLagrangian is
-//! used with an LRSDPFunction.
-template <typename MatrixType>
-static inline void
-UpdateGradient(arma::mat& s,
-               const arma::mat& rrt,
-               const std::vector<MatrixType>& ais,
-               const arma::vec& bis,
-               const arma::vec& lambda,
-               const size_t lambdaOffset,
-               const double sigma)
-{
-  for (size_t i = 0; i < ais.size(); ++i)
+  const double objective = ConstraintTrace(sdp.C(), rt) -
+      arma::dot(lambda, constraints) +
+      (sigma / 2.) * arma::dot(constraints, constraints);
+
+  if (gradient == NULL)
+    return objective;
+
+  const arma::vec y = lambda - sigma * constraints;
+
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+
+  // Each thread sums its share of the transpose of the gradient, 2 * R^T S'.
+  std::vector<arma::mat> threadGradients(numThreads);
+  for (size_t t = 0; t < numThreads; ++t)
+    threadGradients[t].zeros(rt.n_rows, rt.n_cols);
+
+  #pragma omp parallel num_threads(numThreads)
   {
-    const double constraint = accu(ais[i] % rrt) - bis[i];
-    const double y = lambda[lambdaOffset + i] - sigma * constraint;
-    s -= y * ais[i];
+#ifdef _OPENMP
+    const size_t thread = (size_t) omp_get_thread_num();
+#else
+    const size_t thread = 0;
+#endif
+
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < numConstraints; ++i)
+    {
+      if (i < numSparse)
+        AddConstraintGradient(threadGradients[thread], sdp.SparseA()[i], rt,
+            -2. * y[i]);
+      else
+        AddConstraintGradient(threadGradients[thread],
+            sdp.DenseA()[i - numSparse], rt, -2. * y[i]);
+    }
   }
+
+  arma::mat gt = std::move(threadGradients[0]);
+  for (size_t t = 1; t < numThreads; ++t)
+    gt += threadGradients[t];
+  AddConstraintGradient(gt, sdp.C(), rt, 2.);
+
+  *gradient = trans(gt);
+  return objective;
 }
 
 template <typename SDPType>
@@ -136,29 +239,7 @@ EvaluateImpl(const LRSDPFunction<SDPType>& function,
              const arma::vec& lambda,
              const double sigma)
 {
-  // We can calculate the entire objective in a smart way.
-  // L(R, y, s) = Tr(C * (R R^T)) -
-  //     sum_{i = 1}^{m} (y_i (Tr(A_i * (R R^T)) - b_i)) +
-  //     (sigma / 2) * sum_{i = 1}^{m} (Tr(A_i * (R R^T)) - b_i)^2
-
-  // Let's start with the objective: Tr(C * (R R^T)).
-  // Simple, possibly slow solution-- see below for optimization opportunity
-  //
-  // TODO: Note that Tr(C^T * (R R^T)) = Tr( (CR)^T * R ), so
-  // multiplying C*R first, and then taking the trace dot should be more memory
-  // efficient
-  //
-  // Similarly for the constraints, taking A*R first should be more efficient
-  const arma::mat rrt = coordinates * trans(coordinates);
-  double objective = accu(function.SDP().C() % rrt);
-
-  // Now each constraint.
-  UpdateObjective(objective, rrt, function.SDP().SparseA(), function.SDP().SparseB(),
-      lambda, 0, sigma);
-  UpdateObjective(objective, rrt, function.SDP().DenseA(), function.SDP().DenseB(), lambda,
-      function.SDP().NumSparseConstraints(), sigma);
-
-  return objective;
+  return LagrangianImpl(function, coordinates, lambda, sigma, NULL);
 }
 
 template <typename SDPType>
@@ -169,22 +250,20 @@ GradientImpl(const LRSDPFunction<SDPType>& function,
              const double sigma,
              arma::mat& gradient)
 {
-  // We can calculate the gradient in a smart way.
-  // L'(R, y, s) = 2 * S' * R
-  //   with
-  // S' = C - sum_{i = 1}^{m} y'_i A_i
-  // y'_i = y_i - sigma * (Trace(A_i * (R R^T)) - b_i)
-  const arma::mat rrt = coordinates * trans(coordinates);
-  arma::mat s(function.SDP().C());
-
-  UpdateGradient(
-      s, rrt, function.SDP().SparseA(), function.SDP().SparseB(),
-      lambda, 0, sigma);
-  UpdateGradient(
-      s, rrt, function.SDP().DenseA(), function.SDP().DenseB(),
-      lambda, function.SDP().NumSparseConstraints(), sigma);
+  LagrangianImpl(function, coordinates, lambda, sigma, &gradient);
+}
 
-  gradient = 2 * s * coordinates;
+template <typename SDPType>
+static inline double
+EvaluateWithGradientImpl(const LRSDPFunction<SDPType>& function,
+                         const arma::mat& coordinates,
+                         const arma::vec& lambda,
+                         const double sigma,
+                         arma::mat& gradient)
+{
+  // The constraints are shared by the objective and the gradient, so they are
+  // only evaluated once.
+  return LagrangianImpl(function, coordinates, lambda, sigma, &gradient);
 }
 
 // Template specializations for function and gradient evaluation.
@@ -220,6 +299,26 @@ inline void AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>>::Gradient(
   GradientImpl(function, coordinates, lambda, sigma, gradient);
 }
 
+template <>
+inline double
+AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const
+{
+  return EvaluateWithGradientImpl(function, coordinates, lambda, sigma,
+      gradient);
+}
+
+template <>
+inline double
+AugLagrangianFunction<LRSDPFunction<SDP<arma::mat>>>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient) const
+{
+  return EvaluateWithGradientImpl(function, coordinates, lambda, sigma,
+      gradient);
+}
+
 }; // namespace optimization
 }; // namespace mlpack
 
@@ -132,17 +132,73 @@ Alpha(const arma::mat& A, const arma::mat& dA, double tau)
  *
  *   AX + XA = H
  *
- * where A, H are symmetric matrices.
+ * where A, H are symmetric matrices, given the eigenvalue decomposition
+ * A = Q diag(evals) Q^T.  As in Lemma 7.2 of [AHO98], in the eigenbasis of A
+ * the equation is diagonal:
  *
- * TODO(stephentu): Note this method current uses arma's builtin arma::syl
- * method, which is overkill for this situation. See Lemma 7.2 of [AHO98] for
- * how to solve this Lyapunov equation using an eigenvalue decomposition of A.
+ *   (Q^T X Q)_ij = (Q^T H Q)_ij / (evals_i + evals_j).
  *
+ * The decomposition of A is computed once per iteration, so each solve is only
+ * a few matrix products (instead of the two Schur decompositions arma::syl()
+ * performs on every call).
+ *
+ * @param X Matrix to store the solution in.
+ * @param Q Eigenvectors of A.
+ * @param denominators Matrix of evals_i + evals_j.
+ * @param H Right hand side.
  */
 static inline void
-SolveLyapunov(arma::mat& X, const arma::mat& A, const arma::mat& H)
+SolveLyapunov(arma::mat& X,
+              const arma::mat& Q,
+              const arma::mat& denominators,
+              const arma::mat& H)
 {
-  arma::syl(X, A, A, -H);
+  X = (Q.t() * H * Q) / denominators;
+  X = Q * X * Q.t();
+}
+
+/**
+ * Compute column j of the Schur complement matrix (2.15)
+ *
+ *   M = A E^(-1) F A^T,
+ *
+ * given the matrix T_j = Q^T X A_j Q, where Z = Q diag(evals) Q^T.  Column j of
+ * E^(-1) F A^T is svec(G_j), where G_j solves Z G_j + G_j Z = X A_j + A_j X;
+ * in the eigenbasis of Z that right hand side is T_j + T_j^T.  Since the svec
+ * inner product is the trace inner product, M_ij = tr(A_i G_j), which only
+ * needs the nonzero entries of each sparse A_i.
+ *
+ * @param T Q^T X A_j Q.
+ * @param Q Eigenvectors of Z.
+ * @param denominators Matrix of evals_i + evals_j.
+ * @param sparseA Sparse constraint matrices.
+ * @param denseA Dense constraint matrices.
+ * @param M Schur complement matrix to store column j in.
+ * @param j Index of the column to compute.
+ */
+static inline void
+SchurComplementColumn(const arma::mat& T,
+                      const arma::mat& Q,
+                      const arma::mat& denominators,
+                      const std::vector<arma::sp_mat>& sparseA,
+                      const std::vector<arma::mat>& denseA,
+                      arma::mat& M,
+                      const size_t j)
+{
+  arma::mat G = (T + T.t()) / denominators;
+  G = Q * G * Q.t();
+
+  for (size_t i = 0; i < sparseA.size(); ++i)
+  {
+    double sum = 0.;
+    for (arma::sp_mat::const_iterator it = sparseA[i].begin();
+         it != sparseA[i].end(); ++it)
+      sum += (*it) * G(it.row(), it.col());
+    M(i, j) = sum;
+  }
+
+  for (size_t i = 0; i < denseA.size(); ++i)
+    M(sparseA.size() + i, j) = arma::accu(denseA[i] % G);
 }
 
 /**
@@ -161,11 +217,13 @@ SolveLyapunov(arma::mat& X, const arma::mat& A, const arma::mat& H)
  *     E  = Z sym I
  *     F  = X sym I
  *
+ * and Z = Q diag(evals) Q^T (E^(-1) is applied with SolveLyapunov()).
  */
 static inline void
 SolveKKTSystem(const arma::sp_mat& Asparse,
                const arma::mat& Adense,
-               const arma::mat& Z,
+               const arma::mat& Q,
+               const arma::mat& denominators,
                const arma::mat& M,
                const arma::mat& F,
                const arma::vec& rp,
@@ -185,7 +243,7 @@ SolveKKTSystem(const arma::sp_mat& Asparse,
 
   // Compute the RHS of (2.12)
   math::Smat(F * rd - rc, Frd_rc_Mat);
-  SolveLyapunov(Einv_Frd_rc_Mat, Z, 2. * Frd_rc_Mat);
+  SolveLyapunov(Einv_Frd_rc_Mat, Q, denominators, 2. * Frd_rc_Mat);
   math::Svec(Einv_Frd_rc_Mat, Einv_Frd_rc);
 
   arma::vec rhs = rp;
@@ -208,7 +266,8 @@ SolveKKTSystem(const arma::sp_mat& Asparse,
   // Compute dx from (2.13)
   math::Smat(F * (rd - Asparse.t() * dysparse - Adense.t() * dydense) - rc,
       Frd_ATdy_rc_Mat);
-  SolveLyapunov(Einv_Frd_ATdy_rc_Mat, Z, 2. * Frd_ATdy_rc_Mat);
+  SolveLyapunov(Einv_Frd_ATdy_rc_Mat, Q, denominators,
+      2. * Frd_ATdy_rc_Mat);
   math::Svec(Einv_Frd_ATdy_rc_Mat, Einv_Frd_ATdy_rc);
   dsx = -Einv_Frd_ATdy_rc;
 
@@ -260,6 +319,37 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
     Adense.row(i) = Aidense.t();
   }
 
+  // The rows (and columns) that each sparse constraint touches, and the
+  // constraint restricted to them.  These only depend on the sparsity pattern,
+  // so they are found once; most sparse constraints (for instance the rank-one
+  // distance constraints of MVU) touch only a few rows.
+  const size_t numSparse = sdp.NumSparseConstraints();
+  std::vector<arma::uvec> supports(numSparse);
+  std::vector<arma::mat> supportA(numSparse);
+  for (size_t i = 0; i < numSparse; i++)
+  {
+    const arma::sp_mat& A = sdp.SparseA()[i];
+    std::vector<size_t> rows;
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it)
+      rows.push_back(it.row());
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    supports[i].set_size(rows.size());
+    for (size_t k = 0; k < rows.size(); k++)
+      supports[i][k] = rows[k];
+
+    supportA[i].zeros(rows.size(), rows.size());
+    for (arma::sp_mat::const_iterator it = A.begin(); it != A.end(); ++it)
+    {
+      const size_t r = std::lower_bound(rows.begin(), rows.end(), it.row()) -
+          rows.begin();
+      const size_t c = std::lower_bound(rows.begin(), rows.end(), it.col()) -
+          rows.begin();
+      supportA[i](r, c) = (*it);
+    }
+  }
+
   typename private_::vectype<typename SDPType::objective_matrix_type>::type sc;
   math::Svec(sdp.C(), sc);
 
@@ -274,15 +364,12 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
   math::Svec(X, sx);
   math::Svec(Z, sz);
 
-  arma::vec rp, rd, rc, gk;
+  arma::vec rp, rd, rc;
 
-  arma::mat Rc, F, Einv_F_AsparseT, Einv_F_AdenseT, Gk,
-            M, DualCheck;
+  arma::mat Rc, F, Q, Xt, denominators, M, DualCheck;
+  arma::vec evals;
 
   rp.set_size(sdp.NumConstraints());
-
-  Einv_F_AsparseT.set_size(n2bar, sdp.NumSparseConstraints());
-  Einv_F_AdenseT.set_size(n2bar, sdp.NumDenseConstraints());
   M.set_size(sdp.NumConstraints(), sdp.NumConstraints());
 
   double primalObj = 0., alpha, beta;
@@ -307,54 +394,40 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
 
     math::SymKronId(X, F);
 
-    // We compute E^(-1) F A^T by solving Lyapunov equations.
-    // See (2.16).
-    for (size_t i = 0; i < sdp.NumSparseConstraints(); i++)
+    // Every E^(-1) below is applied in the eigenbasis of Z; see
+    // SolveLyapunov().
+    if (!arma::eig_sym(evals, Q, Z))
+      Log::Fatal << "PrimalDualSolver::Optimize(): eigendecomposition of Z "
+          << "failed." << std::endl;
+    denominators.set_size(n, n);
+    for (size_t j = 0; j < n; j++)
+      for (size_t i = 0; i < n; i++)
+        denominators(i, j) = evals[i] + evals[j];
+    Xt = Q.t() * X * Q;
+
+    // Form the M = A E^(-1) F A^T matrix (2.15), one column per constraint,
+    // without storing E^(-1) F A^T.  For a sparse constraint A_j which touches
+    // the rows S only, Q^T X A_j Q = (Xt Q_S^T) (A_SS Q_S), which takes
+    // O(n^2 |S|) time; the columns are independent, so they are split across
+    // threads.
+    #pragma omp parallel for schedule(static)
+    for (size_t j = 0; j < sdp.NumConstraints(); j++)
     {
-      SolveLyapunov(Gk, Z, X * sdp.SparseA()[i] + sdp.SparseA()[i] * X);
-      math::Svec(Gk, gk);
-      Einv_F_AsparseT.col(i) = gk;
-    }
-
-    for (size_t i = 0; i < sdp.NumDenseConstraints(); i++)
-    {
-      SolveLyapunov(Gk, Z, X * sdp.DenseA()[i] + sdp.DenseA()[i] * X);
-      math::Svec(Gk, gk);
-      Einv_F_AdenseT.col(i) = gk;
-    }
-
-    // Form the M = A E^(-1) F A^T matrix (2.15)
-    //
-    // Since we split A up into its sparse and dense components,
-    // we have to handle each block separately.
-    if (sdp.NumSparseConstraints())
-    {
-      M.submat(arma::span(0, sdp.NumSparseConstraints() - 1),
-               arma::span(0, sdp.NumSparseConstraints() - 1)) =
-          Asparse * Einv_F_AsparseT;
-      if (sdp.NumDenseConstraints())
+      arma::mat T;
+      if (j < numSparse)
       {
-        M.submat(arma::span(0, sdp.NumSparseConstraints() - 1),
-                 arma::span(sdp.NumSparseConstraints(),
-                            sdp.NumConstraints() - 1)) =
-            Asparse * Einv_F_AdenseT;
+        arma::mat QS(supports[j].n_elem, n);
+        for (size_t k = 0; k < supports[j].n_elem; k++)
+          QS.row(k) = Q.row(supports[j][k]);
+        T = (Xt * QS.t()) * (supportA[j] * QS);
       }
-    }
-    if (sdp.NumDenseConstraints())
-    {
-      if (sdp.NumSparseConstraints())
+      else
       {
-        M.submat(arma::span(sdp.NumSparseConstraints(),
-                            sdp.NumConstraints() - 1),
-                 arma::span(0,
-                            sdp.NumSparseConstraints() - 1)) =
-            Adense * Einv_F_AsparseT;
+        T = Xt * (Q.t() * sdp.DenseA()[j - numSparse] * Q);
       }
-      M.submat(arma::span(sdp.NumSparseConstraints(),
-                          sdp.NumConstraints() - 1),
-               arma::span(sdp.NumSparseConstraints(),
-                          sdp.NumConstraints() - 1)) =
-          Adense * Einv_F_AdenseT;
+
+      SchurComplementColumn(T, Q, denominators, sdp.SparseA(), sdp.DenseA(),
+          M, j);
     }
 
     const double sxdotsz = arma::dot(sx, sz);
@@ -366,8 +439,8 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
     // This solves step (1) of Section 7, the "predictor" step.
     Rc = -0.5*(X*Z + Z*X);
     math::Svec(Rc, rc);
-    SolveKKTSystem(Asparse, Adense, Z, M, F, rp, rd, rc, dsx, dysparse, dydense,
-        dsz);
+    SolveKKTSystem(Asparse, Adense, Q, denominators, M, F, rp, rd, rc, dsx,
+        dysparse, dydense, dsz);
     math::Smat(dsx, dX);
     math::Smat(dsz, dZ);
 
@@ -383,8 +456,8 @@ PrimalDualSolver<SDPType>::Optimize(arma::mat& X,
     // Step (3), the "corrector" step.
     Rc = mu*arma::eye<arma::mat>(n, n) - 0.5*(X*Z + Z*X + dX*dZ + dZ*dX);
     math::Svec(Rc, rc);
-    SolveKKTSystem(Asparse, Adense, Z, M, F, rp, rd, rc, dsx, dysparse, dydense,
-        dsz);
+    SolveKKTSystem(Asparse, Adense, Q, denominators, M, F, rp, rd, rc, dsx,
+        dysparse, dydense, dsz);
     math::Smat(dsx, dX);
     math::Smat(dsz, dZ);
     alpha = Alpha(X, dX, tau);
@@ -8,6 +8,7 @@
 #define __MLPACK_CORE_OPTIMIZERS_SGD_SGD_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/function/evaluate_with_gradient.hpp>
 
 namespace mlpack {
 namespace optimization {
@@ -64,6 +65,17 @@ namespace optimization {
  * objective function on the first point in the dataset (presumably, the dataset
  * is held internally in the DecomposableFunctionType).
  *
+ * If the DecomposableFunctionType also implements
+ *
+ *   double EvaluateWithGradient(const arma::mat& coordinates,
+ *                               const size_t i,
+ *                               arma::mat& gradient);
+ *
+ * (see HasSeparableEvaluateWithGradient), then it is used at each iteration
+ * instead of Gradient() and Evaluate().  In that case the objective of each
+ * function is taken at the point before the step instead of after it, so the
+ * objective of a pass (used for the tolerance) lags one step behind.
+ *
  * @tparam DecomposableFunctionType Decomposable objective function type to be
  *     minimized.
  */
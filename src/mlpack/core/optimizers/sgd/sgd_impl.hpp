@@ -57,8 +57,8 @@ double SGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
     if ((currentFunction % numFunctions) == 0)
     {
       // Output current objective function.
-      Log::Info << "SGD: iteration " << i << ", objective " << overallObjective
-          << "." << std::endl;
+      MLPACK_LOG_INFO << "SGD: iteration " << i << ", objective "
+          << overallObjective << "." << std::endl;
 
       if (std::isnan(overallObjective) || std::isinf(overallObjective))
       {
@@ -83,21 +83,30 @@ double SGD<DecomposableFunctionType>::Optimize(arma::mat& iterate)
         visitationOrder = arma::shuffle(visitationOrder);
     }
 
-    // Evaluate the gradient for this iteration.
-    if (shuffle)
-      function.Gradient(iterate, visitationOrder[currentFunction], gradient);
-    else
-      function.Gradient(iterate, currentFunction, gradient);
+    const size_t visitedFunction = shuffle ?
+        (size_t) visitationOrder[currentFunction] : currentFunction;
 
-    // And update the iterate.
-    iterate -= stepSize * gradient;
+    if (HasSeparableEvaluateWithGradient<DecomposableFunctionType>::value)
+    {
+      // Evaluate the objective and the gradient for this iteration at once, and
+      // add the objective to the overall objective function.
+      overallObjective += EvaluateWithGradient(function, iterate,
+          visitedFunction, gradient);
 
-    // Now add that to the overall objective function.
-    if (shuffle)
-      overallObjective += function.Evaluate(iterate,
-          visitationOrder[currentFunction]);
+      // And update the iterate.
+      iterate -= stepSize * gradient;
+    }
     else
-      overallObjective += function.Evaluate(iterate, currentFunction);
+    {
+      // Evaluate the gradient for this iteration.
+      function.Gradient(iterate, visitedFunction, gradient);
+
+      // And update the iterate.
+      iterate -= stepSize * gradient;
+
+      // Now add that to the overall objective function.
+      overallObjective += function.Evaluate(iterate, visitedFunction);
+    }
   }
 
   Log::Info << "SGD: maximum iterations (" << maxIterations << ") reached; "
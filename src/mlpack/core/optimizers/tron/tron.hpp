@@ -0,0 +1,164 @@
+/**
+ * @file tron.hpp
+ * @author Ryan Curtin
+ *
+ * The trust region Newton (TRON) optimizer, which minimizes a twice
+ * differentiable function with truncated Newton steps computed by conjugate
+ * gradient.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_TRON_TRON_HPP
+#define __MLPACK_CORE_OPTIMIZERS_TRON_TRON_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/function/evaluate_with_gradient.hpp>
+#include <mlpack/core/optimizers/function/hessian_vector_product.hpp>
+
+namespace mlpack {
+namespace optimization {
+
+/**
+ * The trust region Newton optimizer of Lin, Weng and Keerthi, as used by
+ * LIBLINEAR.  Each iteration approximately minimizes the quadratic model of the
+ * function around the current point, inside a ball of radius delta (the trust
+ * region), with conjugate gradient; the step is taken if it decreases the
+ * function enough, and delta grows or shrinks depending on how well the model
+ * predicted the decrease.  Conjugate gradient needs the Hessian only through
+ * products with a direction, so the Hessian is never formed.  On smooth,
+ * well-conditioned problems (like logistic regression), this typically
+ * converges in far fewer passes over the data than L-BFGS.
+ *
+ * @code
+ * @article{lin2008trust,
+ *   title={Trust region {N}ewton method for logistic regression},
+ *   author={Lin, C.-J. and Weng, R.C. and Keerthi, S.S.},
+ *   journal={Journal of Machine Learning Research},
+ *   volume={9},
+ *   pages={627--650},
+ *   year={2008}
+ * }
+ * @endcode
+ *
+ * A function which can be optimized by this class must implement the following
+ * methods:
+ *
+ *  - double Evaluate(const arma::mat& coordinates);
+ *  - void Gradient(const arma::mat& coordinates, arma::mat& gradient);
+ *  - arma::mat& GetInitialPoint();
+ *
+ * If the function also implements
+ *
+ *  - void HessianVectorProduct(const arma::mat& coordinates,
+ *                              const arma::mat& v,
+ *                              arma::mat& hv);
+ *
+ * (see HasHessianVectorProduct), then it is used for the products of the
+ * Hessian and the conjugate gradient directions; otherwise they are
+ * approximated by finite differences of the gradient, which costs one gradient
+ * evaluation per conjugate gradient iteration.  An EvaluateWithGradient()
+ * function is used if it is available (see HasEvaluateWithGradient).
+ */
+template<typename FunctionType>
+class TRON
+{
+ public:
+  /**
+   * Initialize the TRON optimizer.  Store a reference to the function we will
+   * be optimizing.  Default values are given for every parameter.
+   *
+   * @param function Instance of function to be optimized.
+   * @param maxIterations Maximum number of (Newton) iterations for the
+   *     optimization (0 means no limit).
+   * @param tolerance The optimization stops when the norm of the gradient is
+   *     less than tolerance times the norm of the gradient at the starting
+   *     point.
+   * @param maxCGIterations Maximum number of conjugate gradient iterations for
+   *     each step (0 means the number of coordinates).
+   */
+  TRON(FunctionType& function,
+       const size_t maxIterations = 1000,
+       const double tolerance = 1e-6,
+       const size_t maxCGIterations = 0);
+
+  /**
+   * Use TRON to optimize the given function, starting at the given iterate
+   * point and finding the minimum.  The given starting point will be modified
+   * to store the finishing point of the algorithm, and the final objective
+   * value is returned.
+   *
+   * @param iterate Starting point (will be modified).
+   * @return Objective value of the final point.
+   */
+  double Optimize(arma::mat& iterate);
+
+  //! Return the function that is being optimized.
+  const FunctionType& Function() const { return function; }
+  //! Modify the function that is being optimized.
+  FunctionType& Function() { return function; }
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the relative gradient norm tolerance.
+  double Tolerance() const { return tolerance; }
+  //! Modify the relative gradient norm tolerance.
+  double& Tolerance() { return tolerance; }
+
+  //! Get the maximum number of conjugate gradient iterations of each step.
+  size_t MaxCGIterations() const { return maxCGIterations; }
+  //! Modify the maximum number of conjugate gradient iterations of each step.
+  size_t& MaxCGIterations() { return maxCGIterations; }
+
+  //! Get the number of Newton iterations of the last optimization.
+  size_t Iterations() const { return iterations; }
+  //! Get the total number of conjugate gradient iterations of the last
+  //! optimization.
+  size_t CGIterations() const { return cgIterations; }
+
+  // Convert the object into a string.
+  std::string ToString() const;
+
+ private:
+  //! Internal reference to the function we are optimizing.
+  FunctionType& function;
+
+  //! Maximum number of iterations.
+  size_t maxIterations;
+  //! Relative gradient norm tolerance.
+  double tolerance;
+  //! Maximum number of conjugate gradient iterations of each step.
+  size_t maxCGIterations;
+
+  //! Number of Newton iterations of the last optimization.
+  size_t iterations;
+  //! Number of conjugate gradient iterations of the last optimization.
+  size_t cgIterations;
+
+  /**
+   * Approximately minimize the quadratic model g' s + s' H s / 2 over the
+   * steps s with norm at most delta, with conjugate gradient.  Conjugate
+   * gradient stops when the residual is small enough, or when the step
+   * reaches the boundary of the trust region (also when it finds a direction
+   * of negative curvature).
+   *
+   * @param iterate Current point.
+   * @param gradient Gradient at the current point.
+   * @param delta Radius of the trust region.
+   * @param step Matrix to store the step in.
+   * @param residual Matrix to store the residual -g - H s in.
+   * @return Number of conjugate gradient iterations.
+   */
+  size_t TrustRegionCG(const arma::mat& iterate,
+                       const arma::mat& gradient,
+                       const double delta,
+                       arma::mat& step,
+                       arma::mat& residual);
+};
+
+} // namespace optimization
+} // namespace mlpack
+
+#include "tron_impl.hpp"
+
+#endif
@@ -0,0 +1,201 @@
+/**
+ * @file tron_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the trust region Newton (TRON) optimizer.
+ */
+#ifndef __MLPACK_CORE_OPTIMIZERS_TRON_TRON_IMPL_HPP
+#define __MLPACK_CORE_OPTIMIZERS_TRON_TRON_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "tron.hpp"
+
+namespace mlpack {
+namespace optimization {
+
+template<typename FunctionType>
+TRON<FunctionType>::TRON(FunctionType& function,
+                         const size_t maxIterations,
+                         const double tolerance,
+                         const size_t maxCGIterations) :
+    function(function),
+    maxIterations(maxIterations),
+    tolerance(tolerance),
+    maxCGIterations(maxCGIterations),
+    iterations(0),
+    cgIterations(0)
+{
+  // Nothing to do.
+}
+
+template<typename FunctionType>
+double TRON<FunctionType>::Optimize(arma::mat& iterate)
+{
+  // The constants of the acceptance of steps and of the update of the trust
+  // region radius, from LIBLINEAR.
+  const double eta0 = 1e-4, eta1 = 0.25, eta2 = 0.75;
+  const double sigma1 = 0.25, sigma2 = 0.5, sigma3 = 4.0;
+
+  iterations = 0;
+  cgIterations = 0;
+
+  arma::mat gradient;
+  double objective = EvaluateWithGradient(function, iterate, gradient);
+
+  const double gradientNorm0 = arma::norm(gradient, "fro");
+  double gradientNorm = gradientNorm0;
+  double delta = gradientNorm0;
+
+  arma::mat step, residual, newIterate, newGradient;
+  while (maxIterations == 0 || iterations < maxIterations)
+  {
+    if (gradientNorm <= tolerance * gradientNorm0)
+    {
+      Log::Debug << "TRON gradient norm small enough (terminating "
+          << "successfully)." << std::endl;
+      break;
+    }
+
+    cgIterations += TrustRegionCG(iterate, gradient, delta, step, residual);
+
+    // The decrease that the quadratic model predicts, and the actual decrease.
+    const double gs = arma::accu(gradient % step);
+    const double predicted = -0.5 * (gs - arma::accu(step % residual));
+    newIterate = iterate + step;
+    const double newObjective = EvaluateWithGradient(function, newIterate,
+        newGradient);
+    const double actual = objective - newObjective;
+
+    // The first step also sets the scale of the trust region.
+    const double stepNorm = arma::norm(step, "fro");
+    if (iterations == 0)
+      delta = std::min(delta, stepNorm);
+
+    // Minimize the quadratic that interpolates the function along the step,
+    // to choose the new radius.
+    double alpha;
+    if (newObjective - objective - gs <= 0)
+      alpha = sigma3;
+    else
+      alpha = std::max(sigma1, -0.5 * (gs / (newObjective - objective - gs)));
+
+    if (actual < eta0 * predicted)
+      delta = std::min(std::max(alpha, sigma1) * stepNorm, sigma2 * delta);
+    else if (actual < eta1 * predicted)
+      delta = std::max(sigma1 * delta, std::min(alpha * stepNorm,
+          sigma2 * delta));
+    else if (actual < eta2 * predicted)
+      delta = std::max(sigma1 * delta, std::min(alpha * stepNorm,
+          sigma3 * delta));
+    else
+      delta = std::max(delta, std::min(alpha * stepNorm, sigma3 * delta));
+
+    ++iterations;
+
+    MLPACK_LOG_DEBUG << "TRON iteration " << iterations << "; objective "
+        << newObjective << ", actual decrease " << actual << ", predicted "
+        << "decrease " << predicted << ", trust region radius " << delta
+        << "." << std::endl;
+
+    // Take the step if it decreased the function enough.
+    if (actual > eta0 * predicted)
+    {
+      iterate.swap(newIterate);
+      gradient.swap(newGradient);
+      objective = newObjective;
+      gradientNorm = arma::norm(gradient, "fro");
+    }
+
+    if (actual <= 0 && predicted <= 0)
+    {
+      Log::Debug << "TRON cannot decrease the objective further (terminating)."
+          << std::endl;
+      break;
+    }
+
+    if (std::abs(actual) <= 1e-12 * std::abs(objective) &&
+        std::abs(predicted) <= 1e-12 * std::abs(objective))
+    {
+      Log::Debug << "TRON objective stable (terminating successfully)."
+          << std::endl;
+      break;
+    }
+  }
+
+  return objective;
+}
+
+template<typename FunctionType>
+size_t TRON<FunctionType>::TrustRegionCG(const arma::mat& iterate,
+                                         const arma::mat& gradient,
+                                         const double delta,
+                                         arma::mat& step,
+                                         arma::mat& residual)
+{
+  const size_t maxCG = (maxCGIterations == 0) ? iterate.n_elem :
+      maxCGIterations;
+  const double cgTolerance = 0.1 * arma::norm(gradient, "fro");
+
+  step.zeros(iterate.n_rows, iterate.n_cols);
+  residual = -gradient;
+  arma::mat direction = residual;
+  arma::mat hd;
+  double rr = arma::accu(residual % residual);
+
+  size_t cgIteration = 0;
+  while (cgIteration < maxCG && std::sqrt(rr) > cgTolerance)
+  {
+    ++cgIteration;
+    HessianVectorProduct(function, iterate, gradient, direction, hd);
+    const double dhd = arma::accu(direction % hd);
+
+    if (dhd > 0)
+    {
+      const double alpha = rr / dhd;
+      const arma::mat newStep = step + alpha * direction;
+      if (arma::norm(newStep, "fro") <= delta)
+      {
+        step = newStep;
+        residual -= alpha * hd;
+        const double newRR = arma::accu(residual % residual);
+        direction = residual + (newRR / rr) * direction;
+        rr = newRR;
+        continue;
+      }
+    }
+
+    // The step leaves the trust region, or the direction has negative
+    // curvature; either way, follow the direction to the boundary and stop.
+    const double sd = arma::accu(step % direction);
+    const double ss = arma::accu(step % step);
+    const double dd = arma::accu(direction % direction);
+    const double rad = std::sqrt(sd * sd + dd * (delta * delta - ss));
+    const double tau = (sd >= 0) ? (delta * delta - ss) / (sd + rad) :
+        (rad - sd) / dd;
+    step += tau * direction;
+    residual -= tau * hd;
+    break;
+  }
+
+  return cgIteration;
+}
+
+// Convert the object to a string.
+template<typename FunctionType>
+std::string TRON<FunctionType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "TRON [" << this << "]" << std::endl;
+  convert << "  Function:" << std::endl;
+  convert << util::Indent(function.ToString(), 2);
+  convert << "  Maximum iterations: " << maxIterations << std::endl;
+  convert << "  Tolerance: " << tolerance << std::endl;
+  convert << "  Maximum conjugate gradient iterations: " << maxCGIterations
+      << std::endl;
+  return convert.str();
+}
+
+} // namespace optimization
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,140 @@
+/**
+ * @file best_first_traverser.hpp
+ * @author Ryan Curtin
+ *
+ * A single-tree traverser that expands the nodes of a tree in best-first order
+ * using a priority queue, optionally stopping after a given number of nodes
+ * have been visited.
+ */
+#ifndef __MLPACK_CORE_TREE_BEST_FIRST_TRAVERSER_HPP
+#define __MLPACK_CORE_TREE_BEST_FIRST_TRAVERSER_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/tree_traits.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+#include <queue>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * A single-tree traverser that, instead of recursing depth-first (ordering only
+ * the children of each node by score), keeps every node it has scored but not
+ * yet expanded in a priority queue and always expands the node with the best
+ * (lowest) score next.  For small k this finds good candidates early, so later
+ * nodes are pruned more often.  Base cases are evaluated for the points held
+ * by each expanded node, so this works with any tree whose points are held by
+ * the nodes they are in: BinarySpaceTree, RectangleTree and CoverTree.  For
+ * trees whose first point is the centroid (i.e. cover trees), the base case
+ * with that point is evaluated when the node is scored, and the point of a
+ * self-child is not evaluated again.
+ *
+ * If a visit budget is given, the traversal stops after that many nodes have
+ * been expanded, and the nodes left in the queue are counted as pruned.  The
+ * rules then hold the best results found so far, so the traverser can be used
+ * for anytime approximate search.
+ *
+ * @tparam TreeType Type of tree to traverse.
+ * @tparam RuleType Type of rules to traverse the tree with.
+ */
+template<typename TreeType, typename RuleType>
+class BestFirstTraverser
+{
+ public:
+  /**
+   * Instantiate the best-first traverser with the given rule set and,
+   * optionally, the maximum number of nodes to expand for each query point.
+   *
+   * @param rule Rules to traverse the tree with.
+   * @param maxVisits Maximum number of nodes to expand for each query point (0
+   *     means there is no limit).
+   */
+  BestFirstTraverser(RuleType& rule, const size_t maxVisits = 0);
+
+  /**
+   * Traverse the tree with the given point.
+   *
+   * @param queryIndex The index of the point in the query set which is being
+   *     used as the query point.
+   * @param referenceNode The tree node to be traversed.
+   */
+  void Traverse(const size_t queryIndex, TreeType& referenceNode);
+
+  //! Get the maximum number of nodes to expand for each query point.
+  size_t MaxVisits() const { return maxVisits; }
+  //! Modify the maximum number of nodes to expand for each query point (0
+  //! means there is no limit).
+  size_t& MaxVisits() { return maxVisits; }
+
+  //! Get the number of prunes.
+  size_t NumPrunes() const { return numPrunes; }
+  //! Modify the number of prunes.
+  size_t& NumPrunes() { return numPrunes; }
+
+  //! Get the number of nodes which have been expanded.
+  size_t NumVisited() const { return numVisited; }
+  //! Modify the number of nodes which have been expanded.
+  size_t& NumVisited() { return numVisited; }
+
+  //! The traversal statistics policy (see TraversalStatisticsPolicy).
+  typedef typename TraversalStatisticsPolicy<RuleType>::Type
+      TraversalStatisticsType;
+
+  //! Get the statistics recorded during traversal (with the default policy,
+  //! nothing is recorded).
+  const TraversalStatisticsType& Statistics() const { return statistics; }
+
+ private:
+  //! An entry of the priority queue: a node and its score.
+  struct QueueEntry
+  {
+    //! The node to be expanded.
+    TreeType* node;
+    //! The score of the node.
+    double score;
+
+    //! Comparison operator; the best (lowest) score is at the top of the queue.
+    bool operator<(const QueueEntry& other) const
+    {
+      return (score > other.score);
+    }
+  };
+
+  /**
+   * Score the given node and, unless it can be pruned, add it to the queue.
+   * If the first point of the node is its centroid, the base case with that
+   * point is evaluated here.
+   *
+   * @param queryIndex The index of the query point.
+   * @param node The node to score.
+   * @param parent The parent of the node (NULL for the root).
+   * @param queue The queue of nodes to be expanded.
+   */
+  void ScoreNode(const size_t queryIndex,
+                 TreeType& node,
+                 const TreeType* parent,
+                 std::priority_queue<QueueEntry>& queue);
+
+  //! Reference to the rules with which the tree will be traversed.
+  RuleType& rule;
+
+  //! The maximum number of nodes to expand for each query point.
+  size_t maxVisits;
+
+  //! The statistics recorded during traversal.
+  TraversalStatisticsType statistics;
+
+  //! The number of nodes which have been pruned during traversal.
+  size_t numPrunes;
+
+  //! The number of nodes which have been expanded during traversal.
+  size_t numVisited;
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "best_first_traverser_impl.hpp"
+
+#endif
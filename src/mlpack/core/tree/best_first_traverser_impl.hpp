@@ -0,0 +1,113 @@
+/**
+ * @file best_first_traverser_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the best-first single-tree traverser.
+ */
+#ifndef __MLPACK_CORE_TREE_BEST_FIRST_TRAVERSER_IMPL_HPP
+#define __MLPACK_CORE_TREE_BEST_FIRST_TRAVERSER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "best_first_traverser.hpp"
+
+namespace mlpack {
+namespace tree {
+
+template<typename TreeType, typename RuleType>
+BestFirstTraverser<TreeType, RuleType>::BestFirstTraverser(
+    RuleType& rule,
+    const size_t maxVisits) :
+    rule(rule),
+    maxVisits(maxVisits),
+    numPrunes(0),
+    numVisited(0)
+{ /* Nothing to do. */ }
+
+template<typename TreeType, typename RuleType>
+void BestFirstTraverser<TreeType, RuleType>::Traverse(
+    const size_t queryIndex,
+    TreeType& referenceNode)
+{
+  std::priority_queue<QueueEntry> queue;
+  ScoreNode(queryIndex, referenceNode, NULL, queue);
+
+  size_t visits = 0;
+  while (!queue.empty())
+  {
+    // Once the budget is spent, everything that is left is pruned.
+    if (maxVisits != 0 && visits == maxVisits)
+    {
+      numPrunes += queue.size();
+      return;
+    }
+
+    const QueueEntry entry = queue.top();
+    queue.pop();
+    TreeType& node = *entry.node;
+
+    // The bound may have improved since the node was scored.
+    if (statistics.Rescore(rule, queryIndex, node, entry.score) == DBL_MAX)
+    {
+      ++numPrunes;
+      continue;
+    }
+
+    ++visits;
+    ++numVisited;
+
+    // Evaluate the points held by this node (if the first point is the
+    // centroid, it was evaluated when the node was scored).
+    const size_t first = TreeTraits<TreeType>::FirstPointIsCentroid ? 1 : 0;
+    for (size_t i = first; i < node.NumPoints(); ++i)
+      rule.BaseCase(queryIndex, node.Point(i));
+    if (node.NumPoints() > first)
+      statistics.BaseCases(node, node.NumPoints() - first);
+
+    for (size_t i = 0; i < node.NumChildren(); ++i)
+      ScoreNode(queryIndex, node.Child(i), &node, queue);
+  }
+}
+
+template<typename TreeType, typename RuleType>
+void BestFirstTraverser<TreeType, RuleType>::ScoreNode(
+    const size_t queryIndex,
+    TreeType& node,
+    const TreeType* parent,
+    std::priority_queue<QueueEntry>& queue)
+{
+  // A self-child holds the point of its parent, which has been evaluated
+  // already, so a self-leaf holds nothing new.
+  const bool selfChild = TreeTraits<TreeType>::HasSelfChildren &&
+      (parent != NULL) && (node.Point(0) == parent->Point(0));
+  if (selfChild && node.NumChildren() == 0)
+  {
+    ++numPrunes;
+    return;
+  }
+
+  QueueEntry entry;
+  entry.node = &node;
+  entry.score = statistics.Score(rule, queryIndex, node);
+  if (entry.score == DBL_MAX)
+  {
+    ++numPrunes;
+    return;
+  }
+
+  // If the first point is the centroid, the rules may have evaluated the base
+  // case with it while scoring the node, so evaluate it now; this way it is
+  // not evaluated a second time (NeighborSearchRules skips a base case that is
+  // the same as the last one).
+  if (TreeTraits<TreeType>::FirstPointIsCentroid && !selfChild)
+  {
+    rule.BaseCase(queryIndex, node.Point(0));
+    statistics.BaseCases(node, 1);
+  }
+
+  queue.push(entry);
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
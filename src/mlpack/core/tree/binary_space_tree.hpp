@@ -11,6 +11,7 @@
 #include "bounds.hpp"
 #include "binary_space_tree/midpoint_split.hpp"
 #include "binary_space_tree/mean_split.hpp"
+#include "binary_space_tree/vp_tree_split.hpp"
 #include "binary_space_tree/binary_space_tree.hpp"
 #include "binary_space_tree/single_tree_traverser.hpp"
 #include "binary_space_tree/single_tree_traverser_impl.hpp"
@@ -20,5 +21,6 @@
 #include "binary_space_tree/breadth_first_dual_tree_traverser_impl.hpp"
 #include "binary_space_tree/traits.hpp"
 #include "binary_space_tree/typedef.hpp"
+#include "binary_space_tree/flat_binary_space_tree.hpp"
 
 #endif
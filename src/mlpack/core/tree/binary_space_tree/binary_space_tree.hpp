@@ -8,7 +8,9 @@
 
 #include <mlpack/core.hpp>
 
+#include "../bounds.hpp"
 #include "../statistic.hpp"
+#include "../queue_dual_tree_traverser.hpp"
 #include "midpoint_split.hpp"
 
 namespace mlpack {
@@ -91,6 +93,18 @@ class BinarySpaceTree
   template<typename RuleType>
   class BreadthFirstDualTreeTraverser;
 
+  //! A dual-tree traverser that expands the node combinations breadth-first;
+  //! see queue_dual_tree_traverser.hpp.
+  template<typename RuleType>
+  using LevelOrderDualTreeTraverser =
+      QueueDualTreeTraverser<BinarySpaceTree, RuleType, false>;
+
+  //! A dual-tree traverser that expands the node combinations in order of
+  //! their scores; see queue_dual_tree_traverser.hpp.
+  template<typename RuleType>
+  using PrioritizedDualTreeTraverser =
+      QueueDualTreeTraverser<BinarySpaceTree, RuleType, true>;
+
   /**
    * Construct this as the root node of a binary space tree using the given
    * dataset.  This will copy the input matrix; if you don't want this, consider
@@ -453,6 +467,13 @@ class BinarySpaceTree
   void Center(arma::vec& center) { bound.Center(center); }
 
  private:
+  /**
+   * Nodes with at least this many points build their children in separate
+   * OpenMP tasks (if mlpack is compiled with OpenMP).  Smaller nodes are built
+   * serially, since the overhead of a task would outweigh the work.
+   */
+  static const size_t ParallelBuildThreshold = 10000;
+
   /**
    * Splits the current node, assigning its left and right children recursively.
    *
@@ -474,6 +495,33 @@ class BinarySpaceTree
                  const size_t maxLeafSize,
                  SplitType<BoundType<MetricType>, MatType>& splitter);
 
+  /**
+   * Expand the bound of this node (which is given) to contain all of its
+   * points.  The overloads below handle bound types that need extra work.
+   *
+   * @param boundToUpdate The bound of this node.
+   */
+  template<typename BoundType2>
+  void ExpandBound(BoundType2& boundToUpdate);
+
+  /**
+   * Expand the hyperrectangle bound of this node to contain all of its points.
+   * For large nodes, the points are scanned in parallel chunks; merging tight
+   * bounds is exact, so the bound is the same as one calculated serially.
+   *
+   * @param boundToUpdate The bound of this node.
+   */
+  void ExpandBound(bound::HRectBound<MetricType>& boundToUpdate);
+
+  /**
+   * Expand the hollow ball bound of this node to contain all of its points.
+   * Unless this is the root, the bound is first restricted to a shell around
+   * the center of the parent's bound (the vantage point of the parent).
+   *
+   * @param boundToUpdate The bound of this node.
+   */
+  void ExpandBound(bound::HollowBallBound<MetricType>& boundToUpdate);
+
  protected:
   /**
    * A default constructor.  This is meant to only be used with
@@ -14,6 +14,10 @@
 #include <mlpack/core/util/string_util.hpp>
 #include <queue>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace tree {
 
@@ -632,9 +636,25 @@ void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
     SplitNode(const size_t maxLeafSize,
               SplitType<BoundType<MetricType>, MatType>& splitter)
 {
+#ifdef _OPENMP
+  // The root of a large tree starts a team of threads, and the rest of the
+  // tree is built by tasks run by that team.  If we are already in a parallel
+  // region, the tasks are run by the enclosing team instead.
+  if (parent == NULL && count >= ParallelBuildThreshold && !omp_in_parallel() &&
+      omp_get_max_threads() > 1)
+  {
+    #pragma omp parallel
+    {
+      #pragma omp single
+      SplitNode(maxLeafSize, splitter);
+    }
+    return;
+  }
+#endif
+
   // We need to expand the bounds of this node properly.
   if (count > 0)
-    bound |= dataset->cols(begin, begin + count - 1);
+    ExpandBound(bound);
 
   // Calculate the furthest descendant distance.
   furthestDescendantDistance = 0.5 * bound.Diameter();
@@ -659,11 +679,20 @@ void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
     return;
 
   // Now that we know the split column, we will recursively split the children
-  // by calling their constructors (which perform this splitting process).
-  left = new BinarySpaceTree(this, begin, splitCol - begin, splitter,
+  // by calling their constructors (which perform this splitting process).  The
+  // children hold disjoint ranges of points, so large children can be built in
+  // separate tasks without changing the result.  The splitter is passed by
+  // pointer, so that each task refers to the same object.
+  SplitType<BoundType<MetricType>, MatType>* splitterPtr = &splitter;
+  const bool spawn = (count >= ParallelBuildThreshold);
+
+  #pragma omp task if(spawn) shared(splitterPtr)
+  left = new BinarySpaceTree(this, begin, splitCol - begin, *splitterPtr,
       maxLeafSize);
+  #pragma omp task if(spawn) shared(splitterPtr)
   right = new BinarySpaceTree(this, splitCol, begin + count - splitCol,
-      splitter, maxLeafSize);
+      *splitterPtr, maxLeafSize);
+  #pragma omp taskwait
 
   // Calculate parent distances for those two nodes.
   arma::vec center, leftCenter, rightCenter;
@@ -689,10 +718,24 @@ SplitNode(std::vector<size_t>& oldFromNew,
           const size_t maxLeafSize,
           SplitType<BoundType<MetricType>, MatType>& splitter)
 {
-  // This should be a single function for Bound.
+#ifdef _OPENMP
+  // The root of a large tree starts a team of threads, and the rest of the
+  // tree is built by tasks run by that team.
+  if (parent == NULL && count >= ParallelBuildThreshold && !omp_in_parallel() &&
+      omp_get_max_threads() > 1)
+  {
+    #pragma omp parallel
+    {
+      #pragma omp single
+      SplitNode(oldFromNew, maxLeafSize, splitter);
+    }
+    return;
+  }
+#endif
+
   // We need to expand the bounds of this node properly.
   if (count > 0)
-    bound |= dataset->cols(begin, begin + count - 1);
+    ExpandBound(bound);
 
   // Calculate the furthest descendant distance.
   furthestDescendantDistance = 0.5 * bound.Diameter();
@@ -717,11 +760,21 @@ SplitNode(std::vector<size_t>& oldFromNew,
     return;
 
   // Now that we know the split column, we will recursively split the children
-  // by calling their constructors (which perform this splitting process).
-  left = new BinarySpaceTree(this, begin, splitCol - begin, oldFromNew,
-      splitter, maxLeafSize);
+  // by calling their constructors (which perform this splitting process).  Each
+  // child only permutes its own range of oldFromNew, so large children can be
+  // built in separate tasks and oldFromNew is the same as if the tree were
+  // built serially.
+  std::vector<size_t>* oldFromNewPtr = &oldFromNew;
+  SplitType<BoundType<MetricType>, MatType>* splitterPtr = &splitter;
+  const bool spawn = (count >= ParallelBuildThreshold);
+
+  #pragma omp task if(spawn) shared(oldFromNewPtr, splitterPtr)
+  left = new BinarySpaceTree(this, begin, splitCol - begin, *oldFromNewPtr,
+      *splitterPtr, maxLeafSize);
+  #pragma omp task if(spawn) shared(oldFromNewPtr, splitterPtr)
   right = new BinarySpaceTree(this, splitCol, begin + count - splitCol,
-      oldFromNew, splitter, maxLeafSize);
+      *oldFromNewPtr, *splitterPtr, maxLeafSize);
+  #pragma omp taskwait
 
   // Calculate parent distances for those two nodes.
   arma::vec center, leftCenter, rightCenter;
@@ -736,6 +789,72 @@ SplitNode(std::vector<size_t>& oldFromNew,
   right->ParentDistance() = rightParentDistance;
 }
 
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename BoundType2>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+    ExpandBound(BoundType2& boundToUpdate)
+{
+  boundToUpdate |= dataset->cols(begin, begin + count - 1);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+    ExpandBound(bound::HRectBound<MetricType>& boundToUpdate)
+{
+#ifdef _OPENMP
+  // Only nodes near the top of a large tree are worth scanning in parallel.
+  const size_t chunks = omp_in_parallel() ? (size_t) omp_get_num_threads() : 1;
+  if (chunks > 1 && count >= chunks * ParallelBuildThreshold)
+  {
+    std::vector<bound::HRectBound<MetricType> > chunkBounds(chunks,
+        bound::HRectBound<MetricType>(dataset->n_rows));
+    const size_t chunkSize = (count + chunks - 1) / chunks;
+    for (size_t c = 0; c < chunks; ++c)
+    {
+      const size_t chunkBegin = begin + c * chunkSize;
+      const size_t chunkEnd = std::min(chunkBegin + chunkSize, begin + count);
+
+      #pragma omp task shared(chunkBounds)
+      chunkBounds[c] |= dataset->cols(chunkBegin, chunkEnd - 1);
+    }
+    #pragma omp taskwait
+
+    for (size_t c = 0; c < chunks; ++c)
+      boundToUpdate |= chunkBounds[c];
+    return;
+  }
+#endif
+
+  boundToUpdate |= dataset->cols(begin, begin + count - 1);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+void BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+    ExpandBound(bound::HollowBallBound<MetricType>& boundToUpdate)
+{
+  // The bound of the parent is not modified while its children are built, so
+  // this is safe even if the children are built in parallel.
+  if (parent != NULL)
+    boundToUpdate.SetShell(parent->Bound().Center());
+
+  boundToUpdate |= dataset->cols(begin, begin + count - 1);
+}
+
 // Default constructor (private), for boost::serialization.
 template<typename MetricType,
          typename StatisticType,
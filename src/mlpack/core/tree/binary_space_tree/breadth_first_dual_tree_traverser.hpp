@@ -11,6 +11,7 @@
 #define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_BREADTH_FIRST_DUAL_TREE_TRAVERSER_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
 #include <queue>
 
 #include "../binary_space_tree.hpp"
@@ -79,10 +80,21 @@ class BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
   //! Modify the number of times a base case was calculated.
   size_t& NumBaseCases() { return numBaseCases; }
 
+  //! The traversal statistics policy (see TraversalStatisticsPolicy).
+  typedef typename TraversalStatisticsPolicy<RuleType>::Type
+      TraversalStatisticsType;
+
+  //! Get the statistics recorded during traversal (with the default policy,
+  //! nothing is recorded).
+  const TraversalStatisticsType& Statistics() const { return statistics; }
+
  private:
   //! Reference to the rules with which the trees will be traversed.
   RuleType& rule;
 
+  //! The statistics recorded during traversal.
+  TraversalStatisticsType statistics;
+
   //! The number of prunes.
   size_t numPrunes;
 
@@ -64,7 +64,7 @@ BreadthFirstDualTreeTraverser<RuleType>::Traverse(
   traversalInfo = rule.TraversalInfo();
 
   // Must score the root combination.
-  const double rootScore = rule.Score(queryRoot, referenceRoot);
+  const double rootScore = statistics.Score(rule, queryRoot, referenceRoot);
   if (rootScore == DBL_MAX)
     return; // This probably means something is wrong.
 
@@ -112,7 +112,7 @@ BreadthFirstDualTreeTraverser<RuleType>::Traverse(
     rule.TraversalInfo() = ti;
     const size_t queryDepth = currentFrame.queryDepth;
 
-    double score = rule.Score(queryNode, referenceNode);
+    double score = statistics.Score(rule, queryNode, referenceNode);
     ++numScores;
 
     if (score == DBL_MAX)
@@ -142,6 +142,9 @@ BreadthFirstDualTreeTraverser<RuleType>::Traverse(
 
         numBaseCases += referenceNode.Count();
       }
+
+      statistics.BaseCases(queryNode, referenceNode,
+          queryNode.Count() * referenceNode.Count());
     }
     else if ((!queryNode.IsLeaf()) && referenceNode.IsLeaf())
     {
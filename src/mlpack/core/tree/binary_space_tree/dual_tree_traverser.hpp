@@ -11,12 +11,20 @@
 #define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_DUAL_TREE_TRAVERSER_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+#include <mlpack/core/tree/prefetch.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
 
 #include "binary_space_tree.hpp"
 
 namespace mlpack {
 namespace tree {
 
+// This gives us a HasBlockBaseCaseCheck<T, U> type (where U is a function
+// pointer) we can use with SFINAE to catch when a rule type has a
+// BlockBaseCase(...) function.
+HAS_MEM_FUNC(BlockBaseCase, HasBlockBaseCaseCheck);
+
 template<typename MetricType,
          typename StatisticType,
          typename MatType,
@@ -63,10 +71,21 @@ class BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
   //! Modify the number of times a base case was calculated.
   size_t& NumBaseCases() { return numBaseCases; }
 
+  //! The traversal statistics policy (see TraversalStatisticsPolicy).
+  typedef typename TraversalStatisticsPolicy<RuleType>::Type
+      TraversalStatisticsType;
+
+  //! Get the statistics recorded during traversal (with the default policy,
+  //! nothing is recorded).
+  const TraversalStatisticsType& Statistics() const { return statistics; }
+
  private:
   //! Reference to the rules with which the trees will be traversed.
   RuleType& rule;
 
+  //! The statistics recorded during traversal.
+  TraversalStatisticsType statistics;
+
   //! The number of prunes.
   size_t numPrunes;
 
@@ -82,6 +101,30 @@ class BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
   //! Traversal information, held in the class so that it isn't continually
   //! being reallocated.
   typename RuleType::TraversalInfoType traversalInfo;
+
+  /**
+   * Evaluate the base cases between two leaves.  This overload is used when
+   * the rule type provides a BlockBaseCase() function, which is handed both
+   * leaves at once so that it can compute all of the base cases as a block.
+   */
+  template<typename Rule>
+  typename std::enable_if<HasBlockBaseCaseCheck<Rule,
+      size_t(Rule::*)(BinarySpaceTree&, BinarySpaceTree&)>::value, void>::type
+  LeafBaseCases(Rule& leafRule,
+                BinarySpaceTree& queryNode,
+                BinarySpaceTree& referenceNode);
+
+  /**
+   * Evaluate the base cases between two leaves.  This overload is used when
+   * the rule type does not provide a BlockBaseCase() function, so each query
+   * point is scored and then each base case is evaluated individually.
+   */
+  template<typename Rule>
+  typename std::enable_if<!HasBlockBaseCaseCheck<Rule,
+      size_t(Rule::*)(BinarySpaceTree&, BinarySpaceTree&)>::value, void>::type
+  LeafBaseCases(Rule& leafRule,
+                BinarySpaceTree& queryNode,
+                BinarySpaceTree& referenceNode);
 };
 
 } // namespace tree
@@ -51,28 +51,23 @@ DualTreeTraverser<RuleType>::Traverse(
   // Store the current traversal info.
   traversalInfo = rule.TraversalInfo();
 
+  // Start loading the children that are about to be scored, so that their
+  // cache misses overlap with each other and with the first scores.
+  if (!queryNode.IsLeaf())
+  {
+    PrefetchNode(queryNode.Left());
+    PrefetchNode(queryNode.Right());
+  }
+  if (!referenceNode.IsLeaf())
+  {
+    PrefetchNode(referenceNode.Left());
+    PrefetchNode(referenceNode.Right());
+  }
+
   // If both are leaves, we must evaluate the base case.
   if (queryNode.IsLeaf() && referenceNode.IsLeaf())
   {
-    // Loop through each of the points in each node.
-    const size_t queryEnd = queryNode.Begin() + queryNode.Count();
-    const size_t refEnd = referenceNode.Begin() + referenceNode.Count();
-    for (size_t query = queryNode.Begin(); query < queryEnd; ++query)
-    {
-      // See if we need to investigate this point (this function should be
-      // implemented for the single-tree recursion too).  Restore the traversal
-      // information first.
-      rule.TraversalInfo() = traversalInfo;
-      const double childScore = rule.Score(query, referenceNode);
-
-      if (childScore == DBL_MAX)
-        continue; // We can't improve this particular point.
-
-      for (size_t ref = referenceNode.Begin(); ref < refEnd; ++ref)
-        rule.BaseCase(query, ref);
-
-      numBaseCases += referenceNode.Count();
-    }
+    LeafBaseCases(rule, queryNode, referenceNode);
   }
   else if (((!queryNode.IsLeaf()) && referenceNode.IsLeaf()) ||
            (queryNode.NumDescendants() > 3 * referenceNode.NumDescendants() &&
@@ -80,7 +75,8 @@ DualTreeTraverser<RuleType>::Traverse(
   {
     // We have to recurse down the query node.  In this case the recursion order
     // does not matter.
-    const double leftScore = rule.Score(*queryNode.Left(), referenceNode);
+    const double leftScore = statistics.Score(rule, *queryNode.Left(),
+        referenceNode);
     ++numScores;
 
     if (leftScore != DBL_MAX)
@@ -90,7 +86,8 @@ DualTreeTraverser<RuleType>::Traverse(
 
     // Before recursing, we have to set the traversal information correctly.
     rule.TraversalInfo() = traversalInfo;
-    const double rightScore = rule.Score(*queryNode.Right(), referenceNode);
+    const double rightScore = statistics.Score(rule, *queryNode.Right(),
+        referenceNode);
     ++numScores;
 
     if (rightScore != DBL_MAX)
@@ -103,10 +100,11 @@ DualTreeTraverser<RuleType>::Traverse(
     // We have to recurse down the reference node.  In this case the recursion
     // order does matter.  Before recursing, though, we have to set the
     // traversal information correctly.
-    double leftScore = rule.Score(queryNode, *referenceNode.Left());
+    double leftScore = statistics.Score(rule, queryNode, *referenceNode.Left());
     typename RuleType::TraversalInfoType leftInfo = rule.TraversalInfo();
     rule.TraversalInfo() = traversalInfo;
-    double rightScore = rule.Score(queryNode, *referenceNode.Right());
+    double rightScore = statistics.Score(rule, queryNode,
+        *referenceNode.Right());
     numScores += 2;
 
     if (leftScore < rightScore)
@@ -118,7 +116,8 @@ DualTreeTraverser<RuleType>::Traverse(
       Traverse(queryNode, *referenceNode.Left());
 
       // Is it still valid to recurse to the right?
-      rightScore = rule.Rescore(queryNode, *referenceNode.Right(), rightScore);
+      rightScore = statistics.Rescore(rule, queryNode, *referenceNode.Right(),
+          rightScore);
 
       if (rightScore != DBL_MAX)
       {
@@ -135,7 +134,8 @@ DualTreeTraverser<RuleType>::Traverse(
       Traverse(queryNode, *referenceNode.Right());
 
       // Is it still valid to recurse to the left?
-      leftScore = rule.Rescore(queryNode, *referenceNode.Left(), leftScore);
+      leftScore = statistics.Rescore(rule, queryNode, *referenceNode.Left(),
+          leftScore);
 
       if (leftScore != DBL_MAX)
       {
@@ -160,7 +160,7 @@ DualTreeTraverser<RuleType>::Traverse(
         rule.TraversalInfo() = leftInfo;
         Traverse(queryNode, *referenceNode.Left());
 
-        rightScore = rule.Rescore(queryNode, *referenceNode.Right(),
+        rightScore = statistics.Rescore(rule, queryNode, *referenceNode.Right(),
             rightScore);
 
         if (rightScore != DBL_MAX)
@@ -180,10 +180,12 @@ DualTreeTraverser<RuleType>::Traverse(
     // query descent order does not matter, we will go to the left query child
     // first.  Before recursing, we have to set the traversal information
     // correctly.
-    double leftScore = rule.Score(*queryNode.Left(), *referenceNode.Left());
+    double leftScore = statistics.Score(rule, *queryNode.Left(),
+        *referenceNode.Left());
     typename RuleType::TraversalInfoType leftInfo = rule.TraversalInfo();
     rule.TraversalInfo() = traversalInfo;
-    double rightScore = rule.Score(*queryNode.Left(), *referenceNode.Right());
+    double rightScore = statistics.Score(rule, *queryNode.Left(),
+        *referenceNode.Right());
     typename RuleType::TraversalInfoType rightInfo;
     numScores += 2;
 
@@ -196,8 +198,8 @@ DualTreeTraverser<RuleType>::Traverse(
       Traverse(*queryNode.Left(), *referenceNode.Left());
 
       // Is it still valid to recurse to the right?
-      rightScore = rule.Rescore(*queryNode.Left(), *referenceNode.Right(),
-          rightScore);
+      rightScore = statistics.Rescore(rule, *queryNode.Left(),
+          *referenceNode.Right(), rightScore);
 
       if (rightScore != DBL_MAX)
       {
@@ -214,8 +216,8 @@ DualTreeTraverser<RuleType>::Traverse(
       Traverse(*queryNode.Left(), *referenceNode.Right());
 
       // Is it still valid to recurse to the left?
-      leftScore = rule.Rescore(*queryNode.Left(), *referenceNode.Left(),
-          leftScore);
+      leftScore = statistics.Rescore(rule, *queryNode.Left(),
+          *referenceNode.Left(), leftScore);
 
       if (leftScore != DBL_MAX)
       {
@@ -241,8 +243,8 @@ DualTreeTraverser<RuleType>::Traverse(
         Traverse(*queryNode.Left(), *referenceNode.Left());
 
         // Is it still valid to recurse to the right?
-        rightScore = rule.Rescore(*queryNode.Left(), *referenceNode.Right(),
-            rightScore);
+        rightScore = statistics.Rescore(rule, *queryNode.Left(),
+            *referenceNode.Right(), rightScore);
 
         if (rightScore != DBL_MAX)
         {
@@ -259,10 +261,12 @@ DualTreeTraverser<RuleType>::Traverse(
     rule.TraversalInfo() = traversalInfo;
 
     // Now recurse down the right query node.
-    leftScore = rule.Score(*queryNode.Right(), *referenceNode.Left());
+    leftScore = statistics.Score(rule, *queryNode.Right(),
+        *referenceNode.Left());
     leftInfo = rule.TraversalInfo();
     rule.TraversalInfo() = traversalInfo;
-    rightScore = rule.Score(*queryNode.Right(), *referenceNode.Right());
+    rightScore = statistics.Score(rule, *queryNode.Right(),
+        *referenceNode.Right());
     numScores += 2;
 
     if (leftScore < rightScore)
@@ -274,8 +278,8 @@ DualTreeTraverser<RuleType>::Traverse(
       Traverse(*queryNode.Right(), *referenceNode.Left());
 
       // Is it still valid to recurse to the right?
-      rightScore = rule.Rescore(*queryNode.Right(), *referenceNode.Right(),
-          rightScore);
+      rightScore = statistics.Rescore(rule, *queryNode.Right(),
+          *referenceNode.Right(), rightScore);
 
       if (rightScore != DBL_MAX)
       {
@@ -292,8 +296,8 @@ DualTreeTraverser<RuleType>::Traverse(
       Traverse(*queryNode.Right(), *referenceNode.Right());
 
       // Is it still valid to recurse to the left?
-      leftScore = rule.Rescore(*queryNode.Right(), *referenceNode.Left(),
-          leftScore);
+      leftScore = statistics.Rescore(rule, *queryNode.Right(),
+          *referenceNode.Left(), leftScore);
 
       if (leftScore != DBL_MAX)
       {
@@ -319,8 +323,8 @@ DualTreeTraverser<RuleType>::Traverse(
         Traverse(*queryNode.Right(), *referenceNode.Left());
 
         // Is it still valid to recurse to the right?
-        rightScore = rule.Rescore(*queryNode.Right(), *referenceNode.Right(),
-            rightScore);
+        rightScore = statistics.Rescore(rule, *queryNode.Right(),
+            *referenceNode.Right(), rightScore);
 
         if (rightScore != DBL_MAX)
         {
@@ -335,6 +339,88 @@ DualTreeTraverser<RuleType>::Traverse(
   }
 }
 
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename RuleType>
+template<typename Rule>
+typename std::enable_if<HasBlockBaseCaseCheck<Rule, size_t(Rule::*)(
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&,
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&)
+    >::value, void>::type
+BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+DualTreeTraverser<RuleType>::LeafBaseCases(
+    Rule& leafRule,
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&
+        queryNode,
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&
+        referenceNode)
+{
+  // Start loading the points of both leaves before the rules read them.
+  PrefetchPoints(queryNode.Dataset(), queryNode.Begin(), queryNode.Count());
+  PrefetchPoints(referenceNode.Dataset(), referenceNode.Begin(),
+      referenceNode.Count());
+
+  // The rules handle scoring each query point and evaluating the block of base
+  // cases; they return the number of base cases that were performed.
+  leafRule.TraversalInfo() = traversalInfo;
+  const size_t baseCases = leafRule.BlockBaseCase(queryNode, referenceNode);
+  numBaseCases += baseCases;
+  statistics.BaseCases(queryNode, referenceNode, baseCases);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename RuleType>
+template<typename Rule>
+typename std::enable_if<!HasBlockBaseCaseCheck<Rule, size_t(Rule::*)(
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&,
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&)
+    >::value, void>::type
+BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+DualTreeTraverser<RuleType>::LeafBaseCases(
+    Rule& leafRule,
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&
+        queryNode,
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&
+        referenceNode)
+{
+  // Start loading the reference points while the first query point is scored.
+  PrefetchPoints(referenceNode.Dataset(), referenceNode.Begin(),
+      referenceNode.Count());
+
+  // Loop through each of the points in each node.
+  const size_t queryEnd = queryNode.Begin() + queryNode.Count();
+  const size_t refEnd = referenceNode.Begin() + referenceNode.Count();
+  size_t baseCases = 0;
+  for (size_t query = queryNode.Begin(); query < queryEnd; ++query)
+  {
+    // See if we need to investigate this point (this function should be
+    // implemented for the single-tree recursion too).  Restore the traversal
+    // information first.
+    leafRule.TraversalInfo() = traversalInfo;
+    const double childScore = statistics.Score(leafRule, query, referenceNode);
+
+    if (childScore == DBL_MAX)
+      continue; // We can't improve this particular point.
+
+    for (size_t ref = referenceNode.Begin(); ref < refEnd; ++ref)
+      leafRule.BaseCase(query, ref);
+
+    baseCases += referenceNode.Count();
+  }
+
+  numBaseCases += baseCases;
+  statistics.BaseCases(queryNode, referenceNode, baseCases);
+}
+
 }; // namespace tree
 }; // namespace mlpack
 
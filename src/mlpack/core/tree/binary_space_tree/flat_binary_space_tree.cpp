@@ -0,0 +1,253 @@
+/**
+ * @file flat_binary_space_tree.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the memory management and file I/O of
+ * FlatBinarySpaceTree.
+ */
+#include "flat_binary_space_tree.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+using namespace mlpack;
+using namespace mlpack::tree;
+
+// The block starts with these eight characters, followed by the header words.
+static const char flatTreeMagic[8] = { 'M', 'L', 'P', 'K', 'F', 'B', 'S', 'T' };
+
+// The version of the format.
+static const size_t flatTreeVersion = 1;
+
+// The header words are the byte order mark (1), sizeof(size_t), the version,
+// the dimensionality, the number of points, and the number of nodes.
+static const size_t headerWords = 6;
+
+// Round up to a multiple of eight bytes, so that every array is aligned.
+static size_t Align(const size_t bytes)
+{
+  return (bytes + 7) & ~((size_t) 7);
+}
+
+// The offsets of each array in the block.
+struct FlatTreeLayout
+{
+  size_t dataset, oldFromNew, begins, counts, rights, parents, parentDistances,
+      furthestDescendantDistances, lowerBounds, upperBounds, length;
+
+  FlatTreeLayout(const size_t dimensionality,
+                 const size_t points,
+                 const size_t nodes)
+  {
+    dataset = Align(sizeof(flatTreeMagic) + headerWords * sizeof(size_t));
+    oldFromNew = dataset + Align(dimensionality * points * sizeof(double));
+    begins = oldFromNew + Align(points * sizeof(size_t));
+    counts = begins + Align(nodes * sizeof(size_t));
+    rights = counts + Align(nodes * sizeof(size_t));
+    parents = rights + Align(nodes * sizeof(size_t));
+    parentDistances = parents + Align(nodes * sizeof(size_t));
+    furthestDescendantDistances = parentDistances +
+        Align(nodes * sizeof(double));
+    lowerBounds = furthestDescendantDistances + Align(nodes * sizeof(double));
+    upperBounds = lowerBounds + Align(dimensionality * nodes * sizeof(double));
+    length = upperBounds + Align(dimensionality * nodes * sizeof(double));
+  }
+};
+
+FlatBinarySpaceTree::FlatBinarySpaceTree(const std::string& filename,
+                                         const bool mapFile) :
+    memory(NULL),
+    length(0),
+    mapped(false),
+    numNodes(0),
+    dataset(NULL),
+    oldFromNew(NULL),
+    begins(NULL),
+    counts(NULL),
+    rights(NULL),
+    parents(NULL),
+    parentDistances(NULL),
+    furthestDescendantDistances(NULL),
+    lowerBounds(NULL),
+    upperBounds(NULL)
+{
+  if (mapFile)
+  {
+#ifdef _WIN32
+    throw std::runtime_error("FlatBinarySpaceTree: memory mapping is not "
+        "supported on this platform");
+#else
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+      std::ostringstream oss;
+      oss << "FlatBinarySpaceTree: cannot open '" << filename << "': "
+          << std::strerror(errno);
+      throw std::runtime_error(oss.str());
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) == -1)
+    {
+      close(fd);
+      std::ostringstream oss;
+      oss << "FlatBinarySpaceTree: cannot stat '" << filename << "': "
+          << std::strerror(errno);
+      throw std::runtime_error(oss.str());
+    }
+    length = (size_t) fileStat.st_size;
+
+    // The tree is never modified, but the matrices that use the mapping are not
+    // const, so the mapping is private and writable.
+    void* mapping = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd,
+        0);
+    close(fd); // The mapping holds its own reference to the file.
+    if (mapping == MAP_FAILED)
+    {
+      std::ostringstream oss;
+      oss << "FlatBinarySpaceTree: cannot map '" << filename << "': "
+          << std::strerror(errno);
+      throw std::runtime_error(oss.str());
+    }
+
+    memory = (char*) mapping;
+    mapped = true;
+#endif
+  }
+  else
+  {
+    std::ifstream stream(filename.c_str(), std::ios::binary | std::ios::ate);
+    if (!stream.is_open())
+      throw std::runtime_error("FlatBinarySpaceTree: cannot open '" + filename +
+          "'");
+
+    length = (size_t) stream.tellg();
+    stream.seekg(0);
+    memory = new char[length];
+    if (!stream.read(memory, length))
+    {
+      delete[] memory;
+      memory = NULL;
+      throw std::runtime_error("FlatBinarySpaceTree: cannot read '" + filename +
+          "'");
+    }
+  }
+
+  try
+  {
+    Attach(filename);
+  }
+  catch (std::runtime_error&)
+  {
+    // The destructor will not be called, so release the block here.
+#ifndef _WIN32
+    if (mapped)
+      munmap(memory, length);
+    else
+#endif
+      delete[] memory;
+    throw;
+  }
+}
+
+FlatBinarySpaceTree::~FlatBinarySpaceTree()
+{
+  delete dataset;
+  delete lowerBounds;
+  delete upperBounds;
+  dataset = lowerBounds = upperBounds = NULL;
+
+  if (mapped)
+  {
+#ifndef _WIN32
+    munmap(memory, length);
+#endif
+  }
+  else
+  {
+    delete[] memory;
+  }
+  memory = NULL;
+}
+
+void FlatBinarySpaceTree::Save(const std::string& filename) const
+{
+  std::ofstream stream(filename.c_str(), std::ios::binary);
+  if (!stream.is_open() || !stream.write(memory, length))
+    throw std::runtime_error("FlatBinarySpaceTree::Save(): cannot write '" +
+        filename + "'");
+}
+
+void FlatBinarySpaceTree::Allocate(const size_t dimensionality,
+                                   const size_t points,
+                                   const size_t nodes)
+{
+  const FlatTreeLayout layout(dimensionality, points, nodes);
+
+  length = layout.length;
+  memory = new char[length];
+  // Zero the padding, so that saved files do not hold uninitialized memory.
+  std::memset(memory, 0, length);
+
+  std::memcpy(memory, flatTreeMagic, sizeof(flatTreeMagic));
+  size_t* header = (size_t*) (memory + sizeof(flatTreeMagic));
+  header[0] = 1;
+  header[1] = sizeof(size_t);
+  header[2] = flatTreeVersion;
+  header[3] = dimensionality;
+  header[4] = points;
+  header[5] = nodes;
+
+  Attach("");
+}
+
+void FlatBinarySpaceTree::Attach(const std::string& filename)
+{
+  const size_t headerLength = sizeof(flatTreeMagic) +
+      headerWords * sizeof(size_t);
+  const size_t* header = (const size_t*) (memory + sizeof(flatTreeMagic));
+  if (length < headerLength ||
+      std::memcmp(memory, flatTreeMagic, sizeof(flatTreeMagic)) != 0 ||
+      header[0] != 1 || header[1] != sizeof(size_t) ||
+      header[2] != flatTreeVersion)
+  {
+    throw std::runtime_error("FlatBinarySpaceTree: '" + filename + "' is not "
+        "a flat tree file saved on this kind of machine");
+  }
+
+  const size_t dimensionality = header[3];
+  const size_t points = header[4];
+  numNodes = header[5];
+
+  const FlatTreeLayout layout(dimensionality, points, numNodes);
+  if (layout.length != length)
+    throw std::runtime_error("FlatBinarySpaceTree: '" + filename + "' has the "
+        "wrong length");
+
+  // The matrices use the block as their memory and are strict, so that they
+  // can never be reallocated.
+  dataset = new arma::mat((double*) (memory + layout.dataset), dimensionality,
+      points, false, true);
+  oldFromNew = (size_t*) (memory + layout.oldFromNew);
+  begins = (size_t*) (memory + layout.begins);
+  counts = (size_t*) (memory + layout.counts);
+  rights = (size_t*) (memory + layout.rights);
+  parents = (size_t*) (memory + layout.parents);
+  parentDistances = (double*) (memory + layout.parentDistances);
+  furthestDescendantDistances = (double*) (memory +
+      layout.furthestDescendantDistances);
+  lowerBounds = new arma::mat((double*) (memory + layout.lowerBounds),
+      dimensionality, numNodes, false, true);
+  upperBounds = new arma::mat((double*) (memory + layout.upperBounds),
+      dimensionality, numNodes, false, true);
+}
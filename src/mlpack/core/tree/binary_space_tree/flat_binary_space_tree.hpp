@@ -0,0 +1,184 @@
+/**
+ * @file flat_binary_space_tree.hpp
+ * @author Ryan Curtin
+ *
+ * A compact, pointer-free copy of a BinarySpaceTree built with HRectBound (such
+ * as a kd-tree), stored in one contiguous block of memory so that it can be
+ * saved with a single write and loaded with a single read or a memory mapping.
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_FLAT_BINARY_SPACE_TREE_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_FLAT_BINARY_SPACE_TREE_HPP
+
+#include <mlpack/core.hpp>
+#include <string>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * A FlatBinarySpaceTree holds the structure of a BinarySpaceTree with
+ * HRectBound in a single block of memory, with no pointers.  Nodes are numbered
+ * in depth-first (preorder) order, so the left child of node i is node i + 1
+ * and every subtree occupies a contiguous range of node indices; only the index
+ * of the right child is stored.  The per-node quantities are each held in their
+ * own array (structure-of-arrays form), and the bound of node i is held in
+ * column i of the LowerBounds() and UpperBounds() matrices.
+ *
+ * The block holds, in order: a header; the (rearranged) dataset; the
+ * oldFromNew mapping; the begin, count, right child and parent of each node;
+ * the parent distance and furthest descendant distance of each node; and the
+ * lower and upper bounds of each node.  Save() writes that block as-is, and
+ * the constructor that takes a filename reads it back with a single read (or
+ * maps it into memory, on POSIX systems), so no work proportional to the
+ * number of nodes is done at load time.  The file format depends on the size of
+ * size_t and on the byte order of the machine; a file written on a different
+ * kind of machine is rejected.
+ *
+ * Node statistics are not stored.  The tree cannot be modified after it is
+ * created, and it does not satisfy the TreeType policy, so it cannot be used
+ * with the tree traversers; see neighbor::FlatTreeKNN for a search that uses
+ * it directly.
+ */
+class FlatBinarySpaceTree
+{
+ public:
+  /**
+   * Create a flat copy of the given tree.  The tree must be a BinarySpaceTree
+   * (any split type) with HRectBound, and oldFromNew must be the mapping that
+   * was filled when the tree was built.
+   *
+   * @param tree Root of the tree to copy.
+   * @param oldFromNew Mapping from the indices of the points in the tree to the
+   *      indices of the points in the original dataset.
+   */
+  template<typename TreeType>
+  FlatBinarySpaceTree(const TreeType& tree,
+                      const std::vector<size_t>& oldFromNew);
+
+  /**
+   * Load a flat tree from a file that was written by Save().  If mapFile is
+   * true, the file is memory-mapped (privately) instead of read, so that pages
+   * are only read when they are used and processes on the same host share the
+   * page cache of the file.  A std::runtime_error is thrown if the file cannot
+   * be read or was not written by Save() on this kind of machine.
+   *
+   * @param filename File to load.
+   * @param mapFile If true, map the file instead of reading it.
+   */
+  FlatBinarySpaceTree(const std::string& filename, const bool mapFile = false);
+
+  //! Free the memory held by the tree (or unmap the file).
+  ~FlatBinarySpaceTree();
+
+  /**
+   * Save the tree to the given file with a single write.  A
+   * std::runtime_error is thrown if the file cannot be written.
+   *
+   * @param filename File to save to.
+   */
+  void Save(const std::string& filename) const;
+
+  //! Get the dataset the tree holds (with its points rearranged).
+  const arma::mat& Dataset() const { return *dataset; }
+  //! Get the index in the original dataset of the given point in Dataset().
+  size_t OldFromNew(const size_t point) const { return oldFromNew[point]; }
+
+  //! Get the number of nodes in the tree.
+  size_t NumNodes() const { return numNodes; }
+
+  //! Get the index of the first point held in the given node.
+  size_t Begin(const size_t node) const { return begins[node]; }
+  //! Get the number of points held in the given node (and its descendants).
+  size_t Count(const size_t node) const { return counts[node]; }
+  //! Return whether or not the given node is a leaf.
+  bool IsLeaf(const size_t node) const { return rights[node] == 0; }
+  //! Get the index of the left child of the given (non-leaf) node.
+  size_t Left(const size_t node) const { return node + 1; }
+  //! Get the index of the right child of the given (non-leaf) node.
+  size_t Right(const size_t node) const { return rights[node]; }
+  //! Get the index of the parent of the given node (the root is its own
+  //! parent).
+  size_t Parent(const size_t node) const { return parents[node]; }
+
+  //! Get the distance from the center of the given node to the center of its
+  //! parent.
+  double ParentDistance(const size_t node) const
+  { return parentDistances[node]; }
+  //! Get the furthest possible distance from the center of the given node to
+  //! any of its descendant points.
+  double FurthestDescendantDistance(const size_t node) const
+  { return furthestDescendantDistances[node]; }
+
+  //! Get the lower bounds of every node (one column per node).
+  const arma::mat& LowerBounds() const { return *lowerBounds; }
+  //! Get the upper bounds of every node (one column per node).
+  const arma::mat& UpperBounds() const { return *upperBounds; }
+
+  /**
+   * Calculate the minimum distance between the bound of the given node and the
+   * given point, in the same way as HRectBound::MinDistance().
+   *
+   * @tparam MetricType LMetric the tree was built with.
+   * @param node Index of node.
+   * @param point Point to calculate the distance to.
+   */
+  template<typename MetricType, typename VecType>
+  double MinDistance(const size_t node, const VecType& point) const;
+
+ private:
+  // The memory cannot be copied.
+  FlatBinarySpaceTree(const FlatBinarySpaceTree& other);
+  FlatBinarySpaceTree& operator=(const FlatBinarySpaceTree& other);
+
+  //! Allocate the block for a tree of the given size and write its header.
+  void Allocate(const size_t dimensionality,
+                const size_t points,
+                const size_t nodes);
+
+  //! Check the header of the block, and point the members into it.
+  void Attach(const std::string& filename);
+
+  //! Copy the given node (and its descendants) into the block, in preorder;
+  //! nextNode is the index that the given node will receive.
+  template<typename TreeType>
+  void Flatten(const TreeType& node, const size_t parent, size_t& nextNode);
+
+  //! The block holding the whole tree.
+  char* memory;
+  //! The length of the block, in bytes.
+  size_t length;
+  //! Whether the block is a memory mapping (otherwise it was allocated).
+  bool mapped;
+
+  //! The number of nodes in the tree.
+  size_t numNodes;
+
+  //! The dataset, using the block as its memory.
+  arma::mat* dataset;
+  //! The mapping from indices in the dataset to original indices.
+  size_t* oldFromNew;
+  //! The index of the first point of each node.
+  size_t* begins;
+  //! The number of points in each node.
+  size_t* counts;
+  //! The right child of each node (0 for leaves).
+  size_t* rights;
+  //! The parent of each node.
+  size_t* parents;
+  //! The parent distance of each node.
+  double* parentDistances;
+  //! The furthest descendant distance of each node.
+  double* furthestDescendantDistances;
+  //! The lower bounds of each node, using the block as its memory.
+  arma::mat* lowerBounds;
+  //! The upper bounds of each node, using the block as its memory.
+  arma::mat* upperBounds;
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "flat_binary_space_tree_impl.hpp"
+
+#endif
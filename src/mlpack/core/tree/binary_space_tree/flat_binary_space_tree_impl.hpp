@@ -0,0 +1,126 @@
+/**
+ * @file flat_binary_space_tree_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the templated functions of FlatBinarySpaceTree.
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_FLAT_BINARY_SPACE_TREE_IMPL_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_FLAT_BINARY_SPACE_TREE_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "flat_binary_space_tree.hpp"
+
+#include <stack>
+#include <stdexcept>
+
+namespace mlpack {
+namespace tree {
+
+template<typename TreeType>
+FlatBinarySpaceTree::FlatBinarySpaceTree(
+    const TreeType& tree,
+    const std::vector<size_t>& oldFromNew) :
+    memory(NULL),
+    length(0),
+    mapped(false),
+    numNodes(0),
+    dataset(NULL),
+    oldFromNew(NULL),
+    begins(NULL),
+    counts(NULL),
+    rights(NULL),
+    parents(NULL),
+    parentDistances(NULL),
+    furthestDescendantDistances(NULL),
+    lowerBounds(NULL),
+    upperBounds(NULL)
+{
+  if (oldFromNew.size() != tree.Dataset().n_cols)
+    throw std::invalid_argument("FlatBinarySpaceTree::FlatBinarySpaceTree(): "
+        "size of oldFromNew does not match number of points in tree");
+
+  // Count the nodes, so that the block can be allocated at once.
+  size_t nodes = 0;
+  std::stack<const TreeType*> stack;
+  stack.push(&tree);
+  while (!stack.empty())
+  {
+    const TreeType* node = stack.top();
+    stack.pop();
+    ++nodes;
+
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+      stack.push(&node->Child(i));
+  }
+
+  Allocate(tree.Dataset().n_rows, tree.Dataset().n_cols, nodes);
+
+  // The dataset has the same size as the block's matrix, so this copies into
+  // the block.
+  *dataset = tree.Dataset();
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    this->oldFromNew[i] = oldFromNew[i];
+
+  size_t nextNode = 0;
+  Flatten(tree, 0, nextNode);
+}
+
+template<typename TreeType>
+void FlatBinarySpaceTree::Flatten(const TreeType& node,
+                                  const size_t parent,
+                                  size_t& nextNode)
+{
+  const size_t index = nextNode++;
+
+  begins[index] = node.Begin();
+  counts[index] = node.Count();
+  parents[index] = parent;
+  parentDistances[index] = node.ParentDistance();
+  furthestDescendantDistances[index] = node.FurthestDescendantDistance();
+
+  for (size_t d = 0; d < lowerBounds->n_rows; ++d)
+  {
+    (*lowerBounds)(d, index) = node.Bound()[d].Lo();
+    (*upperBounds)(d, index) = node.Bound()[d].Hi();
+  }
+
+  if (node.NumChildren() == 0)
+  {
+    rights[index] = 0;
+    return;
+  }
+
+  // In preorder, the left subtree comes first and the right child follows it.
+  Flatten(node.Child(0), index, nextNode);
+  rights[index] = nextNode;
+  Flatten(node.Child(1), index, nextNode);
+}
+
+template<typename MetricType, typename VecType>
+double FlatBinarySpaceTree::MinDistance(const size_t node,
+                                        const VecType& point) const
+{
+  const double* lo = lowerBounds->colptr(node);
+  const double* hi = upperBounds->colptr(node);
+
+  double sum = 0;
+  for (size_t d = 0; d < lowerBounds->n_rows; ++d)
+  {
+    const double lower = lo[d] - point[d];
+    const double higher = point[d] - hi[d];
+
+    // This is the same calculation as HRectBound::MinDistance().
+    sum += pow((lower + fabs(lower)) + (higher + fabs(higher)),
+        (double) MetricType::Power);
+  }
+
+  if (MetricType::TakeRoot)
+    return pow(sum, 1.0 / (double) MetricType::Power) / 2.0;
+  else
+    return sum / pow(2.0, MetricType::Power);
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
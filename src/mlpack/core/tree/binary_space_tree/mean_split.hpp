@@ -10,6 +10,7 @@
 #define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_MEAN_SPLIT_HPP
 
 #include <mlpack/core.hpp>
+#include "sparse_partition.hpp"
 
 namespace mlpack {
 namespace tree /** Trees and tree-building procedures. */ {
@@ -178,6 +178,13 @@ size_t MeanSplit<BoundType, MatType>::
                  const size_t splitDimension,
                  const double splitVal)
 {
+  // Sparse matrices are partitioned all at once instead (see
+  // SparsePartition()).
+  size_t splitCol;
+  if (SparsePartition(data, begin, count, splitDimension, splitVal, splitCol,
+      NULL))
+    return splitCol;
+
   // This method modifies the input dataset.  We loop both from the left and
   // right sides of the points contained in this node.  The points less than
   // splitVal should be on the left side of the matrix, and the points greater
@@ -225,6 +232,13 @@ size_t MeanSplit<BoundType, MatType>::
                  const double splitVal,
                  std::vector<size_t>& oldFromNew)
 {
+  // Sparse matrices are partitioned all at once instead (see
+  // SparsePartition()).
+  size_t splitCol;
+  if (SparsePartition(data, begin, count, splitDimension, splitVal, splitCol,
+      &oldFromNew))
+    return splitCol;
+
   // This method modifies the input dataset.  We loop both from the left and
   // right sides of the points contained in this node.  The points less than
   // splitVal should be on the left side of the matrix, and the points greater
@@ -11,6 +11,7 @@
 #define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_MIDPOINT_SPLIT_HPP
 
 #include <mlpack/core.hpp>
+#include "sparse_partition.hpp"
 
 namespace mlpack {
 namespace tree /** Trees and tree-building procedures. */ {
@@ -165,6 +165,13 @@ size_t MidpointSplit<BoundType, MatType>::PerformSplit(
     const size_t splitDimension,
     const double splitVal)
 {
+  // Sparse matrices are partitioned all at once instead (see
+  // SparsePartition()).
+  size_t splitCol;
+  if (SparsePartition(data, begin, count, splitDimension, splitVal, splitCol,
+      NULL))
+    return splitCol;
+
   // This method modifies the input dataset.  We loop both from the left and
   // right sides of the points contained in this node.  The points less than
   // splitVal should be on the left side of the matrix, and the points greater
@@ -212,6 +219,13 @@ size_t MidpointSplit<BoundType, MatType>::PerformSplit(
     const double splitVal,
     std::vector<size_t>& oldFromNew)
 {
+  // Sparse matrices are partitioned all at once instead (see
+  // SparsePartition()).
+  size_t splitCol;
+  if (SparsePartition(data, begin, count, splitDimension, splitVal, splitCol,
+      &oldFromNew))
+    return splitCol;
+
   // This method modifies the input dataset.  We loop both from the left and
   // right sides of the points contained in this node.  The points less than
   // splitVal should be on the left side of the matrix, and the points greater
@@ -10,12 +10,20 @@
 #define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_SINGLE_TREE_TRAVERSER_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+#include <mlpack/core/tree/prefetch.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
 
 #include "binary_space_tree.hpp"
 
 namespace mlpack {
 namespace tree {
 
+// This gives us a HasScoreChildrenCheck<T, U> type (where U is a function
+// pointer) we can use with SFINAE to catch when a rule type has a
+// ScoreChildren(...) function.
+HAS_MEM_FUNC(ScoreChildren, HasScoreChildrenCheck);
+
 template<typename MetricType,
          typename StatisticType,
          typename MatType,
@@ -46,12 +54,52 @@ class BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
   //! Modify the number of prunes.
   size_t& NumPrunes() { return numPrunes; }
 
+  //! The traversal statistics policy (see TraversalStatisticsPolicy).
+  typedef typename TraversalStatisticsPolicy<RuleType>::Type
+      TraversalStatisticsType;
+
+  //! Get the statistics recorded during traversal (with the default policy,
+  //! nothing is recorded).
+  const TraversalStatisticsType& Statistics() const { return statistics; }
+
  private:
   //! Reference to the rules with which the tree will be traversed.
   RuleType& rule;
 
+  //! The statistics recorded during traversal.
+  TraversalStatisticsType statistics;
+
   //! The number of nodes which have been pruned during traversal.
   size_t numPrunes;
+
+  /**
+   * Score the query point with both children of the given node.  This overload
+   * is used when the rule type provides a ScoreChildren() function, which
+   * scores all of the children of a node in one call, so that it can share the
+   * work that does not depend on the child.
+   */
+  template<typename Rule>
+  typename std::enable_if<HasScoreChildrenCheck<Rule,
+      void(Rule::*)(const size_t, BinarySpaceTree&, double*)>::value,
+      void>::type
+  ScoreChildren(Rule& scoreRule,
+                const size_t queryIndex,
+                BinarySpaceTree& referenceNode,
+                double* scores);
+
+  /**
+   * Score the query point with both children of the given node.  This overload
+   * is used when the rule type does not provide a ScoreChildren() function, so
+   * Score() is called for each child.
+   */
+  template<typename Rule>
+  typename std::enable_if<!HasScoreChildrenCheck<Rule,
+      void(Rule::*)(const size_t, BinarySpaceTree&, double*)>::value,
+      void>::type
+  ScoreChildren(Rule& scoreRule,
+                const size_t queryIndex,
+                BinarySpaceTree& referenceNode,
+                double* scores);
 };
 
 }; // namespace tree
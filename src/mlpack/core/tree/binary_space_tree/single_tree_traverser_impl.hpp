@@ -49,12 +49,30 @@ SingleTreeTraverser<RuleType>::Traverse(
     const size_t refEnd = referenceNode.Begin() + referenceNode.Count();
     for (size_t i = referenceNode.Begin(); i < refEnd; ++i)
       rule.BaseCase(queryIndex, i);
+
+    statistics.BaseCases(referenceNode, referenceNode.Count());
   }
   else
   {
+    // Start loading both children before either is scored, so that the two
+    // cache misses overlap.
+    PrefetchNode(referenceNode.Left());
+    PrefetchNode(referenceNode.Right());
+
     // If either score is DBL_MAX, we do not recurse into that node.
-    double leftScore = rule.Score(queryIndex, *referenceNode.Left());
-    double rightScore = rule.Score(queryIndex, *referenceNode.Right());
+    double scores[2];
+    ScoreChildren(rule, queryIndex, referenceNode, scores);
+    double leftScore = scores[0];
+    double rightScore = scores[1];
+
+    // Start loading the points of the children that are leaves we will visit,
+    // so that they arrive while the other child is being searched.
+    if (leftScore != DBL_MAX && referenceNode.Left()->IsLeaf())
+      PrefetchPoints(referenceNode.Dataset(), referenceNode.Left()->Begin(),
+          referenceNode.Left()->Count());
+    if (rightScore != DBL_MAX && referenceNode.Right()->IsLeaf())
+      PrefetchPoints(referenceNode.Dataset(), referenceNode.Right()->Begin(),
+          referenceNode.Right()->Count());
 
     if (leftScore < rightScore)
     {
@@ -62,7 +80,8 @@ SingleTreeTraverser<RuleType>::Traverse(
       Traverse(queryIndex, *referenceNode.Left());
 
       // Is it still valid to recurse to the right?
-      rightScore = rule.Rescore(queryIndex, *referenceNode.Right(), rightScore);
+      rightScore = statistics.Rescore(rule, queryIndex, *referenceNode.Right(),
+          rightScore);
 
       if (rightScore != DBL_MAX)
         Traverse(queryIndex, *referenceNode.Right()); // Recurse to the right.
@@ -75,7 +94,8 @@ SingleTreeTraverser<RuleType>::Traverse(
       Traverse(queryIndex, *referenceNode.Right());
 
       // Is it still valid to recurse to the left?
-      leftScore = rule.Rescore(queryIndex, *referenceNode.Left(), leftScore);
+      leftScore = statistics.Rescore(rule, queryIndex, *referenceNode.Left(),
+          leftScore);
 
       if (leftScore != DBL_MAX)
         Traverse(queryIndex, *referenceNode.Left()); // Recurse to the left.
@@ -94,8 +114,8 @@ SingleTreeTraverser<RuleType>::Traverse(
         Traverse(queryIndex, *referenceNode.Left());
 
         // Is it still valid to recurse to the right?
-        rightScore = rule.Rescore(queryIndex, *referenceNode.Right(),
-            rightScore);
+        rightScore = statistics.Rescore(rule, queryIndex,
+            *referenceNode.Right(), rightScore);
 
         if (rightScore != DBL_MAX)
           Traverse(queryIndex, *referenceNode.Right());
@@ -106,6 +126,53 @@ SingleTreeTraverser<RuleType>::Traverse(
   }
 }
 
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename RuleType>
+template<typename Rule>
+typename std::enable_if<HasScoreChildrenCheck<Rule, void(Rule::*)(
+    const size_t,
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&,
+    double*)>::value, void>::type
+BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+SingleTreeTraverser<RuleType>::ScoreChildren(
+    Rule& scoreRule,
+    const size_t queryIndex,
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&
+        referenceNode,
+    double* scores)
+{
+  statistics.ScoreChildren(scoreRule, queryIndex, referenceNode, scores);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename BoundMetricType> class BoundType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+template<typename RuleType>
+template<typename Rule>
+typename std::enable_if<!HasScoreChildrenCheck<Rule, void(Rule::*)(
+    const size_t,
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&,
+    double*)>::value, void>::type
+BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>::
+SingleTreeTraverser<RuleType>::ScoreChildren(
+    Rule& scoreRule,
+    const size_t queryIndex,
+    BinarySpaceTree<MetricType, StatisticType, MatType, BoundType, SplitType>&
+        referenceNode,
+    double* scores)
+{
+  scores[0] = statistics.Score(scoreRule, queryIndex, *referenceNode.Left());
+  scores[1] = statistics.Score(scoreRule, queryIndex, *referenceNode.Right());
+}
+
 }; // namespace tree
 }; // namespace mlpack
 
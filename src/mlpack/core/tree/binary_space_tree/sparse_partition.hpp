@@ -0,0 +1,95 @@
+/**
+ * @file sparse_partition.hpp
+ * @author Ryan Curtin
+ *
+ * Partition the columns of a sparse matrix around a value in one dimension, for
+ * the MidpointSplit and MeanSplit classes.
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_SPARSE_PARTITION_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_SPARSE_PARTITION_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * Partition the points of a node of a dense matrix.  Dense columns are swapped
+ * by the splitting classes themselves, so this does nothing and returns false.
+ */
+template<typename MatType>
+bool SparsePartition(MatType& /* data */,
+                     const size_t /* begin */,
+                     const size_t /* count */,
+                     const size_t /* splitDimension */,
+                     const double /* splitVal */,
+                     size_t& /* splitCol */,
+                     std::vector<size_t>* /* oldFromNew */)
+{
+  return false;
+}
+
+/**
+ * Partition the points of a node of a sparse matrix, so that the points with
+ * value less than splitVal in dimension splitDimension come first (in their
+ * original order), followed by the other points.  Swapping two columns of a
+ * sparse matrix may move the nonzero elements of the whole matrix, so instead
+ * the new order is computed first and then the columns of the node are
+ * reordered at once, in time linear in their number of nonzero elements.
+ *
+ * @param data The dataset used by the binary space tree.
+ * @param begin Index of the starting point in the dataset that belongs to
+ *    this node.
+ * @param count Number of points in this node.
+ * @param splitDimension The dimension to split the node on.
+ * @param splitVal The split in dimension splitDimension is based on this
+ *    value.
+ * @param splitCol The index of the first point on the right side.
+ * @param oldFromNew If not NULL, the old positions of the points of the node
+ *    are reordered in the same way.
+ * @return True (the points are always partitioned).
+ */
+template<typename eT>
+bool SparsePartition(arma::SpMat<eT>& data,
+                     const size_t begin,
+                     const size_t count,
+                     const size_t splitDimension,
+                     const double splitVal,
+                     size_t& splitCol,
+                     std::vector<size_t>* oldFromNew)
+{
+  const arma::SpMat<eT>& constData = data;
+
+  std::vector<bool> goesLeft(count);
+  arma::Col<arma::uword> order(count);
+  size_t left = 0;
+  for (size_t i = 0; i < count; ++i)
+  {
+    goesLeft[i] = ((double) constData(splitDimension, begin + i) < splitVal);
+    if (goesLeft[i])
+      order[left++] = i;
+  }
+
+  size_t right = left;
+  for (size_t i = 0; i < count; ++i)
+    if (!goesLeft[i])
+      order[right++] = i;
+
+  data.reorder_cols(begin, order);
+
+  if (oldFromNew != NULL)
+  {
+    const std::vector<size_t> oldIndices(oldFromNew->begin() + begin,
+        oldFromNew->begin() + begin + count);
+    for (size_t i = 0; i < count; ++i)
+      (*oldFromNew)[begin + i] = oldIndices[order[i]];
+  }
+
+  splitCol = begin + left;
+  return true;
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
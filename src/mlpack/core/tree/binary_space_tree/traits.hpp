@@ -56,6 +56,49 @@ class TreeTraits<BinarySpaceTree<MetricType, StatisticType, MatType, BoundType,
   static const bool BinaryTree = true;
 };
 
+/**
+ * This is a specialization of the TreeTraits class to the BinarySpaceTree tree
+ * type with HollowBallBound (the VPTree).  The bounds of the children are
+ * balls around different points, so they may overlap; otherwise the traits are
+ * the same as any other BinarySpaceTree.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         template<typename SplitBoundType, typename SplitMatType>
+             class SplitType>
+class TreeTraits<BinarySpaceTree<MetricType, StatisticType, MatType,
+                                 bound::HollowBallBound, SplitType>>
+{
+ public:
+  /**
+   * The bounds of the children of a node may overlap, although the children
+   * hold disjoint sets of points.
+   */
+  static const bool HasOverlappingChildren = true;
+
+  /**
+   * The first point in a node is the center of its bound, but it is not the
+   * centroid of the node.
+   */
+  static const bool FirstPointIsCentroid = false;
+
+  /**
+   * Points are not contained at multiple levels of the binary space tree.
+   */
+  static const bool HasSelfChildren = false;
+
+  /**
+   * Points are rearranged during building of the tree.
+   */
+  static const bool RearrangesDataset = true;
+
+  /**
+   * This is always a binary tree.
+   */
+  static const bool BinaryTree = true;
+};
+
 } // namespace tree
 } // namespace mlpack
 
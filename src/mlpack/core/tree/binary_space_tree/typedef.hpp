@@ -135,6 +135,41 @@ using MeanSplitBallTree = BinarySpaceTree<MetricType,
                                           bound::HRectBound,
                                           MeanSplit>;
 
+/**
+ * A vantage-point tree.  Each node of this tree holds its points only in the
+ * leaves, like the KDTree, but nodes are split around a vantage point (one of
+ * the points of the node): the points closer to the vantage point than the
+ * median distance go to the left child, and the others go to the right child.
+ * The bound of each node is a HollowBallBound, which is a ball around the
+ * node's own vantage point intersected with the shell of distances from the
+ * parent's vantage point that the node was given.  Since the construction and
+ * the bounds only use distances, this tree does not depend on the coordinate
+ * axes, which can make it a better choice than the KDTree for
+ * higher-dimensional data.
+ *
+ * @code
+ * @inproceedings{yianilos1993data,
+ *   title={Data structures and algorithms for nearest neighbor search in
+ *       general metric spaces},
+ *   author={Yianilos, P.N.},
+ *   booktitle={Proceedings of the Fourth Annual ACM-SIAM Symposium on Discrete
+ *       Algorithms (SODA 1993)},
+ *   pages={311--321},
+ *   year={1993}
+ * }
+ * @endcode
+ *
+ * This template typedef satisfies the TreeType policy API.
+ *
+ * @see @ref trees, BinarySpaceTree, VPTreeSplit, HollowBallBound
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+using VPTree = BinarySpaceTree<MetricType,
+                               StatisticType,
+                               MatType,
+                               bound::HollowBallBound,
+                               VPTreeSplit>;
+
 } // namespace tree
 } // namespace mlpack
 
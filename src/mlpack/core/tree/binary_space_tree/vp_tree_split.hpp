@@ -0,0 +1,129 @@
+/**
+ * @file vp_tree_split.hpp
+ * @author Ryan Curtin
+ *
+ * Definition of VPTreeSplit, a class that splits a binary space partitioning
+ * tree node into two parts using the median distance of the points in the node
+ * from a vantage point.
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_VP_TREE_SPLIT_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_VP_TREE_SPLIT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree /** Trees and tree-building procedures. */ {
+
+/**
+ * A binary space partitioning tree node is split into its left and right child
+ * around a vantage point: the points closer to the vantage point than the
+ * median distance go to the left child, and the others go to the right child.
+ * The vantage point of a node is the center of its bound, which must be a
+ * bound (such as HollowBallBound) whose center is one of the points of the
+ * node.
+ *
+ * The center of a HollowBallBound is the first point of the node, so after the
+ * points are divided, the point of each child that is furthest from the vantage
+ * point is moved to the front of the child; this makes the vantage point of
+ * each child a point near the edge of the child, which spreads the distances
+ * from it (as Yianilos suggests) without computing any more distances.
+ *
+ * For more information, see the following paper.
+ *
+ * @code
+ * @inproceedings{yianilos1993data,
+ *   title={Data structures and algorithms for nearest neighbor search in
+ *       general metric spaces},
+ *   author={Yianilos, P.N.},
+ *   booktitle={Proceedings of the Fourth Annual ACM-SIAM Symposium on Discrete
+ *       Algorithms (SODA 1993)},
+ *   pages={311--321},
+ *   year={1993}
+ * }
+ * @endcode
+ */
+template<typename BoundType, typename MatType = arma::mat>
+class VPTreeSplit
+{
+ public:
+  /**
+   * Split the node according to the median distance of its points from the
+   * vantage point (the center of the bound).
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   */
+  static bool SplitNode(const BoundType& bound,
+                        MatType& data,
+                        const size_t begin,
+                        const size_t count,
+                        size_t& splitCol);
+
+  /**
+   * Split the node according to the median distance of its points from the
+   * vantage point (the center of the bound) and return a list of changed
+   * indices.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   * @param oldFromNew Vector which will be filled with the old positions for
+   *    each new point.
+   */
+  static bool SplitNode(const BoundType& bound,
+                        MatType& data,
+                        const size_t begin,
+                        const size_t count,
+                        size_t& splitCol,
+                        std::vector<size_t>& oldFromNew);
+
+ private:
+  /**
+   * Reorder the points of the node so that the points closer to the vantage
+   * point than the median distance come first, and move the point of each part
+   * that is furthest from the vantage point to the front of that part.  If all
+   * the points are the same distance from the vantage point, false is
+   * returned and nothing is changed.
+   *
+   * @param bound The bound used for this node.
+   * @param data The dataset used by the binary space tree.
+   * @param begin Index of the starting point in the dataset that belongs to
+   *    this node.
+   * @param count Number of points in this node.
+   * @param splitCol The index at which the dataset is divided into two parts
+   *    after the rearrangement.
+   * @param oldFromNew Vector which will be filled with the old positions for
+   *    each new point (may be NULL).
+   */
+  static bool PerformSplit(const BoundType& bound,
+                           MatType& data,
+                           const size_t begin,
+                           const size_t count,
+                           size_t& splitCol,
+                           std::vector<size_t>* oldFromNew);
+
+  //! Swap two points (and their distances and indices).
+  static void Swap(MatType& data,
+                   arma::vec& distances,
+                   const size_t begin,
+                   const size_t i,
+                   const size_t j,
+                   std::vector<size_t>* oldFromNew);
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "vp_tree_split_impl.hpp"
+
+#endif
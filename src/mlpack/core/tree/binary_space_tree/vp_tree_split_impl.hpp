@@ -0,0 +1,112 @@
+/**
+ * @file vp_tree_split_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of class (VPTreeSplit) to split a binary space partition tree
+ * around a vantage point.
+ */
+#ifndef __MLPACK_CORE_TREE_BINARY_SPACE_TREE_VP_TREE_SPLIT_IMPL_HPP
+#define __MLPACK_CORE_TREE_BINARY_SPACE_TREE_VP_TREE_SPLIT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "vp_tree_split.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace tree {
+
+template<typename BoundType, typename MatType>
+bool VPTreeSplit<BoundType, MatType>::SplitNode(const BoundType& bound,
+                                                MatType& data,
+                                                const size_t begin,
+                                                const size_t count,
+                                                size_t& splitCol)
+{
+  return PerformSplit(bound, data, begin, count, splitCol, NULL);
+}
+
+template<typename BoundType, typename MatType>
+bool VPTreeSplit<BoundType, MatType>::SplitNode(const BoundType& bound,
+                                                MatType& data,
+                                                const size_t begin,
+                                                const size_t count,
+                                                size_t& splitCol,
+                                                std::vector<size_t>& oldFromNew)
+{
+  return PerformSplit(bound, data, begin, count, splitCol, &oldFromNew);
+}
+
+template<typename BoundType, typename MatType>
+bool VPTreeSplit<BoundType, MatType>::PerformSplit(
+    const BoundType& bound,
+    MatType& data,
+    const size_t begin,
+    const size_t count,
+    size_t& splitCol,
+    std::vector<size_t>* oldFromNew)
+{
+  // Calculate the distance of each point from the vantage point.
+  arma::vec distances(count);
+  for (size_t i = 0; i < count; ++i)
+    distances[i] = bound.Metric().Evaluate(bound.Center(),
+        data.col(begin + i));
+
+  const double minDistance = distances.min();
+  if (distances.max() == minDistance)
+    return false; // The points can't be separated.
+
+  arma::vec sorted(distances);
+  std::nth_element(sorted.begin(), sorted.begin() + count / 2, sorted.end());
+  const double median = sorted[count / 2];
+
+  // Points closer than the median go to the left.  If the median is the
+  // smallest distance, that would leave the left child empty, so then the
+  // points at the median distance go to the left too.  Either way, both
+  // children get at least one point.
+  const bool inclusive = (median == minDistance);
+  size_t left = 0;
+  size_t right = count;
+  while (left < right)
+  {
+    if (distances[left] < median || (inclusive && distances[left] == median))
+      ++left;
+    else
+      Swap(data, distances, begin, left, --right, oldFromNew);
+  }
+
+  // Move the furthest point of each part to its front, so that it becomes the
+  // vantage point of the child.
+  const size_t leftFurthest = std::max_element(distances.begin(),
+      distances.begin() + left) - distances.begin();
+  Swap(data, distances, begin, 0, leftFurthest, oldFromNew);
+  const size_t rightFurthest = std::max_element(distances.begin() + left,
+      distances.end()) - distances.begin();
+  Swap(data, distances, begin, left, rightFurthest, oldFromNew);
+
+  splitCol = begin + left;
+  return true;
+}
+
+template<typename BoundType, typename MatType>
+void VPTreeSplit<BoundType, MatType>::Swap(MatType& data,
+                                           arma::vec& distances,
+                                           const size_t begin,
+                                           const size_t i,
+                                           const size_t j,
+                                           std::vector<size_t>* oldFromNew)
+{
+  if (i == j)
+    return;
+
+  data.swap_cols(begin + i, begin + j);
+  std::swap(distances[i], distances[j]);
+
+  if (oldFromNew != NULL)
+    std::swap((*oldFromNew)[begin + i], (*oldFromNew)[begin + j]);
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
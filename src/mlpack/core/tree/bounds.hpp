@@ -13,5 +13,6 @@
 #include "bound_traits.hpp"
 #include "hrectbound.hpp"
 #include "ballbound.hpp"
+#include "hollow_ball_bound.hpp"
 
 #endif // __MLPACK_CORE_TREE_BOUNDS_HPP
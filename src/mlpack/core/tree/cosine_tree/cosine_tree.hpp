@@ -13,17 +13,43 @@
 namespace mlpack {
 namespace tree {
 
-// Predeclare classes for CosineNodeQueue typedef.
-class CompareCosineNode;
-class CosineTree;
+class CompareCosineNode
+{
+ public:
 
-// CosineNodeQueue typedef.
-typedef boost::heap::priority_queue<CosineTree*,
-    boost::heap::compare<CompareCosineNode> > CosineNodeQueue;
+  // Comparison function for construction of priority queue.
+  template<typename TreeType>
+  bool operator() (const TreeType* a, const TreeType* b) const
+  {
+    return a->L2Error() < b->L2Error();
+  }
+};
 
-class CosineTree
+/**
+ * A cosine tree, used by QUIC-SVD to build a low-error subspace of the columns
+ * of a matrix.  The tree can be built on any dense Armadillo matrix type, so
+ * float data (arma::fmat) is supported as well as double data; the basis and
+ * the centroids are stored in the element type of the matrix, and the error
+ * estimates are calculated in double precision.
+ *
+ * If mlpack is compiled with OpenMP, the work on the columns of a node (norms,
+ * centroids and cosines) and the projections onto the basis vectors of the
+ * nodes in the priority queue are done in parallel.
+ *
+ * @tparam MatType Type of matrix the tree is built on.
+ */
+template<typename MatType = arma::mat>
+class CosineTreeType
 {
  public:
+  //! The element type of the matrix.
+  typedef typename MatType::elem_type ElemType;
+  //! The type of the centroids and basis vectors.
+  typedef arma::Col<ElemType> VecType;
+  //! The type of the priority queue of nodes.
+  typedef boost::heap::priority_queue<CosineTreeType*,
+      boost::heap::compare<CompareCosineNode> > NodeQueue;
+
   /**
    * CosineTree constructor for the root node of the tree. It initializes the
    * necessary variables required for splitting of the node, and building the
@@ -32,7 +58,7 @@ class CosineTree
    *
    * @param dataset Matrix for which cosine tree is constructed.
    */
-  CosineTree(const arma::mat& dataset);
+  CosineTreeType(const MatType& dataset);
 
   /**
    * CosineTree constructor for nodes other than the root node of the tree. It
@@ -43,7 +69,8 @@ class CosineTree
    * @param parentNode Pointer to the parent cosine node.
    * @param subIndices Pointer to vector of column indices to be included.
    */
-  CosineTree(CosineTree& parentNode, const std::vector<size_t>& subIndices);
+  CosineTreeType(CosineTreeType& parentNode,
+                 const std::vector<size_t>& subIndices);
 
   /**
    * Construct the CosineTree and the basis for the given matrix, and passed
@@ -59,14 +86,14 @@ class CosineTree
    * @param epsilon Error tolerance fraction for calculated subspace.
    * @param delta Cumulative probability for Monte Carlo error lower bound.
    */
-  CosineTree(const arma::mat& dataset,
-             const double epsilon,
-             const double delta);
+  CosineTreeType(const MatType& dataset,
+                 const double epsilon,
+                 const double delta);
 
   /**
    * Clean up the CosineTree: release allocated memory (including children).
    */
-  ~CosineTree();
+  ~CosineTreeType();
 
   /**
    * Calculates the orthonormalization of the passed centroid, with respect to
@@ -77,10 +104,10 @@ class CosineTree
    * @param newBasisVector Orthonormalized centroid of the node.
    * @param addBasisVector Address to additional basis vector.
    */
-  void ModifiedGramSchmidt(CosineNodeQueue& treeQueue,
-                           arma::vec& centroid,
-                           arma::vec& newBasisVector,
-                           arma::vec* addBasisVector = NULL);
+  void ModifiedGramSchmidt(NodeQueue& treeQueue,
+                           VecType& centroid,
+                           VecType& newBasisVector,
+                           VecType* addBasisVector = NULL);
 
   /**
    * Estimates the squared error of the projection of the input node's matrix
@@ -94,17 +121,17 @@ class CosineTree
    * @param addBasisVector1 Address to first additional basis vector.
    * @param addBasisVector2 Address to second additional basis vector.
    */
-  double MonteCarloError(CosineTree* node,
-                         CosineNodeQueue& treeQueue,
-                         arma::vec* addBasisVector1 = NULL,
-                         arma::vec* addBasisVector2 = NULL);
+  double MonteCarloError(CosineTreeType* node,
+                         NodeQueue& treeQueue,
+                         VecType* addBasisVector1 = NULL,
+                         VecType* addBasisVector2 = NULL);
 
   /**
    * Constructs the final basis matrix, after the cosine tree construction.
    *
    * @param treeQueue Priority queue of cosine nodes.
    */
-  void ConstructBasis(CosineNodeQueue& treeQueue);
+  void ConstructBasis(NodeQueue& treeQueue);
 
   /**
    * This function splits the cosine node into two children based on the cosines
@@ -161,10 +188,10 @@ class CosineTree
   void CalculateCentroid();
 
   //! Returns the basis of the constructed subspace.
-  void GetFinalBasis(arma::mat& finalBasis) { finalBasis = basis; }
+  void GetFinalBasis(MatType& finalBasis) { finalBasis = basis; }
 
   //! Get pointer to the dataset matrix.
-  const arma::mat& GetDataset() const { return dataset; }
+  const MatType& GetDataset() const { return dataset; }
 
   //! Get the indices of columns in the node.
   std::vector<size_t>& VectorIndices() { return indices; }
@@ -175,28 +202,28 @@ class CosineTree
   double L2Error() const { return l2Error; }
 
   //! Get pointer to the centroid vector.
-  arma::vec& Centroid() { return centroid; }
+  VecType& Centroid() { return centroid; }
 
   //! Set the basis vector of the node.
-  void BasisVector(arma::vec& bVector) { this->basisVector = bVector; }
+  void BasisVector(VecType& bVector) { this->basisVector = bVector; }
 
   //! Get the basis vector of the node.
-  arma::vec& BasisVector() { return basisVector; }
+  VecType& BasisVector() { return basisVector; }
 
   //! Get pointer to the parent node.
-  CosineTree* Parent() const { return parent; }
+  CosineTreeType* Parent() const { return parent; }
   //! Modify the pointer to the parent node.
-  CosineTree*& Parent() { return parent; }
+  CosineTreeType*& Parent() { return parent; }
 
   //! Get pointer to the left child of the node.
-  CosineTree* Left() const { return left; }
+  CosineTreeType* Left() const { return left; }
   //! Modify the pointer to the left child of the node.
-  CosineTree*& Left() { return left; }
+  CosineTreeType*& Left() { return left; }
 
   //! Get pointer to the right child of the node.
-  CosineTree* Right() const { return right; }
+  CosineTreeType* Right() const { return right; }
   //! Modify the pointer to the left child of the node.
-  CosineTree*& Right() { return right; }
+  CosineTreeType*& Right() { return right; }
 
   //! Get number of columns of input matrix in the node.
   size_t NumColumns() const { return numColumns; }
@@ -209,25 +236,25 @@ class CosineTree
 
  private:
   //! Matrix for which cosine tree is constructed.
-  const arma::mat& dataset;
+  const MatType& dataset;
   //! Cumulative probability for Monte Carlo error lower bound.
   double delta;
   //! Subspace basis of the input dataset.
-  arma::mat basis;
+  MatType basis;
   //! Parent of the node.
-  CosineTree* parent;
+  CosineTreeType* parent;
   //! Left child of the node.
-  CosineTree* left;
+  CosineTreeType* left;
   //! Right child of the node.
-  CosineTree* right;
+  CosineTreeType* right;
   //! Indices of columns of input matrix in the node.
   std::vector<size_t> indices;
   //! L2-norm squared of columns in the node.
   arma::vec l2NormsSquared;
   //! Centroid of columns of input matrix in the node.
-  arma::vec centroid;
+  VecType centroid;
   //! Orthonormalized basis vector of the node.
-  arma::vec basisVector;
+  VecType basisVector;
   //! Index of split point of cosine node.
   size_t splitPointIndex;
   //! Number of columns of input matrix in the node.
@@ -238,18 +265,16 @@ class CosineTree
   double frobNormSquared;
 };
 
-class CompareCosineNode
-{
- public:
+//! The cosine tree on double data.
+typedef CosineTreeType<arma::mat> CosineTree;
 
-  // Comparison function for construction of priority queue.
-  bool operator() (const CosineTree* a, const CosineTree* b) const
-  {
-    return a->L2Error() < b->L2Error();
-  }
-};
+//! The priority queue of nodes of a cosine tree on double data.
+typedef CosineTree::NodeQueue CosineNodeQueue;
 
 }; // namespace tree
 }; // namespace mlpack
 
+// Include implementation.
+#include "cosine_tree_impl.hpp"
+
 #endif
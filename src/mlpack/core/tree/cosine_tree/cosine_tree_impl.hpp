@@ -4,6 +4,10 @@
  *
  * Implementation of cosine tree.
  */
+#ifndef __MLPACK_CORE_TREE_COSINE_TREE_COSINE_TREE_IMPL_HPP
+#define __MLPACK_CORE_TREE_COSINE_TREE_COSINE_TREE_IMPL_HPP
+
+// In case it hasn't been included yet.
 #include "cosine_tree.hpp"
 
 #include <boost/math/distributions/normal.hpp>
@@ -11,7 +15,8 @@
 namespace mlpack {
 namespace tree {
 
-CosineTree::CosineTree(const arma::mat& dataset) :
+template<typename MatType>
+CosineTreeType<MatType>::CosineTreeType(const MatType& dataset) :
     dataset(dataset),
     parent(NULL),
     left(NULL),
@@ -23,6 +28,7 @@ CosineTree::CosineTree(const arma::mat& dataset) :
   l2NormsSquared.zeros(numColumns);
 
   // Set indices and calculate squared norms of the columns.
+  #pragma omp parallel for schedule(static)
   for(size_t i = 0; i < numColumns; i++)
   {
     indices[i] = i;
@@ -39,8 +45,9 @@ CosineTree::CosineTree(const arma::mat& dataset) :
   splitPointIndex = ColumnSampleLS();
 }
 
-CosineTree::CosineTree(CosineTree& parentNode,
-                       const std::vector<size_t>& subIndices) :
+template<typename MatType>
+CosineTreeType<MatType>::CosineTreeType(CosineTreeType& parentNode,
+                                        const std::vector<size_t>& subIndices) :
     dataset(parentNode.GetDataset()),
     parent(&parentNode),
     left(NULL),
@@ -67,20 +74,21 @@ CosineTree::CosineTree(CosineTree& parentNode,
   splitPointIndex = ColumnSampleLS();
 }
 
-CosineTree::CosineTree(const arma::mat& dataset,
-                       const double epsilon,
-                       const double delta) :
+template<typename MatType>
+CosineTreeType<MatType>::CosineTreeType(const MatType& dataset,
+                                        const double epsilon,
+                                        const double delta) :
     dataset(dataset),
     delta(delta),
     left(NULL),
     right(NULL)
 {
   // Declare the cosine tree priority queue.
-  CosineNodeQueue treeQueue;
+  NodeQueue treeQueue;
 
   // Define root node of the tree and add it to the queue.
-  CosineTree root(dataset);
-  arma::vec tempVector = arma::zeros(dataset.n_rows);
+  CosineTreeType root(dataset);
+  VecType tempVector = arma::zeros<VecType>(dataset.n_rows);
   root.L2Error(0);
   root.BasisVector(tempVector);
   treeQueue.push(&root);
@@ -91,7 +99,7 @@ CosineTree::CosineTree(const arma::mat& dataset,
   while (monteCarloError > epsilon * root.FrobNormSquared())
   {
     // Pop node from queue with highest projection error.
-    CosineTree* currentNode;
+    CosineTreeType* currentNode;
     currentNode = treeQueue.top();
     treeQueue.pop();
 
@@ -99,12 +107,12 @@ CosineTree::CosineTree(const arma::mat& dataset,
     currentNode->CosineNodeSplit();
 
     // Obtain pointers to the left and right children of the current node.
-    CosineTree *currentLeft, *currentRight;
+    CosineTreeType *currentLeft, *currentRight;
     currentLeft = currentNode->Left();
     currentRight = currentNode->Right();
 
     // Calculate basis vectors of left and right children.
-    arma::vec lBasisVector, rBasisVector;
+    VecType lBasisVector, rBasisVector;
 
     ModifiedGramSchmidt(treeQueue, currentLeft->Centroid(), lBasisVector);
     ModifiedGramSchmidt(treeQueue, currentRight->Centroid(), rBasisVector,
@@ -130,7 +138,8 @@ CosineTree::CosineTree(const arma::mat& dataset,
   ConstructBasis(treeQueue);
 }
 
-CosineTree::~CosineTree()
+template<typename MatType>
+CosineTreeType<MatType>::~CosineTreeType()
 {
   if (left)
     delete left;
@@ -138,33 +147,49 @@ CosineTree::~CosineTree()
     delete right;
 }
 
-void CosineTree::ModifiedGramSchmidt(CosineNodeQueue& treeQueue,
-                                     arma::vec& centroid,
-                                     arma::vec& newBasisVector,
-                                     arma::vec* addBasisVector)
+template<typename MatType>
+void CosineTreeType<MatType>::ModifiedGramSchmidt(NodeQueue& treeQueue,
+                                                  VecType& centroid,
+                                                  VecType& newBasisVector,
+                                                  VecType* addBasisVector)
 {
-  // Set new basis vector to centroid.
-  newBasisVector = centroid;
-
-  // Variables for iterating throught the priority queue.
-  CosineTree *currentNode;
-  CosineNodeQueue::const_iterator i = treeQueue.begin();
-
-  // For every vector in the current basis, remove its projection from the
-  // centroid.
+  // Collect the vectors of the current basis, and the additional basis vector
+  // if it is passed.
+  std::vector<const VecType*> basisVectors;
+  basisVectors.reserve(treeQueue.size() + 1);
+  typename NodeQueue::const_iterator i = treeQueue.begin();
   for(; i != treeQueue.end(); i++)
-  {
-    currentNode = *i;
-
-    double projection = arma::dot(currentNode->BasisVector(), centroid);
-    newBasisVector -= projection * currentNode->BasisVector();
-  }
-
-  // If additional basis vector is passed, take it into account.
+    basisVectors.push_back(&(*i)->BasisVector());
   if(addBasisVector)
+    basisVectors.push_back(addBasisVector);
+
+  // Compute the projections of the centroid onto every basis vector.  These
+  // are independent of each other, so they are computed in parallel.
+  const size_t numBasis = basisVectors.size();
+  VecType projections(numBasis);
+  #pragma omp parallel for schedule(static)
+  for(size_t k = 0; k < numBasis; k++)
+    projections[k] = arma::dot(*basisVectors[k], centroid);
+
+  // Remove the projections from the centroid, in parallel over blocks of rows,
+  // so that each block of every basis vector is read only once.
+  newBasisVector = centroid;
+  const size_t numRows = centroid.n_elem;
+  const size_t blockSize = 256;
+  const size_t numBlocks = (numRows + blockSize - 1) / blockSize;
+  ElemType* newBasis = newBasisVector.memptr();
+  #pragma omp parallel for schedule(static)
+  for(size_t b = 0; b < numBlocks; b++)
   {
-    double projection = arma::dot(*addBasisVector, centroid);
-    newBasisVector -= *addBasisVector * projection;
+    const size_t begin = b * blockSize;
+    const size_t end = std::min(numRows, begin + blockSize);
+    for(size_t k = 0; k < numBasis; k++)
+    {
+      const ElemType* basisVector = basisVectors[k]->memptr();
+      const ElemType projection = projections[k];
+      for(size_t r = begin; r < end; r++)
+        newBasis[r] -= projection * basisVector[r];
+    }
   }
 
   // Normalize the modified centroid vector.
@@ -172,10 +197,11 @@ void CosineTree::ModifiedGramSchmidt(CosineNodeQueue& treeQueue,
     newBasisVector /= arma::norm(newBasisVector, 2);
 }
 
-double CosineTree::MonteCarloError(CosineTree* node,
-                                   CosineNodeQueue& treeQueue,
-                                   arma::vec* addBasisVector1,
-                                   arma::vec* addBasisVector2)
+template<typename MatType>
+double CosineTreeType<MatType>::MonteCarloError(CosineTreeType* node,
+                                                NodeQueue& treeQueue,
+                                                VecType* addBasisVector1,
+                                                VecType* addBasisVector2)
 {
   std::vector<size_t> sampledIndices;
   arma::vec probabilities;
@@ -185,55 +211,41 @@ double CosineTree::MonteCarloError(CosineTree* node,
   size_t numSamples = log(node->NumColumns()) + 1;
   node->ColumnSamplesLS(sampledIndices, probabilities, numSamples);
 
-  // Get pointer to the original dataset.
-  arma::mat dataset = node->GetDataset();
+  // Get a reference to the original dataset.
+  const MatType& dataset = node->GetDataset();
 
-  // Initialize weighted projection magnitudes as zeros.
-  arma::vec weightedMagnitudes;
-  weightedMagnitudes.zeros(numSamples);
-
-  // Set size of projection vector, depending on whether additional basis
-  // vectors are passed.
-  size_t projectionSize;
+  // Collect the vectors of the current basis, and the two additional basis
+  // vectors if they are passed.
+  std::vector<const VecType*> basisVectors;
+  basisVectors.reserve(treeQueue.size() + 2);
+  typename NodeQueue::const_iterator j = treeQueue.begin();
+  for(; j != treeQueue.end(); j++)
+    basisVectors.push_back(&(*j)->BasisVector());
   if(addBasisVector1 && addBasisVector2)
-    projectionSize = treeQueue.size() + 2;
-  else
-    projectionSize = treeQueue.size();
-
-  // For each sample, calculate the weighted projection onto the current basis.
-  for(size_t i = 0; i < numSamples; i++)
   {
-    // Initialize projection as a vector of zeros.
-    arma::vec projection;
-    projection.zeros(projectionSize);
-
-    CosineTree *currentNode;
-    CosineNodeQueue::const_iterator j = treeQueue.begin();
-
-    size_t k = 0;
-    // Compute the projection of the sampled vector onto the existing subspace.
-    for(; j != treeQueue.end(); j++, k++)
-    {
-      currentNode = *j;
-
-      projection(k) = arma::dot(dataset.col(sampledIndices[i]),
-                                currentNode->BasisVector());
-    }
-    // If two additional vectors are passed, take their projections.
-    if(addBasisVector1 && addBasisVector2)
-    {
-      projection(k++) = arma::dot(dataset.col(sampledIndices[i]),
-                                  *addBasisVector1);
-      projection(k) = arma::dot(dataset.col(sampledIndices[i]),
-                                *addBasisVector2);
-    }
+    basisVectors.push_back(addBasisVector1);
+    basisVectors.push_back(addBasisVector2);
+  }
 
-    // Calculate the Frobenius norm squared of the projected vector.
-    double frobProjection = arma::norm(projection, "frob");
-    double frobProjectionSquared = frobProjection * frobProjection;
+  // Compute the projection of each sampled vector onto each basis vector; the
+  // basis vectors are handled in parallel.
+  const size_t numBasis = basisVectors.size();
+  arma::mat projections(numBasis, numSamples);
+  #pragma omp parallel for schedule(static)
+  for(size_t k = 0; k < numBasis; k++)
+  {
+    for(size_t i = 0; i < numSamples; i++)
+      projections(k, i) = arma::dot(dataset.col(sampledIndices[i]),
+                                    *basisVectors[k]);
+  }
 
-    // Calculate the weighted projection magnitude.
-    weightedMagnitudes(i) = frobProjectionSquared / probabilities(i);
+  // Calculate the weighted projection magnitude of each sample, which is the
+  // squared norm of its projection onto the basis.
+  arma::vec weightedMagnitudes(numSamples);
+  for(size_t i = 0; i < numSamples; i++)
+  {
+    weightedMagnitudes(i) = arma::dot(projections.col(i), projections.col(i)) /
+        probabilities(i);
   }
 
   // Compute mean and standard deviation of the weighted samples.
@@ -257,14 +269,15 @@ double CosineTree::MonteCarloError(CosineTree* node,
   return (node->FrobNormSquared() - lowerBound);
 }
 
-void CosineTree::ConstructBasis(CosineNodeQueue& treeQueue)
+template<typename MatType>
+void CosineTreeType<MatType>::ConstructBasis(NodeQueue& treeQueue)
 {
   // Initialize basis as matrix of zeros.
   basis.zeros(dataset.n_rows, treeQueue.size());
 
   // Variables for iterating through the priority queue.
-  CosineTree *currentNode;
-  CosineNodeQueue::const_iterator i = treeQueue.begin();
+  CosineTreeType *currentNode;
+  typename NodeQueue::const_iterator i = treeQueue.begin();
 
   // Transfer basis vectors from the queue to the basis matrix.
   size_t j = 0;
@@ -275,7 +288,8 @@ void CosineTree::ConstructBasis(CosineNodeQueue& treeQueue)
   }
 }
 
-void CosineTree::CosineNodeSplit()
+template<typename MatType>
+void CosineTreeType<MatType>::CosineNodeSplit()
 {
   //! If less than two nodes, splitting does not make sense.
   if(numColumns < 3) return;
@@ -307,13 +321,15 @@ void CosineTree::CosineNodeSplit()
   }
 
   // Split the node into left and right children.
-  left = new CosineTree(*this, leftIndices);
-  right = new CosineTree(*this, rightIndices);
+  left = new CosineTreeType(*this, leftIndices);
+  right = new CosineTreeType(*this, rightIndices);
 }
 
-void CosineTree::ColumnSamplesLS(std::vector<size_t>& sampledIndices,
-                                 arma::vec& probabilities,
-                                 size_t numSamples)
+template<typename MatType>
+void CosineTreeType<MatType>::ColumnSamplesLS(
+    std::vector<size_t>& sampledIndices,
+    arma::vec& probabilities,
+    size_t numSamples)
 {
   // Initialize the cumulative distribution vector size.
   arma::vec cDistribution;
@@ -342,7 +358,8 @@ void CosineTree::ColumnSamplesLS(std::vector<size_t>& sampledIndices,
   }
 }
 
-size_t CosineTree::ColumnSampleLS()
+template<typename MatType>
+size_t CosineTreeType<MatType>::ColumnSampleLS()
 {
   // If only one element is present, there can only be one sample.
   if(numColumns < 2)
@@ -368,10 +385,11 @@ size_t CosineTree::ColumnSampleLS()
   return BinarySearch(cDistribution, randValue, start, end);
 }
 
-size_t CosineTree::BinarySearch(arma::vec& cDistribution,
-                                double value,
-                                size_t start,
-                                size_t end)
+template<typename MatType>
+size_t CosineTreeType<MatType>::BinarySearch(arma::vec& cDistribution,
+                                             double value,
+                                             size_t start,
+                                             size_t end)
 {
   size_t pivot = (start + end) / 2;
 
@@ -396,11 +414,15 @@ size_t CosineTree::BinarySearch(arma::vec& cDistribution,
   }
 }
 
-void CosineTree::CalculateCosines(arma::vec& cosines)
+template<typename MatType>
+void CosineTreeType<MatType>::CalculateCosines(arma::vec& cosines)
 {
   // Initialize cosine vector as a vector of zeros.
   cosines.zeros(numColumns);
 
+  // The cosines of the columns are independent, so they are calculated in
+  // parallel.
+  #pragma omp parallel for schedule(static)
   for(size_t i = 0; i < numColumns; i++)
   {
     // If norm is zero, store cosine value as zero. Else, calculate cosine value
@@ -417,18 +439,31 @@ void CosineTree::CalculateCosines(arma::vec& cosines)
   }
 }
 
-void CosineTree::CalculateCentroid()
+template<typename MatType>
+void CosineTreeType<MatType>::CalculateCentroid()
 {
   // Initialize centroid as vector of zeros.
   centroid.zeros(dataset.n_rows);
 
-  // Calculate centroid of columns in the node.
-  for(size_t i = 0; i < numColumns; i++)
+  // Calculate centroid of columns in the node.  Each thread sums its share of
+  // the columns, and the partial sums are added up at the end.
+  #pragma omp parallel
   {
-    centroid += dataset.col(indices[i]);
+    VecType partialSum = arma::zeros<VecType>(dataset.n_rows);
+
+    #pragma omp for schedule(static)
+    for(size_t i = 0; i < numColumns; i++)
+    {
+      partialSum += dataset.col(indices[i]);
+    }
+
+    #pragma omp critical
+    centroid += partialSum;
   }
   centroid /= numColumns;
 }
 
 }; // namespace tree
 }; // namespace mlpack
+
+#endif
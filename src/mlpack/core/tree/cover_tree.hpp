@@ -9,6 +9,7 @@
 
 #include <mlpack/core.hpp>
 #include "cover_tree/first_point_is_root.hpp"
+#include "cover_tree/reorder_points.hpp"
 #include "cover_tree/cover_tree.hpp"
 #include "cover_tree/single_tree_traverser.hpp"
 #include "cover_tree/single_tree_traverser_impl.hpp"
@@ -10,7 +10,10 @@
 #include <mlpack/core.hpp>
 
 #include "../statistic.hpp"
+#include "../node_arena.hpp"
+#include "../queue_dual_tree_traverser.hpp"
 #include "first_point_is_root.hpp"
+#include "reorder_points.hpp"
 
 namespace mlpack {
 namespace tree {
@@ -142,6 +145,71 @@ class CoverTree
             MetricType& metric,
             const double base = 2.0);
 
+  /**
+   * Create the cover tree with the given dataset and given base, then reorder
+   * the points of the dataset into the depth-first order of the tree, so that
+   * the descendants of each node are contiguous columns of Dataset().  The
+   * tree holds the reordered copy of the dataset; the original dataset is not
+   * modified.  The column i of Dataset() is the column oldFromNew[i] of the
+   * original dataset.
+   *
+   * @param dataset Reference to the dataset to build a tree on.
+   * @param oldFromNew Vector which will be filled with the old position for
+   *     each new point.
+   * @param base Base to use during tree building (default 2.0).
+   * @param metric Instantiated metric to use during tree building (optional).
+   */
+  CoverTree(const MatType& dataset,
+            std::vector<size_t>& oldFromNew,
+            const double base = 2.0,
+            MetricType* metric = NULL);
+
+  /**
+   * Create the cover tree with the given dataset and the given instantiated
+   * metric, then reorder the points of the dataset into the depth-first order
+   * of the tree.  The original dataset is not modified.
+   *
+   * @param dataset Reference to the dataset to build a tree on.
+   * @param metric Instantiated metric to use during tree building.
+   * @param oldFromNew Vector which will be filled with the old position for
+   *     each new point.
+   * @param base Base to use during tree building (default 2.0).
+   */
+  CoverTree(const MatType& dataset,
+            MetricType& metric,
+            std::vector<size_t>& oldFromNew,
+            const double base = 2.0);
+
+  /**
+   * Create the cover tree with the given dataset, taking ownership of the
+   * dataset, then reorder the points of the dataset into the depth-first order
+   * of the tree.
+   *
+   * @param dataset Reference to the dataset to build a tree on.
+   * @param oldFromNew Vector which will be filled with the old position for
+   *     each new point.
+   * @param base Base to use during tree building (default 2.0).
+   */
+  CoverTree(MatType&& dataset,
+            std::vector<size_t>& oldFromNew,
+            const double base = 2.0);
+
+  /**
+   * Create the cover tree with the given dataset and the given instantiated
+   * metric, taking ownership of the dataset, then reorder the points of the
+   * dataset into the depth-first order of the tree.
+   *
+   * @param dataset Reference to the dataset to build a tree on.
+   * @param metric Instantiated metric to use during tree building.
+   * @param oldFromNew Vector which will be filled with the old position for
+   *     each new point.
+   * @param base Base to use during tree building (default 2.0).
+   */
+  CoverTree(MatType&& dataset,
+            MetricType& metric,
+            std::vector<size_t>& oldFromNew,
+            const double base = 2.0);
+
   /**
    * Construct a child cover tree node.  This constructor is not meant to be
    * used externally, but it could be used to insert another node into a tree.
@@ -232,6 +300,15 @@ class CoverTree
    */
   ~CoverTree();
 
+  /**
+   * Allocate memory for a node.  While a NodeArena::Scope is alive, nodes are
+   * taken from its arena; otherwise, they come from the heap.
+   */
+  static void* operator new(size_t size) { return NodeArena::Allocate(size); }
+
+  //! Free memory given by operator new(); see NodeArena.
+  static void operator delete(void* memory) { NodeArena::Free(memory); }
+
   //! A single-tree cover tree traverser; see single_tree_traverser.hpp for
   //! implementation.
   template<typename RuleType>
@@ -244,6 +321,18 @@ class CoverTree
   template<typename RuleType>
   using BreadthFirstDualTreeTraverser = DualTreeTraverser<RuleType>;
 
+  //! A dual-tree traverser that expands the node combinations breadth-first;
+  //! see queue_dual_tree_traverser.hpp.
+  template<typename RuleType>
+  using LevelOrderDualTreeTraverser =
+      QueueDualTreeTraverser<CoverTree, RuleType, false>;
+
+  //! A dual-tree traverser that expands the node combinations in order of
+  //! their scores; see queue_dual_tree_traverser.hpp.
+  template<typename RuleType>
+  using PrioritizedDualTreeTraverser =
+      QueueDualTreeTraverser<CoverTree, RuleType, true>;
+
   //! Get a reference to the dataset.
   const MatType& Dataset() const { return *dataset; }
 
@@ -399,6 +488,24 @@ class CoverTree
   //! The metric used for this tree.
   MetricType* metric;
 
+  /**
+   * Replace the dataset of the tree (the root) with a copy whose columns are in
+   * the depth-first order of the tree: each point is placed where it is first
+   * met by a preorder traversal (which visits the self-child first), so that
+   * the points of each node are the columns [Point(), Point() +
+   * NumDescendants()).  The point of every node is changed to match.
+   *
+   * @param oldFromNew Vector which will be filled with the old position for
+   *     each new point.
+   */
+  void ReorderDataset(std::vector<size_t>& oldFromNew);
+
+  /**
+   * Distances from a point to point sets at least this large are calculated in
+   * parallel (if mlpack is compiled with OpenMP).
+   */
+  static const size_t ParallelDistanceThreshold = 2048;
+
   /**
    * Create the children for this node.
    */
@@ -412,7 +519,9 @@ class CoverTree
    * Fill the vector of distances with the distances between the point specified
    * by pointIndex and each point in the indices array.  The distances of the
    * first pointSetSize points in indices are calculated (so, this does not
-   * necessarily need to use all of the points in the arrays).
+   * necessarily need to use all of the points in the arrays).  Large point
+   * sets are handled in parallel; every distance is calculated the same way
+   * regardless, so the tree does not depend on the number of threads.
    *
    * @param pointIndex Point to build the distances for.
    * @param indices List of indices to compute distances for.
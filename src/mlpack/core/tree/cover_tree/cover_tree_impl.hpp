@@ -363,6 +363,123 @@ CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
       << "construction." << std::endl;
 }
 
+// Create the cover tree, then reorder the dataset.
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
+    const MatType& dataset,
+    std::vector<size_t>& oldFromNew,
+    const double base,
+    MetricType* metric) :
+    CoverTree(dataset, base, metric)
+{
+  ReorderDataset(oldFromNew);
+}
+
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
+    const MatType& dataset,
+    MetricType& metric,
+    std::vector<size_t>& oldFromNew,
+    const double base) :
+    CoverTree(dataset, metric, base)
+{
+  ReorderDataset(oldFromNew);
+}
+
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
+    MatType&& data,
+    std::vector<size_t>& oldFromNew,
+    const double base) :
+    CoverTree(std::move(data), base)
+{
+  ReorderDataset(oldFromNew);
+}
+
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::CoverTree(
+    MatType&& data,
+    MetricType& metric,
+    std::vector<size_t>& oldFromNew,
+    const double base) :
+    CoverTree(std::move(data), metric, base)
+{
+  ReorderDataset(oldFromNew);
+}
+
+// Reorder the dataset into the depth-first order of the tree.
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
+    ReorderDataset(std::vector<size_t>& oldFromNew)
+{
+  const size_t n = dataset->n_cols;
+  oldFromNew.resize(n);
+  if (n == 0)
+    return;
+
+  // Number each point when a preorder traversal first meets it.  The
+  // self-child is visited first, so the point of a node is always numbered
+  // just before its other descendants, and the descendants of each node are
+  // numbered consecutively.
+  std::vector<size_t> newFromOld(n, size_t() - 1);
+  MatType* newDataset = new MatType(dataset->n_rows, n);
+  size_t next = 0;
+
+  std::vector<CoverTree*> stack(1, this);
+  while (!stack.empty())
+  {
+    CoverTree* node = stack.back();
+    stack.pop_back();
+
+    if (newFromOld[node->point] == size_t() - 1)
+    {
+      newFromOld[node->point] = next;
+      oldFromNew[next] = node->point;
+      newDataset->col(next) = dataset->col(node->point);
+      ++next;
+    }
+
+    node->point = newFromOld[node->point];
+    node->dataset = newDataset;
+
+    // Push the children in reverse, so that the self-child is visited first.
+    for (size_t i = node->children.size(); i > 0; --i)
+      stack.push_back(node->children[i - 1]);
+  }
+
+  // The statistics only depend on the points of each node, not on where they
+  // are in the dataset, so they do not need to be rebuilt.
+  if (localDataset)
+    delete dataset;
+  dataset = newDataset;
+  localDataset = true;
+}
+
 template<
     typename MetricType,
     typename StatisticType,
@@ -1015,6 +1132,13 @@ void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
   // For each point, rebuild the distances.  The indices do not need to be
   // modified.
   distanceComps += pointSetSize;
+
+  // Only the distances are computed in parallel.  The children of a node
+  // cannot be built in parallel: each child takes points out of the near set
+  // that its later siblings would otherwise use, so the tree depends on the
+  // order in which the children are built.
+  #pragma omp parallel for if(pointSetSize >= ParallelDistanceThreshold) \
+      schedule(static)
   for (size_t i = 0; i < pointSetSize; ++i)
   {
     distances[i] = metric->Evaluate(dataset->col(pointIndex),
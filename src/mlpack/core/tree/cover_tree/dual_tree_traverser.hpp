@@ -8,6 +8,8 @@
 #define __MLPACK_CORE_TREE_COVER_TREE_DUAL_TREE_TRAVERSER_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+#include <mlpack/core/tree/prefetch.hpp>
 #include <queue>
 
 namespace mlpack {
@@ -48,10 +50,21 @@ class CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
   size_t NumScores() const { return 0; }
   size_t NumBaseCases() const { return 0; }
 
+  //! The traversal statistics policy (see TraversalStatisticsPolicy).
+  typedef typename TraversalStatisticsPolicy<RuleType>::Type
+      TraversalStatisticsType;
+
+  //! Get the statistics recorded during traversal (with the default policy,
+  //! nothing is recorded).
+  const TraversalStatisticsType& Statistics() const { return statistics; }
+
  private:
   //! The instantiated rule set for pruning branches.
   RuleType& rule;
 
+  //! The statistics recorded during traversal.
+  TraversalStatisticsType statistics;
+
   //! The number of pruned nodes.
   size_t numPrunes;
 
@@ -95,6 +108,12 @@ class CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
   void ReferenceRecursion(CoverTree& queryNode,
                           std::map<int, std::vector<DualCoverTreeMapEntry> >&
                               referenceMap);
+
+  //! Before entry i of a list of entries is visited, start loading the
+  //! reference nodes that follow it (see PrefetchAhead()).
+  static void PrefetchEntries(
+      const std::vector<DualCoverTreeMapEntry>& entries,
+      const size_t i);
 };
 
 }; // namespace tree
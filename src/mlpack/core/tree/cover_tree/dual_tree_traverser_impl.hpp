@@ -45,9 +45,10 @@ DualTreeTraverser<RuleType>::Traverse(CoverTree& queryNode,
   rootRefEntry.referenceNode = &referenceNode;
 
   // Perform the evaluation between the roots of either tree.
-  rootRefEntry.score = rule.Score(queryNode, referenceNode);
+  rootRefEntry.score = statistics.Score(rule, queryNode, referenceNode);
   rootRefEntry.baseCase = rule.BaseCase(queryNode.Point(),
       referenceNode.Point());
+  statistics.BaseCases(queryNode, referenceNode, 1);
   rootRefEntry.traversalInfo = rule.TraversalInfo();
 
   refMap[referenceNode.Scale()].push_back(rootRefEntry);
@@ -111,6 +112,8 @@ DualTreeTraverser<RuleType>::Traverse(
 
   for (size_t i = 0; i < pointVector.size(); ++i)
   {
+    PrefetchEntries(pointVector, i);
+
     // Get a reference to the frame.
     const DualCoverTreeMapEntry& frame = pointVector[i];
 
@@ -128,7 +131,7 @@ DualTreeTraverser<RuleType>::Traverse(
     // Score the node, to see if we can prune it, after restoring the traversal
     // info.
     rule.TraversalInfo() = frame.traversalInfo;
-    double score = rule.Score(queryNode, *refNode);
+    double score = statistics.Score(rule, queryNode, *refNode);
 
     if (score == DBL_MAX)
     {
@@ -138,6 +141,7 @@ DualTreeTraverser<RuleType>::Traverse(
 
     // If not, compute the base case.
     rule.BaseCase(queryNode.Point(), pointVector[i].referenceNode->Point());
+    statistics.BaseCases(queryNode, *pointVector[i].referenceNode, 1);
   }
 }
 
@@ -174,6 +178,8 @@ DualTreeTraverser<RuleType>::PruneMap(
     // Loop over each entry in the vector.
     for (size_t j = 0; j < scaleVector.size(); ++j)
     {
+      PrefetchEntries(scaleVector, j);
+
       const DualCoverTreeMapEntry& frame = scaleVector[j];
 
       // First evaluate if we can prune without performing the base case.
@@ -181,7 +187,7 @@ DualTreeTraverser<RuleType>::PruneMap(
 
       // Perform the actual scoring, after restoring the traversal info.
       rule.TraversalInfo() = frame.traversalInfo;
-      double score = rule.Score(queryNode, *refNode);
+      double score = statistics.Score(rule, queryNode, *refNode);
 
       if (score == DBL_MAX)
       {
@@ -193,6 +199,7 @@ DualTreeTraverser<RuleType>::PruneMap(
       // If it isn't pruned, we must evaluate the base case.
       const double baseCase = rule.BaseCase(queryNode.Point(),
           refNode->Point());
+      statistics.BaseCases(queryNode, *refNode, 1);
 
       // Add to child map.
       newScaleVector.push_back(frame);
@@ -227,6 +234,8 @@ DualTreeTraverser<RuleType>::PruneMap(
     // Loop over each entry in the vector.
     for (size_t j = 0; j < scaleVector.size(); ++j)
     {
+      PrefetchEntries(scaleVector, j);
+
       const DualCoverTreeMapEntry& frame = scaleVector[j];
 
       // First evaluate if we can prune without performing the base case.
@@ -234,7 +243,7 @@ DualTreeTraverser<RuleType>::PruneMap(
 
       // Perform the actual scoring, after restoring the traversal info.
       rule.TraversalInfo() = frame.traversalInfo;
-      double score = rule.Score(queryNode, *refNode);
+      double score = statistics.Score(rule, queryNode, *refNode);
 
       if (score == DBL_MAX)
       {
@@ -246,6 +255,7 @@ DualTreeTraverser<RuleType>::PruneMap(
       // If it isn't pruned, we must evaluate the base case.
       const double baseCase = rule.BaseCase(queryNode.Point(),
           refNode->Point());
+      statistics.BaseCases(queryNode, *refNode, 1);
 
       // Add to child map.
       newScaleVector.push_back(frame);
@@ -300,13 +310,15 @@ DualTreeTraverser<RuleType>::ReferenceRecursion(
     // Now loop over each element.
     for (size_t i = 0; i < scaleVector.size(); ++i)
     {
+      PrefetchEntries(scaleVector, i);
+
       // Get a reference to the current element.
       const DualCoverTreeMapEntry& frame = scaleVector.at(i);
 
       CoverTree* refNode = frame.referenceNode;
 
       // Create the score for the children.
-      double score = rule.Rescore(queryNode, *refNode, frame.score);
+      double score = statistics.Rescore(rule, queryNode, *refNode, frame.score);
 
       // Now if this childScore is DBL_MAX we can prune all children.  In this
       // recursion setup pruning is all or nothing for children.
@@ -318,11 +330,14 @@ DualTreeTraverser<RuleType>::ReferenceRecursion(
 
       // If it is not pruned, we must evaluate the base case.
 
-      // Add the children.
+      // Add the children, after asking for all of them at once.
+      for (size_t j = 0; j < refNode->NumChildren(); ++j)
+        PrefetchNode(&refNode->Child(j));
       for (size_t j = 0; j < refNode->NumChildren(); ++j)
       {
         rule.TraversalInfo() = frame.traversalInfo;
-        double childScore = rule.Score(queryNode, refNode->Child(j));
+        double childScore = statistics.Score(rule, queryNode,
+            refNode->Child(j));
         if (childScore == DBL_MAX)
         {
           ++numPrunes;
@@ -332,6 +347,7 @@ DualTreeTraverser<RuleType>::ReferenceRecursion(
         // It wasn't pruned; evaluate the base case.
         const double baseCase = rule.BaseCase(queryNode.Point(),
             refNode->Child(j).Point());
+        statistics.BaseCases(queryNode, refNode->Child(j), 1);
 
         DualCoverTreeMapEntry newFrame;
         newFrame.referenceNode = &refNode->Child(j);
@@ -348,6 +364,31 @@ DualTreeTraverser<RuleType>::ReferenceRecursion(
   }
 }
 
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+template<typename RuleType>
+void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
+DualTreeTraverser<RuleType>::PrefetchEntries(
+    const std::vector<DualCoverTreeMapEntry>& entries,
+    const size_t i)
+{
+  // Nothing was prefetched before the first entry.
+  if (i == 0)
+  {
+    PrefetchNode(entries[0].referenceNode);
+    if (entries.size() > 1)
+      PrefetchNode(entries[1].referenceNode);
+  }
+
+  PrefetchAhead(
+      (i + 1 < entries.size()) ? entries[i + 1].referenceNode : NULL,
+      (i + 2 < entries.size()) ? entries[i + 2].referenceNode : NULL);
+}
+
 }; // namespace tree
 }; // namespace mlpack
 
@@ -0,0 +1,39 @@
+/**
+ * @file reorder_points.hpp
+ * @author Ryan Curtin
+ *
+ * A policy for the cover tree which chooses the root point with another policy
+ * and marks the tree as one which reorders its dataset when it is built.
+ */
+#ifndef __MLPACK_CORE_TREE_COVER_TREE_REORDER_POINTS_HPP
+#define __MLPACK_CORE_TREE_COVER_TREE_REORDER_POINTS_HPP
+
+#include <mlpack/core.hpp>
+#include "first_point_is_root.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * This class is meant to be used as a choice for the policy class
+ * RootPointPolicy of the CoverTree class.  The root point is chosen by the
+ * given RootPointPolicy, but a cover tree with this policy has the TreeTraits
+ * RearrangesDataset set to true, so that tree-based algorithms (such as
+ * NeighborSearch, RangeSearch, and FastMKS) build it with the constructors that
+ * reorder the dataset into the depth-first order of the tree and unmap their
+ * results afterwards.  In the reordered dataset the points of each node are
+ * contiguous, so a traversal of the tree reads memory in order.
+ *
+ * @tparam RootPointPolicy Determines which point to use as the root node.
+ */
+template<typename RootPointPolicy = FirstPointIsRoot>
+class ReorderPoints : public RootPointPolicy
+{
+ public:
+  // ChooseRoot() is that of RootPointPolicy.
+};
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
@@ -10,12 +10,29 @@
 #define __MLPACK_CORE_TREE_COVER_TREE_SINGLE_TREE_TRAVERSER_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+#include <mlpack/core/tree/prefetch.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
 
 #include "cover_tree.hpp"
 
 namespace mlpack {
 namespace tree {
 
+// This gives us a HasBatchBaseCasesCheck<T, U> type (where U is a function
+// pointer) we can use with SFINAE to catch when a rule type has a
+// BatchBaseCases(...) function.
+HAS_MEM_FUNC(BatchBaseCases, HasBatchBaseCasesCheck);
+
+//! An entry of the map of nodes left to visit during a traversal.
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+struct CoverTreeMapEntry;
+
 template<
     typename MetricType,
     typename StatisticType,
@@ -46,12 +63,59 @@ class CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
   //! Set the number of prunes (good for a reset to 0).
   size_t& NumPrunes() { return numPrunes; }
 
+  //! The traversal statistics policy (see TraversalStatisticsPolicy).
+  typedef typename TraversalStatisticsPolicy<RuleType>::Type
+      TraversalStatisticsType;
+
+  //! Get the statistics recorded during traversal (with the default policy,
+  //! nothing is recorded).
+  const TraversalStatisticsType& Statistics() const { return statistics; }
+
  private:
   //! Reference to the rules with which the tree will be traversed.
   RuleType& rule;
 
+  //! The statistics recorded during traversal.
+  TraversalStatisticsType statistics;
+
   //! The number of nodes which have been pruned during traversal.
   size_t numPrunes;
+
+  //! The type of an entry of the map of nodes left to visit.
+  typedef CoverTreeMapEntry<MetricType, StatisticType, MatType, RootPointPolicy>
+      MapEntryType;
+
+  //! Before entry i of a list of entries is visited, start loading the entries
+  //! that follow it (see PrefetchAhead()).
+  static void PrefetchEntries(const std::vector<MapEntryType>& entries,
+                              const size_t i);
+
+  /**
+   * Before the leaves are visited, hand the points of every leaf that can't
+   * yet be pruned to the rules, so that they can evaluate all of those base
+   * cases as a block.  This overload is used when the rule type provides a
+   * BatchBaseCases() function.
+   */
+  template<typename Rule>
+  typename std::enable_if<HasBatchBaseCasesCheck<Rule,
+      void(Rule::*)(const size_t, const std::vector<size_t>&)>::value,
+      void>::type
+  BatchLeafBaseCases(Rule& leafRule,
+                     const size_t queryIndex,
+                     const std::vector<MapEntryType>& leaves);
+
+  /**
+   * This overload is used when the rule type does not provide a
+   * BatchBaseCases() function; it does nothing, and each base case is
+   * evaluated when its leaf is visited.
+   */
+  template<typename Rule>
+  typename std::enable_if<!HasBatchBaseCasesCheck<Rule,
+      void(Rule::*)(const size_t, const std::vector<size_t>&)>::value,
+      void>::type
+  BatchLeafBaseCases(Rule& /* leafRule */,
+                     const size_t /* queryIndex */,
+                     const std::vector<MapEntryType>& /* leaves */) { }
 };
 
 } // namespace tree
@@ -80,7 +80,7 @@ SingleTreeTraverser<RuleType>::Traverse(
   std::map<int, std::vector<MapEntryType> > mapQueue;
 
   // Create the score for the children.
-  double rootChildScore = rule.Score(queryIndex, referenceNode);
+  double rootChildScore = statistics.Score(rule, queryIndex, referenceNode);
 
   if (rootChildScore == DBL_MAX)
   {
@@ -93,6 +93,7 @@ SingleTreeTraverser<RuleType>::Traverse(
     // using TreeTraits::FirstPointIsCentroid; this is an optimization that
     // (theoretically) the compiler should get right.
     double rootBaseCase = rule.BaseCase(queryIndex, referenceNode.Point());
+    statistics.BaseCases(referenceNode, 1);
 
     // Don't add the self-leaf.
     size_t i = 0;
@@ -130,9 +131,11 @@ SingleTreeTraverser<RuleType>::Traverse(
     // Before traversing all the points in this scale, sort by score.
     std::sort(scaleVector.begin(), scaleVector.end());
 
-    // Now loop over each element.
+    // Now loop over each element, loading the next ones while it is scored.
     for (size_t i = 0; i < scaleVector.size(); ++i)
     {
+      PrefetchEntries(scaleVector, i);
+
       // Get a reference to the current element.
       const MapEntryType& frame = scaleVector.at(i);
 
@@ -143,14 +146,14 @@ SingleTreeTraverser<RuleType>::Traverse(
       double baseCase = frame.baseCase;
 
       // First we recalculate the score of this node to find if we can prune it.
-      if (rule.Rescore(queryIndex, *node, score) == DBL_MAX)
+      if (statistics.Rescore(rule, queryIndex, *node, score) == DBL_MAX)
       {
         ++numPrunes;
         continue;
       }
 
       // Create the score for the children.
-      const double childScore = rule.Score(queryIndex, *node);
+      const double childScore = statistics.Score(rule, queryIndex, *node);
 
       // Now if this childScore is DBL_MAX we can prune all children.  In this
       // recursion setup pruning is all or nothing for children.
@@ -165,7 +168,10 @@ SingleTreeTraverser<RuleType>::Traverse(
       // trees using TreeTraits::FirstPointIsCentroid; this is an optimization
       // that (theoretically) the compiler should get right.
       if (point != parent)
+      {
         baseCase = rule.BaseCase(queryIndex, point);
+        statistics.BaseCases(*node, 1);
+      }
 
       // Don't add the self-leaf.
       size_t j = 0;
@@ -192,16 +198,20 @@ SingleTreeTraverser<RuleType>::Traverse(
   }
 
   // Now deal with the leaves.
-  for (size_t i = 0; i < mapQueue[INT_MIN].size(); ++i)
+  std::vector<MapEntryType>& leaves = mapQueue[INT_MIN];
+  BatchLeafBaseCases(rule, queryIndex, leaves);
+  for (size_t i = 0; i < leaves.size(); ++i)
   {
-    const MapEntryType& frame = mapQueue[INT_MIN].at(i);
+    PrefetchEntries(leaves, i);
+
+    const MapEntryType& frame = leaves.at(i);
 
     CoverTree* node = frame.node;
     const double score = frame.score;
     const size_t point = node->Point();
 
     // First, recalculate the score of this node to find if we can prune it.
-    double rescore = rule.Rescore(queryIndex, *node, score);
+    double rescore = statistics.Rescore(rule, queryIndex, *node, score);
 
     if (rescore == DBL_MAX)
     {
@@ -212,7 +222,7 @@ SingleTreeTraverser<RuleType>::Traverse(
     // For this to be a valid dual-tree algorithm, we *must* evaluate the
     // combination, even if pruning it will make no difference.  It's the
     // definition.
-    const double actualScore = rule.Score(queryIndex, *node);
+    const double actualScore = statistics.Score(rule, queryIndex, *node);
 
     if (actualScore == DBL_MAX)
     {
@@ -226,10 +236,64 @@ SingleTreeTraverser<RuleType>::Traverse(
       // trees using TreeTraits::FirstPointIsCentroid; this is an optimization
       // that (theoretically) the compiler should get right.
       rule.BaseCase(queryIndex, point);
+      statistics.BaseCases(*node, 1);
     }
   }
 }
 
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+template<typename RuleType>
+template<typename Rule>
+typename std::enable_if<HasBatchBaseCasesCheck<Rule,
+    void(Rule::*)(const size_t, const std::vector<size_t>&)>::value, void>::type
+CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
+SingleTreeTraverser<RuleType>::BatchLeafBaseCases(
+    Rule& leafRule,
+    const size_t queryIndex,
+    const std::vector<MapEntryType>& leaves)
+{
+  // Leaves that can already be pruned are left out.  The rest may still be
+  // pruned when they are visited, but then their base cases were only wasted
+  // as part of the block.
+  std::vector<size_t> points;
+  points.reserve(leaves.size());
+  for (size_t i = 0; i < leaves.size(); ++i)
+    if (leafRule.Rescore(queryIndex, *leaves[i].node, leaves[i].score) !=
+        DBL_MAX)
+      points.push_back(leaves[i].node->Point());
+
+  leafRule.BatchBaseCases(queryIndex, points);
+}
+
+template<
+    typename MetricType,
+    typename StatisticType,
+    typename MatType,
+    typename RootPointPolicy
+>
+template<typename RuleType>
+void CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>::
+SingleTreeTraverser<RuleType>::PrefetchEntries(
+    const std::vector<MapEntryType>& entries,
+    const size_t i)
+{
+  // Nothing was prefetched before the first entry.
+  if (i == 0)
+  {
+    PrefetchNode(entries[0].node);
+    if (entries.size() > 1)
+      PrefetchNode(entries[1].node);
+  }
+
+  PrefetchAhead((i + 1 < entries.size()) ? entries[i + 1].node : NULL,
+      (i + 2 < entries.size()) ? entries[i + 2].node : NULL);
+}
+
 } // namespace tree
 } // namespace mlpack
 
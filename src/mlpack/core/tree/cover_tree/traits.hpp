@@ -54,6 +54,40 @@ class TreeTraits<CoverTree<MetricType, StatisticType, MatType, RootPointPolicy>>
   static const bool BinaryTree = false;
 };
 
+/**
+ * The specialization of the TreeTraits class for cover trees that reorder the
+ * dataset when they are built (see ReorderPoints).  These are the same as for
+ * any other cover tree, except that the dataset is rearranged.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename RootPointPolicy>
+class TreeTraits<CoverTree<MetricType,
+                           StatisticType,
+                           MatType,
+                           ReorderPoints<RootPointPolicy>>>
+{
+ public:
+  //! Children of cover tree nodes may overlap.
+  static const bool HasOverlappingChildren = true;
+
+  //! The point of each node is its centroid.
+  static const bool FirstPointIsCentroid = true;
+
+  //! Cover trees have self-children.
+  static const bool HasSelfChildren = true;
+
+  /**
+   * Points are reordered into the depth-first order of the tree when the tree
+   * is built.
+   */
+  static const bool RearrangesDataset = true;
+
+  //! The cover tree is not necessarily a binary tree.
+  static const bool BinaryTree = false;
+};
+
 } // namespace tree
 } // namespace mlpack
 
@@ -36,6 +36,23 @@ using StandardCoverTree = CoverTree<MetricType,
                                     MatType,
                                     FirstPointIsRoot>;
 
+/**
+ * The standard cover tree, but with the dataset reordered into the depth-first
+ * order of the tree when it is built (see ReorderPoints), so that the points of
+ * each node are contiguous in memory.  Tree-based algorithms using this tree
+ * unmap their results, so they give the same results as with the
+ * StandardCoverTree.
+ *
+ * This template typedef satisfies the requirements of the TreeType API.
+ *
+ * @see @ref trees, CoverTree, StandardCoverTree
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+using ReorderedCoverTree = CoverTree<MetricType,
+                                     StatisticType,
+                                     MatType,
+                                     ReorderPoints<FirstPointIsRoot>>;
+
 } // namespace tree
 } // namespace mlpack
 
@@ -0,0 +1,206 @@
+/**
+ * @file hollow_ball_bound.hpp
+ * @author Ryan Curtin
+ *
+ * Bounds that are useful for binary space partitioning trees.  Interface to a
+ * ball bound that is additionally restricted to a spherical shell around
+ * another point, as used by vantage-point trees.
+ */
+#ifndef __MLPACK_CORE_TREE_HOLLOW_BALL_BOUND_HPP
+#define __MLPACK_CORE_TREE_HOLLOW_BALL_BOUND_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+#include "bound_traits.hpp"
+
+namespace mlpack {
+namespace bound {
+
+/**
+ * A hollow ball bound encloses a set of points that lie within a certain
+ * distance (the radius) of a center point, and that also lie within a spherical
+ * shell (a range of distances) around a second point, the hollow center.  This
+ * is the region that a node of a vantage-point tree represents: the hollow
+ * center is the vantage point of the parent node, and the shell is the range of
+ * distances from the vantage point that the node was given when the parent was
+ * split.  The shell is optional; until SetShell() is called, the bound is an
+ * ordinary ball.
+ *
+ * Unlike BallBound, the center is never moved: it is the first point that is
+ * added to the bound, and the radius is the distance to the furthest point that
+ * has been added.  Since only distances are used, the bound works with any
+ * metric (not just LMetric), but the metric must satisfy the triangle
+ * inequality (so, for instance, LMetric<2, false> may not be used).
+ *
+ * @tparam TMetricType Metric type used in the distance measure.
+ * @tparam VecType Type of vector (arma::vec or arma::sp_vec).
+ */
+template<typename TMetricType = metric::LMetric<2, true>,
+         typename VecType = arma::vec>
+class HollowBallBound
+{
+ public:
+  typedef VecType Vec;
+  //! Needed for BinarySpaceTree.
+  typedef TMetricType MetricType;
+
+ private:
+  //! The radius of the ball around the center (negative if empty).
+  double radius;
+  //! The center of the ball.
+  VecType center;
+  //! The center of the shell (empty if there is no shell).
+  VecType hollowCenter;
+  //! The range of distances from the hollow center.
+  math::Range shell;
+  //! The metric used in this bound.
+  TMetricType metric;
+
+ public:
+  //! Empty constructor.
+  HollowBallBound();
+
+  /**
+   * Create the hollow ball bound with the specified dimensionality.  The bound
+   * is empty and has no shell.
+   *
+   * @param dimension Dimensionality of the bound.
+   */
+  HollowBallBound(const size_t dimension);
+
+  //! Get the radius of the ball.
+  double Radius() const { return radius; }
+  //! Modify the radius of the ball.
+  double& Radius() { return radius; }
+
+  //! Get the center point of the ball.
+  const VecType& Center() const { return center; }
+  //! Modify the center point of the ball.
+  VecType& Center() { return center; }
+
+  //! Return whether or not the bound is restricted to a shell.
+  bool HasShell() const { return hollowCenter.n_elem > 0; }
+  //! Get the center of the shell (empty if there is no shell).
+  const VecType& HollowCenter() const { return hollowCenter; }
+  //! Get the range of distances from the hollow center.
+  const math::Range& Shell() const { return shell; }
+
+  /**
+   * Restrict the bound to a shell around the given point.  The shell is empty
+   * until points are added with operator|=(), which expands it to the range of
+   * distances of those points from the given point.  (Points that were added
+   * before this call are not taken into account.)
+   *
+   * @param hollowCenter Center of the shell.
+   */
+  void SetShell(const VecType& hollowCenter);
+
+  //! Get the dimensionality of the bound.
+  double Dim() const { return center.n_elem; }
+
+  /**
+   * Get the minimum width of the bound.  The shell may cut arbitrarily close
+   * to the center, so the only safe answer if there is a shell is 0.
+   */
+  double MinWidth() const { return HasShell() ? 0.0 : radius * 2.0; }
+
+  //! Get the range of the ball in a certain dimension.
+  math::Range operator[](const size_t i) const;
+
+  /**
+   * Determines if a point is within this bound.
+   */
+  bool Contains(const VecType& point) const;
+
+  /**
+   * Place the center of the ball into the given vector.
+   *
+   * @param center Vector which the center will be written to.
+   */
+  void Center(VecType& center) const { center = this->center; }
+
+  /**
+   * Calculates minimum bound-to-point distance.
+   */
+  template<typename OtherVecType>
+  double MinDistance(const OtherVecType& point,
+                     typename boost::enable_if<IsVector<OtherVecType> >* = 0)
+      const;
+
+  /**
+   * Calculates minimum bound-to-bound distance.
+   */
+  double MinDistance(const HollowBallBound& other) const;
+
+  /**
+   * Computes maximum bound-to-point distance.
+   */
+  template<typename OtherVecType>
+  double MaxDistance(const OtherVecType& point,
+                     typename boost::enable_if<IsVector<OtherVecType> >* = 0)
+      const;
+
+  /**
+   * Computes maximum bound-to-bound distance.
+   */
+  double MaxDistance(const HollowBallBound& other) const;
+
+  /**
+   * Calculates minimum and maximum bound-to-point distance.
+   */
+  template<typename OtherVecType>
+  math::Range RangeDistance(
+      const OtherVecType& other,
+      typename boost::enable_if<IsVector<OtherVecType> >* = 0) const;
+
+  /**
+   * Calculates minimum and maximum bound-to-bound distance.
+   */
+  math::Range RangeDistance(const HollowBallBound& other) const;
+
+  /**
+   * Expand the bound to include the given points.  If the bound is empty, the
+   * first point becomes the center.  The radius (and the shell, if there is
+   * one) grow just enough to contain the points.
+   *
+   * @tparam MatType Type of matrix; could be arma::mat, arma::spmat, or a
+   *     vector.
+   * @tparam data Data points to add.
+   */
+  template<typename MatType>
+  const HollowBallBound& operator|=(const MatType& data);
+
+  /**
+   * Returns the diameter of the ball.
+   */
+  double Diameter() const { return 2 * radius; }
+
+  //! Returns the distance metric used in this bound.
+  const TMetricType& Metric() const { return metric; }
+  //! Modify the distance metric used in this bound.
+  TMetricType& Metric() { return metric; }
+
+  //! Serialize the bound.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int version);
+
+  /**
+   * Returns a string representation of this object.
+   */
+  std::string ToString() const;
+};
+
+//! A specialization of BoundTraits for this bound type.
+template<typename TMetricType, typename VecType>
+struct BoundTraits<HollowBallBound<TMetricType, VecType>>
+{
+  //! These bounds are potentially loose in some dimensions.
+  const static bool HasTightBounds = false;
+};
+
+} // namespace bound
+} // namespace mlpack
+
+#include "hollow_ball_bound_impl.hpp"
+
+#endif // __MLPACK_CORE_TREE_HOLLOW_BALL_BOUND_HPP
@@ -0,0 +1,289 @@
+/**
+ * @file hollow_ball_bound_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Bounds that are useful for binary space partitioning trees.
+ * Implementation of the HollowBallBound class.
+ */
+#ifndef __MLPACK_CORE_TREE_HOLLOW_BALL_BOUND_IMPL_HPP
+#define __MLPACK_CORE_TREE_HOLLOW_BALL_BOUND_IMPL_HPP
+
+// In case it hasn't been included already.
+#include "hollow_ball_bound.hpp"
+
+#include <string>
+
+namespace mlpack {
+namespace bound {
+
+//! Empty constructor.
+template<typename TMetricType, typename VecType>
+HollowBallBound<TMetricType, VecType>::HollowBallBound() :
+    radius(-DBL_MAX)
+{ /* Nothing to do. */ }
+
+/**
+ * Create the hollow ball bound with the specified dimensionality.
+ *
+ * @param dimension Dimensionality of the bound.
+ */
+template<typename TMetricType, typename VecType>
+HollowBallBound<TMetricType, VecType>::HollowBallBound(const size_t dimension) :
+    radius(-DBL_MAX),
+    center(dimension)
+{ /* Nothing to do. */ }
+
+//! Restrict the bound to a shell around the given point.
+template<typename TMetricType, typename VecType>
+void HollowBallBound<TMetricType, VecType>::SetShell(
+    const VecType& hollowCenter)
+{
+  this->hollowCenter = hollowCenter;
+  shell = math::Range(); // Empty until points are added.
+}
+
+//! Get the range of the ball in a certain dimension.
+template<typename TMetricType, typename VecType>
+math::Range HollowBallBound<TMetricType, VecType>::operator[](
+    const size_t i) const
+{
+  if (radius < 0)
+    return math::Range();
+  else
+    return math::Range(center[i] - radius, center[i] + radius);
+}
+
+/**
+ * Determines if a point is within the bound.
+ */
+template<typename TMetricType, typename VecType>
+bool HollowBallBound<TMetricType, VecType>::Contains(const VecType& point) const
+{
+  if (radius < 0)
+    return false;
+
+  if (metric.Evaluate(center, point) > radius)
+    return false;
+
+  return !HasShell() || shell.Contains(metric.Evaluate(hollowCenter, point));
+}
+
+/**
+ * Calculates minimum bound-to-point distance.  By the triangle inequality, the
+ * point can be no closer than its distance to the ball, and no closer than its
+ * distance to the shell.
+ */
+template<typename TMetricType, typename VecType>
+template<typename OtherVecType>
+double HollowBallBound<TMetricType, VecType>::MinDistance(
+    const OtherVecType& point,
+    typename boost::enable_if<IsVector<OtherVecType> >* /* junk */) const
+{
+  if (radius < 0)
+    return DBL_MAX;
+
+  double distance = metric.Evaluate(point, center) - radius;
+
+  if (HasShell())
+  {
+    const double hollowDistance = metric.Evaluate(point, hollowCenter);
+    distance = std::max(distance, std::max(hollowDistance - shell.Hi(),
+        shell.Lo() - hollowDistance));
+  }
+
+  return math::ClampNonNegative(distance);
+}
+
+/**
+ * Calculates minimum bound-to-bound distance.  Each combination of the balls
+ * and shells of the two bounds gives a lower bound on the distance; the shells
+ * of siblings in a vantage-point tree have the same center, so for them the
+ * shell-to-shell term is the gap between the two shells.
+ */
+template<typename TMetricType, typename VecType>
+double HollowBallBound<TMetricType, VecType>::MinDistance(
+    const HollowBallBound& other) const
+{
+  if (radius < 0 || other.radius < 0)
+    return DBL_MAX;
+
+  double distance = metric.Evaluate(center, other.center) - radius -
+      other.radius;
+
+  if (HasShell())
+  {
+    const double hollowDistance = metric.Evaluate(hollowCenter, other.center);
+    distance = std::max(distance, std::max(hollowDistance - shell.Hi(),
+        shell.Lo() - hollowDistance) - other.radius);
+  }
+
+  if (other.HasShell())
+  {
+    const double hollowDistance = metric.Evaluate(other.hollowCenter, center);
+    distance = std::max(distance, std::max(hollowDistance - other.shell.Hi(),
+        other.shell.Lo() - hollowDistance) - radius);
+  }
+
+  if (HasShell() && other.HasShell())
+  {
+    const double hollowDistance = metric.Evaluate(hollowCenter,
+        other.hollowCenter);
+    distance = std::max(distance, hollowDistance - shell.Hi() -
+        other.shell.Hi());
+    distance = std::max(distance, shell.Lo() - hollowDistance -
+        other.shell.Hi());
+    distance = std::max(distance, other.shell.Lo() - hollowDistance -
+        shell.Hi());
+  }
+
+  return math::ClampNonNegative(distance);
+}
+
+/**
+ * Computes maximum bound-to-point distance.
+ */
+template<typename TMetricType, typename VecType>
+template<typename OtherVecType>
+double HollowBallBound<TMetricType, VecType>::MaxDistance(
+    const OtherVecType& point,
+    typename boost::enable_if<IsVector<OtherVecType> >* /* junk */) const
+{
+  if (radius < 0)
+    return DBL_MAX;
+
+  double distance = metric.Evaluate(point, center) + radius;
+
+  if (HasShell())
+    distance = std::min(distance, metric.Evaluate(point, hollowCenter) +
+        shell.Hi());
+
+  return distance;
+}
+
+/**
+ * Computes maximum bound-to-bound distance.
+ */
+template<typename TMetricType, typename VecType>
+double HollowBallBound<TMetricType, VecType>::MaxDistance(
+    const HollowBallBound& other) const
+{
+  if (radius < 0 || other.radius < 0)
+    return DBL_MAX;
+
+  double distance = metric.Evaluate(center, other.center) + radius +
+      other.radius;
+
+  if (HasShell())
+    distance = std::min(distance, metric.Evaluate(hollowCenter, other.center) +
+        shell.Hi() + other.radius);
+
+  if (other.HasShell())
+    distance = std::min(distance, metric.Evaluate(other.hollowCenter, center) +
+        other.shell.Hi() + radius);
+
+  if (HasShell() && other.HasShell())
+    distance = std::min(distance, metric.Evaluate(hollowCenter,
+        other.hollowCenter) + shell.Hi() + other.shell.Hi());
+
+  return distance;
+}
+
+/**
+ * Calculates minimum and maximum bound-to-point distance.
+ */
+template<typename TMetricType, typename VecType>
+template<typename OtherVecType>
+math::Range HollowBallBound<TMetricType, VecType>::RangeDistance(
+    const OtherVecType& point,
+    typename boost::enable_if<IsVector<OtherVecType> >* /* junk */) const
+{
+  if (radius < 0)
+    return math::Range(DBL_MAX, DBL_MAX);
+
+  return math::Range(MinDistance(point), MaxDistance(point));
+}
+
+/**
+ * Calculates minimum and maximum bound-to-bound distance.
+ */
+template<typename TMetricType, typename VecType>
+math::Range HollowBallBound<TMetricType, VecType>::RangeDistance(
+    const HollowBallBound& other) const
+{
+  if (radius < 0 || other.radius < 0)
+    return math::Range(DBL_MAX, DBL_MAX);
+
+  return math::Range(MinDistance(other), MaxDistance(other));
+}
+
+/**
+ * Expand the bound to include the given points.  The center is never moved, so
+ * that it can be used as a vantage point.
+ */
+template<typename TMetricType, typename VecType>
+template<typename MatType>
+const HollowBallBound<TMetricType, VecType>&
+HollowBallBound<TMetricType, VecType>::operator|=(const MatType& data)
+{
+  if (data.n_cols == 0)
+    return *this;
+
+  if (radius < 0)
+  {
+    center = data.col(0);
+    radius = 0;
+  }
+
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    const double distance = metric.Evaluate(center, data.col(i));
+    if (distance > radius)
+      radius = distance;
+
+    if (HasShell())
+    {
+      const double hollowDistance = metric.Evaluate(hollowCenter, data.col(i));
+      shell |= math::Range(hollowDistance, hollowDistance);
+    }
+  }
+
+  return *this;
+}
+
+//! Serialize the HollowBallBound.
+template<typename TMetricType, typename VecType>
+template<typename Archive>
+void HollowBallBound<TMetricType, VecType>::Serialize(
+    Archive& ar,
+    const unsigned int /* version */)
+{
+  ar & data::CreateNVP(radius, "radius");
+  ar & data::CreateNVP(center, "center");
+  ar & data::CreateNVP(hollowCenter, "hollowCenter");
+  ar & data::CreateNVP(shell, "shell");
+  ar & data::CreateNVP(metric, "metric");
+}
+
+/**
+ * Returns a string representation of this object.
+ */
+template<typename TMetricType, typename VecType>
+std::string HollowBallBound<TMetricType, VecType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "HollowBallBound [" << this << "]" << std::endl;
+  convert << "  Radius:  " << radius << std::endl;
+  convert << "  Center:" << std::endl << center;
+  if (HasShell())
+  {
+    convert << "  Shell: [" << shell.Lo() << ", " << shell.Hi() << "]"
+        << std::endl;
+    convert << "  Hollow center:" << std::endl << hollowCenter;
+  }
+  return convert.str();
+}
+
+} // namespace bound
+} // namespace mlpack
+
+#endif // __MLPACK_CORE_TREE_HOLLOW_BALL_BOUND_IMPL_HPP
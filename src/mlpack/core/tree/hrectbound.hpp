@@ -34,6 +34,50 @@ struct IsLMetric<metric::LMetric<Power, TakeRoot>>
   static const bool Value = true;
 };
 
+/**
+ * Read the elements of a point in order of dimension.  For a dense point this
+ * is just element access; a sparse point is walked along its nonzero elements,
+ * so that reading every dimension costs O(d + nnz) instead of a search for
+ * each dimension.  The dimensions must be read in increasing order.
+ */
+template<typename VecType, bool Sparse = IsSparseVector<VecType>::value>
+class ElementReader
+{
+ public:
+  ElementReader(const VecType& point) : point(point) { }
+
+  //! Get the element of the point in dimension d.
+  double operator()(const size_t d) { return point[d]; }
+
+ private:
+  const VecType& point;
+};
+
+//! Specialization for sparse points.
+template<typename VecType>
+class ElementReader<VecType, true>
+{
+ public:
+  ElementReader(const VecType& point) : it(point.begin()), end(point.end()) { }
+
+  //! Get the element of the point in dimension d.
+  double operator()(const size_t d)
+  {
+    // The position of an element is its row in a column and its column in a
+    // row; the other index is 0.
+    while (it != end && (size_t) (it.row() + it.col()) < d)
+      ++it;
+
+    if (it != end && (size_t) (it.row() + it.col()) == d)
+      return (double) (*it);
+    return 0.0;
+  }
+
+ private:
+  typename VecType::const_iterator it;
+  const typename VecType::const_iterator end;
+};
+
 } // namespace util
 
 /**
@@ -170,6 +214,17 @@ class HRectBound
   template<typename MatType>
   HRectBound& operator|=(const MatType& data);
 
+  /**
+   * Expands this region to include the columns of a sparse matrix.  Only the
+   * nonzero elements are visited (with value 0 included in every dimension
+   * that some column does not have a nonzero element in), so this costs
+   * O(d + nnz).
+   *
+   * @param data Data points to expand this region to include.
+   */
+  template<typename eT>
+  HRectBound& operator|=(const arma::SpSubview<eT>& data);
+
   /**
    * Expands this region to encompass another bound.
    */
@@ -197,13 +252,52 @@ class HRectBound
    */
   std::string ToString() const;
 
+  /**
+   * The largest dimensionality whose ranges are held in the bound itself
+   * instead of on the heap.  For these dimensionalities, the distance
+   * calculations are also compiled for each dimensionality, so that their
+   * loops are unrolled; this makes low-dimensional (e.g. geospatial) data much
+   * faster to search.
+   */
+  static const size_t MaxInlineDim = 4;
+
  private:
   //! The dimensionality of the bound.
   size_t dim;
-  //! The bounds for each dimension.
+  //! The bounds for each dimension; this points to inlineBounds if dim is at
+  //! most MaxInlineDim.
   math::Range* bounds;
   //! Cached minimum width of bound.
   double minWidth;
+  //! The bounds, if there are at most MaxInlineDim dimensions.
+  math::Range inlineBounds[MaxInlineDim];
+
+  //! Set the dimensionality and allocate the bounds (which are not set).
+  void Allocate(const size_t dimension);
+  //! Free the bounds, if they are on the heap.
+  void Free();
+
+  //! Minimum distance to the given bounds (of another HRectBound).  If Dims is
+  //! nonzero, it is the dimensionality.
+  template<size_t Dims>
+  double MinBoundDistance(const math::Range* otherBounds) const;
+  //! Maximum distance to the given bounds.
+  template<size_t Dims>
+  double MaxBoundDistance(const math::Range* otherBounds) const;
+  //! Minimum and maximum distance to the given bounds.
+  template<size_t Dims>
+  math::Range RangeBoundDistance(const math::Range* otherBounds) const;
+
+  //! Minimum distance to the given point.  If Dims is nonzero, it is the
+  //! dimensionality.
+  template<size_t Dims, typename VecType>
+  double MinPointDistance(const VecType& point) const;
+  //! Maximum distance to the given point.
+  template<size_t Dims, typename VecType>
+  double MaxPointDistance(const VecType& point) const;
+  //! Minimum and maximum distance to the given point.
+  template<size_t Dims, typename VecType>
+  math::Range RangePointDistance(const VecType& point) const;
 };
 
 // A specialization of BoundTraits for this class.
@@ -17,6 +17,9 @@
 namespace mlpack {
 namespace bound {
 
+template<typename MetricType>
+const size_t HRectBound<MetricType>::MaxInlineDim;
+
 /**
  * Empty constructor.
  */
@@ -33,20 +36,24 @@ inline HRectBound<MetricType>::HRectBound() :
  */
 template<typename MetricType>
 inline HRectBound<MetricType>::HRectBound(const size_t dimension) :
-    dim(dimension),
-    bounds(new math::Range[dim]),
+    dim(0),
+    bounds(NULL),
     minWidth(0)
-{ /* Nothing to do. */ }
+{
+  Allocate(dimension);
+}
 
 /**
  * Copy constructor necessary to prevent memory leaks.
  */
 template<typename MetricType>
 inline HRectBound<MetricType>::HRectBound(const HRectBound& other) :
-    dim(other.Dim()),
-    bounds(new math::Range[dim]),
+    dim(0),
+    bounds(NULL),
     minWidth(other.MinWidth())
 {
+  Allocate(other.Dim());
+
   // Copy other bounds over.
   for (size_t i = 0; i < dim; i++)
     bounds[i] = other[i];
@@ -62,11 +69,8 @@ inline HRectBound<MetricType>& HRectBound<MetricType>::operator=(
   if (dim != other.Dim())
   {
     // Reallocation is necessary.
-    if (bounds)
-      delete[] bounds;
-
-    dim = other.Dim();
-    bounds = new math::Range[dim];
+    Free();
+    Allocate(other.Dim());
   }
 
   // Now copy each of the bound values.
@@ -87,6 +91,14 @@ inline HRectBound<MetricType>::HRectBound(HRectBound&& other) :
     bounds(other.bounds),
     minWidth(other.minWidth)
 {
+  // Bounds held inside the other bound must be copied.
+  if (other.bounds == other.inlineBounds)
+  {
+    bounds = inlineBounds;
+    for (size_t i = 0; i < dim; i++)
+      bounds[i] = other.bounds[i];
+  }
+
   // Fix the other bound.
   other.dim = 0;
   other.bounds = NULL;
@@ -99,8 +111,27 @@ inline HRectBound<MetricType>::HRectBound(HRectBound&& other) :
 template<typename MetricType>
 inline HRectBound<MetricType>::~HRectBound()
 {
-  if (bounds)
+  Free();
+}
+
+template<typename MetricType>
+inline void HRectBound<MetricType>::Allocate(const size_t dimension)
+{
+  dim = dimension;
+  if (dim == 0)
+    bounds = NULL;
+  else if (dim <= MaxInlineDim)
+    bounds = inlineBounds;
+  else
+    bounds = new math::Range[dim];
+}
+
+template<typename MetricType>
+inline void HRectBound<MetricType>::Free()
+{
+  if (bounds != inlineBounds)
     delete[] bounds;
+  bounds = NULL;
 }
 
 /**
@@ -156,13 +187,32 @@ inline double HRectBound<MetricType>::MinDistance(
 {
   Log::Assert(point.n_elem == dim);
 
+  // Low dimensionalities have their own unrolled loops.
+  switch (dim)
+  {
+    case 1: return MinPointDistance<1>(point);
+    case 2: return MinPointDistance<2>(point);
+    case 3: return MinPointDistance<3>(point);
+    case 4: return MinPointDistance<4>(point);
+    default: return MinPointDistance<0>(point);
+  }
+}
+
+template<typename MetricType>
+template<size_t Dims, typename VecType>
+inline double HRectBound<MetricType>::MinPointDistance(const VecType& point)
+    const
+{
+  const size_t dims = (Dims == 0) ? dim : Dims;
   double sum = 0;
+  meta::ElementReader<VecType> element(point);
 
   double lower, higher;
-  for (size_t d = 0; d < dim; d++)
+  for (size_t d = 0; d < dims; d++)
   {
-    lower = bounds[d].Lo() - point[d];
-    higher = point[d] - bounds[d].Hi();
+    const double value = element(d);
+    lower = bounds[d].Lo() - value;
+    higher = value - bounds[d].Hi();
 
     // Since only one of 'lower' or 'higher' is negative, if we add each's
     // absolute value to itself and then sum those two, our result is the
@@ -189,12 +239,28 @@ double HRectBound<MetricType>::MinDistance(const HRectBound& other) const
 {
   Log::Assert(dim == other.dim);
 
+  switch (dim)
+  {
+    case 1: return MinBoundDistance<1>(other.bounds);
+    case 2: return MinBoundDistance<2>(other.bounds);
+    case 3: return MinBoundDistance<3>(other.bounds);
+    case 4: return MinBoundDistance<4>(other.bounds);
+    default: return MinBoundDistance<0>(other.bounds);
+  }
+}
+
+template<typename MetricType>
+template<size_t Dims>
+inline double HRectBound<MetricType>::MinBoundDistance(
+    const math::Range* otherBounds) const
+{
+  const size_t dims = (Dims == 0) ? dim : Dims;
   double sum = 0;
   const math::Range* mbound = bounds;
-  const math::Range* obound = other.bounds;
+  const math::Range* obound = otherBounds;
 
   double lower, higher;
-  for (size_t d = 0; d < dim; d++)
+  for (size_t d = 0; d < dims; d++)
   {
     lower = obound->Lo() - mbound->Hi();
     higher = mbound->Lo() - obound->Hi();
@@ -225,14 +291,32 @@ inline double HRectBound<MetricType>::MaxDistance(
     const VecType& point,
     typename boost::enable_if<IsVector<VecType> >* /* junk */) const
 {
-  double sum = 0;
-
   Log::Assert(point.n_elem == dim);
 
-  for (size_t d = 0; d < dim; d++)
+  switch (dim)
   {
-    double v = std::max(fabs(point[d] - bounds[d].Lo()),
-        fabs(bounds[d].Hi() - point[d]));
+    case 1: return MaxPointDistance<1>(point);
+    case 2: return MaxPointDistance<2>(point);
+    case 3: return MaxPointDistance<3>(point);
+    case 4: return MaxPointDistance<4>(point);
+    default: return MaxPointDistance<0>(point);
+  }
+}
+
+template<typename MetricType>
+template<size_t Dims, typename VecType>
+inline double HRectBound<MetricType>::MaxPointDistance(const VecType& point)
+    const
+{
+  const size_t dims = (Dims == 0) ? dim : Dims;
+  double sum = 0;
+  meta::ElementReader<VecType> element(point);
+
+  for (size_t d = 0; d < dims; d++)
+  {
+    const double value = element(d);
+    double v = std::max(fabs(value - bounds[d].Lo()),
+        fabs(bounds[d].Hi() - value));
     sum += pow(v, (double) MetricType::Power);
   }
 
@@ -250,15 +334,31 @@ template<typename MetricType>
 inline double HRectBound<MetricType>::MaxDistance(const HRectBound& other)
     const
 {
-  double sum = 0;
-
   Log::Assert(dim == other.dim);
 
+  switch (dim)
+  {
+    case 1: return MaxBoundDistance<1>(other.bounds);
+    case 2: return MaxBoundDistance<2>(other.bounds);
+    case 3: return MaxBoundDistance<3>(other.bounds);
+    case 4: return MaxBoundDistance<4>(other.bounds);
+    default: return MaxBoundDistance<0>(other.bounds);
+  }
+}
+
+template<typename MetricType>
+template<size_t Dims>
+inline double HRectBound<MetricType>::MaxBoundDistance(
+    const math::Range* otherBounds) const
+{
+  const size_t dims = (Dims == 0) ? dim : Dims;
+  double sum = 0;
+
   double v;
-  for (size_t d = 0; d < dim; d++)
+  for (size_t d = 0; d < dims; d++)
   {
-    v = std::max(fabs(other.bounds[d].Hi() - bounds[d].Lo()),
-        fabs(bounds[d].Hi() - other.bounds[d].Lo()));
+    v = std::max(fabs(otherBounds[d].Hi() - bounds[d].Lo()),
+        fabs(bounds[d].Hi() - otherBounds[d].Lo()));
     sum += pow(v, (double) MetricType::Power); // v is non-negative.
   }
 
@@ -276,16 +376,32 @@ template<typename MetricType>
 inline math::Range HRectBound<MetricType>::RangeDistance(
     const HRectBound& other) const
 {
+  Log::Assert(dim == other.dim);
+
+  switch (dim)
+  {
+    case 1: return RangeBoundDistance<1>(other.bounds);
+    case 2: return RangeBoundDistance<2>(other.bounds);
+    case 3: return RangeBoundDistance<3>(other.bounds);
+    case 4: return RangeBoundDistance<4>(other.bounds);
+    default: return RangeBoundDistance<0>(other.bounds);
+  }
+}
+
+template<typename MetricType>
+template<size_t Dims>
+inline math::Range HRectBound<MetricType>::RangeBoundDistance(
+    const math::Range* otherBounds) const
+{
+  const size_t dims = (Dims == 0) ? dim : Dims;
   double loSum = 0;
   double hiSum = 0;
 
-  Log::Assert(dim == other.dim);
-
   double v1, v2, vLo, vHi;
-  for (size_t d = 0; d < dim; d++)
+  for (size_t d = 0; d < dims; d++)
   {
-    v1 = other.bounds[d].Lo() - bounds[d].Hi();
-    v2 = bounds[d].Lo() - other.bounds[d].Hi();
+    v1 = otherBounds[d].Lo() - bounds[d].Hi();
+    v2 = bounds[d].Lo() - otherBounds[d].Hi();
     // One of v1 or v2 is negative.
     if (v1 >= v2)
     {
@@ -318,16 +434,35 @@ inline math::Range HRectBound<MetricType>::RangeDistance(
     const VecType& point,
     typename boost::enable_if<IsVector<VecType> >* /* junk */) const
 {
+  Log::Assert(point.n_elem == dim);
+
+  switch (dim)
+  {
+    case 1: return RangePointDistance<1>(point);
+    case 2: return RangePointDistance<2>(point);
+    case 3: return RangePointDistance<3>(point);
+    case 4: return RangePointDistance<4>(point);
+    default: return RangePointDistance<0>(point);
+  }
+}
+
+template<typename MetricType>
+template<size_t Dims, typename VecType>
+inline math::Range HRectBound<MetricType>::RangePointDistance(
+    const VecType& point) const
+{
+  const size_t dims = (Dims == 0) ? dim : Dims;
   double loSum = 0;
   double hiSum = 0;
 
-  Log::Assert(point.n_elem == dim);
+  meta::ElementReader<VecType> element(point);
 
   double v1, v2, vLo, vHi;
-  for (size_t d = 0; d < dim; d++)
+  for (size_t d = 0; d < dims; d++)
   {
-    v1 = bounds[d].Lo() - point[d]; // Negative if point[d] > lo.
-    v2 = point[d] - bounds[d].Hi(); // Negative if point[d] < hi.
+    const double value = element(d);
+    v1 = bounds[d].Lo() - value; // Negative if point[d] > lo.
+    v2 = value - bounds[d].Hi(); // Negative if point[d] < hi.
     // One of v1 or v2 (or both) is negative.
     if (v1 >= 0) // point[d] <= bounds_[d].Lo().
     {
@@ -369,8 +504,10 @@ inline HRectBound<MetricType>& HRectBound<MetricType>::operator|=(
 {
   Log::Assert(data.n_rows == dim);
 
-  arma::vec mins(min(data, 1));
-  arma::vec maxs(max(data, 1));
+  // The data may not hold doubles (i.e. it may be arma::fmat), so convert the
+  // extremes explicitly.
+  const arma::vec mins = arma::conv_to<arma::vec>::from(min(data, 1));
+  const arma::vec maxs = arma::conv_to<arma::vec>::from(max(data, 1));
 
   minWidth = DBL_MAX;
   for (size_t i = 0; i < dim; i++)
@@ -384,6 +521,54 @@ inline HRectBound<MetricType>& HRectBound<MetricType>::operator|=(
   return *this;
 }
 
+/**
+ * Expands this region to include the columns of a sparse matrix.
+ */
+template<typename MetricType>
+template<typename eT>
+inline HRectBound<MetricType>& HRectBound<MetricType>::operator|=(
+    const arma::SpSubview<eT>& data)
+{
+  Log::Assert(data.n_rows == dim);
+
+  if (data.n_cols == 0)
+    return *this;
+
+  arma::vec mins(dim);
+  arma::vec maxs(dim);
+  mins.fill(DBL_MAX);
+  maxs.fill(-DBL_MAX);
+  arma::Col<size_t> nonzeros(dim);
+  nonzeros.zeros();
+
+  for (typename arma::SpSubview<eT>::const_iterator it = data.begin();
+       it != data.end(); ++it)
+  {
+    const double value = (double) (*it);
+    mins[it.row()] = std::min(mins[it.row()], value);
+    maxs[it.row()] = std::max(maxs[it.row()], value);
+    ++nonzeros[it.row()];
+  }
+
+  minWidth = DBL_MAX;
+  for (size_t i = 0; i < dim; i++)
+  {
+    // Some column has a zero in this dimension.
+    if (nonzeros[i] < data.n_cols)
+    {
+      mins[i] = std::min(mins[i], 0.0);
+      maxs[i] = std::max(maxs[i], 0.0);
+    }
+
+    bounds[i] |= math::Range(mins[i], maxs[i]);
+    const double width = bounds[i].Width();
+    if (width < minWidth)
+      minWidth = width;
+  }
+
+  return *this;
+}
+
 /**
  * Expands this region to encompass another bound.
  */
@@ -449,9 +634,9 @@ void HRectBound<MetricType>::Serialize(Archive& ar,
   // Allocate memory for the bounds, if necessary.
   if (Archive::is_loading::value)
   {
-    if (bounds)
-      delete[] bounds;
-    bounds = new math::Range[dim];
+    const size_t dimension = dim;
+    Free();
+    Allocate(dimension);
   }
 
   ar & data::CreateArrayNVP(bounds, dim, "bounds");
@@ -0,0 +1,128 @@
+/**
+ * @file node_arena.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of NodeArena.
+ */
+#include "node_arena.hpp"
+
+#include <new>
+
+using namespace mlpack;
+using namespace mlpack::tree;
+
+// Each allocation is preceded by a header holding the arena it came from (NULL
+// for the heap), padded so that the node itself is aligned for any type.
+union AllocationHeader
+{
+  NodeArena* arena;
+  long double alignLongDouble;
+  long long alignLongLong;
+  void* alignPointer;
+};
+
+static const size_t headerSize = sizeof(AllocationHeader);
+
+// Round the given size up to a multiple of the alignment of any type.
+static size_t Align(const size_t size)
+{
+  return (size + headerSize - 1) / headerSize * headerSize;
+}
+
+thread_local NodeArena* NodeArena::current = NULL;
+
+NodeArena::Scope::Scope(const size_t blockSize) :
+    arena(new NodeArena(blockSize)),
+    previous(current)
+{
+  current = arena;
+}
+
+NodeArena::Scope::~Scope()
+{
+  current = previous;
+  arena->scoped = false;
+  if (arena->nodes == 0)
+    delete arena;
+}
+
+NodeArena::NodeArena(const size_t blockSize) :
+    blockSize(Align(blockSize)),
+    blockUsed(0),
+    bytesReserved(0),
+    bytesUsed(0),
+    nodes(0),
+    scoped(true)
+{
+  // Nothing to do.
+}
+
+NodeArena::~NodeArena()
+{
+  for (size_t i = 0; i < blocks.size(); ++i)
+    ::operator delete(blocks[i]);
+}
+
+void* NodeArena::Take(const size_t bytes)
+{
+  // An allocation larger than a block gets a block of its own, so that the
+  // rest of the last block can still be used.
+  if (bytes > blockSize)
+  {
+    char* block = static_cast<char*>(::operator new(bytes));
+    if (blocks.empty())
+    {
+      blocks.push_back(block);
+      blockUsed = blockSize; // So that the next allocation makes a new block.
+    }
+    else
+    {
+      blocks.insert(blocks.end() - 1, block);
+    }
+    bytesReserved += bytes;
+    bytesUsed += bytes;
+    return block;
+  }
+
+  if (blocks.empty() || blockUsed + bytes > blockSize)
+  {
+    blocks.push_back(static_cast<char*>(::operator new(blockSize)));
+    blockUsed = 0;
+    bytesReserved += blockSize;
+  }
+
+  void* memory = blocks.back() + blockUsed;
+  blockUsed += bytes;
+  bytesUsed += bytes;
+  return memory;
+}
+
+void* NodeArena::Allocate(const size_t size)
+{
+  const size_t bytes = headerSize + Align(size);
+  AllocationHeader* header = static_cast<AllocationHeader*>((current == NULL) ?
+      ::operator new(bytes) : current->Take(bytes));
+  header->arena = current;
+  if (current != NULL)
+    ++current->nodes;
+
+  return header + 1;
+}
+
+void NodeArena::Free(void* memory)
+{
+  if (memory == NULL)
+    return;
+
+  AllocationHeader* header = static_cast<AllocationHeader*>(memory) - 1;
+  NodeArena* arena = header->arena;
+  if (arena == NULL)
+  {
+    ::operator delete(header);
+    return;
+  }
+
+  // The memory stays in the arena until the arena is freed.
+  if (--arena->nodes == 0 && !arena->scoped)
+    delete arena;
+}
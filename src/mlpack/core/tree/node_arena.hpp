@@ -0,0 +1,147 @@
+/**
+ * @file node_arena.hpp
+ * @author Ryan Curtin
+ *
+ * An arena from which the nodes of a tree can be allocated, so that building a
+ * tree does not make one heap allocation per node and the nodes of a tree lie
+ * next to each other in memory.
+ */
+#ifndef __MLPACK_CORE_TREE_NODE_ARENA_HPP
+#define __MLPACK_CORE_TREE_NODE_ARENA_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * An arena of large blocks of memory, from which tree nodes are allocated by
+ * bumping a pointer.  Trees that support arenas (CoverTree and RectangleTree)
+ * have a class-specific operator new and operator delete that call Allocate()
+ * and Free(); while a NodeArena::Scope is alive, every node created by the
+ * same thread (while building a tree, copying it, or loading it from an
+ * archive) is taken from the arena of the scope.  Otherwise, nodes come from
+ * the heap as usual.
+ *
+ * Deleting a node of an arena runs its destructor but gives back no memory;
+ * the blocks are freed all at once, when the scope has ended and the last node
+ * of the arena has been deleted.  So the tree is used and deleted exactly as
+ * one whose nodes came from the heap:
+ *
+ * @code
+ * CoverTree<>* tree;
+ * {
+ *   NodeArena::Scope scope;
+ *   tree = new CoverTree<>(dataset);
+ * }
+ * // ... use the tree ...
+ * delete tree; // The blocks of the arena are freed here.
+ * @endcode
+ *
+ * Nodes created after the scope ends (for instance, by inserting points into
+ * a RectangleTree) come from the heap, and may be mixed freely with the nodes
+ * of the arena.  An arena is not thread-safe: the nodes of an arena should not
+ * be created or deleted by several threads at once.  (Nodes created by other
+ * threads while the scope is alive come from the heap.)
+ */
+class NodeArena
+{
+ public:
+  /**
+   * While a Scope is alive, nodes created by its thread are allocated from its
+   * arena.  Scopes may be nested; the innermost one is used.
+   */
+  class Scope
+  {
+   public:
+    /**
+     * Create a new arena and use it until the scope ends.
+     *
+     * @param blockSize Size (in bytes) of each block of the arena.
+     */
+    explicit Scope(const size_t blockSize = 1 << 20);
+
+    /**
+     * Stop using the arena.  If none of its nodes are alive, it is freed now;
+     * otherwise, it is freed when the last one is deleted.
+     */
+    ~Scope();
+
+    //! Get the arena of the scope.
+    const NodeArena& Arena() const { return *arena; }
+
+   private:
+    //! The arena of the scope.
+    NodeArena* arena;
+    //! The arena that was used before the scope began, if any.
+    NodeArena* previous;
+
+    // A scope cannot be copied.
+    Scope(const Scope&);
+    Scope& operator=(const Scope&);
+  };
+
+  /**
+   * Allocate memory for a node from the arena of the current scope of this
+   * thread, or from the heap if there is none.
+   *
+   * @param size Size (in bytes) of the node.
+   */
+  static void* Allocate(const size_t size);
+
+  /**
+   * Free memory given by Allocate().  Memory from the heap is given back
+   * immediately; memory from an arena is not, but once all the nodes of an
+   * arena whose scope has ended are freed, the whole arena is.
+   *
+   * @param memory Memory given by Allocate() (or NULL).
+   */
+  static void Free(void* memory);
+
+  //! Get the number of nodes of the arena that are alive.
+  size_t Nodes() const { return nodes; }
+  //! Get the number of blocks of the arena.
+  size_t Blocks() const { return blocks.size(); }
+  //! Get the number of bytes of the blocks of the arena.
+  size_t BytesReserved() const { return bytesReserved; }
+  //! Get the number of bytes taken from the blocks of the arena.
+  size_t BytesUsed() const { return bytesUsed; }
+
+ private:
+  //! Create an empty arena with the given block size.
+  NodeArena(const size_t blockSize);
+  //! Free the blocks of the arena.
+  ~NodeArena();
+
+  //! Take the given number of bytes from the last block, making a new block
+  //! if it is too full.
+  void* Take(const size_t bytes);
+
+  //! The blocks of the arena.
+  std::vector<char*> blocks;
+  //! The size of each block (larger allocations get a block of their own).
+  size_t blockSize;
+  //! The number of bytes used in the last block.
+  size_t blockUsed;
+  //! The number of bytes of all blocks.
+  size_t bytesReserved;
+  //! The number of bytes taken from all blocks.
+  size_t bytesUsed;
+  //! The number of nodes of the arena that are alive.
+  size_t nodes;
+  //! Whether the scope of the arena is still alive.
+  bool scoped;
+
+  //! The arena of the innermost scope of this thread, if any.
+  static thread_local NodeArena* current;
+
+  // An arena cannot be copied.
+  NodeArena(const NodeArena&);
+  NodeArena& operator=(const NodeArena&);
+};
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,122 @@
+/**
+ * @file prefetch.hpp
+ * @author Ryan Curtin
+ *
+ * Software prefetching for the tree traversers: hints that ask the processor to
+ * start loading a tree node or a block of points into cache a little before
+ * they are needed, so that the traversal does not stall on every node it
+ * visits.
+ */
+#ifndef __MLPACK_CORE_TREE_PREFETCH_HPP
+#define __MLPACK_CORE_TREE_PREFETCH_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * Ask the processor to load the cache line holding the given address (for
+ * reading).  This is only a hint: it never faults, even for an invalid
+ * address, and it does nothing if the compiler has no prefetch intrinsic or if
+ * mlpack was compiled with MLPACK_NO_PREFETCH (the NO_PREFETCH CMake option),
+ * which is useful to measure what prefetching gains.
+ */
+inline void Prefetch(const void* address)
+{
+#if !defined(MLPACK_NO_PREFETCH) && defined(__GNUC__)
+  __builtin_prefetch(address, 0, 3);
+#else
+  (void) address;
+#endif
+}
+
+/**
+ * Prefetch the given number of bytes starting at the given address, one cache
+ * line (of 64 bytes) at a time.  At most maxBytes bytes are prefetched, since
+ * asking for much more than that just evicts the data that is being used.
+ *
+ * @param address Address of the first byte.
+ * @param bytes Number of bytes to prefetch.
+ * @param maxBytes Maximum number of bytes to prefetch.
+ */
+inline void PrefetchBytes(const void* address,
+                          const size_t bytes,
+                          const size_t maxBytes = 2048)
+{
+#if !defined(MLPACK_NO_PREFETCH) && defined(__GNUC__)
+  const char* begin = static_cast<const char*>(address);
+  const size_t end = std::min(bytes, maxBytes);
+  for (size_t offset = 0; offset < end; offset += 64)
+    __builtin_prefetch(begin + offset, 0, 3);
+#else
+  (void) address;
+  (void) bytes;
+  (void) maxBytes;
+#endif
+}
+
+/**
+ * Prefetch the first few cache lines of the given tree node.  For
+ * BinarySpaceTree and CoverTree, these hold the child pointers, the bound (for
+ * low-dimensional HRectBounds, whose ranges are held in the node), and the
+ * statistic, which are what Score() reads first.
+ *
+ * @param node Node to prefetch (may be NULL, which does nothing).
+ */
+template<typename TreeType>
+inline void PrefetchNode(const TreeType* node)
+{
+  if (node != NULL)
+    PrefetchBytes(node, sizeof(TreeType), 256);
+}
+
+/**
+ * Prefetch the given columns of a dense matrix, before the base cases with
+ * those points are evaluated (for instance, the points of a leaf, which are
+ * contiguous in the dataset of a BinarySpaceTree).
+ *
+ * @param data Dataset holding the points.
+ * @param begin Index of the first point.
+ * @param count Number of points.
+ */
+template<typename eT>
+inline void PrefetchPoints(const arma::Mat<eT>& data,
+                           const size_t begin,
+                           const size_t count)
+{
+  if (count > 0)
+    PrefetchBytes(data.colptr(begin), count * data.n_rows * sizeof(eT));
+}
+
+/**
+ * Sparse (and other) matrices don't store their points contiguously by column,
+ * so nothing is prefetched for them.
+ */
+template<typename MatType>
+inline void PrefetchPoints(const MatType& /* data */,
+                           const size_t /* begin */,
+                           const size_t /* count */) { }
+
+/**
+ * Prefetch ahead in a list of cover tree nodes that are visited one after the
+ * other: the node after next, and the point of the next node (whose own cache
+ * lines were asked for on the step before), so that neither stalls the
+ * traversal when its turn comes.  The point of a cover tree node is a column of
+ * the dataset, which (unless the dataset is reordered) may be anywhere in it.
+ *
+ * @param next The next node in the list (or NULL).
+ * @param afterNext The node after that (or NULL).
+ */
+template<typename TreeType>
+inline void PrefetchAhead(const TreeType* next, const TreeType* afterNext)
+{
+  PrefetchNode(afterNext);
+  if (next != NULL)
+    PrefetchPoints(next->Dataset(), next->Point(), 1);
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
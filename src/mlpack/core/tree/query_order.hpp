@@ -0,0 +1,110 @@
+/**
+ * @file query_order.hpp
+ * @author Ryan Curtin
+ *
+ * A utility function to find an order of a set of query points in which nearby
+ * points come one after the other, so that single-tree search can process the
+ * queries in that order and reuse the parts of the reference tree that the
+ * previous query brought into cache.
+ */
+#ifndef __MLPACK_CORE_TREE_QUERY_ORDER_HPP
+#define __MLPACK_CORE_TREE_QUERY_ORDER_HPP
+
+#include <mlpack/core.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * Fill order with a permutation of the columns of the given points, in which
+ * points that are close to each other are (mostly) next to each other: the
+ * order of the leaves of a kd-tree built on the points.  The points are not
+ * moved and no tree is built; the indices are split, as in kd-tree
+ * construction, at the median of the widest dimension, until each range holds
+ * no more than leafSize points.  This takes O(d n log(n / leafSize)) time for n
+ * points in d dimensions.
+ *
+ * The points in a leaf end up close together in the order, so queries taken in
+ * that order visit mostly the same reference nodes one after the other.  Since
+ * single-tree search writes the results of each query point to its own column,
+ * the results do not need to be permuted back.
+ *
+ * If spatial is false, the order is simply 0, 1, ..., n - 1.
+ *
+ * @param points Set of points (one per column).
+ * @param order Vector to store the order of the points in.
+ * @param spatial If false, the order is the order of the columns.
+ * @param leafSize Number of points below which ranges are not split.
+ */
+template<typename MatType>
+void QueryOrder(const MatType& points,
+                std::vector<size_t>& order,
+                const bool spatial = true,
+                const size_t leafSize = 8)
+{
+  order.resize(points.n_cols);
+  for (size_t i = 0; i < points.n_cols; ++i)
+    order[i] = i;
+
+  if (!spatial)
+    return;
+
+  // Each range of the order still to be split, as [begin, end).
+  std::vector<std::pair<size_t, size_t>> ranges;
+  ranges.push_back(std::make_pair(size_t(0), size_t(points.n_cols)));
+  arma::vec minValues(points.n_rows);
+  arma::vec maxValues(points.n_rows);
+  while (!ranges.empty())
+  {
+    const size_t begin = ranges.back().first;
+    const size_t end = ranges.back().second;
+    ranges.pop_back();
+
+    if (end - begin <= std::max(leafSize, size_t(1)))
+      continue;
+
+    // Find the widest dimension of the points in the range.
+    minValues.fill(DBL_MAX);
+    maxValues.fill(-DBL_MAX);
+    for (size_t i = begin; i < end; ++i)
+    {
+      for (size_t d = 0; d < points.n_rows; ++d)
+      {
+        const double value = points(d, order[i]);
+        minValues[d] = std::min(minValues[d], value);
+        maxValues[d] = std::max(maxValues[d], value);
+      }
+    }
+
+    size_t splitDim = 0;
+    double maxWidth = 0.0;
+    for (size_t d = 0; d < points.n_rows; ++d)
+    {
+      if (maxValues[d] - minValues[d] > maxWidth)
+      {
+        maxWidth = maxValues[d] - minValues[d];
+        splitDim = d;
+      }
+    }
+
+    // If all the points are the same, their order doesn't matter.
+    if (maxWidth == 0.0)
+      continue;
+
+    const size_t middle = begin + (end - begin) / 2;
+    auto lessInDim = [&points, splitDim](const size_t a, const size_t b)
+        { return points(splitDim, a) < points(splitDim, b); };
+    std::nth_element(order.begin() + begin, order.begin() + middle,
+        order.begin() + end, lessInDim);
+
+    ranges.push_back(std::make_pair(middle, end));
+    ranges.push_back(std::make_pair(begin, middle));
+  }
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
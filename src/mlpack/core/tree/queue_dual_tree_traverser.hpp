@@ -0,0 +1,206 @@
+/**
+ * @file queue_dual_tree_traverser.hpp
+ * @author Ryan Curtin
+ *
+ * A dual-tree traverser that keeps the node combinations it has scored in a
+ * queue, and expands them either in breadth-first order or in order of their
+ * scores, falling back to depth-first recursion when the queue is full.
+ */
+#ifndef __MLPACK_CORE_TREE_QUEUE_DUAL_TREE_TRAVERSER_HPP
+#define __MLPACK_CORE_TREE_QUEUE_DUAL_TREE_TRAVERSER_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/tree_traits.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+#include <queue>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * A dual-tree traverser that, instead of recursing depth-first, keeps every
+ * node combination it has scored but not yet expanded in a queue.  If
+ * Prioritized is false, the combinations are expanded in the order they were
+ * scored (breadth-first); if it is true, the combination with the best
+ * (lowest) score is always expanded next, so that the most promising
+ * combinations are searched first and the bounds of the rules are tightened
+ * early.  Each combination is rescored when it is expanded, since the bounds
+ * may have improved since it was scored.
+ *
+ * The traverser works with any tree whose points are held either only by the
+ * leaves (BinarySpaceTree, RectangleTree), or by every node, with the first
+ * point the centroid (CoverTree).  Base cases are evaluated between the points
+ * held by the two nodes of each expanded combination; for trees whose first
+ * point is the centroid, the base case between the centroids is evaluated
+ * when the combination is scored, and not again for a combination of two
+ * self-children.
+ *
+ * The queue can hold many combinations (up to the number of leaf
+ * combinations, for a breadth-first traversal with no prunes), so its size is
+ * capped: once the queue holds maxFrontier combinations, each combination that
+ * is expanded has its children traversed depth-first (in the order of their
+ * scores) instead of being added to the queue.
+ *
+ * @tparam TreeType Type of the trees to traverse.
+ * @tparam RuleType Type of the rules to traverse the trees with.
+ * @tparam Prioritized Whether to expand the combinations in order of their
+ *     scores (otherwise they are expanded breadth-first).
+ */
+template<typename TreeType, typename RuleType, bool Prioritized>
+class QueueDualTreeTraverser
+{
+ public:
+  /**
+   * Instantiate the dual-tree traverser with the given rule set and,
+   * optionally, the maximum number of combinations to hold in the queue.
+   *
+   * @param rule Rules to traverse the trees with.
+   * @param maxFrontier Maximum number of combinations in the queue (0 means
+   *     there is no limit).
+   */
+  QueueDualTreeTraverser(RuleType& rule, const size_t maxFrontier = 1000000);
+
+  /**
+   * Traverse the two trees.  This does not reset the number of prunes.
+   *
+   * @param queryNode The query node to be traversed.
+   * @param referenceNode The reference node to be traversed.
+   */
+  void Traverse(TreeType& queryNode, TreeType& referenceNode);
+
+  //! Get the maximum number of combinations in the queue.
+  size_t MaxFrontier() const { return maxFrontier; }
+  //! Modify the maximum number of combinations in the queue (0 means there is
+  //! no limit).
+  size_t& MaxFrontier() { return maxFrontier; }
+
+  //! Get the number of prunes.
+  size_t NumPrunes() const { return numPrunes; }
+  //! Modify the number of prunes.
+  size_t& NumPrunes() { return numPrunes; }
+
+  //! Get the number of visited combinations.
+  size_t NumVisited() const { return numVisited; }
+  //! Modify the number of visited combinations.
+  size_t& NumVisited() { return numVisited; }
+
+  //! Get the number of times a node combination was scored.
+  size_t NumScores() const { return numScores; }
+  //! Modify the number of times a node combination was scored.
+  size_t& NumScores() { return numScores; }
+
+  //! Get the number of times a base case was calculated.
+  size_t NumBaseCases() const { return numBaseCases; }
+  //! Modify the number of times a base case was calculated.
+  size_t& NumBaseCases() { return numBaseCases; }
+
+  //! Get the largest number of combinations the queue held.
+  size_t PeakFrontier() const { return peakFrontier; }
+
+  //! The traversal statistics policy (see TraversalStatisticsPolicy).
+  typedef typename TraversalStatisticsPolicy<RuleType>::Type
+      TraversalStatisticsType;
+
+  //! Get the statistics recorded during traversal (with the default policy,
+  //! nothing is recorded).
+  const TraversalStatisticsType& Statistics() const { return statistics; }
+
+ private:
+  //! A scored node combination that has not been expanded yet.
+  struct Frame
+  {
+    //! The query node.
+    TreeType* queryNode;
+    //! The reference node.
+    TreeType* referenceNode;
+    //! The score of the combination.
+    double score;
+    //! The traversal information after the combination was scored.
+    typename RuleType::TraversalInfoType traversalInfo;
+
+    //! Comparison operator; the best (lowest) score is at the top of a
+    //! priority queue.
+    bool operator<(const Frame& other) const { return (score > other.score); }
+  };
+
+  //! The queue of combinations: a priority queue or a FIFO queue.
+  typedef typename std::conditional<Prioritized,
+      std::priority_queue<Frame>, std::queue<Frame>>::type QueueType;
+
+  //! Get the next combination of a priority queue.
+  static const Frame& Next(std::priority_queue<Frame>& queue)
+  {
+    return queue.top();
+  }
+
+  //! Get the next combination of a FIFO queue.
+  static const Frame& Next(std::queue<Frame>& queue) { return queue.front(); }
+
+  /**
+   * Score the given combination and, unless it can be pruned, add it to the
+   * given vector.  If the first point of each node is the centroid, the base
+   * case between the centroids is evaluated here.
+   *
+   * @param queryNode The query node.
+   * @param referenceNode The reference node.
+   * @param parent The combination that was expanded into this one (NULL for
+   *     the roots).
+   * @param frames The vector to add the scored combination to.
+   */
+  void ScoreFrame(TreeType& queryNode,
+                  TreeType& referenceNode,
+                  const Frame* parent,
+                  std::vector<Frame>& frames);
+
+  /**
+   * Evaluate the base cases between the points held by the nodes of the given
+   * combination, and score the combinations of their children.
+   *
+   * @param frame The combination to expand.
+   * @param children The vector to add the scored child combinations to.
+   */
+  void Expand(const Frame& frame, std::vector<Frame>& children);
+
+  /**
+   * Rescore the given combination and, unless it can be pruned, expand it and
+   * traverse its children depth-first.
+   *
+   * @param frame The combination to traverse.
+   */
+  void DepthFirst(const Frame& frame);
+
+  //! Reference to the rules with which the trees will be traversed.
+  RuleType& rule;
+
+  //! The maximum number of combinations in the queue.
+  size_t maxFrontier;
+
+  //! The statistics recorded during traversal.
+  TraversalStatisticsType statistics;
+
+  //! The number of prunes.
+  size_t numPrunes;
+
+  //! The number of node combinations that have been visited during traversal.
+  size_t numVisited;
+
+  //! The number of times a node combination was scored.
+  size_t numScores;
+
+  //! The number of times a base case was calculated.
+  size_t numBaseCases;
+
+  //! The largest number of combinations the queue held.
+  size_t peakFrontier;
+
+  //! The traversal information of the rules when the traversal started.
+  typename RuleType::TraversalInfoType rootInfo;
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "queue_dual_tree_traverser_impl.hpp"
+
+#endif
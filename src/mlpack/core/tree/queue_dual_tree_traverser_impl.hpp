@@ -0,0 +1,205 @@
+/**
+ * @file queue_dual_tree_traverser_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the QueueDualTreeTraverser.
+ */
+#ifndef __MLPACK_CORE_TREE_QUEUE_DUAL_TREE_TRAVERSER_IMPL_HPP
+#define __MLPACK_CORE_TREE_QUEUE_DUAL_TREE_TRAVERSER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "queue_dual_tree_traverser.hpp"
+
+namespace mlpack {
+namespace tree {
+
+template<typename TreeType, typename RuleType, bool Prioritized>
+QueueDualTreeTraverser<TreeType, RuleType, Prioritized>::
+QueueDualTreeTraverser(RuleType& rule, const size_t maxFrontier) :
+    rule(rule),
+    maxFrontier(maxFrontier),
+    numPrunes(0),
+    numVisited(0),
+    numScores(0),
+    numBaseCases(0),
+    peakFrontier(0)
+{ /* Nothing to do. */ }
+
+template<typename TreeType, typename RuleType, bool Prioritized>
+void QueueDualTreeTraverser<TreeType, RuleType, Prioritized>::Traverse(
+    TreeType& queryNode,
+    TreeType& referenceNode)
+{
+  // Store the current traversal info; the roots are scored with it.
+  rootInfo = rule.TraversalInfo();
+
+  std::vector<Frame> frames;
+  ScoreFrame(queryNode, referenceNode, NULL, frames);
+
+  QueueType queue;
+  for (size_t i = 0; i < frames.size(); ++i)
+    queue.push(frames[i]);
+  peakFrontier = std::max(peakFrontier, (size_t) queue.size());
+
+  while (!queue.empty())
+  {
+    const Frame frame = Next(queue);
+    queue.pop();
+
+    // The bounds may have improved since the combination was scored.
+    rule.TraversalInfo() = frame.traversalInfo;
+    if (statistics.Rescore(rule, *frame.queryNode, *frame.referenceNode,
+        frame.score) == DBL_MAX)
+    {
+      ++numPrunes;
+      continue;
+    }
+
+    frames.clear();
+    Expand(frame, frames);
+
+    if (maxFrontier == 0 || queue.size() + frames.size() <= maxFrontier)
+    {
+      for (size_t i = 0; i < frames.size(); ++i)
+        queue.push(frames[i]);
+      peakFrontier = std::max(peakFrontier, (size_t) queue.size());
+    }
+    else
+    {
+      // The queue is full, so the children are traversed depth-first, best
+      // first.
+      std::sort(frames.begin(), frames.end(),
+          [](const Frame& a, const Frame& b) { return a.score < b.score; });
+      for (size_t i = 0; i < frames.size(); ++i)
+        DepthFirst(frames[i]);
+    }
+  }
+}
+
+template<typename TreeType, typename RuleType, bool Prioritized>
+void QueueDualTreeTraverser<TreeType, RuleType, Prioritized>::ScoreFrame(
+    TreeType& queryNode,
+    TreeType& referenceNode,
+    const Frame* parent,
+    std::vector<Frame>& frames)
+{
+  // If both nodes are self-children, the base case between their points has
+  // been evaluated already, and if both are leaves, there is nothing new.
+  const bool selfPair = TreeTraits<TreeType>::HasSelfChildren &&
+      (parent != NULL) &&
+      (queryNode.Point(0) == parent->queryNode->Point(0)) &&
+      (referenceNode.Point(0) == parent->referenceNode->Point(0));
+  if (selfPair && queryNode.IsLeaf() && referenceNode.IsLeaf())
+  {
+    ++numPrunes;
+    return;
+  }
+
+  // Restore the traversal info of the parent combination before scoring.
+  rule.TraversalInfo() = (parent == NULL) ? rootInfo : parent->traversalInfo;
+
+  Frame frame;
+  frame.queryNode = &queryNode;
+  frame.referenceNode = &referenceNode;
+  frame.score = statistics.Score(rule, queryNode, referenceNode);
+  ++numScores;
+  if (frame.score == DBL_MAX)
+  {
+    ++numPrunes;
+    return;
+  }
+
+  // If the first point is the centroid, the rules may have evaluated the base
+  // case between the centroids while scoring, so evaluate it now; this way it
+  // is not evaluated a second time (the rules skip a base case that is the same
+  // as the last one).
+  if (TreeTraits<TreeType>::FirstPointIsCentroid && !selfPair)
+  {
+    rule.BaseCase(queryNode.Point(0), referenceNode.Point(0));
+    statistics.BaseCases(queryNode, referenceNode, 1);
+    ++numBaseCases;
+  }
+
+  frame.traversalInfo = rule.TraversalInfo();
+  frames.push_back(frame);
+}
+
+template<typename TreeType, typename RuleType, bool Prioritized>
+void QueueDualTreeTraverser<TreeType, RuleType, Prioritized>::Expand(
+    const Frame& frame,
+    std::vector<Frame>& children)
+{
+  ++numVisited;
+
+  TreeType& queryNode = *frame.queryNode;
+  TreeType& referenceNode = *frame.referenceNode;
+
+  // Evaluate the points held by the two nodes (if the first point is the
+  // centroid, the base case between the centroids was evaluated already).
+  size_t baseCases = 0;
+  for (size_t i = 0; i < queryNode.NumPoints(); ++i)
+  {
+    for (size_t j = 0; j < referenceNode.NumPoints(); ++j)
+    {
+      if (TreeTraits<TreeType>::FirstPointIsCentroid && i == 0 && j == 0)
+        continue;
+
+      rule.BaseCase(queryNode.Point(i), referenceNode.Point(j));
+      ++baseCases;
+    }
+  }
+
+  if (baseCases > 0)
+  {
+    statistics.BaseCases(queryNode, referenceNode, baseCases);
+    numBaseCases += baseCases;
+  }
+
+  // Now score the combinations of the children.
+  if (queryNode.IsLeaf() && referenceNode.IsLeaf())
+    return;
+
+  if (referenceNode.IsLeaf())
+  {
+    for (size_t i = 0; i < queryNode.NumChildren(); ++i)
+      ScoreFrame(queryNode.Child(i), referenceNode, &frame, children);
+  }
+  else if (queryNode.IsLeaf())
+  {
+    for (size_t j = 0; j < referenceNode.NumChildren(); ++j)
+      ScoreFrame(queryNode, referenceNode.Child(j), &frame, children);
+  }
+  else
+  {
+    for (size_t i = 0; i < queryNode.NumChildren(); ++i)
+      for (size_t j = 0; j < referenceNode.NumChildren(); ++j)
+        ScoreFrame(queryNode.Child(i), referenceNode.Child(j), &frame,
+            children);
+  }
+}
+
+template<typename TreeType, typename RuleType, bool Prioritized>
+void QueueDualTreeTraverser<TreeType, RuleType, Prioritized>::DepthFirst(
+    const Frame& frame)
+{
+  rule.TraversalInfo() = frame.traversalInfo;
+  if (statistics.Rescore(rule, *frame.queryNode, *frame.referenceNode,
+      frame.score) == DBL_MAX)
+  {
+    ++numPrunes;
+    return;
+  }
+
+  std::vector<Frame> children;
+  Expand(frame, children);
+
+  std::sort(children.begin(), children.end(),
+      [](const Frame& a, const Frame& b) { return a.score < b.score; });
+  for (size_t i = 0; i < children.size(); ++i)
+    DepthFirst(children[i]);
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
@@ -10,6 +10,7 @@
 #define __MLPACK_CORE_TREE_RECTANGLE_TREE_DUAL_TREE_TRAVERSER_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
 
 #include "rectangle_tree.hpp"
 
@@ -60,6 +61,14 @@ class RectangleTree<MetricType, StatisticType, MatType, SplitType,
   //! Modify the number of times a base case was calculated.
   size_t& NumBaseCases() { return numBaseCases; }
 
+  //! The traversal statistics policy (see TraversalStatisticsPolicy).
+  typedef typename TraversalStatisticsPolicy<RuleType>::Type
+      TraversalStatisticsType;
+
+  //! Get the statistics recorded during traversal (with the default policy,
+  //! nothing is recorded).
+  const TraversalStatisticsType& Statistics() const { return statistics; }
+
  private:
 
   // We use this struct and this function to make the sorting and scoring easy
@@ -80,6 +89,9 @@ class RectangleTree<MetricType, StatisticType, MatType, SplitType,
   //! Reference to the rules with which the trees will be traversed.
   RuleType& rule;
 
+  //! The statistics recorded during traversal.
+  TraversalStatisticsType statistics;
+
   //! The number of prunes.
   size_t numPrunes;
 
@@ -63,8 +63,8 @@ DualTreeTraverser<RuleType>::Traverse(RectangleTree& queryNode,
     {
       // Restore the traversal information.
       rule.TraversalInfo() = traversalInfo;
-      const double childScore = rule.Score(queryNode.Points()[query],
-          referenceNode);
+      const double childScore = statistics.Score(rule,
+          queryNode.Points()[query], referenceNode);
 
       if (childScore == DBL_MAX)
         continue;  // We don't require a search in this reference node.
@@ -73,6 +73,7 @@ DualTreeTraverser<RuleType>::Traverse(RectangleTree& queryNode,
         rule.BaseCase(queryNode.Points()[query], referenceNode.Points()[ref]);
 
       numBaseCases += referenceNode.Count();
+      statistics.BaseCases(queryNode, referenceNode, referenceNode.Count());
     }
   }
   else if (!queryNode.IsLeaf() && referenceNode.IsLeaf())
@@ -83,7 +84,7 @@ DualTreeTraverser<RuleType>::Traverse(RectangleTree& queryNode,
       // Before recursing, we have to set the traversal information correctly.
       rule.TraversalInfo() = traversalInfo;
       ++numScores;
-      if (rule.Score(queryNode.Child(i), referenceNode) < DBL_MAX)
+      if (statistics.Score(rule, queryNode.Child(i), referenceNode) < DBL_MAX)
         Traverse(queryNode.Child(i), referenceNode);
       else
         numPrunes++;
@@ -100,7 +101,7 @@ DualTreeTraverser<RuleType>::Traverse(RectangleTree& queryNode,
     {
       rule.TraversalInfo() = traversalInfo;
       nodesAndScores[i].node = referenceNode.Children()[i];
-      nodesAndScores[i].score = rule.Score(queryNode,
+      nodesAndScores[i].score = statistics.Score(rule, queryNode,
           *(nodesAndScores[i].node));
       nodesAndScores[i].travInfo = rule.TraversalInfo();
     }
@@ -110,7 +111,7 @@ DualTreeTraverser<RuleType>::Traverse(RectangleTree& queryNode,
     for (size_t i = 0; i < nodesAndScores.size(); i++)
     {
       rule.TraversalInfo() = nodesAndScores[i].travInfo;
-      if (rule.Rescore(queryNode, *(nodesAndScores[i].node),
+      if (statistics.Rescore(rule, queryNode, *(nodesAndScores[i].node),
           nodesAndScores[i].score) < DBL_MAX)
       {
         Traverse(queryNode, *(nodesAndScores[i].node));
@@ -135,7 +136,7 @@ DualTreeTraverser<RuleType>::Traverse(RectangleTree& queryNode,
       {
         rule.TraversalInfo() = traversalInfo;
         nodesAndScores[i].node = referenceNode.Children()[i];
-        nodesAndScores[i].score = rule.Score(queryNode.Child(j),
+        nodesAndScores[i].score = statistics.Score(rule, queryNode.Child(j),
             *nodesAndScores[i].node);
         nodesAndScores[i].travInfo = rule.TraversalInfo();
       }
@@ -145,8 +146,8 @@ DualTreeTraverser<RuleType>::Traverse(RectangleTree& queryNode,
       for (size_t i = 0; i < nodesAndScores.size(); i++)
       {
         rule.TraversalInfo() = nodesAndScores[i].travInfo;
-        if (rule.Rescore(queryNode.Child(j), *(nodesAndScores[i].node),
-            nodesAndScores[i].score) < DBL_MAX)
+        if (statistics.Rescore(rule, queryNode.Child(j),
+            *(nodesAndScores[i].node), nodesAndScores[i].score) < DBL_MAX)
         {
           Traverse(queryNode.Child(j), *(nodesAndScores[i].node));
         }
@@ -32,7 +32,6 @@ void RTreeSplit::SplitLeafNode(TreeType* tree, std::vector<bool>& relevels)
     TreeType* copy = new TreeType(*tree, false);
     copy->Parent() = tree;
     tree->Count() = 0;
-    tree->NullifyData();
     // Because this was a leaf node, numChildren must be 0.
     tree->Children()[(tree->NumChildren())++] = copy;
     SplitLeafNode(copy, relevels);
@@ -96,7 +95,6 @@ bool RTreeSplit::SplitNonLeafNode(TreeType* tree, std::vector<bool>& relevels)
     TreeType* copy = new TreeType(*tree, false);
     copy->Parent() = tree;
     tree->NumChildren() = 0;
-    tree->NullifyData();
     tree->Children()[(tree->NumChildren())++] = copy;
     SplitNonLeafNode(copy, relevels);
     return true;
@@ -167,8 +165,9 @@ void RTreeSplit::GetPointSeeds(const TreeType& tree, int& iRet, int& jRet)
   {
     for (size_t j = i + 1; j < tree.Count(); j++)
     {
-      const double score = arma::prod(arma::abs(tree.LocalDataset().col(i) -
-          tree.LocalDataset().col(j)));
+      const double score = arma::prod(arma::abs(
+          tree.Dataset().col(tree.Point(i)) -
+          tree.Dataset().col(tree.Point(j))));
 
       if (score > worstPairScore)
       {
@@ -236,16 +235,12 @@ void RTreeSplit::AssignPointDestNode(TreeType* oldTree,
   if (intI > intJ)
   {
     oldTree->Points()[intI] = oldTree->Points()[--end]; // Decrement end.
-    oldTree->LocalDataset().col(intI) = oldTree->LocalDataset().col(end);
     oldTree->Points()[intJ] = oldTree->Points()[--end]; // Decrement end.
-    oldTree->LocalDataset().col(intJ) = oldTree->LocalDataset().col(end);
   }
   else
   {
     oldTree->Points()[intJ] = oldTree->Points()[--end]; // Decrement end.
-    oldTree->LocalDataset().col(intJ) = oldTree->LocalDataset().col(end);
     oldTree->Points()[intI] = oldTree->Points()[--end]; // Decrement end.
-    oldTree->LocalDataset().col(intI) = oldTree->LocalDataset().col(end);
   }
 
   size_t numAssignedOne = 1;
@@ -287,7 +282,7 @@ void RTreeSplit::AssignPointDestNode(TreeType* oldTree,
       double newVolTwo = 1.0;
       for (size_t i = 0; i < oldTree->Bound().Dim(); i++)
       {
-        double c = oldTree->LocalDataset().col(index)[i];
+        double c = oldTree->Dataset()(i, oldTree->Point(index));
         newVolOne *= treeOne->Bound()[i].Contains(c) ?
             treeOne->Bound()[i].Width() : (c < treeOne->Bound()[i].Lo() ?
             (treeOne->Bound()[i].Hi() - c) : (c - treeOne->Bound()[i].Lo()));
@@ -331,7 +326,6 @@ void RTreeSplit::AssignPointDestNode(TreeType* oldTree,
     }
 
     oldTree->Points()[bestIndex] = oldTree->Points()[--end]; // Decrement end.
-    oldTree->LocalDataset().col(bestIndex) = oldTree->LocalDataset().col(end);
   }
 
   // See if we need to satisfy the minimum fill.
@@ -12,12 +12,29 @@
 
 #include "../hrectbound.hpp"
 #include "../statistic.hpp"
+#include "../node_arena.hpp"
+#include "../queue_dual_tree_traverser.hpp"
 #include "r_tree_split.hpp"
 #include "r_tree_descent_heuristic.hpp"
 
 namespace mlpack {
 namespace tree /** Trees and tree-building procedures. */ {
 
+/**
+ * Pass an object of this type to the RectangleTree constructor to build the
+ * tree with Sort-Tile-Recursive bulk loading (Leutenegger, Lopez and Edgington,
+ * 1997) instead of inserting the points one at a time.
+ */
+struct STRBulkLoad { };
+
+/**
+ * Pass an object of this type to the RectangleTree constructor to build the
+ * tree with Hilbert packing (Kamel and Faloutsos, 1993): the points are sorted
+ * by their position along a Hilbert curve and cut into leaves in that order,
+ * and each level of nodes is cut in the same order into the level above.
+ */
+struct HilbertBulkLoad { };
+
 /**
  * A rectangle type tree tree, such as an R-tree or X-tree.  Once the
  * bound and type of dataset is defined, the tree will construct itself.  Call
@@ -106,10 +123,9 @@ class RectangleTree
   //! Whether or not we are responsible for deleting the dataset.  This is
   //! probably not aligned well...
   bool ownsDataset;
-  //! The mapping to the dataset
+  //! The indices in the dataset of the points held by this node (if it is a
+  //! leaf).  Leaves do not hold copies of their points.
   std::vector<size_t> points;
-  //! The local dataset
-  MatType* localDataset;
 
  public:
   //! So other classes can use TreeType::Mat.
@@ -123,6 +139,18 @@ class RectangleTree
   template<typename RuleType>
   class DualTreeTraverser;
 
+  //! A dual-tree traverser that expands the node combinations breadth-first;
+  //! see queue_dual_tree_traverser.hpp.
+  template<typename RuleType>
+  using LevelOrderDualTreeTraverser =
+      QueueDualTreeTraverser<RectangleTree, RuleType, false>;
+
+  //! A dual-tree traverser that expands the node combinations in order of
+  //! their scores; see queue_dual_tree_traverser.hpp.
+  template<typename RuleType>
+  using PrioritizedDualTreeTraverser =
+      QueueDualTreeTraverser<RectangleTree, RuleType, true>;
+
   /**
    * Construct this as the root node of a rectangle type tree using the given
    * dataset.  This will modify the ordering of the points in the dataset!
@@ -165,6 +193,101 @@ class RectangleTree
                 const size_t minNumChildren = 2,
                 const size_t firstDataIndex = 0);
 
+  /**
+   * Construct this as the root node of a rectangle type tree using the given
+   * dataset, packing the points into nodes with Sort-Tile-Recursive (STR) bulk
+   * loading instead of inserting them one at a time.  The points are sorted
+   * and tiled into leaves that are as full as possible, and the leaves are
+   * tiled the same way into each level above them, so the whole tree is built
+   * in O(n log n) time without any node splits.  Leaves hold between
+   * maxLeafSize / 2 and maxLeafSize points (unless the root is a leaf), and
+   * every leaf is on the same level.  The SplitType and DescentType are only
+   * used if points are inserted later.  The dataset is not modified.
+   *
+   * @param data Dataset from which to create the tree.
+   * @param maxLeafSize Maximum size of each leaf in the tree.
+   * @param minLeafSize Minimum size of each leaf in the tree.  This must be at
+   *      most maxLeafSize / 2.
+   * @param maxNumChildren The maximum number of child nodes a non-leaf node may
+   *      have.
+   * @param minNumChildren The minimum number of child nodes a non-leaf node may
+   *      have.  This must be at most maxNumChildren / 2.
+   */
+  RectangleTree(const MatType& data,
+                const STRBulkLoad& /* bulkLoad */,
+                const size_t maxLeafSize = 20,
+                const size_t minLeafSize = 8,
+                const size_t maxNumChildren = 5,
+                const size_t minNumChildren = 2);
+
+  /**
+   * Construct this as the root node of a rectangle type tree using the given
+   * dataset with Sort-Tile-Recursive bulk loading, taking ownership of the
+   * given dataset.  See the constructor above for details.
+   *
+   * @param data Dataset from which to create the tree.
+   * @param maxLeafSize Maximum size of each leaf in the tree.
+   * @param minLeafSize Minimum size of each leaf in the tree.
+   * @param maxNumChildren The maximum number of child nodes a non-leaf node may
+   *      have.
+   * @param minNumChildren The minimum number of child nodes a non-leaf node may
+   *      have.
+   */
+  RectangleTree(MatType&& data,
+                const STRBulkLoad& /* bulkLoad */,
+                const size_t maxLeafSize = 20,
+                const size_t minLeafSize = 8,
+                const size_t maxNumChildren = 5,
+                const size_t minNumChildren = 2);
+
+  /**
+   * Construct this as the root node of a rectangle type tree using the given
+   * dataset, packing the points into nodes in the order of their Hilbert
+   * values instead of inserting them one at a time.  The discrete Hilbert value
+   * of each point is computed once, so the points are sorted with integer
+   * comparisons, and the nodes of each level are already in curve order, so
+   * they are cut into the level above without sorting again.  As with
+   * Sort-Tile-Recursive bulk loading, leaves hold between maxLeafSize / 2 and
+   * maxLeafSize points (unless the root is a leaf), every leaf is on the same
+   * level, and the SplitType and DescentType are only used if points are
+   * inserted later.  The dataset is not modified.
+   *
+   * @param data Dataset from which to create the tree.
+   * @param maxLeafSize Maximum size of each leaf in the tree.
+   * @param minLeafSize Minimum size of each leaf in the tree.  This must be at
+   *      most maxLeafSize / 2.
+   * @param maxNumChildren The maximum number of child nodes a non-leaf node may
+   *      have.
+   * @param minNumChildren The minimum number of child nodes a non-leaf node may
+   *      have.  This must be at most maxNumChildren / 2.
+   */
+  RectangleTree(const MatType& data,
+                const HilbertBulkLoad& /* bulkLoad */,
+                const size_t maxLeafSize = 20,
+                const size_t minLeafSize = 8,
+                const size_t maxNumChildren = 5,
+                const size_t minNumChildren = 2);
+
+  /**
+   * Construct this as the root node of a rectangle type tree using the given
+   * dataset with Hilbert packing, taking ownership of the given dataset.  See
+   * the constructor above for details.
+   *
+   * @param data Dataset from which to create the tree.
+   * @param maxLeafSize Maximum size of each leaf in the tree.
+   * @param minLeafSize Minimum size of each leaf in the tree.
+   * @param maxNumChildren The maximum number of child nodes a non-leaf node may
+   *      have.
+   * @param minNumChildren The minimum number of child nodes a non-leaf node may
+   *      have.
+   */
+  RectangleTree(MatType&& data,
+                const HilbertBulkLoad& /* bulkLoad */,
+                const size_t maxLeafSize = 20,
+                const size_t minLeafSize = 8,
+                const size_t maxNumChildren = 5,
+                const size_t minNumChildren = 2);
+
   /**
    * Construct this as an empty node with the specified parent.  Copying the
    * parameters (maxLeafSize, minLeafSize, maxNumChildren, minNumChildren,
@@ -198,6 +321,15 @@ class RectangleTree
    */
   ~RectangleTree();
 
+  /**
+   * Allocate memory for a node.  While a NodeArena::Scope is alive, nodes are
+   * taken from its arena; otherwise, they come from the heap.
+   */
+  static void* operator new(size_t size) { return NodeArena::Allocate(size); }
+
+  //! Free memory given by operator new(); see NodeArena.
+  static void operator delete(void* memory) { NodeArena::Free(memory); }
+
   /**
    * Delete this node of the tree, but leave the stuff contained in it intact.
    * This is used when splitting a node, where the data in this tree is moved to
@@ -205,11 +337,6 @@ class RectangleTree
    */
   void SoftDelete();
 
-  /**
-   * Set dataset to null. Used for memory management.  Be cafeful.
-   */
-  void NullifyData();
-
   /**
    * Inserts a point into the tree. The point will be copied to the data matrix
    * of the leaf node where it is finally inserted, but we pass by reference
@@ -352,11 +479,6 @@ class RectangleTree
   //! Modify the points vector for this node.  Be careful!
   std::vector<size_t>& Points() { return points; }
 
-  //! Get the local dataset of this node.
-  const MatType& LocalDataset() const { return *localDataset; }
-  //! Modify the local dataset of this node.
-  MatType& LocalDataset() { return *localDataset; }
-
   //! Get the metric which the tree uses.
   MetricType Metric() const { return MetricType(); }
 
@@ -547,6 +669,61 @@ class RectangleTree
    */
   void SplitNode(std::vector<bool>& relevels);
 
+  /**
+   * Build the tree under this (empty) root node with Sort-Tile-Recursive bulk
+   * loading, or with Hilbert packing if hilbert is true.
+   */
+  void BulkLoad(const bool hilbert);
+
+  /**
+   * Sort-Tile-Recursive tiling: divide the items in order[begin, end) into
+   * groups of at most the given capacity, such that items in a group are close
+   * to each other.  The items are sorted along the given dimension and cut into
+   * slabs, and each slab is tiled along the next dimension.  Each item's
+   * position is a column of the given matrix.  Groups are stored in order, and
+   * the end of each group is appended to groupEnds.
+   */
+  static void Tile(const arma::mat& positions,
+                   std::vector<size_t>& order,
+                   const size_t begin,
+                   const size_t end,
+                   const size_t dimension,
+                   const size_t capacity,
+                   std::vector<size_t>& groupEnds);
+
+  /**
+   * Hilbert tiling: divide the items in order into groups of at most the given
+   * capacity, in the order of the Hilbert values of their positions (the
+   * columns of the given matrix; see HilbertValues()).  The end of each group
+   * is appended to groupEnds.
+   */
+  static void HilbertTile(const arma::mat& positions,
+                          std::vector<size_t>& order,
+                          const size_t capacity,
+                          std::vector<size_t>& groupEnds);
+
+  /**
+   * Compute the discrete Hilbert value of each column of the given matrix.
+   * Each of the first (at most 64) dimensions is quantized to
+   * min(64 / dimensions, 32) bits over the range of the points, and the cell of
+   * each point is mapped to its index along the Hilbert curve through those
+   * cells (with Skilling's algorithm), so that points that are close along the
+   * curve are close in space.
+   *
+   * @param positions Points to compute the Hilbert values of.
+   * @param values Vector to store the Hilbert value of each point in.
+   */
+  static void HilbertValues(const arma::mat& positions,
+                            std::vector<uint64_t>& values);
+
+  //! Cut the items in [begin, end) into the fewest groups of at most the given
+  //! capacity, whose sizes differ by at most one, and append the end of each
+  //! group to groupEnds.
+  static void CutGroups(const size_t begin,
+                        const size_t end,
+                        const size_t capacity,
+                        std::vector<size_t>& groupEnds);
+
  protected:
   /**
    * A default constructor.  This is meant to only be used with
@@ -13,6 +13,7 @@
 #include <mlpack/core/util/cli.hpp>
 #include <mlpack/core/util/log.hpp>
 #include <mlpack/core/util/string_util.hpp>
+#include <algorithm>
 
 namespace mlpack {
 namespace tree {
@@ -43,9 +44,7 @@ RectangleTree(const MatType& data,
     parentDistance(0),
     dataset(new MatType(data)),
     ownsDataset(true),
-    points(maxLeafSize + 1), // Add one to make splitting the node simpler.
-    localDataset(new MatType(arma::zeros<MatType>(data.n_rows,
-                                                  maxLeafSize + 1)))
+    points(maxLeafSize + 1) // Add one to make splitting the node simpler.
 {
   stat = StatisticType(*this);
 
@@ -82,9 +81,7 @@ RectangleTree(MatType&& data,
     parentDistance(0),
     dataset(new MatType(std::move(data))),
     ownsDataset(true),
-    points(maxLeafSize + 1), // Add one to make splitting the node simpler.
-    localDataset(new MatType(arma::zeros<MatType>(dataset->n_rows,
-                                                  maxLeafSize + 1)))
+    points(maxLeafSize + 1) // Add one to make splitting the node simpler.
 {
   stat = StatisticType(*this);
 
@@ -95,6 +92,130 @@ RectangleTree(MatType&& data,
     root->InsertPoint(i);
 }
 
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType,
+         typename DescentType>
+RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+RectangleTree(const MatType& data,
+              const STRBulkLoad& /* bulkLoad */,
+              const size_t maxLeafSize,
+              const size_t minLeafSize,
+              const size_t maxNumChildren,
+              const size_t minNumChildren) :
+    maxNumChildren(maxNumChildren),
+    minNumChildren(minNumChildren),
+    numChildren(0),
+    children(maxNumChildren + 1), // Add one to make splitting the node simpler.
+    parent(NULL),
+    begin(0),
+    count(0),
+    maxLeafSize(maxLeafSize),
+    minLeafSize(minLeafSize),
+    bound(data.n_rows),
+    splitHistory(bound.Dim()),
+    parentDistance(0),
+    dataset(new MatType(data)),
+    ownsDataset(true),
+    points(maxLeafSize + 1) // Add one to make splitting the node simpler.
+{
+  BulkLoad(false);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType,
+         typename DescentType>
+RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+RectangleTree(MatType&& data,
+              const STRBulkLoad& /* bulkLoad */,
+              const size_t maxLeafSize,
+              const size_t minLeafSize,
+              const size_t maxNumChildren,
+              const size_t minNumChildren) :
+    maxNumChildren(maxNumChildren),
+    minNumChildren(minNumChildren),
+    numChildren(0),
+    children(maxNumChildren + 1), // Add one to make splitting the node simpler.
+    parent(NULL),
+    begin(0),
+    count(0),
+    maxLeafSize(maxLeafSize),
+    minLeafSize(minLeafSize),
+    bound(data.n_rows),
+    splitHistory(bound.Dim()),
+    parentDistance(0),
+    dataset(new MatType(std::move(data))),
+    ownsDataset(true),
+    points(maxLeafSize + 1) // Add one to make splitting the node simpler.
+{
+  BulkLoad(false);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType,
+         typename DescentType>
+RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+RectangleTree(const MatType& data,
+              const HilbertBulkLoad& /* bulkLoad */,
+              const size_t maxLeafSize,
+              const size_t minLeafSize,
+              const size_t maxNumChildren,
+              const size_t minNumChildren) :
+    maxNumChildren(maxNumChildren),
+    minNumChildren(minNumChildren),
+    numChildren(0),
+    children(maxNumChildren + 1), // Add one to make splitting the node simpler.
+    parent(NULL),
+    begin(0),
+    count(0),
+    maxLeafSize(maxLeafSize),
+    minLeafSize(minLeafSize),
+    bound(data.n_rows),
+    splitHistory(bound.Dim()),
+    parentDistance(0),
+    dataset(new MatType(data)),
+    ownsDataset(true),
+    points(maxLeafSize + 1) // Add one to make splitting the node simpler.
+{
+  BulkLoad(true);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType,
+         typename DescentType>
+RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+RectangleTree(MatType&& data,
+              const HilbertBulkLoad& /* bulkLoad */,
+              const size_t maxLeafSize,
+              const size_t minLeafSize,
+              const size_t maxNumChildren,
+              const size_t minNumChildren) :
+    maxNumChildren(maxNumChildren),
+    minNumChildren(minNumChildren),
+    numChildren(0),
+    children(maxNumChildren + 1), // Add one to make splitting the node simpler.
+    parent(NULL),
+    begin(0),
+    count(0),
+    maxLeafSize(maxLeafSize),
+    minLeafSize(minLeafSize),
+    bound(data.n_rows),
+    splitHistory(bound.Dim()),
+    parentDistance(0),
+    dataset(new MatType(std::move(data))),
+    ownsDataset(true),
+    points(maxLeafSize + 1) // Add one to make splitting the node simpler.
+{
+  BulkLoad(true);
+}
+
 template<typename MetricType,
          typename StatisticType,
          typename MatType,
@@ -118,9 +239,7 @@ RectangleTree(
     parentDistance(0),
     dataset(&parentNode->Dataset()),
     ownsDataset(false),
-    points(maxLeafSize + 1), // Add one to make splitting the node simpler.
-    localDataset(new MatType(arma::zeros<MatType>(parentNode->Bound().Dim(),
-                                                  maxLeafSize + 1)))
+    points(maxLeafSize + 1) // Add one to make splitting the node simpler.
 {
   stat = StatisticType(*this);
 }
@@ -150,30 +269,40 @@ RectangleTree(
     bound(other.bound),
     splitHistory(other.SplitHistory()),
     parentDistance(other.ParentDistance()),
-    dataset(new MatType(*other.dataset)),
-    ownsDataset(true),
-    points(other.Points()),
-    localDataset(NULL)
+    // Only a deep copy of a root node copies the dataset; every other copy
+    // shares the dataset (a shallow copy is used when the root is split).
+    dataset((deepCopy && other.Parent() == NULL) ?
+        new MatType(*other.dataset) : other.dataset),
+    ownsDataset(deepCopy && other.Parent() == NULL),
+    points(other.Points())
 {
   if (deepCopy)
   {
-    if (numChildren > 0)
+    for (size_t i = 0; i < numChildren; i++)
     {
-      for (size_t i = 0; i < numChildren; i++)
-      {
-        children[i] = new RectangleTree(*(other.Children()[i]));
-      }
+      children[i] = new RectangleTree(*(other.Children()[i]));
+      children[i]->Parent() = this;
     }
-    else
+
+    // The copied children point to the other tree's dataset; point them to
+    // our copy instead.
+    if (ownsDataset)
     {
-      localDataset = new MatType(other.LocalDataset());
+      std::vector<RectangleTree*> stack(children.begin(),
+          children.begin() + numChildren);
+      while (!stack.empty())
+      {
+        RectangleTree* node = stack.back();
+        stack.pop_back();
+        node->dataset = dataset;
+        for (size_t i = 0; i < node->NumChildren(); i++)
+          stack.push_back(node->Children()[i]);
+      }
     }
   }
   else
   {
     children = other.Children();
-    arma::mat& otherData = const_cast<arma::mat&>(other.LocalDataset());
-    localDataset = &otherData;
   }
 }
 
@@ -214,8 +343,6 @@ RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
 
   if (ownsDataset)
     delete dataset;
-
-  delete localDataset;
 }
 
 /**
@@ -239,20 +366,6 @@ void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
   delete this;
 }
 
-/**
- * Set the local dataset to null.
- */
-template<typename MetricType,
-         typename StatisticType,
-         typename MatType,
-         typename SplitType,
-         typename DescentType>
-void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
-    NullifyData()
-{
-  localDataset = NULL;
-}
-
 /**
  * Recurse through the tree and insert the point at the leaf node chosen
  * by the heuristic.
@@ -275,7 +388,6 @@ void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
   // If this is a leaf node, we stop here and add the point.
   if (numChildren == 0)
   {
-    localDataset->col(count) = dataset->col(point);
     points[count++] = point;
     SplitNode(lvls);
     return;
@@ -308,7 +420,6 @@ void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
   // If this is a leaf node, we stop here and add the point.
   if (numChildren == 0)
   {
-    localDataset->col(count) = dataset->col(point);
     points[count++] = point;
     SplitNode(relevels);
     return;
@@ -382,8 +493,7 @@ bool RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
     {
       if (points[i] == point)
       {
-        localDataset->col(i) = localDataset->col(--count); // Decrement count.
-        points[i] = points[count];
+        points[i] = points[--count]; // Decrement count.
         // This function wil ensure that minFill is satisfied.
         CondenseTree(dataset->col(point), lvls, true);
         return true;
@@ -417,8 +527,7 @@ bool RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
     {
       if (points[i] == point)
       {
-        localDataset->col(i) = localDataset->col(--count);
-        points[i] = points[count];
+        points[i] = points[--count]; // Decrement count.
         // This function will ensure that minFill is satisfied.
         CondenseTree(dataset->col(point), relevels, true);
         return true;
@@ -655,6 +764,279 @@ void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
   }
 }
 
+/**
+ * Build the tree with Sort-Tile-Recursive bulk loading.  The points are tiled
+ * into leaves, and then the nodes of each level are tiled (by their centers)
+ * into the nodes of the level above, until the remaining nodes fit in the root.
+ * With Hilbert packing, the points are tiled in the order of their Hilbert
+ * values instead, and each level is cut in the order of the level below.
+ */
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType,
+         typename DescentType>
+void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+    BulkLoad(const bool hilbert)
+{
+  const size_t n = dataset->n_cols;
+
+  // If all the points fit in one leaf, the root is that leaf.
+  if (n <= maxLeafSize)
+  {
+    for (size_t i = 0; i < n; ++i)
+      points[i] = i;
+    count = n;
+    if (n > 0)
+      bound |= *dataset;
+
+    stat = StatisticType(*this);
+    return;
+  }
+
+  std::vector<size_t> order(n);
+  for (size_t i = 0; i < n; ++i)
+    order[i] = i;
+
+  // Pack the points into leaves.
+  std::vector<size_t> groupEnds;
+  if (hilbert)
+    HilbertTile(*dataset, order, maxLeafSize, groupEnds);
+  else
+    Tile(*dataset, order, 0, n, 0, maxLeafSize, groupEnds);
+
+  std::vector<RectangleTree*> nodes(groupEnds.size());
+  size_t groupBegin = 0;
+  for (size_t g = 0; g < groupEnds.size(); ++g)
+  {
+    RectangleTree* leaf = new RectangleTree(this);
+    for (size_t i = groupBegin; i < groupEnds[g]; ++i)
+    {
+      leaf->points[leaf->count++] = order[i];
+      leaf->bound |= dataset->col(order[i]);
+    }
+    leaf->stat = StatisticType(*leaf);
+
+    nodes[g] = leaf;
+    groupBegin = groupEnds[g];
+  }
+
+  // Now pack each level into the level above it.
+  while (nodes.size() > maxNumChildren)
+  {
+    order.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i)
+      order[i] = i;
+
+    // With Hilbert packing, the nodes are already in the order of the curve.
+    groupEnds.clear();
+    if (hilbert)
+    {
+      CutGroups(0, nodes.size(), maxNumChildren, groupEnds);
+    }
+    else
+    {
+      arma::mat centers(dataset->n_rows, nodes.size());
+      for (size_t i = 0; i < nodes.size(); ++i)
+      {
+        arma::vec center;
+        nodes[i]->Center(center);
+        centers.col(i) = center;
+      }
+
+      Tile(centers, order, 0, nodes.size(), 0, maxNumChildren, groupEnds);
+    }
+
+    std::vector<RectangleTree*> parents(groupEnds.size());
+    groupBegin = 0;
+    for (size_t g = 0; g < groupEnds.size(); ++g)
+    {
+      RectangleTree* node = new RectangleTree(this);
+      for (size_t i = groupBegin; i < groupEnds[g]; ++i)
+      {
+        RectangleTree* child = nodes[order[i]];
+        node->children[node->numChildren++] = child;
+        child->parent = node;
+        node->bound |= child->bound;
+      }
+      node->stat = StatisticType(*node);
+
+      parents[g] = node;
+      groupBegin = groupEnds[g];
+    }
+
+    nodes.swap(parents);
+  }
+
+  // The remaining nodes are the children of the root.
+  for (size_t i = 0; i < nodes.size(); ++i)
+  {
+    children[numChildren++] = nodes[i];
+    nodes[i]->parent = this;
+    bound |= nodes[i]->bound;
+  }
+
+  stat = StatisticType(*this);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType,
+         typename DescentType>
+void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+    Tile(const arma::mat& positions,
+         std::vector<size_t>& order,
+         const size_t begin,
+         const size_t end,
+         const size_t dimension,
+         const size_t capacity,
+         std::vector<size_t>& groupEnds)
+{
+  const size_t n = end - begin;
+  const size_t groups = (n + capacity - 1) / capacity;
+
+  std::sort(order.begin() + begin, order.begin() + end,
+      [&positions, dimension](const size_t a, const size_t b)
+      { return positions(dimension, a) < positions(dimension, b); });
+
+  // In the last dimension (or if everything fits in one group), cut the sorted
+  // items into groups whose sizes differ by at most one.
+  if (dimension + 1 == positions.n_rows || groups <= 1)
+  {
+    CutGroups(begin, end, capacity, groupEnds);
+    return;
+  }
+
+  // Otherwise, with d dimensions left, cut the items into ceil(groups^(1 / d))
+  // slabs of equal size and tile each slab along the next dimension.  Because
+  // there are never more slabs than groups, every group ends up at least half
+  // full.
+  const size_t slabs = (size_t) std::ceil(std::pow((double) groups,
+      1.0 / (double) (positions.n_rows - dimension)) - 1e-10);
+  for (size_t s = 0; s < slabs; ++s)
+  {
+    Tile(positions, order, begin + (s * n) / slabs,
+        begin + ((s + 1) * n) / slabs, dimension + 1, capacity, groupEnds);
+  }
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType,
+         typename DescentType>
+void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+    HilbertTile(const arma::mat& positions,
+                std::vector<size_t>& order,
+                const size_t capacity,
+                std::vector<size_t>& groupEnds)
+{
+  // Each Hilbert value is computed once, so the sort only compares integers.
+  std::vector<uint64_t> values;
+  HilbertValues(positions, values);
+
+  std::stable_sort(order.begin(), order.end(),
+      [&values](const size_t a, const size_t b)
+      { return values[a] < values[b]; });
+
+  CutGroups(0, order.size(), capacity, groupEnds);
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType,
+         typename DescentType>
+void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+    HilbertValues(const arma::mat& positions,
+                  std::vector<uint64_t>& values)
+{
+  const size_t dims = std::min((size_t) positions.n_rows, (size_t) 64);
+  const size_t bits = std::min((size_t) 64 / std::max(dims, (size_t) 1),
+      (size_t) 32);
+  const double maxCell = std::ldexp(1.0, (int) bits) - 1.0;
+
+  values.resize(positions.n_cols);
+  if (dims == 0 || positions.n_cols == 0)
+  {
+    std::fill(values.begin(), values.end(), 0);
+    return;
+  }
+
+  const arma::vec minima = arma::min(positions.rows(0, dims - 1), 1);
+  const arma::vec ranges = arma::max(positions.rows(0, dims - 1), 1) - minima;
+
+  std::vector<uint64_t> x(dims);
+  for (size_t p = 0; p < positions.n_cols; ++p)
+  {
+    // Quantize the point to its cell.
+    for (size_t i = 0; i < dims; ++i)
+    {
+      const double scaled = (ranges[i] > 0) ? (positions(i, p) - minima[i]) /
+          ranges[i] * maxCell : 0.0;
+      x[i] = (uint64_t) std::min(std::max(scaled + 0.5, 0.0), maxCell);
+    }
+
+    // Skilling's transform of the cell coordinates into the transposed Hilbert
+    // index: first undo the excess work of the rotations and reflections...
+    const uint64_t top = (uint64_t) 1 << (bits - 1);
+    for (uint64_t q = top; q > 1; q >>= 1)
+    {
+      const uint64_t mask = q - 1;
+      for (size_t i = 0; i < dims; ++i)
+      {
+        if (x[i] & q)
+        {
+          x[0] ^= mask; // Invert.
+        }
+        else
+        {
+          const uint64_t t = (x[0] ^ x[i]) & mask; // Exchange.
+          x[0] ^= t;
+          x[i] ^= t;
+        }
+      }
+    }
+
+    // ...and then Gray encode.
+    for (size_t i = 1; i < dims; ++i)
+      x[i] ^= x[i - 1];
+    uint64_t t = 0;
+    for (uint64_t q = top; q > 1; q >>= 1)
+      if (x[dims - 1] & q)
+        t ^= q - 1;
+    for (size_t i = 0; i < dims; ++i)
+      x[i] ^= t;
+
+    // The index interleaves the bits of the transposed coordinates, most
+    // significant bits first.
+    uint64_t value = 0;
+    for (size_t b = bits; b-- > 0; )
+      for (size_t i = 0; i < dims; ++i)
+        value = (value << 1) | ((x[i] >> b) & 1);
+
+    values[p] = value;
+  }
+}
+
+template<typename MetricType,
+         typename StatisticType,
+         typename MatType,
+         typename SplitType,
+         typename DescentType>
+void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
+    CutGroups(const size_t begin,
+              const size_t end,
+              const size_t capacity,
+              std::vector<size_t>& groupEnds)
+{
+  const size_t n = end - begin;
+  const size_t groups = (n + capacity - 1) / capacity;
+  for (size_t g = 1; g <= groups; ++g)
+    groupEnds.push_back(begin + (g * n) / groups);
+}
+
 //! Default constructor for boost::serialization.
 template<typename MetricType,
          typename StatisticType,
@@ -674,8 +1056,7 @@ RectangleTree() :
     splitHistory(0),
     parentDistance(0.0),
     dataset(NULL),
-    ownsDataset(false),
-    localDataset(NULL)
+    ownsDataset(false)
 {
   // Nothing to do.
 }
@@ -783,12 +1164,9 @@ void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
 
       numChildren = child->NumChildren();
 
+      // In case the tree has a height of two.
       for (size_t i = 0; i < child->Count(); i++)
-      {
-        // In case the tree has a height of two.
         points[i] = child->Points()[i];
-        localDataset->col(i) = child->LocalDataset().col(i);
-      }
 
       count = child->Count();
       maxNumChildren = child->MaxNumChildren(); // Required for the X tree.
@@ -825,8 +1203,8 @@ bool RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
         double min = DBL_MAX;
         for (size_t j = 0; j < count; j++)
         {
-          if (localDataset->col(j)[i] < min)
-            min = localDataset->col(j)[i];
+          if ((*dataset)(i, points[j]) < min)
+            min = (*dataset)(i, points[j]);
         }
 
         if (bound[i].Lo() < min)
@@ -844,8 +1222,8 @@ bool RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
         double max = -1 * DBL_MAX;
         for (size_t j = 0; j < count; j++)
         {
-          if (localDataset->col(j)[i] > max)
-            max = localDataset->col(j)[i];
+          if ((*dataset)(i, points[j]) > max)
+            max = (*dataset)(i, points[j]);
         }
 
         if (bound[i].Hi() > max)
@@ -994,8 +1372,6 @@ void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
     if (ownsDataset && dataset)
       delete dataset;
 
-    if (localDataset)
-      delete localDataset;
   }
 
   ar & CreateNVP(maxNumChildren, "maxNumChildren");
@@ -1031,7 +1407,6 @@ void RectangleTree<MetricType, StatisticType, MatType, SplitType, DescentType>::
     ownsDataset = true;
 
   ar & CreateNVP(points, "points");
-  ar & CreateNVP(localDataset, "localDataset");
 
   // Because 'children' holds mlpack types (that have Serialize()), we can't use
   // the std::vector serialization.
@@ -10,6 +10,7 @@
 #define __MLPACK_CORE_TREE_RECTANGLE_TREE_SINGLE_TREE_TRAVERSER_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
 
 #include "rectangle_tree.hpp"
 
@@ -45,6 +46,14 @@ class RectangleTree<MetricType, StatisticType, MatType, SplitType,
   //! Modify the number of prunes.
   size_t& NumPrunes() { return numPrunes; }
 
+  //! The traversal statistics policy (see TraversalStatisticsPolicy).
+  typedef typename TraversalStatisticsPolicy<RuleType>::Type
+      TraversalStatisticsType;
+
+  //! Get the statistics recorded during traversal (with the default policy,
+  //! nothing is recorded).
+  const TraversalStatisticsType& Statistics() const { return statistics; }
+
  private:
 
   // We use this class and this function to make the sorting and scoring easy
@@ -63,6 +72,9 @@ class RectangleTree<MetricType, StatisticType, MatType, SplitType,
   //! Reference to the rules with which the tree will be traversed.
   RuleType& rule;
 
+  //! The statistics recorded during traversal.
+  TraversalStatisticsType statistics;
+
   //! The number of nodes which have been prenud during traversal.
   size_t numPrunes;
 };
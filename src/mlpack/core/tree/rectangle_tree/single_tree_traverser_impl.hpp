@@ -47,6 +47,8 @@ SingleTreeTraverser<RuleType>::Traverse(
     for (size_t i = 0; i < referenceNode.Count(); i++)
       rule.BaseCase(queryIndex, referenceNode.Points()[i]);
 
+    statistics.BaseCases(referenceNode, referenceNode.Count());
+
     return;
   }
 
@@ -56,7 +58,8 @@ SingleTreeTraverser<RuleType>::Traverse(
   for (size_t i = 0; i < referenceNode.NumChildren(); i++)
   {
     nodesAndScores[i].node = referenceNode.Children()[i];
-    nodesAndScores[i].score = rule.Score(queryIndex, *nodesAndScores[i].node);
+    nodesAndScores[i].score = statistics.Score(rule, queryIndex,
+        *nodesAndScores[i].node);
   }
 
   std::sort(nodesAndScores.begin(), nodesAndScores.end(), NodeComparator);
@@ -65,7 +68,7 @@ SingleTreeTraverser<RuleType>::Traverse(
   // one that isn't good enough.
   for (size_t i = 0; i < referenceNode.NumChildren(); i++)
   {
-    if (rule.Rescore(queryIndex, *nodesAndScores[i].node,
+    if (statistics.Rescore(rule, queryIndex, *nodesAndScores[i].node,
         nodesAndScores[i].score) != DBL_MAX)
     {
       Traverse(queryIndex, *nodesAndScores[i].node);
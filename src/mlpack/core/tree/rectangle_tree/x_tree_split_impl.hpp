@@ -32,7 +32,6 @@ void XTreeSplit::SplitLeafNode(TreeType* tree, std::vector<bool>& relevels)
     TreeType* copy = new TreeType(*tree, false);
     copy->Parent() = tree;
     tree->Count() = 0;
-    tree->NullifyData();
     // Because this was a leaf node, numChildren must be 0.
     tree->Children()[(tree->NumChildren())++] = copy;
     assert(tree->NumChildren() == 1);
@@ -64,7 +63,7 @@ void XTreeSplit::SplitLeafNode(TreeType* tree, std::vector<bool>& relevels)
     for (size_t i = 0; i < sorted.size(); i++)
     {
       sorted[i].d = tree->Bound().Metric().Evaluate(center,
-          tree->LocalDataset().col(i));
+          tree->Dataset().col(tree->Point(i)));
        sorted[i].n = i;
     }
 
@@ -110,7 +109,7 @@ void XTreeSplit::SplitLeafNode(TreeType* tree, std::vector<bool>& relevels)
     // Since we only have points in the leaf nodes, we only need to sort once.
     std::vector<sortStruct> sorted(tree->Count());
     for (size_t i = 0; i < sorted.size(); i++) {
-      sorted[i].d = tree->LocalDataset().col(i)[j];
+      sorted[i].d = tree->Dataset()(j, tree->Point(i));
       sorted[i].n = i;
     }
 
@@ -143,25 +142,25 @@ void XTreeSplit::SplitLeafNode(TreeType* tree, std::vector<bool>& relevels)
       std::vector<double> minG2(maxG1.size());
       for (size_t k = 0; k < tree->Bound().Dim(); k++)
       {
-        minG1[k] = maxG1[k] = tree->LocalDataset().col(sorted[0].n)[k];
-        minG2[k] = maxG2[k] = tree->LocalDataset().col(
-            sorted[sorted.size() - 1].n)[k];
+        minG1[k] = maxG1[k] = tree->Dataset()(k, tree->Point(sorted[0].n));
+        minG2[k] = maxG2[k] = tree->Dataset()(k, tree->Point(
+            sorted[sorted.size() - 1].n));
 
         for (size_t l = 1; l < tree->Count() - 1; l++)
         {
           if (l < cutOff)
           {
-            if (tree->LocalDataset().col(sorted[l].n)[k] < minG1[k])
-              minG1[k] = tree->LocalDataset().col(sorted[l].n)[k];
-            else if (tree->LocalDataset().col(sorted[l].n)[k] > maxG1[k])
-              maxG1[k] = tree->LocalDataset().col(sorted[l].n)[k];
+            if (tree->Dataset()(k, tree->Point(sorted[l].n)) < minG1[k])
+              minG1[k] = tree->Dataset()(k, tree->Point(sorted[l].n));
+            else if (tree->Dataset()(k, tree->Point(sorted[l].n)) > maxG1[k])
+              maxG1[k] = tree->Dataset()(k, tree->Point(sorted[l].n));
           }
           else
           {
-            if (tree->LocalDataset().col(sorted[l].n)[k] < minG2[k])
-              minG2[k] = tree->LocalDataset().col(sorted[l].n)[k];
-            else if (tree->LocalDataset().col(sorted[l].n)[k] > maxG2[k])
-              maxG2[k] = tree->LocalDataset().col(sorted[l].n)[k];
+            if (tree->Dataset()(k, tree->Point(sorted[l].n)) < minG2[k])
+              minG2[k] = tree->Dataset()(k, tree->Point(sorted[l].n));
+            else if (tree->Dataset()(k, tree->Point(sorted[l].n)) > maxG2[k])
+              maxG2[k] = tree->Dataset()(k, tree->Point(sorted[l].n));
           }
         }
       }
@@ -209,7 +208,7 @@ void XTreeSplit::SplitLeafNode(TreeType* tree, std::vector<bool>& relevels)
   std::vector<sortStruct> sorted(tree->Count());
   for (size_t i = 0; i < sorted.size(); i++)
   {
-    sorted[i].d = tree->LocalDataset().col(i)[bestAxis];
+    sorted[i].d = tree->Dataset()(bestAxis, tree->Point(i));
     sorted[i].n = i;
   }
 
@@ -301,7 +300,6 @@ bool XTreeSplit::SplitNonLeafNode(TreeType* tree, std::vector<bool>& relevels)
 
     copy->Parent() = tree;
     tree->NumChildren() = 0;
-    tree->NullifyData();
     tree->Children()[(tree->NumChildren())++] = copy;
     XTreeSplit::SplitNonLeafNode(copy, relevels);
     return true;
@@ -741,7 +739,6 @@ bool XTreeSplit::SplitNonLeafNode(TreeType* tree, std::vector<bool>& relevels)
 
         delete treeOne;
         delete treeTwo;
-        tree->NullifyData();
         tree->SoftDelete();
         return false;
       }
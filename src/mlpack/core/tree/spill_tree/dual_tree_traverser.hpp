@@ -0,0 +1,76 @@
+/**
+ * @file dual_tree_traverser.hpp
+ * @author Ryan Curtin
+ *
+ * A nested class of SpillTree which runs the defeatist single-tree traversal
+ * for each point of a query tree.
+ */
+#ifndef __MLPACK_CORE_TREE_SPILL_TREE_DUAL_TREE_TRAVERSER_HPP
+#define __MLPACK_CORE_TREE_SPILL_TREE_DUAL_TREE_TRAVERSER_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
+#include "spill_tree.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The dual-tree traverser for spill trees.  Pruning a whole query node at an
+ * overlapping reference node would mean sending every query point in it to the
+ * same child, which defeats the purpose of the hyperplanes; so this traverser
+ * instead runs the defeatist SingleTreeTraverser for each distinct point held
+ * by the query node.  It is provided so that spill trees can be used wherever
+ * a dual-tree traversal is expected, and it gives the same results as
+ * single-tree search.
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+template<typename RuleType>
+class SpillTree<MetricType, StatisticType, MatType>::DualTreeTraverser
+{
+ public:
+  /**
+   * Instantiate the dual-tree traverser with the given rule set.
+   */
+  DualTreeTraverser(RuleType& rule);
+
+  /**
+   * Traverse the reference tree for each point held by the query node.
+   *
+   * @param queryNode The query node to be traversed.
+   * @param referenceNode The reference node to be traversed.
+   */
+  void Traverse(SpillTree& queryNode, SpillTree& referenceNode);
+
+  //! Get the number of prunes.
+  size_t NumPrunes() const { return numPrunes; }
+  //! Modify the number of prunes.
+  size_t& NumPrunes() { return numPrunes; }
+
+  //! The traversal statistics policy (see TraversalStatisticsPolicy).
+  typedef typename TraversalStatisticsPolicy<RuleType>::Type
+      TraversalStatisticsType;
+
+  //! Get the statistics recorded during traversal (with the default policy,
+  //! nothing is recorded).
+  const TraversalStatisticsType& Statistics() const { return statistics; }
+
+ private:
+  //! Reference to the rules with which the trees will be traversed.
+  RuleType& rule;
+
+  //! The statistics recorded during traversal.
+  TraversalStatisticsType statistics;
+
+  //! The number of nodes which have been pruned during traversal.
+  size_t numPrunes;
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "dual_tree_traverser_impl.hpp"
+
+#endif
@@ -0,0 +1,64 @@
+/**
+ * @file dual_tree_traverser_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the dual-tree traverser for spill trees.
+ */
+#ifndef __MLPACK_CORE_TREE_SPILL_TREE_DUAL_TREE_TRAVERSER_IMPL_HPP
+#define __MLPACK_CORE_TREE_SPILL_TREE_DUAL_TREE_TRAVERSER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "dual_tree_traverser.hpp"
+
+#include <algorithm>
+#include <stack>
+
+namespace mlpack {
+namespace tree {
+
+template<typename MetricType, typename StatisticType, typename MatType>
+template<typename RuleType>
+SpillTree<MetricType, StatisticType, MatType>::
+DualTreeTraverser<RuleType>::DualTreeTraverser(RuleType& rule) :
+    rule(rule),
+    numPrunes(0)
+{ /* Nothing to do. */ }
+
+template<typename MetricType, typename StatisticType, typename MatType>
+template<typename RuleType>
+void SpillTree<MetricType, StatisticType, MatType>::
+DualTreeTraverser<RuleType>::Traverse(
+    SpillTree<MetricType, StatisticType, MatType>& queryNode,
+    SpillTree<MetricType, StatisticType, MatType>& referenceNode)
+{
+  // Collect the points held by the leaves of the query node.  A point may be
+  // held by more than one leaf, but it should only be searched for once.
+  std::vector<size_t> queries;
+  queries.reserve(queryNode.NumDescendants());
+  std::stack<SpillTree*> nodes;
+  nodes.push(&queryNode);
+  while (!nodes.empty())
+  {
+    SpillTree* node = nodes.top();
+    nodes.pop();
+
+    for (size_t i = 0; i < node->NumPoints(); ++i)
+      queries.push_back(node->Point(i));
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+      nodes.push(&node->Child(i));
+  }
+
+  std::sort(queries.begin(), queries.end());
+  queries.erase(std::unique(queries.begin(), queries.end()), queries.end());
+
+  SingleTreeTraverser<RuleType> traverser(rule);
+  for (size_t i = 0; i < queries.size(); ++i)
+    traverser.Traverse(queries[i], referenceNode);
+
+  numPrunes += traverser.NumPrunes();
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
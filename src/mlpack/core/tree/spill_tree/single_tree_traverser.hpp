@@ -0,0 +1,86 @@
+/**
+ * @file single_tree_traverser.hpp
+ * @author Ryan Curtin
+ *
+ * A nested class of SpillTree which traverses the tree with a given set of
+ * rules.  At overlapping nodes, the traversal is defeatist: it descends only
+ * into the child chosen by the rules.  Other nodes are traversed depth-first,
+ * with the rules indicating the branches which can be pruned and the order in
+ * which to recurse.
+ */
+#ifndef __MLPACK_CORE_TREE_SPILL_TREE_SINGLE_TREE_TRAVERSER_HPP
+#define __MLPACK_CORE_TREE_SPILL_TREE_SINGLE_TREE_TRAVERSER_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+
+#include "spill_tree.hpp"
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The defeatist single-tree traverser for spill trees.  At a node whose
+ * children overlap, the rules are asked for the child which is most likely to
+ * hold the best results (with RuleType::GetBestChild()), and only that child is
+ * visited; so, below such nodes, exactly one leaf is visited.  The children of
+ * other nodes are scored, visited in order, and pruned, just as with the
+ * BinarySpaceTree traverser.  The rules must provide the following function, in
+ * addition to the usual BaseCase(), Score(), and Rescore():
+ *
+ * @code
+ * // Return the index of the child of the given node which should be visited.
+ * size_t GetBestChild(const size_t queryIndex, TreeType& referenceNode);
+ * @endcode
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+template<typename RuleType>
+class SpillTree<MetricType, StatisticType, MatType>::SingleTreeTraverser
+{
+ public:
+  /**
+   * Instantiate the single tree traverser with the given rule set.
+   */
+  SingleTreeTraverser(RuleType& rule);
+
+  /**
+   * Traverse the tree with the given point.
+   *
+   * @param queryIndex The index of the point in the query set which is being
+   *     used as the query point.
+   * @param referenceNode The tree node to be traversed.
+   */
+  void Traverse(const size_t queryIndex, SpillTree& referenceNode);
+
+  //! Get the number of prunes (children of overlapping nodes which were not
+  //! visited are counted too).
+  size_t NumPrunes() const { return numPrunes; }
+  //! Modify the number of prunes.
+  size_t& NumPrunes() { return numPrunes; }
+
+  //! The traversal statistics policy (see TraversalStatisticsPolicy).
+  typedef typename TraversalStatisticsPolicy<RuleType>::Type
+      TraversalStatisticsType;
+
+  //! Get the statistics recorded during traversal (with the default policy,
+  //! nothing is recorded).
+  const TraversalStatisticsType& Statistics() const { return statistics; }
+
+ private:
+  //! Reference to the rules with which the tree will be traversed.
+  RuleType& rule;
+
+  //! The statistics recorded during traversal.
+  TraversalStatisticsType statistics;
+
+  //! The number of nodes which have been pruned during traversal.
+  size_t numPrunes;
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "single_tree_traverser_impl.hpp"
+
+#endif
@@ -0,0 +1,110 @@
+/**
+ * @file single_tree_traverser_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the defeatist single-tree traverser for spill trees.
+ */
+#ifndef __MLPACK_CORE_TREE_SPILL_TREE_SINGLE_TREE_TRAVERSER_IMPL_HPP
+#define __MLPACK_CORE_TREE_SPILL_TREE_SINGLE_TREE_TRAVERSER_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "single_tree_traverser.hpp"
+
+namespace mlpack {
+namespace tree {
+
+template<typename MetricType, typename StatisticType, typename MatType>
+template<typename RuleType>
+SpillTree<MetricType, StatisticType, MatType>::
+SingleTreeTraverser<RuleType>::SingleTreeTraverser(RuleType& rule) :
+    rule(rule),
+    numPrunes(0)
+{ /* Nothing to do. */ }
+
+template<typename MetricType, typename StatisticType, typename MatType>
+template<typename RuleType>
+void SpillTree<MetricType, StatisticType, MatType>::
+SingleTreeTraverser<RuleType>::Traverse(
+    const size_t queryIndex,
+    SpillTree<MetricType, StatisticType, MatType>& referenceNode)
+{
+  // If we are a leaf, run the base case as necessary.
+  if (referenceNode.IsLeaf())
+  {
+    for (size_t i = 0; i < referenceNode.NumPoints(); ++i)
+      rule.BaseCase(queryIndex, referenceNode.Point(i));
+
+    statistics.BaseCases(referenceNode, referenceNode.NumPoints());
+  }
+  else if (referenceNode.Overlap())
+  {
+    // The children hold some of the same points, so visiting both would find
+    // them twice.  Defeatist search only visits the best child.
+    const size_t bestChild = rule.GetBestChild(queryIndex, referenceNode);
+    Traverse(queryIndex, referenceNode.Child(bestChild));
+    ++numPrunes;
+  }
+  else
+  {
+    // If either score is DBL_MAX, we do not recurse into that node.
+    double leftScore = statistics.Score(rule, queryIndex,
+        *referenceNode.Left());
+    double rightScore = statistics.Score(rule, queryIndex,
+        *referenceNode.Right());
+
+    if (leftScore < rightScore)
+    {
+      // Recurse to the left.
+      Traverse(queryIndex, *referenceNode.Left());
+
+      // Is it still valid to recurse to the right?
+      rightScore = statistics.Rescore(rule, queryIndex, *referenceNode.Right(),
+          rightScore);
+
+      if (rightScore != DBL_MAX)
+        Traverse(queryIndex, *referenceNode.Right()); // Recurse to the right.
+      else
+        ++numPrunes;
+    }
+    else if (rightScore < leftScore)
+    {
+      // Recurse to the right.
+      Traverse(queryIndex, *referenceNode.Right());
+
+      // Is it still valid to recurse to the left?
+      leftScore = statistics.Rescore(rule, queryIndex, *referenceNode.Left(),
+          leftScore);
+
+      if (leftScore != DBL_MAX)
+        Traverse(queryIndex, *referenceNode.Left()); // Recurse to the left.
+      else
+        ++numPrunes;
+    }
+    else // leftScore is equal to rightScore.
+    {
+      if (leftScore == DBL_MAX)
+      {
+        numPrunes += 2; // Pruned both left and right.
+      }
+      else
+      {
+        // Choose the left first.
+        Traverse(queryIndex, *referenceNode.Left());
+
+        // Is it still valid to recurse to the right?
+        rightScore = statistics.Rescore(rule, queryIndex,
+            *referenceNode.Right(), rightScore);
+
+        if (rightScore != DBL_MAX)
+          Traverse(queryIndex, *referenceNode.Right());
+        else
+          ++numPrunes;
+      }
+    }
+  }
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,427 @@
+/**
+ * @file spill_tree.hpp
+ * @author Ryan Curtin
+ *
+ * Definition of the SpillTree class, a random projection tree whose children
+ * may share the points near the splitting hyperplane.
+ */
+#ifndef __MLPACK_CORE_TREE_SPILL_TREE_SPILL_TREE_HPP
+#define __MLPACK_CORE_TREE_SPILL_TREE_SPILL_TREE_HPP
+
+#include <mlpack/core.hpp>
+
+#include "../bounds.hpp"
+#include "../statistic.hpp"
+
+namespace mlpack {
+namespace tree /** Trees and tree-building procedures. */ {
+
+/**
+ * A hybrid spill tree is a binary tree for approximate nearest neighbor search.
+ * Each node is split by a hyperplane orthogonal to a random direction, through
+ * the median of the projections of the points of the node onto that direction
+ * (as in a random projection tree).  The points whose projections lie within
+ * tau of the split value are put in both children ("spilled"), so the children
+ * of a node may overlap.  If spilling would give a child more than rho times
+ * the points of the node, the node is split without overlap instead.
+ *
+ * The point of the overlap is that defeatist search becomes reasonable: at a
+ * node whose children overlap, the single-tree traverser of this class only
+ * descends into the child on the side of the hyperplane that the query point is
+ * on (see the GetNearestChild() function), and it visits exactly one leaf below
+ * such a node.  A query point that is within tau of the hyperplane finds the
+ * reference points on the other side that are within tau of the hyperplane
+ * anyway.  Nodes without overlap are searched with the usual bound-based
+ * pruning, so with rho close to 0 (no node overlaps) search is exact.  With tau
+ * equal to 0, the default, the tree is a plain random projection tree, and a
+ * search visits only a single leaf.
+ *
+ * The tree does not rearrange the dataset; each leaf holds a list of the
+ * indices of its points.  A point may be held by more than one leaf; therefore,
+ * this tree is only meant to be used with the traversers it provides.  Each
+ * leaf holds at least half of the maximum leaf size (rounded up), unless the
+ * points of a node can not be split (or the whole dataset is smaller than
+ * that), so defeatist search finds k neighbors if k is no greater than that.
+ *
+ * For more information, see the following paper.
+ *
+ * @code
+ * @inproceedings{liu2004investigation,
+ *   title={An investigation of practical approximate nearest neighbor
+ *       algorithms},
+ *   author={Liu, T. and Moore, A.W. and Gray, A.G. and Yang, K.},
+ *   booktitle={Advances in Neural Information Processing Systems 17 (NIPS
+ *       2004)},
+ *   pages={825--832},
+ *   year={2004}
+ * }
+ * @endcode
+ *
+ * @tparam MetricType The metric used for tree-building.  The HRectBound of each
+ *     node requires that an LMetric<> is used (so, EuclideanDistance,
+ *     ManhattanDistance, etc.).
+ * @tparam StatisticType Extra data contained in the node.  See statistic.hpp
+ *     for the necessary skeleton interface.
+ * @tparam MatType The dataset class.
+ */
+template<typename MetricType,
+         typename StatisticType = EmptyStatistic,
+         typename MatType = arma::mat>
+class SpillTree
+{
+ private:
+  //! The left child node.
+  SpillTree* left;
+  //! The right child node.
+  SpillTree* right;
+  //! The parent node (NULL if this is the root of the tree).
+  SpillTree* parent;
+  //! The number of points held by the leaves below this node (points that are
+  //! held by more than one leaf are counted more than once).
+  size_t count;
+  //! The indices of the points held by this node, if it is a leaf.
+  arma::Col<size_t> pointIndices;
+  //! Whether or not this is an overlapping node, whose children may hold the
+  //! same points (with tau = 0, they only do so if projections are tied).
+  //! Defeatist search descends into only one child of such a node.
+  bool overlap;
+  //! The direction that the points of this node were projected onto.
+  arma::vec projectionVector;
+  //! The value of the projection at which the node was split.
+  double splitValue;
+  //! The bound object for this node.
+  bound::HRectBound<MetricType> bound;
+  //! Any extra data contained in the node.
+  StatisticType stat;
+  //! The distance from the centroid of this node to the centroid of the parent.
+  double parentDistance;
+  //! The worst possible distance to the furthest descendant, cached to speed
+  //! things up.
+  double furthestDescendantDistance;
+  //! The dataset.  If we are the root of the tree, we own the dataset and must
+  //! delete it.
+  const MatType* dataset;
+
+ public:
+  //! So other classes can use TreeType::Mat.
+  typedef MatType Mat;
+
+  //! A defeatist single-tree traverser for spill trees; see
+  //! single_tree_traverser.hpp for implementation.
+  template<typename RuleType>
+  class SingleTreeTraverser;
+
+  //! A dual-tree traverser for spill trees; see dual_tree_traverser.hpp.
+  template<typename RuleType>
+  class DualTreeTraverser;
+
+  /**
+   * Construct this as the root node of a spill tree using the given dataset.
+   * This will copy the input matrix; if you don't want this, consider using
+   * the constructor that takes an rvalue reference and use std::move().
+   *
+   * @param data Dataset to create tree from.  This will be copied!
+   * @param maxLeafSize Size of each leaf in the tree.
+   * @param tau Width of the overlap buffer on each side of the hyperplane.
+   * @param rho Largest fraction of the points of a node that a child of an
+   *     overlapping node may hold; this must be between 0 and 1.
+   */
+  SpillTree(const MatType& data,
+            const size_t maxLeafSize = 20,
+            const double tau = 0.0,
+            const double rho = 0.7);
+
+  /**
+   * Construct this as the root node of a spill tree using the given dataset.
+   * This will take ownership of the data matrix.
+   *
+   * @param data Dataset to create tree from.
+   * @param maxLeafSize Size of each leaf in the tree.
+   * @param tau Width of the overlap buffer on each side of the hyperplane.
+   * @param rho Largest fraction of the points of a node that a child of an
+   *     overlapping node may hold; this must be between 0 and 1.
+   */
+  SpillTree(MatType&& data,
+            const size_t maxLeafSize = 20,
+            const double tau = 0.0,
+            const double rho = 0.7);
+
+  /**
+   * Construct this node as a child of the given parent, holding the given
+   * points.  Do not use this directly; it is used by the constructors above.
+   *
+   * @param parent Parent of this node.
+   * @param points Indices of the points held by this node.
+   * @param maxLeafSize Size of each leaf in the tree.
+   * @param tau Width of the overlap buffer on each side of the hyperplane.
+   * @param rho Largest fraction of the points of a node that a child of an
+   *     overlapping node may hold.
+   */
+  SpillTree(SpillTree* parent,
+            const arma::Col<size_t>& points,
+            const size_t maxLeafSize,
+            const double tau,
+            const double rho);
+
+  /**
+   * Create a spill tree by copying the other tree.  Be careful!  This can take
+   * a long time and use a lot of memory.
+   *
+   * @param other Tree to be copied.
+   */
+  SpillTree(const SpillTree& other);
+
+  /**
+   * Initialize the tree from a boost::serialization archive.
+   *
+   * @param ar Archive to load tree from.  Must be an iarchive, not an oarchive.
+   */
+  template<typename Archive>
+  SpillTree(
+      Archive& ar,
+      const typename boost::enable_if<typename Archive::is_loading>::type* = 0);
+
+  /**
+   * Deletes this node, deallocating the memory for the children and calling
+   * their destructors in turn.  This will invalidate any pointers or references
+   * to any nodes which are children of this one.
+   */
+  ~SpillTree();
+
+  //! Return the bound object for this node.
+  const bound::HRectBound<MetricType>& Bound() const { return bound; }
+  //! Return the bound object for this node.
+  bound::HRectBound<MetricType>& Bound() { return bound; }
+
+  //! Return the statistic object for this node.
+  const StatisticType& Stat() const { return stat; }
+  //! Return the statistic object for this node.
+  StatisticType& Stat() { return stat; }
+
+  //! Return whether or not this node is a leaf (true if it has no children).
+  bool IsLeaf() const { return !left; }
+
+  //! Gets the left child of this node.
+  SpillTree* Left() const { return left; }
+  //! Modify the left child of this node.
+  SpillTree*& Left() { return left; }
+
+  //! Gets the right child of this node.
+  SpillTree* Right() const { return right; }
+  //! Modify the right child of this node.
+  SpillTree*& Right() { return right; }
+
+  //! Gets the parent of this node.
+  SpillTree* Parent() const { return parent; }
+  //! Modify the parent of this node.
+  SpillTree*& Parent() { return parent; }
+
+  //! Get the dataset which the tree is built on.
+  const MatType& Dataset() const { return *dataset; }
+
+  //! Get the metric that the tree uses.
+  MetricType Metric() const { return MetricType(); }
+
+  //! Return whether or not this is an overlapping node, whose children may
+  //! hold the same points.  Defeatist search descends into only one child of
+  //! such a node.
+  bool Overlap() const { return overlap; }
+
+  //! Get the direction that the points of this node were projected onto.
+  const arma::vec& ProjectionVector() const { return projectionVector; }
+  //! Get the value of the projection at which the node was split.
+  double SplitValue() const { return splitValue; }
+
+  //! Return the number of children in this node.
+  size_t NumChildren() const { return left ? 2 : 0; }
+
+  /**
+   * Return the index of the child on the same side of the hyperplane of this
+   * node as the given point (0 for the left child, 1 for the right child).
+   * This node must not be a leaf.
+   *
+   * @param point Point to find the nearest child of.
+   */
+  template<typename VecType>
+  size_t GetNearestChild(
+      const VecType& point,
+      typename boost::enable_if<IsVector<VecType> >::type* = 0) const;
+
+  /**
+   * Return the index of the child on the other side of the hyperplane of this
+   * node from the given point (0 for the left child, 1 for the right child).
+   * This node must not be a leaf.
+   *
+   * @param point Point to find the furthest child of.
+   */
+  template<typename VecType>
+  size_t GetFurthestChild(
+      const VecType& point,
+      typename boost::enable_if<IsVector<VecType> >::type* = 0) const;
+
+  /**
+   * Return the furthest distance to a point held in this node.  If this is not
+   * a leaf node, then the distance is 0 because the node holds no points.
+   */
+  double FurthestPointDistance() const;
+
+  /**
+   * Return the furthest possible descendant distance.  This returns the
+   * maximum distance from the center to the edge of the bound, which may be
+   * more than the actual furthest descendant distance, but never less.
+   */
+  double FurthestDescendantDistance() const
+  { return furthestDescendantDistance; }
+
+  //! Return the minimum distance from the center of the node to any bound edge.
+  double MinimumBoundDistance() const { return bound.MinWidth() / 2.0; }
+
+  //! Return the distance from the center of this node to the center of the
+  //! parent node.
+  double ParentDistance() const { return parentDistance; }
+  //! Modify the distance from the center of this node to the center of the
+  //! parent node.
+  double& ParentDistance() { return parentDistance; }
+
+  /**
+   * Return the specified child (0 will be left, 1 will be right).  If the index
+   * is greater than 1, this will return the right child.
+   *
+   * @param child Index of child to return.
+   */
+  SpillTree& Child(const size_t child) const
+  { return (child == 0) ? *left : *right; }
+
+  //! Return the number of points in this node (0 if not a leaf).
+  size_t NumPoints() const { return pointIndices.n_elem; }
+
+  /**
+   * Return the number of descendants of this node.  Points that are held by
+   * more than one leaf below this node are counted once for each leaf.
+   */
+  size_t NumDescendants() const { return count; }
+
+  /**
+   * Return the index (with reference to the dataset) of a particular
+   * descendant of this node.  The index should be greater than zero but less
+   * than the number of descendants.
+   *
+   * @param index Index of the descendant.
+   */
+  size_t Descendant(const size_t index) const;
+
+  /**
+   * Return the index (with reference to the dataset) of a particular point in
+   * this node.  This will happily return invalid indices if the given index is
+   * greater than the number of points in this node (obtained with NumPoints())
+   * -- be careful.
+   *
+   * @param index Index of point for which a dataset index is wanted.
+   */
+  size_t Point(const size_t index) const { return pointIndices[index]; }
+
+  //! Return the minimum distance to another node.
+  double MinDistance(const SpillTree* other) const
+  {
+    return bound.MinDistance(other->Bound());
+  }
+
+  //! Return the maximum distance to another node.
+  double MaxDistance(const SpillTree* other) const
+  {
+    return bound.MaxDistance(other->Bound());
+  }
+
+  //! Return the minimum and maximum distance to another node.
+  math::Range RangeDistance(const SpillTree* other) const
+  {
+    return bound.RangeDistance(other->Bound());
+  }
+
+  //! Return the minimum distance to another point.
+  template<typename VecType>
+  double MinDistance(const VecType& point,
+                     typename boost::enable_if<IsVector<VecType> >::type* = 0)
+      const
+  {
+    return bound.MinDistance(point);
+  }
+
+  //! Return the maximum distance to another point.
+  template<typename VecType>
+  double MaxDistance(const VecType& point,
+                     typename boost::enable_if<IsVector<VecType> >::type* = 0)
+      const
+  {
+    return bound.MaxDistance(point);
+  }
+
+  //! Return the minimum and maximum distance to another point.
+  template<typename VecType>
+  math::Range
+  RangeDistance(const VecType& point,
+                typename boost::enable_if<IsVector<VecType> >::type* = 0) const
+  {
+    return bound.RangeDistance(point);
+  }
+
+  //! Returns false: this tree type does not have self children.
+  static bool HasSelfChildren() { return false; }
+
+  //! Store the center of the bounding region in the given vector.
+  void Center(arma::vec& center) { bound.Center(center); }
+
+ private:
+  /**
+   * Split the node holding the given points, if it holds more than the maximum
+   * leaf size and the points can be separated.
+   *
+   * @param points Indices of the points held by this node.
+   * @param maxLeafSize Size of each leaf in the tree.
+   * @param tau Width of the overlap buffer on each side of the hyperplane.
+   * @param rho Largest fraction of the points of a node that a child of an
+   *     overlapping node may hold.
+   */
+  void SplitNode(const arma::Col<size_t>& points,
+                 const size_t maxLeafSize,
+                 const double tau,
+                 const double rho);
+
+  //! Throw a std::invalid_argument if tau or rho is invalid.
+  static void CheckParameters(const double tau, const double rho);
+
+ protected:
+  /**
+   * A default constructor.  This is meant to only be used with
+   * boost::serialization, which is allowed with the friend declaration below.
+   * This does not return a valid tree!  The method must be protected, so that
+   * the serialization shim can work with the default constructor.
+   */
+  SpillTree();
+
+  //! Friend access is given for the default constructor.
+  friend class boost::serialization::access;
+
+ public:
+  /**
+   * Serialize the tree.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int version);
+
+  /**
+   * Returns a string representation of this object.
+   */
+  std::string ToString() const;
+};
+
+} // namespace tree
+} // namespace mlpack
+
+// Include implementation.
+#include "spill_tree_impl.hpp"
+
+// Include everything else, if necessary.
+#include "../spill_tree.hpp"
+
+#endif
@@ -0,0 +1,501 @@
+/**
+ * @file spill_tree_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the SpillTree class.
+ */
+#ifndef __MLPACK_CORE_TREE_SPILL_TREE_SPILL_TREE_IMPL_HPP
+#define __MLPACK_CORE_TREE_SPILL_TREE_SPILL_TREE_IMPL_HPP
+
+// In case it wasn't included already for some reason.
+#include "spill_tree.hpp"
+
+#include <mlpack/core/util/log.hpp>
+#include <mlpack/core/util/string_util.hpp>
+#include <queue>
+
+namespace mlpack {
+namespace tree {
+
+template<typename MetricType, typename StatisticType, typename MatType>
+SpillTree<MetricType, StatisticType, MatType>::SpillTree(
+    const MatType& data,
+    const size_t maxLeafSize,
+    const double tau,
+    const double rho) :
+    left(NULL),
+    right(NULL),
+    parent(NULL),
+    count(0),
+    overlap(false),
+    splitValue(0.0),
+    bound(data.n_rows),
+    parentDistance(0), // Parent distance for the root is 0: it has no parent.
+    furthestDescendantDistance(0),
+    dataset(NULL)
+{
+  // Check the parameters before anything is allocated.
+  CheckParameters(tau, rho);
+  dataset = new MatType(data); // Copies the dataset.
+
+  // The root holds every point.
+  arma::Col<size_t> points(dataset->n_cols);
+  for (size_t i = 0; i < dataset->n_cols; ++i)
+    points[i] = i;
+
+  SplitNode(points, maxLeafSize, tau, rho);
+
+  // Create the statistic depending on if we are a leaf or not.
+  stat = StatisticType(*this);
+}
+
+template<typename MetricType, typename StatisticType, typename MatType>
+SpillTree<MetricType, StatisticType, MatType>::SpillTree(
+    MatType&& data,
+    const size_t maxLeafSize,
+    const double tau,
+    const double rho) :
+    left(NULL),
+    right(NULL),
+    parent(NULL),
+    count(0),
+    overlap(false),
+    splitValue(0.0),
+    bound(data.n_rows),
+    parentDistance(0), // Parent distance for the root is 0: it has no parent.
+    furthestDescendantDistance(0),
+    dataset(NULL)
+{
+  // Check the parameters before anything is allocated.
+  CheckParameters(tau, rho);
+  dataset = new MatType(std::move(data));
+
+  // The root holds every point.
+  arma::Col<size_t> points(dataset->n_cols);
+  for (size_t i = 0; i < dataset->n_cols; ++i)
+    points[i] = i;
+
+  SplitNode(points, maxLeafSize, tau, rho);
+
+  // Create the statistic depending on if we are a leaf or not.
+  stat = StatisticType(*this);
+}
+
+template<typename MetricType, typename StatisticType, typename MatType>
+SpillTree<MetricType, StatisticType, MatType>::SpillTree(
+    SpillTree* parent,
+    const arma::Col<size_t>& points,
+    const size_t maxLeafSize,
+    const double tau,
+    const double rho) :
+    left(NULL),
+    right(NULL),
+    parent(parent),
+    count(0),
+    overlap(false),
+    splitValue(0.0),
+    bound(parent->Dataset().n_rows),
+    parentDistance(0),
+    furthestDescendantDistance(0),
+    dataset(&parent->Dataset())
+{
+  // Perform the actual splitting.
+  SplitNode(points, maxLeafSize, tau, rho);
+
+  // Create the statistic depending on if we are a leaf or not.
+  stat = StatisticType(*this);
+}
+
+/**
+ * Create a spill tree by copying the other tree.  Be careful!  This can take a
+ * long time and use a lot of memory.
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+SpillTree<MetricType, StatisticType, MatType>::SpillTree(
+    const SpillTree& other) :
+    left(NULL),
+    right(NULL),
+    parent(other.parent),
+    count(other.count),
+    pointIndices(other.pointIndices),
+    overlap(other.overlap),
+    projectionVector(other.projectionVector),
+    splitValue(other.splitValue),
+    bound(other.bound),
+    stat(other.stat),
+    parentDistance(other.parentDistance),
+    furthestDescendantDistance(other.furthestDescendantDistance),
+    // Copy matrix, but only if we are the root.
+    dataset((other.parent == NULL) ? new MatType(*other.dataset) : NULL)
+{
+  // Create left and right children (if any).
+  if (other.Left())
+  {
+    left = new SpillTree(*other.Left());
+    left->Parent() = this; // Set parent to this, not other tree.
+  }
+
+  if (other.Right())
+  {
+    right = new SpillTree(*other.Right());
+    right->Parent() = this; // Set parent to this, not other tree.
+  }
+
+  // Propagate matrix, but only if we are the root.
+  if (parent == NULL)
+  {
+    std::queue<SpillTree*> queue;
+    if (left)
+      queue.push(left);
+    if (right)
+      queue.push(right);
+    while (!queue.empty())
+    {
+      SpillTree* node = queue.front();
+      queue.pop();
+
+      node->dataset = dataset;
+      if (node->left)
+        queue.push(node->left);
+      if (node->right)
+        queue.push(node->right);
+    }
+  }
+}
+
+/**
+ * Initialize the tree from an archive.
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+template<typename Archive>
+SpillTree<MetricType, StatisticType, MatType>::SpillTree(
+    Archive& ar,
+    const typename boost::enable_if<typename Archive::is_loading>::type*) :
+    SpillTree() // Create an empty SpillTree.
+{
+  // We've delegated to the constructor which gives us an empty tree, and now we
+  // can serialize from it.
+  ar >> data::CreateNVP(*this, "tree");
+}
+
+/**
+ * Deletes this node, deallocating the memory for the children and calling their
+ * destructors in turn.  This will invalidate any pointers or references to any
+ * nodes which are children of this one.
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+SpillTree<MetricType, StatisticType, MatType>::~SpillTree()
+{
+  if (left)
+    delete left;
+  if (right)
+    delete right;
+
+  // If we're the root, delete the matrix.
+  if (!parent)
+    delete dataset;
+}
+
+/**
+ * Return the index of the child on the same side of the hyperplane as the
+ * point.
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+template<typename VecType>
+size_t SpillTree<MetricType, StatisticType, MatType>::GetNearestChild(
+    const VecType& point,
+    typename boost::enable_if<IsVector<VecType> >::type*) const
+{
+  return (arma::dot(projectionVector, point) <= splitValue) ? 0 : 1;
+}
+
+/**
+ * Return the index of the child on the other side of the hyperplane from the
+ * point.
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+template<typename VecType>
+size_t SpillTree<MetricType, StatisticType, MatType>::GetFurthestChild(
+    const VecType& point,
+    typename boost::enable_if<IsVector<VecType> >::type*) const
+{
+  return (arma::dot(projectionVector, point) <= splitValue) ? 1 : 0;
+}
+
+/**
+ * Return a bound on the furthest point in the node from the center.  This
+ * returns 0 unless the node is a leaf.
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+double SpillTree<MetricType, StatisticType, MatType>::FurthestPointDistance()
+    const
+{
+  if (!IsLeaf())
+    return 0.0;
+
+  // Otherwise return the distance from the center to a corner of the bound.
+  return 0.5 * bound.Diameter();
+}
+
+/**
+ * Return the index of a particular descendant contained in this node.  The
+ * descendants of the left child come first.
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+size_t SpillTree<MetricType, StatisticType, MatType>::Descendant(
+    const size_t index) const
+{
+  if (IsLeaf())
+    return pointIndices[index];
+  else if (index < left->NumDescendants())
+    return left->Descendant(index);
+  else
+    return right->Descendant(index - left->NumDescendants());
+}
+
+template<typename MetricType, typename StatisticType, typename MatType>
+void SpillTree<MetricType, StatisticType, MatType>::SplitNode(
+    const arma::Col<size_t>& points,
+    const size_t maxLeafSize,
+    const double tau,
+    const double rho)
+{
+  // We need to expand the bounds of this node properly.
+  if (points.n_elem > 0)
+    bound |= dataset->cols(arma::conv_to<arma::uvec>::from(points));
+
+  // Calculate the furthest descendant distance.
+  furthestDescendantDistance = 0.5 * bound.Diameter();
+
+  // Now, check if we need to split at all.  (A single point can't be split,
+  // even if the maximum leaf size is 0.)
+  count = points.n_elem;
+  if (count <= std::max(maxLeafSize, (size_t) 1))
+  {
+    pointIndices = points;
+    return;
+  }
+
+  // Project the points onto a random direction.
+  projectionVector = arma::randn<arma::vec>(dataset->n_rows);
+  projectionVector /= arma::norm(projectionVector, 2);
+
+  arma::vec projections(count);
+  for (size_t i = 0; i < count; ++i)
+    projections[i] = arma::dot(projectionVector, dataset->col(points[i]));
+
+  // If every point has the same projection, the points are all the same (or
+  // we were extraordinarily unlucky), and we can't split them.
+  const arma::uvec order = arma::sort_index(projections);
+  if (projections[order[0]] == projections[order[count - 1]])
+  {
+    pointIndices = points;
+    return;
+  }
+
+  // The hyperplane goes through the median projection.  In order of
+  // projection, the first half of the points go to the left child and the
+  // others go to the right child.
+  const size_t half = count / 2;
+  splitValue = 0.5 * (projections[order[half - 1]] + projections[order[half]]);
+
+  // The points in the buffer around the hyperplane go to both children, but
+  // only if neither child would be left with too many points; otherwise the
+  // node is split without overlap.
+  size_t leftEnd = half;
+  while (leftEnd < count && projections[order[leftEnd]] <= splitValue + tau)
+    ++leftEnd;
+  size_t rightBegin = half;
+  while (rightBegin > 0 &&
+         projections[order[rightBegin - 1]] >= splitValue - tau)
+    --rightBegin;
+
+  overlap = (leftEnd <= rho * count) && (count - rightBegin <= rho * count);
+  if (!overlap)
+  {
+    leftEnd = half;
+    rightBegin = half;
+  }
+
+  arma::Col<size_t> leftPoints(leftEnd);
+  for (size_t i = 0; i < leftEnd; ++i)
+    leftPoints[i] = points[order[i]];
+  arma::Col<size_t> rightPoints(count - rightBegin);
+  for (size_t i = rightBegin; i < count; ++i)
+    rightPoints[i - rightBegin] = points[order[i]];
+
+  // Now that we know which points go to each child, we will recursively split
+  // the children by calling their constructors (which perform this splitting
+  // process).
+  left = new SpillTree(this, leftPoints, maxLeafSize, tau, rho);
+  right = new SpillTree(this, rightPoints, maxLeafSize, tau, rho);
+  count = left->NumDescendants() + right->NumDescendants();
+
+  // Calculate parent distances for those two nodes.
+  arma::vec center, leftCenter, rightCenter;
+  Center(center);
+  left->Center(leftCenter);
+  right->Center(rightCenter);
+
+  left->ParentDistance() = MetricType::Evaluate(center, leftCenter);
+  right->ParentDistance() = MetricType::Evaluate(center, rightCenter);
+}
+
+template<typename MetricType, typename StatisticType, typename MatType>
+void SpillTree<MetricType, StatisticType, MatType>::CheckParameters(
+    const double tau,
+    const double rho)
+{
+  if (tau < 0.0)
+  {
+    std::ostringstream oss;
+    oss << "SpillTree::SpillTree(): tau must be nonnegative (given " << tau
+        << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // If rho were 1, an overlapping node could have a child holding all of its
+  // points, and splitting would never end.
+  if (rho <= 0.0 || rho >= 1.0)
+  {
+    std::ostringstream oss;
+    oss << "SpillTree::SpillTree(): rho must be greater than 0 and less than 1 "
+        << "(given " << rho << ")";
+    throw std::invalid_argument(oss.str());
+  }
+}
+
+// Default constructor (private), for boost::serialization.
+template<typename MetricType, typename StatisticType, typename MatType>
+SpillTree<MetricType, StatisticType, MatType>::SpillTree() :
+    left(NULL),
+    right(NULL),
+    parent(NULL),
+    count(0),
+    overlap(false),
+    splitValue(0.0),
+    stat(*this),
+    parentDistance(0),
+    furthestDescendantDistance(0),
+    dataset(NULL)
+{
+  // Nothing to do.
+}
+
+/**
+ * Serialize the tree.
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+template<typename Archive>
+void SpillTree<MetricType, StatisticType, MatType>::Serialize(
+    Archive& ar,
+    const unsigned int /* version */)
+{
+  using data::CreateNVP;
+
+  // If we're loading, and we have children, they need to be deleted.
+  if (Archive::is_loading::value)
+  {
+    if (left)
+      delete left;
+    if (right)
+      delete right;
+    if (!parent)
+      delete dataset;
+  }
+
+  ar & CreateNVP(parent, "parent");
+  ar & CreateNVP(count, "count");
+  ar & CreateNVP(pointIndices, "pointIndices");
+  ar & CreateNVP(overlap, "overlap");
+  ar & CreateNVP(projectionVector, "projectionVector");
+  ar & CreateNVP(splitValue, "splitValue");
+  ar & CreateNVP(bound, "bound");
+  ar & CreateNVP(stat, "statistic");
+  ar & CreateNVP(parentDistance, "parentDistance");
+  ar & CreateNVP(furthestDescendantDistance, "furthestDescendantDistance");
+  ar & CreateNVP(dataset, "dataset");
+
+  // Save children last; otherwise boost::serialization gets confused.
+  ar & CreateNVP(left, "left");
+  ar & CreateNVP(right, "right");
+
+  // Due to quirks of boost::serialization, if a tree is saved as an object and
+  // not a pointer, the first level of the tree will be duplicated on load.
+  // Therefore, if we are the root of the tree, then we need to make sure our
+  // children's parent links are correct, and delete the duplicated node if
+  // necessary.
+  if (Archive::is_loading::value)
+  {
+    // Get parents of left and right children, or, NULL, if they don't exist.
+    SpillTree* leftParent = left ? left->Parent() : NULL;
+    SpillTree* rightParent = right ? right->Parent() : NULL;
+
+    // Reassign parent links if necessary.
+    if (left && left->Parent() != this)
+      left->Parent() = this;
+    if (right && right->Parent() != this)
+      right->Parent() = this;
+
+    // Do we need to delete the left parent?
+    if (leftParent != NULL && leftParent != this)
+    {
+      // Sever the duplicate parent's children.  Ensure we don't delete the
+      // dataset, by faking the duplicated parent's parent (that is, we need to
+      // set the parent to something non-NULL; 'this' works).
+      leftParent->Parent() = this;
+      leftParent->Left() = NULL;
+      leftParent->Right() = NULL;
+      delete leftParent;
+    }
+
+    // Do we need to delete the right parent?
+    if (rightParent != NULL && rightParent != this && rightParent != leftParent)
+    {
+      // Sever the duplicate parent's children, in the same way as above.
+      rightParent->Parent() = this;
+      rightParent->Left() = NULL;
+      rightParent->Right() = NULL;
+      delete rightParent;
+    }
+  }
+}
+
+/**
+ * Returns a string representation of this object.
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+std::string SpillTree<MetricType, StatisticType, MatType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "SpillTree [" << this << "]" << std::endl;
+  convert << "  Number of descendants: " << count << std::endl;
+  if (!IsLeaf())
+  {
+    convert << "  Split value: " << splitValue << std::endl;
+    convert << "  Overlapping children: " << (overlap ? "yes" : "no")
+        << std::endl;
+  }
+  convert << "  Bound: " << std::endl;
+  convert << mlpack::util::Indent(bound.ToString(), 2);
+  convert << "  Statistic: " << std::endl;
+  convert << mlpack::util::Indent(stat.ToString(), 2);
+
+  // How many levels should we print?  This will print the top two tree levels.
+  if (left != NULL && parent == NULL)
+  {
+    convert << " Left child:" << std::endl;
+    convert << mlpack::util::Indent(left->ToString(), 2);
+  }
+  if (right != NULL && parent == NULL)
+  {
+    convert << " Right child:" << std::endl;
+    convert << mlpack::util::Indent(right->ToString(), 2);
+  }
+  return convert.str();
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,55 @@
+/**
+ * @file traits.hpp
+ * @author Ryan Curtin
+ *
+ * Specialization of the TreeTraits class for the SpillTree type of tree.
+ */
+#ifndef __MLPACK_CORE_TREE_SPILL_TREE_TRAITS_HPP
+#define __MLPACK_CORE_TREE_SPILL_TREE_TRAITS_HPP
+
+#include <mlpack/core/tree/tree_traits.hpp>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * This is a specialization of the TreeTraits class to the SpillTree tree type.
+ * It defines characteristics of the spill tree, and is used to help write
+ * tree-independent (but still optimized) tree-based algorithms.  See
+ * mlpack/core/tree/tree_traits.hpp for more information.
+ */
+template<typename MetricType, typename StatisticType, typename MatType>
+class TreeTraits<SpillTree<MetricType, StatisticType, MatType>>
+{
+ public:
+  /**
+   * The children of a spill tree node may hold the same points.
+   */
+  static const bool HasOverlappingChildren = true;
+
+  /**
+   * There is no guarantee that the first point in a node is its centroid.
+   */
+  static const bool FirstPointIsCentroid = false;
+
+  /**
+   * Points are not contained at multiple levels of the spill tree.
+   */
+  static const bool HasSelfChildren = false;
+
+  /**
+   * Points are not rearranged during building of the tree; the leaves hold
+   * lists of point indices instead.
+   */
+  static const bool RearrangesDataset = false;
+
+  /**
+   * This is always a binary tree.
+   */
+  static const bool BinaryTree = true;
+};
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
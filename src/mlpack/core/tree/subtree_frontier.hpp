@@ -0,0 +1,108 @@
+/**
+ * @file subtree_frontier.hpp
+ * @author Ryan Curtin
+ *
+ * A utility function to split a tree into a set of disjoint subtrees, which is
+ * useful for dividing a traversal into independent pieces of work (i.e. for
+ * parallelization).
+ */
+#ifndef __MLPACK_CORE_TREE_SUBTREE_FRONTIER_HPP
+#define __MLPACK_CORE_TREE_SUBTREE_FRONTIER_HPP
+
+#include <mlpack/core.hpp>
+#include <vector>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * Split the given tree into a frontier of disjoint subtrees such that every
+ * point held in the tree is a descendant of exactly one node in the frontier.
+ * The node with the most descendants is repeatedly replaced by its children,
+ * until there are at least minNodes nodes in the frontier or every node in the
+ * frontier is a leaf.  The nodes in the frontier are returned in no particular
+ * order.
+ *
+ * This requires that no node above the frontier holds a point that is not also
+ * held by one of its descendants.  This is true for kd-trees and ball trees
+ * (only leaves hold points), for R trees (only leaves hold points), and for
+ * cover trees (the point held by a node is also held by its self-child).  The
+ * overlapping children of a spill tree may hold the same points, so its
+ * frontier may not be disjoint; use FrontierIsDisjoint() to check.
+ *
+ * @param root Root of the tree to split.
+ * @param minNodes Minimum number of subtrees desired.
+ * @param frontier Vector to store the subtrees in.
+ */
+template<typename TreeType>
+void SubtreeFrontier(TreeType& root,
+                     const size_t minNodes,
+                     std::vector<TreeType*>& frontier)
+{
+  frontier.clear();
+  frontier.push_back(&root);
+
+  while (frontier.size() < minNodes)
+  {
+    // Find the largest subtree that can still be split.
+    size_t largest = frontier.size();
+    size_t largestDescendants = 0;
+    for (size_t i = 0; i < frontier.size(); ++i)
+    {
+      if (frontier[i]->NumChildren() == 0)
+        continue;
+
+      if (frontier[i]->NumDescendants() > largestDescendants)
+      {
+        largest = i;
+        largestDescendants = frontier[i]->NumDescendants();
+      }
+    }
+
+    // If every node is a leaf, we cannot split any further.
+    if (largest == frontier.size())
+      break;
+
+    // Replace the node with its children.
+    TreeType* node = frontier[largest];
+    frontier[largest] = &node->Child(0);
+    for (size_t i = 1; i < node->NumChildren(); ++i)
+      frontier.push_back(&node->Child(i));
+  }
+}
+
+/**
+ * Return whether no point is a descendant of more than one node of the given
+ * frontier.  This is always true for trees whose children hold disjoint sets
+ * of points, but not for spill trees, whose overlapping children may hold the
+ * same points.  A traversal of each node of the frontier on its own thread is
+ * only safe if this is true.
+ *
+ * @param frontier Nodes of the frontier (from SubtreeFrontier()).
+ * @param numPoints Number of points in the dataset of the tree.
+ */
+template<typename TreeType>
+bool FrontierIsDisjoint(const std::vector<TreeType*>& frontier,
+                        const size_t numPoints)
+{
+  // The node of the frontier that each point was found in, if any.
+  std::vector<size_t> owner(numPoints, frontier.size());
+  for (size_t i = 0; i < frontier.size(); ++i)
+  {
+    for (size_t j = 0; j < frontier[i]->NumDescendants(); ++j)
+    {
+      // A point may appear more than once in the same node.
+      const size_t point = frontier[i]->Descendant(j);
+      if (owner[point] != frontier.size() && owner[point] != i)
+        return false;
+      owner[point] = i;
+    }
+  }
+
+  return true;
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
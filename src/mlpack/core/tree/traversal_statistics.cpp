@@ -0,0 +1,147 @@
+/**
+ * @file traversal_statistics.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the non-templated parts of TraversalStatistics.
+ */
+#include "traversal_statistics.hpp"
+
+using namespace mlpack;
+using namespace mlpack::tree;
+
+void TraversalStatistics::Counters::Merge(const Counters& other)
+{
+  scores += other.scores;
+  prunes += other.prunes;
+  rescores += other.rescores;
+  rescoreSuccesses += other.rescoreSuccesses;
+  baseCases += other.baseCases;
+}
+
+TraversalStatistics::TraversalStatistics(const bool mergeIntoGlobal) :
+    mergeIntoGlobal(mergeIntoGlobal)
+{
+  // Nothing to do.
+}
+
+TraversalStatistics::~TraversalStatistics()
+{
+  if (mergeIntoGlobal)
+  {
+    // Traversers may be destroyed by several threads at once.
+    #pragma omp critical(traversal_statistics_global)
+    Global().Merge(*this);
+  }
+}
+
+void TraversalStatistics::Merge(const TraversalStatistics& other)
+{
+  total.Merge(other.total);
+
+  if (queryDepths.size() < other.queryDepths.size())
+    queryDepths.resize(other.queryDepths.size());
+  for (size_t i = 0; i < other.queryDepths.size(); ++i)
+    queryDepths[i].Merge(other.queryDepths[i]);
+
+  if (referenceDepths.size() < other.referenceDepths.size())
+    referenceDepths.resize(other.referenceDepths.size());
+  for (size_t i = 0; i < other.referenceDepths.size(); ++i)
+    referenceDepths[i].Merge(other.referenceDepths[i]);
+
+  std::map<std::pair<size_t, size_t>, Counters>::const_iterator it;
+  for (it = other.nodeSizes.begin(); it != other.nodeSizes.end(); ++it)
+    nodeSizes[it->first].Merge(it->second);
+}
+
+void TraversalStatistics::Reset()
+{
+  total = Counters();
+  queryDepths.clear();
+  referenceDepths.clear();
+  nodeSizes.clear();
+}
+
+TraversalStatistics& TraversalStatistics::Global()
+{
+  // This is never freed, so that it is still available when the CLI object is
+  // destroyed at exit (which reports it).
+  static TraversalStatistics* global = new TraversalStatistics(false);
+  return *global;
+}
+
+// Get floor(log2(size)), taking the size of an empty node to be 1.
+static size_t SizeBin(size_t size)
+{
+  size_t bin = 0;
+  while (size > 1)
+  {
+    size >>= 1;
+    ++bin;
+  }
+  return bin;
+}
+
+void TraversalStatistics::Add(const Counters& c,
+                              const size_t queryDepth,
+                              const size_t referenceDepth,
+                              const size_t querySize,
+                              const size_t referenceSize)
+{
+  total.Merge(c);
+
+  if (queryDepths.size() <= queryDepth)
+    queryDepths.resize(queryDepth + 1);
+  queryDepths[queryDepth].Merge(c);
+
+  if (referenceDepths.size() <= referenceDepth)
+    referenceDepths.resize(referenceDepth + 1);
+  referenceDepths[referenceDepth].Merge(c);
+
+  nodeSizes[std::make_pair(SizeBin(querySize), SizeBin(referenceSize))].Merge(
+      c);
+}
+
+// Write the fields of a Counters object (without braces).
+static void CountersToJSON(std::ostream& stream,
+                           const TraversalStatistics::Counters& c)
+{
+  stream << "\"scores\": " << c.scores << ", \"prunes\": " << c.prunes
+      << ", \"rescores\": " << c.rescores << ", \"rescore_successes\": "
+      << c.rescoreSuccesses << ", \"base_cases\": " << c.baseCases;
+}
+
+// Write a list of per-depth counts.
+static void DepthsToJSON(std::ostream& stream,
+                         const std::vector<TraversalStatistics::Counters>& d)
+{
+  stream << "[";
+  for (size_t i = 0; i < d.size(); ++i)
+  {
+    stream << ((i == 0) ? "\n" : ",\n") << "    { \"depth\": " << i << ", ";
+    CountersToJSON(stream, d[i]);
+    stream << " }";
+  }
+  stream << ((d.size() > 0) ? "\n  ]" : "]");
+}
+
+void TraversalStatistics::ToJSON(std::ostream& stream) const
+{
+  stream << "{\n  \"total\": { ";
+  CountersToJSON(stream, total);
+  stream << " },\n  \"query_depths\": ";
+  DepthsToJSON(stream, queryDepths);
+  stream << ",\n  \"reference_depths\": ";
+  DepthsToJSON(stream, referenceDepths);
+  stream << ",\n  \"node_sizes\": [";
+
+  std::map<std::pair<size_t, size_t>, Counters>::const_iterator it;
+  for (it = nodeSizes.begin(); it != nodeSizes.end(); ++it)
+  {
+    stream << ((it == nodeSizes.begin()) ? "\n" : ",\n")
+        << "    { \"query_size_log2\": " << it->first.first
+        << ", \"reference_size_log2\": " << it->first.second << ", ";
+    CountersToJSON(stream, it->second);
+    stream << " }";
+  }
+  stream << ((nodeSizes.size() > 0) ? "\n  ]" : "]") << "\n}\n";
+}
@@ -0,0 +1,356 @@
+/**
+ * @file traversal_statistics.hpp
+ * @author Ryan Curtin
+ *
+ * Policies for the tree traversers that optionally record how many node
+ * combinations were scored, pruned, and rescored, and how many base cases were
+ * evaluated, broken down by node depth and node size.  This is useful for
+ * choosing tree types and leaf sizes for a particular dataset.
+ */
+#ifndef __MLPACK_CORE_TREE_TRAVERSAL_STATISTICS_HPP
+#define __MLPACK_CORE_TREE_TRAVERSAL_STATISTICS_HPP
+
+#include <cfloat>
+#include <cstddef>
+#include <map>
+#include <ostream>
+#include <utility>
+#include <vector>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * The default traversal statistics policy, which records nothing.  Each
+ * function simply forwards to the rules (or does nothing at all), and is
+ * inline, so a traverser using this policy behaves (and performs) exactly as if
+ * it were not instrumented.
+ */
+class NullTraversalStatistics
+{
+ public:
+  //! Score the given node combination.
+  template<typename RuleType, typename TreeType>
+  double Score(RuleType& rule, TreeType& queryNode, TreeType& referenceNode)
+  {
+    return rule.Score(queryNode, referenceNode);
+  }
+
+  //! Score the given query point and reference node.
+  template<typename RuleType, typename TreeType>
+  double Score(RuleType& rule, const size_t queryIndex, TreeType& referenceNode)
+  {
+    return rule.Score(queryIndex, referenceNode);
+  }
+
+  //! Score the given query point and every child of the reference node, with
+  //! one call to the rules.
+  template<typename RuleType, typename TreeType>
+  void ScoreChildren(RuleType& rule,
+                     const size_t queryIndex,
+                     TreeType& referenceNode,
+                     double* scores)
+  {
+    rule.ScoreChildren(queryIndex, referenceNode, scores);
+  }
+
+  //! Rescore the given node combination.
+  template<typename RuleType, typename TreeType>
+  double Rescore(RuleType& rule,
+                 TreeType& queryNode,
+                 TreeType& referenceNode,
+                 const double oldScore)
+  {
+    return rule.Rescore(queryNode, referenceNode, oldScore);
+  }
+
+  //! Rescore the given query point and reference node.
+  template<typename RuleType, typename TreeType>
+  double Rescore(RuleType& rule,
+                 const size_t queryIndex,
+                 TreeType& referenceNode,
+                 const double oldScore)
+  {
+    return rule.Rescore(queryIndex, referenceNode, oldScore);
+  }
+
+  //! Note that base cases were evaluated between two nodes.
+  template<typename TreeType>
+  void BaseCases(const TreeType& /* queryNode */,
+                 const TreeType& /* referenceNode */,
+                 const size_t /* count */) { }
+
+  //! Note that base cases were evaluated between a query point and a node.
+  template<typename TreeType>
+  void BaseCases(const TreeType& /* referenceNode */,
+                 const size_t /* count */) { }
+};
+
+/**
+ * A traversal statistics policy that counts the calls to Score() and
+ * Rescore() made by a traverser, how many of those calls pruned, and how many
+ * base cases were evaluated.  Each event is recorded three times: by the depth
+ * of the query node, by the depth of the reference node, and by the sizes
+ * (number of descendants, binned by powers of two) of both nodes.  For
+ * single-tree traversals, the query is treated as a node of size 1 at depth 0.
+ *
+ * Finding the depth of a node requires walking up the tree, and finding the
+ * size of a node may require walking down it (for RectangleTree), so
+ * traversals are noticeably slower with this policy.
+ *
+ * When a TraversalStatistics object is destroyed, its counts are added to
+ * TraversalStatistics::Global(), so that the statistics of every traversal in
+ * a program can be reported at once.  This is safe to do from multiple OpenMP
+ * threads.
+ */
+class TraversalStatistics
+{
+ public:
+  //! The counts held for each depth and each combination of node sizes.
+  struct Counters
+  {
+    //! The number of calls to Score().
+    size_t scores;
+    //! The number of calls to Score() that pruned.
+    size_t prunes;
+    //! The number of calls to Rescore().
+    size_t rescores;
+    //! The number of calls to Rescore() that did not prune.
+    size_t rescoreSuccesses;
+    //! The number of base cases.
+    size_t baseCases;
+
+    Counters() :
+        scores(0), prunes(0), rescores(0), rescoreSuccesses(0), baseCases(0)
+    { }
+
+    //! Add the given counts to these counts.
+    void Merge(const Counters& other);
+  };
+
+  /**
+   * Create an empty set of traversal statistics.
+   *
+   * @param mergeIntoGlobal If true, the counts are added to Global() when this
+   *      object is destroyed.
+   */
+  TraversalStatistics(const bool mergeIntoGlobal = true);
+
+  //! Add the counts to Global(), if requested.
+  ~TraversalStatistics();
+
+  //! Score the given node combination and record it.
+  template<typename RuleType, typename TreeType>
+  double Score(RuleType& rule, TreeType& queryNode, TreeType& referenceNode)
+  {
+    const double score = rule.Score(queryNode, referenceNode);
+    Counters c;
+    c.scores = 1;
+    c.prunes = (score == DBL_MAX) ? 1 : 0;
+    Add(c, queryNode, referenceNode);
+    return score;
+  }
+
+  //! Score the given query point and reference node and record it.
+  template<typename RuleType, typename TreeType>
+  double Score(RuleType& rule, const size_t queryIndex, TreeType& referenceNode)
+  {
+    const double score = rule.Score(queryIndex, referenceNode);
+    Counters c;
+    c.scores = 1;
+    c.prunes = (score == DBL_MAX) ? 1 : 0;
+    Add(c, referenceNode);
+    return score;
+  }
+
+  //! Score the given query point and every child of the reference node, with
+  //! one call to the rules, and record each score.
+  template<typename RuleType, typename TreeType>
+  void ScoreChildren(RuleType& rule,
+                     const size_t queryIndex,
+                     TreeType& referenceNode,
+                     double* scores)
+  {
+    rule.ScoreChildren(queryIndex, referenceNode, scores);
+    for (size_t i = 0; i < referenceNode.NumChildren(); ++i)
+    {
+      Counters c;
+      c.scores = 1;
+      c.prunes = (scores[i] == DBL_MAX) ? 1 : 0;
+      Add(c, referenceNode.Child(i));
+    }
+  }
+
+  //! Rescore the given node combination and record it.
+  template<typename RuleType, typename TreeType>
+  double Rescore(RuleType& rule,
+                 TreeType& queryNode,
+                 TreeType& referenceNode,
+                 const double oldScore)
+  {
+    const double score = rule.Rescore(queryNode, referenceNode, oldScore);
+    Counters c;
+    c.rescores = 1;
+    c.rescoreSuccesses = (score == DBL_MAX) ? 0 : 1;
+    Add(c, queryNode, referenceNode);
+    return score;
+  }
+
+  //! Rescore the given query point and reference node and record it.
+  template<typename RuleType, typename TreeType>
+  double Rescore(RuleType& rule,
+                 const size_t queryIndex,
+                 TreeType& referenceNode,
+                 const double oldScore)
+  {
+    const double score = rule.Rescore(queryIndex, referenceNode, oldScore);
+    Counters c;
+    c.rescores = 1;
+    c.rescoreSuccesses = (score == DBL_MAX) ? 0 : 1;
+    Add(c, referenceNode);
+    return score;
+  }
+
+  //! Record that the given number of base cases were evaluated between two
+  //! nodes.
+  template<typename TreeType>
+  void BaseCases(const TreeType& queryNode,
+                 const TreeType& referenceNode,
+                 const size_t count)
+  {
+    Counters c;
+    c.baseCases = count;
+    Add(c, queryNode, referenceNode);
+  }
+
+  //! Record that the given number of base cases were evaluated between a query
+  //! point and a reference node.
+  template<typename TreeType>
+  void BaseCases(const TreeType& referenceNode, const size_t count)
+  {
+    Counters c;
+    c.baseCases = count;
+    Add(c, referenceNode);
+  }
+
+  //! Get the total counts.
+  const Counters& Total() const { return total; }
+  //! Get the counts for each query node depth.
+  const std::vector<Counters>& QueryDepths() const { return queryDepths; }
+  //! Get the counts for each reference node depth.
+  const std::vector<Counters>& ReferenceDepths() const
+  { return referenceDepths; }
+  //! Get the counts for each combination of query and reference node sizes;
+  //! the key holds floor(log2(size)) for the query and reference nodes.
+  const std::map<std::pair<size_t, size_t>, Counters>& NodeSizes() const
+  { return nodeSizes; }
+
+  //! Add the counts held in another TraversalStatistics object to this one.
+  void Merge(const TraversalStatistics& other);
+
+  //! Reset all counts to zero.
+  void Reset();
+
+  //! Write the counts to the given stream as a JSON object.
+  void ToJSON(std::ostream& stream) const;
+
+  //! Get the statistics accumulated over every traversal in the program.
+  static TraversalStatistics& Global();
+
+ private:
+  // Copies would be merged into Global() twice.
+  TraversalStatistics(const TraversalStatistics& other);
+  TraversalStatistics& operator=(const TraversalStatistics& other);
+
+  //! Whether or not to add the counts to Global() on destruction.
+  bool mergeIntoGlobal;
+
+  //! The total counts.
+  Counters total;
+  //! The counts for each query node depth.
+  std::vector<Counters> queryDepths;
+  //! The counts for each reference node depth.
+  std::vector<Counters> referenceDepths;
+  //! The counts for each pair of binned query and reference node sizes.
+  std::map<std::pair<size_t, size_t>, Counters> nodeSizes;
+
+  //! Add the counts for an event between two nodes to each table.
+  template<typename TreeType>
+  void Add(const Counters& c,
+           const TreeType& queryNode,
+           const TreeType& referenceNode)
+  {
+    Add(c, Depth(queryNode), Depth(referenceNode),
+        queryNode.NumDescendants(), referenceNode.NumDescendants());
+  }
+
+  //! Add the counts for an event between a query point and a reference node to
+  //! each table.
+  template<typename TreeType>
+  void Add(const Counters& c, const TreeType& referenceNode)
+  {
+    Add(c, 0, Depth(referenceNode), 1, referenceNode.NumDescendants());
+  }
+
+  //! Get the depth of a node by walking up to the root.
+  template<typename TreeType>
+  static size_t Depth(const TreeType& node)
+  {
+    size_t depth = 0;
+    for (const TreeType* n = node.Parent(); n != NULL; n = n->Parent())
+      ++depth;
+    return depth;
+  }
+
+  //! Add the given counts to each table.
+  void Add(const Counters& c,
+           const size_t queryDepth,
+           const size_t referenceDepth,
+           const size_t querySize,
+           const size_t referenceSize);
+};
+
+/**
+ * The traversal statistics policy used when none is selected for a particular
+ * rule type.  This is NullTraversalStatistics, unless mlpack was configured
+ * with -DTRAVERSAL_STATISTICS=ON (which defines MLPACK_TRAVERSAL_STATISTICS),
+ * in which case every traversal is instrumented.
+ */
+#ifdef MLPACK_TRAVERSAL_STATISTICS
+typedef TraversalStatistics DefaultTraversalStatistics;
+#else
+typedef NullTraversalStatistics DefaultTraversalStatistics;
+#endif
+
+/**
+ * Select the traversal statistics policy that traversers use with a given rule
+ * type.  To instrument the traversals of a single rule type without
+ * instrumenting every traversal, specialize this for that rule type:
+ *
+ * @code
+ * namespace mlpack {
+ * namespace tree {
+ *
+ * template<>
+ * struct TraversalStatisticsPolicy<MyRules>
+ * {
+ *   typedef TraversalStatistics Type;
+ * };
+ *
+ * } // namespace tree
+ * } // namespace mlpack
+ * @endcode
+ *
+ * The specialization must be visible wherever a traverser is instantiated with
+ * that rule type.
+ */
+template<typename RuleType>
+struct TraversalStatisticsPolicy
+{
+  typedef DefaultTraversalStatistics Type;
+};
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
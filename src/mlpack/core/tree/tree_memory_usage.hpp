@@ -0,0 +1,54 @@
+/**
+ * @file tree_memory_usage.hpp
+ * @author Ryan Curtin
+ *
+ * Estimate the memory used by a tree, for --print_memory.
+ */
+#ifndef __MLPACK_CORE_TREE_TREE_MEMORY_USAGE_HPP
+#define __MLPACK_CORE_TREE_TREE_MEMORY_USAGE_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace mlpack {
+namespace tree {
+
+/**
+ * Get the number of nodes in the given tree.  Any tree type with NumChildren()
+ * and Child() can be used.
+ */
+template<typename TreeType>
+size_t NumNodes(const TreeType& tree)
+{
+  // Don't recurse, since some trees (like cover trees) can be very deep.
+  size_t nodes = 0;
+  std::vector<const TreeType*> stack(1, &tree);
+  while (!stack.empty())
+  {
+    const TreeType* node = stack.back();
+    stack.pop_back();
+    ++nodes;
+
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+      stack.push_back(&node->Child(i));
+  }
+
+  return nodes;
+}
+
+/**
+ * Estimate the memory used by the nodes of the given tree (in bytes), as the
+ * number of nodes times the size of a node.  This does not include the dataset
+ * of the tree, or memory that the bounds and statistics of the nodes allocate
+ * themselves.
+ */
+template<typename TreeType>
+size_t TreeMemoryUsage(const TreeType& tree)
+{
+  return NumNodes(tree) * sizeof(TreeType);
+}
+
+} // namespace tree
+} // namespace mlpack
+
+#endif
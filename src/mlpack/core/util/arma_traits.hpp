@@ -86,4 +86,34 @@ struct IsVector<arma::SpSubview<eT> >
   const static bool value = true;
 };
 
+/**
+ * If value == true, then VecType is a sparse Armadillo vector (or a sparse
+ * subview, such as a column of an arma::sp_mat).  The nonzero elements of such
+ * a vector can be iterated over in order with its const_iterator; looking up
+ * an element with operator[] requires a search instead.
+ */
+template<typename VecType>
+struct IsSparseVector
+{
+  const static bool value = false;
+};
+
+template<typename eT>
+struct IsSparseVector<arma::SpCol<eT> >
+{
+  const static bool value = true;
+};
+
+template<typename eT>
+struct IsSparseVector<arma::SpRow<eT> >
+{
+  const static bool value = true;
+};
+
+template<typename eT>
+struct IsSparseVector<arma::SpSubview<eT> >
+{
+  const static bool value = true;
+};
+
 #endif
@@ -0,0 +1,169 @@
+/**
+ * @file batch_predict.hpp
+ * @author Ryan Curtin
+ *
+ * BatchPredict() and BatchClassify(), which score a large set of points with a
+ * trained model block by block, in parallel, writing into a preallocated
+ * output.  The points may be dense or sparse, with float or double elements;
+ * each block is passed to the model as the matrix type it expects.
+ */
+#ifndef __MLPACK_CORE_UTIL_BATCH_PREDICT_HPP
+#define __MLPACK_CORE_UTIL_BATCH_PREDICT_HPP
+
+#include <mlpack/prereqs.hpp>
+#include <mlpack/core/util/parallel.hpp>
+
+namespace mlpack {
+
+/**
+ * The default number of points in each block scored by BatchPredict() and
+ * BatchClassify().
+ */
+const size_t batchPredictBlockSize = 8192;
+
+/**
+ * Call f() on the given columns of the points, which already have the type
+ * the model expects, as a matrix that aliases their memory.
+ */
+template<typename ModelMatType, typename FunctionType>
+void BatchBlock(const ModelMatType& points,
+                const size_t begin,
+                const size_t count,
+                FunctionType f,
+                std::true_type /* sameType */)
+{
+  typedef typename ModelMatType::elem_type ElemType;
+  const ModelMatType block(const_cast<ElemType*>(points.colptr(begin)),
+      points.n_rows, count, false, true);
+  f(block);
+}
+
+/**
+ * Call f() on the given columns of the points (dense or sparse), converted to
+ * the dense type the model expects.  Only one block is converted at a time.
+ */
+template<typename ModelMatType, typename MatType, typename FunctionType>
+void BatchBlock(const MatType& points,
+                const size_t begin,
+                const size_t count,
+                FunctionType f,
+                std::false_type /* sameType */)
+{
+  const arma::Mat<typename MatType::elem_type> dense(points.cols(begin,
+      begin + count - 1));
+  const ModelMatType block = arma::conv_to<ModelMatType>::from(dense);
+  f(block);
+}
+
+/**
+ * Call f(block, output) for each block of at most blockSize columns of the
+ * points, in parallel, where block is the block converted to ModelMatType (or
+ * an alias of it, if the points already have that type), and output is a
+ * vector that aliases the elements of results for those columns.  results is
+ * set to one element per point; if it already has that size, its memory is
+ * reused, so scoring many sets of the same size (for instance the chunks of a
+ * data::ChunkedReader) allocates nothing for the results.
+ *
+ * f must write exactly one element of output for each column of block, and
+ * must not resize output to anything else.  Any parallel loops inside f are run
+ * serially, since they are nested in the loop over the blocks.
+ *
+ * @tparam ModelMatType Type of the matrix the model takes.
+ * @param points Points to score, one per column.
+ * @param results Vector to store the results in (one per point).
+ * @param f Function that scores one block.
+ * @param blockSize Maximum number of points in each block.
+ */
+template<typename ModelMatType = arma::mat,
+         typename MatType,
+         typename OutputType,
+         typename FunctionType>
+void BatchApply(const MatType& points,
+                OutputType& results,
+                FunctionType f,
+                const size_t blockSize = batchPredictBlockSize)
+{
+  if (blockSize == 0)
+    throw std::invalid_argument("BatchApply(): block size must be positive");
+
+  results.set_size(points.n_cols);
+  const size_t blocks = (points.n_cols + blockSize - 1) / blockSize;
+
+  typedef typename std::is_same<MatType, ModelMatType>::type SameType;
+  parallel::For(0, blocks, [&](const size_t b)
+  {
+    const size_t begin = b * blockSize;
+    const size_t count = std::min(blockSize, (size_t) points.n_cols - begin);
+
+    BatchBlock<ModelMatType>(points, begin, count,
+        [&](const ModelMatType& block)
+    {
+      OutputType output(results.memptr() + begin, count, false, true);
+      f(block, output);
+    }, SameType());
+  });
+}
+
+/**
+ * Predict the responses of the given points with model.Predict(), block by
+ * block, in parallel (see BatchApply()).  This works with any model that has a
+ * const Predict(points, predictions) method, like LinearRegression, LARS,
+ * LogisticRegression, and SoftmaxRegression.
+ *
+ * @code
+ * arma::vec predictions(points.n_cols); // Allocated once.
+ * BatchPredict(lr, points, predictions);
+ * @endcode
+ *
+ * @tparam ModelMatType Type of the matrix the model takes.
+ * @param model Trained model.
+ * @param points Points to predict the responses of, one per column.
+ * @param predictions Vector to store the predictions in (one per point).
+ * @param blockSize Maximum number of points in each block.
+ */
+template<typename ModelMatType = arma::mat,
+         typename ModelType,
+         typename MatType,
+         typename OutputType>
+void BatchPredict(const ModelType& model,
+                  const MatType& points,
+                  OutputType& predictions,
+                  const size_t blockSize = batchPredictBlockSize)
+{
+  BatchApply<ModelMatType>(points, predictions,
+      [&](const ModelMatType& block, OutputType& output)
+  {
+    model.Predict(block, output);
+  }, blockSize);
+}
+
+/**
+ * Classify the given points with model.Classify(), block by block, in parallel
+ * (see BatchApply()).  This works with any model that has a const
+ * Classify(points, labels) method, like NaiveBayesClassifier and GMM.
+ *
+ * @tparam ModelMatType Type of the matrix the model takes.
+ * @param model Trained model.
+ * @param points Points to classify, one per column.
+ * @param labels Vector to store the labels in (one per point).
+ * @param blockSize Maximum number of points in each block.
+ */
+template<typename ModelMatType = arma::mat,
+         typename ModelType,
+         typename MatType,
+         typename OutputType>
+void BatchClassify(const ModelType& model,
+                   const MatType& points,
+                   OutputType& labels,
+                   const size_t blockSize = batchPredictBlockSize)
+{
+  BatchApply<ModelMatType>(points, labels,
+      [&](const ModelMatType& block, OutputType& output)
+  {
+    model.Classify(block, output);
+  }, blockSize);
+}
+
+} // namespace mlpack
+
+#endif
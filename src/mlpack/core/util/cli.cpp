@@ -8,14 +8,21 @@
 #include <boost/program_options.hpp>
 #include <boost/any.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <fstream>
 #include <iostream>
 #include <string>
 
 #include "cli.hpp"
 #include "log.hpp"
+#include "memory.hpp"
+#include "parallel.hpp"
 
 #include "option.hpp"
 
+#ifdef MLPACK_TRAVERSAL_STATISTICS
+  #include <mlpack/core/tree/traversal_statistics.hpp>
+#endif
+
 using namespace mlpack;
 using namespace mlpack::util;
 
@@ -65,9 +72,9 @@ CLI::~CLI()
     Print();
 
     Log::Info << "Program timers:" << std::endl;
-    std::map<std::string, timeval>::iterator it;
-    for (it = timer.GetAllTimers().begin(); it != timer.GetAllTimers().end();
-        ++it)
+    const std::map<std::string, timeval> timers = timer.GetAllTimers();
+    std::map<std::string, timeval>::const_iterator it;
+    for (it = timers.begin(); it != timers.end(); ++it)
     {
       std::string i = (*it).first;
       Log::Info << "  " << i << ": ";
@@ -75,6 +82,72 @@ CLI::~CLI()
     }
   }
 
+  // Print the memory used, if desired; this is printed even without
+  // --verbose.
+  if (HasParam("print_memory") && !HasParam("help") && !HasParam("info"))
+  {
+    const bool ignoreInput = Log::Info.ignoreInput;
+    Log::Info.ignoreInput = false;
+
+    Log::Info << "Program memory:" << std::endl;
+    Log::Info << "  current RSS: " << Memory::Format(Memory::CurrentRSS())
+        << std::endl;
+    Log::Info << "  peak RSS: " << Memory::Format(Memory::PeakRSS())
+        << std::endl;
+    if (Memory::Accounting())
+      Log::Info << "  allocations: " << Memory::Allocations() << " ("
+          << Memory::Format(Memory::AllocatedBytes()) << ")" << std::endl;
+
+    Log::Info << "Memory during each timer:" << std::endl;
+    const std::map<std::string, timeval> timers = timer.GetAllTimers();
+    std::map<std::string, timeval>::const_iterator it;
+    for (it = timers.begin(); it != timers.end(); ++it)
+    {
+      Log::Info << "  " << it->first << ": ";
+      timer.PrintMemory(it->first);
+    }
+
+    const std::map<std::string, size_t> reports = Memory::Reports();
+    if (!reports.empty())
+    {
+      Log::Info << "Memory of each model:" << std::endl;
+      std::map<std::string, size_t>::const_iterator r;
+      for (r = reports.begin(); r != reports.end(); ++r)
+        Log::Info << "  " << r->first << ": " << Memory::Format(r->second)
+            << std::endl;
+    }
+
+    Log::Info.ignoreInput = ignoreInput;
+  }
+
+  // Write the timers, if desired.
+  if (HasParam("timers_file") && !HasParam("help") && !HasParam("info"))
+  {
+    const std::string filename = GetParam<std::string>("timers_file");
+    std::ofstream stream(filename.c_str());
+    if (!stream.is_open())
+      Log::Warn << "Cannot open file '" << filename << "' to save timers to!"
+          << std::endl;
+    else
+      timer.ToJSON(stream);
+  }
+
+#ifdef MLPACK_TRAVERSAL_STATISTICS
+  // Write the statistics of every tree traversal in the program, if desired.
+  if (HasParam("traversal_statistics_file") && !HasParam("help") &&
+      !HasParam("info"))
+  {
+    const std::string filename =
+        GetParam<std::string>("traversal_statistics_file");
+    std::ofstream stream(filename.c_str());
+    if (!stream.is_open())
+      Log::Warn << "Cannot open file '" << filename << "' to save traversal "
+          << "statistics to!" << std::endl;
+    else
+      tree::TraversalStatistics::Global().ToJSON(stream);
+  }
+#endif
+
   // Notify the user if we are debugging, but only if we actually parsed the
   // options.  This way this output doesn't show up inexplicably for someone who
   // may not have wanted it there (i.e. in Boost unit tests).
@@ -224,6 +297,22 @@ void CLI::DefaultMessages()
     Log::Info.ignoreInput = false;
   }
 
+  // Set the number of threads of every parallel region, if desired.
+  if (HasParam("threads"))
+  {
+    const int threads = GetParam<int>("threads");
+    if (threads < 0)
+      Log::Fatal << "Invalid number of threads: " << threads << "; must be "
+          << "nonnegative." << std::endl;
+
+#ifndef _OPENMP
+    if (threads > 1)
+      Log::Warn << "--threads ignored because MLPACK was compiled without "
+          << "OpenMP." << std::endl;
+#endif
+    parallel::SetThreads((size_t) threads);
+  }
+
   // Notify the user if we are debugging.  This is not done in the constructor
   // because the output streams may not be set up yet.  We also don't want this
   // message twice if the user just asked for help or information.
@@ -407,6 +496,12 @@ void CLI::ParseCommandLine(int argc, char** line)
   UpdateGmap();
   DefaultMessages();
   RequiredOptions();
+
+  // Each run of each timer is only needed for the trace of --timers_file.
+  if (HasParam("timers_file"))
+    GetSingleton().timer.RecordEvents(true);
+  if (HasParam("print_memory"))
+    GetSingleton().timer.RecordMemory(true);
 }
 
 /*
@@ -473,6 +568,11 @@ void CLI::ParseStream(std::istream& stream)
   DefaultMessages();
   RequiredOptions();
 
+  if (HasParam("timers_file"))
+    GetSingleton().timer.RecordEvents(true);
+  if (HasParam("print_memory"))
+    GetSingleton().timer.RecordMemory(true);
+
   Timer::Start("total_time");
 }
 
@@ -742,3 +842,17 @@ PARAM_STRING("info", "Get help on a specific module or option.", "", "");
 PARAM_FLAG("verbose", "Display informational messages and the full list of "
     "parameters and timers at the end of execution.", "v");
 PARAM_FLAG("version", "Display the version of mlpack.", "V");
+PARAM_STRING("timers_file", "If specified, the timers are written to this file "
+    "as JSON: the total time of each timer, in the tree of nested timers, and "
+    "each run of each timer as a Chrome trace event (so the file can be opened "
+    "with chrome://tracing).", "", "");
+PARAM_INT("threads", "Number of threads used for parallel computation (0 uses "
+    "the OpenMP default, usually the number of cores).", "", 0);
+PARAM_FLAG("print_memory", "Print the memory used by the program at the end of "
+    "execution: the peak resident set size, the memory used during each timer, "
+    "and the memory of the models.", "");
+#ifdef MLPACK_TRAVERSAL_STATISTICS
+PARAM_STRING("traversal_statistics_file", "If specified, statistics of every "
+    "tree traversal (the number of scores, prunes, rescores, and base cases, "
+    "by node depth and node size) are written to this file as JSON.", "", "");
+#endif
@@ -45,6 +45,19 @@ namespace mlpack {
  * mode.  Messages to Log::Info will only be shown when the --verbose flag is
  * given to the program (or rather, the CLI class).
  *
+ * Hidden messages are not formatted, but their arguments are still evaluated.
+ * For output in loops that run many times, use MLPACK_LOG_DEBUG,
+ * MLPACK_LOG_INFO, and MLPACK_LOG_WARN instead, which skip the whole statement
+ * if the stream is muted:
+ *
+ * @code
+ * MLPACK_LOG_INFO << "Iteration " << i << "; objective " << f.Evaluate(x)
+ *     << "." << std::endl;
+ * @endcode
+ *
+ * If mlpack is configured with -D NO_LOG_INFO=ON (and without debugging), then
+ * MLPACK_LOG_INFO statements are compiled out entirely.
+ *
  * @see PrefixedOutStream, NullOutStream, CLI
  */
 class Log
@@ -85,4 +98,26 @@ class Log
 
 }; //namespace mlpack
 
+/**
+ * Write to the given stream only if it is enabled; otherwise, the rest of the
+ * statement (including the evaluation of its arguments) is skipped.  This is
+ * safe to use as the body of an if statement with an else.
+ */
+#define MLPACK_LOG_IF_ENABLED(stream) \
+    if (!(stream).Enabled()) { } else (stream)
+
+//! Lazy Log::Debug; see Log.
+#define MLPACK_LOG_DEBUG MLPACK_LOG_IF_ENABLED(mlpack::Log::Debug)
+
+//! Lazy Log::Info; see Log.  This is compiled out if MLPACK_NO_LOG_INFO is
+//! defined in non-debug builds.
+#if defined(MLPACK_NO_LOG_INFO) && !defined(DEBUG)
+  #define MLPACK_LOG_INFO if (true) { } else mlpack::Log::Info
+#else
+  #define MLPACK_LOG_INFO MLPACK_LOG_IF_ENABLED(mlpack::Log::Info)
+#endif
+
+//! Lazy Log::Warn; see Log.
+#define MLPACK_LOG_WARN MLPACK_LOG_IF_ENABLED(mlpack::Log::Warn)
+
 #endif
@@ -0,0 +1,207 @@
+/**
+ * @file memory.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the Memory class, and (with MLPACK_MEMORY_ACCOUNTING) of
+ * the global operator new that counts allocations.
+ */
+#include "memory.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <sstream>
+
+#if defined(__unix__) || defined(__unix) || \
+    (defined(__MACH__) && defined(__APPLE__))
+  #include <sys/resource.h> // getrusage()
+  #include <unistd.h>       // sysconf()
+#endif
+
+#if defined(__MACH__) && defined(__APPLE__)
+  #include <mach/mach.h>    // task_info()
+#endif
+
+using namespace mlpack;
+
+namespace {
+
+//! The number of allocations.
+std::atomic<size_t> allocations(0);
+//! The number of bytes allocated.
+std::atomic<size_t> allocatedBytes(0);
+
+//! The reports of the memory used by models.
+std::map<std::string, size_t>& ReportMap()
+{
+  static std::map<std::string, size_t> reports;
+  return reports;
+}
+
+//! Protects the reports.
+std::mutex& ReportLock()
+{
+  static std::mutex lock;
+  return lock;
+}
+
+} // anonymous namespace
+
+#ifdef MLPACK_MEMORY_ACCOUNTING
+
+// Count every allocation made with the global operator new.  The counters are
+// relaxed atomics, so this is cheap but not free; that's why it is a build
+// option.
+void* operator new(std::size_t size)
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+  void* pointer = std::malloc((size == 0) ? 1 : size);
+  if (pointer == NULL)
+    throw std::bad_alloc();
+
+  return pointer;
+}
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+  allocations.fetch_add(1, std::memory_order_relaxed);
+  allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+  return std::malloc((size == 0) ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+  return operator new(size, tag);
+}
+
+void operator delete(void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+  std::free(pointer);
+}
+
+#endif
+
+size_t Memory::CurrentRSS()
+{
+#if defined(__MACH__) && defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info,
+      &count) != KERN_SUCCESS)
+    return 0;
+
+  return (size_t) info.resident_size;
+#elif defined(__linux__)
+  // The second number of /proc/self/statm is the resident set size, in pages.
+  FILE* file = std::fopen("/proc/self/statm", "r");
+  if (file == NULL)
+    return 0;
+
+  unsigned long size, resident;
+  const int read = std::fscanf(file, "%lu %lu", &size, &resident);
+  std::fclose(file);
+  if (read != 2)
+    return 0;
+
+  return (size_t) resident * (size_t) sysconf(_SC_PAGESIZE);
+#else
+  return 0;
+#endif
+}
+
+size_t Memory::PeakRSS()
+{
+#if defined(__unix__) || defined(__unix) || \
+    (defined(__MACH__) && defined(__APPLE__))
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+
+  #if defined(__MACH__) && defined(__APPLE__)
+  // OS X gives bytes...
+  return (size_t) usage.ru_maxrss;
+  #else
+  // ...and everything else gives kilobytes.
+  return (size_t) usage.ru_maxrss * 1024;
+  #endif
+#else
+  return 0;
+#endif
+}
+
+bool Memory::Accounting()
+{
+#ifdef MLPACK_MEMORY_ACCOUNTING
+  return true;
+#else
+  return false;
+#endif
+}
+
+size_t Memory::Allocations()
+{
+  return allocations.load(std::memory_order_relaxed);
+}
+
+size_t Memory::AllocatedBytes()
+{
+  return allocatedBytes.load(std::memory_order_relaxed);
+}
+
+void Memory::Report(const std::string& name, const size_t bytes)
+{
+  std::lock_guard<std::mutex> guard(ReportLock());
+  ReportMap()[name] = bytes;
+}
+
+std::map<std::string, size_t> Memory::Reports()
+{
+  std::lock_guard<std::mutex> guard(ReportLock());
+  return ReportMap();
+}
+
+std::string Memory::Format(const size_t bytes)
+{
+  static const char* units[] = { "B", "KB", "MB", "GB", "TB" };
+
+  double value = (double) bytes;
+  size_t unit = 0;
+  while (value >= 1024.0 && unit < 4)
+  {
+    value /= 1024.0;
+    ++unit;
+  }
+
+  std::ostringstream oss;
+  if (unit == 0)
+    oss << bytes << " B";
+  else
+    oss << std::fixed << std::setprecision(2) << value << " " << units[unit];
+
+  return oss.str();
+}
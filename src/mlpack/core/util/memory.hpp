@@ -0,0 +1,100 @@
+/**
+ * @file memory.hpp
+ * @author Ryan Curtin
+ *
+ * Memory accounting for MLPACK: the memory used by the process, the number of
+ * allocations, and the memory used by models, for --print_memory.
+ */
+#ifndef __MLPACK_CORE_UTIL_MEMORY_HPP
+#define __MLPACK_CORE_UTIL_MEMORY_HPP
+
+#include <mlpack/core/arma_extend/arma_extend.hpp> // Includes Armadillo.
+#include <map>
+#include <string>
+#include <vector>
+
+namespace mlpack {
+
+/**
+ * The Memory class gives the memory used by the process, and keeps the reports
+ * of the memory used by models, which are printed (with the memory used during
+ * each timer) by the mlpack::CLI object when --print_memory is given.
+ *
+ * The number of allocations is only counted when MLPACK is built with the
+ * MEMORY_ACCOUNTING CMake option, which replaces the global operator new; it
+ * does not include the memory of Armadillo objects, which Armadillo allocates
+ * itself.  The resident set sizes are only known on Linux and OS X (and are 0
+ * elsewhere).
+ *
+ * @code
+ * Memory::Report("reference_tree", tree::TreeMemoryUsage(*tree));
+ * Memory::Report("neighbors", MemoryUsage(neighbors));
+ * @endcode
+ */
+class Memory
+{
+ public:
+  //! Get the resident set size of the process, in bytes.
+  static size_t CurrentRSS();
+
+  //! Get the largest resident set size the process has had, in bytes.
+  static size_t PeakRSS();
+
+  //! Get whether allocations are counted (see Allocations()).
+  static bool Accounting();
+
+  //! Get the number of allocations with the global operator new so far.
+  static size_t Allocations();
+
+  //! Get the number of bytes allocated with the global operator new so far
+  //! (whether or not they have been freed).
+  static size_t AllocatedBytes();
+
+  /**
+   * Record that the given model (or other object) uses the given number of
+   * bytes, for --print_memory.  Reporting the same name again replaces the
+   * report.
+   *
+   * @param name Name of the object.
+   * @param bytes Number of bytes it uses.
+   */
+  static void Report(const std::string& name, const size_t bytes);
+
+  //! Get all of the reports.
+  static std::map<std::string, size_t> Reports();
+
+  //! Format the given number of bytes for printing (such as "1.50 MB").
+  static std::string Format(const size_t bytes);
+};
+
+//! Get the number of bytes used by the given matrix (or vector).
+template<typename eT>
+size_t MemoryUsage(const arma::Mat<eT>& matrix)
+{
+  return sizeof(matrix) + matrix.n_elem * sizeof(eT);
+}
+
+//! Get the number of bytes used by the given cube.
+template<typename eT>
+size_t MemoryUsage(const arma::Cube<eT>& cube)
+{
+  return sizeof(cube) + cube.n_elem * sizeof(eT);
+}
+
+//! Get the number of bytes used by the given vector (of objects that don't
+//! allocate memory themselves).
+template<typename T>
+size_t MemoryUsage(const std::vector<T>& vector)
+{
+  return sizeof(vector) + vector.capacity() * sizeof(T);
+}
+
+//! Get the number of bytes used by the given vector of bools.
+inline size_t MemoryUsage(const std::vector<bool>& vector)
+{
+  return sizeof(vector) + vector.capacity() / 8;
+}
+
+} // namespace mlpack
+
+#endif
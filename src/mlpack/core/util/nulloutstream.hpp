@@ -71,6 +71,9 @@ class NullOutStream
   //! Does nothing.
   template<typename T>
   NullOutStream& operator<<(const T&) { return *this; }
+
+  //! Nothing written to this stream has an effect.
+  bool Enabled() const { return false; }
 };
 
 } // namespace util
@@ -0,0 +1,395 @@
+/**
+ * @file parallel.hpp
+ * @author Ryan Curtin
+ *
+ * A small parallel runtime for MLPACK, built on OpenMP: the number of threads,
+ * control of nested parallelism, parallel loops and deterministic reductions,
+ * task groups for recursive algorithms, and tasks spread across the places
+ * (for instance, the sockets) of the machine.
+ */
+#ifndef __MLPACK_CORE_UTIL_PARALLEL_HPP
+#define __MLPACK_CORE_UTIL_PARALLEL_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace parallel {
+
+/**
+ * Get the number of threads that a parallel region started here would use.
+ * Inside a parallel region, this is 1 unless nested parallelism is allowed
+ * (see ScopedNesting); so code that splits its work by the number of threads
+ * does not split it again when it is called from a parallel loop, for instance
+ * the Lloyd iterations of each parallel k-means restart.  Without OpenMP, this
+ * is always 1.
+ */
+inline size_t Threads()
+{
+#ifdef _OPENMP
+  if (omp_get_active_level() >= omp_get_max_active_levels())
+    return 1;
+  return (size_t) omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+/**
+ * Set the number of threads used by the parallel regions that are started
+ * from now on; this is what the --threads option sets.  Without OpenMP, this
+ * does nothing.
+ */
+inline void SetThreads(const size_t threads)
+{
+#ifdef _OPENMP
+  if (threads > 0)
+    omp_set_num_threads((int) threads);
+#else
+  (void) threads;
+#endif
+}
+
+//! Get whether we are inside an active parallel region.
+inline bool InParallel()
+{
+#ifdef _OPENMP
+  return (omp_in_parallel() != 0);
+#else
+  return false;
+#endif
+}
+
+//! Get the index of the calling thread in its team (0 outside of a parallel
+//! region).
+inline size_t ThreadIndex()
+{
+#ifdef _OPENMP
+  return (size_t) omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+/**
+ * Allow a given number of levels of nested parallel regions (the enclosing
+ * region counts as one) while this object exists, and restore the previous
+ * setting when it is destroyed.  By default OpenMP runs nested regions with one
+ * thread, which avoids oversubscription; this is only worthwhile when the
+ * outer region has fewer tasks than threads.  The number of threads of the
+ * inner regions should then be limited; inside a parallel region, SetThreads()
+ * only changes it for the calling thread.
+ *
+ * @code
+ * parallel::ScopedNesting nesting(2);
+ * #pragma omp parallel for num_threads(restarts)
+ * for (size_t r = 0; r < restarts; ++r)
+ * {
+ *   parallel::SetThreads(threads / restarts);
+ *   RunRestart(r); // Its parallel loops use threads / restarts threads.
+ * }
+ * @endcode
+ */
+class ScopedNesting
+{
+ public:
+  //! Allow the given number of active levels of parallel regions.
+  ScopedNesting(const size_t levels)
+  {
+#ifdef _OPENMP
+    oldLevels = omp_get_max_active_levels();
+    omp_set_max_active_levels((int) levels);
+#else
+    (void) levels;
+    oldLevels = 1;
+#endif
+  }
+
+  //! Restore the previous number of active levels.
+  ~ScopedNesting()
+  {
+#ifdef _OPENMP
+    omp_set_max_active_levels(oldLevels);
+#endif
+  }
+
+ private:
+  //! The previous number of active levels.
+  int oldLevels;
+};
+
+/**
+ * Call f(i) for every i in [begin, end), in parallel.  If chunkSize is 0, the
+ * range is split into one contiguous block per thread (the schedule(static)
+ * that most loops in MLPACK use); otherwise, the threads take chunks of
+ * chunkSize indices as they become free, which balances iterations of
+ * different cost.  The calls for different indices must be independent.  The
+ * loop is serial if it is nested in a parallel region (see Threads()) or if it
+ * has only one iteration.
+ *
+ * @code
+ * parallel::For(0, data.n_cols, [&](const size_t i)
+ * {
+ *   norms[i] = arma::norm(data.col(i), 2);
+ * });
+ * @endcode
+ *
+ * @param begin First index.
+ * @param end One past the last index.
+ * @param f Function to call on each index.
+ * @param chunkSize Number of indices taken at once by a thread (0 for a static
+ *     schedule).
+ */
+template<typename FunctionType>
+void For(const size_t begin,
+         const size_t end,
+         FunctionType f,
+         const size_t chunkSize = 0)
+{
+  if (end <= begin)
+    return;
+
+#ifdef _OPENMP
+  const bool spawn = (Threads() > 1 && end - begin > 1);
+  if (chunkSize == 0)
+  {
+    #pragma omp parallel for schedule(static) if(spawn)
+    for (size_t i = begin; i < end; ++i)
+      f(i);
+  }
+  else
+  {
+    #pragma omp parallel for schedule(dynamic, chunkSize) if(spawn)
+    for (size_t i = begin; i < end; ++i)
+      f(i);
+  }
+#else
+  (void) chunkSize;
+  for (size_t i = begin; i < end; ++i)
+    f(i);
+#endif
+}
+
+/**
+ * Reduce over the indices [0, n) in blocks of blockSize indices, in parallel,
+ * so that the result is the same every time for a fixed number of threads.
+ * Each thread starts from its own copy of init and calls f(state, begin, end)
+ * with it for each of its blocks [begin, end).  The static schedule gives each
+ * thread the same blocks every time, and the states of the threads are then
+ * combined in thread order, with merge(result, state); so floating-point sums
+ * are always added in the same order, whichever thread finishes first.  The
+ * reduction is serial if it is nested in a parallel region (see Threads()) or
+ * if there is only one block.
+ *
+ * Loops that need more per-thread state than one block has (like the
+ * bound-based k-means steps, whose threads keep scratch space and their own
+ * copy of the metric) follow the same scheme by hand: one state per thread, a
+ * static schedule, and a merge in thread order afterwards.
+ *
+ * @code
+ * arma::vec sum = parallel::BlockReduce(data.n_cols, 1024,
+ *     arma::vec(data.n_rows, arma::fill::zeros),
+ *     [&](arma::vec& blockSum, const size_t begin, const size_t end)
+ *     {
+ *       blockSum += arma::sum(data.cols(begin, end - 1), 1);
+ *     },
+ *     [](arma::vec& total, const arma::vec& blockSum) { total += blockSum; });
+ * @endcode
+ *
+ * @param n Number of indices.
+ * @param blockSize Number of indices in each block.
+ * @param init Initial state of each thread.
+ * @param f Function to call on the state of the thread and each block.
+ * @param merge Function to merge the state of each thread into the result.
+ * @return The merged states of all threads.
+ */
+template<typename StateType,
+         typename BlockFunctionType,
+         typename MergeFunctionType>
+StateType BlockReduce(const size_t n,
+                      const size_t blockSize,
+                      const StateType& init,
+                      BlockFunctionType f,
+                      MergeFunctionType merge)
+{
+  const size_t numBlocks = (n + blockSize - 1) / blockSize;
+  const size_t numThreads = std::max((size_t) 1, std::min(Threads(),
+      numBlocks));
+
+  // The states are made here, in case fewer threads than requested run.
+  std::vector<StateType> states(numThreads, init);
+
+  #pragma omp parallel num_threads(numThreads) if(numThreads > 1)
+  {
+    StateType& state = states[ThreadIndex()];
+
+    #pragma omp for schedule(static)
+    for (size_t block = 0; block < numBlocks; ++block)
+    {
+      const size_t begin = block * blockSize;
+      f(state, begin, std::min(begin + blockSize, n));
+    }
+  }
+
+  StateType result = std::move(states[0]);
+  for (size_t t = 1; t < numThreads; ++t)
+    merge(result, states[t]);
+  return result;
+}
+
+/**
+ * Call f(i) for every i in [0, tasks), with the threads that call f() spread
+ * across the places given by OMP_PLACES (with OMP_PLACES=sockets, one thread
+ * per socket, as far as there are sockets).  The index i is always given to the
+ * same thread of the team, so if the number of threads does not change, every
+ * call with the same number of tasks runs f(i) on the same place.  Memory is
+ * usually allocated on the NUMA node of the thread that first writes to it, so
+ * data built by f(i) in one call stays close to the thread that reads it in
+ * f(i) in the next.
+ *
+ * Inside f(), nested parallelism is allowed and the remaining threads are
+ * shared out: Threads() is the number of threads divided by the number of
+ * tasks, and the parallel loops of f() use threads of the same place (with
+ * OMP_PROC_BIND=spread,close).  The tasks are run serially if Spread() is
+ * called inside a parallel region, if there is only one thread, or if the
+ * compiler does not support OpenMP 4.0 thread affinity.
+ *
+ * @code
+ * parallel::Spread(shards.size(), [&](const size_t i)
+ * {
+ *   shards[i] = new Shard(...); // Built and first touched on its place.
+ * });
+ * @endcode
+ *
+ * @param tasks Number of tasks.
+ * @param f Function to call on each task index.
+ */
+template<typename FunctionType>
+void Spread(const size_t tasks, FunctionType f)
+{
+#if defined(_OPENMP) && (_OPENMP >= 201307)
+  const size_t threads = Threads();
+  if (threads > 1 && tasks > 1)
+  {
+    const size_t team = std::min(tasks, threads);
+    const size_t innerThreads = std::max(threads / team, (size_t) 1);
+    ScopedNesting nesting(2);
+
+    #pragma omp parallel num_threads(team) proc_bind(spread)
+    {
+      SetThreads(innerThreads);
+      const size_t teamSize = (size_t) omp_get_num_threads();
+      for (size_t i = ThreadIndex(); i < tasks; i += teamSize)
+        f(i);
+    }
+    return;
+  }
+#endif
+
+  for (size_t i = 0; i < tasks; ++i)
+    f(i);
+}
+
+/**
+ * A group of tasks for recursive algorithms, like building the two children of
+ * a tree node.  Tasks started with Run() may be run by any thread of the
+ * enclosing team, and idle threads take (steal) tasks that were started by
+ * other threads; Wait() (or the destructor) waits for all of the tasks of the
+ * group, but not for the tasks those tasks started themselves.  The tasks must
+ * be run from inside RunTasks(); otherwise, or if spawn is false, each task is
+ * run immediately by the calling thread, which is how small subproblems should
+ * be handled.
+ *
+ * @code
+ * size_t Count(Node& node)
+ * {
+ *   size_t left = 0, right = 0;
+ *   parallel::TaskGroup group;
+ *   const bool spawn = (node.NumPoints() >= threshold);
+ *   group.Run([&]() { left = Count(node.Left()); }, spawn);
+ *   group.Run([&]() { right = Count(node.Right()); }, spawn);
+ *   group.Wait();
+ *   return left + right + 1;
+ * }
+ *
+ * size_t count = 0;
+ * parallel::RunTasks([&]() { count = Count(root); });
+ * @endcode
+ */
+class TaskGroup
+{
+ public:
+  //! Create an empty task group.
+  TaskGroup() { }
+
+  //! Wait for the tasks of the group.
+  ~TaskGroup() { Wait(); }
+
+  /**
+   * Start a task that calls f().  The function is copied into the task, so
+   * anything it refers to must outlive the call to Wait().
+   *
+   * @param f Function to call.
+   * @param spawn If false, f() is called immediately by this thread.
+   */
+  template<typename FunctionType>
+  void Run(FunctionType f, const bool spawn = true)
+  {
+#ifdef _OPENMP
+    #pragma omp task if(spawn) firstprivate(f)
+    f();
+#else
+    (void) spawn;
+    f();
+#endif
+  }
+
+  //! Wait for all of the tasks started by Run().
+  void Wait()
+  {
+#ifdef _OPENMP
+    #pragma omp taskwait
+#endif
+  }
+
+ private:
+  //! A task group cannot be copied.
+  TaskGroup(const TaskGroup& other);
+  //! A task group cannot be copied.
+  TaskGroup& operator=(const TaskGroup& other);
+};
+
+/**
+ * Call f() in a parallel region, so that the tasks it starts with TaskGroup
+ * are run by a team of threads.  f() itself is called by one thread.  If we
+ * are already in a parallel region (or there is only one thread), f() is just
+ * called, and its tasks are run by the enclosing team, if there is one.
+ */
+template<typename FunctionType>
+void RunTasks(FunctionType f)
+{
+#ifdef _OPENMP
+  if (!InParallel() && Threads() > 1)
+  {
+    #pragma omp parallel
+    {
+      #pragma omp single
+      f();
+    }
+    return;
+  }
+#endif
+
+  f();
+}
+
+} // namespace parallel
+} // namespace mlpack
+
+#endif
@@ -15,6 +15,9 @@
 
 using namespace mlpack::util;
 
+thread_local const PrefixedOutStream* PrefixedOutStream::captured = NULL;
+thread_local std::ostream* PrefixedOutStream::captureTarget = NULL;
+
 /**
  * These are all necessary because gcc's template mechanism does not seem smart
  * enough to figure out what I want to pass into operator<< without these.  That
@@ -10,6 +10,7 @@
 
 #include <iostream>
 #include <iomanip>
+#include <sstream>
 #include <string>
 #include <streambuf>
 #include <stdexcept>
@@ -113,6 +114,13 @@ class PrefixedOutStream
   template<typename T>
   PrefixedOutStream& operator<<(const T& s);
 
+  /**
+   * Return whether or not anything written to the stream can have an effect
+   * (that is, whether the stream is not muted, or is fatal).  When this is
+   * false, output is discarded without being formatted.
+   */
+  bool Enabled() const { return !ignoreInput || fatal; }
+
   //! The output stream that all data is to be sent too; example: std::cout.
   std::ostream& destination;
 
@@ -120,6 +128,13 @@ class PrefixedOutStream
   bool ignoreInput;
 
  private:
+  friend class ScopedLogCapture;
+
+  //! The stream whose output the calling thread captures, if any.
+  static thread_local const PrefixedOutStream* captured;
+  //! Where the captured output of the calling thread goes.
+  static thread_local std::ostream* captureTarget;
+
   HAS_MEM_FUNC(ToString, HasToString)
 
   //! This handles forwarding all primitive types transparently.
@@ -177,6 +192,83 @@ class PrefixedOutStream
   bool fatal;
 };
 
+/**
+ * For as long as this object lives, whatever the calling thread writes to the
+ * given PrefixedOutStream goes to the given ostream instead, without prefixes.
+ * Other threads are not affected.  This lets each task of a parallel loop keep
+ * its own messages, so that they can be written in order after the loop.
+ *
+ * @code
+ * std::vector<std::ostringstream> warnings(tasks);
+ * #pragma omp parallel for
+ * for (size_t i = 0; i < tasks; ++i)
+ * {
+ *   util::ScopedLogCapture capture(Log::Warn, warnings[i]);
+ *   RunTask(i); // Its warnings go to warnings[i].
+ * }
+ * for (size_t i = 0; i < tasks; ++i)
+ *   Log::Warn << warnings[i].str();
+ * @endcode
+ */
+class ScopedLogCapture
+{
+ public:
+  //! Capture what the calling thread writes to the given stream.
+  ScopedLogCapture(const PrefixedOutStream& stream, std::ostream& target) :
+      previous(PrefixedOutStream::captured),
+      previousTarget(PrefixedOutStream::captureTarget)
+  {
+    PrefixedOutStream::captured = &stream;
+    PrefixedOutStream::captureTarget = &target;
+  }
+
+  //! Go back to the capture that was used before, if any.
+  ~ScopedLogCapture()
+  {
+    PrefixedOutStream::captured = previous;
+    PrefixedOutStream::captureTarget = previousTarget;
+  }
+
+ private:
+  //! The stream that was captured before.
+  const PrefixedOutStream* previous;
+  //! Where the output captured before went.
+  std::ostream* previousTarget;
+
+  // Scopes must be nested, so they cannot be copied.
+  ScopedLogCapture(const ScopedLogCapture& other);
+  ScopedLogCapture& operator=(const ScopedLogCapture& other);
+};
+
+/**
+ * Mute the given PrefixedOutStream for as long as this object lives, and then
+ * restore it, even if an exception is thrown.  This mutes the stream for every
+ * thread.
+ */
+class ScopedLogMute
+{
+ public:
+  //! Mute the given stream.
+  ScopedLogMute(PrefixedOutStream& stream) :
+      stream(stream), ignoring(stream.ignoreInput)
+  {
+    stream.ignoreInput = true;
+  }
+
+  //! Restore the stream to what it was before.
+  ~ScopedLogMute() { stream.ignoreInput = ignoring; }
+
+ private:
+  //! The muted stream.
+  PrefixedOutStream& stream;
+  //! Whether the stream was muted before.
+  bool ignoring;
+
+  // Scopes must be nested, so they cannot be copied.
+  ScopedLogMute(const ScopedLogMute& other);
+  ScopedLogMute& operator=(const ScopedLogMute& other);
+};
+
 }; // namespace util
 }; // namespace mlpack
 
@@ -18,7 +18,9 @@ namespace util {
 template<typename T>
 PrefixedOutStream& PrefixedOutStream::operator<<(const T& s)
 {
-  CallBaseLogic<T>(s);
+  // Don't call ToString() for a muted stream.
+  if (Enabled())
+    CallBaseLogic<T>(s);
   return *this;
 }
 
@@ -62,6 +64,25 @@ void PrefixedOutStream::CallBaseLogic(const T& s,
 template<typename T>
 void PrefixedOutStream::BaseLogic(const T& val)
 {
+  // Output to a muted stream is discarded, so don't bother formatting it.
+  if (!Enabled())
+    return;
+
+  // Output captured by this thread is kept as it is; the prefixes are added
+  // when it is written to the stream later.
+  if (captured == this)
+  {
+    *captureTarget << val;
+    if (fatal)
+    {
+      std::ostringstream convert;
+      convert << val;
+      if (convert.str().find('\n') != std::string::npos)
+        throw std::runtime_error("fatal error; see Log::Fatal output");
+    }
+    return;
+  }
+
   // We will use this to track whether or not we need to terminate at the end of
   // this call (only for streams which terminate after a newline).
   bool newlined = false;
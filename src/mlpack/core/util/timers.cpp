@@ -8,25 +8,123 @@
 #include "timers.hpp"
 #include "cli.hpp"
 #include "log.hpp"
+#include "memory.hpp"
 
+#include <algorithm>
 #include <map>
+#include <sstream>
 #include <string>
 
 using namespace mlpack;
 
-// On Windows machines, we need to define timersub.
-#ifdef _WIN32
-inline void timersub(const timeval* tvp, const timeval* uvp, timeval* vvp)
+namespace {
+
+//! Convert a time to microseconds.
+inline unsigned long long Microseconds(const timeval& t)
 {
-  vvp->tv_sec = tvp->tv_sec - uvp->tv_sec;
-  vvp->tv_usec = tvp->tv_usec - uvp->tv_usec;
-  if (vvp->tv_usec < 0)
+  return (unsigned long long) t.tv_sec * 1000000ULL +
+      (unsigned long long) t.tv_usec;
+}
+
+//! Convert a number of microseconds to a time.
+inline timeval ToTimeval(const unsigned long long microseconds)
+{
+  timeval t;
+  t.tv_sec = (long) (microseconds / 1000000ULL);
+  t.tv_usec = (long) (microseconds % 1000000ULL);
+  return t;
+}
+
+//! Write a string as a JSON string.
+void StringToJSON(std::ostream& stream, const std::string& str)
+{
+  stream << '"';
+  for (size_t i = 0; i < str.size(); ++i)
   {
-     --vvp->tv_sec;
-     vvp->tv_usec += 1000000;
+    if (str[i] == '"' || str[i] == '\\')
+      stream << '\\' << str[i];
+    else if ((unsigned char) str[i] < 0x20)
+      stream << "\\u00" << "0123456789abcdef"[str[i] >> 4]
+          << "0123456789abcdef"[str[i] & 0xF];
+    else
+      stream << str[i];
   }
+  stream << '"';
+}
+
+//! The totals of a timer in one place of the tree, over all of the threads.
+struct TimerSummary
+{
+  TimerSummary() :
+      time(0),
+      runs(0),
+      threads(0),
+      peakRSS(0),
+      peakGrowth(0),
+      allocations(0),
+      allocatedBytes(0)
+  { }
+
+  unsigned long long time;
+  size_t runs;
+  size_t threads;
+  size_t peakRSS;
+  size_t peakGrowth;
+  size_t allocations;
+  size_t allocatedBytes;
+};
+
+typedef std::map<std::vector<std::string>, TimerSummary> SummaryMap;
+
+//! Check whether the given path starts with the given prefix.
+bool StartsWith(const std::vector<std::string>& path,
+                const std::vector<std::string>& prefix)
+{
+  return (path.size() > prefix.size()) &&
+      std::equal(prefix.begin(), prefix.end(), path.begin());
 }
-#endif
+
+/**
+ * Write the list of the timers nested in the given parent, starting at it and
+ * leaving it past them.  The map is ordered depth-first, and holds each parent
+ * of each timer, so the timers nested in the parent are the ones right after
+ * it.
+ */
+void SummariesToJSON(std::ostream& stream,
+                     SummaryMap::const_iterator& it,
+                     const SummaryMap::const_iterator end,
+                     const std::vector<std::string>& parent,
+                     const std::string& indent,
+                     const bool memory)
+{
+  stream << "[";
+  bool first = true;
+  while (it != end && StartsWith(it->first, parent))
+  {
+    const std::vector<std::string>& path = it->first;
+    const TimerSummary& summary = it->second;
+    ++it;
+
+    stream << (first ? "\n" : ",\n") << indent << "  { \"name\": ";
+    StringToJSON(stream, path.back());
+    stream << ", \"microseconds\": " << summary.time << ", \"runs\": "
+        << summary.runs << ", \"threads\": " << summary.threads;
+    if (memory)
+    {
+      stream << ", \"peak_rss\": " << summary.peakRSS << ", \"peak_growth\": "
+          << summary.peakGrowth << ", \"allocations\": "
+          << summary.allocations << ", \"allocated_bytes\": "
+          << summary.allocatedBytes;
+    }
+    stream << ", \"children\": ";
+    SummariesToJSON(stream, it, end, path, indent + "  ", memory);
+    stream << " }";
+    first = false;
+  }
+  stream << (first ? "]" : "\n" + indent + "]");
+}
+
+} // anonymous namespace
 
 /**
  * Start the given timer.
@@ -52,19 +150,54 @@ timeval Timer::Get(const std::string& name)
   return CLI::GetSingleton().timer.GetTimer(name);
 }
 
-std::map<std::string, timeval>& Timers::GetAllTimers()
+Timers::Timers() : recordEvents(false), recordMemory(false)
+{
+  origin = Now();
+}
+
+std::map<std::string, timeval> Timers::GetAllTimers()
 {
+  std::lock_guard<std::mutex> guard(lock);
+
+  std::map<std::string, unsigned long long> totals;
+  std::map<std::thread::id, ThreadTimers>::const_iterator t;
+  for (t = threads.begin(); t != threads.end(); ++t)
+  {
+    std::map<std::vector<std::string>, TimerTotal>::const_iterator it;
+    for (it = t->second.totals.begin(); it != t->second.totals.end(); ++it)
+      totals[it->first.back()] += it->second.time;
+  }
+
+  std::map<std::string, timeval> timers;
+  std::map<std::string, unsigned long long>::const_iterator it;
+  for (it = totals.begin(); it != totals.end(); ++it)
+    timers[it->first] = ToTimeval(it->second);
+
   return timers;
 }
 
 timeval Timers::GetTimer(const std::string& timerName)
 {
-  return timers[timerName];
+  std::lock_guard<std::mutex> guard(lock);
+
+  // A timer cannot be nested in itself, so the total of each of its places in
+  // the tree is the total of the timer.
+  unsigned long long total = 0;
+  std::map<std::thread::id, ThreadTimers>::const_iterator t;
+  for (t = threads.begin(); t != threads.end(); ++t)
+  {
+    std::map<std::vector<std::string>, TimerTotal>::const_iterator it;
+    for (it = t->second.totals.begin(); it != t->second.totals.end(); ++it)
+      if (it->first.back() == timerName)
+        total += it->second.time;
+  }
+
+  return ToTimeval(total);
 }
 
 void Timers::PrintTimer(const std::string& timerName)
 {
-  timeval& t = timers[timerName];
+  const timeval t = GetTimer(timerName);
   Log::Info << t.tv_sec << "." << std::setw(6) << std::setfill('0')
       << t.tv_usec << "s";
 
@@ -203,36 +336,77 @@ void Timers::GetTime(timeval* tv)
 #endif
 }
 
-void Timers::StartTimer(const std::string& timerName)
+unsigned long long Timers::Now()
 {
-  if ((timerState[timerName] == 1) && (timerName != "total_time"))
-  {
-    std::ostringstream error;
-    error << "Timer::Start(): timer '" << timerName
-        << "' has already been started";
-    throw std::runtime_error(error.str());
-  }
-
-  timerState[timerName] = true;
-
   timeval tmp;
   tmp.tv_sec = 0;
   tmp.tv_usec = 0;
 
   GetTime(&tmp);
+  return Microseconds(tmp);
+}
+
+Timers::ThreadTimers& Timers::Local()
+{
+  const std::thread::id id = std::this_thread::get_id();
+  std::map<std::thread::id, ThreadTimers>::iterator it = threads.find(id);
+  if (it == threads.end())
+  {
+    if (threads.empty())
+      mainThread = id;
+
+    it = threads.insert(std::make_pair(id, ThreadTimers())).first;
+    it->second.index = threads.size() - 1;
+  }
+
+  return it->second;
+}
+
+void Timers::StartTimer(const std::string& timerName)
+{
+  const unsigned long long now = Now();
 
-  // Check to see if the timer already exists.  If it does, we'll subtract the
-  // old value.
-  if (timers.count(timerName) == 1)
+  std::lock_guard<std::mutex> guard(lock);
+  ThreadTimers& local = Local();
+
+  std::map<std::string, RunningTimer>::iterator it =
+      local.running.find(timerName);
+  if (it != local.running.end())
   {
-    timeval tmpDelta;
+    // The total_time timer may be started again, by each of the ways of
+    // parsing the options.
+    if (timerName == "total_time")
+    {
+      it->second.start = now;
+      return;
+    }
 
-    timersub(&tmp, &timers[timerName], &tmpDelta);
+    std::ostringstream error;
+    error << "Timer::Start(): timer '" << timerName
+        << "' has already been started";
+    throw std::runtime_error(error.str());
+  }
 
-    tmp = tmpDelta;
+  // Nest the timer in the innermost running timer of this thread or, if there
+  // is none, of the main thread.  The main thread may be running this timer
+  // too (as one of the threads of a parallel loop), so then the timer goes
+  // next to it instead of in it.
+  const ThreadTimers& parent = local.active.empty() ? threads[mainThread] :
+      local;
+  RunningTimer& timer = local.running[timerName];
+  timer.start = now;
+  timer.peakRSS = recordMemory ? Memory::PeakRSS() : 0;
+  timer.allocations = Memory::Allocations();
+  timer.allocatedBytes = Memory::AllocatedBytes();
+  if (!parent.active.empty())
+  {
+    timer.path = parent.running.find(parent.active.back())->second.path;
+    timer.path.erase(std::find(timer.path.begin(), timer.path.end(),
+        timerName), timer.path.end());
   }
+  timer.path.push_back(timerName);
 
-  timers[timerName] = tmp;
+  local.active.push_back(timerName);
 }
 
 #ifdef _WIN32
@@ -256,21 +430,151 @@ void Timers::FileTimeToTimeVal(timeval* tv)
 
 void Timers::StopTimer(const std::string& timerName)
 {
-  if ((timerState[timerName] == 0) && (timerName != "total_time"))
+  const unsigned long long now = Now();
+
+  std::lock_guard<std::mutex> guard(lock);
+  ThreadTimers& local = Local();
+
+  std::map<std::string, RunningTimer>::iterator it =
+      local.running.find(timerName);
+  if (it == local.running.end())
   {
+    // The total_time timer is stopped by CLI, whether or not it was started.
+    if (timerName == "total_time")
+      return;
+
     std::ostringstream error;
     error << "Timer::Stop(): timer '" << timerName
         << "' has already been stopped";
     throw std::runtime_error(error.str());
   }
 
-  timerState[timerName] = false;
+  const RunningTimer& timer = it->second;
+  const unsigned long long duration = (now > timer.start) ?
+      (now - timer.start) : 0;
+
+  TimerTotal& total = local.totals[timer.path];
+  total.time += duration;
+  ++total.runs;
+
+  if (recordMemory && timer.peakRSS != 0)
+  {
+    const size_t peak = Memory::PeakRSS();
+    total.peakRSS = std::max(total.peakRSS, peak);
+    total.peakGrowth = std::max(total.peakGrowth, peak - timer.peakRSS);
+    total.allocations += Memory::Allocations() - timer.allocations;
+    total.allocatedBytes += Memory::AllocatedBytes() - timer.allocatedBytes;
+  }
+
+  if (recordEvents)
+  {
+    TimerEvent event;
+    event.name = timerName;
+    event.thread = local.index;
+    event.start = (timer.start > origin) ? (timer.start - origin) : 0;
+    event.duration = duration;
+    events.push_back(event);
+  }
+
+  // Timers are usually stopped in the reverse of the order they were started
+  // in, but they don't have to be.
+  for (size_t i = local.active.size(); i > 0; --i)
+  {
+    if (local.active[i - 1] == timerName)
+    {
+      local.active.erase(local.active.begin() + (i - 1));
+      break;
+    }
+  }
+
+  local.running.erase(it);
+}
+
+void Timers::RecordEvents(const bool record)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  recordEvents = record;
+}
+
+void Timers::RecordMemory(const bool record)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  recordMemory = record;
+}
+
+void Timers::PrintMemory(const std::string& timerName)
+{
+  size_t peakRSS = 0, peakGrowth = 0, allocations = 0, allocatedBytes = 0;
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    std::map<std::thread::id, ThreadTimers>::const_iterator t;
+    for (t = threads.begin(); t != threads.end(); ++t)
+    {
+      std::map<std::vector<std::string>, TimerTotal>::const_iterator it;
+      for (it = t->second.totals.begin(); it != t->second.totals.end(); ++it)
+      {
+        if (it->first.back() != timerName)
+          continue;
+
+        peakRSS = std::max(peakRSS, it->second.peakRSS);
+        peakGrowth = std::max(peakGrowth, it->second.peakGrowth);
+        allocations += it->second.allocations;
+        allocatedBytes += it->second.allocatedBytes;
+      }
+    }
+  }
+
+  Log::Info << "peak RSS " << Memory::Format(peakRSS) << " (grew by "
+      << Memory::Format(peakGrowth) << ")";
+  if (Memory::Accounting())
+    Log::Info << ", " << allocations << " allocations ("
+        << Memory::Format(allocatedBytes) << ")";
+  Log::Info << std::endl;
+}
 
-  timeval delta, b, a = timers[timerName];
+void Timers::ToJSON(std::ostream& stream)
+{
+  std::lock_guard<std::mutex> guard(lock);
+
+  // Add up the totals of each place in the tree over all of the threads, and
+  // add each of the places a timer is nested in, so that the tree is whole even
+  // if some of them are still running.
+  SummaryMap summaries;
+  std::map<std::thread::id, ThreadTimers>::const_iterator t;
+  for (t = threads.begin(); t != threads.end(); ++t)
+  {
+    std::map<std::vector<std::string>, TimerTotal>::const_iterator it;
+    for (it = t->second.totals.begin(); it != t->second.totals.end(); ++it)
+    {
+      TimerSummary& summary = summaries[it->first];
+      summary.time += it->second.time;
+      summary.runs += it->second.runs;
+      ++summary.threads;
+      summary.peakRSS = std::max(summary.peakRSS, it->second.peakRSS);
+      summary.peakGrowth = std::max(summary.peakGrowth,
+          it->second.peakGrowth);
+      summary.allocations += it->second.allocations;
+      summary.allocatedBytes += it->second.allocatedBytes;
+
+      for (size_t i = 1; i < it->first.size(); ++i)
+        summaries[std::vector<std::string>(it->first.begin(),
+            it->first.begin() + i)];
+    }
+  }
 
-  GetTime(&b);
+  stream << "{\n  \"timers\": ";
+  SummaryMap::const_iterator it = summaries.begin();
+  SummariesToJSON(stream, it, summaries.end(), std::vector<std::string>(),
+      "  ", recordMemory);
 
-  // Calculate the delta time.
-  timersub(&b, &a, &delta);
-  timers[timerName] = delta;
+  stream << ",\n  \"displayTimeUnit\": \"ms\",\n  \"traceEvents\": [";
+  for (size_t i = 0; i < events.size(); ++i)
+  {
+    stream << ((i == 0) ? "\n" : ",\n") << "    { \"name\": ";
+    StringToJSON(stream, events[i].name);
+    stream << ", \"cat\": \"mlpack\", \"ph\": \"X\", \"pid\": 0, \"tid\": "
+        << events[i].thread << ", \"ts\": " << events[i].start
+        << ", \"dur\": " << events[i].duration << " }";
+  }
+  stream << ((events.size() > 0) ? "\n  ]" : "]") << "\n}\n";
 }
@@ -9,7 +9,12 @@
 #define __MLPACK_CORE_UTILITIES_TIMERS_HPP
 
 #include <map>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 
 #if defined(__unix__) || defined(__unix)
   #include <time.h>       // clock_gettime()
@@ -58,6 +63,16 @@ namespace mlpack {
  * The timer class provides a way for MLPACK methods to be timed.  The three
  * methods contained in this class allow a named timer to be started and
  * stopped, and its value to be obtained.
+ *
+ * Timers are thread-safe.  Each thread has its own set of running timers, so
+ * several threads may run the same timer at once (for instance, in a parallel
+ * loop); the value of a timer is its total over all of the threads.  A timer
+ * started while other timers are running on the thread is nested in the most
+ * recently started of them.  A timer started on a thread with no running
+ * timers (such as a worker thread of a parallel region) is nested in the
+ * running timers of the main thread, the first thread that used a timer.  The
+ * nesting is shown by the JSON export of the timers (see Timers::ToJSON(),
+ * and --timers_file for programs).
  */
 class Timer
 {
@@ -69,7 +84,7 @@ class Timer
    * run, and do not reset.
    *
    * @note A std::runtime_error exception will be thrown if a timer is started
-   * twice.
+   * twice on the same thread.
    *
    * @param name Name of timer to be started.
    */
@@ -78,31 +93,69 @@ class Timer
   /**
    * Stop the given timer.
    *
-   * @note A std::runtime_error exception will be thrown if a timer is started
-   * twice.
+   * @note A std::runtime_error exception will be thrown if the timer is not
+   * running on this thread.
    *
    * @param name Name of timer to be stopped.
    */
   static void Stop(const std::string& name);
 
   /**
-   * Get the value of the given timer.
+   * Get the value of the given timer: the total length of each of its
+   * completed runs, on every thread.
    *
    * @param name Name of timer to return value of.
    */
   static timeval Get(const std::string& name);
 };
 
+/**
+ * A timer that runs for the lifetime of the object, for timing a scope:
+ *
+ * @code
+ * {
+ *   ScopedTimer t("tree_building");
+ *   // ...
+ * } // The tree_building timer is stopped here, even if an exception is thrown.
+ * @endcode
+ *
+ * Scoped timers nest in the same way as Timer::Start() and Timer::Stop().
+ */
+class ScopedTimer
+{
+ public:
+  //! Start the given timer.
+  ScopedTimer(const std::string& name) : name(name) { Timer::Start(name); }
+
+  //! Stop the timer, unless it has already been stopped with Timer::Stop().
+  ~ScopedTimer()
+  {
+    try
+    {
+      Timer::Stop(name);
+    }
+    catch (std::runtime_error& /* e */)
+    {
+      // The timer was already stopped.
+    }
+  }
+
+ private:
+  //! The name of the timer.
+  std::string name;
+};
+
 class Timers
 {
  public:
-  //! Nothing to do for the constructor.
-  Timers() { }
+  //! Create an empty set of timers.
+  Timers();
 
   /**
-   * Returns a copy of all the timers used via this interface.
+   * Returns a copy of all the timers used via this interface (the total of
+   * each timer over all of the threads).
    */
-  std::map<std::string, timeval>& GetAllTimers();
+  std::map<std::string, timeval> GetAllTimers();
 
   /**
    * Returns a copy of the timer specified.
@@ -120,28 +173,149 @@ class Timers
   void PrintTimer(const std::string& timerName);
 
   /**
-   * Initializes a timer, available like a normal value specified on
-   * the command line.  Timers are of type timeval.  If a timer is started, then
+   * Initializes a timer, available like a normal value specified on
+   * the command line.  Timers are of type timeval.  If a timer is started, then
    * stopped, then re-started, then stopped, the final timer value will be the
    * length of both runs of the timer.
-   *
-   * @param timerName The name of the timer in question.
-   */
+   *
+   * @param timerName The name of the timer in question.
+   */
   void StartTimer(const std::string& timerName);
 
   /**
-   * Halts the timer, and replaces it's value with
-   * the delta time from it's start
-   *
-   * @param timerName The name of the timer in question.
-   */
+   * Halts the timer, and adds the time since it was started to its value on
+   * this thread.
+   *
+   * @param timerName The name of the timer in question.
+   */
   void StopTimer(const std::string& timerName);
 
+  /**
+   * Set whether each run of each timer is recorded (as an event of the trace,
+   * for ToJSON()), from now on.  By default, only the totals are kept.
+   */
+  void RecordEvents(const bool record);
+
+  /**
+   * Set whether the memory used during each timer is recorded (for
+   * PrintMemory() and ToJSON()), from now on.  This is the growth of the peak
+   * resident set size of the process during each of its runs and, when
+   * allocations are counted (see Memory::Accounting()), the number and size of
+   * the allocations made (by any thread) during them.
+   */
+  void RecordMemory(const bool record);
+
+  /**
+   * Prints the memory used during the specified timer: the largest peak
+   * resident set size at the end of one of its runs, the most the peak grew
+   * during one of its runs, and the allocations made during its runs.
+   *
+   * @param timerName The name of the timer in question.
+   */
+  void PrintMemory(const std::string& timerName);
+
+  /**
+   * Write the timers to the given stream as JSON.  The "timers" list holds the
+   * tree of nested timers; each node gives the total time of the timer in that
+   * place (in microseconds), its number of runs, the number of threads that ran
+   * it, and the timers nested in it.  The "traceEvents" list holds each run of
+   * each timer that was recorded (see RecordEvents()) in the Chrome trace event
+   * format, so the file can be opened with chrome://tracing or Perfetto.  Only
+   * completed runs are included.  If memory is recorded (see RecordMemory()),
+   * each node also gives the memory used during the timer, in bytes.
+   */
+  void ToJSON(std::ostream& stream);
+
  private:
-  //! A map of all the timers that are being tracked.
-  std::map<std::string, timeval> timers;
-  //! A map that contains whether or not each timer is currently running.
-  std::map<std::string, bool> timerState;
+  //! A timer that is running on a thread.
+  struct RunningTimer
+  {
+    //! The time it was started at (in microseconds).
+    unsigned long long start;
+    //! The names of the timers it is nested in, followed by its own name.
+    std::vector<std::string> path;
+    //! The peak resident set size when it was started (if memory is
+    //! recorded).
+    size_t peakRSS;
+    //! The number of allocations when it was started.
+    size_t allocations;
+    //! The number of bytes allocated when it was started.
+    size_t allocatedBytes;
+  };
+
+  //! The total of the runs of a timer in one place of the tree of timers.
+  struct TimerTotal
+  {
+    TimerTotal() :
+        time(0),
+        runs(0),
+        peakRSS(0),
+        peakGrowth(0),
+        allocations(0),
+        allocatedBytes(0)
+    { }
+
+    //! The total length of the runs (in microseconds).
+    unsigned long long time;
+    //! The number of runs.
+    size_t runs;
+    //! The largest peak resident set size at the end of a run.
+    size_t peakRSS;
+    //! The most the peak resident set size grew during a run.
+    size_t peakGrowth;
+    //! The number of allocations during the runs.
+    size_t allocations;
+    //! The number of bytes allocated during the runs.
+    size_t allocatedBytes;
+  };
+
+  //! A run of a timer, for the trace.
+  struct TimerEvent
+  {
+    //! The name of the timer.
+    std::string name;
+    //! The index of the thread that ran it.
+    size_t thread;
+    //! The time it was started at (in microseconds since the timers were
+    //! created).
+    unsigned long long start;
+    //! The length of the run (in microseconds).
+    unsigned long long duration;
+  };
+
+  //! The timers of one thread.
+  struct ThreadTimers
+  {
+    //! The index of the thread, in the order the threads first used a timer.
+    size_t index;
+    //! The running timers, by name.
+    std::map<std::string, RunningTimer> running;
+    //! The names of the running timers, in the order they were started.
+    std::vector<std::string> active;
+    //! The totals of the timers, by path.
+    std::map<std::vector<std::string>, TimerTotal> totals;
+  };
+
+  //! The timers of each thread.
+  std::map<std::thread::id, ThreadTimers> threads;
+  //! The main thread (the first thread that used a timer).
+  std::thread::id mainThread;
+  //! The recorded runs of the timers.
+  std::vector<TimerEvent> events;
+  //! Whether runs are recorded.
+  bool recordEvents;
+  //! Whether the memory used during runs is recorded.
+  bool recordMemory;
+  //! The time the timers were created at (in microseconds).
+  unsigned long long origin;
+  //! Protects all of the above.
+  std::mutex lock;
+
+  //! Get the timers of the calling thread; the lock must be held.
+  ThreadTimers& Local();
+
+  //! Get the current time, in microseconds.
+  unsigned long long Now();
 
   void FileTimeToTimeVal(timeval* tv);
   void GetTime(timeval* tv);
@@ -60,7 +60,11 @@ class AdaBoost
   double tolerance;
 
   /**
-   * Classification Function.
+   * Classification Function.  The test points are classified in blocks, in
+   * parallel if mlpack is compiled with OpenMP; the weak hypotheses are applied
+   * in order, and a point is not passed to the remaining ones once their total
+   * weight can no longer change its predicted class.
+   *
    * @param test Testing data.
    * @param predictedLabels Vector to store the predicted labels of the
    *                         test set.
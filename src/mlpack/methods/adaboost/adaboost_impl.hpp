@@ -59,13 +59,18 @@ AdaBoost<MatType, WeakLearner>::AdaBoost(
   // To be used for prediction by the Weak Learner for prediction.
   arma::Row<size_t> predictedLabels(labels.n_cols);
 
-  // Use tempData to modify input Data for incorporating weights.
-  MatType tempData(data);
-
   // This matrix is a helper matrix used to calculate the final hypothesis.
   arma::mat sumFinalH(predictedLabels.n_cols, numClasses);
   sumFinalH.fill(0.0);
 
+  // Every weak hypothesis adds alphat to the true class of each point and
+  // subtracts it from the other classes (whatever the hypothesis predicts), so
+  // the update of sumFinalH is alphat times this matrix.
+  arma::mat labelSigns(labels.n_cols, numClasses);
+  labelSigns.fill(-1.0);
+  for (size_t j = 0; j < labels.n_cols; j++)
+    labelSigns(j, labels(j)) = 1.0;
+
   // load the initial weights into a 2-D matrix
   const double initWeight = 1.0 / double(data.n_cols * numClasses);
   arma::mat D(data.n_cols, numClasses);
@@ -75,49 +80,31 @@ AdaBoost<MatType, WeakLearner>::AdaBoost(
   // for focussing on the perceptron weights.
   arma::rowvec weights(predictedLabels.n_cols);
 
+  // The sign (+1 if correctly classified, -1 otherwise) of each point in the
+  // current round.
+  arma::vec correct(predictedLabels.n_cols);
+
   // This is the final hypothesis.
   arma::Row<size_t> finalH(predictedLabels.n_cols);
 
   // now start the boosting rounds
   for (int i = 0; i < iterations; i++)
   {
-    // Initialized to zero in every round.
-    // rt is used for calculation of alphat, is the weighted error
-    // rt = (sum)D(i)y(i)ht(xi)
-    rt = 0.0;
-
-    // zt is used for weight normalization.
-    zt = 0.0;
-
     // Build the weight vectors
     BuildWeightMatrix(D, weights);
 
-    // call the other weak learner and train the labels.
-    WeakLearner w(other, tempData, labels, weights);
-    w.Classify(tempData, predictedLabels);
+    // call the other weak learner and train the labels.  The weak learner is
+    // trained on the data directly; there is no need to copy it.
+    WeakLearner w(other, data, labels, weights);
+    w.Classify(data, predictedLabels);
 
-    // Now from predictedLabels, build ht, the weak hypothesis
-    // buildClassificationMatrix(ht, predictedLabels);
+    // Now, start calculation of alpha(t) using ht.
+    for (size_t j = 0; j < correct.n_elem; j++)
+      correct(j) = (predictedLabels(j) == labels(j)) ? 1.0 : -1.0;
 
-    // Now, start calculation of alpha(t) using ht
-
-    for (size_t j = 0;j < D.n_rows; j++) // instead of D, ht
-    {
-      if (predictedLabels(j) == labels(j))
-      {
-        // for (int k = 0;k < numClasses; k++)
-        //   rt += D(j,k);
-        rt += arma::accu(D.row(j));
-      }
-
-      else
-      {
-        // for (int k = 0;k < numClasses; k++)
-        //   rt -= D(j,k);
-        rt -= arma::accu(D.row(j));
-      }
-    }
-    // end calculation of rt
+    // rt is used for calculation of alphat, is the weighted error
+    // rt = (sum)D(i)y(i)ht(xi)
+    rt = arma::dot(correct, weights.t());
 
     if (i > 0)
     {
@@ -134,42 +121,14 @@ AdaBoost<MatType, WeakLearner>::AdaBoost(
     alpha.push_back(alphat);
     wl.push_back(w);
 
-    // now start modifying weights
-    for (size_t j = 0;j < D.n_rows; j++)
-    {
-      double expo = exp(alphat);
-      if (predictedLabels(j) == labels(j))
-      {
-          for (size_t k = 0;k < D.n_cols; k++)
-          {
-            // we calculate zt, the normalization constant
-            zt += D(j,k) / expo; // * exp(-1 * alphat * yt(j,k) * ht(j,k));
-            D(j,k) = D(j,k) / expo;
-
-            // adding to the matrix of FinalHypothesis
-            // sumFinalH(j,k) += (alphat * ht(j,k));
-            if (k == labels(j))
-              sumFinalH(j,k) += (alphat);// * ht(j,k));
-            else
-              sumFinalH(j,k) -= (alphat);
-          }
-      }
-      else
-      {
-        for (size_t k = 0;k < D.n_cols; k++)
-          {
-            // we calculate zt, the normalization constant
-            zt += D(j,k) * expo;
-            D(j,k) = D(j,k) * expo;
-
-            // adding to the matrix of FinalHypothesis
-            if (k == labels(j))
-              sumFinalH(j,k) += (alphat);// * ht(j,k));
-            else
-              sumFinalH(j,k) -= (alphat);
-          }
-      }
-    }
+    // now modify the weights: the rows of correctly classified points are
+    // divided by exp(alphat), and the others are multiplied by it.  zt is the
+    // normalization constant.
+    D = arma::diagmat(arma::exp(-alphat * correct)) * D;
+    zt = arma::accu(D);
+
+    // adding to the matrix of FinalHypothesis
+    sumFinalH += alphat * labelSigns;
 
     // normalization of D
     D = D / zt;
@@ -205,28 +164,82 @@ void AdaBoost<MatType, WeakLearner>::Classify(
     const MatType& test,
     arma::Row<size_t>& predictedLabels)
 {
-  arma::Row<size_t> tempPredictedLabels(predictedLabels.n_cols);
-  arma::mat cMatrix(numClasses, test.n_cols);
+  predictedLabels.set_size(test.n_cols);
+
+  // Each weak hypothesis votes for the class it predicts, with weight
+  // alpha[i] times that class, so it can change the difference between the
+  // votes of two classes by at most |alpha[i]| * (numClasses - 1).  margins[i]
+  // bounds how much the hypotheses from i onwards can change it.
+  std::vector<double> margins(wl.size() + 1, 0.0);
+  for (size_t i = wl.size(); i > 0; i--)
+    margins[i - 1] = margins[i] + std::abs(alpha[i - 1]) * (numClasses - 1);
+
+  // The test points are classified in blocks, in parallel.  Within a block,
+  // the hypotheses are applied in order, and a point is no longer passed to
+  // the remaining hypotheses once its predicted class cannot change.
+  const size_t blockSize = 256;
+  const size_t numBlocks = (test.n_cols + blockSize - 1) / blockSize;
+
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t b = 0; b < numBlocks; b++)
+  {
+    const size_t begin = b * blockSize;
+    const size_t count = std::min(blockSize, (size_t) test.n_cols - begin);
 
-  cMatrix.zeros();
-  predictedLabels.zeros();
+    arma::mat cMatrix(numClasses, count);
+    cMatrix.zeros();
 
-  for (size_t i = 0;i < wl.size(); i++)
-  {
-    wl[i].Classify(test, tempPredictedLabels);
+    // The points of the block whose predicted class may still change.
+    std::vector<size_t> active(count);
+    for (size_t j = 0; j < count; j++)
+      active[j] = j;
 
-    for (size_t j = 0; j < tempPredictedLabels.n_cols; j++)
-      cMatrix(tempPredictedLabels(j), j) += (alpha[i] * tempPredictedLabels(j));
-  }
+    MatType points;
+    arma::Row<size_t> tempPredictedLabels;
+    for (size_t i = 0; i < wl.size() && !active.empty(); i++)
+    {
+      points.set_size(test.n_rows, active.size());
+      for (size_t j = 0; j < active.size(); j++)
+        points.col(j) = test.col(begin + active[j]);
 
-  arma::colvec cMRow;
-  arma::uword max_index;
+      tempPredictedLabels.set_size(active.size());
+      wl[i].Classify(points, tempPredictedLabels);
 
-  for (size_t i = 0; i < predictedLabels.n_cols; i++)
-  {
-    cMRow = cMatrix.col(i);
-    cMRow.max(max_index);
-    predictedLabels(i) = max_index;
+      std::vector<size_t> stillActive;
+      for (size_t j = 0; j < active.size(); j++)
+      {
+        const size_t label = tempPredictedLabels(j);
+        cMatrix(label, active[j]) += (alpha[i] * label);
+
+        // Find the lead of the best class over the second best.
+        double best = -DBL_MAX, second = -DBL_MAX;
+        for (size_t k = 0; k < numClasses; k++)
+        {
+          const double vote = cMatrix(k, active[j]);
+          if (vote > best)
+          {
+            second = best;
+            best = vote;
+          }
+          else if (vote > second)
+          {
+            second = vote;
+          }
+        }
+
+        if (best - second <= margins[i + 1])
+          stillActive.push_back(active[j]);
+      }
+
+      active.swap(stillActive);
+    }
+
+    arma::uword max_index;
+    for (size_t j = 0; j < count; j++)
+    {
+      cMatrix.unsafe_col(j).max(max_index);
+      predictedLabels(begin + j) = max_index;
+    }
   }
 }
 
@@ -244,14 +257,7 @@ void AdaBoost<MatType, WeakLearner>::BuildWeightMatrix(
     const arma::mat& D,
     arma::rowvec& weights)
 {
-  size_t i, j;
-  weights.fill(0.0);
-
-  for (i = 0; i < D.n_rows; i++)
-  {
-    for (j = 0; j < D.n_cols; j++)
-      weights(i) += D(i, j);
-  }
+  weights = arma::trans(arma::sum(D, 1));
 }
 
 } // namespace adaboost
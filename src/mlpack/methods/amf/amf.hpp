@@ -17,9 +17,11 @@
 
 #include <mlpack/methods/amf/update_rules/nmf_mult_dist.hpp>
 #include <mlpack/methods/amf/update_rules/nmf_als.hpp>
+#include <mlpack/methods/amf/update_rules/weighted_als.hpp>
 #include <mlpack/methods/amf/update_rules/svd_batch_learning.hpp>
 #include <mlpack/methods/amf/update_rules/svd_incomplete_incremental_learning.hpp>
 #include <mlpack/methods/amf/update_rules/svd_complete_incremental_learning.hpp>
+#include <mlpack/methods/amf/update_rules/svd_parallel_incremental_learning.hpp>
 
 #include <mlpack/methods/amf/init_rules/random_init.hpp>
 #include <mlpack/methods/amf/init_rules/random_acol_init.hpp>
@@ -137,6 +139,29 @@ typedef amf::AMF<amf::SimpleResidueTermination,
                  amf::RandomAcolInitialization<>,
                  amf::NMFALSUpdate> NMFALSFactorizer;
 
+/**
+ * WeightedALSFactorizer factorizes the given (sparse) matrix V into two
+ * matrices W and H by alternating least squares fitted to the observed entries
+ * of V only.
+ *
+ * @see WeightedALSUpdate
+ */
+typedef amf::AMF<amf::SimpleResidueTermination,
+                 amf::RandomInitialization,
+                 amf::WeightedALSUpdate> WeightedALSFactorizer;
+
+/**
+ * SparseSVDParallelIncrementalFactorizer factorizes the given sparse matrix V
+ * into two matrices W and H by incremental gradient descent, with the updates
+ * of disjoint blocks of ratings made in parallel.
+ *
+ * @see SVDParallelIncrementalLearning
+ */
+typedef amf::AMF<amf::SimpleResidueTermination,
+                 amf::RandomAcolInitialization<>,
+                 amf::SVDParallelIncrementalLearning>
+        SparseSVDParallelIncrementalFactorizer;
+
 //! Add simple typedefs
 #ifdef MLPACK_USE_CXX11
 
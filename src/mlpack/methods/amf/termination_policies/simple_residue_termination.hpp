@@ -62,11 +62,15 @@ class SimpleResidueTermination
    */
   bool IsConverged(arma::mat& W, arma::mat& H)
   {
-    // Calculate the norm and compute the residue, but do it by hand, so as to
-    // avoid calculating (W*H), which may be very large.
+    // Calculate the norm and compute the residue, but avoid calculating (W*H),
+    // which may be very large: the norm of column j of W*H is
+    // sqrt(h_j^T (W^T W) h_j), and W^T W is only r x r.
+    const arma::mat gram = arma::trans(W) * W;
+    const arma::mat gramH = gram * H;
     double norm = 0.0;
+    #pragma omp parallel for schedule(static) reduction(+:norm)
     for (size_t j = 0; j < H.n_cols; ++j)
-      norm += arma::norm(W * H.col(j), "fro");
+      norm += std::sqrt(std::max(arma::dot(H.col(j), gramH.col(j)), 0.0));
     residue = fabs(normOld - norm) / normOld;
 
     // Store the norm.
@@ -74,7 +78,8 @@ class SimpleResidueTermination
 
     // Increment iteration count
     iteration++;
-    Log::Info << "Iteration " << iteration << "; residue " << residue << ".\n";
+    MLPACK_LOG_INFO << "Iteration " << iteration << "; residue " << residue
+        << ".\n";
 
     // Check if termination criterion is met.
     return (residue < minResidue || iteration > maxIterations);
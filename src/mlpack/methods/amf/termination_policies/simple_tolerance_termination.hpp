@@ -63,36 +63,17 @@ class SimpleToleranceTermination
    */
   bool IsConverged(arma::mat& W, arma::mat& H)
   {
-    arma::mat WH;
-
-    WH = W * H;
-
     // compute residue
     residueOld = residue;
-    size_t n = V->n_rows;
-    size_t m = V->n_cols;
     double sum = 0;
     size_t count = 0;
-    for(size_t i = 0;i < n;i++)
-    {
-        for(size_t j = 0;j < m;j++)
-        {
-            double temp = 0;
-            if((temp = (*V)(i,j)) != 0)
-            {
-                temp = (temp - WH(i, j));
-                temp = temp * temp;
-                sum += temp;
-                count++;
-            }
-        }
-    }
+    SquaredError(*V, W, H, sum, count);
     residue = sum / count;
     residue = sqrt(residue);
 
     // increment iteration count
     iteration++;
-    Log::Info << "Iteration " << iteration << "; residue "
+    MLPACK_LOG_INFO << "Iteration " << iteration << "; residue "
         << ((residueOld - residue) / residueOld) << ".\n";
 
     // if residue tolerance is not satisfied
@@ -155,6 +136,71 @@ class SimpleToleranceTermination
   double& Tolerance() { return tolerance; }
 
  private:
+  /**
+   * Compute the sum of the squared errors of W * H on the nonzero entries of
+   * the dense matrix V, and count those entries.  W * H is computed in full,
+   * and scanned in the same (column-major) order as V.
+   */
+  static void SquaredError(const arma::mat& V,
+                           const arma::mat& W,
+                           const arma::mat& H,
+                           double& sum,
+                           size_t& count)
+  {
+    const arma::mat WH = W * H;
+    for (size_t j = 0; j < V.n_cols; ++j)
+    {
+      for (size_t i = 0; i < V.n_rows; ++i)
+      {
+        const double value = V(i, j);
+        if (value != 0)
+        {
+          const double error = value - WH(i, j);
+          sum += error * error;
+          ++count;
+        }
+      }
+    }
+  }
+
+  /**
+   * Compute the sum of the squared errors of W * H on the nonzero entries of
+   * the sparse matrix V, and count those entries.  Only the predictions of
+   * the nonzero entries are computed, so this takes O(nnz(V) r) time, and W * H
+   * (which may be much larger than V) is never formed.
+   */
+  static void SquaredError(const arma::sp_mat& V,
+                           const arma::mat& W,
+                           const arma::mat& H,
+                           double& sum,
+                           size_t& count)
+  {
+    // The rows of W are used as columns, so they are contiguous.
+    const arma::mat Wt = arma::trans(W);
+
+    double localSum = 0;
+    size_t localCount = 0;
+    #pragma omp parallel for schedule(static) \
+        reduction(+:localSum, localCount)
+    for (size_t j = 0; j < V.n_cols; ++j)
+    {
+      for (size_t k = V.col_ptrs[j]; k < V.col_ptrs[j + 1]; ++k)
+      {
+        const double value = V.values[k];
+        if (value != 0)
+        {
+          const double error = value - arma::dot(Wt.col(V.row_indices[k]),
+              H.col(j));
+          localSum += error * error;
+          ++localCount;
+        }
+      }
+    }
+
+    sum += localSum;
+    count += localCount;
+  }
+
   //! tolerance
   double tolerance;
   //! iteration threshold
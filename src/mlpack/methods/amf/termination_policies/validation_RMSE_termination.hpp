@@ -108,24 +108,26 @@ class ValidationRMSETermination
    */
   bool IsConverged(arma::mat& W, arma::mat& H)
   {
-    arma::mat WH;
-
-    WH = W * H;
-
-    // compute validation RMSE
+    // compute validation RMSE; only the predictions of the validation points
+    // are needed, so W * H is not formed (the rows of W are used as columns,
+    // so they are contiguous)
     if (iteration != 0)
     {
-      rmseOld = rmse;
-      rmse = 0;
+      const arma::mat Wt = arma::trans(W);
+      double sum = 0;
+      #pragma omp parallel for schedule(static) reduction(+:sum)
       for(size_t i = 0; i < num_test_points; i++)
       {
-        size_t t_row = test_points(i, 0);
-        size_t t_col = test_points(i, 1);
-        double t_val = test_points(i, 2);
-        double temp = (t_val - WH(t_row, t_col));
+        const size_t t_row = (size_t) test_points(i, 0);
+        const size_t t_col = (size_t) test_points(i, 1);
+        const double t_val = test_points(i, 2);
+        double temp = (t_val - arma::dot(Wt.col(t_row), H.col(t_col)));
         temp *= temp;
-        rmse += temp;
+        sum += temp;
       }
+
+      rmseOld = rmse;
+      rmse = sum;
       rmse /= num_test_points;
       rmse = sqrt(rmse);
     }
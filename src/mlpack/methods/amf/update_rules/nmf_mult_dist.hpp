@@ -30,6 +30,12 @@ namespace amf {
  * This is a multiplicative rule that ensures that the Frobenius norm
  * \f$ \sqrt{\sum_i \sum_j(V-WH)^2} \f$ is non-increasing between subsequent
  * iterations. Both of the update rules for W and H are defined in this file.
+ *
+ * For a sparse V, the same rules are evaluated without any dense matrix of the
+ * size of V: V H^T and W^T V are computed from the nonzero entries of V only,
+ * with OpenMP if it is available, and the denominators are computed as
+ * W (H H^T) and (W^T W) H.  To compute V H^T with one pass over the rows of V,
+ * Initialize() stores a transposed copy of a sparse V.
  */
 class NMFMultiplicativeDistanceUpdate
 {
@@ -47,6 +53,17 @@ class NMFMultiplicativeDistanceUpdate
     // Nothing to do.
   }
 
+  /**
+   * Initialize the factorization of a sparse matrix, by storing its transpose.
+   *
+   * @param dataset Input matrix to be factorized.
+   * @param rank Rank of factorization (not used).
+   */
+  void Initialize(const arma::sp_mat& dataset, const size_t /* rank */)
+  {
+    transposed = dataset.t();
+  }
+
   /**
    * The update rule for the basis matrix W. The formula used isa
    *
@@ -69,6 +86,25 @@ class NMFMultiplicativeDistanceUpdate
     W = (W % (V * H.t())) / (W * H * H.t());
   }
 
+  /**
+   * The update rule for the basis matrix W, for a sparse input matrix.  This is
+   * the same rule as above, but only the nonzero entries of V are used.
+   *
+   * @param V Input matrix to be factorized (not used; Initialize() stores its
+   *      transpose).
+   * @param W Basis matrix to be updated.
+   * @param H Encoding matrix.
+   */
+  inline void WUpdate(const arma::sp_mat& /* V */,
+                      arma::mat& W,
+                      const arma::mat& H) const
+  {
+    // Column i of H V^T is (V H^T)^T for row i of V.
+    arma::mat numerator;
+    SparseProduct(H, transposed, numerator);
+    W = (W % trans(numerator)) / (W * (H * trans(H)));
+  }
+
   /**
    * The update rule for the encoding matrix H. The formula used is
    *
@@ -91,9 +127,58 @@ class NMFMultiplicativeDistanceUpdate
     H = (H % (W.t() * V)) / (W.t() * W * H);
   }
 
+  /**
+   * The update rule for the encoding matrix H, for a sparse input matrix.  This
+   * is the same rule as above, but only the nonzero entries of V are used.
+   *
+   * @param V Input matrix to be factorized.
+   * @param W Basis matrix.
+   * @param H Encoding matrix to be updated.
+   */
+  inline void HUpdate(const arma::sp_mat& V,
+                      const arma::mat& W,
+                      arma::mat& H) const
+  {
+    arma::mat numerator;
+    SparseProduct(trans(W), V, numerator);
+    H = (H % numerator) / ((trans(W) * W) * H);
+  }
+
   //! Serialize the object (in this case, there is nothing to serialize).
   template<typename Archive>
   void Serialize(Archive& /* ar */, const unsigned int /* version */) { }
+
+ private:
+  /**
+   * Compute the product A S of a dense and a sparse matrix, one column of the
+   * result at a time (in parallel, if OpenMP is available).
+   *
+   * @param a Dense matrix.
+   * @param s Sparse matrix.
+   * @param output Matrix to store the product in.
+   */
+  static void SparseProduct(const arma::mat& a,
+                            const arma::sp_mat& s,
+                            arma::mat& output)
+  {
+    output.zeros(a.n_rows, s.n_cols);
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t j = 0; j < s.n_cols; ++j)
+    {
+      double* out = output.colptr(j);
+      for (size_t k = s.col_ptrs[j]; k < s.col_ptrs[j + 1]; ++k)
+      {
+        const double* in = a.colptr(s.row_indices[k]);
+        const double value = s.values[k];
+        for (size_t i = 0; i < a.n_rows; ++i)
+          out[i] += value * in[i];
+      }
+    }
+  }
+
+  //! The transpose of a sparse input matrix, stored by Initialize().
+  arma::sp_mat transposed;
 };
 
 } // namespace amf
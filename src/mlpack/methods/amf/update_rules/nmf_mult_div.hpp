@@ -36,9 +36,15 @@ namespace amf {
  * is non-increasing between subsequent iterations. Both of the update rules
  * for W and H are defined in this file.
  *
- * This set of update rules is not meant to work with sparse matrices.  Using
- * sparse matrices often causes NaNs in the output, so other choices of update
- * rules are better in that situation.
+ * For a sparse V, V / (W H) is only needed at the nonzero entries of V, since
+ * the other entries contribute nothing to the numerators; the denominators are
+ * sums of the rows of H and the columns of W.  So in that case (W H) is only
+ * evaluated at the nonzero entries, and no dense matrix of the size of V is
+ * ever formed; the rows of W and the columns of H are updated in parallel if
+ * OpenMP is available.  To visit the rows of V quickly, Initialize() stores a
+ * transposed copy of a sparse V.  This also avoids the NaNs that the dense
+ * rules give when (W H) is zero where V is zero, but a NaN is still produced
+ * if (W H) is zero at a nonzero entry of V.
  */
 class NMFMultiplicativeDivergenceUpdate
 {
@@ -56,6 +62,17 @@ class NMFMultiplicativeDivergenceUpdate
     // Nothing to do.
   }
 
+  /**
+   * Initialize the factorization of a sparse matrix, by storing its transpose.
+   *
+   * @param dataset Input matrix to be factorized.
+   * @param rank Rank of factorization (not used).
+   */
+  void Initialize(const arma::sp_mat& dataset, const size_t /* rank */)
+  {
+    transposed = dataset.t();
+  }
+
   /**
    * The update rule for the basis matrix W. The formula used is
    *
@@ -100,6 +117,48 @@ class NMFMultiplicativeDivergenceUpdate
     }
   }
 
+  /**
+   * The update rule for the basis matrix W, for a sparse input matrix.  This is
+   * the same rule as above, but (W H) is only evaluated at the nonzero entries
+   * of V.
+   *
+   * @param V Input matrix to be factorized (not used; Initialize() stores its
+   *      transpose).
+   * @param W Basis matrix to be updated.
+   * @param H Encoding matrix.
+   */
+  inline void WUpdate(const arma::sp_mat& /* V */,
+                      arma::mat& W,
+                      const arma::mat& H) const
+  {
+    const size_t r = H.n_rows;
+    const arma::vec hSums = arma::sum(H, 1);
+
+    // Column i of the transpose of W is row i of W, and column i of the
+    // transpose of V holds the nonzero entries of row i of V.
+    arma::mat wt = trans(W);
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t i = 0; i < transposed.n_cols; ++i)
+    {
+      arma::vec numerator(r);
+      numerator.zeros();
+
+      const arma::vec w(wt.colptr(i), r, false, true);
+      for (size_t k = transposed.col_ptrs[i]; k < transposed.col_ptrs[i + 1];
+           ++k)
+      {
+        const arma::vec h(const_cast<double*>(H.colptr(
+            transposed.row_indices[k])), r, false, true);
+        numerator += (transposed.values[k] / arma::dot(w, h)) * h;
+      }
+
+      wt.col(i) = wt.col(i) % numerator / hSums;
+    }
+
+    W = trans(wt);
+  }
+
   /**
    * The update rule for the encoding matrix H. The formula used is
    *
@@ -144,9 +203,50 @@ class NMFMultiplicativeDivergenceUpdate
     }
   }
 
+  /**
+   * The update rule for the encoding matrix H, for a sparse input matrix.  This
+   * is the same rule as above, but (W H) is only evaluated at the nonzero
+   * entries of V.
+   *
+   * @param V Input matrix to be factorized.
+   * @param W Basis matrix.
+   * @param H Encoding matrix to be updated.
+   */
+  inline void HUpdate(const arma::sp_mat& V,
+                      const arma::mat& W,
+                      arma::mat& H) const
+  {
+    const size_t r = W.n_cols;
+    const arma::vec wSums = trans(arma::sum(W, 0));
+
+    // Column i of the transpose of W is row i of W.
+    const arma::mat wt = trans(W);
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t j = 0; j < V.n_cols; ++j)
+    {
+      arma::vec numerator(r);
+      numerator.zeros();
+
+      const arma::vec h(H.colptr(j), r, false, true);
+      for (size_t k = V.col_ptrs[j]; k < V.col_ptrs[j + 1]; ++k)
+      {
+        const arma::vec w(const_cast<double*>(wt.colptr(V.row_indices[k])),
+            r, false, true);
+        numerator += (V.values[k] / arma::dot(w, h)) * w;
+      }
+
+      H.col(j) = H.col(j) % numerator / wSums;
+    }
+  }
+
   //! Serialize the object (in this case, there is nothing to serialize).
   template<typename Archive>
   void Serialize(Archive& /* ar */, const unsigned int /* version */) { }
+
+ private:
+  //! The transpose of a sparse input matrix, stored by Initialize().
+  arma::sp_mat transposed;
 };
 
 } // namespace amf
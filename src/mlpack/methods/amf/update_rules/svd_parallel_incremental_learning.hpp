@@ -0,0 +1,254 @@
+/**
+ * @file svd_parallel_incremental_learning.hpp
+ * @author Ryan Curtin
+ *
+ * Parallel (stratified) version of the SVD incremental learning rules used in
+ * AMF (Alternating Matrix Factorization).
+ */
+#ifndef __MLPACK_METHODS_AMF_SVD_PARALLEL_INCREMENTAL_LEARNING_HPP
+#define __MLPACK_METHODS_AMF_SVD_PARALLEL_INCREMENTAL_LEARNING_HPP
+
+#include <mlpack/core.hpp>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace amf {
+
+/**
+ * This class is a parallel version of SVDCompleteIncrementalLearning and
+ * SVDIncompleteIncrementalLearning for sparse matrices.  Each incremental
+ * update only touches one row of W and one column of H, so updates for
+ * ratings in different rows and columns can be made at the same time.  The
+ * nonzero entries of V are split into a grid of numStrata x numStrata blocks,
+ * by item and by user; one sweep over V is made of numStrata sub-epochs, and in
+ * sub-epoch s the blocks (b, (b + s) % numStrata) are processed in parallel.
+ * These blocks share no rows and no columns, so no locking is needed, and for
+ * a given number of strata the result does not depend on the number of
+ * threads.  This is the stratified SGD of the following paper:
+ *
+ * @code
+ * @inproceedings{gemulla2011large,
+ *   title={Large-scale matrix factorization with distributed stochastic
+ *       gradient descent},
+ *   author={Gemulla, R. and Nijkamp, E. and Haas, P.J. and Sismanis, Y.},
+ *   booktitle={Proceedings of the 17th ACM SIGKDD International Conference on
+ *       Knowledge Discovery and Data Mining},
+ *   pages={69--77},
+ *   year={2011}
+ * }
+ * @endcode
+ *
+ * With complete updates, W and H are updated after each rating, as in
+ * SVDCompleteIncrementalLearning.  Otherwise, the ratings of each user within
+ * a block are handled together, as in SVDIncompleteIncrementalLearning: the W
+ * rows of the items are updated first, and then the H column of the user.
+ *
+ * One WUpdate() and HUpdate() pair makes a full sweep over V (WUpdate() makes
+ * the sweep, and HUpdate() stores the new H), so this rule is used with the
+ * usual termination policies (such as SimpleResidueTermination or
+ * SimpleToleranceTermination), and not with the incremental termination
+ * wrappers.
+ */
+class SVDParallelIncrementalLearning
+{
+ public:
+  /**
+   * Initialize the parameters of SVDParallelIncrementalLearning.
+   *
+   * @param u Step value used in learning.
+   * @param kw Regularization constant for W matrix.
+   * @param kh Regularization constant for H matrix.
+   * @param complete If true, W and H are updated after each rating; otherwise,
+   *      after the ratings of each user in a block.
+   * @param strata Number of blocks of items and of users (0 means the maximum
+   *      number of OpenMP threads).
+   */
+  SVDParallelIncrementalLearning(const double u = 0.001,
+                                 const double kw = 0,
+                                 const double kh = 0,
+                                 const bool complete = true,
+                                 const size_t strata = 0) :
+      u(u), kw(kw), kh(kh), complete(complete), strata(strata), numStrata(0)
+  {
+    // Nothing to do.
+  }
+
+  /**
+   * Initialize parameters before factorization.  This splits the nonzero
+   * entries of the dataset into the blocks of the grid.
+   *
+   * @param dataset Input matrix to be factorized.
+   * @param rank rank of factorization
+   */
+  template<typename MatType>
+  void Initialize(const MatType& dataset, const size_t /* rank */)
+  {
+    const arma::sp_mat data(dataset);
+
+#ifdef _OPENMP
+    numStrata = (strata == 0) ? (size_t) omp_get_max_threads() : strata;
+#else
+    numStrata = (strata == 0) ? 1 : strata;
+#endif
+    numStrata = std::max((size_t) 1, std::min(numStrata,
+        (size_t) std::min(data.n_rows, data.n_cols)));
+
+    // Within each block, the entries are in order of users.
+    blocks.clear();
+    blocks.resize(numStrata * numStrata);
+    for (size_t j = 0; j < data.n_cols; ++j)
+    {
+      const size_t userBlock = (j * numStrata) / data.n_cols;
+      for (size_t k = data.col_ptrs[j]; k < data.col_ptrs[j + 1]; ++k)
+      {
+        const size_t i = data.row_indices[k];
+        const size_t itemBlock = (i * numStrata) / data.n_rows;
+        blocks[itemBlock * numStrata + userBlock].push_back(
+            Entry(i, j, data.values[k]));
+      }
+    }
+  }
+
+  /**
+   * Make a full sweep over the input matrix, updating W and a copy of H (which
+   * is stored by HUpdate()).
+   *
+   * @param V Input matrix to be factorized (not used; Initialize() splits it).
+   * @param W Basis matrix to be updated.
+   * @param H Encoding matrix.
+   */
+  template<typename MatType>
+  inline void WUpdate(const MatType& /* V */,
+                      arma::mat& W,
+                      const arma::mat& H)
+  {
+    updatedH = H;
+
+    for (size_t s = 0; s < numStrata; ++s)
+    {
+      #pragma omp parallel for schedule(dynamic, 1)
+      for (size_t b = 0; b < numStrata; ++b)
+      {
+        const std::vector<Entry>& block =
+            blocks[b * numStrata + (b + s) % numStrata];
+        if (complete)
+          CompleteSweep(block, W, updatedH);
+        else
+          IncompleteSweep(block, W, updatedH);
+      }
+    }
+  }
+
+  /**
+   * Store the H matrix computed by the last sweep.
+   *
+   * @param V Input matrix to be factorized.
+   * @param W Basis matrix.
+   * @param H Encoding matrix to be updated.
+   */
+  template<typename MatType>
+  inline void HUpdate(const MatType& /* V */,
+                      const arma::mat& /* W */,
+                      arma::mat& H)
+  {
+    H = updatedH;
+  }
+
+  //! Get the number of blocks of items and of users used by the last
+  //! Initialize().
+  size_t NumStrata() const { return numStrata; }
+
+ private:
+  //! A nonzero entry of the input matrix.
+  struct Entry
+  {
+    Entry(const size_t item, const size_t user, const double value) :
+        item(item), user(user), value(value) { }
+
+    size_t item;
+    size_t user;
+    double value;
+  };
+
+  //! Update W and H after each rating of the block.
+  void CompleteSweep(const std::vector<Entry>& block,
+                     arma::mat& W,
+                     arma::mat& H) const
+  {
+    for (size_t k = 0; k < block.size(); ++k)
+    {
+      const Entry& e = block[k];
+      const double error = e.value - arma::dot(W.row(e.item), H.col(e.user));
+
+      const arma::rowvec w = W.row(e.item);
+      const arma::vec h = H.col(e.user);
+      W.row(e.item) += u * (error * trans(h) - kw * w);
+      H.col(e.user) += u * (error * trans(w) - kh * h);
+    }
+  }
+
+  //! Update W and H after the ratings of each user of the block.
+  void IncompleteSweep(const std::vector<Entry>& block,
+                       arma::mat& W,
+                       arma::mat& H) const
+  {
+    size_t begin = 0;
+    while (begin < block.size())
+    {
+      const size_t user = block[begin].user;
+      size_t end = begin;
+      while (end < block.size() && block[end].user == user)
+        ++end;
+
+      // First update the W rows of the items the user rated.
+      for (size_t k = begin; k < end; ++k)
+      {
+        const Entry& e = block[k];
+        const double error = e.value - arma::dot(W.row(e.item), H.col(user));
+        const arma::rowvec w = W.row(e.item);
+        W.row(e.item) += u * (error * trans(H.col(user)) - kw * w);
+      }
+
+      // Then update the H column of the user.
+      arma::vec deltaH(H.n_rows);
+      deltaH.zeros();
+      for (size_t k = begin; k < end; ++k)
+      {
+        const Entry& e = block[k];
+        deltaH += (e.value - arma::dot(W.row(e.item), H.col(user))) *
+            trans(W.row(e.item));
+      }
+      deltaH -= kh * H.col(user);
+      H.col(user) += u * deltaH;
+
+      begin = end;
+    }
+  }
+
+  //! Step size of learning.
+  double u;
+  //! Regularization parameter for W matrix.
+  double kw;
+  //! Regularization parameter for H matrix.
+  double kh;
+  //! If true, W and H are updated after each rating.
+  bool complete;
+  //! The requested number of blocks of items and of users (0 for the number
+  //! of threads).
+  size_t strata;
+
+  //! The number of blocks of items and of users.
+  size_t numStrata;
+  //! The nonzero entries of each block of the grid (row-major by item block).
+  std::vector<std::vector<Entry> > blocks;
+  //! The H matrix being updated by the current sweep.
+  arma::mat updatedH;
+}; // class SVDParallelIncrementalLearning
+
+} // namespace amf
+} // namespace mlpack
+
+#endif
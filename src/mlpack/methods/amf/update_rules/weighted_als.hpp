@@ -0,0 +1,190 @@
+/**
+ * @file weighted_als.hpp
+ * @author Ryan Curtin
+ *
+ * Weighted alternating least squares update rule for AMF, which only uses the
+ * observed entries of the matrix.
+ */
+#ifndef __MLPACK_METHODS_AMF_UPDATE_RULES_WEIGHTED_ALS_HPP
+#define __MLPACK_METHODS_AMF_UPDATE_RULES_WEIGHTED_ALS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace amf {
+
+/**
+ * This class implements alternating least squares with weighted-lambda
+ * regularization (ALS-WR), as described in the following paper:
+ *
+ * @code
+ * @inproceedings{zhou2008large,
+ *   title={Large-scale parallel collaborative filtering for the Netflix
+ *       prize},
+ *   author={Zhou, Y. and Wilkinson, D. and Schreiber, R. and Pan, R.},
+ *   booktitle={Algorithmic Aspects in Information and Management},
+ *   pages={337--348},
+ *   year={2008}
+ * }
+ * @endcode
+ *
+ * Unlike NMFALSUpdate, only the nonzero (observed) entries of V are fitted;
+ * the zero entries are taken to be missing.  Row i of W is the solution of the
+ * small r x r system
+ *
+ * \f[
+ * (H_{\Omega_i} H_{\Omega_i}^T + \lambda n_i I) w_i = H_{\Omega_i} v_i
+ * \f]
+ *
+ * where \f$ \Omega_i \f$ is the set of observed entries in row i of V and
+ * \f$ n_i = |\Omega_i| \f$, and the columns of H are updated in the same way.
+ * The cost of an iteration is linear in the number of observed entries, and no
+ * dense n x m product is ever formed, so this is the update rule to use for
+ * large sparse rating matrices.  If mlpack is compiled with OpenMP, the rows of
+ * W (and the columns of H) are solved in parallel.
+ *
+ * The rule keeps a sparse copy of V and of its transpose (for fast access to
+ * the rows of V), which are built by Initialize().  Rows and columns of V
+ * without any observed entries are set to zero.
+ */
+class WeightedALSUpdate
+{
+ public:
+  /**
+   * Create the weighted ALS update rule with the given regularization
+   * parameter.
+   *
+   * @param lambda Regularization parameter; it is scaled by the number of
+   *      observed entries in each row and column.  Must be positive.
+   */
+  WeightedALSUpdate(const double lambda = 0.01) : lambda(lambda)
+  {
+    if (lambda <= 0.0)
+    {
+      std::ostringstream oss;
+      oss << "WeightedALSUpdate::WeightedALSUpdate(): lambda (" << lambda
+          << ") must be positive";
+      throw std::invalid_argument(oss.str());
+    }
+  }
+
+  /**
+   * Store the observed entries of the matrix to be factorized.
+   *
+   * @param dataset Input matrix to be factorized.
+   * @param rank Rank of factorization (not used).
+   */
+  template<typename MatType>
+  void Initialize(const MatType& dataset, const size_t /* rank */)
+  {
+    observations = arma::sp_mat(dataset);
+    observationsT = observations.t();
+  }
+
+  /**
+   * The update rule for the basis matrix W.  Each row of W is solved for using
+   * only the observed entries of the corresponding row of V.
+   *
+   * @param V Input matrix to be factorized (not used; Initialize() stores it).
+   * @param W Basis matrix to be updated.
+   * @param H Encoding matrix.
+   */
+  template<typename MatType>
+  inline void WUpdate(const MatType& /* V */,
+                      arma::mat& W,
+                      const arma::mat& H)
+  {
+    // Column i of the transpose holds the observed entries of row i of V.
+    arma::mat newW(W.n_cols, W.n_rows);
+    Solve(observationsT, H, newW);
+    W = trans(newW);
+  }
+
+  /**
+   * The update rule for the encoding matrix H.  Each column of H is solved for
+   * using only the observed entries of the corresponding column of V.
+   *
+   * @param V Input matrix to be factorized (not used; Initialize() stores it).
+   * @param W Basis matrix.
+   * @param H Encoding matrix to be updated.
+   */
+  template<typename MatType>
+  inline void HUpdate(const MatType& /* V */,
+                      const arma::mat& W,
+                      arma::mat& H)
+  {
+    const arma::mat factors = trans(W);
+    Solve(observations, factors, H);
+  }
+
+  //! Get the regularization parameter.
+  double Lambda() const { return lambda; }
+  //! Modify the regularization parameter.
+  double& Lambda() { return lambda; }
+
+  //! Serialize the object.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(lambda, "lambda");
+  }
+
+ private:
+  /**
+   * Solve for each column of the output, using the observed entries in the
+   * same column of the given matrix and the factors (one factor per column)
+   * they belong to.
+   *
+   * @param observed Observed entries; column j is used for output column j.
+   * @param factors Fixed factors, one column for each row of observed.
+   * @param output Matrix to store the solutions in.
+   */
+  void Solve(const arma::sp_mat& observed,
+             const arma::mat& factors,
+             arma::mat& output) const
+  {
+    const size_t r = factors.n_rows;
+    output.set_size(r, observed.n_cols);
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t j = 0; j < observed.n_cols; ++j)
+    {
+      const size_t begin = observed.col_ptrs[j];
+      const size_t end = observed.col_ptrs[j + 1];
+      if (begin == end)
+      {
+        output.col(j).zeros();
+        continue;
+      }
+
+      arma::mat a(r, r);
+      a.eye();
+      a *= lambda * (end - begin);
+      arma::vec b(r);
+      b.zeros();
+      for (size_t k = begin; k < end; ++k)
+      {
+        const arma::vec f(const_cast<double*>(factors.colptr(
+            observed.row_indices[k])), r, false, true);
+        a += f * trans(f);
+        b += observed.values[k] * f;
+      }
+
+      arma::vec x;
+      arma::solve(x, a, b);
+      output.col(j) = x;
+    }
+  }
+
+  //! Regularization parameter.
+  double lambda;
+  //! The observed entries of the matrix.
+  arma::sp_mat observations;
+  //! The observed entries of the transpose of the matrix.
+  arma::sp_mat observationsT;
+}; // class WeightedALSUpdate
+
+} // namespace amf
+} // namespace mlpack
+
+#endif
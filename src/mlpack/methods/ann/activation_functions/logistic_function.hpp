@@ -8,6 +8,7 @@
 #define __MLPACK_METHODS_ANN_ACTIVATION_FUNCTIONS_LOGISTIC_FUNCTION_HPP
 
 #include <mlpack/core.hpp>
+#include "math_policies.hpp"
 
 namespace mlpack {
 namespace ann /** Artificial Neural Network. */ {
@@ -20,8 +21,15 @@ namespace ann /** Artificial Neural Network. */ {
  * f'(x) &=& f(x) * (1 - f(x)) \\
  * f^{-1}(y) &=& ln(\frac{y}{1-y})
  * @f}
+ *
+ * The derivative is computed from the output of the function, so that nothing
+ * is evaluated again in the backward pass.
+ *
+ * @tparam MathPolicy Policy used to evaluate the exponential (ExactMath or
+ *     FastMath).
  */
-class LogisticFunction
+template<typename MathPolicy = ExactMath>
+class LogisticFunctionType
 {
   public:
   /**
@@ -33,19 +41,13 @@ class LogisticFunction
   template<typename eT>
   static double fn(const eT x)
   {
-    if(x < arma::Math<eT>::log_max())
-    {
-      if (x > -arma::Math<eT>::log_max())
-        return 1.0 /  (1.0 + std::exp(-x));
-
-      return 0.0;
-    }
-
-    return 1.0;
+    // If e^{-x} overflows, the result is still 0.
+    return 1.0 / (1.0 + MathPolicy::Exp(-x));
   }
 
   /**
-   * Computes the logistic function.
+   * Computes the logistic function.  The loop has no branches, so it is
+   * vectorized by the compiler with the FastMath policy.
    *
    * @param x Input data.
    * @param y The resulting output activation.
@@ -55,8 +57,9 @@ class LogisticFunction
   {
     y = x;
 
-    for (size_t i = 0; i < x.n_elem; i++)
-      y(i) = fn(x(i));
+    typename OutputVecType::elem_type* values = y.memptr();
+    for (size_t i = 0; i < y.n_elem; i++)
+      values[i] = fn(values[i]);
   }
 
   /**
@@ -104,7 +107,14 @@ class LogisticFunction
   {
     x = arma::trunc_log(y / (1 - y));
   }
-}; // class LogisticFunction
+}; // class LogisticFunctionType
+
+//! The logistic function, evaluated with the standard library.
+typedef LogisticFunctionType<ExactMath> LogisticFunction;
+
+//! The logistic function, evaluated with a fast approximation of the
+//! exponential (see FastMath).
+typedef LogisticFunctionType<FastMath> FastLogisticFunction;
 
 }; // namespace ann
 }; // namespace mlpack
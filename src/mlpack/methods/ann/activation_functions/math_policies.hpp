@@ -0,0 +1,86 @@
+/**
+ * @file math_policies.hpp
+ * @author Ryan Curtin
+ *
+ * Policies for the evaluation of the exponential and hyperbolic tangent in the
+ * activation functions: exactly, with the standard library, or with a fast
+ * polynomial approximation of bounded error.
+ */
+#ifndef __MLPACK_METHODS_ANN_ACTIVATION_FUNCTIONS_MATH_POLICIES_HPP
+#define __MLPACK_METHODS_ANN_ACTIVATION_FUNCTIONS_MATH_POLICIES_HPP
+
+#include <mlpack/core.hpp>
+#include <cstring>
+#include <stdint.h>
+
+namespace mlpack {
+namespace ann /** Artificial Neural Network. */ {
+
+/**
+ * Evaluate the exponential and the hyperbolic tangent with the standard
+ * library.  This is the default policy of the activation functions.
+ */
+class ExactMath
+{
+ public:
+  //! Compute e^x.
+  static double Exp(const double x) { return std::exp(x); }
+
+  //! Compute tanh(x).
+  static double Tanh(const double x) { return std::tanh(x); }
+};
+
+/**
+ * Evaluate the exponential and the hyperbolic tangent with a polynomial
+ * approximation.  The exponential is reduced to e^r 2^k, with |r| <= ln(2) / 2,
+ * and e^r is approximated by its Taylor polynomial of degree 7; the relative
+ * error is below 1e-8 (for x in [-708, 709]; outside, x is clamped to that
+ * range).  The hyperbolic tangent is computed from the exponential, with an
+ * absolute error below 1e-8.
+ *
+ * Neither function has branches or calls into the standard library, so the
+ * loops of the activation functions over a matrix can be vectorized by the
+ * compiler.  The error is far below what matters for training a network, but
+ * the results are not the same as those of ExactMath.
+ */
+class FastMath
+{
+ public:
+  //! Approximate e^x.
+  static double Exp(const double x)
+  {
+    // Clamp x, so that 2^k is a normal double.
+    const double clamped = std::min(std::max(x, -708.0), 709.0);
+
+    // Split x into k ln(2) + r; ln(2) is split in two parts, so that r is
+    // computed accurately.
+    const double k = std::floor(clamped * 1.4426950408889634 + 0.5);
+    const double r = (clamped - k * 6.93145751953125e-1) -
+        k * 1.42860682030941723212e-6;
+
+    // The Taylor polynomial of e^r, in Horner form.
+    const double p = 1.0 + r * (1.0 + r * (1.0 / 2.0 + r * (1.0 / 6.0 +
+        r * (1.0 / 24.0 + r * (1.0 / 120.0 + r * (1.0 / 720.0 +
+        r * (1.0 / 5040.0)))))));
+
+    // Build 2^k from its exponent bits.
+    const int64_t bits = ((int64_t) k + 1023) << 52;
+    double scale;
+    std::memcpy(&scale, &bits, sizeof(double));
+
+    return p * scale;
+  }
+
+  //! Approximate tanh(x), as (1 - e^{-2|x|}) / (1 + e^{-2|x|}) with the sign
+  //! of x.
+  static double Tanh(const double x)
+  {
+    const double e = Exp(-2.0 * std::abs(x));
+    return std::copysign((1.0 - e) / (1.0 + e), x);
+  }
+};
+
+}; // namespace ann
+}; // namespace mlpack
+
+#endif
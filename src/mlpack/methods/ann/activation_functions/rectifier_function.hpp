@@ -60,7 +60,8 @@ class RectifierFunction
   template<typename eT>
   static void fn(const arma::Mat<eT>& x, arma::Mat<eT>& y)
   {
-    y = arma::max(arma::zeros<arma::Mat<eT> >(x.n_rows, x.n_cols), x);
+    y = x;
+    Rectify(y.memptr(), y.n_elem);
   }
 
   /**
@@ -73,8 +74,7 @@ class RectifierFunction
   static void fn(const arma::Cube<eT>& x, arma::Cube<eT>& y)
   {
     y = x;
-    for (size_t s = 0; s < x.n_slices; s++)
-      fn(x.slice(s), y.slice(s));
+    Rectify(y.memptr(), y.n_elem);
   }
 
   /**
@@ -99,8 +99,19 @@ class RectifierFunction
   {
     x = y;
 
-    for (size_t i = 0; i < y.n_elem; i++)
-      x(i) = deriv(y(i));
+    typename OutputType::elem_type* values = x.memptr();
+    for (size_t i = 0; i < x.n_elem; i++)
+      values[i] = (values[i] > 0);
+  }
+
+ private:
+  //! Replace the negative values of the array by 0, in place.  The loop has no
+  //! branches and no temporaries, so it is vectorized by the compiler.
+  template<typename eT>
+  static void Rectify(eT* values, const size_t n)
+  {
+    for (size_t i = 0; i < n; i++)
+      values[i] = std::max(values[i], eT(0));
   }
 }; // class RectifierFunction
 
@@ -66,8 +66,15 @@ class SoftsignFunction
   {
     y = x;
 
-    for (size_t i = 0; i < x.n_elem; i++)
-      y(i) = fn(x(i));
+    // This has no branches, so that the loop is vectorized by the compiler;
+    // infinite inputs give the same results as fn().
+    typename OutputVecType::elem_type* values = y.memptr();
+    for (size_t i = 0; i < y.n_elem; i++)
+    {
+      const double value = std::min(std::max((double) values[i], -DBL_MAX),
+          DBL_MAX);
+      values[i] = value / (1.0 + std::abs(value));
+    }
   }
 
   /**
@@ -78,7 +85,7 @@ class SoftsignFunction
    */
   static double deriv(const double y)
   {
-    return std::pow(1.0 - std::abs(y), 2);
+    return (1.0 - std::abs(y)) * (1.0 - std::abs(y));
   }
 
   /**
@@ -90,7 +97,7 @@ class SoftsignFunction
   template<typename InputVecType, typename OutputVecType>
   static void deriv(const InputVecType& y, OutputVecType& x)
   {
-    x = arma::pow(1.0 - arma::abs(y), 2);
+    x = arma::square(1.0 - arma::abs(y));
   }
 
   /**
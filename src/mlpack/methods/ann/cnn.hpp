@@ -11,6 +11,7 @@
 #include <mlpack/core.hpp>
 
 #include <mlpack/methods/ann/network_traits.hpp>
+#include <mlpack/methods/ann/weight_blob.hpp>
 #include <mlpack/methods/ann/layer/layer_traits.hpp>
 #include <mlpack/methods/ann/performance_functions/cee_function.hpp>
 
@@ -48,7 +49,11 @@ class CNN
   /**
    * Run a single iteration of the feed forward algorithm, using the given
    * input and target vector, store the calculated error into the error
-   * parameter.
+   * parameter.  The input may hold a batch of samples: slice
+   * (map * batchSize + i) of the input is the given input map of sample i, and
+   * column i of the target is the target of sample i.  Then the errors of the
+   * samples are summed, and the gradients computed by FeedBackward() are
+   * averaged over the batch.
    *
    * @param input Input data used to evaluate the network.
    * @param target Target data used to calculate the network error.
@@ -89,7 +94,9 @@ class CNN
 
   /**
    * Evaluate the network using the given input. The output activation is
-   * stored into the output parameter.
+   * stored into the output parameter.  The network is run in inference mode:
+   * layers like DropoutLayer are deterministic, and the layer inputs, which
+   * only the backward pass needs, are not stored.
    *
    * @param input Input data used to evaluate the network.
    * @param output Output data used to store the output activation
@@ -130,6 +137,85 @@ class CNN
     return trainError;
   }
 
+  /**
+   * Copy the weights of the given network, which has to have the same
+   * structure as this one, into the layers of this network.  This is used to
+   * bring a replica up to date before it computes the gradients of a shard of
+   * a batch.
+   *
+   * @param other Network to copy the weights from.
+   */
+  void CopyWeights(const CNN& other)
+  {
+    CopyWeights<>(network, other.network);
+  }
+
+  /**
+   * Scale the gradients accumulated by the layer optimizers since the last
+   * ApplyGradients() call by the given factor.
+   *
+   * @param factor Factor the accumulated gradients are multiplied with.
+   */
+  void ScaleGradients(const double factor)
+  {
+    ScaleGradients<>(network, factor);
+  }
+
+  /**
+   * Add the gradients accumulated by the layer optimizers of the given
+   * network, which has to have the same structure as this one, to the
+   * gradients accumulated by this network, and reset the gradients of the
+   * given network.  A following ApplyGradients() call then takes a step with
+   * the gradients of both networks.
+   *
+   * @param other Network to take the accumulated gradients from.
+   */
+  void MergeGradients(CNN& other)
+  {
+    MergeGradients<>(network, other.network);
+  }
+
+  /**
+   * Save the weights of the network to the given file, as one raw binary blob
+   * (see WeightBlob).  The network has to be built in the same way to load
+   * them again.  A std::runtime_error is thrown if the file cannot be written.
+   *
+   * @param filename Name of the file to write.
+   */
+  void SaveWeights(const std::string& filename)
+  {
+    WeightBlob blob;
+    CollectWeights<>(network, blob);
+    blob.Save(filename);
+  }
+
+  /**
+   * Load the weights of the network from the given file, written by
+   * SaveWeights() for a network built in the same way.  The whole file is
+   * read at once, which makes this much faster than boost::serialization for
+   * loading a trained network.  A std::runtime_error is thrown if the file
+   * cannot be read or does not match the network.
+   *
+   * @param filename Name of the file to read.
+   */
+  void LoadWeights(const std::string& filename)
+  {
+    WeightBlob blob;
+    CollectWeights<>(network, blob);
+    blob.Load(filename);
+  }
+
+  /**
+   * Serialize the network, by serializing each of the layers which have
+   * parameters.  The network (and so its layers) has to be constructed in the
+   * same way before it is loaded.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    SerializeLayers<>(ar, network);
+  }
+
  private:
   /**
    * Reset the network by setting the layer status.
@@ -185,10 +271,19 @@ class CNN
   template<size_t I = 0, typename DataType, typename... Tp>
   void Forward(const DataType& input, std::tuple<Tp...>& t)
   {
-    std::get<I>(t).InputParameter() = input;
+    // The input parameters are only needed by the backward pass, so they are
+    // not stored when the network is used for prediction.
+    if (deterministic)
+    {
+      std::get<I>(t).Forward(input, std::get<I>(t).OutputParameter());
+    }
+    else
+    {
+      std::get<I>(t).InputParameter() = input;
 
-    std::get<I>(t).Forward(std::get<I>(t).InputParameter(),
-                           std::get<I>(t).OutputParameter());
+      std::get<I>(t).Forward(std::get<I>(t).InputParameter(),
+                             std::get<I>(t).OutputParameter());
+    }
 
     ForwardTail<I + 1, Tp...>(t);
   }
@@ -197,7 +292,8 @@ class CNN
   typename std::enable_if<I == sizeof...(Tp), void>::type
   ForwardTail(std::tuple<Tp...>& /* unused */)
   {
-    LinkParameter(network);
+    if (!deterministic)
+      LinkParameter(network);
   }
 
   template<size_t I = 1, typename... Tp>
@@ -374,6 +470,229 @@ class CNN
     /* Nothing to do here */
   }
 
+  /**
+   * Copy the weights of the layers of the given network into the layers of
+   * this network.
+   *
+   * enable_if (SFINAE) is used to iterate through the network connections.
+   * The general case peels off the first type and recurses, as usual with
+   * variadic function templates.
+   */
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I == Max, void>::type
+  CopyWeights(std::tuple<Tp...>& /* unused */,
+              const std::tuple<Tp...>& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I < Max, void>::type
+  CopyWeights(std::tuple<Tp...>& t, const std::tuple<Tp...>& other)
+  {
+    Copy(std::get<I>(t), std::get<I>(other), std::get<I>(t).OutputParameter(),
+         std::get<I + 1>(t).Delta());
+
+    CopyWeights<I + 1, Max, Tp...>(t, other);
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Copy(T& t, T& other, P& /* unused */, D& /* unused */)
+  {
+    t.Weights() = other.Weights();
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      !HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Copy(T& /* unused */, T& /* unused */, P& /* unused */, D& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  /**
+   * Scale the gradients accumulated by the layer optimizers.
+   *
+   * enable_if (SFINAE) is used to iterate through the network connections.
+   * The general case peels off the first type and recurses, as usual with
+   * variadic function templates.
+   */
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I == Max, void>::type
+  ScaleGradients(std::tuple<Tp...>& /* unused */, const double /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I < Max, void>::type
+  ScaleGradients(std::tuple<Tp...>& t, const double factor)
+  {
+    Scale(std::get<I>(t), std::get<I>(t).OutputParameter(),
+          std::get<I + 1>(t).Delta(), factor);
+
+    ScaleGradients<I + 1, Max, Tp...>(t, factor);
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Scale(T& t, P& /* unused */, D& /* unused */, const double factor)
+  {
+    t.Optimizer().Gradient() *= factor;
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      !HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Scale(T& /* unused */, P& /* unused */, D& /* unused */,
+        const double /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  /**
+   * Move the gradients accumulated by the layer optimizers of the given
+   * network into the layer optimizers of this network.
+   *
+   * enable_if (SFINAE) is used to iterate through the network connections.
+   * The general case peels off the first type and recurses, as usual with
+   * variadic function templates.
+   */
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I == Max, void>::type
+  MergeGradients(std::tuple<Tp...>& /* unused */,
+                 std::tuple<Tp...>& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I < Max, void>::type
+  MergeGradients(std::tuple<Tp...>& t, std::tuple<Tp...>& other)
+  {
+    Merge(std::get<I>(t), std::get<I>(other), std::get<I>(t).OutputParameter(),
+          std::get<I + 1>(t).Delta());
+
+    MergeGradients<I + 1, Max, Tp...>(t, other);
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Merge(T& t, T& other, P& /* unused */, D& /* unused */)
+  {
+    // The gradient storage of an optimizer is empty until its first update.
+    if (other.Optimizer().Gradient().n_elem == 0)
+      return;
+
+    if (t.Optimizer().Gradient().n_elem == 0)
+      t.Optimizer().Gradient() = other.Optimizer().Gradient();
+    else
+      t.Optimizer().Gradient() += other.Optimizer().Gradient();
+
+    other.Optimizer().Reset();
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      !HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Merge(T& /* unused */, T& /* unused */, P& /* unused */, D& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  /**
+   * Add the weights of the layers to the given weight blob.
+   *
+   * enable_if (SFINAE) is used to iterate through the network connections.
+   * The general case peels off the first type and recurses, as usual with
+   * variadic function templates.
+   */
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I == Max, void>::type
+  CollectWeights(std::tuple<Tp...>& /* unused */, WeightBlob& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I < Max, void>::type
+  CollectWeights(std::tuple<Tp...>& t, WeightBlob& blob)
+  {
+    Collect(std::get<I>(t), std::get<I>(t).OutputParameter(),
+            std::get<I + 1>(t).Delta(), blob);
+
+    CollectWeights<I + 1, Max, Tp...>(t, blob);
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Collect(T& t, P& /* unused */, D& /* unused */, WeightBlob& blob)
+  {
+    blob.Add(t.Weights());
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      !HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Collect(T& /* unused */, P& /* unused */, D& /* unused */,
+          WeightBlob& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  /**
+   * Serialize each of the layers which have a Serialize() function.
+   *
+   * enable_if (SFINAE) is used to iterate through the network layer.
+   * The general case peels off the first type and recurses, as usual with
+   * variadic function templates.
+   */
+  template<size_t I = 0, typename Archive, typename... Tp>
+  typename std::enable_if<I == sizeof...(Tp), void>::type
+  SerializeLayers(Archive& /* unused */, std::tuple<Tp...>& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  template<size_t I = 0, typename Archive, typename... Tp>
+  typename std::enable_if<I < sizeof...(Tp), void>::type
+  SerializeLayers(Archive& ar, std::tuple<Tp...>& t)
+  {
+    SerializeLayer(ar, std::get<I>(t), I);
+    SerializeLayers<I + 1, Archive, Tp...>(ar, t);
+  }
+
+  template<typename Archive, typename T>
+  typename std::enable_if<data::HasSerialize<T>::value, void>::type
+  SerializeLayer(Archive& ar, T& layer, const size_t i)
+  {
+    std::ostringstream oss;
+    oss << "layer" << i;
+    ar & data::CreateNVP(layer, oss.str());
+  }
+
+  template<typename Archive, typename T>
+  typename std::enable_if<!data::HasSerialize<T>::value, void>::type
+  SerializeLayer(Archive& /* unused */,
+                 T& /* unused */,
+                 const size_t /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
   /*
    * Calculate and store the output activation.
    */
@@ -23,6 +23,15 @@ namespace ann /** Artificial Neural Network. */ {
  * ValidConvolution: returns only those parts of the convolution that are
  * computed without the zero-padded edges.
  *
+ * Besides the usual Convolution() overloads, the class provides
+ * MapConvolution() and MapGradient(), which work on all of the maps of a
+ * convolution layer (and all of the samples of a batch) at once; ConvLayer uses
+ * them when they are available.  These transform each input map and each
+ * filter only once per call, and sum the products of the spectra over the
+ * input maps (or the samples) before a single inverse transform for each
+ * output, so the cost of a pass is dominated by one transform per map instead
+ * of three per pair of maps.
+ *
  * @tparam BorderMode Type of the border mode (FullConvolution or
  * ValidConvolution).
  * @tparam padLastDim Pad the last dimension of the input to to turn it from
@@ -208,6 +217,278 @@ class FFTConvolution
     }
   }
 
+  /*
+   * Perform the convolution of a layer with inMaps input maps and outMaps
+   * output maps, for a batch of samples.  Slice (inMap * batchSize + i) of the
+   * input is the given input map of sample i, and the output is laid out in
+   * the same way.  The filter of input map inMap and output map outMap is
+   * slice (inMap * outMaps + outMap) of the filters, and the output map is the
+   * sum of the convolutions of each input map with its filter.  Each input map
+   * and each filter is transformed once, and each output map is transformed
+   * back once.
+   *
+   * @param input Input maps of each sample of the batch.
+   * @param filter The inMaps * outMaps filters.
+   * @param outMaps The number of output maps.
+   * @param output Output maps of each sample of the batch.
+   */
+  template<typename eT>
+  static void MapConvolution(const arma::Cube<eT>& input,
+                             const arma::Cube<eT>& filter,
+                             const size_t outMaps,
+                             arma::Cube<eT>& output)
+  {
+    const size_t inMaps = filter.n_slices / outMaps;
+    const size_t batchSize = input.n_slices / inMaps;
+
+    std::vector<arma::Mat<std::complex<eT> > > inputSpectra, filterSpectra;
+    InputSpectra(input, filter.n_rows, filter.n_cols, inputSpectra);
+    FilterSpectra(filter, inputSpectra[0].n_rows, inputSpectra[0].n_cols,
+        filterSpectra);
+
+    const size_t outputRows = OutputSize(input.n_rows, filter.n_rows);
+    const size_t outputCols = OutputSize(input.n_cols, filter.n_cols);
+    output.set_size(outputRows, outputCols, outMaps * batchSize);
+
+    // Each output slice (one output map of one sample) is computed by a single
+    // thread, and each thread reuses its own spectrum buffer.
+    #pragma omp parallel
+    {
+      arma::Mat<std::complex<eT> > spectrum;
+
+      #pragma omp for schedule(static)
+      for (size_t s = 0; s < output.n_slices; s++)
+      {
+        const size_t outMap = s / batchSize;
+        const size_t i = s % batchSize;
+
+        spectrum = inputSpectra[i] % filterSpectra[outMap];
+        for (size_t inMap = 1; inMap < inMaps; inMap++)
+        {
+          spectrum += inputSpectra[inMap * batchSize + i] %
+              filterSpectra[inMap * outMaps + outMap];
+        }
+
+        arma::Mat<eT> outputSlice(output.slice_memptr(s), outputRows,
+            outputCols, false, true);
+        Extract(spectrum, input.n_rows, input.n_cols, filter.n_rows,
+            filter.n_cols, outputSlice);
+      }
+    }
+  }
+
+  /*
+   * Compute the convolutions of each input map with each map of the delta
+   * (used as the filter), summed over a batch of samples.  This is the
+   * gradient of the filters of a convolution layer.  The input and the delta
+   * are laid out as for MapConvolution(), and slice (inMap * outMaps + outMap)
+   * of the gradient is the sum over the samples of the convolution of input
+   * map inMap with delta map outMap.  Each input map and each delta map is
+   * transformed once, and each gradient is transformed back once.
+   *
+   * @param input Input maps of each sample of the batch.
+   * @param delta Delta maps of each sample of the batch.
+   * @param outMaps The number of delta (output) maps.
+   * @param gradient The inMaps * outMaps gradients.
+   */
+  template<typename eT>
+  static void MapGradient(const arma::Cube<eT>& input,
+                          const arma::Cube<eT>& delta,
+                          const size_t outMaps,
+                          arma::Cube<eT>& gradient)
+  {
+    const size_t batchSize = delta.n_slices / outMaps;
+    const size_t inMaps = input.n_slices / batchSize;
+
+    std::vector<arma::Mat<std::complex<eT> > > inputSpectra, deltaSpectra;
+    InputSpectra(input, delta.n_rows, delta.n_cols, inputSpectra);
+    FilterSpectra(delta, inputSpectra[0].n_rows, inputSpectra[0].n_cols,
+        deltaSpectra);
+
+    const size_t gradientRows = OutputSize(input.n_rows, delta.n_rows);
+    const size_t gradientCols = OutputSize(input.n_cols, delta.n_cols);
+    gradient.set_size(gradientRows, gradientCols, inMaps * outMaps);
+
+    // Each gradient (one pair of input and output maps) is computed by a
+    // single thread, and each thread reuses its own spectrum buffer.
+    #pragma omp parallel
+    {
+      arma::Mat<std::complex<eT> > spectrum;
+
+      #pragma omp for schedule(static)
+      for (size_t s = 0; s < gradient.n_slices; s++)
+      {
+        const size_t inMap = s / outMaps;
+        const size_t outMap = s % outMaps;
+
+        spectrum = inputSpectra[inMap * batchSize] %
+            deltaSpectra[outMap * batchSize];
+        for (size_t i = 1; i < batchSize; i++)
+        {
+          spectrum += inputSpectra[inMap * batchSize + i] %
+              deltaSpectra[outMap * batchSize + i];
+        }
+
+        arma::Mat<eT> gradientSlice(gradient.slice_memptr(s), gradientRows,
+            gradientCols, false, true);
+        Extract(spectrum, input.n_rows, input.n_cols, delta.n_rows,
+            delta.n_cols, gradientSlice);
+      }
+    }
+  }
+
+ private:
+  /*
+   * Pad the input to the working size of the transforms (valid mode): the
+   * size of the input, with one more column if padLastDim is set.
+   *
+   * @param input Input to pad.
+   * @param filterRows Number of rows of the filter.
+   * @param filterCols Number of columns of the filter.
+   * @param padded Storage for the padded input.
+   */
+  template<typename eT, typename Border = BorderMode>
+  static typename std::enable_if<
+      std::is_same<Border, ValidConvolution>::value, void>::type
+  PadInput(const arma::Mat<eT>& input,
+           const size_t /* filterRows */,
+           const size_t /* filterCols */,
+           arma::Mat<eT>& padded)
+  {
+    padded = input;
+    if (padLastDim)
+      padded.resize(padded.n_rows, padded.n_cols + 1);
+  }
+
+  /*
+   * Pad the input to the working size of the transforms (full mode): the input
+   * is surrounded by filterRows - 1 rows and filterCols - 1 columns of zeros,
+   * with one more column if padLastDim is set.
+   *
+   * @param input Input to pad.
+   * @param filterRows Number of rows of the filter.
+   * @param filterCols Number of columns of the filter.
+   * @param padded Storage for the padded input.
+   */
+  template<typename eT, typename Border = BorderMode>
+  static typename std::enable_if<
+      std::is_same<Border, FullConvolution>::value, void>::type
+  PadInput(const arma::Mat<eT>& input,
+           const size_t filterRows,
+           const size_t filterCols,
+           arma::Mat<eT>& padded)
+  {
+    padded.zeros(input.n_rows + 2 * (filterRows - 1),
+        input.n_cols + 2 * (filterCols - 1) + (padLastDim ? 1 : 0));
+    padded.submat(filterRows - 1, filterCols - 1,
+        filterRows - 1 + input.n_rows - 1,
+        filterCols - 1 + input.n_cols - 1) = input;
+  }
+
+  //! Get the size of the output along one dimension (valid mode).
+  template<typename Border = BorderMode>
+  static typename std::enable_if<
+      std::is_same<Border, ValidConvolution>::value, size_t>::type
+  OutputSize(const size_t inputSize, const size_t filterSize)
+  {
+    return inputSize - filterSize + 1;
+  }
+
+  //! Get the size of the output along one dimension (full mode).
+  template<typename Border = BorderMode>
+  static typename std::enable_if<
+      std::is_same<Border, FullConvolution>::value, size_t>::type
+  OutputSize(const size_t inputSize, const size_t filterSize)
+  {
+    return inputSize + filterSize - 1;
+  }
+
+  /*
+   * Transform each slice of the input, padded to the working size.
+   *
+   * @param input Input maps.
+   * @param filterRows Number of rows of the filters.
+   * @param filterCols Number of columns of the filters.
+   * @param spectra Storage for the spectrum of each slice.
+   */
+  template<typename eT>
+  static void InputSpectra(const arma::Cube<eT>& input,
+                           const size_t filterRows,
+                           const size_t filterCols,
+                           std::vector<arma::Mat<std::complex<eT> > >& spectra)
+  {
+    spectra.resize(input.n_slices);
+
+    #pragma omp parallel
+    {
+      arma::Mat<eT> padded;
+
+      #pragma omp for schedule(static)
+      for (size_t s = 0; s < input.n_slices; s++)
+      {
+        const arma::Mat<eT> slice(const_cast<eT*>(input.slice_memptr(s)),
+            input.n_rows, input.n_cols, false, true);
+        PadInput(slice, filterRows, filterCols, padded);
+        spectra[s] = arma::fft2(padded);
+      }
+    }
+  }
+
+  /*
+   * Transform each slice of the filter, padded with zeros to the working size.
+   *
+   * @param filter Filters.
+   * @param rows Number of rows of the working size.
+   * @param cols Number of columns of the working size.
+   * @param spectra Storage for the spectrum of each slice.
+   */
+  template<typename eT>
+  static void FilterSpectra(const arma::Cube<eT>& filter,
+                            const size_t rows,
+                            const size_t cols,
+                            std::vector<arma::Mat<std::complex<eT> > >& spectra)
+  {
+    spectra.resize(filter.n_slices);
+
+    #pragma omp parallel
+    {
+      arma::Mat<eT> padded;
+
+      #pragma omp for schedule(static)
+      for (size_t s = 0; s < filter.n_slices; s++)
+      {
+        padded.zeros(rows, cols);
+        padded.submat(0, 0, filter.n_rows - 1, filter.n_cols - 1) =
+            filter.slice(s);
+        spectra[s] = arma::fft2(padded);
+      }
+    }
+  }
+
+  /*
+   * Transform the given spectrum back, and extract the region of interest of
+   * the convolution.  The padLastDim column is cut out with the rest.
+   *
+   * @param spectrum Spectrum of the convolution at the working size.
+   * @param inputRows Number of rows of the input.
+   * @param inputCols Number of columns of the input.
+   * @param filterRows Number of rows of the filter.
+   * @param filterCols Number of columns of the filter.
+   * @param output Storage for the output, which has the output size already.
+   */
+  template<typename eT>
+  static void Extract(const arma::Mat<std::complex<eT> >& spectrum,
+                      const size_t inputRows,
+                      const size_t inputCols,
+                      const size_t filterRows,
+                      const size_t filterCols,
+                      arma::Mat<eT>& output)
+  {
+    const arma::Mat<eT> result = arma::real(arma::ifft2(spectrum));
+    output = result.submat(filterRows - 1, filterCols - 1,
+        filterRows - 1 + OutputSize(inputRows, filterRows) - 1,
+        filterCols - 1 + OutputSize(inputCols, filterCols) - 1);
+  }
 };  // class FFTConvolution
 
 }; // namespace ann
@@ -0,0 +1,423 @@
+/**
+ * @file im2col_convolution.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the convolution by lowering the input to a matrix of
+ * patches (im2col), so that the convolution is a single matrix product.
+ */
+#ifndef __MLPACK_METHODS_ANN_CONVOLUTION_RULES_IM2COL_CONVOLUTION_HPP
+#define __MLPACK_METHODS_ANN_CONVOLUTION_RULES_IM2COL_CONVOLUTION_HPP
+
+#include <mlpack/core.hpp>
+#include "border_modes.hpp"
+
+namespace mlpack {
+namespace ann /** Artificial Neural Network. */ {
+
+/**
+ * Computes the two-dimensional convolution by lowering the input to a matrix
+ * (im2col).  Each row of the lowered matrix holds the patch of the input that
+ * lies under the filter at one output position, so the convolution with any
+ * number of filters is one matrix product, which is handed to BLAS.  This
+ * class allows specification of the type of the border type. The convolution
+ * can be compute with the valid border type of the full border type (default).
+ *
+ * FullConvolution: returns the full two-dimensional convolution.
+ * ValidConvolution: returns only those parts of the convolution that are
+ * computed without the zero-padded edges.
+ *
+ * Besides the usual Convolution() overloads, the class provides
+ * MapConvolution() and MapGradient(), which work on all of the maps of a
+ * convolution layer (and all of the samples of a batch) at once; ConvLayer uses
+ * them when they are available, so each pass of the layer is a single matrix
+ * product.  The lowered matrix takes (filter size) times as much memory as the
+ * input.
+ *
+ * @tparam BorderMode Type of the border mode (FullConvolution or
+ * ValidConvolution).
+ */
+template<typename BorderMode = FullConvolution>
+class Im2colConvolution
+{
+ public:
+  /*
+   * Perform a convolution (valid or full mode).
+   *
+   * @param input Input used to perform the convolution.
+   * @param filter Filter used to perform the conolution.
+   * @param output Output data that contains the results of the convolution.
+   */
+  template<typename eT>
+  static void Convolution(const arma::Mat<eT>& input,
+                          const arma::Mat<eT>& filter,
+                          arma::Mat<eT>& output)
+  {
+    arma::Mat<eT> padded;
+    const arma::Mat<eT>& border = Pad(input, filter.n_rows, filter.n_cols,
+        padded);
+
+    const size_t outputRows = border.n_rows - filter.n_rows + 1;
+    const size_t outputCols = border.n_cols - filter.n_cols + 1;
+
+    arma::Mat<eT> lowered(outputRows * outputCols, filter.n_elem);
+    Lower(border, filter.n_rows, filter.n_cols, lowered, 0, 0);
+
+    const arma::Col<eT> result = lowered * arma::vectorise(filter);
+    output = arma::Mat<eT>(result.memptr(), outputRows, outputCols);
+  }
+
+  /*
+   * Perform a convolution using 3rd order tensors; each slice of the input is
+   * convolved with the same slice of the filter.
+   *
+   * @param input Input used to perform the convolution.
+   * @param filter Filter used to perform the conolution.
+   * @param output Output data that contains the results of the convolution.
+   */
+  template<typename eT>
+  static void Convolution(const arma::Cube<eT>& input,
+                          const arma::Cube<eT>& filter,
+                          arma::Cube<eT>& output)
+  {
+    arma::Mat<eT> convOutput;
+    Im2colConvolution<BorderMode>::Convolution(input.slice(0),
+        filter.slice(0), convOutput);
+
+    output = arma::Cube<eT>(convOutput.n_rows, convOutput.n_cols,
+        input.n_slices);
+    output.slice(0) = convOutput;
+
+    for (size_t i = 1; i < input.n_slices; i++)
+    {
+      Im2colConvolution<BorderMode>::Convolution(input.slice(i),
+          filter.slice(i), convOutput);
+      output.slice(i) = convOutput;
+    }
+  }
+
+  /*
+   * Perform a convolution using dense matrix as input and a 3rd order tensors
+   * as filter and output.  The input is lowered once, and all of the filters
+   * are applied with a single matrix product.
+   *
+   * @param input Input used to perform the convolution.
+   * @param filter Filter used to perform the conolution.
+   * @param output Output data that contains the results of the convolution.
+   */
+  template<typename eT>
+  static void Convolution(const arma::Mat<eT>& input,
+                          const arma::Cube<eT>& filter,
+                          arma::Cube<eT>& output)
+  {
+    arma::Mat<eT> padded;
+    const arma::Mat<eT>& border = Pad(input, filter.n_rows, filter.n_cols,
+        padded);
+
+    const size_t outputRows = border.n_rows - filter.n_rows + 1;
+    const size_t outputCols = border.n_cols - filter.n_cols + 1;
+    const size_t filterSize = filter.n_rows * filter.n_cols;
+
+    arma::Mat<eT> lowered(outputRows * outputCols, filterSize);
+    Lower(border, filter.n_rows, filter.n_cols, lowered, 0, 0);
+
+    const arma::Mat<eT> filters(filter.memptr(), filterSize, filter.n_slices);
+    const arma::Mat<eT> result = lowered * filters;
+
+    output.set_size(outputRows, outputCols, filter.n_slices);
+    for (size_t i = 0; i < filter.n_slices; i++)
+      output.slice(i) = arma::Mat<eT>(result.colptr(i), outputRows,
+          outputCols);
+  }
+
+  /*
+   * Perform a convolution using a 3rd order tensors as input and output and a
+   * dense matrix as filter.  All of the slices are lowered into one matrix, so
+   * the filter is applied with a single matrix product.
+   *
+   * @param input Input used to perform the convolution.
+   * @param filter Filter used to perform the conolution.
+   * @param output Output data that contains the results of the convolution.
+   */
+  template<typename eT>
+  static void Convolution(const arma::Cube<eT>& input,
+                          const arma::Mat<eT>& filter,
+                          arma::Cube<eT>& output)
+  {
+    // Each slice is lowered as if it were one sample of a batch with a single
+    // map.
+    size_t outputRows, outputCols;
+    arma::Mat<eT> lowered;
+    LowerMaps(input, 1, filter.n_rows, filter.n_cols, lowered, outputRows,
+        outputCols);
+
+    const size_t outputSize = outputRows * outputCols;
+    const arma::Col<eT> result = lowered * arma::vectorise(filter);
+
+    output.set_size(outputRows, outputCols, input.n_slices);
+    for (size_t i = 0; i < input.n_slices; i++)
+      output.slice(i) = arma::Mat<eT>(result.memptr() + i * outputSize,
+          outputRows, outputCols);
+  }
+
+  /*
+   * Perform the convolution of a layer with inMaps input maps and outMaps
+   * output maps, for a batch of samples, with a single matrix product.  Slice
+   * (inMap * batchSize + i) of the input is the given input map of sample i,
+   * and the output is laid out in the same way.  The filter of input map
+   * inMap and output map outMap is slice (inMap * outMaps + outMap) of the
+   * filters, and the output map is the sum of the convolutions of each input
+   * map with its filter.
+   *
+   * @param input Input maps of each sample of the batch.
+   * @param filter The inMaps * outMaps filters.
+   * @param outMaps The number of output maps.
+   * @param output Output maps of each sample of the batch.
+   */
+  template<typename eT>
+  static void MapConvolution(const arma::Cube<eT>& input,
+                             const arma::Cube<eT>& filter,
+                             const size_t outMaps,
+                             arma::Cube<eT>& output)
+  {
+    const size_t inMaps = filter.n_slices / outMaps;
+    const size_t batchSize = input.n_slices / inMaps;
+    const size_t filterSize = filter.n_rows * filter.n_cols;
+
+    // Each row of the lowered matrix holds the patches of all the input maps
+    // at one output position of one sample.
+    size_t outputRows, outputCols;
+    arma::Mat<eT> lowered;
+    LowerMaps(input, inMaps, filter.n_rows, filter.n_cols, lowered,
+        outputRows, outputCols);
+
+    // Each column of the filter matrix holds the filters of one output map.
+    arma::Mat<eT> filters(inMaps * filterSize, outMaps);
+    for (size_t inMap = 0; inMap < inMaps; inMap++)
+    {
+      for (size_t outMap = 0; outMap < outMaps; outMap++)
+      {
+        filters.col(outMap).subvec(inMap * filterSize,
+            (inMap + 1) * filterSize - 1) = arma::vectorise(
+            filter.slice(inMap * outMaps + outMap));
+      }
+    }
+
+    const arma::Mat<eT> result = lowered * filters;
+
+    const size_t outputSize = outputRows * outputCols;
+    output.set_size(outputRows, outputCols, outMaps * batchSize);
+    for (size_t outMap = 0; outMap < outMaps; outMap++)
+    {
+      for (size_t i = 0; i < batchSize; i++)
+      {
+        output.slice(outMap * batchSize + i) = arma::Mat<eT>(
+            result.colptr(outMap) + i * outputSize, outputRows, outputCols);
+      }
+    }
+  }
+
+  /*
+   * Compute the convolutions of each input map with each map of the delta
+   * (used as the filter), summed over a batch of samples, with a single matrix
+   * product.  This is the gradient of the filters of a convolution layer.  The
+   * input and the delta are laid out as for MapConvolution(), and slice
+   * (inMap * outMaps + outMap) of the gradient is the sum over the samples of
+   * the convolution of input map inMap with delta map outMap.
+   *
+   * @param input Input maps of each sample of the batch.
+   * @param delta Delta maps of each sample of the batch.
+   * @param outMaps The number of delta (output) maps.
+   * @param gradient The inMaps * outMaps gradients.
+   */
+  template<typename eT>
+  static void MapGradient(const arma::Cube<eT>& input,
+                          const arma::Cube<eT>& delta,
+                          const size_t outMaps,
+                          arma::Cube<eT>& gradient)
+  {
+    const size_t batchSize = delta.n_slices / outMaps;
+    const size_t inMaps = input.n_slices / batchSize;
+
+    // The gradient at each filter position is the dot product of the delta and
+    // the input under it.  Lowering the input with the filter (not the delta)
+    // as the window gives one row per delta position, with the input under
+    // each filter position, so the gradient is the transpose of the lowered
+    // matrix times the delta.
+    const size_t deltaRows = delta.n_rows;
+    const size_t deltaCols = delta.n_cols;
+    const size_t deltaSize = deltaRows * deltaCols;
+
+    arma::Mat<eT> padded;
+    const arma::Mat<eT>& first = Pad(input.slice(0), deltaRows, deltaCols,
+        padded);
+    const size_t gradientRows = first.n_rows - deltaRows + 1;
+    const size_t gradientCols = first.n_cols - deltaCols + 1;
+    const size_t gradientSize = gradientRows * gradientCols;
+
+    arma::Mat<eT> lowered(deltaSize * batchSize, inMaps * gradientSize);
+    for (size_t inMap = 0; inMap < inMaps; inMap++)
+    {
+      for (size_t i = 0; i < batchSize; i++)
+      {
+        const arma::Mat<eT>& border = Pad(input.slice(inMap * batchSize + i),
+            deltaRows, deltaCols, padded);
+        Lower(border, gradientRows, gradientCols, lowered, i * deltaSize,
+            inMap * gradientSize);
+      }
+    }
+
+    // Each column of the delta matrix holds one delta map of all the samples.
+    const arma::Mat<eT> deltas(delta.memptr(), deltaSize * batchSize, outMaps);
+    const arma::Mat<eT> result = lowered.t() * deltas;
+
+    gradient.set_size(gradientRows, gradientCols, inMaps * outMaps);
+    for (size_t inMap = 0; inMap < inMaps; inMap++)
+    {
+      for (size_t outMap = 0; outMap < outMaps; outMap++)
+      {
+        gradient.slice(inMap * outMaps + outMap) = arma::Mat<eT>(
+            result.colptr(outMap) + inMap * gradientSize, gradientRows,
+            gradientCols);
+      }
+    }
+  }
+
+ private:
+  /*
+   * Return the input padded for the border mode (valid mode); no padding is
+   * needed.
+   *
+   * @param input Input to pad.
+   * @param filterRows Number of rows of the filter.
+   * @param filterCols Number of columns of the filter.
+   * @param padded Storage for the padded input (unused).
+   */
+  template<typename eT, typename Border = BorderMode>
+  static typename std::enable_if<
+      std::is_same<Border, ValidConvolution>::value, const arma::Mat<eT>&>::type
+  Pad(const arma::Mat<eT>& input,
+      const size_t /* filterRows */,
+      const size_t /* filterCols */,
+      arma::Mat<eT>& /* padded */)
+  {
+    return input;
+  }
+
+  /*
+   * Return the input padded for the border mode (full mode); the input is
+   * surrounded by filterRows - 1 rows and filterCols - 1 columns of zeros.
+   *
+   * @param input Input to pad.
+   * @param filterRows Number of rows of the filter.
+   * @param filterCols Number of columns of the filter.
+   * @param padded Storage for the padded input.
+   */
+  template<typename eT, typename Border = BorderMode>
+  static typename std::enable_if<
+      std::is_same<Border, FullConvolution>::value, const arma::Mat<eT>&>::type
+  Pad(const arma::Mat<eT>& input,
+      const size_t filterRows,
+      const size_t filterCols,
+      arma::Mat<eT>& padded)
+  {
+    padded.zeros(input.n_rows + 2 * (filterRows - 1),
+        input.n_cols + 2 * (filterCols - 1));
+    padded.submat(filterRows - 1, filterCols - 1,
+        filterRows - 1 + input.n_rows - 1,
+        filterCols - 1 + input.n_cols - 1) = input;
+
+    return padded;
+  }
+
+  /*
+   * Lower the (already padded) input into a block of the given matrix: row p of
+   * the block holds the input under the filter at output position p (in
+   * column-major order), in the same order as the elements of the filter.  The
+   * block has (input.n_rows - filterRows + 1) * (input.n_cols - filterCols + 1)
+   * rows and filterRows * filterCols columns.
+   *
+   * @param input Input to lower.
+   * @param filterRows Number of rows of the filter.
+   * @param filterCols Number of columns of the filter.
+   * @param lowered Matrix to store the block in.
+   * @param row First row of the block.
+   * @param col First column of the block.
+   */
+  template<typename eT>
+  static void Lower(const arma::Mat<eT>& input,
+                    const size_t filterRows,
+                    const size_t filterCols,
+                    arma::Mat<eT>& lowered,
+                    const size_t row,
+                    const size_t col)
+  {
+    const size_t outputRows = input.n_rows - filterRows + 1;
+    const size_t outputCols = input.n_cols - filterCols + 1;
+
+    // Each column of the block is the part of the input that one element of
+    // the filter is multiplied with, so it is copied one contiguous run of
+    // outputRows elements at a time.
+    for (size_t kj = 0; kj < filterCols; ++kj)
+    {
+      for (size_t ki = 0; ki < filterRows; ++ki)
+      {
+        eT* loweredPtr = lowered.colptr(col + kj * filterRows + ki) + row;
+        for (size_t j = 0; j < outputCols; ++j, loweredPtr += outputRows)
+        {
+          const eT* inputPtr = input.colptr(kj + j) + ki;
+          std::copy(inputPtr, inputPtr + outputRows, loweredPtr);
+        }
+      }
+    }
+  }
+
+  /*
+   * Lower the given maps of each sample of a batch into one matrix: slice
+   * (map * batchSize + i) of the input is lowered into the rows of sample i
+   * and the columns of the map.
+   *
+   * @param input Maps of each sample of the batch.
+   * @param maps The number of maps of each sample.
+   * @param filterRows Number of rows of the filter.
+   * @param filterCols Number of columns of the filter.
+   * @param lowered Matrix to store the lowered input in.
+   * @param outputRows Number of rows of the convolution output.
+   * @param outputCols Number of columns of the convolution output.
+   */
+  template<typename eT>
+  static void LowerMaps(const arma::Cube<eT>& input,
+                        const size_t maps,
+                        const size_t filterRows,
+                        const size_t filterCols,
+                        arma::Mat<eT>& lowered,
+                        size_t& outputRows,
+                        size_t& outputCols)
+  {
+    const size_t batchSize = input.n_slices / maps;
+    const size_t filterSize = filterRows * filterCols;
+
+    arma::Mat<eT> padded;
+    const arma::Mat<eT>& first = Pad(input.slice(0), filterRows, filterCols,
+        padded);
+    outputRows = first.n_rows - filterRows + 1;
+    outputCols = first.n_cols - filterCols + 1;
+    const size_t outputSize = outputRows * outputCols;
+
+    lowered.set_size(outputSize * batchSize, maps * filterSize);
+    for (size_t map = 0; map < maps; map++)
+    {
+      for (size_t i = 0; i < batchSize; i++)
+      {
+        const arma::Mat<eT>& border = Pad(input.slice(map * batchSize + i),
+            filterRows, filterCols, padded);
+        Lower(border, filterRows, filterCols, lowered, i * outputSize,
+            map * filterSize);
+      }
+    }
+  }
+};  // class Im2colConvolution
+
+}; // namespace ann
+}; // namespace mlpack
+
+#endif
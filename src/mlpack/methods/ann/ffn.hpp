@@ -10,7 +10,10 @@
 #include <mlpack/core.hpp>
 
 #include <mlpack/methods/ann/network_traits.hpp>
+#include <mlpack/methods/ann/flat_parameters.hpp>
+#include <mlpack/methods/ann/weight_blob.hpp>
 #include <mlpack/methods/ann/layer/layer_traits.hpp>
+#include <mlpack/methods/ann/optimizer/sparse_gradient.hpp>
 #include <mlpack/methods/ann/performance_functions/cee_function.hpp>
 
 namespace mlpack {
@@ -22,11 +25,16 @@ namespace ann /** Artificial Neural Network. */ {
  * @tparam LayerTypes Contains all layer modules used to construct the network.
  * @tparam OutputLayerType The outputlayer type used to evaluate the network.
  * @tparam PerformanceFunction Performance strategy used to claculate the error.
+ * @tparam ParameterType Where the weights and gradients of the layers are kept
+ *         and how they are updated: by the optimizer of each layer
+ *         (LayerParameters), or in one buffer by a single optimizer
+ *         (FlatParameters).
  */
 template <
   typename LayerTypes,
   typename OutputLayerType,
-  class PerformanceFunction = CrossEntropyErrorFunction<>
+  class PerformanceFunction = CrossEntropyErrorFunction<>,
+  class ParameterType = LayerParameters
 >
 class FFN
 {
@@ -41,13 +49,19 @@ class FFN
   FFN(const LayerTypes& network, OutputLayerType& outputLayer)
     : network(network), outputLayer(outputLayer), trainError(0)
   {
-    // Nothing to do here.
+    // Move the weights of the layers into the buffers of the parameter
+    // policy, if it has any.
+    CollectParameters<>(this->network);
+    parameters.Allocate();
   }
 
   /**
    * Run a single iteration of the feed forward algorithm, using the given
    * input and target vector, store the calculated error into the error
-   * parameter.
+   * parameter.  The input may hold a batch of samples, one per column (with
+   * the targets laid out in the same way); then the errors of the samples are
+   * summed, and the gradients computed by FeedBackward() are averaged over the
+   * batch.
    *
    * @param input Input data used to evaluate the network.
    * @param target Target data used to calculate the network error.
@@ -73,6 +87,7 @@ class FFN
   {
     Backward(error, network);
     UpdateGradients<>(network);
+    parameters.Update();
   }
 
   /**
@@ -81,6 +96,8 @@ class FFN
   void ApplyGradients()
   {
     ApplyGradients<>(network);
+    parameters.Optimize();
+    parameters.Reset();
 
     // Reset the overall error.
     trainError = 0;
@@ -88,7 +105,9 @@ class FFN
 
   /**
    * Evaluate the network using the given input. The output activation is
-   * stored into the output parameter.
+   * stored into the output parameter.  The network is run in inference mode:
+   * layers like DropoutLayer are deterministic, and the layer inputs, which
+   * only the backward pass needs, are not stored.
    *
    * @param input Input data used to evaluate the network.
    * @param output Output data used to store the output activation
@@ -129,7 +148,102 @@ class FFN
     return trainError;
   }
 
+  /**
+   * Copy the weights of the given network, which has to have the same
+   * structure as this one, into the layers of this network.  This is used to
+   * bring a replica up to date before it computes the gradients of a shard of
+   * a batch.
+   *
+   * @param other Network to copy the weights from.
+   */
+  void CopyWeights(const FFN& other)
+  {
+    CopyWeights<>(network, other.network);
+    parameters.Copy(other.parameters);
+  }
+
+  /**
+   * Scale the gradients accumulated by the layer optimizers since the last
+   * ApplyGradients() call by the given factor.
+   *
+   * @param factor Factor the accumulated gradients are multiplied with.
+   */
+  void ScaleGradients(const double factor)
+  {
+    ScaleGradients<>(network, factor);
+    parameters.Scale(factor);
+  }
+
+  /**
+   * Add the gradients accumulated by the layer optimizers of the given
+   * network, which has to have the same structure as this one, to the
+   * gradients accumulated by this network, and reset the gradients of the
+   * given network.  A following ApplyGradients() call then takes a step with
+   * the gradients of both networks.
+   *
+   * @param other Network to take the accumulated gradients from.
+   */
+  void MergeGradients(FFN& other)
+  {
+    MergeGradients<>(network, other.network);
+    parameters.Merge(other.parameters);
+  }
+
+  /**
+   * Save the weights of the network to the given file, as one raw binary blob
+   * (see WeightBlob).  The network has to be built in the same way to load
+   * them again.  A std::runtime_error is thrown if the file cannot be written.
+   *
+   * @param filename Name of the file to write.
+   */
+  void SaveWeights(const std::string& filename)
+  {
+    WeightBlob blob;
+    CollectWeights<>(network, blob);
+    blob.Save(filename);
+  }
+
+  /**
+   * Load the weights of the network from the given file, written by
+   * SaveWeights() for a network built in the same way.  The whole file is
+   * read at once, which makes this much faster than boost::serialization for
+   * loading a trained network.  A std::runtime_error is thrown if the file
+   * cannot be read or does not match the network.
+   *
+   * @param filename Name of the file to read.
+   */
+  void LoadWeights(const std::string& filename)
+  {
+    WeightBlob blob;
+    CollectWeights<>(network, blob);
+    blob.Load(filename);
+  }
+
+  /**
+   * Serialize the network, by serializing each of the layers which have
+   * parameters.  The network (and so its layers) has to be constructed in the
+   * same way before it is loaded.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    SerializeLayers<>(ar, network);
+  }
+
+  //! Get the parameter policy.
+  const ParameterType& Parameters() const { return parameters; }
+  //! Modify the parameter policy.
+  ParameterType& Parameters() { return parameters; }
+
  private:
+  //! Whether the given layer is updated by its own optimizer, rather than by
+  //! the parameter policy.
+  template<typename T>
+  static bool OwnOptimizer()
+  {
+    return !ParameterType::IsFlat || HasSparseGradient<T>::value;
+  }
+
   /**
    * Reset the network by zeroing the layer activations and by setting the
    * layer status.
@@ -184,10 +298,19 @@ class FFN
   template<size_t I = 0, typename DataType, typename... Tp>
   void Forward(const DataType& input, std::tuple<Tp...>& t)
   {
-    std::get<I>(t).InputParameter() = input;
+    // The input parameters are only needed by the backward pass, so they are
+    // not stored when the network is used for prediction.
+    if (deterministic)
+    {
+      std::get<I>(t).Forward(input, std::get<I>(t).OutputParameter());
+    }
+    else
+    {
+      std::get<I>(t).InputParameter() = input;
 
-    std::get<I>(t).Forward(std::get<I>(t).InputParameter(),
-                           std::get<I>(t).OutputParameter());
+      std::get<I>(t).Forward(std::get<I>(t).InputParameter(),
+                             std::get<I>(t).OutputParameter());
+    }
 
     ForwardTail<I + 1, Tp...>(t);
   }
@@ -196,7 +319,8 @@ class FFN
   typename std::enable_if<I == sizeof...(Tp), void>::type
   ForwardTail(std::tuple<Tp...>& /* unused */)
   {
-    LinkParameter(network);
+    if (!deterministic)
+      LinkParameter(network);
   }
 
   template<size_t I = 1, typename... Tp>
@@ -319,7 +443,8 @@ class FFN
   Update(T& t, P& /* unused */, D& delta)
   {
     t.Gradient(delta, t.Gradient());
-    t.Optimizer().Update();
+    if (OwnOptimizer<T>())
+      t.Optimizer().Update();
   }
 
   template<typename T, typename P, typename D>
@@ -361,8 +486,11 @@ class FFN
       HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
   Apply(T& t, P& /* unused */, D& /* unused */)
   {
-    t.Optimizer().Optimize();
-    t.Optimizer().Reset();
+    if (OwnOptimizer<T>())
+    {
+      t.Optimizer().Optimize();
+      t.Optimizer().Reset();
+    }
   }
 
   template<typename T, typename P, typename D>
@@ -373,6 +501,290 @@ class FFN
     /* Nothing to do here */
   }
 
+  /**
+   * Copy the weights of the layers of the given network into the layers of
+   * this network.
+   *
+   * enable_if (SFINAE) is used to iterate through the network connections.
+   * The general case peels off the first type and recurses, as usual with
+   * variadic function templates.
+   */
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I == Max, void>::type
+  CopyWeights(std::tuple<Tp...>& /* unused */,
+              const std::tuple<Tp...>& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I < Max, void>::type
+  CopyWeights(std::tuple<Tp...>& t, const std::tuple<Tp...>& other)
+  {
+    Copy(std::get<I>(t), std::get<I>(other), std::get<I>(t).OutputParameter(),
+         std::get<I + 1>(t).Delta());
+
+    CopyWeights<I + 1, Max, Tp...>(t, other);
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Copy(T& t, T& other, P& /* unused */, D& /* unused */)
+  {
+    if (OwnOptimizer<T>())
+      t.Weights() = other.Weights();
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      !HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Copy(T& /* unused */, T& /* unused */, P& /* unused */, D& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  /**
+   * Scale the gradients accumulated by the layer optimizers.
+   *
+   * enable_if (SFINAE) is used to iterate through the network connections.
+   * The general case peels off the first type and recurses, as usual with
+   * variadic function templates.
+   */
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I == Max, void>::type
+  ScaleGradients(std::tuple<Tp...>& /* unused */, const double /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I < Max, void>::type
+  ScaleGradients(std::tuple<Tp...>& t, const double factor)
+  {
+    Scale(std::get<I>(t), std::get<I>(t).OutputParameter(),
+          std::get<I + 1>(t).Delta(), factor);
+
+    ScaleGradients<I + 1, Max, Tp...>(t, factor);
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Scale(T& t, P& /* unused */, D& /* unused */, const double factor)
+  {
+    if (OwnOptimizer<T>())
+      t.Optimizer().Gradient() *= factor;
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      !HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Scale(T& /* unused */, P& /* unused */, D& /* unused */,
+        const double /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  /**
+   * Move the gradients accumulated by the layer optimizers of the given
+   * network into the layer optimizers of this network.
+   *
+   * enable_if (SFINAE) is used to iterate through the network connections.
+   * The general case peels off the first type and recurses, as usual with
+   * variadic function templates.
+   */
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I == Max, void>::type
+  MergeGradients(std::tuple<Tp...>& /* unused */,
+                 std::tuple<Tp...>& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I < Max, void>::type
+  MergeGradients(std::tuple<Tp...>& t, std::tuple<Tp...>& other)
+  {
+    Merge(std::get<I>(t), std::get<I>(other), std::get<I>(t).OutputParameter(),
+          std::get<I + 1>(t).Delta());
+
+    MergeGradients<I + 1, Max, Tp...>(t, other);
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      HasGradientCheck<T, void(T::*)(const D&, P&)>::value &&
+      !HasSparseGradient<T>::value, void>::type
+  Merge(T& t, T& other, P& /* unused */, D& /* unused */)
+  {
+    // The gradient storage of an optimizer is empty until its first update.
+    if (!OwnOptimizer<T>() || other.Optimizer().Gradient().n_elem == 0)
+      return;
+
+    if (t.Optimizer().Gradient().n_elem == 0)
+      t.Optimizer().Gradient() = other.Optimizer().Gradient();
+    else
+      t.Optimizer().Gradient() += other.Optimizer().Gradient();
+
+    other.Optimizer().Reset();
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      HasGradientCheck<T, void(T::*)(const D&, P&)>::value &&
+      HasSparseGradient<T>::value, void>::type
+  Merge(T& t, T& other, P& /* unused */, D& /* unused */)
+  {
+    // A sparse gradient holds only the columns it touched, so the columns of
+    // the two gradients are merged by index.
+    AddSparseGradient(t.Optimizer().Gradient(), t.Optimizer().GradientIndices(),
+        other.Optimizer().Gradient(), other.Optimizer().GradientIndices());
+
+    other.Optimizer().Reset();
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      !HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Merge(T& /* unused */, T& /* unused */, P& /* unused */, D& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  /**
+   * Add the weights of the layers to the given weight blob.
+   *
+   * enable_if (SFINAE) is used to iterate through the network connections.
+   * The general case peels off the first type and recurses, as usual with
+   * variadic function templates.
+   */
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I == Max, void>::type
+  CollectWeights(std::tuple<Tp...>& /* unused */, WeightBlob& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I < Max, void>::type
+  CollectWeights(std::tuple<Tp...>& t, WeightBlob& blob)
+  {
+    Collect(std::get<I>(t), std::get<I>(t).OutputParameter(),
+            std::get<I + 1>(t).Delta(), blob);
+
+    CollectWeights<I + 1, Max, Tp...>(t, blob);
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Collect(T& t, P& /* unused */, D& /* unused */, WeightBlob& blob)
+  {
+    blob.Add(t.Weights());
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      !HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Collect(T& /* unused */, P& /* unused */, D& /* unused */,
+          WeightBlob& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  /**
+   * Add the weights and gradients of the layers to the parameter policy,
+   * except those of the layers with a sparse gradient.
+   *
+   * enable_if (SFINAE) is used to iterate through the network connections.
+   * The general case peels off the first type and recurses, as usual with
+   * variadic function templates.
+   */
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I == Max, void>::type
+  CollectParameters(std::tuple<Tp...>& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I < Max, void>::type
+  CollectParameters(std::tuple<Tp...>& t)
+  {
+    CollectParameter(std::get<I>(t), std::get<I>(t).OutputParameter(),
+                     std::get<I + 1>(t).Delta());
+
+    CollectParameters<I + 1, Max, Tp...>(t);
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  CollectParameter(T& t, P& /* unused */, D& /* unused */)
+  {
+    if (!OwnOptimizer<T>())
+      parameters.Add(t.Weights(), t.Gradient());
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      !HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  CollectParameter(T& /* unused */, P& /* unused */, D& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  /**
+   * Serialize each of the layers which have a Serialize() function.
+   *
+   * enable_if (SFINAE) is used to iterate through the network layer.
+   * The general case peels off the first type and recurses, as usual with
+   * variadic function templates.
+   */
+  template<size_t I = 0, typename Archive, typename... Tp>
+  typename std::enable_if<I == sizeof...(Tp), void>::type
+  SerializeLayers(Archive& /* unused */, std::tuple<Tp...>& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  template<size_t I = 0, typename Archive, typename... Tp>
+  typename std::enable_if<I < sizeof...(Tp), void>::type
+  SerializeLayers(Archive& ar, std::tuple<Tp...>& t)
+  {
+    SerializeLayer(ar, std::get<I>(t), I);
+    SerializeLayers<I + 1, Archive, Tp...>(ar, t);
+  }
+
+  template<typename Archive, typename T>
+  typename std::enable_if<data::HasSerialize<T>::value, void>::type
+  SerializeLayer(Archive& ar, T& layer, const size_t i)
+  {
+    std::ostringstream oss;
+    oss << "layer" << i;
+    ar & data::CreateNVP(layer, oss.str());
+  }
+
+  template<typename Archive, typename T>
+  typename std::enable_if<!data::HasSerialize<T>::value, void>::type
+  SerializeLayer(Archive& /* unused */,
+                 T& /* unused */,
+                 const size_t /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
   /*
    * Calculate and store the output activation.
    */
@@ -395,16 +807,20 @@ class FFN
 
   //! The current evaluation mode (training or testing).
   bool deterministic;
+
+  //! The weights and gradients of the layers, if they are kept together.
+  ParameterType parameters;
 }; // class FFN
 
 //! Network traits for the FFN network.
 template <
   typename LayerTypes,
   typename OutputLayerType,
-  class PerformanceFunction
+  class PerformanceFunction,
+  class ParameterType
 >
 class NetworkTraits<
-    FFN<LayerTypes, OutputLayerType, PerformanceFunction> >
+    FFN<LayerTypes, OutputLayerType, PerformanceFunction, ParameterType> >
 {
  public:
   static const bool IsFNN = true;
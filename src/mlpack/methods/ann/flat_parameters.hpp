@@ -0,0 +1,374 @@
+/**
+ * @file flat_parameters.hpp
+ * @author Ryan Curtin
+ *
+ * Definition of the LayerParameters and FlatParameters classes, which decide
+ * where the FFN class keeps the weights and gradients of its layers, and how
+ * it updates them.
+ */
+#ifndef __MLPACK_METHODS_ANN_FLAT_PARAMETERS_HPP
+#define __MLPACK_METHODS_ANN_FLAT_PARAMETERS_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/ann/optimizer/rmsprop.hpp>
+
+#include <new>
+
+namespace mlpack {
+namespace ann /** Artificial Neural Network. */ {
+
+/**
+ * The default parameter policy of the FFN class: each layer keeps its own
+ * weights and gradients, and is updated by its own optimizer.
+ */
+class LayerParameters
+{
+ public:
+  //! The layers are updated by their own optimizers.
+  static const bool IsFlat = false;
+
+  //! Nothing to do: the layers keep their weights.
+  template<typename WeightsType, typename GradientType>
+  void Add(WeightsType& /* weights */, GradientType& /* gradient */) { }
+
+  //! Nothing to do: the layers keep their weights.
+  void Allocate() { }
+
+  //! Nothing to do: the layer optimizers sum up the gradients.
+  void Update() { }
+
+  //! Nothing to do: the layer optimizers update the weights.
+  void Optimize() { }
+
+  //! Nothing to do: the layer optimizers reset their gradients.
+  void Reset() { }
+
+  //! Nothing to do: the layer optimizers scale their gradients.
+  void Scale(const double /* factor */) { }
+
+  //! Nothing to do: the layer optimizers merge their gradients.
+  void Merge(LayerParameters& /* other */) { }
+
+  //! Nothing to do: the layers copy their weights.
+  void Copy(const LayerParameters& /* other */) { }
+};
+
+/**
+ * A parameter policy of the FFN class that moves the weights and gradients of
+ * all layers into two contiguous buffers, one column each, and updates the
+ * whole network with a single optimizer over those buffers.  The weights and
+ * the gradient of each layer become views into the buffers (each block starts
+ * a multiple of 64 bytes into the buffer, and the padding between blocks is
+ * zero), so the layers compute and use them as before.  Summing up, scaling
+ * and merging the gradients of the network (for example with those of the
+ * replicas of the Trainer), and the optimizer step itself, are then each one
+ * pass over contiguous memory, instead of one call for each layer.
+ *
+ * The layers must not change the size of their weights or gradients while
+ * they are views (Armadillo throws an exception if they try); the weights of
+ * a loaded model have to be loaded into a network of the same structure, as
+ * usual.  Layers with a sparse gradient (see HasSparseGradient) are left out,
+ * and keep their own optimizers.  When the FlatParameters object is destroyed,
+ * the layers get their own copy of their weights back.
+ *
+ * @code
+ * FFN<decltype(modules), decltype(outputLayer), MeanSquaredErrorFunction,
+ *     FlatParameters<Adam> > net(modules, outputLayer);
+ * @endcode
+ *
+ * @tparam OptimizerType Type of the optimizer used to update the weights.
+ */
+template<
+    template<typename, typename> class OptimizerType = mlpack::ann::RMSPROP
+>
+class FlatParameters
+{
+ public:
+  //! The layers are updated as a whole.
+  static const bool IsFlat = true;
+
+  /**
+   * Create the FlatParameters object and its optimizer.  No layer is added.
+   */
+  FlatParameters() :
+      optimizer(new OptimizerType<FlatParameters<OptimizerType>, arma::mat>(
+          *this))
+  {
+    // Nothing to do here.
+  }
+
+  /**
+   * Give the layers their weights back, and delete the optimizer.
+   */
+  ~FlatParameters()
+  {
+    Release();
+    delete optimizer;
+  }
+
+  /**
+   * Add the given weights and gradient of a layer; they have to have the same
+   * size.  They are moved into the buffers by Allocate().
+   *
+   * @param weights Weights of the layer.
+   * @param gradient Gradient of the layer.
+   */
+  void Add(arma::mat& weights, arma::mat& gradient)
+  {
+    blocks.push_back(Block(&weights, &gradient, NULL, NULL, weights.n_rows,
+        weights.n_cols, 1));
+  }
+
+  /**
+   * Add the given weights and gradient of a layer, as 3rd order tensors; they
+   * have to have the same size.  They are moved into the buffers by
+   * Allocate().
+   *
+   * @param weights Weights of the layer.
+   * @param gradient Gradient of the layer.
+   */
+  void Add(arma::cube& weights, arma::cube& gradient)
+  {
+    blocks.push_back(Block(NULL, NULL, &weights, &gradient, weights.n_rows,
+        weights.n_cols, weights.n_slices));
+  }
+
+  /**
+   * Allocate the buffers, copy the current weights of the added layers into
+   * them, and make the weights and gradients of the layers views into the
+   * buffers.  The gradients start at zero.
+   */
+  void Allocate()
+  {
+    size_t size = 0;
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+      blocks[i].offset = size;
+      size += Padded(blocks[i].rows * blocks[i].cols * blocks[i].slices);
+    }
+
+    weights.zeros(size, 1);
+    gradient.zeros(size, 1);
+
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+      Block& b = blocks[i];
+      double* weightsMemory = weights.memptr() + b.offset;
+      double* gradientMemory = gradient.memptr() + b.offset;
+      if (b.matrix != NULL)
+      {
+        std::copy(b.matrix->memptr(), b.matrix->memptr() + b.matrix->n_elem,
+            weightsMemory);
+        Alias(*b.matrix, weightsMemory, b.rows, b.cols);
+        Alias(*b.matrixGradient, gradientMemory, b.rows, b.cols);
+      }
+      else
+      {
+        std::copy(b.cube->memptr(), b.cube->memptr() + b.cube->n_elem,
+            weightsMemory);
+        Alias(*b.cube, weightsMemory, b.rows, b.cols, b.slices);
+        Alias(*b.cubeGradient, gradientMemory, b.rows, b.cols, b.slices);
+      }
+    }
+  }
+
+  /**
+   * Give each layer its own copy of its weights and gradient again, and empty
+   * the buffers.
+   */
+  void Release()
+  {
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+      Block& b = blocks[i];
+      if (b.matrix != NULL)
+      {
+        Own(*b.matrix);
+        Own(*b.matrixGradient);
+      }
+      else
+      {
+        Own(*b.cube);
+        Own(*b.cubeGradient);
+      }
+    }
+
+    blocks.clear();
+    weights.reset();
+    gradient.reset();
+  }
+
+  /*
+   * Sum up the gradients of all layers.
+   */
+  void Update() { optimizer->Update(); }
+
+  /*
+   * Update the weights of all layers with the summed up gradients.
+   */
+  void Optimize() { optimizer->Optimize(); }
+
+  /*
+   * Reset the summed up gradients.
+   */
+  void Reset() { optimizer->Reset(); }
+
+  /**
+   * Scale the summed up gradients by the given factor.
+   *
+   * @param factor Factor the summed up gradients are multiplied with.
+   */
+  void Scale(const double factor) { optimizer->Gradient() *= factor; }
+
+  /**
+   * Add the summed up gradients of the given parameters, which have to hold
+   * the layers of a network of the same structure, and reset them.
+   *
+   * @param other Parameters to take the summed up gradients from.
+   */
+  void Merge(FlatParameters& other)
+  {
+    // The gradient storage of an optimizer is empty until its first update.
+    if (other.Optimizer().Gradient().n_elem == 0)
+      return;
+
+    if (optimizer->Gradient().n_elem == 0)
+      optimizer->Gradient() = other.Optimizer().Gradient();
+    else
+      optimizer->Gradient() += other.Optimizer().Gradient();
+
+    other.Reset();
+  }
+
+  /**
+   * Copy the weights of the given parameters, which have to hold the layers
+   * of a network of the same structure.
+   *
+   * @param other Parameters to copy the weights from.
+   */
+  void Copy(const FlatParameters& other)
+  {
+    // The layers hold views into the buffer, so the weights are copied into
+    // its memory.
+    if (other.Weights().n_elem != weights.n_elem)
+    {
+      std::ostringstream oss;
+      oss << "FlatParameters::Copy(): the other network has "
+          << other.Weights().n_elem << " parameters, but this one has "
+          << weights.n_elem;
+      throw std::invalid_argument(oss.str());
+    }
+
+    std::copy(other.Weights().memptr(), other.Weights().memptr() +
+        weights.n_elem, weights.memptr());
+  }
+
+  //! Get the optimizer.
+  OptimizerType<FlatParameters<OptimizerType>, arma::mat>& Optimizer() const
+  {
+    return *optimizer;
+  }
+  //! Modify the optimizer.
+  OptimizerType<FlatParameters<OptimizerType>, arma::mat>& Optimizer()
+  {
+    return *optimizer;
+  }
+
+  //! Get the weights of all layers.
+  const arma::mat& Weights() const { return weights; }
+  //! Modify the weights of all layers.
+  arma::mat& Weights() { return weights; }
+
+  //! Get the gradients of all layers.
+  const arma::mat& Gradient() const { return gradient; }
+  //! Modify the gradients of all layers.
+  arma::mat& Gradient() { return gradient; }
+
+ private:
+  // The parameters are neither copyable nor assignable, since the layers hold
+  // views into the buffers.
+  FlatParameters(const FlatParameters& other);
+  FlatParameters& operator=(const FlatParameters& other);
+
+  //! The weights and gradient of one layer.
+  struct Block
+  {
+    Block(arma::mat* matrix,
+          arma::mat* matrixGradient,
+          arma::cube* cube,
+          arma::cube* cubeGradient,
+          const size_t rows,
+          const size_t cols,
+          const size_t slices) :
+        matrix(matrix), matrixGradient(matrixGradient), cube(cube),
+        cubeGradient(cubeGradient), rows(rows), cols(cols), slices(slices),
+        offset(0) { }
+
+    //! The weights of the layer, if they are a matrix.
+    arma::mat* matrix;
+    //! The gradient of the layer, if it is a matrix.
+    arma::mat* matrixGradient;
+    //! The weights of the layer, if they are a cube.
+    arma::cube* cube;
+    //! The gradient of the layer, if it is a cube.
+    arma::cube* cubeGradient;
+    //! The size of the weights.
+    size_t rows, cols, slices;
+    //! The position of the block in the buffers.
+    size_t offset;
+  };
+
+  //! Round the given number of elements up to a multiple of 64 bytes.
+  static size_t Padded(const size_t elements)
+  {
+    const size_t alignment = 64 / sizeof(double);
+    return (elements + alignment - 1) / alignment * alignment;
+  }
+
+  //! Make the given matrix a view of the given memory.
+  static void Alias(arma::mat& m,
+                    double* memory,
+                    const size_t rows,
+                    const size_t cols)
+  {
+    m.~Mat();
+    new (&m) arma::mat(memory, rows, cols, false, true);
+  }
+
+  //! Make the given cube a view of the given memory.
+  static void Alias(arma::cube& c,
+                    double* memory,
+                    const size_t rows,
+                    const size_t cols,
+                    const size_t slices)
+  {
+    c.~Cube();
+    new (&c) arma::cube(memory, rows, cols, slices, false, true);
+  }
+
+  //! Give the given matrix (or cube) its own copy of its elements.
+  template<typename MatType>
+  static void Own(MatType& m)
+  {
+    const MatType copy(m);
+    m.~MatType();
+    new (&m) MatType(copy);
+  }
+
+  //! The weights and gradients of the layers.
+  std::vector<Block> blocks;
+
+  //! The weights of all layers.
+  arma::mat weights;
+
+  //! The gradients of all layers.
+  arma::mat gradient;
+
+  //! Locally-stored pointer to the optimzer object.
+  OptimizerType<FlatParameters<OptimizerType>, arma::mat>* optimizer;
+}; // class FlatParameters
+
+}; // namespace ann
+}; // namespace mlpack
+
+#endif
@@ -61,7 +61,8 @@ class KathirvalavakumarSubavathiInitialization
   KathirvalavakumarSubavathiInitialization(const arma::Mat<eT>& data,
                                            const double s) : s(s)
   {
-    dataSum = arma::sum(data + data);
+    // The sums are kept in double precision, whatever the type of the data.
+    dataSum = arma::conv_to<arma::rowvec>::from(arma::sum(data + data));
   }
 
   /**
@@ -75,7 +76,7 @@ class KathirvalavakumarSubavathiInitialization
   template<typename eT>
   void Initialize(arma::Mat<eT>& W, const size_t rows, const size_t cols)
   {
-    arma::Row<eT> b = s * arma::sqrt(3 / (rows * dataSum));
+    arma::rowvec b = s * arma::sqrt(3 / (rows * dataSum));
     const double theta = b.min();
 
     RandomInitialization randomInit(-theta, theta);
@@ -104,7 +105,7 @@ class KathirvalavakumarSubavathiInitialization
 
  private:
   //! Parameter that defines the sum of elements in each column.
-  arma::colvec dataSum;
+  arma::rowvec dataSum;
 
   //! Parameter that defines the active region.
   const double s;
@@ -78,9 +78,9 @@ class BaseLayer
                 const DataType& gy,
                 DataType& g)
   {
-    DataType derivative;
-    ActivationFunction::deriv(input, derivative);
-    g = gy % derivative;
+    // The derivative is computed in place, so that no temporary is needed.
+    ActivationFunction::deriv(input, g);
+    g %= gy;
   }
 
   /**
@@ -97,26 +97,19 @@ class BaseLayer
                 const arma::Mat<eT>& gy,
                 arma::Cube<eT>& g)
   {
-    // Generate a cube using the backpropagated error matrix.
-    arma::Cube<eT> mappedError = arma::zeros<arma::cube>(input.n_rows,
-        input.n_cols, input.n_slices);
+    // The derivative is computed in place, and each slice is then multiplied
+    // by the part of the backpropagated error matrix that belongs to it, so
+    // that no temporary is needed.
+    ActivationFunction::deriv(input, g);
 
-    for (size_t s = 0, j = 0; s < mappedError.n_slices; s+= gy.n_cols, j++)
+    for (size_t s = 0, j = 0; s < g.n_slices; s+= gy.n_cols, j++)
     {
       for (size_t i = 0; i < gy.n_cols; i++)
       {
-        arma::Col<eT> temp = gy.col(i).subvec(
-            j * input.n_rows * input.n_cols,
-            (j + 1) * input.n_rows * input.n_cols - 1);
-
-        mappedError.slice(s + i) = arma::Mat<eT>(temp.memptr(),
-            input.n_rows, input.n_cols);
+        g.slice(s + i) %= arma::Mat<eT>(const_cast<eT*>(gy.colptr(i)) + j *
+            g.n_elem_slice, g.n_rows, g.n_cols, false, true);
       }
     }
-
-    arma::Cube<eT> derivative;
-    ActivationFunction::deriv(input, derivative);
-    g = mappedError % derivative;
   }
 
   //! Get the input parameter.
@@ -74,7 +74,8 @@ class BiasLayer
 
   /**
    * Ordinary feed forward pass of a neural network, evaluating the function
-   * f(x) by propagating the activity forward through f.
+   * f(x) by propagating the activity forward through f.  Each column of the
+   * input is one sample of the batch.
    *
    * @param input Input data used for evaluating the specified function.
    * @param output Resulting output activation.
@@ -82,12 +83,18 @@ class BiasLayer
   template<typename eT>
   void Forward(const arma::Mat<eT>& input, arma::Mat<eT>& output)
   {
-    output = input + (weights * bias);
+    // The bias is added to each column in place, so that no repeated copy of
+    // it is needed.
+    output = input;
+    for (size_t i = 0; i < output.n_cols; i++)
+      output.col(i) += weights * bias;
   }
 
   /**
    * Ordinary feed forward pass of a neural network, evaluating the function
-   * f(x) by propagating the activity forward through f.
+   * f(x) by propagating the activity forward through f.  The slices of the
+   * input hold the maps of each sample of the batch (with the sample index
+   * running fastest).
    *
    * @param input Input data used for evaluating the specified function.
    * @param output Resulting output activation.
@@ -95,10 +102,12 @@ class BiasLayer
   template<typename eT>
   void Forward(const arma::Cube<eT>& input, arma::Cube<eT>& output)
   {
+    const size_t batchSize = input.n_slices / outSize;
+
     output = input;
     for (size_t s = 0; s < input.n_slices; s++)
     {
-      output.slice(s) += weights(s) * bias;
+      output.slice(s) += weights(s / batchSize) * bias;
     }
   }
 
@@ -120,7 +129,8 @@ class BiasLayer
   }
 
   /*
-   * Calculate the gradient using the output delta and the bias.
+   * Calculate the gradient using the output delta and the bias.  The gradient
+   * is averaged over the samples of the batch.
    *
    * @param d The calculated error.
    * @param g The calculated gradient.
@@ -128,15 +138,20 @@ class BiasLayer
   template<typename eT>
   void Gradient(const arma::Cube<eT>& d, InputDataType& g)
   {
-    g = arma::Mat<eT>(weights.n_rows, weights.n_cols);
+    const size_t batchSize = d.n_slices / outSize;
+
+    g = arma::zeros<arma::Mat<eT> >(weights.n_rows, weights.n_cols);
     for (size_t s = 0; s < d.n_slices; s++)
     {
-      g(s) = arma::accu(d.slice(s)) * bias;
+      g(s / batchSize) += arma::accu(d.slice(s)) * bias;
     }
+
+    g /= batchSize;
   }
 
   /*
-   * Calculate the gradient using the output delta and the bias.
+   * Calculate the gradient using the output delta and the bias.  The gradient
+   * is averaged over the samples of the batch.
    *
    * @param d The calculated error.
    * @param g The calculated gradient.
@@ -144,7 +159,7 @@ class BiasLayer
   template<typename eT>
   void Gradient(const arma::Mat<eT>& d, InputDataType& g)
   {
-    g = d * bias;
+    g = arma::sum(d, 1) * bias / d.n_cols;
   }
 
   //! Get the optimizer.
@@ -189,6 +204,16 @@ class BiasLayer
   //! Modify the gradient.
   InputDataType& Gradient() { return gradient; }
 
+  /**
+   * Serialize the layer.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(weights, "weights");
+    ar & data::CreateNVP(bias, "bias");
+  }
+
  private:
   //! Locally-stored number of output units.
   const size_t outSize;
@@ -17,6 +17,18 @@
 namespace mlpack {
 namespace ann /** Artificial Neural Network. */ {
 
+// This gives us a HasMapConvolutionCheck<T, U> type (where U is a function
+// pointer) we can use with SFINAE to catch when a convolution rule has a
+// MapConvolution(...) function, which convolves all of the maps of a layer at
+// once.
+HAS_MEM_FUNC(MapConvolution, HasMapConvolutionCheck);
+
+// This gives us a HasMapGradientCheck<T, U> type (where U is a function
+// pointer) we can use with SFINAE to catch when a convolution rule has a
+// MapGradient(...) function, which computes the gradients of all of the
+// filters of a layer at once.
+HAS_MEM_FUNC(MapGradient, HasMapGradientCheck);
+
 /**
  * Implementation of the ConvLayer class. The ConvLayer class represents a
  * single layer of a neural network.
@@ -26,6 +38,13 @@ namespace ann /** Artificial Neural Network. */ {
  * @tparam ForwardConvolutionRule Convolution to perform forward process.
  * @tparam BackwardConvolutionRule Convolution to perform backward process.
  * @tparam GradientConvolutionRule Convolution to calculate gradient.
+ *
+ * The filter of input map i and output map o is slice (i * outMaps + o) of the
+ * weights.  If the convolution rules provide MapConvolution() and
+ * MapGradient() (like Im2colConvolution), all of the maps of the layer are
+ * handled by one call to the rule in each pass; otherwise, the rules are
+ * called for one pair of maps at a time.
+ *
  * @tparam InputDataType Type of the input data (arma::colvec, arma::mat,
  *         arma::sp_mat or arma::cube).
  * @tparam OutputDataType Type of the output data (arma::colvec, arma::mat,
@@ -99,7 +118,9 @@ class ConvLayer
 
   /**
    * Ordinary feed forward pass of a neural network, evaluating the function
-   * f(x) by propagating the activity forward through f.
+   * f(x) by propagating the activity forward through f.  The input may hold a
+   * batch of samples: slice (map * batchSize + i) is the given map of sample
+   * i, and the output is laid out in the same way.
    *
    * @param input Input data used for evaluating the specified function.
    * @param output Resulting output activation.
@@ -107,21 +128,7 @@ class ConvLayer
   template<typename eT>
   void Forward(const arma::Cube<eT>& input, arma::Cube<eT>& output)
   {
-    const size_t wConv = ConvOutSize(input.n_rows, wfilter, xStride, wPad);
-    const size_t hConv = ConvOutSize(input.n_cols, hfilter, yStride, hPad);
-
-    output = arma::zeros<arma::Cube<eT> >(wConv, hConv, outMaps);
-    for (size_t outMap = 0, outMapIdx = 0; outMap < outMaps; outMap++)
-    {
-      for (size_t inMap = 0; inMap < inMaps; inMap++, outMapIdx++)
-      {
-        arma::Mat<eT> convOutput;
-        ForwardConvolutionRule::Convolution(input.slice(inMap),
-            weights.slice(outMap), convOutput);
-
-        output.slice(outMap) += convOutput;
-      }
-    }
+    ForwardMaps(input, output);
   }
 
   /**
@@ -138,28 +145,12 @@ class ConvLayer
                 const arma::Cube<eT>& gy,
                 arma::Cube<eT>& g)
   {
-    g = arma::zeros<arma::Cube<eT> >(inputParameter.n_rows,
-                                     inputParameter.n_cols,
-                                     inputParameter.n_slices);
-
-    for (size_t outMap = 0, outMapIdx = 0; outMap < inMaps; outMap++)
-    {
-      for (size_t inMap = 0; inMap < outMaps; inMap++, outMapIdx++)
-      {
-        arma::Mat<eT> rotatedFilter;
-        Rotate180(weights.slice(outMap * outMaps + inMap), rotatedFilter);
-
-        arma::Mat<eT> output;
-        BackwardConvolutionRule::Convolution(gy.slice(inMap), rotatedFilter,
-            output);
-
-        g.slice(outMap) += output;
-      }
-    }
+    BackwardMaps(gy, g);
   }
 
   /*
    * Calculate the gradient using the output delta and the input activation.
+   * The gradient is averaged over the samples of the batch.
    *
    * @param d The calculated error.
    * @param g The calculated gradient.
@@ -167,23 +158,8 @@ class ConvLayer
   template<typename eT>
   void Gradient(const arma::Cube<eT>& d, arma::Cube<eT>& g)
   {
-    g = arma::zeros<arma::Cube<eT> >(weights.n_rows, weights.n_cols,
-        weights.n_slices);
-
-    for (size_t outMap = 0; outMap < outMaps; outMap++)
-    {
-      for (size_t inMap = 0, s = outMap; inMap < inMaps; inMap++, s += outMaps)
-      {
-        arma::Cube<eT> inputSlices = inputParameter.slices(inMap, inMap);
-        arma::Cube<eT> deltaSlices = d.slices(outMap, outMap);
-
-        arma::Cube<eT> output;
-        GradientConvolutionRule::Convolution(inputSlices, deltaSlices, output);
-
-        for (size_t i = 0; i < output.n_slices; i++)
-          g.slice(s) += output.slice(i);
-      }
-    }
+    GradientMaps(d, g);
+    g /= (d.n_slices / outMaps);
   }
 
   //! Get the optimizer.
@@ -234,7 +210,237 @@ class ConvLayer
   //! Modify the gradient.
   OutputDataType& Gradient() { return gradient; }
 
+  /**
+   * Serialize the layer.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    // Cubes have no serialization operator, so the size is serialized first
+    // and then the elements, as an array.
+    size_t rows = weights.n_rows;
+    size_t cols = weights.n_cols;
+    size_t slices = weights.n_slices;
+    ar & data::CreateNVP(rows, "rows");
+    ar & data::CreateNVP(cols, "cols");
+    ar & data::CreateNVP(slices, "slices");
+
+    if (Archive::is_loading::value)
+      weights.set_size(rows, cols, slices);
+
+    ar & boost::serialization::make_array(weights.memptr(), weights.n_elem);
+  }
+
  private:
+  /*
+   * Run the forward pass with a convolution rule that can convolve all of the
+   * maps of the layer at once (see Im2colConvolution).
+   *
+   * @param input Input data used for evaluating the specified function.
+   * @param output Resulting output activation.
+   */
+  template<typename eT, typename Rule = ForwardConvolutionRule>
+  typename std::enable_if<HasMapConvolutionCheck<Rule,
+      void(*)(const arma::Cube<eT>&, const arma::Cube<eT>&, const size_t,
+      arma::Cube<eT>&)>::value, void>::type
+  ForwardMaps(const arma::Cube<eT>& input, arma::Cube<eT>& output)
+  {
+    Rule::MapConvolution(input, weights, outMaps, output);
+  }
+
+  /*
+   * Run the forward pass one pair of input and output maps at a time.
+   *
+   * @param input Input data used for evaluating the specified function.
+   * @param output Resulting output activation.
+   */
+  template<typename eT, typename Rule = ForwardConvolutionRule>
+  typename std::enable_if<!HasMapConvolutionCheck<Rule,
+      void(*)(const arma::Cube<eT>&, const arma::Cube<eT>&, const size_t,
+      arma::Cube<eT>&)>::value, void>::type
+  ForwardMaps(const arma::Cube<eT>& input, arma::Cube<eT>& output)
+  {
+    const size_t wConv = ConvOutSize(input.n_rows, wfilter, xStride, wPad);
+    const size_t hConv = ConvOutSize(input.n_cols, hfilter, yStride, hPad);
+    const size_t batchSize = input.n_slices / inMaps;
+
+    output = arma::zeros<arma::Cube<eT> >(wConv, hConv, outMaps * batchSize);
+
+    // Each output slice (one output map of one sample) is computed by a single
+    // thread, and each thread reuses its own convolution buffer.
+    #pragma omp parallel
+    {
+      arma::Mat<eT> convOutput;
+
+      #pragma omp for schedule(static)
+      for (size_t s = 0; s < output.n_slices; s++)
+      {
+        const size_t outMap = s / batchSize;
+        const size_t i = s % batchSize;
+
+        arma::Mat<eT> outputSlice(output.slice_memptr(s), output.n_rows,
+            output.n_cols, false, true);
+        for (size_t inMap = 0; inMap < inMaps; inMap++)
+        {
+          Rule::Convolution(SliceAlias(input, inMap * batchSize + i),
+              SliceAlias(weights, inMap * outMaps + outMap), convOutput);
+
+          outputSlice += convOutput;
+        }
+      }
+    }
+  }
+
+  /*
+   * Run the backward pass with a convolution rule that can convolve all of the
+   * maps of the layer at once.  The delta maps are the input maps of this
+   * convolution, so the rotated filters are reordered to match.
+   *
+   * @param gy The backpropagated error.
+   * @param g The calculated gradient.
+   */
+  template<typename eT, typename Rule = BackwardConvolutionRule>
+  typename std::enable_if<HasMapConvolutionCheck<Rule,
+      void(*)(const arma::Cube<eT>&, const arma::Cube<eT>&, const size_t,
+      arma::Cube<eT>&)>::value, void>::type
+  BackwardMaps(const arma::Cube<eT>& gy, arma::Cube<eT>& g)
+  {
+    rotatedFilters.set_size(weights.n_rows, weights.n_cols, weights.n_slices);
+    for (size_t inMap = 0; inMap < inMaps; inMap++)
+    {
+      for (size_t outMap = 0; outMap < outMaps; outMap++)
+      {
+        Rotate180(weights.slice(inMap * outMaps + outMap),
+            rotatedFilters.slice(outMap * inMaps + inMap));
+      }
+    }
+
+    Rule::MapConvolution(gy, rotatedFilters, inMaps, g);
+  }
+
+  /*
+   * Run the backward pass one pair of input and output maps at a time.
+   *
+   * @param gy The backpropagated error.
+   * @param g The calculated gradient.
+   */
+  template<typename eT, typename Rule = BackwardConvolutionRule>
+  typename std::enable_if<!HasMapConvolutionCheck<Rule,
+      void(*)(const arma::Cube<eT>&, const arma::Cube<eT>&, const size_t,
+      arma::Cube<eT>&)>::value, void>::type
+  BackwardMaps(const arma::Cube<eT>& gy, arma::Cube<eT>& g)
+  {
+    g = arma::zeros<arma::Cube<eT> >(inputParameter.n_rows,
+                                     inputParameter.n_cols,
+                                     inputParameter.n_slices);
+
+    Rotate180(weights, rotatedFilters);
+
+    // Each slice of g (one input map of one sample) is computed by a single
+    // thread, and each thread reuses its own convolution buffer.
+    const size_t batchSize = gy.n_slices / outMaps;
+    #pragma omp parallel
+    {
+      arma::Mat<eT> output;
+
+      #pragma omp for schedule(static)
+      for (size_t s = 0; s < g.n_slices; s++)
+      {
+        const size_t inMap = s / batchSize;
+        const size_t i = s % batchSize;
+
+        arma::Mat<eT> gSlice(g.slice_memptr(s), g.n_rows, g.n_cols, false,
+            true);
+        for (size_t outMap = 0; outMap < outMaps; outMap++)
+        {
+          Rule::Convolution(SliceAlias(gy, outMap * batchSize + i),
+              SliceAlias(rotatedFilters, inMap * outMaps + outMap), output);
+
+          gSlice += output;
+        }
+      }
+    }
+  }
+
+  /*
+   * Calculate the gradient (summed over the batch) with a convolution rule that
+   * can handle all of the maps of the layer at once.
+   *
+   * @param d The calculated error.
+   * @param g The calculated gradient.
+   */
+  template<typename eT, typename Rule = GradientConvolutionRule>
+  typename std::enable_if<HasMapGradientCheck<Rule,
+      void(*)(const arma::Cube<eT>&, const arma::Cube<eT>&, const size_t,
+      arma::Cube<eT>&)>::value, void>::type
+  GradientMaps(const arma::Cube<eT>& d, arma::Cube<eT>& g)
+  {
+    Rule::MapGradient(inputParameter, d, outMaps, g);
+  }
+
+  /*
+   * Calculate the gradient (summed over the batch) one pair of input and output
+   * maps at a time.
+   *
+   * @param d The calculated error.
+   * @param g The calculated gradient.
+   */
+  template<typename eT, typename Rule = GradientConvolutionRule>
+  typename std::enable_if<!HasMapGradientCheck<Rule,
+      void(*)(const arma::Cube<eT>&, const arma::Cube<eT>&, const size_t,
+      arma::Cube<eT>&)>::value, void>::type
+  GradientMaps(const arma::Cube<eT>& d, arma::Cube<eT>& g)
+  {
+    g = arma::zeros<arma::Cube<eT> >(weights.n_rows, weights.n_cols,
+        weights.n_slices);
+
+    // Each filter gradient (one pair of input and output maps) is computed by a
+    // single thread, and each thread reuses its own convolution buffers.
+    const size_t batchSize = d.n_slices / outMaps;
+    #pragma omp parallel
+    {
+      arma::Cube<eT> inputSlices, deltaSlices, output;
+
+      #pragma omp for schedule(static)
+      for (size_t s = 0; s < g.n_slices; s++)
+      {
+        const size_t inMap = s / outMaps;
+        const size_t outMap = s % outMaps;
+
+        arma::Mat<eT> gSlice(g.slice_memptr(s), g.n_rows, g.n_cols, false,
+            true);
+        for (size_t b = 0; b < batchSize; b++)
+        {
+          inputSlices = inputParameter.slices(inMap * batchSize + b,
+              inMap * batchSize + b);
+          deltaSlices = d.slices(outMap * batchSize + b,
+              outMap * batchSize + b);
+
+          Rule::Convolution(inputSlices, deltaSlices, output);
+
+          for (size_t i = 0; i < output.n_slices; i++)
+            gSlice += SliceAlias(output, i);
+        }
+      }
+    }
+  }
+
+  /*
+   * Create a read-only matrix which uses the memory of the given slice of a
+   * cube.  This is used instead of Cube::slice() in the parallel loops, since
+   * slice() may create the matrix object of the slice on first use, which is
+   * not safe when several threads access the same cube.
+   *
+   * @param cube The cube to take the slice of.
+   * @param s Index of the slice.
+   */
+  template<typename eT>
+  static arma::Mat<eT> SliceAlias(const arma::Cube<eT>& cube, const size_t s)
+  {
+    return arma::Mat<eT>(const_cast<eT*>(cube.slice_memptr(s)), cube.n_rows,
+        cube.n_cols, false, true);
+  }
+
   /*
    * Rotates a 3rd-order tesor counterclockwise by 180 degrees.
    *
@@ -244,7 +450,7 @@ class ConvLayer
   template<typename eT>
   void Rotate180(const arma::Cube<eT>& input, arma::Cube<eT>& output)
   {
-    output = arma::Cube<eT>(input.n_rows, input.n_cols, input.n_slices);
+    output.set_size(input.n_rows, input.n_cols, input.n_slices);
 
     // * left-right flip, up-down flip */
     for (size_t s = 0; s < output.n_slices; s++)
@@ -320,6 +526,9 @@ class ConvLayer
   //! Locally-stored output parameter object.
   OutputDataType outputParameter;
 
+  //! Locally-stored workspace for the rotated filters of the backward pass.
+  OutputDataType rotatedFilters;
+
   //! Locally-stored pointer to the optimzer object.
   OptimizerType<ConvLayer<OptimizerType,
                           WeightInitRule,
@@ -23,6 +23,10 @@ namespace ann /** Artificial Neural Network. */ {
  * Note: During training you should set deterministic to false and during
  * testing you should set deterministic to true.
  *
+ * Each layer draws its masks from its own counter-based random stream (see
+ * math::RandomStream), one bit per element, and keeps only those bits for the
+ * backward pass.
+ *
  * For more information, see the following.
  *
  * @code
@@ -61,7 +65,8 @@ class DropoutLayer
                const bool rescale = true) :
       ratio(ratio),
       scale(1.0 / (1.0 - ratio)),
-      rescale(rescale)
+      rescale(rescale),
+      stream(math::NewRandomStream())
   {
     // Nothing to do here.
   }
@@ -92,9 +97,9 @@ class DropoutLayer
     {
       // Scale with input / (1 - ratio) and set values to zero with probability
       // ratio.
-      mask = arma::randu<arma::Mat<eT> >(input.n_rows, input.n_cols);
-      mask.transform( [&](double val) { return (val > ratio); } );
-      output = input % mask * scale;
+      stream.Bernoulli(input.n_elem, 1.0 - ratio, mask);
+      output.copy_size(input);
+      ApplyMask(input.memptr(), input.n_elem, output.memptr());
     }
   }
 
@@ -124,10 +129,9 @@ class DropoutLayer
     {
       // Scale with input / (1 - ratio) and set values to zero with probability
       // ratio.
-      mask = arma::randu<arma::Cube<eT> >(input.n_rows, input.n_cols,
-          input.n_slices);
-      mask.transform( [&](double val) { return (val > ratio); } );
-      output = input % mask * scale;
+      stream.Bernoulli(input.n_elem, 1.0 - ratio, mask);
+      output.copy_size(input);
+      ApplyMask(input.memptr(), input.n_elem, output.memptr());
     }
   }
 
@@ -143,7 +147,8 @@ class DropoutLayer
                 const DataType& gy,
                 DataType& g)
   {
-    g = gy % mask * scale;
+    g.copy_size(gy);
+    ApplyMask(gy.memptr(), gy.n_elem, g.memptr());
   }
 
   //! Get the input parameter.
@@ -182,6 +187,31 @@ class DropoutLayer
   bool& Rescale() {return rescale; }
 
  private:
+  /*
+   * Multiply the kept elements of the given memory with the scale, and set the
+   * other ones to zero, as given by the mask.
+   *
+   * @param input Elements to apply the mask to.
+   * @param n Number of elements.
+   * @param output Memory to store the result in.
+   */
+  template<typename eT>
+  void ApplyMask(const eT* input, const size_t n, eT* output) const
+  {
+    // Selecting the factor with the bit, instead of branching on it, lets the
+    // inner loop be vectorized.
+    const eT factors[2] = { 0, (eT) scale };
+
+    #pragma omp parallel for schedule(static) if (n > 65536)
+    for (size_t w = 0; w < mask.size(); ++w)
+    {
+      const uint64_t bits = mask[w];
+      const size_t end = std::min(n - 64 * w, (size_t) 64);
+      for (size_t b = 0; b < end; ++b)
+        output[64 * w + b] = input[64 * w + b] * factors[(bits >> b) & 1];
+    }
+  }
+
   //! Locally-stored delta object.
   OutputDataType delta;
 
@@ -191,8 +221,9 @@ class DropoutLayer
   //! Locally-stored output parameter object.
   OutputDataType outputParameter;
 
-  //! Locally-stored mast object.
-  OutputDataType mask;
+  //! Locally-stored mask, one bit per element of the last input (a set bit
+  //! keeps the element).
+  std::vector<uint64_t> mask;
 
   //! The probability of setting a value to zero.
   double ratio;
@@ -205,6 +236,9 @@ class DropoutLayer
 
   //! If true the input is rescaled when deterministic is False.
   bool rescale;
+
+  //! Locally-stored random stream the masks are drawn from.
+  math::RandomStream stream;
 }; // class DropoutLayer
 
 //! Layer traits for the bias layer.
@@ -0,0 +1,369 @@
+/**
+ * @file embedding_layer.hpp
+ * @author Ryan Curtin
+ *
+ * Definition of the EmbeddingLayer class, which maps integer ids to learned
+ * dense vectors, and whose gradient holds only the vectors of the ids of the
+ * batch.
+ */
+#ifndef __MLPACK_METHODS_ANN_LAYER_EMBEDDING_LAYER_HPP
+#define __MLPACK_METHODS_ANN_LAYER_EMBEDDING_LAYER_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/ann/layer/layer_traits.hpp>
+#include <mlpack/methods/ann/init_rules/random_init.hpp>
+#include <mlpack/methods/ann/optimizer/rmsprop.hpp>
+
+namespace mlpack {
+namespace ann /** Artificial Neural Network. */ {
+
+/**
+ * Implementation of the EmbeddingLayer class.  The layer holds one vector of
+ * the given number of dimensions for each id of the vocabulary, as the columns
+ * of its weight matrix.  This computes the same function as a LinearLayer on
+ * one-hot encoded inputs, but without forming them: the forward pass is a
+ * lookup, and the gradient holds only the columns of the ids of the batch (see
+ * HasSparseGradient), so that the optimizers that support it (Adam and
+ * RMSPROP) update only those columns.
+ *
+ * The input is either a dense matrix of ids, one column per sample (each row
+ * of the input is one position, and the output of a sample is the
+ * concatenation of the vectors of its ids), or a sparse matrix with one row per
+ * id of the vocabulary, whose output is the weighted sum of the vectors of its
+ * nonzero rows.
+ *
+ * @tparam OptimizerType Type of the optimizer used to update the weights.
+ * @tparam WeightInitRule Rule used to initialize the weight matrix.
+ * @tparam InputDataType Type of the input data (arma::mat or arma::sp_mat).
+ * @tparam OutputDataType Type of the output data (arma::mat).
+ */
+template <
+    template<typename, typename> class OptimizerType = mlpack::ann::RMSPROP,
+    class WeightInitRule = RandomInitialization,
+    typename InputDataType = arma::mat,
+    typename OutputDataType = arma::mat
+>
+class EmbeddingLayer
+{
+ public:
+  /**
+   * Create the EmbeddingLayer object using the specified vocabulary size and
+   * number of dimensions.
+   *
+   * @param vocabSize The number of ids.
+   * @param dimensions The number of dimensions of the vector of each id.
+   * @param WeightInitRule The weight initialization rule used to initialize the
+   *        weight matrix.
+   */
+  EmbeddingLayer(const size_t vocabSize,
+                 const size_t dimensions,
+                 WeightInitRule weightInitRule = WeightInitRule()) :
+      vocabSize(vocabSize),
+      dimensions(dimensions),
+      optimizer(new OptimizerType<EmbeddingLayer<OptimizerType,
+                                                 WeightInitRule,
+                                                 InputDataType,
+                                                 OutputDataType>,
+                                                 OutputDataType>(*this)),
+      ownsOptimizer(true)
+  {
+    weightInitRule.Initialize(weights, dimensions, vocabSize);
+  }
+
+  /**
+   * Delete the embedding layer object and its optimizer.
+   */
+  ~EmbeddingLayer()
+  {
+    if (ownsOptimizer)
+      delete optimizer;
+  }
+
+  /**
+   * Ordinary feed forward pass of a neural network: look up the vectors of the
+   * ids of each column of the input, and concatenate them.
+   *
+   * @param input Input ids, one column per sample.
+   * @param output Resulting output activation.
+   */
+  template<typename eT>
+  void Forward(const arma::Mat<eT>& input, arma::Mat<eT>& output)
+  {
+    output.set_size(dimensions * input.n_rows, input.n_cols);
+
+    for (size_t i = 0; i < input.n_cols; i++)
+    {
+      for (size_t j = 0; j < input.n_rows; j++)
+      {
+        const size_t id = Id(input(j, i));
+        std::copy(weights.colptr(id), weights.colptr(id) + dimensions,
+            output.colptr(i) + j * dimensions);
+      }
+    }
+  }
+
+  /**
+   * Ordinary feed forward pass of a neural network: sum the vectors of the
+   * nonzero rows of each column of the input, weighted by their values.
+   *
+   * @param input Input data, with one row per id.
+   * @param output Resulting output activation.
+   */
+  template<typename eT>
+  void Forward(const arma::SpMat<eT>& input, arma::Mat<eT>& output)
+  {
+    output = weights * input;
+  }
+
+  /**
+   * Ordinary feed backward pass of a neural network.  The input of the layer
+   * consists of ids, so there is no error to propagate further, and the
+   * result is zero.
+   *
+   * @param input The propagated input activation.
+   * @param gy The backpropagated error.
+   * @param g The calculated gradient.
+   */
+  template<typename InputType, typename eT>
+  void Backward(const InputType& /* unused */,
+                const arma::Mat<eT>& /* gy */,
+                arma::Mat<eT>& g)
+  {
+    g.zeros(inputParameter.n_rows, inputParameter.n_cols);
+  }
+
+  /*
+   * Calculate the gradient using the output delta and the input ids.  Only
+   * the columns of the ids of the batch are stored, with their indices in
+   * GradientIndices().  The gradient is averaged over the samples of the
+   * batch.
+   *
+   * @param d The calculated error.
+   * @param g The calculated gradient.
+   */
+  template<typename eT, typename GradientDataType>
+  void Gradient(const arma::Mat<eT>& d, GradientDataType& g)
+  {
+    GradientDelta(inputParameter, d, g);
+  }
+
+  //! Get the optimizer.
+  OptimizerType<EmbeddingLayer<OptimizerType,
+                               WeightInitRule,
+                               InputDataType,
+                               OutputDataType>, OutputDataType>&
+  Optimizer() const
+  {
+    return *optimizer;
+  }
+  //! Modify the optimizer.
+  OptimizerType<EmbeddingLayer<OptimizerType,
+                               WeightInitRule,
+                               InputDataType,
+                               OutputDataType>, OutputDataType>& Optimizer()
+  {
+    return *optimizer;
+  }
+
+  //! Get the weights.
+  OutputDataType& Weights() const { return weights; }
+  //! Modify the weights.
+  OutputDataType& Weights() { return weights; }
+
+  //! Get the input parameter.
+  InputDataType& InputParameter() const {return inputParameter; }
+  //! Modify the input parameter.
+  InputDataType& InputParameter() { return inputParameter; }
+
+  //! Get the output parameter.
+  OutputDataType& OutputParameter() const {return outputParameter; }
+  //! Modify the output parameter.
+  OutputDataType& OutputParameter() { return outputParameter; }
+
+  //! Get the delta.
+  OutputDataType& Delta() const {return delta; }
+  //! Modify the delta.
+  OutputDataType& Delta() { return delta; }
+
+  //! Get the gradient.
+  OutputDataType& Gradient() const {return gradient; }
+  //! Modify the gradient.
+  OutputDataType& Gradient() { return gradient; }
+
+  //! Get the indices of the columns of the gradient.
+  const arma::uvec& GradientIndices() const { return gradientIndices; }
+  //! Modify the indices of the columns of the gradient.
+  arma::uvec& GradientIndices() { return gradientIndices; }
+
+  /**
+   * Serialize the layer.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(weights, "weights");
+  }
+
+ private:
+  /*
+   * Convert an element of the input to an id, and check that it is in the
+   * vocabulary.
+   *
+   * @param value The element of the input.
+   */
+  template<typename eT>
+  size_t Id(const eT value) const
+  {
+    const size_t id = (size_t) value;
+    if (value < 0 || id >= vocabSize)
+    {
+      std::ostringstream oss;
+      oss << "EmbeddingLayer: id " << value << " is not in the vocabulary "
+          << "(which has " << vocabSize << " ids)";
+      throw std::invalid_argument(oss.str());
+    }
+
+    return id;
+  }
+
+  /*
+   * Store the sorted, unique ids of the given list in gradientIndices.
+   *
+   * @param ids The ids of the batch.
+   */
+  void SetIndices(std::vector<size_t>& ids)
+  {
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    gradientIndices.set_size(ids.size());
+    for (size_t i = 0; i < ids.size(); i++)
+      gradientIndices[i] = ids[i];
+  }
+
+  //! Get the column of the given id in the gradient.
+  size_t Column(const size_t id) const
+  {
+    return std::lower_bound(gradientIndices.begin(), gradientIndices.end(),
+        id) - gradientIndices.begin();
+  }
+
+  /*
+   * Calculate the gradient (dense matrix) using the output delta (dense
+   * matrix) and the input ids (dense matrix).
+   *
+   * @param input The input parameter used for calculating the gradient.
+   * @param d The output delta.
+   * @param g The calculated gradient.
+   */
+  template<typename eT>
+  void GradientDelta(const arma::Mat<eT>& input,
+                     const arma::Mat<eT>& d,
+                     arma::Mat<eT>& g)
+  {
+    std::vector<size_t> ids(input.n_elem);
+    for (size_t i = 0; i < input.n_elem; i++)
+      ids[i] = Id(input[i]);
+    SetIndices(ids);
+
+    g.zeros(dimensions, gradientIndices.n_elem);
+    for (size_t i = 0; i < input.n_cols; i++)
+    {
+      for (size_t j = 0; j < input.n_rows; j++)
+      {
+        g.col(Column(Id(input(j, i)))) += d.submat(j * dimensions, i,
+            (j + 1) * dimensions - 1, i);
+      }
+    }
+
+    g /= d.n_cols;
+  }
+
+  /*
+   * Calculate the gradient (dense matrix) using the output delta (dense
+   * matrix) and the input activation (sparse matrix).
+   *
+   * @param input The input parameter used for calculating the gradient.
+   * @param d The output delta.
+   * @param g The calculated gradient.
+   */
+  template<typename eT>
+  void GradientDelta(const arma::SpMat<eT>& input,
+                     const arma::Mat<eT>& d,
+                     arma::Mat<eT>& g)
+  {
+    std::vector<size_t> ids;
+    ids.reserve(input.n_nonzero);
+    for (typename arma::SpMat<eT>::const_iterator it = input.begin();
+         it != input.end(); ++it)
+    {
+      ids.push_back(it.row());
+    }
+    SetIndices(ids);
+
+    g.zeros(dimensions, gradientIndices.n_elem);
+    for (typename arma::SpMat<eT>::const_iterator it = input.begin();
+         it != input.end(); ++it)
+    {
+      g.col(Column(it.row())) += (*it) * d.col(it.col());
+    }
+
+    g /= d.n_cols;
+  }
+
+  //! Locally-stored number of ids.
+  const size_t vocabSize;
+
+  //! Locally-stored number of dimensions of the vector of each id.
+  const size_t dimensions;
+
+  //! Locally-stored weight object.
+  OutputDataType weights;
+
+  //! Locally-stored delta object.
+  OutputDataType delta;
+
+  //! Locally-stored gradient object, with the columns of gradientIndices.
+  OutputDataType gradient;
+
+  //! Locally-stored indices of the columns of the gradient.
+  arma::uvec gradientIndices;
+
+  //! Locally-stored input parameter object.
+  InputDataType inputParameter;
+
+  //! Locally-stored output parameter object.
+  OutputDataType outputParameter;
+
+  //! Locally-stored pointer to the optimzer object.
+  OptimizerType<EmbeddingLayer<OptimizerType,
+                               WeightInitRule,
+                               InputDataType,
+                               OutputDataType>, OutputDataType>* optimizer;
+
+  //! Parameter that indicates if the class owns a optimizer object.
+  bool ownsOptimizer;
+}; // class EmbeddingLayer
+
+//! Layer traits for the embedding layer.
+template<
+    template<typename, typename> class OptimizerType,
+    typename WeightInitRule,
+    typename InputDataType,
+    typename OutputDataType
+>
+class LayerTraits<EmbeddingLayer<
+    OptimizerType, WeightInitRule, InputDataType, OutputDataType> >
+{
+ public:
+  static const bool IsBinary = false;
+  static const bool IsOutputLayer = false;
+  static const bool IsBiasLayer = false;
+  static const bool IsLSTMLayer = false;
+  static const bool IsConnection = true;
+};
+
+}; // namespace ann
+}; // namespace mlpack
+
+#endif
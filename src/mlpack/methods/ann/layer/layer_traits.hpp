@@ -68,6 +68,10 @@ HAS_MEM_FUNC(RecurrentParameter, HasRecurrentParameterCheck);
 // can use with SFINAE to catch when a type has a SeqLen() function.
 HAS_MEM_FUNC(SeqLen, HasSeqLenCheck);
 
+// This gives us a HasCarryStateCheck<T, U> type (where U is a function pointer)
+// we can use with SFINAE to catch when a type has a CarryState() function.
+HAS_MEM_FUNC(CarryState, HasCarryStateCheck);
+
 }; // namespace ann
 }; // namespace mlpack
 
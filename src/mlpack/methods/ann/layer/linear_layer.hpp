@@ -70,7 +70,8 @@ class LinearLayer
 
   /**
    * Ordinary feed forward pass of a neural network, evaluating the function
-   * f(x) by propagating the activity forward through f.
+   * f(x) by propagating the activity forward through f.  Each column of the
+   * input is one sample of the batch.
    *
    * @param input Input data used for evaluating the specified function.
    * @param output Resulting output activation.
@@ -83,7 +84,9 @@ class LinearLayer
 
   /**
    * Ordinary feed forward pass of a neural network, evaluating the function
-   * f(x) by propagating the activity forward through f.
+   * f(x) by propagating the activity forward through f.  The slices of the
+   * input hold the maps of each sample of the batch (with the sample index
+   * running fastest), and each column of the output is one sample.
    *
    * @param input Input data used for evaluating the specified function.
    * @param output Resulting output activation.
@@ -91,18 +94,8 @@ class LinearLayer
   template<typename eT>
   void Forward(const arma::Cube<eT>& input, arma::Mat<eT>& output)
   {
-    arma::Mat<eT> data(input.n_elem, 1);
-
-    for (size_t s = 0, c = 0; s < input.n_slices / data.n_cols; s++)
-    {
-      for (size_t i = 0; i < data.n_cols; i++, c++)
-      {
-        data.col(i).subvec(s * input.n_rows * input.n_cols, (s + 1) *
-            input.n_rows * input.n_cols - 1) = arma::vectorise(input.slice(c));
-      }
-    }
-
-    output = weights * data;
+    MapInput(input, input.n_elem / weights.n_cols);
+    output = weights * mappedInput;
   }
 
   /**
@@ -124,6 +117,7 @@ class LinearLayer
 
   /*
    * Calculate the gradient using the output delta and the input activation.
+   * The gradient is averaged over the samples of the batch.
    *
    * @param d The calculated error.
    * @param g The calculated gradient.
@@ -176,6 +170,15 @@ class LinearLayer
   //! Modify the gradient.
   OutputDataType& Gradient() { return gradient; }
 
+  /**
+   * Serialize the layer.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(weights, "weights");
+  }
+
  private:
    /*
    * Calculate the gradient using the output delta (3rd order tensor) and the
@@ -190,24 +193,8 @@ class LinearLayer
                      const arma::Mat<eT>& d,
                      arma::Cube<eT>& g)
   {
-    g = arma::Cube<eT>(weights.n_rows, weights.n_cols, 1);
-    arma::Mat<eT> data = arma::Mat<eT>(d.n_cols,
-        input.n_elem / d.n_cols);
-
-    for (size_t s = 0, c = 0; s < input.n_slices /
-        data.n_rows; s++)
-    {
-      for (size_t i = 0; i < data.n_rows; i++, c++)
-      {
-        data.row(i).subvec(s * input.n_rows *
-            input.n_cols, (s + 1) *
-            input.n_rows *
-            input.n_cols - 1) = arma::vectorise(
-                input.slice(c), 1);
-      }
-    }
-
-    g.slice(0) = d * data / d.n_cols;
+    g.set_size(weights.n_rows, weights.n_cols, 1);
+    GradientDelta(input, d, g.slice(0));
   }
 
   /*
@@ -223,7 +210,7 @@ class LinearLayer
                      const arma::Mat<eT>& d,
                      arma::Cube<eT>& g)
   {
-    g = arma::Cube<eT>(weights.n_rows, weights.n_cols, 1);
+    g.set_size(weights.n_rows, weights.n_cols, 1);
     Gradient(d, g.slice(0));
   }
 
@@ -236,13 +223,13 @@ class LinearLayer
    * @param g The calculated gradient.
    */
   template<typename eT>
-  void GradientDelta(const arma::Cube<eT>& /* input unused */,
+  void GradientDelta(const arma::Cube<eT>& input,
                      const arma::Mat<eT>& d,
                      arma::Mat<eT>& g)
   {
-    arma::Cube<eT> grad = arma::Cube<eT>(weights.n_rows, weights.n_cols, 1);
-    Gradient(d, grad);
-    g = grad.slice(0);
+    MapInput(input, d.n_cols);
+    g = d * mappedInput.t();
+    g /= d.n_cols;
   }
 
   /*
@@ -258,7 +245,33 @@ class LinearLayer
                      const arma::Mat<eT>& d,
                      arma::Mat<eT>& g)
   {
+    // Dividing in a second step lets the product be written straight into g.
     g = d * input.t();
+    g /= d.n_cols;
+  }
+
+  /*
+   * Store the maps of each sample of the given 3rd order tensor in one column
+   * of the mappedInput workspace.  The workspace keeps its memory between
+   * calls, so nothing is allocated once the batch size is fixed.
+   *
+   * @param input The input maps (with the sample index running fastest).
+   * @param batchSize The number of samples in the input.
+   */
+  template<typename eT>
+  void MapInput(const arma::Cube<eT>& input, const size_t batchSize)
+  {
+    mappedInput.set_size(input.n_elem / batchSize, batchSize);
+
+    for (size_t s = 0, c = 0; s < input.n_slices / batchSize; s++)
+    {
+      for (size_t i = 0; i < batchSize; i++, c++)
+      {
+        std::copy(input.slice_memptr(c), input.slice_memptr(c) +
+            input.n_elem_slice, mappedInput.colptr(i) + s *
+            input.n_elem_slice);
+      }
+    }
   }
 
   //! Locally-stored number of input units.
@@ -282,6 +295,9 @@ class LinearLayer
   //! Locally-stored output parameter object.
   OutputDataType outputParameter;
 
+  //! Locally-stored workspace for the input maps, one sample per column.
+  OutputDataType mappedInput;
+
   //! Locally-stored pointer to the optimzer object.
   OptimizerType<LinearLayer<OptimizerType,
                             WeightInitRule,
@@ -64,6 +64,8 @@ class LSTMLayer
       peepholes(peepholes),
       seqLen(1),
       offset(0),
+      deterministic(false),
+      carryState(false),
       optimizer(new OptimizerType<LSTMLayer<OptimizerType,
                                             GateActivationFunction,
                                             StateActivationFunction,
@@ -102,59 +104,72 @@ class LSTMLayer
   template<typename eT>
   void Forward(const arma::Mat<eT>& input, arma::Mat<eT>& output)
   {
-    if (inGate.n_cols < seqLen)
+    // In inference mode the history of the sequence is not needed for a
+    // backward pass, so only the current step is kept.  The state of the
+    // previous step is kept in prevState either way; with carryState, the first
+    // step continues from the last state of the previous sequence.
+    const size_t steps = deterministic ? 1 : seqLen;
+    const size_t step = offset % steps;
+    const bool hasPrevious = (offset > 0) || (carryState &&
+        prevState.n_elem == outSize);
+
+    if (inGate.n_cols < steps)
     {
-      inGate = arma::zeros<InputDataType>(outSize, seqLen);
-      inGateAct = arma::zeros<InputDataType>(outSize, seqLen);
-      inGateError = arma::zeros<InputDataType>(outSize, seqLen);
-      outGate = arma::zeros<InputDataType>(outSize, seqLen);
-      outGateAct = arma::zeros<InputDataType>(outSize, seqLen);
-      outGateError = arma::zeros<InputDataType>(outSize, seqLen);
-      forgetGate = arma::zeros<InputDataType>(outSize, seqLen);
-      forgetGateAct = arma::zeros<InputDataType>(outSize, seqLen);
-      forgetGateError = arma::zeros<InputDataType>(outSize, seqLen);
-      state = arma::zeros<InputDataType>(outSize, seqLen);
-      stateError = arma::zeros<InputDataType>(outSize, seqLen);
-      cellAct = arma::zeros<InputDataType>(outSize, seqLen);
+      inGate = arma::zeros<InputDataType>(outSize, steps);
+      inGateAct = arma::zeros<InputDataType>(outSize, steps);
+      inGateError = arma::zeros<InputDataType>(outSize, steps);
+      outGate = arma::zeros<InputDataType>(outSize, steps);
+      outGateAct = arma::zeros<InputDataType>(outSize, steps);
+      outGateError = arma::zeros<InputDataType>(outSize, steps);
+      forgetGate = arma::zeros<InputDataType>(outSize, steps);
+      forgetGateAct = arma::zeros<InputDataType>(outSize, steps);
+      forgetGateError = arma::zeros<InputDataType>(outSize, steps);
+      state = arma::zeros<InputDataType>(outSize, steps);
+      stateError = arma::zeros<InputDataType>(outSize, steps);
+      cellAct = arma::zeros<InputDataType>(outSize, steps);
+      stateAct = arma::zeros<InputDataType>(outSize, steps);
     }
 
     // Split up the inputactivation into the 3 parts (inGate, forgetGate,
     // outGate).
-    inGate.col(offset) = input.submat(0, 0, outSize - 1, 0);
-    forgetGate.col(offset) = input.submat(outSize, 0, (outSize * 2) - 1, 0);
-    outGate.col(offset) = input.submat(outSize * 3, 0, (outSize * 4) - 1, 0);
+    inGate.col(step) = input.submat(0, 0, outSize - 1, 0);
+    forgetGate.col(step) = input.submat(outSize, 0, (outSize * 2) - 1, 0);
+    outGate.col(step) = input.submat(outSize * 3, 0, (outSize * 4) - 1, 0);
 
-    if (peepholes && offset > 0)
+    if (peepholes && hasPrevious)
     {
-      inGate.col(offset) += peepholeWeights.slice(0) % state.col(offset - 1);
-      forgetGate.col(offset) += peepholeWeights.slice(1) %
-          state.col(offset - 1);
+      inGate.col(step) += peepholeWeights.slice(0) % prevState;
+      forgetGate.col(step) += peepholeWeights.slice(1) % prevState;
     }
 
-    arma::Col<eT> inGateActivation = inGateAct.unsafe_col(offset);
-    GateActivationFunction::fn(inGate.unsafe_col(offset), inGateActivation);
+    arma::Col<eT> inGateActivation = inGateAct.unsafe_col(step);
+    GateActivationFunction::fn(inGate.unsafe_col(step), inGateActivation);
 
-    arma::Col<eT> forgetGateActivation = forgetGateAct.unsafe_col(offset);
-    GateActivationFunction::fn(forgetGate.unsafe_col(offset),
+    arma::Col<eT> forgetGateActivation = forgetGateAct.unsafe_col(step);
+    GateActivationFunction::fn(forgetGate.unsafe_col(step),
         forgetGateActivation);
 
-    arma::Col<eT> cellActivation = cellAct.unsafe_col(offset);
+    arma::Col<eT> cellActivation = cellAct.unsafe_col(step);
     StateActivationFunction::fn(input.submat(outSize * 2, 0,
         (outSize * 3) - 1, 0), cellActivation);
 
-    state.col(offset) = inGateAct.col(offset) % cellActivation;
+    state.col(step) = inGateAct.col(step) % cellActivation;
 
-    if (offset > 0)
-      state.col(offset) += forgetGateAct.col(offset) % state.col(offset - 1);
+    if (hasPrevious)
+      state.col(step) += forgetGateAct.col(step) % prevState;
+
+    prevState = state.col(step);
 
     if (peepholes)
-      outGate.col(offset) += peepholeWeights.slice(2) % state.col(offset);
+      outGate.col(step) += peepholeWeights.slice(2) % state.col(step);
 
-    arma::Col<eT> outGateActivation = outGateAct.unsafe_col(offset);
-    GateActivationFunction::fn(outGate.unsafe_col(offset), outGateActivation);
+    arma::Col<eT> outGateActivation = outGateAct.unsafe_col(step);
+    GateActivationFunction::fn(outGate.unsafe_col(step), outGateActivation);
 
-    OutputActivationFunction::fn(state.unsafe_col(offset), output);
-    output = outGateAct.col(offset) % output;
+    // The activation of the state is kept for the backward pass.
+    arma::Col<eT> stateActivation = stateAct.unsafe_col(step);
+    OutputActivationFunction::fn(state.unsafe_col(step), stateActivation);
+    output = outGateAct.col(step) % stateAct.col(step);
 
     offset = (offset + 1) % seqLen;
   }
@@ -175,20 +190,20 @@ class LSTMLayer
   {
     size_t queryOffset = seqLen - offset - 1;
 
-    arma::Col<eT> outGateDerivative;
+    // The intermediate results are kept in workspaces, so that nothing is
+    // allocated for each step of the sequence.
     GateActivationFunction::deriv(outGateAct.unsafe_col(queryOffset),
-        outGateDerivative);
-
-    arma::Col<eT> stateActivation;
-    StateActivationFunction::fn(state.unsafe_col(queryOffset), stateActivation);
+        derivative);
 
-    outGateError.col(queryOffset) = outGateDerivative % gy % stateActivation;
+    outGateError.col(queryOffset) = derivative % gy %
+        stateAct.col(queryOffset);
 
-    arma::Col<eT> stateDerivative;
-    StateActivationFunction::deriv(stateActivation, stateDerivative);
+    // The derivative of the output activation is computed from the activation
+    // kept by the forward pass, without evaluating the function again.
+    OutputActivationFunction::deriv(stateAct.col(queryOffset), derivative);
 
     stateError.col(queryOffset) = gy % outGateAct.col(queryOffset) %
-        stateDerivative;
+        derivative;
 
     if (queryOffset < (seqLen - 1))
     {
@@ -210,26 +225,23 @@ class LSTMLayer
           peepholeWeights.slice(2);
     }
 
-    arma::Col<eT> cellDerivative;
-    StateActivationFunction::deriv(cellAct.col(queryOffset), cellDerivative);
+    StateActivationFunction::deriv(cellAct.col(queryOffset), derivative);
 
-    arma::Col<eT> cellError = inGateAct.col(queryOffset) % cellDerivative %
+    cellError = inGateAct.col(queryOffset) % derivative %
         stateError.col(queryOffset);
 
     if (queryOffset > 0)
     {
-      arma::Col<eT> forgetGateDerivative;
       GateActivationFunction::deriv(forgetGateAct.col(queryOffset),
-          forgetGateDerivative);
+          derivative);
 
-      forgetGateError.col(queryOffset) = forgetGateDerivative %
+      forgetGateError.col(queryOffset) = derivative %
           stateError.col(queryOffset) % state.col(queryOffset - 1);
     }
 
-    arma::Col<eT> inGateDerivative;
-    GateActivationFunction::deriv(inGateAct.col(queryOffset), inGateDerivative);
+    GateActivationFunction::deriv(inGateAct.col(queryOffset), derivative);
 
-    inGateError.col(queryOffset) = inGateDerivative %
+    inGateError.col(queryOffset) = derivative %
         stateError.col(queryOffset) % cellAct.col(queryOffset);
 
     if (peepholes)
@@ -246,7 +258,7 @@ class LSTMLayer
       }
     }
 
-    g = arma::zeros<arma::Mat<eT> >(outSize * 4, 1);
+    g.set_size(outSize * 4, 1);
     g.submat(0, 0, outSize - 1, 0) = inGateError.col(queryOffset);
     g.submat(outSize, 0, (outSize * 2) - 1, 0) =
         forgetGateError.col(queryOffset);
@@ -307,6 +319,39 @@ class LSTMLayer
   //! Modify the sequence length.
   size_t& SeqLen() { return seqLen; }
 
+  //! Get the inference mode (in which the sequence history is not kept).
+  bool Deterministic() const { return deterministic; }
+  //! Modify the inference mode (in which the sequence history is not kept).
+  bool& Deterministic() { return deterministic; }
+
+  //! Get whether a sequence continues from the state of the previous one.
+  bool CarryState() const { return carryState; }
+  //! Modify whether a sequence continues from the state of the previous one
+  //! (this is used for truncated backpropagation through time).
+  bool& CarryState() { return carryState; }
+
+  /**
+   * Serialize the layer.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    // Cubes have no serialization operator, so the size is serialized first
+    // and then the elements, as an array.
+    size_t rows = peepholeWeights.n_rows;
+    size_t cols = peepholeWeights.n_cols;
+    size_t slices = peepholeWeights.n_slices;
+    ar & data::CreateNVP(rows, "rows");
+    ar & data::CreateNVP(cols, "cols");
+    ar & data::CreateNVP(slices, "slices");
+
+    if (Archive::is_loading::value)
+      peepholeWeights.set_size(rows, cols, slices);
+
+    ar & boost::serialization::make_array(peepholeWeights.memptr(),
+        peepholeWeights.n_elem);
+  }
+
  private:
   //! Locally-stored number of output units.
   const size_t outSize;
@@ -320,6 +365,14 @@ class LSTMLayer
   //! Locally-stored sequence offset.
   size_t offset;
 
+  //! If true, the layer is used for inference only and does not keep the
+  //! history of the sequence.
+  bool deterministic;
+
+  //! If true, the first step of a sequence continues from the last state of
+  //! the previous sequence.
+  bool carryState;
+
   //! Locally-stored pointer to the optimzer object.
   OptimizerType<LSTMLayer<OptimizerType,
                           GateActivationFunction,
@@ -381,6 +434,18 @@ class LSTMLayer
   //! Locally-stored cell activation object.
   InputDataType cellAct;
 
+  //! Locally-stored state activation object.
+  InputDataType stateAct;
+
+  //! Locally-stored state of the previous step.
+  InputDataType prevState;
+
+  //! Locally-stored workspace for the derivatives of the backward pass.
+  InputDataType derivative;
+
+  //! Locally-stored workspace for the cell error of the backward pass.
+  InputDataType cellError;
+
   //! Locally-stored peephole weight object.
   PeepholeDataType peepholeWeights;
 
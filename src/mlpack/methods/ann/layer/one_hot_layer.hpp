@@ -47,7 +47,8 @@ class OneHotLayer
   }
 
   /*
-   * Calculate the output class using the specified input activation.
+   * Calculate the output class of each column (sample) of the specified input
+   * activation.
    *
    * @param inputActivations Input data used to calculate the output class.
    * @param output Output class of the input activation.
@@ -58,9 +59,12 @@ class OneHotLayer
     output = inputActivations;
     output.zeros();
 
-    arma::uword maxIndex;
-    inputActivations.max(maxIndex);
-    output(maxIndex) = 1;
+    for (size_t i = 0; i < inputActivations.n_cols; i++)
+    {
+      arma::uword maxIndex;
+      inputActivations.col(i).max(maxIndex);
+      output(maxIndex, i) = 1;
+    }
   }
 }; // class OneHotLayer
 
@@ -71,8 +71,18 @@ class PoolingLayer
     output = arma::zeros<arma::Cube<eT> >(input.n_rows / kSize,
                             input.n_cols / kSize, input.n_slices);
 
+    // The slices are pooled in parallel.  The slices are accessed through
+    // matrices which alias their memory, since Cube::slice() may create the
+    // matrix object of a slice on first use, which is not thread safe.
+    #pragma omp parallel for schedule(static)
     for (size_t s = 0; s < input.n_slices; s++)
-      Pooling(input.slice(s), output.slice(s));
+    {
+      const arma::Mat<eT> inputSlice(const_cast<eT*>(input.slice_memptr(s)),
+          input.n_rows, input.n_cols, false, true);
+      arma::Mat<eT> outputSlice(output.slice_memptr(s), output.n_rows,
+          output.n_cols, false, true);
+      Pooling(inputSlice, outputSlice);
+    }
   }
 
   /**
@@ -92,9 +102,23 @@ class PoolingLayer
     g = arma::zeros<arma::Cube<eT> >(inputParameter.n_rows,
         inputParameter.n_cols, inputParameter.n_slices);
 
-    for (size_t s = 0; s < gy.n_slices; s++)
+    // The slices are unpooled in parallel, and each thread reuses its own
+    // buffer for the unpooled error of a pooling window.
+    #pragma omp parallel
     {
-      Unpooling(inputParameter.slice(s), gy.slice(s), g.slice(s));
+      arma::Mat<eT> unpooledError;
+
+      #pragma omp for schedule(static)
+      for (size_t s = 0; s < gy.n_slices; s++)
+      {
+        const arma::Mat<eT> inputSlice(inputParameter.slice_memptr(s),
+            inputParameter.n_rows, inputParameter.n_cols, false, true);
+        const arma::Mat<eT> errorSlice(const_cast<eT*>(gy.slice_memptr(s)),
+            gy.n_rows, gy.n_cols, false, true);
+        arma::Mat<eT> gSlice(g.slice_memptr(s), g.n_rows, g.n_cols, false,
+            true);
+        Unpooling(inputSlice, errorSlice, gSlice, unpooledError);
+      }
     }
   }
 
@@ -112,20 +136,17 @@ class PoolingLayer
                 const arma::Mat<eT>& gy,
                 arma::Cube<eT>& g)
   {
-    // Generate a cube from the error matrix.
-    arma::Cube<eT> mappedError = arma::zeros<arma::cube>(outputParameter.n_rows,
-        outputParameter.n_cols, outputParameter.n_slices);
+    // Generate a cube from the error matrix, in the mappedError workspace.
+    mappedError.set_size(outputParameter.n_rows, outputParameter.n_cols,
+        outputParameter.n_slices);
 
     for (size_t s = 0, j = 0; s < mappedError.n_slices; s+= gy.n_cols, j++)
     {
       for (size_t i = 0; i < gy.n_cols; i++)
       {
-        arma::Col<eT> temp = gy.col(i).subvec(
-            j * outputParameter.n_rows * outputParameter.n_cols,
-            (j + 1) * outputParameter.n_rows * outputParameter.n_cols - 1);
-
-        mappedError.slice(s + i) = arma::Mat<eT>(temp.memptr(),
-            outputParameter.n_rows, outputParameter.n_cols);
+        const eT* error = gy.colptr(i) + j * mappedError.n_elem_slice;
+        std::copy(error, error + mappedError.n_elem_slice,
+            mappedError.slice_memptr(s + i));
       }
     }
 
@@ -176,16 +197,17 @@ class PoolingLayer
    *
    * @param input The input to be apply the unpooling rule.
    * @param output The pooled result.
+   * @param unpooledError Buffer for the unpooled error of a pooling window.
    */
   template<typename eT>
   void Unpooling(const arma::Mat<eT>& input,
                  const arma::Mat<eT>& error,
-                 arma::Mat<eT>& output)
+                 arma::Mat<eT>& output,
+                 arma::Mat<eT>& unpooledError)
   {
     const size_t rStep = input.n_rows / error.n_rows;
     const size_t cStep = input.n_cols / error.n_cols;
 
-    arma::Mat<eT> unpooledError;
     for (size_t j = 0; j < input.n_cols; j += cStep)
     {
       for (size_t i = 0; i < input.n_rows; i += rStep)
@@ -214,6 +236,9 @@ class PoolingLayer
   //! Locally-stored output parameter object.
   OutputDataType outputParameter;
 
+  //! Locally-stored workspace for the error of the backward pass.
+  OutputDataType mappedError;
+
   //! Locally-stored pooling strategy.
   PoolingRule pooling;
 }; // class PoolingLayer
@@ -116,7 +116,7 @@ class RecurrentLayer
   template<typename InputType, typename eT>
   void Backward(const InputType& /* unused */,
                 const arma::Mat<eT>& gy,
-                arma::mat& g)
+                arma::Mat<eT>& g)
   {
     g = (weights).t() * gy;
   }
@@ -181,6 +181,15 @@ class RecurrentLayer
   //! Modify the gradient.
   OutputDataType& Gradient() { return gradient; }
 
+  /**
+   * Serialize the layer.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(weights, "weights");
+  }
+
  private:
   //! Locally-stored number of input units.
   const size_t inSize;
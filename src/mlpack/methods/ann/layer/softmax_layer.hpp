@@ -38,7 +38,8 @@ class SoftmaxLayer
 
   /**
    * Ordinary feed forward pass of a neural network, evaluating the function
-   * f(x) by propagating the activity forward through f.
+   * f(x) by propagating the activity forward through f.  The softmax is taken
+   * over each column (sample) of the input separately.
    *
    * @param input Input data used for evaluating the specified function.
    * @param output Resulting output activation.
@@ -46,9 +47,15 @@ class SoftmaxLayer
   template<typename eT>
   void Forward(const arma::Mat<eT>& input, arma::Mat<eT>& output)
   {
-    output = arma::trunc_exp(input -
-        arma::repmat(arma::max(input), input.n_rows, 1));
-    output /= arma::accu(output);
+    // Each column is normalized in place, so that no repeated copies of the
+    // column maxima and sums are needed.
+    output.set_size(input.n_rows, input.n_cols);
+    for (size_t i = 0; i < input.n_cols; i++)
+    {
+      output.col(i) = arma::trunc_exp(input.col(i) -
+          arma::max(input.col(i)));
+      output.col(i) /= arma::accu(output.col(i));
+    }
   }
 
   /**
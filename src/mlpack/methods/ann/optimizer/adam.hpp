@@ -10,6 +10,7 @@
 #define __MLPACK_METHODS_ANN_OPTIMIZER_ADAM_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/methods/ann/optimizer/sparse_gradient.hpp>
 
 namespace mlpack {
 namespace ann /** Artificial Neural Network. */ {
@@ -19,6 +20,11 @@ namespace ann /** Artificial Neural Network. */ {
  * different parameters from estimates of first and second moments of the
  * gradients.
  *
+ * If the gradient of the layer is sparse (see HasSparseGradient), only the
+ * columns of the weights (and moments) that have a gradient are updated, so
+ * the cost of a step does not depend on the number of columns; the moments of
+ * the other columns are not decayed until they have a gradient again.
+ *
  * For more information, see the following.
  *
  * @code
@@ -71,7 +77,7 @@ class Adam
       variance = mean;
     }
 
-    Optimize(function.Weights(), gradient, mean, variance);
+    Apply(function);
   }
 
   /*
@@ -79,14 +85,7 @@ class Adam
    */
   void Update()
   {
-    if (gradient.n_elem != 0)
-    {
-      gradient += function.Gradient();
-    }
-    else
-    {
-      gradient = function.Gradient();
-    }
+    Accumulate(function);
   }
 
   /*
@@ -95,6 +94,11 @@ class Adam
   void Reset()
   {
     gradient.zeros();
+    if (gradientIndices.n_elem != 0)
+    {
+      gradient.reset();
+      gradientIndices.reset();
+    }
   }
 
   //! Get the gradient.
@@ -102,7 +106,61 @@ class Adam
   //! Modify the gradient.
   DataType& Gradient() { return gradient; }
 
+  //! Get the indices of the columns of a sparse gradient.
+  const arma::uvec& GradientIndices() const { return gradientIndices; }
+  //! Modify the indices of the columns of a sparse gradient.
+  arma::uvec& GradientIndices() { return gradientIndices; }
+
  private:
+  //! Sum up the gradient of a layer with a dense gradient.
+  template<typename FunctionType>
+  typename std::enable_if<!HasSparseGradient<FunctionType>::value, void>::type
+  Accumulate(FunctionType& function)
+  {
+    if (gradient.n_elem != 0)
+    {
+      gradient += function.Gradient();
+    }
+    else
+    {
+      gradient = function.Gradient();
+    }
+  }
+
+  //! Sum up the gradient of a layer with a sparse gradient.
+  template<typename FunctionType>
+  typename std::enable_if<HasSparseGradient<FunctionType>::value, void>::type
+  Accumulate(FunctionType& function)
+  {
+    AddSparseGradient(gradient, gradientIndices, function.Gradient(),
+        function.GradientIndices());
+  }
+
+  //! Update all of the weights of a layer with a dense gradient.
+  template<typename FunctionType>
+  typename std::enable_if<!HasSparseGradient<FunctionType>::value, void>::type
+  Apply(FunctionType& function)
+  {
+    Optimize(function.Weights(), gradient, mean, variance);
+  }
+
+  //! Update only the columns of the weights that have a gradient, for a layer
+  //! with a sparse gradient.
+  template<typename FunctionType>
+  typename std::enable_if<HasSparseGradient<FunctionType>::value, void>::type
+  Apply(FunctionType& function)
+  {
+    for (size_t i = 0; i < gradientIndices.n_elem; i++)
+    {
+      const size_t j = gradientIndices[i];
+      mean.col(j) += (1 - beta1) * (gradient.col(i) - mean.col(j));
+      variance.col(j) += (1 - beta2) * (gradient.col(i) % gradient.col(i) -
+          variance.col(j));
+      function.Weights().col(j) -= lr * mean.col(j) /
+          (arma::sqrt(variance.col(j)) + eps);
+    }
+  }
+
   /**
    * Optimize the given function using Adam.
    *
@@ -164,6 +222,9 @@ class Adam
   //! The current gradient.
   DataType gradient;
 
+  //! The indices of the columns of the current gradient, if it is sparse.
+  arma::uvec gradientIndices;
+
   //! The current mean parameter.
   DataType mean;
 
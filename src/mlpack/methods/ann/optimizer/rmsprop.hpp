@@ -9,6 +9,7 @@
 #define __MLPACK_METHODS_ANN_OPTIMIZER_RMSPROP_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/methods/ann/optimizer/sparse_gradient.hpp>
 
 namespace mlpack {
 namespace ann /** Artificial Neural Network. */ {
@@ -24,6 +25,11 @@ namespace ann /** Artificial Neural Network. */ {
  * \Delta_{t + 1} &=& \Delta_t - v_{t + 1}
  * \f}
  *
+ * If the gradient of the layer is sparse (see HasSparseGradient), only the
+ * columns of the weights (and of the mean squared gradient) that have a
+ * gradient are updated, so the cost of a step does not depend on the number of
+ * columns.
+ *
  * For more information, see the following.
  *
  * @code
@@ -70,7 +76,7 @@ class RMSPROP
       meanSquaredGad.zeros();
     }
 
-    Optimize(function.Weights(), gradient, meanSquaredGad);
+    Apply(function);
   }
 
   /*
@@ -78,15 +84,7 @@ class RMSPROP
    */
   void Update()
   {
-    if (gradient.n_elem != 0)
-    {
-      DataType outputGradient = function.Gradient();
-      gradient += outputGradient;
-    }
-    else
-    {
-      gradient = function.Gradient();
-    }
+    Accumulate(function);
   }
 
   /*
@@ -95,6 +93,11 @@ class RMSPROP
   void Reset()
   {
     gradient.zeros();
+    if (gradientIndices.n_elem != 0)
+    {
+      gradient.reset();
+      gradientIndices.reset();
+    }
   }
 
   //! Get the gradient.
@@ -102,7 +105,62 @@ class RMSPROP
   //! Modify the gradient.
   DataType& Gradient() { return gradient; }
 
+  //! Get the indices of the columns of a sparse gradient.
+  const arma::uvec& GradientIndices() const { return gradientIndices; }
+  //! Modify the indices of the columns of a sparse gradient.
+  arma::uvec& GradientIndices() { return gradientIndices; }
+
  private:
+  //! Sum up the gradient of a layer with a dense gradient.
+  template<typename FunctionType>
+  typename std::enable_if<!HasSparseGradient<FunctionType>::value, void>::type
+  Accumulate(FunctionType& function)
+  {
+    if (gradient.n_elem != 0)
+    {
+      DataType outputGradient = function.Gradient();
+      gradient += outputGradient;
+    }
+    else
+    {
+      gradient = function.Gradient();
+    }
+  }
+
+  //! Sum up the gradient of a layer with a sparse gradient.
+  template<typename FunctionType>
+  typename std::enable_if<HasSparseGradient<FunctionType>::value, void>::type
+  Accumulate(FunctionType& function)
+  {
+    AddSparseGradient(gradient, gradientIndices, function.Gradient(),
+        function.GradientIndices());
+  }
+
+  //! Update all of the weights of a layer with a dense gradient.
+  template<typename FunctionType>
+  typename std::enable_if<!HasSparseGradient<FunctionType>::value, void>::type
+  Apply(FunctionType& function)
+  {
+    Optimize(function.Weights(), gradient, meanSquaredGad);
+  }
+
+  //! Update only the columns of the weights that have a gradient, for a layer
+  //! with a sparse gradient.
+  template<typename FunctionType>
+  typename std::enable_if<HasSparseGradient<FunctionType>::value, void>::type
+  Apply(FunctionType& function)
+  {
+    for (size_t i = 0; i < gradientIndices.n_elem; i++)
+    {
+      const size_t j = gradientIndices[i];
+      meanSquaredGad.col(j) *= alpha;
+      meanSquaredGad.col(j) += (1 - alpha) * (gradient.col(i) %
+          gradient.col(i));
+      function.Weights().col(j) -= lr * gradient.col(i) /
+          (arma::sqrt(meanSquaredGad.col(j)) + eps);
+    }
+  }
+
   /**
    * Optimize the given function using RmsProp.
    *
@@ -155,6 +213,9 @@ class RMSPROP
 
   //! The current gradient.
   DataType gradient;
+
+  //! The indices of the columns of the current gradient, if it is sparse.
+  arma::uvec gradientIndices;
 }; // class RMSPROP
 
 }; // namespace ann
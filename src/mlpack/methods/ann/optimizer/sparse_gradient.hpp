@@ -0,0 +1,100 @@
+/**
+ * @file sparse_gradient.hpp
+ * @author Ryan Curtin
+ *
+ * Support for layers whose gradient is nonzero in only a few columns of their
+ * weights, like EmbeddingLayer: these store only those columns, so that the
+ * optimizers update only the columns that a batch touched.
+ */
+#ifndef __MLPACK_METHODS_ANN_OPTIMIZER_SPARSE_GRADIENT_HPP
+#define __MLPACK_METHODS_ANN_OPTIMIZER_SPARSE_GRADIENT_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/sfinae_utility.hpp>
+
+namespace mlpack {
+namespace ann /** Artificial Neural Network. */ {
+
+// This gives us a HasGradientIndicesCheck<T, U> type (where U is a function
+// pointer) we can use with SFINAE to catch when a type has a
+// GradientIndices() function.
+HAS_MEM_FUNC(GradientIndices, HasGradientIndicesCheck);
+
+/**
+ * HasSparseGradient<LayerType>::value is true if the gradient of the layer
+ * holds only some columns of its weights, whose indices (in increasing order)
+ * are given by
+ *
+ * @code
+ * arma::uvec& GradientIndices();
+ * @endcode
+ *
+ * so that column i of Gradient() is the gradient of column GradientIndices()[i]
+ * of Weights(), and every other column has zero gradient.
+ */
+template<typename LayerType>
+struct HasSparseGradient
+{
+  static const bool value =
+      HasGradientIndicesCheck<LayerType, arma::uvec&(LayerType::*)()>::value;
+};
+
+/**
+ * Add a sparse gradient to another one.  Both sets of indices are in
+ * increasing order, and so is the result; the columns of indices that are in
+ * both are summed.  If the first gradient is empty, it is replaced by the
+ * other one.
+ *
+ * @param gradient The gradient to add to.
+ * @param indices The indices of the columns of gradient.
+ * @param otherGradient The gradient to add.
+ * @param otherIndices The indices of the columns of otherGradient.
+ */
+template<typename eT>
+void AddSparseGradient(arma::Mat<eT>& gradient,
+                       arma::uvec& indices,
+                       const arma::Mat<eT>& otherGradient,
+                       const arma::uvec& otherIndices)
+{
+  if (indices.n_elem == 0)
+  {
+    gradient = otherGradient;
+    indices = otherIndices;
+    return;
+  }
+
+  if (otherIndices.n_elem == 0)
+    return;
+
+  arma::uvec mergedIndices(indices.n_elem + otherIndices.n_elem);
+  arma::Mat<eT> merged(gradient.n_rows, mergedIndices.n_elem);
+
+  size_t i = 0, j = 0, k = 0;
+  for ( ; i < indices.n_elem || j < otherIndices.n_elem; ++k)
+  {
+    if (j == otherIndices.n_elem ||
+        (i < indices.n_elem && indices[i] < otherIndices[j]))
+    {
+      mergedIndices[k] = indices[i];
+      merged.col(k) = gradient.col(i++);
+    }
+    else if (i == indices.n_elem || otherIndices[j] < indices[i])
+    {
+      mergedIndices[k] = otherIndices[j];
+      merged.col(k) = otherGradient.col(j++);
+    }
+    else
+    {
+      mergedIndices[k] = indices[i];
+      merged.col(k) = gradient.col(i++) + otherGradient.col(j++);
+    }
+  }
+
+  indices = mergedIndices.subvec(0, k - 1);
+  gradient = merged.cols(0, k - 1);
+}
+
+}; // namespace ann
+}; // namespace mlpack
+
+#endif
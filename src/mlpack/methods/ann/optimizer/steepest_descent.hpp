@@ -82,6 +82,11 @@ class SteepestDescent
     gradient.zeros();
   }
 
+  //! Get the gradient.
+  DataType& Gradient() const { return gradient; }
+  //! Modify the gradient.
+  DataType& Gradient() { return gradient; }
+
  private:
   /** Optimize the given function using steepest descent.
    *
@@ -30,7 +30,8 @@ class CrossEntropyErrorFunction
 {
   public:
   /**
-   * Computes the cross-entropy error function.
+   * Computes the cross-entropy error function.  If the input holds a batch of
+   * samples (one per column), the errors of the samples are summed.
    *
    * @param input Input data.
    * @param target Target data.
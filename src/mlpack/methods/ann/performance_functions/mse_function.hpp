@@ -20,7 +20,8 @@ class MeanSquaredErrorFunction
 {
   public:
   /**
-   * Computes the mean squared error function.
+   * Computes the mean squared error function.  If the input holds a batch of
+   * samples (one per column), the errors of the samples are summed.
    *
    * @param input Input data.
    * @param target Target data.
@@ -29,7 +30,7 @@ class MeanSquaredErrorFunction
   template<typename DataType>
   static double Error(const DataType& input, const DataType& target)
   {
-    return arma::mean(arma::mean(arma::square(target - input)));
+    return arma::accu(arma::square(target - input)) / input.n_rows;
   }
 
 }; // class MeanSquaredErrorFunction
@@ -12,6 +12,7 @@
 #include <boost/ptr_container/ptr_vector.hpp> 
 
 #include <mlpack/methods/ann/network_traits.hpp>
+#include <mlpack/methods/ann/weight_blob.hpp>
 #include <mlpack/methods/ann/layer/layer_traits.hpp>
 #include <mlpack/methods/ann/performance_functions/cee_function.hpp>
 
@@ -24,6 +25,8 @@ namespace ann /** Artificial Neural Network. */ {
  * @tparam LayerTypes Contains all layer modules used to construct the network.
  * @tparam OutputLayerType The outputlayer type used to evaluate the network.
  * @tparam PerformanceFunction Performance strategy used to claculate the error.
+ * @tparam MatType Type of the stored activations and errors (arma::mat, or
+ *         arma::fmat for a network trained in single precision).
  */
 template <
   typename LayerTypes,
@@ -38,15 +41,32 @@ class RNN
    * Construct the RNN object, which will construct a recurrent neural
    * network with the specified layers.
    *
+   * If bpttSteps is greater than 0, the network is trained with truncated
+   * backpropagation through time: the input sequence is split into windows of
+   * bpttSteps steps, and each window is run forward and then backward before
+   * the next one starts, so only the activations of one window are stored.
+   * The state of the recurrent layers is carried over from one window to the
+   * next, but the errors are not propagated back past the start of a window.
+   * In that case FeedForward() computes the gradients too, and FeedBackward()
+   * has nothing left to do.  If the network only has an output for the whole
+   * sequence (instead of one for each step), only the last window receives an
+   * error.
+   *
    * @param network The network modules used to construct the network.
    * @param outputLayer The outputlayer used to evaluate the network.
+   * @param bpttSteps The number of steps in each window of truncated
+   *     backpropagation through time (0 means the whole sequence).
    */
-  RNN(const LayerTypes& network, OutputLayerType& outputLayer) :
+  RNN(const LayerTypes& network,
+      OutputLayerType& outputLayer,
+      const size_t bpttSteps = 0) :
       network(network),
       outputLayer(outputLayer),
       trainError(0),
       inputSize(0),
-      outputSize(0)
+      outputSize(0),
+      carryState(false),
+      bpttSteps(bpttSteps)
   {
     // Nothing to do here.
   }
@@ -66,7 +86,11 @@ class RNN
                    ErrorType& error)
   {
     deterministic = false;
-    trainError += Evaluate(input, target, error);
+
+    if (bpttSteps > 0)
+      trainError += EvaluateWindows(input, target, error, true);
+    else
+      trainError += Evaluate(input, target, error);
   }
 
   /**
@@ -78,6 +102,11 @@ class RNN
   template <typename InputType, typename ErrorType>
   void FeedBackward(const InputType& input, const ErrorType& error)
   {
+    // With truncated backpropagation through time, the gradients have already
+    // been computed window by window in FeedForward().
+    if (bpttSteps > 0)
+      return;
+
     // Iterate through the input sequence and perform the feed backward pass.
     for (seqNum = seqLen - 1; seqNum >= 0; seqNum--)
     {
@@ -117,7 +146,10 @@ class RNN
 
   /**
    * Evaluate the network using the given input. The output activation is
-   * stored into the output parameter.
+   * stored into the output parameter.  The network is run in inference mode:
+   * layers like DropoutLayer are deterministic, and the activations of the
+   * sequence, which only the backward pass needs, are not stored (the
+   * recurrent layers only keep the activation of the previous step).
    *
    * @param input Input data used to evaluate the network.
    * @param output Output data used to store the output activation
@@ -132,10 +164,11 @@ class RNN
     // Iterate through the input sequence and perform the feed forward pass.
     for (seqNum = 0; seqNum < seqLen; seqNum++)
     {
-      // Perform the forward pass and save the activations.
+      // Perform the forward pass and pass the activations on to the recurrent
+      // layers; the activations are not saved, since there is no backward pass.
       Forward(input.rows(seqNum * inputSize, (seqNum + 1) * inputSize - 1),
           network);
-      SaveActivations(network);
+      LinkRecurrent(network);
 
       // Retrieve output of the subsequence.
       if (seqOutput)
@@ -164,6 +197,11 @@ class RNN
                   const TargetType& target,
                   ErrorType& error)
   {
+    // The windows of truncated backpropagation through time do not need to
+    // store the activations of the whole sequence.
+    if (bpttSteps > 0)
+      return EvaluateWindows(input, target, error, false);
+
     // Initialize the activation storage only once.
     if (activations.empty())
       InitLayer(input, target, network);
@@ -186,8 +224,8 @@ class RNN
       // Retrieve output error of the subsequence.
       if (seqOutput)
       {
-        arma::mat seqError = error.unsafe_col(seqNum);
-        arma::mat seqTarget = target.submat(seqNum * outputSize, 0,
+        MatType seqError = error.unsafe_col(seqNum);
+        MatType seqTarget = target.submat(seqNum * outputSize, 0,
             (seqNum + 1) * outputSize - 1, 0);
         networkError += OutputError(seqTarget, seqError, network);
       }
@@ -206,7 +244,156 @@ class RNN
     return trainError;
   }
 
+  //! Get the number of steps in each window of truncated backpropagation
+  //! through time (0 means the whole sequence).
+  size_t BPTTSteps() const { return bpttSteps; }
+  //! Modify the number of steps in each window of truncated backpropagation
+  //! through time (0 means the whole sequence).
+  size_t& BPTTSteps() { return bpttSteps; }
+
+  /**
+   * Save the weights of the network to the given file, as one raw binary blob
+   * (see WeightBlob).  The network has to be built in the same way to load
+   * them again.  A std::runtime_error is thrown if the file cannot be written.
+   *
+   * @param filename Name of the file to write.
+   */
+  void SaveWeights(const std::string& filename)
+  {
+    WeightBlob blob;
+    CollectWeights<>(network, blob);
+    blob.Save(filename);
+  }
+
+  /**
+   * Load the weights of the network from the given file, written by
+   * SaveWeights() for a network built in the same way.  The whole file is
+   * read at once, which makes this much faster than boost::serialization for
+   * loading a trained network.  A std::runtime_error is thrown if the file
+   * cannot be read or does not match the network.
+   *
+   * @param filename Name of the file to read.
+   */
+  void LoadWeights(const std::string& filename)
+  {
+    WeightBlob blob;
+    CollectWeights<>(network, blob);
+    blob.Load(filename);
+  }
+
+  /**
+   * Serialize the network, by serializing each of the layers which have
+   * parameters.  The network (and so its layers) has to be constructed in the
+   * same way before it is loaded.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    SerializeLayers<>(ar, network);
+  }
+
  private:
+  /**
+   * Evaluate the network on the given sequence one window of bpttSteps steps
+   * at a time, carrying the state of the recurrent layers over from one window
+   * to the next.  If train is true, each window is also run backward and the
+   * gradients are accumulated; otherwise the activations are not stored at
+   * all.
+   *
+   * @param input Input sequence used to evaluate the network.
+   * @param target Target data used to calculate the network error.
+   * @param error The calulated error of the output layer.
+   * @param train Whether or not to compute the gradients.
+   * @return The network error on the whole sequence.
+   */
+  template <typename InputType, typename TargetType, typename ErrorType>
+  double EvaluateWindows(const InputType& input,
+                         const TargetType& target,
+                         ErrorType& error,
+                         const bool train)
+  {
+    if (activations.empty())
+      InitLayer(input, target, network);
+
+    const size_t sequenceLength = input.n_rows / inputSize;
+    deterministic = false;
+    error = ErrorType(outputSize, seqOutput ? sequenceLength : 1);
+
+    double networkError = 0;
+    for (size_t begin = 0; begin < sequenceLength; begin += bpttSteps)
+    {
+      const size_t end = std::min(begin + bpttSteps, sequenceLength);
+      const bool lastWindow = (end == sequenceLength);
+
+      // Only the first window starts from a zero state.
+      carryState = (begin > 0);
+      seqLen = end - begin;
+      ResetParameter(network);
+
+      // Without an output for each step, only the last window has an error to
+      // propagate back.
+      const bool backward = train && (seqOutput || lastWindow);
+
+      for (seqNum = 0; seqNum < seqLen; seqNum++)
+      {
+        const size_t step = begin + seqNum;
+        Forward(input.rows(step * inputSize, (step + 1) * inputSize - 1),
+            network);
+
+        if (backward)
+          SaveActivations(network);
+        else
+          LinkRecurrent(network);
+
+        if (seqOutput)
+        {
+          MatType seqError = error.unsafe_col(step);
+          MatType seqTarget = target.submat(step * outputSize, 0,
+              (step + 1) * outputSize - 1, 0);
+          networkError += OutputError(seqTarget, seqError, network);
+        }
+      }
+
+      if (!seqOutput && lastWindow)
+        networkError = OutputError(target, error, network);
+
+      if (!backward)
+        continue;
+
+      for (seqNum = seqLen - 1; seqNum >= 0; seqNum--)
+      {
+        const size_t step = begin + seqNum;
+        LoadActivations(input.rows(step * inputSize, (step + 1) *
+            inputSize - 1), network);
+
+        if (seqOutput)
+        {
+          ErrorType seqError = error.unsafe_col(step);
+          Backward(seqError, network);
+        }
+        else
+        {
+          Backward(error, network);
+        }
+
+        LinkParameter(network);
+        UpdateGradients<>(network);
+
+        if (seqNum == 0) break;
+      }
+
+      // The backward pass loaded the activations of the first step of the
+      // window; restore the state at the end of the window for the next one.
+      seqNum = seqLen - 1;
+      LoadActivations(input.rows((end - 1) * inputSize, end * inputSize - 1),
+          network);
+      LinkRecurrent(network);
+    }
+
+    carryState = false;
+    return networkError;
+  }
+
   /**
    * Reset the network by clearing the layer activations and by setting the
    * layer status.
@@ -228,7 +415,13 @@ class RNN
   {
     ResetDeterministic(std::get<I>(t));
     ResetSeqLen(std::get<I>(t));
-    ResetRecurrent(std::get<I>(t), std::get<I>(t).InputParameter());
+    ResetCarryState(std::get<I>(t));
+
+    // The recurrent state is kept when a sequence continues from the previous
+    // window.
+    if (!carryState)
+      ResetRecurrent(std::get<I>(t), std::get<I>(t).InputParameter());
+
     std::get<I>(t).Delta().zeros();
 
     ResetParameter<I + 1, Tp...>(t);
@@ -268,6 +461,23 @@ class RNN
       !HasSeqLenCheck<T, size_t&(T::*)(void)>::value, void>::type
   ResetSeqLen(T& /* unused */) { /* Nothing to do here */ }
 
+  /**
+   * Tell all layers that implement the CarryState function whether the
+   * sequence continues from the state of the previous window.
+   */
+  template<typename T>
+  typename std::enable_if<
+      HasCarryStateCheck<T, bool&(T::*)(void)>::value, void>::type
+  ResetCarryState(T& t)
+  {
+    t.CarryState() = carryState;
+  }
+
+  template<typename T>
+  typename std::enable_if<
+      !HasCarryStateCheck<T, bool&(T::*)(void)>::value, void>::type
+  ResetCarryState(T& /* unused */) { /* Nothing to do here */ }
+
   /**
    * Distinguish between recurrent layer and non-recurrent layer when resetting
    * the recurrent parameter.
@@ -722,6 +932,89 @@ class RNN
     /* Nothing to do here */
   }
 
+  /**
+   * Add the weights of the layers to the given weight blob.
+   *
+   * enable_if (SFINAE) is used to iterate through the network connections.
+   * The general case peels off the first type and recurses, as usual with
+   * variadic function templates.
+   */
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I == Max, void>::type
+  CollectWeights(std::tuple<Tp...>& /* unused */, WeightBlob& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  template<size_t I = 0, size_t Max = std::tuple_size<LayerTypes>::value - 1,
+      typename... Tp>
+  typename std::enable_if<I < Max, void>::type
+  CollectWeights(std::tuple<Tp...>& t, WeightBlob& blob)
+  {
+    Collect(std::get<I>(t), std::get<I>(t).OutputParameter(),
+            std::get<I + 1>(t).Delta(), blob);
+
+    CollectWeights<I + 1, Max, Tp...>(t, blob);
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Collect(T& t, P& /* unused */, D& /* unused */, WeightBlob& blob)
+  {
+    blob.Add(t.Weights());
+  }
+
+  template<typename T, typename P, typename D>
+  typename std::enable_if<
+      !HasGradientCheck<T, void(T::*)(const D&, P&)>::value, void>::type
+  Collect(T& /* unused */, P& /* unused */, D& /* unused */,
+          WeightBlob& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  /**
+   * Serialize each of the layers which have a Serialize() function.
+   *
+   * enable_if (SFINAE) is used to iterate through the network layer.
+   * The general case peels off the first type and recurses, as usual with
+   * variadic function templates.
+   */
+  template<size_t I = 0, typename Archive, typename... Tp>
+  typename std::enable_if<I == sizeof...(Tp), void>::type
+  SerializeLayers(Archive& /* unused */, std::tuple<Tp...>& /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
+  template<size_t I = 0, typename Archive, typename... Tp>
+  typename std::enable_if<I < sizeof...(Tp), void>::type
+  SerializeLayers(Archive& ar, std::tuple<Tp...>& t)
+  {
+    SerializeLayer(ar, std::get<I>(t), I);
+    SerializeLayers<I + 1, Archive, Tp...>(ar, t);
+  }
+
+  template<typename Archive, typename T>
+  typename std::enable_if<data::HasSerialize<T>::value, void>::type
+  SerializeLayer(Archive& ar, T& layer, const size_t i)
+  {
+    std::ostringstream oss;
+    oss << "layer" << i;
+    ar & data::CreateNVP(layer, oss.str());
+  }
+
+  template<typename Archive, typename T>
+  typename std::enable_if<!data::HasSerialize<T>::value, void>::type
+  SerializeLayer(Archive& /* unused */,
+                 T& /* unused */,
+                 const size_t /* unused */)
+  {
+    /* Nothing to do here */
+  }
+
   /*
    * Calculate and store the output activation.
    */
@@ -760,6 +1053,13 @@ class RNN
   //! Locally stored parameter that indicates if the input is a sequence.
   bool seqOutput;
 
+  //! Whether the current window continues from the state of the previous one.
+  bool carryState;
+
+  //! The number of steps in each window of truncated backpropagation through
+  //! time (0 means the whole sequence).
+  size_t bpttSteps;
+
   //! The activation storage we are using to perform the feed backward pass.
   boost::ptr_vector<MatType> activations;
 }; // class RNN
@@ -9,10 +9,15 @@
 #define __MLPACK_METHODS_ANN_TRAINER_TRAINER_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/data/chunked_reader.hpp>
 
 #include <mlpack/methods/ann/network_traits.hpp>
 #include <mlpack/methods/ann/layer/layer_traits.hpp>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace ann /** Artificial Neural Network. */ {
 
@@ -22,7 +27,9 @@ namespace ann /** Artificial Neural Network. */ {
  *
  * @tparam NetworkType The type of network which should be trained and
  * evaluated.
- * @tparam MaType Type of the error type (arma::mat or arma::sp_mat).
+ * @tparam MaType Type of the error type (arma::mat, arma::fmat or
+ *     arma::sp_mat); it has to match the output type of the network, so a
+ *     network trained in single precision uses arma::fmat.
  */
 template<
   typename NetworkType,
@@ -36,8 +43,24 @@ class Trainer
      * network according to a supervised dataset by backpropagating the errors.
      *
      * If batchSize is greater 1 the trainer will take a mean gradient step over
-     * this many samples and will update the parameters only at the end of
-     * each epoch (Default 1).
+     * this many samples (Default 1).  Feed forward and convolutional networks
+     * are given the whole batch at once (as the columns of a matrix, or the
+     * slices of a cube), so the layers work with matrix-matrix products;
+     * recurrent networks are still given one sample at a time.
+     *
+     * If mlpack is compiled with OpenMP, the convolution and pooling layers
+     * split their maps across threads.  numThreads sets the number of threads
+     * used while training; 0 means the OpenMP default (which can be set with
+     * the OMP_NUM_THREADS environment variable).
+     *
+     * Feed forward and convolutional networks can also be trained data
+     * parallel, by giving the trainer replicas of the network: networks of the
+     * same type, built from their own layers.  Then each batch is split into
+     * one shard per replica, and the replicas compute the gradients of their
+     * shards at the same time, each in its own thread, starting from the
+     * current weights of the network.  The gradients are summed with a tree
+     * reduction, and the layer optimizers of the network take a single step
+     * with the mean gradient of the batch, as they would without replicas.
      *
      * @param net The network that should be trained.
      * @param maxEpochs The number of maximal trained iterations (0 means no
@@ -47,17 +70,26 @@ class Trainer
      * the specified threshold.
      * @param shuffle If true, the order of the training set is shuffled;
      * otherwise, each data is visited in linear order.
+     * @param numThreads The number of threads used to train the network (0
+     * means the OpenMP default).
+     * @param replicas Replicas of the network used to compute the gradients of
+     * each batch in parallel (none by default).
      */
     Trainer(NetworkType& net,
             const size_t maxEpochs = 0,
             const size_t batchSize = 1,
             const double tolerance = 0.0001,
-            const bool shuffle = true) :
+            const bool shuffle = true,
+            const size_t numThreads = 0,
+            const std::vector<NetworkType*>& replicas =
+                std::vector<NetworkType*>()) :
         net(net),
         maxEpochs(maxEpochs),
         batchSize(batchSize),
         tolerance(tolerance),
-        shuffle(shuffle)
+        shuffle(shuffle),
+        numThreads(numThreads),
+        replicas(replicas)
     {
       // Nothing to do here.
     }
@@ -83,6 +115,14 @@ class Trainer
           ElementCount(trainingData) - 1, ElementCount(trainingData));
       epoch = 0;
 
+#ifdef _OPENMP
+      // Use the requested number of threads while training, and restore the
+      // previous setting afterwards.
+      const int previousThreads = omp_get_max_threads();
+      if (numThreads > 0)
+        omp_set_num_threads((int) numThreads);
+#endif
+
       while(true)
       {
         if (shuffle)
@@ -97,6 +137,94 @@ class Trainer
         if (maxEpochs > 0 && ++epoch >= maxEpochs)
           break;
       }
+
+#ifdef _OPENMP
+      omp_set_num_threads(previousThreads);
+#endif
+    }
+
+    /**
+     * Train the network on a dataset read from disk one chunk of points at a
+     * time, for datasets that do not fit in memory, until the network
+     * converges.  If maxEpochs is greater than zero that many epochs are
+     * maximal trained.
+     *
+     * Each point of the dataset holds the input of a sample, followed by its
+     * labels in the last labelRows dimensions.  While the network trains on
+     * the batches of one chunk, the reader reads the next chunk in the
+     * background, so that I/O and training overlap.  If shuffle is true, the
+     * points of each chunk are visited in a random order (the chunks themselves
+     * are visited in the order of the file, so the chunk size should be much
+     * larger than the batch size).
+     *
+     * @param reader Reader of the training dataset; it is reset at the start
+     * of each epoch.
+     * @param labelRows The number of dimensions of each point that hold the
+     * labels.
+     * @param validationData Data used to evaluate the network.
+     * @tparam validationLabels Labels used to evaluate the network.
+     */
+    template<typename InputType, typename OutputType>
+    void Train(data::ChunkedReader& reader,
+               const size_t labelRows,
+               InputType& validationData,
+               OutputType& validationLabels)
+    {
+      if (labelRows == 0 || labelRows >= reader.Dimensionality())
+      {
+        std::ostringstream oss;
+        oss << "Trainer::Train(): the number of label rows (" << labelRows
+            << ") must be between 1 and the dimensionality of the dataset "
+            << "minus 1 (" << reader.Dimensionality() - 1 << ")";
+        throw std::invalid_argument(oss.str());
+      }
+
+      const size_t inputRows = reader.Dimensionality() - labelRows;
+      epoch = 0;
+
+#ifdef _OPENMP
+      // Use the requested number of threads while training, and restore the
+      // previous setting afterwards.
+      const int previousThreads = omp_get_max_threads();
+      if (numThreads > 0)
+        omp_set_num_threads((int) numThreads);
+#endif
+
+      arma::mat chunk;
+      while(true)
+      {
+        double epochError = 0;
+        size_t points = 0;
+
+        reader.Reset();
+        while (reader.NextChunk(chunk))
+        {
+          arma::mat chunkData = chunk.rows(0, inputRows - 1);
+          arma::mat chunkLabels = chunk.rows(inputRows, chunk.n_rows - 1);
+
+          index = arma::linspace<arma::Col<size_t> >(0, chunk.n_cols - 1,
+              chunk.n_cols);
+          if (shuffle)
+            index = arma::shuffle(index);
+
+          Train(chunkData, chunkLabels);
+          epochError += trainingError * chunk.n_cols;
+          points += chunk.n_cols;
+        }
+
+        trainingError = (points > 0) ? epochError / points : 0;
+        Evaluate(validationData, validationLabels);
+
+        if (validationError <= tolerance)
+          break;
+
+        if (maxEpochs > 0 && ++epoch >= maxEpochs)
+          break;
+      }
+
+#ifdef _OPENMP
+      omp_set_num_threads(previousThreads);
+#endif
     }
 
     //! Get the training error.
@@ -125,15 +253,127 @@ class Trainer
     //! Modify the tolerance for termination.
     double& Tolerance() { return tolerance; }
 
+    //! Get the number of threads used for training (0 means the OpenMP
+    //! default).
+    size_t NumThreads() const { return numThreads; }
+    //! Modify the number of threads used for training (0 means the OpenMP
+    //! default).
+    size_t& NumThreads() { return numThreads; }
+
+    //! Get the replicas of the network used for data parallel training.
+    const std::vector<NetworkType*>& Replicas() const { return replicas; }
+    //! Modify the replicas of the network used for data parallel training.
+    std::vector<NetworkType*>& Replicas() { return replicas; }
+
   private:
     /**
-     * Train the network on the given dataset.
+     * Train the network on the given dataset, one batch of samples at a time.
      *
      * @param data Data used to train the network.
      * @param target Labels used to train the network.
      */
     template<typename InputType, typename OutputType>
-    void Train(InputType& data, OutputType& target)
+    typename std::enable_if<!NetworkTraits<NetworkType>::IsRNN, void>::type
+    Train(InputType& data, OutputType& target)
+    {
+      // Reset the training error.
+      trainingError = 0;
+
+      for (size_t i = 0; i < index.n_elem; i += batchSize)
+      {
+        const size_t end = std::min(i + batchSize, (size_t) index.n_elem);
+        if (!replicas.empty())
+        {
+          trainingError += TrainReplicas(data, target, i, end);
+          continue;
+        }
+
+        const InputType dataBatch = Batch(data, i, end, shuffle);
+        const OutputType targetBatch = Batch(target, i, end, shuffle);
+
+        net.FeedForward(dataBatch, targetBatch, error);
+
+        trainingError += net.Error();
+        net.FeedBackward(dataBatch, error);
+        net.ApplyGradients();
+      }
+
+      trainingError /= index.n_elem;
+    }
+
+    /**
+     * Take a single step on the given batch of samples with the replicas of
+     * the network: each replica computes the gradient of its own shard of the
+     * batch, the gradients are summed with a tree reduction, and the network
+     * applies them.
+     *
+     * @param data Data used to train the network.
+     * @param target Labels used to train the network.
+     * @param begin Position of the first sample of the batch.
+     * @param end Position one past the last sample of the batch.
+     * @return The summed error of the samples of the batch.
+     */
+    template<typename InputType, typename OutputType>
+    double TrainReplicas(InputType& data,
+                         OutputType& target,
+                         const size_t begin,
+                         const size_t end)
+    {
+      const size_t numReplicas = replicas.size();
+      const size_t shardSize = (end - begin + numReplicas - 1) / numReplicas;
+
+      replicaErrors.resize(numReplicas);
+      arma::vec shardErrors = arma::zeros<arma::vec>(numReplicas);
+
+      #pragma omp parallel for num_threads(numReplicas) schedule(static)
+      for (size_t r = 0; r < numReplicas; ++r)
+      {
+        const size_t shardBegin = std::min(begin + r * shardSize, end);
+        const size_t shardEnd = std::min(shardBegin + shardSize, end);
+        if (shardBegin == shardEnd)
+          continue;
+
+        NetworkType& replica = *replicas[r];
+        replica.CopyWeights(net);
+
+        const InputType dataShard = Batch(data, shardBegin, shardEnd, shuffle);
+        const OutputType targetShard = Batch(target, shardBegin, shardEnd,
+            shuffle);
+
+        shardErrors[r] = replica.Evaluate(dataShard, targetShard,
+            replicaErrors[r]);
+        replica.FeedBackward(dataShard, replicaErrors[r]);
+
+        // The gradients of a replica are averaged over its shard, so they are
+        // weighted with the size of the shard to give the mean over the batch.
+        replica.ScaleGradients((double) (shardEnd - shardBegin) /
+            (end - begin));
+      }
+
+      // Sum the gradients of the replicas pairwise, so that the reduction
+      // takes log2(numReplicas) rounds.
+      for (size_t stride = 1; stride < numReplicas; stride *= 2)
+      {
+        #pragma omp parallel for num_threads(numReplicas) schedule(static)
+        for (size_t r = 0; r < numReplicas - stride; r += 2 * stride)
+          replicas[r]->MergeGradients(*replicas[r + stride]);
+      }
+
+      net.MergeGradients(*replicas[0]);
+      net.ApplyGradients();
+
+      return arma::accu(shardErrors);
+    }
+
+    /**
+     * Train the network on the given dataset, one sample at a time.
+     *
+     * @param data Data used to train the network.
+     * @param target Labels used to train the network.
+     */
+    template<typename InputType, typename OutputType>
+    typename std::enable_if<NetworkTraits<NetworkType>::IsRNN, void>::type
+    Train(InputType& data, OutputType& target)
     {
       // Reset the training error.
       trainingError = 0;
@@ -157,13 +397,38 @@ class Trainer
     }
 
     /**
-     * Evaluate the network on the given dataset.
+     * Evaluate the network on the given dataset, one batch of samples at a
+     * time.
      *
      * @param data Data used to train the network.
      * @param target Labels used to train the network.
      */
     template<typename InputType, typename OutputType>
-    void Evaluate(InputType& data, OutputType& target)
+    typename std::enable_if<!NetworkTraits<NetworkType>::IsRNN, void>::type
+    Evaluate(InputType& data, OutputType& target)
+    {
+      // Reset the validation error.
+      validationError = 0;
+
+      for (size_t i = 0; i < ElementCount(data); i += batchSize)
+      {
+        const size_t end = std::min(i + batchSize, ElementCount(data));
+        validationError += net.Evaluate(Batch(data, i, end, false),
+            Batch(target, i, end, false), error);
+      }
+
+      validationError /= ElementCount(data);
+    }
+
+    /**
+     * Evaluate the network on the given dataset, one sample at a time.
+     *
+     * @param data Data used to train the network.
+     * @param target Labels used to train the network.
+     */
+    template<typename InputType, typename OutputType>
+    typename std::enable_if<NetworkTraits<NetworkType>::IsRNN, void>::type
+    Evaluate(InputType& data, OutputType& target)
     {
       // Reset the validation error.
       validationError = 0;
@@ -177,6 +442,61 @@ class Trainer
       validationError /= ElementCount(data);
     }
 
+    /*
+     * Collect the columns of the given batch of samples into a matrix.  If the
+     * samples are visited in linear order, the matrix uses the memory of the
+     * existing matrix object (this approach is currently not alias safe).
+     *
+     * @param input The reference data.
+     * @param begin Position of the first sample of the batch.
+     * @param end Position one past the last sample of the batch.
+     * @param shuffled Whether or not to visit the samples in the (shuffled)
+     *     index order.
+     */
+    template<typename eT>
+    arma::Mat<eT> Batch(arma::Mat<eT>& input,
+                        const size_t begin,
+                        const size_t end,
+                        const bool shuffled)
+    {
+      if (!shuffled)
+      {
+        return arma::Mat<eT>(input.colptr(begin), input.n_rows, end - begin,
+            false, true);
+      }
+
+      arma::Mat<eT> batch(input.n_rows, end - begin);
+      for (size_t i = begin; i < end; ++i)
+        batch.col(i - begin) = input.col(index(i));
+
+      return batch;
+    }
+
+    /*
+     * Collect the slices of the given batch of samples into a cube.
+     *
+     * @param input The reference data.
+     * @param begin Position of the first sample of the batch.
+     * @param end Position one past the last sample of the batch.
+     * @param shuffled Whether or not to visit the samples in the (shuffled)
+     *     index order.
+     */
+    template<typename eT>
+    arma::Cube<eT> Batch(arma::Cube<eT>& input,
+                         const size_t begin,
+                         const size_t end,
+                         const bool shuffled)
+    {
+      if (!shuffled)
+        return input.slices(begin, end - 1);
+
+      arma::Cube<eT> batch(input.n_rows, input.n_cols, end - begin);
+      for (size_t i = begin; i < end; ++i)
+        batch.slice(i - begin) = input.slice(index(i));
+
+      return batch;
+    }
+
     /*
      * Create a Col object which uses memory from an existing matrix object.
      * (This approach is currently not alias safe)
@@ -244,7 +564,7 @@ class Trainer
     //! The network which should be trained and evaluated.
     NetworkType& net;
 
-    //! The current network error of a single input.
+    //! The current network error of a single input or batch.
     MatType error;
 
     //! The current epoch if maxEpochs is set.
@@ -271,6 +591,15 @@ class Trainer
     //! Controls whether or not the individual inputs are shuffled when
     //! iterating.
     bool shuffle;
+
+    //! The number of threads used for training (0 means the OpenMP default).
+    size_t numThreads;
+
+    //! The replicas of the network used for data parallel training.
+    std::vector<NetworkType*> replicas;
+
+    //! The current network error of the shard of each replica.
+    std::vector<MatType> replicaErrors;
 }; // class Trainer
 
 }; // namespace ann
@@ -0,0 +1,204 @@
+/**
+ * @file weight_blob.hpp
+ * @author Ryan Curtin
+ *
+ * Definition of the WeightBlob class, which saves and loads the weights of the
+ * layers of a network as one raw binary file.
+ */
+#ifndef __MLPACK_METHODS_ANN_WEIGHT_BLOB_HPP
+#define __MLPACK_METHODS_ANN_WEIGHT_BLOB_HPP
+
+#include <mlpack/core.hpp>
+
+#include <cstring>
+#include <fstream>
+#include <stdint.h>
+
+namespace mlpack {
+namespace ann /** Artificial Neural Network. */ {
+
+/**
+ * A WeightBlob holds references to the weight matrices (or cubes) of the
+ * layers of a network, so that they can be saved to and loaded from a raw
+ * binary file.  The file starts with a short header that gives the number of
+ * weight blocks and the number and size of the elements of each block; the
+ * elements of all blocks follow, in the order the blocks were added, in the
+ * native byte order.
+ *
+ * Load() reads the whole file with a single read and copies each block into
+ * the weights it belongs to, so it is much cheaper than boost::serialization
+ * for the large matrices of a trained network.  The weights have to have their
+ * final size already (which is the case once the layers are constructed), and
+ * each block of the file has to match them; otherwise a std::runtime_error is
+ * thrown.
+ */
+class WeightBlob
+{
+ public:
+  /**
+   * Add the given weight matrix to the blob.  The matrix is held by reference,
+   * so it must outlive the blob.
+   *
+   * @param weights Weight matrix to add.
+   */
+  template<typename eT>
+  void Add(arma::Mat<eT>& weights)
+  {
+    blocks.push_back(Block((char*) weights.memptr(), weights.n_elem,
+        sizeof(eT)));
+  }
+
+  /**
+   * Add the given weight cube to the blob.  The cube is held by reference, so
+   * it must outlive the blob.
+   *
+   * @param weights Weight cube to add.
+   */
+  template<typename eT>
+  void Add(arma::Cube<eT>& weights)
+  {
+    blocks.push_back(Block((char*) weights.memptr(), weights.n_elem,
+        sizeof(eT)));
+  }
+
+  /**
+   * Save the weights to the given file.  A std::runtime_error is thrown if the
+   * file cannot be written.
+   *
+   * @param filename Name of the file to write.
+   */
+  void Save(const std::string& filename) const
+  {
+    std::ofstream stream(filename.c_str(), std::ios::out | std::ios::binary);
+    if (!stream.is_open())
+      throw std::runtime_error("WeightBlob::Save(): cannot open '" + filename +
+          "' for writing");
+
+    std::vector<uint64_t> header;
+    header.push_back(blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+      header.push_back(blocks[i].elements);
+      header.push_back(blocks[i].elementSize);
+    }
+
+    stream.write(Magic(), MagicLength());
+    stream.write((const char*) &header[0], header.size() * sizeof(uint64_t));
+    for (size_t i = 0; i < blocks.size(); ++i)
+      stream.write(blocks[i].memory, blocks[i].elements *
+          blocks[i].elementSize);
+
+    if (!stream.good())
+      throw std::runtime_error("WeightBlob::Save(): cannot write '" +
+          filename + "'");
+  }
+
+  /**
+   * Load the weights from the given file, which has to have been written by
+   * Save() for weights of the same sizes.  A std::runtime_error is thrown if
+   * the file cannot be read or does not match the weights.
+   *
+   * @param filename Name of the file to read.
+   */
+  void Load(const std::string& filename)
+  {
+    std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!stream.is_open())
+      throw std::runtime_error("WeightBlob::Load(): cannot open '" + filename +
+          "'");
+
+    stream.seekg(0, std::ios::end);
+    const size_t length = (size_t) stream.tellg();
+    stream.seekg(0, std::ios::beg);
+
+    // The expected layout of the file.
+    const size_t headerLength = MagicLength() + (2 * blocks.size() + 1) *
+        sizeof(uint64_t);
+    size_t expectedLength = headerLength;
+    for (size_t i = 0; i < blocks.size(); ++i)
+      expectedLength += blocks[i].elements * blocks[i].elementSize;
+
+    if (length != expectedLength)
+    {
+      std::ostringstream oss;
+      oss << "WeightBlob::Load(): '" << filename << "' holds " << length
+          << " bytes, but the weights need " << expectedLength;
+      throw std::runtime_error(oss.str());
+    }
+
+    std::vector<char> buffer(length);
+    stream.read(&buffer[0], length);
+    if ((size_t) stream.gcount() != length)
+      throw std::runtime_error("WeightBlob::Load(): cannot read '" + filename +
+          "'");
+
+    if (std::memcmp(&buffer[0], Magic(), MagicLength()) != 0)
+      throw std::runtime_error("WeightBlob::Load(): '" + filename + "' is not "
+          "a weight blob");
+
+    std::vector<uint64_t> header(2 * blocks.size() + 1);
+    std::memcpy(&header[0], &buffer[MagicLength()], header.size() *
+        sizeof(uint64_t));
+
+    if (header[0] != blocks.size())
+    {
+      std::ostringstream oss;
+      oss << "WeightBlob::Load(): '" << filename << "' holds " << header[0]
+          << " weight blocks, but the network has " << blocks.size();
+      throw std::runtime_error(oss.str());
+    }
+
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+      if (header[2 * i + 1] != blocks[i].elements ||
+          header[2 * i + 2] != blocks[i].elementSize)
+      {
+        std::ostringstream oss;
+        oss << "WeightBlob::Load(): the weights in '" << filename << "' do "
+            << "not match the weights of block " << i << " (" <<
+            blocks[i].elements << " elements of " << blocks[i].elementSize
+            << " bytes)";
+        throw std::runtime_error(oss.str());
+      }
+    }
+
+    size_t offset = headerLength;
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+      const size_t bytes = blocks[i].elements * blocks[i].elementSize;
+      std::memcpy(blocks[i].memory, &buffer[offset], bytes);
+      offset += bytes;
+    }
+  }
+
+  //! Get the number of weight blocks in the blob.
+  size_t Blocks() const { return blocks.size(); }
+
+ private:
+  //! The memory of one weight matrix or cube.
+  struct Block
+  {
+    Block(char* memory, const size_t elements, const size_t elementSize) :
+        memory(memory), elements(elements), elementSize(elementSize) { }
+
+    //! The memory of the weights.
+    char* memory;
+    //! The number of elements of the weights.
+    size_t elements;
+    //! The size of each element of the weights, in bytes.
+    size_t elementSize;
+  };
+
+  //! The string every weight blob file starts with.
+  static const char* Magic() { return "MLPACK_ANN_WEIGHTS\n"; }
+  //! The length of the string every weight blob file starts with.
+  static size_t MagicLength() { return 19; }
+
+  //! The weight blocks, in the order they are stored in the file.
+  std::vector<Block> blocks;
+};
+
+} // namespace ann
+} // namespace mlpack
+
+#endif
@@ -13,9 +13,12 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <mlpack/methods/fastmks/fastmks.hpp>
+#include <mlpack/methods/lsh/lsh_search.hpp>
 #include <mlpack/methods/amf/amf.hpp>
 #include <mlpack/methods/amf/update_rules/nmf_als.hpp>
 #include <mlpack/methods/amf/termination_policies/simple_residue_termination.hpp>
+#include <algorithm>
 #include <set>
 #include <map>
 #include <iostream>
@@ -40,6 +43,22 @@ struct FactorizerTraits
   static const bool UsesCoordinateList = false;
 };
 
+/**
+ * The ways in which CF can find the best items for a user, once the average
+ * factor vector of the user's neighborhood is known.
+ */
+enum RecommendationSearchType
+{
+  //! Score every item (exact).
+  SCORE_ALL_ITEMS,
+  //! Search a FastMKS index of the item factors with the linear kernel
+  //! (exact).
+  FASTMKS_SEARCH,
+  //! Search an LSH index of the item factors, after transforming the maximum
+  //! inner product search into a nearest neighbor search (approximate).
+  LSH_SEARCH
+};
+
 /**
  * This class implements Collaborative Filtering (CF). This implementation
  * presently supports Alternating Least Squares (ALS) for collaborative
@@ -68,6 +87,23 @@ struct FactorizerTraits
  * are in a matrix that holds doubles, should hold integer (or size_t) values.
  * The user and item indices are assumed to start at 0.
  *
+ * Once the rating matrix is factorized, a tree over the (stretched) H matrix is
+ * built for the nearest neighbor search; it is kept in the model and reused by
+ * GetRecommendations() and Predict(), so these only search it.  Since searching
+ * the tree updates its statistics, the const Predict() functions must not be
+ * called from several threads on the same CF object at once.
+ *
+ * The predicted ratings of a user are the inner products of the item factors
+ * (the rows of W) with the average H column of the user's neighborhood, so the
+ * best items can also be found with a maximum inner product search over the
+ * item factors, instead of scoring every item; see SearchType().  The
+ * FASTMKS_SEARCH and LSH_SEARCH indices are built the first time they are used.
+ * For LSH_SEARCH, the item factors x are scaled by the largest norm M and
+ * mapped to [x / M; sqrt(1 - ||x / M||^2)], and the queries q to
+ * [q / ||q||; 0], so that the nearest neighbors are the items with the largest
+ * inner products (see "On Symmetric and Asymmetric LSHs for Inner Product
+ * Search", Neyshabur and Srebro, 2015).
+ *
  * @tparam FactorizerType The type of matrix factorization to use to decompose
  *     the rating matrix (a W and H matrix).  This must implement the method
  *     Apply(arma::sp_mat& data, size_t rank, arma::mat& W, arma::mat& H).
@@ -124,6 +160,18 @@ class CF
      const size_t numUsersForSimilarity = 5,
      const size_t rank = 0);
 
+  /**
+   * Create a CF object without any model, so that a model can be loaded into it
+   * with Serialize().
+   *
+   * @param numUsersForSimilarity Size of the neighborhood.
+   * @param rank Rank parameter for matrix factorization.
+   */
+  CF(const size_t numUsersForSimilarity = 5, const size_t rank = 0);
+
+  //! Delete the CF object, and the FastMKS index if it was built.
+  ~CF();
+
   //! Sets number of users for calculating similarity.
   void NumUsersForSimilarity(const size_t num)
   {
@@ -169,6 +217,23 @@ class CF
   //! Get the cleaned data matrix.
   const arma::sp_mat& CleanedData() const { return cleanedData; }
 
+  //! Get the way the best items of each user are searched for.
+  RecommendationSearchType SearchType() const { return searchType; }
+  //! Modify the way the best items of each user are searched for.
+  RecommendationSearchType& SearchType() { return searchType; }
+
+  //! Get the number of projections of each LSH table (for LSH_SEARCH).
+  size_t LSHProjections() const { return lshProjections; }
+  //! Modify the number of projections of each LSH table (for LSH_SEARCH).  This
+  //! is used when the index is built.
+  size_t& LSHProjections() { return lshProjections; }
+
+  //! Get the number of LSH tables (for LSH_SEARCH).
+  size_t LSHTables() const { return lshTables; }
+  //! Modify the number of LSH tables (for LSH_SEARCH).  This is used when the
+  //! index is built.
+  size_t& LSHTables() { return lshTables; }
+
   /**
    * Generates the given number of recommendations for all users.
    *
@@ -189,6 +254,38 @@ class CF
                           arma::Mat<size_t>& recommendations,
                           arma::Col<size_t>& users);
 
+  /**
+   * Fold new users into the model without factorizing the rating matrix again.
+   * The H column of each new user is the solution of the small regularized
+   * least squares problem
+   *
+   * \f[
+   * (W_{\Omega}^T W_{\Omega} + \lambda n I) h = W_{\Omega}^T v_{\Omega}
+   * \f]
+   *
+   * over the n items the user rated, against the fixed W.  The new users get
+   * the next user indices, their ratings are appended to the cleaned data, and
+   * the neighbor search tree is rebuilt (W does not change, so the existing
+   * stretch is kept, and the item indices of FastMKS and LSH stay valid).
+   *
+   * @param ratings Ratings of the new users (items x new users); zeros are
+   *      taken to be missing.
+   * @param lambda Regularization parameter, scaled by the number of ratings.
+   */
+  void AddUsers(const arma::sp_mat& ratings, const double lambda = 0.01);
+
+  /**
+   * Solve for the W rows of the given items again against the fixed H, using
+   * all of their ratings in the cleaned data; this is useful for items that
+   * received new ratings (for instance from the users added with AddUsers()).
+   * Since W changes, the neighbor search tree is rebuilt and the FastMKS and
+   * LSH indices are built again the next time they are used.
+   *
+   * @param items Items to update.
+   * @param lambda Regularization parameter, scaled by the number of ratings.
+   */
+  void UpdateItems(const arma::Col<size_t>& items, const double lambda = 0.01);
+
   //! Converts the User, Item, Value Matrix to User-Item Table
   static void CleanData(const arma::mat& data, arma::sp_mat& cleanedData);
 
@@ -220,6 +317,13 @@ class CF
    */
   std::string ToString() const;
 
+  /**
+   * Serialize the CF model: the factorization and the neighbor search tree
+   * built over it.  The factorizer itself is not serialized.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */);
+
  private:
   //! Number of users for similarity.
   size_t numUsersForSimilarity;
@@ -235,22 +339,57 @@ class CF
   arma::mat rating;
   //! Cleaned data matrix.
   arma::sp_mat cleanedData;
+  //! The transposed Cholesky factor of W^T W, which maps H into the space the
+  //! neighbor search is done in.
+  arma::mat stretch;
+  //! The neighbor search model over the stretched H matrix.  Searching updates
+  //! the statistics of the tree, so it is mutable for the const Predict().
+  mutable neighbor::AllkNN neighborSearch;
+
+  //! The way the best items of each user are searched for.
+  RecommendationSearchType searchType;
+  //! The number of projections of each LSH table.
+  size_t lshProjections;
+  //! The number of LSH tables.
+  size_t lshTables;
+  //! The item factors (the transpose of W): the reference set of the FastMKS
+  //! index.
+  arma::mat itemFactors;
+  //! The FastMKS index of the item factors, if it has been built.
+  fastmks::FastMKS<kernel::LinearKernel>* mksIndex;
+  //! The LSH index of the transformed item factors.
+  neighbor::LSHSearch<> lshIndex;
+  //! If true, lshIndex has been built.
+  bool lshTrained;
 
   /**
-   * Helper function to insert a point into the recommendation matrices.
+   * Build the neighbor search tree over the stretched H matrix; this is called
+   * once the factorization is done.
+   */
+  void BuildNeighborSearch();
+
+  /**
+   * Find the neighborhood of each of the given users.
    *
-   * @param queryIndex Index of point whose recommendations we are inserting
-   *     into.
-   * @param pos Position in list to insert into.
-   * @param neighbor Index of item being inserted as a recommendation.
-   * @param value Value of recommendation.
+   * @param users Users to find the neighborhood of.
+   * @param neighborhood Matrix to store the neighborhood of each user in.
+   */
+  void Neighborhood(const arma::Col<size_t>& users,
+                    arma::Mat<size_t>& neighborhood) const;
+
+  /**
+   * Search the FastMKS or LSH index for the best un-rated items of each of the
+   * given users.
+   *
+   * @param numRecs Number of recommendations.
+   * @param recommendations Matrix to save recommendations into.
+   * @param users Users for which recommendations are to be generated.
+   * @param neighborhood Neighborhood of each user.
    */
-  void InsertNeighbor(const size_t queryIndex,
-                      const size_t pos,
-                      const size_t neighbor,
-                      const double value,
-                      arma::Mat<size_t>& recommendations,
-                      arma::mat& values) const;
+  void SearchRecommendations(const size_t numRecs,
+                             arma::Mat<size_t>& recommendations,
+                             const arma::Col<size_t>& users,
+                             const arma::Mat<size_t>& neighborhood);
 
 }; // class CF
 
@@ -55,7 +55,12 @@ CF<FactorizerType>::CF(const arma::mat& data,
                        const size_t rank) :
     numUsersForSimilarity(numUsersForSimilarity),
     rank(rank),
-    factorizer(factorizer)
+    factorizer(factorizer),
+    searchType(SCORE_ALL_ITEMS),
+    lshProjections(10),
+    lshTables(30),
+    mksIndex(NULL),
+    lshTrained(false)
 {
   // Validate neighbourhood size.
   if (numUsersForSimilarity < 1)
@@ -88,6 +93,8 @@ CF<FactorizerType>::CF(const arma::mat& data,
   Timer::Start("cf_factorization");
   ApplyFactorizer(factorizer, data, cleanedData, this->rank, w, h);
   Timer::Stop("cf_factorization");
+
+  BuildNeighborSearch();
 }
 
 /**
@@ -101,7 +108,12 @@ CF<FactorizerType>::CF(const arma::sp_mat& data,
                        const size_t rank) :
     numUsersForSimilarity(numUsersForSimilarity),
     rank(rank),
-    factorizer(factorizer)
+    factorizer(factorizer),
+    searchType(SCORE_ALL_ITEMS),
+    lshProjections(10),
+    lshTables(30),
+    mksIndex(NULL),
+    lshTrained(false)
 {
   // Validate neighbourhood size.
   if (numUsersForSimilarity < 1)
@@ -130,6 +142,66 @@ CF<FactorizerType>::CF(const arma::sp_mat& data,
   }
 
   factorizer.Apply(cleanedData, this->rank, w, h);
+
+  BuildNeighborSearch();
+}
+
+/**
+ * Construct the CF object without a model.
+ */
+template<typename FactorizerType>
+CF<FactorizerType>::CF(const size_t numUsersForSimilarity,
+                       const size_t rank) :
+    numUsersForSimilarity(numUsersForSimilarity),
+    rank(rank),
+    searchType(SCORE_ALL_ITEMS),
+    lshProjections(10),
+    lshTables(30),
+    mksIndex(NULL),
+    lshTrained(false)
+{
+  // Nothing to do.
+}
+
+template<typename FactorizerType>
+CF<FactorizerType>::~CF()
+{
+  if (mksIndex)
+    delete mksIndex;
+}
+
+template<typename FactorizerType>
+void CF<FactorizerType>::BuildNeighborSearch()
+{
+  // We want to avoid calculating the full rating matrix, so we will do nearest
+  // neighbor search only on the H matrix, using the observation that if the
+  // rating matrix X = W*H, then d(X.col(i), X.col(j)) = d(W H.col(i), W
+  // H.col(j)).  This can be seen as nearest neighbor search on the H matrix
+  // with the Mahalanobis distance where M^{-1} = W^T W.  So, we'll decompose
+  // M^{-1} = L L^T (the Cholesky decomposition), and then multiply H by L^T.
+  // Then we can perform nearest neighbor search.  The tree is built once here,
+  // and reused for every search.
+  stretch = arma::chol(w.t() * w); // Due to the Armadillo API, this is L^T.
+  arma::mat stretchedH = stretch * h;
+
+  Timer::Start("cf_tree_building");
+  neighborSearch.Train(std::move(stretchedH));
+  Timer::Stop("cf_tree_building");
+}
+
+template<typename FactorizerType>
+void CF<FactorizerType>::Neighborhood(const arma::Col<size_t>& users,
+                                      arma::Mat<size_t>& neighborhood) const
+{
+  // Assemble the query matrix from the stretched H matrix.  The columns of the
+  // reference set of the tree are reordered, so they are computed again.
+  arma::mat queries(stretch.n_rows, users.n_elem);
+  for (size_t i = 0; i < users.n_elem; ++i)
+    queries.col(i) = stretch * h.col(users[i]);
+
+  arma::mat distances; // Temporary storage.
+  neighborSearch.Search(queries, numUsersForSimilarity, neighborhood,
+      distances);
 }
 
 template<typename FactorizerType>
@@ -152,118 +224,352 @@ void CF<FactorizerType>::GetRecommendations(const size_t numRecs,
                                             arma::Mat<size_t>& recommendations,
                                             arma::Col<size_t>& users)
 {
-  // We want to avoid calculating the full rating matrix, so we will do nearest
-  // neighbor search only on the H matrix, using the observation that if the
-  // rating matrix X = W*H, then d(X.col(i), X.col(j)) = d(W H.col(i), W
-  // H.col(j)).  This can be seen as nearest neighbor search on the H matrix
-  // with the Mahalanobis distance where M^{-1} = W^T W.  So, we'll decompose
-  // M^{-1} = L L^T (the Cholesky decomposition), and then multiply H by L^T.
-  // Then we can perform nearest neighbor search.
-  arma::mat l = arma::chol(w.t() * w);
-  arma::mat stretchedH = l * h; // Due to the Armadillo API, l is L^T.
-
-  // Now, we will use the decomposed w and h matrices to estimate what the user
+  // Calculate the neighborhood of the queried users with the stored tree.
+  // Then we will use the decomposed w and h matrices to estimate what the user
   // would have rated items as, and then pick the best items.
-
-  // Temporarily store feature vector of queried users.
-  arma::mat query(stretchedH.n_rows, users.n_elem);
-
-  // Select feature vectors of queried users.
-  for (size_t i = 0; i < users.n_elem; i++)
-    query.col(i) = stretchedH.col(users(i));
-
-  // Temporary storage for neighborhood of the queried users.
   arma::Mat<size_t> neighborhood;
+  Neighborhood(users, neighborhood);
 
-  // Calculate the neighborhood of the queried users.
-  // This should be a templatized option.
-  neighbor::AllkNN a(stretchedH);
-  arma::mat resultingDistances; // Temporary storage.
-  a.Search(query, numUsersForSimilarity, neighborhood, resultingDistances);
+  if (searchType != SCORE_ALL_ITEMS)
+  {
+    SearchRecommendations(numRecs, recommendations, users, neighborhood);
+    return;
+  }
 
   // Generate recommendations for each query user by finding the maximum numRecs
-  // elements in the averages matrix.
+  // elements of the average rating of the neighborhood.  The averages of a
+  // block of users are computed at once, as W times the average H columns of
+  // their neighborhoods, and the blocks are handled in parallel.
+  const size_t blockSize = 256;
+  const size_t numBlocks = (users.n_elem + blockSize - 1) / blockSize;
   recommendations.set_size(numRecs, users.n_elem);
   recommendations.fill(cleanedData.n_rows); // Invalid item number.
-  arma::mat values(numRecs, users.n_elem);
-  values.fill(-DBL_MAX); // The smallest possible value.
-  for (size_t i = 0; i < users.n_elem; i++)
-  {
-    // First, calculate average of neighborhood values.
-    arma::vec averages;
-    averages.zeros(cleanedData.n_rows);
+  std::vector<char> incomplete(users.n_elem, 0);
 
-    for (size_t j = 0; j < neighborhood.n_rows; ++j)
-      averages += w * h.col(neighborhood(j, i));
-    averages /= neighborhood.n_rows;
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t block = 0; block < numBlocks; ++block)
+  {
+    const size_t begin = block * blockSize;
+    const size_t end = std::min(begin + blockSize, (size_t) users.n_elem);
 
-    // Look through the averages column corresponding to the current user.
-    for (size_t j = 0; j < averages.n_rows; ++j)
+    // First, calculate the average of the neighborhood values of each user.
+    arma::mat neighborhoodH(h.n_rows, end - begin);
+    neighborhoodH.zeros();
+    for (size_t i = begin; i < end; ++i)
     {
-      // Ensure that the user hasn't already rated the item.
-      if (cleanedData(j, users(i)) != 0.0)
-        continue; // The user already rated the item.
+      for (size_t j = 0; j < neighborhood.n_rows; ++j)
+        neighborhoodH.col(i - begin) += h.col(neighborhood(j, i));
+    }
+    neighborhoodH /= neighborhood.n_rows;
 
-      // Is the estimated value better than the worst candidate?
-      const double value = averages[j];
-      if (value > values(values.n_rows - 1, i))
+    const arma::mat averages = w * neighborhoodH;
+
+    std::vector<std::pair<double, size_t> > candidates;
+    for (size_t i = begin; i < end; ++i)
+    {
+      // Collect the items the user hasn't already rated; the rated items of
+      // the user are the nonzero entries of the user's column, in order.
+      const size_t user = users[i];
+      const double* scores = averages.colptr(i - begin);
+      size_t rated = cleanedData.col_ptrs[user];
+      const size_t ratedEnd = cleanedData.col_ptrs[user + 1];
+
+      candidates.clear();
+      for (size_t j = 0; j < averages.n_rows; ++j)
       {
-        // It should be inserted.  Which position?
-        size_t insertPosition = values.n_rows - 1;
-        while (insertPosition > 0)
+        if (rated < ratedEnd && cleanedData.row_indices[rated] == j)
         {
-          if (value <= values(insertPosition - 1, i))
-            break; // The current value is the right one.
-          insertPosition--;
+          ++rated;
+          continue; // The user already rated the item.
         }
 
-        // Now insert it into the list.
-        InsertNeighbor(i, insertPosition, j, value, recommendations,
-            values);
+        // Negate the scores, so that sorting puts the best items (and, among
+        // items with the same score, the lowest index) first.
+        candidates.push_back(std::make_pair(-scores[j], j));
       }
+
+      // Pick the numRecs best items.
+      const size_t found = std::min(numRecs, candidates.size());
+      std::partial_sort(candidates.begin(), candidates.begin() + found,
+          candidates.end());
+      for (size_t k = 0; k < found; ++k)
+        recommendations(k, i) = candidates[k].second;
+
+      if (found < numRecs)
+        incomplete[i] = 1;
     }
+  }
 
-    // If we were not able to come up with enough recommendations, issue a
-    // warning.
-    if (recommendations(values.n_rows - 1, i) == cleanedData.n_rows + 1)
-      Log::Warn << "Could not provide " << values.n_rows << " recommendations "
+  // If we were not able to come up with enough recommendations, issue a
+  // warning.
+  for (size_t i = 0; i < users.n_elem; ++i)
+  {
+    if (incomplete[i])
+      Log::Warn << "Could not provide " << numRecs << " recommendations "
           << "for user " << users(i) << " (not enough un-rated items)!"
           << std::endl;
   }
 }
 
-// Predict the rating for a single user/item combination.
 template<typename FactorizerType>
-double CF<FactorizerType>::Predict(const size_t user, const size_t item) const
+void CF<FactorizerType>::SearchRecommendations(
+    const size_t numRecs,
+    arma::Mat<size_t>& recommendations,
+    const arma::Col<size_t>& users,
+    const arma::Mat<size_t>& neighborhood)
 {
-  // First, we need to find the nearest neighbors of the given user.
-  // We'll use the same technique as for GetRecommendations().
+  // The query of each user is the average H column of its neighborhood, and
+  // the predicted ratings are its inner products with the item factors.
+  arma::mat queries(h.n_rows, users.n_elem);
+  queries.zeros();
+  size_t maxRated = 0;
+  for (size_t i = 0; i < users.n_elem; ++i)
+  {
+    for (size_t j = 0; j < neighborhood.n_rows; ++j)
+      queries.col(i) += h.col(neighborhood(j, i));
 
-  // We want to avoid calculating the full rating matrix, so we will do nearest
-  // neighbor search only on the H matrix, using the observation that if the
-  // rating matrix X = W*H, then d(X.col(i), X.col(j)) = d(W H.col(i), W
-  // H.col(j)).  This can be seen as nearest neighbor search on the H matrix
-  // with the Mahalanobis distance where M^{-1} = W^T W.  So, we'll decompose
-  // M^{-1} = L L^T (the Cholesky decomposition), and then multiply H by L^T.
-  // Then we can perform nearest neighbor search.
-  arma::mat l = arma::chol(w.t() * w);
-  arma::mat stretchedH = l * h; // Due to the Armadillo API, l is L^T.
+    maxRated = std::max(maxRated, (size_t) (cleanedData.col_ptrs[users[i] + 1]
+        - cleanedData.col_ptrs[users[i]]));
+  }
+  queries /= neighborhood.n_rows;
 
-  // Now, we will use the decomposed w and h matrices to estimate what the user
-  // would have rated items as, and then pick the best items.
+  // Search for enough items that the rated items can be skipped.
+  const size_t k = std::min(numRecs + maxRated, (size_t) w.n_rows);
+  arma::Mat<size_t> candidates;
+  if (searchType == FASTMKS_SEARCH)
+  {
+    if (!mksIndex)
+    {
+      itemFactors = trans(w);
+      mksIndex = new fastmks::FastMKS<kernel::LinearKernel>(itemFactors);
+    }
 
-  // Temporarily store feature vector of queried users.
-  arma::mat query = stretchedH.col(user);
+    arma::mat products;
+    mksIndex->Search(queries, k, candidates, products);
+  }
+  else
+  {
+    // Scale the item factors so that the largest norm is 1, and add one
+    // dimension, so that all transformed items have norm 1.
+    if (!lshTrained)
+    {
+      arma::mat transformed(w.n_cols + 1, w.n_rows);
+      transformed.rows(0, w.n_cols - 1) = trans(w);
+      const arma::rowvec norms = sqrt(sum(square(transformed.rows(0,
+          w.n_cols - 1)), 0));
+      const double maxNorm = std::max(norms.max(), DBL_MIN);
+      transformed.rows(0, w.n_cols - 1) /= maxNorm;
+      for (size_t i = 0; i < transformed.n_cols; ++i)
+        transformed(w.n_cols, i) = std::sqrt(std::max(1.0 -
+            std::pow(norms[i] / maxNorm, 2.0), 0.0));
+
+      lshIndex.Train(transformed, lshProjections, lshTables);
+      lshTrained = true;
+    }
 
-  // Temporary storage for neighborhood of the queried users.
-  arma::Mat<size_t> neighborhood;
+    // The queries are normalized, and get a zero in the added dimension.
+    arma::mat transformedQueries(w.n_cols + 1, queries.n_cols);
+    transformedQueries.zeros();
+    for (size_t i = 0; i < queries.n_cols; ++i)
+    {
+      const double norm = arma::norm(queries.col(i), 2);
+      if (norm > 0.0)
+        transformedQueries.submat(0, i, w.n_cols - 1, i) = queries.col(i) /
+            norm;
+    }
 
-  // Calculate the neighborhood of the queried users.
-  // This should be a templatized option.
-  neighbor::AllkNN a(stretchedH, false, true /* single-tree mode */);
-  arma::mat resultingDistances; // Temporary storage.
+    arma::mat distances;
+    lshIndex.Search(transformedQueries, k, candidates, distances);
+  }
 
-  a.Search(query, numUsersForSimilarity, neighborhood, resultingDistances);
+  // Take the best un-rated items of each user, in order.  Invalid indices mark
+  // candidates that were not found.
+  recommendations.set_size(numRecs, users.n_elem);
+  recommendations.fill(cleanedData.n_rows); // Invalid item number.
+  for (size_t i = 0; i < users.n_elem; ++i)
+  {
+    const arma::uword* ratedBegin = cleanedData.row_indices +
+        cleanedData.col_ptrs[users[i]];
+    const arma::uword* ratedEnd = cleanedData.row_indices +
+        cleanedData.col_ptrs[users[i] + 1];
+
+    size_t found = 0;
+    for (size_t j = 0; j < candidates.n_rows && found < numRecs; ++j)
+    {
+      const size_t item = candidates(j, i);
+      if (item >= cleanedData.n_rows ||
+          std::binary_search(ratedBegin, ratedEnd, (arma::uword) item))
+        continue;
+
+      recommendations(found++, i) = item;
+    }
+
+    if (found < numRecs)
+      Log::Warn << "Could not provide " << numRecs << " recommendations "
+          << "for user " << users(i) << " (not enough un-rated items found)!"
+          << std::endl;
+  }
+}
+
+template<typename FactorizerType>
+void CF<FactorizerType>::AddUsers(const arma::sp_mat& ratings,
+                                  const double lambda)
+{
+  if (ratings.n_rows != cleanedData.n_rows)
+  {
+    std::ostringstream oss;
+    oss << "CF::AddUsers(): the ratings have " << ratings.n_rows << " rows, "
+        << "but the model has " << cleanedData.n_rows << " items";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Solve for the H column of each new user against the fixed W.
+  const size_t oldUsers = h.n_cols;
+  const size_t r = h.n_rows;
+  h.resize(r, oldUsers + ratings.n_cols);
+
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t u = 0; u < ratings.n_cols; ++u)
+  {
+    const size_t begin = ratings.col_ptrs[u];
+    const size_t end = ratings.col_ptrs[u + 1];
+    if (begin == end)
+    {
+      h.col(oldUsers + u).zeros();
+      continue;
+    }
+
+    arma::mat a(r, r);
+    a.eye();
+    a *= lambda * (end - begin);
+    arma::vec b(r);
+    b.zeros();
+    for (size_t k = begin; k < end; ++k)
+    {
+      const arma::vec factor = trans(w.row(ratings.row_indices[k]));
+      a += factor * trans(factor);
+      b += ratings.values[k] * factor;
+    }
+
+    arma::vec x;
+    arma::solve(x, a, b);
+    h.col(oldUsers + u) = x;
+  }
+
+  // Append the ratings of the new users to the cleaned data.
+  arma::umat locations(2, cleanedData.n_nonzero + ratings.n_nonzero);
+  arma::vec values(cleanedData.n_nonzero + ratings.n_nonzero);
+  size_t entry = 0;
+  for (size_t u = 0; u < cleanedData.n_cols; ++u)
+  {
+    for (size_t k = cleanedData.col_ptrs[u]; k < cleanedData.col_ptrs[u + 1];
+        ++k, ++entry)
+    {
+      locations(0, entry) = cleanedData.row_indices[k];
+      locations(1, entry) = u;
+      values[entry] = cleanedData.values[k];
+    }
+  }
+  for (size_t u = 0; u < ratings.n_cols; ++u)
+  {
+    for (size_t k = ratings.col_ptrs[u]; k < ratings.col_ptrs[u + 1];
+        ++k, ++entry)
+    {
+      locations(0, entry) = ratings.row_indices[k];
+      locations(1, entry) = oldUsers + u;
+      values[entry] = ratings.values[k];
+    }
+  }
+  cleanedData = arma::sp_mat(locations, values, cleanedData.n_rows,
+      oldUsers + ratings.n_cols);
+
+  // W didn't change, so only the tree has to be built again.
+  Timer::Start("cf_tree_building");
+  neighborSearch.Train(arma::mat(stretch * h));
+  Timer::Stop("cf_tree_building");
+}
+
+template<typename FactorizerType>
+void CF<FactorizerType>::UpdateItems(const arma::Col<size_t>& items,
+                                     const double lambda)
+{
+  // Map each item to its (first) position in the list; items not in the list
+  // map to items.n_elem.
+  std::vector<size_t> positions(cleanedData.n_rows, items.n_elem);
+  for (size_t i = 0; i < items.n_elem; ++i)
+  {
+    if (items[i] >= cleanedData.n_rows)
+    {
+      std::ostringstream oss;
+      oss << "CF::UpdateItems(): item " << items[i] << " is not in the model ("
+          << cleanedData.n_rows << " items)";
+      throw std::invalid_argument(oss.str());
+    }
+
+    if (positions[items[i]] == items.n_elem)
+      positions[items[i]] = i;
+  }
+
+  // Collect the normal equations of each item, in one pass over the ratings.
+  const size_t r = w.n_cols;
+  arma::cube a(r, r, items.n_elem);
+  a.zeros();
+  arma::mat b(r, items.n_elem);
+  b.zeros();
+  arma::Col<size_t> counts(items.n_elem);
+  counts.zeros();
+  for (size_t u = 0; u < cleanedData.n_cols; ++u)
+  {
+    for (size_t k = cleanedData.col_ptrs[u]; k < cleanedData.col_ptrs[u + 1];
+        ++k)
+    {
+      const size_t p = positions[cleanedData.row_indices[k]];
+      if (p == items.n_elem)
+        continue;
+
+      a.slice(p) += h.col(u) * trans(h.col(u));
+      b.col(p) += cleanedData.values[k] * h.col(u);
+      ++counts[p];
+    }
+  }
+
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t p = 0; p < items.n_elem; ++p)
+  {
+    if (positions[items[p]] != p)
+      continue; // A repeated item.
+
+    if (counts[p] == 0)
+    {
+      w.row(items[p]).zeros();
+      continue;
+    }
+
+    a.slice(p) += (lambda * counts[p]) * arma::eye<arma::mat>(r, r);
+    arma::vec x;
+    arma::solve(x, a.slice(p), b.col(p));
+    w.row(items[p]) = trans(x);
+  }
+
+  // W changed, so the stretch and the tree have to be computed again, and the
+  // FastMKS and LSH indices are out of date.
+  BuildNeighborSearch();
+  if (mksIndex)
+    delete mksIndex;
+  mksIndex = NULL;
+  lshTrained = false;
+}
+
+// Predict the rating for a single user/item combination.
+template<typename FactorizerType>
+double CF<FactorizerType>::Predict(const size_t user, const size_t item) const
+{
+  // First, we need to find the nearest neighbors of the given user, with the
+  // stored tree.
+  arma::Col<size_t> users(1);
+  users[0] = user;
+  arma::Mat<size_t> neighborhood;
+  Neighborhood(users, neighborhood);
 
   double rating = 0; // We'll take the average of neighborhood values.
 
@@ -279,11 +585,7 @@ template<typename FactorizerType>
 void CF<FactorizerType>::Predict(const arma::Mat<size_t>& combinations,
                                  arma::vec& predictions) const
 {
-  // First, for nearest neighbor search, stretch the H matrix.
-  arma::mat l = arma::chol(w.t() * w);
-  arma::mat stretchedH = l * h; // Due to the Armadillo API, l is L^T.
-
-  // Now, we must determine those query indices we need to find the nearest
+  // First, we must determine those query indices we need to find the nearest
   // neighbors for.  This is easiest if we just sort the combinations matrix.
   arma::Mat<size_t> sortedCombinations(combinations.n_rows,
                                        combinations.n_cols);
@@ -294,17 +596,10 @@ void CF<FactorizerType>::Predict(const arma::Mat<size_t>& combinations,
   // Now, we have to get the list of unique users we will be searching for.
   arma::Col<size_t> users = arma::unique(combinations.row(0).t());
 
-  // Assemble our query matrix from the stretchedH matrix.
-  arma::mat queries(stretchedH.n_rows, users.n_elem);
-  for (size_t i = 0; i < queries.n_cols; ++i)
-    queries.col(i) = stretchedH.col(users[i]);
-
-  // Now calculate the neighborhood of these users.
-  neighbor::AllkNN a(stretchedH);
-  arma::mat distances;
+  // Now calculate the neighborhood of these users with the stored tree, once
+  // for all the items of each user.
   arma::Mat<size_t> neighborhood;
-
-  a.Search(queries, numUsersForSimilarity, neighborhood, distances);
+  Neighborhood(users, neighborhood);
 
   // Now that we have the neighborhoods we need, calculate the predictions.
   predictions.set_size(combinations.n_cols);
@@ -355,37 +650,34 @@ void CF<FactorizerType>::CleanData(const arma::mat& data, arma::sp_mat& cleanedD
   cleanedData = arma::sp_mat(locations, values, maxItemID, maxUserID);
 }
 
-/**
- * Helper function to insert a point into the recommendation matrices.
- *
- * @param queryIndex Index of point whose recommendations we are inserting into.
- * @param pos Position in list to insert into.
- * @param neighbor Index of item being inserted as a recommendation.
- * @param value Value of recommendation.
- */
+// Serialize the model.
 template<typename FactorizerType>
-void CF<FactorizerType>::InsertNeighbor(const size_t queryIndex,
-                                        const size_t pos,
-                                        const size_t neighbor,
-                                        const double value,
-                                        arma::Mat<size_t>& recommendations,
-                                        arma::mat& values) const
+template<typename Archive>
+void CF<FactorizerType>::Serialize(Archive& ar,
+                                   const unsigned int /* version */)
 {
-  // We only memmove() if there is actually a need to shift something.
-  if (pos < (recommendations.n_rows - 1))
+  using data::CreateNVP;
+
+  ar & CreateNVP(numUsersForSimilarity, "numUsersForSimilarity");
+  ar & CreateNVP(rank, "rank");
+  ar & CreateNVP(w, "w");
+  ar & CreateNVP(h, "h");
+  ar & CreateNVP(cleanedData, "cleanedData");
+  ar & CreateNVP(stretch, "stretch");
+  ar & CreateNVP(neighborSearch, "neighborSearch");
+  ar & CreateNVP(searchType, "searchType");
+  ar & CreateNVP(lshProjections, "lshProjections");
+  ar & CreateNVP(lshTables, "lshTables");
+
+  // The FastMKS and LSH indices are not serialized; they are built again the
+  // first time they are used.
+  if (Archive::is_loading::value)
   {
-    const int len = (values.n_rows - 1) - pos;
-    memmove(values.colptr(queryIndex) + (pos + 1),
-        values.colptr(queryIndex) + pos,
-        sizeof(double) * len);
-    memmove(recommendations.colptr(queryIndex) + (pos + 1),
-        recommendations.colptr(queryIndex) + pos,
-        sizeof(size_t) * len);
+    if (mksIndex)
+      delete mksIndex;
+    mksIndex = NULL;
+    lshTrained = false;
   }
-
-  // Now put the new information in the right index.
-  values(pos, queryIndex) = value;
-  recommendations(pos, queryIndex) = neighbor;
 }
 
 // Return string of object.
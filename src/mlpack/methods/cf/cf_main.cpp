@@ -46,6 +46,8 @@ PROGRAM_INFO("Collaborating Filtering", "This program performs collaborative "
     "'RegSVD' -- Regularized SVD using a SGD optimizer\n"
     "'NMF' -- Non-negative matrix factorization with alternating least squares "
     "update rules\n"
+    "'WeightedALS' -- Alternating least squares fitted to the observed ratings "
+    "only\n"
     "'BatchSVD' -- SVD batch learning\n"
     "'SVDIncompleteIncremental' -- SVD incomplete incremental learning\n"
     "'SVDCompleteIncremental' -- SVD complete incremental learning\n");
@@ -139,9 +141,9 @@ void ComputeRMSE(CF<Factorizer>& cf)
   Log::Info << "RMSE is " << rmse << "." << endl;
 }
 
-template<typename Factorizer>
+template<typename Factorizer, typename MatType>
 void PerformAction(Factorizer&& factorizer,
-                   arma::mat& dataset,
+                   const MatType& dataset,
                    const size_t rank)
 {
   // Parameters for generating the CF object.
@@ -168,8 +170,32 @@ void PerformAction(Factorizer&& factorizer,
   }
 }
 
+// Perform the action on the ratings matrix if it was loaded, and on the
+// coordinate list otherwise.
+template<typename Factorizer>
+void PerformAction(Factorizer&& factorizer,
+                   const arma::mat& dataset,
+                   const arma::sp_mat& ratings,
+                   const size_t rank)
+{
+  if (dataset.n_elem == 0)
+    PerformAction(std::forward<Factorizer>(factorizer), ratings, rank);
+  else
+    PerformAction(std::forward<Factorizer>(factorizer), dataset, rank);
+}
+
+// RegularizedSVD can only use the coordinate list.
+void PerformAction(RegularizedSVD<>&& factorizer,
+                   const arma::mat& dataset,
+                   const arma::sp_mat& /* ratings */,
+                   const size_t rank)
+{
+  PerformAction(std::move(factorizer), dataset, rank);
+}
+
 void AssembleFactorizerType(const std::string& algorithm,
                             arma::mat& dataset,
+                            arma::sp_mat& ratings,
                             const bool maxIterationTermination,
                             const size_t rank)
 {
@@ -182,25 +208,31 @@ void AssembleFactorizerType(const std::string& algorithm,
     {
       typedef AMF<MaxIterationTermination, RandomInitialization, NMFALSUpdate>
           FactorizerType;
-      PerformAction(FactorizerType(mit), dataset, rank);
+      PerformAction(FactorizerType(mit), dataset, ratings, rank);
+    }
+    else if (algorithm == "WeightedALS")
+    {
+      typedef AMF<MaxIterationTermination, RandomInitialization,
+          WeightedALSUpdate> FactorizerType;
+      PerformAction(FactorizerType(mit), dataset, ratings, rank);
     }
     else if (algorithm == "SVDBatch")
     {
       typedef AMF<MaxIterationTermination, RandomInitialization,
           SVDBatchLearning> FactorizerType;
-      PerformAction(FactorizerType(mit), dataset, rank);
+      PerformAction(FactorizerType(mit), dataset, ratings, rank);
     }
     else if (algorithm == "SVDIncompleteIncremental")
     {
       typedef AMF<MaxIterationTermination, RandomInitialization,
           SVDIncompleteIncrementalLearning> FactorizerType;
-      PerformAction(FactorizerType(mit), dataset, rank);
+      PerformAction(FactorizerType(mit), dataset, ratings, rank);
     }
     else if (algorithm == "SVDCompleteIncremental")
     {
       typedef AMF<MaxIterationTermination, RandomInitialization,
           SVDCompleteIncrementalLearning<arma::sp_mat>> FactorizerType;
-      PerformAction(FactorizerType(mit), dataset, rank);
+      PerformAction(FactorizerType(mit), dataset, ratings, rank);
     }
     else if (algorithm == "RegSVD")
     {
@@ -215,16 +247,19 @@ void AssembleFactorizerType(const std::string& algorithm,
     const double minResidue = CLI::GetParam<double>("min_residue");
     SimpleResidueTermination srt(minResidue, maxIterations);
     if (algorithm == "NMF")
-      PerformAction(NMFALSFactorizer(srt), dataset, rank);
+      PerformAction(NMFALSFactorizer(srt), dataset, ratings, rank);
+    else if (algorithm == "WeightedALS")
+      PerformAction(WeightedALSFactorizer(srt), dataset, ratings, rank);
     else if (algorithm == "SVDBatch")
-      PerformAction(SVDBatchFactorizer(srt), dataset, rank);
+      PerformAction(SVDBatchFactorizer(srt), dataset, ratings, rank);
     else if (algorithm == "SVDIncompleteIncremental")
       PerformAction(SparseSVDIncompleteIncrementalFactorizer(srt), dataset,
-          rank);
+          ratings, rank);
     else if (algorithm == "SVDCompleteIncremental")
-      PerformAction(SparseSVDCompleteIncrementalFactorizer(srt), dataset, rank);
+      PerformAction(SparseSVDCompleteIncrementalFactorizer(srt), dataset,
+          ratings, rank);
     else if (algorithm == "RegSVD")
-      PerformAction(RegularizedSVD<>(maxIterations), dataset, rank);
+      PerformAction(RegularizedSVD<>(maxIterations), dataset, ratings, rank);
   }
 }
 
@@ -238,11 +273,6 @@ int main(int argc, char** argv)
   else
     math::RandomSeed(CLI::GetParam<int>("seed"));
 
-  // Read from the input file.
-  const string inputFile = CLI::GetParam<string>("input_file");
-  arma::mat dataset;
-  data::Load(inputFile, dataset, true);
-
   // Recommendation matrix.
   arma::Mat<size_t> recommendations;
 
@@ -261,13 +291,14 @@ int main(int argc, char** argv)
 
   // Issue an error if an invalid factorizer is used.
   if (algo != "NMF" &&
+      algo != "WeightedALS" &&
       algo != "SVDBatch" &&
       algo != "SVDIncompleteIncremental" &&
       algo != "SVDCompleteIncremental" &&
       algo != "RegSVD")
     Log::Fatal << "Invalid decomposition algorithm.  Choices are 'NMF', "
-        << "'SVDBatch', 'SVDIncompleteIncremental', 'SVDCompleteIncremental',"
-        << " and 'RegSVD'." << endl;
+        << "'WeightedALS', 'SVDBatch', 'SVDIncompleteIncremental', "
+        << "'SVDCompleteIncremental', and 'RegSVD'." << endl;
 
   // Issue a warning if the user provided a minimum residue but it will be
   // ignored.
@@ -276,7 +307,21 @@ int main(int argc, char** argv)
     Log::Warn << "--min_residue ignored, because --iteration_only_termination "
         << "is specified." << endl;
 
+  // Read from the input file.  Every factorizer but RegSVD works on the sparse
+  // items-by-users matrix, which can be loaded straight from a text coordinate
+  // list of (user, item, rating) entries (transposing it), without holding the
+  // coordinate list in memory.
+  const string inputFile = CLI::GetParam<string>("input_file");
+  const string extension = data::Extension(data::StripCompression(inputFile));
+  arma::mat dataset;
+  arma::sp_mat ratings;
+  if (algo != "RegSVD" && (extension == "csv" || extension == "tsv" ||
+      extension == "mtx"))
+    data::Load(inputFile, ratings, true);
+  else
+    data::Load(inputFile, dataset, true);
+
   // Perform the factorization and do whatever the user wanted.
-  AssembleFactorizerType(algo, dataset,
+  AssembleFactorizerType(algo, dataset, ratings,
       CLI::HasParam("iteration_only_termination"), rank);
 }
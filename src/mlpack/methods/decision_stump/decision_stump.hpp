@@ -23,6 +23,13 @@ namespace decision_stump {
  * last bin has range up to \infty (split[i + 1] does not exist in that case).
  * Points that are below the first bin will take the label of the first bin.
  *
+ * Training sorts every attribute once, and the sorting permutations are kept
+ * with the stump.  A stump trained with the weighted constructor (as AdaBoost
+ * does in every round) reuses the permutations of the stump it copies its
+ * parameters from; they are checked against the data in linear time, and only
+ * the attributes whose values have changed are sorted again.  The attributes
+ * are evaluated in parallel if mlpack is compiled with OpenMP.
+ *
  * @tparam MatType Type of matrix that is being used (sparse or dense).
  */
 template <typename MatType = arma::mat>
@@ -56,7 +63,11 @@ class DecisionStump
   /**
    * Alternate constructor which copies parameters bucketSize and numClass from
    * an already initiated decision stump, other. It appropriately sets the
-   * weight vector.
+   * weight vector.  The sorting permutations of the attributes are taken from
+   * (and, if they do not match the data, updated in) other, so training many
+   * stumps from the same other object on the same data sorts the data only
+   * once; for the same reason, two stumps should not be trained from the same
+   * other object at the same time.
    *
    * @param other The other initiated Decision Stump object from
    *      which we copy the values.
@@ -101,16 +112,23 @@ class DecisionStump
   //! Stores the labels for each splitting bin.
   arma::Col<size_t> binLabels;
 
+  //! The stable sorting permutation of each attribute of the data the stump
+  //! was last trained on (or that a stump copying it was trained on), one
+  //! attribute per column.
+  mutable arma::umat sortedIndices;
+
   /**
    * Sets up attribute as if it were splitting on it and finds entropy when
    * splitting on attribute.
    *
    * @param attribute A row from the training data, which might be a
    *     candidate for the splitting attribute.
+   * @param sortedIndexAtt The stable sorting permutation of the attribute.
    * @param isWeight Whether we need to run a weighted Decision Stump.
    */
   template <bool isWeight>
   double SetupSplitAttribute(const arma::rowvec& attribute,
+                             const arma::uvec& sortedIndexAtt,
                              const arma::Row<size_t>& labels,
                              const arma::rowvec& weightD);
 
@@ -120,9 +138,13 @@ class DecisionStump
    *
    * @param attribute attribute is the attribute decided by the constructor
    *      on which we now train the decision stump.
+   * @param sortedSplitIndexAtt The stable sorting permutation of the
+   *      attribute.
    */
-  template <typename rType> void TrainOnAtt(const arma::rowvec& attribute,
-                                            const arma::Row<size_t>& labels);
+  template <typename rType>
+  void TrainOnAtt(const arma::rowvec& attribute,
+                  const arma::uvec& sortedSplitIndexAtt,
+                  const arma::Row<size_t>& labels);
 
   /**
    * After the "split" matrix has been set up, merge ranges with identical class
@@ -146,6 +168,17 @@ class DecisionStump
    */
   template <typename rType> int IsDistinct(const arma::Row<rType>& featureRow);
 
+  /**
+   * Returns true if index is the stable sorting permutation of attribute,
+   * that is, if the values are nondecreasing in the order of index and equal
+   * values appear in increasing order of their indices.
+   *
+   * @param attribute The attribute to check.
+   * @param index The permutation to check.
+   */
+  static bool IsSortedBy(const arma::rowvec& attribute,
+                         const arma::uvec& index);
+
   /**
    * Calculate the entropy of the given attribute.
    *
@@ -162,11 +195,14 @@ class DecisionStump
    *
    * @param data Dataset to train on.
    * @param labels Labels for dataset.
+   * @param weightD Weights of the points (if isWeight is true).
+   * @param indices Sorting permutations of the attributes, which are used if
+   *     they match the data and updated otherwise.
    * @param isWeight Whether we need to run a weighted Decision Stump.
    */
   template <bool isWeight>
   void Train(const MatType& data, const arma::Row<size_t>& labels,
-             const arma::rowvec& weightD);
+             const arma::rowvec& weightD, arma::umat& indices);
 
 };
 
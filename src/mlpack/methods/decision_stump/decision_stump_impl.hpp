@@ -33,7 +33,7 @@ DecisionStump<MatType>::DecisionStump(const MatType& data,
 
   arma::rowvec weightD;
 
-  Train<false>(data, labels, weightD);
+  Train<false>(data, labels, weightD, sortedIndices);
 }
 
 /**
@@ -45,26 +45,54 @@ DecisionStump<MatType>::DecisionStump(const MatType& data,
  */
 template<typename MatType>
 template <bool isWeight>
-void DecisionStump<MatType>::Train(const MatType& data, const arma::Row<size_t>& labels,
-                                    const arma::rowvec& weightD)
+void DecisionStump<MatType>::Train(const MatType& data,
+                                   const arma::Row<size_t>& labels,
+                                   const arma::rowvec& weightD,
+                                   arma::umat& indices)
 {
   // If classLabels are not all identical, proceed with training.
   int bestAtt = 0;
-  double entropy;
   const double rootEntropy = CalculateEntropy<size_t, isWeight>(
       labels.subvec(0, labels.n_elem - 1), 0, weightD);
 
-  double gain, bestGain = 0.0;
+  // If the permutations were computed for data of another size, all of them
+  // must be computed again.  The permutations of constant attributes are never
+  // computed; they are left as zeros, which IsSortedBy() rejects.
+  const bool resized = (indices.n_rows != data.n_cols ||
+      indices.n_cols != data.n_rows);
+  if (resized)
+    indices.zeros(data.n_cols, data.n_rows);
+
+  // Calculate the entropy of a split on each attribute in parallel.  Each
+  // attribute is only sorted if its cached permutation does not match it.
+  arma::vec entropies(data.n_rows);
+  std::vector<char> distinct(data.n_rows, 0);
+
+  #pragma omp parallel for schedule(dynamic, 1)
   for (size_t i = 0; i < data.n_rows; i++)
   {
     // Go through each attribute of the data.
-    if (IsDistinct<double>(data.row(i)))
-    {
-      // For each attribute with non-identical values, treat it as a potential
-      // splitting attribute and calculate entropy if split on it.
-      entropy = SetupSplitAttribute<isWeight>(data.row(i), labels, weightD);
+    const arma::rowvec attribute = data.row(i);
+    if (!IsDistinct<double>(attribute))
+      continue;
+
+    // For each attribute with non-identical values, treat it as a potential
+    // splitting attribute and calculate entropy if split on it.
+    arma::uvec index(indices.colptr(i), data.n_cols, false, true);
+    if (resized || !IsSortedBy(attribute, index))
+      index = arma::stable_sort_index(attribute.t());
+
+    entropies[i] = SetupSplitAttribute<isWeight>(attribute, index, labels,
+        weightD);
+    distinct[i] = 1;
+  }
 
-      gain = rootEntropy - entropy;
+  double gain, bestGain = 0.0;
+  for (size_t i = 0; i < data.n_rows; i++)
+  {
+    if (distinct[i])
+    {
+      gain = rootEntropy - entropies[i];
       // Find the attribute with the best entropy so that the gain is
       // maximized.
 
@@ -80,8 +108,16 @@ void DecisionStump<MatType>::Train(const MatType& data, const arma::Row<size_t>&
   }
   splitAttribute = bestAtt;
 
-  // Once the splitting column/attribute has been decided, train on it.
-  TrainOnAtt<double>(data.row(splitAttribute), labels);
+  // Once the splitting column/attribute has been decided, train on it.  If the
+  // attribute is constant, its permutation was not checked.
+  const arma::rowvec attribute = data.row(splitAttribute);
+  if (!distinct[splitAttribute])
+  {
+    indices.col(splitAttribute) = arma::stable_sort_index(attribute.t());
+  }
+  const arma::uvec index(indices.colptr(splitAttribute), data.n_cols, false,
+      true);
+  TrainOnAtt<double>(attribute, index, labels);
 }
 
 /**
@@ -140,7 +176,7 @@ DecisionStump<MatType>::DecisionStump(const DecisionStump<>& other,
   // weightD = weights;
   // tempD = weightD;
 
-  Train<true>(data, labels, weights);
+  Train<true>(data, labels, weights, other.sortedIndices);
 }
 
 /**
@@ -155,19 +191,15 @@ template <typename MatType>
 template <bool isWeight>
 double DecisionStump<MatType>::SetupSplitAttribute(
     const arma::rowvec& attribute,
+    const arma::uvec& sortedIndexAtt,
     const arma::Row<size_t>& labels,
     const arma::rowvec& weightD)
 {
   size_t i, count, begin, end;
   double entropy = 0.0;
 
-  // Sort the attribute in order to calculate splitting ranges.
-  arma::rowvec sortedAtt = arma::sort(attribute);
-
-  // Store the indices of the sorted attribute to build a vector of sorted
-  // labels.  This sort is stable.
-  arma::uvec sortedIndexAtt = arma::stable_sort_index(attribute.t());
-
+  // Use the (stable) sorting permutation of the attribute to build a vector of
+  // sorted labels, in one pass.
   arma::Row<size_t> sortedLabels(attribute.n_elem);
   sortedLabels.fill(0);
 
@@ -244,16 +276,20 @@ double DecisionStump<MatType>::SetupSplitAttribute(
  *
  * @param attribute Attribute is the attribute decided by the constructor on
  *      which we now train the decision stump.
+ * @param sortedSplitIndexAtt The stable sorting permutation of the attribute.
  */
 template <typename MatType>
 template <typename rType>
 void DecisionStump<MatType>::TrainOnAtt(const arma::rowvec& attribute,
+                                        const arma::uvec& sortedSplitIndexAtt,
                                         const arma::Row<size_t>& labels)
 {
   size_t i, count, begin, end;
 
-  arma::rowvec sortedSplitAtt = arma::sort(attribute);
-  arma::uvec sortedSplitIndexAtt = arma::stable_sort_index(attribute.t());
+  arma::rowvec sortedSplitAtt(attribute.n_elem);
+  for (i = 0; i < attribute.n_elem; i++)
+    sortedSplitAtt(i) = attribute(sortedSplitIndexAtt(i));
+
   arma::Row<size_t> sortedLabels(attribute.n_elem);
   sortedLabels.fill(0);
   arma::vec tempSplit;
@@ -400,6 +436,27 @@ int DecisionStump<MatType>::IsDistinct(const arma::Row<rType>& featureRow)
   return 0;
 }
 
+/**
+ * Returns true if index is the stable sorting permutation of attribute.
+ *
+ * @param attribute The attribute to check.
+ * @param index The permutation to check.
+ */
+template <typename MatType>
+bool DecisionStump<MatType>::IsSortedBy(const arma::rowvec& attribute,
+                                        const arma::uvec& index)
+{
+  for (size_t i = 1; i < index.n_elem; ++i)
+  {
+    const double previous = attribute(index(i - 1));
+    const double current = attribute(index(i));
+    if (current < previous ||
+        (current == previous && index(i) <= index(i - 1)))
+      return false;
+  }
+  return true;
+}
+
 /**
  * Calculate entropy of attribute.
  *
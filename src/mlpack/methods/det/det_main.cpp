@@ -7,6 +7,7 @@
 
 #include <mlpack/core.hpp>
 #include "dt_utils.hpp"
+#include "flat_dtree.hpp"
 
 using namespace mlpack;
 using namespace mlpack::det;
@@ -105,8 +106,12 @@ int main(int argc, char *argv[])
       minLeafSize, unprunedTreeEstimateFile);
   Timer::Stop("det_training");
 
+  // Queries are answered with the array-based representation of the tree.
+  const FlatDTree flatTree(*dtreeOpt);
+
   // Compute densities for the training points in the optimal tree.
   FILE *fp = NULL;
+  arma::vec estimates;
 
   if (CLI::GetParam<string>("training_set_estimates_file") != "")
   {
@@ -115,10 +120,12 @@ int main(int argc, char *argv[])
 
     // Compute density estimates for each point in the training set.
     Timer::Start("det_estimation_time");
-    for (size_t i = 0; i < trainingData.n_cols; i++)
-      fprintf(fp, "%lg\n", dtreeOpt->ComputeValue(trainingData.unsafe_col(i)));
+    flatTree.ComputeValue(trainingData, estimates);
     Timer::Stop("det_estimation_time");
 
+    for (size_t i = 0; i < estimates.n_elem; i++)
+      fprintf(fp, "%lg\n", estimates[i]);
+
     fclose(fp);
   }
 
@@ -137,10 +144,12 @@ int main(int argc, char *argv[])
       fp = fopen(CLI::GetParam<string>("test_set_estimates_file").c_str(), "w");
 
       Timer::Start("det_test_set_estimation");
-      for (size_t i = 0; i < testData.n_cols; i++)
-        fprintf(fp, "%lg\n", dtreeOpt->ComputeValue(testData.unsafe_col(i)));
+      flatTree.ComputeValue(testData, estimates);
       Timer::Stop("det_test_set_estimation");
 
+      for (size_t i = 0; i < estimates.n_elem; i++)
+        fprintf(fp, "%lg\n", estimates[i]);
+
       fclose(fp);
     }
   }
@@ -177,10 +177,9 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
   regularizationConstants.fill(0.0);
 
   Timer::Start("cross_validation");
-  // Go through each fold.
-  #pragma omp parallel for default(none) \
-      shared(testSize, cvData, prunedSequence, regularizationConstants, dataset)
-  for (size_t fold = 0; fold < folds; fold++)
+  // Go through each fold; the folds are given to the threads one at a time,
+  // since they may take different times.
+  parallel::For(0, folds, [&](const size_t fold)
   {
     // Break up data into train and test sets.
     size_t start = fold * testSize;
@@ -254,7 +253,7 @@ DTree* mlpack::det::Trainer(arma::mat& dataset,
 
     #pragma omp critical
     regularizationConstants += cvRegularizationConstants;
-  }
+  }, 1);
   Timer::Stop("cross_validation");
 
   double optimalAlpha = -1.0;
@@ -138,93 +138,54 @@ bool DTree::FindSplit(const arma::mat& data,
   assert(data.n_rows == minVals.n_elem);
 
   const size_t points = end - start;
+  const size_t dims = maxVals.n_elem;
+
+  // Search each dimension for its best split.  The dimensions are independent,
+  // so for a large node they are searched in separate tasks.  Each task writes
+  // only its own elements of these arrays.
+  arma::vec dimErrors(dims), dimSplitValues(dims), dimLeftErrors(dims),
+      dimRightErrors(dims);
+  std::vector<char> dimSplitFound(dims);
+  const bool spawn = (points >= ParallelGrowThreshold);
+
+  parallel::TaskGroup group;
+  for (size_t dim = 0; dim < dims; dim++)
+  {
+    group.Run([&, dim]()
+    {
+      dimSplitFound[dim] = FindSplitInDimension(data, dim, minLeafSize,
+          dimErrors[dim], dimSplitValues[dim], dimLeftErrors[dim],
+          dimRightErrors[dim]);
+    }, spawn);
+  }
+  group.Wait();
 
+  // Now choose the best split, in dimension order.
   double minError = logNegError;
   bool splitFound = false;
-
-  // Loop through each dimension.
-  for (size_t dim = 0; dim < maxVals.n_elem; dim++)
+  for (size_t dim = 0; dim < dims; dim++)
   {
-    // Have to deal with REAL, INTEGER, NOMINAL data differently, so we have to
-    // think of how to do that...
-    const double min = minVals[dim];
-    const double max = maxVals[dim];
-
-    // If there is nothing to split in this dimension, move on.
-    if (max - min == 0.0)
-      continue; // Skip to next dimension.
-
-    // Initializing all the stuff for this dimension.
-    bool dimSplitFound = false;
-    // Take an error estimate for this dimension.
-    double minDimError = std::pow(points, 2.0) / (max - min);
-    double dimLeftError = 0.0; // For -Wuninitialized.  These variables will
-    double dimRightError = 0.0; // always be set to something else before use.
-    double dimSplitValue = 0.0;
+    if (!dimSplitFound[dim])
+      continue;
 
     // Find the log volume of all the other dimensions.
-    double volumeWithoutDim = logVolume - std::log(max - min);
-
-    // Get the values for the dimension.
-    arma::rowvec dimVec = data.row(dim).subvec(start, end - 1);
-
-    // Sort the values in ascending order.
-    dimVec = arma::sort(dimVec);
-
-    // Find the best split for this dimension.  We need to figure out why
-    // there are spikes if this minLeafSize is enforced here...
-    for (size_t i = minLeafSize - 1; i < dimVec.n_elem - minLeafSize; ++i)
-    {
-      // This makes sense for real continuous data.  This kinda corrupts the
-      // data and estimation if the data is ordinal.
-      const double split = (dimVec[i] + dimVec[i + 1]) / 2.0;
-
-      if (split == dimVec[i])
-        continue; // We can't split here (two points are the same).
+    const double volumeWithoutDim = logVolume -
+        std::log(maxVals[dim] - minVals[dim]);
 
-      // Another way of picking split is using this:
-      //   split = leftsplit;
-      if ((split - min > 0.0) && (max - split > 0.0))
-      {
-        // Ensure that the right node will have at least the minimum number of
-        // points.
-        Log::Assert((points - i - 1) >= minLeafSize);
-
-        // Now we have to see if the error will be reduced.  Simple manipulation
-        // of the error function gives us the condition we must satisfy:
-        //   |t_l|^2 / V_l + |t_r|^2 / V_r  >= |t|^2 / (V_l + V_r)
-        // and because the volume is only dependent on the dimension we are
-        // splitting, we can assume V_l is just the range of the left and V_r is
-        // just the range of the right.
-        double negLeftError = std::pow(i + 1, 2.0) / (split - min);
-        double negRightError = std::pow(points - i - 1, 2.0) / (max - split);
-
-        // If this is better, take it.
-        if ((negLeftError + negRightError) >= minDimError)
-        {
-          minDimError = negLeftError + negRightError;
-          dimLeftError = negLeftError;
-          dimRightError = negRightError;
-          dimSplitValue = split;
-          dimSplitFound = true;
-        }
-      }
-    }
-
-    double actualMinDimError = std::log(minDimError)
+    double actualMinDimError = std::log(dimErrors[dim])
         - 2 * std::log((double) data.n_cols) - volumeWithoutDim;
 
-    if ((actualMinDimError > minError) && dimSplitFound)
+    if (actualMinDimError > minError)
     {
       // Calculate actual error (in logspace) by adding terms back to our
       // estimate.
       minError = actualMinDimError;
       splitDim = dim;
-      splitValue = dimSplitValue;
-      leftError = std::log(dimLeftError) - 2 * std::log((double) data.n_cols)
-          - volumeWithoutDim;
-      rightError = std::log(dimRightError) - 2 * std::log((double) data.n_cols)
-          - volumeWithoutDim;
+      splitValue = dimSplitValues[dim];
+      leftError = std::log(dimLeftErrors[dim]) - 2 * std::log((double)
+          data.n_cols) - volumeWithoutDim;
+      rightError = std::log(dimRightErrors[dim]) - 2 * std::log((double)
+          data.n_cols) - volumeWithoutDim;
       splitFound = true;
     } // end if better split found in this dimension.
   }
@@ -232,6 +193,83 @@ bool DTree::FindSplit(const arma::mat& data,
   return splitFound;
 }
 
+bool DTree::FindSplitInDimension(const arma::mat& data,
+                                 const size_t dim,
+                                 const size_t minLeafSize,
+                                 double& dimError,
+                                 double& dimSplitValue,
+                                 double& dimLeftError,
+                                 double& dimRightError) const
+{
+  const size_t points = end - start;
+
+  // Have to deal with REAL, INTEGER, NOMINAL data differently, so we have to
+  // think of how to do that...
+  const double min = minVals[dim];
+  const double max = maxVals[dim];
+
+  // If there is nothing to split in this dimension, move on.
+  if (max - min == 0.0)
+    return false;
+
+  // Initializing all the stuff for this dimension.
+  bool dimSplitFound = false;
+  // Take an error estimate for this dimension.
+  dimError = std::pow(points, 2.0) / (max - min);
+  dimLeftError = 0.0;
+  dimRightError = 0.0;
+  dimSplitValue = 0.0;
+
+  // Get the values for the dimension, and sort them in ascending order.  They
+  // are sorted in place, so that the points are only copied once.
+  std::vector<double> dimVec(points);
+  for (size_t i = 0; i < points; ++i)
+    dimVec[i] = data(dim, start + i);
+  std::sort(dimVec.begin(), dimVec.end());
+
+  // Find the best split for this dimension.  We need to figure out why
+  // there are spikes if this minLeafSize is enforced here...
+  for (size_t i = minLeafSize - 1; i < dimVec.size() - minLeafSize; ++i)
+  {
+    // This makes sense for real continuous data.  This kinda corrupts the
+    // data and estimation if the data is ordinal.
+    const double split = (dimVec[i] + dimVec[i + 1]) / 2.0;
+
+    if (split == dimVec[i])
+      continue; // We can't split here (two points are the same).
+
+    // Another way of picking split is using this:
+    //   split = leftsplit;
+    if ((split - min > 0.0) && (max - split > 0.0))
+    {
+      // Ensure that the right node will have at least the minimum number of
+      // points.
+      Log::Assert((points - i - 1) >= minLeafSize);
+
+      // Now we have to see if the error will be reduced.  Simple manipulation
+      // of the error function gives us the condition we must satisfy:
+      //   |t_l|^2 / V_l + |t_r|^2 / V_r  >= |t|^2 / (V_l + V_r)
+      // and because the volume is only dependent on the dimension we are
+      // splitting, we can assume V_l is just the range of the left and V_r is
+      // just the range of the right.
+      double negLeftError = std::pow(i + 1, 2.0) / (split - min);
+      double negRightError = std::pow(points - i - 1, 2.0) / (max - split);
+
+      // If this is better, take it.
+      if ((negLeftError + negRightError) >= dimError)
+      {
+        dimError = negLeftError + negRightError;
+        dimLeftError = negLeftError;
+        dimRightError = negRightError;
+        dimSplitValue = split;
+        dimSplitFound = true;
+      }
+    }
+  }
+
+  return dimSplitFound;
+}
+
 size_t DTree::SplitData(arma::mat& data,
                         const size_t splitDim,
                         const double splitValue,
@@ -275,6 +313,21 @@ double DTree::Grow(arma::mat& data,
   Log::Assert(data.n_rows == maxVals.n_elem);
   Log::Assert(data.n_rows == minVals.n_elem);
 
+  // The root of a large tree starts a team of threads, and the rest of the
+  // tree is grown by tasks run by that team.  If we are already in a parallel
+  // region (for instance, in cross-validation), the tasks are run by the
+  // enclosing team instead.
+  if (root && (size_t) (end - start) >= ParallelGrowThreshold &&
+      !parallel::InParallel() && parallel::Threads() > 1)
+  {
+    double alpha = 0.0;
+    parallel::RunTasks([&]()
+    {
+      alpha = Grow(data, oldFromNew, useVolReg, maxLeafSize, minLeafSize);
+    });
+    return alpha;
+  }
+
   double leftG, rightG;
 
   // Compute points ratio.
@@ -316,10 +369,21 @@ double DTree::Grow(arma::mat& data,
       left = new DTree(maxValsL, minValsL, start, splitIndex, leftError);
       right = new DTree(maxValsR, minValsR, splitIndex, end, rightError);
 
-      leftG = left->Grow(data, oldFromNew, useVolReg, maxLeafSize,
-          minLeafSize);
-      rightG = right->Grow(data, oldFromNew, useVolReg, maxLeafSize,
-          minLeafSize);
+      // The children hold disjoint ranges of the points, so large children
+      // can be grown in separate tasks without changing the result.
+      const bool spawn = ((size_t) (end - start) >= ParallelGrowThreshold);
+      parallel::TaskGroup group;
+      group.Run([&]()
+      {
+        leftG = left->Grow(data, oldFromNew, useVolReg, maxLeafSize,
+            minLeafSize);
+      }, spawn);
+      group.Run([&]()
+      {
+        rightG = right->Grow(data, oldFromNew, useVolReg, maxLeafSize,
+            minLeafSize);
+      }, spawn);
+      group.Wait();
 
       // Store values of R(T~) and |T~|.
       subtreeLeaves = left->SubtreeLeaves() + right->SubtreeLeaves();
@@ -106,7 +106,9 @@ class DTree
 
   /**
    * Greedily expand the tree.  The points in the dataset will be reordered
-   * during tree growth.
+   * during tree growth.  If mlpack is compiled with OpenMP, the children of
+   * large nodes are grown in parallel tasks (they hold disjoint ranges of the
+   * points); the tree is the same for any number of threads.
    *
    * @param data Dataset to build tree on.
    * @param oldFromNew Mappings from old points to new points.
@@ -322,8 +324,15 @@ class DTree
 
   // Utility methods.
 
+  //! Nodes with at least this many points grow their children, and search the
+  //! dimensions for a split, in separate OpenMP tasks.
+  static const size_t ParallelGrowThreshold = 10000;
+
   /**
-   * Find the dimension to split on.
+   * Find the dimension to split on.  If mlpack is compiled with OpenMP, the
+   * dimensions of a large node are searched in separate tasks; the best split
+   * is still chosen in dimension order, so the result does not depend on the
+   * number of threads.
    */
   bool FindSplit(const arma::mat& data,
                  size_t& splitDim,
@@ -332,6 +341,28 @@ class DTree
                  double& rightError,
                  const size_t minLeafSize = 5) const;
 
+  /**
+   * Find the best split of the node in the given dimension.  The errors are
+   * not in log-space, and they are not normalized by the volume of the other
+   * dimensions or the number of points.
+   *
+   * @param data Dataset the tree is built on.
+   * @param dim Dimension to split.
+   * @param minLeafSize Minimum size of a leaf.
+   * @param dimError Negative error of the best split.
+   * @param dimSplitValue Value of the best split.
+   * @param dimLeftError Negative error of the left side of the best split.
+   * @param dimRightError Negative error of the right side of the best split.
+   * @return Whether a split was found in this dimension.
+   */
+  bool FindSplitInDimension(const arma::mat& data,
+                            const size_t dim,
+                            const size_t minLeafSize,
+                            double& dimError,
+                            double& dimSplitValue,
+                            double& dimLeftError,
+                            double& dimRightError) const;
+
   /**
    * Split the data, returning the number of points left of the split.
    */
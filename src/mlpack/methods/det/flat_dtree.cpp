@@ -0,0 +1,141 @@
+/**
+ * @file flat_dtree.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the array-based density estimation tree.
+ */
+#include "flat_dtree.hpp"
+#include <queue>
+
+using namespace mlpack;
+using namespace det;
+
+FlatDTree::FlatDTree()
+{ /* Nothing to do. */ }
+
+FlatDTree::FlatDTree(const DTree& tree) :
+    maxVals(tree.MaxVals()),
+    minVals(tree.MinVals())
+{
+  // Count the nodes, so that every internal node and leaf can be given its
+  // index in breadth-first order as it is visited.
+  size_t numInternal = 0;
+  size_t numLeaves = 0;
+  std::queue<const DTree*> queue;
+  queue.push(&tree);
+  while (!queue.empty())
+  {
+    const DTree* node = queue.front();
+    queue.pop();
+
+    if (node->SubtreeLeaves() == 1)
+    {
+      ++numLeaves;
+    }
+    else
+    {
+      ++numInternal;
+      queue.push(node->Left());
+      queue.push(node->Right());
+    }
+  }
+
+  splitDims.set_size(numInternal);
+  splitValues.set_size(numInternal);
+  children.set_size(2, numInternal);
+  leafValues.set_size(numLeaves);
+
+  // Now visit the nodes again, in the same order.  The index of each child is
+  // known when its parent is visited, because the children are visited in the
+  // order they are pushed.
+  size_t nextInternal = 1; // The root is internal node 0 (if it is internal).
+  size_t nextLeaf = 0;
+  std::queue<const DTree*> nodes;
+  std::queue<size_t> indices;
+  if (tree.SubtreeLeaves() != 1)
+  {
+    nodes.push(&tree);
+    indices.push(0);
+  }
+  else
+  {
+    leafValues[nextLeaf++] = std::exp(std::log(tree.Ratio()) -
+        tree.LogVolume());
+  }
+
+  while (!nodes.empty())
+  {
+    const DTree* node = nodes.front();
+    const size_t index = indices.front();
+    nodes.pop();
+    indices.pop();
+
+    splitDims[index] = node->SplitDim();
+    splitValues[index] = node->SplitValue();
+
+    const DTree* nodeChildren[2] = { node->Left(), node->Right() };
+    for (size_t c = 0; c < 2; ++c)
+    {
+      const DTree* child = nodeChildren[c];
+      if (child->SubtreeLeaves() == 1)
+      {
+        // This is the density that DTree::ComputeValue() gives in the leaf.
+        leafValues[nextLeaf] = std::exp(std::log(child->Ratio()) -
+            child->LogVolume());
+        children(c, index) = numInternal + nextLeaf;
+        ++nextLeaf;
+      }
+      else
+      {
+        children(c, index) = nextInternal;
+        nodes.push(child);
+        indices.push(nextInternal);
+        ++nextInternal;
+      }
+    }
+  }
+}
+
+size_t FlatDTree::FindLeaf(const double* query) const
+{
+  const size_t numInternal = splitDims.n_elem;
+
+  size_t node = 0;
+  while (node < numInternal)
+    node = children((query[splitDims[node]] <= splitValues[node]) ? 0 : 1,
+        node);
+
+  return node - numInternal;
+}
+
+double FlatDTree::ComputeValue(const arma::vec& query) const
+{
+  if (leafValues.n_elem == 0)
+    return 0.0; // The tree is empty.
+
+  Log::Assert(query.n_elem == maxVals.n_elem);
+
+  // Check if the query is within range.
+  for (size_t i = 0; i < query.n_elem; ++i)
+    if ((query[i] < minVals[i]) || (query[i] > maxVals[i]))
+      return 0.0;
+
+  return leafValues[FindLeaf(query.memptr())];
+}
+
+void FlatDTree::ComputeValue(const arma::mat& queries, arma::vec& values) const
+{
+  if (leafValues.n_elem == 0)
+  {
+    values.zeros(queries.n_cols); // The tree is empty.
+    return;
+  }
+
+  Log::Assert(queries.n_rows == maxVals.n_elem);
+
+  values.set_size(queries.n_cols);
+
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < queries.n_cols; ++i)
+    values[i] = ComputeValue(queries.unsafe_col(i));
+}
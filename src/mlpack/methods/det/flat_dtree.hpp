@@ -0,0 +1,119 @@
+/**
+ * @file flat_dtree.hpp
+ * @author Ryan Curtin
+ *
+ * An array-based representation of a trained density estimation tree, for fast
+ * density queries.
+ */
+#ifndef __MLPACK_METHODS_DET_FLAT_DTREE_HPP
+#define __MLPACK_METHODS_DET_FLAT_DTREE_HPP
+
+#include <mlpack/core.hpp>
+#include "dtree.hpp"
+
+namespace mlpack {
+namespace det {
+
+/**
+ * A FlatDTree holds a trained density estimation tree in a few contiguous
+ * arrays, instead of pointer-linked DTree nodes.  The internal nodes are stored
+ * in breadth-first order with their split dimension, split value, and the
+ * indices of their children; the density of each leaf is stored in one more
+ * array.  A query is answered by walking these arrays, so the tree is much more
+ * cache-friendly than the DTree it was made from, and it gives exactly the same
+ * density estimates.
+ *
+ * The tree cannot be modified (it must be rebuilt from the DTree after
+ * pruning), but it can be serialized.
+ *
+ * @code
+ * DTree* tree = Trainer(data, folds, false, maxLeafSize, minLeafSize, "");
+ * FlatDTree flatTree(*tree);
+ *
+ * arma::vec densities;
+ * flatTree.ComputeValue(queries, densities);
+ * @endcode
+ */
+class FlatDTree
+{
+ public:
+  //! Create an empty tree.  The density of every point is 0.
+  FlatDTree();
+
+  /**
+   * Flatten the given trained density estimation tree.
+   *
+   * @param tree Root of the tree to flatten.
+   */
+  FlatDTree(const DTree& tree);
+
+  /**
+   * Compute the density estimate of the given point.
+   *
+   * @param query Point to estimate the density of.
+   * @return Density estimate (0 outside the bounding box of the tree).
+   */
+  double ComputeValue(const arma::vec& query) const;
+
+  /**
+   * Compute the density estimate of each of the given points.  If mlpack is
+   * compiled with OpenMP, the points are evaluated in parallel.
+   *
+   * @param queries Points to estimate the density of (one per column).
+   * @param values Vector to store the density estimates in.
+   */
+  void ComputeValue(const arma::mat& queries, arma::vec& values) const;
+
+  //! Get the number of internal nodes.
+  size_t NumInternalNodes() const { return splitDims.n_elem; }
+  //! Get the number of leaves.
+  size_t NumLeaves() const { return leafValues.n_elem; }
+
+  //! Get the split dimension of each internal node.
+  const arma::Col<size_t>& SplitDims() const { return splitDims; }
+  //! Get the split value of each internal node.
+  const arma::vec& SplitValues() const { return splitValues; }
+  //! Get the density of each leaf.
+  const arma::vec& LeafValues() const { return leafValues; }
+
+  //! Serialize the tree.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    using data::CreateNVP;
+
+    ar & CreateNVP(maxVals, "maxVals");
+    ar & CreateNVP(minVals, "minVals");
+    ar & CreateNVP(splitDims, "splitDims");
+    ar & CreateNVP(splitValues, "splitValues");
+    ar & CreateNVP(children, "children");
+    ar & CreateNVP(leafValues, "leafValues");
+  }
+
+ private:
+  //! The upper bound of the tree in each dimension.
+  arma::vec maxVals;
+  //! The lower bound of the tree in each dimension.
+  arma::vec minVals;
+
+  //! The split dimension of each internal node.
+  arma::Col<size_t> splitDims;
+  //! The split value of each internal node.
+  arma::vec splitValues;
+  //! The children of each internal node; column i holds the left and right
+  //! child of node i.  A child index less than the number of internal nodes
+  //! refers to an internal node; otherwise, the child is the leaf with index
+  //! (child - NumInternalNodes()).
+  arma::Mat<size_t> children;
+  //! The density of each leaf.
+  arma::vec leafValues;
+
+  //! Find the index of the leaf that holds the given point (which must be in
+  //! the bounding box of the tree).
+  size_t FindLeaf(const double* query) const;
+};
+
+} // namespace det
+} // namespace mlpack
+
+#endif // __MLPACK_METHODS_DET_FLAT_DTREE_HPP
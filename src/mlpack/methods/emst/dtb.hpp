@@ -27,6 +27,7 @@
 #include <mlpack/core/metrics/lmetric.hpp>
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
 
 namespace mlpack {
 namespace emst /** Euclidean Minimum Spanning Trees. */ {
@@ -63,6 +64,13 @@ namespace emst /** Euclidean Minimum Spanning Trees. */ {
  * More advanced usage of the class can use different types of trees, pass in an
  * already-built tree, or compute the MST using the O(n^2) naive algorithm.
  *
+ * If Neighbors() is set, the k nearest neighbors of every point are found
+ * first, and every edge of the k-nearest-neighbor graph that can be proven to
+ * be in the MST is added with Kruskal's algorithm; the dual-tree Boruvka
+ * iterations then only connect the components that remain.  The result is
+ * still exact.  On low-dimensional data, most of the MST is in the graph for a
+ * small k (around 10), so this is usually much faster.
+ *
  * @tparam MetricType The metric to use.
  * @tparam MatType The type of data matrix to use.
  * @tparam TreeType Type of tree to use.  This should follow the TreeType policy
@@ -93,6 +101,11 @@ class DualTreeBoruvka
 
   //! Indicates whether or not O(n^2) naive mode will be used.
   bool naive;
+  //! Indicates whether or not each iteration is split across multiple threads.
+  bool parallel;
+  //! The number of nearest neighbors of each point whose edges are tried first
+  //! (0 if the k-nearest-neighbor graph is not used).
+  size_t neighbors;
 
   //! Edges.
   std::vector<EdgePair> edges; // We must use vector with non-numerical types.
@@ -171,12 +184,46 @@ class DualTreeBoruvka
    */
   void ComputeMST(arma::mat& results);
 
+  //! Get whether or not each iteration is split across multiple threads.
+  bool Parallel() const { return parallel; }
+  //! Modify whether or not each iteration is split across multiple threads
+  //! (only available if mlpack was compiled with OpenMP).
+  bool& Parallel() { return parallel; }
+
+  //! Get the number of nearest neighbors of each point whose edges are tried
+  //! before the dual-tree Boruvka iterations (0 if none are).
+  size_t Neighbors() const { return neighbors; }
+  //! Modify the number of nearest neighbors of each point whose edges are
+  //! tried before the dual-tree Boruvka iterations (0 if none are).
+  size_t& Neighbors() { return neighbors; }
+
   /**
    * Returns a string representation of this object.
    */
   std::string ToString() const;
 
  private:
+  /**
+   * Find the candidate edge of each component for one iteration, splitting
+   * the work across threads.  Each thread keeps its own candidate edges, which
+   * are then merged into neighborsDistances, neighborsInComponent, and
+   * neighborsOutComponent.
+   *
+   * @param numThreads Number of threads to use.
+   * @param baseCases Incremented by the number of base cases performed.
+   * @param scores Incremented by the number of node combinations scored.
+   */
+  void ParallelIteration(const size_t numThreads,
+                         size_t& baseCases,
+                         size_t& scores);
+
+  /**
+   * Find the k nearest neighbors of each point (with k = Neighbors()), and add
+   * every edge of the k-nearest-neighbor graph that is proven to be in the MST,
+   * with Kruskal's algorithm over the edges of the graph.
+   */
+  void AddNeighborEdges();
+
   /**
    * Adds a single edge to the edge list
    */
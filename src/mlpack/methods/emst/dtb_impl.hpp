@@ -9,6 +9,12 @@
 
 #include "dtb_rules.hpp"
 
+#include <mlpack/core/tree/subtree_frontier.hpp>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace emst {
 
@@ -55,6 +61,8 @@ DualTreeBoruvka<MetricType, MatType, TreeType>::DualTreeBoruvka(
     data(naive ? dataset : tree->Dataset()),
     ownTree(!naive),
     naive(naive),
+    parallel(false),
+    neighbors(0),
     connections(dataset.n_cols),
     totalDist(0.0),
     metric(metric)
@@ -80,6 +88,8 @@ DualTreeBoruvka<MetricType, MatType, TreeType>::DualTreeBoruvka(
     data(tree->Dataset()),
     ownTree(false),
     naive(false),
+    parallel(false),
+    neighbors(0),
     connections(data.n_cols),
     totalDist(0.0),
     metric(metric)
@@ -121,12 +131,34 @@ void DualTreeBoruvka<MetricType, MatType, TreeType>::ComputeMST(
 
   totalDist = 0; // Reset distance.
 
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+  const bool useThreads = (parallel && numThreads > 1);
+
   typedef DTBRules<MetricType, Tree> RuleType;
   RuleType rules(data, connections, neighborsDistances, neighborsInComponent,
                  neighborsOutComponent, metric);
+  size_t baseCases = 0;
+  size_t scores = 0;
+
+  // Add the edges of the k-nearest-neighbor graph that are in the MST, and set
+  // up the components for the dual-tree Boruvka iterations.
+  if (neighbors > 0 && data.n_cols > 1)
+  {
+    AddNeighborEdges();
+    Cleanup();
+  }
+
   while (edges.size() < (data.n_cols - 1))
   {
-    if (naive)
+    if (useThreads)
+    {
+      ParallelIteration(numThreads, baseCases, scores);
+    }
+    else if (naive)
     {
       // Full O(N^2) traversal.
       for (size_t i = 0; i < data.n_cols; ++i)
@@ -146,9 +178,10 @@ void DualTreeBoruvka<MetricType, MatType, TreeType>::ComputeMST(
     Log::Info << edges.size() << " edges found so far." << std::endl;
     if (!naive)
     {
-      Log::Info << rules.BaseCases() << " cumulative base cases." << std::endl;
-      Log::Info << rules.Scores() << " cumulative node combinations scored."
+      Log::Info << (baseCases + rules.BaseCases()) << " cumulative base cases."
           << std::endl;
+      Log::Info << (scores + rules.Scores()) << " cumulative node combinations "
+          << "scored." << std::endl;
     }
   }
 
@@ -159,6 +192,173 @@ void DualTreeBoruvka<MetricType, MatType, TreeType>::ComputeMST(
   Log::Info << "Total spanning tree length: " << totalDist << std::endl;
 }
 
+/**
+ * Find the candidate edges of one iteration with several threads.
+ */
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+void DualTreeBoruvka<MetricType, MatType, TreeType>::ParallelIteration(
+    const size_t numThreads,
+    size_t& baseCases,
+    size_t& scores)
+{
+  typedef DTBRules<MetricType, Tree> RuleType;
+
+  // Split the tree into several disjoint query subtrees; we generate a few
+  // more subtrees than threads so that the work can be balanced dynamically.
+  // The components do not change during an iteration, so every subtree can be
+  // searched against the whole tree independently.
+  std::vector<Tree*> frontier;
+  if (!naive)
+    tree::SubtreeFrontier(*tree, 4 * numThreads, frontier);
+
+  // The candidate edges found by each thread.
+  std::vector<arma::vec> threadDistances(numThreads);
+  std::vector<arma::Col<size_t> > threadInComponent(numThreads);
+  std::vector<arma::Col<size_t> > threadOutComponent(numThreads);
+
+  size_t iterationBaseCases = 0;
+  size_t iterationScores = 0;
+
+  #pragma omp parallel num_threads(numThreads) \
+      reduction(+:iterationBaseCases, iterationScores)
+  {
+#ifdef _OPENMP
+    const size_t thread = (size_t) omp_get_thread_num();
+#else
+    const size_t thread = 0;
+#endif
+
+    // Each thread only updates its own candidate edges, so its bounds are
+    // looser than when the candidates are shared, but they are still valid.
+    // The query statistics it updates belong to its own subtrees.
+    threadDistances[thread].set_size(data.n_cols);
+    threadDistances[thread].fill(DBL_MAX);
+    threadInComponent[thread].set_size(data.n_cols);
+    threadOutComponent[thread].set_size(data.n_cols);
+
+    MetricType threadMetric(metric);
+    RuleType rules(data, connections, threadDistances[thread],
+        threadInComponent[thread], threadOutComponent[thread], threadMetric);
+
+    if (naive)
+    {
+      #pragma omp for schedule(dynamic, 64)
+      for (size_t i = 0; i < data.n_cols; ++i)
+        for (size_t j = 0; j < data.n_cols; ++j)
+          rules.BaseCase(i, j);
+    }
+    else
+    {
+      typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+
+      #pragma omp for schedule(dynamic)
+      for (size_t i = 0; i < frontier.size(); ++i)
+        traverser.Traverse(*frontier[i], *tree);
+    }
+
+    iterationBaseCases += rules.BaseCases();
+    iterationScores += rules.Scores();
+  }
+
+  // Keep the best candidate edge of each component.  Ties go to the thread
+  // with the lowest index.
+  #pragma omp parallel for num_threads(numThreads) schedule(static)
+  for (size_t c = 0; c < data.n_cols; ++c)
+  {
+    for (size_t t = 0; t < numThreads; ++t)
+    {
+      if (threadDistances[t][c] < neighborsDistances[c])
+      {
+        neighborsDistances[c] = threadDistances[t][c];
+        neighborsInComponent[c] = threadInComponent[t][c];
+        neighborsOutComponent[c] = threadOutComponent[t][c];
+      }
+    }
+  }
+
+  baseCases += iterationBaseCases;
+  scores += iterationScores;
+}
+
+/**
+ * Add the edges of the k-nearest-neighbor graph that are proven to be in the
+ * MST.
+ */
+template<
+    typename MetricType,
+    typename MatType,
+    template<typename TreeMetricType,
+             typename TreeStatType,
+             typename TreeMatType> class TreeType>
+void DualTreeBoruvka<MetricType, MatType, TreeType>::AddNeighborEdges()
+{
+  Timer::Start("emst/knn_graph");
+
+  // Find the nearest neighbors with the same metric and type of tree (or the
+  // naive search, in naive mode).  The indices are those of data.
+  const size_t k = std::min(neighbors, (size_t) data.n_cols - 1);
+  arma::Mat<size_t> neighborIndices;
+  arma::mat neighborDistances;
+  {
+    neighbor::NeighborSearch<neighbor::NearestNeighborSort, MetricType, MatType,
+        TreeType> knn(data, naive, false, metric);
+    knn.Parallel() = parallel;
+    knn.Search(k, neighborIndices, neighborDistances);
+  }
+
+  std::vector<EdgePair> candidates;
+  candidates.reserve(k * data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    for (size_t j = 0; j < k; ++j)
+    {
+      const size_t other = neighborIndices(j, i);
+      candidates.push_back(EdgePair(std::min(i, other), std::max(i, other),
+          neighborDistances(j, i)));
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(), SortFun);
+
+  // An edge that is not in the graph is at least as long as the distance from
+  // either of its ends to its k'th nearest neighbor.  So if every point of a
+  // component is at least as far as d from its k'th nearest neighbor, no edge
+  // shorter than d that leaves the component is missing from the graph, and
+  // the shortest edge of the graph that leaves it (if it is no longer than d)
+  // is in the MST, by the cut property.  Kruskal's algorithm takes each edge
+  // that is proven this way and skips the others, which the dual-tree Boruvka
+  // iterations can still find.  The bound of each component is kept at its
+  // root.
+  arma::vec bounds = arma::trans(neighborDistances.row(k - 1));
+  for (size_t i = 0; i < candidates.size() && edges.size() < data.n_cols - 1;
+       ++i)
+  {
+    const EdgePair& edge = candidates[i];
+    const size_t lesserRoot = connections.Find(edge.Lesser());
+    const size_t greaterRoot = connections.Find(edge.Greater());
+    if (lesserRoot == greaterRoot)
+      continue;
+
+    const double bound = std::min(bounds[lesserRoot], bounds[greaterRoot]);
+    if (std::max(bounds[lesserRoot], bounds[greaterRoot]) < edge.Distance())
+      continue;
+
+    connections.Union(lesserRoot, greaterRoot);
+    bounds[connections.Find(lesserRoot)] = bound;
+    totalDist += edge.Distance();
+    AddEdge(edge.Lesser(), edge.Greater(), edge.Distance());
+  }
+
+  Timer::Stop("emst/knn_graph");
+
+  Log::Info << edges.size() << " edges found in the " << k << "-nearest-"
+      << "neighbor graph." << std::endl;
+}
+
 /**
  * Adds a single edge to the edge list
  */
@@ -337,6 +537,8 @@ std::string DualTreeBoruvka<MetricType, MatType, TreeType>::ToString() const
   convert << "  Data: " << data.n_rows << "x" << data.n_cols <<std::endl;
   convert << "  Total Distance: " << totalDist <<std::endl;
   convert << "  Naive: " << naive << std::endl;
+  convert << "  Parallel: " << parallel << std::endl;
+  convert << "  Neighbors: " << neighbors << std::endl;
   convert << "  Metric: " << std::endl;
   convert << util::Indent(metric.ToString(), 2);
   convert << std::endl;
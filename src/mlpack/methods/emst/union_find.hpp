@@ -11,6 +11,7 @@
 #define __MLPACK_METHODS_EMST_UNION_FIND_HPP
 
 #include <mlpack/core.hpp>
+#include <atomic>
 
 namespace mlpack {
 namespace emst {
@@ -21,22 +22,62 @@ namespace emst {
  * initially in its own component.  Calling Union(x, y) unites the components
  * indexed by x and y.  Find(x) returns the index of the component containing
  * point x.
+ *
+ * Find() and Union() may be called by several threads at once; neither takes a
+ * lock.  The parent of each element and, for roots, the rank are packed into
+ * one word, so that a root can be linked under another root with a single
+ * compare-and-swap that fails if the root has changed in the meantime.  A root
+ * is only linked under a root of higher (rank, index), which keeps the forest
+ * acyclic no matter how the operations interleave.  Find() uses path halving,
+ * also with compare-and-swap.  See the following paper for more details.
+ *
+ * @code
+ * @inproceedings{anderson1991wait,
+ *   title={Wait-free parallel algorithms for the union-find problem},
+ *   author={Anderson, R.J. and Woll, H.},
+ *   booktitle={Proceedings of the Twenty-Third Annual ACM Symposium on Theory
+ *       of Computing (STOC 1991)},
+ *   pages={370--380},
+ *   year={1991}
+ * }
+ * @endcode
  */
 class UnionFind
 {
  private:
-  arma::Col<size_t> parent;
-  arma::ivec rank;
+  //! The number of bits of each word that hold the parent index; the rest hold
+  //! the rank.  The rank is at most log2(size), so six bits are enough.
+  static const size_t parentBits = 8 * sizeof(size_t) - 6;
+  //! The mask that extracts the parent index from a word.
+  static const size_t parentMask = (size_t(1) << parentBits) - 1;
+
+  //! The parent and rank of each element.
+  std::vector<std::atomic<size_t> > nodes;
+
+  //! Get the parent index of a word.
+  static size_t Parent(const size_t word) { return word & parentMask; }
+  //! Get the rank of a word.
+  static size_t Rank(const size_t word) { return word >> parentBits; }
+  //! Pack a parent index and a rank into a word.
+  static size_t Word(const size_t parent, const size_t rank)
+  {
+    return (rank << parentBits) | parent;
+  }
 
  public:
   //! Construct the object with the given size.
-  UnionFind(const size_t size) : parent(size), rank(size)
+  UnionFind(const size_t size) : nodes(size)
   {
-    for (size_t i = 0; i < size; ++i)
+    if (size > parentMask)
     {
-      parent[i] = i;
-      rank[i] = 0;
+      std::ostringstream oss;
+      oss << "UnionFind::UnionFind(): size " << size << " is larger than the "
+          << "maximum size (" << parentMask << ")";
+      throw std::invalid_argument(oss.str());
     }
+
+    for (size_t i = 0; i < size; ++i)
+      nodes[i].store(Word(i, 0), std::memory_order_relaxed);
   }
 
   //! Destroy the object (nothing to do).
@@ -48,17 +89,26 @@ class UnionFind
    * @param x the component to be found
    * @return The index of the component containing x
    */
-  size_t Find(const size_t x)
+  size_t Find(size_t x)
   {
-    if (parent[x] == x)
-    {
-      return x;
-    }
-    else
+    while (true)
     {
-      // This ensures that the tree has a small depth
-      parent[x] = Find(parent[x]);
-      return parent[x];
+      size_t word = nodes[x].load(std::memory_order_acquire);
+      const size_t parent = Parent(word);
+      if (parent == x)
+        return x;
+
+      const size_t grandparent =
+          Parent(nodes[parent].load(std::memory_order_acquire));
+      if (grandparent == parent)
+        return parent;
+
+      // This ensures that the tree has a small depth.  If another thread
+      // changed the parent of x first, it also moved x closer to the root, so
+      // the failure can be ignored.
+      nodes[x].compare_exchange_weak(word, Word(grandparent, Rank(word)),
+          std::memory_order_acq_rel, std::memory_order_acquire);
+      x = grandparent;
     }
   }
 
@@ -70,26 +120,41 @@ class UnionFind
    */
   void Union(const size_t x, const size_t y)
   {
-    const size_t xRoot = Find(x);
-    const size_t yRoot = Find(y);
-
-    if (xRoot == yRoot)
+    while (true)
     {
+      size_t xRoot = Find(x);
+      size_t yRoot = Find(y);
+
+      if (xRoot == yRoot)
+        return;
+
+      size_t xWord = nodes[xRoot].load(std::memory_order_acquire);
+      size_t yWord = nodes[yRoot].load(std::memory_order_acquire);
+
+      // If either root has been linked under another root, start again.
+      if (Parent(xWord) != xRoot || Parent(yWord) != yRoot)
+        continue;
+
+      // The root with the lower (rank, index) is linked under the other.
+      if (Rank(xWord) > Rank(yWord) ||
+          (Rank(xWord) == Rank(yWord) && xRoot > yRoot))
+      {
+        std::swap(xRoot, yRoot);
+        std::swap(xWord, yWord);
+      }
+
+      if (!nodes[xRoot].compare_exchange_strong(xWord,
+          Word(yRoot, Rank(xWord)), std::memory_order_acq_rel))
+        continue;
+
+      // If the ranks were equal, the rank of the new root grows.  If yRoot has
+      // changed in the meantime, its rank does not need to grow any more.
+      if (Rank(xWord) == Rank(yWord))
+        nodes[yRoot].compare_exchange_strong(yWord,
+            Word(yRoot, Rank(yWord) + 1), std::memory_order_acq_rel);
+
       return;
     }
-    else if (rank[xRoot] == rank[yRoot])
-    {
-      parent[yRoot] = parent[xRoot];
-      rank[xRoot] = rank[xRoot] + 1;
-    }
-    else if (rank[xRoot] > rank[yRoot])
-    {
-      parent[yRoot] = xRoot;
-    }
-    else
-    {
-      parent[xRoot] = yRoot;
-    }
   }
 }; // class UnionFind
 
@@ -12,6 +12,7 @@
 #include <mlpack/core/metrics/ip_metric.hpp>
 #include "fastmks_stat.hpp"
 #include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/tree/query_order.hpp>
 
 namespace mlpack {
 namespace fastmks /** Fast max-kernel search. */ {
@@ -42,6 +43,10 @@ namespace fastmks /** Fast max-kernel search. */ {
  * on points in the dataset (and not centroids of regions or anything like
  * that).
  *
+ * If the tree type rearranges the dataset when it is built (for instance,
+ * tree::ReorderedCoverTree), the results are mapped back to the indices of the
+ * original points.
+ *
  * @tparam KernelType Type of kernel to run FastMKS with.
  * @tparam MatType Type of data matrix (usually arma::mat).
  * @tparam TreeType Type of tree to run FastMKS with; it must satisfy the
@@ -146,7 +151,8 @@ class FastMKS
    *
    * Be aware that if your tree modifies the original input matrix, the results
    * here are with respect to the modified input matrix (that is,
-   * queryTree->Dataset()).
+   * queryTree->Dataset()).  The reference indices are those of the original
+   * reference set if this object built the reference tree.
    *
    * @param queryTree Tree built on query points.
    * @param k The number of maximum kernels to find.
@@ -186,14 +192,34 @@ class FastMKS
   //! Modify whether or not single-tree search is used.
   bool& SingleMode() { return singleMode; }
 
+  //! Get whether or not search is split across multiple threads.
+  bool Parallel() const { return parallel; }
+  //! Modify whether or not search is split across multiple threads (only
+  //! available if mlpack was compiled with OpenMP).
+  bool& Parallel() { return parallel; }
+
+  //! Get whether or not single-tree search processes the query points in a
+  //! spatial order.
+  bool ReorderQueries() const { return reorderQueries; }
+  //! Modify whether or not single-tree search processes the query points in a
+  //! spatial order (see tree::QueryOrder()), so that consecutive query points
+  //! visit mostly the same reference nodes.  The results are the same.
+  bool& ReorderQueries() { return reorderQueries; }
+
+  //! Get the self-kernel sqrt(K(r, r)) of each reference point.
+  const arma::vec& ReferenceKernels() const { return referenceKernels; }
+
   /**
    * Returns a string representation of this object.
    */
   std::string ToString() const;
 
  private:
-  //! The reference dataset.
-  const MatType& referenceSet;
+  //! The reference dataset (the dataset of the tree, if there is one).
+  const MatType* referenceSet;
+  //! The original index of each point of the reference tree, if the tree was
+  //! built by this object and it rearranges the dataset.
+  std::vector<size_t> oldFromNewReferences;
   //! The tree built on the reference dataset.
   Tree* referenceTree;
   //! If true, this object created the tree and is responsible for it.
@@ -203,17 +229,40 @@ class FastMKS
   bool singleMode;
   //! If true, naive (brute-force) search is used.
   bool naive;
+  //! If true, search is split across multiple threads.
+  bool parallel;
+  //! If true, single-tree search processes the query points in a spatial
+  //! order.
+  bool reorderQueries;
 
   //! The instantiated inner-product metric induced by the given kernel.
   metric::IPMetric<KernelType> metric;
 
-  //! Utility function.  Copied too many times from too many places.
-  void InsertNeighbor(arma::Mat<size_t>& indices,
-                      arma::mat& products,
-                      const size_t queryIndex,
-                      const size_t pos,
-                      const size_t neighbor,
-                      const double distance);
+  //! The self-kernel sqrt(K(r, r)) of each reference point, computed once when
+  //! the object is constructed.
+  arma::vec referenceKernels;
+
+  //! Compute the self-kernel sqrt(K(x, x)) of each point in the given set.
+  void SelfKernels(const MatType& set, arma::vec& kernels);
+
+  //! Perform single-tree search for each point in the query set.
+  void SingleTreeSearch(const MatType& querySet,
+                        const arma::vec& queryKernels,
+                        arma::Mat<size_t>& indices,
+                        arma::mat& kernels);
+
+  //! Perform dual-tree search with the given query tree.
+  void DualTreeSearch(Tree& queryTree,
+                      const arma::vec& queryKernels,
+                      arma::Mat<size_t>& indices,
+                      arma::mat& kernels);
+
+  //! If this object built a reference tree that rearranges the dataset, map
+  //! the reference indices of the given results back to the original points
+  //! (and, if the query set is the reference set, the columns too).
+  void UnmapResults(arma::Mat<size_t>& indices,
+                    arma::mat& kernels,
+                    const bool monochromatic) const;
 };
 
 } // namespace fastmks
@@ -13,11 +13,68 @@
 #include "fastmks_rules.hpp"
 
 #include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/tree/subtree_frontier.hpp>
+#include <mlpack/methods/neighbor_search/unmap.hpp>
 #include <queue>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace fastmks {
 
+//! Call the tree constructor that does mapping.
+template<typename TreeType, typename MatType>
+TreeType* BuildTree(
+    const MatType& dataset,
+    std::vector<size_t>& oldFromNew,
+    typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == true, TreeType*
+    >::type = 0)
+{
+  return new TreeType(dataset, oldFromNew);
+}
+
+//! Call the tree constructor that does not do mapping.
+template<typename TreeType, typename MatType>
+TreeType* BuildTree(
+    const MatType& dataset,
+    const std::vector<size_t>& /* oldFromNew */,
+    const typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == false, TreeType*
+    >::type = 0)
+{
+  return new TreeType(dataset);
+}
+
+//! Call the tree constructor that does mapping, with an instantiated metric.
+template<typename TreeType, typename MatType, typename MetricType>
+TreeType* BuildTree(
+    const MatType& dataset,
+    MetricType& metric,
+    std::vector<size_t>& oldFromNew,
+    typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == true, TreeType*
+    >::type = 0)
+{
+  return new TreeType(dataset, metric, oldFromNew);
+}
+
+//! Call the tree constructor that does not do mapping, with an instantiated
+//! metric.
+template<typename TreeType, typename MatType, typename MetricType>
+TreeType* BuildTree(
+    const MatType& dataset,
+    MetricType& metric,
+    const std::vector<size_t>& /* oldFromNew */,
+    const typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == false, TreeType*
+    >::type = 0)
+{
+  return new TreeType(dataset, metric);
+}
+
 // No instantiated kernel.
 template<typename KernelType,
          typename MatType,
@@ -25,21 +82,29 @@ template<typename KernelType,
                   typename TreeStatType,
                   typename TreeMatType> class TreeType>
 FastMKS<KernelType, MatType, TreeType>::FastMKS(
-    const MatType& referenceSet,
+    const MatType& referenceSetIn,
     const bool singleMode,
     const bool naive) :
-    referenceSet(referenceSet),
+    referenceSet(&referenceSetIn),
     referenceTree(NULL),
     treeOwner(true),
     singleMode(singleMode),
-    naive(naive)
+    naive(naive),
+    parallel(false),
+    reorderQueries(false)
 {
   Timer::Start("tree_building");
 
+  // If the tree rearranges the dataset, it holds the rearranged copy.
   if (!naive)
-    referenceTree = new Tree(referenceSet);
+  {
+    referenceTree = BuildTree<Tree>(referenceSetIn, oldFromNewReferences);
+    referenceSet = &referenceTree->Dataset();
+  }
 
   Timer::Stop("tree_building");
+
+  SelfKernels(*referenceSet, referenceKernels);
 }
 
 // Instantiated kernel.
@@ -48,24 +113,33 @@ template<typename KernelType,
          template<typename TreeMetricType,
                   typename TreeStatType,
                   typename TreeMatType> class TreeType>
-FastMKS<KernelType, MatType, TreeType>::FastMKS(const MatType& referenceSet,
-                                                KernelType& kernel,
-                                                const bool singleMode,
-                                                const bool naive) :
-    referenceSet(referenceSet),
+FastMKS<KernelType, MatType, TreeType>::FastMKS(
+    const MatType& referenceSetIn,
+    KernelType& kernel,
+    const bool singleMode,
+    const bool naive) :
+    referenceSet(&referenceSetIn),
     referenceTree(NULL),
     treeOwner(true),
     singleMode(singleMode),
     naive(naive),
+    parallel(false),
+    reorderQueries(false),
     metric(kernel)
 {
   Timer::Start("tree_building");
 
   // If necessary, the reference tree should be built.  There is no query tree.
   if (!naive)
-    referenceTree = new Tree(referenceSet, metric);
+  {
+    referenceTree = BuildTree<Tree>(referenceSetIn, metric,
+        oldFromNewReferences);
+    referenceSet = &referenceTree->Dataset();
+  }
 
   Timer::Stop("tree_building");
+
+  SelfKernels(*referenceSet, referenceKernels);
 }
 
 // One dataset, pre-built tree.
@@ -76,14 +150,16 @@ template<typename KernelType,
                   typename TreeMatType> class TreeType>
 FastMKS<KernelType, MatType, TreeType>::FastMKS(Tree* referenceTree,
                                                 const bool singleMode) :
-    referenceSet(referenceTree->Dataset()),
+    referenceSet(&referenceTree->Dataset()),
     referenceTree(referenceTree),
     treeOwner(false),
     singleMode(singleMode),
     naive(false),
+    parallel(false),
+    reorderQueries(false),
     metric(referenceTree->Metric())
 {
-  // Nothing to do.
+  SelfKernels(*referenceSet, referenceKernels);
 }
 
 template<typename KernelType,
@@ -111,8 +187,8 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
 {
   Timer::Start("computing_products");
 
-  // No remapping will be necessary because we are using the cover tree.
   indices.set_size(k, querySet.n_cols);
+  indices.fill(size_t() - 1);
   kernels.set_size(k, querySet.n_cols);
 
   // Naive implementation.
@@ -121,25 +197,27 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
     // Fill kernels.
     kernels.fill(-DBL_MAX);
 
-    // Simple double loop.  Stupid, slow, but a good benchmark.
-    for (size_t q = 0; q < querySet.n_cols; ++q)
+    // Simple double loop.  Stupid, slow, but a good benchmark.  Each thread
+    // only writes the columns of its own query points.
+    KernelCandidateList candidates(indices, kernels);
+    #pragma omp parallel if (parallel)
     {
-      for (size_t r = 0; r < referenceSet.n_cols; ++r)
-      {
-        const double eval = metric.Kernel().Evaluate(querySet.col(q),
-                                                     referenceSet.col(r));
+      KernelType threadKernel(metric.Kernel());
 
-        size_t insertPosition;
-        for (insertPosition = 0; insertPosition < indices.n_rows;
-            ++insertPosition)
-          if (eval > kernels(insertPosition, q))
-            break;
+      #pragma omp for schedule(static)
+      for (size_t q = 0; q < querySet.n_cols; ++q)
+      {
+        for (size_t r = 0; r < referenceSet->n_cols; ++r)
+        {
+          const double eval = threadKernel.Evaluate(querySet.col(q),
+                                                    referenceSet->col(r));
 
-        if (insertPosition < indices.n_rows)
-          InsertNeighbor(indices, kernels, q, insertPosition, r, eval);
+          candidates.Insert(q, r, eval);
+        }
       }
     }
 
+    KernelCandidateList::Sort(indices, kernels);
     Timer::Stop("computing_products");
 
     return;
@@ -151,31 +229,43 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
     // Fill kernels.
     kernels.fill(-DBL_MAX);
 
-    // Create rules object (this will store the results).  This constructor
-    // precalculates each self-kernel value.
-    typedef FastMKSRules<KernelType, Tree> RuleType;
-    RuleType rules(referenceSet, querySet, indices, kernels, metric.Kernel());
+    arma::vec queryKernels;
+    SelfKernels(querySet, queryKernels);
 
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
-
-    Log::Info << rules.BaseCases() << " base cases." << std::endl;
-    Log::Info << rules.Scores() << " scores." << std::endl;
+    SingleTreeSearch(querySet, queryKernels, indices, kernels);
+    KernelCandidateList::Sort(indices, kernels);
+    UnmapResults(indices, kernels, false);
 
     Timer::Stop("computing_products");
     return;
   }
 
-  // Dual-tree implementation.  First, we need to build the query tree.  We are
-  // assuming it doesn't map anything...
+  // Dual-tree implementation.  First, we need to build the query tree.
   Timer::Stop("computing_products");
   Timer::Start("tree_building");
-  Tree queryTree(querySet);
+  std::vector<size_t> oldFromNewQueries;
+  Tree* queryTree = BuildTree<Tree>(querySet, oldFromNewQueries);
   Timer::Stop("tree_building");
 
-  Search(&queryTree, k, indices, kernels);
+  if (!tree::TreeTraits<Tree>::RearrangesDataset)
+  {
+    Search(queryTree, k, indices, kernels);
+    delete queryTree;
+    return;
+  }
+
+  // The reference indices are unmapped by Search(), but the columns are in the
+  // order of the dataset of the query tree.
+  arma::Mat<size_t> treeIndices;
+  arma::mat treeKernels;
+  Search(queryTree, k, treeIndices, treeKernels);
+  delete queryTree;
+
+  for (size_t i = 0; i < treeIndices.n_cols; ++i)
+  {
+    indices.col(oldFromNewQueries[i]) = treeIndices.col(i);
+    kernels.col(oldFromNewQueries[i]) = treeKernels.col(i);
+  }
 }
 
 template<typename KernelType,
@@ -196,22 +286,19 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
         "single mode or naive search is enabled");
   }
 
-  // No remapping will be necessary because we are using the cover tree.
   indices.set_size(k, queryTree->Dataset().n_cols);
+  indices.fill(size_t() - 1);
   kernels.set_size(k, queryTree->Dataset().n_cols);
   kernels.fill(-DBL_MAX);
 
   Timer::Start("computing_products");
-  typedef FastMKSRules<KernelType, Tree> RuleType;
-  RuleType rules(referenceSet, queryTree->Dataset(), indices, kernels,
-      metric.Kernel());
 
-  typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+  arma::vec queryKernels;
+  SelfKernels(queryTree->Dataset(), queryKernels);
 
-  traverser.Traverse(*queryTree, *referenceTree);
-
-  Log::Info << rules.BaseCases() << " base cases." << std::endl;
-  Log::Info << rules.Scores() << " scores." << std::endl;
+  DualTreeSearch(*queryTree, queryKernels, indices, kernels);
+  KernelCandidateList::Sort(indices, kernels);
+  UnmapResults(indices, kernels, false);
 
   Timer::Stop("computing_products");
 }
@@ -226,110 +313,262 @@ void FastMKS<KernelType, MatType, TreeType>::Search(
     arma::Mat<size_t>& indices,
     arma::mat& kernels)
 {
-  // No remapping will be necessary because we are using the cover tree.
   Timer::Start("computing_products");
-  indices.set_size(k, referenceSet.n_cols);
-  kernels.set_size(k, referenceSet.n_cols);
+  indices.set_size(k, referenceSet->n_cols);
+  indices.fill(size_t() - 1);
+  kernels.set_size(k, referenceSet->n_cols);
   kernels.fill(-DBL_MAX);
 
   // Naive implementation.
   if (naive)
   {
-    // Simple double loop.  Stupid, slow, but a good benchmark.
-    for (size_t q = 0; q < referenceSet.n_cols; ++q)
+    // Simple double loop.  Stupid, slow, but a good benchmark.  Each thread
+    // only writes the columns of its own query points.
+    KernelCandidateList candidates(indices, kernels);
+    #pragma omp parallel if (parallel)
     {
-      for (size_t r = 0; r < referenceSet.n_cols; ++r)
-      {
-        if (q == r)
-          continue; // Don't return the point as its own candidate.
+      KernelType threadKernel(metric.Kernel());
 
-        const double eval = metric.Kernel().Evaluate(referenceSet.col(q),
-                                                     referenceSet.col(r));
+      #pragma omp for schedule(static)
+      for (size_t q = 0; q < referenceSet->n_cols; ++q)
+      {
+        for (size_t r = 0; r < referenceSet->n_cols; ++r)
+        {
+          if (q == r)
+            continue; // Don't return the point as its own candidate.
 
-        size_t insertPosition;
-        for (insertPosition = 0; insertPosition < indices.n_rows;
-            ++insertPosition)
-          if (eval > kernels(insertPosition, q))
-            break;
+          const double eval = threadKernel.Evaluate(referenceSet->col(q),
+                                                    referenceSet->col(r));
 
-        if (insertPosition < indices.n_rows)
-          InsertNeighbor(indices, kernels, q, insertPosition, r, eval);
+          candidates.Insert(q, r, eval);
+        }
       }
     }
 
+    KernelCandidateList::Sort(indices, kernels);
     Timer::Stop("computing_products");
 
     return;
   }
 
-  // Single-tree implementation.
+  // Single-tree implementation.  The query set is the reference set, so the
+  // reference self-kernels are used for the query points too.
   if (singleMode)
   {
-    // Create rules object (this will store the results).  This constructor
-    // precalculates each self-kernel value.
-    typedef FastMKSRules<KernelType, Tree> RuleType;
-    RuleType rules(referenceSet, referenceSet, indices, kernels,
-        metric.Kernel());
+    SingleTreeSearch(*referenceSet, referenceKernels, indices, kernels);
+    KernelCandidateList::Sort(indices, kernels);
+    UnmapResults(indices, kernels, true);
 
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
+    Timer::Stop("computing_products");
+    return;
+  }
 
-    for (size_t i = 0; i < referenceSet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+  // Dual-tree implementation.
+  DualTreeSearch(*referenceTree, referenceKernels, indices, kernels);
+  KernelCandidateList::Sort(indices, kernels);
+  UnmapResults(indices, kernels, true);
 
-    // Save the number of pruned nodes.
-    const size_t numPrunes = traverser.NumPrunes();
+  Timer::Stop("computing_products");
+}
 
-    Log::Info << "Pruned " << numPrunes << " nodes." << std::endl;
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::SelfKernels(
+    const MatType& set,
+    arma::vec& kernels)
+{
+  kernels.set_size(set.n_cols);
 
+  #pragma omp parallel if (parallel)
+  {
+    KernelType threadKernel(metric.Kernel());
+
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < set.n_cols; ++i)
+      kernels[i] = sqrt(threadKernel.Evaluate(set.col(i), set.col(i)));
+  }
+}
+
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::SingleTreeSearch(
+    const MatType& querySet,
+    const arma::vec& queryKernels,
+    arma::Mat<size_t>& indices,
+    arma::mat& kernels)
+{
+  typedef FastMKSRules<KernelType, Tree> RuleType;
+  typedef typename Tree::template SingleTreeTraverser<RuleType> TraverserType;
+
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+
+  // Each query point only writes to its own column of the results, so they can
+  // be searched in any order.
+  std::vector<size_t> queryOrder;
+  tree::QueryOrder(querySet, queryOrder, reorderQueries);
+
+  // Unless the first point of each node is its centroid, the rules cache the
+  // kernel value of each reference node in its statistic, so threads cannot
+  // share the reference tree.
+  if (!parallel || numThreads == 1 ||
+      !tree::TreeTraits<Tree>::FirstPointIsCentroid)
+  {
+    if (parallel && numThreads > 1)
+      Log::Info << "Parallel single-tree search is not available for this tree "
+          << "type; searching serially." << std::endl;
+
+    // Create rules object (this will store the results).
+    RuleType rules(*referenceSet, querySet, indices, kernels, metric.Kernel(),
+        queryKernels, referenceKernels);
+    TraverserType traverser(rules);
+
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+      traverser.Traverse(queryOrder[i], *referenceTree);
+
+    Log::Info << "Pruned " << traverser.NumPrunes() << " nodes." << std::endl;
     Log::Info << rules.BaseCases() << " base cases." << std::endl;
     Log::Info << rules.Scores() << " scores." << std::endl;
-
-    Timer::Stop("computing_products");
     return;
   }
 
-  // Dual-tree implementation.
-  Timer::Stop("computing_products");
+  size_t totalPrunes = 0;
+  size_t totalBaseCases = 0;
+  size_t totalScores = 0;
+
+  #pragma omp parallel reduction(+:totalPrunes, totalBaseCases, totalScores)
+  {
+    // Each thread gets its own rules, traverser, and kernel, and only writes to
+    // the columns of the query points it is given.
+    KernelType threadKernel(metric.Kernel());
+    RuleType rules(*referenceSet, querySet, indices, kernels, threadKernel,
+        queryKernels, referenceKernels);
+    TraverserType traverser(rules);
+
+    #pragma omp for schedule(dynamic, 64)
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+      traverser.Traverse(queryOrder[i], *referenceTree);
 
-  Search(referenceTree, k, indices, kernels);
+    totalPrunes += traverser.NumPrunes();
+    totalBaseCases += rules.BaseCases();
+    totalScores += rules.Scores();
+  }
+
+  Log::Info << "Pruned " << totalPrunes << " nodes." << std::endl;
+  Log::Info << totalBaseCases << " base cases." << std::endl;
+  Log::Info << totalScores << " scores." << std::endl;
 }
 
-/**
- * Helper function to insert a point into the neighbors and distances matrices.
- *
- * @param queryIndex Index of point whose neighbors we are inserting into.
- * @param pos Position in list to insert into.
- * @param neighbor Index of reference point which is being inserted.
- * @param distance Distance from query point to reference point.
- */
 template<typename KernelType,
          typename MatType,
          template<typename TreeMetricType,
                   typename TreeStatType,
                   typename TreeMatType> class TreeType>
-void FastMKS<KernelType, MatType, TreeType>::InsertNeighbor(
+void FastMKS<KernelType, MatType, TreeType>::DualTreeSearch(
+    Tree& queryTree,
+    const arma::vec& queryKernels,
     arma::Mat<size_t>& indices,
-    arma::mat& products,
-    const size_t queryIndex,
-    const size_t pos,
-    const size_t neighbor,
-    const double distance)
+    arma::mat& kernels)
 {
-  // We only memmove() if there is actually a need to shift something.
-  if (pos < (products.n_rows - 1))
+  typedef FastMKSRules<KernelType, Tree> RuleType;
+  typedef typename Tree::template DualTreeTraverser<RuleType> TraverserType;
+
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+
+  if (!parallel || numThreads == 1)
+  {
+    RuleType rules(*referenceSet, queryTree.Dataset(), indices, kernels,
+        metric.Kernel(), queryKernels, referenceKernels);
+    TraverserType traverser(rules);
+
+    traverser.Traverse(queryTree, *referenceTree);
+
+    Log::Info << rules.BaseCases() << " base cases." << std::endl;
+    Log::Info << rules.Scores() << " scores." << std::endl;
+    return;
+  }
+
+  // Split the query tree into several disjoint subtrees; we generate a few
+  // more subtrees than threads so that the work can be balanced dynamically.
+  std::vector<Tree*> frontier;
+  tree::SubtreeFrontier(queryTree, 4 * numThreads, frontier);
+
+  // The bound of a query node is never looser than the bound of its parent.
+  // The nodes above the frontier are not visited by any task, so their bounds
+  // must not be left over from an earlier search.
+  for (size_t i = 0; i < frontier.size(); ++i)
+    for (Tree* node = frontier[i]->Parent(); node != NULL;
+        node = node->Parent())
+      node->Stat().Bound() = -DBL_MAX;
+
+  Log::Info << "Splitting dual-tree search into " << frontier.size()
+      << " query subtrees across " << numThreads << " threads." << std::endl;
+
+  size_t totalBaseCases = 0;
+  size_t totalScores = 0;
+
+  #pragma omp parallel for schedule(dynamic) \
+      reduction(+:totalBaseCases, totalScores)
+  for (size_t i = 0; i < frontier.size(); ++i)
   {
-    int len = (products.n_rows - 1) - pos;
-    memmove(products.colptr(queryIndex) + (pos + 1),
-        products.colptr(queryIndex) + pos,
-        sizeof(double) * len);
-    memmove(indices.colptr(queryIndex) + (pos + 1),
-        indices.colptr(queryIndex) + pos,
-        sizeof(size_t) * len);
+    // Each task gets its own rules, traverser, and kernel.  All writes to the
+    // results and to the query statistics are restricted to this query
+    // subtree.
+    KernelType taskKernel(metric.Kernel());
+    RuleType rules(*referenceSet, queryTree.Dataset(), indices, kernels,
+        taskKernel, queryKernels, referenceKernels);
+    TraverserType traverser(rules);
+
+    traverser.Traverse(*frontier[i], *referenceTree);
+
+    totalBaseCases += rules.BaseCases();
+    totalScores += rules.Scores();
   }
 
-  // Now put the new information in the right index.
-  products(pos, queryIndex) = distance;
-  indices(pos, queryIndex) = neighbor;
+  Log::Info << totalBaseCases << " base cases." << std::endl;
+  Log::Info << totalScores << " scores." << std::endl;
+}
+
+template<typename KernelType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void FastMKS<KernelType, MatType, TreeType>::UnmapResults(
+    arma::Mat<size_t>& indices,
+    arma::mat& kernels,
+    const bool monochromatic) const
+{
+  // Only a tree built by this object has a mapping.
+  if (!tree::TreeTraits<Tree>::RearrangesDataset || !treeOwner || naive)
+    return;
+
+  const arma::Mat<size_t> treeIndices(indices);
+  if (monochromatic)
+  {
+    // The query points are the reference points, in the same order.
+    const arma::mat treeKernels(kernels);
+    neighbor::Unmap(treeIndices, treeKernels, oldFromNewReferences,
+        oldFromNewReferences, indices, kernels);
+  }
+  else
+  {
+    neighbor::Unmap(treeIndices, kernels, oldFromNewReferences, indices,
+        kernels);
+  }
 }
 
 // Return string of object.
@@ -344,6 +583,7 @@ std::string FastMKS<KernelType, MatType, TreeType>::ToString() const
   convert << "FastMKS [" << this << "]" << std::endl;
   convert << "  Naive: " << naive << std::endl;
   convert << "  Single: " << singleMode << std::endl;
+  convert << "  Parallel: " << parallel << std::endl;
   convert << "  Metric: " << std::endl;
   convert << mlpack::util::Indent(metric.ToString(),2);
   convert << std::endl;
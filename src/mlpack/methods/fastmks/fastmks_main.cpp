@@ -5,6 +5,7 @@
  * Main executable for maximum inner product search.
  */
 #include <mlpack/core.hpp>
+#include <mlpack/methods/neighbor_search/cosine_neighbor_search.hpp>
 
 #include "fastmks.hpp"
 
@@ -37,7 +38,13 @@ PROGRAM_INFO("FastMKS (Fast Max-Kernel Search)",
     "to the kernel evaluation between those two points."
     "\n\n"
     "This executable performs FastMKS using a cover tree.  The base used to "
-    "build the cover tree can be specified with the --base option.");
+    "build the cover tree can be specified with the --base option."
+    "\n\n"
+    "With the cosine kernel, --cosine_kd_tree may be given: then the points "
+    "are scaled to unit norm, and the points with the largest cosine "
+    "similarity are found as the nearest neighbors with the Euclidean "
+    "distance, using a kd-tree.  The results are the same, but this is usually "
+    "much faster.  Reference points may not have norm 0 with this option.");
 
 // Define our input parameters.
 PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
@@ -56,6 +63,11 @@ PARAM_STRING("kernel", "Kernel type to use: 'linear', 'polynomial', 'cosine', "
 PARAM_FLAG("naive", "If true, O(n^2) naive mode is used for computation.", "N");
 PARAM_FLAG("single", "If true, single-tree search is used (as opposed to "
     "dual-tree search.", "S");
+PARAM_FLAG("parallel", "If true, search is split across multiple threads (only "
+    "available if mlpack was compiled with OpenMP).", "P");
+
+PARAM_FLAG("cosine_kd_tree", "With the cosine kernel, normalize the points and "
+    "search with a kd-tree and the Euclidean distance.", "C");
 
 // Cover tree parameter.
 PARAM_DOUBLE("base", "Base to use during cover tree construction.", "b", 2.0);
@@ -83,6 +95,7 @@ void RunFastMKS(const arma::mat& referenceData,
   {
     // No need for trees.
     FastMKS<KernelType> fastmks(referenceData, kernel, false, naive);
+    fastmks.Parallel() = CLI::HasParam("parallel");
     fastmks.Search(k, indices, kernels);
   }
   else
@@ -95,6 +108,7 @@ void RunFastMKS(const arma::mat& referenceData,
 
     // Create FastMKS object.
     FastMKS<KernelType> fastmks(&tree, single);
+    fastmks.Parallel() = CLI::HasParam("parallel");
 
     // Now search with it.
     fastmks.Search(k, indices, kernels);
@@ -117,6 +131,7 @@ void RunFastMKS(const arma::mat& referenceData,
   {
     // No need for trees.
     FastMKS<KernelType> fastmks(referenceData, kernel, false, naive);
+    fastmks.Parallel() = CLI::HasParam("parallel");
     fastmks.Search(queryData, k, indices, kernels);
   }
   else
@@ -130,6 +145,7 @@ void RunFastMKS(const arma::mat& referenceData,
     // Create FastMKS object.
     FastMKS<KernelType, arma::mat, StandardCoverTree> fastmks(&referenceTree,
         single);
+    fastmks.Parallel() = CLI::HasParam("parallel");
 
     // Now search with it.
     if (single)
@@ -211,6 +227,12 @@ int main(int argc, char** argv)
         << "specified)." << endl;
   }
 
+  if (CLI::HasParam("cosine_kd_tree") && kernelType != "cosine")
+  {
+    Log::Warn << "--cosine_kd_tree ignored because --kernel is not 'cosine'."
+        << endl;
+  }
+
   // Naive mode overrides single mode.
   if (naive && single)
   {
@@ -237,6 +259,11 @@ int main(int argc, char** argv)
       RunFastMKS<PolynomialKernel>(referenceData, single, naive, base, k,
           indices, kernels, pk);
     }
+    else if (kernelType == "cosine" && CLI::HasParam("cosine_kd_tree"))
+    {
+      neighbor::CosineNeighborSearch<> search(referenceData, naive, single);
+      search.Search(k, indices, kernels);
+    }
     else if (kernelType == "cosine")
     {
       CosineDistance cd;
@@ -282,6 +309,11 @@ int main(int argc, char** argv)
       RunFastMKS<PolynomialKernel>(referenceData, queryData, single, naive,
           base, k, indices, kernels, pk);
     }
+    else if (kernelType == "cosine" && CLI::HasParam("cosine_kd_tree"))
+    {
+      neighbor::CosineNeighborSearch<> search(referenceData, naive, single);
+      search.Search(queryData, k, indices, kernels);
+    }
     else if (kernelType == "cosine")
     {
       CosineDistance cd;
@@ -10,11 +10,18 @@
 #include <mlpack/core.hpp>
 #include <mlpack/core/tree/cover_tree/cover_tree.hpp>
 
+#include "../neighbor_search/candidate_list.hpp"
 #include "../neighbor_search/ns_traversal_info.hpp"
+#include "../neighbor_search/sort_policies/furthest_neighbor_sort.hpp"
 
 namespace mlpack {
 namespace fastmks {
 
+//! The candidate lists of max-kernel search; larger kernel values are better,
+//! as larger distances are for furthest neighbor search.
+typedef neighbor::CandidateList<neighbor::FurthestNeighborSort>
+    KernelCandidateList;
+
 /**
  * The base case and pruning rules for FastMKS (fast max-kernel search).
  */
@@ -22,15 +29,47 @@ template<typename KernelType, typename TreeType>
 class FastMKSRules
 {
  public:
+  /**
+   * Construct the rules.  The self-kernels sqrt(K(x, x)) of every query and
+   * reference point must be given; they are not copied, so they must stay
+   * alive as long as the rules do.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param indices Matrix to store resulting indices in.
+   * @param products Matrix to store resulting kernel values in.
+   * @param kernel Instantiated kernel.
+   * @param queryKernels Self-kernel of each query point.
+   * @param referenceKernels Self-kernel of each reference point.
+   */
   FastMKSRules(const typename TreeType::Mat& referenceSet,
                const typename TreeType::Mat& querySet,
                arma::Mat<size_t>& indices,
                arma::mat& products,
-               KernelType& kernel);
+               KernelType& kernel,
+               const arma::vec& queryKernels,
+               const arma::vec& referenceKernels);
 
-  //! Compute the base case (kernel value) between two points.
+  /**
+   * Compute the base case (kernel value) between two points.  If the kernel
+   * value of this pair is the last one computed for the reference point, it
+   * is not computed (or added to the results) again.
+   */
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
+  /**
+   * Compute the base cases between the given query point and each of the
+   * given reference points as one block, if the kernel has a batch evaluation
+   * (see kernel::HasBatchEvaluate); otherwise, do nothing.  The kernel values
+   * are kept, so that BaseCase() does not evaluate them again.  The cover tree
+   * traverser calls this for the leaves it is about to visit.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceIndices Indices of reference points.
+   */
+  void BatchBaseCases(const size_t queryIndex,
+                      const std::vector<size_t>& referenceIndices);
+
   /**
    * Get the score for recursion order.  A low score indicates priority for
    * recursion, while DBL_MAX indicates that the node should not be recursed
@@ -106,11 +145,13 @@ class FastMKSRules
   arma::Mat<size_t>& indices;
   //! The maximum kernels.
   arma::mat& products;
+  //! The candidate lists of the query points, held in indices and products.
+  KernelCandidateList candidates;
 
-  //! Cached query set self-kernels (|| q || for each q).
-  arma::vec queryKernels;
-  //! Cached reference set self-kernels (|| r || for each r).
-  arma::vec referenceKernels;
+  //! Query set self-kernels (|| q || for each q).
+  const arma::vec& queryKernels;
+  //! Reference set self-kernels (|| r || for each r).
+  const arma::vec& referenceKernels;
 
   //! The instantiated kernel.
   KernelType& kernel;
@@ -122,15 +163,32 @@ class FastMKSRules
   //! The last kernel evaluation resulting from BaseCase().
   double lastKernel;
 
+  //! Whether BatchBaseCases() computes anything: the kernel must have a batch
+  //! evaluation, and the data must be dense.
+  static const bool UseBatchBaseCases =
+      kernel::HasBatchEvaluate<KernelType>::value &&
+      arma::is_Mat<typename TreeType::Mat>::value;
+
+  //! For each reference point, the query point of the last base case computed
+  //! for it.
+  arma::Col<size_t> cachedQueryIndices;
+  //! For each reference point, the kernel value of the last base case computed
+  //! for it.
+  arma::vec cachedKernels;
+  //! For each reference point, whether the last base case was computed by
+  //! BatchBaseCases() and has not been given to BaseCase() yet.
+  std::vector<bool> cachePending;
+
+  /**
+   * Get the kernel value between the given query point and the centroid of
+   * the parent of the given reference node, which was computed when the
+   * parent was scored.
+   */
+  double ParentKernel(const size_t queryIndex, const TreeType& referenceNode);
+
   //! Calculate the bound for a given query node.
   double CalculateBound(TreeType& queryNode) const;
 
-  //! Utility function to insert neighbor into list of results.
-  void InsertNeighbor(const size_t queryIndex,
-                      const size_t pos,
-                      const size_t neighbor,
-                      const double distance);
-
   //! For benchmarking.
   size_t baseCases;
   //! For benchmarking.
@@ -19,28 +19,28 @@ FastMKSRules<KernelType, TreeType>::FastMKSRules(
     const typename TreeType::Mat& querySet,
     arma::Mat<size_t>& indices,
     arma::mat& products,
-    KernelType& kernel) :
+    KernelType& kernel,
+    const arma::vec& queryKernels,
+    const arma::vec& referenceKernels) :
     referenceSet(referenceSet),
     querySet(querySet),
     indices(indices),
     products(products),
+    candidates(indices, products),
+    queryKernels(queryKernels),
+    referenceKernels(referenceKernels),
     kernel(kernel),
     lastQueryIndex(-1),
     lastReferenceIndex(-1),
     lastKernel(0.0),
+    cachedQueryIndices(referenceSet.n_cols),
+    cachedKernels(referenceSet.n_cols),
+    cachePending(referenceSet.n_cols, false),
     baseCases(0),
     scores(0)
 {
-  // Precompute each self-kernel.
-  queryKernels.set_size(querySet.n_cols);
-  for (size_t i = 0; i < querySet.n_cols; ++i)
-    queryKernels[i] = sqrt(kernel.Evaluate(querySet.col(i),
-                                           querySet.col(i)));
-
-  referenceKernels.set_size(referenceSet.n_cols);
-  for (size_t i = 0; i < referenceSet.n_cols; ++i)
-    referenceKernels[i] = sqrt(kernel.Evaluate(referenceSet.col(i),
-                                               referenceSet.col(i)));
+  // No base cases have been computed yet.
+  cachedQueryIndices.fill(querySet.n_cols);
 
   // Set to invalid memory, so that the first node combination does not try to
   // dereference null pointers.
@@ -69,9 +69,30 @@ double FastMKSRules<KernelType, TreeType>::BaseCase(
     lastReferenceIndex = referenceIndex;
   }
 
-  ++baseCases;
-  double kernelEval = kernel.Evaluate(querySet.col(queryIndex),
-                                      referenceSet.col(referenceIndex));
+  // The kernel value may have been computed already, either by
+  // BatchBaseCases() or by an earlier call with the same pair.  In the second
+  // case the pair has already been considered for the results.
+  double kernelEval;
+  if (cachedQueryIndices[referenceIndex] == queryIndex)
+  {
+    kernelEval = cachedKernels[referenceIndex];
+    if (!cachePending[referenceIndex])
+    {
+      if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
+        lastKernel = kernelEval;
+      return kernelEval;
+    }
+
+    cachePending[referenceIndex] = false;
+  }
+  else
+  {
+    ++baseCases;
+    kernelEval = kernel.Evaluate(querySet.col(queryIndex),
+                                 referenceSet.col(referenceIndex));
+    cachedQueryIndices[referenceIndex] = queryIndex;
+    cachedKernels[referenceIndex] = kernelEval;
+  }
 
   // Update the last kernel value, if we need to.
   if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
@@ -84,17 +105,41 @@ double FastMKSRules<KernelType, TreeType>::BaseCase(
     return kernelEval;
 
   // If this is a better candidate, insert it into the list.
-  if (kernelEval < products(products.n_rows - 1, queryIndex))
-    return kernelEval;
+  candidates.Insert(queryIndex, referenceIndex, kernelEval);
+
+  return kernelEval;
+}
+
+template<typename KernelType, typename TreeType>
+void FastMKSRules<KernelType, TreeType>::BatchBaseCases(
+    const size_t queryIndex,
+    const std::vector<size_t>& referenceIndices)
+{
+  // Without a batch evaluation, computing the kernel values ahead of time
+  // gains nothing.
+  if (!UseBatchBaseCases || referenceIndices.size() < 2)
+    return;
 
-  size_t insertPosition = 0;
-  for ( ; insertPosition < products.n_rows; ++insertPosition)
-    if (kernelEval >= products(insertPosition, queryIndex))
-      break;
+  arma::mat query(querySet.n_rows, 1);
+  for (size_t j = 0; j < querySet.n_rows; ++j)
+    query.at(j, 0) = querySet.at(j, queryIndex);
 
-  InsertNeighbor(queryIndex, insertPosition, referenceIndex, kernelEval);
+  arma::mat references(referenceSet.n_rows, referenceIndices.size());
+  for (size_t i = 0; i < referenceIndices.size(); ++i)
+    for (size_t j = 0; j < referenceSet.n_rows; ++j)
+      references.at(j, i) = referenceSet.at(j, referenceIndices[i]);
 
-  return kernelEval;
+  arma::mat kernelEvals;
+  kernel::BatchEvaluate(kernel, query, references, kernelEvals);
+
+  for (size_t i = 0; i < referenceIndices.size(); ++i)
+  {
+    cachedQueryIndices[referenceIndices[i]] = queryIndex;
+    cachedKernels[referenceIndices[i]] = kernelEvals[i];
+    cachePending[referenceIndices[i]] = true;
+  }
+
+  baseCases += referenceIndices.size();
 }
 
 template<typename KernelType, typename TreeType>
@@ -102,7 +147,7 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
                                                  TreeType& referenceNode)
 {
   // Compare with the current best.
-  const double bestKernel = products(products.n_rows - 1, queryIndex);
+  const double bestKernel = candidates.Worst(queryIndex);
 
   // See if we can perform a parent-child prune.
   const double furthestDist = referenceNode.FurthestDescendantDistance();
@@ -111,7 +156,7 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
     double maxKernelBound;
     const double parentDist = referenceNode.ParentDistance();
     const double combinedDistBound = parentDist + furthestDist;
-    const double lastKernel = referenceNode.Parent()->Stat().LastKernel();
+    const double lastKernel = ParentKernel(queryIndex, referenceNode);
     if (kernel::KernelTraits<KernelType>::IsNormalized)
     {
       const double squaredDist = std::pow(combinedDistBound, 2.0);
@@ -148,7 +193,7 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
         referenceNode.Parent() != NULL &&
         referenceNode.Point(0) == referenceNode.Parent()->Point(0))
     {
-      kernelEval = referenceNode.Parent()->Stat().LastKernel();
+      kernelEval = ParentKernel(queryIndex, referenceNode);
     }
     else
     {
@@ -163,7 +208,10 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
     kernelEval = kernel.Evaluate(querySet.col(queryIndex), refCenter);
   }
 
-  referenceNode.Stat().LastKernel() = kernelEval;
+  // When the first point is the centroid, ParentKernel() does not need the
+  // statistic; not writing it lets several threads share the reference tree.
+  if (!tree::TreeTraits<TreeType>::FirstPointIsCentroid)
+    referenceNode.Stat().LastKernel() = kernelEval;
 
   double maxKernel;
   if (kernel::KernelTraits<KernelType>::IsNormalized)
@@ -191,6 +239,21 @@ double FastMKSRules<KernelType, TreeType>::Score(const size_t queryIndex,
   return (maxKernel >= bestKernel) ? (1.0 / maxKernel) : DBL_MAX;
 }
 
+template<typename KernelType, typename TreeType>
+double FastMKSRules<KernelType, TreeType>::ParentKernel(
+    const size_t queryIndex,
+    const TreeType& referenceNode)
+{
+  // The parent was scored with this query point before this node, so when the
+  // first point is the centroid, its kernel value is the base case with the
+  // parent's point, which is cached (this only calls the kernel if the cache
+  // entry was overwritten since then).
+  if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
+    return BaseCase(queryIndex, referenceNode.Parent()->Point(0));
+  else
+    return referenceNode.Parent()->Stat().LastKernel();
+}
+
 template<typename KernelType, typename TreeType>
 double FastMKSRules<KernelType, TreeType>::Score(TreeType& queryNode,
                                                  TreeType& referenceNode)
@@ -385,7 +448,7 @@ double FastMKSRules<KernelType, TreeType>::Rescore(const size_t queryIndex,
                                                    TreeType& /*referenceNode*/,
                                                    const double oldScore) const
 {
-  const double bestKernel = products(products.n_rows - 1, queryIndex);
+  const double bestKernel = candidates.Worst(queryIndex);
 
   return ((1.0 / oldScore) >= bestKernel) ? oldScore : DBL_MAX;
 }
@@ -432,10 +495,10 @@ double FastMKSRules<KernelType, TreeType>::CalculateBound(TreeType& queryNode)
   for (size_t i = 0; i < queryNode.NumPoints(); ++i)
   {
     const size_t point = queryNode.Point(i);
-    if (products(products.n_rows - 1, point) < worstPointKernel)
-      worstPointKernel = products(products.n_rows - 1, point);
+    if (candidates.Worst(point) < worstPointKernel)
+      worstPointKernel = candidates.Worst(point);
 
-    if (products(products.n_rows - 1, point) == -DBL_MAX)
+    if (candidates.Worst(point) == -DBL_MAX)
       continue; // Avoid underflow.
 
     // This should be (queryDescendantDistance + centroidDistance) for any tree
@@ -487,37 +550,6 @@ double FastMKSRules<KernelType, TreeType>::CalculateBound(TreeType& queryNode)
   return (interA > interB) ? interA : interB;
 }
 
-/**
- * Helper function to insert a point into the neighbors and distances matrices.
- *
- * @param queryIndex Index of point whose neighbors we are inserting into.
- * @param pos Position in list to insert into.
- * @param neighbor Index of reference point which is being inserted.
- * @param distance Distance from query point to reference point.
- */
-template<typename KernelType, typename TreeType>
-void FastMKSRules<KernelType, TreeType>::InsertNeighbor(const size_t queryIndex,
-                                                        const size_t pos,
-                                                        const size_t neighbor,
-                                                        const double distance)
-{
-  // We only memmove() if there is actually a need to shift something.
-  if (pos < (products.n_rows - 1))
-  {
-    int len = (products.n_rows - 1) - pos;
-    memmove(products.colptr(queryIndex) + (pos + 1),
-        products.colptr(queryIndex) + pos,
-        sizeof(double) * len);
-    memmove(indices.colptr(queryIndex) + (pos + 1),
-        indices.colptr(queryIndex) + pos,
-        sizeof(size_t) * len);
-  }
-
-  // Now put the new information in the right index.
-  products(pos, queryIndex) = distance;
-  indices(pos, queryIndex) = neighbor;
-}
-
 } // namespace fastmks
 } // namespace mlpack
 
@@ -26,6 +26,9 @@ class DiagonalConstraint
     covariance = arma::diagmat(diagonal);
   }
 
+  //! A diagonal covariance is already diagonal, so do nothing.
+  static void ApplyConstraint(const arma::vec& /* diagonalCovariance */) { }
+
   //! Serialize the constraint (which holds nothing, so, nothing to do).
   template<typename Archive>
   static void Serialize(Archive& /* ar */, const unsigned int /* version */) { }
@@ -71,6 +71,19 @@ class EigenvalueRatioConstraint
     covariance = eigenvectors * arma::diagmat(eigenvalues) * eigenvectors.t();
   }
 
+  /**
+   * Apply the eigenvalue ratio constraint to the given diagonal covariance.
+   * The eigenvalues of a diagonal matrix are its elements, so they are changed
+   * directly, in the same order as the eigenvalues of a full matrix.
+   */
+  void ApplyConstraint(arma::vec& diagonalCovariance) const
+  {
+    const arma::uvec order = arma::sort_index(diagonalCovariance);
+    const double first = diagonalCovariance[order[0]];
+    for (size_t i = 0; i < order.n_elem; ++i)
+      diagonalCovariance[order[i]] = first * ratios[i];
+  }
+
   //! Serialize the constraint.
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int /* version */)
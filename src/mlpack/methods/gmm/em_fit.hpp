@@ -31,9 +31,18 @@ namespace gmm {
  *
  * This method should create 'clusters' clusters, and return the assignment of
  * each point to a cluster.
+ *
+ * The Gaussians can be distribution::GaussianDistribution objects, which hold
+ * full covariance matrices, or distribution::DiagonalGaussianDistribution
+ * objects, which hold only the diagonal of the covariance, so that each
+ * iteration takes O(d) time per point and Gaussian instead of O(d^2).  With
+ * diagonal Gaussians, the covariance constraint is applied to the diagonal, so
+ * the CovarianceConstraintPolicy must also have an ApplyConstraint() overload
+ * that takes an arma::vec.
  */
 template<typename InitialClusteringType = kmeans::KMeans<>,
-         typename CovarianceConstraintPolicy = PositiveDefiniteConstraint>
+         typename CovarianceConstraintPolicy = PositiveDefiniteConstraint,
+         typename Distribution = distribution::GaussianDistribution>
 class EMFit
 {
  public:
@@ -75,7 +84,7 @@ class EMFit
    *      clustering.
    */
   void Estimate(const arma::mat& observations,
-                std::vector<distribution::GaussianDistribution>& dists,
+                std::vector<Distribution>& dists,
                 arma::vec& weights,
                 const bool useInitialModel = false);
 
@@ -98,7 +107,7 @@ class EMFit
    */
   void Estimate(const arma::mat& observations,
                 const arma::vec& probabilities,
-                std::vector<distribution::GaussianDistribution>& dists,
+                std::vector<Distribution>& dists,
                 arma::vec& weights,
                 const bool useInitialModel = false);
 
@@ -122,6 +131,19 @@ class EMFit
   //! Modify the tolerance for the convergence of the EM algorithm.
   double& Tolerance() { return tolerance; }
 
+  /**
+   * Get the reducer (NULL if there is none).  If a reducer is set, the
+   * observations given to Estimate() are one shard of a larger dataset that is
+   * held by several processes, each of which calls Estimate() on its own shard
+   * with the same settings: the log-likelihood and the weighted sums of the
+   * M-step are added up over the shards, so every process fits the model of
+   * the whole dataset.  The initial model is the one found by the clusterer of
+   * the root process.  The reducer is not serialized.
+   */
+  math::Reducer* Reducer() const { return reducer; }
+  //! Modify the reducer (NULL for none).
+  math::Reducer*& Reducer() { return reducer; }
+
   //! Serialize the fitter.
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int version);
@@ -142,19 +164,73 @@ class EMFit
                          arma::vec& weights);
 
   /**
-   * Calculate the log-likelihood of a model.  Yes, this is reimplemented in the
-   * GMM code.  Intuition suggests that the log-likelihood is not the best way
-   * to determine if the EM algorithm has converged.
+   * Run the clusterer, and then turn the cluster assignments into diagonal
+   * Gaussians.
+   *
+   * @param observations List of observations.
+   * @param dists Vector to store the Gaussians in.
+   * @param weights Vector to store a priori weights in.
+   */
+  void InitialClustering(
+      const arma::mat& observations,
+      std::vector<distribution::DiagonalGaussianDistribution>& dists,
+      arma::vec& weights);
+
+  //! The number of observations processed together in the E-step and the
+  //! M-step.
+  static const size_t BlockSize = 1024;
+
+  /**
+   * Run the E-step: calculate the conditional probability of each Gaussian
+   * given each observation, and the log-likelihood of the model.  If mlpack is
+   * compiled with OpenMP, blocks of observations are split across threads; the
+   * log-likelihood is summed in block order, so it does not depend on the
+   * number of threads.
    *
-   * @param data Data matrix.
-   * @param means Vector of means.
-   * @param covariances Vector of covariance matrices.
+   * @param observations List of observations.
+   * @param dists Vector of Gaussians.
    * @param weights Vector of a priori weights.
+   * @param condProb Matrix to store the conditional probabilities in (one row
+   *     per observation, one column per Gaussian).
+   * @return Log-likelihood of the model.
+   */
+  double Expectation(const arma::mat& observations,
+                     const std::vector<Distribution>& dists,
+                     const arma::vec& weights,
+                     arma::mat& condProb) const;
+
+  /**
+   * Run the M-step for one Gaussian: set its mean and covariance to the
+   * weighted mean and covariance of the observations, and apply the covariance
+   * constraint.  The mean and covariance are found with a
+   * math::CovarianceAccumulator, in one blocked (and, with OpenMP, parallel)
+   * pass over the observations.
+   *
+   * @param observations List of observations.
+   * @param pointWeights Weight of each observation.
+   * @param weightSum Sum of the weights over all the shards (only used with a
+   *     reducer; otherwise the accumulator sums them).
+   * @param dist Gaussian to update.
+   */
+  void UpdateGaussian(const arma::mat& observations,
+                      const arma::vec& pointWeights,
+                      const double weightSum,
+                      distribution::GaussianDistribution& dist);
+
+  /**
+   * Run the M-step for one diagonal Gaussian: set its mean and the diagonal of
+   * its covariance to the weighted mean and variances of the observations, and
+   * apply the covariance constraint.
+   *
+   * @param observations List of observations.
+   * @param pointWeights Weight of each observation.
+   * @param weightSum Sum of the weights.
+   * @param dist Gaussian to update.
    */
-  double LogLikelihood(const arma::mat& data,
-                       const std::vector<distribution::GaussianDistribution>&
-                           dists,
-                       const arma::vec& weights) const;
+  void UpdateGaussian(const arma::mat& observations,
+                      const arma::vec& pointWeights,
+                      const double weightSum,
+                      distribution::DiagonalGaussianDistribution& dist);
 
   //! Maximum iterations of EM algorithm.
   size_t maxIterations;
@@ -164,6 +240,8 @@ class EMFit
   InitialClusteringType clusterer;
   //! Object which applies constraints to the covariance matrix.
   CovarianceConstraintPolicy constraint;
+  //! The reducer of the statistics of each shard, if the dataset is a shard.
+  math::Reducer* reducer;
 };
 
 } // namespace gmm
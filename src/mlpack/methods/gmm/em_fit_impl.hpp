@@ -15,8 +15,10 @@ namespace mlpack {
 namespace gmm {
 
 //! Constructor.
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-EMFit<InitialClusteringType, CovarianceConstraintPolicy>::EMFit(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+EMFit<InitialClusteringType, CovarianceConstraintPolicy, Distribution>::EMFit(
     const size_t maxIterations,
     const double tolerance,
     InitialClusteringType clusterer,
@@ -24,13 +26,17 @@ EMFit<InitialClusteringType, CovarianceConstraintPolicy>::EMFit(
     maxIterations(maxIterations),
     tolerance(tolerance),
     clusterer(clusterer),
-    constraint(constraint)
+    constraint(constraint),
+    reducer(NULL)
 { /* Nothing to do. */ }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy, Distribution>::
+Estimate(
     const arma::mat& observations,
-    std::vector<distribution::GaussianDistribution>& dists,
+    std::vector<Distribution>& dists,
     arma::vec& weights,
     const bool useInitialModel)
 {
@@ -38,125 +44,90 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
   if (!useInitialModel)
     InitialClustering(observations, dists, weights);
 
-  double l = LogLikelihood(observations, dists, weights);
+  // The E-step for the current model also gives its log-likelihood.
+  arma::mat condProb;
+  double l = Expectation(observations, dists, weights, condProb);
 
   Log::Debug << "EMFit::Estimate(): initial clustering log-likelihood: "
       << l << std::endl;
 
   double lOld = -DBL_MAX;
-  arma::mat condProb(observations.n_cols, dists.size());
+
+  // The number of observations in all the shards.
+  double totalObservations = observations.n_cols;
+  if (reducer != NULL)
+    reducer->Sum(&totalObservations, 1);
 
   // Iterate to update the model until no more improvement is found.
   size_t iteration = 1;
   while (std::abs(l - lOld) > tolerance && iteration != maxIterations)
   {
-    Log::Info << "EMFit::Estimate(): iteration " << iteration << ", "
+    MLPACK_LOG_INFO << "EMFit::Estimate(): iteration " << iteration << ", "
         << "log-likelihood " << l << "." << std::endl;
 
-    // Calculate the conditional probabilities of choosing a particular
-    // Gaussian given the observations and the present theta value.
-    for (size_t i = 0; i < dists.size(); i++)
-    {
-      // Store conditional probabilities into condProb vector for each
-      // Gaussian.  First we make an alias of the condProb vector.
-      arma::vec condProbAlias = condProb.unsafe_col(i);
-      dists[i].Probability(observations, condProbAlias);
-      condProbAlias *= weights[i];
-    }
-
-    // Normalize row-wise.
-    for (size_t i = 0; i < condProb.n_rows; i++)
-    {
-      // Avoid dividing by zero; if the probability for everything is 0, we
-      // don't want to make it NaN.
-      const double probSum = accu(condProb.row(i));
-      if (probSum != 0.0)
-        condProb.row(i) /= probSum;
-    }
-
     // Store the sum of the probability of each state over all the observations.
     arma::vec probRowSums = trans(arma::sum(condProb, 0 /* columnwise */));
+    if (reducer != NULL)
+      reducer->Sum(probRowSums.memptr(), probRowSums.n_elem);
 
     // Calculate the new value of the means using the updated conditional
     // probabilities.
     for (size_t i = 0; i < dists.size(); i++)
     {
       // Don't update if there's no probability of the Gaussian having points.
-      if (probRowSums[i] != 0)
-        dists[i].Mean() = (observations * condProb.col(i)) / probRowSums[i];
+      if (probRowSums[i] == 0.0)
+        continue;
 
-      // Calculate the new value of the covariances using the updated
-      // conditional probabilities and the updated means.
-      arma::mat tmp = observations - (dists[i].Mean() *
-          arma::ones<arma::rowvec>(observations.n_cols));
-      arma::mat tmpB = tmp % (arma::ones<arma::vec>(observations.n_rows) *
-          trans(condProb.col(i)));
-
-      // Don't update if there's no probability of the Gaussian having points.
-      if (probRowSums[i] != 0.0) {
-        arma::mat covariance = (tmp * trans(tmpB)) / probRowSums[i];
-        // Apply covariance constraint.
-        constraint.ApplyConstraint(covariance);
-        dists[i].Covariance(std::move(covariance));
-      }
+      // Calculate the new values of the mean and the covariance using the
+      // updated conditional probabilities.
+      UpdateGaussian(observations, condProb.col(i), probRowSums[i], dists[i]);
     }
 
     // Calculate the new values for omega using the updated conditional
     // probabilities.
-    weights = probRowSums / observations.n_cols;
+    weights = probRowSums / totalObservations;
 
-    // Update values of l; calculate new log-likelihood.
+    // Update values of l; calculate the conditional probabilities and the
+    // log-likelihood of the new model.
     lOld = l;
-    l = LogLikelihood(observations, dists, weights);
+    l = Expectation(observations, dists, weights, condProb);
 
     iteration++;
   }
 }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy, Distribution>::
+Estimate(
     const arma::mat& observations,
     const arma::vec& probabilities,
-    std::vector<distribution::GaussianDistribution>& dists,
+    std::vector<Distribution>& dists,
     arma::vec& weights,
     const bool useInitialModel)
 {
   if (!useInitialModel)
     InitialClustering(observations, dists, weights);
 
-  double l = LogLikelihood(observations, dists, weights);
+  // The E-step for the current model also gives its log-likelihood.
+  arma::mat condProb;
+  double l = Expectation(observations, dists, weights, condProb);
 
   Log::Debug << "EMFit::Estimate(): initial clustering log-likelihood: "
       << l << std::endl;
 
   double lOld = -DBL_MAX;
-  arma::mat condProb(observations.n_cols, dists.size());
+
+  // The probability of the observations in all the shards.
+  double totalProbability = accu(probabilities);
+  if (reducer != NULL)
+    reducer->Sum(&totalProbability, 1);
 
   // Iterate to update the model until no more improvement is found.
   size_t iteration = 1;
   while (std::abs(l - lOld) > tolerance && iteration != maxIterations)
   {
-    // Calculate the conditional probabilities of choosing a particular
-    // Gaussian given the observations and the present theta value.
-    for (size_t i = 0; i < dists.size(); i++)
-    {
-      // Store conditional probabilities into condProb vector for each
-      // Gaussian.  First we make an alias of the condProb vector.
-      arma::vec condProbAlias = condProb.unsafe_col(i);
-      dists[i].Probability(observations, condProbAlias);
-      condProbAlias *= weights[i];
-    }
-
-    // Normalize row-wise.
-    for (size_t i = 0; i < condProb.n_rows; i++)
-    {
-      // Avoid dividing by zero; if the probability for everything is 0, we
-      // don't want to make it NaN.
-      const double probSum = accu(condProb.row(i));
-      if (probSum != 0.0)
-        condProb.row(i) /= probSum;
-    }
-
     // This will store the sum of probabilities of each state over all the
     // observations.
     arma::vec probRowSums(dists.size());
@@ -169,40 +140,33 @@ void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
       // conditional probability of each point being from Gaussian i
       // multiplied by the probability of the point being from this mixture
       // model.
-      probRowSums[i] = accu(condProb.col(i) % probabilities);
-
-      dists[i].Mean() = (observations * (condProb.col(i) % probabilities)) /
-        probRowSums[i];
-
-      // Calculate the new value of the covariances using the updated
-      // conditional probabilities and the updated means.
-      arma::mat tmp = observations - (dists[i].Mean() *
-          arma::ones<arma::rowvec>(observations.n_cols));
-      arma::mat tmpB = tmp % (arma::ones<arma::vec>(observations.n_rows) *
-          trans(condProb.col(i) % probabilities));
-
-      arma::mat cov = (tmp * trans(tmpB)) / probRowSums[i];
-
-      // Apply covariance constraint.
-      constraint.ApplyConstraint(cov);
-
-      dists[i].Covariance(std::move(cov));
+      const arma::vec pointWeights = condProb.col(i) % probabilities;
+      probRowSums[i] = accu(pointWeights);
+      if (reducer != NULL)
+        reducer->Sum(&probRowSums[i], 1);
+
+      // Calculate the new values of the mean and the covariance using the
+      // updated conditional probabilities.
+      UpdateGaussian(observations, pointWeights, probRowSums[i], dists[i]);
     }
 
     // Calculate the new values for omega using the updated conditional
     // probabilities.
-    weights = probRowSums / accu(probabilities);
+    weights = probRowSums / totalProbability;
 
-    // Update values of l; calculate new log-likelihood.
+    // Update values of l; calculate the conditional probabilities and the
+    // log-likelihood of the new model.
     lOld = l;
-    l = LogLikelihood(observations, dists, weights);
+    l = Expectation(observations, dists, weights, condProb);
 
     iteration++;
   }
 }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy, Distribution>::
 InitialClustering(const arma::mat& observations,
                   std::vector<distribution::GaussianDistribution>& dists,
                   arma::vec& weights)
@@ -213,92 +177,247 @@ InitialClustering(const arma::mat& observations,
   // Run clustering algorithm.
   clusterer.Cluster(observations, dists.size(), assignments);
 
+  // Now calculate the means, covariances, and weights, with one accumulator
+  // for the points of each cluster.
+  arma::uvec clusterPoints;
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    clusterPoints = arma::find(assignments == i);
+    const arma::mat clusterObservations = observations.cols(clusterPoints);
+    math::CovarianceAccumulator accumulator(observations.n_rows);
+    accumulator.Add(clusterObservations);
+    weights[i] = accumulator.Weight();
+
+    // Apply constraints to covariance matrix.
+    arma::mat covariance = accumulator.Covariance(1);
+    constraint.ApplyConstraint(covariance);
+
+    dists[i].Mean() = accumulator.Mean();
+    if (reducer != NULL)
+    {
+      reducer->Broadcast(dists[i].Mean().memptr(), dists[i].Mean().n_elem);
+      reducer->Broadcast(covariance.memptr(), covariance.n_elem);
+    }
+    dists[i].Covariance(std::move(covariance));
+  }
+
+  // Finally, normalize weights.
+  weights /= accu(weights);
+  if (reducer != NULL)
+    reducer->Broadcast(weights.memptr(), weights.n_elem);
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy, Distribution>::
+InitialClustering(
+    const arma::mat& observations,
+    std::vector<distribution::DiagonalGaussianDistribution>& dists,
+    arma::vec& weights)
+{
+  // Assignments from clustering.
+  arma::Col<size_t> assignments;
+
+  // Run clustering algorithm.
+  clusterer.Cluster(observations, dists.size(), assignments);
+
   std::vector<arma::vec> means(dists.size());
-  std::vector<arma::mat> covs(dists.size());
+  std::vector<arma::vec> covs(dists.size());
 
-  // Now calculate the means, covariances, and weights.
+  // Now calculate the means, variances, and weights.
   weights.zeros();
   for (size_t i = 0; i < dists.size(); ++i)
   {
     means[i].zeros(dists[i].Mean().n_elem);
-    covs[i].zeros(dists[i].Covariance().n_rows,
-                  dists[i].Covariance().n_cols);
+    covs[i].zeros(dists[i].Covariance().n_elem);
   }
 
-  // From the assignments, generate our means, covariances, and weights.
   for (size_t i = 0; i < observations.n_cols; ++i)
   {
-    const size_t cluster = assignments[i];
-
-    // Add this to the relevant mean.
-    means[cluster] += observations.col(i);
-
-    // Add this to the relevant covariance.
-    covs[cluster] += observations.col(i) * trans(observations.col(i));
-
-    // Now add one to the weights (we will normalize).
-    weights[cluster]++;
+    means[assignments[i]] += observations.col(i);
+    weights[assignments[i]]++;
   }
 
-  // Now normalize the mean and covariance.
   for (size_t i = 0; i < dists.size(); ++i)
-  {
     means[i] /= (weights[i] > 1) ? weights[i] : 1;
-  }
 
   for (size_t i = 0; i < observations.n_cols; ++i)
   {
     const size_t cluster = assignments[i];
-    const arma::vec normObs = observations.col(i) - means[cluster];
-    covs[cluster] += normObs * normObs.t();
+    covs[cluster] += arma::square(observations.col(i) - means[cluster]);
   }
 
   for (size_t i = 0; i < dists.size(); ++i)
   {
     covs[i] /= (weights[i] > 1) ? weights[i] : 1;
 
-    // Apply constraints to covariance matrix.
+    // Apply constraints to the covariance.
     constraint.ApplyConstraint(covs[i]);
 
+    if (reducer != NULL)
+    {
+      reducer->Broadcast(means[i].memptr(), means[i].n_elem);
+      reducer->Broadcast(covs[i].memptr(), covs[i].n_elem);
+    }
+
     std::swap(dists[i].Mean(), means[i]);
     dists[i].Covariance(std::move(covs[i]));
   }
 
   // Finally, normalize weights.
   weights /= accu(weights);
+  if (reducer != NULL)
+    reducer->Broadcast(weights.memptr(), weights.n_elem);
 }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
-double EMFit<InitialClusteringType, CovarianceConstraintPolicy>::LogLikelihood(
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+double EMFit<InitialClusteringType, CovarianceConstraintPolicy, Distribution>::
+Expectation(
     const arma::mat& observations,
-    const std::vector<distribution::GaussianDistribution>& dists,
-    const arma::vec& weights) const
+    const std::vector<Distribution>& dists,
+    const arma::vec& weights,
+    arma::mat& condProb) const
 {
-  double logLikelihood = 0;
+  condProb.set_size(observations.n_cols, dists.size());
 
-  arma::vec phis;
-  arma::mat likelihoods(dists.size(), observations.n_cols);
+  const size_t numBlocks = (observations.n_cols + BlockSize - 1) / BlockSize;
+  arma::vec blockLogLikelihoods(numBlocks);
+  size_t zeroLikelihoods = 0;
 
-  for (size_t i = 0; i < dists.size(); ++i)
+  #pragma omp parallel for schedule(static) reduction(+:zeroLikelihoods)
+  for (size_t block = 0; block < numBlocks; ++block)
+  {
+    const size_t begin = block * BlockSize;
+    const size_t count = std::min(BlockSize,
+        (size_t) observations.n_cols - begin);
+
+    // An alias of the observations in this block, so that each Gaussian is
+    // evaluated on the whole block with a single call.
+    const arma::mat blockObservations(const_cast<double*>(
+        observations.colptr(begin)), observations.n_rows, count, false, true);
+
+    arma::vec phis;
+    for (size_t i = 0; i < dists.size(); ++i)
+    {
+      dists[i].Probability(blockObservations, phis);
+      condProb.submat(begin, i, begin + count - 1, i) = weights[i] * phis;
+    }
+
+    // Normalize row-wise, and sum the log-likelihood of each point.
+    double logLikelihood = 0.0;
+    for (size_t j = begin; j < begin + count; ++j)
+    {
+      // Avoid dividing by zero; if the probability for everything is 0, we
+      // don't want to make it NaN.
+      const double probSum = accu(condProb.row(j));
+      logLikelihood += log(probSum);
+      if (probSum != 0.0)
+        condProb.row(j) /= probSum;
+      else
+        ++zeroLikelihoods;
+    }
+
+    blockLogLikelihoods[block] = logLikelihood;
+  }
+
+  if (zeroLikelihoods > 0)
+    Log::Info << "Likelihood of " << zeroLikelihoods << " points is 0!  They "
+        << "are probably outliers." << std::endl;
+
+  double logLikelihood = accu(blockLogLikelihoods);
+  if (reducer != NULL)
+    reducer->Sum(&logLikelihood, 1);
+
+  return logLikelihood;
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy, Distribution>::
+UpdateGaussian(const arma::mat& observations,
+               const arma::vec& pointWeights,
+               const double weightSum,
+               distribution::GaussianDistribution& dist)
+{
+  // The weighted mean and covariance are found in one blocked pass, in
+  // parallel if mlpack is compiled with OpenMP.
+  math::CovarianceAccumulator accumulator(observations.n_rows);
+  accumulator.Add(observations, pointWeights);
+  arma::mat covariance;
+  if (reducer == NULL)
   {
-    dists[i].Probability(observations, phis);
-    likelihoods.row(i) = weights(i) * trans(phis);
+    dist.Mean() = accumulator.Mean();
+    covariance = accumulator.Covariance(1);
   }
-  // Now sum over every point.
-  for (size_t j = 0; j < observations.n_cols; ++j)
+  else
   {
-    if (accu(likelihoods.col(j)) == 0)
-      Log::Info << "Likelihood of point " << j << " is 0!  It is probably an "
-          << "outlier." << std::endl;
-    logLikelihood += log(accu(likelihoods.col(j)));
+    // Add up the weighted means of the shards; then the scatter matrix of
+    // each shard is moved to the mean of the whole dataset before the scatter
+    // matrices are added up.
+    dist.Mean() = accumulator.Weight() * accumulator.Mean();
+    reducer->Sum(dist.Mean().memptr(), dist.Mean().n_elem);
+    dist.Mean() /= weightSum;
+
+    const arma::vec shift = accumulator.Mean() - dist.Mean();
+    covariance = accumulator.Scatter() +
+        accumulator.Weight() * (shift * trans(shift));
+    reducer->Sum(covariance.memptr(), covariance.n_elem);
+    covariance /= weightSum;
   }
 
-  return logLikelihood;
+  // Apply covariance constraint.
+  constraint.ApplyConstraint(covariance);
+  dist.Covariance(std::move(covariance));
+}
+
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy, Distribution>::
+UpdateGaussian(const arma::mat& observations,
+               const arma::vec& pointWeights,
+               const double weightSum,
+               distribution::DiagonalGaussianDistribution& dist)
+{
+  dist.Mean() = observations * pointWeights;
+  if (reducer != NULL)
+    reducer->Sum(dist.Mean().memptr(), dist.Mean().n_elem);
+  dist.Mean() /= weightSum;
+  const arma::vec& mean = dist.Mean();
+
+  // The variance of each dimension is the weighted sum of the squared
+  // differences; there are no outer products, so this is linear in the
+  // dimensionality.  Each thread sums its own blocks of observations (inside a
+  // parallel region, for instance when the emissions of the states of an HMM
+  // are estimated in parallel, there is only one).
+  arma::vec covariance = parallel::BlockReduce(observations.n_cols, BlockSize,
+      arma::vec(arma::zeros<arma::vec>(observations.n_rows)),
+      [&](arma::vec& sum, const size_t begin, const size_t end)
+      {
+        arma::mat diffs = observations.cols(begin, end - 1);
+        diffs.each_col() -= mean;
+        sum += arma::square(diffs) * pointWeights.subvec(begin, end - 1);
+      },
+      [](arma::vec& total, const arma::vec& sum) { total += sum; });
+  if (reducer != NULL)
+    reducer->Sum(covariance.memptr(), covariance.n_elem);
+  covariance /= weightSum;
+
+  // Apply covariance constraint.
+  constraint.ApplyConstraint(covariance);
+  dist.Covariance(std::move(covariance));
 }
 
-template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+template<typename InitialClusteringType,
+         typename CovarianceConstraintPolicy,
+         typename Distribution>
 template<typename Archive>
-void EMFit<InitialClusteringType, CovarianceConstraintPolicy>::Serialize(
+void EMFit<InitialClusteringType, CovarianceConstraintPolicy, Distribution>::
+Serialize(
     Archive& ar,
     const unsigned int /* version */)
 {
@@ -10,6 +10,8 @@
 #define __MLPACK_METHODS_MOG_MOG_EM_HPP
 
 #include <mlpack/core.hpp>
+#include <exception>
+#include <sstream>
 
 // This is the default fitting method class.
 #include "em_fit.hpp"
@@ -29,12 +31,12 @@ namespace gmm /** Gaussian Mixture Models. */ {
  *
  * @code
  * void Estimate(const arma::mat& observations,
- *               std::vector<distribution::GaussianDistribution>& dists,
+ *               std::vector<Distribution>& dists,
  *               arma::vec& weights);
  *
  * void Estimate(const arma::mat& observations,
  *               const arma::vec& probabilities,
- *               std::vector<distribution::GaussianDistribution>& dists,
+ *               std::vector<Distribution>& dists,
  *               arma::vec& weights);
  * @endcode
  *
@@ -47,6 +49,12 @@ namespace gmm /** Gaussian Mixture Models. */ {
  * For a sample implementation, see the EMFit class; this class uses the EM
  * algorithm to train a GMM, and is the default fitting type.
  *
+ * The Distribution template parameter is the type of each Gaussian; it is
+ * distribution::GaussianDistribution by default.  For high-dimensional data,
+ * distribution::DiagonalGaussianDistribution (see the DiagonalGMM typedef)
+ * stores only the diagonal of each covariance, so training and evaluation take
+ * O(d) time per point and Gaussian instead of O(d^2).
+ *
  * The GMM, once trained, can be used to generate random points from the
  * distribution and estimate the probability of points being from the
  * distribution.  The parameters of the GMM can be obtained through the
@@ -69,7 +77,8 @@ namespace gmm /** Gaussian Mixture Models. */ {
  * arma::vec observation = g.Random();
  * @endcode
  */
-template<typename FittingType = EMFit<>>
+template<typename FittingType = EMFit<>,
+         typename Distribution = distribution::GaussianDistribution>
 class GMM
 {
  private:
@@ -79,7 +88,7 @@ class GMM
   size_t dimensionality;
 
   //! Vector of Gaussians
-  std::vector<distribution::GaussianDistribution> dists;
+  std::vector<Distribution> dists;
 
   //! Vector of a priori weights for each Gaussian.
   arma::vec weights;
@@ -135,7 +144,7 @@ class GMM
    * @param dists Distributions of the model.
    * @param weights Weights of the model.
    */
-  GMM(const std::vector<distribution::GaussianDistribution> & dists,
+  GMM(const std::vector<Distribution> & dists,
       const arma::vec& weights) :
       gaussians(dists.size()),
       dimensionality((!dists.empty()) ? dists[0].Mean().n_elem : 0),
@@ -153,7 +162,7 @@ class GMM
    * @param covariances Covariances of the model.
    * @param weights Weights of the model.
    */
-  GMM(const std::vector<distribution::GaussianDistribution> & dists,
+  GMM(const std::vector<Distribution> & dists,
       const arma::vec& weights,
       FittingType& fitter) :
       gaussians(dists.size()),
@@ -167,7 +176,7 @@ class GMM
    * Copy constructor for GMMs which use different fitting types.
    */
   template<typename OtherFittingType>
-  GMM(const GMM<OtherFittingType>& other);
+  GMM(const GMM<OtherFittingType, Distribution>& other);
 
   /**
    * Copy constructor for GMMs using the same fitting type.  This also copies
@@ -182,7 +191,7 @@ class GMM
    * Copy operator for GMMs which use different fitting types.
    */
   template<typename OtherFittingType>
-  GMM& operator=(const GMM<OtherFittingType>& other);
+  GMM& operator=(const GMM<OtherFittingType, Distribution>& other);
 
   /**
    * Copy operator for GMMs which use the same fitting type.  This also copies
@@ -207,14 +216,13 @@ class GMM
    *
    * @param i index of component.
    */
-  const distribution::GaussianDistribution& Component(size_t i) const {
-      return dists[i]; }
+  const Distribution& Component(size_t i) const { return dists[i]; }
   /**
    * Return a reference to a component distribution.
    *
    * @param i index of component.
    */
-  distribution::GaussianDistribution& Component(size_t i) { return dists[i]; }
+  Distribution& Component(size_t i) { return dists[i]; }
 
   //! Return a const reference to the a priori weights of each Gaussian.
   const arma::vec& Weights() const { return weights; }
@@ -222,9 +230,9 @@ class GMM
   arma::vec& Weights() { return weights; }
 
   //! Return a const reference to the fitting type.
-  const FittingType& Fitter() const { return fitter; }
+  const FittingType& Fitter() const { return *fitter; }
   //! Return a reference to the fitting type.
-  FittingType& Fitter() { return fitter; }
+  FittingType& Fitter() { return *fitter; }
 
   /**
    * Return the probability that the given observation came from this
@@ -244,6 +252,19 @@ class GMM
   double Probability(const arma::vec& observation,
                      const size_t component) const;
 
+  /**
+   * Calculate the log-probability of each observation (column) in the given
+   * matrix being from this distribution.  Each component is evaluated on all
+   * of the observations at once, and the mixture is summed with the largest
+   * term factored out, so that points far from every component do not
+   * underflow.
+   *
+   * @param observations Observations to evaluate the log-probability of.
+   * @param logProbabilities Output log-probability of each observation.
+   */
+  void LogProbability(const arma::mat& observations,
+                      arma::vec& logProbabilities) const;
+
   /**
    * Return a randomly generated observation according to the probability
    * distribution defined by this object.
@@ -259,6 +280,10 @@ class GMM
    * The fitting will be performed 'trials' times; from these trials, the model
    * with the greatest log-likelihood will be selected.  By default, only one
    * trial is performed.  The log-likelihood of the best fitting is returned.
+   * Several trials are run in parallel, each with its own copy of the fitter
+   * and its own random stream (see math::ScopedRandomStream), so the result
+   * does not depend on the number of threads; their Log::Info output is muted
+   * while they run, and the fitter of the best trial is kept.
    *
    * Optionally, the existing model can be used as an initial model for the
    * estimation by setting 'useExistingModel' to true.  If the fitting procedure
@@ -287,6 +312,10 @@ class GMM
    * The fitting will be performed 'trials' times; from these trials, the model
    * with the greatest log-likelihood will be selected.  By default, only one
    * trial is performed.  The log-likelihood of the best fitting is returned.
+   * Several trials are run in parallel, each with its own copy of the fitter
+   * and its own random stream (see math::ScopedRandomStream), so the result
+   * does not depend on the number of threads; their Log::Info output is muted
+   * while they run, and the fitter of the best trial is kept.
    *
    * Optionally, the existing model can be used as an initial model for the
    * estimation by setting 'useExistingModel' to true.  If the fitting procedure
@@ -349,10 +378,36 @@ class GMM
    */
   double LogLikelihood(
       const arma::mat& dataPoints,
-      const std::vector<distribution::GaussianDistribution>& distsL,
+      const std::vector<Distribution>& distsL,
       const arma::vec& weights) const;
+
+  /**
+   * Run the given number of trials (at least two) of the fitter in parallel,
+   * and keep the model with the greatest log-likelihood.  This is used by
+   * GMM::Estimate().
+   *
+   * @param observations Observations of the model.
+   * @param probabilities Probability of each observation being from this
+   *     distribution, or NULL if every observation is.
+   * @param trials Number of trials to perform.
+   * @param useExistingModel If true, the existing model is used as an initial
+   *     model for each trial.
+   * @return The log-likelihood of the best fit.
+   */
+  double EstimateTrials(const arma::mat& observations,
+                        const arma::vec* probabilities,
+                        const size_t trials,
+                        const bool useExistingModel);
 };
 
+/**
+ * A GMM whose Gaussians have diagonal covariance matrices, trained with EM.
+ */
+typedef GMM<EMFit<kmeans::KMeans<>,
+                  PositiveDefiniteConstraint,
+                  distribution::DiagonalGaussianDistribution>,
+            distribution::DiagonalGaussianDistribution> DiagonalGMM;
+
 }; // namespace gmm
 }; // namespace mlpack
 
@@ -22,11 +22,12 @@ namespace gmm {
  * @param gaussians Number of Gaussians in this GMM.
  * @param dimensionality Dimensionality of each Gaussian.
  */
-template<typename FittingType>
-GMM<FittingType>::GMM(const size_t gaussians, const size_t dimensionality) :
+template<typename FittingType, typename Distribution>
+GMM<FittingType, Distribution>::GMM(const size_t gaussians,
+                                    const size_t dimensionality) :
     gaussians(gaussians),
     dimensionality(dimensionality),
-    dists(gaussians, distribution::GaussianDistribution(dimensionality)),
+    dists(gaussians, Distribution(dimensionality)),
     weights(gaussians),
     fitter(new FittingType()),
     ownsFitter(true)
@@ -45,13 +46,13 @@ GMM<FittingType>::GMM(const size_t gaussians, const size_t dimensionality) :
  * @param dimensionality Dimensionality of each Gaussian.
  * @param fitter Initialized fitting mechanism.
  */
-template<typename FittingType>
-GMM<FittingType>::GMM(const size_t gaussians,
-                      const size_t dimensionality,
-                      FittingType& fitter) :
+template<typename FittingType, typename Distribution>
+GMM<FittingType, Distribution>::GMM(const size_t gaussians,
+                                    const size_t dimensionality,
+                                    FittingType& fitter) :
     gaussians(gaussians),
     dimensionality(dimensionality),
-    dists(gaussians, distribution::GaussianDistribution(dimensionality)),
+    dists(gaussians, Distribution(dimensionality)),
     weights(gaussians),
     fitter(&fitter),
     ownsFitter(false)
@@ -62,9 +63,10 @@ GMM<FittingType>::GMM(const size_t gaussians,
 
 
 // Copy constructor.
-template<typename FittingType>
+template<typename FittingType, typename Distribution>
 template<typename OtherFittingType>
-GMM<FittingType>::GMM(const GMM<OtherFittingType>& other) :
+GMM<FittingType, Distribution>::GMM(
+    const GMM<OtherFittingType, Distribution>& other) :
     gaussians(other.gaussians),
     dimensionality(other.dimensionality),
     dists(other.dists),
@@ -73,8 +75,9 @@ GMM<FittingType>::GMM(const GMM<OtherFittingType>& other) :
     ownsFitter(true) { /* Nothing to do. */ }
 
 // Copy constructor for when the other GMM uses the same fitting type.
-template<typename FittingType>
-GMM<FittingType>::GMM(const GMM<FittingType>& other) :
+template<typename FittingType, typename Distribution>
+GMM<FittingType, Distribution>::GMM(
+    const GMM<FittingType, Distribution>& other) :
     gaussians(other.Gaussians()),
     dimensionality(other.dimensionality),
     dists(other.dists),
@@ -82,17 +85,17 @@ GMM<FittingType>::GMM(const GMM<FittingType>& other) :
     fitter(new FittingType(*other.fitter)),
     ownsFitter(true) { /* Nothing to do. */ }
 
-template<typename FittingType>
-GMM<FittingType>::~GMM()
+template<typename FittingType, typename Distribution>
+GMM<FittingType, Distribution>::~GMM()
 {
   if (ownsFitter)
     delete fitter;
 }
 
-template<typename FittingType>
+template<typename FittingType, typename Distribution>
 template<typename OtherFittingType>
-GMM<FittingType>& GMM<FittingType>::operator=(
-    const GMM<OtherFittingType>& other)
+GMM<FittingType, Distribution>& GMM<FittingType, Distribution>::operator=(
+    const GMM<OtherFittingType, Distribution>& other)
 {
   gaussians = other.gaussians;
   dimensionality = other.dimensionality;
@@ -102,8 +105,9 @@ GMM<FittingType>& GMM<FittingType>::operator=(
   return *this;
 }
 
-template<typename FittingType>
-GMM<FittingType>& GMM<FittingType>::operator=(const GMM<FittingType>& other)
+template<typename FittingType, typename Distribution>
+GMM<FittingType, Distribution>& GMM<FittingType, Distribution>::operator=(
+    const GMM<FittingType, Distribution>& other)
 {
   gaussians = other.gaussians;
   dimensionality = other.dimensionality;
@@ -121,8 +125,9 @@ GMM<FittingType>& GMM<FittingType>::operator=(const GMM<FittingType>& other)
 /**
  * Return the probability of the given observation being from this GMM.
  */
-template<typename FittingType>
-double GMM<FittingType>::Probability(const arma::vec& observation) const
+template<typename FittingType, typename Distribution>
+double GMM<FittingType, Distribution>::Probability(
+    const arma::vec& observation) const
 {
   // Sum the probability for each Gaussian in our mixture (and we have to
   // multiply by the prior for each Gaussian too).
@@ -137,21 +142,52 @@ double GMM<FittingType>::Probability(const arma::vec& observation) const
  * Return the probability of the given observation being from the given
  * component in the mixture.
  */
-template<typename FittingType>
-double GMM<FittingType>::Probability(const arma::vec& observation,
-                                     const size_t component) const
+template<typename FittingType, typename Distribution>
+double GMM<FittingType, Distribution>::Probability(const arma::vec& observation,
+                                                   const size_t component) const
 {
   // We are only considering one Gaussian component -- so we only need to call
   // Probability() once.  We do consider the prior probability!
   return weights[component] * dists[component].Probability(observation);
 }
 
+/**
+ * Return the log-probability of each of the given observations being from this
+ * GMM.
+ */
+template<typename FittingType, typename Distribution>
+void GMM<FittingType, Distribution>::LogProbability(
+    const arma::mat& observations,
+    arma::vec& logProbabilities) const
+{
+  // Row i holds log(w_i) + log p_i(x) for each point x.
+  arma::mat logComponents(gaussians, observations.n_cols);
+  arma::vec componentLogProbs;
+  for (size_t i = 0; i < gaussians; ++i)
+  {
+    dists[i].LogProbability(observations, componentLogProbs);
+    logComponents.row(i) = trans(componentLogProbs) + std::log(weights[i]);
+  }
+
+  // Now sum each column with log-sum-exp.
+  logProbabilities.set_size(observations.n_cols);
+  for (size_t j = 0; j < observations.n_cols; ++j)
+  {
+    const double maxLogProb = logComponents.col(j).max();
+    if (maxLogProb == -std::numeric_limits<double>::infinity())
+      logProbabilities[j] = maxLogProb;
+    else
+      logProbabilities[j] = maxLogProb +
+          std::log(accu(arma::exp(logComponents.col(j) - maxLogProb)));
+  }
+}
+
 /**
  * Return a randomly generated observation according to the probability
  * distribution defined by this object.
  */
-template<typename FittingType>
-arma::vec GMM<FittingType>::Random() const
+template<typename FittingType, typename Distribution>
+arma::vec GMM<FittingType, Distribution>::Random() const
 {
   // Determine which Gaussian it will be coming from.
   double gaussRand = math::Random();
@@ -168,17 +204,16 @@ arma::vec GMM<FittingType>::Random() const
     }
   }
 
-  return trans(chol(dists[gaussian].Covariance())) *
-      arma::randn<arma::vec>(dimensionality) + dists[gaussian].Mean();
+  return dists[gaussian].Random();
 }
 
 /**
  * Fit the GMM to the given observations.
  */
-template<typename FittingType>
-double GMM<FittingType>::Estimate(const arma::mat& observations,
-                                  const size_t trials,
-                                  const bool useExistingModel)
+template<typename FittingType, typename Distribution>
+double GMM<FittingType, Distribution>::Estimate(const arma::mat& observations,
+                                                const size_t trials,
+                                                const bool useExistingModel)
 {
   double bestLikelihood; // This will be reported later.
 
@@ -191,62 +226,14 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
         useExistingModel);
     bestLikelihood = LogLikelihood(observations, dists, weights);
   }
+  else if (trials == 0)
+  {
+    return -DBL_MAX; // It's what they asked for...
+  }
   else
   {
-    if (trials == 0)
-      return -DBL_MAX; // It's what they asked for...
-
-    // If each trial must start from the same initial location, we must save it.
-    std::vector<distribution::GaussianDistribution> distsOrig;
-    arma::vec weightsOrig;
-    if (useExistingModel)
-    {
-      distsOrig = dists;
-      weightsOrig = weights;
-    }
-
-    // We need to keep temporary copies.  We'll do the first training into the
-    // actual model position, so that if it's the best we don't need to copy it.
-    fitter->Estimate(observations, dists, weights,
+    bestLikelihood = EstimateTrials(observations, NULL, trials,
         useExistingModel);
-
-    bestLikelihood = LogLikelihood(observations, dists, weights);
-
-    Log::Info << "GMM::Estimate(): Log-likelihood of trial 0 is "
-        << bestLikelihood << "." << std::endl;
-
-    // Now the temporary model.
-    std::vector<distribution::GaussianDistribution> distsTrial(gaussians,
-        distribution::GaussianDistribution(dimensionality));
-    arma::vec weightsTrial(gaussians);
-
-    for (size_t trial = 1; trial < trials; ++trial)
-    {
-      if (useExistingModel)
-      {
-        distsTrial = distsOrig;
-        weightsTrial = weightsOrig;
-      }
-
-      fitter->Estimate(observations, distsTrial, weightsTrial,
-          useExistingModel);
-
-      // Check to see if the log-likelihood of this one is better.
-      double newLikelihood = LogLikelihood(observations, distsTrial,
-          weightsTrial);
-
-      Log::Info << "GMM::Estimate(): Log-likelihood of trial " << trial
-          << " is " << newLikelihood << "." << std::endl;
-
-      if (newLikelihood > bestLikelihood)
-      {
-        // Save new likelihood and copy new model.
-        bestLikelihood = newLikelihood;
-
-        dists = distsTrial;
-        weights = weightsTrial;
-      }
-    }
   }
 
   // Report final log-likelihood and return it.
@@ -259,11 +246,11 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
  * Fit the GMM to the given observations, each of which has a certain
  * probability of being from this distribution.
  */
-template<typename FittingType>
-double GMM<FittingType>::Estimate(const arma::mat& observations,
-                                  const arma::vec& probabilities,
-                                  const size_t trials,
-                                  const bool useExistingModel)
+template<typename FittingType, typename Distribution>
+double GMM<FittingType, Distribution>::Estimate(const arma::mat& observations,
+                                                const arma::vec& probabilities,
+                                                const size_t trials,
+                                                const bool useExistingModel)
 {
   double bestLikelihood; // This will be reported later.
 
@@ -276,67 +263,93 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
         useExistingModel);
     bestLikelihood = LogLikelihood(observations, dists, weights);
   }
+  else if (trials == 0)
+  {
+    return -DBL_MAX; // It's what they asked for...
+  }
   else
   {
-    if (trials == 0)
-      return -DBL_MAX; // It's what they asked for...
-
-    // If each trial must start from the same initial location, we must save it.
-    std::vector<distribution::GaussianDistribution> distsOrig;
-    arma::vec weightsOrig;
-    if (useExistingModel)
-    {
-      distsOrig = dists;
-      weightsOrig = weights;
-    }
-
-    // We need to keep temporary copies.  We'll do the first training into the
-    // actual model position, so that if it's the best we don't need to copy it.
-    fitter->Estimate(observations, probabilities, dists, weights,
+    bestLikelihood = EstimateTrials(observations, &probabilities, trials,
         useExistingModel);
+  }
 
-    bestLikelihood = LogLikelihood(observations, dists, weights);
-
-    Log::Debug << "GMM::Estimate(): Log-likelihood of trial 0 is "
-        << bestLikelihood << "." << std::endl;
+  // Report final log-likelihood and return it.
+  Log::Info << "GMM::Estimate(): log-likelihood of trained GMM is "
+      << bestLikelihood << "." << std::endl;
+  return bestLikelihood;
+}
 
-    // Now the temporary model.
-    std::vector<distribution::GaussianDistribution> distsTrial(gaussians,
-        distribution::GaussianDistribution(dimensionality));
-    arma::vec weightsTrial(gaussians);
+/**
+ * Run several trials of the fitter in parallel, and keep the best model.
+ */
+template<typename FittingType, typename Distribution>
+double GMM<FittingType, Distribution>::EstimateTrials(
+    const arma::mat& observations,
+    const arma::vec* probabilities,
+    const size_t trials,
+    const bool useExistingModel)
+{
+  // Each trial starts from a copy of the current model (which is only used if
+  // useExistingModel is true) and of the fitter, and gets its own random
+  // stream, so that the trials are independent and do not depend on how they
+  // are scheduled.  Log::Info is not thread-safe, so the trials are quiet
+  // while they run; the warnings and errors of each trial are kept and
+  // reported in order afterwards.
+  std::vector<std::vector<Distribution> > distsTrial(trials, dists);
+  std::vector<arma::vec> weightsTrial(trials, weights);
+  std::vector<FittingType> fittersTrial(trials, *fitter);
+  arma::vec likelihoods(trials);
+  std::vector<std::ostringstream> warnings(trials);
+  std::vector<std::exception_ptr> errors(trials);
+  const math::RandomStream stream = math::NewRandomStream();
+  {
+    util::ScopedLogMute mute(Log::Info);
 
-    for (size_t trial = 1; trial < trials; ++trial)
+    #pragma omp parallel for schedule(dynamic, 1)
+    for (size_t trial = 0; trial < trials; ++trial)
     {
-      if (useExistingModel)
+      // An exception can't leave the parallel loop.
+      try
       {
-        distsTrial = distsOrig;
-        weightsTrial = weightsOrig;
+        math::RandomStream trialStream = stream.Split(trial);
+        math::ScopedRandomStream scope(trialStream);
+        util::ScopedLogCapture capture(Log::Warn, warnings[trial]);
+
+        if (probabilities == NULL)
+          fittersTrial[trial].Estimate(observations, distsTrial[trial],
+              weightsTrial[trial], useExistingModel);
+        else
+          fittersTrial[trial].Estimate(observations, *probabilities,
+              distsTrial[trial], weightsTrial[trial], useExistingModel);
+
+        likelihoods[trial] = LogLikelihood(observations, distsTrial[trial],
+            weightsTrial[trial]);
       }
-
-      fitter->Estimate(observations, distsTrial, weightsTrial,
-          useExistingModel);
-
-      // Check to see if the log-likelihood of this one is better.
-      double newLikelihood = LogLikelihood(observations, distsTrial,
-          weightsTrial);
-
-      Log::Debug << "GMM::Estimate(): Log-likelihood of trial " << trial
-          << " is " << newLikelihood << "." << std::endl;
-
-      if (newLikelihood > bestLikelihood)
+      catch (...)
       {
-        // Save new likelihood and copy new model.
-        bestLikelihood = newLikelihood;
-
-        dists = distsTrial;
-        weights = weightsTrial;
+        errors[trial] = std::current_exception();
       }
     }
   }
 
-  // Report final log-likelihood and return it.
-  Log::Info << "GMM::Estimate(): log-likelihood of trained GMM is "
-      << bestLikelihood << "." << std::endl;
+  for (size_t trial = 0; trial < trials; ++trial)
+    if (!warnings[trial].str().empty())
+      Log::Warn << warnings[trial].str();
+  for (size_t trial = 0; trial < trials; ++trial)
+    if (errors[trial])
+      std::rethrow_exception(errors[trial]);
+
+  for (size_t trial = 0; trial < trials; ++trial)
+    Log::Info << "GMM::Estimate(): Log-likelihood of trial " << trial
+        << " is " << likelihoods[trial] << "." << std::endl;
+
+  // Keep the best model, and the fitter that found it.
+  arma::uword best;
+  const double bestLikelihood = likelihoods.max(best);
+  dists = distsTrial[best];
+  weights = weightsTrial[best];
+  *fitter = fittersTrial[best];
+
   return bestLikelihood;
 }
 
@@ -344,25 +357,28 @@ double GMM<FittingType>::Estimate(const arma::mat& observations,
  * Classify the given observations as being from an individual component in this
  * GMM.
  */
-template<typename FittingType>
-void GMM<FittingType>::Classify(const arma::mat& observations,
-                                arma::Col<size_t>& labels) const
+template<typename FittingType, typename Distribution>
+void GMM<FittingType, Distribution>::Classify(const arma::mat& observations,
+                                              arma::Col<size_t>& labels) const
 {
-  // This is not the best way to do this!
-
-  // We should not have to fill this with values, because each one should be
-  // overwritten.
-  labels.set_size(observations.n_cols);
-  for (size_t i = 0; i < observations.n_cols; ++i)
+  // Each component is evaluated on all of the observations at once, and the
+  // comparison is done in log space, so that points far from every component
+  // (whose probabilities would underflow) are still classified correctly.
+  labels.zeros(observations.n_cols);
+  arma::vec bestLogProbs(observations.n_cols);
+  bestLogProbs.fill(-std::numeric_limits<double>::infinity());
+
+  arma::vec logProbs;
+  for (size_t j = 0; j < gaussians; ++j)
   {
-    // Find maximum probability component.
-    double probability = 0;
-    for (size_t j = 0; j < gaussians; ++j)
+    dists[j].LogProbability(observations, logProbs);
+    logProbs += std::log(weights[j]);
+
+    for (size_t i = 0; i < observations.n_cols; ++i)
     {
-      double newProb = Probability(observations.unsafe_col(i), j);
-      if (newProb >= probability)
+      if (logProbs[i] >= bestLogProbs[i])
       {
-        probability = newProb;
+        bestLogProbs[i] = logProbs[i];
         labels[i] = j;
       }
     }
@@ -372,10 +388,10 @@ void GMM<FittingType>::Classify(const arma::mat& observations,
 /**
  * Get the log-likelihood of this data's fit to the model.
  */
-template<typename FittingType>
-double GMM<FittingType>::LogLikelihood(
+template<typename FittingType, typename Distribution>
+double GMM<FittingType, Distribution>::LogLikelihood(
     const arma::mat& data,
-    const std::vector<distribution::GaussianDistribution>& distsL,
+    const std::vector<Distribution>& distsL,
     const arma::vec& weightsL) const
 {
   double loglikelihood = 0;
@@ -397,8 +413,8 @@ double GMM<FittingType>::LogLikelihood(
 /**
 * Returns a string representation of this object.
 */
-template<typename FittingType>
-std::string GMM<FittingType>::ToString() const
+template<typename FittingType, typename Distribution>
+std::string GMM<FittingType, Distribution>::ToString() const
 {
   std::ostringstream convert;
   std::ostringstream data;
@@ -426,9 +442,11 @@ std::string GMM<FittingType>::ToString() const
 /**
  * Serialize the object.
  */
-template<typename FittingType>
+template<typename FittingType, typename Distribution>
 template<typename Archive>
-void GMM<FittingType>::Serialize(Archive& ar, const unsigned int /* version */)
+void GMM<FittingType, Distribution>::Serialize(
+    Archive& ar,
+    const unsigned int /* version */)
 {
   using data::CreateNVP;
 
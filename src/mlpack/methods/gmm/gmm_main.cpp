@@ -8,10 +8,16 @@
 
 #include "gmm.hpp"
 #include "no_constraint.hpp"
+#include "online_em_fit.hpp"
 #include "gmm_util.hpp"
 
 #include <mlpack/methods/kmeans/refined_start.hpp>
 
+#ifdef MLPACK_USE_MPI
+  #include <memory>
+  #include <mlpack/core/math/mpi_reducer.hpp>
+#endif
+
 using namespace mlpack;
 using namespace mlpack::gmm;
 using namespace mlpack::util;
@@ -35,13 +41,32 @@ PROGRAM_INFO("Gaussian Mixture Model (GMM) Training",
     "iteration of the EM algorithm which ensure that the covariance matrices "
     "are positive definite.  Specifying the flag can cause faster runtime, "
     "but may also cause non-positive definite covariance matrices, which will "
-    "cause the program to crash.");
+    "cause the program to crash."
+    "\n\n"
+    "If the 'online' flag is given, the GMM is trained with online (stepwise) "
+    "EM: the data is processed in mini-batches of size 'batch_size', and the "
+    "model is updated after each mini-batch with a step size that decays as "
+    "(2 + t)^(-step_power), where t is the number of mini-batches seen.  A "
+    "GMM saved by an earlier online run can be given with 'input_model_file' so"
+    " that training carries on from it with new data.  The 'no_force_positive'"
+    " flag must match the earlier run."
+    "\n\n"
+    "If mlpack was built with MPI, the 'distributed' flag fits a GMM to a "
+    "dataset that is split into one file per process (run with mpirun): each "
+    "'%r' in 'input_file' is replaced with the rank of the process, and the "
+    "sums of each EM iteration are added up over the processes, so that the "
+    "model is that of the whole dataset.  The model is saved by rank 0 only, "
+    "and the log-likelihood it reports is that of its own shard.  Only one "
+    "trial is done, and 'online' is not available.");
 
 PARAM_STRING_REQ("input_file", "File containing the data on which the model "
     "will be fit.", "i");
 PARAM_INT("gaussians", "Number of Gaussians in the GMM.", "g", 1);
 PARAM_STRING("output_file", "The file to write the trained GMM parameters "
     "into.", "o", "gmm.xml");
+PARAM_STRING("input_model_file", "File containing a GMM saved by an earlier "
+    "run with --online, to continue training from (requires --online).", "m",
+    "");
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 PARAM_INT("trials", "Number of trials to perform in training GMM.", "t", 10);
 
@@ -52,7 +77,18 @@ PARAM_FLAG("no_force_positive", "Do not force the covariance matrices to be "
 PARAM_INT("max_iterations", "Maximum number of iterations of EM algorithm "
     "(passing 0 will run until convergence).", "n", 250);
 
+// Parameters for online EM.
+PARAM_FLAG("online", "Train with online EM on mini-batches of the data.", "O");
+PARAM_INT("batch_size", "If using --online, the number of points in each "
+    "mini-batch.", "b", 1000);
+PARAM_DOUBLE("step_power", "If using --online, the power of the step size "
+    "schedule (must be in (0.5, 1]).", "k", 0.6);
+
 // Parameters for dataset modification.
+PARAM_FLAG("distributed", "Fit the GMM to a dataset that is split across MPI "
+    "processes, one file per process (only if mlpack was built with MPI).",
+    "D");
+
 PARAM_DOUBLE("noise", "Variance of zero-mean Gaussian noise to add to data.",
     "N", 0);
 
@@ -65,10 +101,81 @@ PARAM_DOUBLE("percentage", "If using --refined_start, specify the percentage of"
     " the dataset used for each sampling (should be between 0.0 and 1.0).",
     "p", 0.02);
 
+// Train a GMM with online EM, carrying on from --input_model_file if it was
+// given, and save it.  Returns the log-likelihood of the model.
+template<typename CovarianceConstraintPolicy>
+double TrainOnline(const arma::mat& dataPoints, const size_t gaussians)
+{
+  typedef OnlineEMFit<KMeans<>, CovarianceConstraintPolicy> FitterType;
+
+  GMM<FitterType> gmm(gaussians, dataPoints.n_rows);
+  const bool useExistingModel = CLI::HasParam("input_model_file");
+  if (useExistingModel)
+  {
+    const string inputModelFile = CLI::GetParam<string>("input_model_file");
+    data::Load(inputModelFile, "gmm", gmm, true); // Fatal on failure.
+
+    if (gmm.Dimensionality() != dataPoints.n_rows)
+      Log::Fatal << "Model in '" << inputModelFile << "' has dimensionality "
+          << gmm.Dimensionality() << ", but the data has dimensionality "
+          << dataPoints.n_rows << "!" << endl;
+
+    Log::Info << "Loaded GMM with " << gmm.Gaussians() << " Gaussians from '"
+        << inputModelFile << "' (" << gmm.Fitter().Steps() << " mini-batches "
+        << "seen so far)." << endl;
+  }
+
+  // The parameters given on the command line override those of a loaded
+  // model.
+  if (!useExistingModel || CLI::HasParam("batch_size"))
+    gmm.Fitter().BatchSize() = (size_t) CLI::GetParam<int>("batch_size");
+  if (!useExistingModel || CLI::HasParam("step_power"))
+    gmm.Fitter().StepPower() = CLI::GetParam<double>("step_power");
+
+  Timer::Start("em");
+  const double likelihood = gmm.Estimate(dataPoints, 1, useExistingModel);
+  Timer::Stop("em");
+
+  SaveGMM(gmm, CLI::GetParam<string>("output_file"));
+  return likelihood;
+}
+
+// With --distributed, the reducer of the sums of each process; otherwise NULL.
+math::Reducer* reducer = NULL;
+// Whether this process saves the model.
+bool saveModel = true;
+
 int main(int argc, char* argv[])
 {
   CLI::ParseCommandLine(argc, argv);
 
+#ifdef MLPACK_USE_MPI
+  std::unique_ptr<math::MPISession> session;
+  std::unique_ptr<math::MPIReducer> mpiReducer;
+  if (CLI::HasParam("distributed"))
+  {
+    session.reset(new math::MPISession());
+    mpiReducer.reset(new math::MPIReducer());
+    reducer = mpiReducer.get();
+    saveModel = session->Root();
+
+    // Each process reads its own shard, and only rank 0 talks.
+    CLI::GetParam<string>("input_file") =
+        session->RankFileName(CLI::GetParam<string>("input_file"));
+    if (!session->Root())
+      Log::Info.ignoreInput = true;
+
+    if (CLI::HasParam("online"))
+      Log::Fatal << "--online cannot be used with --distributed." << endl;
+    if (CLI::HasParam("trials") && CLI::GetParam<int>("trials") > 1)
+      Log::Fatal << "Only one trial can be done with --distributed." << endl;
+  }
+#else
+  if (CLI::HasParam("distributed"))
+    Log::Fatal << "--distributed can only be used if mlpack was built with "
+        << "MPI." << endl;
+#endif
+
   // Check parameters and load data.
   if (CLI::GetParam<int>("seed") != 0)
     math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
@@ -101,11 +208,39 @@ int main(int argc, char* argv[])
   const size_t maxIterations = (size_t) CLI::GetParam<int>("max_iterations");
   const double tolerance = CLI::GetParam<double>("tolerance");
   const bool forcePositive = !CLI::HasParam("no_force_positive");
+  const int trials = (reducer == NULL) ? CLI::GetParam<int>("trials") : 1;
+
+  if (CLI::HasParam("input_model_file") && !CLI::HasParam("online"))
+    Log::Fatal << "--input_model_file can only be used with --online." << endl;
 
   // This gets a bit weird because we need different types depending on whether
   // --refined_start is specified.
   double likelihood;
-  if (CLI::HasParam("refined_start"))
+  if (CLI::HasParam("online"))
+  {
+    if (CLI::HasParam("refined_start"))
+      Log::Fatal << "--refined_start cannot be used with --online." << endl;
+    if (CLI::HasParam("trials"))
+      Log::Warn << "--trials is ignored with --online; only one trial is done."
+          << endl;
+
+    const int batchSize = CLI::GetParam<int>("batch_size");
+    if (batchSize <= 0)
+      Log::Fatal << "Invalid batch size (" << batchSize << "); must be greater "
+          << "than 0." << endl;
+
+    const double stepPower = CLI::GetParam<double>("step_power");
+    if (stepPower <= 0.5 || stepPower > 1.0)
+      Log::Fatal << "Invalid step power (" << stepPower << "); must be in "
+          << "(0.5, 1]." << endl;
+
+    if (forcePositive)
+      likelihood = TrainOnline<PositiveDefiniteConstraint>(dataPoints,
+          size_t(gaussians));
+    else
+      likelihood = TrainOnline<NoConstraint>(dataPoints, size_t(gaussians));
+  }
+  else if (CLI::HasParam("refined_start"))
   {
     const int samplings = CLI::GetParam<int>("samplings");
     const double percentage = CLI::GetParam<double>("percentage");
@@ -129,33 +264,37 @@ int main(int argc, char* argv[])
     if (forcePositive)
     {
       EMFit<KMeansType> em(maxIterations, tolerance, k);
+      em.Reducer() = reducer;
 
       GMM<EMFit<KMeansType> > gmm(size_t(gaussians), dataPoints.n_rows, em);
 
       // Compute the parameters of the model using the EM algorithm.
       Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
+      likelihood = gmm.Estimate(dataPoints, trials);
       Timer::Stop("em");
 
       // Save results.
       const string outputFile = CLI::GetParam<string>("output_file");
-      SaveGMM(gmm, outputFile);
+      if (saveModel)
+        SaveGMM(gmm, outputFile);
     }
     else
     {
       EMFit<KMeansType, NoConstraint> em(maxIterations, tolerance, k);
+      em.Reducer() = reducer;
 
       GMM<EMFit<KMeansType, NoConstraint> > gmm(size_t(gaussians),
           dataPoints.n_rows, em);
 
       // Compute the parameters of the model using the EM algorithm.
       Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
+      likelihood = gmm.Estimate(dataPoints, trials);
       Timer::Stop("em");
 
       // Save results.
       const string outputFile = CLI::GetParam<string>("output_file");
-      SaveGMM(gmm, outputFile);
+      if (saveModel)
+        SaveGMM(gmm, outputFile);
     }
   }
   else
@@ -164,23 +303,26 @@ int main(int argc, char* argv[])
     if (forcePositive)
     {
       EMFit<> em(maxIterations, tolerance);
+      em.Reducer() = reducer;
 
       // Calculate mixture of Gaussians.
       GMM<> gmm(size_t(gaussians), dataPoints.n_rows, em);
 
       // Compute the parameters of the model using the EM algorithm.
       Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
+      likelihood = gmm.Estimate(dataPoints, trials);
       Timer::Stop("em");
 
       // Save results.
       const string outputFile = CLI::GetParam<string>("output_file");
-      SaveGMM(gmm, outputFile);
+      if (saveModel)
+        SaveGMM(gmm, outputFile);
     }
     else
     {
       // Use no constraints on the covariance matrix.
       EMFit<KMeans<>, NoConstraint> em(maxIterations, tolerance);
+      em.Reducer() = reducer;
 
       // Calculate mixture of Gaussians.
       GMM<EMFit<KMeans<>, NoConstraint> > gmm(size_t(gaussians),
@@ -188,12 +330,13 @@ int main(int argc, char* argv[])
 
       // Compute the parameters of the model using the EM algorithm.
       Timer::Start("em");
-      likelihood = gmm.Estimate(dataPoints, CLI::GetParam<int>("trials"));
+      likelihood = gmm.Estimate(dataPoints, trials);
       Timer::Stop("em");
 
       // Save results.
       const string outputFile = CLI::GetParam<string>("output_file");
-      SaveGMM(gmm, outputFile);
+      if (saveModel)
+        SaveGMM(gmm, outputFile);
     }
   }
 
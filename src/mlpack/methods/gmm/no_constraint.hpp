@@ -23,6 +23,9 @@ class NoConstraint
   //! Do nothing, and do not modify the covariance matrix.
   static void ApplyConstraint(const arma::mat& /* covariance */) { }
 
+  //! Do nothing, and do not modify the diagonal covariance.
+  static void ApplyConstraint(const arma::vec& /* diagonalCovariance */) { }
+
   //! Serialize the object (nothing to do).
   template<typename Archive>
   static void Serialize(Archive& /* ar */, const unsigned int /* version */) { }
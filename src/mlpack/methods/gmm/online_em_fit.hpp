@@ -0,0 +1,219 @@
+/**
+ * @file online_em_fit.hpp
+ * @author Ryan Curtin
+ *
+ * Utility class to fit a GMM with online (stepwise) EM on mini-batches of the
+ * observations.  Used by GMM::Estimate<>().
+ */
+#ifndef __MLPACK_METHODS_GMM_ONLINE_EM_FIT_HPP
+#define __MLPACK_METHODS_GMM_ONLINE_EM_FIT_HPP
+
+#include <mlpack/core.hpp>
+
+// Used for the initial model.
+#include "em_fit.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+/**
+ * This class fits a GMM to observations with the online (stepwise) EM
+ * algorithm.  Instead of running the E-step and M-step on the whole dataset at
+ * each iteration, the observations are processed in mini-batches.  Each
+ * mini-batch gives estimates of the sufficient statistics of the model (the
+ * responsibilities of each Gaussian, and the weighted first and second
+ * moments).  These are blended into running statistics with the step size
+ *
+ *   rho_t = (stepOffset + t)^(-stepPower),
+ *
+ * where t is the number of mini-batches seen so far, and then the model is
+ * recomputed from the running statistics.  For the iterates to converge,
+ * stepPower should be in (0.5, 1].  For more information, see the following
+ * paper:
+ *
+ * @code
+ * @article{cappe2009online,
+ *   title={On-line expectation-maximization algorithm for latent data models},
+ *   author={Capp{\'e}, O. and Moulines, E.},
+ *   journal={Journal of the Royal Statistical Society: Series B (Statistical
+ *       Methodology)},
+ *   volume={71},
+ *   number={3},
+ *   pages={593--613},
+ *   year={2009}
+ * }
+ * @endcode
+ *
+ * Each call to Estimate() makes the given number of passes over the
+ * observations.  If useInitialModel is true, the running statistics are
+ * computed from the given model, so that training can carry on from a model
+ * that was saved: a stream of data can be given to Estimate() one chunk at a
+ * time.  The number of mini-batches seen is kept in this object (and
+ * serialized with it), so the step size keeps decreasing across calls.
+ * Because of that, GMM::Estimate() should be called with only one trial.
+ *
+ * The initial model, when useInitialModel is false, is found in the same way
+ * as EMFit finds it, with the InitialClusteringType.  The
+ * CovarianceConstraintPolicy is applied to each covariance each time the model
+ * is recomputed.
+ */
+template<typename InitialClusteringType = kmeans::KMeans<>,
+         typename CovarianceConstraintPolicy = PositiveDefiniteConstraint>
+class OnlineEMFit
+{
+ public:
+  /**
+   * Construct the OnlineEMFit object.
+   *
+   * @param batchSize Number of observations in each mini-batch.
+   * @param passes Number of passes over the observations in each call to
+   *     Estimate().
+   * @param stepPower Power of the step size schedule; must be in (0.5, 1].
+   * @param stepOffset Offset of the step size schedule; must be positive.
+   * @param clusterer Object which will perform the initial clustering.
+   * @param constraint Object which applies constraints to the covariances.
+   */
+  OnlineEMFit(const size_t batchSize = 1000,
+              const size_t passes = 1,
+              const double stepPower = 0.6,
+              const double stepOffset = 2.0,
+              InitialClusteringType clusterer = InitialClusteringType(),
+              CovarianceConstraintPolicy constraint =
+                  CovarianceConstraintPolicy());
+
+  /**
+   * Fit the observations to a Gaussian mixture model (GMM) using online EM.
+   * The size of the vectors (indicating the number of components) must already
+   * be set.  If useInitialModel is set to true, then training continues from
+   * the model given in the dists and weights parameters, instead of starting
+   * from an initial clustering.
+   *
+   * @param observations List of observations to train on.
+   * @param dists Vector to store the trained Gaussians in.
+   * @param weights Vector to store a priori weights in.
+   * @param useInitialModel If true, training continues from the given model.
+   */
+  void Estimate(const arma::mat& observations,
+                std::vector<distribution::GaussianDistribution>& dists,
+                arma::vec& weights,
+                const bool useInitialModel = false);
+
+  /**
+   * Fit the observations to a Gaussian mixture model (GMM) using online EM,
+   * taking into account the probabilities of each point being from this
+   * mixture.  The size of the vectors (indicating the number of components)
+   * must already be set.  If useInitialModel is set to true, then training
+   * continues from the model given in the dists and weights parameters,
+   * instead of starting from an initial clustering.
+   *
+   * @param observations List of observations to train on.
+   * @param probabilities Probability of each point being from this model.
+   * @param dists Vector to store the trained Gaussians in.
+   * @param weights Vector to store a priori weights in.
+   * @param useInitialModel If true, training continues from the given model.
+   */
+  void Estimate(const arma::mat& observations,
+                const arma::vec& probabilities,
+                std::vector<distribution::GaussianDistribution>& dists,
+                arma::vec& weights,
+                const bool useInitialModel = false);
+
+  //! Get the clusterer.
+  const InitialClusteringType& Clusterer() const { return clusterer; }
+  //! Modify the clusterer.
+  InitialClusteringType& Clusterer() { return clusterer; }
+
+  //! Get the covariance constraint policy class.
+  const CovarianceConstraintPolicy& Constraint() const { return constraint; }
+  //! Modify the covariance constraint policy class.
+  CovarianceConstraintPolicy& Constraint() { return constraint; }
+
+  //! Get the number of observations in each mini-batch.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of observations in each mini-batch.
+  size_t& BatchSize() { return batchSize; }
+
+  //! Get the number of passes over the observations in each call to
+  //! Estimate().
+  size_t Passes() const { return passes; }
+  //! Modify the number of passes over the observations in each call to
+  //! Estimate().
+  size_t& Passes() { return passes; }
+
+  //! Get the power of the step size schedule.
+  double StepPower() const { return stepPower; }
+  //! Modify the power of the step size schedule.
+  double& StepPower() { return stepPower; }
+
+  //! Get the offset of the step size schedule.
+  double StepOffset() const { return stepOffset; }
+  //! Modify the offset of the step size schedule.
+  double& StepOffset() { return stepOffset; }
+
+  //! Get the number of mini-batches seen so far.
+  size_t Steps() const { return steps; }
+  //! Modify the number of mini-batches seen so far (set it to 0 to restart the
+  //! step size schedule).
+  size_t& Steps() { return steps; }
+
+  //! Serialize the fitter.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int version);
+
+ private:
+  /**
+   * Compute the sufficient statistics of the given model: the weight of each
+   * Gaussian, and the weighted first and second moments.
+   */
+  void ModelStatistics(
+      const std::vector<distribution::GaussianDistribution>& dists,
+      const arma::vec& weights,
+      arma::vec& weightStats,
+      arma::mat& meanStats,
+      std::vector<arma::mat>& covarianceStats) const;
+
+  /**
+   * Run the E-step on one mini-batch and blend its statistics into the running
+   * statistics, then recompute the model from them.
+   *
+   * @param batch Observations in the mini-batch.
+   * @param batchProbabilities Probability of each observation in the
+   *     mini-batch being from this model.
+   * @param dists Gaussians to update.
+   * @param weights A priori weights to update.
+   * @param weightStats Running weight of each Gaussian.
+   * @param meanStats Running first moment of each Gaussian (one column per
+   *     Gaussian).
+   * @param covarianceStats Running second moment of each Gaussian.
+   */
+  void Step(const arma::mat& batch,
+            const arma::vec& batchProbabilities,
+            std::vector<distribution::GaussianDistribution>& dists,
+            arma::vec& weights,
+            arma::vec& weightStats,
+            arma::mat& meanStats,
+            std::vector<arma::mat>& covarianceStats);
+
+  //! Number of observations in each mini-batch.
+  size_t batchSize;
+  //! Number of passes over the observations in each call to Estimate().
+  size_t passes;
+  //! Power of the step size schedule.
+  double stepPower;
+  //! Offset of the step size schedule.
+  double stepOffset;
+  //! Number of mini-batches seen so far.
+  size_t steps;
+  //! Object which will perform the clustering.
+  InitialClusteringType clusterer;
+  //! Object which applies constraints to the covariance matrix.
+  CovarianceConstraintPolicy constraint;
+};
+
+} // namespace gmm
+} // namespace mlpack
+
+// Include implementation.
+#include "online_em_fit_impl.hpp"
+
+#endif
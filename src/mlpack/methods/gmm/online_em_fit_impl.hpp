@@ -0,0 +1,223 @@
+/**
+ * @file online_em_fit_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of online EM for fitting GMMs.
+ */
+#ifndef __MLPACK_METHODS_GMM_ONLINE_EM_FIT_IMPL_HPP
+#define __MLPACK_METHODS_GMM_ONLINE_EM_FIT_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "online_em_fit.hpp"
+
+namespace mlpack {
+namespace gmm {
+
+//! Constructor.
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy>::OnlineEMFit(
+    const size_t batchSize,
+    const size_t passes,
+    const double stepPower,
+    const double stepOffset,
+    InitialClusteringType clusterer,
+    CovarianceConstraintPolicy constraint) :
+    batchSize(batchSize),
+    passes(passes),
+    stepPower(stepPower),
+    stepOffset(stepOffset),
+    steps(0),
+    clusterer(clusterer),
+    constraint(constraint)
+{
+  if (batchSize == 0)
+    throw std::invalid_argument("OnlineEMFit::OnlineEMFit(): batch size must "
+        "be greater than 0");
+
+  if (stepPower <= 0.5 || stepPower > 1.0)
+  {
+    std::ostringstream oss;
+    oss << "OnlineEMFit::OnlineEMFit(): step power (" << stepPower << ") must "
+        << "be in (0.5, 1]";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (stepOffset <= 0.0)
+  {
+    std::ostringstream oss;
+    oss << "OnlineEMFit::OnlineEMFit(): step offset (" << stepOffset << ") "
+        << "must be positive";
+    throw std::invalid_argument(oss.str());
+  }
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
+    const arma::mat& observations,
+    std::vector<distribution::GaussianDistribution>& dists,
+    arma::vec& weights,
+    const bool useInitialModel)
+{
+  // Every observation is certainly from this model.
+  Estimate(observations, arma::ones<arma::vec>(observations.n_cols), dists,
+      weights, useInitialModel);
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy>::Estimate(
+    const arma::mat& observations,
+    const arma::vec& probabilities,
+    std::vector<distribution::GaussianDistribution>& dists,
+    arma::vec& weights,
+    const bool useInitialModel)
+{
+  if (!useInitialModel)
+  {
+    // Find the initial model the same way EMFit does.  A maximum of one
+    // iteration means that no EM iterations are done.
+    EMFit<InitialClusteringType, CovarianceConstraintPolicy> em(1, 0.0,
+        clusterer, constraint);
+    em.Estimate(observations, dists, weights, false);
+    steps = 0;
+  }
+
+  // The running statistics start from the current model.
+  arma::vec weightStats;
+  arma::mat meanStats;
+  std::vector<arma::mat> covarianceStats;
+  ModelStatistics(dists, weights, weightStats, meanStats, covarianceStats);
+
+  for (size_t pass = 0; pass < passes; ++pass)
+  {
+    for (size_t begin = 0; begin < observations.n_cols; begin += batchSize)
+    {
+      const size_t count = std::min(batchSize,
+          (size_t) observations.n_cols - begin);
+
+      // An alias of the observations in this mini-batch.
+      const arma::mat batch(const_cast<double*>(observations.colptr(begin)),
+          observations.n_rows, count, false, true);
+
+      Step(batch, probabilities.subvec(begin, begin + count - 1), dists,
+          weights, weightStats, meanStats, covarianceStats);
+    }
+
+    Log::Info << "OnlineEMFit::Estimate(): pass " << pass << " done; "
+        << steps << " mini-batches seen so far." << std::endl;
+  }
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy>::
+ModelStatistics(
+    const std::vector<distribution::GaussianDistribution>& dists,
+    const arma::vec& weights,
+    arma::vec& weightStats,
+    arma::mat& meanStats,
+    std::vector<arma::mat>& covarianceStats) const
+{
+  const size_t dimensionality = (dists.empty()) ? 0 : dists[0].Mean().n_elem;
+
+  weightStats = weights / accu(weights);
+  meanStats.set_size(dimensionality, dists.size());
+  covarianceStats.resize(dists.size());
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    const arma::vec& mean = dists[i].Mean();
+    meanStats.col(i) = weightStats[i] * mean;
+    covarianceStats[i] = weightStats[i] * (dists[i].Covariance() +
+        mean * trans(mean));
+  }
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy>::Step(
+    const arma::mat& batch,
+    const arma::vec& batchProbabilities,
+    std::vector<distribution::GaussianDistribution>& dists,
+    arma::vec& weights,
+    arma::vec& weightStats,
+    arma::mat& meanStats,
+    std::vector<arma::mat>& covarianceStats)
+{
+  const double totalProbability = accu(batchProbabilities);
+  if (totalProbability == 0.0)
+    return; // Nothing to learn from this mini-batch.
+
+  // E-step: the conditional probability of each Gaussian given each point.
+  arma::mat condProb(batch.n_cols, dists.size());
+  arma::vec phis;
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    dists[i].Probability(batch, phis);
+    condProb.col(i) = weights[i] * phis;
+  }
+
+  for (size_t j = 0; j < batch.n_cols; ++j)
+  {
+    // A point with zero likelihood under every Gaussian contributes nothing.
+    const double probSum = accu(condProb.row(j));
+    if (probSum != 0.0)
+      condProb.row(j) *= batchProbabilities[j] / probSum;
+  }
+
+  // Blend the statistics of this mini-batch into the running statistics.
+  const double stepSize = std::pow(stepOffset + steps, -stepPower);
+  ++steps;
+
+  arma::mat weightedBatch(batch.n_rows, batch.n_cols);
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    for (size_t j = 0; j < batch.n_cols; ++j)
+      weightedBatch.col(j) = condProb(j, i) * batch.col(j);
+
+    weightStats[i] = (1.0 - stepSize) * weightStats[i] + stepSize *
+        accu(condProb.col(i)) / totalProbability;
+    meanStats.col(i) = (1.0 - stepSize) * meanStats.col(i) + stepSize *
+        arma::sum(weightedBatch, 1) / totalProbability;
+    covarianceStats[i] = (1.0 - stepSize) * covarianceStats[i] + stepSize *
+        (weightedBatch * trans(batch)) / totalProbability;
+  }
+
+  // M-step: recompute the model from the running statistics.
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    // Don't update if the Gaussian has never had any points.
+    if (weightStats[i] == 0.0)
+      continue;
+
+    arma::vec mean = meanStats.col(i) / weightStats[i];
+    arma::mat covariance = covarianceStats[i] / weightStats[i] -
+        mean * trans(mean);
+
+    // Apply covariance constraint.
+    constraint.ApplyConstraint(covariance);
+
+    dists[i].Mean() = std::move(mean);
+    dists[i].Covariance(std::move(covariance));
+  }
+
+  weights = weightStats / accu(weightStats);
+}
+
+template<typename InitialClusteringType, typename CovarianceConstraintPolicy>
+template<typename Archive>
+void OnlineEMFit<InitialClusteringType, CovarianceConstraintPolicy>::Serialize(
+    Archive& ar,
+    const unsigned int /* version */)
+{
+  using data::CreateNVP;
+
+  ar & CreateNVP(batchSize, "batchSize");
+  ar & CreateNVP(passes, "passes");
+  ar & CreateNVP(stepPower, "stepPower");
+  ar & CreateNVP(stepOffset, "stepOffset");
+  ar & CreateNVP(steps, "steps");
+  ar & CreateNVP(clusterer, "clusterer");
+  ar & CreateNVP(constraint, "constraint");
+}
+
+} // namespace gmm
+} // namespace mlpack
+
+#endif
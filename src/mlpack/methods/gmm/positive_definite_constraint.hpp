@@ -40,6 +40,30 @@ class PositiveDefiniteConstraint
     }
   }
 
+  /**
+   * Apply the positive definiteness constraint to the given diagonal
+   * covariance.  A diagonal covariance is positive definite when each of its
+   * elements is positive, so each element is checked instead of the
+   * determinant (which can underflow in high dimensions).
+   *
+   * @param diagonalCovariance Diagonal of the covariance matrix.
+   */
+  static void ApplyConstraint(arma::vec& diagonalCovariance)
+  {
+    if (diagonalCovariance.min() <= 1e-50)
+    {
+      Log::Debug << "Covariance matrix is not positive definite.  Adding "
+          << "perturbation." << std::endl;
+
+      double perturbation = 1e-30;
+      while (diagonalCovariance.min() <= 1e-50)
+      {
+        diagonalCovariance += perturbation;
+        perturbation *= 10;
+      }
+    }
+  }
+
   //! Serialize the constraint (which stores nothing, so, nothing to do).
   template<typename Archive>
   static void Serialize(Archive& /* ar */, const unsigned int /* version */) { }
@@ -44,6 +44,16 @@ namespace hmm /** Hidden Markov Models. */ {
  * };
  * @endcode
  *
+ * If the distribution also has a batch log-probability function,
+ *
+ * @code
+ *   void LogProbability(const arma::mat& observations,
+ *                       arma::vec& logProbabilities) const;
+ * @endcode
+ *
+ * then it is used to evaluate each state's emissions for a whole sequence at
+ * once (see distribution::BatchLogProbability()).
+ *
  * See the mlpack::distribution::DiscreteDistribution class for an example.  One
  * would use the DiscreteDistribution class when the observations are
  * non-negative integers.  Other distributions could be Gaussians, a mixture of
@@ -245,13 +255,24 @@ class HMM
    * sequence, using the Viterbi algorithm, returning the log-likelihood of the
    * most likely state sequence.
    *
+   * Only the nonzero entries of the transition matrix are visited, so for a
+   * sparse (e.g. left-to-right) transition matrix each time step takes time
+   * linear in the number of possible transitions.  If beamWidth is nonzero,
+   * only the beamWidth most likely states at each time step are expanded to
+   * the next one (beam search); this is much faster for models with many
+   * states, but the result is then not guaranteed to be the most probable
+   * sequence.
+   *
    * @param dataSeq Sequence of observations.
    * @param stateSeq Vector in which the most probable state sequence will be
    *    stored.
+   * @param beamWidth Number of states to keep at each time step (0 keeps all
+   *    of them).
    * @return Log-likelihood of most probable state sequence.
    */
   double Predict(const arma::mat& dataSeq,
-                 arma::Col<size_t>& stateSeq) const;
+                 arma::Col<size_t>& stateSeq,
+                 const size_t beamWidth = 0) const;
 
   /**
    * Compute the log-likelihood of the given data sequence.
@@ -358,6 +379,72 @@ class HMM
                 const arma::vec& scales,
                 arma::mat& backwardProb) const;
 
+  /**
+   * Compute the log-probability of each observation in the given data sequence
+   * under each emission distribution.  The returned matrix has rows equal to
+   * the number of hidden states and columns equal to the number of
+   * observations.  Each state's emissions are evaluated with one batch call, if
+   * the distribution has one.
+   *
+   * @param dataSeq Data sequence to compute log-probabilities for.
+   * @param logEmission Matrix in which the log-probabilities will be saved.
+   */
+  void EmissionLogProbability(const arma::mat& dataSeq,
+                              arma::mat& logEmission) const;
+
+  /**
+   * The Forward algorithm, given the emission log-probabilities of each state
+   * (from EmissionLogProbability()).  Each time step is one matrix-vector
+   * product with the transition matrix.  The emission log-probabilities of each
+   * time step are shifted by their maximum before they are exponentiated, and
+   * the shift is added back into the log of the scaling factor, so no time
+   * step underflows unless every state has zero probability.
+   *
+   * @param logEmission Emission log-probabilities of each state.
+   * @param logScales Vector in which the logs of the scaling factors will be
+   *     saved.
+   * @param forwardProb Matrix in which forward probabilities will be saved.
+   */
+  void ScaledForward(const arma::mat& logEmission,
+                     arma::vec& logScales,
+                     arma::mat& forwardProb) const;
+
+  /**
+   * The Backward algorithm, given the emission log-probabilities of each state
+   * and the logs of the scaling factors found by ScaledForward().
+   *
+   * @param logEmission Emission log-probabilities of each state.
+   * @param logScales Logs of the scaling factors.
+   * @param backwardProb Matrix in which backward probabilities will be saved.
+   */
+  void ScaledBackward(const arma::mat& logEmission,
+                      const arma::vec& logScales,
+                      arma::mat& backwardProb) const;
+
+  /**
+   * Find the nonzero entries of the transition matrix, in compressed sparse
+   * column form: the nonzero entries of column j are in the rows
+   * rowIndices[colPtrs[j]] to rowIndices[colPtrs[j + 1] - 1], in increasing
+   * order.
+   *
+   * @param colPtrs Vector in which the start of each column will be saved.
+   * @param rowIndices Vector in which the rows of the nonzero entries will be
+   *     saved.
+   * @return Whether the transition matrix is sparse enough that products with
+   *     it should only visit the nonzero entries.
+   */
+  bool TransitionNonzeros(arma::Col<size_t>& colPtrs,
+                          arma::Col<size_t>& rowIndices) const;
+
+  /**
+   * Find the states with nonzero probability at one time step of the Viterbi
+   * algorithm, keeping only the beamWidth most likely ones if beamWidth is
+   * nonzero.  The states are returned in increasing order.
+   */
+  void BeamStates(const arma::vec& logStateProb,
+                  const size_t beamWidth,
+                  std::vector<size_t>& active) const;
+
   //! Set of emission probability distributions; one for each state.
   std::vector<Distribution> emission;
 
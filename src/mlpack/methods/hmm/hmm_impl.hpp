@@ -12,6 +12,10 @@
 // Just in case...
 #include "hmm.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace hmm {
 
@@ -94,89 +98,170 @@ void HMM<Distribution>::Train(const std::vector<arma::mat>& dataSeq)
   }
 
   // These are used later for training of each distribution.  We initialize it
-  // all now so we don't have to do any allocation later on.
+  // all now so we don't have to do any allocation later on.  The observations
+  // do not change between iterations, so the list of them is filled once; the
+  // observations of each sequence start at seqOffsets[seq].
   std::vector<arma::vec> emissionProb(transition.n_cols,
       arma::vec(totalLength));
   arma::mat emissionList(dimensionality, totalLength);
+  std::vector<size_t> seqOffsets(dataSeq.size());
+  size_t sumTime = 0;
+  for (size_t seq = 0; seq < dataSeq.size(); seq++)
+  {
+    seqOffsets[seq] = sumTime;
+    if (dataSeq[seq].n_cols > 0)
+      emissionList.cols(sumTime, sumTime + dataSeq[seq].n_cols - 1) =
+          dataSeq[seq];
+    sumTime += dataSeq[seq].n_cols;
+  }
+
+  // Inside a parallel region, this is 1 (see parallel::Threads()).
+  const size_t numThreads = parallel::Threads();
+
+  // Transitions that are impossible stay impossible (the update is
+  // multiplicative), so only the nonzero entries of the transition matrix need
+  // to be estimated.  For a sparse transition matrix, this makes each iteration
+  // linear in the number of nonzero entries instead of quadratic in the number
+  // of states.
+  arma::Col<size_t> colPtrs, rowIndices;
+  TransitionNonzeros(colPtrs, rowIndices);
+
+  // Each thread accumulates into its own initial and transition estimates; the
+  // transition estimates hold one value for each nonzero entry.
+  std::vector<arma::vec> threadInitial(numThreads);
+  std::vector<arma::vec> threadTransition(numThreads);
+  arma::vec seqLoglik(dataSeq.size());
 
   // This should be the Baum-Welch algorithm (EM for HMM estimation). This
   // follows the procedure outlined in Elliot, Aggoun, and Moore's book "Hidden
   // Markov Models: Estimation and Control", pp. 36-40.
   for (size_t iter = 0; iter < iterations; iter++)
   {
-    // Clear new transition matrix and emission probabilities.
-    arma::vec newInitial(transition.n_rows);
-    newInitial.zeros();
-    arma::mat newTransition(transition.n_rows, transition.n_cols);
-    newTransition.zeros();
-
-    // Reset log likelihood.
-    loglik = 0;
+    // Sequences are independent given the current model, so the E-step is run
+    // for them in parallel.  The sequences are dealt out to the threads
+    // round-robin, because their lengths may vary a lot; for a given number of
+    // threads, the result does not depend on the timing of the threads.
+    #pragma omp parallel num_threads(numThreads)
+    {
+#ifdef _OPENMP
+      const size_t thread = (size_t) omp_get_thread_num();
+#else
+      const size_t thread = 0;
+#endif
 
-    // Sum over time.
-    size_t sumTime = 0;
+      // Clear new transition matrix and emission probabilities.
+      arma::vec& newInitial = threadInitial[thread];
+      arma::vec& newTransition = threadTransition[thread];
+      newInitial.zeros(transition.n_rows);
+      newTransition.zeros(rowIndices.n_elem);
 
-    // Loop over each sequence.
-    for (size_t seq = 0; seq < dataSeq.size(); seq++)
-    {
       arma::mat stateProb;
       arma::mat forward;
       arma::mat backward;
-      arma::vec scales;
-
-      // Add the log-likelihood of this sequence.  This is the E-step.
-      loglik += Estimate(dataSeq[seq], stateProb, forward, backward, scales);
-
-      // Now re-estimate the parameters.  This is the M-step.
-      //   pi_i = sum_d ((1 / P(seq[d])) sum_t (f(i, 0) b(i, 0))
-      //   T_ij = sum_d ((1 / P(seq[d])) sum_t (f(i, t) T_ij E_i(seq[d][t]) b(i,
-      //           t + 1)))
-      //   E_ij = sum_d ((1 / P(seq[d])) sum_{t | seq[d][t] = j} f(i, t) b(i, t)
-      // We store the new estimates in a different matrix.
-      for (size_t t = 0; t < dataSeq[seq].n_cols; t++)
+      arma::mat logEmission;
+      arma::vec logScales;
+      arma::vec nextEmission(transition.n_rows);
+
+      // Loop over each sequence.
+      #pragma omp for schedule(static, 1)
+      for (size_t seq = 0; seq < dataSeq.size(); seq++)
       {
-        for (size_t j = 0; j < transition.n_cols; j++)
+        // Run the forward-backward algorithm, and store the log-likelihood of
+        // this sequence.  This is the E-step.
+        EmissionLogProbability(dataSeq[seq], logEmission);
+        ScaledForward(logEmission, logScales, forward);
+        ScaledBackward(logEmission, logScales, backward);
+        stateProb = forward % backward;
+        seqLoglik[seq] = accu(logScales);
+
+        // Now re-estimate the parameters.  This is the M-step.
+        //   pi_i = sum_d ((1 / P(seq[d])) sum_t (f(i, 0) b(i, 0))
+        //   T_ij = sum_d ((1 / P(seq[d])) sum_t (f(i, t) T_ij E_i(seq[d][t])
+        //           b(i, t + 1)))
+        //   E_ij = sum_d ((1 / P(seq[d])) sum_{t | seq[d][t] = j} f(i, t)
+        //           b(i, t)
+        // We store the new estimates in a different matrix.
+        if (dataSeq[seq].n_cols > 0)
+          newInitial += stateProb.col(0);
+
+        for (size_t t = 0; t < dataSeq[seq].n_cols; t++)
         {
-          // Add to estimate of initial probability for state j.
-          newInitial[j] = stateProb(j, 0);
-
           if (t < dataSeq[seq].n_cols - 1)
           {
-            // Estimate of T_ij (probability of transition from state j to state
-            // i).  We postpone multiplication of the old T_ij until later.
-            for (size_t i = 0; i < transition.n_rows; i++)
-              newTransition(i, j) += forward(j, t) * backward(i, t + 1) *
-                  emission[i].Probability(dataSeq[seq].unsafe_col(t + 1)) /
-                  scales[t + 1];
+            // The scaled emission probabilities of the next observation are
+            // the same for every j.
+            nextEmission = arma::exp(logEmission.col(t + 1) -
+                logScales[t + 1]);
+
+            // Estimate of T_ij (probability of transition from state j to
+            // state i).  We postpone multiplication of the old T_ij until
+            // later.
+            for (size_t j = 0; j < transition.n_cols; j++)
+            {
+              for (size_t k = colPtrs[j]; k < colPtrs[j + 1]; k++)
+              {
+                const size_t i = rowIndices[k];
+                newTransition[k] += forward(j, t) * backward(i, t + 1) *
+                    nextEmission[i];
+              }
+            }
           }
 
-          // Add to list of emission observations, for Distribution::Estimate().
-          emissionList.col(sumTime) = dataSeq[seq].col(t);
-          emissionProb[j][sumTime] = stateProb(j, t);
+          // Add to list of emission probabilities, for
+          // Distribution::Estimate().  Each sequence has its own columns.
+          for (size_t j = 0; j < transition.n_cols; j++)
+            emissionProb[j][seqOffsets[seq] + t] = stateProb(j, t);
         }
-        sumTime++;
       }
     }
 
+    // Add up the estimates of each thread, in order.
+    arma::vec newInitial = std::move(threadInitial[0]);
+    arma::vec newTransition = std::move(threadTransition[0]);
+    for (size_t t = 1; t < numThreads; ++t)
+    {
+      newInitial += threadInitial[t];
+      newTransition += threadTransition[t];
+    }
+
+    loglik = accu(seqLoglik);
+
     // Normalize the new initial probabilities.
     if (dataSeq.size() == 0)
       initial = newInitial / dataSeq.size();
 
-    // Assign the new transition matrix.  We use %= (element-wise
-    // multiplication) because every element of the new transition matrix must
-    // still be multiplied by the old elements (this is the multiplication we
-    // earlier postponed).
-    transition %= newTransition;
+    // Assign the new transition matrix.  We multiply because every element of
+    // the new transition matrix must still be multiplied by the old elements
+    // (this is the multiplication we earlier postponed).  The zero elements
+    // stay zero.
+    for (size_t j = 0; j < transition.n_cols; j++)
+      for (size_t k = colPtrs[j]; k < colPtrs[j + 1]; k++)
+        transition(rowIndices[k], j) *= newTransition[k];
 
     // Now we normalize the transition matrix.
     for (size_t i = 0; i < transition.n_cols; i++)
       transition.col(i) /= accu(transition.col(i));
 
-    // Now estimate emission probabilities.
-    for (size_t state = 0; state < transition.n_cols; state++)
+    // Now estimate emission probabilities.  The states are independent, so
+    // their distributions are estimated in parallel, all from the same list of
+    // observations with the weights of the state; the threads take one state
+    // at a time, since fitting a mixture can take much longer for some states
+    // than for others.  Each state gets its own random stream (the initial
+    // clustering of a GMM is random), so the result does not depend on how the
+    // states are scheduled.  Log::Info is not thread-safe, so the states are
+    // quiet while they are estimated.
+    const math::RandomStream stream = math::NewRandomStream();
+    const bool ignoring = Log::Info.ignoreInput;
+    Log::Info.ignoreInput = true;
+    parallel::For(0, transition.n_cols, [&](const size_t state)
+    {
+      math::RandomStream stateStream = stream.Split(state);
+      math::ScopedRandomStream scope(stateStream);
       emission[state].Estimate(emissionList, emissionProb[state]);
+    }, 1);
+    Log::Info.ignoreInput = ignoring;
 
-    Log::Debug << "Iteration " << iter << ": log-likelihood " << loglik
+    MLPACK_LOG_DEBUG << "Iteration " << iter << ": log-likelihood " << loglik
         << std::endl;
 
     if (std::abs(oldLoglik - loglik) < tolerance)
@@ -296,15 +381,20 @@ double HMM<Distribution>::Estimate(const arma::mat& dataSeq,
                                    arma::vec& scales) const
 {
   // First run the forward-backward algorithm.
-  Forward(dataSeq, scales, forwardProb);
-  Backward(dataSeq, scales, backwardProb);
+  arma::mat logEmission;
+  arma::vec logScales;
+  EmissionLogProbability(dataSeq, logEmission);
+  ScaledForward(logEmission, logScales, forwardProb);
+  ScaledBackward(logEmission, logScales, backwardProb);
+  scales = arma::exp(logScales);
 
   // Now assemble the state probability matrix based on the forward and backward
   // probabilities.
   stateProb = forwardProb % backwardProb;
 
-  // Finally assemble the log-likelihood and return it.
-  return accu(log(scales));
+  // Finally assemble the log-likelihood and return it.  This is summed from the
+  // logs of the scaling factors, which do not underflow.
+  return accu(logScales);
 }
 
 /**
@@ -378,48 +468,75 @@ void HMM<Distribution>::Generate(const size_t length,
  */
 template<typename Distribution>
 double HMM<Distribution>::Predict(const arma::mat& dataSeq,
-                                  arma::Col<size_t>& stateSeq) const
+                                  arma::Col<size_t>& stateSeq,
+                                  const size_t beamWidth) const
 {
   // This is an implementation of the Viterbi algorithm for finding the most
-  // probable sequence of states to produce the observed data sequence.  We
-  // don't use log-likelihoods to save that little bit of time, but we'll
-  // calculate the log-likelihood at the end of it all.
+  // probable sequence of states to produce the observed data sequence.  It
+  // works with log-likelihoods, so that long sequences do not underflow.
   stateSeq.set_size(dataSeq.n_cols);
   arma::mat logStateProb(transition.n_rows, dataSeq.n_cols);
-  arma::mat stateSeqBack(transition.n_rows, dataSeq.n_cols);
-
-  // Store the logs of the transposed transition matrix.  This is because we
-  // will be using the rows of the transition matrix.
-  arma::mat logTrans(log(trans(transition)));
+  arma::Mat<size_t> stateSeqBack(transition.n_rows, dataSeq.n_cols);
+
+  // Each state's best predecessor is found by pushing each state of the last
+  // time step along its possible transitions; only the nonzero entries of
+  // each column of the transition matrix are visited, so a sparse transition
+  // matrix takes time linear in its number of nonzero entries.
+  arma::Col<size_t> colPtrs, rowIndices;
+  TransitionNonzeros(colPtrs, rowIndices);
+  arma::vec logTrans(rowIndices.n_elem);
+  for (size_t j = 0; j < transition.n_cols; j++)
+    for (size_t k = colPtrs[j]; k < colPtrs[j + 1]; k++)
+      logTrans[k] = log(transition(rowIndices[k], j));
+
+  // Evaluate the emissions of the whole sequence first.
+  arma::mat logEmission;
+  EmissionLogProbability(dataSeq, logEmission);
 
   // The calculation of the first state is slightly different; the probability
   // of the first state being state j is the maximum probability that the state
   // came to be j from another state.
-  logStateProb.col(0).zeros();
   for (size_t state = 0; state < transition.n_rows; state++)
   {
-    logStateProb(state, 0) = log(initial[state] *
-        emission[state].Probability(dataSeq.unsafe_col(0)));
+    logStateProb(state, 0) = log(initial[state]) + logEmission(state, 0);
     stateSeqBack(state, 0) = state;
   }
 
-  // Store the best first state.
-  arma::uword index;
+  // The states that are expanded at the next time step, in increasing order
+  // (so that ties go to the lowest state, like arma::max()).  With a beam,
+  // only the beamWidth most likely states are kept.
+  std::vector<size_t> active;
+  BeamStates(logStateProb.unsafe_col(0), beamWidth, active);
+
   for (size_t t = 1; t < dataSeq.n_cols; t++)
   {
     // Assemble the state probability for this element.
     // Given that we are in state j, we use state with the highest probability
     // of being the previous state.
-    for (size_t j = 0; j < transition.n_rows; j++)
+    logStateProb.col(t).fill(-std::numeric_limits<double>::infinity());
+    stateSeqBack.col(t).zeros();
+    for (size_t a = 0; a < active.size(); a++)
     {
-      arma::vec prob = logStateProb.col(t - 1) + logTrans.col(j);
-      logStateProb(j, t) = prob.max(index) +
-          log(emission[j].Probability(dataSeq.unsafe_col(t)));
-        stateSeqBack(j, t) = index;
+      const size_t i = active[a];
+      const double prevLogProb = logStateProb(i, t - 1);
+      for (size_t k = colPtrs[i]; k < colPtrs[i + 1]; k++)
+      {
+        const size_t j = rowIndices[k];
+        const double logProb = prevLogProb + logTrans[k];
+        if (logProb > logStateProb(j, t))
+        {
+          logStateProb(j, t) = logProb;
+          stateSeqBack(j, t) = i;
+        }
+      }
     }
+
+    logStateProb.col(t) += logEmission.col(t);
+    BeamStates(logStateProb.unsafe_col(t), beamWidth, active);
   }
 
   // Backtrack to find the most probable state sequence.
+  arma::uword index;
   logStateProb.unsafe_col(dataSeq.n_cols - 1).max(index);
   stateSeq[dataSeq.n_cols - 1] = index;
   for (size_t t = 2; t <= dataSeq.n_cols; t++)
@@ -436,12 +553,14 @@ template<typename Distribution>
 double HMM<Distribution>::LogLikelihood(const arma::mat& dataSeq) const
 {
   arma::mat forward;
-  arma::vec scales;
+  arma::mat logEmission;
+  arma::vec logScales;
 
-  Forward(dataSeq, scales, forward);
+  EmissionLogProbability(dataSeq, logEmission);
+  ScaledForward(logEmission, logScales, forward);
 
-  // The log-likelihood is the log of the scales for each time step.
-  return accu(log(scales));
+  // The log-likelihood is the sum of the logs of the scales for each time step.
+  return accu(logScales);
 }
 
 /**
@@ -493,75 +612,199 @@ template<typename Distribution>
 void HMM<Distribution>::Forward(const arma::mat& dataSeq,
                                 arma::vec& scales,
                                 arma::mat& forwardProb) const
+{
+  arma::mat logEmission;
+  arma::vec logScales;
+  EmissionLogProbability(dataSeq, logEmission);
+  ScaledForward(logEmission, logScales, forwardProb);
+  scales = arma::exp(logScales);
+}
+
+template<typename Distribution>
+void HMM<Distribution>::Backward(const arma::mat& dataSeq,
+                                 const arma::vec& scales,
+                                 arma::mat& backwardProb) const
+{
+  arma::mat logEmission;
+  EmissionLogProbability(dataSeq, logEmission);
+  ScaledBackward(logEmission, arma::log(scales), backwardProb);
+}
+
+/**
+ * Compute the emission log-probabilities of each state for the whole sequence.
+ */
+template<typename Distribution>
+void HMM<Distribution>::EmissionLogProbability(const arma::mat& dataSeq,
+                                               arma::mat& logEmission) const
+{
+  logEmission.set_size(emission.size(), dataSeq.n_cols);
+  arma::vec logProbs;
+  for (size_t state = 0; state < emission.size(); state++)
+  {
+    distribution::BatchLogProbability(emission[state], dataSeq, logProbs);
+    logEmission.row(state) = trans(logProbs);
+  }
+}
+
+template<typename Distribution>
+void HMM<Distribution>::ScaledForward(const arma::mat& logEmission,
+                                      arma::vec& logScales,
+                                      arma::mat& forwardProb) const
 {
   // Our goal is to calculate the forward probabilities:
   //  P(X_k | o_{1:k}) for all possible states X_k, for each time point k.
-  forwardProb.zeros(transition.n_rows, dataSeq.n_cols);
-  scales.zeros(dataSeq.n_cols);
-
-  // The first entry in the forward algorithm uses the initial state
-  // probabilities.  Note that MATLAB assumes that the starting state (at
-  // t = -1) is state 0; this is not our assumption here.  To force that
-  // behavior, you could append a single starting state to every single data
-  // sequence and that should produce results in line with MATLAB.
-  for (size_t state = 0; state < transition.n_rows; state++)
-    forwardProb(state, 0) = initial(state) *
-        emission[state].Probability(dataSeq.unsafe_col(0));
+  forwardProb.set_size(transition.n_rows, logEmission.n_cols);
+  logScales.set_size(logEmission.n_cols);
 
-  // Then normalize the column.
-  scales[0] = accu(forwardProb.col(0));
-  forwardProb.col(0) /= scales[0];
+  // If most transitions are impossible, the products with the transition
+  // matrix only visit its nonzero entries.
+  arma::Col<size_t> colPtrs, rowIndices;
+  const bool sparse = TransitionNonzeros(colPtrs, rowIndices);
 
-  // Now compute the probabilities for each successive observation.
-  for (size_t t = 1; t < dataSeq.n_cols; t++)
+  arma::vec emissionProb, predicted;
+  for (size_t t = 0; t < logEmission.n_cols; t++)
   {
-    for (size_t j = 0; j < transition.n_rows; j++)
+    // Exponentiate the emission log-probabilities relative to the largest one;
+    // this is the shift of a log-sum-exp, and it is added back into the scale.
+    const double shift = logEmission.col(t).max();
+    emissionProb = arma::exp(logEmission.col(t) - shift);
+
+    // The first entry in the forward algorithm uses the initial state
+    // probabilities.  Note that MATLAB assumes that the starting state (at
+    // t = -1) is state 0; this is not our assumption here.  To force that
+    // behavior, you could append a single starting state to every single data
+    // sequence and that should produce results in line with MATLAB.
+    //
+    // After that, the forward probability of state j at time t is the sum over
+    // all states of the probability of the previous state transitioning to the
+    // current state, times the probability of emitting the given observation.
+    if (t == 0)
+    {
+      forwardProb.col(t) = initial % emissionProb;
+    }
+    else if (sparse)
+    {
+      predicted.zeros(transition.n_rows);
+      for (size_t i = 0; i < transition.n_cols; i++)
+        for (size_t k = colPtrs[i]; k < colPtrs[i + 1]; k++)
+          predicted[rowIndices[k]] += transition(rowIndices[k], i) *
+              forwardProb(i, t - 1);
+
+      forwardProb.col(t) = predicted % emissionProb;
+    }
+    else
     {
-      // The forward probability of state j at time t is the sum over all states
-      // of the probability of the previous state transitioning to the current
-      // state and emitting the given observation.
-      forwardProb(j, t) = accu(forwardProb.col(t - 1) %
-          trans(transition.row(j))) *
-          emission[j].Probability(dataSeq.unsafe_col(t));
+      forwardProb.col(t) = (transition * forwardProb.col(t - 1)) %
+          emissionProb;
     }
 
     // Normalize probability.
-    scales[t] = accu(forwardProb.col(t));
-    forwardProb.col(t) /= scales[t];
+    const double scale = accu(forwardProb.col(t));
+    forwardProb.col(t) /= scale;
+    logScales[t] = std::log(scale) + shift;
   }
 }
 
 template<typename Distribution>
-void HMM<Distribution>::Backward(const arma::mat& dataSeq,
-                                 const arma::vec& scales,
-                                 arma::mat& backwardProb) const
+void HMM<Distribution>::ScaledBackward(const arma::mat& logEmission,
+                                       const arma::vec& logScales,
+                                       arma::mat& backwardProb) const
 {
   // Our goal is to calculate the backward probabilities:
   //  P(X_k | o_{k + 1:T}) for all possible states X_k, for each time point k.
-  backwardProb.zeros(transition.n_rows, dataSeq.n_cols);
+  backwardProb.set_size(transition.n_rows, logEmission.n_cols);
+  if (logEmission.n_cols == 0)
+    return;
 
   // The last element probability is 1.
-  backwardProb.col(dataSeq.n_cols - 1).fill(1);
-
-  // Now step backwards through all other observations.
-  for (size_t t = dataSeq.n_cols - 2; t + 1 > 0; t--)
+  backwardProb.col(logEmission.n_cols - 1).fill(1);
+
+  // If most transitions are impossible, the products with the transition
+  // matrix only visit its nonzero entries.
+  arma::Col<size_t> colPtrs, rowIndices;
+  const bool sparse = TransitionNonzeros(colPtrs, rowIndices);
+
+  // Now step backwards through all other observations.  The backward
+  // probability of state j at time t is the sum over all states of the
+  // probability of the next state having been a transition from the current
+  // state multiplied by the probability of each of those states emitting the
+  // given observation, normalized by the weights from the forward algorithm.
+  arma::vec weighted;
+  for (size_t t = logEmission.n_cols - 1; t > 0; t--)
   {
-    for (size_t j = 0; j < transition.n_rows; j++)
+    weighted = backwardProb.col(t) % arma::exp(logEmission.col(t) -
+        logScales[t]);
+
+    if (sparse)
     {
-      // The backward probability of state j at time t is the sum over all state
-      // of the probability of the next state having been a transition from the
-      // current state multiplied by the probability of each of those states
-      // emitting the given observation.
-      for (size_t state = 0; state < transition.n_rows; state++)
-        backwardProb(j, t) += transition(state, j) * backwardProb(state, t + 1)
-            * emission[state].Probability(dataSeq.unsafe_col(t + 1));
-
-      // Normalize by the weights from the forward algorithm.
-      backwardProb(j, t) /= scales[t + 1];
+      for (size_t j = 0; j < transition.n_cols; j++)
+      {
+        double sum = 0.0;
+        for (size_t k = colPtrs[j]; k < colPtrs[j + 1]; k++)
+          sum += transition(rowIndices[k], j) * weighted[rowIndices[k]];
+        backwardProb(j, t - 1) = sum;
+      }
+    }
+    else
+    {
+      backwardProb.col(t - 1) = trans(transition) * weighted;
     }
   }
 }
 
+/**
+ * Find the nonzero entries of the transition matrix.
+ */
+template<typename Distribution>
+bool HMM<Distribution>::TransitionNonzeros(arma::Col<size_t>& colPtrs,
+                                           arma::Col<size_t>& rowIndices) const
+{
+  colPtrs.set_size(transition.n_cols + 1);
+  std::vector<size_t> rows;
+  colPtrs[0] = 0;
+  for (size_t j = 0; j < transition.n_cols; j++)
+  {
+    for (size_t i = 0; i < transition.n_rows; i++)
+      if (transition(i, j) != 0.0)
+        rows.push_back(i);
+
+    colPtrs[j + 1] = rows.size();
+  }
+
+  rowIndices = arma::conv_to<arma::Col<size_t>>::from(rows);
+
+  // Scattered loops over the nonzero entries are slower per entry than a dense
+  // matrix-vector product, so they only pay off when most entries are zero.
+  return (8 * rowIndices.n_elem < transition.n_elem);
+}
+
+/**
+ * Choose the states to expand at the next time step of the Viterbi algorithm.
+ */
+template<typename Distribution>
+void HMM<Distribution>::BeamStates(const arma::vec& logStateProb,
+                                   const size_t beamWidth,
+                                   std::vector<size_t>& active) const
+{
+  active.clear();
+  for (size_t state = 0; state < logStateProb.n_elem; state++)
+    if (logStateProb[state] > -std::numeric_limits<double>::infinity())
+      active.push_back(state);
+
+  if (beamWidth == 0 || active.size() <= beamWidth)
+    return;
+
+  // Keep the beamWidth most likely states, in increasing order.
+  std::nth_element(active.begin(), active.begin() + beamWidth - 1,
+      active.end(), [&logStateProb](const size_t a, const size_t b)
+      {
+        return (logStateProb[a] > logStateProb[b]) ||
+            ((logStateProb[a] == logStateProb[b]) && (a < b));
+      });
+  active.resize(beamWidth);
+  std::sort(active.begin(), active.end());
+}
+
 template<typename Distribution>
 std::string HMM<Distribution>::ToString() const
 {
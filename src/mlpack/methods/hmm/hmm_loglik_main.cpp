@@ -14,10 +14,18 @@
 PROGRAM_INFO("Hidden Markov Model (HMM) Sequence Log-Likelihood", "This "
     "utility takes an already-trained HMM (--model_file) and evaluates the "
     "log-likelihood of a given sequence of observations (--input_file).  The "
-    "computed log-likelihood is given directly to stdout.");
+    "computed log-likelihood is given directly to stdout."
+    "\n\n"
+    "If --batch is given, --input_file should contain a list of files, one per "
+    "line, each containing an observation sequence.  The model is loaded once, "
+    "the log-likelihoods are computed in parallel (if mlpack was compiled with "
+    "OpenMP), and they are given to stdout, one per line, in the same order as "
+    "the list.");
 
 PARAM_STRING_REQ("input_file", "File containing observations,", "i");
 PARAM_STRING_REQ("model_file", "File containing HMM.", "m");
+PARAM_FLAG("batch", "If true, input_file is expected to contain a list of "
+    "files to use as input observation sequences.", "b");
 
 using namespace mlpack;
 using namespace mlpack::hmm;
@@ -34,28 +42,52 @@ struct Loglik
   template<typename HMMType>
   static void Apply(HMMType& hmm, void* /* extraInfo */)
   {
-    // Load the data sequence.
     const string inputFile = CLI::GetParam<string>("input_file");
-    mat dataSeq;
-    data::Load(inputFile, dataSeq, true);
 
-    // Detect if we need to transpose the data, in the case where the input data
-    // has one dimension.
-    if ((dataSeq.n_cols == 1) && (hmm.Emission()[0].Dimensionality() == 1))
+    if (!CLI::HasParam("batch"))
     {
-      Log::Info << "Data sequence appears to be transposed; correcting."
-          << endl;
-      dataSeq = dataSeq.t();
+      // Load the data sequence.
+      mat dataSeq;
+      LoadSequence(inputFile, hmm, dataSeq);
+
+      const double loglik = hmm.LogLikelihood(dataSeq);
+
+      cout << loglik << endl;
+      return;
     }
 
-    if (dataSeq.n_rows != hmm.Emission()[0].Dimensionality())
-      Log::Fatal << "Dimensionality of sequence (" << dataSeq.n_rows << ") is "
-          << "not equal to the dimensionality of the HMM ("
-          << hmm.Emission()[0].Dimensionality() << ")!" << endl;
+    vector<string> files;
+    ReadFileList(inputFile, files);
+
+    // The number of sequences that are loaded and evaluated at a time.
+    const size_t chunkSize = 1024;
+    Log::Info << "Evaluating " << files.size() << " sequences from '"
+        << inputFile << "'." << endl;
+
+    // Work through the list a chunk at a time, so that all of the sequences
+    // don't need to be held in memory at once.
+    vector<mat> dataSeqs;
+    arma::vec logliks;
+    for (size_t begin = 0; begin < files.size(); begin += chunkSize)
+    {
+      const size_t count = std::min(chunkSize, files.size() - begin);
+
+      dataSeqs.resize(count);
+      logliks.set_size(count);
+      for (size_t i = 0; i < count; ++i)
+        LoadSequence(files[begin + i], hmm, dataSeqs[i]);
 
-    const double loglik = hmm.LogLikelihood(dataSeq);
+      // The sequences are independent, and they may have very different
+      // lengths.
+      #pragma omp parallel for schedule(dynamic, 1)
+      for (size_t i = 0; i < count; ++i)
+        logliks[i] = hmm.LogLikelihood(dataSeqs[i]);
+
+      for (size_t i = 0; i < count; ++i)
+        cout << logliks[i] << "\n";
+    }
 
-    cout << loglik << endl;
+    cout << flush;
   }
 };
 
@@ -31,6 +31,32 @@ void LoadHMMAndPerformAction(const std::string& modelFile,
 template<typename HMMType>
 void SaveHMM(HMMType& hmm, const std::string& modelFile);
 
+/**
+ * Read a list of file names, one per line, from the given file.  This is used
+ * by the --batch option of the HMM programs.  Empty lines are skipped.  If the
+ * file cannot be opened, a fatal error is given.
+ *
+ * @param listFile File containing the list of file names.
+ * @param files Vector to store the file names in.
+ */
+inline void ReadFileList(const std::string& listFile,
+                         std::vector<std::string>& files);
+
+/**
+ * Load an observation sequence for the given HMM from a file, transposing it if
+ * it has one dimension and was saved as a column.  If the dimensionality of the
+ * sequence does not match the HMM, or the sequence is empty, a fatal error is
+ * given.
+ *
+ * @param sequenceFile File containing the observation sequence.
+ * @param hmm HMM that the sequence will be used with.
+ * @param dataSeq Matrix to store the sequence in.
+ */
+template<typename HMMType>
+void LoadSequence(const std::string& sequenceFile,
+                  const HMMType& hmm,
+                  arma::mat& dataSeq);
+
 } // namespace hmm
 } // namespace mlpack
 
@@ -136,6 +136,53 @@ void SaveHMMHelper(HMMType& hmm, const std::string& modelFile)
   ar << data::CreateNVP(hmm, "hmm");
 }
 
+inline void ReadFileList(const std::string& listFile,
+                         std::vector<std::string>& files)
+{
+  std::ifstream f(listFile);
+  if (!f.is_open())
+    Log::Fatal << "Could not open '" << listFile << "' for reading."
+        << std::endl;
+
+  files.clear();
+  std::string line;
+  while (std::getline(f, line))
+  {
+    // Allow files with Windows line endings.
+    if (!line.empty() && line[line.size() - 1] == '\r')
+      line.erase(line.size() - 1);
+
+    if (!line.empty())
+      files.push_back(line);
+  }
+}
+
+template<typename HMMType>
+void LoadSequence(const std::string& sequenceFile,
+                  const HMMType& hmm,
+                  arma::mat& dataSeq)
+{
+  data::Load(sequenceFile, dataSeq, true); // Fatal on failure.
+
+  // Detect if we need to transpose the data, in the case where the input data
+  // has one dimension.
+  if ((dataSeq.n_cols == 1) && (hmm.Emission()[0].Dimensionality() == 1))
+  {
+    Log::Info << "Data sequence in '" << sequenceFile << "' appears to be "
+        << "transposed; correcting." << std::endl;
+    dataSeq = dataSeq.t();
+  }
+
+  if (dataSeq.n_rows != hmm.Emission()[0].Dimensionality())
+    Log::Fatal << "Dimensionality of sequence in '" << sequenceFile << "' ("
+        << dataSeq.n_rows << ") is not equal to the dimensionality of the HMM ("
+        << hmm.Emission()[0].Dimensionality() << ")!" << std::endl;
+
+  if (dataSeq.n_cols == 0)
+    Log::Fatal << "Sequence in '" << sequenceFile << "' is empty!"
+        << std::endl;
+}
+
 // Utility functions to turn a type into something we can store.
 template<typename HMMType>
 char GetHMMType() { return char(-1); }
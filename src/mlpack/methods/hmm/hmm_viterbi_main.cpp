@@ -16,12 +16,26 @@ PROGRAM_INFO("Hidden Markov Model (HMM) Viterbi State Prediction", "This "
     "utility takes an already-trained HMM (--model_file) and evaluates the "
     "most probably hidden state sequence of a given sequence of observations "
     "(--input_file), using the Viterbi algorithm.  The computed state sequence "
-    "is saved to the specified output file (--output_file).");
+    "is saved to the specified output file (--output_file)."
+    "\n\n"
+    "If --batch is given, --input_file should contain a list of files, one per "
+    "line, each containing an observation sequence.  The model is loaded once, "
+    "the sequences are decoded in parallel (if mlpack was compiled with "
+    "OpenMP), and the state sequences are written to --output_file, one line "
+    "per input sequence, in the same order as the list."
+    "\n\n"
+    "For models with many states, --beam_width can be given to keep only the "
+    "most probable states at each time step (beam search); this is faster, but "
+    "the computed state sequence may then not be the most probable one.");
 
 PARAM_STRING_REQ("input_file", "File containing observations,", "i");
 PARAM_STRING_REQ("model_file", "File containing HMM.", "m");
 PARAM_STRING("output_file", "File to save predicted state sequence to.", "o",
     "output.csv");
+PARAM_FLAG("batch", "If true, input_file is expected to contain a list of "
+    "files to use as input observation sequences.", "b");
+PARAM_INT("beam_width", "Number of most probable states to keep at each time "
+    "step (0 means that exact Viterbi decoding is done).", "w", 0);
 
 using namespace mlpack;
 using namespace mlpack::hmm;
@@ -38,32 +52,72 @@ struct Viterbi
   template<typename HMMType>
   static void Apply(HMMType& hmm, void* /* extraInfo */)
   {
-    // Load observations.
     const string inputFile = CLI::GetParam<string>("input_file");
+    const string outputFile = CLI::GetParam<string>("output_file");
 
-    mat dataSeq;
-    data::Load(inputFile, dataSeq, true);
+    const int beamWidth = CLI::GetParam<int>("beam_width");
+    if (beamWidth < 0)
+      Log::Fatal << "Invalid beam width (" << beamWidth << "); must be greater "
+          << "than or equal to 0." << endl;
 
-    // See if transposing the data could make it the right dimensionality.
-    if ((dataSeq.n_cols == 1) && (hmm.Emission()[0].Dimensionality() == 1))
+    if (!CLI::HasParam("batch"))
     {
-      Log::Info << "Data sequence appears to be transposed; correcting."
-          << endl;
-      dataSeq = dataSeq.t();
+      // Load observations.
+      mat dataSeq;
+      LoadSequence(inputFile, hmm, dataSeq);
+
+      arma::Col<size_t> sequence;
+      hmm.Predict(dataSeq, sequence, (size_t) beamWidth);
+
+      // Save output.
+      data::Save(outputFile, sequence, true);
+      return;
     }
 
-    // Verify correct dimensionality.
-    if (dataSeq.n_rows != hmm.Emission()[0].Dimensionality())
-      Log::Fatal << "Observation dimensionality (" << dataSeq.n_rows << ") "
-          << "does not match HMM Gaussian dimensionality ("
-          << hmm.Emission()[0].Dimensionality() << ")!" << endl;
+    vector<string> files;
+    ReadFileList(inputFile, files);
 
-    arma::Col<size_t> sequence;
-    hmm.Predict(dataSeq, sequence);
+    // The number of sequences that are loaded, decoded, and written at a time.
+    const size_t chunkSize = 1024;
+    Log::Info << "Decoding " << files.size() << " sequences from '"
+        << inputFile << "'." << endl;
 
-    // Save output.
-    const string outputFile = CLI::GetParam<string>("output_file");
-    data::Save(outputFile, sequence, true);
+    ofstream output(outputFile);
+    if (!output.is_open())
+      Log::Fatal << "Could not open '" << outputFile << "' for writing."
+          << endl;
+
+    // Work through the list a chunk at a time, so that all of the sequences
+    // don't need to be held in memory at once.
+    vector<mat> dataSeqs;
+    vector<arma::Col<size_t>> sequences;
+    for (size_t begin = 0; begin < files.size(); begin += chunkSize)
+    {
+      const size_t count = std::min(chunkSize, files.size() - begin);
+
+      dataSeqs.resize(count);
+      sequences.resize(count);
+      for (size_t i = 0; i < count; ++i)
+        LoadSequence(files[begin + i], hmm, dataSeqs[i]);
+
+      // The sequences are independent, and they may have very different
+      // lengths.
+      #pragma omp parallel for schedule(dynamic, 1)
+      for (size_t i = 0; i < count; ++i)
+        hmm.Predict(dataSeqs[i], sequences[i], (size_t) beamWidth);
+
+      // Write the state sequences of this chunk, in order.
+      for (size_t i = 0; i < count; ++i)
+      {
+        for (size_t t = 0; t < sequences[i].n_elem; ++t)
+          output << ((t == 0) ? "" : ",") << sequences[i][t];
+        output << "\n";
+      }
+    }
+
+    if (!output.good())
+      Log::Fatal << "Error writing state sequences to '" << outputFile << "'."
+          << endl;
   }
 };
 
@@ -0,0 +1,210 @@
+/**
+ * @file kde.hpp
+ * @author Ryan Curtin
+ *
+ * Defines the KDE class, which performs kernel density estimation with
+ * single-tree or dual-tree algorithms.
+ */
+#ifndef __MLPACK_METHODS_KDE_KDE_HPP
+#define __MLPACK_METHODS_KDE_KDE_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/tree/binary_space_tree.hpp>
+#include "kde_stat.hpp"
+
+namespace mlpack {
+namespace kde /** Kernel density estimation. */ {
+
+/**
+ * The KDE class performs kernel density estimation: for each query point q, it
+ * computes the average kernel value
+ *
+ * @f[
+ * f(q) = \frac{1}{N} \sum_{r} K(q, r)
+ * @f]
+ *
+ * over the N reference points r.  (For a density that integrates to one, this
+ * must still be divided by the normalizing constant of the kernel, such as
+ * GaussianKernel::Normalizer().)  It is implemented in the style of a
+ * generalized tree-independent dual-tree algorithm; a pair of nodes (or, in
+ * single-tree mode, a query point and a reference node) is pruned when the
+ * kernel values between them are close enough to be approximated by one value.
+ * Each estimate is then within
+ *
+ * @code
+ * relError * f(q) + absError
+ * @endcode
+ *
+ * of the exact one.  See KDERules for details.
+ *
+ * The kernel must be a function of the distance between the points that does
+ * not increase with the distance, with an Evaluate(distance) method; that is,
+ * KernelTraits<KernelType>::DecreasesWithDistance must be true (as it is for
+ * the Gaussian, Epanechnikov, Laplacian, triangular, and spherical kernels).
+ * The distance is given by MetricType, which must be the metric the kernel is
+ * defined with (usually the Euclidean distance).
+ *
+ * @tparam KernelType Kernel to use for density estimation.
+ * @tparam MetricType Metric to use for distance calculations.
+ * @tparam MatType Type of data to use.
+ * @tparam TreeType Type of tree to use; must satisfy the TreeType policy API.
+ */
+template<typename KernelType = kernel::GaussianKernel,
+         typename MetricType = metric::EuclideanDistance,
+         typename MatType = arma::mat,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType = tree::KDTree>
+class KDE
+{
+  static_assert(kernel::KernelTraits<KernelType>::DecreasesWithDistance,
+      "KDE can only be used with kernels that decrease with distance.");
+
+ public:
+  //! Convenience typedef.
+  typedef TreeType<MetricType, KDEStat, MatType> Tree;
+
+  /**
+   * Initialize the KDE object with the given error tolerances and kernel.  No
+   * reference set is given yet; Train() must be called before Evaluate().
+   *
+   * @param relError Relative error tolerance of each estimation.
+   * @param absError Absolute error tolerance of each estimation.
+   * @param kernel Instantiated kernel.
+   * @param naive Whether the computation should be done in O(n^2) naive mode.
+   * @param singleMode Whether single-tree computation should be used (as
+   *      opposed to dual-tree computation).
+   * @param metric Instantiated distance metric.
+   */
+  KDE(const double relError = 0.05,
+      const double absError = 0.0,
+      const KernelType kernel = KernelType(),
+      const bool naive = false,
+      const bool singleMode = false,
+      const MetricType metric = MetricType());
+
+  /**
+   * Destroy the KDE object.  If trees were created, they will be deleted.
+   */
+  ~KDE();
+
+  /**
+   * Set the reference set to the given dataset, and build a tree on it (unless
+   * in naive mode).  The dataset is copied.
+   *
+   * @param referenceSet New set of reference data.
+   */
+  void Train(const MatType& referenceSet);
+
+  /**
+   * Set the reference set to the given dataset, taking ownership of it, and
+   * build a tree on it (unless in naive mode).  The points may be rearranged.
+   *
+   * @param referenceSet New set of reference data.
+   */
+  void Train(MatType&& referenceSet);
+
+  /**
+   * Estimate the density at each point of the given query set.  The
+   * estimations are given in the order of the query set.
+   *
+   * @param querySet Set of query points.
+   * @param estimations Vector to store the estimation of each query point in.
+   */
+  void Evaluate(const MatType& querySet, arma::vec& estimations);
+
+  /**
+   * Estimate the density at each point of the reference set (the kernel value
+   * between a point and itself is included).  The estimations are given in the
+   * order of the dataset given to Train().
+   *
+   * @param estimations Vector to store the estimation of each point in.
+   */
+  void Evaluate(arma::vec& estimations);
+
+  //! Get the relative error tolerance.
+  double RelativeError() const { return relError; }
+  //! Modify the relative error tolerance (it must not be negative).
+  double& RelativeError() { return relError; }
+
+  //! Get the absolute error tolerance.
+  double AbsoluteError() const { return absError; }
+  //! Modify the absolute error tolerance (it must not be negative).
+  double& AbsoluteError() { return absError; }
+
+  //! Get whether naive mode is used.
+  bool Naive() const { return naive; }
+  //! Get whether single-tree mode is used.
+  bool SingleMode() const { return singleMode; }
+  //! Modify whether single-tree mode is used.
+  bool& SingleMode() { return singleMode; }
+
+  //! Get the kernel.
+  const KernelType& Kernel() const { return kernel; }
+  //! Modify the kernel.
+  KernelType& Kernel() { return kernel; }
+
+  //! Get the reference tree (NULL in naive mode or before Train()).
+  const Tree* ReferenceTree() const { return referenceTree; }
+
+  //! Get the number of base cases of the last call to Evaluate().
+  size_t BaseCases() const { return baseCases; }
+  //! Get the number of scores of the last call to Evaluate().
+  size_t Scores() const { return scores; }
+  //! Get the number of approximations of the last call to Evaluate().
+  size_t Approximations() const { return approximations; }
+
+ private:
+  //! The relative error tolerance.
+  double relError;
+  //! The absolute error tolerance.
+  double absError;
+  //! The instantiated kernel.
+  KernelType kernel;
+  //! If true, O(n^2) naive computation is used.
+  bool naive;
+  //! If true, single-tree computation is used.
+  bool singleMode;
+  //! The instantiated metric.
+  MetricType metric;
+
+  //! Mappings to old reference indices (used when this object builds trees).
+  std::vector<size_t> oldFromNewReferences;
+  //! Reference tree (NULL in naive mode).
+  Tree* referenceTree;
+  //! Reference dataset (NULL before Train()).
+  const MatType* referenceSet;
+  //! If true, this object owns the reference set (only in naive mode).
+  bool setOwner;
+
+  //! The number of base cases of the last evaluation.
+  size_t baseCases;
+  //! The number of scores of the last evaluation.
+  size_t scores;
+  //! The number of approximations of the last evaluation.
+  size_t approximations;
+
+  //! Check the error tolerances and the query set.
+  void CheckEvaluation(const MatType& querySet) const;
+
+  //! Add the kernel sums over the reference set of the given query points (in
+  //! the order of querySet) with brute force.
+  void NaiveEvaluate(const MatType& querySet, arma::vec& estimations);
+
+  //! Free the reference tree and set.
+  void Clear();
+
+  // Copying would share the reference tree.
+  KDE(const KDE& other);
+  KDE& operator=(const KDE& other);
+};
+
+} // namespace kde
+} // namespace mlpack
+
+// Include implementation.
+#include "kde_impl.hpp"
+
+#endif
@@ -0,0 +1,376 @@
+/**
+ * @file kde_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the KDE class.
+ */
+#ifndef __MLPACK_METHODS_KDE_KDE_IMPL_HPP
+#define __MLPACK_METHODS_KDE_KDE_IMPL_HPP
+
+// Just in case it hasn't been included.
+#include "kde.hpp"
+
+// The rules for traversal.
+#include "kde_rules.hpp"
+
+namespace mlpack {
+namespace kde {
+
+//! Call the tree constructor that does mapping.
+template<typename TreeType>
+TreeType* BuildTree(
+    typename TreeType::Mat& dataset,
+    std::vector<size_t>& oldFromNew,
+    typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == true, TreeType*
+    >::type = 0)
+{
+  return new TreeType(dataset, oldFromNew);
+}
+
+//! Call the tree constructor that does not do mapping.
+template<typename TreeType>
+TreeType* BuildTree(
+    const typename TreeType::Mat& dataset,
+    const std::vector<size_t>& /* oldFromNew */,
+    const typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == false, TreeType*
+    >::type = 0)
+{
+  return new TreeType(dataset);
+}
+
+//! Call the tree constructor that does mapping, taking ownership of the data.
+template<typename TreeType>
+TreeType* BuildTree(
+    typename TreeType::Mat&& dataset,
+    std::vector<size_t>& oldFromNew,
+    const typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == true, TreeType*
+    >::type = 0)
+{
+  return new TreeType(std::move(dataset), oldFromNew);
+}
+
+//! Call the tree constructor that does not do mapping, taking ownership of the
+//! data.
+template<typename TreeType>
+TreeType* BuildTree(
+    typename TreeType::Mat&& dataset,
+    const std::vector<size_t>& /* oldFromNew */,
+    const typename boost::enable_if_c<
+        tree::TreeTraits<TreeType>::RearrangesDataset == false, TreeType*
+    >::type = 0)
+{
+  return new TreeType(std::move(dataset));
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+KDE<KernelType, MetricType, MatType, TreeType>::KDE(
+    const double relError,
+    const double absError,
+    const KernelType kernel,
+    const bool naive,
+    const bool singleMode,
+    const MetricType metric) :
+    relError(relError),
+    absError(absError),
+    kernel(kernel),
+    naive(naive),
+    singleMode(!naive && singleMode), // Naive overrides single mode.
+    metric(metric),
+    referenceTree(NULL),
+    referenceSet(NULL),
+    setOwner(false),
+    baseCases(0),
+    scores(0),
+    approximations(0)
+{
+  if (relError < 0.0 || absError < 0.0)
+  {
+    std::ostringstream oss;
+    oss << "KDE::KDE(): error tolerances (" << relError << " relative, "
+        << absError << " absolute) must not be negative";
+    throw std::invalid_argument(oss.str());
+  }
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+KDE<KernelType, MetricType, MatType, TreeType>::~KDE()
+{
+  Clear();
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void KDE<KernelType, MetricType, MatType, TreeType>::Train(
+    const MatType& referenceSet)
+{
+  // The tree may hold on to its dataset, so it gets its own copy.
+  Train(MatType(referenceSet));
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void KDE<KernelType, MetricType, MatType, TreeType>::Train(
+    MatType&& referenceSet)
+{
+  Clear();
+
+  if (naive)
+  {
+    this->referenceSet = new MatType(std::move(referenceSet));
+    setOwner = true;
+  }
+  else
+  {
+    Timer::Start("kde/tree_building");
+    referenceTree = BuildTree<Tree>(std::move(referenceSet),
+        oldFromNewReferences);
+    this->referenceSet = &referenceTree->Dataset();
+    Timer::Stop("kde/tree_building");
+  }
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void KDE<KernelType, MetricType, MatType, TreeType>::Evaluate(
+    const MatType& querySet,
+    arma::vec& estimations)
+{
+  CheckEvaluation(querySet);
+  baseCases = 0;
+  scores = 0;
+  approximations = 0;
+
+  typedef KDERules<MetricType, KernelType, Tree> RuleType;
+  estimations.zeros(querySet.n_cols);
+
+  if (naive)
+  {
+    Timer::Start("kde/computing_estimations");
+    NaiveEvaluate(querySet, estimations);
+    Timer::Stop("kde/computing_estimations");
+  }
+  else if (singleMode)
+  {
+    typedef typename Tree::template SingleTreeTraverser<RuleType>
+        TraverserType;
+
+    Timer::Start("kde/computing_estimations");
+    RuleType rules(*referenceSet, querySet, estimations, relError, absError,
+        metric, kernel);
+    TraverserType traverser(rules);
+
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+      traverser.Traverse(i, *referenceTree);
+
+    baseCases = rules.BaseCases();
+    scores = rules.Scores();
+    approximations = rules.Approximations();
+    Timer::Stop("kde/computing_estimations");
+  }
+  else
+  {
+    typedef typename Tree::template DualTreeTraverser<RuleType> TraverserType;
+
+    // Build the query tree; it may rearrange (its copy of) the query points.
+    Timer::Start("kde/tree_building");
+    std::vector<size_t> oldFromNewQueries;
+    Tree* queryTree = BuildTree<Tree>(const_cast<MatType&>(querySet),
+        oldFromNewQueries);
+    Timer::Stop("kde/tree_building");
+
+    Timer::Start("kde/computing_estimations");
+    arma::vec treeEstimations(querySet.n_cols, arma::fill::zeros);
+    RuleType rules(*referenceSet, queryTree->Dataset(), treeEstimations,
+        relError, absError, metric, kernel);
+    TraverserType traverser(rules);
+    traverser.Traverse(*queryTree, *referenceTree);
+
+    baseCases = rules.BaseCases();
+    scores = rules.Scores();
+    approximations = rules.Approximations();
+
+    // Map the estimations back to the order of the query set.
+    if (tree::TreeTraits<Tree>::RearrangesDataset)
+    {
+      for (size_t i = 0; i < treeEstimations.n_elem; ++i)
+        estimations[oldFromNewQueries[i]] = treeEstimations[i];
+    }
+    else
+    {
+      estimations = std::move(treeEstimations);
+    }
+
+    delete queryTree;
+    Timer::Stop("kde/computing_estimations");
+  }
+
+  estimations /= referenceSet->n_cols;
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void KDE<KernelType, MetricType, MatType, TreeType>::Evaluate(
+    arma::vec& estimations)
+{
+  if (referenceSet == NULL)
+    throw std::invalid_argument("KDE::Evaluate(): no reference set; call "
+        "Train() first");
+
+  // In naive mode the reference set is in its original order.
+  if (naive)
+  {
+    Evaluate(*referenceSet, estimations);
+    return;
+  }
+
+  CheckEvaluation(*referenceSet);
+  baseCases = 0;
+  scores = 0;
+  approximations = 0;
+
+  typedef KDERules<MetricType, KernelType, Tree> RuleType;
+
+  Timer::Start("kde/computing_estimations");
+  arma::vec treeEstimations(referenceSet->n_cols, arma::fill::zeros);
+  RuleType rules(*referenceSet, *referenceSet, treeEstimations, relError,
+      absError, metric, kernel);
+
+  // The reference tree is its own query tree.
+  if (singleMode)
+  {
+    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
+    for (size_t i = 0; i < referenceSet->n_cols; ++i)
+      traverser.Traverse(i, *referenceTree);
+  }
+  else
+  {
+    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+    traverser.Traverse(*referenceTree, *referenceTree);
+  }
+
+  baseCases = rules.BaseCases();
+  scores = rules.Scores();
+  approximations = rules.Approximations();
+
+  // Map the estimations back to the order of the dataset given to Train().
+  if (tree::TreeTraits<Tree>::RearrangesDataset)
+  {
+    estimations.set_size(treeEstimations.n_elem);
+    for (size_t i = 0; i < treeEstimations.n_elem; ++i)
+      estimations[oldFromNewReferences[i]] = treeEstimations[i];
+  }
+  else
+  {
+    estimations = std::move(treeEstimations);
+  }
+  Timer::Stop("kde/computing_estimations");
+
+  estimations /= referenceSet->n_cols;
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void KDE<KernelType, MetricType, MatType, TreeType>::CheckEvaluation(
+    const MatType& querySet) const
+{
+  if (referenceSet == NULL)
+    throw std::invalid_argument("KDE::Evaluate(): no reference set; call "
+        "Train() first");
+
+  if (relError < 0.0 || absError < 0.0)
+  {
+    std::ostringstream oss;
+    oss << "KDE::Evaluate(): error tolerances (" << relError << " relative, "
+        << absError << " absolute) must not be negative";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (querySet.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "KDE::Evaluate(): dimensionality of query set (" << querySet.n_rows
+        << ") is not equal to the dimensionality of the reference set ("
+        << referenceSet->n_rows << ")";
+    throw std::invalid_argument(oss.str());
+  }
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void KDE<KernelType, MetricType, MatType, TreeType>::NaiveEvaluate(
+    const MatType& querySet,
+    arma::vec& estimations)
+{
+  // Each query point is only touched by one thread.
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+  {
+    double sum = 0.0;
+    for (size_t j = 0; j < referenceSet->n_cols; ++j)
+      sum += kernel.Evaluate(metric.Evaluate(querySet.col(i),
+          referenceSet->col(j)));
+    estimations[i] += sum;
+  }
+
+  baseCases = querySet.n_cols * referenceSet->n_cols;
+}
+
+template<typename KernelType,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void KDE<KernelType, MetricType, MatType, TreeType>::Clear()
+{
+  delete referenceTree;
+  if (setOwner)
+    delete referenceSet;
+
+  referenceTree = NULL;
+  referenceSet = NULL;
+  setOwner = false;
+  oldFromNewReferences.clear();
+}
+
+} // namespace kde
+} // namespace mlpack
+
+#endif
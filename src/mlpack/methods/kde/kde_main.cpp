@@ -0,0 +1,181 @@
+/**
+ * @file kde_main.cpp
+ * @author Ryan Curtin
+ *
+ * Executable for kernel density estimation with single-tree or dual-tree
+ * algorithms.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/kernels/epanechnikov_kernel.hpp>
+#include <mlpack/core/kernels/laplacian_kernel.hpp>
+#include <mlpack/core/kernels/triangular_kernel.hpp>
+#include <mlpack/core/kernels/spherical_kernel.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/tree/rectangle_tree.hpp>
+
+#include "kde.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::kde;
+using namespace mlpack::kernel;
+using namespace mlpack::tree;
+using namespace mlpack::metric;
+
+PROGRAM_INFO("Kernel Density Estimation",
+    "This program estimates the density of the reference points at each query "
+    "point with a kernel: the estimation at a query point is the average of "
+    "the kernel between it and each reference point.  (It is not divided by "
+    "the normalizing constant of the kernel, so it is only proportional to a "
+    "density; for anomaly scoring, points with low estimations are outliers.) "
+    " If no query file is given, the density is estimated at each reference "
+    "point (its kernel with itself is included)."
+    "\n\n"
+    "By default, a dual-tree algorithm is used: a pair of nodes is pruned when "
+    "the kernel values between them are close enough to be approximated, so "
+    "that each estimation is within --rel_error times the exact estimation, "
+    "plus --abs_error.  --single_mode uses single-tree search instead, and "
+    "--naive computes every kernel value."
+    "\n\n"
+    "The kernel is chosen with --kernel ('gaussian', 'epanechnikov', "
+    "'laplacian', 'triangular', or 'spherical'), and its bandwidth with "
+    "--bandwidth; the tree type is chosen with --tree_type ('kd', 'ball', "
+    "'cover', or 'r')."
+    "\n\n"
+    "For example, the following will save the density estimation at each point "
+    "of 'query.csv' of the points in 'reference.csv', with a Gaussian kernel of"
+    " bandwidth 0.5, to 'density.csv':"
+    "\n\n"
+    "$ kde --reference_file=reference.csv --query_file=query.csv\n"
+    "  --bandwidth=0.5 --output_file=density.csv");
+
+PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
+    "r");
+PARAM_STRING("query_file", "File containing query points (optional).", "q", "");
+PARAM_STRING("output_file", "File to save the density estimation of each query"
+    " point to.", "o", "");
+
+PARAM_STRING("kernel", "Kernel to use: 'gaussian', 'epanechnikov', "
+    "'laplacian', 'triangular', or 'spherical'.", "k", "gaussian");
+PARAM_DOUBLE("bandwidth", "Bandwidth of the kernel.", "b", 1.0);
+PARAM_STRING("tree_type", "Type of tree to use: 'kd', 'ball', 'cover', or 'r'.",
+    "t", "kd");
+
+PARAM_DOUBLE("rel_error", "Relative error tolerance of each estimation.", "e",
+    0.05);
+PARAM_DOUBLE("abs_error", "Absolute error tolerance of each estimation.", "E",
+    0.0);
+PARAM_FLAG("naive", "If true, O(n^2) naive mode is used for computation.", "N");
+PARAM_FLAG("single_mode", "If true, single-tree search is used (as opposed to "
+    "dual-tree search).", "S");
+
+// Given the kernel, figure out the tree type and run KDE.
+template<typename KernelType>
+void FindTreeType(const KernelType& kernel);
+
+// Given the kernel and the tree type, load the data and run KDE.
+template<typename KernelType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RunKDE(const KernelType& kernel);
+
+int main(int argc, char *argv[])
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  const double bandwidth = CLI::GetParam<double>("bandwidth");
+  if (bandwidth <= 0.0)
+    Log::Fatal << "Invalid bandwidth (" << bandwidth << "); must be greater "
+        << "than 0." << endl;
+
+  if (CLI::GetParam<double>("rel_error") < 0.0 ||
+      CLI::GetParam<double>("abs_error") < 0.0)
+    Log::Fatal << "--rel_error and --abs_error must not be negative." << endl;
+
+  if (!CLI::HasParam("output_file"))
+    Log::Warn << "--output_file is not specified, so no results will be saved!"
+        << endl;
+
+  const string kernelType = CLI::GetParam<string>("kernel");
+  if (kernelType == "gaussian")
+    FindTreeType(GaussianKernel(bandwidth));
+  else if (kernelType == "epanechnikov")
+    FindTreeType(EpanechnikovKernel(bandwidth));
+  else if (kernelType == "laplacian")
+    FindTreeType(LaplacianKernel(bandwidth));
+  else if (kernelType == "triangular")
+    FindTreeType(TriangularKernel(bandwidth));
+  else if (kernelType == "spherical")
+    FindTreeType(SphericalKernel(bandwidth));
+  else
+    Log::Fatal << "Unknown kernel '" << kernelType << "'; valid choices are "
+        << "'gaussian', 'epanechnikov', 'laplacian', 'triangular', and "
+        << "'spherical'." << endl;
+}
+
+template<typename KernelType>
+void FindTreeType(const KernelType& kernel)
+{
+  const string treeType = CLI::GetParam<string>("tree_type");
+  if (treeType == "kd")
+    RunKDE<KernelType, KDTree>(kernel);
+  else if (treeType == "ball")
+    RunKDE<KernelType, BallTree>(kernel);
+  else if (treeType == "cover")
+    RunKDE<KernelType, StandardCoverTree>(kernel);
+  else if (treeType == "r")
+    RunKDE<KernelType, RTree>(kernel);
+  else
+    Log::Fatal << "Unknown tree type '" << treeType << "'; valid choices are "
+        << "'kd', 'ball', 'cover', and 'r'." << endl;
+}
+
+template<typename KernelType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RunKDE(const KernelType& kernel)
+{
+  arma::mat referenceSet;
+  data::Load(CLI::GetParam<string>("reference_file"), referenceSet, true);
+  Log::Info << "Loaded reference data from '"
+      << CLI::GetParam<string>("reference_file") << "' ("
+      << referenceSet.n_rows << " x " << referenceSet.n_cols << ")." << endl;
+
+  KDE<KernelType, EuclideanDistance, arma::mat, TreeType> kde(
+      CLI::GetParam<double>("rel_error"), CLI::GetParam<double>("abs_error"),
+      kernel, CLI::HasParam("naive"), CLI::HasParam("single_mode"));
+
+  arma::vec estimations;
+  try
+  {
+    kde.Train(std::move(referenceSet));
+
+    if (CLI::HasParam("query_file"))
+    {
+      arma::mat querySet;
+      data::Load(CLI::GetParam<string>("query_file"), querySet, true);
+      Log::Info << "Loaded query data from '"
+          << CLI::GetParam<string>("query_file") << "' (" << querySet.n_rows
+          << " x " << querySet.n_cols << ")." << endl;
+
+      kde.Evaluate(querySet, estimations);
+    }
+    else
+    {
+      kde.Evaluate(estimations);
+    }
+  }
+  catch (std::exception& e)
+  {
+    Log::Fatal << e.what() << endl;
+  }
+
+  Log::Info << kde.BaseCases() << " base cases, " << kde.Scores() << " scores, "
+      << "and " << kde.Approximations() << " approximations." << endl;
+
+  if (CLI::HasParam("output_file"))
+    data::Save(CLI::GetParam<string>("output_file"), estimations);
+}
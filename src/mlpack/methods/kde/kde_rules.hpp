@@ -0,0 +1,178 @@
+/**
+ * @file kde_rules.hpp
+ * @author Ryan Curtin
+ *
+ * Rules for dual-tree (and single-tree) kernel density estimation, so that it
+ * can be done with arbitrary tree types.
+ */
+#ifndef __MLPACK_METHODS_KDE_KDE_RULES_HPP
+#define __MLPACK_METHODS_KDE_KDE_RULES_HPP
+
+#include <mlpack/core.hpp>
+#include "../neighbor_search/ns_traversal_info.hpp"
+
+namespace mlpack {
+namespace kde {
+
+/**
+ * The rules for kernel density estimation.  For each query point, the sum of
+ * the kernel values between it and every reference point is accumulated.  The
+ * kernel must satisfy KernelTraits<KernelType>::DecreasesWithDistance, so that
+ * the range of distances between a query point (or node) and a reference node
+ * gives the range of kernel values between them.  When that range is small
+ * enough, every reference point of the node is given the middle of the range
+ * of kernel values, and the node is pruned; so the error of the contribution
+ * of each reference point is at most
+ *
+ * @code
+ * relError * K(q, r) + absError,
+ * @endcode
+ *
+ * and the error of the sum is bounded in the same way.
+ */
+template<typename MetricType, typename KernelType, typename TreeType>
+class KDERules
+{
+ public:
+  /**
+   * Construct the KDERules object.  This is usually done from within the KDE
+   * class at evaluation time.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param estimations Vector to add the kernel sum of each query point to (it
+   *      must be filled with zeros).
+   * @param relError Relative error tolerance of each kernel value.
+   * @param absError Absolute error tolerance of each kernel value.
+   * @param metric Instantiated metric.
+   * @param kernel Instantiated kernel.
+   */
+  KDERules(const arma::mat& referenceSet,
+           const arma::mat& querySet,
+           arma::vec& estimations,
+           const double relError,
+           const double absError,
+           MetricType& metric,
+           KernelType& kernel);
+
+  /**
+   * Compute the base case between the given query point and reference point,
+   * and add the kernel value to the estimation of the query point.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceIndex Index of reference point.
+   */
+  double BaseCase(const size_t queryIndex, const size_t referenceIndex);
+
+  /**
+   * Get the score for recursion order.  If the kernel values between the query
+   * point and the reference node are close enough, they are approximated and
+   * DBL_MAX is returned (the node is pruned).
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceNode Candidate node to be recursed into.
+   */
+  double Score(const size_t queryIndex, TreeType& referenceNode);
+
+  /**
+   * Re-evaluate the score for recursion order.  A node is never approximated
+   * after it was scored, so this returns the old score.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceNode Candidate node to be recursed into.
+   * @param oldScore Old score produced by Score() (or Rescore()).
+   */
+  double Rescore(const size_t queryIndex,
+                 TreeType& referenceNode,
+                 const double oldScore) const;
+
+  /**
+   * Get the score for recursion order.  If the kernel values between every
+   * point of the query node and the reference node are close enough, they are
+   * approximated and DBL_MAX is returned (the node combination is pruned).
+   *
+   * @param queryNode Candidate query node to recurse into.
+   * @param referenceNode Candidate reference node to recurse into.
+   */
+  double Score(TreeType& queryNode, TreeType& referenceNode);
+
+  /**
+   * Re-evaluate the score for recursion order.  A node combination is never
+   * approximated after it was scored, so this returns the old score.
+   *
+   * @param queryNode Candidate query node to recurse into.
+   * @param referenceNode Candidate reference node to recurse into.
+   * @param oldScore Old score produced by Score() (or Rescore()).
+   */
+  double Rescore(TreeType& queryNode,
+                 TreeType& referenceNode,
+                 const double oldScore) const;
+
+  typedef neighbor::NeighborSearchTraversalInfo<TreeType> TraversalInfoType;
+
+  const TraversalInfoType& TraversalInfo() const { return traversalInfo; }
+  TraversalInfoType& TraversalInfo() { return traversalInfo; }
+
+  //! Get the number of base cases.
+  size_t BaseCases() const { return baseCases; }
+  //! Get the number of scores (that is, calls to RangeDistance()).
+  size_t Scores() const { return scores; }
+  //! Get the number of times that the kernel values between a query point and
+  //! a reference node were approximated.
+  size_t Approximations() const { return approximations; }
+
+ private:
+  //! The reference set.
+  const arma::mat& referenceSet;
+  //! The query set.
+  const arma::mat& querySet;
+  //! The kernel sum of each query point.
+  arma::vec& estimations;
+  //! The relative error tolerance.
+  const double relError;
+  //! The absolute error tolerance.
+  const double absError;
+  //! The instantiated metric.
+  MetricType& metric;
+  //! The instantiated kernel.
+  KernelType& kernel;
+
+  //! The last query index.
+  size_t lastQueryIndex;
+  //! The last reference index.
+  size_t lastReferenceIndex;
+  //! The distance of the last base case.
+  double lastDistance;
+
+  //! Holds the last visited query and reference nodes.
+  TraversalInfoType traversalInfo;
+
+  //! The number of base cases.
+  size_t baseCases;
+  //! The number of scores.
+  size_t scores;
+  //! The number of approximations.
+  size_t approximations;
+
+  /**
+   * Return whether the kernel values over the given range of distances are
+   * close enough to be approximated, and set value to the approximation.
+   */
+  bool CanApproximate(const math::Range& distances, double& value) const;
+
+  /**
+   * Add the given approximate kernel value, once for each point of the given
+   * reference node, to the estimation of the given query point.
+   */
+  void AddApproximation(const size_t queryIndex,
+                        TreeType& referenceNode,
+                        const double value);
+};
+
+} // namespace kde
+} // namespace mlpack
+
+// Include implementation.
+#include "kde_rules_impl.hpp"
+
+#endif
@@ -0,0 +1,248 @@
+/**
+ * @file kde_rules_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of rules for kernel density estimation with generic trees.
+ */
+#ifndef __MLPACK_METHODS_KDE_KDE_RULES_IMPL_HPP
+#define __MLPACK_METHODS_KDE_KDE_RULES_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kde_rules.hpp"
+
+namespace mlpack {
+namespace kde {
+
+template<typename MetricType, typename KernelType, typename TreeType>
+KDERules<MetricType, KernelType, TreeType>::KDERules(
+    const arma::mat& referenceSet,
+    const arma::mat& querySet,
+    arma::vec& estimations,
+    const double relError,
+    const double absError,
+    MetricType& metric,
+    KernelType& kernel) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    estimations(estimations),
+    relError(relError),
+    absError(absError),
+    metric(metric),
+    kernel(kernel),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols),
+    lastDistance(0.0),
+    baseCases(0),
+    scores(0),
+    approximations(0)
+{
+  // Nothing to do.
+}
+
+//! The base case.  Evaluate the kernel between the two points and add it to
+//! the estimation of the query point.
+template<typename MetricType, typename KernelType, typename TreeType>
+inline force_inline
+double KDERules<MetricType, KernelType, TreeType>::BaseCase(
+    const size_t queryIndex,
+    const size_t referenceIndex)
+{
+  // If we have just performed this base case, don't add it again.
+  if ((lastQueryIndex == queryIndex) && (lastReferenceIndex == referenceIndex))
+    return lastDistance;
+
+  const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
+      referenceSet.unsafe_col(referenceIndex));
+  ++baseCases;
+
+  // Update last indices, so we don't accidentally perform a base case twice.
+  lastQueryIndex = queryIndex;
+  lastReferenceIndex = referenceIndex;
+  lastDistance = distance;
+
+  estimations[queryIndex] += kernel.Evaluate(distance);
+
+  return distance;
+}
+
+//! Single-tree scoring function.
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Score(
+    const size_t queryIndex,
+    TreeType& referenceNode)
+{
+  math::Range distances;
+
+  if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
+  {
+    // In this situation, we calculate the base case.  So we should check to be
+    // sure we haven't already done that.
+    double baseCase;
+    if (tree::TreeTraits<TreeType>::HasSelfChildren &&
+        (referenceNode.Parent() != NULL) &&
+        (referenceNode.Point(0) == referenceNode.Parent()->Point(0)))
+    {
+      // If the tree has self-children and this is a self-child, the base case
+      // was already calculated.
+      baseCase = referenceNode.Parent()->Stat().LastDistance();
+      lastQueryIndex = queryIndex;
+      lastReferenceIndex = referenceNode.Point(0);
+      lastDistance = baseCase;
+    }
+    else
+    {
+      // We must calculate the base case by hand.
+      baseCase = BaseCase(queryIndex, referenceNode.Point(0));
+    }
+
+    // This may be possibly loose for non-ball bound trees.
+    distances.Lo() = baseCase - referenceNode.FurthestDescendantDistance();
+    distances.Hi() = baseCase + referenceNode.FurthestDescendantDistance();
+
+    // Update last distance calculation.
+    referenceNode.Stat().LastDistance() = baseCase;
+  }
+  else
+  {
+    distances = referenceNode.RangeDistance(querySet.unsafe_col(queryIndex));
+    ++scores;
+  }
+
+  double value;
+  if (CanApproximate(distances, value))
+  {
+    AddApproximation(queryIndex, referenceNode, value);
+    return DBL_MAX; // We don't need to go any deeper.
+  }
+
+  // Closer nodes hold the largest kernel values, so visit them first.
+  return std::max(distances.Lo(), 0.0);
+}
+
+//! Single-tree rescoring function.
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Rescore(
+    const size_t /* queryIndex */,
+    TreeType& /* referenceNode */,
+    const double oldScore) const
+{
+  // If it wasn't pruned before, it isn't pruned now.
+  return oldScore;
+}
+
+//! Dual-tree scoring function.
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Score(
+    TreeType& queryNode,
+    TreeType& referenceNode)
+{
+  math::Range distances;
+  if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
+  {
+    // It is possible that the base case has already been calculated.
+    double baseCase = 0.0;
+    if ((traversalInfo.LastQueryNode() != NULL) &&
+        (traversalInfo.LastReferenceNode() != NULL) &&
+        (traversalInfo.LastQueryNode()->Point(0) == queryNode.Point(0)) &&
+        (traversalInfo.LastReferenceNode()->Point(0) == referenceNode.Point(0)))
+    {
+      baseCase = traversalInfo.LastBaseCase();
+
+      // Make sure that if BaseCase() is called, we don't add it again.
+      lastQueryIndex = queryNode.Point(0);
+      lastReferenceIndex = referenceNode.Point(0);
+      lastDistance = baseCase;
+    }
+    else
+    {
+      // We must calculate the base case.
+      baseCase = BaseCase(queryNode.Point(0), referenceNode.Point(0));
+    }
+
+    distances.Lo() = baseCase - queryNode.FurthestDescendantDistance()
+        - referenceNode.FurthestDescendantDistance();
+    distances.Hi() = baseCase + queryNode.FurthestDescendantDistance()
+        + referenceNode.FurthestDescendantDistance();
+
+    // Update the last distances performed for the query and reference node.
+    traversalInfo.LastBaseCase() = baseCase;
+  }
+  else
+  {
+    // Just perform the calculation.
+    distances = referenceNode.RangeDistance(&queryNode);
+    ++scores;
+  }
+
+  // If the kernel values are close enough for every pair of points, every
+  // query point in the query node gets the approximation.
+  double value;
+  if (CanApproximate(distances, value))
+  {
+    for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
+      AddApproximation(queryNode.Descendant(i), referenceNode, value);
+    return DBL_MAX; // We don't need to go any deeper.
+  }
+
+  traversalInfo.LastQueryNode() = &queryNode;
+  traversalInfo.LastReferenceNode() = &referenceNode;
+  return std::max(distances.Lo(), 0.0);
+}
+
+//! Dual-tree rescoring function.
+template<typename MetricType, typename KernelType, typename TreeType>
+double KDERules<MetricType, KernelType, TreeType>::Rescore(
+    TreeType& /* queryNode */,
+    TreeType& /* referenceNode */,
+    const double oldScore) const
+{
+  // If it wasn't pruned before, it isn't pruned now.
+  return oldScore;
+}
+
+//! Decide whether the kernel values over a range of distances can be
+//! approximated by a single value.
+template<typename MetricType, typename KernelType, typename TreeType>
+bool KDERules<MetricType, KernelType, TreeType>::CanApproximate(
+    const math::Range& distances,
+    double& value) const
+{
+  // The kernel decreases with the distance, so its largest value is at the
+  // smallest distance.  The middle of the range of kernel values is within
+  // half the width of the range of every kernel value in it; that must be
+  // within the tolerance for the smallest kernel value.
+  const double maxKernel = kernel.Evaluate(std::max(distances.Lo(), 0.0));
+  const double minKernel = kernel.Evaluate(distances.Hi());
+  value = (maxKernel + minKernel) / 2.0;
+
+  return (maxKernel - minKernel) <= 2.0 * (relError * minKernel + absError);
+}
+
+//! Add the approximation for all the points in the given node to the
+//! estimation of the given query point.
+template<typename MetricType, typename KernelType, typename TreeType>
+void KDERules<MetricType, KernelType, TreeType>::AddApproximation(
+    const size_t queryIndex,
+    TreeType& referenceNode,
+    const double value)
+{
+  // Some types of trees calculate the base case evaluation before Score() is
+  // called, so if the base case has already been calculated, then we must avoid
+  // adding that point to the estimation again.
+  size_t baseCaseMod = 0;
+  if (tree::TreeTraits<TreeType>::FirstPointIsCentroid &&
+      (queryIndex == lastQueryIndex) &&
+      (referenceNode.Point(0) == lastReferenceIndex))
+  {
+    baseCaseMod = 1;
+  }
+
+  estimations[queryIndex] += (referenceNode.NumDescendants() - baseCaseMod) *
+      value;
+  ++approximations;
+}
+
+} // namespace kde
+} // namespace mlpack
+
+#endif
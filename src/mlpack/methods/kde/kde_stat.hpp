@@ -0,0 +1,57 @@
+/**
+ * @file kde_stat.hpp
+ * @author Ryan Curtin
+ *
+ * Statistic class for KDE, which holds the last base case result of the node.
+ */
+#ifndef __MLPACK_METHODS_KDE_KDE_STAT_HPP
+#define __MLPACK_METHODS_KDE_KDE_STAT_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kde {
+
+/**
+ * Statistic class for KDE, to be set to the StatisticType of the tree type
+ * that kernel density estimation is performed with.  This class just holds the
+ * distance of the last base case of the node, so that trees whose first point
+ * is the centroid of the node do not evaluate it twice.
+ */
+class KDEStat
+{
+ public:
+  /**
+   * Initialize the statistic.
+   */
+  KDEStat() : lastDistance(0.0) { }
+
+  /**
+   * Initialize the statistic given a tree node that this statistic belongs to.
+   * In this case, we ignore the node.
+   */
+  template<typename TreeType>
+  KDEStat(TreeType& /* node */) :
+      lastDistance(0.0) { }
+
+  //! Get the last distance evaluation.
+  double LastDistance() const { return lastDistance; }
+  //! Modify the last distance evaluation.
+  double& LastDistance() { return lastDistance; }
+
+  //! Serialize the statistic.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(lastDistance, "lastDistance");
+  }
+
+ private:
+  //! The last distance evaluation.
+  double lastDistance;
+};
+
+} // namespace kde
+} // namespace mlpack
+
+#endif
@@ -54,7 +54,8 @@ class KernelPCA
    * @param transformedData Matrix to output results into.
    * @param eigval KPCA eigenvalues will be written to this vector.
    * @param eigvec KPCA eigenvectors will be written to this matrix.
-   * @param newDimension New dimension for the dataset.
+   * @param newDimension New dimension for the dataset.  The kernel rule may
+   *     find only this many eigenpairs, instead of all of them.
    */
   void Apply(const arma::mat& data,
              arma::mat& transformedData,
@@ -72,7 +72,8 @@ void KernelPCA<KernelType, KernelRule>::Apply(arma::mat& data,
 
   Apply(data, data, eigVal, coeffs, newDimension);
 
-  if (newDimension < coeffs.n_rows && newDimension > 0)
+  // The kernel rule may have only found newDimension eigenpairs already.
+  if (newDimension < data.n_rows && newDimension > 0)
     data.shed_rows(newDimension, data.n_rows - 1);
 }
 
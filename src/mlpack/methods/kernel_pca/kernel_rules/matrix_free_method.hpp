@@ -0,0 +1,130 @@
+/**
+ * @file matrix_free_method.hpp
+ * @author Ryan Curtin
+ *
+ * Use the exact kernel matrix without storing it, for the top eigenpairs only.
+ */
+#ifndef __MLPACK_METHODS_KERNEL_PCA_MATRIX_FREE_METHOD_HPP
+#define __MLPACK_METHODS_KERNEL_PCA_MATRIX_FREE_METHOD_HPP
+
+#include <mlpack/core.hpp>
+#include "partial_eig_sym.hpp"
+
+namespace mlpack {
+namespace kpca {
+
+/**
+ * Exact kernel PCA for the top eigenpairs only, without storing the n x n
+ * kernel matrix.  The eigenpairs of the centered kernel matrix are found with
+ * PartialEigSym(), and each product with the kernel matrix evaluates it again,
+ * in blocks of kernel::kernelMatrixTileSize rows (in parallel, if mlpack is
+ * compiled with OpenMP).  This takes O(n (rank + partialEigSymOversampling))
+ * memory, instead of the O(n^2) of NaiveKernelRule, in exchange for evaluating
+ * the kernel matrix once per iteration.  The results are the same as those of
+ * NaiveKernelRule, up to the tolerance of PartialEigSym() and the signs of the
+ * eigenvectors.
+ *
+ * @tparam KernelType Kernel to use.
+ */
+template<typename KernelType>
+class MatrixFreeKernelRule
+{
+  public:
+    /**
+     * Apply kernel PCA with the exact kernel matrix, without storing it.
+     *
+     * @param data Input data points.
+     * @param transformedData Matrix to output results into.
+     * @param eigval KPCA eigenvalues will be written to this vector.
+     * @param eigvec KPCA eigenvectors will be written to this matrix.
+     * @param rank Number of eigenpairs to find (at most the number of points;
+     *     all of them if 0).
+     * @param kernel Kernel to be used for computation.
+     */
+    static void ApplyKernelMatrix(const arma::mat& data,
+                                  arma::mat& transformedData,
+                                  arma::vec& eigval,
+                                  arma::mat& eigvec,
+                                  const size_t rank,
+                                  KernelType kernel = KernelType())
+    {
+      const size_t k = (rank == 0) ? data.n_cols :
+          std::min(rank, (size_t) data.n_cols);
+
+      // The centered kernel matrix is K - 1 m^T - m 1^T + mean(m) 1 1^T, where
+      // m holds the means of the rows (and columns) of K.
+      CenteredKernelProduct product(data, kernel);
+      PartialEigSym(product, data.n_cols, k, eigval, eigvec);
+
+      // The projection of the points onto the eigenvectors is
+      // (V^T K) / sqrt(lambda) = sqrt(lambda) V^T.
+      transformedData = arma::diagmat(arma::sqrt(eigval)) *
+          arma::trans(eigvec);
+    }
+
+  private:
+    //! The product with the centered kernel matrix, for PartialEigSym().
+    class CenteredKernelProduct
+    {
+     public:
+      CenteredKernelProduct(const arma::mat& data, KernelType& kernel) :
+          data(data),
+          kernel(kernel)
+      {
+        // The means of the rows of the kernel matrix are its product with a
+        // vector of ones.
+        KernelTimes(arma::ones<arma::mat>(data.n_cols, 1), rowMean);
+        rowMean /= data.n_cols;
+        mean = arma::accu(rowMean) / data.n_cols;
+      }
+
+      void operator()(const arma::mat& x, arma::mat& y) const
+      {
+        KernelTimes(x, y);
+
+        const arma::rowvec xSum = arma::sum(x, 0);
+        const arma::rowvec xMean = arma::trans(rowMean) * x;
+        y.each_row() -= xMean;
+        y -= rowMean * xSum;
+        y.each_row() += mean * xSum;
+      }
+
+     private:
+      //! Set y to the product of the (uncentered) kernel matrix and x.
+      void KernelTimes(const arma::mat& x, arma::mat& y) const
+      {
+        y.set_size(data.n_cols, x.n_cols);
+        const size_t blockSize = kernel::kernelMatrixTileSize;
+        const size_t blocks = (data.n_cols + blockSize - 1) / blockSize;
+
+        // Each block of rows of the kernel matrix is evaluated, used, and
+        // thrown away; each thread writes only its own rows of y.
+        #pragma omp parallel for schedule(dynamic, 1)
+        for (size_t b = 0; b < blocks; ++b)
+        {
+          const size_t begin = b * blockSize;
+          const size_t count = std::min(blockSize, data.n_cols - begin);
+          const arma::mat block(const_cast<double*>(data.colptr(begin)),
+              data.n_rows, count, false, true);
+
+          arma::mat rows;
+          kernel::BatchEvaluate(kernel, block, data, rows);
+          y.rows(begin, begin + count - 1) = rows * x;
+        }
+      }
+
+      //! The points.
+      const arma::mat& data;
+      //! The kernel.
+      KernelType& kernel;
+      //! The means of the rows of the kernel matrix.
+      arma::vec rowMean;
+      //! The mean of the kernel matrix.
+      double mean;
+    };
+};
+
+}; // namespace kpca
+}; // namespace mlpack
+
+#endif
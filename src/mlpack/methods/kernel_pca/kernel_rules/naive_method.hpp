@@ -9,6 +9,7 @@
 #define __MLPACK_METHODS_KERNEL_PCA_NAIVE_METHOD_HPP
 
 #include <mlpack/core.hpp>
+#include "partial_eig_sym.hpp"
 
 namespace mlpack {
 namespace kpca {
@@ -18,44 +19,29 @@ class NaiveKernelRule
 {
   public:
     /**
-     * Construct the exact kernel matrix.
+     * Construct the exact kernel matrix.  If only a few eigenpairs are needed
+     * (see UsePartialEigSym()), they are found with PartialEigSym() instead of
+     * a full eigendecomposition.
      *
      * @param data Input data points.
      * @param transformedData Matrix to output results into.
      * @param eigval KPCA eigenvalues will be written to this vector.
      * @param eigvec KPCA eigenvectors will be written to this matrix.
-     * @param rank Rank to be used for matrix approximation.
+     * @param rank Number of eigenpairs to find (all of them if rank is 0 or the
+     *     number of points).
      * @param kernel Kernel to be used for computation.
      */
     static void ApplyKernelMatrix(const arma::mat& data,
                                   arma::mat& transformedData,
                                   arma::vec& eigval,
                                   arma::mat& eigvec,
-                                  const size_t /* unused */,
+                                  const size_t rank,
                                   KernelType kernel = KernelType())
   {
-    // Construct the kernel matrix.
+    // Construct the kernel matrix.  Since it is symmetric, only the tiles on
+    // and above the diagonal are evaluated.
     arma::mat kernelMatrix;
-    // Resize the kernel matrix to the right size.
-    kernelMatrix.set_size(data.n_cols, data.n_cols);
-
-    // Note that we only need to calculate the upper triangular part of the
-    // kernel matrix, since it is symmetric. This helps minimize the number of
-    // kernel evaluations.
-    for (size_t i = 0; i < data.n_cols; ++i)
-    {
-      for (size_t j = i; j < data.n_cols; ++j)
-      {
-        // Evaluate the kernel on these two points.
-        kernelMatrix(i, j) = kernel.Evaluate(data.unsafe_col(i),
-                                             data.unsafe_col(j));
-      }
-    }
-
-    // Copy to the lower triangular part of the matrix.
-    for (size_t i = 1; i < data.n_cols; ++i)
-      for (size_t j = 0; j < i; ++j)
-        kernelMatrix(i, j) = kernelMatrix(j, i);
+    kernel::KernelMatrix(kernel, data, kernelMatrix);
 
     // For PCA the data has to be centered, even if the data is centered. But it
     // is not guaranteed that the data, when mapped to the kernel space, is also
@@ -67,6 +53,17 @@ class NaiveKernelRule
     kernelMatrix.each_row() -= rowMean;
     kernelMatrix += arma::sum(rowMean) / kernelMatrix.n_cols;
 
+    if (UsePartialEigSym(kernelMatrix.n_cols, rank))
+    {
+      // Only find the top eigenpairs of the centered kernel matrix.
+      MatrixProduct product(kernelMatrix);
+      PartialEigSym(product, kernelMatrix.n_cols, rank, eigval, eigvec);
+
+      transformedData = eigvec.t() * kernelMatrix;
+      transformedData.each_col() /= arma::sqrt(eigval);
+      return;
+    }
+
     // Eigendecompose the centered kernel matrix.
     arma::eig_sym(eigval, eigvec, kernelMatrix);
 
@@ -81,6 +78,22 @@ class NaiveKernelRule
     transformedData = eigvec.t() * kernelMatrix;
     transformedData.each_col() /= arma::sqrt(eigval);
   }
+
+  private:
+    //! The product with a stored matrix, for PartialEigSym().
+    class MatrixProduct
+    {
+     public:
+      MatrixProduct(const arma::mat& matrix) : matrix(matrix) { }
+
+      void operator()(const arma::mat& x, arma::mat& y) const
+      {
+        y = matrix * x;
+      }
+
+     private:
+      const arma::mat& matrix;
+    };
 };
 
 }; // namespace kpca
@@ -0,0 +1,123 @@
+/**
+ * @file partial_eig_sym.hpp
+ * @author Ryan Curtin
+ *
+ * A partial symmetric eigensolver, for the kernel rules that only need the top
+ * eigenpairs of the (centered) kernel matrix.
+ */
+#ifndef __MLPACK_METHODS_KERNEL_PCA_PARTIAL_EIG_SYM_HPP
+#define __MLPACK_METHODS_KERNEL_PCA_PARTIAL_EIG_SYM_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kpca {
+
+//! The number of extra directions of the subspace of PartialEigSym().
+const size_t partialEigSymOversampling = 10;
+
+/**
+ * Return whether PartialEigSym() should be used instead of a full
+ * eigendecomposition to find the top rank eigenpairs of an n x n matrix: this
+ * is the case when its subspace is small compared to the matrix, so that each
+ * iteration costs much less than the O(n^3) full decomposition.
+ */
+inline bool UsePartialEigSym(const size_t n, const size_t rank)
+{
+  return (rank > 0) && (4 * (rank + partialEigSymOversampling) <= n);
+}
+
+/**
+ * Find the rank eigenpairs of largest eigenvalue of a symmetric n x n positive
+ * semidefinite matrix, with block subspace iteration and a Rayleigh-Ritz
+ * projection at each step.  The matrix is only used through products with
+ * blocks of vectors, so it never has to be stored: op(x, y) must set y to the
+ * product of the matrix and x, which is n x (rank + partialEigSymOversampling)
+ * at most.
+ *
+ * The iteration stops when the residual || A v - lambda v || of each of the
+ * rank eigenpairs is at most tolerance times the largest eigenvalue, or after
+ * maxIterations products.  Each iteration takes one product and O(n l^2) time
+ * for the subspace of l = rank + partialEigSymOversampling vectors.  The
+ * iteration converges to the eigenvalues of largest magnitude, so the matrix
+ * should be positive semidefinite (as a centered kernel matrix is, for a
+ * positive definite kernel).
+ *
+ * @param op Function that multiplies the matrix by a block of vectors.
+ * @param n Size of the matrix.
+ * @param rank Number of eigenpairs to find.
+ * @param eigval Vector to store the eigenvalues in, largest first.
+ * @param eigvec Matrix to store the eigenvectors in (n x rank).
+ * @param tolerance Relative tolerance on the residuals.
+ * @param maxIterations Maximum number of products.
+ */
+template<typename OperatorType>
+void PartialEigSym(OperatorType& op,
+                   const size_t n,
+                   const size_t rank,
+                   arma::vec& eigval,
+                   arma::mat& eigvec,
+                   const double tolerance = 1e-8,
+                   const size_t maxIterations = 300)
+{
+  const size_t l = std::min(rank + partialEigSymOversampling, n);
+
+  arma::mat q, r, y, b, ritzVectors;
+  arma::vec ritzValues;
+  arma::qr_econ(q, r, arma::randn<arma::mat>(n, l));
+
+  size_t iteration = 0;
+  while (true)
+  {
+    op(q, y);
+    ++iteration;
+
+    // Project the matrix onto the subspace, and find the Ritz pairs, with the
+    // largest eigenvalues first.
+    b = arma::trans(q) * y;
+    b = 0.5 * (b + arma::trans(b));
+    arma::eig_sym(ritzValues, ritzVectors, b);
+    ritzValues = arma::flipud(ritzValues);
+    ritzVectors = arma::fliplr(ritzVectors);
+
+    // The product of the matrix and the Ritz vectors is y times the
+    // eigenvectors of b, so the residuals cost no more products.
+    eigvec = q * ritzVectors.cols(0, rank - 1);
+    y = y * ritzVectors;
+
+    const double scale = std::max(std::abs(ritzValues[0]), DBL_MIN);
+    double worstResidual = 0.0;
+    for (size_t i = 0; i < rank; ++i)
+    {
+      const double residual = arma::norm(y.col(i) - ritzValues[i] *
+          eigvec.col(i), 2);
+      worstResidual = std::max(worstResidual, residual / scale);
+    }
+
+    if (worstResidual <= tolerance)
+    {
+      Log::Debug << "PartialEigSym(): converged after " << iteration
+          << " iterations." << std::endl;
+      break;
+    }
+
+    if (iteration == maxIterations)
+    {
+      Log::Warn << "PartialEigSym(): reached the maximum number of iterations ("
+          << maxIterations << "); the largest relative residual is "
+          << worstResidual << "." << std::endl;
+      break;
+    }
+
+    // The next subspace is spanned by the product of the matrix and the
+    // current one.
+    arma::qr_econ(q, r, y);
+  }
+
+  eigval = ritzValues.subvec(0, rank - 1);
+}
+
+}; // namespace kpca
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * @file random_fourier_features.hpp
+ * @author Ryan Curtin
+ *
+ * Use random Fourier features for approximating the kernel matrix.
+ */
+
+#ifndef __MLPACK_METHODS_KERNEL_PCA_RANDOM_FOURIER_FEATURES_HPP
+#define __MLPACK_METHODS_KERNEL_PCA_RANDOM_FOURIER_FEATURES_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/methods/random_fourier_features/random_fourier_features.hpp>
+
+namespace mlpack {
+namespace kpca {
+
+/**
+ * Kernel PCA with random Fourier features: the points are mapped explicitly to
+ * NumFeatures features whose inner products approximate the kernel, and PCA is
+ * done on the features.  This takes O(n NumFeatures) memory instead of the
+ * O(n^2) of the exact kernel matrix.  The kernel must be shift-invariant (see
+ * kernel::RandomFourierFeatures).
+ *
+ * @tparam KernelType Shift-invariant kernel to approximate.
+ * @tparam NumFeatures Number of random features to use.
+ */
+template<typename KernelType, size_t NumFeatures = 512>
+class RandomFourierFeaturesKernelRule
+{
+  public:
+    /**
+     * Apply kernel PCA using random Fourier features.  The eigenvectors are the
+     * principal components in the space of the features (NumFeatures x
+     * NumFeatures).
+     *
+     * @param data Input data points.
+     * @param transformedData Matrix to output results into.
+     * @param eigval KPCA eigenvalues will be written to this vector.
+     * @param eigvec KPCA eigenvectors will be written to this matrix.
+     * @param rank Rank to be used for matrix approximation.
+     * @param kernel Kernel to be used for computation.
+     */
+    static void ApplyKernelMatrix(const arma::mat& data,
+                                  arma::mat& transformedData,
+                                  arma::vec& eigval,
+                                  arma::mat& eigvec,
+                                  const size_t /* unused */,
+                                  KernelType kernel = KernelType())
+    {
+      kernel::RandomFourierFeatures<KernelType> features(data.n_rows,
+          NumFeatures, kernel);
+      arma::mat z;
+      features.Transform(data, z);
+
+      // Since the feature map is explicit, the features can actually be
+      // centered, and the (centered) kernel matrix never has to be formed.
+      z.each_col() -= arma::mean(z, 1);
+
+      // The nonzero eigenvalues of z^T z (the approximate centered kernel
+      // matrix) are the eigenvalues of z z^T.
+      arma::eig_sym(eigval, eigvec, arma::mat(z * z.t()));
+
+      // Swap the eigenvalues since they are ordered backwards (we need largest
+      // to smallest).
+      for (size_t i = 0; i < floor(eigval.n_elem / 2.0); ++i)
+        eigval.swap_rows(i, (eigval.n_elem - 1) - i);
+
+      // Flip the coefficients to produce the same effect.
+      eigvec = arma::fliplr(eigvec);
+
+      transformedData = eigvec.t() * z;
+    }
+};
+
+}; // namespace kpca
+}; // namespace mlpack
+
+#endif
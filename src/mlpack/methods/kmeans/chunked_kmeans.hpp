@@ -0,0 +1,113 @@
+/**
+ * @file chunked_kmeans.hpp
+ * @author Ryan Curtin
+ *
+ * A k-means driver for datasets that do not fit in memory, which makes each
+ * Lloyd iteration one pass over the dataset on disk.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_CHUNKED_KMEANS_HPP
+#define __MLPACK_METHODS_KMEANS_CHUNKED_KMEANS_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/data/chunked_reader.hpp>
+#include "naive_kmeans.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * This class runs Lloyd's algorithm on a dataset that is read from disk one
+ * chunk at a time with a data::ChunkedReader, so the dataset never has to be in
+ * memory.  Each iteration is one pass over the file: the points of each chunk
+ * are assigned to their closest centroids with NaiveKMeans (so the parallelism
+ * and the blocked distance computations of NaiveKMeans are used), and the
+ * centroid sums and counts of the chunks are added up.  The reader loads the
+ * next chunk while the current one is processed.
+ *
+ * Unless initial centroids are given, they are k points of the dataset chosen
+ * uniformly at random in one extra pass (with reservoir sampling).  Empty
+ * clusters keep their centroid from the previous iteration.
+ *
+ * @code
+ * data::ChunkedReader reader("huge.bin", 1000000);
+ * ChunkedKMeans<> kmeans;
+ * arma::mat centroids;
+ * kmeans.Cluster(reader, 100, centroids);
+ *
+ * std::ofstream labels("labels.csv");
+ * kmeans.Assign(reader, centroids, labels);
+ * @endcode
+ *
+ * @tparam MetricType The distance metric to use.
+ */
+template<typename MetricType = metric::EuclideanDistance>
+class ChunkedKMeans
+{
+ public:
+  /**
+   * Create the ChunkedKMeans object.
+   *
+   * @param maxIterations Maximum number of iterations allowed before giving up
+   *     (0 means no limit).
+   * @param metric Optional MetricType object; for when the metric has state
+   *     it needs to store.
+   */
+  ChunkedKMeans(const size_t maxIterations = 1000,
+                const MetricType metric = MetricType());
+
+  /**
+   * Cluster the dataset of the given reader, storing the centroids.
+   *
+   * @param reader Reader of the dataset to cluster.
+   * @param clusters Number of clusters to compute.
+   * @param centroids Matrix in which the centroids are stored.
+   * @param initialGuess If true, then it is assumed that centroids contains the
+   *     initial centroids of each cluster.
+   */
+  void Cluster(data::ChunkedReader& reader,
+               const size_t clusters,
+               arma::mat& centroids,
+               const bool initialGuess = false);
+
+  /**
+   * Assign each point of the dataset of the given reader to its closest
+   * centroid, and write the results to the given stream, one line per point,
+   * without keeping them in memory.
+   *
+   * @param reader Reader of the dataset.
+   * @param centroids Cluster centroids.
+   * @param output Stream to write the results to.
+   * @param labelsOnly If true, each line holds only the cluster of the point;
+   *     otherwise it holds the point followed by its cluster.
+   * @param separator Character to separate the values of a line with.
+   */
+  void Assign(data::ChunkedReader& reader,
+              const arma::mat& centroids,
+              std::ostream& output,
+              const bool labelsOnly = true,
+              const char separator = ',');
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Set the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the distance metric.
+  const MetricType& Metric() const { return metric; }
+  //! Modify the distance metric.
+  MetricType& Metric() { return metric; }
+
+ private:
+  //! Maximum number of iterations before giving up.
+  size_t maxIterations;
+  //! Instantiated distance metric.
+  MetricType metric;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "chunked_kmeans_impl.hpp"
+
+#endif
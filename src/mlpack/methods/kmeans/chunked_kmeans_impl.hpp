@@ -0,0 +1,196 @@
+/**
+ * @file chunked_kmeans_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of ChunkedKMeans, the k-means driver for datasets on disk.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_CHUNKED_KMEANS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_CHUNKED_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "chunked_kmeans.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MetricType>
+ChunkedKMeans<MetricType>::ChunkedKMeans(const size_t maxIterations,
+                                         const MetricType metric) :
+    maxIterations(maxIterations),
+    metric(metric)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType>
+void ChunkedKMeans<MetricType>::Cluster(data::ChunkedReader& reader,
+                                        const size_t clusters,
+                                        arma::mat& centroids,
+                                        const bool initialGuess)
+{
+  if (clusters == 0 || clusters > reader.NumPoints())
+    Log::Fatal << "ChunkedKMeans::Cluster(): cannot find " << clusters
+        << " clusters in " << reader.NumPoints() << " points!" << std::endl;
+
+  arma::mat chunk;
+  if (initialGuess)
+  {
+    if (centroids.n_cols != clusters)
+      Log::Fatal << "ChunkedKMeans::Cluster(): wrong number of initial cluster "
+        << "centroids (" << centroids.n_cols << ", should be " << clusters
+        << ")!" << std::endl;
+
+    if (centroids.n_rows != reader.Dimensionality())
+      Log::Fatal << "ChunkedKMeans::Cluster(): initial cluster centroids have "
+        << "wrong dimensionality (" << centroids.n_rows << ", should be "
+        << reader.Dimensionality() << ")!" << std::endl;
+  }
+  else
+  {
+    // Choose k points uniformly at random with reservoir sampling: the i'th
+    // point replaces a random sampled point with probability k / (i + 1).
+    centroids.set_size(reader.Dimensionality(), clusters);
+    size_t seen = 0;
+    reader.Reset();
+    while (reader.NextChunk(chunk))
+    {
+      for (size_t i = 0; i < chunk.n_cols; ++i, ++seen)
+      {
+        if (seen < clusters)
+        {
+          centroids.col(seen) = chunk.col(i);
+        }
+        else
+        {
+          const size_t slot = std::min((size_t) (math::Random() * (seen + 1)),
+              seen);
+          if (slot < clusters)
+            centroids.col(slot) = chunk.col(i);
+        }
+      }
+    }
+  }
+
+  arma::mat sums(centroids.n_rows, clusters);
+  arma::Col<size_t> counts(clusters);
+  arma::mat chunkCentroids;
+  arma::Col<size_t> chunkCounts;
+  size_t iteration = 0;
+  double cNorm;
+
+  do
+  {
+    // One pass over the dataset.
+    sums.zeros();
+    counts.zeros();
+    reader.Reset();
+    while (reader.NextChunk(chunk))
+    {
+      NaiveKMeans<MetricType, arma::mat> lloydStep(chunk, metric);
+      lloydStep.Iterate(centroids, chunkCentroids, chunkCounts);
+
+      // The step gives the mean of each cluster in the chunk; turn it back
+      // into a sum.
+      for (size_t c = 0; c < clusters; ++c)
+        if (chunkCounts[c] > 0)
+          sums.col(c) += chunkCounts[c] * chunkCentroids.col(c);
+      counts += chunkCounts;
+    }
+
+    // Move the centroids, and see how far they moved.
+    cNorm = 0.0;
+    size_t emptyClusters = 0;
+    for (size_t c = 0; c < clusters; ++c)
+    {
+      if (counts[c] == 0)
+      {
+        ++emptyClusters;
+        continue;
+      }
+
+      const arma::vec newCentroid = sums.col(c) / counts[c];
+      cNorm += std::pow(metric.Evaluate(centroids.col(c), newCentroid), 2.0);
+      centroids.col(c) = newCentroid;
+    }
+    cNorm = std::sqrt(cNorm);
+
+    iteration++;
+    Log::Info << "ChunkedKMeans::Cluster(): iteration " << iteration
+        << ", residual " << cNorm << ".\n";
+    if (emptyClusters > 0)
+      Log::Warn << "ChunkedKMeans::Cluster(): " << emptyClusters << " empty "
+          << "clusters in iteration " << iteration << "." << std::endl;
+  } while (cNorm > 1e-5 && iteration != maxIterations);
+
+  if (iteration != maxIterations)
+    Log::Info << "ChunkedKMeans::Cluster(): converged after " << iteration
+        << " iterations." << std::endl;
+  else
+    Log::Info << "ChunkedKMeans::Cluster(): terminated after limit of "
+        << iteration << " iterations." << std::endl;
+}
+
+template<typename MetricType>
+void ChunkedKMeans<MetricType>::Assign(data::ChunkedReader& reader,
+                                       const arma::mat& centroids,
+                                       std::ostream& output,
+                                       const bool labelsOnly,
+                                       const char separator)
+{
+  if (centroids.n_rows != reader.Dimensionality())
+    Log::Fatal << "ChunkedKMeans::Assign(): centroids have wrong "
+        << "dimensionality (" << centroids.n_rows << ", should be "
+        << reader.Dimensionality() << ")!" << std::endl;
+
+  // Write the points with enough digits that they can be read back exactly.
+  const std::streamsize precision = output.precision(
+      std::numeric_limits<double>::digits10 + 2);
+
+  arma::mat chunk;
+  arma::Col<size_t> assignments;
+  reader.Reset();
+  while (reader.NextChunk(chunk))
+  {
+    assignments.set_size(chunk.n_cols);
+
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < chunk.n_cols; ++i)
+    {
+      // Find the closest centroid to this point.
+      double minDistance = std::numeric_limits<double>::infinity();
+      size_t closestCluster = centroids.n_cols; // Invalid value.
+
+      for (size_t j = 0; j < centroids.n_cols; ++j)
+      {
+        const double distance = metric.Evaluate(chunk.col(i),
+            centroids.col(j));
+
+        if (distance < minDistance)
+        {
+          minDistance = distance;
+          closestCluster = j;
+        }
+      }
+
+      assignments[i] = closestCluster;
+    }
+
+    // Write this chunk out before the next one is processed.
+    for (size_t i = 0; i < chunk.n_cols; ++i)
+    {
+      if (!labelsOnly)
+        for (size_t d = 0; d < chunk.n_rows; ++d)
+          output << chunk(d, i) << separator;
+
+      output << assignments[i] << '\n';
+    }
+  }
+
+  output.precision(precision);
+  output.flush();
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -25,6 +25,15 @@ namespace kmeans {
  * dataset.  The conditions under which this will perform best are probably
  * limited to the case where k is close to the number of points in the dataset,
  * and the number of iterations of the k-means algorithm will be few.
+ *
+ * The tree on the points is built once, and the bounds held in its statistics
+ * are carried from one iteration to the next and adjusted by how far each
+ * centroid moved.  The tree on the centroids is also kept between iterations:
+ * its points are moved to the new centroids, and the rules loosen their bounds
+ * by how far the centroids have drifted since the tree was built.  The tree is
+ * only rebuilt once that drift exceeds RebuildThreshold() times the average
+ * distance between each centroid and its nearest other centroid (measured when
+ * the tree was built).
  */
 template<
     typename MetricType,
@@ -52,7 +61,7 @@ class DualTreeKMeans
   DualTreeKMeans(const MatType& dataset, MetricType& metric);
 
   /**
-   * Delete the tree constructed by the DualTreeKMeans object.
+   * Delete the trees constructed by the DualTreeKMeans object.
    */
   ~DualTreeKMeans();
 
@@ -73,6 +82,16 @@ class DualTreeKMeans
   //! Modify the number of distance calculations.
   size_t& DistanceCalculations() { return distanceCalculations; }
 
+  //! Get the centroid drift (relative to the centroid spacing) that causes the
+  //! centroid tree to be rebuilt.
+  double RebuildThreshold() const { return rebuildThreshold; }
+  //! Modify the centroid drift (relative to the centroid spacing) that causes
+  //! the centroid tree to be rebuilt.
+  double& RebuildThreshold() { return rebuildThreshold; }
+
+  //! Get the number of times the centroid tree has been built.
+  size_t CentroidTreeBuilds() const { return centroidTreeBuilds; }
+
  private:
   //! The original dataset reference.
   const MatType& datasetOrig; // Maybe not necessary.
@@ -99,12 +118,34 @@ class DualTreeKMeans
 
   std::vector<bool> visited; // Was the point visited this iteration?
 
-  arma::mat lastIterationCentroids; // For sanity checks.
+  arma::mat lastIterationCentroids; // The centroids of the last iteration.
 
   arma::vec clusterDistances; // The amount the clusters moved last iteration.
 
   arma::mat interclusterDistances; // Static storage for intercluster distances.
 
+  //! The tree built on the centroids, kept between iterations.
+  Tree* centroidTree;
+  //! The mappings of the centroids in the centroid tree.
+  std::vector<size_t> oldFromNewCentroids;
+  //! The centroids the centroid tree is built on (for trees that do not copy
+  //! the dataset); these are moved to the current centroids each iteration.
+  MatType treeCentroids;
+  //! The centroids at the time the centroid tree was built.
+  arma::mat builtCentroids;
+  //! The intercluster distances at the time the centroid tree was built.
+  arma::mat builtInterclusterDistances;
+  //! The average of builtInterclusterDistances.
+  double builtSpacing;
+  //! Centroid drift (relative to builtSpacing) that triggers a rebuild.
+  double rebuildThreshold;
+  //! The number of times the centroid tree has been built.
+  size_t centroidTreeBuilds;
+
+  //! Build the centroid tree on the given centroids, and find the intercluster
+  //! distances with it.
+  void BuildCentroidTree(const arma::mat& centroids);
+
   //! Update the bounds in the tree before the next iteration.
   //! centroids is the current (not yet searched) centroids.
   void UpdateTree(Tree& node,
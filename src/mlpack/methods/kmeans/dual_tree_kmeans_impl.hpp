@@ -62,7 +62,11 @@ DualTreeKMeans<MetricType, MatType, TreeType>::DualTreeKMeans(
     lowerBounds(dataset.n_cols),
     prunedPoints(dataset.n_cols, false), // Fill with false.
     assignments(dataset.n_cols),
-    visited(dataset.n_cols, false) // Fill with false.
+    visited(dataset.n_cols, false), // Fill with false.
+    centroidTree(NULL),
+    builtSpacing(0.0),
+    rebuildThreshold(0.05),
+    centroidTreeBuilds(0)
 {
   for (size_t i = 0; i < dataset.n_cols; ++i)
   {
@@ -83,6 +87,8 @@ DualTreeKMeans<MetricType, MatType, TreeType>::~DualTreeKMeans()
 {
   if (tree)
     delete tree;
+  if (centroidTree)
+    delete centroidTree;
 }
 
 // Run a single iteration.
@@ -96,48 +102,22 @@ double DualTreeKMeans<MetricType, MatType, TreeType>::Iterate(
     arma::mat& newCentroids,
     arma::Col<size_t>& counts)
 {
-  // Build a tree on the centroids.
   arma::mat oldCentroids(centroids); // Slow. :(
-  std::vector<size_t> oldFromNewCentroids;
-  Tree* centroidTree = BuildTree<Tree>(const_cast<MatType&>(centroids),
-      oldFromNewCentroids);
 
-  // Reset information in the tree, if we need to.
   if (iteration > 0)
   {
-    Timer::Start("knn");
-
-    // Find the nearest neighbors of each of the clusters.  We have to make our
-    // own TreeType, which is a little bit abuse, but we know for sure the
-    // TreeStatType we have will work.
-    neighbor::NeighborSearch<neighbor::NearestNeighborSort, MetricType, MatType,
-        NNSTreeType> nns(centroidTree);
-
-    // If the tree maps points, we need an intermediate result matrix.
-    arma::mat* interclusterDistancesTemp =
-        (tree::TreeTraits<Tree>::RearrangesDataset) ?
-        new arma::mat(1, centroids.n_elem) : &interclusterDistances;
-
-    arma::Mat<size_t> closestClusters; // We don't actually care about these.
-    nns.Search(1, closestClusters, *interclusterDistancesTemp);
-    distanceCalculations += nns.BaseCases() + nns.Scores();
-
-    // We need to do the unmapping ourselves, if the tree does mapping.
-    if (tree::TreeTraits<Tree>::RearrangesDataset)
+    // Find how far each centroid moved since the last iteration.  This is not
+    // taken from the last iteration, because the empty cluster policy may
+    // have moved some centroids since.
+    clusterDistances[centroids.n_cols] = 0.0;
+    for (size_t c = 0; c < centroids.n_cols; ++c)
     {
-      for (size_t i = 0; i < interclusterDistances.n_elem; ++i)
-        interclusterDistances[oldFromNewCentroids[i]] =
-            (*interclusterDistancesTemp)[i];
-
-      delete interclusterDistancesTemp;
+      clusterDistances[c] = metric.Evaluate(centroids.col(c),
+          lastIterationCentroids.col(c));
+      if (clusterDistances[c] > clusterDistances[centroids.n_cols])
+        clusterDistances[centroids.n_cols] = clusterDistances[c];
     }
-
-    Timer::Stop("knn");
-
-    UpdateTree(*tree, oldCentroids);
-
-    for (size_t i = 0; i < dataset.n_cols; ++i)
-      visited[i] = false;
+    distanceCalculations += centroids.n_cols;
   }
   else
   {
@@ -146,11 +126,56 @@ double DualTreeKMeans<MetricType, MatType, TreeType>::Iterate(
     interclusterDistances.set_size(1, centroids.n_cols);
   }
 
+  // Find how far the centroids have drifted since the centroid tree was built,
+  // to see if the tree is still good enough to use.
+  arma::vec drift;
+  double maxDrift = 0.0;
+  if (centroidTree != NULL && builtCentroids.n_cols == centroids.n_cols)
+  {
+    drift.set_size(centroids.n_cols);
+    for (size_t c = 0; c < centroids.n_cols; ++c)
+      drift[c] = metric.Evaluate(centroids.col(c), builtCentroids.col(c));
+    distanceCalculations += centroids.n_cols;
+    maxDrift = drift.max();
+  }
+
+  if (drift.n_elem == 0 || maxDrift > rebuildThreshold * builtSpacing)
+  {
+    BuildCentroidTree(centroids);
+    maxDrift = 0.0;
+  }
+  else
+  {
+    // Move the points of the tree to the current centroids.  The bounds of the
+    // tree are now off by at most maxDrift, which the rules account for.
+    MatType& treeData = const_cast<MatType&>(centroidTree->Dataset());
+    for (size_t c = 0; c < centroids.n_cols; ++c)
+      treeData.col(c) = centroids.col(
+          (tree::TreeTraits<Tree>::RearrangesDataset) ?
+          oldFromNewCentroids[c] : c);
+
+    // The distance between a centroid and its nearest other centroid can have
+    // shrunk by at most the drift of both.
+    for (size_t c = 0; c < centroids.n_cols; ++c)
+      interclusterDistances[c] = std::max(builtInterclusterDistances[c] -
+          drift[c] - maxDrift, 0.0);
+  }
+
+  // Update the bounds in the tree, if we need to.
+  if (iteration > 0)
+  {
+    UpdateTree(*tree, oldCentroids);
+
+    for (size_t i = 0; i < dataset.n_cols; ++i)
+      visited[i] = false;
+  }
+
   // We won't use the AllkNN class here because we have our own set of rules.
   lastIterationCentroids = oldCentroids;
   typedef DualTreeKMeansRules<MetricType, Tree> RuleType;
   RuleType rules(centroidTree->Dataset(), dataset, assignments, upperBounds,
-      lowerBounds, metric, prunedPoints, oldFromNewCentroids, visited);
+      lowerBounds, metric, prunedPoints, oldFromNewCentroids, visited,
+      maxDrift);
 
   typename Tree::template BreadthFirstDualTreeTraverser<RuleType>
       traverser(rules);
@@ -175,38 +200,75 @@ double DualTreeKMeans<MetricType, MatType, TreeType>::Iterate(
 
   // Now, calculate how far the clusters moved, after normalizing them.
   double residual = 0.0;
-  clusterDistances[centroids.n_cols] = 0.0;
   for (size_t c = 0; c < centroids.n_cols; ++c)
   {
-    // Get the mapping to the old cluster, if necessary.
-    const size_t old = (tree::TreeTraits<Tree>::RearrangesDataset) ?
-        oldFromNewCentroids[c] : c;
-    if (counts[old] == 0)
+    if (counts[c] == 0)
     {
-      newCentroids.col(old).fill(DBL_MAX);
-      clusterDistances[old] = 0;
+      newCentroids.col(c).fill(DBL_MAX);
     }
     else
     {
-      newCentroids.col(old) /= counts(old);
-      const double movement = metric.Evaluate(centroids.col(c),
-          newCentroids.col(old));
-      clusterDistances[old] = movement;
-      residual += std::pow(movement, 2.0);
-
-      if (movement > clusterDistances[centroids.n_cols])
-        clusterDistances[centroids.n_cols] = movement;
+      newCentroids.col(c) /= counts(c);
+      residual += std::pow(metric.Evaluate(centroids.col(c),
+          newCentroids.col(c)), 2.0);
     }
   }
   distanceCalculations += centroids.n_cols;
 
-  delete centroidTree;
-
   ++iteration;
 
   return std::sqrt(residual);
 }
 
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void DualTreeKMeans<MetricType, MatType, TreeType>::BuildCentroidTree(
+    const arma::mat& centroids)
+{
+  if (centroidTree)
+    delete centroidTree;
+
+  builtCentroids = centroids;
+  treeCentroids = centroids;
+  centroidTree = BuildTree<Tree>(treeCentroids, oldFromNewCentroids);
+  ++centroidTreeBuilds;
+
+  Timer::Start("knn");
+
+  // Find the nearest neighbors of each of the clusters.  We have to make our
+  // own TreeType, which is a little bit abuse, but we know for sure the
+  // TreeStatType we have will work.
+  neighbor::NeighborSearch<neighbor::NearestNeighborSort, MetricType, MatType,
+      NNSTreeType> nns(centroidTree);
+
+  // If the tree maps points, we need an intermediate result matrix.
+  arma::mat* interclusterDistancesTemp =
+      (tree::TreeTraits<Tree>::RearrangesDataset) ?
+      new arma::mat(1, centroids.n_elem) : &interclusterDistances;
+
+  arma::Mat<size_t> closestClusters; // We don't actually care about these.
+  nns.Search(1, closestClusters, *interclusterDistancesTemp);
+  distanceCalculations += nns.BaseCases() + nns.Scores();
+
+  // We need to do the unmapping ourselves, if the tree does mapping.
+  if (tree::TreeTraits<Tree>::RearrangesDataset)
+  {
+    for (size_t i = 0; i < interclusterDistances.n_elem; ++i)
+      interclusterDistances[oldFromNewCentroids[i]] =
+          (*interclusterDistancesTemp)[i];
+
+    delete interclusterDistancesTemp;
+  }
+
+  Timer::Stop("knn");
+
+  builtInterclusterDistances = interclusterDistances;
+  builtSpacing = arma::mean(arma::vectorise(interclusterDistances));
+}
+
 template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
@@ -337,6 +399,14 @@ visited[node.Descendant(i)] << ".\n";
   else
   {
     node.Stat().LowerBound() -= clusterDistances[centroids.n_cols];
+
+    // The owner may not own every point in the node, but the upper bound is
+    // still a bound on the distance from each point to the owner, once the
+    // owner's movement is accounted for.  So it can be kept for the next
+    // traversal.
+    if (node.Stat().Owner() < centroids.n_cols &&
+        node.Stat().UpperBound() != DBL_MAX)
+      node.Stat().UpperBound() += clusterDistances[node.Stat().Owner()];
   }
 
   // Recurse into children, and if all the children (and all the points) are
@@ -446,10 +516,10 @@ visited[node.Descendant(i)] << ".\n";
 
   if (!node.Stat().StaticPruned())
   {
-    node.Stat().UpperBound() = DBL_MAX;
+    // The upper bound and its owner have been adjusted for the movement of the
+    // owner, so they are kept; the rest is found again by the traversal.
     node.Stat().LowerBound() = DBL_MAX;
     node.Stat().Pruned() = size_t(-1);
-    node.Stat().Owner() = centroids.n_cols;
     node.Stat().StaticPruned() = false;
   }
   else // The node is now pruned.
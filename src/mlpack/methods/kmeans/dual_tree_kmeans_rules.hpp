@@ -26,7 +26,8 @@ class DualTreeKMeansRules
                       MetricType& metric,
                       const std::vector<bool>& prunedPoints,
                       const std::vector<size_t>& oldFromNewCentroids,
-                      std::vector<bool>& visited);
+                      std::vector<bool>& visited,
+                      const double centroidDrift = 0.0);
 
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
@@ -64,6 +65,11 @@ class DualTreeKMeansRules
 
   std::vector<bool>& visited;
 
+  //! How much the distances between query and reference nodes may be
+  //! overestimated, because the centroids have moved since the reference tree
+  //! was built.
+  double boundSlack;
+
   size_t baseCases;
   size_t scores;
 
@@ -22,7 +22,8 @@ DualTreeKMeansRules<MetricType, TreeType>::DualTreeKMeansRules(
     MetricType& metric,
     const std::vector<bool>& prunedPoints,
     const std::vector<size_t>& oldFromNewCentroids,
-    std::vector<bool>& visited) :
+    std::vector<bool>& visited,
+    const double centroidDrift) :
     centroids(centroids),
     dataset(dataset),
     assignments(assignments),
@@ -32,6 +33,11 @@ DualTreeKMeansRules<MetricType, TreeType>::DualTreeKMeansRules(
     prunedPoints(prunedPoints),
     oldFromNewCentroids(oldFromNewCentroids),
     visited(visited),
+    // Each centroid is at most centroidDrift from where it was when the tree
+    // was built.  The bound of a node can be off by that much, and its
+    // furthest descendant distance (taken from a point that moved too) by
+    // twice that much.
+    boundSlack(2.0 * centroidDrift),
     baseCases(0),
     scores(0),
     lastQueryIndex(dataset.n_cols),
@@ -111,7 +117,16 @@ inline double DualTreeKMeansRules<MetricType, TreeType>::Score(
   {
     queryNode.Stat().Pruned() = queryNode.Parent()->Stat().Pruned();
     queryNode.Stat().LowerBound() = queryNode.Parent()->Stat().LowerBound();
-    queryNode.Stat().Owner() = queryNode.Parent()->Stat().Owner();
+
+    // The upper bound kept from the last iteration may be looser than the
+    // parent's.  The owner must go with the bound that is used; otherwise the
+    // owner could be one of the centroids the parent has already pruned.
+    if (queryNode.Parent()->Stat().UpperBound() <=
+        queryNode.Stat().UpperBound())
+    {
+      queryNode.Stat().UpperBound() = queryNode.Parent()->Stat().UpperBound();
+      queryNode.Stat().Owner() = queryNode.Parent()->Stat().Owner();
+    }
   }
 
   if (queryNode.Stat().Pruned() == centroids.n_cols)
@@ -203,6 +218,7 @@ inline double DualTreeKMeansRules<MetricType, TreeType>::Score(
     // actually happen for kd-trees or cover trees.
     adjustedScore = 0.0;
   }
+  adjustedScore -= boundSlack;
 
   // Now, check if we can prune.
   if (adjustedScore > queryNode.Stat().UpperBound())
@@ -216,7 +232,7 @@ inline double DualTreeKMeansRules<MetricType, TreeType>::Score(
       {
         // If this might affect the lower bound, make it more exact.
         queryNode.Stat().LowerBound() = std::min(queryNode.Stat().LowerBound(),
-            queryNode.MinDistance(&referenceNode));
+            queryNode.MinDistance(&referenceNode) - boundSlack);
         ++scores;
       }
 
@@ -229,15 +245,16 @@ inline double DualTreeKMeansRules<MetricType, TreeType>::Score(
   {
     // Get minimum and maximum distances.
     const math::Range distances = queryNode.RangeDistance(&referenceNode);
+    const double minDistance = std::max(distances.Lo() - boundSlack, 0.0);
 
-    score = distances.Lo();
+    score = minDistance;
     ++scores;
-    if (distances.Lo() > queryNode.Stat().UpperBound())
+    if (minDistance > queryNode.Stat().UpperBound())
     {
       // The reference node can own no points in this query node.  We may
       // improve the lower bound on pruned nodes, though.
-      if (distances.Lo() < queryNode.Stat().LowerBound())
-        queryNode.Stat().LowerBound() = distances.Lo();
+      if (minDistance < queryNode.Stat().LowerBound())
+        queryNode.Stat().LowerBound() = minDistance;
 
       // This assumes that reference clusters don't appear elsewhere in the
       // tree.
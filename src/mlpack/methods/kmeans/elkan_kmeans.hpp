@@ -7,6 +7,8 @@
 #ifndef __MLPACK_METHODS_KMEANS_ELKAN_KMEANS_HPP
 #define __MLPACK_METHODS_KMEANS_ELKAN_KMEANS_HPP
 
+#include "float_bound.hpp"
+
 namespace mlpack {
 namespace kmeans {
 
@@ -23,6 +25,9 @@ class ElkanKMeans
    * Run a single iteration of Elkan's algorithm, updating the given centroids
    * into the newCentroids matrix.
    *
+   * With OpenMP, the points and their bounds are split across threads, and the
+   * sums of the threads are combined as in parallel::BlockReduce().
+   *
    * @param centroids Current cluster centroids.
    * @param newCentroids New cluster centroids.
    * @param counts Current counts, to be overwritten with new counts.
@@ -49,8 +54,10 @@ class ElkanKMeans
 
   //! Upper bounds on the distance between each point and its closest cluster.
   arma::vec upperBounds;
-  //! Lower bounds on the distance between each point and each cluster.
-  arma::mat lowerBounds;
+  //! Lower bounds on the distance between each point and each cluster.  There
+  //! are k of these for each point, so they are stored in single precision
+  //! (rounded down) to halve their memory.
+  arma::fmat lowerBounds;
 
   //! Track distance calculations.
   size_t distanceCalculations;
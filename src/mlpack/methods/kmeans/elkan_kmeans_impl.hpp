@@ -10,6 +10,10 @@
 // In case it hasn't been included yet.
 #include "elkan_kmeans.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace kmeans {
 
@@ -20,7 +24,7 @@ ElkanKMeans<MetricType, MatType>::ElkanKMeans(const MatType& dataset,
     metric(metric),
     distanceCalculations(0)
 {
-
+  // Nothing to do.
 }
 
 // Run a single iteration of Elkan's algorithm for Lloyd iterations.
@@ -29,10 +33,6 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
                                                  arma::mat& newCentroids,
                                                  arma::Col<size_t>& counts)
 {
-  // Clear new centroids.
-  newCentroids.zeros(centroids.n_rows, centroids.n_cols);
-  counts.zeros(centroids.n_cols);
-
   // At the beginning of the iteration, we must compute the distances between
   // all centers.  This is O(k^2).
   clusterDistances.set_size(centroids.n_cols, centroids.n_cols);
@@ -41,9 +41,6 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   // being the closest cluster centroid.
   clusterDistances.diag().fill(DBL_MAX);
 
-  // Initially set r(x) to true.
-  std::vector<bool> mustRecalculate(dataset.n_cols, true);
-
   // If this is the first iteration, we must reset all the bounds.
   if (lowerBounds.n_rows != centroids.n_cols)
   {
@@ -74,19 +71,42 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   // that this is equivalent to s(c) for each cluster c.
   minClusterDistances = 0.5 * arma::min(clusterDistances).t();
 
-  // Now loop over all points, and see which ones need to be updated.
-  for (size_t i = 0; i < dataset.n_cols; ++i)
+  const size_t numThreads = parallel::Threads();
+
+  // Steps 2 to 4 run on the points of each thread, which alone updates their
+  // bounds and keeps its own centroid sums and counts.
+  std::vector<arma::mat> threadCentroids(numThreads);
+  std::vector<arma::Col<size_t> > threadCounts(numThreads);
+  size_t pointDistances = 0;
+
+  #pragma omp parallel num_threads(numThreads) reduction(+:pointDistances)
   {
-    // Step 2: identify all points such that u(x) <= s(c(x)).
-    if (upperBounds(i) <= minClusterDistances(assignments[i]))
-    {
-      // No change needed.  This point must still belong to that cluster.
-      counts(assignments[i])++;
-      newCentroids.col(assignments[i]) += arma::vec(dataset.col(i));
-      continue;
-    }
-    else
+#ifdef _OPENMP
+    const size_t thread = (size_t) omp_get_thread_num();
+#else
+    const size_t thread = 0;
+#endif
+    arma::mat& sums = threadCentroids[thread];
+    arma::Col<size_t>& threadCount = threadCounts[thread];
+    sums.zeros(centroids.n_rows, centroids.n_cols);
+    threadCount.zeros(centroids.n_cols);
+
+    MetricType threadMetric(metric);
+
+    #pragma omp for schedule(static, 256)
+    for (size_t i = 0; i < dataset.n_cols; ++i)
     {
+      // Step 2: identify all points such that u(x) <= s(c(x)).
+      if (upperBounds(i) <= minClusterDistances(assignments[i]))
+      {
+        // No change needed.  This point must still belong to that cluster.
+        threadCount(assignments[i])++;
+        sums.col(assignments[i]) += arma::vec(dataset.col(i));
+        continue;
+      }
+
+      // Initially set r(x) to true.
+      bool mustRecalculate = true;
       for (size_t c = 0; c < centroids.n_cols; ++c)
       {
         // Step 3: for all remaining points x and centers c such that c != c(x),
@@ -103,13 +123,14 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
         // Step 3a: if r(x) then compute d(x, c(x)) and assign r(x) = false.
         // Otherwise, d(x, c(x)) = u(x).
         double dist;
-        if (mustRecalculate[i])
+        if (mustRecalculate)
         {
-          mustRecalculate[i] = false;
-          dist = metric.Evaluate(dataset.col(i), centroids.col(assignments[i]));
-          lowerBounds(assignments[i], i) = dist;
+          mustRecalculate = false;
+          dist = threadMetric.Evaluate(dataset.col(i),
+                                       centroids.col(assignments[i]));
+          lowerBounds(assignments[i], i) = FloatLowerBound(dist);
           upperBounds(i) = dist;
-          distanceCalculations++;
+          pointDistances++;
 
           // Check if we can prune again.
           if (upperBounds(i) <= lowerBounds(c, i))
@@ -128,10 +149,10 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
             dist > 0.5 * clusterDistances(assignments[i], c))
         {
           // Compute d(x, c).  If d(x, c) < d(x, c(x)) then assign c(x) = c.
-          const double pointDist = metric.Evaluate(dataset.col(i),
-                                                   centroids.col(c));
-          lowerBounds(c, i) = pointDist;
-          distanceCalculations++;
+          const double pointDist = threadMetric.Evaluate(dataset.col(i),
+                                                         centroids.col(c));
+          lowerBounds(c, i) = FloatLowerBound(pointDist);
+          pointDistances++;
           if (pointDist < dist)
           {
             upperBounds(i) = pointDist;
@@ -139,13 +160,24 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
           }
         }
       }
+
+      // At this point, we know the new cluster assignment.
+      // Step 4: for each center c, let m(c) be the mean of the points assigned
+      // to c.
+      sums.col(assignments[i]) += arma::vec(dataset.col(i));
+      threadCount[assignments[i]]++;
     }
+  }
+  distanceCalculations += pointDistances;
 
-    // At this point, we know the new cluster assignment.
-    // Step 4: for each center c, let m(c) be the mean of the points assigned to
-    // c.
-    newCentroids.col(assignments[i]) += arma::vec(dataset.col(i));
-    counts[assignments[i]]++;
+  // Step 4 needs the sums of every thread; they are merged in thread order, as
+  // in parallel::BlockReduce().
+  newCentroids = std::move(threadCentroids[0]);
+  counts = std::move(threadCounts[0]);
+  for (size_t t = 1; t < numThreads; ++t)
+  {
+    newCentroids += threadCentroids[t];
+    counts += threadCounts[t];
   }
 
   // Now, normalize and calculate the distance each cluster has moved.
@@ -163,13 +195,15 @@ double ElkanKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
     distanceCalculations++;
   }
 
+  #pragma omp parallel for num_threads(numThreads) schedule(static)
   for (size_t i = 0; i < dataset.n_cols; ++i)
   {
     // Step 5: for each point x and center c, assign
     //   l(x, c) = max { l(x, c) - d(c, m(c)), 0 }.
     // But it doesn't actually matter if l(x, c) is positive.
     for (size_t c = 0; c < centroids.n_cols; ++c)
-      lowerBounds(c, i) -= moveDistances(c);
+      lowerBounds(c, i) = FloatLowerBound(lowerBounds(c, i) -
+          moveDistances(c));
 
     // Step 6: for each point x, assign
     //   u(x) = u(x) + d(m(c(x)), c(x))
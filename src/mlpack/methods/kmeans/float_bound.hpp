@@ -0,0 +1,36 @@
+/**
+ * @file float_bound.hpp
+ * @author Ryan Curtin
+ *
+ * Storage of lower distance bounds in single precision, for the Lloyd step
+ * types that keep many bounds for each point.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_FLOAT_BOUND_HPP
+#define __MLPACK_METHODS_KMEANS_FLOAT_BOUND_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * Convert a lower bound on a distance to single precision, rounding it down so
+ * that it is still a lower bound.  Storing the bounds this way halves their
+ * memory, and a bound that is slightly too loose only costs the occasional
+ * extra distance calculation, never a wrong assignment.
+ *
+ * @param bound Lower bound to convert.
+ */
+inline float FloatLowerBound(const double bound)
+{
+  float result = (float) bound;
+  if ((double) result > bound)
+    result = std::nextafter(result, -std::numeric_limits<float>::infinity());
+
+  return result;
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -24,6 +24,9 @@ class HamerlyKMeans
    * Run a single iteration of Hamerly's algorithm, updating the given centroids
    * into the newCentroids matrix.
    *
+   * With OpenMP, each thread runs the bound tests on its own share of the
+   * points; see parallel::BlockReduce() for how their sums are combined.
+   *
    * @param centroids Current cluster centroids.
    * @param newCentroids New cluster centroids.
    * @param counts Current counts, to be overwritten with new counts.
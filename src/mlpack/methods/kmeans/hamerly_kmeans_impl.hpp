@@ -10,6 +10,10 @@
 // In case it hasn't been included yet.
 #include "hamerly_kmeans.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace kmeans {
 
@@ -40,10 +44,6 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
     minClusterDistances.set_size(centroids.n_cols);
   }
 
-  // Reset new centroids.
-  newCentroids.zeros(centroids.n_rows, centroids.n_cols);
-  counts.zeros(centroids.n_cols);
-
   // Calculate minimum intra-cluster distance for each cluster.
   minClusterDistances.fill(DBL_MAX);
   for (size_t i = 0; i < centroids.n_cols; ++i)
@@ -62,63 +62,101 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
     }
   }
 
-  for (size_t i = 0; i < dataset.n_cols; ++i)
-  {
-    const double m = std::max(minClusterDistances(assignments[i]),
-                              lowerBounds(i));
+  const size_t numThreads = parallel::Threads();
 
-    // First bound test.
-    if (upperBounds(i) <= m)
-    {
-      ++hamerlyPruned;
-      newCentroids.col(assignments[i]) += dataset.col(i);
-      ++counts(assignments[i]);
-      continue;
-    }
+  // Each thread tightens the bounds of its own points, and sums them into its
+  // own copy of the new centroids.
+  std::vector<arma::mat> threadCentroids(numThreads);
+  std::vector<arma::Col<size_t> > threadCounts(numThreads);
+  size_t pointDistances = 0;
 
-    // Tighten upper bound.
-    upperBounds(i) = metric.Evaluate(dataset.col(i),
-                                     centroids.col(assignments[i]));
-    ++distanceCalculations;
+  #pragma omp parallel num_threads(numThreads) \
+      reduction(+:hamerlyPruned, pointDistances)
+  {
+#ifdef _OPENMP
+    const size_t thread = (size_t) omp_get_thread_num();
+#else
+    const size_t thread = 0;
+#endif
+    arma::mat& sums = threadCentroids[thread];
+    arma::Col<size_t>& threadCount = threadCounts[thread];
+    sums.zeros(centroids.n_rows, centroids.n_cols);
+    threadCount.zeros(centroids.n_cols);
 
-    // Second bound test.
-    if (upperBounds(i) <= m)
-    {
-      newCentroids.col(assignments[i]) += dataset.col(i);
-      ++counts(assignments[i]);
-      continue;
-    }
+    MetricType threadMetric(metric);
 
-    // The bounds failed.  So test against all other clusters.
-    // This is Hamerly's Point-All-Ctrs() function from the paper.
-    // We have to reset the lower bound first.
-    lowerBounds(i) = DBL_MAX;
-    for (size_t c = 0; c < centroids.n_cols; ++c)
+    #pragma omp for schedule(static, 256)
+    for (size_t i = 0; i < dataset.n_cols; ++i)
     {
-      if (c == assignments[i])
+      const double m = std::max(minClusterDistances(assignments[i]),
+                                lowerBounds(i));
+
+      // First bound test.
+      if (upperBounds(i) <= m)
+      {
+        ++hamerlyPruned;
+        sums.col(assignments[i]) += dataset.col(i);
+        ++threadCount(assignments[i]);
         continue;
+      }
 
-      const double dist = metric.Evaluate(dataset.col(i), centroids.col(c));
+      // Tighten upper bound.
+      upperBounds(i) = threadMetric.Evaluate(dataset.col(i),
+                                             centroids.col(assignments[i]));
+      ++pointDistances;
 
-      // Is this a better cluster?  At this point, upperBounds[i] = d(i, c(i)).
-      if (dist < upperBounds(i))
+      // Second bound test.
+      if (upperBounds(i) <= m)
       {
-        // lowerBounds holds the second closest cluster.
-        lowerBounds(i) = upperBounds(i);
-        upperBounds(i) = dist;
-        assignments[i] = c;
+        sums.col(assignments[i]) += dataset.col(i);
+        ++threadCount(assignments[i]);
+        continue;
       }
-      else if (dist < lowerBounds(i))
+
+      // The bounds failed.  So test against all other clusters.
+      // This is Hamerly's Point-All-Ctrs() function from the paper.
+      // We have to reset the lower bound first.
+      lowerBounds(i) = DBL_MAX;
+      for (size_t c = 0; c < centroids.n_cols; ++c)
       {
-        // This is a closer second-closest cluster.
-        lowerBounds(i) = dist;
+        if (c == assignments[i])
+          continue;
+
+        const double dist = threadMetric.Evaluate(dataset.col(i),
+                                                  centroids.col(c));
+
+        // Is this a better cluster?  At this point, upperBounds[i] = d(i,
+        // c(i)).
+        if (dist < upperBounds(i))
+        {
+          // lowerBounds holds the second closest cluster.
+          lowerBounds(i) = upperBounds(i);
+          upperBounds(i) = dist;
+          assignments[i] = c;
+        }
+        else if (dist < lowerBounds(i))
+        {
+          // This is a closer second-closest cluster.
+          lowerBounds(i) = dist;
+        }
       }
+      pointDistances += centroids.n_cols - 1;
+
+      // Update new centroids.
+      sums.col(assignments[i]) += dataset.col(i);
+      ++threadCount(assignments[i]);
     }
-    distanceCalculations += centroids.n_cols - 1;
+  }
+  distanceCalculations += pointDistances;
 
-    // Update new centroids.
-    newCentroids.col(assignments[i]) += dataset.col(i);
-    ++counts(assignments[i]);
+  // Merge the thread sums before Move-Centers() (in thread order; see
+  // parallel::BlockReduce()).
+  newCentroids = std::move(threadCentroids[0]);
+  counts = std::move(threadCounts[0]);
+  for (size_t t = 1; t < numThreads; ++t)
+  {
+    newCentroids += threadCentroids[t];
+    counts += threadCounts[t];
   }
 
   // Normalize centroids and calculate cluster movement (contains parts of
@@ -155,6 +193,7 @@ double HamerlyKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   }
 
   // Now update bounds (lines 3-8 of Update-Bounds()).
+  #pragma omp parallel for num_threads(numThreads) schedule(static)
   for (size_t i = 0; i < dataset.n_cols; ++i)
   {
     upperBounds(i) += centroidMovements(assignments[i]);
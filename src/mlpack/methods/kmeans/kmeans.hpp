@@ -77,11 +77,14 @@ class KMeans
    *     specially initialized partitioning policy is required.
    * @param emptyClusterAction Optional EmptyClusterPolicy object; for when a
    *     specially initialized empty cluster policy is required.
+   * @param restarts Number of times to run k-means from a different initial
+   *     partition (see Restarts()).
    */
   KMeans(const size_t maxIterations = 1000,
          const MetricType metric = MetricType(),
          const InitialPartitionPolicy partitioner = InitialPartitionPolicy(),
-         const EmptyClusterPolicy emptyClusterAction = EmptyClusterPolicy());
+         const EmptyClusterPolicy emptyClusterAction = EmptyClusterPolicy(),
+         const size_t restarts = 1);
 
 
   /**
@@ -152,6 +155,35 @@ class KMeans
   //! Set the maximum number of iterations.
   size_t& MaxIterations() { return maxIterations; }
 
+  /**
+   * Get the number of restarts.  When no initial guess is given, k-means is
+   * run this many times from different initial partitions, and the centroids
+   * with the lowest inertia (the sum of the squared distances from each point
+   * to its closest centroid) are kept.  The restarts are run in parallel, each
+   * with its own copy of the policies and its own random stream (see
+   * math::ScopedRandomStream), so the result does not depend on the number of
+   * threads; their Log::Info output is muted while they run.
+   */
+  size_t Restarts() const { return restarts; }
+  //! Modify the number of restarts.
+  size_t& Restarts() { return restarts; }
+
+  /**
+   * Get the reducer (NULL if there is none).  If a reducer is set, the dataset
+   * given to Cluster() is one shard of a larger dataset that is held by
+   * several processes, each of which calls Cluster() on its own shard: the
+   * statistics of the initial partition, the centroid sums and counts of each
+   * Lloyd iteration, and the inertias of the restarts are added up over the
+   * shards, so every process gets the centroids of the whole dataset.  When a
+   * cluster becomes empty, the centroids chosen by the root process are used.
+   * Only the NaiveKMeans Lloyd step can be used with a reducer, and the
+   * restarts are then run one after another.  The assignments given by
+   * Cluster() are those of the local shard.
+   */
+  math::Reducer* Reducer() const { return reducer; }
+  //! Modify the reducer (NULL for none).
+  math::Reducer*& Reducer() { return reducer; }
+
   //! Get the distance metric.
   const MetricType& Metric() const { return metric; }
   //! Modify the distance metric.
@@ -178,12 +210,29 @@ class KMeans
  private:
   //! Maximum number of iterations before giving up.
   size_t maxIterations;
+  //! Number of times to run k-means from a different initial partition.
+  size_t restarts;
   //! Instantiated distance metric.
   MetricType metric;
   //! Instantiated initial partitioning policy.
   InitialPartitionPolicy partitioner;
   //! Instantiated empty cluster policy.
   EmptyClusterPolicy emptyClusterAction;
+  //! The reducer of the statistics of each shard, if the dataset is a shard.
+  math::Reducer* reducer;
+
+  /**
+   * Run k-means once, from the given initial centroids or from the initial
+   * partition of the partitioner.
+   */
+  void ClusterOnce(const MatType& data,
+                   const size_t clusters,
+                   arma::mat& centroids,
+                   const bool initialGuess);
+
+  //! Compute the sum of the squared distances from each point to its closest
+  //! centroid.
+  double Inertia(const MatType& data, const arma::mat& centroids);
 };
 
 } // namespace kmeans
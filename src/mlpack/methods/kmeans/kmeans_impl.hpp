@@ -12,6 +12,26 @@
 namespace mlpack {
 namespace kmeans {
 
+//! Give the reducer to the Lloyd step; NaiveKMeans can add up the statistics
+//! of several shards.
+template<typename MetricType, typename MatType>
+void SetLloydStepReducer(NaiveKMeans<MetricType, MatType>& lloydStep,
+                         math::Reducer* reducer)
+{
+  lloydStep.Reducer() = reducer;
+}
+
+//! Other Lloyd steps keep state about each point between iterations, so they
+//! cannot be used with a reducer.
+template<typename LloydStepType>
+void SetLloydStepReducer(LloydStepType& /* lloydStep */,
+                         math::Reducer* reducer)
+{
+  if (reducer != NULL)
+    throw std::invalid_argument("KMeans::Cluster(): only the NaiveKMeans Lloyd "
+        "step can be used with a reducer");
+}
+
 /**
  * Construct the K-Means object.
  */
@@ -29,11 +49,14 @@ KMeans<
 KMeans(const size_t maxIterations,
        const MetricType metric,
        const InitialPartitionPolicy partitioner,
-       const EmptyClusterPolicy emptyClusterAction) :
+       const EmptyClusterPolicy emptyClusterAction,
+       const size_t restarts) :
     maxIterations(maxIterations),
+    restarts(restarts),
     metric(metric),
     partitioner(partitioner),
-    emptyClusterAction(emptyClusterAction)
+    emptyClusterAction(emptyClusterAction),
+    reducer(NULL)
 {
   // Nothing to do.
 }
@@ -106,6 +129,66 @@ Cluster(const MatType& data,
         << data.n_rows << ")!" << std::endl;
   }
 
+  if (initialGuess || restarts <= 1)
+  {
+    ClusterOnce(data, clusters, centroids, initialGuess);
+    return;
+  }
+
+  // Each restart gets its own copy of this object, so that the policies can
+  // keep state, and its own random stream, so that the restarts are
+  // independent and do not depend on how they are scheduled.  Log::Info is not
+  // thread-safe, so the restarts are quiet while they run.  With a reducer,
+  // every process must run the restarts in the same order.
+  std::vector<arma::mat> restartCentroids(restarts);
+  arma::vec inertias(restarts);
+  const math::RandomStream stream = math::NewRandomStream();
+  const bool ignoring = Log::Info.ignoreInput;
+  Log::Info.ignoreInput = true;
+
+  #pragma omp parallel for schedule(dynamic, 1) if (reducer == NULL)
+  for (size_t r = 0; r < restarts; ++r)
+  {
+    math::RandomStream restartStream = stream.Split(r);
+    math::ScopedRandomStream scope(restartStream);
+
+    KMeans restart(*this);
+    restart.ClusterOnce(data, clusters, restartCentroids[r], false);
+    inertias[r] = restart.Inertia(data, restartCentroids[r]);
+  }
+
+  Log::Info.ignoreInput = ignoring;
+  for (size_t r = 0; r < restarts; ++r)
+    Log::Info << "KMeans::Cluster(): inertia of restart " << r << " is "
+        << inertias[r] << "." << std::endl;
+
+  arma::uword best;
+  inertias.min(best);
+  Log::Info << "KMeans::Cluster(): keeping restart " << best << "."
+      << std::endl;
+  centroids.steal_mem(restartCentroids[best]);
+}
+
+/**
+ * Run k-means once from the given initial centroids, or from the initial
+ * partition of the partitioner.
+ */
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         template<class, class> class LloydStepType,
+         typename MatType>
+void KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    LloydStepType,
+    MatType>::
+ClusterOnce(const MatType& data,
+            const size_t clusters,
+            arma::mat& centroids,
+            const bool initialGuess)
+{
   // Use the partitioner to come up with the partition assignments and calculate
   // the initial centroids.
   if (!initialGuess)
@@ -126,6 +209,16 @@ Cluster(const MatType& data,
       counts[assignments[i]]++;
     }
 
+    // The initial centroids are those of the partitions of all the shards.
+    if (reducer != NULL)
+    {
+      reducer->Sum(centroids.memptr(), centroids.n_elem);
+      arma::vec shardCounts = arma::conv_to<arma::vec>::from(counts);
+      reducer->Sum(shardCounts.memptr(), shardCounts.n_elem);
+      for (size_t i = 0; i < clusters; ++i)
+        counts[i] = (size_t) shardCounts[i];
+    }
+
     for (size_t i = 0; i < clusters; ++i)
       if (counts[i] != 0)
         centroids.col(i) /= counts[i];
@@ -137,6 +230,7 @@ Cluster(const MatType& data,
   size_t iteration = 0;
 
   LloydStepType<MetricType, MatType> lloydStep(data, metric);
+  SetLloydStepReducer(lloydStep, reducer);
   arma::mat centroidsOther;
   double cNorm;
 
@@ -151,11 +245,13 @@ Cluster(const MatType& data,
 
     // If we are not allowing empty clusters, then check that all of our
     // clusters have points.
+    bool emptyClusters = false;
     for (size_t i = 0; i < clusters; i++)
     {
       if (counts[i] == 0)
       {
-        Log::Info << "Cluster " << i << " is empty.\n";
+        emptyClusters = true;
+        MLPACK_LOG_INFO << "Cluster " << i << " is empty.\n";
         if (iteration % 2 == 0)
           emptyClusterAction.EmptyCluster(data, i, centroids, centroidsOther,
               counts, metric, iteration);
@@ -165,9 +261,18 @@ Cluster(const MatType& data,
       }
     }
 
+    // The empty cluster policy only sees the local shard, so the centroids of
+    // the root process are used by every process.
+    if (reducer != NULL && emptyClusters)
+    {
+      arma::mat& newCentroids = (iteration % 2 == 0) ? centroidsOther :
+          centroids;
+      reducer->Broadcast(newCentroids.memptr(), newCentroids.n_elem);
+    }
+
     iteration++;
-    Log::Info << "KMeans::Cluster(): iteration " << iteration << ", residual "
-        << cNorm << ".\n";
+    MLPACK_LOG_INFO << "KMeans::Cluster(): iteration " << iteration
+        << ", residual " << cNorm << ".\n";
     if (isnan(cNorm) || isinf(cNorm))
       cNorm = 1e-4; // Keep iterating.
 
@@ -193,6 +298,40 @@ Cluster(const MatType& data,
       << std::endl;
 }
 
+/**
+ * Compute the sum of the squared distances from each point to its closest
+ * centroid.
+ */
+template<typename MetricType,
+         typename InitialPartitionPolicy,
+         typename EmptyClusterPolicy,
+         template<class, class> class LloydStepType,
+         typename MatType>
+double KMeans<
+    MetricType,
+    InitialPartitionPolicy,
+    EmptyClusterPolicy,
+    LloydStepType,
+    MatType>::
+Inertia(const MatType& data, const arma::mat& centroids)
+{
+  double inertia = 0.0;
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    double minDistance = std::numeric_limits<double>::infinity();
+    for (size_t j = 0; j < centroids.n_cols; ++j)
+      minDistance = std::min(minDistance,
+          metric.Evaluate(data.col(i), centroids.col(j)));
+
+    inertia += minDistance * minDistance;
+  }
+
+  if (reducer != NULL)
+    reducer->Sum(&inertia, 1);
+
+  return inertia;
+}
+
 /**
  * Perform k-means clustering on the data, returning a list of cluster
  * assignments and the centroids of each cluster.
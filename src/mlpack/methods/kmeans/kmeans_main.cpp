@@ -5,14 +5,25 @@
  * Executable for running K-Means.
  */
 #include <mlpack/core.hpp>
+#include <fstream>
+#include <memory>
 
 #include "kmeans.hpp"
 #include "allow_empty_clusters.hpp"
 #include "refined_start.hpp"
+#include "kmeans_plus_plus.hpp"
+#include "kmeans_parallel.hpp"
 #include "elkan_kmeans.hpp"
 #include "hamerly_kmeans.hpp"
 #include "pelleg_moore_kmeans.hpp"
 #include "dual_tree_kmeans.hpp"
+#include "yinyang_kmeans.hpp"
+#include "mini_batch_kmeans.hpp"
+#include "chunked_kmeans.hpp"
+
+#ifdef MLPACK_USE_MPI
+  #include <mlpack/core/math/mpi_reducer.hpp>
+#endif
 
 using namespace mlpack;
 using namespace mlpack::kmeans;
@@ -34,12 +45,43 @@ PROGRAM_INFO("K-Means Clustering", "This program performs K-Means clustering "
     "to be used in each sample, the --percentage parameter is used (it should "
     "be a value between 0.0 and 1.0)."
     "\n\n"
+    "The k-means++ seeding (--kmeans_plus_plus (-K)) and its scalable version "
+    "k-means|| (--kmeans_parallel (-L)) are much cheaper alternatives, and "
+    "usually leave far fewer Lloyd iterations to run.  k-means|| runs --rounds "
+    "sampling rounds, each of which samples about --oversampling times the "
+    "number of clusters points."
+    "\n\n"
+    "With --restarts (-n), k-means is run that many times from different "
+    "initial points (in parallel, if mlpack was compiled with OpenMP), and the "
+    "centroids with the lowest inertia (the sum of the squared distances from "
+    "each point to its closest centroid) are kept.  Restarts are not used with "
+    "--initial_centroids."
+    "\n\n"
+    "If the dataset does not fit in memory, --chunk_size (-Z) can be given; "
+    "then the input file (in arma_binary format with one point per column, or "
+    "a CSV/text file with one point per line) is read that many points at a "
+    "time in each Lloyd iteration, and the labels are written to --output_file "
+    "as they are computed.  This uses the naive Lloyd step and random initial "
+    "points (or --initial_centroids), and --in_place is not available."
+    "\n\n"
+    "If mlpack was built with MPI, --distributed (-D) clusters a dataset that "
+    "is split into one file per process (run with mpirun): each '%r' in "
+    "--inputFile, --output_file, and --initial_centroids is replaced with the "
+    "rank of the process, and the sums of each Lloyd iteration are added up "
+    "over the processes, so that the centroids are those of the whole dataset. "
+    " The centroids are saved by rank 0 only, and the labels of each shard are "
+    "saved to the output file of its process.  This uses the naive Lloyd step, "
+    "and --restarts and --chunk_size are not available."
+    "\n\n"
     "There are several options available for the algorithm used for each Lloyd "
     "iteration, specified with the --algorithm (-a) option.  The standard O(kN)"
     " approach can be used ('naive').  Other options include the Pelleg-Moore "
     "tree-based algorithm ('pelleg-moore'), Elkan's triangle-inequality based "
-    "algorithm ('elkan'), and Hamerly's modification to Elkan's algorithm "
-    "('hamerly')."
+    "algorithm ('elkan'), Hamerly's modification to Elkan's algorithm "
+    "('hamerly'), and the Yinyang algorithm ('yinyang'), which keeps much of "
+    "the pruning of Elkan's algorithm with far less memory for large k.  For "
+    "very large datasets, mini-batch k-means ('minibatch') only looks at a "
+    "random batch of 1000 points in each iteration; its result is approximate."
     "\n\n"
     "As of October 2014, the --overclustering option has been removed.  If you "
     "want this support back, let us know -- file a bug at "
@@ -65,6 +107,9 @@ PARAM_FLAG("labels_only", "Only output labels into output file.", "l");
 PARAM_INT("max_iterations", "Maximum number of iterations before K-Means "
     "terminates.", "m", 1000);
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
+PARAM_INT("restarts", "Number of times to run k-means from different initial "
+    "points, in parallel; the centroids with the lowest inertia are kept.", "n",
+    1);
 PARAM_STRING("initial_centroids", "Start with the specified initial centroids.",
              "I", "");
 
@@ -76,8 +121,28 @@ PARAM_INT("samplings", "Number of samplings to perform for refined start (use "
 PARAM_DOUBLE("percentage", "Percentage of dataset to use for each refined start"
     " sampling (use when --refined_start is specified).", "p", 0.02);
 
+// Parameters for datasets that are read from disk in chunks.
+PARAM_INT("chunk_size", "If positive, read the input dataset from disk this "
+    "many points at a time instead of loading it.", "Z", 0);
+
+// Parameters for datasets that are split across MPI processes.
+PARAM_FLAG("distributed", "Cluster a dataset that is split across MPI "
+    "processes, one file per process (only if mlpack was built with MPI).",
+    "D");
+
+// Parameters for k-means++ and k-means|| seeding.
+PARAM_FLAG("kmeans_plus_plus", "Use the k-means++ seeding to choose initial "
+    "points.", "K");
+PARAM_FLAG("kmeans_parallel", "Use the k-means|| seeding to choose initial "
+    "points.", "L");
+PARAM_DOUBLE("oversampling", "Oversampling factor for k-means|| (use when "
+    "--kmeans_parallel is specified).", "O", 2.0);
+PARAM_INT("rounds", "Number of sampling rounds for k-means|| (use when "
+    "--kmeans_parallel is specified).", "R", 5);
+
 PARAM_STRING("algorithm", "Algorithm to use for the Lloyd iteration ('naive', "
-    "'pelleg-moore', 'elkan', 'hamerly', or 'dtnn').", "a", "naive");
+    "'pelleg-moore', 'elkan', 'hamerly', 'yinyang', 'minibatch', or 'dtnn').",
+    "a", "naive");
 
 // Given the type of initial partition policy, figure out the empty cluster
 // policy and run k-means.
@@ -95,16 +160,67 @@ template<typename InitialPartitionPolicy,
          template<class, class> class LloydStepType>
 void RunKMeans(const InitialPartitionPolicy& ipp);
 
+// Run k-means on a dataset that is read from disk in chunks.
+void RunChunkedKMeans();
+
+// With --distributed, the reducer of the sums of each process; otherwise NULL.
+math::Reducer* reducer = NULL;
+// Whether this process saves the centroids.
+bool saveCentroids = true;
+
 int main(int argc, char** argv)
 {
   CLI::ParseCommandLine(argc, argv);
 
+#ifdef MLPACK_USE_MPI
+  std::unique_ptr<math::MPISession> session;
+  std::unique_ptr<math::MPIReducer> mpiReducer;
+  if (CLI::HasParam("distributed"))
+  {
+    session.reset(new math::MPISession());
+    mpiReducer.reset(new math::MPIReducer());
+    reducer = mpiReducer.get();
+    saveCentroids = session->Root();
+
+    // Each process reads and writes its own files, and only rank 0 talks.
+    CLI::GetParam<string>("inputFile") =
+        session->RankFileName(CLI::GetParam<string>("inputFile"));
+    CLI::GetParam<string>("output_file") =
+        session->RankFileName(CLI::GetParam<string>("output_file"));
+    CLI::GetParam<string>("initial_centroids") =
+        session->RankFileName(CLI::GetParam<string>("initial_centroids"));
+    if (!session->Root())
+      Log::Info.ignoreInput = true;
+
+    if (CLI::GetParam<string>("algorithm") != "naive")
+      Log::Fatal << "Only the 'naive' algorithm can be used with "
+          << "--distributed." << endl;
+    if (CLI::GetParam<int>("restarts") > 1)
+      Log::Fatal << "--restarts cannot be used with --distributed." << endl;
+    if (CLI::GetParam<int>("chunk_size") != 0)
+      Log::Fatal << "--chunk_size cannot be used with --distributed." << endl;
+  }
+#else
+  if (CLI::HasParam("distributed"))
+    Log::Fatal << "--distributed can only be used if mlpack was built with "
+        << "MPI." << endl;
+#endif
+
   // Initialize random seed.
   if (CLI::GetParam<int>("seed") != 0)
     math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
   else
     math::RandomSeed((size_t) std::time(NULL));
 
+  if (CLI::GetParam<int>("chunk_size") < 0)
+    Log::Fatal << "Invalid chunk size (" << CLI::GetParam<int>("chunk_size")
+        << ")! Must be greater than or equal to 0." << endl;
+  if (CLI::GetParam<int>("chunk_size") > 0)
+  {
+    RunChunkedKMeans();
+    return 0;
+  }
+
   // Now, start building the KMeans type that we'll be using.  Start with the
   // initial partition policy.  The call to FindEmptyClusterPolicy<> results in
   // a call to RunKMeans<> and the algorithm is completed.
@@ -122,6 +238,25 @@ int main(int argc, char** argv)
 
     FindEmptyClusterPolicy<RefinedStart>(RefinedStart(samplings, percentage));
   }
+  else if (CLI::HasParam("kmeans_plus_plus"))
+  {
+    FindEmptyClusterPolicy<KMeansPlusPlus>(KMeansPlusPlus());
+  }
+  else if (CLI::HasParam("kmeans_parallel"))
+  {
+    const double oversampling = CLI::GetParam<double>("oversampling");
+    const int rounds = CLI::GetParam<int>("rounds");
+
+    if (oversampling <= 0.0)
+      Log::Fatal << "Oversampling factor (" << oversampling << ") must be "
+          << "greater than 0.0!" << endl;
+    if (rounds < 0)
+      Log::Fatal << "Number of rounds (" << rounds << ") must not be "
+          << "negative!" << endl;
+
+    FindEmptyClusterPolicy<KMeansParallel>(KMeansParallel(oversampling,
+        (size_t) rounds));
+  }
   else
   {
     FindEmptyClusterPolicy<RandomPartition>(RandomPartition());
@@ -149,6 +284,11 @@ void FindLloydStepType(const InitialPartitionPolicy& ipp)
     RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, ElkanKMeans>(ipp);
   else if (algorithm == "hamerly")
     RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, HamerlyKMeans>(ipp);
+  else if (algorithm == "yinyang")
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, YinyangKMeans>(ipp);
+  else if (algorithm == "minibatch")
+    RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy,
+        MiniBatchKMeans>(ipp);
   else if (algorithm == "pelleg-moore")
     RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy,
         PellegMooreKMeans>(ipp);
@@ -162,7 +302,8 @@ void FindLloydStepType(const InitialPartitionPolicy& ipp)
     RunKMeans<InitialPartitionPolicy, EmptyClusterPolicy, NaiveKMeans>(ipp);
   else
     Log::Fatal << "Unknown algorithm: '" << algorithm << "'.  Supported options"
-        << " are 'naive', 'pelleg-moore', 'elkan', and 'hamerly'." << endl;
+        << " are 'naive', 'pelleg-moore', 'elkan', 'hamerly', 'yinyang', and "
+        << "'minibatch'." << endl;
 }
 
 // Given the template parameters, sanitize/load input and run k-means.
@@ -197,6 +338,13 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
         ")! Must be greater than or equal to 0." << endl;
   }
 
+  const int restarts = CLI::GetParam<int>("restarts");
+  if (restarts < 1)
+  {
+    Log::Fatal << "Invalid value for restarts (" << restarts << ")! Must be "
+        << "greater than or equal to 1." << endl;
+  }
+
   // Make sure we have an output file if we're not doing the work in-place.
   if (!CLI::HasParam("in_place") && !CLI::HasParam("output_file") &&
       !CLI::HasParam("centroid_file"))
@@ -223,16 +371,26 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
     if (CLI::HasParam("refined_start"))
       Log::Warn << "Initial centroids are specified, but will be ignored "
           << "because --refined_start is also specified!" << endl;
+    else if (CLI::HasParam("kmeans_plus_plus") ||
+             CLI::HasParam("kmeans_parallel"))
+      Log::Warn << "Initial centroids are specified, so the seeding method "
+          << "will not be used!" << endl;
     else
       Log::Info << "Using initial centroid guesses from '" <<
           initialCentroidsFile << "'." << endl;
+
+    if (CLI::GetParam<int>("restarts") > 1)
+      Log::Warn << "Initial centroids are specified, so --restarts will be "
+          << "ignored!" << endl;
   }
 
   Timer::Start("clustering");
   KMeans<metric::EuclideanDistance,
          InitialPartitionPolicy,
          EmptyClusterPolicy,
-         LloydStepType> kmeans(maxIterations, metric::EuclideanDistance(), ipp);
+         LloydStepType> kmeans(maxIterations, metric::EuclideanDistance(), ipp,
+                               EmptyClusterPolicy(), (size_t) restarts);
+  kmeans.Reducer() = reducer;
 
   if (CLI::HasParam("output_file") || CLI::HasParam("in_place"))
   {
@@ -288,6 +446,88 @@ void RunKMeans(const InitialPartitionPolicy& ipp)
   }
 
   // Should we write the centroids to a file?
+  if (CLI::HasParam("centroid_file") && saveCentroids)
+    data::Save(CLI::GetParam<std::string>("centroid_file"), centroids);
+}
+
+// Run k-means on a dataset that is read from disk in chunks.
+void RunChunkedKMeans()
+{
+  const string inputFile = CLI::GetParam<string>("inputFile");
+  const size_t chunkSize = (size_t) CLI::GetParam<int>("chunk_size");
+  int clusters = CLI::GetParam<int>("clusters");
+  if (clusters < 0 || (clusters == 0 && !CLI::HasParam("initial_centroids")))
+    Log::Fatal << "Invalid number of clusters requested (" << clusters << ")! "
+        << "Must be positive, or 0 with --initial_centroids." << endl;
+
+  const int maxIterations = CLI::GetParam<int>("max_iterations");
+  if (maxIterations < 0)
+    Log::Fatal << "Invalid value for maximum iterations (" << maxIterations <<
+        ")! Must be greater than or equal to 0." << endl;
+
+  if (CLI::HasParam("in_place"))
+    Log::Fatal << "--in_place cannot be used with --chunk_size; use "
+        << "--output_file instead." << endl;
+  if (CLI::GetParam<string>("algorithm") != "naive" ||
+      CLI::HasParam("refined_start") || CLI::HasParam("kmeans_plus_plus") ||
+      CLI::HasParam("kmeans_parallel"))
+    Log::Warn << "With --chunk_size, the naive Lloyd step and random initial "
+        << "points are always used; --algorithm and the seeding options are "
+        << "ignored." << endl;
+  if (CLI::GetParam<int>("restarts") > 1)
+    Log::Warn << "--restarts cannot be used with --chunk_size, and will be "
+        << "ignored." << endl;
+  if (!CLI::HasParam("output_file") && !CLI::HasParam("centroid_file"))
+    Log::Warn << "--output_file and --centroid_file are not set; no results "
+        << "will be saved." << std::endl;
+
+  // Opening the file reads its header (or counts its lines).
+  std::unique_ptr<data::ChunkedReader> reader;
+  try
+  {
+    reader.reset(new data::ChunkedReader(inputFile, chunkSize));
+  }
+  catch (std::exception& e)
+  {
+    Log::Fatal << e.what() << endl;
+  }
+
+  arma::mat centroids;
+  const bool initialCentroidGuess = CLI::HasParam("initial_centroids");
+  if (initialCentroidGuess)
+  {
+    data::Load(CLI::GetParam<string>("initial_centroids"), centroids, true);
+    if (clusters == 0)
+      clusters = centroids.n_cols;
+  }
+
+  Timer::Start("clustering");
+  ChunkedKMeans<> kmeans((size_t) maxIterations);
+  try
+  {
+    kmeans.Cluster(*reader, (size_t) clusters, centroids,
+        initialCentroidGuess);
+
+    if (CLI::HasParam("output_file"))
+    {
+      // The labels are written as they are computed, so they do not have to
+      // fit in memory either.
+      const string outputFile = CLI::GetParam<string>("output_file");
+      std::ofstream output(outputFile.c_str());
+      if (!output.is_open())
+        Log::Fatal << "Cannot open '" << outputFile << "' for writing!" << endl;
+
+      kmeans.Assign(*reader, centroids, output,
+          CLI::HasParam("labels_only"),
+          (data::Extension(outputFile) == "csv") ? ',' : ' ');
+    }
+  }
+  catch (std::exception& e)
+  {
+    Log::Fatal << e.what() << endl;
+  }
+  Timer::Stop("clustering");
+
   if (CLI::HasParam("centroid_file"))
     data::Save(CLI::GetParam<std::string>("centroid_file"), centroids);
 }
@@ -0,0 +1,106 @@
+/**
+ * @file kmeans_parallel.hpp
+ * @author Ryan Curtin
+ *
+ * An implementation of the k-means|| seeding of Bahmani et al., a version of
+ * k-means++ that needs only a few passes over the data.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_HPP
+
+#include <mlpack/core.hpp>
+#include "kmeans_plus_plus.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * The k-means|| ("scalable k-means++") initial partitioning policy.  Where
+ * k-means++ needs k passes over the data to choose k centroids, k-means|| runs
+ * a small number of rounds, each of which is one pass over the data that
+ * samples every point independently with probability proportional to its
+ * squared distance to the closest candidate so far, with about
+ * oversampling * k points sampled in each round.  Each candidate is then
+ * weighted by the number of points closest to it, and the weighted candidates
+ * are reclustered into k centroids with the weighted k-means++ seeding.
+ * Finally, each point is assigned to its closest centroid.  For more
+ * information, see the following paper:
+ *
+ * @code
+ * @article{bahmani2012scalable,
+ *   title={Scalable k-means++},
+ *   author={Bahmani, B. and Moseley, B. and Vattani, A. and Kumar, R. and
+ *       Vassilvitskii, S.},
+ *   journal={Proceedings of the VLDB Endowment},
+ *   volume={5},
+ *   number={7},
+ *   pages={622--633},
+ *   year={2012}
+ * }
+ * @endcode
+ *
+ * If mlpack was compiled with OpenMP, the distances of each round are computed
+ * in parallel.
+ */
+class KMeansParallel
+{
+ public:
+  /**
+   * Create the KMeansParallel object, optionally specifying the oversampling
+   * factor and the number of rounds.
+   *
+   * @param oversampling Expected number of points sampled in each round,
+   *     divided by the number of clusters.
+   * @param rounds Number of sampling rounds.
+   */
+  KMeansParallel(const double oversampling = 2.0,
+                 const size_t rounds = 5) :
+      oversampling(oversampling), rounds(rounds) { }
+
+  /**
+   * Partition the given dataset into the given number of clusters with the
+   * k-means|| seeding.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Dataset to partition.
+   * @param clusters Number of clusters to split dataset into.
+   * @param assignments Vector to store cluster assignments into.  Values will
+   *     be between 0 and (clusters - 1).
+   */
+  template<typename MatType>
+  void Cluster(const MatType& data,
+               const size_t clusters,
+               arma::Col<size_t>& assignments) const;
+
+  //! Get the oversampling factor.
+  double Oversampling() const { return oversampling; }
+  //! Modify the oversampling factor.
+  double& Oversampling() { return oversampling; }
+
+  //! Get the number of sampling rounds.
+  size_t Rounds() const { return rounds; }
+  //! Modify the number of sampling rounds.
+  size_t& Rounds() { return rounds; }
+
+  //! Serialize the object.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(oversampling, "oversampling");
+    ar & data::CreateNVP(rounds, "rounds");
+  }
+
+ private:
+  //! The expected number of points sampled in each round, over k.
+  double oversampling;
+  //! The number of sampling rounds.
+  size_t rounds;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "kmeans_parallel_impl.hpp"
+
+#endif
@@ -0,0 +1,185 @@
+/**
+ * @file kmeans_parallel_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the k-means|| seeding.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PARALLEL_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kmeans_parallel.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+//! Partition the given dataset with the k-means|| seeding.
+template<typename MatType>
+void KMeansParallel::Cluster(const MatType& data,
+                             const size_t clusters,
+                             arma::Col<size_t>& assignments) const
+{
+  if (clusters == 0 || clusters > data.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "KMeansParallel::Cluster(): cannot choose " << clusters
+        << " centroids from " << data.n_cols << " points";
+    throw std::invalid_argument(oss.str());
+  }
+
+  const size_t n = data.n_cols;
+
+  // The squared distance from each point to its closest candidate, and the
+  // index of that candidate.
+  arma::vec minDistances(n);
+  minDistances.fill(std::numeric_limits<double>::infinity());
+  arma::Col<size_t> closest(n);
+  closest.zeros();
+
+  // The first candidate is a random point.
+  std::vector<size_t> candidates;
+  candidates.push_back(std::min((size_t) (math::Random() * n), n - 1));
+
+  size_t counted = 0; // The number of candidates in minDistances.
+  for (size_t round = 0; round <= rounds; ++round)
+  {
+    // Update the distances with the candidates of the last round.
+    arma::mat newCandidates(data.n_rows, candidates.size() - counted);
+    for (size_t c = counted; c < candidates.size(); ++c)
+      newCandidates.col(c - counted) = data.col(candidates[c]);
+
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; ++i)
+    {
+      for (size_t c = 0; c < newCandidates.n_cols; ++c)
+      {
+        const double distance = metric::SquaredEuclideanDistance::Evaluate(
+            data.col(i), newCandidates.col(c));
+        if (distance < minDistances[i])
+        {
+          minDistances[i] = distance;
+          closest[i] = counted + c;
+        }
+      }
+    }
+    counted = candidates.size();
+
+    if (round == rounds)
+      break;
+
+    // Sample each point independently.  The random number generator is not
+    // thread-safe, so this pass is not parallel, but it is cheap compared to
+    // the distance calculations.  Candidates are at distance 0, so they are
+    // never sampled again.
+    const double cost = arma::accu(minDistances);
+    if (cost == 0.0)
+      break; // Every point is a candidate already.
+
+    const double scale = oversampling * clusters / cost;
+    for (size_t i = 0; i < n; ++i)
+      if (math::Random() < scale * minDistances[i])
+        candidates.push_back(i);
+  }
+
+  Log::Info << "KMeansParallel::Cluster(): " << candidates.size()
+      << " candidates sampled." << std::endl;
+
+  if (candidates.size() < clusters)
+  {
+    // This can only happen when there are fewer distinct points than clusters,
+    // or when the rounds sampled too few points; k-means++ can handle that.
+    Log::Warn << "KMeansParallel::Cluster(): only " << candidates.size()
+        << " candidates sampled for " << clusters << " clusters; using "
+        << "k-means++ instead." << std::endl;
+    KMeansPlusPlus::Cluster(data, clusters, assignments);
+    return;
+  }
+
+  // Weight each candidate by the number of points closest to it.
+  arma::mat candidateSet(data.n_rows, candidates.size());
+  arma::vec weights(candidates.size());
+  weights.zeros();
+  for (size_t c = 0; c < candidates.size(); ++c)
+    candidateSet.col(c) = data.col(candidates[c]);
+  for (size_t i = 0; i < n; ++i)
+    weights[closest[i]] += 1.0;
+
+  // Recluster the weighted candidates: choose k of them with the weighted
+  // k-means++ seeding, and refine them with a few weighted Lloyd iterations.
+  arma::Col<size_t> centers, candidateAssignments;
+  KMeansPlusPlus::SelectCenters(candidateSet, weights, clusters, centers,
+      candidateAssignments);
+
+  arma::mat centroids(data.n_rows, clusters);
+  for (size_t j = 0; j < clusters; ++j)
+    centroids.col(j) = candidateSet.col(centers[j]);
+
+  for (size_t iteration = 0; iteration < 10; ++iteration)
+  {
+    arma::mat sums(data.n_rows, clusters);
+    sums.zeros();
+    arma::vec weightSums(clusters);
+    weightSums.zeros();
+    for (size_t c = 0; c < candidateSet.n_cols; ++c)
+    {
+      sums.col(candidateAssignments[c]) += weights[c] * candidateSet.col(c);
+      weightSums[candidateAssignments[c]] += weights[c];
+    }
+
+    for (size_t j = 0; j < clusters; ++j)
+      if (weightSums[j] > 0.0)
+        centroids.col(j) = sums.col(j) / weightSums[j];
+
+    bool changed = false;
+    for (size_t c = 0; c < candidateSet.n_cols; ++c)
+    {
+      double minDistance = std::numeric_limits<double>::infinity();
+      size_t closestCluster = clusters;
+      for (size_t j = 0; j < clusters; ++j)
+      {
+        const double distance = metric::SquaredEuclideanDistance::Evaluate(
+            candidateSet.col(c), centroids.col(j));
+        if (distance < minDistance)
+        {
+          minDistance = distance;
+          closestCluster = j;
+        }
+      }
+
+      if (closestCluster != candidateAssignments[c])
+      {
+        candidateAssignments[c] = closestCluster;
+        changed = true;
+      }
+    }
+
+    if (!changed)
+      break;
+  }
+
+  // Turn the final centroids into assignments.
+  assignments.set_size(n);
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n; ++i)
+  {
+    double minDistance = std::numeric_limits<double>::infinity();
+    size_t closestCluster = clusters;
+    for (size_t j = 0; j < clusters; ++j)
+    {
+      const double distance = metric::SquaredEuclideanDistance::Evaluate(
+          data.col(i), centroids.col(j));
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCluster = j;
+      }
+    }
+
+    assignments[i] = closestCluster;
+  }
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,93 @@
+/**
+ * @file kmeans_plus_plus.hpp
+ * @author Ryan Curtin
+ *
+ * An implementation of the k-means++ seeding of Arthur and Vassilvitskii, which
+ * chooses well-spread initial centroids for k-means.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * The k-means++ initial partitioning policy.  The first centroid is a random
+ * point, and each following centroid is a point chosen with probability
+ * proportional to its squared distance to the closest centroid chosen so far.
+ * Each point is then assigned to its closest centroid.  This takes k passes
+ * over the data, and the expected k-means cost of the seeding is within a
+ * factor of O(log k) of the optimal cost.  For more information, see the
+ * following paper:
+ *
+ * @code
+ * @inproceedings{arthur2007kmeans,
+ *   title={k-means++: The advantages of careful seeding},
+ *   author={Arthur, D. and Vassilvitskii, S.},
+ *   booktitle={Proceedings of the Eighteenth Annual ACM-SIAM Symposium on
+ *       Discrete Algorithms (SODA 2007)},
+ *   pages={1027--1035},
+ *   year={2007}
+ * }
+ * @endcode
+ *
+ * If mlpack was compiled with OpenMP, the distances of each pass are
+ * computed in parallel.
+ */
+class KMeansPlusPlus
+{
+ public:
+  //! Empty constructor, required by the InitialPartitionPolicy policy.
+  KMeansPlusPlus() { }
+
+  /**
+   * Partition the given dataset into the given number of clusters, by choosing
+   * the k-means++ centroids and assigning each point to the closest one.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Dataset to partition.
+   * @param clusters Number of clusters to split dataset into.
+   * @param assignments Vector to store cluster assignments into.  Values will
+   *     be between 0 and (clusters - 1).
+   */
+  template<typename MatType>
+  static void Cluster(const MatType& data,
+                      const size_t clusters,
+                      arma::Col<size_t>& assignments);
+
+  /**
+   * Choose the given number of centroids from the points of the dataset with
+   * the k-means++ seeding, where each point may be given a weight (so that a
+   * point is chosen with probability proportional to its weight times its
+   * squared distance to the closest centroid so far).  This is also the
+   * reclustering step of KMeansParallel.
+   *
+   * @tparam MatType Type of data (arma::mat or arma::sp_mat).
+   * @param data Dataset to choose centroids from.
+   * @param weights Weight of each point, or an empty vector for equal weights.
+   * @param clusters Number of centroids to choose.
+   * @param centers Indices of the chosen points.
+   * @param assignments Index (in centers) of the closest centroid to each
+   *     point.
+   */
+  template<typename MatType>
+  static void SelectCenters(const MatType& data,
+                            const arma::vec& weights,
+                            const size_t clusters,
+                            arma::Col<size_t>& centers,
+                            arma::Col<size_t>& assignments);
+
+  //! Serialize the partitioner (nothing to do).
+  template<typename Archive>
+  void Serialize(Archive& /* ar */, const unsigned int /* version */) { }
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "kmeans_plus_plus_impl.hpp"
+
+#endif
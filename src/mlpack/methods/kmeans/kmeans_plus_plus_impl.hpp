@@ -0,0 +1,106 @@
+/**
+ * @file kmeans_plus_plus_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the k-means++ seeding.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_KMEANS_PLUS_PLUS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "kmeans_plus_plus.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace kmeans {
+
+//! Partition the given dataset with the k-means++ seeding.
+template<typename MatType>
+void KMeansPlusPlus::Cluster(const MatType& data,
+                             const size_t clusters,
+                             arma::Col<size_t>& assignments)
+{
+  arma::Col<size_t> centers;
+  SelectCenters(data, arma::vec(), clusters, centers, assignments);
+}
+
+//! Choose centroids with the (weighted) k-means++ seeding.
+template<typename MatType>
+void KMeansPlusPlus::SelectCenters(const MatType& data,
+                                   const arma::vec& weights,
+                                   const size_t clusters,
+                                   arma::Col<size_t>& centers,
+                                   arma::Col<size_t>& assignments)
+{
+  if (clusters == 0 || clusters > data.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "KMeansPlusPlus::SelectCenters(): cannot choose " << clusters
+        << " centroids from " << data.n_cols << " points";
+    throw std::invalid_argument(oss.str());
+  }
+
+  const size_t n = data.n_cols;
+  const bool weighted = (weights.n_elem == n);
+
+  // The squared distance from each point to its closest centroid so far.
+  arma::vec minDistances(n);
+  minDistances.fill(std::numeric_limits<double>::infinity());
+  assignments.zeros(n);
+  centers.set_size(clusters);
+
+  // The probability of choosing each point, up to each point.
+  arma::vec cumulative(n);
+
+  for (size_t c = 0; c < clusters; ++c)
+  {
+    size_t center;
+    const double total = (c == 0) ? 0.0 : cumulative[n - 1];
+    if (total > 0.0)
+    {
+      // Choose a point with probability proportional to its (weighted) squared
+      // distance.  A point that is already a centroid has probability 0.
+      const double r = math::Random() * total;
+      center = std::upper_bound(cumulative.begin(), cumulative.end(), r) -
+          cumulative.begin();
+      center = std::min(center, n - 1);
+    }
+    else
+    {
+      // Either this is the first centroid, or every point is at distance 0 from
+      // a centroid (there are many duplicate points); choose any point.
+      center = std::min((size_t) (math::Random() * n), n - 1);
+    }
+    centers[c] = center;
+
+    // Update the distances with the new centroid.
+    const arma::vec centerPoint(data.col(center));
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; ++i)
+    {
+      const double distance = metric::SquaredEuclideanDistance::Evaluate(
+          data.col(i), centerPoint);
+      if (distance < minDistances[i])
+      {
+        minDistances[i] = distance;
+        assignments[i] = c;
+      }
+    }
+
+    if (c + 1 == clusters)
+      break;
+
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i)
+    {
+      sum += (weighted ? weights[i] : 1.0) * minDistances[i];
+      cumulative[i] = sum;
+    }
+  }
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
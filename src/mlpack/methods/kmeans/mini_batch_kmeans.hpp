@@ -0,0 +1,125 @@
+/**
+ * @file mini_batch_kmeans.hpp
+ * @author Ryan Curtin
+ *
+ * An implementation of a mini-batch step of the Lloyd algorithm, which only
+ * looks at a random sample of the points in each iteration.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_HPP
+#define __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * An implementation of mini-batch k-means, for use as the LloydStepType of the
+ * KMeans class.  Unlike the other Lloyd step types, each iteration does not
+ * look at the whole dataset: it draws a random batch of points, assigns each
+ * of them to its closest centroid, and moves each centroid towards the batch
+ * points assigned to it with a per-centroid learning rate of one over the
+ * number of points the centroid has been given so far.  For more information,
+ * see the following paper:
+ *
+ * @code
+ * @inproceedings{sculley2010web,
+ *   title={Web-scale k-means clustering},
+ *   author={Sculley, D.},
+ *   booktitle={Proceedings of the 19th International Conference on World Wide
+ *       Web (WWW 2010)},
+ *   pages={1177--1178},
+ *   year={2010}
+ * }
+ * @endcode
+ *
+ * The result is an approximation of the clustering Lloyd's algorithm finds,
+ * but each iteration costs O(bk) instead of O(nk), where b is the batch size.
+ * The batch should be several times larger than the number of clusters, so
+ * that few centroids are left without points in the first iterations.
+ *
+ * Because the centroids keep moving a little from batch to batch, the
+ * movement alone is not a good convergence test.  Iterate() also tracks an
+ * exponentially weighted average of the mean distance of the batch points to
+ * their centroids, and once that average has not improved for
+ * MaxNoImprovement iterations in a row, Iterate() returns 0 so that KMeans
+ * stops.
+ *
+ * The counts that Iterate() returns are the total number of points given to
+ * each centroid over all iterations, so a cluster is only reported as empty if
+ * no point was ever assigned to it.
+ *
+ * @param MetricType Type of metric used with this implementation.
+ * @param MatType Matrix type (arma::mat or arma::sp_mat).
+ */
+template<typename MetricType, typename MatType>
+class MiniBatchKMeans
+{
+ public:
+  /**
+   * Construct the MiniBatchKMeans object with the given dataset and metric.
+   *
+   * @param dataset Dataset.
+   * @param metric Instantiated metric.
+   * @param batchSize Number of points to sample in each iteration.
+   */
+  MiniBatchKMeans(const MatType& dataset,
+                  MetricType& metric,
+                  const size_t batchSize = 1000);
+
+  /**
+   * Run a single mini-batch iteration, updating the given centroids into the
+   * newCentroids matrix.  If mlpack was compiled with OpenMP, the points of the
+   * batch are assigned to their centroids in parallel.
+   *
+   * @param centroids Current cluster centroids.
+   * @param newCentroids New cluster centroids.
+   * @param counts Number of points assigned to each cluster so far.
+   * @return The movement of the centroids, or 0 if the batches have stopped
+   *     improving.
+   */
+  double Iterate(const arma::mat& centroids,
+                 arma::mat& newCentroids,
+                 arma::Col<size_t>& counts);
+
+  size_t DistanceCalculations() const { return distanceCalculations; }
+
+  //! Get the number of points sampled in each iteration.
+  size_t BatchSize() const { return batchSize; }
+  //! Modify the number of points sampled in each iteration.
+  size_t& BatchSize() { return batchSize; }
+
+  //! The number of iterations without improvement before Iterate() reports
+  //! convergence.
+  static const size_t MaxNoImprovement = 10;
+
+ private:
+  //! The dataset.
+  const MatType& dataset;
+  //! The instantiated metric.
+  MetricType& metric;
+
+  //! The number of points sampled in each iteration.
+  size_t batchSize;
+
+  //! The total number of points given to each cluster.
+  arma::Col<size_t> clusterCounts;
+
+  //! The average batch distortion, weighted towards recent batches.
+  double averageDistortion;
+  //! The lowest average batch distortion so far.
+  double bestDistortion;
+  //! The number of iterations since bestDistortion was last improved.
+  size_t noImprovement;
+
+  //! Number of distance calculations.
+  size_t distanceCalculations;
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "mini_batch_kmeans_impl.hpp"
+
+#endif
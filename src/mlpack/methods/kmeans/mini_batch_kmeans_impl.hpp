@@ -0,0 +1,174 @@
+/**
+ * @file mini_batch_kmeans_impl.hpp
+ * @author Ryan Curtin
+ *
+ * An implementation of a mini-batch step of the Lloyd algorithm.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_MINI_BATCH_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "mini_batch_kmeans.hpp"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MetricType, typename MatType>
+MiniBatchKMeans<MetricType, MatType>::MiniBatchKMeans(const MatType& dataset,
+                                                      MetricType& metric,
+                                                      const size_t batchSize) :
+    dataset(dataset),
+    metric(metric),
+    batchSize(batchSize),
+    averageDistortion(0.0),
+    bestDistortion(DBL_MAX),
+    noImprovement(0),
+    distanceCalculations(0)
+{
+  if (batchSize == 0)
+    throw std::invalid_argument("MiniBatchKMeans::MiniBatchKMeans(): batch "
+        "size must be positive");
+}
+
+// Run a single iteration.
+template<typename MetricType, typename MatType>
+double MiniBatchKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
+                                                     arma::mat& newCentroids,
+                                                     arma::Col<size_t>& counts)
+{
+  // If this is the first iteration, no points have been given to any cluster.
+  const bool firstIteration = (clusterCounts.n_elem != centroids.n_cols);
+  if (firstIteration)
+  {
+    clusterCounts.zeros(centroids.n_cols);
+    bestDistortion = DBL_MAX;
+    noImprovement = 0;
+  }
+
+  // Draw the batch.  The random number generator is not thread-safe, so this
+  // is done before the parallel section; the batch is sorted so that the
+  // points are visited in memory order.
+  const size_t n = dataset.n_cols;
+  arma::Col<size_t> batch(batchSize);
+  for (size_t i = 0; i < batchSize; ++i)
+    batch[i] = std::min((size_t) (math::Random() * n), n - 1);
+  batch = arma::sort(batch);
+
+  const size_t numThreads = parallel::Threads();
+
+  // Each thread accumulates the sums and counts of its own batch points.
+  std::vector<arma::mat> threadSums(numThreads);
+  std::vector<arma::Col<size_t> > threadCounts(numThreads);
+  double distortion = 0.0;
+
+  #pragma omp parallel num_threads(numThreads) reduction(+:distortion)
+  {
+#ifdef _OPENMP
+    const size_t thread = (size_t) omp_get_thread_num();
+#else
+    const size_t thread = 0;
+#endif
+    threadSums[thread].zeros(centroids.n_rows, centroids.n_cols);
+    threadCounts[thread].zeros(centroids.n_cols);
+
+    MetricType threadMetric(metric);
+
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < batchSize; ++i)
+    {
+      // Find the closest centroid to this point.
+      double minDistance = std::numeric_limits<double>::infinity();
+      size_t closestCluster = centroids.n_cols; // Invalid value.
+
+      for (size_t j = 0; j < centroids.n_cols; ++j)
+      {
+        const double distance = threadMetric.Evaluate(dataset.col(batch[i]),
+            centroids.col(j));
+
+        if (distance < minDistance)
+        {
+          minDistance = distance;
+          closestCluster = j;
+        }
+      }
+
+      Log::Assert(closestCluster != centroids.n_cols);
+
+      threadSums[thread].col(closestCluster) +=
+          arma::vec(dataset.col(batch[i]));
+      threadCounts[thread][closestCluster]++;
+      distortion += minDistance;
+    }
+  }
+  distanceCalculations += batchSize * centroids.n_cols;
+
+  // Merge the batch sums in thread order, as parallel::BlockReduce() does.
+  arma::mat batchSums = std::move(threadSums[0]);
+  arma::Col<size_t> batchCounts = std::move(threadCounts[0]);
+  for (size_t t = 1; t < numThreads; ++t)
+  {
+    batchSums += threadSums[t];
+    batchCounts += threadCounts[t];
+  }
+
+  // Moving a centroid towards each of its m new points in turn, with a
+  // learning rate of 1 / (number of points given to it so far), is the same as
+  // taking the weighted mean of the old centroid and the new points.
+  newCentroids = centroids;
+  for (size_t c = 0; c < centroids.n_cols; ++c)
+  {
+    if (batchCounts[c] == 0)
+      continue;
+
+    const double oldCount = (double) clusterCounts[c];
+    clusterCounts[c] += batchCounts[c];
+    newCentroids.col(c) = (oldCount * centroids.col(c) + batchSums.col(c)) /
+        (double) clusterCounts[c];
+  }
+  counts = clusterCounts;
+
+  // Calculate the movement of the centroids.
+  double cNorm = 0.0;
+  for (size_t c = 0; c < centroids.n_cols; ++c)
+  {
+    cNorm += std::pow(metric.Evaluate(centroids.col(c), newCentroids.col(c)),
+        2.0);
+  }
+  distanceCalculations += centroids.n_cols;
+
+  // Update the average distance of the batch points to their centroids; a
+  // batch is given more weight the larger it is compared to the dataset.
+  distortion /= batchSize;
+  if (firstIteration)
+  {
+    averageDistortion = distortion;
+  }
+  else
+  {
+    const double alpha = std::min(2.0 * batchSize / (n + 1.0), 1.0);
+    averageDistortion = (1.0 - alpha) * averageDistortion + alpha * distortion;
+  }
+
+  if (averageDistortion < bestDistortion)
+  {
+    bestDistortion = averageDistortion;
+    noImprovement = 0;
+  }
+  else if (++noImprovement >= MaxNoImprovement)
+  {
+    Log::Info << "MiniBatchKMeans::Iterate(): no improvement for "
+        << noImprovement << " iterations; converged." << std::endl;
+    return 0.0;
+  }
+
+  return std::sqrt(cNorm);
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
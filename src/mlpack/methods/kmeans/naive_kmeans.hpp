@@ -9,6 +9,9 @@
 #ifndef __MLPACK_METHODS_KMEANS_NAIVE_KMEANS_HPP
 #define __MLPACK_METHODS_KMEANS_NAIVE_KMEANS_HPP
 
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/math/reducer.hpp>
+
 namespace mlpack {
 namespace kmeans {
 
@@ -37,8 +40,17 @@ class NaiveKMeans
    * Run a single iteration of the Lloyd algorithm, updating the given centroids
    * into the newCentroids matrix.
    *
+   * With OpenMP, the blocks of points are assigned and summed in parallel with
+   * parallel::BlockReduce().
+   *
+   * If a reducer is set (see Reducer()), the dataset is one shard of a larger
+   * dataset, and the centroid sums and counts are added up over all the shards
+   * before the new centroids are computed, so every process gets the
+   * centroids of the whole dataset.
+   *
    * @param centroids Current cluster centroids.
    * @param newCentroids New cluster centroids.
+   * @param counts Number of points assigned to each new cluster.
    */
   double Iterate(const arma::mat& centroids,
                  arma::mat& newCentroids,
@@ -46,6 +58,11 @@ class NaiveKMeans
 
   size_t DistanceCalculations() const { return distanceCalculations; }
 
+  //! Get the reducer of the centroid sums and counts (NULL if there is none).
+  math::Reducer* Reducer() const { return reducer; }
+  //! Modify the reducer of the centroid sums and counts (NULL for none).
+  math::Reducer*& Reducer() { return reducer; }
+
  private:
   //! The dataset.
   const MatType& dataset;
@@ -54,6 +71,60 @@ class NaiveKMeans
 
   //! Number of distance calculations.
   size_t distanceCalculations;
+  //! The reducer of the centroid sums and counts, if the dataset is a shard.
+  math::Reducer* reducer;
+
+  //! The number of points assigned to clusters as one block.
+  static const size_t BlockSize = 256;
+
+  //! Whether or not the distances of a block can be computed with matrix
+  //! multiplication: the metric must be the (squared) Euclidean distance, and
+  //! the data must be dense.
+  static const bool UseBlockDistances =
+      metric::IsEuclideanMetric<MetricType>::Value &&
+      arma::is_Mat<MatType>::value &&
+      std::is_same<typename MatType::elem_type, double>::value;
+
+  /**
+   * Find the closest centroid to each point in the given block, computing each
+   * distance with the metric.
+   *
+   * @param begin Index of the first point in the block.
+   * @param end Index of the last point in the block.
+   * @param centroids Current cluster centroids.
+   * @param centroidNorms Ignored.
+   * @param threadMetric Instantiated metric.
+   * @param assignments Vector to store the closest centroid of each point in.
+   */
+  void AssignBlock(const size_t begin,
+                   const size_t end,
+                   const arma::mat& centroids,
+                   const arma::vec& centroidNorms,
+                   MetricType& threadMetric,
+                   arma::Col<size_t>& assignments,
+                   std::false_type /* useBlockDistances */) const;
+
+  /**
+   * Find the closest centroid to each point in the given block, ranking the
+   * centroids with one matrix multiplication.  Because of rounding, the
+   * distance of every centroid that ranks (nearly) as close as the best is
+   * then computed with the metric, so the result is the same as if every
+   * distance had been computed with the metric.
+   *
+   * @param begin Index of the first point in the block.
+   * @param end Index of the last point in the block.
+   * @param centroids Current cluster centroids.
+   * @param centroidNorms Squared norm of each centroid.
+   * @param threadMetric Instantiated metric.
+   * @param assignments Vector to store the closest centroid of each point in.
+   */
+  void AssignBlock(const size_t begin,
+                   const size_t end,
+                   const arma::mat& centroids,
+                   const arma::vec& centroidNorms,
+                   MetricType& threadMetric,
+                   arma::Col<size_t>& assignments,
+                   std::true_type /* useBlockDistances */) const;
 };
 
 } // namespace kmeans
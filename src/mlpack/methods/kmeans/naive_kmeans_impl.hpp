@@ -20,7 +20,8 @@ NaiveKMeans<MetricType, MatType>::NaiveKMeans(const MatType& dataset,
                                               MetricType& metric) :
     dataset(dataset),
     metric(metric),
-    distanceCalculations(0)
+    distanceCalculations(0),
+    reducer(NULL)
 { /* Nothing to do. */ }
 
 // Run a single iteration.
@@ -29,32 +30,49 @@ double NaiveKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
                                                  arma::mat& newCentroids,
                                                  arma::Col<size_t>& counts)
 {
-  newCentroids.zeros(centroids.n_rows, centroids.n_cols);
-  counts.zeros(centroids.n_cols);
+  // The squared norms of the centroids are only needed with block distances.
+  arma::vec centroidNorms;
+  if (UseBlockDistances)
+    centroidNorms = arma::trans(arma::sum(arma::square(centroids), 0));
 
-  // Find the closest centroid to each point and update the new centroids.
-  for (size_t i = 0; i < dataset.n_cols; i++)
-  {
-    // Find the closest centroid to this point.
-    double minDistance = std::numeric_limits<double>::infinity();
-    size_t closestCluster = centroids.n_cols; // Invalid value.
+  // Each thread accumulates the sums and counts of its own blocks of points.
+  typedef std::pair<arma::mat, arma::Col<size_t>> SumsType;
+  SumsType sums = parallel::BlockReduce(dataset.n_cols, BlockSize,
+      SumsType(arma::zeros<arma::mat>(centroids.n_rows, centroids.n_cols),
+          arma::zeros<arma::Col<size_t>>(centroids.n_cols)),
+      [&](SumsType& blockSums, const size_t begin, const size_t end)
+      {
+        MetricType blockMetric(metric);
+        arma::Col<size_t> assignments(end - begin);
 
-    for (size_t j = 0; j < centroids.n_cols; j++)
-    {
-      const double distance = metric.Evaluate(dataset.col(i), centroids.col(j));
+        // Find the closest centroid to each point in the block.
+        AssignBlock(begin, end - 1, centroids, centroidNorms, blockMetric,
+            assignments, std::integral_constant<bool, UseBlockDistances>());
 
-      if (distance < minDistance)
+        // Update the closest centroids.
+        for (size_t i = begin; i < end; ++i)
+        {
+          const size_t closestCluster = assignments[i - begin];
+          blockSums.first.col(closestCluster) += arma::vec(dataset.col(i));
+          blockSums.second[closestCluster]++;
+        }
+      },
+      [](SumsType& total, const SumsType& blockSums)
       {
-        minDistance = distance;
-        closestCluster = j;
-      }
-    }
+        total.first += blockSums.first;
+        total.second += blockSums.second;
+      });
+  newCentroids = std::move(sums.first);
+  counts = std::move(sums.second);
 
-    Log::Assert(closestCluster != centroids.n_cols);
-
-    // We now have the minimum distance centroid index.  Update that centroid.
-    newCentroids.col(closestCluster) += arma::vec(dataset.col(i));
-    counts(closestCluster)++;
+  // Add up the sums and counts of every shard, if the dataset is a shard.
+  if (reducer != NULL)
+  {
+    reducer->Sum(newCentroids.memptr(), newCentroids.n_elem);
+    arma::vec shardCounts = arma::conv_to<arma::vec>::from(counts);
+    reducer->Sum(shardCounts.memptr(), shardCounts.n_elem);
+    for (size_t i = 0; i < counts.n_elem; ++i)
+      counts[i] = (size_t) shardCounts[i];
   }
 
   // Now normalize the centroid.
@@ -78,6 +96,91 @@ double NaiveKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
   return std::sqrt(cNorm);
 }
 
+template<typename MetricType, typename MatType>
+void NaiveKMeans<MetricType, MatType>::AssignBlock(
+    const size_t begin,
+    const size_t end,
+    const arma::mat& centroids,
+    const arma::vec& /* centroidNorms */,
+    MetricType& threadMetric,
+    arma::Col<size_t>& assignments,
+    std::false_type /* useBlockDistances */) const
+{
+  for (size_t i = begin; i <= end; ++i)
+  {
+    // Find the closest centroid to this point.
+    double minDistance = std::numeric_limits<double>::infinity();
+    size_t closestCluster = centroids.n_cols; // Invalid value.
+
+    for (size_t j = 0; j < centroids.n_cols; j++)
+    {
+      const double distance = threadMetric.Evaluate(dataset.col(i),
+          centroids.col(j));
+
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCluster = j;
+      }
+    }
+
+    Log::Assert(closestCluster != centroids.n_cols);
+
+    assignments[i - begin] = closestCluster;
+  }
+}
+
+template<typename MetricType, typename MatType>
+void NaiveKMeans<MetricType, MatType>::AssignBlock(
+    const size_t begin,
+    const size_t end,
+    const arma::mat& centroids,
+    const arma::vec& centroidNorms,
+    MetricType& threadMetric,
+    arma::Col<size_t>& assignments,
+    std::true_type /* useBlockDistances */) const
+{
+  // ||x - c||^2 = ||x||^2 + ||c||^2 - 2 x^T c, and ||x||^2 does not change the
+  // ranking of the centroids for a point, so (||c||^2 - 2 x^T c) ranks them.
+  const arma::mat points = dataset.cols(begin, end);
+  const arma::mat scores = arma::trans(centroids) * points;
+  const double maxCentroidNorm = centroidNorms.max();
+
+  for (size_t p = 0; p < points.n_cols; ++p)
+  {
+    double bestScore = std::numeric_limits<double>::infinity();
+    for (size_t j = 0; j < centroids.n_cols; ++j)
+      bestScore = std::min(bestScore, centroidNorms[j] - 2 * scores(j, p));
+
+    // The rounding error of a score is far smaller than this tolerance, so the
+    // closest centroid is always among the candidates within it.
+    const double pointNorm = arma::dot(points.col(p), points.col(p));
+    const double tolerance = 1e-8 * (pointNorm + maxCentroidNorm);
+
+    // Compute the exact distance to each candidate, in order, just like the
+    // loop over all the centroids does.
+    double minDistance = std::numeric_limits<double>::infinity();
+    size_t closestCluster = centroids.n_cols; // Invalid value.
+    for (size_t j = 0; j < centroids.n_cols; ++j)
+    {
+      if (centroidNorms[j] - 2 * scores(j, p) > bestScore + tolerance)
+        continue;
+
+      const double distance = threadMetric.Evaluate(points.col(p),
+          centroids.col(j));
+      if (distance < minDistance)
+      {
+        minDistance = distance;
+        closestCluster = j;
+      }
+    }
+
+    Log::Assert(closestCluster != centroids.n_cols);
+
+    assignments[p] = closestCluster;
+  }
+}
+
 } // namespace kmeans
 } // namespace mlpack
 
@@ -40,9 +40,14 @@ class RandomPartition
                              const size_t clusters,
                              arma::Col<size_t>& assignments)
   {
-    // Implementation is so simple we'll put it here in the header file.
-    assignments = arma::shuffle(arma::linspace<arma::Col<size_t> >(0,
-        (clusters - 1), data.n_cols));
+    // Implementation is so simple we'll put it here in the header file.  The
+    // shuffle uses math::RandInt() (not arma::shuffle()), so that it draws
+    // from the stream of the calling thread when it is run in parallel (see
+    // math::ScopedRandomStream).
+    assignments = arma::linspace<arma::Col<size_t> >(0, (clusters - 1),
+        data.n_cols);
+    for (size_t i = data.n_cols; i > 1; --i)
+      std::swap(assignments[i - 1], assignments[math::RandInt((int) i)]);
   }
 
   //! Serialize the partitioner (nothing to do).
@@ -0,0 +1,112 @@
+/**
+ * @file yinyang_kmeans.hpp
+ * @author Ryan Curtin
+ *
+ * An implementation of the Yinyang algorithm for exact Lloyd iterations, which
+ * keeps one lower bound for each group of centroids instead of one for each
+ * centroid.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_YINYANG_KMEANS_HPP
+#define __MLPACK_METHODS_KMEANS_YINYANG_KMEANS_HPP
+
+#include "float_bound.hpp"
+
+namespace mlpack {
+namespace kmeans {
+
+/**
+ * An implementation of the Yinyang k-means algorithm for a single Lloyd
+ * iteration.  The centroids are clustered into about k / 10 groups when the
+ * first iteration is run, and each point keeps an upper bound on the distance
+ * to its centroid and, for each group, a lower bound on the distance to every
+ * centroid of that group except its own.  A point is only compared with the
+ * centroids of the groups whose lower bound is smaller than its upper bound,
+ * so most of the pruning of Elkan's algorithm is kept, but the bounds take
+ * k / 10 values per point instead of k.  The lower bounds are also stored in
+ * single precision.  For more information, see the following paper:
+ *
+ * @code
+ * @inproceedings{ding2015yinyang,
+ *   title={Yinyang k-means: A drop-in replacement of the classic k-means with
+ *       consistent speedup},
+ *   author={Ding, Y. and Zhao, Y. and Shen, X. and Musuvathi, M. and
+ *       Mytkowicz, T.},
+ *   booktitle={Proceedings of the 32nd International Conference on Machine
+ *       Learning (ICML 2015)},
+ *   pages={579--587},
+ *   year={2015}
+ * }
+ * @endcode
+ *
+ * Like ElkanKMeans, this requires the metric to satisfy the triangle
+ * inequality.
+ *
+ * @param MetricType Type of metric used with this implementation.
+ * @param MatType Matrix type (arma::mat or arma::sp_mat).
+ */
+template<typename MetricType, typename MatType>
+class YinyangKMeans
+{
+ public:
+  /**
+   * Construct the YinyangKMeans object, which must store several sets of
+   * bounds.
+   */
+  YinyangKMeans(const MatType& dataset, MetricType& metric);
+
+  /**
+   * Run a single iteration of the Yinyang algorithm, updating the given
+   * centroids into the newCentroids matrix.
+   *
+   * With OpenMP, the global and group filters run on the points in parallel,
+   * and the centroid sums are combined as in parallel::BlockReduce().
+   *
+   * @param centroids Current cluster centroids.
+   * @param newCentroids New cluster centroids.
+   * @param counts Current counts, to be overwritten with new counts.
+   */
+  double Iterate(const arma::mat& centroids,
+                 arma::mat& newCentroids,
+                 arma::Col<size_t>& counts);
+
+  size_t DistanceCalculations() const { return distanceCalculations; }
+
+ private:
+  //! The dataset.
+  const MatType& dataset;
+  //! The instantiated metric.
+  MetricType& metric;
+
+  //! The group of each centroid.
+  arma::Col<size_t> centroidGroups;
+  //! The centroids of each group, one group after the other.
+  arma::Col<size_t> groupMembers;
+  //! The offset of the centroids of each group in groupMembers.
+  arma::Col<size_t> groupOffsets;
+
+  //! Holds the index of the cluster that owns each point.
+  arma::Col<size_t> assignments;
+
+  //! Upper bounds on the distance between each point and its closest cluster.
+  arma::vec upperBounds;
+  //! Lower bounds on the distance between each point and the clusters of each
+  //! group (other than its own cluster).
+  arma::fmat lowerBounds;
+
+  //! Track distance calculations.
+  size_t distanceCalculations;
+
+  /**
+   * Cluster the given centroids into groups with a few Lloyd iterations, and
+   * fill centroidGroups, groupMembers, and groupOffsets.
+   */
+  void GroupCentroids(const arma::mat& centroids);
+};
+
+} // namespace kmeans
+} // namespace mlpack
+
+// Include implementation.
+#include "yinyang_kmeans_impl.hpp"
+
+#endif
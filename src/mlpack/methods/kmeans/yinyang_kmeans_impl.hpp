@@ -0,0 +1,281 @@
+/**
+ * @file yinyang_kmeans_impl.hpp
+ * @author Ryan Curtin
+ *
+ * An implementation of the Yinyang algorithm for exact Lloyd iterations.
+ */
+#ifndef __MLPACK_METHODS_KMEANS_YINYANG_KMEANS_IMPL_HPP
+#define __MLPACK_METHODS_KMEANS_YINYANG_KMEANS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "yinyang_kmeans.hpp"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+namespace mlpack {
+namespace kmeans {
+
+template<typename MetricType, typename MatType>
+YinyangKMeans<MetricType, MatType>::YinyangKMeans(const MatType& dataset,
+                                                  MetricType& metric) :
+    dataset(dataset),
+    metric(metric),
+    distanceCalculations(0)
+{
+  // Nothing to do.
+}
+
+// Run a single iteration of the Yinyang algorithm for Lloyd iterations.
+template<typename MetricType, typename MatType>
+double YinyangKMeans<MetricType, MatType>::Iterate(const arma::mat& centroids,
+                                                   arma::mat& newCentroids,
+                                                   arma::Col<size_t>& counts)
+{
+  // If this is the first iteration, we must group the centroids and reset all
+  // the bounds.
+  if (centroidGroups.n_elem != centroids.n_cols)
+  {
+    GroupCentroids(centroids);
+
+    lowerBounds.zeros(groupOffsets.n_elem - 1, dataset.n_cols);
+    upperBounds.set_size(dataset.n_cols);
+    upperBounds.fill(DBL_MAX);
+    assignments.zeros(dataset.n_cols);
+  }
+
+  const size_t numGroups = groupOffsets.n_elem - 1;
+
+  const size_t numThreads = parallel::Threads();
+
+  // Each thread filters its own points, with its own scratch space for the
+  // group distances, and sums them into its own copy of the new centroids.
+  std::vector<arma::mat> threadCentroids(numThreads);
+  std::vector<arma::Col<size_t> > threadCounts(numThreads);
+  size_t pointDistances = 0;
+
+  #pragma omp parallel num_threads(numThreads) reduction(+:pointDistances)
+  {
+#ifdef _OPENMP
+    const size_t thread = (size_t) omp_get_thread_num();
+#else
+    const size_t thread = 0;
+#endif
+    arma::mat& sums = threadCentroids[thread];
+    arma::Col<size_t>& threadCount = threadCounts[thread];
+    sums.zeros(centroids.n_rows, centroids.n_cols);
+    threadCount.zeros(centroids.n_cols);
+
+    MetricType threadMetric(metric);
+
+    // The closest and second closest distance in each group that is searched,
+    // and the cluster that gives the closest distance.
+    arma::vec firstDistances(numGroups);
+    arma::vec secondDistances(numGroups);
+    arma::Col<size_t> firstClusters(numGroups);
+    std::vector<char> searched(numGroups);
+
+    #pragma omp for schedule(static, 256)
+    for (size_t i = 0; i < dataset.n_cols; ++i)
+    {
+      const size_t owner = assignments[i];
+
+      // The global filter: if the upper bound is below every group bound, the
+      // assignment cannot change.
+      const double groupBound = (double) arma::min(lowerBounds.col(i));
+      if (upperBounds(i) > groupBound)
+      {
+        // Tighten the upper bound, and try again.
+        upperBounds(i) = threadMetric.Evaluate(dataset.col(i),
+                                               centroids.col(owner));
+        ++pointDistances;
+      }
+
+      if (upperBounds(i) <= groupBound)
+      {
+        sums.col(owner) += arma::vec(dataset.col(i));
+        ++threadCount[owner];
+        continue;
+      }
+
+      // The group filter: only search the groups whose bound is smaller than
+      // the distance to the best cluster found so far.
+      double bestDistance = upperBounds(i);
+      size_t bestCluster = owner;
+      for (size_t g = 0; g < numGroups; ++g)
+      {
+        searched[g] = (lowerBounds(g, i) < bestDistance);
+        if (!searched[g])
+          continue;
+
+        firstDistances[g] = DBL_MAX;
+        secondDistances[g] = DBL_MAX;
+        firstClusters[g] = owner;
+        for (size_t m = groupOffsets[g]; m < groupOffsets[g + 1]; ++m)
+        {
+          const size_t c = groupMembers[m];
+          if (c == owner)
+            continue;
+
+          const double distance = threadMetric.Evaluate(dataset.col(i),
+                                                        centroids.col(c));
+          ++pointDistances;
+          if (distance < firstDistances[g])
+          {
+            secondDistances[g] = firstDistances[g];
+            firstDistances[g] = distance;
+            firstClusters[g] = c;
+          }
+          else if (distance < secondDistances[g])
+          {
+            secondDistances[g] = distance;
+          }
+        }
+
+        if (firstDistances[g] < bestDistance)
+        {
+          bestDistance = firstDistances[g];
+          bestCluster = firstClusters[g];
+        }
+      }
+
+      // Each searched group now has an exact bound, which leaves out the old
+      // cluster of the point.
+      for (size_t g = 0; g < numGroups; ++g)
+        if (searched[g])
+          lowerBounds(g, i) = FloatLowerBound(firstDistances[g]);
+
+      if (bestCluster != owner)
+      {
+        // The group of the new cluster must leave it out instead, and the group
+        // of the old cluster must now include it.
+        const size_t newGroup = centroidGroups[bestCluster];
+        const size_t oldGroup = centroidGroups[owner];
+        lowerBounds(newGroup, i) = FloatLowerBound(secondDistances[newGroup]);
+        lowerBounds(oldGroup, i) = std::min(lowerBounds(oldGroup, i),
+            FloatLowerBound(upperBounds(i)));
+
+        upperBounds(i) = bestDistance;
+        assignments[i] = bestCluster;
+      }
+
+      sums.col(assignments[i]) += arma::vec(dataset.col(i));
+      ++threadCount[assignments[i]];
+    }
+  }
+  distanceCalculations += pointDistances;
+
+  // The centroids and groups are moved with the sums of all threads, merged in
+  // the order of parallel::BlockReduce().
+  newCentroids = std::move(threadCentroids[0]);
+  counts = std::move(threadCounts[0]);
+  for (size_t t = 1; t < numThreads; ++t)
+  {
+    newCentroids += threadCentroids[t];
+    counts += threadCounts[t];
+  }
+
+  // Now, normalize and calculate the distance each cluster and each group has
+  // moved.
+  arma::vec moveDistances(centroids.n_cols);
+  arma::vec groupMoveDistances(numGroups);
+  groupMoveDistances.zeros();
+  double cNorm = 0.0; // Cluster movement for residual.
+  for (size_t c = 0; c < centroids.n_cols; ++c)
+  {
+    if (counts[c] > 0)
+      newCentroids.col(c) /= counts[c];
+    else
+      newCentroids.col(c).fill(DBL_MAX); // Fill with invalid value.
+
+    moveDistances(c) = metric.Evaluate(newCentroids.col(c), centroids.col(c));
+    cNorm += std::pow(moveDistances(c), 2.0);
+    distanceCalculations++;
+
+    groupMoveDistances[centroidGroups[c]] = std::max(
+        groupMoveDistances[centroidGroups[c]], moveDistances(c));
+  }
+
+  // A group bound can shrink by as much as the furthest move of any cluster in
+  // the group, and the upper bound can grow by the move of the point's cluster.
+  #pragma omp parallel for num_threads(numThreads) schedule(static)
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    for (size_t g = 0; g < numGroups; ++g)
+      lowerBounds(g, i) = FloatLowerBound(lowerBounds(g, i) -
+          groupMoveDistances[g]);
+
+    upperBounds(i) += moveDistances(assignments[i]);
+  }
+
+  return std::sqrt(cNorm);
+}
+
+template<typename MetricType, typename MatType>
+void YinyangKMeans<MetricType, MatType>::GroupCentroids(
+    const arma::mat& centroids)
+{
+  // The paper suggests k / 10 groups.
+  const size_t k = centroids.n_cols;
+  const size_t numGroups = std::max((size_t) 1, k / 10);
+
+  // Start from evenly spaced centroids, and run a few Lloyd iterations.
+  arma::mat groupCentroids(centroids.n_rows, numGroups);
+  for (size_t g = 0; g < numGroups; ++g)
+    groupCentroids.col(g) = centroids.col(g * k / numGroups);
+
+  centroidGroups.zeros(k);
+  arma::Col<size_t> groupCounts(numGroups);
+  for (size_t iteration = 0; iteration < 5; ++iteration)
+  {
+    for (size_t c = 0; c < k; ++c)
+    {
+      double minDistance = DBL_MAX;
+      for (size_t g = 0; g < numGroups; ++g)
+      {
+        const double distance = metric.Evaluate(centroids.col(c),
+                                                groupCentroids.col(g));
+        if (distance < minDistance)
+        {
+          minDistance = distance;
+          centroidGroups[c] = g;
+        }
+      }
+    }
+    distanceCalculations += k * numGroups;
+
+    // Move each non-empty group to the mean of its centroids.
+    arma::mat sums(centroids.n_rows, numGroups);
+    sums.zeros();
+    groupCounts.zeros();
+    for (size_t c = 0; c < k; ++c)
+    {
+      sums.col(centroidGroups[c]) += centroids.col(c);
+      ++groupCounts[centroidGroups[c]];
+    }
+
+    for (size_t g = 0; g < numGroups; ++g)
+      if (groupCounts[g] > 0)
+        groupCentroids.col(g) = sums.col(g) / groupCounts[g];
+  }
+
+  // List the centroids of each group in order.
+  groupOffsets.zeros(numGroups + 1);
+  for (size_t c = 0; c < k; ++c)
+    ++groupOffsets[centroidGroups[c] + 1];
+  for (size_t g = 0; g < numGroups; ++g)
+    groupOffsets[g + 1] += groupOffsets[g];
+
+  groupMembers.set_size(k);
+  arma::Col<size_t> position = groupOffsets.subvec(0, numGroups - 1);
+  for (size_t c = 0; c < k; ++c)
+    groupMembers[position[centroidGroups[c]]++] = c;
+
+  Log::Info << "Yinyang k-means: " << numGroups << " groups of centroids.\n";
+}
+
+} // namespace kmeans
+} // namespace mlpack
+
+#endif
@@ -6,20 +6,40 @@
  */
 #include "lars.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 using namespace mlpack;
 using namespace mlpack::regression;
 
+// Compute the Gram matrix X' * X of row-major data.
+static void GramProduct(const arma::mat& dataRef, arma::mat& gram)
+{
+  gram = trans(dataRef) * dataRef;
+}
+
+// The product of sparse data is sparse, but the Gram matrix is stored densely.
+static void GramProduct(const arma::sp_mat& dataRef, arma::mat& gram)
+{
+  const arma::sp_mat sparseGram = trans(dataRef) * dataRef;
+  gram = arma::mat(sparseGram);
+}
+
 LARS::LARS(const bool useCholesky,
            const double lambda1,
            const double lambda2,
            const double tolerance) :
-    matGram(matGramInternal),
+    sharedGram(NULL),
     useCholesky(useCholesky),
     lasso((lambda1 != 0)),
     lambda1(lambda1),
     elasticNet((lambda1 != 0) && (lambda2 != 0)),
     lambda2(lambda2),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    lassocond(false),
+    interpolated(false),
+    lastBreakpointLambda(0.0)
 { /* Nothing left to do. */ }
 
 LARS::LARS(const bool useCholesky,
@@ -27,79 +47,282 @@ LARS::LARS(const bool useCholesky,
            const double lambda1,
            const double lambda2,
            const double tolerance) :
-    matGram(gramMatrix),
+    sharedGram(&gramMatrix),
     useCholesky(useCholesky),
     lasso((lambda1 != 0)),
     lambda1(lambda1),
     elasticNet((lambda1 != 0) && (lambda2 != 0)),
     lambda2(lambda2),
-    tolerance(tolerance)
+    tolerance(tolerance),
+    lassocond(false),
+    interpolated(false),
+    lastBreakpointLambda(0.0)
 { /* Nothing left to do */ }
 
 void LARS::Regress(const arma::mat& matX,
                    const arma::vec& y,
                    arma::vec& beta,
-                   const bool transposeData)
+                   const bool transposeData,
+                   const bool warmStart)
+{
+  RegressImpl(matX, y, beta, transposeData, warmStart);
+}
+
+template<typename MatType>
+void LARS::RegressImpl(const MatType& matX,
+                       const arma::vec& y,
+                       arma::vec& beta,
+                       const bool transposeData,
+                       const bool warmStart)
 {
-  Timer::Start("lars_regression");
+  // The timers are global, so several LARS objects running at once (like in
+  // SparseCoding::OptimizeCode()) can't share one; only time the regression
+  // when it isn't run from inside a parallel region.
+#ifdef _OPENMP
+  const bool timed = !omp_in_parallel();
+#else
+  const bool timed = true;
+#endif
+  if (timed)
+    Timer::Start("lars_regression");
 
   // This matrix may end up holding the transpose -- if necessary.
-  arma::mat dataTrans;
+  MatType dataTrans;
   // dataRef is row-major.
-  const arma::mat& dataRef = (transposeData ? dataTrans : matX);
+  const MatType& dataRef = (transposeData ? dataTrans : matX);
   if (transposeData)
     dataTrans = trans(matX);
 
-  // Compute X' * y.
-  arma::vec vecXTy = trans(dataRef) * y;
+  RunPath(dataRef, y, beta, warmStart, false);
 
-  // Set up active set variables.  In the beginning, the active set has size 0
-  // (all dimensions are inactive).
-  isActive.resize(dataRef.n_cols, false);
+  if (timed)
+    Timer::Stop("lars_regression");
+}
 
-  // Set up ignores set variables. Initialized empty.
-  isIgnored.resize(dataRef.n_cols, false);
+void LARS::RegressPath(const arma::mat& matX,
+                       const arma::vec& y,
+                       const bool transposeData)
+{
+  RegressPathImpl(matX, y, transposeData);
+}
 
-  // Initialize yHat and beta.
-  beta = arma::zeros(dataRef.n_cols);
-  arma::vec yHat = arma::zeros(dataRef.n_rows);
-  arma::vec yHatDirection = arma::vec(dataRef.n_rows);
+template<typename MatType>
+void LARS::RegressPathImpl(const MatType& matX,
+                           const arma::vec& y,
+                           const bool transposeData)
+{
+#ifdef _OPENMP
+  const bool timed = !omp_in_parallel();
+#else
+  const bool timed = true;
+#endif
+  if (timed)
+    Timer::Start("lars_regression");
+
+  MatType dataTrans;
+  const MatType& dataRef = (transposeData ? dataTrans : matX);
+  if (transposeData)
+    dataTrans = trans(matX);
 
-  bool lassocond = false;
+  arma::vec beta;
+  RunPath(dataRef, y, beta, false, true);
 
-  // Compute the initial maximum correlation among all dimensions.
-  arma::vec corr = vecXTy;
-  double maxCorr = 0;
-  size_t changeInd = 0;
-  for (size_t i = 0; i < vecXTy.n_elem; ++i)
+  if (timed)
+    Timer::Stop("lars_regression");
+}
+
+void LARS::Regress(const arma::mat& matX,
+                   const arma::mat& responses,
+                   arma::mat& beta,
+                   const bool transposeData)
+{
+  RegressResponsesImpl(matX, responses, beta, transposeData);
+}
+
+template<typename MatType>
+void LARS::RegressResponsesImpl(const MatType& matX,
+                                const arma::mat& responses,
+                                arma::mat& beta,
+                                const bool transposeData)
+{
+#ifdef _OPENMP
+  const bool timed = !omp_in_parallel();
+#else
+  const bool timed = true;
+#endif
+  if (timed)
+    Timer::Start("lars_regression");
+
+  MatType dataTrans;
+  const MatType& dataRef = (transposeData ? dataTrans : matX);
+  if (transposeData)
+    dataTrans = trans(matX);
+
+  if (responses.n_rows != dataRef.n_rows)
   {
-    if (fabs(corr(i)) > maxCorr)
-    {
-      maxCorr = fabs(corr(i));
-      changeInd = i;
-    }
+    std::ostringstream oss;
+    oss << "LARS::Regress(): number of responses (" << responses.n_rows
+        << ") must be equal to the number of points (" << dataRef.n_rows
+        << ")";
+    throw std::invalid_argument(oss.str());
   }
 
-  betaPath.push_back(beta);
-  lambdaPath.push_back(maxCorr);
-
-  // If the maximum correlation is too small, there is no reason to continue.
-  if (maxCorr < lambda1)
+  // Compute the Gram matrix once, in the same way RunPath() would, so that it
+  // can be shared by all of the responses.
+  if (sharedGram == NULL)
+    ComputeGram(dataRef);
+
+  // Each response is solved independently, with its own LARS object, so the
+  // loop over the responses can be split across threads.  RunPath() does not
+  // use the timers, so it is safe to call here even without OpenMP.
+  beta.set_size(dataRef.n_cols, responses.n_cols);
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < responses.n_cols; ++i)
   {
-    lambdaPath[0] = lambda1;
+    LARS lars(useCholesky, GramMatrix(), lambda1, lambda2, tolerance);
+
+    // This is an alias of beta.col(i), so RunPath() writes straight into it.
+    arma::vec responseBeta = beta.unsafe_col(i);
+    lars.RunPath(dataRef, responses.unsafe_col(i), responseBeta, false, false);
+  }
+
+  if (timed)
     Timer::Stop("lars_regression");
+}
+
+void LARS::PathSolution(const double lambda, arma::vec& beta) const
+{
+  if (betaPath.empty())
+    throw std::invalid_argument("LARS::PathSolution(): no solution path has "
+        "been computed; call Regress() or RegressPath() first");
+
+  // The solution is linear in lambda between consecutive breakpoints.
+  if (lambda >= lambdaPath[0])
+  {
+    beta = betaPath[0];
     return;
   }
 
-  // Compute the Gram matrix.  If this is the elastic net problem, we will add
-  // lambda2 * I_n to the matrix.
-  if (matGram.n_elem == 0)
+  for (size_t i = 1; i < lambdaPath.size(); ++i)
+  {
+    if (lambda >= lambdaPath[i])
+    {
+      const double interp = (lambdaPath[i - 1] - lambda) /
+          (lambdaPath[i - 1] - lambdaPath[i]);
+      beta = (1 - interp) * betaPath[i - 1] + interp * betaPath[i];
+      return;
+    }
+  }
+
+  beta = betaPath.back();
+}
+
+template<typename MatType>
+void LARS::ComputeGram(const MatType& dataRef)
+{
+  // If this is the elastic net problem, we will add lambda2 * I_n to the
+  // matrix.
+  GramProduct(dataRef, matGramInternal);
+
+  if (elasticNet && !useCholesky)
+    matGramInternal += lambda2 * arma::eye(dataRef.n_cols, dataRef.n_cols);
+}
+
+template<typename MatType>
+void LARS::RunPath(const MatType& dataRef,
+                   const arma::vec& y,
+                   arma::vec& beta,
+                   const bool warmStart,
+                   const bool fullPath)
+{
+  const arma::mat& matGram = GramMatrix();
+
+  // Compute X' * y.
+  arma::vec vecXTy = trans(dataRef) * y;
+
+  arma::vec yHat;
+  arma::vec yHatDirection = arma::vec(dataRef.n_rows);
+  arma::vec corr;
+  double maxCorr = 0;
+  size_t changeInd = 0;
+
+  // A warm start continues the path of the last run from its last breakpoint,
+  // keeping the active set and the Cholesky factor.  This is only possible if
+  // the last run has taken at least one step, and if lambda1 has not grown past
+  // the breakpoint before it; otherwise, start from scratch.
+  const size_t pathLength = betaPath.size();
+  if (warmStart && (pathLength >= 2) && (lambda1 < lambdaPath[pathLength - 2]))
   {
-    // In this case, matGram should reference matGramInternal.
-    matGramInternal = trans(dataRef) * dataRef;
+    // Undo the interpolation of the last solution.
+    if (interpolated)
+    {
+      betaPath.back() = lastBreakpointBeta;
+      lambdaPath.back() = lastBreakpointLambda;
+      interpolated = false;
+    }
+
+    // If the new lambda1 is still before the last breakpoint, the solution
+    // only needs to be interpolated again.
+    if (lasso && (lambdaPath.back() <= lambda1))
+    {
+      InterpolateBeta();
+      beta = betaPath.back();
+      return;
+    }
 
-    if (elasticNet && !useCholesky)
-      matGramInternal += lambda2 * arma::eye(dataRef.n_cols, dataRef.n_cols);
+    beta = betaPath.back();
+    yHat = dataRef * beta;
+    corr = vecXTy - trans(dataRef) * yHat;
+    if (elasticNet)
+      corr -= lambda2 * beta;
+
+    maxCorr = lambdaPath.back();
+  }
+  else
+  {
+    // Set up active set variables.  In the beginning, the active set has size
+    // 0 (all dimensions are inactive).
+    activeSet.clear();
+    isActive.assign(dataRef.n_cols, false);
+
+    // Set up ignores set variables. Initialized empty.
+    ignoreSet.clear();
+    isIgnored.assign(dataRef.n_cols, false);
+
+    matUtriCholFactor.reset();
+    betaPath.clear();
+    lambdaPath.clear();
+    lassocond = false;
+    interpolated = false;
+
+    // Initialize yHat and beta.
+    beta = arma::zeros(dataRef.n_cols);
+    yHat = arma::zeros(dataRef.n_rows);
+
+    // Compute the initial maximum correlation among all dimensions.
+    corr = vecXTy;
+    for (size_t i = 0; i < vecXTy.n_elem; ++i)
+    {
+      if (fabs(corr(i)) > maxCorr)
+      {
+        maxCorr = fabs(corr(i));
+        changeInd = i;
+      }
+    }
+
+    betaPath.push_back(beta);
+    lambdaPath.push_back(maxCorr);
+
+    // If the maximum correlation is too small, there is no reason to continue.
+    if (!fullPath && (maxCorr < lambda1))
+    {
+      lambdaPath[0] = lambda1;
+      return;
+    }
+
+    // Compute the Gram matrix, unless it was given to us.
+    if (sharedGram == NULL)
+      ComputeGram(dataRef);
   }
 
   // Main loop.
@@ -225,13 +448,15 @@ void LARS::Regress(const arma::mat& matX,
     // If not all variables are active.
     if ((activeSet.size() + ignoreSet.size()) < dataRef.n_cols)
     {
-      // Compute correlations with direction.
+      // Compute correlations with direction, all at once (this is one sparse
+      // product if the data is sparse).
+      const arma::vec dirCorrs = trans(dataRef) * yHatDirection;
       for (size_t ind = 0; ind < dataRef.n_cols; ind++)
       {
         if (isActive[ind] || isIgnored[ind])
           continue;
 
-        double dirCorr = dot(dataRef.col(ind), yHatDirection);
+        const double dirCorr = dirCorrs[ind];
         double val1 = (maxCorr - corr(ind)) / (normalization - dirCorr);
         double val2 = (maxCorr + corr(ind)) / (normalization + dirCorr);
         if ((val1 > 0) && (val1 < gamma))
@@ -242,7 +467,7 @@ void LARS::Regress(const arma::mat& matX,
     }
 
     // Bound gamma according to LASSO.
-    if (lasso)
+    if (lasso || fullPath)
     {
       lassocond = false;
       double lassoboundOnGamma = DBL_MAX;
@@ -305,8 +530,9 @@ void LARS::Regress(const arma::mat& matX,
 
     lambdaPath.push_back(curLambda);
 
-    // Time to stop for LASSO?
-    if (lasso)
+    // Time to stop for LASSO?  The full path runs until no dimensions are
+    // left.
+    if (lasso && !fullPath)
     {
       if (curLambda <= lambda1)
       {
@@ -318,13 +544,19 @@ void LARS::Regress(const arma::mat& matX,
 
   // Unfortunate copy...
   beta = betaPath.back();
-
-  Timer::Stop("lars_regression");
 }
 
 void LARS::Predict(const arma::mat& points,
                    arma::vec& predictions,
                    const bool rowMajor) const
+{
+  PredictImpl(points, predictions, rowMajor);
+}
+
+template<typename MatType>
+void LARS::PredictImpl(const MatType& points,
+                       arma::vec& predictions,
+                       const bool rowMajor) const
 {
   // We really only need to store beta internally...
   if (rowMajor)
@@ -361,6 +593,19 @@ void LARS::ComputeYHatDirection(const arma::mat& matX,
     yHatDirection += betaDirection(i) * matX.col(activeSet[i]);
 }
 
+void LARS::ComputeYHatDirection(const arma::sp_mat& matX,
+                                const arma::vec& betaDirection,
+                                arma::vec& yHatDirection)
+{
+  // Multiply by the direction over all dimensions, which only touches the
+  // nonzero elements of the active dimensions.
+  arma::vec fullDirection = arma::zeros<arma::vec>(matX.n_cols);
+  for (size_t i = 0; i < activeSet.size(); i++)
+    fullDirection[activeSet[i]] = betaDirection(i);
+
+  yHatDirection = matX * fullDirection;
+}
+
 void LARS::InterpolateBeta()
 {
   int pathLength = betaPath.size();
@@ -371,6 +616,11 @@ void LARS::InterpolateBeta()
   double interp = (penultimateLambda - lambda1)
       / (penultimateLambda - ultimateLambda);
 
+  // Keep the breakpoint, so that a warm start can continue from it.
+  lastBreakpointBeta = betaPath[pathLength - 1];
+  lastBreakpointLambda = ultimateLambda;
+  interpolated = true;
+
   betaPath[pathLength - 1] = (1 - interp) * (betaPath[pathLength - 2])
       + interp * betaPath[pathLength - 1];
 
@@ -493,9 +743,29 @@ std::string LARS::ToString() const
 {
   std::ostringstream convert;
   convert << "LARS [" << this << "]" << std::endl;
-  convert << "  Gram Matrix: " << matGram.n_rows << "x" << matGram.n_cols;
+  convert << "  Gram Matrix: " << GramMatrix().n_rows << "x"
+      << GramMatrix().n_cols;
   convert << std::endl;
   convert << "  Tolerance: " << tolerance << std::endl;
   return convert.str();
 }
 
+
+// The sparse overloads of Regress(), RegressPath() and Predict() are templates
+// (see lars_impl.hpp), so the implementations they call for sparse data are
+// instantiated here.
+template void LARS::RegressImpl(const arma::sp_mat& matX,
+                                const arma::vec& y,
+                                arma::vec& beta,
+                                const bool transposeData,
+                                const bool warmStart);
+template void LARS::RegressResponsesImpl(const arma::sp_mat& matX,
+                                         const arma::mat& responses,
+                                         arma::mat& beta,
+                                         const bool transposeData);
+template void LARS::RegressPathImpl(const arma::sp_mat& matX,
+                                    const arma::vec& y,
+                                    const bool transposeData);
+template void LARS::PredictImpl(const arma::sp_mat& points,
+                                arma::vec& predictions,
+                                const bool rowMajor) const;
@@ -103,6 +103,11 @@ class LARS
    * Set the parameters to LARS, and pass in a precalculated Gram matrix.  Both
    * lambda1 and lambda2 default to 0.
    *
+   * The Gram matrix is not copied: this object (and any copy of it) only
+   * refers to it, so one Gram matrix can be shared by many LARS objects, but it
+   * must not be modified or destroyed while they are in use.  For the elastic
+   * net without Cholesky decomposition, it should already include lambda2 * I.
+   *
    * @param useCholesky Whether or not to use Cholesky decomposition when
    *    solving linear system (as opposed to using the full Gram matrix).
    * @param gramMatrix Gram matrix.
@@ -130,12 +135,132 @@ class LARS
    * @param responses A vector of targets.
    * @param beta Vector to store the solution (the coefficients) in.
    * @param transposeData Set to false if the data is row-major.
+   * @param warmStart If true, continue the solution path of the last call to
+   *     Regress() instead of starting from scratch (see below).
+   *
+   * Different LARS objects may run Regress() at the same time (for instance
+   * from an OpenMP parallel region), as long as they don't share the beta
+   * vector; the "lars_regression" timer is only used outside of parallel
+   * regions.
+   *
+   * To solve the LASSO for a decreasing sequence of values of lambda1 on the
+   * same data and responses, set Lambda1() to each value in turn and call
+   * Regress() with warmStart = true.  Each call then continues the path from
+   * the last breakpoint of the previous call, keeping its active set and
+   * Cholesky factor, instead of running the whole path again.  If there is no
+   * path to continue (or lambda1 is larger than before), a warm start is the
+   * same as a cold start.
    */
   void Regress(const arma::mat& data,
                const arma::vec& responses,
                arma::vec& beta,
+               const bool transposeData = true,
+               const bool warmStart = false);
+
+  /**
+   * Run LARS on sparse data; see the dense version of Regress() above.  The
+   * correlations are computed with sparse products, so each step of the path
+   * takes time proportional to the number of nonzero elements.  The Gram matrix
+   * (if it was not given to the constructor) is computed as a sparse product
+   * and then stored as a dense matrix.
+   *
+   * This is a template over sparse Armadillo types only, so that dense
+   * expressions (such as X.t()) are not ambiguous and use the dense version.
+   *
+   * @param data Column-major sparse input data (or row-major input data if
+   *     transposeData = false).
+   * @param responses A vector of targets.
+   * @param beta Vector to store the solution (the coefficients) in.
+   * @param transposeData Set to false if the data is row-major.
+   * @param warmStart If true, continue the solution path of the last call to
+   *     Regress().
+   */
+  template<typename T1>
+  void Regress(const arma::SpBase<double, T1>& data,
+               const arma::vec& responses,
+               arma::vec& beta,
+               const bool transposeData = true,
+               const bool warmStart = false);
+
+  /**
+   * Run LARS for several response vectors at once, on the same data.  The
+   * Gram matrix is computed once and shared, and if mlpack is compiled with
+   * OpenMP, the responses are solved in parallel.  The solution paths of the
+   * individual responses are not kept, so BetaPath() and LambdaPath() are not
+   * changed by this method.
+   *
+   * @param data Column-major input data (or row-major input data if
+   *     transposeData = false).
+   * @param responses Matrix of targets, with one column for each response
+   *     vector (so each column has one element for each point).
+   * @param beta Matrix to store the solutions in; column i holds the
+   *     coefficients for column i of responses.
+   * @param transposeData Set to false if the data is row-major.
+   */
+  void Regress(const arma::mat& data,
+               const arma::mat& responses,
+               arma::mat& beta,
                const bool transposeData = true);
 
+  /**
+   * Run LARS for several response vectors at once, on the same sparse data;
+   * see the dense version of this method above.
+   *
+   * @param data Column-major sparse input data (or row-major input data if
+   *     transposeData = false).
+   * @param responses Matrix of targets, with one column for each response
+   *     vector.
+   * @param beta Matrix to store the solutions in.
+   * @param transposeData Set to false if the data is row-major.
+   */
+  template<typename T1>
+  void Regress(const arma::SpBase<double, T1>& data,
+               const arma::mat& responses,
+               arma::mat& beta,
+               const bool transposeData = true);
+
+  /**
+   * Compute the whole LASSO solution path, down to lambda1 = 0 (or until no
+   * dimensions are left), regardless of the value of lambda1.  Every
+   * breakpoint of the path is stored in BetaPath() and LambdaPath(), and the
+   * solution for any value of lambda1 can then be found with PathSolution(),
+   * so a single run is enough to sweep over many values of lambda1.
+   *
+   * @param data Column-major input data (or row-major input data if
+   *     transposeData = false).
+   * @param responses A vector of targets.
+   * @param transposeData Set to false if the data is row-major.
+   */
+  void RegressPath(const arma::mat& data,
+                   const arma::vec& responses,
+                   const bool transposeData = true);
+
+  /**
+   * Compute the whole LASSO solution path on sparse data; see the dense version
+   * of RegressPath() above.
+   *
+   * @param data Column-major sparse input data (or row-major input data if
+   *     transposeData = false).
+   * @param responses A vector of targets.
+   * @param transposeData Set to false if the data is row-major.
+   */
+  template<typename T1>
+  void RegressPath(const arma::SpBase<double, T1>& data,
+                   const arma::vec& responses,
+                   const bool transposeData = true);
+
+  /**
+   * Compute the solution for the given value of lambda1 from the stored
+   * solution path, by interpolating between the breakpoints around it.  The
+   * result is only exact for values of lambda1 that the path covers: after
+   * RegressPath(), that is any value; after Regress(), any value at least as
+   * large as Lambda1().
+   *
+   * @param lambda Value of lambda1 to compute the solution for.
+   * @param beta Vector to store the solution in.
+   */
+  void PathSolution(const double lambda, arma::vec& beta) const;
+
   /**
    * Predict y_i for each data point in the given data matrix, using the
    * currently-trained LARS model (so make sure you run Regress() first).  If
@@ -149,6 +274,19 @@ class LARS
                arma::vec& predictions,
                const bool rowMajor = false) const;
 
+  /**
+   * Predict y_i for each point in the given sparse data matrix; see the dense
+   * version of Predict() above.
+   *
+   * @param points The sparse data points to regress on.
+   * @param predictions y, which will contained calculated values on completion.
+   * @param rowMajor Set to true if the data is row-major.
+   */
+  template<typename T1>
+  void Predict(const arma::SpBase<double, T1>& points,
+               arma::vec& predictions,
+               const bool rowMajor = false) const;
+
   //! Access the set of active dimensions.
   const std::vector<size_t>& ActiveSet() const { return activeSet; }
 
@@ -160,6 +298,18 @@ class LARS
   //! the last element.
   const std::vector<double>& LambdaPath() const { return lambdaPath; }
 
+  //! Get the regularization parameter for the l1-norm penalty.
+  double Lambda1() const { return lambda1; }
+  //! Modify the regularization parameter for the l1-norm penalty (whether
+  //! or not the problem is the LASSO is still decided by the constructor).
+  double& Lambda1() { return lambda1; }
+
+  //! Get the Gram matrix: the one given to the constructor, or else the one
+  //! computed by the last call to Regress() or RegressPath() (which may be
+  //! given to other LARS objects on the same data).
+  const arma::mat& GramMatrix() const
+  { return (sharedGram == NULL) ? matGramInternal : *sharedGram; }
+
   //! Access the upper triangular cholesky factor.
   const arma::mat& MatUtriCholFactor() const { return matUtriCholFactor; }
 
@@ -167,11 +317,12 @@ class LARS
   std::string ToString() const;
 
  private:
-  //! Gram matrix.
+  //! Gram matrix, if it is computed by this object.
   arma::mat matGramInternal;
 
-  //! Reference to the Gram matrix we will use.
-  const arma::mat& matGram;
+  //! The Gram matrix given to the constructor (NULL if there is none), which
+  //! is shared, not copied.
+  const arma::mat* sharedGram;
 
   //! Upper triangular cholesky factor; initially 0x0 matrix.
   arma::mat matUtriCholFactor;
@@ -212,6 +363,66 @@ class LARS
   //! Membership indicator for set of ignored variables.
   std::vector<bool> isIgnored;
 
+  //! True if the last step of the path removed a variable from the active set.
+  bool lassocond;
+
+  //! True if the last element of the solution path was interpolated.
+  bool interpolated;
+  //! The last breakpoint of the path, before it was interpolated.
+  arma::vec lastBreakpointBeta;
+  //! The value of lambda_1 at the last breakpoint, before interpolation.
+  double lastBreakpointLambda;
+
+  //! The implementation of Regress() for one response vector, for dense or
+  //! sparse data.
+  template<typename MatType>
+  void RegressImpl(const MatType& data,
+                   const arma::vec& responses,
+                   arma::vec& beta,
+                   const bool transposeData,
+                   const bool warmStart);
+
+  //! The implementation of Regress() for several response vectors.
+  template<typename MatType>
+  void RegressResponsesImpl(const MatType& data,
+                            const arma::mat& responses,
+                            arma::mat& beta,
+                            const bool transposeData);
+
+  //! The implementation of RegressPath().
+  template<typename MatType>
+  void RegressPathImpl(const MatType& data,
+                       const arma::vec& responses,
+                       const bool transposeData);
+
+  //! The implementation of Predict().
+  template<typename MatType>
+  void PredictImpl(const MatType& points,
+                   arma::vec& predictions,
+                   const bool rowMajor) const;
+
+  //! Compute the Gram matrix of the given row-major data into matGramInternal
+  //! (with lambda2 * I added for the elastic net without Cholesky).
+  template<typename MatType>
+  void ComputeGram(const MatType& dataRef);
+
+  /**
+   * Run LARS on row-major data; this is the shared implementation of
+   * Regress() and RegressPath(), and it does not use the timers.
+   *
+   * @param dataRef Row-major input data (dense or sparse).
+   * @param y Vector of targets.
+   * @param beta Vector to store the solution in.
+   * @param warmStart If true, continue the last solution path.
+   * @param fullPath If true, compute the whole LASSO solution path.
+   */
+  template<typename MatType>
+  void RunPath(const MatType& dataRef,
+               const arma::vec& y,
+               arma::vec& beta,
+               const bool warmStart,
+               const bool fullPath);
+
   /**
    * Remove activeVarInd'th element from active set.
    *
@@ -238,6 +449,11 @@ class LARS
                             const arma::vec& betaDirection,
                             arma::vec& yHatDirection);
 
+  // compute "equiangular" direction in output space, for sparse data
+  void ComputeYHatDirection(const arma::sp_mat& matX,
+                            const arma::vec& betaDirection,
+                            arma::vec& yHatDirection);
+
   // interpolate to compute last solution vector
   void InterpolateBeta();
 
@@ -255,4 +471,7 @@ class LARS
 }; // namespace regression
 }; // namespace mlpack
 
+// Include implementation.
+#include "lars_impl.hpp"
+
 #endif
@@ -0,0 +1,59 @@
+/**
+ * @file lars_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the overloads of LARS for sparse data.
+ */
+#ifndef __MLPACK_METHODS_LARS_LARS_IMPL_HPP
+#define __MLPACK_METHODS_LARS_LARS_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "lars.hpp"
+
+namespace mlpack {
+namespace regression {
+
+template<typename T1>
+void LARS::Regress(const arma::SpBase<double, T1>& data,
+                   const arma::vec& responses,
+                   arma::vec& beta,
+                   const bool transposeData,
+                   const bool warmStart)
+{
+  // A sparse matrix is used directly; an expression is evaluated first.
+  const arma::unwrap_spmat<T1> unwrapped(data.get_ref());
+  RegressImpl(unwrapped.M, responses, beta, transposeData, warmStart);
+}
+
+template<typename T1>
+void LARS::Regress(const arma::SpBase<double, T1>& data,
+                   const arma::mat& responses,
+                   arma::mat& beta,
+                   const bool transposeData)
+{
+  const arma::unwrap_spmat<T1> unwrapped(data.get_ref());
+  RegressResponsesImpl(unwrapped.M, responses, beta, transposeData);
+}
+
+template<typename T1>
+void LARS::RegressPath(const arma::SpBase<double, T1>& data,
+                       const arma::vec& responses,
+                       const bool transposeData)
+{
+  const arma::unwrap_spmat<T1> unwrapped(data.get_ref());
+  RegressPathImpl(unwrapped.M, responses, transposeData);
+}
+
+template<typename T1>
+void LARS::Predict(const arma::SpBase<double, T1>& points,
+                   arma::vec& predictions,
+                   const bool rowMajor) const
+{
+  const arma::unwrap_spmat<T1> unwrapped(points.get_ref());
+  PredictImpl(unwrapped.M, predictions, rowMajor);
+}
+
+}; // namespace regression
+}; // namespace mlpack
+
+#endif
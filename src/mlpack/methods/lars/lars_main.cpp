@@ -106,7 +106,8 @@ int main(int argc, char* argv[])
     data::Load(testFile, testPoints, true, false);
 
     arma::vec predictions;
-    lars.Predict(testPoints.t(), predictions, false);
+    // The test points were loaded without transposing, so they are row-major.
+    lars.Predict(testPoints, predictions, true);
 
     // Save test predictions.  One per line, so, we need a rowvec.
     arma::rowvec predToSave = predictions.t();
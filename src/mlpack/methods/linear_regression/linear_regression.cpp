@@ -93,6 +93,12 @@ void LinearRegression::Train(const arma::mat& predictors,
   }
 }
 
+void LinearRegression::Train(const NormalEquations& equations)
+{
+  intercept = equations.Intercept();
+  equations.Solve(lambda, parameters);
+}
+
 void LinearRegression::Predict(const arma::mat& points, arma::vec& predictions)
     const
 {
@@ -9,6 +9,7 @@
 #define __MLPACK_METHODS_LINEAR_REGRESSION_LINEAR_REGRESSION_HPP
 
 #include <mlpack/core.hpp>
+#include "normal_equations.hpp"
 
 namespace mlpack {
 namespace regression /** Regression methods. */ {
@@ -67,6 +68,17 @@ class LinearRegression
              const bool intercept = true,
              const arma::vec& weights = arma::vec());
 
+  /**
+   * Train the LinearRegression model from normal equations accumulated over
+   * chunks of data, so that the whole dataset never has to be in memory.  The
+   * intercept setting is taken from the accumulator, and the regularization
+   * parameter from Lambda().  Careful!  This will completely ignore and
+   * overwrite the existing model.
+   *
+   * @param equations Normal equations accumulated over the training data.
+   */
+  void Train(const NormalEquations& equations);
+
   /**
    * Calculate y_i for each data point in points.
    *
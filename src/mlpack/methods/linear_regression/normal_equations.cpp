@@ -0,0 +1,158 @@
+/**
+ * @file normal_equations.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the NormalEquations accumulator.
+ */
+#include "normal_equations.hpp"
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
+using namespace mlpack;
+using namespace mlpack::regression;
+
+NormalEquations::NormalEquations(const size_t dimensionality,
+                                 const bool intercept) :
+    dimensionality(dimensionality),
+    intercept(intercept),
+    numPoints(0)
+{
+  const size_t size = dimensionality + (intercept ? 1 : 0);
+  xtx.zeros(size, size);
+  xty.zeros(size);
+}
+
+void NormalEquations::Add(const arma::mat& predictors,
+                          const arma::vec& responses,
+                          const arma::vec& weights)
+{
+  if (predictors.n_rows != dimensionality)
+  {
+    std::ostringstream oss;
+    oss << "NormalEquations::Add(): dimensionality of predictors ("
+        << predictors.n_rows << ") must be equal to the dimensionality of the "
+        << "accumulator (" << dimensionality << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (responses.n_elem != predictors.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "NormalEquations::Add(): number of responses (" << responses.n_elem
+        << ") must be equal to the number of points (" << predictors.n_cols
+        << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (weights.n_elem > 0 && weights.n_elem != predictors.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "NormalEquations::Add(): number of weights (" << weights.n_elem
+        << ") must be equal to the number of points (" << predictors.n_cols
+        << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // The chunk is split into blocks of points; each block is small enough that
+  // its copy (with the row of ones for the intercept) is cheap.
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (predictors.n_cols + blockSize - 1) / blockSize;
+
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+
+  // Each thread sums its blocks into its own buffers.  The buffers are
+  // allocated here, in case fewer threads than requested run.
+  std::vector<arma::mat> threadXTX(numThreads);
+  std::vector<arma::vec> threadXTy(numThreads);
+  for (size_t t = 0; t < numThreads; ++t)
+  {
+    threadXTX[t].zeros(xtx.n_rows, xtx.n_cols);
+    threadXTy[t].zeros(xty.n_elem);
+  }
+
+  #pragma omp parallel num_threads(numThreads)
+  {
+#ifdef _OPENMP
+    const size_t thread = (size_t) omp_get_thread_num();
+#else
+    const size_t thread = 0;
+#endif
+
+    #pragma omp for schedule(static)
+    for (size_t block = 0; block < numBlocks; ++block)
+    {
+      const size_t begin = block * blockSize;
+      const size_t end = std::min(begin + blockSize,
+          (size_t) predictors.n_cols);
+
+      // The intercept is the first dimension, like in
+      // LinearRegression::Train().
+      arma::mat p = predictors.cols(begin, end - 1);
+      if (intercept)
+        p.insert_rows(0, arma::ones<arma::mat>(1, p.n_cols));
+
+      const arma::vec r = responses.subvec(begin, end - 1);
+      if (weights.n_elem > 0)
+      {
+        const arma::mat pw = p * arma::diagmat(weights.subvec(begin, end - 1));
+        threadXTX[thread] += pw * arma::trans(p);
+        threadXTy[thread] += pw * r;
+      }
+      else
+      {
+        threadXTX[thread] += p * arma::trans(p);
+        threadXTy[thread] += p * r;
+      }
+    }
+  }
+
+  // Add up the buffers of each thread, in order.
+  for (size_t t = 0; t < numThreads; ++t)
+  {
+    xtx += threadXTX[t];
+    xty += threadXTy[t];
+  }
+
+  numPoints += predictors.n_cols;
+}
+
+void NormalEquations::Merge(const NormalEquations& other)
+{
+  if (other.dimensionality != dimensionality)
+  {
+    std::ostringstream oss;
+    oss << "NormalEquations::Merge(): dimensionality of other accumulator ("
+        << other.dimensionality << ") must be equal to the dimensionality of "
+        << "this accumulator (" << dimensionality << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (other.intercept != intercept)
+    throw std::invalid_argument("NormalEquations::Merge(): both accumulators "
+        "must use an intercept, or neither");
+
+  xtx += other.xtx;
+  xty += other.xty;
+  numPoints += other.numPoints;
+}
+
+void NormalEquations::Solve(const double lambda, arma::vec& parameters) const
+{
+  if (numPoints == 0)
+    throw std::invalid_argument("NormalEquations::Solve(): no points have been "
+        "added");
+
+  // Add the ridge penalty to the diagonal; the intercept is not penalized.
+  arma::mat a = xtx;
+  if (lambda != 0.0)
+    for (size_t i = (intercept ? 1 : 0); i < a.n_rows; ++i)
+      a(i, i) += lambda;
+
+  arma::solve(parameters, a, xty);
+}
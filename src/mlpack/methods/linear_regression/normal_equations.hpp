@@ -0,0 +1,137 @@
+/**
+ * @file normal_equations.hpp
+ * @author Ryan Curtin
+ *
+ * An accumulator for the normal equations of linear regression, which can be
+ * filled one chunk of data at a time so that the whole dataset never has to be
+ * in memory.
+ */
+#ifndef __MLPACK_METHODS_LINEAR_REGRESSION_NORMAL_EQUATIONS_HPP
+#define __MLPACK_METHODS_LINEAR_REGRESSION_NORMAL_EQUATIONS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace regression {
+
+/**
+ * NormalEquations accumulates X^T X and X^T y (where X holds one point in each
+ * row, plus a column of ones if an intercept is used) over chunks of data.
+ * Once every chunk has been added, the ridge regression problem is the small
+ * d x d linear system
+ *
+ * \f[
+ * (X^T X + \lambda I') B = X^T y
+ * \f]
+ *
+ * where I' is the identity matrix, except that the intercept is not penalized.
+ * This is what LinearRegression::Train(const NormalEquations&) solves.
+ *
+ * The chunks may come from anywhere (for instance, from files loaded one at a
+ * time with data::Load()); if mlpack is compiled with OpenMP, each chunk is
+ * split across threads.  Accumulators filled on different machines (or by
+ * different threads) can be combined with Merge(), and they can be serialized
+ * to be sent between machines.
+ *
+ * @code
+ * NormalEquations equations(dimensionality);
+ * for (size_t i = 0; i < chunkFiles.size(); ++i)
+ * {
+ *   arma::mat chunk;
+ *   arma::vec chunkResponses;
+ *   // Load the chunk and its responses...
+ *   equations.Add(chunk, chunkResponses);
+ * }
+ *
+ * LinearRegression lr;
+ * lr.Lambda() = lambda;
+ * lr.Train(equations);
+ * @endcode
+ *
+ * Solving the normal equations squares the condition number of the problem, so
+ * for badly conditioned data the QR decomposition used by
+ * LinearRegression::Train(const arma::mat&, ...) is more accurate.
+ */
+class NormalEquations
+{
+ public:
+  /**
+   * Create an empty accumulator for data with the given dimensionality.
+   *
+   * @param dimensionality Number of dimensions of each point.
+   * @param intercept Whether or not to include an intercept term.
+   */
+  NormalEquations(const size_t dimensionality = 0,
+                  const bool intercept = true);
+
+  /**
+   * Add a chunk of points to the normal equations.
+   *
+   * @param predictors Points in the chunk (one point in each column).
+   * @param responses Response for each point in the chunk.
+   * @param weights Observation weights for each point in the chunk (optional).
+   */
+  void Add(const arma::mat& predictors,
+           const arma::vec& responses,
+           const arma::vec& weights = arma::vec());
+
+  /**
+   * Add the points of another accumulator to this one.  Both accumulators must
+   * have the same dimensionality and the same setting for the intercept.
+   *
+   * @param other Accumulator to merge into this one.
+   */
+  void Merge(const NormalEquations& other);
+
+  /**
+   * Solve the normal equations for the parameters of the linear regression
+   * model, with the given ridge regularization parameter.  If an intercept is
+   * used, it is the first parameter, and it is not penalized.
+   *
+   * @param lambda Tikhonov regularization parameter for ridge regression.
+   * @param parameters Vector to store the parameters in.
+   */
+  void Solve(const double lambda, arma::vec& parameters) const;
+
+  //! Get the number of dimensions of each point.
+  size_t Dimensionality() const { return dimensionality; }
+  //! Get whether or not an intercept term is used.
+  bool Intercept() const { return intercept; }
+  //! Get the number of points added so far.
+  size_t NumPoints() const { return numPoints; }
+
+  //! Get the accumulated X^T X.
+  const arma::mat& XTX() const { return xtx; }
+  //! Get the accumulated X^T y.
+  const arma::vec& XTy() const { return xty; }
+
+  /**
+   * Serialize the accumulator.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    ar & data::CreateNVP(dimensionality, "dimensionality");
+    ar & data::CreateNVP(intercept, "intercept");
+    ar & data::CreateNVP(numPoints, "numPoints");
+    ar & data::CreateNVP(xtx, "xtx");
+    ar & data::CreateNVP(xty, "xty");
+  }
+
+ private:
+  //! The number of dimensions of each point.
+  size_t dimensionality;
+  //! Whether or not an intercept term is used.
+  bool intercept;
+  //! The number of points added so far.
+  size_t numPoints;
+  //! The accumulated X^T X (including the intercept, if used).
+  arma::mat xtx;
+  //! The accumulated X^T y (including the intercept, if used).
+  arma::vec xty;
+};
+
+} // namespace regression
+} // namespace mlpack
+
+#endif
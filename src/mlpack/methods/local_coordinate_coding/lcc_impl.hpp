@@ -97,34 +97,45 @@ void LocalCoordinateCoding<DictionaryInitializer>::Encode(
 template<typename DictionaryInitializer>
 void LocalCoordinateCoding<DictionaryInitializer>::OptimizeCode()
 {
-  arma::mat invSqDists = 1.0 / (repmat(trans(sum(square(dictionary))), 1,
-      data.n_cols) + repmat(sum(square(data)), atoms, 1) - 2 * trans(dictionary)
-      * data);
+  // The inverse squared distances from each point to each atom are computed
+  // one point at a time, so no atoms x points matrix is needed.
+  const arma::vec dictNorms = trans(sum(square(dictionary)));
 
   arma::mat dictGram = trans(dictionary) * dictionary;
-  arma::mat dictGramTD(dictGram.n_rows, dictGram.n_cols);
 
-  for (size_t i = 0; i < data.n_cols; i++)
+  Log::Debug << "Coding " << data.n_cols << " points." << std::endl;
+
+  // Each point is coded independently, so the loop over the points can be
+  // split across threads.  Each thread reuses its own weighted dictionary and
+  // weighted Gram matrix for all of its points.
+  #pragma omp parallel
   {
-    // report progress
-    if ((i % 100) == 0)
-    {
-      Log::Debug << "Optimization at point " << i << "." << std::endl;
-    }
+    arma::mat dictPrime(dictionary.n_rows, dictionary.n_cols);
+    arma::mat dictGramTD(dictGram.n_rows, dictGram.n_cols);
 
-    arma::vec invW = invSqDists.unsafe_col(i);
-    arma::mat dictPrime = dictionary * diagmat(invW);
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < data.n_cols; i++)
+    {
+      const arma::vec invW = 1.0 / (dictNorms + arma::dot(data.unsafe_col(i),
+          data.unsafe_col(i)) - 2 * trans(dictionary) * data.unsafe_col(i));
 
-    arma::mat dictGramTD = diagmat(invW) * dictGram * diagmat(invW);
+      // dictPrime = dictionary * diagmat(invW), and
+      // dictGramTD = diagmat(invW) * dictGram * diagmat(invW).
+      for (size_t j = 0; j < dictionary.n_cols; j++)
+      {
+        dictPrime.col(j) = invW[j] * dictionary.col(j);
+        dictGramTD.col(j) = invW[j] * (dictGram.col(j) % invW);
+      }
 
-    bool useCholesky = false;
-    regression::LARS lars(useCholesky, dictGramTD, 0.5 * lambda);
+      bool useCholesky = false;
+      regression::LARS lars(useCholesky, dictGramTD, 0.5 * lambda);
 
-    // Run LARS for this point, by making an alias of the point and passing
-    // that.
-    arma::vec beta = codes.unsafe_col(i);
-    lars.Regress(dictPrime, data.unsafe_col(i), beta, false);
-    beta %= invW; // Remember, beta is an alias of codes.col(i).
+      // Run LARS for this point, by making an alias of the point and passing
+      // that.
+      arma::vec beta = codes.unsafe_col(i);
+      lars.Regress(dictPrime, data.unsafe_col(i), beta, false);
+      beta %= invW; // Remember, beta is an alias of codes.col(i).
+    }
   }
 }
 
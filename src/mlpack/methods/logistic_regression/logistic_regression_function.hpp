@@ -18,6 +18,13 @@ namespace regression {
  * The log-likelihood function for the logistic regression objective function.
  * This is used by various mlpack optimizers to train a logistic regression
  * model.
+ *
+ * The predictors can be dense (arma::mat) or sparse (arma::sp_mat).  With a
+ * sparse matrix, the products over the whole dataset are taken without
+ * transposing it, and the separable Evaluate() and Gradient() only visit the
+ * nonzero features of the point, so each SGD step costs time proportional to
+ * the number of nonzero features (plus the dimensionality, if lambda is
+ * nonzero).
  */
 template<typename MatType = arma::mat>
 class LogisticRegressionFunction
@@ -76,6 +83,20 @@ class LogisticRegressionFunction
    */
   double Evaluate(const arma::mat& parameters, const size_t i) const;
 
+  /**
+   * Evaluate the logistic regression log-likelihood function with the given
+   * parameters, using only the batchSize points starting at begin.  This is
+   * the sum of Evaluate(parameters, i) over those points, and is used by
+   * optimizers such as MiniBatchSGD.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the first point of the batch.
+   * @param batchSize Number of points in the batch.
+   */
+  double Evaluate(const arma::mat& parameters,
+                  const size_t begin,
+                  const size_t batchSize) const;
+
   /**
    * Evaluate the gradient of the logistic regression log-likelihood function
    * with the given parameters.
@@ -99,6 +120,82 @@ class LogisticRegressionFunction
                 const size_t i,
                 arma::mat& gradient) const;
 
+  /**
+   * Evaluate the gradient of the logistic regression log-likelihood function
+   * with the given parameters, with respect to only one point in the dataset,
+   * as a sparse vector.  This is used by optimizers such as ParallelSGD, which
+   * update only the nonzero coordinates of each gradient.
+   *
+   * The gradient is nonzero only for the intercept and the nonzero features of
+   * the point (all features, for a dense predictors matrix).  So that the
+   * regularization stays sparse too, the regularization of feature j is split
+   * evenly between the points in which feature j is nonzero; over a full pass,
+   * the sum of these gradients is the same as the full gradient.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param i Index of point to use for objective function gradient evaluation.
+   * @param gradient Sparse vector to output gradient into.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t i,
+                arma::sp_mat& gradient) const;
+
+  /**
+   * Evaluate the gradient of the logistic regression log-likelihood function
+   * with the given parameters, with respect to only the batchSize points
+   * starting at begin.  This is the sum of Gradient(parameters, i, gradient)
+   * over those points, and is used by optimizers such as MiniBatchSGD.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param begin Index of the first point of the batch.
+   * @param batchSize Number of points in the batch.
+   * @param gradient Vector to output gradient into.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                const size_t batchSize,
+                arma::mat& gradient) const;
+
+  /**
+   * Evaluate the logistic regression log-likelihood function and its gradient
+   * with the given parameters at once, so that the sigmoids of the points are
+   * only computed once.  This is used by optimizers such as L_BFGS.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param gradient Vector to output gradient into.
+   * @return Objective at the given parameters.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
+  /**
+   * Evaluate the logistic regression log-likelihood function and its gradient
+   * with the given parameters at once, using only one data point.  This is
+   * used by optimizers such as SGD.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param i Index of point to use for the evaluation.
+   * @param gradient Vector to output gradient into.
+   * @return Objective of the point at the given parameters.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              const size_t i,
+                              arma::mat& gradient) const;
+
+  /**
+   * Compute the product of the Hessian of the logistic regression objective
+   * function at the given parameters and the given direction, without forming
+   * the Hessian; this costs two passes over the data, like Gradient().  This is
+   * used by optimizers such as TRON.
+   *
+   * @param parameters Vector of logistic regression parameters.
+   * @param v Direction to multiply the Hessian by.
+   * @param hv Vector to output the product into.
+   */
+  void HessianVectorProduct(const arma::mat& parameters,
+                            const arma::mat& v,
+                            arma::mat& hv) const;
+
   //! Return the initial point for the optimization.
   const arma::mat& GetInitialPoint() const { return initialPoint; }
 
@@ -106,6 +203,62 @@ class LogisticRegressionFunction
   size_t NumFunctions() const { return predictors.n_cols; }
 
  private:
+  //! Compute the dot product of point i of a dense dataset with the weights.
+  template<typename eT>
+  static double PointDot(const arma::Mat<eT>& predictors,
+                         const size_t i,
+                         const double* weights);
+
+  //! Compute the dot product of point i of a sparse dataset with the weights,
+  //! visiting only the nonzero features of the point.
+  template<typename eT>
+  static double PointDot(const arma::SpMat<eT>& predictors,
+                         const size_t i,
+                         const double* weights);
+
+  //! Add point i of a dense dataset, multiplied by scale, to out.
+  template<typename eT>
+  static void PointAdd(const arma::Mat<eT>& predictors,
+                       const size_t i,
+                       const double scale,
+                       double* out);
+
+  //! Add point i of a sparse dataset, multiplied by scale, to out, visiting
+  //! only the nonzero features of the point.
+  template<typename eT>
+  static void PointAdd(const arma::SpMat<eT>& predictors,
+                       const size_t i,
+                       const double scale,
+                       double* out);
+
+  //! Get the indices and values of the features of point i of a dense
+  //! dataset (all of them).
+  template<typename eT>
+  static void PointFeatures(const arma::Mat<eT>& predictors,
+                            const size_t i,
+                            arma::uvec& features,
+                            arma::vec& values);
+
+  //! Get the indices and values of the nonzero features of point i of a sparse
+  //! dataset.
+  template<typename eT>
+  static void PointFeatures(const arma::SpMat<eT>& predictors,
+                            const size_t i,
+                            arma::uvec& features,
+                            arma::vec& values);
+
+  //! Count the number of points each feature of a dense dataset is nonzero in
+  //! (this is taken to be every point).
+  template<typename eT>
+  static void CountFeatures(const arma::Mat<eT>& predictors,
+                            arma::vec& featureCounts);
+
+  //! Count the number of points each feature of a sparse dataset is nonzero
+  //! in.
+  template<typename eT>
+  static void CountFeatures(const arma::SpMat<eT>& predictors,
+                            arma::vec& featureCounts);
+
   //! The initial point, from which to start the optimization.
   arma::mat initialPoint;
   //! The matrix of data points (predictors).
@@ -114,6 +267,9 @@ class LogisticRegressionFunction
   const arma::Row<size_t>& responses;
   //! The regularization parameter for L2-regularization.
   double lambda;
+  //! The number of points each feature is nonzero in, for the sparse
+  //! gradient.
+  arma::vec featureCounts;
 };
 
 } // namespace regression
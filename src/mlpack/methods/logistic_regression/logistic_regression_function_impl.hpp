@@ -30,6 +30,8 @@ LogisticRegressionFunction<MatType>::LogisticRegressionFunction(
         << "predictors matrix has " << predictors.n_cols << " points, but "
         << "responses vector has " << responses.n_elem << " elements (should be"
         << " " << predictors.n_cols << ")!" << std::endl;
+
+  CountFeatures(predictors, featureCounts);
 }
 
 template<typename MatType>
@@ -47,6 +49,8 @@ LogisticRegressionFunction<MatType>::LogisticRegressionFunction(
   if (initialPoint.n_rows != (predictors.n_rows + 1) ||
       initialPoint.n_cols != 1)
     this->initialPoint = arma::zeros<arma::mat>(predictors.n_rows + 1, 1);
+
+  CountFeatures(predictors, featureCounts);
 }
 
 /**
@@ -71,10 +75,12 @@ double LogisticRegressionFunction<MatType>::Evaluate(
                 parameters.col(0).subvec(1, parameters.n_elem - 1));
 
   // Calculate vectors of sigmoids.  The intercept term is parameters(0, 0) and
-  // does not need to be multiplied by any of the predictors.
-  const arma::vec exponents = parameters(0, 0) + predictors.t() *
-      parameters.col(0).subvec(1, parameters.n_elem - 1);
-  const arma::vec sigmoid = 1.0 / (1.0 + arma::exp(-exponents));
+  // does not need to be multiplied by any of the predictors.  The product is
+  // taken as w' X, so that a sparse predictors matrix is not transposed.
+  const arma::rowvec weights =
+      parameters.col(0).subvec(1, parameters.n_elem - 1).t();
+  const arma::rowvec exponents = parameters(0, 0) + weights * predictors;
+  const arma::rowvec sigmoid = 1.0 / (1.0 + arma::exp(-exponents));
 
   // Assemble full objective function.  Often the objective function and the
   // regularization as given are divided by the number of features, but this
@@ -105,13 +111,14 @@ double LogisticRegressionFunction<MatType>::Evaluate(
 {
   // Calculate the regularization term.  We must divide by the number of points,
   // so that sum(Evaluate(parameters, [1:points])) == Evaluate(parameters).
-  const double regularization = lambda * (1.0 / (2.0 * predictors.n_cols)) *
+  const double regularization = (lambda == 0.0) ? 0.0 :
+      lambda * (1.0 / (2.0 * predictors.n_cols)) *
       arma::dot(parameters.col(0).subvec(1, parameters.n_elem - 1),
                 parameters.col(0).subvec(1, parameters.n_elem - 1));
 
   // Calculate sigmoid.
-  const double exponent = parameters(0, 0) + arma::dot(predictors.col(i),
-      parameters.col(0).subvec(1, parameters.n_elem - 1));
+  const double exponent = parameters(0, 0) + PointDot(predictors, i,
+      parameters.memptr() + 1);
   const double sigmoid = 1.0 / (1.0 + std::exp(-exponent));
 
   if (responses[i] == 1)
@@ -120,6 +127,43 @@ double LogisticRegressionFunction<MatType>::Evaluate(
     return -log(1.0 - sigmoid) + regularization;
 }
 
+/**
+ * Evaluate the logistic regression objective function on a batch of contiguous
+ * points.  This is useful for optimizers that use mini-batches, such as
+ * MiniBatchSGD.
+ */
+template<typename MatType>
+double LogisticRegressionFunction<MatType>::Evaluate(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t batchSize) const
+{
+  // The regularization term is scaled so that the sum over all batches is the
+  // regularization of Evaluate(parameters).
+  const double regularization = (lambda == 0.0) ? 0.0 :
+      lambda * (batchSize / (2.0 * predictors.n_cols)) *
+      arma::dot(parameters.col(0).subvec(1, parameters.n_elem - 1),
+                parameters.col(0).subvec(1, parameters.n_elem - 1));
+
+  // Calculate the sigmoids of the batch all at once.
+  const arma::rowvec weights =
+      parameters.col(0).subvec(1, parameters.n_elem - 1).t();
+  const arma::rowvec exponents = parameters(0, 0) + weights *
+      predictors.cols(begin, begin + batchSize - 1);
+  const arma::rowvec sigmoid = 1.0 / (1.0 + arma::exp(-exponents));
+
+  double result = 0.0;
+  for (size_t i = 0; i < batchSize; ++i)
+  {
+    if (responses[begin + i] == 1)
+      result += log(sigmoid[i]);
+    else
+      result += log(1.0 - sigmoid[i]);
+  }
+
+  return -result + regularization;
+}
+
 //! Evaluate the gradient of the logistic regression objective function.
 template<typename MatType>
 void LogisticRegressionFunction<MatType>::Gradient(
@@ -130,13 +174,17 @@ void LogisticRegressionFunction<MatType>::Gradient(
   arma::mat regularization;
   regularization = lambda * parameters.col(0).subvec(1, parameters.n_elem - 1);
 
+  const arma::rowvec weights =
+      parameters.col(0).subvec(1, parameters.n_elem - 1).t();
   const arma::rowvec sigmoids = (1 / (1 + arma::exp(-parameters(0, 0)
-      - parameters.col(0).subvec(1, parameters.n_elem - 1).t() * predictors)));
+      - weights * predictors)));
+  const arma::vec errors = arma::conv_to<arma::vec>::from(responses) -
+      sigmoids.t();
 
   gradient.set_size(parameters.n_elem);
-  gradient[0] = -arma::accu(responses - sigmoids);
-  gradient.col(0).subvec(1, parameters.n_elem - 1) = -predictors * (responses -
-      sigmoids).t() + regularization;
+  gradient[0] = -arma::accu(errors);
+  gradient.col(0).subvec(1, parameters.n_elem - 1) = -predictors * errors +
+      regularization;
 }
 
 /**
@@ -150,19 +198,318 @@ void LogisticRegressionFunction<MatType>::Gradient(
     const size_t i,
     arma::mat& gradient) const
 {
-  // Calculate the regularization term.
-  arma::mat regularization;
-  regularization = lambda * parameters.col(0).subvec(1, parameters.n_elem - 1)
-      / predictors.n_cols;
+  const double sigmoid = 1.0 / (1.0 + std::exp(-parameters(0, 0)
+      - PointDot(predictors, i, parameters.memptr() + 1)));
+
+  // Start with the regularization term, and then add the term of the point.
+  // For a sparse predictors matrix, only the nonzero features of the point
+  // are visited.
+  gradient.set_size(parameters.n_elem, 1);
+  if (lambda == 0.0)
+    gradient.zeros();
+  else
+    gradient.col(0).subvec(1, parameters.n_elem - 1) = lambda *
+        parameters.col(0).subvec(1, parameters.n_elem - 1) / predictors.n_cols;
+
+  const double error = responses[i] - sigmoid;
+  gradient[0] = -error;
+  PointAdd(predictors, i, -error, gradient.memptr() + 1);
+}
+
+/**
+ * Evaluate the logistic regression objective function and its gradient at once.
+ * This is the same as Evaluate() followed by Gradient(), but the sigmoids of
+ * the points (and the product w' X) are only computed once.
+ */
+template<typename MatType>
+double LogisticRegressionFunction<MatType>::EvaluateWithGradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  // For the regularization, we ignore the first term, which is the intercept
+  // term.
+  const double regularization = 0.5 * lambda *
+      arma::dot(parameters.col(0).subvec(1, parameters.n_elem - 1),
+                parameters.col(0).subvec(1, parameters.n_elem - 1));
+
+  const arma::rowvec weights =
+      parameters.col(0).subvec(1, parameters.n_elem - 1).t();
+  const arma::rowvec sigmoids = 1.0 / (1.0 + arma::exp(-parameters(0, 0)
+      - weights * predictors));
+
+  double result = 0.0;
+  for (size_t i = 0; i < responses.n_elem; ++i)
+  {
+    if (responses[i] == 1)
+      result += log(sigmoids[i]);
+    else
+      result += log(1.0 - sigmoids[i]);
+  }
+
+  const arma::vec errors = arma::conv_to<arma::vec>::from(responses) -
+      sigmoids.t();
 
+  gradient.set_size(parameters.n_elem, 1);
+  gradient[0] = -arma::accu(errors);
+  gradient.col(0).subvec(1, parameters.n_elem - 1) = -predictors * errors +
+      lambda * parameters.col(0).subvec(1, parameters.n_elem - 1);
+
+  // Invert the result, because it's a minimization.
+  return -result + regularization;
+}
+
+/**
+ * Evaluate the logistic regression objective function and its gradient with
+ * respect to one point at once, so that the sigmoid of the point is only
+ * computed once.  This is useful for optimizers such as SGD.
+ */
+template<typename MatType>
+double LogisticRegressionFunction<MatType>::EvaluateWithGradient(
+    const arma::mat& parameters,
+    const size_t i,
+    arma::mat& gradient) const
+{
   const double sigmoid = 1.0 / (1.0 + std::exp(-parameters(0, 0)
-      - arma::dot(predictors.col(i), parameters.col(0).subvec(1,
-      parameters.n_elem - 1))));
+      - PointDot(predictors, i, parameters.memptr() + 1)));
 
-  gradient.set_size(parameters.n_elem);
-  gradient[0] = -(responses[i] - sigmoid);
-  gradient.col(0).subvec(1, parameters.n_elem - 1) = -predictors.col(i)
-      * (responses[i] - sigmoid) + regularization;
+  // The regularization term of the objective and the gradient, divided by the
+  // number of points as in Evaluate(parameters, i).
+  gradient.set_size(parameters.n_elem, 1);
+  double regularization = 0.0;
+  if (lambda == 0.0)
+  {
+    gradient.zeros();
+  }
+  else
+  {
+    regularization = lambda * (1.0 / (2.0 * predictors.n_cols)) *
+        arma::dot(parameters.col(0).subvec(1, parameters.n_elem - 1),
+                  parameters.col(0).subvec(1, parameters.n_elem - 1));
+    gradient.col(0).subvec(1, parameters.n_elem - 1) = lambda *
+        parameters.col(0).subvec(1, parameters.n_elem - 1) / predictors.n_cols;
+  }
+
+  const double error = responses[i] - sigmoid;
+  gradient[0] = -error;
+  PointAdd(predictors, i, -error, gradient.memptr() + 1);
+
+  if (responses[i] == 1)
+    return -log(sigmoid) + regularization;
+  else
+    return -log(1.0 - sigmoid) + regularization;
+}
+
+/**
+ * Compute the product of the Hessian of the logistic regression objective
+ * function and a direction.  The Hessian is X' D X plus the regularization,
+ * where X holds the points (with a leading 1 for the intercept) and D is the
+ * diagonal matrix of the variances s (1 - s) of the sigmoids.
+ */
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::HessianVectorProduct(
+    const arma::mat& parameters,
+    const arma::mat& v,
+    arma::mat& hv) const
+{
+  const arma::rowvec weights =
+      parameters.col(0).subvec(1, parameters.n_elem - 1).t();
+  const arma::rowvec sigmoids = (1 / (1 + arma::exp(-parameters(0, 0)
+      - weights * predictors)));
+
+  // The product of each point and the direction, scaled by the variance of
+  // its sigmoid.
+  const arma::rowvec directions = v(0, 0) +
+      v.col(0).subvec(1, v.n_elem - 1).t() * predictors;
+  const arma::vec scaled = (sigmoids % (1.0 - sigmoids) % directions).t();
+
+  hv.set_size(parameters.n_elem, 1);
+  hv[0] = arma::accu(scaled);
+  hv.col(0).subvec(1, parameters.n_elem - 1) = predictors * scaled +
+      lambda * v.col(0).subvec(1, v.n_elem - 1);
+}
+
+/**
+ * Evaluate the gradient of the logistic regression objective function with
+ * respect to one point, as a sparse vector.  This is useful for optimizers that
+ * update only the nonzero coordinates of the gradient, such as ParallelSGD.
+ */
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::Gradient(
+    const arma::mat& parameters,
+    const size_t i,
+    arma::sp_mat& gradient) const
+{
+  const double sigmoid = 1.0 / (1.0 + std::exp(-parameters(0, 0)
+      - PointDot(predictors, i, parameters.memptr() + 1)));
+  const double error = responses[i] - sigmoid;
+
+  arma::uvec features;
+  arma::vec featureValues;
+  PointFeatures(predictors, i, features, featureValues);
+
+  // The intercept comes first; then each feature j of the point, with its
+  // share of the regularization.  The features are in increasing order, so the
+  // locations are already sorted.
+  arma::umat locations(2, features.n_elem + 1);
+  arma::vec values(features.n_elem + 1);
+  locations(0, 0) = 0;
+  locations(1, 0) = 0;
+  values[0] = -error;
+  for (size_t k = 0; k < features.n_elem; ++k)
+  {
+    const size_t j = features[k];
+    locations(0, k + 1) = j + 1;
+    locations(1, k + 1) = 0;
+    values[k + 1] = -error * featureValues[k];
+    if (lambda != 0.0)
+      values[k + 1] += lambda * parameters[j + 1] / featureCounts[j];
+  }
+
+  gradient = arma::sp_mat(locations, values, parameters.n_elem, 1);
+}
+
+/**
+ * Evaluate the gradient of the logistic regression objective function with
+ * respect to a batch of contiguous points.  This is useful for optimizers that
+ * use mini-batches, such as MiniBatchSGD.
+ */
+template<typename MatType>
+void LogisticRegressionFunction<MatType>::Gradient(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t batchSize,
+    arma::mat& gradient) const
+{
+  const size_t end = begin + batchSize - 1;
+  const arma::rowvec weights =
+      parameters.col(0).subvec(1, parameters.n_elem - 1).t();
+  const arma::rowvec sigmoids = (1 / (1 + arma::exp(-parameters(0, 0)
+      - weights * predictors.cols(begin, end))));
+  const arma::vec errors = arma::conv_to<arma::vec>::from(
+      responses.subvec(begin, end)) - sigmoids.t();
+
+  gradient.set_size(parameters.n_elem, 1);
+  gradient[0] = -arma::accu(errors);
+  gradient.col(0).subvec(1, parameters.n_elem - 1) =
+      -predictors.cols(begin, end) * errors;
+
+  // The regularization term of each point in the batch.
+  if (lambda != 0.0)
+    gradient.col(0).subvec(1, parameters.n_elem - 1) += lambda *
+        (double(batchSize) / predictors.n_cols) *
+        parameters.col(0).subvec(1, parameters.n_elem - 1);
+}
+
+template<typename MatType>
+template<typename eT>
+double LogisticRegressionFunction<MatType>::PointDot(
+    const arma::Mat<eT>& predictors,
+    const size_t i,
+    const double* weights)
+{
+  const eT* point = predictors.colptr(i);
+  double result = 0.0;
+  for (size_t j = 0; j < predictors.n_rows; ++j)
+    result += point[j] * weights[j];
+
+  return result;
+}
+
+template<typename MatType>
+template<typename eT>
+double LogisticRegressionFunction<MatType>::PointDot(
+    const arma::SpMat<eT>& predictors,
+    const size_t i,
+    const double* weights)
+{
+  double result = 0.0;
+  for (typename arma::SpMat<eT>::const_iterator it = predictors.begin_col(i);
+       it != predictors.end_col(i); ++it)
+    result += (*it) * weights[it.row()];
+
+  return result;
+}
+
+template<typename MatType>
+template<typename eT>
+void LogisticRegressionFunction<MatType>::PointAdd(
+    const arma::Mat<eT>& predictors,
+    const size_t i,
+    const double scale,
+    double* out)
+{
+  const eT* point = predictors.colptr(i);
+  for (size_t j = 0; j < predictors.n_rows; ++j)
+    out[j] += scale * point[j];
+}
+
+template<typename MatType>
+template<typename eT>
+void LogisticRegressionFunction<MatType>::PointAdd(
+    const arma::SpMat<eT>& predictors,
+    const size_t i,
+    const double scale,
+    double* out)
+{
+  for (typename arma::SpMat<eT>::const_iterator it = predictors.begin_col(i);
+       it != predictors.end_col(i); ++it)
+    out[it.row()] += scale * (*it);
+}
+
+template<typename MatType>
+template<typename eT>
+void LogisticRegressionFunction<MatType>::PointFeatures(
+    const arma::Mat<eT>& predictors,
+    const size_t i,
+    arma::uvec& features,
+    arma::vec& values)
+{
+  features = arma::linspace<arma::uvec>(0, predictors.n_rows - 1,
+      predictors.n_rows);
+  values = arma::conv_to<arma::vec>::from(predictors.col(i));
+}
+
+template<typename MatType>
+template<typename eT>
+void LogisticRegressionFunction<MatType>::PointFeatures(
+    const arma::SpMat<eT>& predictors,
+    const size_t i,
+    arma::uvec& features,
+    arma::vec& values)
+{
+  const size_t nonzeros = predictors.col_ptrs[i + 1] - predictors.col_ptrs[i];
+  features.set_size(nonzeros);
+  values.set_size(nonzeros);
+
+  size_t k = 0;
+  for (typename arma::SpMat<eT>::const_iterator it = predictors.begin_col(i);
+       it != predictors.end_col(i); ++it, ++k)
+  {
+    features[k] = it.row();
+    values[k] = (*it);
+  }
+}
+
+template<typename MatType>
+template<typename eT>
+void LogisticRegressionFunction<MatType>::CountFeatures(
+    const arma::Mat<eT>& predictors,
+    arma::vec& featureCounts)
+{
+  featureCounts.set_size(predictors.n_rows);
+  featureCounts.fill(predictors.n_cols);
+}
+
+template<typename MatType>
+template<typename eT>
+void LogisticRegressionFunction<MatType>::CountFeatures(
+    const arma::SpMat<eT>& predictors,
+    arma::vec& featureCounts)
+{
+  featureCounts.zeros(predictors.n_rows);
+  for (typename arma::SpMat<eT>::const_iterator it = predictors.begin();
+       it != predictors.end(); ++it)
+    ++featureCounts[it.row()];
 }
 
 } // namespace regression
@@ -99,9 +99,11 @@ void LogisticRegression<MatType>::Predict(const MatType& predictors,
 {
   // Calculate sigmoid function for each point.  The (1.0 - decisionBoundary)
   // term correctly sets an offset so that floor() returns 0 or 1 correctly.
+  // The product is taken as w' X, so that a sparse predictors matrix is not
+  // transposed.
+  const arma::rowvec weights = parameters.subvec(1, parameters.n_elem - 1).t();
   responses = arma::conv_to<arma::Row<size_t>>::from((1.0 /
-      (1.0 + arma::exp(-parameters(0) - predictors.t() *
-      parameters.subvec(1, parameters.n_elem - 1)))) +
+      (1.0 + arma::exp(-parameters(0) - weights * predictors))) +
       (1.0 - decisionBoundary));
 }
 
@@ -111,7 +113,7 @@ double LogisticRegression<MatType>::ComputeError(
     const arma::Row<size_t>& responses) const
 {
   // Construct a new error function.
-  LogisticRegressionFunction<> newErrorFunction(predictors, responses,
+  LogisticRegressionFunction<MatType> newErrorFunction(predictors, responses,
       lambda);
 
   return newErrorFunction.Evaluate(parameters);
@@ -8,6 +8,7 @@
 #include "logistic_regression.hpp"
 
 #include <mlpack/core/optimizers/sgd/sgd.hpp>
+#include <mlpack/core/optimizers/tron/tron.hpp>
 
 using namespace std;
 using namespace mlpack;
@@ -15,8 +16,9 @@ using namespace mlpack::regression;
 using namespace mlpack::optimization;
 
 PROGRAM_INFO("L2-regularized Logistic Regression and Prediction",
-    "An implementation of L2-regularized logistic regression using either the "
-    "L-BFGS optimizer or SGD (stochastic gradient descent).  This solves the "
+    "An implementation of L2-regularized logistic regression using the "
+    "L-BFGS optimizer, the TRON (trust region Newton) optimizer, or SGD "
+    "(stochastic gradient descent).  This solves the "
     "regression problem"
     "\n\n"
     "  y = (1 / 1 + e^-(X * b))"
@@ -38,11 +40,14 @@ PROGRAM_INFO("L2-regularized Logistic Regression and Prediction",
     "When a model is being trained, there are many options.  L2 regularization "
     "(to prevent overfitting) can be specified with the -l option, and the "
     "optimizer used to train the model can be specified with the --optimizer "
-    "option.  Available options are 'sgd' (stochastic gradient descent) and "
-    "'lbfgs' (the L-BFGS optimizer).  There are also various parameters for the"
-    " optimizer; the --max_iterations parameter specifies the maximum number of"
-    " allowed iterations, and the --tolerance (-e) parameter specifies the "
-    "tolerance for convergence.  For the SGD optimizer, the --step_size "
+    "option.  Available options are 'sgd' (stochastic gradient descent), "
+    "'lbfgs' (the L-BFGS optimizer), and 'tron' (the trust region Newton "
+    "optimizer, which often needs far fewer passes over the data than L-BFGS "
+    "on large, well-conditioned problems).  There are also various parameters "
+    "for the optimizer; the --max_iterations parameter specifies the maximum "
+    "number of allowed iterations, and the --tolerance (-e) parameter specifies"
+    " the tolerance for convergence (for TRON, relative to the initial gradient"
+    " norm).  For the SGD optimizer, the --step_size "
     "parameter controls the step size taken at each iteration by the optimizer."
     "  If the objective function for your data is oscillating between Inf and "
     "0, the step size is probably too large.  There are more parameters for the"
@@ -68,8 +73,8 @@ PARAM_STRING("labels_file", "A file containing labels (0 or 1) for the points "
 
 // Optimizer parameters.
 PARAM_DOUBLE("lambda", "L2-regularization parameter for training.", "L", 0.0);
-PARAM_STRING("optimizer", "Optimizer to use for training ('lbfgs' or 'sgd').",
-    "O", "lbfgs");
+PARAM_STRING("optimizer", "Optimizer to use for training ('lbfgs', 'sgd', or "
+    "'tron').", "O", "lbfgs");
 PARAM_DOUBLE("tolerance", "Convergence tolerance for optimizer.", "e", 1e-10);
 PARAM_INT("max_iterations", "Maximum iterations for optimizer (0 indicates no "
     "limit).", "M", 10000);
@@ -123,9 +128,10 @@ int main(int argc, char** argv)
     Log::Fatal << "Tolerance must be positive (received " << tolerance << ")."
         << endl;
 
-  // Optimizer has to be L-BFGS or SGD.
-  if (optimizerType != "lbfgs" && optimizerType != "sgd")
-    Log::Fatal << "--optimizer must be 'lbfgs' or 'sgd'." << endl;
+  // Optimizer has to be L-BFGS, SGD, or TRON.
+  if (optimizerType != "lbfgs" && optimizerType != "sgd" &&
+      optimizerType != "tron")
+    Log::Fatal << "--optimizer must be 'lbfgs', 'sgd', or 'tron'." << endl;
 
   // Lambda must be positive.
   if (lambda < 0.0)
@@ -141,7 +147,7 @@ int main(int argc, char** argv)
     Log::Fatal << "Step size (--step_size) must be positive (received "
         << stepSize << ")." << endl;
 
-  if (CLI::HasParam("step_size") && optimizerType == "lbfgs")
+  if (CLI::HasParam("step_size") && optimizerType != "sgd")
     Log::Warn << "Step size (--step_size) ignored because 'sgd' optimizer is "
         << "not being used." << endl;
 
@@ -222,6 +228,16 @@ int main(int argc, char** argv)
       // This will train the model.
       model.Train(lbfgsOpt);
     }
+    else if (optimizerType == "tron")
+    {
+      TRON<LogisticRegressionFunction<>> tronOpt(lrf);
+      tronOpt.MaxIterations() = maxIterations;
+      tronOpt.Tolerance() = tolerance;
+      Log::Info << "Training model with TRON optimizer." << endl;
+
+      // This will train the model.
+      model.Train(tronOpt);
+    }
   }
 
   if (!testFile.empty())
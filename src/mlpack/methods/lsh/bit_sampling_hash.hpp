@@ -0,0 +1,139 @@
+/**
+ * @file bit_sampling_hash.hpp
+ * @author Ryan Curtin
+ *
+ * The bit sampling hash family, for the Hamming distance between binary
+ * points.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_BIT_SAMPLING_HASH_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_BIT_SAMPLING_HASH_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The bit sampling hash family of Indyk and Motwani, for points whose
+ * coordinates are 0 or 1: each hash function is one coordinate of the point,
+ * chosen at random, so two points get the same bit with probability 1 - h / d,
+ * where h is the Hamming distance between them and d is the dimensionality.
+ * A coordinate is taken to be 1 if it is at least 0.5.  Each key element is a
+ * bit, so LSHSearch stores a packed signature of every point and can filter
+ * its candidates by Hamming distance.  For binary points, the Euclidean
+ * distance that LSHSearch ranks the candidates by is the square root of the
+ * Hamming distance, so it gives the same order.
+ *
+ * @code
+ * @inproceedings{indyk1998approximate,
+ *   title={Approximate nearest neighbors: towards removing the curse of
+ *       dimensionality},
+ *   author={Indyk, P. and Motwani, R.},
+ *   booktitle={Proceedings of the 30th Annual ACM Symposium on Theory of
+ *       Computing (STOC 1998)},
+ *   pages={604--613},
+ *   year={1998}
+ * }
+ * @endcode
+ *
+ * See PStableHash for the policy this implements.  The hash width is not used.
+ */
+class BitSamplingHash
+{
+ public:
+  //! Each key element is a bit.
+  static const bool BinaryKeys = true;
+
+  //! Create an empty hash family; Train() must be called before it is used.
+  BitSamplingHash() : numProj(0) { }
+
+  //! Draw the coordinates sampled by every table (with replacement).
+  void Train(const arma::mat& referenceSet,
+             const size_t numProj,
+             const size_t numTables,
+             const double /* hashWidth */)
+  {
+    dimensions.set_size(numProj * numTables);
+    for (size_t i = 0; i < dimensions.n_elem; ++i)
+      dimensions[i] = (size_t) math::RandInt(referenceSet.n_rows);
+    this->numProj = numProj;
+  }
+
+  //! Compute the projections of the given points in the given table: the
+  //! sampled coordinates, minus 0.5.
+  void Project(const arma::mat& points,
+               const size_t table,
+               arma::mat& projectionsOut) const
+  {
+    Sample(points, table * numProj, numProj, projectionsOut);
+  }
+
+  //! Compute the projections of the given points in the first numTables
+  //! tables.
+  void ProjectAll(const arma::mat& points,
+                  const size_t numTables,
+                  arma::mat& projectionsOut) const
+  {
+    Sample(points, 0, numTables * numProj, projectionsOut);
+  }
+
+  //! The key of a projection is 1 if it is nonnegative and 0 otherwise.
+  arma::mat Keys(const arma::mat& projectionsIn) const
+  {
+    arma::mat keys(projectionsIn.n_rows, projectionsIn.n_cols);
+    for (size_t i = 0; i < projectionsIn.n_elem; ++i)
+      keys[i] = (projectionsIn[i] >= 0.0) ? 1.0 : 0.0;
+    return keys;
+  }
+
+  //! Move j flips bit j of the key, at the cost of the squared distance of the
+  //! coordinate to 0.5.
+  void ProbeMoves(const arma::vec& projection,
+                  const arma::vec& key,
+                  arma::vec& costs,
+                  arma::vec& steps) const
+  {
+    costs = arma::square(projection);
+    steps = 1.0 - 2.0 * key;
+  }
+
+  //! Get the coordinates sampled by every table; table i samples elements
+  //! i * numProj to (i + 1) * numProj - 1.
+  const arma::Col<size_t>& Dimensions() const { return dimensions; }
+
+  //! Get the memory used by the hash functions, in bytes.
+  size_t MemoryUsage() const { return mlpack::MemoryUsage(dimensions); }
+
+  //! Serialize the hash functions.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    using data::CreateNVP;
+
+    ar & CreateNVP(dimensions, "dimensions");
+    ar & CreateNVP(numProj, "numProj");
+  }
+
+ private:
+  //! The coordinate sampled by each hash function of every table.
+  arma::Col<size_t> dimensions;
+  //! The number of hash functions of each table.
+  size_t numProj;
+
+  //! Gather the given sampled coordinates of the given points.
+  void Sample(const arma::mat& points,
+              const size_t first,
+              const size_t count,
+              arma::mat& projectionsOut) const
+  {
+    projectionsOut.set_size(count, points.n_cols);
+    for (size_t j = 0; j < points.n_cols; ++j)
+      for (size_t i = 0; i < count; ++i)
+        projectionsOut(i, j) = points(dimensions[first + i], j) - 0.5;
+  }
+};
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
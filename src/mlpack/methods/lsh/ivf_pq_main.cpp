@@ -0,0 +1,231 @@
+/**
+ * @file ivf_pq_main.cpp
+ * @author Ryan Curtin
+ *
+ * This file computes approximate nearest neighbors with an inverted file index
+ * compressed by product quantization (IVF-PQ).
+ */
+#include <time.h>
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/data/mapped_matrix.hpp>
+
+#include <memory>
+#include <string>
+
+#include "ivf_pq_search.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+// Information about the program itself.
+PROGRAM_INFO("All K-Approximate-Nearest-Neighbor Search with IVF-PQ",
+    "This program will calculate the k approximate-nearest-neighbors of a set "
+    "of points with an inverted file index compressed by product quantization "
+    "(IVF-PQ).  The reference points are split into --lists lists by k-means "
+    "clustering, and the residual of each point from the centroid of its list "
+    "is stored as --subspaces bytes, one code for each subspace of the "
+    "dimensions; the reference set itself is not stored in the index.  Each "
+    "query point is searched in the --probes lists nearest to it, with "
+    "distances computed from the codes."
+    "\n\n"
+    "For example, the following will build an index with 1024 lists and 16 "
+    "bytes per point on 'input.bin', save it to 'index.xml', and return 5 "
+    "neighbors of each point in 'queries.csv', searching 8 lists for each:"
+    "\n\n"
+    "$ ivf_pq -r input.bin -x -l 1024 -S 16 -M index.xml -q queries.csv -k 5 "
+    "-p 8 -n neighbors.csv -d distances.csv"
+    "\n\n"
+    "Since the distances computed from the codes are approximate, the best "
+    "--rerank candidates of each query point can be re-ranked with their exact "
+    "distances, taken from the reference file; with --mmap_reference, the "
+    "reference file is memory-mapped, so only the candidates are read from "
+    "disk.  A saved index can be given with --input_model_file, together with "
+    "the reference file if re-ranking is wanted."
+    "\n\n"
+    "The output files are organized as those of the lsh program.  If fewer "
+    "than k points are in the searched lists, the remaining neighbors have the "
+    "largest representable index and distance.");
+
+PARAM_STRING("reference_file", "File containing the reference dataset.", "r",
+    "");
+PARAM_FLAG("mmap_reference", "If true, the reference file is memory-mapped "
+    "instead of loaded.  It must be in Armadillo binary format, with one point "
+    "per column (i.e., not transposed).", "x");
+PARAM_STRING("query_file", "File containing query points (optional).", "q", "");
+PARAM_STRING("distances_file", "File to output distances into.", "d", "");
+PARAM_STRING("neighbors_file", "File to output neighbors into.", "n", "");
+PARAM_INT("k", "Number of nearest neighbors to find.", "k", 0);
+
+PARAM_STRING("input_model_file", "File containing a saved IVF-PQ index.", "m",
+    "");
+PARAM_STRING("output_model_file", "If specified, the IVF-PQ index will be "
+    "saved to the given file.", "M", "");
+
+PARAM_INT("lists", "Number of lists (k-means clusters) of the index.", "l",
+    256);
+PARAM_INT("subspaces", "Number of subspaces; each point is stored as this many "
+    "bytes.", "S", 8);
+PARAM_INT("codewords", "Number of codewords of each subspace (at most 256).",
+    "c", 256);
+PARAM_INT("training_points", "Number of reference points sampled to train the "
+    "index (0 for all).", "t", 0);
+PARAM_INT("max_iterations", "Maximum number of iterations of each k-means "
+    "clustering.", "i", 100);
+
+PARAM_INT("probes", "Number of lists to search for each query point.", "p", 1);
+PARAM_INT("rerank", "Number of candidates of each query point to re-rank with "
+    "their exact distances (0 for no re-ranking); requires the reference "
+    "file.", "R", 0);
+PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
+
+int main(int argc, char *argv[])
+{
+  // Give CLI the command line parameters the user passed in.
+  CLI::ParseCommandLine(argc, argv);
+
+  if (CLI::GetParam<int>("seed") != 0)
+    math::RandomSeed((size_t) CLI::GetParam<int>("seed"));
+  else
+    math::RandomSeed((size_t) time(NULL));
+
+  const string referenceFile = CLI::GetParam<string>("reference_file");
+  const string inputModelFile = CLI::GetParam<string>("input_model_file");
+  const int k = CLI::GetParam<int>("k");
+  const int probes = CLI::GetParam<int>("probes");
+  const int rerank = CLI::GetParam<int>("rerank");
+
+  // Sanity check on parameters.
+  if (referenceFile == "" && inputModelFile == "")
+    Log::Fatal << "One of --reference_file or --input_model_file must be "
+        << "specified!" << endl;
+  if (CLI::HasParam("mmap_reference") && referenceFile == "")
+    Log::Fatal << "--mmap_reference requires --reference_file." << endl;
+  if (k < 0)
+    Log::Fatal << "Invalid k: " << k << "; must be nonnegative." << endl;
+  if (probes <= 0)
+    Log::Fatal << "Invalid number of probes: " << probes << "; must be "
+        << "positive." << endl;
+  if (rerank < 0)
+    Log::Fatal << "Invalid rerank: " << rerank << "; must be nonnegative."
+        << endl;
+  if (rerank > 0 && referenceFile == "")
+    Log::Fatal << "--rerank requires --reference_file." << endl;
+  if (k == 0 && (CLI::HasParam("neighbors_file") ||
+      CLI::HasParam("distances_file")))
+    Log::Warn << "--k is 0, so no neighbors will be saved." << endl;
+
+  // Load or map the reference set, if it was given.
+  arma::mat referenceData;
+  unique_ptr<data::MappedMatrix> mappedReference;
+  const arma::mat* referenceSet = NULL;
+  if (referenceFile != "")
+  {
+    if (CLI::HasParam("mmap_reference"))
+    {
+      try
+      {
+        mappedReference.reset(new data::MappedMatrix(referenceFile));
+      }
+      catch (std::runtime_error& e)
+      {
+        Log::Fatal << e.what() << "." << endl;
+      }
+
+      referenceSet = &mappedReference->Matrix();
+      Log::Info << "Mapped reference data from '" << referenceFile << "' ("
+          << referenceSet->n_rows << " x " << referenceSet->n_cols << ")."
+          << endl;
+    }
+    else
+    {
+      data::Load(referenceFile, referenceData, true);
+      referenceSet = &referenceData;
+      Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+          << referenceSet->n_rows << " x " << referenceSet->n_cols << ")."
+          << endl;
+    }
+  }
+
+  IVFPQSearch index;
+  if (inputModelFile != "")
+  {
+    data::Load(inputModelFile, "ivf_pq_model", index, true);
+    Log::Info << "Loaded IVF-PQ index from '" << inputModelFile << "' ("
+        << index.ReferencePoints() << " points, " << index.Lists()
+        << " lists, " << index.Subspaces() << " subspaces)." << endl;
+  }
+  else
+  {
+    Log::Info << "Building IVF-PQ index with " << CLI::GetParam<int>("lists")
+        << " lists and " << CLI::GetParam<int>("subspaces") << " subspaces."
+        << endl;
+
+    Timer::Start("index_building");
+    try
+    {
+      index.Train(*referenceSet, (size_t) CLI::GetParam<int>("lists"),
+          (size_t) CLI::GetParam<int>("subspaces"),
+          (size_t) CLI::GetParam<int>("codewords"),
+          (size_t) CLI::GetParam<int>("max_iterations"),
+          (size_t) CLI::GetParam<int>("training_points"));
+    }
+    catch (std::invalid_argument& e)
+    {
+      Log::Fatal << e.what() << "." << endl;
+    }
+    Timer::Stop("index_building");
+  }
+
+  Memory::Report("ivf_pq_model", index.MemoryUsage());
+
+  if (k > 0)
+  {
+    arma::mat queryData;
+    const arma::mat* querySet = referenceSet;
+    if (CLI::GetParam<string>("query_file") != "")
+    {
+      const string queryFile = CLI::GetParam<string>("query_file");
+      data::Load(queryFile, queryData, true);
+      querySet = &queryData;
+      Log::Info << "Loaded query data from '" << queryFile << "' ("
+          << queryData.n_rows << " x " << queryData.n_cols << ")." << endl;
+    }
+    else if (querySet == NULL)
+    {
+      Log::Fatal << "--query_file or --reference_file must be specified to "
+          << "search." << endl;
+    }
+
+    Log::Info << "Computing " << k << " approximate nearest neighbors."
+        << endl;
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    try
+    {
+      index.Search(*querySet, (size_t) k, neighbors, distances,
+          (size_t) probes, (rerank > 0) ? referenceSet : NULL,
+          (size_t) rerank);
+    }
+    catch (std::invalid_argument& e)
+    {
+      Log::Fatal << e.what() << "." << endl;
+    }
+
+    Log::Info << "Neighbors computed." << endl;
+
+    Memory::Report("neighbors", MemoryUsage(neighbors));
+    Memory::Report("distances", MemoryUsage(distances));
+
+    if (CLI::GetParam<string>("distances_file") != "")
+      data::Save(CLI::GetParam<string>("distances_file"), distances);
+    if (CLI::GetParam<string>("neighbors_file") != "")
+      data::Save(CLI::GetParam<string>("neighbors_file"), neighbors);
+  }
+
+  if (CLI::GetParam<string>("output_model_file") != "")
+    data::Save(CLI::GetParam<string>("output_model_file"), "ivf_pq_model",
+        index);
+}
@@ -0,0 +1,308 @@
+/**
+ * @file ivf_pq_search.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of IVFPQSearch.
+ */
+#include "ivf_pq_search.hpp"
+
+#include <mlpack/methods/kmeans/kmeans.hpp>
+#include <mlpack/methods/neighbor_search/candidate_list.hpp>
+#include <mlpack/methods/neighbor_search/sort_policies/nearest_neighbor_sort.hpp>
+
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+IVFPQSearch::IVFPQSearch() : candidatesScored(0)
+{ /* Nothing to do. */ }
+
+IVFPQSearch::IVFPQSearch(const arma::mat& referenceSet,
+                         const size_t lists,
+                         const size_t subspaces,
+                         const size_t codewords,
+                         const size_t maxIterations,
+                         const size_t trainingPoints) :
+    candidatesScored(0)
+{
+  Train(referenceSet, lists, subspaces, codewords, maxIterations,
+      trainingPoints);
+}
+
+//! Get the index of the column of the given matrix nearest to the given point.
+static size_t Nearest(const arma::mat& points, const double* point)
+{
+  size_t best = 0;
+  double bestDistance = DBL_MAX;
+  for (size_t j = 0; j < points.n_cols; ++j)
+  {
+    const double* column = points.colptr(j);
+    double distance = 0.0;
+    for (size_t d = 0; d < points.n_rows; ++d)
+      distance += (point[d] - column[d]) * (point[d] - column[d]);
+
+    if (distance < bestDistance)
+    {
+      best = j;
+      bestDistance = distance;
+    }
+  }
+
+  return best;
+}
+
+void IVFPQSearch::Train(const arma::mat& referenceSet,
+                        const size_t lists,
+                        const size_t subspaces,
+                        const size_t codewords,
+                        const size_t maxIterations,
+                        const size_t trainingPoints)
+{
+  const size_t n = referenceSet.n_cols;
+  const size_t sampleSize = (trainingPoints == 0) ? n :
+      std::min(trainingPoints, n);
+
+  std::ostringstream oss;
+  if (n == 0)
+    oss << "cannot build an index of an empty reference set";
+  else if (n > (size_t) std::numeric_limits<arma::u32>::max())
+    oss << "the reference set has " << n << " points, but at most "
+        << std::numeric_limits<arma::u32>::max() << " can be indexed";
+  else if (lists == 0 || lists > sampleSize)
+    oss << "number of lists (" << lists << ") must be between 1 and the "
+        << "number of training points (" << sampleSize << ")";
+  else if (subspaces == 0 || subspaces > referenceSet.n_rows)
+    oss << "number of subspaces (" << subspaces << ") must be between 1 and "
+        << "the dimensionality of the reference set (" << referenceSet.n_rows
+        << ")";
+  else if (codewords == 0 || codewords > 256 || codewords > sampleSize)
+    oss << "number of codewords (" << codewords << ") must be between 1 and "
+        << "256, and at most the number of training points (" << sampleSize
+        << ")";
+
+  if (!oss.str().empty())
+    throw std::invalid_argument("IVFPQSearch::Train(): " + oss.str());
+
+  // Sample the training points without replacement (a partial Fisher-Yates
+  // shuffle of the indices).
+  arma::mat training;
+  if (sampleSize == n)
+  {
+    training = referenceSet;
+  }
+  else
+  {
+    arma::Col<size_t> indices(n);
+    for (size_t i = 0; i < n; ++i)
+      indices[i] = i;
+
+    training.set_size(referenceSet.n_rows, sampleSize);
+    for (size_t i = 0; i < sampleSize; ++i)
+    {
+      const size_t j = std::min(n - 1, i + (size_t) (math::Random() * (n - i)));
+      std::swap(indices[i], indices[j]);
+      training.col(i) = referenceSet.col(indices[i]);
+    }
+  }
+
+  Timer::Start("ivf_pq/coarse_quantizer");
+  kmeans::KMeans<> kmeans(maxIterations);
+  kmeans.Cluster(training, lists, centroids);
+  Timer::Stop("ivf_pq/coarse_quantizer");
+
+  // The codebooks are trained on the residuals of the training points.
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < training.n_cols; ++i)
+    training.col(i) -= centroids.col(Nearest(centroids, training.colptr(i)));
+
+  Timer::Start("ivf_pq/codebooks");
+  codebooks.clear();
+  codebooks.resize(subspaces);
+  for (size_t m = 0; m < subspaces; ++m)
+  {
+    const arma::mat subspace = training.rows(SubspaceBegin(m),
+        SubspaceBegin(m + 1) - 1);
+    kmeans.Cluster(subspace, codewords, codebooks[m]);
+  }
+  Timer::Stop("ivf_pq/codebooks");
+
+  // Assign each point to its list, and lay the lists out contiguously.
+  Timer::Start("ivf_pq/encoding");
+  arma::Col<size_t> assignments(n);
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n; ++i)
+    assignments[i] = Nearest(centroids, referenceSet.colptr(i));
+
+  listOffsets.zeros(lists + 1);
+  for (size_t i = 0; i < n; ++i)
+    ++listOffsets[assignments[i] + 1];
+  for (size_t l = 0; l < lists; ++l)
+    listOffsets[l + 1] += listOffsets[l];
+
+  arma::Col<size_t> positions = listOffsets.subvec(0, lists - 1);
+  listContents.set_size(n);
+  for (size_t i = 0; i < n; ++i)
+    listContents[positions[assignments[i]]++] = (arma::u32) i;
+
+  codes.set_size(subspaces, n);
+  #pragma omp parallel for schedule(static)
+  for (size_t p = 0; p < n; ++p)
+  {
+    const size_t i = listContents[p];
+    const arma::vec residual = referenceSet.col(i) -
+        centroids.col(assignments[i]);
+    Encode(residual, codes.colptr(p));
+  }
+  Timer::Stop("ivf_pq/encoding");
+}
+
+void IVFPQSearch::Search(const arma::mat& querySet,
+                         const size_t k,
+                         arma::Mat<size_t>& neighbors,
+                         arma::mat& distances,
+                         const size_t probes,
+                         const arma::mat* fullData,
+                         const size_t rerank)
+{
+  std::ostringstream oss;
+  if (Lists() == 0)
+    oss << "the index has not been trained";
+  else if (querySet.n_rows != Dimensionality())
+    oss << "dimensionality of the query set (" << querySet.n_rows << ") is "
+        << "not equal to the dimensionality of the index ("
+        << Dimensionality() << ")";
+  else if (k > ReferencePoints())
+    oss << "requested value of k (" << k << ") is greater than the number of "
+        << "points in the index (" << ReferencePoints() << ")";
+  else if (probes == 0)
+    oss << "number of probes must be positive";
+  else if (fullData && (fullData->n_rows != Dimensionality() ||
+      fullData->n_cols != ReferencePoints()))
+    oss << "the full-precision data (" << fullData->n_rows << " x "
+        << fullData->n_cols << ") does not match the index ("
+        << Dimensionality() << " x " << ReferencePoints() << ")";
+
+  if (!oss.str().empty())
+    throw std::invalid_argument("IVFPQSearch::Search(): " + oss.str());
+
+  typedef CandidateList<NearestNeighborSort> CandidateListType;
+
+  // With re-ranking, more candidates than k are collected by approximate
+  // (squared) distance.
+  const size_t probedLists = std::min(probes, Lists());
+  const size_t candidateCount = (fullData == NULL) ? k :
+      std::min(std::max(k, rerank), ReferencePoints());
+  arma::Mat<size_t> candidateNeighbors(candidateCount, querySet.n_cols);
+  candidateNeighbors.fill(size_t() - 1);
+  arma::mat candidateDistances(candidateCount, querySet.n_cols);
+  candidateDistances.fill(DBL_MAX);
+  CandidateListType candidates(candidateNeighbors, candidateDistances);
+
+  const size_t subspaces = Subspaces();
+  const size_t codebookSize = codebooks[0].n_cols;
+  size_t scored = 0;
+
+  Timer::Start("ivf_pq/search");
+  #pragma omp parallel for schedule(static) reduction(+:scored)
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+  {
+    // Find the lists whose centroids are nearest to the query point.
+    arma::vec centroidDistances(Lists());
+    for (size_t l = 0; l < Lists(); ++l)
+      centroidDistances[l] = arma::accu(arma::square(querySet.col(i) -
+          centroids.col(l)));
+    const arma::uvec order = arma::sort_index(centroidDistances);
+
+    arma::mat table(codebookSize, subspaces);
+    for (size_t j = 0; j < probedLists; ++j)
+    {
+      // Tabulate the squared distances from the residual of the query point
+      // to each codeword of each subspace.
+      const size_t l = order[j];
+      const arma::vec residual = querySet.col(i) - centroids.col(l);
+      for (size_t m = 0; m < subspaces; ++m)
+      {
+        const arma::vec subvector = residual.subvec(SubspaceBegin(m),
+            SubspaceBegin(m + 1) - 1);
+        for (size_t c = 0; c < codebookSize; ++c)
+          table(c, m) = arma::accu(arma::square(subvector -
+              codebooks[m].col(c)));
+      }
+
+      for (size_t p = listOffsets[l]; p < listOffsets[l + 1]; ++p)
+      {
+        const unsigned char* code = codes.colptr(p);
+        double distance = 0.0;
+        for (size_t m = 0; m < subspaces; ++m)
+          distance += table(code[m], m);
+
+        candidates.Insert(i, listContents[p], distance);
+      }
+
+      scored += listOffsets[l + 1] - listOffsets[l];
+    }
+  }
+  candidatesScored = scored;
+
+  CandidateListType::Sort(candidateNeighbors, candidateDistances);
+
+  if (fullData == NULL)
+  {
+    neighbors = candidateNeighbors;
+    distances = candidateDistances;
+  }
+  else
+  {
+    // Re-rank the candidates with their exact squared distances.
+    neighbors.set_size(k, querySet.n_cols);
+    neighbors.fill(size_t() - 1);
+    distances.set_size(k, querySet.n_cols);
+    distances.fill(DBL_MAX);
+    CandidateListType results(neighbors, distances);
+
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+    {
+      for (size_t j = 0; j < candidateCount; ++j)
+      {
+        const size_t neighbor = candidateNeighbors(j, i);
+        if (neighbor == size_t() - 1)
+          break;
+
+        results.Insert(i, neighbor, arma::accu(arma::square(querySet.col(i) -
+            fullData->col(neighbor))));
+      }
+    }
+
+    CandidateListType::Sort(neighbors, distances);
+  }
+  Timer::Stop("ivf_pq/search");
+
+  // The distances were computed squared.
+  for (size_t i = 0; i < distances.n_elem; ++i)
+    if (distances[i] != DBL_MAX)
+      distances[i] = std::sqrt(distances[i]);
+
+  Log::Info << candidatesScored << " candidates scored for "
+      << querySet.n_cols << " query points (" << probedLists << " of "
+      << Lists() << " lists probed per query point)." << std::endl;
+}
+
+size_t IVFPQSearch::MemoryUsage() const
+{
+  size_t bytes = sizeof(*this) + mlpack::MemoryUsage(centroids) +
+      mlpack::MemoryUsage(codes) + mlpack::MemoryUsage(listOffsets) +
+      mlpack::MemoryUsage(listContents);
+
+  bytes += mlpack::MemoryUsage(codebooks);
+  for (size_t m = 0; m < codebooks.size(); ++m)
+    bytes += mlpack::MemoryUsage(codebooks[m]) - sizeof(arma::mat);
+
+  return bytes;
+}
+
+void IVFPQSearch::Encode(const arma::vec& residual, unsigned char* code) const
+{
+  for (size_t m = 0; m < codebooks.size(); ++m)
+    code[m] = (unsigned char) Nearest(codebooks[m],
+        residual.memptr() + SubspaceBegin(m));
+}
@@ -0,0 +1,190 @@
+/**
+ * @file ivf_pq_search.hpp
+ * @author Ryan Curtin
+ *
+ * Defines the IVFPQSearch class, which performs an approximate nearest
+ * neighbor search with an inverted file index whose points are compressed with
+ * product quantization.
+ *
+ * The details of this method can be found in the following paper:
+ *
+ * @article{jegou2011product,
+ *  title={Product quantization for nearest neighbor search},
+ *  author={J{\'e}gou, H. and Douze, M. and Schmid, C.},
+ *  journal={IEEE Transactions on Pattern Analysis and Machine Intelligence},
+ *  volume={33},
+ *  number={1},
+ *  pages={117--128},
+ *  year={2011}
+ * }
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_IVF_PQ_SEARCH_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_IVF_PQ_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+#include <vector>
+#include <string>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The IVFPQSearch class builds a compressed index of a reference set and uses
+ * it to compute approximate Euclidean nearest neighbors of query points.  The
+ * reference points are split into lists by a coarse quantizer (the centroids
+ * of k-means clustering), and the residual of each point from the centroid of
+ * its list is encoded by product quantization: the dimensions are split into
+ * subspaces, each with its own codebook of (at most 256) codewords found by
+ * k-means, so that each point is stored as one byte per subspace and the index
+ * of the point.  The reference set itself is not kept.
+ *
+ * A query point is searched in the lists whose centroids are nearest to it;
+ * for each list, a table of the squared distances from the residual of the
+ * query to each codeword of each subspace is built, and the approximate
+ * distance to a point is the sum of the table entries of its codes.  Since the
+ * returned distances are approximate, the best candidates can be re-ranked
+ * with their exact distances, if the full-precision data (for instance, a
+ * data::MappedMatrix of the reference set) is given to Search().
+ */
+class IVFPQSearch
+{
+ public:
+  /**
+   * Create an empty index; Train() must be called before Search().
+   */
+  IVFPQSearch();
+
+  /**
+   * Build the index on the given reference set; see Train().
+   */
+  IVFPQSearch(const arma::mat& referenceSet,
+              const size_t lists,
+              const size_t subspaces,
+              const size_t codewords = 256,
+              const size_t maxIterations = 100,
+              const size_t trainingPoints = 0);
+
+  /**
+   * Build the index on the given reference set.  The coarse quantizer and the
+   * codebooks are trained with k-means on a random sample of the reference
+   * set; then every reference point is assigned to its nearest list and
+   * encoded.  A std::invalid_argument is thrown if the parameters are not
+   * valid for the reference set.
+   *
+   * @param referenceSet Set of reference points.
+   * @param lists Number of lists (clusters of the coarse quantizer).
+   * @param subspaces Number of subspaces the dimensions are split into; this
+   *     is the number of bytes stored for each point.
+   * @param codewords Number of codewords of each subspace (at most 256).
+   * @param maxIterations Maximum number of iterations of each k-means
+   *     clustering.
+   * @param trainingPoints Number of points sampled to train the quantizers;
+   *     if 0, every reference point is used.
+   */
+  void Train(const arma::mat& referenceSet,
+             const size_t lists,
+             const size_t subspaces,
+             const size_t codewords = 256,
+             const size_t maxIterations = 100,
+             const size_t trainingPoints = 0);
+
+  /**
+   * For each point in the query set, compute the approximate nearest
+   * neighbors in the probed lists, and store them in the given matrices (k
+   * rows, one column per query point).  The distances are Euclidean distances
+   * computed from the codes, unless the candidates are re-ranked.  If fewer
+   * than k points are in the probed lists, the remaining neighbors are
+   * SIZE_MAX and their distances are DBL_MAX.
+   *
+   * @param querySet Set of query points.
+   * @param k Number of neighbors to search for.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   * @param probes Number of lists to search for each query point.
+   * @param fullData If not NULL, the full-precision reference set, used to
+   *     re-rank the candidates.
+   * @param rerank Number of candidates (by approximate distance) that are
+   *     re-ranked with their exact distances; it is taken to be at least k
+   *     when fullData is given.
+   */
+  void Search(const arma::mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances,
+              const size_t probes = 1,
+              const arma::mat* fullData = NULL,
+              const size_t rerank = 0);
+
+  //! Get the number of reference points in the index.
+  size_t ReferencePoints() const { return listContents.n_elem; }
+  //! Get the dimensionality of the reference points.
+  size_t Dimensionality() const { return centroids.n_rows; }
+  //! Get the number of lists.
+  size_t Lists() const { return centroids.n_cols; }
+  //! Get the number of subspaces.
+  size_t Subspaces() const { return codebooks.size(); }
+
+  //! Get the centroids of the coarse quantizer (one per column).
+  const arma::mat& Centroids() const { return centroids; }
+  //! Get the codebook of the given subspace (one codeword per column).
+  const arma::mat& Codebook(const size_t i) const { return codebooks[i]; }
+  //! Get the first dimension of the given subspace (SubspaceBegin(i + 1) is
+  //! one past its last dimension).
+  size_t SubspaceBegin(const size_t i) const
+  { return i * centroids.n_rows / codebooks.size(); }
+
+  //! Get the codes of the points (one column per point, in list order).
+  const arma::Mat<unsigned char>& Codes() const { return codes; }
+  //! Get the offsets of the lists in Codes() and ListContents(); list i holds
+  //! the points from ListOffsets()[i] to ListOffsets()[i + 1].
+  const arma::Col<size_t>& ListOffsets() const { return listOffsets; }
+  //! Get the indices of the points, in list order.
+  const arma::Col<arma::u32>& ListContents() const { return listContents; }
+
+  //! Get the number of candidates that were scored in the last search.
+  size_t CandidatesScored() const { return candidatesScored; }
+
+  //! Get the memory used by the index, in bytes.
+  size_t MemoryUsage() const;
+
+  /**
+   * Serialize the index.
+   */
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    using data::CreateNVP;
+
+    if (Archive::is_loading::value)
+      codebooks.clear();
+
+    ar & CreateNVP(centroids, "centroids");
+    ar & CreateNVP(codebooks, "codebooks");
+    ar & CreateNVP(codes, "codes");
+    ar & CreateNVP(listOffsets, "listOffsets");
+    ar & CreateNVP(listContents, "listContents");
+  }
+
+ private:
+  //! The centroids of the coarse quantizer.
+  arma::mat centroids;
+  //! The codebook of each subspace.
+  std::vector<arma::mat> codebooks;
+  //! The codes of the points, in list order.
+  arma::Mat<unsigned char> codes;
+  //! The offsets of the lists in codes and listContents.
+  arma::Col<size_t> listOffsets;
+  //! The indices of the points, in list order.
+  arma::Col<arma::u32> listContents;
+  //! The number of candidates scored in the last search.
+  size_t candidatesScored;
+
+  //! Encode the given residual into the given column of codes.
+  void Encode(const arma::vec& residual, unsigned char* code) const;
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
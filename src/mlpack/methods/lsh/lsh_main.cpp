@@ -41,7 +41,16 @@ PROGRAM_INFO("All K-Approximate-Nearest-Neighbor Search with LSH",
     "\n\n"
     "Because this is approximate-nearest-neighbors search, results may be "
     "different from run to run.  Thus, the --seed option can be specified to "
-    "set the random seed.");
+    "set the random seed."
+    "\n\n"
+    "The hash family is given by --hash_type: 'p-stable' (the default, for the "
+    "Euclidean distance), 'simhash' (sign random projections, for the angle "
+    "between points, which should then be normalized), or 'bit-sampling' (for "
+    "the Hamming distance between points with coordinates 0 or 1).  With "
+    "'simhash' and 'bit-sampling', each point also has a bit signature of its "
+    "keys in every table, and --max_hamming_distance discards the candidates "
+    "whose signature differs from that of the query in more bits before their "
+    "distances are computed.");
 
 // Define our input parameters that this program will take.
 PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
@@ -61,9 +70,62 @@ PARAM_DOUBLE("hash_width", "The hash width for the first-level hashing in the "
     "hash width for its use.", "H", 0.0);
 PARAM_INT("second_hash_size", "The size of the second level hash table.", "M",
     99901);
-PARAM_INT("bucket_size", "The size of a bucket in the second level hash.", "B",
-    500);
+PARAM_INT("bucket_size", "The size of a bucket in the second level hash (0 "
+    "for no limit).", "B", 500);
+PARAM_INT("probes", "Number of additional buckets to probe in each table "
+    "(multiprobe LSH).", "T", 0);
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
+PARAM_STRING("hash_type", "Hash family: 'p-stable', 'simhash', or "
+    "'bit-sampling'.", "t", "p-stable");
+PARAM_INT("max_hamming_distance", "If nonnegative, discard the candidates "
+    "whose signature differs from that of the query in more bits (only with "
+    "'simhash' and 'bit-sampling').", "D", -1);
+
+// Build the model with the given hash family, and search with it.
+template<typename HashType>
+void RunLSH(const arma::mat& referenceData,
+            const arma::mat& queryData,
+            const size_t k,
+            arma::Mat<size_t>& neighbors,
+            arma::mat& distances)
+{
+  // Pick up the LSH-specific parameters.
+  const size_t numProj = CLI::GetParam<int>("projections");
+  const size_t numTables = CLI::GetParam<int>("tables");
+  const double hashWidth = CLI::GetParam<double>("hash_width");
+  const size_t secondHashSize = CLI::GetParam<int>("second_hash_size");
+  const size_t bucketSize = CLI::GetParam<int>("bucket_size");
+  const int maxHamming = CLI::GetParam<int>("max_hamming_distance");
+  const size_t maxHammingDistance = (maxHamming < 0) ? size_t() - 1 :
+      (size_t) maxHamming;
+
+  if (hashWidth == 0.0)
+    Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
+        numTables << " tables (L) with default hash width." << endl;
+  else
+    Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
+        numTables << " tables (L) with hash width(r): " << hashWidth << endl;
+
+  Timer::Start("hash_building");
+
+  LSHSearch<NearestNeighborSort, HashType> allkann(referenceData, numProj,
+      numTables, hashWidth, secondHashSize, bucketSize);
+
+  Timer::Stop("hash_building");
+
+  Log::Info << "Computing " << k << " distance approximate nearest neighbors "
+      << endl;
+  const size_t numProbes = (size_t) CLI::GetParam<int>("probes");
+  if (CLI::HasParam("query_file"))
+    allkann.Search(queryData, k, neighbors, distances, 0, numProbes,
+        maxHammingDistance);
+  else
+    allkann.Search(k, neighbors, distances, 0, numProbes, maxHammingDistance);
+
+  Log::Info << "Neighbors computed." << endl;
+
+  Memory::Report("lsh_model", allkann.MemoryUsage());
+}
 
 int main(int argc, char *argv[])
 {
@@ -81,8 +143,20 @@ int main(int argc, char *argv[])
   string neighborsFile = CLI::GetParam<string>("neighbors_file");
 
   size_t k = CLI::GetParam<int>("k");
-  size_t secondHashSize = CLI::GetParam<int>("second_hash_size");
-  size_t bucketSize = CLI::GetParam<int>("bucket_size");
+  const string hashType = CLI::GetParam<string>("hash_type");
+
+  if (hashType != "p-stable" && hashType != "simhash" &&
+      hashType != "bit-sampling")
+  {
+    Log::Fatal << "Invalid hash type '" << hashType << "'; must be "
+        << "'p-stable', 'simhash', or 'bit-sampling'." << endl;
+  }
+
+  if (hashType == "p-stable" && CLI::GetParam<int>("max_hamming_distance") >= 0)
+  {
+    Log::Fatal << "--max_hamming_distance requires --hash_type 'simhash' or "
+        << "'bit-sampling'." << endl;
+  }
 
   arma::mat referenceData;
   arma::mat queryData; // So it doesn't go out of scope.
@@ -100,11 +174,6 @@ int main(int argc, char *argv[])
     Log::Fatal << referenceData.n_cols << ")." << endl;
   }
 
-  // Pick up the LSH-specific parameters.
-  const size_t numProj = CLI::GetParam<int>("projections");
-  const size_t numTables = CLI::GetParam<int>("tables");
-  const double hashWidth = CLI::GetParam<double>("hash_width");
-
   arma::Mat<size_t> neighbors;
   arma::mat distances;
 
@@ -117,30 +186,15 @@ int main(int argc, char *argv[])
               << queryData.n_rows << " x " << queryData.n_cols << ")." << endl;
   }
 
-  if (hashWidth == 0.0)
-    Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
-        numTables << " tables (L) with default hash width." << endl;
-  else
-    Log::Info << "Using LSH with " << numProj << " projections (K) and " <<
-        numTables << " tables (L) with hash width(r): " << hashWidth << endl;
-
-  Timer::Start("hash_building");
-
-  LSHSearch<>* allkann;
-
-  allkann = new LSHSearch<>(referenceData, numProj, numTables, hashWidth,
-                            secondHashSize, bucketSize);
-
-  Timer::Stop("hash_building");
-
-  Log::Info << "Computing " << k << " distance approximate nearest neighbors "
-      << endl;
-  if (CLI::HasParam("query_file"))
-    allkann->Search(queryData, k, neighbors, distances);
+  if (hashType == "p-stable")
+    RunLSH<PStableHash>(referenceData, queryData, k, neighbors, distances);
+  else if (hashType == "simhash")
+    RunLSH<SimHash>(referenceData, queryData, k, neighbors, distances);
   else
-    allkann->Search(k, neighbors, distances);
+    RunLSH<BitSamplingHash>(referenceData, queryData, k, neighbors, distances);
 
-  Log::Info << "Neighbors computed." << endl;
+  Memory::Report("neighbors", MemoryUsage(neighbors));
+  Memory::Report("distances", MemoryUsage(distances));
 
   // Save output.
   if (distancesFile != "")
@@ -148,6 +202,4 @@ int main(int argc, char *argv[])
 
   if (neighborsFile != "")
     data::Save(neighborsFile, neighbors);
-
-  delete allkann;
 }
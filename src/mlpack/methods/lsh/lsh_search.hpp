@@ -26,10 +26,15 @@
 #include <mlpack/core.hpp>
 #include <vector>
 #include <string>
+#include <cstdint>
 
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/methods/neighbor_search/sort_policies/nearest_neighbor_sort.hpp>
 
+#include "p_stable_hash.hpp"
+#include "sim_hash.hpp"
+#include "bit_sampling_hash.hpp"
+
 namespace mlpack {
 namespace neighbor {
 
@@ -38,9 +43,22 @@ namespace neighbor {
  * this hash to compute the distance-approximate nearest-neighbors of the given
  * queries.
  *
+ * The hash functions of the tables are given by the HashType policy: the
+ * default PStableHash is for the Euclidean distance, SimHash (sign random
+ * projections) is for the angle between points, and BitSamplingHash is for the
+ * Hamming distance between binary points.  With SimHash and BitSamplingHash,
+ * each key element is a bit, so the keys of every point in every table are
+ * also stored as a packed signature (64 bits to a word, each table starting a
+ * new word); Search() can then discard the candidates whose signature is too
+ * far (in Hamming distance, computed with popcount) from the signature of the
+ * query before computing the exact distance.  The exact distance is always
+ * the Euclidean distance.
+ *
  * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ * @tparam HashType The hash family of the tables; see PStableHash.
  */
-template<typename SortPolicy = NearestNeighborSort>
+template<typename SortPolicy = NearestNeighborSort,
+         typename HashType = PStableHash>
 class LSHSearch
 {
  public:
@@ -57,12 +75,14 @@ class LSHSearch
    * @param hashWidth The width of hash for every table. If 0 (the default) is
    *     provided, then the hash width is automatically obtained by computing
    *     the average pairwise distance of 25 pairs.  This should be a reasonable
-   *     upper bound on the nearest-neighbor distance in general.
+   *     upper bound on the nearest-neighbor distance in general.  Only
+   *     PStableHash uses the hash width.
    * @param secondHashSize The size of the second hash table. This should be a
    *     large prime number.
    * @param bucketSize The size of the bucket in the second hash table. This is
-   *     the maximum number of points that can be hashed into single bucket.
-   *     Default values are already provided here.
+   *     the maximum number of points that can be hashed into single bucket; if
+   *     it is 0, the buckets have no maximum size.  Default values are already
+   *     provided here.
    */
   LSHSearch(const arma::mat& referenceSet,
             const size_t numProj,
@@ -84,7 +104,9 @@ class LSHSearch
 
   /**
    * Train the LSH model on the given dataset.  This means building new hash
-   * tables.
+   * tables.  The parameters are the same as for the constructor.  Since the
+   * buckets hold 32-bit point indices, the dataset can have at most 2^32 - 1
+   * points; otherwise a std::invalid_argument is thrown.
    */
   void Train(const arma::mat& referenceSet,
              const size_t numProj,
@@ -93,6 +115,27 @@ class LSHSearch
              const size_t secondHashSize = 99901,
              const size_t bucketSize = 500);
 
+  /**
+   * Insert new points into the trained model.  The new points are hashed into
+   * the existing tables (with the existing projections, so the model is not
+   * retrained) and appended to the reference set, with indices following the
+   * existing points.  The model then holds its own copy of the reference set,
+   * so the dataset the model was trained on is not modified.
+   *
+   * @param newPoints Points to insert.
+   */
+  void Insert(const arma::mat& newPoints);
+
+  /**
+   * Remove the point with the given index from the model.  The point is only
+   * marked as removed (so the indices of the other points don't change), and
+   * it is never returned as a neighbor again.  The space it takes is freed
+   * only when the model is retrained.
+   *
+   * @param index Index of the point to remove.
+   */
+  void Remove(const size_t index);
+
   /**
    * Compute the nearest neighbors of the points in the given query set and
    * store the output in the given matrices.  The matrices will be set to the
@@ -111,12 +154,24 @@ class LSHSearch
    *     available without having to build hashing for every table size.
    *     By default, this is set to zero in which case all tables are
    *     considered.
+   * @param numProbes Number of additional buckets to probe in each table
+   *     (multiprobe LSH).  The additional buckets are the ones the query would
+   *     most likely have fallen into, so probing them finds more neighbor
+   *     candidates without needing more tables.  By default this is zero, and
+   *     only the bucket of the query is probed in each table.
+   * @param maxHammingDistance If given, the candidates whose signature differs
+   *     from the signature of the query in more than this many bits are
+   *     discarded without computing their distance.  This is only available
+   *     with hash families with binary keys (like SimHash); otherwise a
+   *     std::invalid_argument is thrown.
    */
   void Search(const arma::mat& querySet,
               const size_t k,
               arma::Mat<size_t>& resultingNeighbors,
               arma::mat& distances,
-              const size_t numTablesToSearch = 0);
+              const size_t numTablesToSearch = 0,
+              const size_t numProbes = 0,
+              const size_t maxHammingDistance = size_t() - 1);
 
   /**
    * Compute the nearest neighbors and store the output in the given matrices.
@@ -135,11 +190,19 @@ class LSHSearch
    *     available without having to build hashing for every table size.
    *     By default, this is set to zero in which case all tables are
    *     considered.
+   * @param numProbes Number of additional buckets to probe in each table
+   *     (multiprobe LSH).  By default this is zero, and only the bucket of the
+   *     query is probed in each table.
+   * @param maxHammingDistance If given, the candidates whose signature differs
+   *     from the signature of the query in more than this many bits are
+   *     discarded without computing their distance (only with binary keys).
    */
   void Search(const size_t k,
               arma::Mat<size_t>& resultingNeighbors,
               arma::mat& distances,
-              const size_t numTablesToSearch = 0);
+              const size_t numTablesToSearch = 0,
+              const size_t numProbes = 0,
+              const size_t maxHammingDistance = size_t() - 1);
 
   /**
    * Serialize the LSH model.
@@ -152,6 +215,12 @@ class LSHSearch
   //! Returns a string representation of this object.
   std::string ToString() const;
 
+  /**
+   * Get the memory used by the model (in bytes): the projections, the second
+   * hash table, and the reference set, if the model owns it.
+   */
+  size_t MemoryUsage() const;
+
   //! Return the number of distance evaluations performed.
   size_t DistanceEvaluations() const { return distanceEvaluations; }
   //! Modify the number of distance evaluations performed.
@@ -160,22 +229,53 @@ class LSHSearch
   //! Return the reference dataset.
   const arma::mat& ReferenceSet() const { return *referenceSet; }
 
+  //! Get whether or not each point of the reference set has been removed.
+  const std::vector<bool>& Removed() const { return removed; }
+
+  //! Get the hash functions of the tables.
+  const HashType& Hash() const { return hash; }
+
   //! Get the number of projections.
-  size_t NumProjections() const { return projections.size(); }
-  //! Get the projection matrix of the given table.
-  const arma::mat& Projection(const size_t i) const { return projections[i]; }
+  size_t NumProjections() const { return numTables; }
+  //! Get the projection matrix of the given table (only with PStableHash).
+  const arma::mat& Projection(const size_t i) const
+  { return hash.Projection(i); }
 
   //! Get the offsets 'b' for each of the projections.  (One 'b' per column.)
-  const arma::mat& Offsets() const { return offsets; }
+  //! (Only with PStableHash.)
+  const arma::mat& Offsets() const { return hash.Offsets(); }
+
+  //! Get the number of 64-bit words of the signature of each point (0 if the
+  //! hash family does not have binary keys).
+  size_t SignatureWords() const
+  { return HashType::BinaryKeys ? numTables * WordsPerTable() : 0; }
+  //! Get the signatures of the reference points; the signature of point i is
+  //! in the words from i * SignatureWords() to (i + 1) * SignatureWords() - 1,
+  //! and the bits of table t start at word t * ((NumProjections() + 63) / 64).
+  const std::vector<uint64_t>& Signatures() const { return signatures; }
+
+  /**
+   * Get the number of bits that differ between the two given signatures, each
+   * of the given number of words.  This uses the popcount instruction, if the
+   * compiler targets a processor that has one.
+   */
+  static size_t HammingDistance(const uint64_t* a,
+                                const uint64_t* b,
+                                const size_t words);
 
   //! Get the weights of the second hash.
   const arma::vec& SecondHashWeights() const { return secondHashWeights; }
 
-  //! Get the bucket size of the second hash.
+  //! Get the bucket size of the second hash (0 means no maximum size).
   size_t BucketSize() const { return bucketSize; }
 
-  //! Get the second hash table.
-  const arma::Mat<size_t>& SecondHashTable() const { return secondHashTable; }
+  //! Get the offset of each bucket of the second hash table in
+  //! BucketContents(); bucket i holds the points in [offsets[i],
+  //! offsets[i + 1]).
+  const arma::Col<size_t>& BucketOffsets() const { return bucketOffsets; }
+  //! Get the points in every bucket of the second hash table, bucket by
+  //! bucket.
+  const arma::Col<arma::u32>& BucketContents() const { return bucketContents; }
 
  private:
   /**
@@ -187,27 +287,128 @@ class LSHSearch
    * Then each key in this hash table is hashed into a second hash table using a
    * standard hash.
    *
-   * This function does not have any parameters and relies on parameters which
-   * are private members of this class, intialized during the class
-   * intialization.
+   * Apart from the hash width (which is given to the hash family), this
+   * function relies on parameters which are private members of this class,
+   * intialized during the class intialization.
+   *
+   * @param hashWidth The hash width given to Train().
    */
-  void BuildHash();
+  void BuildHash(const double hashWidth);
 
   /**
-   * This function takes a query and hashes it into each of the hash tables to
-   * get keys for the query and then the key is hashed to a bucket of the second
-   * hash table and all the points (if any) in those buckets are collected as
-   * the potential neighbor candidates.
+   * Hash the given points into every table.  This gives the bucket of the
+   * 'secondHashTable' that each point falls into in each table.
    *
-   * @param queryPoint The query point currently being processed.
+   * @param points Points to hash.
+   * @param pointBuckets Matrix to store the bucket of point i in table j in, as
+   *     element (i, j).
+   * @param pointSignatures Vector to store the signatures of the points in, if
+   *     the hash family has binary keys.
+   */
+  void HashPoints(const arma::mat& points,
+                  arma::Mat<arma::u32>& pointBuckets,
+                  std::vector<uint64_t>& pointSignatures) const;
+
+  //! Get the number of signature words of each table.
+  size_t WordsPerTable() const { return (numProj + 63) / 64; }
+
+  /**
+   * Pack the given binary keys of one point (one column per table) into the
+   * given signature.
+   */
+  void PackKeys(const arma::mat& keys, uint64_t* signature) const;
+
+  /**
+   * Add new points to the buckets of the 'secondHashTable', after the points
+   * already in them (unless the bucket is full).
+   *
+   * @param pointBuckets The bucket of each new point in each table, as given
+   *     by HashPoints().
+   * @param firstIndex The index of the first new point in the reference set.
+   */
+  void AddToBuckets(const arma::Mat<arma::u32>& pointBuckets,
+                    const size_t firstIndex);
+
+  /**
+   * Search for the neighbors of every point in the query set, once the output
+   * matrices have been initialized.  The query points are hashed into the
+   * tables a block at a time with one matrix product, and (with OpenMP) the
+   * blocks are searched in parallel.
+   *
+   * @param querySet Set of query points.
+   * @param sameSet Whether the query set is the reference set.
+   * @param resultingNeighbors Matrix storing lists of neighbors for each query
+   *     point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   * @param numTablesToSearch The number of tables to search (0 for all).
+   * @param numProbes The number of additional buckets to probe in each table.
+   * @param maxHammingDistance The largest Hamming distance of the signature of
+   *     a candidate to the signature of the query (size_t() - 1 for no
+   *     filtering).
+   */
+  void SearchQueries(const arma::mat& querySet,
+                     const bool sameSet,
+                     arma::Mat<size_t>& resultingNeighbors,
+                     arma::mat& distances,
+                     size_t numTablesToSearch,
+                     const size_t numProbes,
+                     const size_t maxHammingDistance);
+
+  /**
+   * This function takes the keys of a query in each of the hash tables, hashes
+   * each key to a bucket of the second hash table, and collects all the points
+   * (if any) in those buckets as the potential neighbor candidates.
+   *
+   * @param allProjInTables The projection of the query in each table to search
+   *    (one column per table), as given by the hash family.
    * @param referenceIndices The list of neighbor candidates obtained from
    *    hashing the query into all the hash tables and eventually into
-   *    multiple buckets of the second hash table.
+   *    multiple buckets of the second hash table, in increasing order.
+   * @param numProbes The number of additional buckets to probe in each table.
+   * @param considered Marks for the reference points which are candidates;
+   *    this must be all false (with one entry per reference point), and it is
+   *    all false again when the function returns.
    */
-  template<typename VecType>
-  void ReturnIndicesFromTable(const VecType& queryPoint,
+  void ReturnIndicesFromTable(const arma::mat& allProjInTables,
                               arma::uvec& referenceIndices,
-                              size_t numTablesToSearch) const;
+                              const size_t numProbes,
+                              std::vector<bool>& considered) const;
+
+  /**
+   * Find the keys of the additional buckets of one table to probe for
+   * multiprobe LSH, as presented in the following paper:
+   *
+   * @code
+   * @inproceedings{lv2007multi,
+   *   title={Multi-probe LSH: efficient indexing for high-dimensional
+   *       similarity search},
+   *   author={Lv, Q. and Josephson, W. and Wang, Z. and Charikar, M. and Li,
+   *       K.},
+   *   booktitle={Proceedings of the 33rd International Conference on Very
+   *       Large Data Bases (VLDB 2007)},
+   *   pages={950--961},
+   *   year={2007}
+   * }
+   * @endcode
+   *
+   * A bucket next to the bucket of the query is reached by moving the query
+   * across some of the boundaries of its bucket, and the cost of a set of moves
+   * is the sum of the costs of the moves given by the hash family (for
+   * PStableHash, the squared distances of the scaled projection of the query to
+   * those boundaries).  The sets of moves are generated in increasing order of
+   * cost, so the buckets the query most likely belongs to come first.
+   *
+   * @param projection The projection of the query in the table, as given by
+   *     the hash family.
+   * @param numProbes The number of additional buckets to find.
+   * @param probeKeys Matrix to store the keys of the additional buckets in (one
+   *     per column, in the order they should be probed).  This has fewer than
+   *     numProbes columns if there are not that many neighboring buckets.
+   */
+  void GetProbeKeys(const arma::vec& projection,
+                    const size_t numProbes,
+                    arma::mat& probeKeys) const;
 
   /**
    * This is a helper function that computes the distance of the query to the
@@ -274,14 +475,8 @@ class LSHSearch
   //! The number of hash tables.
   size_t numTables;
 
-  //! The std::vector containing the projection matrix of each table.
-  std::vector<arma::mat> projections; // should be [numProj x dims] x numTables
-
-  //! The list of the offsets 'b' for each of the projection for each table.
-  arma::mat offsets; // should be numProj x numTables
-
-  //! The hash width.
-  double hashWidth;
+  //! The hash functions of every table.
+  HashType hash;
 
   //! The big prime representing the size of the second hash.
   size_t secondHashSize;
@@ -289,19 +484,25 @@ class LSHSearch
   //! The weights of the second hash.
   arma::vec secondHashWeights;
 
-  //! The bucket size of the second hash.
+  //! The bucket size of the second hash (0 for no maximum size).
   size_t bucketSize;
 
-  //! The final hash table; should be (< secondHashSize) x bucketSize.
-  arma::Mat<size_t> secondHashTable;
+  //! The second hash table is held in compressed sparse row form: the points
+  //! of bucket i are bucketContents[bucketOffsets[i]] up to (but not
+  //! including) bucketContents[bucketOffsets[i + 1]].  Should be
+  //! secondHashSize + 1.
+  arma::Col<size_t> bucketOffsets;
+
+  //! The points in each bucket of the second hash table, stored contiguously
+  //! bucket by bucket.
+  arma::Col<arma::u32> bucketContents;
 
-  //! The number of elements present in each hash bucket; should be
-  //! secondHashSize.
-  arma::Col<size_t> bucketContentSize;
+  //! Whether or not each point of the reference set has been removed.
+  std::vector<bool> removed;
 
-  //! For a particular hash value, points to the row in secondHashTable
-  //! corresponding to this value.  Should be secondHashSize.
-  arma::Col<size_t> bucketRowInHashTable;
+  //! The packed signature of each point of the reference set, if the hash
+  //! family has binary keys.
+  std::vector<uint64_t> signatures;
 
   //! The number of distance evaluations.
   size_t distanceEvaluations;
@@ -9,12 +9,19 @@
 
 #include <mlpack/core.hpp>
 
+#include <queue>
+#include <bitset>
+
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace neighbor {
 
 // Construct the object.
-template<typename SortPolicy>
-LSHSearch<SortPolicy>::
+template<typename SortPolicy, typename HashType>
+LSHSearch<SortPolicy, HashType>::
 LSHSearch(const arma::mat& referenceSet,
           const size_t numProj,
           const size_t numTables,
@@ -25,7 +32,6 @@ LSHSearch(const arma::mat& referenceSet,
   ownsSet(false),
   numProj(numProj),
   numTables(numTables),
-  hashWidth(hashWidthIn),
   secondHashSize(secondHashSize),
   bucketSize(bucketSize),
   distanceEvaluations(0)
@@ -36,13 +42,12 @@ LSHSearch(const arma::mat& referenceSet,
 }
 
 // Empty constructor.
-template<typename SortPolicy>
-LSHSearch<SortPolicy>::LSHSearch() :
+template<typename SortPolicy, typename HashType>
+LSHSearch<SortPolicy, HashType>::LSHSearch() :
     referenceSet(new arma::mat()), // empty dataset
     ownsSet(true),
     numProj(0),
     numTables(0),
-    hashWidth(0),
     secondHashSize(99901),
     bucketSize(500),
     distanceEvaluations(0)
@@ -51,22 +56,40 @@ LSHSearch<SortPolicy>::LSHSearch() :
 }
 
 // Destructor.
-template<typename SortPolicy>
-LSHSearch<SortPolicy>::~LSHSearch()
+template<typename SortPolicy, typename HashType>
+LSHSearch<SortPolicy, HashType>::~LSHSearch()
 {
   if (ownsSet)
     delete referenceSet;
 }
 
 // Train on a new reference set.
-template<typename SortPolicy>
-void LSHSearch<SortPolicy>::Train(const arma::mat& referenceSet,
-                                  const size_t numProj,
-                                  const size_t numTables,
-                                  const double hashWidthIn,
-                                  const size_t secondHashSize,
-                                  const size_t bucketSize)
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::Train(const arma::mat& referenceSet,
+                                            const size_t numProj,
+                                            const size_t numTables,
+                                            const double hashWidthIn,
+                                            const size_t secondHashSize,
+                                            const size_t bucketSize)
 {
+  if (referenceSet.n_cols > (size_t) std::numeric_limits<arma::u32>::max())
+  {
+    std::ostringstream oss;
+    oss << "LSHSearch::Train(): reference set has " << referenceSet.n_cols
+        << " points, but at most " << std::numeric_limits<arma::u32>::max()
+        << " are supported!" << std::endl;
+    throw std::invalid_argument(oss.str());
+  }
+
+  if (secondHashSize > (size_t) std::numeric_limits<arma::u32>::max())
+  {
+    std::ostringstream oss;
+    oss << "LSHSearch::Train(): second hash size (" << secondHashSize
+        << ") must be at most " << std::numeric_limits<arma::u32>::max()
+        << "!" << std::endl;
+    throw std::invalid_argument(oss.str());
+  }
+
   // Set new reference set.
   if (this->referenceSet && ownsSet)
     delete this->referenceSet;
@@ -76,37 +99,20 @@ void LSHSearch<SortPolicy>::Train(const arma::mat& referenceSet,
   // Set new parameters.
   this->numProj = numProj;
   this->numTables = numTables;
-  this->hashWidth = hashWidthIn;
   this->secondHashSize = secondHashSize;
   this->bucketSize = bucketSize;
 
-  if (hashWidth == 0.0) // The user has not provided any value.
-  {
-    // Compute a heuristic hash width from the data.
-    for (size_t i = 0; i < 25; i++)
-    {
-      size_t p1 = (size_t) math::RandInt(referenceSet.n_cols);
-      size_t p2 = (size_t) math::RandInt(referenceSet.n_cols);
-
-      hashWidth += std::sqrt(metric::EuclideanDistance::Evaluate(
-          referenceSet.unsafe_col(p1), referenceSet.unsafe_col(p2)));
-    }
-
-    hashWidth /= 25;
-  }
-
-  Log::Info << "Hash width chosen as: " << hashWidth << std::endl;
-
-  BuildHash();
+  BuildHash(hashWidthIn);
 }
 
-template<typename SortPolicy>
-void LSHSearch<SortPolicy>::InsertNeighbor(arma::mat& distances,
-                                           arma::Mat<size_t>& neighbors,
-                                           const size_t queryIndex,
-                                           const size_t pos,
-                                           const size_t neighbor,
-                                           const double distance) const
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::InsertNeighbor(
+    arma::mat& distances,
+    arma::Mat<size_t>& neighbors,
+    const size_t queryIndex,
+    const size_t pos,
+    const size_t neighbor,
+    const double distance) const
 {
   // We only memmove() if there is actually a need to shift something.
   if (pos < (distances.n_rows - 1))
@@ -127,12 +133,12 @@ void LSHSearch<SortPolicy>::InsertNeighbor(arma::mat& distances,
 
 // Base case where the query set is the reference set.  (So, we can't return
 // ourselves as the nearest neighbor.)
-template<typename SortPolicy>
+template<typename SortPolicy, typename HashType>
 inline force_inline
-void LSHSearch<SortPolicy>::BaseCase(const size_t queryIndex,
-                                     const size_t referenceIndex,
-                                     arma::Mat<size_t>& neighbors,
-                                     arma::mat& distances) const
+void LSHSearch<SortPolicy, HashType>::BaseCase(const size_t queryIndex,
+                                               const size_t referenceIndex,
+                                               arma::Mat<size_t>& neighbors,
+                                               arma::mat& distances) const
 {
   // If the points are the same, we can't continue.
   if (queryIndex == referenceIndex)
@@ -156,13 +162,13 @@ void LSHSearch<SortPolicy>::BaseCase(const size_t queryIndex,
 }
 
 // Base case for bichromatic search.
-template<typename SortPolicy>
+template<typename SortPolicy, typename HashType>
 inline force_inline
-void LSHSearch<SortPolicy>::BaseCase(const size_t queryIndex,
-                                     const size_t referenceIndex,
-                                     const arma::mat& querySet,
-                                     arma::Mat<size_t>& neighbors,
-                                     arma::mat& distances) const
+void LSHSearch<SortPolicy, HashType>::BaseCase(const size_t queryIndex,
+                                               const size_t referenceIndex,
+                                               const arma::mat& querySet,
+                                               arma::Mat<size_t>& neighbors,
+                                               arma::mat& distances) const
 {
   const double distance = metric::EuclideanDistance::Evaluate(
       querySet.unsafe_col(queryIndex),
@@ -181,74 +187,155 @@ void LSHSearch<SortPolicy>::BaseCase(const size_t queryIndex,
         referenceIndex, distance);
 }
 
-template<typename SortPolicy>
-template<typename VecType>
-void LSHSearch<SortPolicy>::ReturnIndicesFromTable(
-    const VecType& queryPoint,
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::ReturnIndicesFromTable(
+    const arma::mat& allProjInTables,
     arma::uvec& referenceIndices,
-    size_t numTablesToSearch) const
+    const size_t numProbes,
+    std::vector<bool>& considered) const
 {
-  // Decide on the number of tables to look into.
-  if (numTablesToSearch == 0) // If no user input is given, search all.
-    numTablesToSearch = numTables;
-
-  // Sanity check to make sure that the existing number of tables is not
-  // exceeded.
-  if (numTablesToSearch > numTables)
-    numTablesToSearch = numTables;
-
-  // Hash the query in each of the 'numTablesToSearch' hash tables using the
-  // 'numProj' projections for each table. This gives us 'numTablesToSearch'
-  // keys for the query where each key is a 'numProj' dimensional integer
-  // vector.
-
-  // Compute the projection of the query in each table.
-  arma::mat allProjInTables(numProj, numTablesToSearch);
-  for (size_t i = 0; i < numTablesToSearch; i++)
-    allProjInTables.unsafe_col(i) = projections[i].t() * queryPoint;
-  allProjInTables += offsets.cols(0, numTablesToSearch - 1);
-  allProjInTables /= hashWidth;
+  const size_t numTablesToSearch = allProjInTables.n_cols;
 
   // Compute the hash value of each key of the query into a bucket of the
   // 'secondHashTable' using the 'secondHashWeights'.
-  arma::rowvec hashVec = secondHashWeights.t() * arma::floor(allProjInTables);
+  arma::rowvec hashVec = secondHashWeights.t() * hash.Keys(allProjInTables);
 
   for (size_t i = 0; i < hashVec.n_elem; i++)
     hashVec[i] = (double) ((size_t) hashVec[i] % secondHashSize);
 
   Log::Assert(hashVec.n_elem == numTablesToSearch);
 
+  std::vector<size_t> bucketHashes(hashVec.n_elem);
+  for (size_t i = 0; i < hashVec.n_elem; i++)
+    bucketHashes[i] = (size_t) hashVec[i];
+
+  // For multiprobe LSH, also probe the buckets of each table that the query
+  // most likely belongs to, after its own.
+  if (numProbes > 0)
+  {
+    for (size_t i = 0; i < numTablesToSearch; i++)
+    {
+      arma::mat probeKeys;
+      GetProbeKeys(allProjInTables.unsafe_col(i), numProbes, probeKeys);
+
+      const arma::rowvec probeHashVec = secondHashWeights.t() * probeKeys;
+      for (size_t j = 0; j < probeHashVec.n_elem; j++)
+        bucketHashes.push_back((size_t) probeHashVec[j] % secondHashSize);
+    }
+  }
+
   // For all the buckets that the query is hashed into, sequentially
-  // collect the indices in those buckets.
-  arma::Col<size_t> refPointsConsidered;
-  refPointsConsidered.zeros(referenceSet->n_cols);
+  // collect the distinct indices in those buckets.
+  std::vector<size_t> candidates;
+  for (size_t i = 0; i < bucketHashes.size(); i++) // For all buckets.
+  {
+    // Pick the indices in the bucket corresponding to 'hashInd'.
+    const size_t hashInd = bucketHashes[i];
+    for (size_t j = bucketOffsets[hashInd]; j < bucketOffsets[hashInd + 1]; j++)
+    {
+      const size_t index = bucketContents[j];
+      if (!considered[index] && !removed[index])
+      {
+        considered[index] = true;
+        candidates.push_back(index);
+      }
+    }
+  }
 
-  for (size_t i = 0; i < hashVec.n_elem; i++) // For all tables.
+  // Reset the marks for the next query, and return the candidates in
+  // increasing order.
+  referenceIndices.set_size(candidates.size());
+  for (size_t i = 0; i < candidates.size(); i++)
   {
-    size_t hashInd = (size_t) hashVec[i];
+    considered[candidates[i]] = false;
+    referenceIndices[i] = candidates[i];
+  }
+  referenceIndices = arma::sort(referenceIndices);
+}
+
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::GetProbeKeys(const arma::vec& projection,
+                                                   const size_t numProbes,
+                                                   arma::mat& probeKeys) const
+{
+  const arma::vec key = hash.Keys(projection);
+
+  // Move j changes element (j % numProj) of the key by steps[j], at cost
+  // costs[j]; for PStableHash, move j (for j < numProj) takes the query across
+  // the lower boundary of its bucket in dimension j, and move j + numProj
+  // takes it across the upper boundary.
+  arma::vec costs, steps;
+  hash.ProbeMoves(projection, key, costs, steps);
+  const size_t numMoves = costs.n_elem;
+  const arma::uvec order = arma::sort_index(costs);
+
+  // A set of moves is held as the sorted positions of its moves in 'order',
+  // along with its total cost.  Every set is reached from the set {0} by
+  // replacing its last move with the next one (a shift) or by adding the next
+  // move (an expansion), and neither can make the cost smaller, so taking the
+  // sets from a heap gives them in increasing order of cost.
+  typedef std::pair<double, std::vector<size_t>> MoveSet;
+  std::priority_queue<MoveSet, std::vector<MoveSet>, std::greater<MoveSet>>
+      heap;
+  heap.push(MoveSet(costs[order[0]], std::vector<size_t>(1, 0)));
+
+  probeKeys.set_size(numProj, numProbes);
+  size_t numFound = 0;
+  std::vector<bool> moved(numProj);
+  while (numFound < numProbes && !heap.empty())
+  {
+    const MoveSet moveSet = heap.top();
+    heap.pop();
 
-    if (bucketContentSize[hashInd] > 0)
+    const size_t last = moveSet.second.back();
+    if (last + 1 < numMoves)
     {
-      // Pick the indices in the bucket corresponding to 'hashInd'.
-      size_t tableRow = bucketRowInHashTable[hashInd];
-      assert(tableRow < secondHashSize);
-      assert(tableRow < secondHashTable.n_rows);
+      MoveSet shift(moveSet);
+      shift.second.back() = last + 1;
+      shift.first += costs[order[last + 1]] - costs[order[last]];
+      heap.push(shift);
+
+      MoveSet expansion(moveSet);
+      expansion.second.push_back(last + 1);
+      expansion.first += costs[order[last + 1]];
+      heap.push(expansion);
+    }
 
-      for (size_t j = 0; j < bucketContentSize[hashInd]; j++)
-        refPointsConsidered[secondHashTable(tableRow, j)]++;
+    // The query can't cross both boundaries of a dimension at once.
+    std::fill(moved.begin(), moved.end(), false);
+    bool valid = true;
+    for (size_t i = 0; i < moveSet.second.size() && valid; ++i)
+    {
+      const size_t dim = order[moveSet.second[i]] % numProj;
+      valid = !moved[dim];
+      moved[dim] = true;
+    }
+
+    if (!valid)
+      continue;
+
+    probeKeys.col(numFound) = key;
+    for (size_t i = 0; i < moveSet.second.size(); ++i)
+    {
+      const size_t move = order[moveSet.second[i]];
+      probeKeys(move % numProj, numFound) += steps[move];
     }
+    ++numFound;
   }
 
-  referenceIndices = arma::find(refPointsConsidered > 0);
+  probeKeys.resize(numProj, numFound);
 }
 
 // Search for nearest neighbors in a given query set.
-template<typename SortPolicy>
-void LSHSearch<SortPolicy>::Search(const arma::mat& querySet,
-                                   const size_t k,
-                                   arma::Mat<size_t>& resultingNeighbors,
-                                   arma::mat& distances,
-                                   const size_t numTablesToSearch)
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::Search(
+    const arma::mat& querySet,
+    const size_t k,
+    arma::Mat<size_t>& resultingNeighbors,
+    arma::mat& distances,
+    const size_t numTablesToSearch,
+    const size_t numProbes,
+    const size_t maxHammingDistance)
 {
   // Ensure the dimensionality of the query set is correct.
   if (querySet.n_rows != referenceSet->n_rows)
@@ -269,6 +356,12 @@ void LSHSearch<SortPolicy>::Search(const arma::mat& querySet,
     throw std::invalid_argument(oss.str());
   }
 
+  if (maxHammingDistance != size_t() - 1 && !HashType::BinaryKeys)
+  {
+    throw std::invalid_argument("LSHSearch::Search(): filtering by Hamming "
+        "distance requires a hash family with binary keys!");
+  }
+
   // Set the size of the neighbor and distance matrices.
   resultingNeighbors.set_size(k, querySet.n_cols);
   distances.set_size(k, querySet.n_cols);
@@ -279,83 +372,183 @@ void LSHSearch<SortPolicy>::Search(const arma::mat& querySet,
   if (k == 0)
     return;
 
-  size_t avgIndicesReturned = 0;
-
   Timer::Start("computing_neighbors");
 
-  // Go through every query point sequentially.
-  for (size_t i = 0; i < querySet.n_cols; i++)
-  {
-    // Hash every query into every hash table and eventually into the
-    // 'secondHashTable' to obtain the neighbor candidates.
-    arma::uvec refIndices;
-    ReturnIndicesFromTable(querySet.col(i), refIndices, numTablesToSearch);
-
-    // An informative book-keeping for the number of neighbor candidates
-    // returned on average.
-    avgIndicesReturned += refIndices.n_elem;
-
-    // Sequentially go through all the candidates and save the best 'k'
-    // candidates.
-    for (size_t j = 0; j < refIndices.n_elem; j++)
-      BaseCase(i, (size_t) refIndices[j], querySet, resultingNeighbors,
-          distances);
-  }
+  SearchQueries(querySet, false, resultingNeighbors, distances,
+      numTablesToSearch, numProbes, maxHammingDistance);
 
   Timer::Stop("computing_neighbors");
-
-  distanceEvaluations += avgIndicesReturned;
-  avgIndicesReturned /= querySet.n_cols;
-  Log::Info << avgIndicesReturned << " distinct indices returned on average." <<
-      std::endl;
 }
 
 // Search for approximate neighbors of the reference set.
-template<typename SortPolicy>
-void LSHSearch<SortPolicy>::
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::
 Search(const size_t k,
        arma::Mat<size_t>& resultingNeighbors,
        arma::mat& distances,
-       const size_t numTablesToSearch)
+       const size_t numTablesToSearch,
+       const size_t numProbes,
+       const size_t maxHammingDistance)
 {
+  if (maxHammingDistance != size_t() - 1 && !HashType::BinaryKeys)
+  {
+    throw std::invalid_argument("LSHSearch::Search(): filtering by Hamming "
+        "distance requires a hash family with binary keys!");
+  }
+
   // This is monochromatic search; the query set is the reference set.
   resultingNeighbors.set_size(k, referenceSet->n_cols);
   distances.set_size(k, referenceSet->n_cols);
   distances.fill(SortPolicy::WorstDistance());
   resultingNeighbors.fill(referenceSet->n_cols);
 
-  size_t avgIndicesReturned = 0;
-
   Timer::Start("computing_neighbors");
 
-  // Go through every query point sequentially.
-  for (size_t i = 0; i < referenceSet->n_cols; i++)
-  {
-    // Hash every query into every hash table and eventually into the
-    // 'secondHashTable' to obtain the neighbor candidates.
-    arma::uvec refIndices;
-    ReturnIndicesFromTable(referenceSet->col(i), refIndices, numTablesToSearch);
-
-    // An informative book-keeping for the number of neighbor candidates
-    // returned on average.
-    avgIndicesReturned += refIndices.n_elem;
-
-    // Sequentially go through all the candidates and save the best 'k'
-    // candidates.
-    for (size_t j = 0; j < refIndices.n_elem; j++)
-      BaseCase(i, (size_t) refIndices[j], resultingNeighbors, distances);
-  }
+  SearchQueries(*referenceSet, true, resultingNeighbors, distances,
+      numTablesToSearch, numProbes, maxHammingDistance);
 
   Timer::Stop("computing_neighbors");
+}
+
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::SearchQueries(
+    const arma::mat& querySet,
+    const bool sameSet,
+    arma::Mat<size_t>& resultingNeighbors,
+    arma::mat& distances,
+    size_t numTablesToSearch,
+    const size_t numProbes,
+    const size_t maxHammingDistance)
+{
+  // Decide on the number of tables to look into.
+  if (numTablesToSearch == 0) // If no user input is given, search all.
+    numTablesToSearch = numTables;
+
+  // Sanity check to make sure that the existing number of tables is not
+  // exceeded.
+  if (numTablesToSearch > numTables)
+    numTablesToSearch = numTables;
+
+  if (querySet.n_cols == 0 || numTablesToSearch == 0)
+    return;
+
+  // The signature of a query covers every table, so every table is projected
+  // if the candidates are filtered.
+  const bool filter = (maxHammingDistance != size_t() - 1);
+  const size_t projectedTables = filter ? numTables : numTablesToSearch;
+  const size_t words = SignatureWords();
+
+  const size_t blockSize = 256;
+  const size_t numBlocks = (querySet.n_cols + blockSize - 1) / blockSize;
+  size_t avgIndicesReturned = 0;
+  size_t numFiltered = 0;
+
+  // The queries are independent, so the blocks are searched in parallel; each
+  // thread keeps its own marks of the neighbor candidates of a query.
+  #pragma omp parallel reduction(+:avgIndicesReturned, numFiltered)
+  {
+    std::vector<bool> considered(referenceSet->n_cols, false);
+    std::vector<uint64_t> querySignature(words);
+
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t b = 0; b < numBlocks; b++)
+    {
+      const size_t begin = b * blockSize;
+      const size_t end = std::min(begin + blockSize, (size_t) querySet.n_cols);
+
+      // Hash every query of the block into every hash table, with a single
+      // matrix product for PStableHash.  Column j of the result, viewed as a
+      // ('numProj' x 'projectedTables') matrix, holds the projection of query
+      // j in each table.
+      arma::mat blockProj;
+      hash.ProjectAll(querySet.cols(begin, end - 1), projectedTables,
+          blockProj);
+
+      for (size_t i = begin; i < end; i++)
+      {
+        // Hash the query into the 'secondHashTable' to obtain the neighbor
+        // candidates.
+        const arma::mat allProjInTables(blockProj.colptr(i - begin), numProj,
+            numTablesToSearch, false, true);
+        arma::uvec refIndices;
+        ReturnIndicesFromTable(allProjInTables, refIndices, numProbes,
+            considered);
+
+        // An informative book-keeping for the number of neighbor candidates
+        // returned on average.
+        avgIndicesReturned += refIndices.n_elem;
+
+        if (filter)
+        {
+          const arma::mat allProj(blockProj.colptr(i - begin), numProj,
+              numTables, false, true);
+          PackKeys(hash.Keys(allProj), &querySignature[0]);
+        }
+
+        // Sequentially go through all the candidates and save the best 'k'
+        // candidates.
+        for (size_t j = 0; j < refIndices.n_elem; j++)
+        {
+          // Candidates with distant signatures are discarded first.
+          if (filter && HammingDistance(&querySignature[0],
+              &signatures[refIndices[j] * words], words) > maxHammingDistance)
+          {
+            ++numFiltered;
+            continue;
+          }
+
+          if (sameSet)
+            BaseCase(i, (size_t) refIndices[j], resultingNeighbors, distances);
+          else
+            BaseCase(i, (size_t) refIndices[j], querySet, resultingNeighbors,
+                distances);
+        }
+      }
+    }
+  }
 
-  distanceEvaluations += avgIndicesReturned;
-  avgIndicesReturned /= referenceSet->n_cols;
+  distanceEvaluations += avgIndicesReturned - numFiltered;
+  avgIndicesReturned /= querySet.n_cols;
   Log::Info << avgIndicesReturned << " distinct indices returned on average." <<
       std::endl;
+  if (filter)
+    Log::Info << numFiltered << " candidates discarded by Hamming distance."
+        << std::endl;
 }
 
-template<typename SortPolicy>
-void LSHSearch<SortPolicy>::BuildHash()
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::PackKeys(const arma::mat& keys,
+                                               uint64_t* signature) const
+{
+  const size_t wordsPerTable = WordsPerTable();
+  std::fill(signature, signature + keys.n_cols * wordsPerTable, 0);
+  for (size_t t = 0; t < keys.n_cols; ++t)
+    for (size_t j = 0; j < keys.n_rows; ++j)
+      if (keys(j, t) != 0.0)
+        signature[t * wordsPerTable + j / 64] |= (uint64_t(1) << (j % 64));
+}
+
+template<typename SortPolicy, typename HashType>
+inline force_inline
+size_t LSHSearch<SortPolicy, HashType>::HammingDistance(const uint64_t* a,
+                                                        const uint64_t* b,
+                                                        const size_t words)
+{
+  size_t distance = 0;
+  for (size_t i = 0; i < words; ++i)
+  {
+#ifdef __GNUC__
+    distance += (size_t) __builtin_popcountll(a[i] ^ b[i]);
+#else
+    distance += std::bitset<64>(a[i] ^ b[i]).count();
+#endif
+  }
+
+  return distance;
+}
+
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::BuildHash(const double hashWidth)
 {
   // The first level hash for a single table outputs a 'numProj'-dimensional
   // integer key for each point in the set -- (key, pointID)
@@ -378,129 +571,197 @@ void LSHSearch<SortPolicy>::BuildHash()
   secondHashWeights = arma::floor(arma::randu(numProj) *
                                   (double) secondHashSize);
 
-  // The 'secondHashTable' is initially an empty matrix of size
-  // ('secondHashSize' x 'bucketSize'). But by only filling the buckets
-  // as points land in them allows us to shrink the size of the
-  // 'secondHashTable' at the end of the hashing.
-
-  // Fill the second hash table n = referenceSet.n_cols.  This is because no
-  // point has index 'n' so the presence of this in the bucket denotes that
-  // there are no more points in this bucket.
-  secondHashTable.set_size(secondHashSize, bucketSize);
-  secondHashTable.fill(referenceSet->n_cols);
-
-  // Keep track of the size of each bucket in the hash.  At the end of hashing
-  // most buckets will be empty.
-  bucketContentSize.zeros(secondHashSize);
-
-  // Instead of putting the points in the row corresponding to the bucket, we
-  // chose the next empty row and keep track of the row in which the bucket
-  // lies. This allows us to stack together and slice out the empty buckets at
-  // the end of the hashing.
-  bucketRowInHashTable.set_size(secondHashSize);
-  bucketRowInHashTable.fill(secondHashSize);
-
-  // Keep track of number of non-empty rows in the 'secondHashTable'.
-  size_t numRowsInTable = 0;
-
-  // Step II: The offsets for all projections in all tables.
-  // Since the 'offsets' are in [0, hashWidth], we obtain the 'offsets'
-  // as randu(numProj, numTables) * hashWidth.
-  offsets.randu(numProj, numTables);
-  offsets *= hashWidth;
-
-  // Step III: Create each hash table in the first level hash one by one and
-  // putting them directly into the 'secondHashTable' for memory efficiency.
-  projections.clear(); // Reset projections vector.
+  // Step II: Draw the hash functions of every table (for PStableHash, the
+  // offsets and then the projections).  These are drawn before any table is
+  // built, so the tables don't depend on the number of threads.
+  hash.Train(*referenceSet, numProj, numTables, hashWidth);
+
+  // Step III: Hash every point into every table, and put the points in the
+  // (initially empty) buckets of the 'secondHashTable'.
+  arma::Mat<arma::u32> pointBuckets;
+  HashPoints(*referenceSet, pointBuckets, signatures);
+
+  bucketOffsets.zeros(secondHashSize + 1);
+  bucketContents.reset();
+  AddToBuckets(pointBuckets, 0);
+
+  removed.assign(referenceSet->n_cols, false);
+}
+
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::HashPoints(
+    const arma::mat& points,
+    arma::Mat<arma::u32>& pointBuckets,
+    std::vector<uint64_t>& pointSignatures) const
+{
+  pointBuckets.set_size(points.n_cols, numTables);
+
+  // Each table has its own words in the signatures, so the tables can fill
+  // them in parallel.
+  const size_t words = SignatureWords();
+  const size_t wordsPerTable = WordsPerTable();
+  pointSignatures.assign(points.n_cols * words, 0);
+
+  // Only the bucket of each point in the 'secondHashTable' is kept, for memory
+  // efficiency.  The tables are independent, so they are hashed in parallel.
+  #pragma omp parallel for schedule(dynamic, 1)
   for (size_t i = 0; i < numTables; i++)
   {
-    // Step IV: Obtain the 'numProj' projections for each table.
-
-    // For L2 metric, 2-stable distributions are used, and
-    // the normal Z ~ N(0, 1) is a 2-stable distribution.
-    arma::mat projMat;
-    projMat.randn(referenceSet->n_rows, numProj);
-
-    // Save the projection matrix for querying.
-    projections.push_back(projMat);
-
-    // Step V: create the 'numProj'-dimensional key for each point in each
-    // table.
-
-    // The following code performs the task of hashing each point to a
-    // 'numProj'-dimensional integer key.  Hence you get a ('numProj' x
-    // 'referenceSet.n_cols') key matrix.
-    //
-    // For a single table, let the 'numProj' projections be denoted by 'proj_i'
-    // and the corresponding offset be 'offset_i'.  Then the key of a single
-    // point is obtained as:
-    // key = { floor( (<proj_i, point> + offset_i) / 'hashWidth' ) forall i }
-    arma::mat offsetMat = arma::repmat(offsets.unsafe_col(i), 1,
-                                       referenceSet->n_cols);
-    arma::mat hashMat = projMat.t() * (*referenceSet);
-    hashMat += offsetMat;
-    hashMat /= hashWidth;
-
-    // Step VI: Putting the points in the 'secondHashTable' by hashing the key.
-    // Now we hash every key, point ID to its corresponding bucket.
-    arma::rowvec secondHashVec = secondHashWeights.t() * arma::floor(hashMat);
+    // Create the 'numProj'-dimensional key for each point in each table.
+    // Hence you get a ('numProj' x 'points.n_cols') key matrix.
+    arma::mat hashMat;
+    hash.Project(points, i, hashMat);
+    const arma::mat keys = hash.Keys(hashMat);
+
+    if (HashType::BinaryKeys)
+    {
+      for (size_t j = 0; j < points.n_cols; j++)
+        for (size_t p = 0; p < numProj; p++)
+          if (keys(p, j) != 0.0)
+            pointSignatures[j * words + i * wordsPerTable + p / 64] |=
+                (uint64_t(1) << (p % 64));
+    }
+
+    // Now we hash every key, point ID to its corresponding bucket in the
+    // 'secondHashTable'.
+    arma::rowvec secondHashVec = secondHashWeights.t() * keys;
+
+    Log::Assert(secondHashVec.n_elem == points.n_cols);
 
     // This gives us the bucket for the corresponding point ID.
     for (size_t j = 0; j < secondHashVec.n_elem; j++)
-      secondHashVec[j] = (double)((size_t) secondHashVec[j] % secondHashSize);
+      pointBuckets(j, i) = (arma::u32) ((size_t) secondHashVec[j] %
+          secondHashSize);
+  } // Loop over tables.
+}
 
-    Log::Assert(secondHashVec.n_elem == referenceSet->n_cols);
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::AddToBuckets(
+    const arma::Mat<arma::u32>& pointBuckets,
+    const size_t firstIndex)
+{
+  // The buckets are stored contiguously, so the size of each bucket has to be
+  // known before any points are put in it.  First count the points in each
+  // bucket, including the new ones unless the bucket is full.
+  // 'newOffsets[i + 1]' holds the size of bucket i until the sizes are summed
+  // into offsets.
+  arma::Col<size_t> newOffsets(secondHashSize + 1);
+  newOffsets[0] = 0;
+  for (size_t i = 0; i < secondHashSize; i++)
+    newOffsets[i + 1] = bucketOffsets[i + 1] - bucketOffsets[i];
+
+  for (size_t i = 0; i < pointBuckets.n_elem; i++)
+  {
+    const size_t hashInd = pointBuckets[i];
+    if (bucketSize == 0 || newOffsets[hashInd + 1] < bucketSize)
+      newOffsets[hashInd + 1]++;
+  }
 
-    // Insert the point in the corresponding row to its bucket in the
-    // 'secondHashTable'.
-    for (size_t j = 0; j < secondHashVec.n_elem; j++)
+  size_t numNonEmptyBuckets = 0;
+  size_t maxBucketSize = 0;
+  for (size_t i = 0; i < secondHashSize; i++)
+  {
+    if (newOffsets[i + 1] > 0)
+      numNonEmptyBuckets++;
+    if (newOffsets[i + 1] > maxBucketSize)
+      maxBucketSize = newOffsets[i + 1];
+
+    newOffsets[i + 1] += newOffsets[i];
+  }
+
+  // Then copy the points already in each bucket, and insert each new point in
+  // its bucket in each table (in the same order as they were counted, so that
+  // full buckets keep the same points).
+  arma::Col<arma::u32> newContents(newOffsets[secondHashSize]);
+  arma::Col<size_t> bucketFill(newOffsets.memptr(), secondHashSize);
+  for (size_t i = 0; i < secondHashSize; i++)
+    for (size_t j = bucketOffsets[i]; j < bucketOffsets[i + 1]; j++)
+      newContents[bucketFill[i]++] = bucketContents[j];
+
+  for (size_t i = 0; i < pointBuckets.n_cols; i++)
+  {
+    for (size_t j = 0; j < pointBuckets.n_rows; j++)
     {
-      // This is the bucket number.
-      size_t hashInd = (size_t) secondHashVec[j];
-      // The point ID is 'j'.
+      const size_t hashInd = pointBuckets(j, i);
+      if (bucketFill[hashInd] < newOffsets[hashInd + 1])
+        newContents[bucketFill[hashInd]++] = (arma::u32) (firstIndex + j);
+    }
+  }
 
-      // If this is currently an empty bucket, start a new row keep track of
-      // which row corresponds to the bucket.
-      if (bucketContentSize[hashInd] == 0)
-      {
-        // Start a new row for hash.
-        bucketRowInHashTable[hashInd] = numRowsInTable;
-        secondHashTable(numRowsInTable, 0) = j;
+  bucketOffsets.swap(newOffsets);
+  bucketContents.swap(newContents);
 
-        numRowsInTable++;
-      }
+  Log::Info << "Final hash table size: " << bucketContents.n_elem
+      << " points in " << numNonEmptyBuckets << " buckets (largest bucket has "
+      << maxBucketSize << " points)." << std::endl;
+}
 
-      else
-      {
-        // If bucket is already present in the 'secondHashTable', find the
-        // corresponding row and insert the point ID in this row unless the
-        // bucket is full, in which case, do nothing.
-        if (bucketContentSize[hashInd] < bucketSize)
-          secondHashTable(bucketRowInHashTable[hashInd],
-                          bucketContentSize[hashInd]) = j;
-      }
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::Insert(const arma::mat& newPoints)
+{
+  if (bucketOffsets.is_empty())
+  {
+    throw std::invalid_argument("LSHSearch::Insert(): the model must be "
+        "trained before points can be inserted!");
+  }
 
-      // Increment the count of the points in this bucket.
-      if (bucketContentSize[hashInd] < bucketSize)
-        bucketContentSize[hashInd]++;
-    } // Loop over all points in the reference set.
-  } // Loop over tables.
+  if (newPoints.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "LSHSearch::Insert(): dimensionality of new points ("
+        << newPoints.n_rows << ") is not equal to the dimensionality the model "
+        << "was trained on (" << referenceSet->n_rows << ")!" << std::endl;
+    throw std::invalid_argument(oss.str());
+  }
 
-  // Step VII: Condensing the 'secondHashTable'.
-  size_t maxBucketSize = 0;
-  for (size_t i = 0; i < bucketContentSize.n_elem; i++)
-    if (bucketContentSize[i] > maxBucketSize)
-      maxBucketSize = bucketContentSize[i];
+  const size_t firstIndex = referenceSet->n_cols;
+  if (firstIndex + newPoints.n_cols >
+      (size_t) std::numeric_limits<arma::u32>::max())
+  {
+    std::ostringstream oss;
+    oss << "LSHSearch::Insert(): reference set would have "
+        << (firstIndex + newPoints.n_cols) << " points, but at most "
+        << std::numeric_limits<arma::u32>::max() << " are supported!"
+        << std::endl;
+    throw std::invalid_argument(oss.str());
+  }
+
+  arma::Mat<arma::u32> pointBuckets;
+  std::vector<uint64_t> newSignatures;
+  HashPoints(newPoints, pointBuckets, newSignatures);
+  AddToBuckets(pointBuckets, firstIndex);
+  signatures.insert(signatures.end(), newSignatures.begin(),
+      newSignatures.end());
+
+  // Append the new points to our own copy of the reference set.
+  const arma::mat* oldReferenceSet = referenceSet;
+  referenceSet = new arma::mat(arma::join_rows(*oldReferenceSet, newPoints));
+  if (ownsSet)
+    delete oldReferenceSet;
+  ownsSet = true;
+
+  removed.resize(referenceSet->n_cols, false);
+}
+
+template<typename SortPolicy, typename HashType>
+void LSHSearch<SortPolicy, HashType>::Remove(const size_t index)
+{
+  if (index >= referenceSet->n_cols)
+  {
+    std::ostringstream oss;
+    oss << "LSHSearch::Remove(): cannot remove point " << index << "; the "
+        << "reference set has only " << referenceSet->n_cols << " points!"
+        << std::endl;
+    throw std::invalid_argument(oss.str());
+  }
 
-  Log::Info << "Final hash table size: (" << numRowsInTable << " x "
-            << maxBucketSize << ")" << std::endl;
-  secondHashTable.resize(numRowsInTable, maxBucketSize);
+  removed[index] = true;
 }
 
-template<typename SortPolicy>
+template<typename SortPolicy, typename HashType>
 template<typename Archive>
-void LSHSearch<SortPolicy>::Serialize(Archive& ar,
-                                      const unsigned int /* version */)
+void LSHSearch<SortPolicy, HashType>::Serialize(Archive& ar,
+                                                const unsigned int version)
 {
   using data::CreateNVP;
 
@@ -516,24 +777,36 @@ void LSHSearch<SortPolicy>::Serialize(Archive& ar,
   ar & CreateNVP(numProj, "numProj");
   ar & CreateNVP(numTables, "numTables");
 
-  // Delete existing projections, if necessary.
-  if (Archive::is_loading::value)
-    projections.clear();
-
-  ar & CreateNVP(projections, "projections");
-  ar & CreateNVP(offsets, "offsets");
-  ar & CreateNVP(hashWidth, "hashWidth");
+  // The hash functions are serialized in place (for PStableHash, as the
+  // projections, offsets, and hash width).
+  hash.Serialize(ar, version);
   ar & CreateNVP(secondHashSize, "secondHashSize");
   ar & CreateNVP(secondHashWeights, "secondHashWeights");
   ar & CreateNVP(bucketSize, "bucketSize");
-  ar & CreateNVP(secondHashTable, "secondHashTable");
-  ar & CreateNVP(bucketContentSize, "bucketContentSize");
-  ar & CreateNVP(bucketRowInHashTable, "bucketRowInHashTable");
+  ar & CreateNVP(bucketOffsets, "bucketOffsets");
+  ar & CreateNVP(bucketContents, "bucketContents");
+  ar & CreateNVP(removed, "removed");
+  if (HashType::BinaryKeys)
+    ar & CreateNVP(signatures, "signatures");
   ar & CreateNVP(distanceEvaluations, "distanceEvaluations");
 }
 
-template<typename SortPolicy>
-std::string LSHSearch<SortPolicy>::ToString() const
+template<typename SortPolicy, typename HashType>
+size_t LSHSearch<SortPolicy, HashType>::MemoryUsage() const
+{
+  size_t bytes = sizeof(*this) + hash.MemoryUsage() +
+      mlpack::MemoryUsage(secondHashWeights) +
+      mlpack::MemoryUsage(bucketOffsets) + mlpack::MemoryUsage(bucketContents) +
+      mlpack::MemoryUsage(removed) + mlpack::MemoryUsage(signatures);
+
+  if (ownsSet)
+    bytes += mlpack::MemoryUsage(*referenceSet);
+
+  return bytes;
+}
+
+template<typename SortPolicy, typename HashType>
+std::string LSHSearch<SortPolicy, HashType>::ToString() const
 {
   std::ostringstream convert;
   convert << "LSHSearch [" << this << "]" << std::endl;
@@ -541,7 +814,7 @@ std::string LSHSearch<SortPolicy>::ToString() const
   convert <<  referenceSet->n_cols << std::endl;
   convert << "  Number of Projections: " << numProj << std::endl;
   convert << "  Number of Tables: " << numTables << std::endl;
-  convert << "  Hash Width: " << hashWidth << std::endl;
+  convert << "  Signature Words: " << SignatureWords() << std::endl;
   return convert.str();
 }
 
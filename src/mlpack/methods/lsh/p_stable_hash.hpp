@@ -0,0 +1,238 @@
+/**
+ * @file p_stable_hash.hpp
+ * @author Ryan Curtin
+ *
+ * The hash family of LSH with 2-stable distributions, for the Euclidean
+ * distance.  This is the default hash family of LSHSearch.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_P_STABLE_HASH_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_P_STABLE_HASH_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <vector>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The p-stable hash family (with the 2-stable normal distribution) of Datar et
+ * al.: each hash function projects a point onto a random Gaussian direction,
+ * adds a random offset in [0, hashWidth), and divides by the hash width, so
+ * that the floor of the result is the key of the point.  Nearby points (in the
+ * Euclidean distance) are likely to get the same key.
+ *
+ * This class implements the HashType policy of LSHSearch:
+ *
+ * @code
+ * // Draw the hash functions of numTables tables with numProj functions each.
+ * void Train(const arma::mat& referenceSet, const size_t numProj,
+ *            const size_t numTables, const double hashWidth);
+ *
+ * // Compute the projections of the points in the given table (numProj rows).
+ * void Project(const arma::mat& points, const size_t table,
+ *              arma::mat& projections) const;
+ *
+ * // Compute the projections of the points in the first numTables tables,
+ * // stacked table by table (numProj * numTables rows).
+ * void ProjectAll(const arma::mat& points, const size_t numTables,
+ *                 arma::mat& projections) const;
+ *
+ * // Get the integer keys of the given projections.
+ * arma::mat Keys(const arma::mat& projections) const;
+ *
+ * // Get the moves of a key for multiprobe LSH: move j changes element
+ * // (j % numProj) of the key by steps[j], at cost costs[j].
+ * void ProbeMoves(const arma::vec& projection, const arma::vec& key,
+ *                 arma::vec& costs, arma::vec& steps) const;
+ *
+ * // Whether every key element is 0 or 1, so that keys can be packed into
+ * // bit signatures.
+ * static const bool BinaryKeys;
+ *
+ * // Serialize the hash functions, and get the memory they use.
+ * template<typename Archive> void Serialize(Archive& ar, const unsigned int);
+ * size_t MemoryUsage() const;
+ * @endcode
+ */
+class PStableHash
+{
+ public:
+  //! The keys are integers, not bits.
+  static const bool BinaryKeys = false;
+
+  //! Create an empty hash family; Train() must be called before it is used.
+  PStableHash() : hashWidth(0.0) { }
+
+  /**
+   * Draw the offsets and then the projections of every table.  If the given
+   * hash width is 0, a heuristic hash width is computed from the reference
+   * set: the average distance between 25 random pairs of points.
+   */
+  void Train(const arma::mat& referenceSet,
+             const size_t numProj,
+             const size_t numTables,
+             const double hashWidthIn)
+  {
+    hashWidth = hashWidthIn;
+    if (hashWidth == 0.0) // The user has not provided any value.
+    {
+      // Compute a heuristic hash width from the data.
+      for (size_t i = 0; i < 25; i++)
+      {
+        size_t p1 = (size_t) math::RandInt(referenceSet.n_cols);
+        size_t p2 = (size_t) math::RandInt(referenceSet.n_cols);
+
+        hashWidth += std::sqrt(metric::EuclideanDistance::Evaluate(
+            referenceSet.unsafe_col(p1), referenceSet.unsafe_col(p2)));
+      }
+
+      hashWidth /= 25;
+    }
+
+    Log::Info << "Hash width chosen as: " << hashWidth << std::endl;
+
+    // Since the 'offsets' are in [0, hashWidth], we obtain the 'offsets' as
+    // randu(numProj, numTables) * hashWidth.
+    offsets.randu(numProj, numTables);
+    offsets *= hashWidth;
+
+    // Obtain the 'numProj' projections for each table.  For the L2 metric,
+    // 2-stable distributions are used, and the normal Z ~ N(0, 1) is a
+    // 2-stable distribution.
+    projections.clear();
+    for (size_t i = 0; i < numTables; i++)
+    {
+      arma::mat projMat;
+      projMat.randn(referenceSet.n_rows, numProj);
+      projections.push_back(projMat);
+    }
+
+    Stack();
+  }
+
+  //! Compute the projections of the given points in the given table.
+  void Project(const arma::mat& points,
+               const size_t table,
+               arma::mat& projectionsOut) const
+  {
+    // For a single table, let the 'numProj' projections be denoted by 'proj_i'
+    // and the corresponding offset be 'offset_i'.  Then the key of a single
+    // point is obtained as:
+    // key = { floor( (<proj_i, point> + offset_i) / 'hashWidth' ) forall i }
+    projectionsOut = projections[table].t() * points;
+    projectionsOut.each_col() += offsets.unsafe_col(table);
+    projectionsOut /= hashWidth;
+  }
+
+  //! Compute the projections of the given points in the first numTables
+  //! tables, with one matrix product.
+  void ProjectAll(const arma::mat& points,
+                  const size_t numTables,
+                  arma::mat& projectionsOut) const
+  {
+    const size_t rows = offsets.n_rows * numTables;
+    projectionsOut = stackedProjections.cols(0, rows - 1).t() * points;
+    projectionsOut.each_col() += stackedOffsets.subvec(0, rows - 1);
+    projectionsOut /= hashWidth;
+  }
+
+  //! The key of a projection is its floor.
+  arma::mat Keys(const arma::mat& projectionsIn) const
+  {
+    return arma::floor(projectionsIn);
+  }
+
+  /**
+   * Move j (for j < numProj) takes the point across the lower boundary of its
+   * bucket in dimension j, and move j + numProj takes it across the upper
+   * boundary.  Each move costs the squared distance to that boundary.
+   */
+  void ProbeMoves(const arma::vec& projection,
+                  const arma::vec& key,
+                  arma::vec& costs,
+                  arma::vec& steps) const
+  {
+    const size_t numProj = projection.n_elem;
+    costs.set_size(2 * numProj);
+    steps.set_size(2 * numProj);
+    for (size_t j = 0; j < numProj; ++j)
+    {
+      costs[j] = projection[j] - key[j];
+      costs[j + numProj] = 1.0 - costs[j];
+      steps[j] = -1.0;
+      steps[j + numProj] = 1.0;
+    }
+    costs = arma::square(costs);
+  }
+
+  //! Get the number of tables.
+  size_t NumTables() const { return projections.size(); }
+  //! Get the projection matrix of the given table.
+  const arma::mat& Projection(const size_t i) const { return projections[i]; }
+  //! Get the offsets 'b' for each of the projections.  (One 'b' per column.)
+  const arma::mat& Offsets() const { return offsets; }
+  //! Get the hash width.
+  double HashWidth() const { return hashWidth; }
+
+  //! Get the memory used by the hash functions, in bytes.
+  size_t MemoryUsage() const
+  {
+    size_t bytes = mlpack::MemoryUsage(offsets) +
+        mlpack::MemoryUsage(projections) +
+        mlpack::MemoryUsage(stackedProjections) +
+        mlpack::MemoryUsage(stackedOffsets);
+    for (size_t i = 0; i < projections.size(); ++i)
+      bytes += mlpack::MemoryUsage(projections[i]) - sizeof(arma::mat);
+
+    return bytes;
+  }
+
+  //! Serialize the hash functions.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    using data::CreateNVP;
+
+    // Delete existing projections, if necessary.
+    if (Archive::is_loading::value)
+      projections.clear();
+
+    ar & CreateNVP(projections, "projections");
+    ar & CreateNVP(offsets, "offsets");
+    ar & CreateNVP(hashWidth, "hashWidth");
+
+    if (Archive::is_loading::value)
+      Stack();
+  }
+
+ private:
+  //! The projection matrix of each table (dims x numProj).
+  std::vector<arma::mat> projections;
+  //! The offsets 'b' of each projection of each table (numProj x numTables).
+  arma::mat offsets;
+  //! The hash width.
+  double hashWidth;
+
+  //! The projections of every table, side by side, so that points are hashed
+  //! into several tables with a single matrix product.
+  arma::mat stackedProjections;
+  //! The offsets of every table, stacked.
+  arma::vec stackedOffsets;
+
+  //! Build the stacked projections and offsets.
+  void Stack()
+  {
+    const size_t dims = projections.empty() ? 0 : projections[0].n_rows;
+    stackedProjections.set_size(dims, offsets.n_elem);
+    for (size_t i = 0; i < projections.size(); i++)
+      stackedProjections.cols(i * offsets.n_rows, (i + 1) * offsets.n_rows - 1)
+          = projections[i];
+    stackedOffsets = arma::vectorise(offsets);
+  }
+};
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
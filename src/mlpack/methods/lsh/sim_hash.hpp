@@ -0,0 +1,124 @@
+/**
+ * @file sim_hash.hpp
+ * @author Ryan Curtin
+ *
+ * The sign random projection (SimHash) hash family, for the angle between
+ * points.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_SIM_HASH_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_SIM_HASH_HPP
+
+#include <mlpack/core.hpp>
+#include <vector>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The sign random projection hash family of Charikar (SimHash): each hash
+ * function is the side of a random hyperplane through the origin that a point
+ * lies on, so two points get the same bit with probability 1 - theta / pi,
+ * where theta is the angle between them.  Each key element is a bit, so
+ * LSHSearch stores a packed signature of every point and can filter its
+ * candidates by Hamming distance.  The exact distance that LSHSearch ranks the
+ * candidates by is the Euclidean distance, which gives the same order as the
+ * angle if the points are normalized to unit length.
+ *
+ * @code
+ * @inproceedings{charikar2002similarity,
+ *   title={Similarity estimation techniques from rounding algorithms},
+ *   author={Charikar, M.S.},
+ *   booktitle={Proceedings of the 34th Annual ACM Symposium on Theory of
+ *       Computing (STOC 2002)},
+ *   pages={380--388},
+ *   year={2002}
+ * }
+ * @endcode
+ *
+ * See PStableHash for the policy this implements.  The hash width is not used.
+ */
+class SimHash
+{
+ public:
+  //! Each key element is a bit.
+  static const bool BinaryKeys = true;
+
+  //! Create an empty hash family; Train() must be called before it is used.
+  SimHash() : numProj(0) { }
+
+  //! Draw the random hyperplanes of every table.
+  void Train(const arma::mat& referenceSet,
+             const size_t numProj,
+             const size_t numTables,
+             const double /* hashWidth */)
+  {
+    projections.randn(referenceSet.n_rows, numProj * numTables);
+    this->numProj = numProj;
+  }
+
+  //! Compute the projections of the given points in the given table.
+  void Project(const arma::mat& points,
+               const size_t table,
+               arma::mat& projectionsOut) const
+  {
+    projectionsOut = projections.cols(table * numProj,
+        (table + 1) * numProj - 1).t() * points;
+  }
+
+  //! Compute the projections of the given points in the first numTables
+  //! tables, with one matrix product.
+  void ProjectAll(const arma::mat& points,
+                  const size_t numTables,
+                  arma::mat& projectionsOut) const
+  {
+    projectionsOut = projections.cols(0, numTables * numProj - 1).t() * points;
+  }
+
+  //! The key of a projection is 1 if it is nonnegative and 0 otherwise.
+  arma::mat Keys(const arma::mat& projectionsIn) const
+  {
+    arma::mat keys(projectionsIn.n_rows, projectionsIn.n_cols);
+    for (size_t i = 0; i < projectionsIn.n_elem; ++i)
+      keys[i] = (projectionsIn[i] >= 0.0) ? 1.0 : 0.0;
+    return keys;
+  }
+
+  //! Move j flips bit j of the key, at the cost of the squared distance of the
+  //! projection to the hyperplane.
+  void ProbeMoves(const arma::vec& projection,
+                  const arma::vec& key,
+                  arma::vec& costs,
+                  arma::vec& steps) const
+  {
+    costs = arma::square(projection);
+    steps = 1.0 - 2.0 * key;
+  }
+
+  //! Get the normals of the hyperplanes of every table; table i has columns
+  //! i * numProj to (i + 1) * numProj - 1.
+  const arma::mat& Projections() const { return projections; }
+
+  //! Get the memory used by the hash functions, in bytes.
+  size_t MemoryUsage() const { return mlpack::MemoryUsage(projections); }
+
+  //! Serialize the hash functions.
+  template<typename Archive>
+  void Serialize(Archive& ar, const unsigned int /* version */)
+  {
+    using data::CreateNVP;
+
+    ar & CreateNVP(projections, "projections");
+    ar & CreateNVP(numProj, "numProj");
+  }
+
+ private:
+  //! The normals of the hyperplanes of every table, side by side.
+  arma::mat projections;
+  //! The number of hyperplanes of each table.
+  size_t numProj;
+};
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,173 @@
+/**
+ * @file als_matrix_completion.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the ALSMatrixCompletion class.
+ */
+#include "als_matrix_completion.hpp"
+
+namespace mlpack {
+namespace matrix_completion {
+
+ALSMatrixCompletion::ALSMatrixCompletion(const size_t m,
+                                         const size_t n,
+                                         const arma::umat& indices,
+                                         const arma::vec& values,
+                                         const size_t r,
+                                         const double lambda,
+                                         const size_t maxIterations,
+                                         const double tolerance) :
+    m(m), n(n), r(r), lambda(lambda), maxIterations(maxIterations),
+    tolerance(tolerance)
+{
+  Build(indices, values);
+}
+
+void ALSMatrixCompletion::Build(const arma::umat& indices,
+                                const arma::vec& values)
+{
+  if (indices.n_rows != 2)
+    Log::Fatal << "ALSMatrixCompletion::Build(): matrix of constraint indices "
+        << "does not have 2 rows!" << std::endl;
+
+  if (indices.n_cols != values.n_elem)
+    Log::Fatal << "ALSMatrixCompletion::Build(): the number of constraint "
+        << "indices (columns of constraint indices matrix) does not match the "
+        << "number of constraint values (length of constraint value vector)!"
+        << std::endl;
+
+  if (r == 0)
+    Log::Fatal << "ALSMatrixCompletion::Build(): rank must be positive!"
+        << std::endl;
+
+  if (lambda <= 0.0)
+    Log::Fatal << "ALSMatrixCompletion::Build(): lambda (" << lambda << ") "
+        << "must be positive!" << std::endl;
+
+  const size_t p = indices.n_cols;
+  rowPtrs.zeros(m + 1);
+  colPtrs.zeros(n + 1);
+  for (size_t i = 0; i < p; i++)
+  {
+    if (indices(0, i) >= m || indices(1, i) >= n)
+      Log::Fatal << "ALSMatrixCompletion::Build(): indices (" << indices(0, i)
+          << ", " << indices(1, i) << ") are out of bounds for matrix of size "
+          << m << " x " << n << "!" << std::endl;
+
+    ++rowPtrs[indices(0, i) + 1];
+    ++colPtrs[indices(1, i) + 1];
+  }
+
+  for (size_t i = 0; i < m; i++)
+    rowPtrs[i + 1] += rowPtrs[i];
+  for (size_t j = 0; j < n; j++)
+    colPtrs[j + 1] += colPtrs[j];
+
+  // Place each known entry in its row and in its column (a counting sort).
+  rowIndices.set_size(p);
+  rowValues.set_size(p);
+  colIndices.set_size(p);
+  colValues.set_size(p);
+  arma::Col<size_t> rowNext = rowPtrs;
+  arma::Col<size_t> colNext = colPtrs;
+  for (size_t i = 0; i < p; i++)
+  {
+    const size_t row = indices(0, i);
+    const size_t col = indices(1, i);
+
+    rowIndices[rowNext[row]] = col;
+    rowValues[rowNext[row]++] = values[i];
+    colIndices[colNext[col]] = row;
+    colValues[colNext[col]++] = values[i];
+  }
+}
+
+void ALSMatrixCompletion::Recover(arma::mat& recovered)
+{
+  arma::mat w, h;
+  Recover(w, h);
+  recovered = w * h;
+}
+
+void ALSMatrixCompletion::Recover(arma::mat& w, arma::mat& h)
+{
+  // The left factor is kept transposed, so that each row of W is contiguous.
+  arma::mat wt(r, m);
+  h.randu(r, n);
+
+  double lastObjective = DBL_MAX;
+  for (size_t i = 0; i < maxIterations; i++)
+  {
+    Solve(rowPtrs, rowIndices, rowValues, h, wt);
+    Solve(colPtrs, colIndices, colValues, wt, h);
+
+    const double objective = Objective(wt, h);
+    Log::Info << "ALSMatrixCompletion::Recover(): iteration " << i << ", "
+        << "objective " << objective << "." << std::endl;
+
+    if (std::abs(lastObjective - objective) <= tolerance * objective)
+      break;
+
+    lastObjective = objective;
+  }
+
+  w = trans(wt);
+}
+
+void ALSMatrixCompletion::Solve(const arma::Col<size_t>& ptrs,
+                                const arma::Col<size_t>& entryIndices,
+                                const arma::vec& entryValues,
+                                const arma::mat& factors,
+                                arma::mat& output) const
+{
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (size_t j = 0; j < output.n_cols; ++j)
+  {
+    const size_t begin = ptrs[j];
+    const size_t end = ptrs[j + 1];
+    if (begin == end)
+    {
+      output.col(j).zeros();
+      continue;
+    }
+
+    arma::mat a(r, r);
+    a.eye();
+    a *= lambda;
+    arma::vec b(r);
+    b.zeros();
+    for (size_t k = begin; k < end; ++k)
+    {
+      const arma::vec f(const_cast<double*>(factors.colptr(entryIndices[k])),
+          r, false, true);
+      a += f * trans(f);
+      b += entryValues[k] * f;
+    }
+
+    arma::vec x;
+    arma::solve(x, a, b);
+    output.col(j) = x;
+  }
+}
+
+double ALSMatrixCompletion::Objective(const arma::mat& wt,
+                                      const arma::mat& h) const
+{
+  double objective = 0.0;
+
+  #pragma omp parallel for schedule(dynamic, 64) reduction(+:objective)
+  for (size_t j = 0; j < n; ++j)
+  {
+    for (size_t k = colPtrs[j]; k < colPtrs[j + 1]; ++k)
+    {
+      const double error = colValues[k] - arma::dot(wt.col(colIndices[k]),
+          h.col(j));
+      objective += error * error;
+    }
+  }
+
+  return objective + lambda * (arma::accu(wt % wt) + arma::accu(h % h));
+}
+
+} // namespace matrix_completion
+} // namespace mlpack
@@ -0,0 +1,177 @@
+/**
+ * @file als_matrix_completion.hpp
+ * @author Ryan Curtin
+ *
+ * Low rank matrix completion by alternating least squares on the known
+ * entries, which scales to much larger matrices than the SDP formulation.
+ */
+#ifndef __MLPACK_METHODS_MATRIX_COMPLETION_ALS_MATRIX_COMPLETION_HPP
+#define __MLPACK_METHODS_MATRIX_COMPLETION_ALS_MATRIX_COMPLETION_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace matrix_completion {
+
+/**
+ * This class solves low rank matrix completion problems by alternating least
+ * squares.  The completed matrix is X = W H, where W is m x r and H is r x n,
+ * and W and H minimize
+ *
+ *   sum_{(i, j) known} (X_ij - M_ij)^2 + lambda (||W||_F^2 + ||H||_F^2).
+ *
+ * For r at least the rank of the solution, this is the same as the nuclear
+ * norm regularized problem
+ *
+ *   min sum_{(i, j) known} (X_ij - M_ij)^2 + 2 lambda ||X||_*,
+ *
+ * so a small lambda gives (approximately) the solution of the nuclear norm
+ * minimization that MatrixCompletion solves.  For more details, see the
+ * following paper:
+ *
+ * @code
+ * @article{hastie2015matrix,
+ *   title={Matrix completion and low-rank SVD via fast alternating least
+ *       squares},
+ *   author={Hastie, T. and Mazumder, R. and Lee, J.D. and Zadeh, R.},
+ *   journal={Journal of Machine Learning Research},
+ *   volume={16},
+ *   pages={3367--3402},
+ *   year={2015}
+ * }
+ * @endcode
+ *
+ * Each half-iteration solves a small r x r system for each row of W (or column
+ * of H), using only the known entries of that row (or column), and if mlpack is
+ * compiled with OpenMP, the systems are solved in parallel.  The memory used is
+ * proportional to the number of known entries plus (m + n) r, unlike the SDP of
+ * MatrixCompletion, which is of size (m + n) x (m + n); but here the rank has
+ * to be given.
+ *
+ * An example of how to use this class is shown below:
+ *
+ * @code
+ * size_t m, n;         // size of unknown matrix
+ * arma::umat indices;  // contains the known indices [2 x n_entries]
+ * arma::vec values;    // contains the known values [n_entries]
+ * arma::mat recovered; // will contain the completed matrix
+ *
+ * ALSMatrixCompletion mc(m, n, indices, values, 5);
+ * mc.Recover(recovered);
+ * @endcode
+ *
+ * @see MatrixCompletion
+ */
+class ALSMatrixCompletion
+{
+ public:
+  /**
+   * Construct a matrix completion problem.
+   *
+   * @param m Number of rows of original matrix.
+   * @param n Number of columns of original matrix.
+   * @param indices Matrix containing the indices of the known entries (must be
+   *    [2 x p]).
+   * @param values Vector containing the values of the known entries (must be
+   *    length p).
+   * @param r Rank of solution.
+   * @param lambda Regularization parameter (must be positive).
+   * @param maxIterations Maximum number of alternating iterations.
+   * @param tolerance Relative change of the objective between iterations below
+   *    which the optimization terminates.
+   */
+  ALSMatrixCompletion(const size_t m,
+                      const size_t n,
+                      const arma::umat& indices,
+                      const arma::vec& values,
+                      const size_t r,
+                      const double lambda = 1e-5,
+                      const size_t maxIterations = 1000,
+                      const double tolerance = 1e-10);
+
+  /**
+   * Fill in the remaining values.
+   *
+   * @param recovered Will contain the completed matrix.
+   */
+  void Recover(arma::mat& recovered);
+
+  /**
+   * Compute the factors of the completed matrix W H, without forming it.
+   *
+   * @param w Will contain the m x r left factor.
+   * @param h Will contain the r x n right factor.
+   */
+  void Recover(arma::mat& w, arma::mat& h);
+
+  //! Get the rank of the solution.
+  size_t Rank() const { return r; }
+  //! Modify the rank of the solution.
+  size_t& Rank() { return r; }
+
+  //! Get the regularization parameter.
+  double Lambda() const { return lambda; }
+  //! Modify the regularization parameter.
+  double& Lambda() { return lambda; }
+
+  //! Get the maximum number of iterations.
+  size_t MaxIterations() const { return maxIterations; }
+  //! Modify the maximum number of iterations.
+  size_t& MaxIterations() { return maxIterations; }
+
+  //! Get the tolerance for termination.
+  double Tolerance() const { return tolerance; }
+  //! Modify the tolerance for termination.
+  double& Tolerance() { return tolerance; }
+
+ private:
+  //! Number of rows in original matrix.
+  size_t m;
+  //! Number of columns in original matrix.
+  size_t n;
+  //! Rank of the solution.
+  size_t r;
+  //! Regularization parameter.
+  double lambda;
+  //! Maximum number of iterations.
+  size_t maxIterations;
+  //! Tolerance for termination.
+  double tolerance;
+
+  //! Start of the known entries of each row (m + 1 elements).
+  arma::Col<size_t> rowPtrs;
+  //! Column of each known entry, in order of rows.
+  arma::Col<size_t> rowIndices;
+  //! Value of each known entry, in order of rows.
+  arma::vec rowValues;
+  //! Start of the known entries of each column (n + 1 elements).
+  arma::Col<size_t> colPtrs;
+  //! Row of each known entry, in order of columns.
+  arma::Col<size_t> colIndices;
+  //! Value of each known entry, in order of columns.
+  arma::vec colValues;
+
+  //! Validate the input matrices and sort the known entries by rows and by
+  //! columns.
+  void Build(const arma::umat& indices, const arma::vec& values);
+
+  /**
+   * Solve for each column of the output, using the known entries of the
+   * corresponding row or column and the fixed factors (one factor per column)
+   * they belong to.
+   */
+  void Solve(const arma::Col<size_t>& ptrs,
+             const arma::Col<size_t>& entryIndices,
+             const arma::vec& entryValues,
+             const arma::mat& factors,
+             arma::mat& output) const;
+
+  //! Compute the objective, given the transposed left factor and the right
+  //! factor.
+  double Objective(const arma::mat& wt, const arma::mat& h) const;
+};
+
+} // namespace matrix_completion
+} // namespace mlpack
+
+#endif
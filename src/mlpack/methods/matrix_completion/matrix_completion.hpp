@@ -43,7 +43,10 @@ namespace matrix_completion {
  * mc.Recover(recovered);
  * @endcode
  *
- * @see LRSDP
+ * The SDP is of size (m + n) x (m + n), so for large matrices, use
+ * ALSMatrixCompletion instead.
+ *
+ * @see LRSDP, ALSMatrixCompletion
  */
 class MatrixCompletion
 {
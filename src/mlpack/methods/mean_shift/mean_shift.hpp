@@ -12,6 +12,7 @@
 #include <mlpack/core/kernels/gaussian_kernel.hpp>
 #include <mlpack/core/kernels/kernel_traits.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/methods/neighbor_search/knn_graph.hpp>
 #include <boost/utility.hpp>
 
 namespace mlpack {
@@ -67,6 +68,22 @@ class MeanShift
    */
   double EstimateRadius(const MatType& data, const double ratio = 0.2);
 
+  /**
+   * Give an estimation of radius from a k-nearest-neighbor graph that has
+   * already been built for the dataset, without searching again.  This is the
+   * same estimate as EstimateRadius(data, ratio) when the graph was built with
+   * k = ratio * data.n_cols.
+   *
+   * @param graph k-nearest-neighbor graph of the dataset.
+   */
+  template<typename MetricType,
+           typename GraphMatType,
+           template<typename TreeMetricType,
+                    typename TreeStatType,
+                    typename TreeMatType> class TreeType>
+  double EstimateRadius(
+      const neighbor::KNNGraph<MetricType, GraphMatType, TreeType>& graph);
+
   /**
    * Perform mean shift clustering on the data, returning a list of cluster
    * assignments and centroids.
@@ -96,6 +113,14 @@ class MeanShift
   //! Modify the kernel.
   KernelType& Kernel() { return kernel; }
 
+  //! Get whether the range searches and the centroid updates are split across
+  //! multiple threads.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the range searches and the centroid updates are split
+  //! across multiple threads.  This has no effect if mlpack was not compiled
+  //! with OpenMP support.
+  bool& Parallel() { return parallel; }
+
  private:
   /**
    * To speed up, we can generate some seeds from data set and use
@@ -157,6 +182,10 @@ class MeanShift
 
   //! Instantiated kernel.
   KernelType kernel;
+
+  //! If true, the range searches and the centroid updates are split across
+  //! multiple threads.
+  bool parallel;
 };
 
 } // namespace meanshift
@@ -32,7 +32,8 @@ MeanShift(const double radius,
           const KernelType kernel) :
     radius(radius),
     maxIterations(maxIterations),
-    kernel(kernel)
+    kernel(kernel),
+    parallel(false)
 {
   // Nothing to do.
 }
@@ -49,6 +50,7 @@ double MeanShift<UseKernel, KernelType, MatType>::
 EstimateRadius(const MatType& data, double ratio)
 {
   neighbor::AllkNN neighborSearch(data);
+  neighborSearch.Parallel() = parallel;
 
   /**
    * For each point in dataset, select nNeighbors nearest points and get
@@ -67,6 +69,21 @@ EstimateRadius(const MatType& data, double ratio)
   return sum(maxDistances) / (double) data.n_cols;
 }
 
+// Estimate radius based on a given k-nearest-neighbor graph.
+template<bool UseKernel, typename KernelType, typename MatType>
+template<typename MetricType,
+         typename GraphMatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+double MeanShift<UseKernel, KernelType, MatType>::EstimateRadius(
+    const neighbor::KNNGraph<MetricType, GraphMatType, TreeType>& graph)
+{
+  // The largest of the distances to the k nearest neighbors of a point is the
+  // distance to the k'th one.
+  return accu(graph.KthDistances()) / (double) graph.NumPoints();
+}
+
 // Class to compare two vectors.
 template <typename VecType>
 class less
@@ -198,62 +215,99 @@ inline void MeanShift<UseKernel, KernelType, MatType>::Cluster(
   }
 
   // Holds all centroids before removing duplicate ones.
-  arma::mat allCentroids(pSeeds->n_rows, pSeeds->n_cols);
+  arma::mat allCentroids(*pSeeds);
 
   assignments.set_size(data.n_cols);
 
   range::RangeSearch<> rangeSearcher(data);
+  rangeSearcher.Parallel() = parallel;
   math::Range validRadius(0, radius);
   std::vector<std::vector<size_t> > neighbors;
   std::vector<std::vector<double> > distances;
 
-  // For each seed, perform mean shift algorithm.
-  for (size_t i = 0; i < pSeeds->n_cols; ++i)
+  // The seeds whose centroids are still moving, and whether or not the
+  // centroid of each seed has converged.
+  std::vector<size_t> active(pSeeds->n_cols);
+  for (size_t i = 0; i < active.size(); ++i)
+    active[i] = i;
+  std::vector<bool> converged(pSeeds->n_cols, false);
+
+  // What happened to each active centroid in an iteration.
+  const char dropped = 0, stopped = 1, moving = 2;
+
+  // Perform the mean shift algorithm for all the seeds at once, so that the
+  // neighbors of every moving centroid are found with a single range search.
+  for (size_t completedIterations = 0; completedIterations < maxIterations &&
+       !active.empty(); completedIterations++)
   {
-    // Initial centroid is the seed itself.
-    allCentroids.col(i) = pSeeds->unsafe_col(i);
-    for (size_t completedIterations = 0; completedIterations < maxIterations;
-         completedIterations++)
-    {
-      // Store new centroid in this.
-      arma::colvec newCentroid = arma::zeros<arma::colvec>(pSeeds->n_rows);
+    arma::mat activeCentroids(pSeeds->n_rows, active.size());
+    for (size_t i = 0; i < active.size(); ++i)
+      activeCentroids.col(i) = allCentroids.unsafe_col(active[i]);
 
-      rangeSearcher.Search(allCentroids.unsafe_col(i), validRadius,
-          neighbors, distances);
-      if (neighbors[0].size() <= 1)
-        break;
+    rangeSearcher.Search(activeCentroids, validRadius, neighbors, distances);
+
+    // The centroids are updated in parallel.  The outcome for each one is
+    // recorded, so that the list of moving centroids can be rebuilt afterwards
+    // in order.
+    std::vector<char> status(active.size(), dropped);
+
+    #pragma omp parallel for schedule(dynamic, 16) if (parallel)
+    for (size_t i = 0; i < active.size(); ++i)
+    {
+      const size_t seed = active[i];
+      if (neighbors[i].size() <= 1)
+        continue;
 
       // Calculate new centroid.
-      if (!CalculateCentroid(data, neighbors[0], distances[0], newCentroid))
-        newCentroid = allCentroids.unsafe_col(i);
+      arma::colvec newCentroid = arma::zeros<arma::colvec>(pSeeds->n_rows);
+      if (!CalculateCentroid(data, neighbors[i], distances[i], newCentroid))
+        newCentroid = allCentroids.unsafe_col(seed);
 
       // If the mean shift vector is small enough, it has converged.
       if (metric::EuclideanDistance::Evaluate(newCentroid,
-          allCentroids.unsafe_col(i)) < 1e-3 * radius)
+          allCentroids.unsafe_col(seed)) < 1e-3 * radius)
       {
-        // Determine if the new centroid is duplicate with old ones.
-        bool isDuplicated = false;
-        for (size_t k = 0; k < centroids.n_cols; ++k)
-        {
-          const double distance = metric::EuclideanDistance::Evaluate(
-              allCentroids.unsafe_col(i), centroids.unsafe_col(k));
-          if (distance < radius)
-          {
-            isDuplicated = true;
-            break;
-          }
-        }
-
-        if (!isDuplicated)
-          centroids.insert_cols(centroids.n_cols, allCentroids.unsafe_col(i));
-
-        // Get out of the loop.
-        break;
+        status[i] = stopped;
+        continue;
       }
 
       // Update the centroid.
-      allCentroids.col(i) = newCentroid;
+      allCentroids.col(seed) = newCentroid;
+      status[i] = moving;
+    }
+
+    std::vector<size_t> stillActive;
+    for (size_t i = 0; i < active.size(); ++i)
+    {
+      if (status[i] == stopped)
+        converged[active[i]] = true;
+      else if (status[i] == moving)
+        stillActive.push_back(active[i]);
+    }
+
+    active.swap(stillActive);
+  }
+
+  // Keep each converged centroid that isn't a duplicate of an earlier one.
+  for (size_t i = 0; i < pSeeds->n_cols; ++i)
+  {
+    if (!converged[i])
+      continue;
+
+    bool isDuplicated = false;
+    for (size_t k = 0; k < centroids.n_cols; ++k)
+    {
+      const double distance = metric::EuclideanDistance::Evaluate(
+          allCentroids.unsafe_col(i), centroids.unsafe_col(k));
+      if (distance < radius)
+      {
+        isDuplicated = true;
+        break;
+      }
     }
+
+    if (!isDuplicated)
+      centroids.insert_cols(centroids.n_cols, allCentroids.unsafe_col(i));
   }
 
   // Assign centroids to each point.
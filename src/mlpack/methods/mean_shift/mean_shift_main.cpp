@@ -39,6 +39,9 @@ PARAM_INT("max_iterations", "Maximum number of iterations before mean shift "
 PARAM_DOUBLE("radius", "If distance of two centroids is less than the given "
     "radius, one will be removed.  A radius of 0 or less means an estimate will"
     " be calculated and used.", "r", 0);
+PARAM_FLAG("parallel", "If true, the range searches and the centroid updates "
+    "are split across multiple threads (only available if mlpack was compiled "
+    "with OpenMP).", "p");
 
 int main(int argc, char** argv)
 {
@@ -68,6 +71,7 @@ int main(int argc, char** argv)
   arma::Col<size_t> assignments;
 
   MeanShift<> meanShift(radius, maxIterations);
+  meanShift.Parallel() = CLI::HasParam("parallel");
 
   Timer::Start("clustering");
   Log::Info << "Performing mean shift clustering..." << endl;
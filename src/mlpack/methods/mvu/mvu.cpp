@@ -26,14 +26,32 @@ void MVU::Unfold(const size_t newDim,
                  const size_t numNeighbors,
                  arma::mat& outputData)
 {
+  // We first have to get the nearest neighbors of each point.
+  neighbor::KNNGraph<> graph(data, numNeighbors);
+
+  Unfold(newDim, graph, outputData);
+}
+
+void MVU::Unfold(const size_t newDim,
+                 const neighbor::KNNGraph<>& graph,
+                 arma::mat& outputData)
+{
+  if (graph.NumPoints() != data.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "MVU::Unfold(): the graph has " << graph.NumPoints() << " points, "
+        << "but the data has " << data.n_cols << " points";
+    throw std::invalid_argument(oss.str());
+  }
+
   // First we have to choose the output point.  We'll take a linear projection
   // of the data for now (this is probably not a good final solution).
 //  outputData = trans(data.rows(0, newDim - 1));
   // Following Nick's idea.
   outputData.randu(data.n_cols, newDim);
 
-  // The number of constraints is the number of nearest neighbors plus one.
-  LRSDP<arma::sp_mat> mvuSolver(numNeighbors * data.n_cols + 1, outputData);
+  // The number of constraints is the number of edges in the graph plus one.
+  LRSDP<arma::sp_mat> mvuSolver(graph.NumEdges() + 1, outputData);
 
   // Set up the objective.  Because we are maximizing the trace of (R R^T),
   // we'll instead state it as min(-I_n * (R R^T)), meaning C() is -I_n.
@@ -50,23 +68,18 @@ void MVU::Unfold(const size_t newDim,
   mvuSolver.AModes().ones();
   mvuSolver.AModes()[0] = 0;
 
-  // Now all of the other constraints.  We first have to run AllkNN to get the
-  // list of nearest neighbors.
-  arma::Mat<size_t> neighbors;
-  arma::mat distances;
-
-  AllkNN allknn(data);
-  allknn.Search(numNeighbors, neighbors, distances);
-
-  // Add each of the other constraints.  They are sparse constraints:
+  // Add each of the other constraints, one for each edge (i, j) of the graph
+  // with i < j.  They are sparse constraints:
   //   Tr(A_ij K) = d_ij;
   //   A_ij = zeros except for 1 at (i, i), (j, j); -1 at (i, j), (j, i).
-  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  size_t index = 1; // This is the index of the constraint.
+  for (size_t i = 0; i < graph.NumPoints(); ++i)
   {
-    for (size_t j = 0; j < numNeighbors; ++j)
+    for (size_t e = graph.Offsets()[i]; e < graph.Offsets()[i + 1]; ++e)
     {
-      // This is the index of the constraint.
-      const size_t index = (i * numNeighbors) + j + 1;
+      const size_t j = graph.Neighbors()[e];
+      if (j < i)
+        continue; // This edge was added from the other side.
 
       arma::mat& aRef = mvuSolver.A()[index];
 
@@ -79,21 +92,22 @@ void MVU::Unfold(const size_t newDim,
 
       // A_ij(i, j) = -1.
       aRef(0, 1) = i;
-      aRef(1, 1) = neighbors(j, i);
+      aRef(1, 1) = j;
       aRef(2, 1) = -1;
 
       // A_ij(j, i) = -1.
-      aRef(0, 2) = neighbors(j, i);
+      aRef(0, 2) = j;
       aRef(1, 2) = i;
       aRef(2, 2) = -1;
 
       // A_ij(j, j) = 1.
-      aRef(0, 3) = neighbors(j, i);
-      aRef(1, 3) = neighbors(j, i);
+      aRef(0, 3) = j;
+      aRef(1, 3) = j;
       aRef(2, 3) = 1;
 
       // The constraint b_ij is the distance between these two points.
-      mvuSolver.B()[index] = distances(j, i);
+      mvuSolver.B()[index] = graph.Distances()[e];
+      ++index;
     }
   }
 
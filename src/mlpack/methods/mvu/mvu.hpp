@@ -13,6 +13,7 @@
 #define __MLPACK_METHODS_MVU_MVU_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/methods/neighbor_search/knn_graph.hpp>
 
 namespace mlpack {
 namespace mvu {
@@ -33,6 +34,18 @@ class MVU
               const size_t numNeighbors,
               arma::mat& outputCoordinates);
 
+  /**
+   * Unfold the data using a k-nearest-neighbor graph that has already been
+   * built for it; there is one distance constraint for each edge of the graph.
+   *
+   * @param newDim Dimensionality of the output.
+   * @param graph k-nearest-neighbor graph of the data.
+   * @param outputCoordinates Matrix to store the unfolded data in.
+   */
+  void Unfold(const size_t newDim,
+              const neighbor::KNNGraph<>& graph,
+              arma::mat& outputCoordinates);
+
  private:
   const arma::mat& data;
 };
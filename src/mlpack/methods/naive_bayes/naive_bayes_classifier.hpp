@@ -77,8 +77,13 @@ class NaiveBayesClassifier
   /**
    * Train the Naive Bayes classifier on the given dataset.  If the incremental
    * algorithm is used, the current model is used as a starting point (this is
-   * the default).  If the incremental algorithm is not used, then the current
-   * model is ignored and the new model will be trained only on the given data.
+   * the default): the means and variances of the dataset are combined with
+   * those of the model with the pairwise (batch Welford) update, so the result
+   * is the same as training on all of the points at once, and new batches of
+   * data can be added without reprocessing the old ones.  If the incremental
+   * algorithm is not used, then the current model is ignored and the new model
+   * will be trained only on the given data.  If mlpack is compiled with OpenMP,
+   * the points are split across threads.
    * Note that even if the incremental algorithm is not used, the data must have
    * the same dimensionality and number of classes that the model was
    * initialized with.  If you want to change the dimensionality or number of
@@ -106,7 +111,10 @@ class NaiveBayesClassifier
 
   /**
    * Given a bunch of data points, this function evaluates the class of each of
-   * those data points, and puts it in the vector 'results'.
+   * those data points, and puts it in the vector 'results'.  The
+   * log-probabilities of each class are computed for blocks of points at a
+   * time, and if mlpack is compiled with OpenMP, the blocks are split across
+   * threads.
    *
    * @code
    * arma::mat test_data; // each column is a test point
@@ -118,7 +126,7 @@ class NaiveBayesClassifier
    * @param data List of data points.
    * @param results Vector that class predictions will be placed into.
    */
-  void Classify(const MatType& data, arma::Row<size_t>& results);
+  void Classify(const MatType& data, arma::Row<size_t>& results) const;
 
   //! Get the sample means for each class.
   const MatType& Means() const { return means; }
@@ -135,11 +143,33 @@ class NaiveBayesClassifier
   //! Modify the prior probabilities for each class.
   arma::vec& Probabilities() { return probabilities; }
 
+  //! Get the number of training points seen so far.
+  size_t TrainingPoints() const { return trainingPoints; }
+  //! Modify the number of training points seen so far.
+  size_t& TrainingPoints() { return trainingPoints; }
+
   //! Serialize the classifier.
   template<typename Archive>
   void Serialize(Archive& ar, const unsigned int /* version */);
 
  private:
+  /**
+   * Compute the number of points, the mean, and the sum of squared differences
+   * from the mean of each class in the given dataset.
+   *
+   * @param data The dataset.
+   * @param labels Labels of the points in the dataset.
+   * @param counts Vector to store the number of points of each class in.
+   * @param batchMeans Matrix to store the mean of each class in.
+   * @param batchSquares Matrix to store the sum of squared differences from the
+   *     mean of each class in.
+   */
+  void BatchStatistics(const MatType& data,
+                       const arma::Row<size_t>& labels,
+                       arma::vec& counts,
+                       MatType& batchMeans,
+                       MatType& batchSquares) const;
+
   //! Sample mean for each class.
   MatType means;
   //! Sample variances for each class.
@@ -16,6 +16,10 @@
 // In case it hasn't been included already.
 #include "naive_bayes_classifier.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace naive_bayes {
 
@@ -64,75 +68,151 @@ void NaiveBayesClassifier<MatType>::Train(const MatType& data,
                                           const bool incremental)
 {
   // Calculate the class probabilities as well as the sample mean and variance
-  // for each of the features with respect to each of the labels.
-  if (incremental)
+  // for each of the features with respect to each of the labels.  The
+  // statistics of the batch are calculated with a two-pass algorithm; this is
+  // stable, and the points can be split across threads.
+  arma::vec batchCounts;
+  MatType batchMeans, batchSquares;
+  BatchStatistics(data, labels, batchCounts, batchMeans, batchSquares);
+
+  if (!incremental)
   {
-    // Use incremental algorithm.
-    // Fist, de-normalize probabilities.
-    probabilities *= trainingPoints;
+    // Ignore the current model.
+    probabilities.zeros();
+    means.zeros();
+    variances.zeros();
+    trainingPoints = 0;
+  }
 
-    for (size_t j = 0; j < data.n_cols; ++j)
+  // Now combine the statistics of the batch with those of the model.  This is
+  // the pairwise update of Chan, Golub, and LeVeque ("Algorithms for computing
+  // the sample variance: analysis and recommendations", 1983), which is the
+  // batch version of Welford's algorithm: with n points in the model and m
+  // points in the batch, and delta the difference of their means,
+  //
+  //   mean = mean_n + delta * m / (n + m)
+  //   M2 = M2_n + M2_m + delta^2 * n * m / (n + m)
+  //
+  // where M2 is the sum of the squared differences from the mean.
+  for (size_t i = 0; i < probabilities.n_elem; ++i)
+  {
+    const double m = batchCounts[i];
+    if (m == 0.0)
     {
-      const size_t label = labels[j];
-      ++probabilities[label];
-
-      arma::vec delta = data.col(j) - means.col(label);
-      means.col(label) += delta / probabilities[label];
-      variances.col(label) += delta % (data.col(j) - means.col(label));
+      // The model for this class does not change, but its count does.
+      probabilities[i] *= trainingPoints;
+      continue;
     }
 
-    for (size_t i = 0; i < probabilities.n_elem; ++i)
-    {
-      if (probabilities[i] > 2)
-        variances.col(i) /= (probabilities[i] - 1);
-    }
+    // Recover the number of points of this class, and the sum of squared
+    // differences, from the model.
+    const double n = std::floor(probabilities[i] * trainingPoints + 0.5);
+    const double total = n + m;
+
+    arma::vec delta = batchMeans.col(i) - means.col(i);
+    means.col(i) += delta * (m / total);
+
+    arma::vec squares = batchSquares.col(i) + arma::square(delta) *
+        (n * m / total);
+    if (n > 1)
+      squares += variances.col(i) * (n - 1);
+
+    if (total > 1)
+      variances.col(i) = squares / (total - 1);
+    else
+      variances.col(i) = squares;
+
+    probabilities[i] = total;
   }
-  else
+
+  // Ensure that the variances are invertible.
+  for (size_t i = 0; i < variances.n_elem; ++i)
+    if (variances[i] == 0.0)
+      variances[i] = 1e-50;
+
+  trainingPoints += data.n_cols;
+  if (trainingPoints > 0)
+    probabilities /= trainingPoints;
+}
+
+template<typename MatType>
+void NaiveBayesClassifier<MatType>::BatchStatistics(
+    const MatType& data,
+    const arma::Row<size_t>& labels,
+    arma::vec& counts,
+    MatType& batchMeans,
+    MatType& batchSquares) const
+{
+  const size_t classes = probabilities.n_elem;
+
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+
+  // Each thread sums its own points; the sums of the threads are added up in
+  // order.  The static schedule gives each thread the same points in both
+  // passes.
+  std::vector<arma::vec> threadCounts(numThreads);
+  std::vector<MatType> threadSums(numThreads);
+
+  #pragma omp parallel num_threads(numThreads)
   {
-    // Set all parameters to zero
-    probabilities.zeros();
-    means.zeros();
-    variances.zeros();
+#ifdef _OPENMP
+    const size_t thread = (size_t) omp_get_thread_num();
+#else
+    const size_t thread = 0;
+#endif
 
-    // Don't use incremental algorithm.  This is a two-pass algorithm.  It is
-    // possible to calculate the means and variances using a faster one-pass
-    // algorithm but there are some precision and stability issues.  If this is
-    // too slow, it's an option to use the faster algorithm by default and then
-    // have this (and the incremental algorithm) be other options.
+    threadCounts[thread].zeros(classes);
+    threadSums[thread].zeros(data.n_rows, classes);
 
-    // Calculate the means.
+    #pragma omp for schedule(static)
     for (size_t j = 0; j < data.n_cols; ++j)
     {
       const size_t label = labels[j];
-      ++probabilities[label];
-      means.col(label) += data.col(j);
+      ++threadCounts[thread][label];
+      threadSums[thread].col(label) += data.col(j);
     }
+  }
 
-    // Normalize means.
-    for (size_t i = 0; i < probabilities.n_elem; ++i)
-      if (probabilities[i] != 0.0)
-        means.col(i) /= probabilities[i];
+  counts = std::move(threadCounts[0]);
+  batchMeans = std::move(threadSums[0]);
+  for (size_t t = 1; t < numThreads; ++t)
+  {
+    counts += threadCounts[t];
+    batchMeans += threadSums[t];
+  }
+
+  // Normalize means.
+  for (size_t i = 0; i < classes; ++i)
+    if (counts[i] != 0.0)
+      batchMeans.col(i) /= counts[i];
+
+  // Calculate the sums of squared differences from the means.
+  #pragma omp parallel num_threads(numThreads)
+  {
+#ifdef _OPENMP
+    const size_t thread = (size_t) omp_get_thread_num();
+#else
+    const size_t thread = 0;
+#endif
 
-    // Calculate variances.
+    threadSums[thread].zeros(data.n_rows, classes);
+
+    #pragma omp for schedule(static)
     for (size_t j = 0; j < data.n_cols; ++j)
     {
       const size_t label = labels[j];
-      variances.col(label) += square(data.col(j) - means.col(label));
+      threadSums[thread].col(label) += arma::square(data.col(j) -
+          batchMeans.col(label));
     }
-
-    // Normalize variances.
-    for (size_t i = 0; i < probabilities.n_elem; ++i)
-      if (probabilities[i] > 1)
-        variances.col(i) /= (probabilities[i] - 1);
   }
 
-  // Ensure that the variances are invertible.
-  for (size_t i = 0; i < variances.n_elem; ++i)
-    if (variances[i] == 0.0)
-      variances[i] = 1e-50;
-
-  probabilities /= data.n_cols;
-  trainingPoints += data.n_cols;
+  batchSquares = std::move(threadSums[0]);
+  for (size_t t = 1; t < numThreads; ++t)
+    batchSquares += threadSums[t];
 }
 
 template<typename MatType>
@@ -158,52 +238,60 @@ void NaiveBayesClassifier<MatType>::Train(const VecType& point,
 
 template<typename MatType>
 void NaiveBayesClassifier<MatType>::Classify(const MatType& data,
-                                             arma::Row<size_t>& results)
+                                             arma::Row<size_t>& results) const
 {
   // Check that the number of features in the test data is same as in the
   // training data.
   Log::Assert(data.n_rows == means.n_rows);
 
-  arma::vec probs = arma::log(probabilities);
-  arma::mat invVar = 1.0 / variances;
-
-  arma::mat testProbs = arma::repmat(probs.t(), data.n_cols, 1);
-
   results.set_size(data.n_cols); // No need to fill with anything yet.
 
   Log::Info << "Running Naive Bayes classifier on " << data.n_cols
       << " data points with " << data.n_rows << " features each." << std::endl;
 
-  // Calculate the joint probability for each of the data points for each of the
-  // means.n_cols.
-
-  // Loop over every class.
-  for (size_t i = 0; i < means.n_cols; i++)
+  // The log-probability of a point x under class i is
+  //
+  //   log(P(Y = i)) - (d / 2) log(2 pi) - (1 / 2) sum_k log(var_ik)
+  //       - (1 / 2) sum_k (x_k - mean_ik)^2 / var_ik,
+  //
+  // so, up to the constant term, each class needs one matrix-vector product
+  // of the squared differences with the inverse variances.  This is all done
+  // in log-space, so that high-dimensional points do not underflow.
+  const MatType invVar = 1.0 / variances;
+  arma::vec logNorms(means.n_cols);
+  for (size_t i = 0; i < means.n_cols; ++i)
+    logNorms[i] = std::log(probabilities[i]) -
+        0.5 * arma::accu(arma::log(variances.col(i)));
+
+  // The points are processed in blocks, which are split across threads.
+  const size_t blockSize = 1024;
+  const size_t blocks = (data.n_cols + blockSize - 1) / blockSize;
+
+  #pragma omp parallel for schedule(static)
+  for (size_t b = 0; b < blocks; ++b)
   {
-    // This is an adaptation of gmm::phi() for the case where the covariance is
-    // a diagonal matrix.
-    arma::mat diffs = data - arma::repmat(means.col(i), 1, data.n_cols);
-    arma::mat rhs = -0.5 * arma::diagmat(invVar.col(i)) * diffs;
-    arma::vec exponents(diffs.n_cols);
-    for (size_t j = 0; j < diffs.n_cols; ++j)
-      exponents(j) = std::exp(arma::accu(diffs.col(j) % rhs.unsafe_col(j)));
-
-    testProbs.col(i) += log(pow(2 * M_PI, (double) data.n_rows / -2.0) *
-        std::pow(arma::det(arma::diagmat(invVar.col(i))), -0.5) * exponents);
-  }
+    const size_t begin = b * blockSize;
+    const size_t count = std::min(blockSize, (size_t) data.n_cols - begin);
+    arma::mat testProbs(means.n_cols, count);
+    MatType diffs(data.n_rows, count);
+    for (size_t i = 0; i < means.n_cols; ++i)
+    {
+      for (size_t j = 0; j < count; ++j)
+        diffs.col(j) = data.col(begin + j) - means.col(i);
 
-  // Now calculate the label.
-  for (size_t i = 0; i < data.n_cols; ++i)
-  {
-    // Find the index of the class with maximum probability for this point.
-    arma::uword maxIndex = 0;
-    arma::vec pointProbs = testProbs.row(i).t();
-    pointProbs.max(maxIndex);
+      testProbs.row(i) = logNorms[i] - 0.5 * (invVar.col(i).t() *
+          arma::square(diffs));
+    }
 
-    results[i] = maxIndex;
+    // Now calculate the label of each point: the index of the class with
+    // maximum probability.
+    for (size_t j = 0; j < count; ++j)
+    {
+      arma::uword maxIndex = 0;
+      testProbs.unsafe_col(j).max(maxIndex);
+      results[begin + j] = maxIndex;
+    }
   }
-
-  return;
 }
 
 template<typename MatType>
@@ -214,6 +302,7 @@ void NaiveBayesClassifier<MatType>::Serialize(Archive& ar,
   ar & data::CreateNVP(means, "means");
   ar & data::CreateNVP(variances, "variances");
   ar & data::CreateNVP(probabilities, "probabilities");
+  ar & data::CreateNVP(trainingPoints, "trainingPoints");
 }
 
 } // namespace naive_bayes
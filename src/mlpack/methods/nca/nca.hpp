@@ -83,6 +83,11 @@ class NCA
   OptimizerType<SoftmaxErrorFunction<MetricType> >& Optimizer()
   { return optimizer; }
 
+  //! Get the number of neighbors the softmax is truncated to (0 means all).
+  size_t NumNeighbors() const { return errorFunction.NumNeighbors(); }
+  //! Modify the number of neighbors the softmax is truncated to (0 means all).
+  size_t& NumNeighbors() { return errorFunction.NumNeighbors(); }
+
   // Returns a string representation of this object.
   std::string ToString() const;
 
@@ -33,6 +33,11 @@ void NCA<MetricType, OptimizerType>::LearnDistance(arma::mat& outputMatrix)
       (outputMatrix.n_cols != dataset.n_rows))
     outputMatrix.eye(dataset.n_rows, dataset.n_rows);
 
+  if (errorFunction.NumNeighbors() != 0)
+    Log::Info << "Truncating the softmax to the "
+        << errorFunction.NumNeighbors() << " nearest neighbors of each point."
+        << std::endl;
+
   Timer::Start("nca_sgd_optimization");
 
   optimizer.Optimize(outputMatrix);
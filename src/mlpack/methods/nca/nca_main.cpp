@@ -90,6 +90,9 @@ PARAM_INT("max_line_search_trials", "Maximum number of line search trials for "
 PARAM_DOUBLE("min_step", "Minimum step of line search for L-BFGS.", "m", 1e-20);
 PARAM_DOUBLE("max_step", "Maximum step of line search for L-BFGS.", "M", 1e20);
 
+PARAM_INT("num_neighbors", "If nonzero, truncate the softmax of each point to "
+    "its k nearest neighbors in the projected space.", "k", 0);
+
 PARAM_INT("seed", "Random seed.  If 0, 'std::time(NULL)' is used.", "s", 0);
 
 
@@ -170,6 +173,12 @@ int main(int argc, char* argv[])
   const double minStep = CLI::GetParam<double>("min_step");
   const double maxStep = CLI::GetParam<double>("max_step");
 
+  if (CLI::GetParam<int>("num_neighbors") < 0)
+    Log::Fatal << "Invalid number of neighbors "
+        << CLI::GetParam<int>("num_neighbors") << "; must be nonnegative!"
+        << std::endl;
+  const size_t numNeighbors = (size_t) CLI::GetParam<int>("num_neighbors");
+
   // Load data.
   arma::mat data;
   data::Load(inputFile, data, true);
@@ -227,6 +236,7 @@ int main(int argc, char* argv[])
     nca.Optimizer().MaxIterations() = maxIterations;
     nca.Optimizer().Tolerance() = tolerance;
     nca.Optimizer().Shuffle() = shuffle;
+    nca.NumNeighbors() = numNeighbors;
 
     nca.LearnDistance(distance);
   }
@@ -241,6 +251,7 @@ int main(int argc, char* argv[])
     nca.Optimizer().MaxLineSearchTrials() = maxLineSearchTrials;
     nca.Optimizer().MinStep() = minStep;
     nca.Optimizer().MaxStep() = maxStep;
+    nca.NumNeighbors() = numNeighbors;
 
     nca.LearnDistance(distance);
   }
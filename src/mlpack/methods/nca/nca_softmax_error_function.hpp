@@ -9,6 +9,7 @@
 #define __MLPACK_METHODS_NCA_NCA_SOFTMAX_ERROR_FUNCTION_HPP
 
 #include <mlpack/core.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
 
 namespace mlpack {
 namespace nca {
@@ -32,6 +33,16 @@ namespace nca {
  * optimizers use, overloads of Evaluate() and Gradient() are given which only
  * operate on one point in the dataset.  This is useful for optimizers like
  * stochastic gradient descent (see mlpack::optimization::SGD).
+ *
+ * Since every p_ij depends on all of the points, each evaluation takes O(n^2)
+ * time (or O(n) time for one point).  For large datasets, the sums in p_ij can
+ * be truncated to the k nearest neighbors of x_i in the projected space, by
+ * setting NumNeighbors() to k; then, each evaluation only takes O(nk) time (or
+ * O(k) time for one point), plus the time to find the neighbors.  The
+ * neighbors are found with the Euclidean distance in the projected space (so
+ * they are exact for the default metric), and they are only found again when
+ * the projection has changed by more than NeighborTolerance() (relative to its
+ * Frobenius norm) since they were last found.
  */
 template<typename MetricType = metric::SquaredEuclideanDistance>
 class SoftmaxErrorFunction
@@ -97,6 +108,33 @@ class SoftmaxErrorFunction
                 const size_t i,
                 arma::mat& gradient);
 
+  /**
+   * Evaluate the softmax function and its gradient for the given covariance
+   * matrix at once.  This uses the cached precalculated values, so the p_i and
+   * the denominators of the p_ij are only computed once for both.
+   *
+   * @param covariance Covariance matrix of Mahalanobis distance.
+   * @param gradient Matrix to store the calculated gradient in.
+   * @return Objective at the given covariance matrix.
+   */
+  double EvaluateWithGradient(const arma::mat& covariance,
+                              arma::mat& gradient);
+
+  /**
+   * Evaluate the softmax objective function and its gradient for the given
+   * covariance matrix on only one point of the dataset at once.  The scan over
+   * the dataset (and the stretching of the dataset) is shared by both, so this
+   * takes about the time of one call to the separable Gradient().
+   *
+   * @param covariance Covariance matrix of Mahalanobis distance.
+   * @param i Index of point to use for the evaluation.
+   * @param gradient Matrix to store the calculated gradient in.
+   * @return Objective of the point at the given covariance matrix.
+   */
+  double EvaluateWithGradient(const arma::mat& covariance,
+                              const size_t i,
+                              arma::mat& gradient);
+
   /**
    * Get the initial point.
    */
@@ -108,6 +146,20 @@ class SoftmaxErrorFunction
    */
   size_t NumFunctions() const { return dataset.n_cols; }
 
+  //! Get the number of neighbors the softmax of each point is truncated to (0
+  //! means no truncation).
+  size_t NumNeighbors() const { return numNeighbors; }
+  //! Modify the number of neighbors the softmax of each point is truncated to
+  //! (0 means no truncation).
+  size_t& NumNeighbors() { return numNeighbors; }
+
+  //! Get the relative change of the projection above which the neighbors are
+  //! found again.
+  double NeighborTolerance() const { return neighborTolerance; }
+  //! Modify the relative change of the projection above which the neighbors
+  //! are found again.
+  double& NeighborTolerance() { return neighborTolerance; }
+
   // convert the obkect into a string
   std::string ToString() const;
 
@@ -133,6 +185,43 @@ class SoftmaxErrorFunction
   //! False if nothing has ever been precalculated (only at construction time).
   bool precalculated;
 
+  //! The number of neighbors the softmax is truncated to (0 for none).
+  size_t numNeighbors;
+  //! The relative change of the projection above which the neighbors are
+  //! found again.
+  double neighborTolerance;
+  //! The nearest neighbors of each point in the projected space, if the
+  //! softmax is truncated.
+  arma::Mat<size_t> neighbors;
+  //! The coordinates the neighbors were found with.
+  arma::mat neighborCoordinates;
+
+  /**
+   * Find the nearest neighbors of each point in the projected space again, if
+   * the softmax is truncated and the coordinates have changed by more than the
+   * neighbor tolerance since the neighbors were last found.
+   *
+   * @param coordinates Coordinates matrix to find the neighbors with.
+   * @return Whether or not the neighbors changed.
+   */
+  bool UpdateNeighbors(const arma::mat& coordinates);
+
+  /**
+   * Compute exp(-d(A x_i, A x_k)) for each point k that the softmax of point i
+   * is taken over: every other point, or, if the softmax is truncated, the
+   * nearest neighbors of point i.  This is used by the separable Evaluate()
+   * and Gradient().
+   *
+   * @param coordinates Coordinates matrix (A).
+   * @param i Index of the point.
+   * @param candidates Vector to store the indices of the points k in.
+   * @param evals Vector to store exp(-d(A x_i, A x_k)) in.
+   */
+  void PointKernels(const arma::mat& coordinates,
+                    const size_t i,
+                    arma::Col<size_t>& candidates,
+                    arma::vec& evals);
+
   /**
    * Precalculate the denominators and numerators that will make up the p_ij,
    * but only if the coordinates matrix is different than the last coordinates
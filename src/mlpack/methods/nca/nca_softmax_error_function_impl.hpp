@@ -22,7 +22,9 @@ SoftmaxErrorFunction<MetricType>::SoftmaxErrorFunction(
     dataset(dataset),
     labels(labels),
     metric(metric),
-    precalculated(false)
+    precalculated(false),
+    numNeighbors(0),
+    neighborTolerance(0.1)
 { /* nothing to do */ }
 
 //! The non-separable implementation, which uses Precalculate() to save time.
@@ -42,28 +44,22 @@ double SoftmaxErrorFunction<MetricType>::Evaluate(const arma::mat& coordinates,
                                                   const size_t i)
 {
   // Unfortunately each evaluation will take O(N) time because it requires a
-  // scan over all points in the dataset.  Our objective is to compute p_i.
+  // scan over all points in the dataset (or O(k) time, if the softmax is
+  // truncated).  Our objective is to compute p_i.
   double denominator = 0;
   double numerator = 0;
 
-  // It's quicker to do this now than one point at a time later.
-  stretchedDataset = coordinates * dataset;
+  arma::Col<size_t> candidates;
+  arma::vec evals;
+  PointKernels(coordinates, i, candidates, evals);
 
-  for (size_t k = 0; k < dataset.n_cols; ++k)
+  for (size_t c = 0; c < candidates.n_elem; ++c)
   {
-    // Don't consider the case where the points are the same.
-    if (k == i)
-      continue;
-
-    // We want to evaluate exp(-D(A x_i, A x_k)).
-    double eval = std::exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
-                                            stretchedDataset.unsafe_col(k)));
-
     // If they are in the same class, update the numerator.
-    if (labels[i] == labels[k])
-      numerator += eval;
+    if (labels[i] == labels[candidates[c]])
+      numerator += evals[c];
 
-    denominator += eval;
+    denominator += evals[c];
   }
 
   // Now the result is just a simple division, but we have to be sure that the
@@ -100,6 +96,33 @@ void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
   //     (p_i p_ik + p_k p_ki) x_ik x_ik^T
   arma::mat sum;
   sum.zeros(stretchedDataset.n_rows, stretchedDataset.n_rows);
+  if (numNeighbors != 0)
+  {
+    // With a truncated softmax, p_ik is only nonzero for the neighbors k of i,
+    // and p_ik and p_ki are no longer related, so each neighbor adds
+    //   (p_i - 1) p_ik x_ik x_ik^T   if i and k are in the same class, or
+    //   p_i p_ik x_ik x_ik^T         otherwise.
+    for (size_t i = 0; i < stretchedDataset.n_cols; i++)
+    {
+      for (size_t c = 0; c < neighbors.n_rows; c++)
+      {
+        const size_t k = neighbors(c, i);
+        const double eval = exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
+            stretchedDataset.unsafe_col(k)));
+        const double p_ik = eval / denominators(i);
+
+        const arma::vec x_ik = dataset.col(i) - dataset.col(k);
+        if (labels[i] == labels[k])
+          sum += ((p[i] - 1) * p_ik) * (x_ik * trans(x_ik));
+        else
+          sum += (p[i] * p_ik) * (x_ik * trans(x_ik));
+      }
+    }
+
+    gradient = -2 * coordinates * sum;
+    return;
+  }
+
   for (size_t i = 0; i < stretchedDataset.n_cols; i++)
   {
     for (size_t k = (i + 1); k < stretchedDataset.n_cols; k++)
@@ -126,11 +149,33 @@ void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
   gradient = -2 * coordinates * sum;
 }
 
-//! The separable implementation.
+//! The separable implementation, which is the fused one without the objective.
 template<typename MetricType>
 void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
                                                 const size_t i,
                                                 arma::mat& gradient)
+{
+  EvaluateWithGradient(coordinates, i, gradient);
+}
+
+//! The non-separable fused implementation, where Precalculate() is used.
+template<typename MetricType>
+double SoftmaxErrorFunction<MetricType>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    arma::mat& gradient)
+{
+  // The gradient computation does the precalculation, which also gives us p.
+  Gradient(coordinates, gradient);
+
+  return -accu(p); // Negate because the optimizer is a minimizer.
+}
+
+//! The separable fused implementation.
+template<typename MetricType>
+double SoftmaxErrorFunction<MetricType>::EvaluateWithGradient(
+    const arma::mat& coordinates,
+    const size_t i,
+    arma::mat& gradient)
 {
   // We will need to calculate p_i before this evaluation is done, so these two
   // variables will hold the information necessary for that.
@@ -145,18 +190,14 @@ void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
   firstTerm.zeros(coordinates.n_rows, coordinates.n_cols);
   secondTerm.zeros(coordinates.n_rows, coordinates.n_cols);
 
-  // Compute the stretched dataset.
-  stretchedDataset = coordinates * dataset;
+  arma::Col<size_t> candidates;
+  arma::vec evals;
+  PointKernels(coordinates, i, candidates, evals);
 
-  for (size_t k = 0; k < dataset.n_cols; ++k)
+  for (size_t c = 0; c < candidates.n_elem; ++c)
   {
-    // Don't consider the case where the points are the same.
-    if (i == k)
-      continue;
-
-    // Calculate the numerator of p_ik.
-    double eval = exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
-                                       stretchedDataset.unsafe_col(k)));
+    const size_t k = candidates[c];
+    const double eval = evals[c];
 
     // If the points are in the same class, we must add to the second term of
     // the gradient as well as the numerator of p_i.  We will divide by the
@@ -182,7 +223,7 @@ void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
     // If the denominator is zero, then all p_ik should be zero and there is
     // no gradient contribution from this point.
     gradient.zeros(coordinates.n_rows, coordinates.n_rows);
-    return;
+    return 0;
   }
   else
   {
@@ -194,6 +235,8 @@ void SoftmaxErrorFunction<MetricType>::Gradient(const arma::mat& coordinates,
   // Now multiply the first term by p_i, and add the two together and multiply
   // all by 2 * A.  We negate it though, because our optimizer is a minimizer.
   gradient = -2 * coordinates * (p * firstTerm - secondTerm);
+
+  return -p; // Negate because the optimizer is a minimizer.
 }
 
 template<typename MetricType>
@@ -209,9 +252,13 @@ void SoftmaxErrorFunction<MetricType>::Precalculate(
   // Ensure it is the right size.
   lastCoordinates.set_size(coordinates.n_rows, coordinates.n_cols);
 
+  // Find the neighbors again, if the softmax is truncated and the coordinates
+  // have moved far enough.
+  const bool neighborsChanged = UpdateNeighbors(coordinates);
+
   // Make sure the calculation is necessary.
   if ((accu(coordinates == lastCoordinates) == coordinates.n_elem) &&
-      precalculated)
+      precalculated && !neighborsChanged)
     return; // No need to calculate; we already have this stuff saved.
 
   // Coordinates are different; save the new ones, and stretch the dataset.
@@ -226,23 +273,44 @@ void SoftmaxErrorFunction<MetricType>::Precalculate(
   // order of O((n * (n + 1)) / 2), which really isn't all that great.
   p.zeros(stretchedDataset.n_cols);
   denominators.zeros(stretchedDataset.n_cols);
-  for (size_t i = 0; i < stretchedDataset.n_cols; i++)
+  if (numNeighbors != 0)
   {
-    for (size_t j = (i + 1); j < stretchedDataset.n_cols; j++)
+    // With a truncated softmax, only the neighbors of each point are summed
+    // over, which takes O(nk) time.
+    for (size_t i = 0; i < stretchedDataset.n_cols; i++)
     {
-      // Evaluate exp(-d(x_i, x_j)).
-      double eval = exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
-                                         stretchedDataset.unsafe_col(j)));
-
-      // Add this to the denominators of both p_i and p_j: K(i, j) = K(j, i).
-      denominators[i] += eval;
-      denominators[j] += eval;
+      for (size_t c = 0; c < neighbors.n_rows; c++)
+      {
+        const size_t j = neighbors(c, i);
+        const double eval = exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
+            stretchedDataset.unsafe_col(j)));
 
-      // If i and j are the same class, add to numerator of both.
-      if (labels[i] == labels[j])
+        denominators[i] += eval;
+        if (labels[i] == labels[j])
+          p[i] += eval;
+      }
+    }
+  }
+  else
+  {
+    for (size_t i = 0; i < stretchedDataset.n_cols; i++)
+    {
+      for (size_t j = (i + 1); j < stretchedDataset.n_cols; j++)
       {
-        p[i] += eval;
-        p[j] += eval;
+        // Evaluate exp(-d(x_i, x_j)).
+        double eval = exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
+                                           stretchedDataset.unsafe_col(j)));
+
+        // Add this to the denominators of both p_i and p_j: K(i, j) = K(j, i).
+        denominators[i] += eval;
+        denominators[j] += eval;
+
+        // If i and j are the same class, add to numerator of both.
+        if (labels[i] == labels[j])
+        {
+          p[i] += eval;
+          p[j] += eval;
+        }
       }
     }
   }
@@ -267,6 +335,97 @@ void SoftmaxErrorFunction<MetricType>::Precalculate(
   precalculated = true;
 }
 
+template<typename MetricType>
+bool SoftmaxErrorFunction<MetricType>::UpdateNeighbors(
+    const arma::mat& coordinates)
+{
+  if (numNeighbors == 0)
+  {
+    // Forget any neighbors from before the softmax was no longer truncated.
+    if (neighbors.n_elem == 0)
+      return false;
+
+    neighbors.reset();
+    neighborCoordinates.reset();
+    return true;
+  }
+
+  if (numNeighbors >= dataset.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "SoftmaxErrorFunction::UpdateNeighbors(): number of neighbors ("
+        << numNeighbors << ") must be less than the number of points ("
+        << dataset.n_cols << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // The neighbors are still good enough if the projection hasn't changed much.
+  if ((neighbors.n_rows == numNeighbors) &&
+      (neighborCoordinates.n_rows == coordinates.n_rows) &&
+      (neighborCoordinates.n_cols == coordinates.n_cols) &&
+      (arma::norm(coordinates - neighborCoordinates, "fro") <=
+       neighborTolerance * arma::norm(neighborCoordinates, "fro")))
+    return false;
+
+  neighborCoordinates = coordinates;
+
+  // Search the projected dataset for the nearest neighbors of each point.  The
+  // search excludes the point itself.
+  neighbor::AllkNN knn(arma::mat(coordinates * dataset));
+  arma::mat distances;
+  knn.Search(numNeighbors, neighbors, distances);
+
+  Log::Debug << "SoftmaxErrorFunction: found " << numNeighbors << " nearest "
+      << "neighbors of each point in the projected space." << std::endl;
+
+  return true;
+}
+
+template<typename MetricType>
+void SoftmaxErrorFunction<MetricType>::PointKernels(
+    const arma::mat& coordinates,
+    const size_t i,
+    arma::Col<size_t>& candidates,
+    arma::vec& evals)
+{
+  if (numNeighbors != 0)
+  {
+    // Only the neighbors of point i are needed, so only they are stretched.
+    UpdateNeighbors(coordinates);
+    const arma::vec stretchedPoint = coordinates * dataset.col(i);
+
+    candidates = neighbors.col(i);
+    evals.set_size(candidates.n_elem);
+    for (size_t c = 0; c < candidates.n_elem; ++c)
+    {
+      const arma::vec stretchedNeighbor = coordinates *
+          dataset.col(candidates[c]);
+      evals[c] = std::exp(-metric.Evaluate(stretchedPoint, stretchedNeighbor));
+    }
+
+    return;
+  }
+
+  // It's quicker to do this now than one point at a time later.
+  stretchedDataset = coordinates * dataset;
+
+  candidates.set_size(dataset.n_cols - 1);
+  evals.set_size(dataset.n_cols - 1);
+  size_t c = 0;
+  for (size_t k = 0; k < dataset.n_cols; ++k)
+  {
+    // Don't consider the case where the points are the same.
+    if (k == i)
+      continue;
+
+    // We want to evaluate exp(-D(A x_i, A x_k)).
+    candidates[c] = k;
+    evals[c] = std::exp(-metric.Evaluate(stretchedDataset.unsafe_col(i),
+                                         stretchedDataset.unsafe_col(k)));
+    ++c;
+  }
+}
+
 template<typename MetricType>
 std::string SoftmaxErrorFunction<MetricType>::ToString() const{
   std::ostringstream convert;
@@ -276,6 +435,7 @@ std::string SoftmaxErrorFunction<MetricType>::ToString() const{
   convert << "  Labels: " << labels.n_elem << std::endl;
   //convert << "Metric: " << metric << std::endl;
   convert << "  Precalculated: " << precalculated << std::endl;
+  convert << "  Neighbors: " << numNeighbors << std::endl;
   return convert.str();
 }
 
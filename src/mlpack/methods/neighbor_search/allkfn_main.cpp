@@ -62,7 +62,7 @@ PARAM_INT("k", "Number of furthest neighbors to find.", "k", 0);
 // The user may specify the type of tree to use, and a few pararmeters for tree
 // building.
 PARAM_STRING("tree_type", "Type of tree to use: 'kd', 'cover', 'r', 'r-star', "
-    "'ball'.", "t", "kd");
+    "'ball', 'vp'.", "t", "kd");
 PARAM_INT("leaf_size", "Leaf size for tree building.", "l", 20);
 PARAM_FLAG("random_basis", "Before tree-building, project the data onto a "
     "random orthogonal basis.", "R");
@@ -72,6 +72,8 @@ PARAM_INT("seed", "Random seed (if 0, std::time(NULL) is used).", "s", 0);
 PARAM_FLAG("naive", "If true, O(n^2) naive mode is used for computation.", "N");
 PARAM_FLAG("single_mode", "If true, single-tree search is used (as opposed to "
     "dual-tree search).", "s");
+PARAM_FLAG("parallel", "If true, tree-based search is split across multiple "
+    "threads (only available if mlpack was compiled with OpenMP).", "P");
 
 // Convenience typedef.
 typedef NSModel<FurthestNeighborSort> KFNModel;
@@ -160,9 +162,11 @@ int main(int argc, char *argv[])
       tree = KFNModel::R_STAR_TREE;
     else if (treeType == "ball")
       tree = KFNModel::BALL_TREE;
+    else if (treeType == "vp")
+      tree = KFNModel::VP_TREE;
     else
       Log::Fatal << "Unknown tree type '" << treeType << "'; valid choices are "
-          << "'kd', 'cover', 'r', 'r-star', and 'ball'." << endl;
+          << "'kd', 'cover', 'r', 'r-star', 'ball', and 'vp'." << endl;
 
     kfn.TreeType() = tree;
     kfn.RandomBasis() = randomBasis;
@@ -191,6 +195,9 @@ int main(int argc, char *argv[])
     kfn.LeafSize() = size_t(lsInt);
   }
 
+  // Set whether or not the search should be parallelized.
+  kfn.Parallel() = CLI::HasParam("parallel");
+
   // Perform search, if desired.
   if (CLI::HasParam("k"))
   {
@@ -6,11 +6,15 @@
  * options.
  */
 #include <mlpack/core.hpp>
+#include <mlpack/core/data/mapped_matrix.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
 
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <memory>
 
 #include "neighbor_search.hpp"
 #include "unmap.hpp"
@@ -41,11 +45,26 @@ PROGRAM_INFO("k-Nearest-Neighbors",
     "neighbors output file corresponds to the index of the point in the "
     "reference set which is the i'th nearest neighbor from the point in the "
     "query set with index j.  Row i and column j in the distances output file "
-    "corresponds to the distance between those two points.");
+    "corresponds to the distance between those two points."
+    "\n\n"
+    "If --batch_mode is specified, the model is kept in memory and batches of "
+    "query points are read from standard input until it is closed, so that "
+    "many small searches can be served without reloading the model.  Each "
+    "query point is given on one line as comma- or whitespace-separated "
+    "values, and a batch is terminated by an empty line.  For each batch, one line is "
+    "written to standard output for each query point, holding the indices of "
+    "its k neighbors followed by the k distances, and the results of the batch "
+    "are terminated by an empty line.  Batches with at least "
+    "--dual_tree_min_batch points are searched with dual-tree search; smaller "
+    "batches use single-tree search.  Note that with --verbose, informational "
+    "output (prefixed with '[INFO ]') is also written to standard output.");
 
 // Define our input parameters that this program will take.
 PARAM_STRING("reference_file", "File containing the reference dataset.", "r",
     "");
+PARAM_FLAG("mmap_reference", "If true, the reference file is memory-mapped "
+    "instead of loaded.  It must be in Armadillo binary format, with one point "
+    "per column (i.e., not transposed).", "x");
 PARAM_STRING("distances_file", "File to output distances into.", "d", "");
 PARAM_STRING("neighbors_file", "File to output neighbors into.", "n", "");
 
@@ -63,9 +82,19 @@ PARAM_INT("k", "Number of nearest neighbors to find.", "k", 0);
 // The user may specify the type of tree to use, and a few parameters for tree
 // building.
 PARAM_STRING("tree_type", "Type of tree to use: 'kd', 'cover', 'r', 'r-star', "
-    "'ball'.", "t", "kd");
+    "'ball', 'vp', 'spill', or 'auto'.  Search with spill trees is "
+    "approximate.  With 'auto', the tree type and leaf size with the fastest "
+    "trial search on samples of the data are used (and saved with the model), "
+    "and --leaf_size is ignored.", "t", "kd");
+PARAM_INT("auto_sample_size", "Number of points sampled from the reference "
+    "and query sets for the trial searches of --tree_type 'auto'.", "A", 1000);
 PARAM_INT("leaf_size", "Leaf size for tree building (used for kd-trees, R "
-    "trees, and R* trees).", "l", 20);
+    "trees, R* trees, and spill trees).", "l", 20);
+PARAM_DOUBLE("tau", "Width of the overlap buffer around the splitting "
+    "hyperplanes of spill trees; larger values give more accurate but slower "
+    "search.", "u", 0.0);
+PARAM_DOUBLE("rho", "Largest fraction of the points of a spill tree node that "
+    "a child of an overlapping node may hold (between 0 and 1).", "o", 0.7);
 PARAM_FLAG("random_basis", "Before tree-building, project the data onto a "
     "random orthogonal basis.", "R");
 PARAM_INT("seed", "Random seed (if 0, std::time(NULL) is used).", "s", 0);
@@ -74,10 +103,232 @@ PARAM_INT("seed", "Random seed (if 0, std::time(NULL) is used).", "s", 0);
 PARAM_FLAG("naive", "If true, O(n^2) naive mode is used for computation.", "N");
 PARAM_FLAG("single_mode", "If true, single-tree search is used (as opposed to "
     "dual-tree search).", "S");
+PARAM_FLAG("parallel", "If true, tree-based search is split across multiple "
+    "threads (only available if mlpack was compiled with OpenMP).", "P");
+PARAM_DOUBLE("epsilon", "If greater than 0, tree-based search is approximate: "
+    "each returned neighbor distance is at most (1 + epsilon) times the true "
+    "neighbor distance.", "e", 0.0);
+PARAM_FLAG("best_first", "If true, single-tree search expands the most "
+    "promising node first (instead of searching depth-first).", "F");
+PARAM_INT("max_visits", "If greater than 0, best-first search expands at most "
+    "this many nodes for each query point, so the results are approximate.",
+    "X", 0);
+PARAM_FLAG("reorder_queries", "If true, single-tree search processes the "
+    "query points in a spatial order, so that consecutive query points visit "
+    "mostly the same parts of the reference tree.", "O");
+
+PARAM_FLAG("float", "If true, the reference and query sets are loaded and "
+    "searched in single precision.  Only kd-trees are supported, and model "
+    "files given with --input_model_file or --output_model_file are "
+    "single-precision models.", "f");
+
+// Settings for serving batches of queries.
+PARAM_FLAG("batch_mode", "If true, batches of query points are read from "
+    "standard input and the results are written to standard output (see "
+    "above).", "B");
+PARAM_INT("dual_tree_min_batch", "In batch mode, the minimum number of points "
+    "in a batch for dual-tree search to be used.", "b", 500);
 
 // Convenience typedef.
 typedef NSModel<NearestNeighborSort> KNNModel;
 
+// Convenience typedef for single-precision search.
+typedef NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::fmat,
+    KDTree> FloatKNN;
+
+/**
+ * Perform the search in single precision, with kd-trees.  NSModel only holds
+ * double-precision datasets, so a FloatKNN object is used (and saved) instead.
+ * The reference tree is built with the default leaf size.  The search settings
+ * (--naive, --single_mode, --parallel, --epsilon, --best_first, --max_visits
+ * and --reorder_queries) are all given to FloatKNN; the options for other tree
+ * types are rejected.
+ */
+void FloatSearch()
+{
+  if (CLI::HasParam("tree_type") && CLI::GetParam<string>("tree_type") != "kd")
+    Log::Fatal << "Only kd-trees are supported with --float; --tree_type must "
+        << "be 'kd'." << endl;
+  if (CLI::HasParam("tau") || CLI::HasParam("rho"))
+    Log::Fatal << "--tau (-u) and --rho (-o) are only used by spill trees, "
+        << "which are not supported with --float." << endl;
+  if (CLI::HasParam("auto_sample_size"))
+    Log::Fatal << "--auto_sample_size (-A) is only used with --tree_type "
+        << "'auto', which is not supported with --float." << endl;
+  if (CLI::HasParam("leaf_size"))
+    Log::Warn << "--leaf_size (-l) will be ignored because --float is "
+        << "specified." << endl;
+  if (CLI::HasParam("random_basis"))
+    Log::Warn << "--random_basis (-R) will be ignored because --float is "
+        << "specified." << endl;
+  if (CLI::HasParam("batch_mode") || CLI::HasParam("mmap_reference"))
+    Log::Fatal << "--batch_mode and --mmap_reference are not supported with "
+        << "--float." << endl;
+
+  FloatKNN knn;
+  if (CLI::HasParam("reference_file"))
+  {
+    const string referenceFile = CLI::GetParam<string>("reference_file");
+    arma::fmat referenceSet;
+    data::Load(referenceFile, referenceSet, true);
+
+    Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+        << referenceSet.n_rows << " x " << referenceSet.n_cols << ")."
+        << endl;
+
+    knn.Naive() = CLI::HasParam("naive");
+    knn.SingleMode() = CLI::HasParam("single_mode");
+    knn.Train(std::move(referenceSet));
+  }
+  else
+  {
+    const string inputModelFile = CLI::GetParam<string>("input_model_file");
+    data::Load(inputModelFile, "knn_model", knn, true); // Fatal on failure.
+
+    Log::Info << "Loaded single-precision kNN model from '" << inputModelFile
+        << "' (trained on " << knn.ReferenceSet().n_rows << "x"
+        << knn.ReferenceSet().n_cols << " dataset)." << endl;
+
+    knn.SingleMode() = CLI::HasParam("single_mode");
+    knn.Naive() = CLI::HasParam("naive");
+  }
+
+  knn.Parallel() = CLI::HasParam("parallel");
+  knn.Epsilon() = CLI::GetParam<double>("epsilon");
+  knn.BestFirst() = CLI::HasParam("best_first");
+  knn.ReorderQueries() = CLI::HasParam("reorder_queries");
+  knn.MaxVisits() = (size_t) CLI::GetParam<int>("max_visits");
+
+  if (CLI::HasParam("k"))
+  {
+    const size_t k = (size_t) CLI::GetParam<int>("k");
+    if (CLI::GetParam<int>("k") < 1 || k > knn.ReferenceSet().n_cols)
+      Log::Fatal << "Invalid k: " << k << "; must be greater than 0 and less "
+          << "than or equal to the number of reference points ("
+          << knn.ReferenceSet().n_cols << ")." << endl;
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    if (CLI::HasParam("query_file"))
+    {
+      const string queryFile = CLI::GetParam<string>("query_file");
+      arma::fmat queryData;
+      data::Load(queryFile, queryData, true);
+      Log::Info << "Loaded query data from '" << queryFile << "' ("
+          << queryData.n_rows << "x" << queryData.n_cols << ")." << endl;
+
+      knn.Search(queryData, k, neighbors, distances);
+    }
+    else
+    {
+      knn.Search(k, neighbors, distances);
+    }
+    Log::Info << "Search complete." << endl;
+
+    Memory::Report("knn_model", knn.MemoryUsage());
+    Memory::Report("neighbors", MemoryUsage(neighbors));
+    Memory::Report("distances", MemoryUsage(distances));
+
+    // The distances are computed in single precision, so save them that way.
+    if (CLI::HasParam("neighbors_file"))
+      data::Save(CLI::GetParam<string>("neighbors_file"), neighbors);
+    if (CLI::HasParam("distances_file"))
+      data::Save(CLI::GetParam<string>("distances_file"),
+          arma::conv_to<arma::fmat>::from(distances));
+  }
+
+  if (CLI::HasParam("output_model_file"))
+    data::Save(CLI::GetParam<string>("output_model_file"), "knn_model", knn);
+}
+
+/**
+ * Read one batch of query points from the given stream.  Each line holds one
+ * point, and the batch ends with an empty line or the end of the stream.  Lines
+ * that do not have the right dimensionality are skipped with a warning, so the
+ * batch may be empty.  Returns false if the stream ended before any lines of a
+ * batch were read.
+ */
+bool ReadBatch(istream& stream, const size_t dimensionality, arma::mat& batch)
+{
+  vector<double> values;
+  size_t numPoints = 0;
+  size_t numLines = 0;
+  string line;
+  while (getline(stream, line))
+  {
+    if (line.find_first_not_of(" \t\r") == string::npos)
+    {
+      if (numLines == 0)
+        continue; // Skip leading empty lines.
+      else
+        break;
+    }
+
+    ++numLines;
+
+    // Commas are treated as whitespace.
+    replace(line.begin(), line.end(), ',', ' ');
+    istringstream lineStream(line);
+    vector<double> point;
+    double value;
+    while (lineStream >> value)
+      point.push_back(value);
+
+    if (point.size() != dimensionality)
+    {
+      Log::Warn << "Skipping query point with dimensionality " << point.size()
+          << " (expected " << dimensionality << ")." << endl;
+      continue;
+    }
+
+    values.insert(values.end(), point.begin(), point.end());
+    ++numPoints;
+  }
+
+  batch = arma::mat(values.data(), dimensionality, numPoints);
+  return (numLines > 0);
+}
+
+/**
+ * Select the tree type and leaf size of the model with trial searches on
+ * samples of the data, for --tree_type 'auto'.  The query set (if there is
+ * one) is loaded here, since it is needed for the trials.
+ */
+void SelectTree(KNNModel& knn,
+                const arma::mat& referenceSet,
+                const bool singleMode,
+                arma::mat& queryData,
+                bool& queryLoaded)
+{
+  if (CLI::HasParam("query_file") && !CLI::HasParam("batch_mode"))
+  {
+    const string queryFile = CLI::GetParam<string>("query_file");
+    data::Load(queryFile, queryData, true);
+    Log::Info << "Loaded query data from '" << queryFile << "' ("
+        << queryData.n_rows << "x" << queryData.n_cols << ")." << endl;
+    queryLoaded = true;
+  }
+
+  // If no search is done, the trials search for one neighbor.
+  const size_t k = (CLI::GetParam<int>("k") > 0) ?
+      (size_t) CLI::GetParam<int>("k") : 1;
+
+  Timer::Start("tree_selection");
+  try
+  {
+    knn.SelectTree(referenceSet, queryLoaded ? &queryData : NULL, k,
+        singleMode, (size_t) CLI::GetParam<int>("auto_sample_size"));
+  }
+  catch (std::invalid_argument& e)
+  {
+    Log::Fatal << e.what() << "." << endl;
+  }
+  Timer::Stop("tree_selection");
+
+  Log::Info << "Selected " << knn.TreeName() << " with leaf size "
+      << knn.LeafSize() << "." << endl;
+}
+
 int main(int argc, char *argv[])
 {
   // Give CLI the command line parameters the user passed in.
@@ -110,6 +361,9 @@ int main(int argc, char *argv[])
     if (CLI::HasParam("random_basis"))
       Log::Warn << "--random_basis (-R) will be ignored because "
           << "--input_model_file is specified." << endl;
+    if (CLI::HasParam("tau") || CLI::HasParam("rho"))
+      Log::Warn << "--tau (-u) and --rho (-o) will be ignored because "
+          << "--input_model_file is specified." << endl;
     if (CLI::HasParam("naive"))
       Log::Warn << "--naive (-N) will be ignored because --input_model_file is "
           << "specified." << endl;
@@ -121,7 +375,7 @@ int main(int argc, char *argv[])
         << "results from this program will be saved!" << endl;
 
   // If the user specifies k but no output files, they should be warned.
-  if (CLI::HasParam("k") &&
+  if (CLI::HasParam("k") && !CLI::HasParam("batch_mode") &&
       !(CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file")))
     Log::Warn << "Neither --neighbors_file nor --distances_file is specified, "
         << "so the nearest neighbor search results will not be saved!" << endl;
@@ -142,10 +396,48 @@ int main(int argc, char *argv[])
         "than 0." << endl;
   }
 
+  // Sanity check on epsilon.
+  const double epsilon = CLI::GetParam<double>("epsilon");
+  if (epsilon < 0)
+    Log::Fatal << "Invalid epsilon: " << epsilon << ".  Must be nonnegative."
+        << endl;
+  if (epsilon > 0 && CLI::HasParam("naive"))
+    Log::Warn << "--epsilon ignored because --naive is present." << endl;
+
+  // Sanity check on the best-first search settings.
+  const int maxVisits = CLI::GetParam<int>("max_visits");
+  if (maxVisits < 0)
+    Log::Fatal << "Invalid maximum number of visits: " << maxVisits << ".  "
+        << "Must be nonnegative." << endl;
+  if (maxVisits > 0 && !CLI::HasParam("best_first"))
+    Log::Warn << "--max_visits ignored because --best_first is not present."
+        << endl;
+  if (CLI::HasParam("best_first") && !CLI::HasParam("single_mode"))
+    Log::Warn << "--best_first ignored because --single_mode is not present."
+        << endl;
+  if (CLI::HasParam("reorder_queries") && !CLI::HasParam("single_mode"))
+    Log::Warn << "--reorder_queries ignored because --single_mode is not "
+        << "present." << endl;
+
+  // Single-precision search is handled separately.
+  if (CLI::HasParam("float"))
+  {
+    FloatSearch();
+    return 0;
+  }
+
+  // If the reference set is memory-mapped, the mapping must outlive the model,
+  // which will use the mapped memory directly.
+  std::unique_ptr<data::MappedMatrix> mappedReference;
+
   // We either have to load the reference data, or we have to load the model.
   NSModel<NearestNeighborSort> knn;
   const bool naive = CLI::HasParam("naive");
   const bool singleMode = CLI::HasParam("single_mode");
+
+  // The query set is loaded early if it is needed to select the tree type.
+  arma::mat queryData;
+  bool queryLoaded = false;
   if (CLI::HasParam("reference_file"))
   {
     // Get all the parameters.
@@ -154,7 +446,10 @@ int main(int argc, char *argv[])
     const bool randomBasis = CLI::HasParam("random_basis");
 
     int tree = 0;
-    if (treeType == "kd")
+    const bool selectTree = (treeType == "auto");
+    if (selectTree)
+      tree = KNNModel::KD_TREE;
+    else if (treeType == "kd")
       tree = KNNModel::KD_TREE;
     else if (treeType == "cover")
       tree = KNNModel::COVER_TREE;
@@ -164,21 +459,87 @@ int main(int argc, char *argv[])
       tree = KNNModel::R_STAR_TREE;
     else if (treeType == "ball")
       tree = KNNModel::BALL_TREE;
+    else if (treeType == "vp")
+      tree = KNNModel::VP_TREE;
+    else if (treeType == "spill")
+      tree = KNNModel::SPILL_TREE;
     else
       Log::Fatal << "Unknown tree type '" << treeType << "'; valid choices are "
-          << "'kd', 'cover', 'r', 'r-star', and 'ball'." << endl;
+          << "'kd', 'cover', 'r', 'r-star', 'ball', 'vp', 'spill', and 'auto'."
+          << endl;
+
+    if (selectTree && naive)
+      Log::Warn << "--tree_type 'auto' ignored because --naive is present."
+          << endl;
+    if (selectTree && CLI::HasParam("leaf_size"))
+      Log::Warn << "--leaf_size (-l) ignored because --tree_type is 'auto'."
+          << endl;
+    if (!selectTree && CLI::HasParam("auto_sample_size"))
+      Log::Warn << "--auto_sample_size (-A) ignored because --tree_type is not "
+          << "'auto'." << endl;
+    if (CLI::GetParam<int>("auto_sample_size") < 2)
+      Log::Fatal << "Invalid --auto_sample_size: "
+          << CLI::GetParam<int>("auto_sample_size") << "; must be at least 2."
+          << endl;
+
+    if (tree != KNNModel::SPILL_TREE && (CLI::HasParam("tau") ||
+        CLI::HasParam("rho")))
+      Log::Warn << "--tau (-u) and --rho (-o) are only used with spill trees."
+          << endl;
+
+    const double tau = CLI::GetParam<double>("tau");
+    const double rho = CLI::GetParam<double>("rho");
+    if (tau < 0)
+      Log::Fatal << "Invalid tau: " << tau << ".  Must be nonnegative." << endl;
+    if (rho <= 0 || rho >= 1)
+      Log::Fatal << "Invalid rho: " << rho << ".  Must be between 0 and 1."
+          << endl;
 
     knn.TreeType() = tree;
     knn.RandomBasis() = randomBasis;
+    knn.Tau() = tau;
+    knn.Rho() = rho;
 
-    arma::mat referenceSet;
-    data::Load(referenceFile, referenceSet, true);
+    if (CLI::HasParam("mmap_reference"))
+    {
+      try
+      {
+        mappedReference.reset(new data::MappedMatrix(referenceFile));
+      }
+      catch (std::runtime_error& e)
+      {
+        Log::Fatal << e.what() << "." << endl;
+      }
+
+      Log::Info << "Mapped reference data from '" << referenceFile << "' ("
+          << mappedReference->Matrix().n_rows << " x "
+          << mappedReference->Matrix().n_cols << ")." << endl;
+
+      if (selectTree && !naive)
+        SelectTree(knn, mappedReference->Matrix(), singleMode, queryData,
+            queryLoaded);
+
+      // The model will take the mapped memory without copying it.
+      knn.BuildModel(std::move(mappedReference->Matrix()),
+          (selectTree && !naive) ? knn.LeafSize() : size_t(lsInt), naive,
+          singleMode);
+    }
+    else
+    {
+      arma::mat referenceSet;
+      data::Load(referenceFile, referenceSet, true);
 
-    Log::Info << "Loaded reference data from '" << referenceFile << "' ("
-        << referenceSet.n_rows << " x " << referenceSet.n_cols << ")."
-        << endl;
+      Log::Info << "Loaded reference data from '" << referenceFile << "' ("
+          << referenceSet.n_rows << " x " << referenceSet.n_cols << ")."
+          << endl;
 
-    knn.BuildModel(std::move(referenceSet), size_t(lsInt), naive, singleMode);
+      if (selectTree && !naive)
+        SelectTree(knn, referenceSet, singleMode, queryData, queryLoaded);
+
+      knn.BuildModel(std::move(referenceSet),
+          (selectTree && !naive) ? knn.LeafSize() : size_t(lsInt), naive,
+          singleMode);
+    }
   }
   else
   {
@@ -193,17 +554,96 @@ int main(int argc, char *argv[])
     // Adjust singleMode and naive if necessary.
     knn.SingleMode() = CLI::HasParam("single_mode");
     knn.Naive() = CLI::HasParam("naive");
-    knn.LeafSize() = size_t(lsInt);
+
+    // The model holds the leaf size it was built with.
+    if (CLI::HasParam("leaf_size"))
+      knn.LeafSize() = size_t(lsInt);
   }
 
+  // Set whether or not the search should be parallelized.
+  knn.Parallel() = CLI::HasParam("parallel");
+
+  // Set the approximation level; 0 gives exact search.
+  knn.Epsilon() = epsilon;
+
+  // Set the order in which single-tree search expands nodes.
+  knn.BestFirst() = CLI::HasParam("best_first");
+  knn.ReorderQueries() = CLI::HasParam("reorder_queries");
+  knn.MaxVisits() = size_t(maxVisits);
+
+  // Serve batches of queries, if desired.
+  if (CLI::HasParam("batch_mode"))
+  {
+    const size_t k = (size_t) CLI::GetParam<int>("k");
+    if (!CLI::HasParam("k") || CLI::GetParam<int>("k") < 1 ||
+        k > knn.Dataset().n_cols)
+      Log::Fatal << "In batch mode, k (--k) must be specified, and must be "
+          << "greater than 0 and less than or equal to the number of reference "
+          << "points (" << knn.Dataset().n_cols << ")." << endl;
+
+    if (CLI::GetParam<int>("dual_tree_min_batch") < 1)
+      Log::Fatal << "Invalid --dual_tree_min_batch: "
+          << CLI::GetParam<int>("dual_tree_min_batch") << "; must be greater "
+          << "than 0." << endl;
+    const size_t dualTreeMinBatch =
+        (size_t) CLI::GetParam<int>("dual_tree_min_batch");
+
+    if (CLI::HasParam("query_file") || CLI::HasParam("neighbors_file") ||
+        CLI::HasParam("distances_file"))
+      Log::Warn << "--query_file, --neighbors_file, and --distances_file are "
+          << "ignored in batch mode." << endl;
+
+    size_t numBatches = 0;
+    arma::mat batch;
+    while (ReadBatch(cin, knn.Dataset().n_rows, batch))
+    {
+      // Every batch gets a response, even if none of its points were valid.
+      if (batch.n_cols == 0)
+      {
+        cout << endl << flush;
+        ++numBatches;
+        continue;
+      }
+
+      arma::Mat<size_t> neighbors;
+      arma::mat distances;
+
+      // The Timer accumulates across batches, so we take the difference to get
+      // the latency of this batch.
+      const timeval before = Timer::Get("batch_search");
+      Timer::Start("batch_search");
+      const size_t batchSize = batch.n_cols;
+      knn.SearchBatch(std::move(batch), k, neighbors, distances,
+          dualTreeMinBatch);
+      Timer::Stop("batch_search");
+      const timeval after = Timer::Get("batch_search");
+      const double latency = (after.tv_sec - before.tv_sec) +
+          (after.tv_usec - before.tv_usec) / 1e6;
+
+      for (size_t i = 0; i < neighbors.n_cols; ++i)
+      {
+        for (size_t j = 0; j < k; ++j)
+          cout << neighbors(j, i) << ", ";
+        for (size_t j = 0; j + 1 < k; ++j)
+          cout << distances(j, i) << ", ";
+        cout << distances(k - 1, i) << endl;
+      }
+      cout << endl << flush;
+
+      Log::Info << "Batch " << numBatches << ": searched " << batchSize
+          << " points in " << latency << "s." << endl;
+      ++numBatches;
+    }
+
+    Log::Info << "Served " << numBatches << " batches." << endl;
+  }
   // Perform search, if desired.
-  if (CLI::HasParam("k"))
+  else if (CLI::HasParam("k"))
   {
     const string queryFile = CLI::GetParam<string>("query_file");
     const size_t k = (size_t) CLI::GetParam<int>("k");
 
-    arma::mat queryData;
-    if (queryFile != "")
+    if (queryFile != "" && !queryLoaded)
     {
       data::Load(queryFile, queryData, true);
       Log::Info << "Loaded query data from '" << queryFile << "' ("
@@ -236,6 +676,10 @@ int main(int argc, char *argv[])
       knn.Search(k, neighbors, distances);
     Log::Info << "Search complete." << endl;
 
+    Memory::Report("knn_model", knn.MemoryUsage());
+    Memory::Report("neighbors", MemoryUsage(neighbors));
+    Memory::Report("distances", MemoryUsage(distances));
+
     // Save output, if desired.
     if (CLI::HasParam("neighbors_file"))
       data::Save(CLI::GetParam<string>("neighbors_file"), neighbors);
@@ -0,0 +1,537 @@
+/**
+ * @file allknn_mpi_main.cpp
+ * @author Ryan Curtin
+ *
+ * Distributed all-k-nearest-neighbors search with MPI: the reference set is
+ * split spatially across the ranks, and each query point is only sent to the
+ * ranks whose partitions could hold one of its nearest neighbors.
+ */
+#include <mpi.h>
+
+#include <mlpack/core.hpp>
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <climits>
+
+#include "partitioned_neighbor_search.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+// Information about the program itself.
+PROGRAM_INFO("Distributed k-Nearest-Neighbors",
+    "This program calculates the k-nearest-neighbors of a set of points, like "
+    "allknn, but with the reference set split across the ranks of an MPI job, "
+    "so that the trees of the whole reference set do not have to fit on one "
+    "node.  It is run with mpirun (or the launcher of the MPI installation); "
+    "for example, the following calculates the 5 nearest neighbors of each "
+    "point in 'query.csv' among the points of 'reference.bin' on 16 ranks:"
+    "\n\n"
+    "$ mpirun -n 16 allknn_mpi --k=5 --reference_file=reference.bin\n"
+    "  --query_file=query.csv --distances_file=distances.csv\n"
+    "  --neighbors_file=neighbors.csv"
+    "\n\n"
+    "Rank 0 loads the reference set and splits it into one partition per rank "
+    "with the top levels of a kd-tree, so each partition covers a compact "
+    "region of space; each rank then builds a kd-tree on its own partition, "
+    "and rank 0 frees the reference set.  The query set (or the reference "
+    "set, if no query set is given) is split into contiguous blocks, one per "
+    "rank.  Each query point is first searched on the rank whose partition "
+    "bound is nearest to it, and then only on the ranks whose partition "
+    "bounds are nearer than its current k'th nearest neighbor; the candidates "
+    "of each rank are merged, so the results are the same as those of allknn "
+    "(up to ties).  The results are gathered on rank 0, which saves them in "
+    "the same format as allknn."
+    "\n\n"
+    "Query points are routed in rounds of --block_size points per rank, which "
+    "bounds the size of each message: the block size times the number of "
+    "ranks times the larger of k and the dimensionality must fit in an int.");
+
+PARAM_STRING_REQ("reference_file", "File containing the reference dataset.",
+    "r");
+PARAM_STRING("query_file", "File containing query points (optional).", "q", "");
+PARAM_STRING("distances_file", "File to output distances into.", "d", "");
+PARAM_STRING("neighbors_file", "File to output neighbors into.", "n", "");
+PARAM_INT_REQ("k", "Number of nearest neighbors to find.", "k");
+PARAM_INT("block_size", "Number of query points of each rank to route in each "
+    "round.", "b", 4096);
+
+// Convenience typedefs.
+typedef PartitionedNeighborSearch<NearestNeighborSort> PartitionedKNN;
+typedef NeighborSearch<NearestNeighborSort> LocalKNN;
+
+//! The largest number of elements sent in one MPI message.
+static const size_t maxMessageSize = INT_MAX / 2;
+
+//! Get the MPI datatype of size_t.
+static MPI_Datatype SizeType()
+{
+  return (sizeof(size_t) == sizeof(unsigned long)) ? MPI_UNSIGNED_LONG :
+      MPI_UNSIGNED_LONG_LONG;
+}
+
+//! Send a buffer (of any size) to the given rank, in pieces if necessary.
+template<typename eT>
+static void SendBuffer(const eT* buffer,
+                       const size_t size,
+                       MPI_Datatype type,
+                       const int destination)
+{
+  for (size_t sent = 0; sent < size; sent += maxMessageSize)
+    MPI_Send(const_cast<eT*>(buffer) + sent,
+        (int) std::min(maxMessageSize, size - sent), type, destination, 0,
+        MPI_COMM_WORLD);
+}
+
+//! Receive a buffer sent with SendBuffer() from the given rank.
+template<typename eT>
+static void ReceiveBuffer(eT* buffer,
+                          const size_t size,
+                          MPI_Datatype type,
+                          const int source)
+{
+  for (size_t received = 0; received < size; received += maxMessageSize)
+    MPI_Recv(buffer + received, (int) std::min(maxMessageSize,
+        size - received), type, source, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+}
+
+/**
+ * Send the given columns of a matrix from rank 0 to every rank (the columns in
+ * columns[r] to rank r); every rank receives its columns into block.
+ */
+static void ScatterColumns(const arma::mat& matrix,
+                           const std::vector<arma::Col<size_t> >& columns,
+                           const int rank,
+                           const int ranks,
+                           arma::mat& block)
+{
+  size_t dimensionality = matrix.n_rows;
+  MPI_Bcast(&dimensionality, 1, SizeType(), 0, MPI_COMM_WORLD);
+
+  if (rank == 0)
+  {
+    for (int r = ranks - 1; r >= 0; --r)
+    {
+      arma::uvec selected(columns[r].n_elem);
+      for (size_t i = 0; i < columns[r].n_elem; ++i)
+        selected[i] = (arma::uword) columns[r][i];
+
+      arma::mat points = matrix.cols(selected);
+      if (r == 0)
+      {
+        block = std::move(points);
+        break;
+      }
+
+      size_t count = points.n_cols;
+      SendBuffer(&count, 1, SizeType(), r);
+      SendBuffer(points.memptr(), points.n_elem, MPI_DOUBLE, r);
+    }
+  }
+  else
+  {
+    size_t count;
+    ReceiveBuffer(&count, 1, SizeType(), 0);
+    block.set_size(dimensionality, count);
+    ReceiveBuffer(block.memptr(), block.n_elem, MPI_DOUBLE, 0);
+  }
+}
+
+/**
+ * Send each query point of this rank to the ranks in its route, search the
+ * query points that arrive from every rank in the local partition, and merge
+ * the candidates that come back into the given candidate list.  This is a
+ * collective operation: every rank must call it the same number of times.
+ *
+ * @param queries Query points of this rank.
+ * @param routes For each rank, the indices of the query points to send to it.
+ * @param search Search of the local partition.
+ * @param localIndices Indices (in the reference set) of the local points.
+ * @param k Number of neighbors to search for.
+ * @param candidates Candidate list of the query points of this rank.
+ */
+static void RouteAndSearch(const arma::mat& queries,
+                           const std::vector<std::vector<size_t> >& routes,
+                           LocalKNN& search,
+                           const arma::Col<size_t>& localIndices,
+                           const size_t k,
+                           CandidateList<NearestNeighborSort>& candidates)
+{
+  const int ranks = (int) routes.size();
+  const int d = (int) queries.n_rows;
+
+  // Tell every rank how many query points it will get.
+  std::vector<int> sendCounts(ranks), receiveCounts(ranks);
+  for (int r = 0; r < ranks; ++r)
+    sendCounts[r] = (int) routes[r].size();
+  MPI_Alltoall(&sendCounts[0], 1, MPI_INT, &receiveCounts[0], 1, MPI_INT,
+      MPI_COMM_WORLD);
+
+  std::vector<int> sendOffsets(ranks, 0), receiveOffsets(ranks, 0);
+  for (int r = 1; r < ranks; ++r)
+  {
+    sendOffsets[r] = sendOffsets[r - 1] + sendCounts[r - 1];
+    receiveOffsets[r] = receiveOffsets[r - 1] + receiveCounts[r - 1];
+  }
+  const int sent = sendOffsets[ranks - 1] + sendCounts[ranks - 1];
+  const int received = receiveOffsets[ranks - 1] + receiveCounts[ranks - 1];
+
+  // Send the query points themselves.
+  arma::mat sendPoints(d, sent);
+  for (int r = 0; r < ranks; ++r)
+    for (size_t i = 0; i < routes[r].size(); ++i)
+      sendPoints.col(sendOffsets[r] + i) = queries.col(routes[r][i]);
+
+  arma::mat receivedPoints(d, received);
+  std::vector<int> sendSizes(ranks), sendDisplacements(ranks),
+      receiveSizes(ranks), receiveDisplacements(ranks);
+  for (int r = 0; r < ranks; ++r)
+  {
+    sendSizes[r] = d * sendCounts[r];
+    sendDisplacements[r] = d * sendOffsets[r];
+    receiveSizes[r] = d * receiveCounts[r];
+    receiveDisplacements[r] = d * receiveOffsets[r];
+  }
+  MPI_Alltoallv(sendPoints.memptr(), &sendSizes[0], &sendDisplacements[0],
+      MPI_DOUBLE, receivedPoints.memptr(), &receiveSizes[0],
+      &receiveDisplacements[0], MPI_DOUBLE, MPI_COMM_WORLD);
+
+  // Search the local partition, and pad the results to k candidates, since
+  // the partition may have fewer than k points.
+  arma::Mat<size_t> resultNeighbors(k, received);
+  arma::mat resultDistances(k, received);
+  resultNeighbors.fill(size_t() - 1);
+  resultDistances.fill(NearestNeighborSort::WorstDistance());
+  const size_t localK = std::min(k, (size_t) localIndices.n_elem);
+  if (received > 0 && localK > 0)
+  {
+    arma::Mat<size_t> localNeighbors;
+    arma::mat localDistances;
+    search.Search(receivedPoints, localK, localNeighbors, localDistances);
+    for (int i = 0; i < received; ++i)
+    {
+      for (size_t j = 0; j < localK; ++j)
+      {
+        resultNeighbors(j, i) = localIndices[localNeighbors(j, i)];
+        resultDistances(j, i) = localDistances(j, i);
+      }
+    }
+  }
+
+  // Send the candidates back to the ranks that the query points came from.
+  arma::Mat<size_t> returnedNeighbors(k, sent);
+  arma::mat returnedDistances(k, sent);
+  for (int r = 0; r < ranks; ++r)
+  {
+    sendSizes[r] = (int) k * receiveCounts[r];
+    sendDisplacements[r] = (int) k * receiveOffsets[r];
+    receiveSizes[r] = (int) k * sendCounts[r];
+    receiveDisplacements[r] = (int) k * sendOffsets[r];
+  }
+  MPI_Alltoallv(resultNeighbors.memptr(), &sendSizes[0], &sendDisplacements[0],
+      SizeType(), returnedNeighbors.memptr(), &receiveSizes[0],
+      &receiveDisplacements[0], SizeType(), MPI_COMM_WORLD);
+  MPI_Alltoallv(resultDistances.memptr(), &sendSizes[0], &sendDisplacements[0],
+      MPI_DOUBLE, returnedDistances.memptr(), &receiveSizes[0],
+      &receiveDisplacements[0], MPI_DOUBLE, MPI_COMM_WORLD);
+
+  for (int r = 0; r < ranks; ++r)
+  {
+    for (size_t i = 0; i < routes[r].size(); ++i)
+    {
+      const size_t column = sendOffsets[r] + i;
+      for (size_t j = 0; j < k; ++j)
+      {
+        if (returnedNeighbors(j, column) == size_t() - 1)
+          break;
+
+        candidates.Insert(routes[r][i], returnedNeighbors(j, column),
+            returnedDistances(j, column));
+      }
+    }
+  }
+}
+
+static void Run(const int rank, const int ranks)
+{
+  if (CLI::GetParam<int>("k") < 1)
+    Log::Fatal << "Invalid k: " << CLI::GetParam<int>("k") << "; must be "
+        << "greater than 0." << endl;
+  if (CLI::GetParam<int>("block_size") < 1)
+    Log::Fatal << "Invalid block size: " << CLI::GetParam<int>("block_size")
+        << "; must be greater than 0." << endl;
+
+  const size_t k = (size_t) CLI::GetParam<int>("k");
+  const size_t blockSize = (size_t) CLI::GetParam<int>("block_size");
+
+  // With no query set, the reference set is searched for one more neighbor,
+  // and each point is removed from its own results.
+  const bool monochromatic = !CLI::HasParam("query_file");
+  const size_t searchK = monochromatic ? k + 1 : k;
+
+  // Rank 0 splits the reference set into one partition per rank.
+  arma::mat referenceSet, querySet;
+  std::vector<arma::Col<size_t> > partitionIndices;
+  if (rank == 0)
+  {
+    data::Load(CLI::GetParam<string>("reference_file"), referenceSet, true);
+    const size_t referencePoints = referenceSet.n_cols;
+    if (searchK > referencePoints)
+      Log::Fatal << "Invalid k: " << k << "; must be less than the number of "
+          << "reference points (" << referencePoints << ")." << endl;
+
+    Timer::Start("partitioning");
+    PartitionedKNN::Partition(referenceSet, (size_t) ranks, partitionIndices);
+    Timer::Stop("partitioning");
+    if (partitionIndices.size() < (size_t) ranks)
+      Log::Fatal << "The reference set could only be split into "
+          << partitionIndices.size() << " partitions; use fewer ranks." << endl;
+
+    Log::Info << "Split " << referencePoints << " reference points into "
+        << ranks << " partitions." << endl;
+  }
+
+  arma::mat localPoints;
+  ScatterColumns(referenceSet, partitionIndices, rank, ranks, localPoints);
+
+  arma::Col<size_t> localIndices;
+  if (rank == 0)
+  {
+    for (int r = 1; r < ranks; ++r)
+      SendBuffer(partitionIndices[r].memptr(), partitionIndices[r].n_elem,
+          SizeType(), r);
+    localIndices = partitionIndices[0];
+  }
+  else
+  {
+    localIndices.set_size(localPoints.n_cols);
+    ReceiveBuffer(localIndices.memptr(), localIndices.n_elem, SizeType(), 0);
+  }
+
+  // MPI counts are ints, so the messages of one round must not be too big.
+  const size_t d = localPoints.n_rows;
+  if ((size_t) ranks * blockSize * std::max(searchK, d) > (size_t) INT_MAX)
+    Log::Fatal << "Block size " << blockSize << " is too large for " << ranks
+        << " ranks; use a smaller --block_size." << endl;
+
+  // Share the bound of every partition.
+  PartitionedKNN::BoundType localBound(d);
+  localBound |= localPoints;
+  arma::vec localRanges(2 * d);
+  for (size_t i = 0; i < d; ++i)
+  {
+    localRanges[2 * i] = localBound[i].Lo();
+    localRanges[2 * i + 1] = localBound[i].Hi();
+  }
+  arma::mat ranges(2 * d, ranks);
+  MPI_Allgather(localRanges.memptr(), (int) (2 * d), MPI_DOUBLE,
+      ranges.memptr(), (int) (2 * d), MPI_DOUBLE, MPI_COMM_WORLD);
+
+  std::vector<PartitionedKNN::BoundType> bounds(ranks,
+      PartitionedKNN::BoundType(d));
+  for (int r = 0; r < ranks; ++r)
+    for (size_t i = 0; i < d; ++i)
+      bounds[r][i] = math::Range(ranges(2 * i, r), ranges(2 * i + 1, r));
+
+  Timer::Start("tree_building");
+  LocalKNN search(std::move(localPoints), false, false);
+  Timer::Stop("tree_building");
+
+  // Rank 0 splits the query set into contiguous blocks, one per rank.
+  if (rank == 0)
+  {
+    if (monochromatic)
+      querySet = std::move(referenceSet);
+    else
+      data::Load(CLI::GetParam<string>("query_file"), querySet, true);
+
+    referenceSet.reset();
+    if (querySet.n_rows != d)
+      Log::Fatal << "Query set has dimensionality " << querySet.n_rows
+          << ", but the reference set has dimensionality " << d << "." << endl;
+  }
+
+  size_t queryPoints = querySet.n_cols;
+  MPI_Bcast(&queryPoints, 1, SizeType(), 0, MPI_COMM_WORLD);
+
+  std::vector<arma::Col<size_t> > queryBlocks(ranks);
+  std::vector<size_t> blockBegin(ranks);
+  size_t begin = 0;
+  for (int r = 0; r < ranks; ++r)
+  {
+    const size_t count = queryPoints / ranks +
+        (((size_t) r < queryPoints % ranks) ? 1 : 0);
+    blockBegin[r] = begin;
+    queryBlocks[r].set_size(count);
+    for (size_t i = 0; i < count; ++i)
+      queryBlocks[r][i] = begin + i;
+    begin += count;
+  }
+
+  arma::mat localQueries;
+  ScatterColumns(querySet, queryBlocks, rank, ranks, localQueries);
+  querySet.reset();
+
+  // Route the query points in rounds, so that each message stays small; every
+  // rank takes part in every round, even if it has no query points left.
+  arma::Mat<size_t> neighbors(searchK, localQueries.n_cols);
+  arma::mat distances(searchK, localQueries.n_cols);
+  neighbors.fill(size_t() - 1);
+  distances.fill(NearestNeighborSort::WorstDistance());
+  CandidateList<NearestNeighborSort> candidates(neighbors, distances);
+
+  size_t localRounds = ((size_t) localQueries.n_cols + blockSize - 1) /
+      blockSize;
+  size_t rounds;
+  MPI_Allreduce(&localRounds, &rounds, 1, SizeType(), MPI_MAX,
+      MPI_COMM_WORLD);
+
+  Timer::Start("computing_neighbors");
+  std::vector<size_t> first(blockSize);
+  std::vector<std::vector<size_t> > routes(ranks);
+  size_t routedQueries = 0;
+  for (size_t round = 0; round < rounds; ++round)
+  {
+    const size_t begin = std::min(round * blockSize,
+        (size_t) localQueries.n_cols);
+    const size_t end = std::min(begin + blockSize,
+        (size_t) localQueries.n_cols);
+
+    // First send each query point to the rank whose bound is nearest to it.
+    for (int r = 0; r < ranks; ++r)
+      routes[r].clear();
+    for (size_t i = begin; i < end; ++i)
+    {
+      const arma::vec query(localQueries.colptr(i), d, false, true);
+      first[i - begin] = PartitionedKNN::BestPartition(query, bounds);
+      routes[first[i - begin]].push_back(i);
+    }
+    RouteAndSearch(localQueries, routes, search, localIndices, searchK,
+        candidates);
+
+    // Then send it to every other rank whose bound is nearer than its current
+    // k'th nearest neighbor.
+    for (int r = 0; r < ranks; ++r)
+      routes[r].clear();
+    for (size_t i = begin; i < end; ++i)
+    {
+      const arma::vec query(localQueries.colptr(i), d, false, true);
+      for (int r = 0; r < ranks; ++r)
+      {
+        if ((size_t) r != first[i - begin] &&
+            NearestNeighborSort::IsBetter(PartitionedKNN::BestDistance(query,
+            bounds[r]), candidates.Worst(i)))
+          routes[r].push_back(i);
+      }
+    }
+    RouteAndSearch(localQueries, routes, search, localIndices, searchK,
+        candidates);
+
+    for (int r = 0; r < ranks; ++r)
+      routedQueries += routes[r].size();
+  }
+  CandidateList<NearestNeighborSort>::Sort(neighbors, distances);
+  Timer::Stop("computing_neighbors");
+
+  size_t totalRouted = 0;
+  MPI_Reduce(&routedQueries, &totalRouted, 1, SizeType(), MPI_SUM, 0,
+      MPI_COMM_WORLD);
+  Log::Info << "Query points were sent to " << totalRouted << " ranks besides "
+      << "their first one." << endl;
+
+  // Remove each point from its own results, if the reference set was
+  // searched.
+  if (monochromatic)
+  {
+    for (size_t i = 0; i < neighbors.n_cols; ++i)
+    {
+      size_t self = k;
+      for (size_t j = 0; j < k; ++j)
+      {
+        if (neighbors(j, i) == blockBegin[rank] + i)
+        {
+          self = j;
+          break;
+        }
+      }
+
+      for (size_t j = self; j < k; ++j)
+      {
+        neighbors(j, i) = neighbors(j + 1, i);
+        distances(j, i) = distances(j + 1, i);
+      }
+    }
+
+    neighbors.shed_row(k);
+    distances.shed_row(k);
+  }
+
+  // Gather the results on rank 0, in the order of the query set.
+  if (rank == 0)
+  {
+    arma::Mat<size_t> allNeighbors(k, queryPoints);
+    arma::mat allDistances(k, queryPoints);
+    for (int r = 0; r < ranks; ++r)
+    {
+      const size_t count = queryBlocks[r].n_elem;
+      if (count == 0)
+        continue;
+
+      if (r == 0)
+      {
+        allNeighbors.cols(0, count - 1) = neighbors;
+        allDistances.cols(0, count - 1) = distances;
+      }
+      else
+      {
+        ReceiveBuffer(allNeighbors.colptr(blockBegin[r]), k * count,
+            SizeType(), r);
+        ReceiveBuffer(allDistances.colptr(blockBegin[r]), k * count,
+            MPI_DOUBLE, r);
+      }
+    }
+
+    if (CLI::HasParam("neighbors_file"))
+      data::Save(CLI::GetParam<string>("neighbors_file"), allNeighbors);
+    if (CLI::HasParam("distances_file"))
+      data::Save(CLI::GetParam<string>("distances_file"), allDistances);
+  }
+  else if (neighbors.n_cols > 0)
+  {
+    SendBuffer(neighbors.memptr(), neighbors.n_elem, SizeType(), 0);
+    SendBuffer(distances.memptr(), distances.n_elem, MPI_DOUBLE, 0);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  MPI_Init(&argc, &argv);
+
+  int rank, ranks;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+
+  // Give CLI the command line parameters the user passed in.
+  CLI::ParseCommandLine(argc, argv);
+
+  // Only rank 0 prints informational output.
+  if (rank != 0)
+    Log::Info.ignoreInput = true;
+
+  // A fatal error on any rank stops the whole job, since the other ranks would
+  // otherwise wait for it forever.
+  try
+  {
+    Run(rank, ranks);
+  }
+  catch (std::exception&)
+  {
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+
+  MPI_Finalize();
+  return 0;
+}
@@ -0,0 +1,221 @@
+/**
+ * @file candidate_list.hpp
+ * @author Ryan Curtin
+ *
+ * The lists of the k best candidates of each query point during a search, held
+ * in the columns of the neighbors and distances matrices.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_CANDIDATE_LIST_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_CANDIDATE_LIST_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The k best candidates of each query point, held in the columns of a k x n
+ * matrix of neighbor indices and a k x n matrix of distances (or any other
+ * value that SortPolicy::IsBetter() can compare, such as kernel values).  The
+ * matrices must be filled with size_t() - 1 and SortPolicy::WorstDistance()
+ * (or some other value that every candidate is better than) before the search.
+ *
+ * For small k, each column is kept sorted, best candidate first; inserting a
+ * candidate shifts the worse candidates down, which is O(k) but cheap for short
+ * columns.  For k of at least HeapThreshold, each column is instead kept as a
+ * binary heap with the worst candidate first, so a candidate is inserted in
+ * O(log k) time; then Sort() must be called once the search is done to sort
+ * the columns.  Either way, Worst() gives the k'th best candidate of a query
+ * point, which is the bound that the search prunes with.
+ *
+ * Only the columns of the query points that are given to Insert() are written
+ * to, so objects for disjoint sets of query points can be used by different
+ * threads on the same matrices.
+ *
+ * If the lists already hold some candidates before the search (a warm start),
+ * Unique() should be set, so that a candidate that is found again is not held
+ * twice; checking that costs O(k) for each candidate that would be inserted.
+ *
+ * @tparam SortPolicy The policy that defines which candidates are better.
+ */
+template<typename SortPolicy>
+class CandidateList
+{
+ public:
+  //! The smallest k for which the columns are kept as heaps.
+  static const size_t HeapThreshold = 64;
+
+  /**
+   * Hold the candidates in the given matrices, which have k rows and one
+   * column for each query point.
+   *
+   * @param neighbors Matrix of the indices of the candidates.
+   * @param distances Matrix of the distances of the candidates.
+   */
+  CandidateList(arma::Mat<size_t>& neighbors, arma::mat& distances) :
+      neighbors(neighbors),
+      distances(distances),
+      heap(UseHeap(distances.n_rows)),
+      unique(false)
+  { }
+
+  //! Get whether candidates already in a list are not inserted again.
+  bool Unique() const { return unique; }
+  //! Modify whether candidates already in a list are not inserted again.
+  bool& Unique() { return unique; }
+
+  //! Return whether the columns are kept as heaps for the given k.
+  static bool UseHeap(const size_t k) { return k >= HeapThreshold; }
+
+  //! Get the k'th best candidate distance of the given query point.
+  double Worst(const size_t queryIndex) const
+  {
+    return distances(heap ? 0 : distances.n_rows - 1, queryIndex);
+  }
+
+  /**
+   * Insert the given candidate for the given query point, if it is better than
+   * the k'th best candidate; the k'th best candidate is then dropped.
+   *
+   * @param queryIndex Index of the query point.
+   * @param neighbor Index of the candidate.
+   * @param distance Distance from the query point to the candidate.
+   * @return Whether the candidate was inserted.
+   */
+  bool Insert(const size_t queryIndex,
+              const size_t neighbor,
+              const double distance)
+  {
+    if (heap)
+    {
+      if (!SortPolicy::IsBetter(distance, distances(0, queryIndex)))
+        return false;
+      if (unique && Contains(queryIndex, neighbor))
+        return false;
+
+      SiftDown(distances.colptr(queryIndex), neighbors.colptr(queryIndex),
+          distances.n_rows, neighbor, distance);
+      return true;
+    }
+
+    // If this distance is better than any of the current candidates, the
+    // SortDistance() function will give us the position to insert it into.
+    arma::vec queryDist = distances.unsafe_col(queryIndex);
+    arma::Col<size_t> queryIndices = neighbors.unsafe_col(queryIndex);
+    const size_t pos = SortPolicy::SortDistance(queryDist, queryIndices,
+        distance);
+
+    // SortDistance() returns (size_t() - 1) if we shouldn't add it.
+    if (pos == (size_t() - 1))
+      return false;
+    if (unique && Contains(queryIndex, neighbor))
+      return false;
+
+    // We only memmove() if there is actually a need to shift something.
+    if (pos < (distances.n_rows - 1))
+    {
+      const size_t len = (distances.n_rows - 1) - pos;
+      memmove(distances.colptr(queryIndex) + (pos + 1),
+          distances.colptr(queryIndex) + pos, sizeof(double) * len);
+      memmove(neighbors.colptr(queryIndex) + (pos + 1),
+          neighbors.colptr(queryIndex) + pos, sizeof(size_t) * len);
+    }
+
+    // Now put the new information in the right index.
+    distances(pos, queryIndex) = distance;
+    neighbors(pos, queryIndex) = neighbor;
+    return true;
+  }
+
+  /**
+   * Sort each column of the given matrices, best candidate first, if they were
+   * kept as heaps during the search; otherwise they are already sorted and
+   * nothing is done.  This must be called once the search is done.
+   *
+   * @param neighbors Matrix of the indices of the candidates.
+   * @param distances Matrix of the distances of the candidates.
+   */
+  static void Sort(arma::Mat<size_t>& neighbors, arma::mat& distances)
+  {
+    if (!UseHeap(distances.n_rows))
+      return;
+
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < distances.n_cols; ++i)
+    {
+      // Heapsort: move the worst candidate to the end of the heap, and shrink
+      // the heap by one, until the heap is empty.
+      double* columnDistances = distances.colptr(i);
+      size_t* columnNeighbors = neighbors.colptr(i);
+      for (size_t size = distances.n_rows; size > 1; --size)
+      {
+        const double distance = columnDistances[size - 1];
+        const size_t neighbor = columnNeighbors[size - 1];
+        columnDistances[size - 1] = columnDistances[0];
+        columnNeighbors[size - 1] = columnNeighbors[0];
+        SiftDown(columnDistances, columnNeighbors, size - 1, neighbor,
+            distance);
+      }
+    }
+  }
+
+ private:
+  //! The indices of the candidates.
+  arma::Mat<size_t>& neighbors;
+  //! The distances of the candidates.
+  arma::mat& distances;
+  //! Whether the columns are kept as heaps.
+  const bool heap;
+  //! Whether candidates already in a list are not inserted again.
+  bool unique;
+
+  //! Return whether the given candidate is in the list of the given query
+  //! point.
+  bool Contains(const size_t queryIndex, const size_t neighbor) const
+  {
+    const size_t* column = neighbors.colptr(queryIndex);
+    for (size_t i = 0; i < neighbors.n_rows; ++i)
+      if (column[i] == neighbor)
+        return true;
+
+    return false;
+  }
+
+  /**
+   * Replace the worst candidate (the root) of the given heap with the given
+   * candidate, and restore the heap: every candidate is no better than those
+   * below it.
+   */
+  static void SiftDown(double* heapDistances,
+                       size_t* heapNeighbors,
+                       const size_t size,
+                       const size_t neighbor,
+                       const double distance)
+  {
+    size_t node = 0;
+    while (2 * node + 1 < size)
+    {
+      // Find the worse child.
+      size_t child = 2 * node + 1;
+      if (child + 1 < size &&
+          !SortPolicy::IsBetter(heapDistances[child + 1], heapDistances[child]))
+        ++child;
+
+      // Stop once the worse child is no worse than the new candidate.
+      if (SortPolicy::IsBetter(heapDistances[child], distance))
+        break;
+
+      heapDistances[node] = heapDistances[child];
+      heapNeighbors[node] = heapNeighbors[child];
+      node = child;
+    }
+
+    heapDistances[node] = distance;
+    heapNeighbors[node] = neighbor;
+  }
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ * @file cosine_neighbor_search.hpp
+ * @author Ryan Curtin
+ *
+ * Definition of CosineNeighborSearch, which finds the points with the largest
+ * cosine similarity by normalizing the data and using the Euclidean distance,
+ * so that kd-trees can be used.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_COSINE_NEIGHBOR_SEARCH_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_COSINE_NEIGHBOR_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/kernels/cosine_distance.hpp>
+#include "neighbor_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * Search for the points with the largest cosine similarity (see
+ * kernel::CosineDistance) to each query point.  This gives the same results as
+ * fastmks::FastMKS with the CosineDistance kernel, but it is usually much
+ * faster: the reference set (and each query set) is scaled to unit norm once,
+ * and for unit vectors || a - b ||^2 = 2 - 2 cos(a, b), so the points with the
+ * largest cosine similarity are the nearest neighbors with the Euclidean
+ * distance.  That search is done with NeighborSearch, which can use the bounds
+ * of kd-trees to prune.
+ *
+ * The similarities are returned (in decreasing order) instead of the Euclidean
+ * distances.  Reference points with norm 0 have no direction, so they are not
+ * allowed; query points with norm 0 have similarity 0 to every point.
+ *
+ * @code
+ * CosineNeighborSearch<> search(referenceSet);
+ * search.Search(querySet, 10, indices, similarities);
+ * @endcode
+ *
+ * @tparam TreeType The tree type to use; any tree that works with the Euclidean
+ *      distance can be used.
+ */
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType = tree::KDTree>
+class CosineNeighborSearch
+{
+ public:
+  //! The type of the search on the normalized points.
+  typedef NeighborSearch<NearestNeighborSort, metric::EuclideanDistance,
+      arma::mat, TreeType> NeighborSearchType;
+
+  /**
+   * Normalize the reference set and build the tree on it.  If a reference
+   * point has norm 0, a std::invalid_argument is thrown.
+   *
+   * @param referenceSet Set of reference points.
+   * @param naive If true, O(n^2) naive search will be used.
+   * @param singleMode If true, single-tree search will be used.
+   */
+  CosineNeighborSearch(const arma::mat& referenceSet,
+                       const bool naive = false,
+                       const bool singleMode = false);
+
+  /**
+   * Find the k points in the reference set with the largest cosine similarity
+   * to each point in the query set.
+   *
+   * @param querySet Set of query points.
+   * @param k Number of points to find for each query point.
+   * @param indices Matrix to store the indices of the points in.
+   * @param similarities Matrix to store the cosine similarities in.
+   */
+  void Search(const arma::mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& indices,
+              arma::mat& similarities);
+
+  /**
+   * Find the k other points in the reference set with the largest cosine
+   * similarity to each reference point.
+   *
+   * @param k Number of points to find for each point.
+   * @param indices Matrix to store the indices of the points in.
+   * @param similarities Matrix to store the cosine similarities in.
+   */
+  void Search(const size_t k,
+              arma::Mat<size_t>& indices,
+              arma::mat& similarities);
+
+  //! Get the search on the normalized points.
+  const NeighborSearchType& Searcher() const { return searcher; }
+  //! Modify the search on the normalized points.
+  NeighborSearchType& Searcher() { return searcher; }
+
+ private:
+  //! Get the normalized reference set, checking that no point has norm 0.
+  static arma::mat NormalizedReferenceSet(const arma::mat& referenceSet);
+
+  //! Turn the Euclidean distances between unit vectors into similarities.
+  static void Similarities(arma::mat& distances);
+
+  //! The search on the normalized points.
+  NeighborSearchType searcher;
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+// Include implementation.
+#include "cosine_neighbor_search_impl.hpp"
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * @file cosine_neighbor_search_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of CosineNeighborSearch.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_COSINE_NEIGHBOR_SEARCH_IMPL_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_COSINE_NEIGHBOR_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "cosine_neighbor_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+template<template<typename, typename, typename> class TreeType>
+CosineNeighborSearch<TreeType>::CosineNeighborSearch(
+    const arma::mat& referenceSet,
+    const bool naive,
+    const bool singleMode) :
+    searcher(NormalizedReferenceSet(referenceSet), naive, singleMode)
+{
+  // Nothing to do.
+}
+
+template<template<typename, typename, typename> class TreeType>
+void CosineNeighborSearch<TreeType>::Search(const arma::mat& querySet,
+                                            const size_t k,
+                                            arma::Mat<size_t>& indices,
+                                            arma::mat& similarities)
+{
+  arma::mat normalizedQuerySet(querySet);
+  kernel::CosineDistance::Normalize(normalizedQuerySet);
+
+  searcher.Search(normalizedQuerySet, k, indices, similarities);
+  Similarities(similarities);
+
+  // A query point of norm 0 is at distance 1 from every (unit) reference
+  // point, but its similarity to each of them is 0.
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+    if (arma::norm(querySet.col(i), 2) == 0.0)
+      similarities.col(i).zeros();
+}
+
+template<template<typename, typename, typename> class TreeType>
+void CosineNeighborSearch<TreeType>::Search(const size_t k,
+                                            arma::Mat<size_t>& indices,
+                                            arma::mat& similarities)
+{
+  searcher.Search(k, indices, similarities);
+  Similarities(similarities);
+}
+
+template<template<typename, typename, typename> class TreeType>
+arma::mat CosineNeighborSearch<TreeType>::NormalizedReferenceSet(
+    const arma::mat& referenceSet)
+{
+  arma::mat normalized(referenceSet);
+  for (size_t i = 0; i < normalized.n_cols; ++i)
+  {
+    const double pointNorm = arma::norm(normalized.col(i), 2);
+    if (pointNorm == 0.0)
+    {
+      std::ostringstream oss;
+      oss << "CosineNeighborSearch::CosineNeighborSearch(): reference point "
+          << i << " has norm 0, so it has no direction";
+      throw std::invalid_argument(oss.str());
+    }
+
+    normalized.col(i) /= pointNorm;
+  }
+
+  return normalized;
+}
+
+template<template<typename, typename, typename> class TreeType>
+void CosineNeighborSearch<TreeType>::Similarities(arma::mat& distances)
+{
+  // || a - b ||^2 = 2 - 2 cos(a, b) for unit vectors; roundoff can take the
+  // result just outside of [-1, 1].
+  for (size_t i = 0; i < distances.n_elem; ++i)
+    distances[i] = std::min(std::max(1.0 - 0.5 * distances[i] * distances[i],
+        -1.0), 1.0);
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
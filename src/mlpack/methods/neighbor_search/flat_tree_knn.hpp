@@ -0,0 +1,77 @@
+/**
+ * @file flat_tree_knn.hpp
+ * @author Ryan Curtin
+ *
+ * Single-tree k-nearest-neighbor search on a FlatBinarySpaceTree.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_FLAT_TREE_KNN_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_FLAT_TREE_KNN_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+#include <mlpack/core/tree/binary_space_tree/flat_binary_space_tree.hpp>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * Find the k nearest neighbors of a set of query points with single-tree
+ * search on a FlatBinarySpaceTree.  The search works directly on the arrays of
+ * the flat tree, visiting the closer child of each node first and pruning nodes
+ * that are further away than the current k'th nearest neighbor, so it returns
+ * the same results as AllkNN in single-tree mode (up to ties).  Since a flat
+ * tree can be loaded (or mapped) without rebuilding it, this is useful when a
+ * large reference tree is searched by many short-lived processes.
+ *
+ * @tparam MetricType LMetric that the flat tree was built with.
+ */
+template<typename MetricType = metric::EuclideanDistance>
+class FlatTreeKNN
+{
+ public:
+  /**
+   * Prepare to search the given tree, which must outlive this object.
+   *
+   * @param referenceTree Flat tree holding the reference set.
+   */
+  FlatTreeKNN(const tree::FlatBinarySpaceTree& referenceTree);
+
+  /**
+   * Find the k nearest neighbors of each point in the query set.  The indices
+   * stored in neighbors refer to the original reference set (that is, they
+   * have already been mapped with the oldFromNew mapping of the tree).  If
+   * mlpack is compiled with OpenMP, the query points are searched in parallel.
+   *
+   * @param querySet Set of query points (one per column).
+   * @param k Number of neighbors to find.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   */
+  void Search(const arma::mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances) const;
+
+  //! Get the tree being searched.
+  const tree::FlatBinarySpaceTree& ReferenceTree() const
+  { return referenceTree; }
+
+ private:
+  //! The tree being searched.
+  const tree::FlatBinarySpaceTree& referenceTree;
+
+  //! Search for the neighbors of a single query point.
+  void SearchPoint(const arma::vec& query,
+                   const size_t k,
+                   size_t* neighbors,
+                   double* distances) const;
+};
+
+} // namespace neighbor
+} // namespace mlpack
+
+// Include implementation.
+#include "flat_tree_knn_impl.hpp"
+
+#endif
@@ -0,0 +1,153 @@
+/**
+ * @file flat_tree_knn_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of FlatTreeKNN.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_FLAT_TREE_KNN_IMPL_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_FLAT_TREE_KNN_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "flat_tree_knn.hpp"
+
+#include <queue>
+#include <stack>
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename MetricType>
+FlatTreeKNN<MetricType>::FlatTreeKNN(
+    const tree::FlatBinarySpaceTree& referenceTree) :
+    referenceTree(referenceTree)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType>
+void FlatTreeKNN<MetricType>::Search(const arma::mat& querySet,
+                                     const size_t k,
+                                     arma::Mat<size_t>& neighbors,
+                                     arma::mat& distances) const
+{
+  const arma::mat& referenceSet = referenceTree.Dataset();
+  if (k > referenceSet.n_cols)
+  {
+    std::stringstream ss;
+    ss << "requested value of k (" << k << ") is greater than the number of "
+        << "points in the reference set (" << referenceSet.n_cols << ")";
+    throw std::invalid_argument(ss.str());
+  }
+
+  if (querySet.n_rows != referenceSet.n_rows)
+  {
+    std::stringstream ss;
+    ss << "cannot search for neighbors of points of dimensionality "
+        << querySet.n_rows << " in a tree of dimensionality "
+        << referenceSet.n_rows;
+    throw std::invalid_argument(ss.str());
+  }
+
+  Timer::Start("computing_neighbors");
+
+  neighbors.set_size(k, querySet.n_cols);
+  distances.set_size(k, querySet.n_cols);
+
+  #pragma omp parallel for schedule(dynamic, 64)
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+  {
+    const arma::vec query(querySet.colptr(i), querySet.n_rows, false, true);
+    SearchPoint(query, k, neighbors.colptr(i), distances.colptr(i));
+  }
+
+  Timer::Stop("computing_neighbors");
+}
+
+template<typename MetricType>
+void FlatTreeKNN<MetricType>::SearchPoint(const arma::vec& query,
+                                          const size_t k,
+                                          size_t* neighbors,
+                                          double* distances) const
+{
+  const arma::mat& referenceSet = referenceTree.Dataset();
+
+  // The current candidates, with the worst one on top.
+  std::priority_queue<std::pair<double, size_t> > candidates;
+  double bound = DBL_MAX;
+
+  // Nodes still to visit, along with the minimum distance to them.
+  std::stack<std::pair<size_t, double> > nodes;
+  nodes.push(std::make_pair(0, referenceTree.MinDistance<MetricType>(0,
+      query)));
+
+  while (!nodes.empty())
+  {
+    const size_t node = nodes.top().first;
+    const double nodeDistance = nodes.top().second;
+    nodes.pop();
+
+    // The bound may have tightened since this node was pushed.
+    if (nodeDistance > bound)
+      continue;
+
+    if (referenceTree.IsLeaf(node))
+    {
+      const size_t end = referenceTree.Begin(node) + referenceTree.Count(node);
+      for (size_t j = referenceTree.Begin(node); j < end; ++j)
+      {
+        const double distance = MetricType::Evaluate(query,
+            referenceSet.col(j));
+        if (candidates.size() < k)
+        {
+          candidates.push(std::make_pair(distance, j));
+        }
+        else if (distance < candidates.top().first)
+        {
+          candidates.pop();
+          candidates.push(std::make_pair(distance, j));
+        }
+
+        if (candidates.size() == k)
+          bound = candidates.top().first;
+      }
+
+      continue;
+    }
+
+    // Push the further child first, so that the closer child is visited first.
+    const size_t left = referenceTree.Left(node);
+    const size_t right = referenceTree.Right(node);
+    const double leftDistance = referenceTree.MinDistance<MetricType>(left,
+        query);
+    const double rightDistance = referenceTree.MinDistance<MetricType>(right,
+        query);
+
+    if (leftDistance <= rightDistance)
+    {
+      if (rightDistance <= bound)
+        nodes.push(std::make_pair(right, rightDistance));
+      if (leftDistance <= bound)
+        nodes.push(std::make_pair(left, leftDistance));
+    }
+    else
+    {
+      if (leftDistance <= bound)
+        nodes.push(std::make_pair(left, leftDistance));
+      if (rightDistance <= bound)
+        nodes.push(std::make_pair(right, rightDistance));
+    }
+  }
+
+  // Empty the candidates from the worst to the best.
+  for (size_t j = k; j > 0; --j)
+  {
+    neighbors[j - 1] = referenceTree.OldFromNew(candidates.top().second);
+    distances[j - 1] = candidates.top().first;
+    candidates.pop();
+  }
+}
+
+} // namespace neighbor
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,106 @@
+/**
+ * @file knn_graph.hpp
+ * @author Ryan Curtin
+ *
+ * Definition of KNNGraph, the symmetrized k-nearest-neighbor graph of a
+ * dataset, which can be built once and given to every method that needs it.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_KNN_GRAPH_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_KNN_GRAPH_HPP
+
+#include <mlpack/core.hpp>
+#include "neighbor_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * The k-nearest-neighbor graph of a dataset.  Points i and j are adjacent if j
+ * is one of the k nearest neighbors of i or i is one of the k nearest
+ * neighbors of j, so the graph is symmetric, and the weight of each edge is the
+ * distance between its points.  The graph is built with one all-k-nearest-
+ * neighbor search, and it is stored in compressed sparse row (CSR) form: the
+ * neighbors of point i are Neighbors()[Offsets()[i]] through
+ * Neighbors()[Offsets()[i + 1] - 1], in increasing order of index, and
+ * Distances() holds the corresponding distances.  Unlike an arma::sp_mat, this
+ * keeps the edges between duplicate points, whose distance is 0.
+ *
+ * Methods that need the neighbors of each point (MVU and mean shift, for
+ * instance) can accept a KNNGraph, so that one graph can be shared instead of
+ * running a separate neighbor search in each of them.
+ *
+ * @code
+ * KNNGraph<> graph(dataset, 10);
+ * for (size_t i = graph.Offsets()[0]; i < graph.Offsets()[1]; ++i)
+ *   std::cout << "Point 0 is adjacent to point " << graph.Neighbors()[i]
+ *       << ".\n";
+ * @endcode
+ *
+ * @tparam MetricType The metric to use for computation.
+ * @tparam MatType The type of data matrix.
+ * @tparam TreeType The tree type to use for the neighbor search.
+ */
+template<typename MetricType = metric::EuclideanDistance,
+         typename MatType = arma::mat,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType = tree::KDTree>
+class KNNGraph
+{
+ public:
+  /**
+   * Build the k-nearest-neighbor graph of the given dataset.
+   *
+   * @param data Dataset to build the graph of.
+   * @param k Number of nearest neighbors of each point.
+   * @param parallel Whether or not to split the work across multiple threads
+   *     (only available if mlpack was compiled with OpenMP).
+   * @param metric An optional instance of the MetricType class.
+   */
+  KNNGraph(const MatType& data,
+           const size_t k,
+           const bool parallel = false,
+           const MetricType metric = MetricType());
+
+  //! Get the number of points in the graph.
+  size_t NumPoints() const { return offsets.n_elem - 1; }
+  //! Get the number of nearest neighbors each point was joined to.
+  size_t K() const { return k; }
+  //! Get the number of (undirected) edges in the graph.
+  size_t NumEdges() const { return neighbors.n_elem / 2; }
+
+  //! Get the offset of the neighbors of each point (NumPoints() + 1 entries).
+  const arma::Col<size_t>& Offsets() const { return offsets; }
+  //! Get the neighbors of every point, one point after the other.
+  const arma::Col<size_t>& Neighbors() const { return neighbors; }
+  //! Get the distance to each neighbor in Neighbors().
+  const arma::vec& Distances() const { return distances; }
+
+  //! Get the distance from each point to its k'th nearest neighbor.
+  const arma::vec& KthDistances() const { return kthDistances; }
+
+  /**
+   * Returns a string representation of this object.
+   */
+  std::string ToString() const;
+
+ private:
+  //! The number of nearest neighbors of each point.
+  size_t k;
+  //! The offset of the neighbors of each point.
+  arma::Col<size_t> offsets;
+  //! The neighbors of every point.
+  arma::Col<size_t> neighbors;
+  //! The distance to each neighbor.
+  arma::vec distances;
+  //! The distance from each point to its k'th nearest neighbor.
+  arma::vec kthDistances;
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+// Include implementation.
+#include "knn_graph_impl.hpp"
+
+#endif
@@ -0,0 +1,148 @@
+/**
+ * @file knn_graph_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of KNNGraph.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_KNN_GRAPH_IMPL_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_KNN_GRAPH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "knn_graph.hpp"
+
+#include <algorithm>
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+KNNGraph<MetricType, MatType, TreeType>::KNNGraph(const MatType& data,
+                                                  const size_t k,
+                                                  const bool parallel,
+                                                  const MetricType metric) :
+    k(k)
+{
+  if (k == 0 || k >= data.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "KNNGraph::KNNGraph(): k must be between 1 and the number of points "
+        << "minus one (" << data.n_cols - 1 << "), but " << k << " was given";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // Find the k nearest neighbors of every point.  The results are in terms of
+  // the original indices, even if the tree rearranges the dataset.
+  arma::Mat<size_t> knnNeighbors;
+  arma::mat knnDistances;
+  {
+    NeighborSearch<NearestNeighborSort, MetricType, MatType, TreeType>
+        search(data, false, false, metric);
+    search.Parallel() = parallel;
+    search.Search(k, knnNeighbors, knnDistances);
+  }
+
+  kthDistances = trans(knnDistances.row(k - 1));
+
+  // Each neighbor pair gives an edge in both directions, so count the edges of
+  // each point before storing them.  Pairs that are neighbors of each other
+  // are stored twice at first.
+  const size_t n = data.n_cols;
+  arma::Col<size_t> rawOffsets(n + 1);
+  rawOffsets.zeros();
+  for (size_t i = 0; i < n; ++i)
+  {
+    rawOffsets[i + 1] += k;
+    for (size_t j = 0; j < k; ++j)
+      ++rawOffsets[knnNeighbors(j, i) + 1];
+  }
+  for (size_t i = 0; i < n; ++i)
+    rawOffsets[i + 1] += rawOffsets[i];
+
+  arma::Col<size_t> rawNeighbors(rawOffsets[n]);
+  arma::vec rawDistances(rawOffsets[n]);
+  arma::Col<size_t> position = rawOffsets.subvec(0, n - 1);
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t j = 0; j < k; ++j)
+    {
+      const size_t neighbor = knnNeighbors(j, i);
+      rawNeighbors[position[i]] = neighbor;
+      rawDistances[position[i]++] = knnDistances(j, i);
+      rawNeighbors[position[neighbor]] = i;
+      rawDistances[position[neighbor]++] = knnDistances(j, i);
+    }
+  }
+
+  // Free the search results before the graph is compacted.
+  knnNeighbors.reset();
+  knnDistances.reset();
+
+  // Sort the neighbors of each point and drop the duplicates.
+  arma::Col<size_t> degrees(n);
+  #pragma omp parallel for if (parallel) schedule(dynamic, 256)
+  for (size_t i = 0; i < n; ++i)
+  {
+    const size_t start = rawOffsets[i];
+    std::vector<std::pair<size_t, double> > edges;
+    edges.reserve(rawOffsets[i + 1] - start);
+    for (size_t e = start; e < rawOffsets[i + 1]; ++e)
+      edges.push_back(std::make_pair(rawNeighbors[e], rawDistances[e]));
+
+    std::sort(edges.begin(), edges.end());
+
+    size_t degree = 0;
+    for (size_t e = 0; e < edges.size(); ++e)
+    {
+      if (degree > 0 && edges[e].first == rawNeighbors[start + degree - 1])
+        continue;
+
+      rawNeighbors[start + degree] = edges[e].first;
+      rawDistances[start + degree] = edges[e].second;
+      ++degree;
+    }
+
+    degrees[i] = degree;
+  }
+
+  offsets.set_size(n + 1);
+  offsets[0] = 0;
+  for (size_t i = 0; i < n; ++i)
+    offsets[i + 1] = offsets[i] + degrees[i];
+
+  neighbors.set_size(offsets[n]);
+  distances.set_size(offsets[n]);
+  #pragma omp parallel for if (parallel) schedule(static)
+  for (size_t i = 0; i < n; ++i)
+  {
+    for (size_t e = 0; e < degrees[i]; ++e)
+    {
+      neighbors[offsets[i] + e] = rawNeighbors[rawOffsets[i] + e];
+      distances[offsets[i] + e] = rawDistances[rawOffsets[i] + e];
+    }
+  }
+}
+
+// Return a string representation of the object.
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+std::string KNNGraph<MetricType, MatType, TreeType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "KNNGraph [" << this << "]" << std::endl;
+  convert << "  Points: " << NumPoints() << std::endl;
+  convert << "  k: " << k << std::endl;
+  convert << "  Edges: " << NumEdges() << std::endl;
+  return convert.str();
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,117 @@
+/**
+ * @file mahalanobis_neighbor_search.hpp
+ * @author Ryan Curtin
+ *
+ * Definition of MahalanobisNeighborSearch, which answers neighbor searches
+ * with the Mahalanobis distance by transforming the data and using the
+ * Euclidean distance, so that any tree type can be used.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_MAHALANOBIS_NEIGHBOR_SEARCH_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_MAHALANOBIS_NEIGHBOR_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/mahalanobis_distance.hpp>
+#include "neighbor_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * Neighbor search with the Mahalanobis distance.  Evaluating the distance
+ * directly costs O(d^2) for each pair of points, and the Mahalanobis distance
+ * can't be used with the bounds of kd-trees; but the distance between x and y
+ * is the Euclidean distance between W x and W y, where W is given by
+ * MahalanobisDistance::Transformation().  So this class transforms the
+ * reference set once (and each query set once), and runs NeighborSearch with
+ * the Euclidean distance on the transformed points.  The returned distances are
+ * the Mahalanobis distances (squared if TakeRoot is false for the given
+ * metric).
+ *
+ * @code
+ * MahalanobisDistance<> metric(covariance);
+ * MahalanobisNeighborSearch<> knn(referenceSet, metric);
+ * knn.Search(querySet, 5, neighbors, distances);
+ * @endcode
+ *
+ * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ * @tparam TreeType The tree type to use; any tree that works with the Euclidean
+ *      distance can be used.
+ */
+template<typename SortPolicy = NearestNeighborSort,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType = tree::KDTree>
+class MahalanobisNeighborSearch
+{
+ public:
+  //! The type of the search on the transformed points.
+  typedef NeighborSearch<SortPolicy, metric::EuclideanDistance, arma::mat,
+      TreeType> NeighborSearchType;
+
+  /**
+   * Transform the reference set and build the tree on it.
+   *
+   * @param referenceSet Set of reference points.
+   * @param metric The Mahalanobis distance to search with.
+   * @param naive If true, O(n^2) naive search will be used.
+   * @param singleMode If true, single-tree search will be used.
+   */
+  template<bool TakeRoot>
+  MahalanobisNeighborSearch(const arma::mat& referenceSet,
+                            const metric::MahalanobisDistance<TakeRoot>& metric,
+                            const bool naive = false,
+                            const bool singleMode = false);
+
+  /**
+   * Find the k nearest (or furthest) neighbors in the reference set of each
+   * point in the query set.  The query set is transformed first.
+   *
+   * @param querySet Set of query points.
+   * @param k Number of neighbors to search for.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   */
+  void Search(const arma::mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances);
+
+  /**
+   * Find the k nearest (or furthest) neighbors of each point in the reference
+   * set (not counting the point itself).
+   *
+   * @param k Number of neighbors to search for.
+   * @param neighbors Matrix storing lists of neighbors for each point.
+   * @param distances Matrix storing distances of neighbors for each point.
+   */
+  void Search(const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances);
+
+  //! Get the matrix the points are transformed by.
+  const arma::mat& Transformation() const { return transformation; }
+  //! Get whether the distances are Mahalanobis distances (or their squares).
+  bool TakeRoot() const { return takeRoot; }
+
+  //! Get the search on the transformed points.
+  const NeighborSearchType& Searcher() const { return searcher; }
+  //! Modify the search on the transformed points.
+  NeighborSearchType& Searcher() { return searcher; }
+
+ private:
+  //! The matrix the points are transformed by.
+  arma::mat transformation;
+  //! If false, the distances are squared.
+  bool takeRoot;
+  //! The search on the transformed points.
+  NeighborSearchType searcher;
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+// Include implementation.
+#include "mahalanobis_neighbor_search_impl.hpp"
+
+#endif
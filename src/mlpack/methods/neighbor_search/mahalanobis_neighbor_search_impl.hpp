@@ -0,0 +1,71 @@
+/**
+ * @file mahalanobis_neighbor_search_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of MahalanobisNeighborSearch.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_MAHALANOBIS_NEIGHBOR_SEARCH_IMPL_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_MAHALANOBIS_NEIGHBOR_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "mahalanobis_neighbor_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename SortPolicy,
+         template<typename, typename, typename> class TreeType>
+template<bool TakeRoot>
+MahalanobisNeighborSearch<SortPolicy, TreeType>::MahalanobisNeighborSearch(
+    const arma::mat& referenceSet,
+    const metric::MahalanobisDistance<TakeRoot>& metric,
+    const bool naive,
+    const bool singleMode) :
+    transformation(metric.Transformation()),
+    takeRoot(TakeRoot),
+    searcher(arma::mat(transformation * referenceSet), naive, singleMode)
+{
+  // Nothing to do.
+}
+
+template<typename SortPolicy,
+         template<typename, typename, typename> class TreeType>
+void MahalanobisNeighborSearch<SortPolicy, TreeType>::Search(
+    const arma::mat& querySet,
+    const size_t k,
+    arma::Mat<size_t>& neighbors,
+    arma::mat& distances)
+{
+  if (querySet.n_rows != transformation.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "MahalanobisNeighborSearch::Search(): dimensionality of query set ("
+        << querySet.n_rows << ") is not equal to the dimensionality of the "
+        << "covariance matrix (" << transformation.n_cols << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  searcher.Search(arma::mat(transformation * querySet), k, neighbors,
+      distances);
+
+  if (!takeRoot)
+    distances = arma::square(distances);
+}
+
+template<typename SortPolicy,
+         template<typename, typename, typename> class TreeType>
+void MahalanobisNeighborSearch<SortPolicy, TreeType>::Search(
+    const size_t k,
+    arma::Mat<size_t>& neighbors,
+    arma::mat& distances)
+{
+  searcher.Search(k, neighbors, distances);
+
+  if (!takeRoot)
+    distances = arma::square(distances);
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
@@ -9,12 +9,17 @@
 #define __MLPACK_METHODS_NEIGHBOR_SEARCH_NEIGHBOR_SEARCH_HPP
 
 #include <mlpack/core.hpp>
+#include <algorithm>
 #include <vector>
 #include <string>
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
 #include <mlpack/core/tree/rectangle_tree.hpp>
 #include <mlpack/core/tree/binary_space_tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/subtree_frontier.hpp>
+#include <mlpack/core/tree/best_first_traverser.hpp>
+#include <mlpack/core/tree/query_order.hpp>
+#include <mlpack/core/tree/tree_memory_usage.hpp>
 
 #include <mlpack/core/metrics/lmetric.hpp>
 #include "neighbor_search_stat.hpp"
@@ -190,6 +195,36 @@ class NeighborSearch
    */
   void Train(Tree* referenceTree);
 
+  /**
+   * Insert a new point into the reference set without rebuilding the reference
+   * tree.  The point is appended to the reference set (so its index is the
+   * number of reference points before the insertion), and then inserted into
+   * the reference tree.  This is only available for tree types that support
+   * insertion (i.e. RectangleTree types such as RTree and RStarTree); in naive
+   * mode, the point is only appended to the reference set.  If the set or tree
+   * was not built by this object, a copy of the reference set is made the
+   * first time that this is called in naive mode.
+   *
+   * @param point Point to insert.
+   */
+  void Insert(const arma::Col<typename MatType::elem_type>& point);
+
+  /**
+   * Remove the reference point with the given index from the reference tree,
+   * without rebuilding it.  The point is kept in the reference set, so that the
+   * indices of the other reference points do not change, but it will not be
+   * returned as a neighbor by any subsequent search, and k may be at most the
+   * number of points that were not removed.  In a search without a query set,
+   * a removed point is not searched for, and its column of the results holds
+   * size_t() - 1 and the worst distance.  This is only available for tree types
+   * that support deletion (i.e. RectangleTree types), and not in naive mode (a
+   * naive search after a removal throws).  If the point is not in the tree, a
+   * std::invalid_argument exception is thrown.
+   *
+   * @param index Index of the reference point to remove.
+   */
+  void Remove(const size_t index);
+
   /**
    * For each point in the query set, compute the nearest neighbors and store
    * the output in the given matrices.  The matrices will be set to the size of
@@ -219,16 +254,27 @@ class NeighborSearch
    * number of points in the query dataset and k is the number of neighbors
    * being searched for.
    *
+   * The query tree may be reused for several searches; its statistics are
+   * reset before each one.  If warmStart is true, the given matrices must
+   * instead hold the results of an earlier search with this query tree for
+   * some other number of neighbors, and the search is extended from them: for
+   * a smaller k the results are truncated without any search, and for a larger
+   * k the known neighbors are kept as the first candidates of each query point,
+   * so they are not searched for again.
+   *
    * @param queryTree Tree built on query points.
    * @param k Number of neighbors to search for.
    * @param neighbors Matrix storing lists of neighbors for each query point.
    * @param distances Matrix storing distances of neighbors for each query
    *      point.
+   * @param warmStart Whether neighbors and distances hold earlier results to
+   *      extend.
    */
   void Search(Tree* queryTree,
               const size_t k,
               arma::Mat<size_t>& neighbors,
-              arma::mat& distances);
+              arma::mat& distances,
+              const bool warmStart = false);
 
   /**
    * Search for the nearest neighbors of every point in the reference set.  This
@@ -248,9 +294,59 @@ class NeighborSearch
               arma::Mat<size_t>& neighbors,
               arma::mat& distances);
 
+  /**
+   * Search for the nearest neighbors of each point in the query set, handing
+   * the results of each query point to the given callback as soon as they are
+   * final instead of storing the results of every query point.  The query set
+   * is searched in blocks of blockSize points (with the current search mode),
+   * so only the results of one block are ever held in memory.  After each
+   * block, the callback is called as
+   *
+   * @code
+   * callback(queryIndex, neighbors, distances);
+   * @endcode
+   *
+   * for each query point of the block, in order, where neighbors and distances
+   * are the k neighbors of the query point (as arma::Col<size_t> and
+   * arma::vec) and queryIndex is its index in the query set.
+   *
+   * @param querySet Set of query points.
+   * @param k Number of neighbors to search for.
+   * @param callback Callback to call with the results of each query point.
+   * @param blockSize Number of query points to search at once.
+   */
+  template<typename CallbackType>
+  void Search(const MatType& querySet,
+              const size_t k,
+              CallbackType& callback,
+              const size_t blockSize = 4096);
+
+  /**
+   * Search for the nearest neighbors of every point in the reference set,
+   * handing the results of each point to the given callback as soon as they
+   * are final; see the other overload of Search() with a callback.  Each block
+   * of points is searched for k + 1 neighbors in the reference set, and the
+   * point itself is removed from its results.
+   *
+   * @param k Number of neighbors to search for.
+   * @param callback Callback to call with the results of each point.
+   * @param blockSize Number of points to search at once.
+   */
+  template<typename CallbackType>
+  void Search(const size_t k,
+              CallbackType& callback,
+              const size_t blockSize = 4096);
+
   //! Returns a string representation of this object.
   std::string ToString() const;
 
+  /**
+   * Estimate the memory used by the model (in bytes): the nodes of the
+   * reference tree and the reference set, if the model owns them, and the
+   * model itself.
+   */
+  size_t MemoryUsage() const;
+
   //! Return the total number of base case evaluations performed during the last
   //! search.
   size_t BaseCases() const { return baseCases; }
@@ -268,6 +364,88 @@ class NeighborSearch
   //! Modify whether or not search is done in single-tree mode.
   bool& SingleMode() { return singleMode; }
 
+  //! Access whether or not tree-based search is split across multiple threads.
+  bool Parallel() const { return parallel; }
+  //! Modify whether or not tree-based search is split across multiple threads.
+  //! This has no effect if mlpack was not compiled with OpenMP support.
+  bool& Parallel() { return parallel; }
+
+  //! Access the relative error tolerance for approximate search.
+  double Epsilon() const { return epsilon; }
+  /**
+   * Modify the relative error tolerance for approximate search.  If epsilon is
+   * greater than zero, tree-based search returns neighbors whose distances are
+   * within a relative error of epsilon of the true neighbor distances (for
+   * nearest neighbor search, each returned distance is at most (1 + epsilon)
+   * times the true distance).  This does not affect naive search.
+   */
+  double& Epsilon() { return epsilon; }
+
+  //! Access whether or not single-tree search expands nodes in best-first
+  //! order.
+  bool BestFirst() const { return bestFirst; }
+  /**
+   * Modify whether or not single-tree search expands nodes in best-first order
+   * (with tree::BestFirstTraverser) instead of depth-first order.  This has no
+   * effect on dual-tree or naive search.
+   */
+  bool& BestFirst() { return bestFirst; }
+
+  //! Get whether or not single-tree search processes the query points in a
+  //! spatial order.
+  bool ReorderQueries() const { return reorderQueries; }
+  /**
+   * Modify whether or not single-tree search processes the query points in a
+   * spatial order (see tree::QueryOrder()), so that consecutive query points
+   * are close to each other and visit mostly the same reference nodes.  The
+   * results are the same; only the order in which the query points are
+   * searched changes.  This has no effect on dual-tree or naive search.
+   */
+  bool& ReorderQueries() { return reorderQueries; }
+
+  //! Access the number of nodes best-first search may expand for each query
+  //! point.
+  size_t MaxVisits() const { return maxVisits; }
+  /**
+   * Modify the number of nodes best-first search may expand for each query
+   * point (0 means there is no limit).  With a limit, search is approximate:
+   * each query point gets the best neighbors found in the nodes that were
+   * expanded.
+   */
+  size_t& MaxVisits() { return maxVisits; }
+
+  //! Get the maximum number of base cases tree-based search may perform.
+  size_t BaseCaseBudget() const { return baseCaseBudget; }
+  /**
+   * Modify the maximum number of base cases tree-based search may perform (0
+   * means there is no limit).  Once the budget is spent, every remaining node
+   * is pruned, and each query point gets the best neighbors found so far; see
+   * Truncated() for the query points that were cut short.  A budgeted search is
+   * always serial.  This has no effect on naive search.
+   */
+  size_t& BaseCaseBudget() { return baseCaseBudget; }
+
+  //! Get the maximum time (in seconds) tree-based search may take.
+  double TimeBudget() const { return timeBudget; }
+  /**
+   * Modify the maximum time (in seconds) tree-based search may take (0 means
+   * there is no limit).  This works like BaseCaseBudget(); the time is only
+   * checked every so often while nodes are scored, so a search may run a little
+   * over its budget.
+   */
+  double& TimeBudget() { return timeBudget; }
+
+  /**
+   * Get whether the search of each query point was cut short by the base case
+   * or time budget in the last call to Search() (in the order of the query
+   * points given to Search()).  A truncated query point had nodes pruned
+   * because the budget was spent, so its neighbors may not be the true (or
+   * epsilon-approximate) neighbors.  The overloads of Search() that take a
+   * callback search each block of query points with its own budget, and this
+   * only covers the last block.
+   */
+  const std::vector<bool>& Truncated() const { return truncated; }
+
   //! Access the reference dataset.
   const MatType& ReferenceSet() const { return *referenceSet; }
 
@@ -292,6 +470,24 @@ class NeighborSearch
   bool naive;
   //! Indicates if single-tree search is being used (as opposed to dual-tree).
   bool singleMode;
+  //! Indicates if tree-based search should be split across threads.
+  bool parallel;
+  //! Relative error tolerance for approximate search (0 for exact search).
+  double epsilon;
+  //! Indicates if single-tree search expands nodes in best-first order.
+  bool bestFirst;
+  //! Indicates if single-tree search processes the query points in a spatial
+  //! order.
+  bool reorderQueries;
+  //! The number of nodes best-first search may expand for each query point (0
+  //! for no limit).
+  size_t maxVisits;
+  //! The maximum number of base cases for tree-based search (0 for no limit).
+  size_t baseCaseBudget;
+  //! The maximum time for tree-based search, in seconds (0 for no limit).
+  double timeBudget;
+  //! Whether each query point was truncated by the budget in the last search.
+  std::vector<bool> truncated;
 
   //! Instantiation of metric.
   MetricType metric;
@@ -305,6 +501,106 @@ class NeighborSearch
   //! Search() without a query set.
   bool treeNeedsReset;
 
+  //! For each reference point, whether it was removed with Remove(); this is
+  //! empty if no point was removed since the reference set was given.
+  std::vector<bool> removed;
+
+  //! Get whether the reference point with the given index was removed.
+  bool Removed(const size_t index) const
+  { return index < removed.size() && removed[index]; }
+
+  //! Get the number of reference points that were not removed.
+  size_t NumLivePoints() const
+  {
+    return referenceSet->n_cols -
+        std::count(removed.begin(), removed.end(), true);
+  }
+
+  /**
+   * Throw std::invalid_argument if k neighbors can't be found for each query
+   * point: k must be at most the number of reference points that were not
+   * removed (or less than that, if each point is searched for in the reference
+   * set and excluded from its own results).  Naive search can't skip removed
+   * points, so it throws if any point was removed.
+   *
+   * @param k Number of neighbors to search for.
+   * @param excludeSelf Whether each query point is excluded from its results.
+   */
+  void CheckSearch(const size_t k, const bool excludeSelf) const;
+
+  /**
+   * Perform a single-tree traversal for each point in the given query set,
+   * storing the results in the given matrices (which must already be
+   * initialized).  If parallel search is enabled, the query points are split
+   * into chunks across threads; each thread has its own NeighborSearchRules
+   * object and traverser, and writes directly into the columns of its query
+   * points.  Trees with self-children (i.e. cover trees) are always searched
+   * serially, because their rules cache distances in the reference tree.  If
+   * best-first search is enabled, tree::BestFirstTraverser is used instead of
+   * the tree's own single-tree traverser.
+   *
+   * @param querySet Set of query points.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *      point.
+   * @param sameSet Whether or not the query set is the reference set.
+   */
+  void SingleTreeSearch(const MatType& querySet,
+                        arma::Mat<size_t>& neighbors,
+                        arma::mat& distances,
+                        const bool sameSet);
+
+  /**
+   * Perform a dual-tree traversal of the given query tree against the reference
+   * tree, storing the results in the given matrices (which must already be
+   * initialized).  If parallel search is enabled, the query tree is split into
+   * a number of disjoint subtrees, and each of those is traversed against the
+   * reference tree with its own NeighborSearchRules object.  Because each query
+   * subtree holds a disjoint set of points, each thread writes to its own
+   * columns of the neighbors and distances matrices.  (If the subtrees are not
+   * disjoint, as may happen with spill trees, the search is serial.)  The
+   * number of base cases and scores are accumulated into baseCases and scores.
+   *
+   * @param queryTree Tree built on the query points.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *      point.
+   * @param sameSet Whether or not the query tree is the reference tree.
+   * @param uniqueCandidates Whether the candidate lists already hold some
+   *      neighbors, which must not be inserted again.
+   */
+  void DualTreeSearch(Tree& queryTree,
+                      arma::Mat<size_t>& neighbors,
+                      arma::mat& distances,
+                      const bool sameSet,
+                      const bool uniqueCandidates = false);
+
+  //! Reset the bounds held in the statistics of every node of the given tree,
+  //! so that it can be used for another dual-tree search.
+  static void ResetBounds(Tree& tree);
+
+  //! The number of query points and of reference points in each block of a
+  //! naive search.
+  static const size_t NaiveBlockSize = 1024;
+
+  /**
+   * Evaluate the base cases between every query point and every reference
+   * point with the given rules, in blocks of NaiveBlockSize query points and
+   * NaiveBlockSize reference points, so that the distances of a block can be
+   * computed with one matrix multiplication (see
+   * NeighborSearchRules::RangeBaseCase()).  For each query point, the reference
+   * points are still visited in order, so the results are the same as those of
+   * calling BaseCase() on each pair.
+   *
+   * @param rules Rules of the search.
+   * @param numQueries Number of query points.
+   * @param numReferences Number of reference points.
+   */
+  template<typename RuleType>
+  static void NaiveSearch(RuleType& rules,
+                          const size_t numQueries,
+                          const size_t numReferences);
+
   //! The NSModel class should have access to internal members.
   friend class NSModel<SortPolicy>;
 }; // class NeighborSearch
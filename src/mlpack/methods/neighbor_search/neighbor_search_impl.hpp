@@ -10,6 +10,10 @@
 
 #include <mlpack/core.hpp>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 #include "neighbor_search_rules.hpp"
 
 namespace mlpack {
@@ -83,6 +87,13 @@ NeighborSearch(const MatType& referenceSetIn,
     setOwner(false),
     naive(naive),
     singleMode(!naive && singleMode), // No single mode if naive.
+    parallel(false),
+    epsilon(0.0),
+    bestFirst(false),
+    reorderQueries(false),
+    maxVisits(0),
+    baseCaseBudget(0),
+    timeBudget(0.0),
     metric(metric),
     baseCases(0),
     scores(0),
@@ -113,6 +124,13 @@ NeighborSearch(MatType&& referenceSetIn,
     setOwner(naive),
     naive(naive),
     singleMode(!naive && singleMode),
+    parallel(false),
+    epsilon(0.0),
+    bestFirst(false),
+    reorderQueries(false),
+    maxVisits(0),
+    baseCaseBudget(0),
+    timeBudget(0.0),
     metric(metric),
     baseCases(0),
     scores(0),
@@ -139,6 +157,13 @@ NeighborSearch(Tree* referenceTree,
     setOwner(false),
     naive(false),
     singleMode(singleMode),
+    parallel(false),
+    epsilon(0.0),
+    bestFirst(false),
+    reorderQueries(false),
+    maxVisits(0),
+    baseCaseBudget(0),
+    timeBudget(0.0),
     metric(metric),
     baseCases(0),
     scores(0),
@@ -165,6 +190,13 @@ NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
     setOwner(true),
     naive(naive),
     singleMode(singleMode),
+    parallel(false),
+    epsilon(0.0),
+    bestFirst(false),
+    reorderQueries(false),
+    maxVisits(0),
+    baseCaseBudget(0),
+    timeBudget(0.0),
     metric(metric),
     baseCases(0),
     scores(0),
@@ -231,6 +263,7 @@ Train(const MatType& referenceSet)
   else
     this->referenceSet = &referenceSet;
   setOwner = false; // We don't own the set in either case.
+  removed.clear(); // None of the new reference points are removed.
 }
 
 template<typename SortPolicy,
@@ -273,6 +306,7 @@ Train(MatType&& referenceSetIn)
     referenceSet = new MatType(std::move(referenceSetIn));
     setOwner = true;
   }
+  removed.clear(); // None of the new reference points are removed.
 }
 
 template<typename SortPolicy,
@@ -298,6 +332,106 @@ Train(Tree* referenceTree)
   this->referenceSet = &referenceTree->Dataset();
   treeOwner = false;
   setOwner = false;
+  removed.clear(); // None of the new reference points are removed.
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+Insert(const arma::Col<typename MatType::elem_type>& point)
+{
+  if (referenceSet->n_elem == 0)
+    throw std::invalid_argument("cannot insert into an empty reference set; "
+        "call Train() first");
+  if (point.n_elem != referenceSet->n_rows)
+    throw std::invalid_argument("dimensionality of point to insert does not "
+        "match dimensionality of reference set");
+
+  if (naive)
+  {
+    // We can only modify the reference set if we own it.
+    if (!setOwner)
+    {
+      referenceSet = new MatType(*referenceSet);
+      setOwner = true;
+    }
+
+    MatType& dataset = const_cast<MatType&>(*referenceSet);
+    dataset.insert_cols(dataset.n_cols, point);
+  }
+  else
+  {
+    // The tree holds the dataset, and nodes only hold pointers to it, so we
+    // can append the point and then insert it by index.
+    MatType& dataset = const_cast<MatType&>(referenceTree->Dataset());
+    dataset.insert_cols(dataset.n_cols, point);
+    referenceTree->InsertPoint(dataset.n_cols - 1);
+
+    // Now the reference set is the tree's dataset (if it wasn't already).
+    if (setOwner && referenceSet != &referenceTree->Dataset())
+      delete referenceSet;
+    referenceSet = &referenceTree->Dataset();
+    setOwner = false;
+
+    // Any bounds cached in the tree from an earlier search are now invalid.
+    treeNeedsReset = true;
+  }
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+Remove(const size_t index)
+{
+  if (naive)
+    throw std::invalid_argument("cannot remove points in naive mode");
+
+  if (index >= referenceTree->Dataset().n_cols ||
+      !referenceTree->DeletePoint(index))
+    throw std::invalid_argument("cannot remove point that is not in the "
+        "reference tree");
+
+  // The point stays in the reference set, so it is marked as removed.
+  if (removed.size() < referenceSet->n_cols)
+    removed.resize(referenceSet->n_cols, false);
+  removed[index] = true;
+
+  treeNeedsReset = true;
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+CheckSearch(const size_t k, const bool excludeSelf) const
+{
+  if (naive && !removed.empty())
+    throw std::invalid_argument("cannot search in naive mode after points "
+        "were removed from the reference set");
+
+  const size_t livePoints = NumLivePoints();
+  if (k > livePoints || (excludeSelf && k == livePoints))
+  {
+    std::stringstream ss;
+    ss << "requested value of k (" << k << ") is greater than "
+        << (excludeSelf ? "or equal to " : "") << "the number of points in "
+        << "the reference set (" << livePoints << ")";
+    throw std::invalid_argument(ss.str());
+  }
 }
 
 /**
@@ -317,18 +451,13 @@ Search(const MatType& querySet,
        arma::Mat<size_t>& neighbors,
        arma::mat& distances)
 {
-  if (k > referenceSet->n_cols)
-  {
-    std::stringstream ss;
-    ss << "requested value of k (" << k << ") is greater than the number of "
-        << "points in the reference set (" << referenceSet->n_cols << ")";
-    throw std::invalid_argument(ss.str());
-  }
+  CheckSearch(k, false);
 
   Timer::Start("computing_neighbors");
 
   baseCases = 0;
   scores = 0;
+  truncated.assign(querySet.n_cols, false);
 
   // This will hold mappings for query points, if necessary.
   std::vector<size_t> oldFromNewQueries;
@@ -366,30 +495,14 @@ Search(const MatType& querySet,
     // Create the helper object for the tree traversal.
     RuleType rules(*referenceSet, querySet, *neighborPtr, *distancePtr, metric);
 
-    // The naive brute-force traversal.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      for (size_t j = 0; j < referenceSet->n_cols; ++j)
-        rules.BaseCase(i, j);
+    // The naive brute-force traversal, one block of pairs at a time.
+    NaiveSearch(rules, querySet.n_cols, referenceSet->n_cols);
 
     baseCases += querySet.n_cols * referenceSet->n_cols;
   }
   else if (singleMode)
   {
-    // Create the helper object for the tree traversal.
-    RuleType rules(*referenceSet, querySet, *neighborPtr, *distancePtr, metric);
-
-    // Create the traverser.
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
-
-    scores += rules.Scores();
-    baseCases += rules.BaseCases();
-
-    Log::Info << rules.Scores() << " node combinations were scored.\n";
-    Log::Info << rules.BaseCases() << " base cases were calculated.\n";
+    SingleTreeSearch(querySet, *neighborPtr, *distancePtr, false);
   }
   else // Dual-tree recursion.
   {
@@ -400,24 +513,14 @@ Search(const MatType& querySet,
     Timer::Stop("tree_building");
     Timer::Start("computing_neighbors");
 
-    // Create the helper object for the tree traversal.
-    RuleType rules(*referenceSet, queryTree->Dataset(), *neighborPtr,
-        *distancePtr, metric);
-
-    // Create the traverser.
-    TraversalType<RuleType> traverser(rules);
-
-    traverser.Traverse(*queryTree, *referenceTree);
-
-    scores += rules.Scores();
-    baseCases += rules.BaseCases();
-
-    Log::Info << rules.Scores() << " node combinations were scored.\n";
-    Log::Info << rules.BaseCases() << " base cases were calculated.\n";
+    DualTreeSearch(*queryTree, *neighborPtr, *distancePtr, false);
 
     delete queryTree;
   }
 
+  // For large k, the candidate lists were kept as heaps; sort them.
+  CandidateList<SortPolicy>::Sort(*neighborPtr, *distancePtr);
+
   Timer::Stop("computing_neighbors");
 
   // Map points back to original indices, if necessary.
@@ -442,6 +545,11 @@ Search(const MatType& querySet,
         }
       }
 
+      // Map the truncation flags.
+      const std::vector<bool> newTruncated(truncated);
+      for (size_t i = 0; i < newTruncated.size(); ++i)
+        truncated[oldFromNewQueries[i]] = newTruncated[i];
+
       // Finished with temporary matrices.
       delete neighborPtr;
       delete distancePtr;
@@ -460,6 +568,11 @@ Search(const MatType& querySet,
         neighbors.col(queryMapping) = neighborPtr->col(i);
       }
 
+      // Map the truncation flags.
+      const std::vector<bool> newTruncated(truncated);
+      for (size_t i = 0; i < newTruncated.size(); ++i)
+        truncated[oldFromNewQueries[i]] = newTruncated[i];
+
       // Finished with temporary matrices.
       delete neighborPtr;
       delete distancePtr;
@@ -491,13 +604,20 @@ void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
 Search(Tree* queryTree,
        const size_t k,
        arma::Mat<size_t>& neighbors,
-       arma::mat& distances)
+       arma::mat& distances,
+       const bool warmStart)
 {
-  if (k > referenceSet->n_cols)
+  CheckSearch(k, false);
+
+  if (warmStart && (neighbors.n_cols != queryTree->Dataset().n_cols ||
+      distances.n_cols != neighbors.n_cols ||
+      distances.n_rows != neighbors.n_rows))
   {
     std::stringstream ss;
-    ss << "requested value of k (" << k << ") is greater than the number of "
-        << "points in the reference set (" << referenceSet->n_cols << ")";
+    ss << "cannot extend earlier results of size " << neighbors.n_rows << "x"
+        << neighbors.n_cols << " (distances " << distances.n_rows << "x"
+        << distances.n_cols << ") for a query set of "
+        << queryTree->Dataset().n_cols << " points";
     throw std::invalid_argument(ss.str());
   }
 
@@ -513,33 +633,77 @@ Search(Tree* queryTree,
 
   // Get a reference to the query set.
   const MatType& querySet = queryTree->Dataset();
+  truncated.assign(querySet.n_cols, false);
+
+  // The earlier results already hold the nearest neighbors for a smaller k.
+  if (warmStart && k <= neighbors.n_rows)
+  {
+    if (k < neighbors.n_rows)
+    {
+      neighbors.shed_rows(k, neighbors.n_rows - 1);
+      distances.shed_rows(k, distances.n_rows - 1);
+    }
+    Timer::Stop("computing_neighbors");
+    return;
+  }
 
   // We won't need to map query indices, but will we need to map distances?
   arma::Mat<size_t>* neighborPtr = &neighbors;
+  const bool mapReferences = (treeOwner &&
+      tree::TreeTraits<Tree>::RearrangesDataset);
 
-  if (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset)
+  if (mapReferences || warmStart)
     neighborPtr = new arma::Mat<size_t>;
 
   neighborPtr->set_size(k, querySet.n_cols);
   neighborPtr->fill(size_t() - 1);
-  distances.set_size(k, querySet.n_cols);
-  distances.fill(SortPolicy::WorstDistance());
 
-  // Create the helper object for the traversal.
-  typedef NeighborSearchRules<SortPolicy, MetricType, Tree> RuleType;
-  RuleType rules(*referenceSet, querySet, *neighborPtr, distances, metric);
+  if (warmStart)
+  {
+    // Seed the new candidate lists with the known neighbors, whose indices
+    // must first be mapped back into the reference tree.
+    std::vector<size_t> newFromOldReferences;
+    if (mapReferences)
+    {
+      newFromOldReferences.resize(oldFromNewReferences.size());
+      for (size_t i = 0; i < oldFromNewReferences.size(); ++i)
+        newFromOldReferences[oldFromNewReferences[i]] = i;
+    }
 
-  // Create the traverser.
-  TraversalType<RuleType> traverser(rules);
-  traverser.Traverse(*queryTree, *referenceTree);
+    const arma::mat oldDistances(distances);
+    distances.set_size(k, querySet.n_cols);
+    distances.fill(SortPolicy::WorstDistance());
 
-  scores += rules.Scores();
-  baseCases += rules.BaseCases();
+    CandidateList<SortPolicy> candidates(*neighborPtr, distances);
+    for (size_t i = 0; i < neighbors.n_cols; ++i)
+    {
+      for (size_t j = 0; j < neighbors.n_rows; ++j)
+      {
+        if (neighbors(j, i) == size_t() - 1)
+          continue;
+
+        candidates.Insert(i, mapReferences ?
+            newFromOldReferences[neighbors(j, i)] : neighbors(j, i),
+            oldDistances(j, i));
+      }
+    }
+  }
+  else
+  {
+    distances.set_size(k, querySet.n_cols);
+    distances.fill(SortPolicy::WorstDistance());
+  }
+
+  // The statistics may hold bounds from an earlier search with this tree.
+  ResetBounds(*queryTree);
+
+  DualTreeSearch(*queryTree, *neighborPtr, distances, false, warmStart);
+  CandidateList<SortPolicy>::Sort(*neighborPtr, distances);
 
   Timer::Stop("computing_neighbors");
 
   // Do we need to map indices?
-  if (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset)
+  if (mapReferences)
   {
     // We must map reference indices only.
     neighbors.set_size(k, querySet.n_cols);
@@ -552,6 +716,11 @@ Search(Tree* queryTree,
     // Finished with temporary matrix.
     delete neighborPtr;
   }
+  else if (warmStart)
+  {
+    neighbors = *neighborPtr;
+    delete neighborPtr;
+  }
 }
 
 template<typename SortPolicy,
@@ -566,18 +735,13 @@ Search(const size_t k,
        arma::Mat<size_t>& neighbors,
        arma::mat& distances)
 {
-  if (k > referenceSet->n_cols)
-  {
-    std::stringstream ss;
-    ss << "requested value of k (" << k << ") is greater than the number of "
-        << "points in the reference set (" << referenceSet->n_cols << ")";
-    throw std::invalid_argument(ss.str());
-  }
+  CheckSearch(k, false);
 
   Timer::Start("computing_neighbors");
 
   baseCases = 0;
   scores = 0;
+  truncated.assign(referenceSet->n_cols, false);
 
   arma::Mat<size_t>* neighborPtr = &neighbors;
   arma::mat* distancePtr = &distances;
@@ -595,75 +759,38 @@ Search(const size_t k,
   distancePtr->set_size(k, referenceSet->n_cols);
   distancePtr->fill(SortPolicy::WorstDistance());
 
-  // Create the helper object for the traversal.
-  typedef NeighborSearchRules<SortPolicy, MetricType, Tree> RuleType;
-  RuleType rules(*referenceSet, *referenceSet, *neighborPtr, *distancePtr,
-      metric, true /* don't return the same point as nearest neighbor */);
-
   if (naive)
   {
-    // The naive brute-force solution.
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      for (size_t j = 0; j < referenceSet->n_cols; ++j)
-        rules.BaseCase(i, j);
+    // Create the helper object for the traversal.
+    typedef NeighborSearchRules<SortPolicy, MetricType, Tree> RuleType;
+    RuleType rules(*referenceSet, *referenceSet, *neighborPtr, *distancePtr,
+        metric, true /* don't return the same point as nearest neighbor */);
+
+    // The naive brute-force solution, one block of pairs at a time.
+    NaiveSearch(rules, referenceSet->n_cols, referenceSet->n_cols);
 
     baseCases += referenceSet->n_cols * referenceSet->n_cols;
   }
   else if (singleMode)
   {
-    // Create the traverser.
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
-
-    scores += rules.Scores();
-    baseCases += rules.BaseCases();
-
-    Log::Info << rules.Scores() << " node combinations were scored.\n";
-    Log::Info << rules.BaseCases() << " base cases were calculated.\n";
+    SingleTreeSearch(*referenceSet, *neighborPtr, *distancePtr, true);
   }
   else
   {
     // The dual-tree monochromatic search case may require resetting the bounds
     // in the tree.
     if (treeNeedsReset)
-    {
-      std::stack<Tree*> nodes;
-      nodes.push(referenceTree);
-      while (!nodes.empty())
-      {
-        Tree* node = nodes.top();
-        nodes.pop();
-
-        // Reset bounds of this node.
-        node->Stat().FirstBound() = SortPolicy::WorstDistance();
-        node->Stat().SecondBound() = SortPolicy::WorstDistance();
-        node->Stat().Bound() = SortPolicy::WorstDistance();
-        node->Stat().LastDistance() = 0.0;
-
-        // Then add the children.
-        for (size_t i = 0; i < node->NumChildren(); ++i)
-          nodes.push(&node->Child(i));
-      }
-    }
-
-    // Create the traverser.
-    TraversalType<RuleType> traverser(rules);
-
-    traverser.Traverse(*referenceTree, *referenceTree);
-
-    scores += rules.Scores();
-    baseCases += rules.BaseCases();
+      ResetBounds(*referenceTree);
 
-    Log::Info << rules.Scores() << " node combinations were scored.\n";
-    Log::Info << rules.BaseCases() << " base cases were calculated.\n";
+    DualTreeSearch(*referenceTree, *neighborPtr, *distancePtr, true);
 
     // Next time we perform this search, we'll need to reset the tree.
     treeNeedsReset = true;
   }
 
+  // For large k, the candidate lists were kept as heaps; sort them.
+  CandidateList<SortPolicy>::Sort(*neighborPtr, *distancePtr);
+
   Timer::Stop("computing_neighbors");
 
   // Do we need to map the reference indices?
@@ -683,12 +810,429 @@ Search(const size_t k,
         neighbors(j, refMapping) = oldFromNewReferences[(*neighborPtr)(j, i)];
     }
 
+    // Map the truncation flags.
+    const std::vector<bool> newTruncated(truncated);
+    for (size_t i = 0; i < newTruncated.size(); ++i)
+      truncated[oldFromNewReferences[i]] = newTruncated[i];
+
     // Finished with temporary matrices.
     delete neighborPtr;
     delete distancePtr;
   }
 }
 
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+template<typename CallbackType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+Search(const MatType& querySet,
+       const size_t k,
+       CallbackType& callback,
+       const size_t blockSize)
+{
+  if (blockSize == 0)
+    throw std::invalid_argument("NeighborSearch::Search(): block size must be "
+        "positive");
+
+  size_t totalBaseCases = 0;
+  size_t totalScores = 0;
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  for (size_t begin = 0; begin < querySet.n_cols; begin += blockSize)
+  {
+    const size_t end = std::min(begin + blockSize, (size_t) querySet.n_cols);
+    Search(querySet.cols(begin, end - 1), k, neighbors, distances);
+    totalBaseCases += baseCases;
+    totalScores += scores;
+
+    for (size_t i = 0; i < neighbors.n_cols; ++i)
+    {
+      const arma::Col<size_t> queryNeighbors(neighbors.unsafe_col(i));
+      const arma::vec queryDistances(distances.unsafe_col(i));
+      callback(begin + i, queryNeighbors, queryDistances);
+    }
+  }
+
+  baseCases = totalBaseCases;
+  scores = totalScores;
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+template<typename CallbackType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+Search(const size_t k,
+       CallbackType& callback,
+       const size_t blockSize)
+{
+  CheckSearch(k, true);
+
+  if (blockSize == 0)
+    throw std::invalid_argument("NeighborSearch::Search(): block size must be "
+        "positive");
+
+  // The reference set may have been rearranged, but the points are given to
+  // the callback in their original order.
+  const bool mapped = treeOwner && tree::TreeTraits<Tree>::RearrangesDataset;
+  std::vector<size_t> newFromOld;
+  if (mapped)
+  {
+    newFromOld.resize(oldFromNewReferences.size());
+    for (size_t i = 0; i < oldFromNewReferences.size(); ++i)
+      newFromOld[oldFromNewReferences[i]] = i;
+  }
+
+  size_t totalBaseCases = 0;
+  size_t totalScores = 0;
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  arma::Col<size_t> queryNeighbors(k);
+  arma::vec queryDistances(k);
+  for (size_t begin = 0; begin < referenceSet->n_cols; begin += blockSize)
+  {
+    const size_t end = std::min(begin + blockSize,
+        (size_t) referenceSet->n_cols);
+
+    // Points removed with Remove() are not searched for.
+    std::vector<size_t> blockPoints;
+    for (size_t i = begin; i < end; ++i)
+      if (!Removed(mapped ? newFromOld[i] : i))
+        blockPoints.push_back(i);
+    if (blockPoints.empty())
+      continue;
+
+    MatType block(referenceSet->n_rows, blockPoints.size());
+    for (size_t i = 0; i < blockPoints.size(); ++i)
+      block.col(i) = referenceSet->col(mapped ? newFromOld[blockPoints[i]] :
+          blockPoints[i]);
+
+    Search(block, k + 1, neighbors, distances);
+    totalBaseCases += baseCases;
+    totalScores += scores;
+
+    for (size_t i = 0; i < neighbors.n_cols; ++i)
+    {
+      // Skip the point itself; if it isn't in the results (because of ties
+      // with duplicate points), skip the last result instead.
+      size_t skip = k;
+      for (size_t j = 0; j < k + 1; ++j)
+      {
+        if (neighbors(j, i) == blockPoints[i])
+        {
+          skip = j;
+          break;
+        }
+      }
+
+      for (size_t j = 0, l = 0; j < k + 1; ++j)
+      {
+        if (j == skip)
+          continue;
+
+        queryNeighbors[l] = neighbors(j, i);
+        queryDistances[l] = distances(j, i);
+        ++l;
+      }
+
+      callback(blockPoints[i], queryNeighbors, queryDistances);
+    }
+  }
+
+  baseCases = totalBaseCases;
+  scores = totalScores;
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+SingleTreeSearch(const MatType& querySet,
+                 arma::Mat<size_t>& neighbors,
+                 arma::mat& distances,
+                 const bool sameSet)
+{
+  typedef NeighborSearchRules<SortPolicy, MetricType, Tree> RuleType;
+  typedef typename Tree::template SingleTreeTraverser<RuleType> TraverserType;
+  typedef tree::BestFirstTraverser<Tree, RuleType> BestFirstTraverserType;
+
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+
+  // The query points are searched in the order of queryOrder; each one writes
+  // only to its own column of the results, so they need no unpermuting.
+  std::vector<size_t> queryOrder;
+  tree::QueryOrder(querySet, queryOrder, reorderQueries);
+
+  // The best-first traverser visits every child that is not pruned, so with
+  // overlapping children (like those of a spill tree, which may hold the same
+  // points) a reference point could be found twice.
+  const bool uniqueCandidates = bestFirst &&
+      tree::TreeTraits<Tree>::HasOverlappingChildren;
+
+  // Trees with self-children cache the last point-to-node distance in the
+  // statistic of each reference node during single-tree search, so threads
+  // cannot share the reference tree.  A budget can't be shared by threads
+  // either.
+  const bool budgeted = (baseCaseBudget > 0 || timeBudget > 0.0);
+  if (!parallel || numThreads == 1 || tree::TreeTraits<Tree>::HasSelfChildren ||
+      budgeted)
+  {
+    if (parallel && numThreads > 1)
+      Log::Info << "Parallel single-tree search is not available for this tree "
+          << "type or with a budget; searching serially." << std::endl;
+
+    // Create the helper object for the tree traversal.
+    RuleType rules(*referenceSet, querySet, neighbors, distances, metric,
+        sameSet, epsilon);
+    rules.UniqueCandidates() = uniqueCandidates;
+    SearchBudget budget(baseCaseBudget, timeBudget, querySet.n_cols);
+    if (budgeted)
+      rules.Budget() = &budget;
+
+    // Create the traverser and have it traverse for each point.
+    if (bestFirst)
+    {
+      BestFirstTraverserType traverser(rules, maxVisits);
+      for (size_t i = 0; i < querySet.n_cols; ++i)
+        if (!sameSet || !Removed(queryOrder[i]))
+          traverser.Traverse(queryOrder[i], *referenceTree);
+    }
+    else
+    {
+      TraverserType traverser(rules);
+      for (size_t i = 0; i < querySet.n_cols; ++i)
+        if (!sameSet || !Removed(queryOrder[i]))
+          traverser.Traverse(queryOrder[i], *referenceTree);
+    }
+
+    scores += rules.Scores();
+    baseCases += rules.BaseCases();
+    if (budgeted)
+      truncated = budget.Truncated();
+
+    Log::Info << rules.Scores() << " node combinations were scored.\n";
+    Log::Info << rules.BaseCases() << " base cases were calculated.\n";
+    return;
+  }
+
+  size_t totalScores = 0;
+  size_t totalBaseCases = 0;
+
+  #pragma omp parallel reduction(+:totalScores, totalBaseCases)
+  {
+    // Each thread gets its own rules, traverser, and metric, and only writes to
+    // the columns of the query points it is given.
+    MetricType threadMetric(metric);
+    RuleType rules(*referenceSet, querySet, neighbors, distances, threadMetric,
+        sameSet, epsilon);
+    rules.UniqueCandidates() = uniqueCandidates;
+    TraverserType traverser(rules);
+    BestFirstTraverserType bestFirstTraverser(rules, maxVisits);
+
+    #pragma omp for schedule(dynamic, 64)
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+    {
+      if (sameSet && Removed(queryOrder[i]))
+        continue;
+
+      if (bestFirst)
+        bestFirstTraverser.Traverse(queryOrder[i], *referenceTree);
+      else
+        traverser.Traverse(queryOrder[i], *referenceTree);
+    }
+
+    totalScores += rules.Scores();
+    totalBaseCases += rules.BaseCases();
+  }
+
+  scores += totalScores;
+  baseCases += totalBaseCases;
+
+  Log::Info << totalScores << " node combinations were scored.\n";
+  Log::Info << totalBaseCases << " base cases were calculated.\n";
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+DualTreeSearch(Tree& queryTree,
+               arma::Mat<size_t>& neighbors,
+               arma::mat& distances,
+               const bool sameSet,
+               const bool uniqueCandidates)
+{
+  typedef NeighborSearchRules<SortPolicy, MetricType, Tree> RuleType;
+
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+
+  // A budget can't be shared by threads, so a budgeted search is serial.
+  const bool budgeted = (baseCaseBudget > 0 || timeBudget > 0.0);
+
+  // Split the query tree into several disjoint subtrees; we generate a few
+  // more subtrees than threads so that the work can be balanced dynamically.
+  // The overlapping children of a spill tree may hold the same query points,
+  // whose results would then be written by several threads at once, so if the
+  // subtrees are not disjoint the search is serial.
+  std::vector<Tree*> frontier;
+  bool disjoint = true;
+  if (parallel && numThreads > 1 && !budgeted)
+  {
+    tree::SubtreeFrontier(queryTree, 4 * numThreads, frontier);
+    if (tree::TreeTraits<Tree>::HasOverlappingChildren)
+      disjoint = tree::FrontierIsDisjoint(frontier,
+          queryTree.Dataset().n_cols);
+  }
+
+  // The squared norms for the block base cases are computed once here, so
+  // that they are not recomputed by the rules of each task.
+  arma::vec queryNorms, referenceNorms;
+  RuleType::SquaredNorms(*referenceSet, referenceNorms);
+  if (!sameSet)
+    RuleType::SquaredNorms(queryTree.Dataset(), queryNorms);
+  const arma::vec& queryNormsRef = (sameSet ? referenceNorms : queryNorms);
+
+  if (!parallel || numThreads == 1 || budgeted || !disjoint)
+  {
+    // Create the helper object for the tree traversal.
+    RuleType rules(*referenceSet, queryTree.Dataset(), neighbors, distances,
+        metric, sameSet, epsilon);
+    rules.UniqueCandidates() = uniqueCandidates;
+    rules.SetSquaredNorms(queryNormsRef, referenceNorms);
+    SearchBudget budget(baseCaseBudget, timeBudget,
+        queryTree.Dataset().n_cols);
+    if (budgeted)
+      rules.Budget() = &budget;
+
+    // Create the traverser.
+    TraversalType<RuleType> traverser(rules);
+
+    traverser.Traverse(queryTree, *referenceTree);
+
+    scores += rules.Scores();
+    baseCases += rules.BaseCases();
+    if (budgeted)
+      truncated = budget.Truncated();
+
+    Log::Info << rules.Scores() << " node combinations were scored.\n";
+    Log::Info << rules.BaseCases() << " base cases were calculated.\n";
+    return;
+  }
+
+  Log::Info << "Splitting dual-tree search into " << frontier.size()
+      << " query subtrees across " << numThreads << " threads." << std::endl;
+
+  size_t totalScores = 0;
+  size_t totalBaseCases = 0;
+
+  #pragma omp parallel for schedule(dynamic) \
+      reduction(+:totalScores, totalBaseCases)
+  for (size_t i = 0; i < frontier.size(); ++i)
+  {
+    // Each task gets its own rules, traverser, and metric.  All writes to the
+    // neighbors and distances matrices are restricted to the columns of the
+    // points held in this query subtree.
+    MetricType taskMetric(metric);
+    RuleType rules(*referenceSet, queryTree.Dataset(), neighbors, distances,
+        taskMetric, sameSet, epsilon);
+    rules.UniqueCandidates() = uniqueCandidates;
+    rules.SetSquaredNorms(queryNormsRef, referenceNorms);
+    TraversalType<RuleType> traverser(rules);
+
+    traverser.Traverse(*frontier[i], *referenceTree);
+
+    totalScores += rules.Scores();
+    totalBaseCases += rules.BaseCases();
+  }
+
+  scores += totalScores;
+  baseCases += totalBaseCases;
+
+  Log::Info << totalScores << " node combinations were scored.\n";
+  Log::Info << totalBaseCases << " base cases were calculated.\n";
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+ResetBounds(Tree& tree)
+{
+  std::stack<Tree*> nodes;
+  nodes.push(&tree);
+  while (!nodes.empty())
+  {
+    Tree* node = nodes.top();
+    nodes.pop();
+
+    // Reset bounds of this node.
+    node->Stat().FirstBound() = SortPolicy::WorstDistance();
+    node->Stat().SecondBound() = SortPolicy::WorstDistance();
+    node->Stat().Bound() = SortPolicy::WorstDistance();
+    node->Stat().LastDistance() = 0.0;
+
+    // Then add the children.
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+      nodes.push(&node->Child(i));
+  }
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+template<typename RuleType>
+void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
+NaiveSearch(RuleType& rules,
+            const size_t numQueries,
+            const size_t numReferences)
+{
+  for (size_t i = 0; i < numQueries; i += NaiveBlockSize)
+  {
+    const size_t queryEnd = std::min(i + NaiveBlockSize, numQueries) - 1;
+    for (size_t j = 0; j < numReferences; j += NaiveBlockSize)
+    {
+      const size_t referenceEnd = std::min(j + NaiveBlockSize, numReferences)
+          - 1;
+      rules.RangeBaseCase(i, queryEnd, j, referenceEnd);
+    }
+  }
+}
+
 // Return a String of the Object.
 template<typename SortPolicy,
          typename MetricType,
@@ -713,6 +1257,29 @@ std::string NeighborSearch<SortPolicy, MetricType, MatType, TreeType,
   return convert.str();
 }
 
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename> class TraversalType>
+size_t NeighborSearch<SortPolicy, MetricType, MatType, TreeType,
+                      TraversalType>::MemoryUsage() const
+{
+  size_t bytes = sizeof(*this) + mlpack::MemoryUsage(oldFromNewReferences) +
+      mlpack::MemoryUsage(truncated);
+
+  if (referenceTree && treeOwner)
+    bytes += tree::TreeMemoryUsage(*referenceTree);
+
+  // The reference set is held by the tree, if the tree is ours.
+  if (referenceSet && (treeOwner || setOwner))
+    bytes += mlpack::MemoryUsage(*referenceSet);
+
+  return bytes;
+}
+
 //! Serialize the NeighborSearch model.
 template<typename SortPolicy,
          typename MetricType,
@@ -756,6 +1323,7 @@ void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
 
       referenceTree = NULL;
       oldFromNewReferences.clear();
+      removed.clear(); // Points can't be removed in naive mode.
       treeOwner = false;
     }
   }
@@ -773,6 +1341,7 @@ void NeighborSearch<SortPolicy, MetricType, MatType, TreeType, TraversalType>::
 
     ar & CreateNVP(referenceTree, "referenceTree");
     ar & CreateNVP(oldFromNewReferences, "oldFromNewReferences");
+    ar & CreateNVP(removed, "removed");
 
     // If we are loading, set the dataset accordingly and clean up memory if
     // necessary.
@@ -8,7 +8,11 @@
 #ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_NEIGHBOR_SEARCH_RULES_HPP
 #define __MLPACK_METHODS_NEIGHBOR_SEARCH_NEIGHBOR_SEARCH_RULES_HPP
 
+#include <mlpack/core/metrics/lmetric.hpp>
+#include "candidate_list.hpp"
 #include "ns_traversal_info.hpp"
+#include "search_budget.hpp"
+#include "sort_policies/nearest_neighbor_sort.hpp"
 
 namespace mlpack {
 namespace neighbor {
@@ -17,12 +21,30 @@ template<typename SortPolicy, typename MetricType, typename TreeType>
 class NeighborSearchRules
 {
  public:
+  /**
+   * Construct the NeighborSearchRules object.  This is usually done from within
+   * the NeighborSearch class at search time.
+   *
+   * If epsilon is greater than zero, the search is (1 + epsilon)-approximate:
+   * every pruning bound is relaxed with SortPolicy::Relax(), so that each
+   * returned neighbor distance is guaranteed to be within a relative error of
+   * epsilon of the true neighbor distance for that rank.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param neighbors Matrix to store resulting neighbor indices in.
+   * @param distances Matrix to store resulting distances in.
+   * @param metric Instantiated metric.
+   * @param sameSet If true, the query and reference sets are the same.
+   * @param epsilon Relative approximation error (0 gives exact search).
+   */
   NeighborSearchRules(const typename TreeType::Mat& referenceSet,
                       const typename TreeType::Mat& querySet,
                       arma::Mat<size_t>& neighbors,
                       arma::mat& distances,
                       MetricType& metric,
-                      const bool sameSet = false);
+                      const bool sameSet = false,
+                      const double epsilon = 0.0);
   /**
    * Get the distance from the query point to the reference point.
    * This will update the "neighbor" matrix with the new point if appropriate
@@ -33,6 +55,49 @@ class NeighborSearchRules
    */
   double BaseCase(const size_t queryIndex, const size_t referenceIndex);
 
+  /**
+   * Evaluate the base cases between every point in the given query leaf and
+   * every point in the given reference leaf.  Each query point is first scored
+   * against the reference node, and query points that cannot be improved are
+   * skipped.  For nearest neighbor search with the Euclidean distance, the
+   * whole block of (squared) distances is then computed at once as
+   * ||q||^2 + ||r||^2 - 2 Q^T R; the squared norms of the points are computed
+   * the first time this is called.  Because that expansion is not exact, it is
+   * only used to filter out reference points; any point that might be a
+   * candidate has its distance recomputed with the metric before it is
+   * inserted, so the results are identical to calling BaseCase() on each pair.
+   * For other metrics and sort policies, BaseCase() is simply called on each
+   * pair.
+   *
+   * The points held by each leaf must be contiguous in the dataset, as they are
+   * for BinarySpaceTree (whose dual-tree traverser calls this function).
+   *
+   * @param queryNode Query leaf.
+   * @param referenceNode Reference leaf.
+   * @return Number of base cases that were performed.
+   */
+  size_t BlockBaseCase(TreeType& queryNode, TreeType& referenceNode);
+
+  /**
+   * Evaluate the base cases between every query point in the given range of
+   * columns and every reference point in the given range of columns, as in a
+   * naive search.  For nearest neighbor search with the Euclidean distance, the
+   * block of (squared) distances is computed at once with a matrix
+   * multiplication, as in BlockBaseCase() (so a BLAS that offloads large
+   * multiplications to a GPU, such as NVBLAS, runs it there); the squared norms
+   * of the points are computed the first time this is called.  Otherwise
+   * BaseCase() is called on each pair.
+   *
+   * @param queryBegin Index of the first query point.
+   * @param queryEnd Index of the last query point.
+   * @param referenceBegin Index of the first reference point.
+   * @param referenceEnd Index of the last reference point.
+   */
+  void RangeBaseCase(const size_t queryBegin,
+                     const size_t queryEnd,
+                     const size_t referenceBegin,
+                     const size_t referenceEnd);
+
   /**
    * Get the score for recursion order.  A low score indicates priority for
    * recursion, while DBL_MAX indicates that the node should not be recursed
@@ -43,6 +108,34 @@ class NeighborSearchRules
    */
   double Score(const size_t queryIndex, TreeType& referenceNode);
 
+  /**
+   * Score the query point with every child of the given reference node, in one
+   * call; the score of child i is stored in childScores[i], and is the same as
+   * that of Score().  The query point and the bound on its k'th best distance
+   * are only looked up once, and the distances to all of the children are
+   * computed before any of them is compared, so that the loads of the bounds of
+   * the children overlap.  This is used by the single-tree traverser of
+   * BinarySpaceTree.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceNode Node whose children are scored.
+   * @param childScores Array to store the score of each child in (with
+   *     referenceNode.NumChildren() elements).
+   */
+  void ScoreChildren(const size_t queryIndex,
+                     TreeType& referenceNode,
+                     double* childScores);
+
+  /**
+   * Get the index of the child of the given reference node that is most likely
+   * to hold the best neighbors of the query point.  This is used by defeatist
+   * traversals (such as the one of SpillTree), which visit only that child.
+   *
+   * @param queryIndex Index of query point.
+   * @param referenceNode Node whose children are considered.
+   */
+  size_t GetBestChild(const size_t queryIndex, TreeType& referenceNode);
+
   /**
    * Re-evaluate the score for recursion order.  A low score indicates priority
    * for recursion, while DBL_MAX indicates that the node should not be recursed
@@ -96,6 +189,58 @@ class NeighborSearchRules
   //! Convenience typedef.
   typedef NeighborSearchTraversalInfo<TreeType> TraversalInfoType;
 
+  //! Get the relative error tolerance for approximate search.
+  double Epsilon() const { return epsilon; }
+
+  //! Get the budget of the traversal (NULL if there is no budget).
+  SearchBudget* Budget() const { return budget; }
+  //! Modify the budget of the traversal.  Once the budget is spent, every node
+  //! that would be recursed into is pruned instead, unless a query point still
+  //! has fewer than k candidates; the query points it would have been recursed
+  //! into for are marked as truncated in the budget.
+  SearchBudget*& Budget() { return budget; }
+
+  //! Get whether a reference point already among the candidates of a query
+  //! point is not inserted again.
+  bool UniqueCandidates() const { return candidates.Unique(); }
+  //! Modify whether a reference point already among the candidates of a query
+  //! point is not inserted again.  This must be set if the candidate lists are
+  //! not empty when the traversal starts.
+  bool& UniqueCandidates() { return candidates.Unique(); }
+
+  /**
+   * Use the given squared norms of the query and reference points in the block
+   * kernel, instead of computing them.  When several rules objects search the
+   * same sets (as in parallel dual-tree search), the norms can then be computed
+   * once and shared.  The vectors must outlive the traversal.
+   *
+   * @param queryNorms Squared norms of the query points.
+   * @param referenceNorms Squared norms of the reference points.
+   */
+  void SetSquaredNorms(const arma::vec& queryNorms,
+                       const arma::vec& referenceNorms)
+  {
+    querySquaredNorms = &queryNorms;
+    referenceSquaredNorms = &referenceNorms;
+  }
+
+  /**
+   * Compute the squared norms of the points in the given set, for
+   * SetSquaredNorms().  If the block kernel is not used (for other metrics and
+   * sort policies), the norms are not needed and are left empty.
+   *
+   * @param set Set of points.
+   * @param norms Vector to store the squared norms in.
+   */
+  static void SquaredNorms(const typename TreeType::Mat& set, arma::vec& norms)
+  {
+    if (UseBlockKernel)
+      norms = arma::conv_to<arma::vec>::from(arma::trans(
+          arma::sum(arma::square(set), 0)));
+    else
+      norms.reset();
+  }
+
   //! Get the traversal info.
   const TraversalInfoType& TraversalInfo() const { return traversalInfo; }
   //! Modify the traversal info.
@@ -114,12 +259,18 @@ class NeighborSearchRules
   //! The matrix the resultant neighbor distances should be stored in.
   arma::mat& distances;
 
+  //! The candidate lists of the query points, held in neighbors and distances.
+  CandidateList<SortPolicy> candidates;
+
   //! The instantiated metric.
   MetricType& metric;
 
   //! Denotes whether or not the reference and query sets are the same.
   bool sameSet;
 
+  //! Relative error tolerance for approximate search (0 for exact search).
+  double epsilon;
+
   //! The last query point BaseCase() was called with.
   size_t lastQueryIndex;
   //! The last reference point BaseCase() was called with.
@@ -132,28 +283,97 @@ class NeighborSearchRules
   //! The number of scores that have been performed.
   size_t scores;
 
+  //! The budget of the traversal, if any.
+  SearchBudget* budget;
+
   //! Traversal info for the parent combination; this is updated by the
   //! traversal before each call to Score().
   TraversalInfoType traversalInfo;
 
+  //! Whether or not BlockBaseCase() can use the matrix multiplication kernel.
+  static const bool UseBlockKernel =
+      metric::IsEuclideanMetric<MetricType>::Value &&
+      std::is_same<SortPolicy, NearestNeighborSort>::value;
+
+  //! Holds the inner products between a query leaf and a reference leaf, so
+  //! that BlockBaseCase() does not reallocate it for every pair of leaves.
+  arma::Mat<typename TreeType::Mat::elem_type> innerProducts;
+  //! Holds the query points that BlockBaseCase() must evaluate.
+  std::vector<size_t> activeQueries;
+  //! The squared norms of the query points, for the block kernel (NULL until
+  //! they are given or computed).
+  const arma::vec* querySquaredNorms;
+  //! The squared norms of the reference points, for the block kernel.
+  const arma::vec* referenceSquaredNorms;
+  //! The squared norms of the query points, if they were not given.
+  arma::vec computedQueryNorms;
+  //! The squared norms of the reference points, if they were not given.
+  arma::vec computedReferenceNorms;
+
+  //! Compute the squared norms of the query and reference points, if they
+  //! were not given with SetSquaredNorms() and have not been computed yet.
+  void ComputeSquaredNorms();
+
+  //! Evaluate the base cases for the active query points in BlockBaseCase()
+  //! one pair at a time.
+  void EvaluateBlock(TreeType& queryNode,
+                     TreeType& referenceNode,
+                     std::false_type useBlockKernel);
+
+  //! Evaluate the base cases for the active query points in BlockBaseCase()
+  //! with the matrix multiplication kernel.
+  void EvaluateBlock(TreeType& queryNode,
+                     TreeType& referenceNode,
+                     std::true_type useBlockKernel);
+
+  //! Evaluate the base cases of a range of query points and a range of
+  //! reference points in RangeBaseCase() one pair at a time.
+  void EvaluateRange(const size_t queryBegin,
+                     const size_t queryEnd,
+                     const size_t referenceBegin,
+                     const size_t referenceEnd,
+                     std::false_type useBlockKernel);
+
+  //! Evaluate the base cases of a range of query points and a range of
+  //! reference points in RangeBaseCase() with the matrix multiplication
+  //! kernel.
+  void EvaluateRange(const size_t queryBegin,
+                     const size_t queryEnd,
+                     const size_t referenceBegin,
+                     const size_t referenceEnd,
+                     std::true_type useBlockKernel);
+
   /**
-   * Recalculate the bound for a given query node.
+   * Insert the candidates of the active query points among the reference
+   * points with the given indices, using the inner products held in
+   * innerProducts (one row for each query point starting at queryBegin, one
+   * column for each reference point starting at referenceBegin) and the
+   * squared norms of the points, to skip the points that cannot be
+   * candidates.
    */
-  double CalculateBound(TreeType& queryNode) const;
+  void InsertBlock(const size_t queryBegin,
+                   const size_t referenceBegin,
+                   const arma::vec& queryNorms,
+                   const arma::vec& referenceNorms);
 
   /**
-   * Insert a point into the neighbors and distances matrices; this is a helper
-   * function.
-   *
-   * @param queryIndex Index of point whose neighbors we are inserting into.
-   * @param pos Position in list to insert into.
-   * @param neighbor Index of reference point which is being inserted.
-   * @param distance Distance from query point to reference point.
-   */
-  void InsertNeighbor(const size_t queryIndex,
-                      const size_t pos,
-                      const size_t neighbor,
-                      const double distance);
+   * If the budget has been spent, prune a node that would otherwise be recursed
+   * into (that is, one with a score other than DBL_MAX) and mark the query
+   * point as truncated.  Otherwise, return the score unchanged.
+   */
+  double CheckBudget(const size_t queryIndex, const double score) const;
+
+  /**
+   * If the budget has been spent, prune a node combination that would otherwise
+   * be recursed into and mark all the descendants of the query node as
+   * truncated.  Otherwise, return the score unchanged.
+   */
+  double CheckBudget(TreeType& queryNode, const double score) const;
+
+  /**
+   * Recalculate the bound for a given query node.
+   */
+  double CalculateBound(TreeType& queryNode) const;
 };
 
 }; // namespace neighbor
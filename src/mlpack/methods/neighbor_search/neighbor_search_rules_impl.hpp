@@ -20,17 +20,23 @@ NeighborSearchRules<SortPolicy, MetricType, TreeType>::NeighborSearchRules(
     arma::Mat<size_t>& neighbors,
     arma::mat& distances,
     MetricType& metric,
-    const bool sameSet) :
+    const bool sameSet,
+    const double epsilon) :
     referenceSet(referenceSet),
     querySet(querySet),
     neighbors(neighbors),
     distances(distances),
+    candidates(neighbors, distances),
     metric(metric),
     sameSet(sameSet),
+    epsilon(epsilon),
     lastQueryIndex(querySet.n_cols),
     lastReferenceIndex(referenceSet.n_cols),
     baseCases(0),
-    scores(0)
+    scores(0),
+    budget(NULL),
+    querySquaredNorms(NULL),
+    referenceSquaredNorms(NULL)
 {
   // We must set the traversal info last query and reference node pointers to
   // something that is both invalid (i.e. not a tree node) and not NULL.  We'll
@@ -53,20 +59,21 @@ BaseCase(const size_t queryIndex, const size_t referenceIndex)
   if ((lastQueryIndex == queryIndex) && (lastReferenceIndex == referenceIndex))
     return lastBaseCase;
 
-  double distance = metric.Evaluate(querySet.col(queryIndex),
-                                    referenceSet.col(referenceIndex));
+  // For nearest neighbor search, the distance is not needed once it is known
+  // to be worse than the k'th best candidate, so the metric may stop early and
+  // return a smaller (but still worse) distance.  That is not done when the
+  // base case is also the distance between the centroids of two nodes, because
+  // a smaller distance would loosen the bounds that Score() gets from it.
+  const bool bounded = std::is_same<SortPolicy, NearestNeighborSort>::value &&
+      !tree::TreeTraits<TreeType>::FirstPointIsCentroid;
+  const double bound = bounded ? candidates.Worst(queryIndex) :
+      DBL_MAX;
+  double distance = metric::BoundedEvaluate(metric, querySet.col(queryIndex),
+      referenceSet.col(referenceIndex), bound);
   ++baseCases;
 
-  // If this distance is better than any of the current candidates, the
-  // SortDistance() function will give us the position to insert it into.
-  arma::vec queryDist = distances.unsafe_col(queryIndex);
-  arma::Col<size_t> queryIndices = neighbors.unsafe_col(queryIndex);
-  const size_t insertPosition = SortPolicy::SortDistance(queryDist,
-      queryIndices, distance);
-
-  // SortDistance() returns (size_t() - 1) if we shouldn't add it.
-  if (insertPosition != (size_t() - 1))
-    InsertNeighbor(queryIndex, insertPosition, referenceIndex, distance);
+  // Insert the point if it is better than any of the current candidates.
+  candidates.Insert(queryIndex, referenceIndex, distance);
 
   // Cache this information for the next time BaseCase() is called.
   lastQueryIndex = queryIndex;
@@ -76,6 +83,171 @@ BaseCase(const size_t queryIndex, const size_t referenceIndex)
   return distance;
 }
 
+template<typename SortPolicy, typename MetricType, typename TreeType>
+size_t NeighborSearchRules<SortPolicy, MetricType, TreeType>::BlockBaseCase(
+    TreeType& queryNode,
+    TreeType& referenceNode)
+{
+  // Find the query points that might be improved by this reference node.
+  activeQueries.clear();
+  for (size_t i = 0; i < queryNode.NumPoints(); ++i)
+    if (Score(queryNode.Point(i), referenceNode) != DBL_MAX)
+      activeQueries.push_back(i);
+
+  if (activeQueries.size() == 0 || referenceNode.NumPoints() == 0)
+    return 0;
+
+  EvaluateBlock(queryNode, referenceNode,
+      std::integral_constant<bool, UseBlockKernel>());
+
+  return activeQueries.size() * referenceNode.NumPoints();
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void NeighborSearchRules<SortPolicy, MetricType, TreeType>::EvaluateBlock(
+    TreeType& queryNode,
+    TreeType& referenceNode,
+    std::false_type /* useBlockKernel */)
+{
+  for (size_t i = 0; i < activeQueries.size(); ++i)
+    for (size_t j = 0; j < referenceNode.NumPoints(); ++j)
+      BaseCase(queryNode.Point(activeQueries[i]), referenceNode.Point(j));
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void NeighborSearchRules<SortPolicy, MetricType, TreeType>::EvaluateBlock(
+    TreeType& queryNode,
+    TreeType& referenceNode,
+    std::true_type /* useBlockKernel */)
+{
+  // Compute all of the inner products between the two leaves at once.
+  const size_t numQueries = queryNode.NumPoints();
+  const size_t numReferences = referenceNode.NumPoints();
+  const size_t queryBegin = queryNode.Point(0);
+  const size_t queryEnd = queryBegin + numQueries - 1;
+  const size_t referenceBegin = referenceNode.Point(0);
+  const size_t referenceEnd = referenceBegin + numReferences - 1;
+  innerProducts = arma::trans(querySet.cols(queryBegin, queryEnd)) *
+      referenceSet.cols(referenceBegin, referenceEnd);
+
+  ComputeSquaredNorms();
+  InsertBlock(queryBegin, referenceBegin,
+      querySquaredNorms->subvec(queryBegin, queryEnd),
+      referenceSquaredNorms->subvec(referenceBegin, referenceEnd));
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void NeighborSearchRules<SortPolicy, MetricType, TreeType>::RangeBaseCase(
+    const size_t queryBegin,
+    const size_t queryEnd,
+    const size_t referenceBegin,
+    const size_t referenceEnd)
+{
+  EvaluateRange(queryBegin, queryEnd, referenceBegin, referenceEnd,
+      std::integral_constant<bool, UseBlockKernel>());
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void NeighborSearchRules<SortPolicy, MetricType, TreeType>::EvaluateRange(
+    const size_t queryBegin,
+    const size_t queryEnd,
+    const size_t referenceBegin,
+    const size_t referenceEnd,
+    std::false_type /* useBlockKernel */)
+{
+  for (size_t i = queryBegin; i <= queryEnd; ++i)
+    for (size_t j = referenceBegin; j <= referenceEnd; ++j)
+      BaseCase(i, j);
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void NeighborSearchRules<SortPolicy, MetricType, TreeType>::EvaluateRange(
+    const size_t queryBegin,
+    const size_t queryEnd,
+    const size_t referenceBegin,
+    const size_t referenceEnd,
+    std::true_type /* useBlockKernel */)
+{
+  ComputeSquaredNorms();
+  innerProducts = arma::trans(querySet.cols(queryBegin, queryEnd)) *
+      referenceSet.cols(referenceBegin, referenceEnd);
+
+  activeQueries.resize(queryEnd - queryBegin + 1);
+  for (size_t i = 0; i < activeQueries.size(); ++i)
+    activeQueries[i] = i;
+
+  InsertBlock(queryBegin, referenceBegin,
+      querySquaredNorms->subvec(queryBegin, queryEnd),
+      referenceSquaredNorms->subvec(referenceBegin, referenceEnd));
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void NeighborSearchRules<SortPolicy, MetricType, TreeType>::
+    ComputeSquaredNorms()
+{
+  // Unless they were given, the norms are computed the first time a block is
+  // evaluated, so searches that never reach the block kernel do not pay for
+  // them.
+  if (querySquaredNorms == NULL)
+  {
+    SquaredNorms(querySet, computedQueryNorms);
+    querySquaredNorms = &computedQueryNorms;
+  }
+  if (referenceSquaredNorms == NULL)
+  {
+    SquaredNorms(referenceSet, computedReferenceNorms);
+    referenceSquaredNorms = &computedReferenceNorms;
+  }
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+void NeighborSearchRules<SortPolicy, MetricType, TreeType>::InsertBlock(
+    const size_t queryBegin,
+    const size_t referenceBegin,
+    const arma::vec& queryNorms,
+    const arma::vec& referenceNorms)
+{
+  typedef typename TreeType::Mat::elem_type ElemType;
+  const size_t numReferences = innerProducts.n_cols;
+
+  // The expansion loses precision to cancellation, so we use a conservative
+  // bound on its error (this is proportional to the dimensionality and the
+  // norms of the points) when deciding whether a point may be a candidate.
+  const double tolerance = 8.0 * (querySet.n_rows + 2) *
+      std::numeric_limits<ElemType>::epsilon();
+
+  for (size_t i = 0; i < activeQueries.size(); ++i)
+  {
+    const size_t queryIndex = queryBegin + activeQueries[i];
+    const double queryNorm = queryNorms[activeQueries[i]];
+    for (size_t j = 0; j < numReferences; ++j)
+    {
+      const size_t referenceIndex = referenceBegin + j;
+      if (sameSet && (queryIndex == referenceIndex))
+        continue;
+
+      ++baseCases;
+
+      // Compare the approximate squared distance against the (squared) k'th
+      // best distance for this query point.
+      const double bestDistance = candidates.Worst(queryIndex);
+      const double bestSquared = (MetricType::TakeRoot) ?
+          bestDistance * bestDistance : bestDistance;
+      const double approxSquared = queryNorm + referenceNorms[j] -
+          2.0 * innerProducts(activeQueries[i], j);
+      if (approxSquared > bestSquared * (1.0 + tolerance) +
+          tolerance * (queryNorm + referenceNorms[j]))
+        continue;
+
+      // This point may be a candidate, so compute its exact distance.
+      const double distance = metric.Evaluate(querySet.col(queryIndex),
+          referenceSet.col(referenceIndex));
+
+      candidates.Insert(queryIndex, referenceIndex, distance);
+    }
+  }
+}
+
 template<typename SortPolicy, typename MetricType, typename TreeType>
 inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
     const size_t queryIndex,
@@ -111,10 +283,52 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
         &referenceNode);
   }
 
-  // Compare against the best k'th distance for this query point so far.
-  const double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  // Compare against the best k'th distance for this query point so far,
+  // relaxed for approximate search.
+  const double bestDistance = SortPolicy::Relax(
+      candidates.Worst(queryIndex), epsilon);
+
+  return CheckBudget(queryIndex,
+      (SortPolicy::IsBetter(distance, bestDistance)) ? distance : DBL_MAX);
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+inline void NeighborSearchRules<SortPolicy, MetricType, TreeType>::
+ScoreChildren(const size_t queryIndex,
+              TreeType& referenceNode,
+              double* childScores)
+{
+  // If the first point of each node is its centroid, the scores come from base
+  // cases (which may be cached in the statistics), so each child is scored on
+  // its own.
+  if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
+  {
+    for (size_t i = 0; i < referenceNode.NumChildren(); ++i)
+      childScores[i] = Score(queryIndex, referenceNode.Child(i));
+    return;
+  }
+
+  const size_t numChildren = referenceNode.NumChildren();
+  scores += numChildren; // Count each child as a call to Score().
+  for (size_t i = 0; i < numChildren; ++i)
+    childScores[i] = SortPolicy::BestPointToNodeDistance(
+        querySet.col(queryIndex), &referenceNode.Child(i));
+
+  // Compare against the best k'th distance for this query point so far,
+  // relaxed for approximate search.
+  const double bestDistance = SortPolicy::Relax(
+      candidates.Worst(queryIndex), epsilon);
+  for (size_t i = 0; i < numChildren; ++i)
+    childScores[i] = CheckBudget(queryIndex,
+        (SortPolicy::IsBetter(childScores[i], bestDistance)) ? childScores[i] :
+        DBL_MAX);
+}
 
-  return (SortPolicy::IsBetter(distance, bestDistance)) ? distance : DBL_MAX;
+template<typename SortPolicy, typename MetricType, typename TreeType>
+inline size_t NeighborSearchRules<SortPolicy, MetricType, TreeType>::
+GetBestChild(const size_t queryIndex, TreeType& referenceNode)
+{
+  return SortPolicy::GetBestChild(querySet.col(queryIndex), referenceNode);
 }
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
@@ -127,10 +341,12 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Rescore(
   if (oldScore == DBL_MAX)
     return oldScore;
 
-  // Just check the score again against the distances.
-  const double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  // Just check the score again against the (relaxed) distances.
+  const double bestDistance = SortPolicy::Relax(
+      candidates.Worst(queryIndex), epsilon);
 
-  return (SortPolicy::IsBetter(oldScore, bestDistance)) ? oldScore : DBL_MAX;
+  return CheckBudget(queryIndex,
+      (SortPolicy::IsBetter(oldScore, bestDistance)) ? oldScore : DBL_MAX);
 }
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
@@ -278,6 +494,11 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Score(
 
   if (SortPolicy::IsBetter(distance, bestDistance))
   {
+    // If the budget is spent, prune instead; the traversal information is then
+    // not needed.
+    if (CheckBudget(queryNode, distance) == DBL_MAX)
+      return DBL_MAX;
+
     // Set traversal information.
     traversalInfo.LastQueryNode() = &queryNode;
     traversalInfo.LastReferenceNode() = &referenceNode;
@@ -306,7 +527,41 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::Rescore(
   // Update our bound.
   const double bestDistance = CalculateBound(queryNode);
 
-  return (SortPolicy::IsBetter(oldScore, bestDistance)) ? oldScore : DBL_MAX;
+  return CheckBudget(queryNode,
+      (SortPolicy::IsBetter(oldScore, bestDistance)) ? oldScore : DBL_MAX);
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::
+CheckBudget(const size_t queryIndex, const double score) const
+{
+  // A query point is searched until it has k candidates, even after the budget
+  // is spent, so that it gets some results.
+  if (budget == NULL || score == DBL_MAX ||
+      candidates.Worst(queryIndex) == SortPolicy::WorstDistance() ||
+      !budget->Exhausted(baseCases))
+    return score;
+
+  budget->Truncate(queryIndex);
+  return DBL_MAX;
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::
+CheckBudget(TreeType& queryNode, const double score) const
+{
+  // The first bound of the query node (which Score() and Rescore() have just
+  // updated) is the worst k'th candidate distance of any of its descendants, so
+  // it is only the worst distance if some descendant has fewer than k
+  // candidates; then the node is searched further, even after the budget is
+  // spent.
+  if (budget == NULL || score == DBL_MAX ||
+      queryNode.Stat().FirstBound() == SortPolicy::WorstDistance() ||
+      !budget->Exhausted(baseCases))
+    return score;
+
+  budget->Truncate(queryNode);
+  return DBL_MAX;
 }
 
 // Calculate the bound for a given query node in its current state and update
@@ -340,7 +595,9 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::
   // style for cover trees.
 
   // Then, to assemble the final bound, since both bounds are valid, we simply
-  // take the better of the two.
+  // take the better of the two.  The better bound still holds every descendant
+  // query point's current k'th candidate distance, so for approximate search
+  // it can be relaxed once it has been cached.
 
   double worstDistance = SortPolicy::BestDistance();
   double bestDistance = SortPolicy::WorstDistance();
@@ -348,7 +605,7 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::
   // Loop over points held in the node.
   for (size_t i = 0; i < queryNode.NumPoints(); ++i)
   {
-    const double distance = distances(distances.n_rows - 1, queryNode.Point(i));
+    const double distance = candidates.Worst(queryNode.Point(i));
     if (SortPolicy::IsBetter(worstDistance, distance))
       worstDistance = distance;
     if (SortPolicy::IsBetter(distance, bestDistance))
@@ -402,46 +659,15 @@ inline double NeighborSearchRules<SortPolicy, MetricType, TreeType>::
   if (SortPolicy::IsBetter(queryNode.Stat().SecondBound(), bestDistance))
     bestDistance = queryNode.Stat().SecondBound();
 
-  // Cache bounds for later.
+  // Cache bounds for later.  The cached bounds are never relaxed, so that the
+  // relaxation is not compounded as the bounds are propagated through the tree.
   queryNode.Stat().FirstBound() = worstDistance;
   queryNode.Stat().SecondBound() = bestDistance;
 
   if (SortPolicy::IsBetter(worstDistance, bestDistance))
-    return worstDistance;
+    return SortPolicy::Relax(worstDistance, epsilon);
   else
-    return bestDistance;
-}
-
-/**
- * Helper function to insert a point into the neighbors and distances matrices.
- *
- * @param queryIndex Index of point whose neighbors we are inserting into.
- * @param pos Position in list to insert into.
- * @param neighbor Index of reference point which is being inserted.
- * @param distance Distance from query point to reference point.
- */
-template<typename SortPolicy, typename MetricType, typename TreeType>
-void NeighborSearchRules<SortPolicy, MetricType, TreeType>::InsertNeighbor(
-    const size_t queryIndex,
-    const size_t pos,
-    const size_t neighbor,
-    const double distance)
-{
-  // We only memmove() if there is actually a need to shift something.
-  if (pos < (distances.n_rows - 1))
-  {
-    int len = (distances.n_rows - 1) - pos;
-    memmove(distances.colptr(queryIndex) + (pos + 1),
-        distances.colptr(queryIndex) + pos,
-        sizeof(double) * len);
-    memmove(neighbors.colptr(queryIndex) + (pos + 1),
-        neighbors.colptr(queryIndex) + pos,
-        sizeof(size_t) * len);
-  }
-
-  // Now put the new information in the right index.
-  distances(pos, queryIndex) = distance;
-  neighbors(pos, queryIndex) = neighbor;
+    return SortPolicy::Relax(bestDistance, epsilon);
 }
 
 }; // namespace neighbor
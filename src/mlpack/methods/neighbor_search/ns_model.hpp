@@ -13,6 +13,9 @@
 #include <mlpack/core/tree/binary_space_tree.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
 #include <mlpack/core/tree/rectangle_tree.hpp>
+#include <mlpack/core/tree/spill_tree.hpp>
+
+#include <chrono>
 
 #include "neighbor_search.hpp"
 
@@ -47,7 +50,9 @@ class NSModel
     COVER_TREE,
     R_TREE,
     R_STAR_TREE,
-    BALL_TREE
+    BALL_TREE,
+    VP_TREE,
+    SPILL_TREE
   };
 
  private:
@@ -58,6 +63,10 @@ class NSModel
   bool randomBasis;
   arma::mat q;
 
+  // Parameters for building spill trees.
+  double tau;
+  double rho;
+
   template<template<typename TreeMetricType,
                     typename TreeStatType,
                     typename TreeMatType> class TreeType>
@@ -72,6 +81,26 @@ class NSModel
   NSType<tree::RTree>* rTreeNS;
   NSType<tree::RStarTree>* rStarTreeNS;
   NSType<tree::BallTree>* ballTreeNS;
+  NSType<tree::VPTree>* vpTreeNS;
+  NSType<tree::SpillTree>* spillTreeNS;
+
+  // Whether the query tree of dual-tree search is kept for the next search.
+  bool cacheQueryTree;
+  // The cached query tree; at most one of these pointers is non-NULL.
+  typename NSType<tree::KDTree>::Tree* kdQueryTree;
+  typename NSType<tree::BallTree>::Tree* ballQueryTree;
+  typename NSType<tree::VPTree>::Tree* vpQueryTree;
+  // The original indices of the points of the cached query tree.
+  std::vector<size_t> oldFromNewQueries;
+  // The results of the last search with the cached query tree, in the order of
+  // its points.
+  arma::Mat<size_t> cachedNeighbors;
+  arma::mat cachedDistances;
+  // The settings of the search that gave the cached results, which are only
+  // reused by a search with the same settings.
+  double cachedEpsilon;
+  size_t cachedBaseCaseBudget;
+  double cachedTimeBudget;
 
  public:
   /**
@@ -97,6 +126,27 @@ class NSModel
   bool Naive() const;
   bool& Naive();
 
+  //! Expose whether or not dual-tree search is split across threads.
+  bool Parallel() const;
+  bool& Parallel();
+
+  //! Expose the relative error tolerance for approximate search.
+  double Epsilon() const;
+  double& Epsilon();
+
+  //! Expose whether or not single-tree search expands nodes best-first.
+  bool BestFirst() const;
+  bool& BestFirst();
+
+  //! Expose whether or not single-tree search processes the query points in a
+  //! spatial order.
+  bool ReorderQueries() const;
+  bool& ReorderQueries();
+
+  //! Expose the number of nodes best-first search may expand per query point.
+  size_t MaxVisits() const;
+  size_t& MaxVisits();
+
   size_t LeafSize() const { return leafSize; }
   size_t& LeafSize() { return leafSize; }
 
@@ -106,12 +156,80 @@ class NSModel
   bool RandomBasis() const { return randomBasis; }
   bool& RandomBasis() { return randomBasis; }
 
+  /**
+   * Get the width of the overlap buffer used when a spill tree is built.  With
+   * spill trees, search is approximate: it visits only one leaf below each
+   * overlapping node (see SpillTree).  The default is 0, which gives a plain
+   * random projection tree.
+   */
+  double Tau() const { return tau; }
+  //! Modify the width of the overlap buffer used when a spill tree is built.
+  double& Tau() { return tau; }
+
+  //! Get the largest fraction of the points of a spill tree node that a child
+  //! of an overlapping node may hold.  The default is 0.7.
+  double Rho() const { return rho; }
+  //! Modify the largest fraction of the points of a spill tree node that a
+  //! child of an overlapping node may hold.
+  double& Rho() { return rho; }
+
+  /**
+   * Get whether the query tree built for dual-tree search with a kd-tree, ball
+   * tree or vantage-point tree is kept, with the results, for the next call to
+   * Search() with a query set.  If that call is given an identical query set,
+   * the tree is not rebuilt, and the earlier results are extended if k is
+   * larger or truncated if it is not (see NeighborSearch::Search()).  The
+   * earlier results are only used if Epsilon() and the base case and time
+   * budgets have not changed; otherwise only the tree is reused.  The default
+   * is false.
+   */
+  bool CacheQueryTree() const { return cacheQueryTree; }
+  //! Modify whether the query tree is kept for the next search.
+  bool& CacheQueryTree() { return cacheQueryTree; }
+
+  /**
+   * Choose the tree type and leaf size of the model for the given data, before
+   * BuildModel() is called.  Random samples of at most sampleSize points of the
+   * reference set (and of the query set, if it is given; otherwise the search
+   * is monochromatic) are taken, and a model is built and searched on them
+   * with each exact tree type (every type except spill trees) and each leaf
+   * size in { 5, 10, 20, 40, 80 }.  The configuration with the smallest time
+   * to build and search is kept in TreeType() and LeafSize(), which are
+   * saved with the model.  Since the samples are smaller than the data, this is
+   * a heuristic; the chosen leaf size should then be passed to BuildModel().
+   *
+   * @param referenceSet Set of reference points.
+   * @param querySet Set of query points, or NULL for monochromatic search.
+   * @param k Number of neighbors that will be searched for.
+   * @param singleMode Whether single-tree search will be used.
+   * @param sampleSize Maximum number of points sampled from each set.
+   */
+  void SelectTree(const arma::mat& referenceSet,
+                  const arma::mat* querySet,
+                  const size_t k,
+                  const bool singleMode,
+                  const size_t sampleSize = 1000);
+
   //! Build the reference tree.
   void BuildModel(arma::mat&& referenceSet,
                   const size_t leafSize,
                   const bool naive,
                   const bool singleMode);
 
+  /**
+   * Insert a point into the reference set without rebuilding the model.  This
+   * is only supported for R trees and R* trees; otherwise, a
+   * std::invalid_argument exception is thrown.
+   */
+  void Insert(const arma::vec& point);
+
+  /**
+   * Remove the reference point with the given index from the model without
+   * rebuilding it.  This is only supported for R trees and R* trees; otherwise,
+   * a std::invalid_argument exception is thrown.
+   */
+  void Remove(const size_t index);
+
   //! Perform neighbor search.  The query set will be reordered.
   void Search(arma::mat&& querySet,
               const size_t k,
@@ -123,7 +241,60 @@ class NSModel
               arma::Mat<size_t>& neighbors,
               arma::mat& distances);
 
+  /**
+   * Perform neighbor search on one batch of query points.  This is meant for
+   * long-lived query sessions, where the reference tree stays in memory and
+   * many small batches are searched one after another.  Unless naive search is
+   * in use, a query tree is built for the batch and dual-tree search is used if
+   * the batch holds at least dualTreeMinBatch points; smaller batches use
+   * single-tree search, since building a query tree is not worthwhile for them.
+   * The search mode of the model is restored afterwards.  The query set will
+   * be reordered.
+   *
+   * @param querySet Batch of query points.
+   * @param k Number of neighbors to find.
+   * @param neighbors Matrix to store the neighbors in.
+   * @param distances Matrix to store the distances in.
+   * @param dualTreeMinBatch Minimum batch size for dual-tree search.
+   */
+  void SearchBatch(arma::mat&& querySet,
+                   const size_t k,
+                   arma::Mat<size_t>& neighbors,
+                   arma::mat& distances,
+                   const size_t dualTreeMinBatch);
+
   std::string TreeName() const;
+
+  //! Get the number of base cases evaluated by the last search.
+  size_t BaseCases() const;
+
+  //! Estimate the memory used by the model (in bytes); see
+  //! NeighborSearch::MemoryUsage().
+  size_t MemoryUsage() const;
+
+ private:
+  /**
+   * Warn if defeatist search with a spill tree did not find k neighbors for
+   * some query points.  Each leaf of a spill tree holds at least half of the
+   * leaf size (rounded up), so this only happens if k is larger than that.
+   */
+  void CheckDefeatistResults(const arma::Mat<size_t>& neighbors) const;
+
+  /**
+   * Perform dual-tree search with a query tree built on the given query set,
+   * or with the cached query tree if its points are the same; the tree (and
+   * the results) are then cached if CacheQueryTree() is set.
+   */
+  template<typename NSTypeT>
+  void QueryTreeSearch(NSTypeT& ns,
+                       typename NSTypeT::Tree*& queryTree,
+                       arma::mat&& querySet,
+                       const size_t k,
+                       arma::Mat<size_t>& neighbors,
+                       arma::mat& distances);
+
+  //! Delete the cached query tree and results, if any.
+  void ClearQueryTree();
 };
 
 } // namespace neighbor
@@ -23,12 +23,24 @@ namespace neighbor {
 template<typename SortPolicy>
 NSModel<SortPolicy>::NSModel(int treeType, bool randomBasis) :
     treeType(treeType),
+    leafSize(20),
     randomBasis(randomBasis),
+    tau(0.0),
+    rho(0.7),
     kdTreeNS(NULL),
     coverTreeNS(NULL),
     rTreeNS(NULL),
     rStarTreeNS(NULL),
-    ballTreeNS(NULL)
+    ballTreeNS(NULL),
+    vpTreeNS(NULL),
+    spillTreeNS(NULL),
+    cacheQueryTree(false),
+    kdQueryTree(NULL),
+    ballQueryTree(NULL),
+    vpQueryTree(NULL),
+    cachedEpsilon(0.0),
+    cachedBaseCaseBudget(0),
+    cachedTimeBudget(0.0)
 {
   // Nothing to do.
 }
@@ -47,6 +59,12 @@ NSModel<SortPolicy>::~NSModel()
     delete rStarTreeNS;
   if (ballTreeNS)
     delete ballTreeNS;
+  if (vpTreeNS)
+    delete vpTreeNS;
+  if (spillTreeNS)
+    delete spillTreeNS;
+
+  ClearQueryTree();
 }
 
 //! Serialize the kNN model.
@@ -56,6 +74,7 @@ void NSModel<SortPolicy>::Serialize(Archive& ar,
                                     const unsigned int /* version */)
 {
   ar & data::CreateNVP(treeType, "treeType");
+  ar & data::CreateNVP(leafSize, "leafSize");
   ar & data::CreateNVP(randomBasis, "randomBasis");
   ar & data::CreateNVP(q, "q");
 
@@ -72,12 +91,22 @@ void NSModel<SortPolicy>::Serialize(Archive& ar,
       delete rStarTreeNS;
     if (ballTreeNS)
       delete ballTreeNS;
+    if (vpTreeNS)
+      delete vpTreeNS;
+    if (spillTreeNS)
+      delete spillTreeNS;
 
     // Set all the pointers to NULL.
     kdTreeNS = NULL;
     coverTreeNS = NULL;
     rTreeNS = NULL;
     rStarTreeNS = NULL;
+    ballTreeNS = NULL;
+    vpTreeNS = NULL;
+    spillTreeNS = NULL;
+
+    // The cached query tree was searched against the old model.
+    ClearQueryTree();
   }
 
   // We'll only need to serialize one of the kNN objects, based on the type.
@@ -99,6 +128,12 @@ void NSModel<SortPolicy>::Serialize(Archive& ar,
     case BALL_TREE:
       ar & data::CreateNVP(ballTreeNS, name);
       break;
+    case VP_TREE:
+      ar & data::CreateNVP(vpTreeNS, name);
+      break;
+    case SPILL_TREE:
+      ar & data::CreateNVP(spillTreeNS, name);
+      break;
   }
 }
 
@@ -115,6 +150,10 @@ const arma::mat& NSModel<SortPolicy>::Dataset() const
     return rStarTreeNS->ReferenceSet();
   else if (ballTreeNS)
     return ballTreeNS->ReferenceSet();
+  else if (vpTreeNS)
+    return vpTreeNS->ReferenceSet();
+  else if (spillTreeNS)
+    return spillTreeNS->ReferenceSet();
 
   throw std::runtime_error("no neighbor search model initialized");
 }
@@ -133,6 +172,10 @@ bool NSModel<SortPolicy>::SingleMode() const
     return rStarTreeNS->SingleMode();
   else if (ballTreeNS)
     return ballTreeNS->SingleMode();
+  else if (vpTreeNS)
+    return vpTreeNS->SingleMode();
+  else if (spillTreeNS)
+    return spillTreeNS->SingleMode();
 
   throw std::runtime_error("no neighbor search model initialized");
 }
@@ -150,6 +193,10 @@ bool& NSModel<SortPolicy>::SingleMode()
     return rStarTreeNS->SingleMode();
   else if (ballTreeNS)
     return ballTreeNS->SingleMode();
+  else if (vpTreeNS)
+    return vpTreeNS->SingleMode();
+  else if (spillTreeNS)
+    return spillTreeNS->SingleMode();
 
   throw std::runtime_error("no neighbor search model initialized");
 }
@@ -167,6 +214,10 @@ bool NSModel<SortPolicy>::Naive() const
     return rStarTreeNS->Naive();
   else if (ballTreeNS)
     return ballTreeNS->Naive();
+  else if (vpTreeNS)
+    return vpTreeNS->Naive();
+  else if (spillTreeNS)
+    return spillTreeNS->Naive();
 
   throw std::runtime_error("no neighbor search model initialized");
 }
@@ -184,10 +235,325 @@ bool& NSModel<SortPolicy>::Naive()
     return rStarTreeNS->Naive();
   else if (ballTreeNS)
     return ballTreeNS->Naive();
+  else if (vpTreeNS)
+    return vpTreeNS->Naive();
+  else if (spillTreeNS)
+    return spillTreeNS->Naive();
+
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+template<typename SortPolicy>
+bool NSModel<SortPolicy>::Parallel() const
+{
+  if (kdTreeNS)
+    return kdTreeNS->Parallel();
+  else if (coverTreeNS)
+    return coverTreeNS->Parallel();
+  else if (rTreeNS)
+    return rTreeNS->Parallel();
+  else if (rStarTreeNS)
+    return rStarTreeNS->Parallel();
+  else if (ballTreeNS)
+    return ballTreeNS->Parallel();
+  else if (vpTreeNS)
+    return vpTreeNS->Parallel();
+  else if (spillTreeNS)
+    return spillTreeNS->Parallel();
+
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+template<typename SortPolicy>
+bool& NSModel<SortPolicy>::Parallel()
+{
+  if (kdTreeNS)
+    return kdTreeNS->Parallel();
+  else if (coverTreeNS)
+    return coverTreeNS->Parallel();
+  else if (rTreeNS)
+    return rTreeNS->Parallel();
+  else if (rStarTreeNS)
+    return rStarTreeNS->Parallel();
+  else if (ballTreeNS)
+    return ballTreeNS->Parallel();
+  else if (vpTreeNS)
+    return vpTreeNS->Parallel();
+  else if (spillTreeNS)
+    return spillTreeNS->Parallel();
 
   throw std::runtime_error("no neighbor search model initialized");
 }
 
+template<typename SortPolicy>
+double NSModel<SortPolicy>::Epsilon() const
+{
+  if (kdTreeNS)
+    return kdTreeNS->Epsilon();
+  else if (coverTreeNS)
+    return coverTreeNS->Epsilon();
+  else if (rTreeNS)
+    return rTreeNS->Epsilon();
+  else if (rStarTreeNS)
+    return rStarTreeNS->Epsilon();
+  else if (ballTreeNS)
+    return ballTreeNS->Epsilon();
+  else if (vpTreeNS)
+    return vpTreeNS->Epsilon();
+  else if (spillTreeNS)
+    return spillTreeNS->Epsilon();
+
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+template<typename SortPolicy>
+double& NSModel<SortPolicy>::Epsilon()
+{
+  if (kdTreeNS)
+    return kdTreeNS->Epsilon();
+  else if (coverTreeNS)
+    return coverTreeNS->Epsilon();
+  else if (rTreeNS)
+    return rTreeNS->Epsilon();
+  else if (rStarTreeNS)
+    return rStarTreeNS->Epsilon();
+  else if (ballTreeNS)
+    return ballTreeNS->Epsilon();
+  else if (vpTreeNS)
+    return vpTreeNS->Epsilon();
+  else if (spillTreeNS)
+    return spillTreeNS->Epsilon();
+
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+template<typename SortPolicy>
+bool NSModel<SortPolicy>::BestFirst() const
+{
+  if (kdTreeNS)
+    return kdTreeNS->BestFirst();
+  else if (coverTreeNS)
+    return coverTreeNS->BestFirst();
+  else if (rTreeNS)
+    return rTreeNS->BestFirst();
+  else if (rStarTreeNS)
+    return rStarTreeNS->BestFirst();
+  else if (ballTreeNS)
+    return ballTreeNS->BestFirst();
+  else if (vpTreeNS)
+    return vpTreeNS->BestFirst();
+  else if (spillTreeNS)
+    return spillTreeNS->BestFirst();
+
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+template<typename SortPolicy>
+bool& NSModel<SortPolicy>::BestFirst()
+{
+  if (kdTreeNS)
+    return kdTreeNS->BestFirst();
+  else if (coverTreeNS)
+    return coverTreeNS->BestFirst();
+  else if (rTreeNS)
+    return rTreeNS->BestFirst();
+  else if (rStarTreeNS)
+    return rStarTreeNS->BestFirst();
+  else if (ballTreeNS)
+    return ballTreeNS->BestFirst();
+  else if (vpTreeNS)
+    return vpTreeNS->BestFirst();
+  else if (spillTreeNS)
+    return spillTreeNS->BestFirst();
+
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+template<typename SortPolicy>
+bool NSModel<SortPolicy>::ReorderQueries() const
+{
+  if (kdTreeNS)
+    return kdTreeNS->ReorderQueries();
+  else if (coverTreeNS)
+    return coverTreeNS->ReorderQueries();
+  else if (rTreeNS)
+    return rTreeNS->ReorderQueries();
+  else if (rStarTreeNS)
+    return rStarTreeNS->ReorderQueries();
+  else if (ballTreeNS)
+    return ballTreeNS->ReorderQueries();
+  else if (vpTreeNS)
+    return vpTreeNS->ReorderQueries();
+  else if (spillTreeNS)
+    return spillTreeNS->ReorderQueries();
+
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+template<typename SortPolicy>
+bool& NSModel<SortPolicy>::ReorderQueries()
+{
+  if (kdTreeNS)
+    return kdTreeNS->ReorderQueries();
+  else if (coverTreeNS)
+    return coverTreeNS->ReorderQueries();
+  else if (rTreeNS)
+    return rTreeNS->ReorderQueries();
+  else if (rStarTreeNS)
+    return rStarTreeNS->ReorderQueries();
+  else if (ballTreeNS)
+    return ballTreeNS->ReorderQueries();
+  else if (vpTreeNS)
+    return vpTreeNS->ReorderQueries();
+  else if (spillTreeNS)
+    return spillTreeNS->ReorderQueries();
+
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+template<typename SortPolicy>
+size_t NSModel<SortPolicy>::MaxVisits() const
+{
+  if (kdTreeNS)
+    return kdTreeNS->MaxVisits();
+  else if (coverTreeNS)
+    return coverTreeNS->MaxVisits();
+  else if (rTreeNS)
+    return rTreeNS->MaxVisits();
+  else if (rStarTreeNS)
+    return rStarTreeNS->MaxVisits();
+  else if (ballTreeNS)
+    return ballTreeNS->MaxVisits();
+  else if (vpTreeNS)
+    return vpTreeNS->MaxVisits();
+  else if (spillTreeNS)
+    return spillTreeNS->MaxVisits();
+
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+template<typename SortPolicy>
+size_t& NSModel<SortPolicy>::MaxVisits()
+{
+  if (kdTreeNS)
+    return kdTreeNS->MaxVisits();
+  else if (coverTreeNS)
+    return coverTreeNS->MaxVisits();
+  else if (rTreeNS)
+    return rTreeNS->MaxVisits();
+  else if (rStarTreeNS)
+    return rStarTreeNS->MaxVisits();
+  else if (ballTreeNS)
+    return ballTreeNS->MaxVisits();
+  else if (vpTreeNS)
+    return vpTreeNS->MaxVisits();
+  else if (spillTreeNS)
+    return spillTreeNS->MaxVisits();
+
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+//! Choose the tree type and leaf size from trial searches on samples.
+template<typename SortPolicy>
+void NSModel<SortPolicy>::SelectTree(const arma::mat& referenceSet,
+                                     const arma::mat* querySet,
+                                     const size_t k,
+                                     const bool singleMode,
+                                     const size_t sampleSize)
+{
+  const size_t numReferences = std::min(sampleSize, referenceSet.n_cols);
+  const size_t numQueries = (querySet == NULL) ? 0 :
+      std::min(sampleSize, querySet->n_cols);
+  if (k == 0 || numReferences < 2 || (querySet != NULL && numQueries == 0))
+  {
+    std::ostringstream oss;
+    oss << "NSModel::SelectTree(): cannot select a tree for k = " << k
+        << " with " << numReferences << " sampled reference points and "
+        << numQueries << " sampled query points";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // The sampled reference set may have fewer points than k.
+  const size_t trialK = std::min(k, numReferences - 1);
+
+  // Draw the samples without replacement.
+  arma::mat referenceSample(referenceSet.n_rows, numReferences);
+  std::vector<size_t> indices(referenceSet.n_cols);
+  for (size_t i = 0; i < indices.size(); ++i)
+    indices[i] = i;
+  for (size_t i = 0; i < numReferences; ++i)
+  {
+    std::swap(indices[i], indices[math::RandInt(i, (int) indices.size())]);
+    referenceSample.col(i) = referenceSet.col(indices[i]);
+  }
+
+  arma::mat querySample;
+  if (querySet != NULL)
+  {
+    querySample.set_size(querySet->n_rows, numQueries);
+    indices.resize(querySet->n_cols);
+    for (size_t i = 0; i < indices.size(); ++i)
+      indices[i] = i;
+    for (size_t i = 0; i < numQueries; ++i)
+    {
+      std::swap(indices[i], indices[math::RandInt(i, (int) indices.size())]);
+      querySample.col(i) = querySet->col(indices[i]);
+    }
+  }
+
+  // Spill trees are not tried, since search with them is approximate.
+  const int treeTypes[6] = { KD_TREE, COVER_TREE, R_TREE, R_STAR_TREE,
+      BALL_TREE, VP_TREE };
+  const size_t leafSizes[5] = { 5, 10, 20, 40, 80 };
+
+  double bestTime = DBL_MAX;
+  int bestTreeType = treeType;
+  size_t bestLeafSize = leafSize;
+  for (size_t t = 0; t < 6; ++t)
+  {
+    // Cover trees have no leaf size.
+    const size_t numLeafSizes = (treeTypes[t] == COVER_TREE) ? 1 : 5;
+    for (size_t l = 0; l < numLeafSizes; ++l)
+    {
+      const size_t trialLeafSize = (treeTypes[t] == COVER_TREE) ? leafSize :
+          leafSizes[l];
+
+      NSModel trial(treeTypes[t], randomBasis);
+      arma::mat references(referenceSample);
+      arma::mat queries(querySample);
+      arma::Mat<size_t> neighbors;
+      arma::mat distances;
+
+      const std::chrono::steady_clock::time_point start =
+          std::chrono::steady_clock::now();
+      trial.BuildModel(std::move(references), trialLeafSize, false,
+          singleMode);
+      if (querySet != NULL)
+        trial.Search(std::move(queries), trialK, neighbors, distances);
+      else
+        trial.Search(trialK, neighbors, distances);
+      const double time = std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count();
+
+      Log::Info << "Trial search with " << trial.TreeName() << " (leaf size "
+          << trialLeafSize << "): " << trial.BaseCases() << " base cases, "
+          << time << "s." << std::endl;
+
+      if (time < bestTime)
+      {
+        bestTime = time;
+        bestTreeType = treeTypes[t];
+        bestLeafSize = trialLeafSize;
+      }
+    }
+  }
+
+  treeType = bestTreeType;
+  leafSize = bestLeafSize;
+  Log::Info << "Selected " << TreeName() << " with leaf size " << leafSize
+      << "." << std::endl;
+}
+
 //! Build the reference tree.
 template<typename SortPolicy>
 void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
@@ -199,32 +565,7 @@ void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
   if (randomBasis)
   {
     Log::Info << "Creating random basis..." << std::endl;
-    while (true)
-    {
-      // [Q, R] = qr(randn(d, d));
-      // Q = Q * diag(sign(diag(R)));
-      arma::mat r;
-      if (arma::qr(q, r, arma::randn<arma::mat>(referenceSet.n_rows,
-              referenceSet.n_rows)))
-      {
-        arma::vec rDiag(r.n_rows);
-        for (size_t i = 0; i < rDiag.n_elem; ++i)
-        {
-          if (r(i, i) < 0)
-            rDiag(i) = -1;
-          else if (r(i, i) > 0)
-            rDiag(i) = 1;
-          else
-            rDiag(i) = 0;
-        }
-
-        q *= arma::diagmat(rDiag);
-
-        // Check if the determinant is positive.
-        if (arma::det(q) >= 0)
-          break;
-      }
-    }
+    math::RandomBasis(q, referenceSet.n_rows);
   }
 
   // Clean memory, if necessary.
@@ -238,10 +579,17 @@ void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
     delete rStarTreeNS;
   if (ballTreeNS)
     delete ballTreeNS;
+  if (vpTreeNS)
+    delete vpTreeNS;
+  if (spillTreeNS)
+    delete spillTreeNS;
+
+  ClearQueryTree();
+  this->leafSize = leafSize;
 
   // Do we need to modify the reference set?
   if (randomBasis)
-    referenceSet = q * referenceSet;
+    math::TransformInPlace(q, referenceSet);
 
   if (!naive)
   {
@@ -307,6 +655,47 @@ void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
         ballTreeNS->oldFromNewReferences = std::move(oldFromNewReferences);
       }
 
+      break;
+    case VP_TREE:
+      // If necessary, build the vantage-point tree.
+      if (naive)
+      {
+        vpTreeNS = new NSType<tree::VPTree>(std::move(referenceSet), naive,
+            singleMode);
+      }
+      else
+      {
+        std::vector<size_t> oldFromNewReferences;
+        typename NSType<tree::VPTree>::Tree* vpTree =
+            new typename NSType<tree::VPTree>::Tree(std::move(referenceSet),
+            oldFromNewReferences, leafSize);
+        vpTreeNS = new NSType<tree::VPTree>(vpTree, singleMode);
+
+        // Give the model ownership of the tree and the mappings.
+        vpTreeNS->treeOwner = true;
+        vpTreeNS->oldFromNewReferences = std::move(oldFromNewReferences);
+      }
+
+      break;
+    case SPILL_TREE:
+      // If necessary, build the spill tree.  It does not rearrange the
+      // dataset, so no mappings are needed.
+      if (naive)
+      {
+        spillTreeNS = new NSType<tree::SpillTree>(std::move(referenceSet),
+            naive, singleMode);
+      }
+      else
+      {
+        typename NSType<tree::SpillTree>::Tree* spillTree =
+            new typename NSType<tree::SpillTree>::Tree(std::move(referenceSet),
+            leafSize, tau, rho);
+        spillTreeNS = new NSType<tree::SpillTree>(spillTree, singleMode);
+
+        // Give the model ownership of the tree.
+        spillTreeNS->treeOwner = true;
+      }
+
       break;
   }
 
@@ -317,6 +706,45 @@ void NSModel<SortPolicy>::BuildModel(arma::mat&& referenceSet,
   }
 }
 
+//! Insert a point into the reference set.
+template<typename SortPolicy>
+void NSModel<SortPolicy>::Insert(const arma::vec& point)
+{
+  // The point must be projected just like the reference set was.
+  const arma::vec projected = (randomBasis) ? arma::vec(q * point) : point;
+
+  switch (treeType)
+  {
+    case R_TREE:
+      rTreeNS->Insert(projected);
+      break;
+    case R_STAR_TREE:
+      rStarTreeNS->Insert(projected);
+      break;
+    default:
+      throw std::invalid_argument("insertion without rebuilding is only "
+          "supported for R trees and R* trees");
+  }
+}
+
+//! Remove a point from the reference set.
+template<typename SortPolicy>
+void NSModel<SortPolicy>::Remove(const size_t index)
+{
+  switch (treeType)
+  {
+    case R_TREE:
+      rTreeNS->Remove(index);
+      break;
+    case R_STAR_TREE:
+      rStarTreeNS->Remove(index);
+      break;
+    default:
+      throw std::invalid_argument("removal without rebuilding is only "
+          "supported for R trees and R* trees");
+  }
+}
+
 //! Perform neighbor search.  The query set will be reordered.
 template<typename SortPolicy>
 void NSModel<SortPolicy>::Search(arma::mat&& querySet,
@@ -326,7 +754,7 @@ void NSModel<SortPolicy>::Search(arma::mat&& querySet,
 {
   // We may need to map the query set randomly.
   if (randomBasis)
-    querySet = q * querySet;
+    math::TransformInPlace(q, querySet);
 
   Log::Info << "Searching for " << k << " nearest neighbors with ";
   if (!Naive() && !SingleMode())
@@ -341,27 +769,9 @@ void NSModel<SortPolicy>::Search(arma::mat&& querySet,
     case KD_TREE:
       if (!kdTreeNS->Naive() && !kdTreeNS->SingleMode())
       {
-        // Build a second tree and search.
-        Timer::Start("tree_building");
-        Log::Info << "Building query tree..." << std::endl;
-        std::vector<size_t> oldFromNewQueries;
-        typename NSType<tree::KDTree>::Tree queryTree(std::move(querySet),
-            oldFromNewQueries, leafSize);
-        Log::Info << "Tree built." << std::endl;
-        Timer::Stop("tree_building");
-
-        arma::Mat<size_t> neighborsOut;
-        arma::mat distancesOut;
-        kdTreeNS->Search(&queryTree, k, neighborsOut, distancesOut);
-
-        // Unmap the query points.
-        distances.set_size(distancesOut.n_rows, distancesOut.n_cols);
-        neighbors.set_size(neighborsOut.n_rows, neighborsOut.n_cols);
-        for (size_t i = 0; i < neighborsOut.n_cols; ++i)
-        {
-          neighbors.col(oldFromNewQueries[i]) = neighborsOut.col(i);
-          distances.col(oldFromNewQueries[i]) = distancesOut.col(i);
-        }
+        // Build a second tree (or reuse the cached one) and search.
+        QueryTreeSearch(*kdTreeNS, kdQueryTree, std::move(querySet), k,
+            neighbors, distances);
       }
       else
       {
@@ -384,27 +794,9 @@ void NSModel<SortPolicy>::Search(arma::mat&& querySet,
     case BALL_TREE:
       if (!ballTreeNS->Naive() && !ballTreeNS->SingleMode())
       {
-        // Build a second tree and search.
-        Timer::Start("tree_building");
-        Log::Info << "Building query tree..." << std::endl;
-        std::vector<size_t> oldFromNewQueries;
-        typename NSType<tree::BallTree>::Tree queryTree(std::move(querySet),
-            oldFromNewQueries, leafSize);
-        Log::Info << "Tree built." << std::endl;
-        Timer::Stop("tree_building");
-
-        arma::Mat<size_t> neighborsOut;
-        arma::mat distancesOut;
-        ballTreeNS->Search(&queryTree, k, neighborsOut, distancesOut);
-
-        // Unmap the query points.
-        distances.set_size(distancesOut.n_rows, distancesOut.n_cols);
-        neighbors.set_size(neighborsOut.n_rows, neighborsOut.n_cols);
-        for (size_t i = 0; i < neighborsOut.n_cols; ++i)
-        {
-          neighbors.col(oldFromNewQueries[i]) = neighborsOut.col(i);
-          distances.col(oldFromNewQueries[i]) = distancesOut.col(i);
-        }
+        // Build a second tree (or reuse the cached one) and search.
+        QueryTreeSearch(*ballTreeNS, ballQueryTree, std::move(querySet), k,
+            neighbors, distances);
       }
       else
       {
@@ -413,6 +805,28 @@ void NSModel<SortPolicy>::Search(arma::mat&& querySet,
       }
 
       break;
+    case VP_TREE:
+      if (!vpTreeNS->Naive() && !vpTreeNS->SingleMode())
+      {
+        // Build a second tree (or reuse the cached one) and search.
+        QueryTreeSearch(*vpTreeNS, vpQueryTree, std::move(querySet), k,
+            neighbors, distances);
+      }
+      else
+      {
+        // Search without building a second tree.
+        vpTreeNS->Search(querySet, k, neighbors, distances);
+      }
+
+      break;
+    case SPILL_TREE:
+      // No mapping necessary.
+      spillTreeNS->Search(querySet, k, neighbors, distances);
+
+      // Defeatist search may not find k neighbors if k is larger than a leaf.
+      if (!spillTreeNS->Naive())
+        CheckDefeatistResults(neighbors);
+      break;
   }
 }
 
@@ -447,9 +861,166 @@ void NSModel<SortPolicy>::Search(const size_t k,
     case BALL_TREE:
       ballTreeNS->Search(k, neighbors, distances);
       break;
+    case VP_TREE:
+      vpTreeNS->Search(k, neighbors, distances);
+      break;
+    case SPILL_TREE:
+      spillTreeNS->Search(k, neighbors, distances);
+      if (!spillTreeNS->Naive())
+        CheckDefeatistResults(neighbors);
+      break;
   }
 }
 
+//! Perform neighbor search on one batch of a long-lived query session.
+template<typename SortPolicy>
+void NSModel<SortPolicy>::SearchBatch(arma::mat&& querySet,
+                                      const size_t k,
+                                      arma::Mat<size_t>& neighbors,
+                                      arma::mat& distances,
+                                      const size_t dualTreeMinBatch)
+{
+  // Small batches are not worth building a query tree for.
+  const bool oldSingleMode = SingleMode();
+  SingleMode() = oldSingleMode || (querySet.n_cols < dualTreeMinBatch);
+
+  // The old mode is restored even if the search throws, so that a failed batch
+  // does not change how later batches are searched.
+  try
+  {
+    Search(std::move(querySet), k, neighbors, distances);
+  }
+  catch (...)
+  {
+    SingleMode() = oldSingleMode;
+    throw;
+  }
+
+  SingleMode() = oldSingleMode;
+}
+
+//! Perform dual-tree search with a new or cached query tree.
+template<typename SortPolicy>
+template<typename NSTypeT>
+void NSModel<SortPolicy>::QueryTreeSearch(NSTypeT& ns,
+                                          typename NSTypeT::Tree*& queryTree,
+                                          arma::mat&& querySet,
+                                          const size_t k,
+                                          arma::Mat<size_t>& neighbors,
+                                          arma::mat& distances)
+{
+  // The cached tree can be used if it holds the same points.
+  bool sameQuerySet = (cacheQueryTree && queryTree != NULL &&
+      queryTree->Dataset().n_rows == querySet.n_rows &&
+      queryTree->Dataset().n_cols == querySet.n_cols);
+  for (size_t i = 0; sameQuerySet && i < querySet.n_cols; ++i)
+  {
+    const double* point = queryTree->Dataset().colptr(i);
+    const double* queryPoint = querySet.colptr(oldFromNewQueries[i]);
+    for (size_t d = 0; d < querySet.n_rows; ++d)
+    {
+      if (point[d] != queryPoint[d])
+      {
+        sameQuerySet = false;
+        break;
+      }
+    }
+  }
+
+  // The cached results came from a search with the cached settings; with any
+  // other settings they are not valid, so only the tree can be reused.
+  const bool sameSettings = (ns.Epsilon() == cachedEpsilon &&
+      ns.BaseCaseBudget() == cachedBaseCaseBudget &&
+      ns.TimeBudget() == cachedTimeBudget);
+
+  arma::Mat<size_t> neighborsOut;
+  arma::mat distancesOut;
+  if (sameQuerySet && sameSettings)
+  {
+    Log::Info << "Reusing cached query tree." << std::endl;
+    neighborsOut = cachedNeighbors;
+    distancesOut = cachedDistances;
+    ns.Search(queryTree, k, neighborsOut, distancesOut, true);
+  }
+  else if (sameQuerySet)
+  {
+    Log::Info << "Reusing cached query tree; the search settings changed, so "
+        << "the cached results are discarded." << std::endl;
+    cachedNeighbors.reset();
+    cachedDistances.reset();
+    ns.Search(queryTree, k, neighborsOut, distancesOut);
+  }
+  else
+  {
+    ClearQueryTree();
+
+    Timer::Start("tree_building");
+    Log::Info << "Building query tree..." << std::endl;
+    queryTree = new typename NSTypeT::Tree(std::move(querySet),
+        oldFromNewQueries, leafSize);
+    Log::Info << "Tree built." << std::endl;
+    Timer::Stop("tree_building");
+
+    ns.Search(queryTree, k, neighborsOut, distancesOut);
+  }
+
+  // Unmap the query points.
+  distances.set_size(distancesOut.n_rows, distancesOut.n_cols);
+  neighbors.set_size(neighborsOut.n_rows, neighborsOut.n_cols);
+  for (size_t i = 0; i < neighborsOut.n_cols; ++i)
+  {
+    neighbors.col(oldFromNewQueries[i]) = neighborsOut.col(i);
+    distances.col(oldFromNewQueries[i]) = distancesOut.col(i);
+  }
+
+  if (!cacheQueryTree)
+  {
+    ClearQueryTree();
+  }
+  else if (neighborsOut.n_rows > cachedNeighbors.n_rows)
+  {
+    // Keep the longest lists, from which any smaller k can be answered.
+    cachedNeighbors = std::move(neighborsOut);
+    cachedDistances = std::move(distancesOut);
+    cachedEpsilon = ns.Epsilon();
+    cachedBaseCaseBudget = ns.BaseCaseBudget();
+    cachedTimeBudget = ns.TimeBudget();
+  }
+}
+
+//! Delete the cached query tree and results.
+template<typename SortPolicy>
+void NSModel<SortPolicy>::ClearQueryTree()
+{
+  delete kdQueryTree;
+  delete ballQueryTree;
+  delete vpQueryTree;
+  kdQueryTree = NULL;
+  ballQueryTree = NULL;
+  vpQueryTree = NULL;
+
+  oldFromNewQueries.clear();
+  cachedNeighbors.reset();
+  cachedDistances.reset();
+}
+
+//! Warn if defeatist search did not find every neighbor.
+template<typename SortPolicy>
+void NSModel<SortPolicy>::CheckDefeatistResults(
+    const arma::Mat<size_t>& neighbors) const
+{
+  size_t missing = 0;
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+    if (neighbors(neighbors.n_rows - 1, i) == size_t() - 1)
+      ++missing;
+
+  if (missing > 0)
+    Log::Warn << "Defeatist spill tree search found fewer than " <<
+        neighbors.n_rows << " neighbors for " << missing << " of " <<
+        neighbors.n_cols << " query points (the missing neighbors have index "
+        << "SIZE_MAX); use a leaf size of at least twice k." << std::endl;
+}
+
 //! Get the name of the tree type.
 template<typename SortPolicy>
 std::string NSModel<SortPolicy>::TreeName() const
@@ -466,11 +1037,59 @@ std::string NSModel<SortPolicy>::TreeName() const
       return "R* tree";
     case BALL_TREE:
       return "ball tree";
+    case VP_TREE:
+      return "vantage-point tree";
+    case SPILL_TREE:
+      return "spill tree";
     default:
       return "unknown tree";
   }
 }
 
+//! Get the number of base cases evaluated by the last search.
+template<typename SortPolicy>
+size_t NSModel<SortPolicy>::BaseCases() const
+{
+  if (kdTreeNS)
+    return kdTreeNS->BaseCases();
+  else if (coverTreeNS)
+    return coverTreeNS->BaseCases();
+  else if (rTreeNS)
+    return rTreeNS->BaseCases();
+  else if (rStarTreeNS)
+    return rStarTreeNS->BaseCases();
+  else if (ballTreeNS)
+    return ballTreeNS->BaseCases();
+  else if (vpTreeNS)
+    return vpTreeNS->BaseCases();
+  else if (spillTreeNS)
+    return spillTreeNS->BaseCases();
+
+  throw std::runtime_error("no neighbor search model initialized");
+}
+
+//! Estimate the memory used by the model.
+template<typename SortPolicy>
+size_t NSModel<SortPolicy>::MemoryUsage() const
+{
+  if (kdTreeNS)
+    return sizeof(*this) + kdTreeNS->MemoryUsage();
+  else if (coverTreeNS)
+    return sizeof(*this) + coverTreeNS->MemoryUsage();
+  else if (rTreeNS)
+    return sizeof(*this) + rTreeNS->MemoryUsage();
+  else if (rStarTreeNS)
+    return sizeof(*this) + rStarTreeNS->MemoryUsage();
+  else if (ballTreeNS)
+    return sizeof(*this) + ballTreeNS->MemoryUsage();
+  else if (vpTreeNS)
+    return sizeof(*this) + vpTreeNS->MemoryUsage();
+  else if (spillTreeNS)
+    return sizeof(*this) + spillTreeNS->MemoryUsage();
+
+  return sizeof(*this);
+}
+
 } // namespace neighbor
 } // namespace mlpack
 
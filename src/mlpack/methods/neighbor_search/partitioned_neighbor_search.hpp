@@ -0,0 +1,212 @@
+/**
+ * @file partitioned_neighbor_search.hpp
+ * @author Ryan Curtin
+ *
+ * Neighbor search over a reference set that is split spatially into
+ * partitions, each with its own tree; only the partitions that could hold a
+ * better candidate are searched for each query point.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_PARTITIONED_NEIGHBOR_SEARCH_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_PARTITIONED_NEIGHBOR_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/parallel.hpp>
+#include "neighbor_search.hpp"
+#include "candidate_list.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * Neighbor search over a reference set that is split into partitions with the
+ * top levels of a kd-tree, so that each partition covers a compact region of
+ * space.  Each partition is searched with its own NeighborSearch object (with
+ * the Euclidean distance and a kd-tree).  A query point is first searched in
+ * the partition whose bound is best for it, which gives a bound on its k'th
+ * best candidate; it is then searched only in the other partitions whose
+ * bounds could hold a better candidate than that, and the candidates of every
+ * partition are merged.  The results are the same as those of NeighborSearch
+ * on the whole reference set (up to ties).
+ *
+ * The partitioning and routing are given as static functions too, so that the
+ * partitions can be held by different processes; the allknn_mpi program does
+ * this with MPI, one partition per rank.
+ *
+ * On a machine with several NUMA nodes (sockets), the partitions can instead
+ * be spread across the nodes of one process: in parallel mode, each partition
+ * is copied and its tree built by its own thread, with the threads spread
+ * across the places of OMP_PLACES (see parallel::Spread()), so that the memory
+ * of each partition is allocated on the node of its thread.  Each partition is
+ * then searched by the same thread, along with the other threads of its place
+ * (with the parallel search of NeighborSearch), so the base cases read only
+ * local memory.  For one partition per socket, run with OMP_PLACES=sockets and
+ * OMP_PROC_BIND=spread,close, and give the number of sockets as the number of
+ * partitions.
+ *
+ * @tparam SortPolicy The sort policy for distances; see NearestNeighborSort.
+ */
+template<typename SortPolicy = NearestNeighborSort>
+class PartitionedNeighborSearch
+{
+ public:
+  //! The search used for each partition.
+  typedef NeighborSearch<SortPolicy> LocalSearchType;
+  //! The bound of each partition.
+  typedef bound::HRectBound<metric::EuclideanDistance> BoundType;
+
+  /**
+   * Split the given reference set into (at most) the given number of
+   * partitions, and build a tree on each of them.  Fewer partitions are made
+   * only if the kd-tree that splits the reference set has fewer leaves.
+   *
+   * @param referenceSet Set of reference points.
+   * @param partitions Number of partitions to split the reference set into.
+   * @param parallel If true, the partitions are built and searched by threads
+   *     spread across the places of the machine (see above).
+   */
+  PartitionedNeighborSearch(const arma::mat& referenceSet,
+                            const size_t partitions,
+                            const bool parallel = false);
+
+  //! Free the search of each partition.
+  ~PartitionedNeighborSearch();
+
+  /**
+   * For each point in the query set, find the k best neighbors in the
+   * reference set, and store them in the given matrices (k rows, one column
+   * per query point).  The indices in neighbors refer to the reference set
+   * given to the constructor.
+   *
+   * @param querySet Set of query points.
+   * @param k Number of neighbors to search for.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *     point.
+   */
+  void Search(const arma::mat& querySet,
+              const size_t k,
+              arma::Mat<size_t>& neighbors,
+              arma::mat& distances);
+
+  /**
+   * Split the given reference set into (at most) the given number of
+   * partitions: a kd-tree is built on the reference set, and, starting from
+   * its root, the node with the most points is replaced by its children until
+   * there are enough nodes.  The indices of the points of each node are stored
+   * in indices.
+   *
+   * @param referenceSet Set of reference points.
+   * @param partitions Number of partitions to split the reference set into.
+   * @param indices Vector to store the indices of each partition in.
+   */
+  static void Partition(const arma::mat& referenceSet,
+                        const size_t partitions,
+                        std::vector<arma::Col<size_t> >& indices);
+
+  /**
+   * Get the best possible distance (according to SortPolicy) from the given
+   * query point to any point in the given bound.
+   */
+  template<typename VecType>
+  static double BestDistance(const VecType& query, const BoundType& bound);
+
+  /**
+   * Get the index of the partition whose bound is best for the given query
+   * point; this is the partition that it is searched in first.
+   */
+  template<typename VecType>
+  static size_t BestPartition(const VecType& query,
+                              const std::vector<BoundType>& bounds);
+
+  //! Get the number of partitions.
+  size_t Partitions() const { return searches.size(); }
+  //! Get the bound of the given partition.
+  const BoundType& Bound(const size_t i) const { return bounds[i]; }
+  //! Get the indices of the reference points of the given partition.
+  const arma::Col<size_t>& Indices(const size_t i) const { return indices[i]; }
+
+  /**
+   * Get the number of times that a query point was searched in a partition
+   * during the last call to Search(); this is between the number of query
+   * points and that number times the number of partitions.
+   */
+  size_t RoutedQueries() const { return routedQueries; }
+
+  //! Get whether the partitions are searched in parallel.
+  bool Parallel() const { return parallel; }
+  //! Modify whether the partitions are searched in parallel, each by the
+  //! threads of its own place.  The memory of the partitions is only spread
+  //! across places if this was also set when they were built.
+  bool& Parallel() { return parallel; }
+
+ private:
+  //! The search of each partition.
+  std::vector<LocalSearchType*> searches;
+  //! The bound of each partition.
+  std::vector<BoundType> bounds;
+  //! The indices of the reference points of each partition.
+  std::vector<arma::Col<size_t> > indices;
+  //! The number of reference points.
+  size_t referencePoints;
+  //! The number of query points searched in a partition in the last search.
+  size_t routedQueries;
+  //! If true, the partitions are searched in parallel.
+  bool parallel;
+
+  //! Copy the points of the given partition and build its search.
+  void BuildPartition(const arma::mat& referenceSet, const size_t partition);
+
+  /**
+   * Search each partition for the query points routed to it (in parallel, if
+   * parallel mode is on), and merge the candidates into the given candidate
+   * list.
+   */
+  void SearchPartitions(const arma::mat& querySet,
+                        const std::vector<std::vector<size_t> >& routes,
+                        const size_t k,
+                        CandidateList<SortPolicy>& candidates);
+
+  /**
+   * Search the given partition for the given query points, and store the
+   * neighbors (as indices of the whole reference set) and the distances.
+   */
+  void SearchPartition(const size_t partition,
+                       const arma::mat& querySet,
+                       const std::vector<size_t>& queries,
+                       const size_t k,
+                       arma::Mat<size_t>& neighbors,
+                       arma::mat& distances);
+
+  /**
+   * The node type given to SortPolicy::BestPointToNodeDistance(): it only
+   * needs the distances from a point to the bound.
+   */
+  class BoundNode
+  {
+   public:
+    BoundNode(const BoundType& bound) : bound(bound) { }
+
+    template<typename VecType>
+    double MinDistance(const VecType& point) const
+    { return bound.MinDistance(point); }
+
+    template<typename VecType>
+    double MaxDistance(const VecType& point) const
+    { return bound.MaxDistance(point); }
+
+   private:
+    const BoundType& bound;
+  };
+
+  // Copying would share the searches of the partitions.
+  PartitionedNeighborSearch(const PartitionedNeighborSearch& other);
+  PartitionedNeighborSearch& operator=(const PartitionedNeighborSearch& other);
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+// Include implementation.
+#include "partitioned_neighbor_search_impl.hpp"
+
+#endif
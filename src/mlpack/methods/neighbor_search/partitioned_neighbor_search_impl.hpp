@@ -0,0 +1,285 @@
+/**
+ * @file partitioned_neighbor_search_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of PartitionedNeighborSearch.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_PARTITIONED_NEIGHBOR_SEARCH_IMPL_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_PARTITIONED_NEIGHBOR_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "partitioned_neighbor_search.hpp"
+
+namespace mlpack {
+namespace neighbor {
+
+template<typename SortPolicy>
+PartitionedNeighborSearch<SortPolicy>::PartitionedNeighborSearch(
+    const arma::mat& referenceSet,
+    const size_t partitions,
+    const bool parallel) :
+    referencePoints(referenceSet.n_cols),
+    routedQueries(0),
+    parallel(parallel)
+{
+  Partition(referenceSet, partitions, indices);
+
+  searches.resize(indices.size(), NULL);
+  bounds.resize(indices.size(), BoundType(referenceSet.n_rows));
+
+  // In parallel mode, the points and tree of each partition are first touched
+  // (and so allocated) by the thread that will search them.
+  if (parallel)
+  {
+    parallel::Spread(indices.size(), [&](const size_t p)
+    {
+      BuildPartition(referenceSet, p);
+    });
+  }
+  else
+  {
+    for (size_t p = 0; p < indices.size(); ++p)
+      BuildPartition(referenceSet, p);
+  }
+}
+
+template<typename SortPolicy>
+PartitionedNeighborSearch<SortPolicy>::~PartitionedNeighborSearch()
+{
+  for (size_t p = 0; p < searches.size(); ++p)
+    delete searches[p];
+}
+
+template<typename SortPolicy>
+void PartitionedNeighborSearch<SortPolicy>::Search(
+    const arma::mat& querySet,
+    const size_t k,
+    arma::Mat<size_t>& neighbors,
+    arma::mat& distances)
+{
+  if (k > referencePoints)
+  {
+    std::stringstream ss;
+    ss << "requested value of k (" << k << ") is greater than the number of "
+        << "points in the reference set (" << referencePoints << ")";
+    throw std::invalid_argument(ss.str());
+  }
+
+  neighbors.set_size(k, querySet.n_cols);
+  neighbors.fill(size_t() - 1);
+  distances.set_size(k, querySet.n_cols);
+  distances.fill(SortPolicy::WorstDistance());
+  CandidateList<SortPolicy> candidates(neighbors, distances);
+  routedQueries = 0;
+
+  // First search each query point in the partition whose bound is best for
+  // it; these candidates bound the k'th best distance of the query point.
+  std::vector<size_t> first(querySet.n_cols);
+  std::vector<std::vector<size_t> > routes(searches.size());
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+  {
+    const arma::vec query(const_cast<double*>(querySet.colptr(i)),
+        querySet.n_rows, false, true);
+    first[i] = BestPartition(query, bounds);
+    routes[first[i]].push_back(i);
+  }
+
+  SearchPartitions(querySet, routes, k, candidates);
+
+  // Then search each other partition only for the query points that it could
+  // hold a better candidate than the current k'th best one for.
+  for (size_t p = 0; p < searches.size(); ++p)
+  {
+    routes[p].clear();
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+    {
+      if (first[i] == p)
+        continue;
+
+      const arma::vec query(const_cast<double*>(querySet.colptr(i)),
+          querySet.n_rows, false, true);
+      if (SortPolicy::IsBetter(BestDistance(query, bounds[p]),
+          candidates.Worst(i)))
+        routes[p].push_back(i);
+    }
+  }
+
+  SearchPartitions(querySet, routes, k, candidates);
+
+  CandidateList<SortPolicy>::Sort(neighbors, distances);
+
+  Log::Info << routedQueries << " searches of a query point in a partition ("
+      << searches.size() << " partitions, " << querySet.n_cols
+      << " query points)." << std::endl;
+}
+
+template<typename SortPolicy>
+void PartitionedNeighborSearch<SortPolicy>::Partition(
+    const arma::mat& referenceSet,
+    const size_t partitions,
+    std::vector<arma::Col<size_t> >& indices)
+{
+  if (partitions == 0)
+    throw std::invalid_argument("PartitionedNeighborSearch::Partition(): "
+        "number of partitions must be positive");
+
+  if (referenceSet.n_cols == 0)
+    throw std::invalid_argument("PartitionedNeighborSearch::Partition(): "
+        "cannot partition an empty reference set");
+
+  // Only the top levels of the tree are used, so its leaves can be large.
+  typedef tree::KDTree<metric::EuclideanDistance, tree::EmptyStatistic,
+      arma::mat> TreeType;
+  std::vector<size_t> oldFromNew;
+  const size_t leafSize = std::max((size_t) 1,
+      (size_t) referenceSet.n_cols / (4 * partitions));
+  TreeType tree(referenceSet, oldFromNew, leafSize);
+
+  std::vector<const TreeType*> nodes(1, &tree);
+  while (nodes.size() < partitions)
+  {
+    // Split the node with the most points, unless every node is a leaf.
+    size_t largest = nodes.size();
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+      if (!nodes[i]->IsLeaf() && (largest == nodes.size() ||
+          nodes[i]->Count() > nodes[largest]->Count()))
+        largest = i;
+    }
+
+    if (largest == nodes.size())
+      break;
+
+    const TreeType* node = nodes[largest];
+    nodes[largest] = node->Left();
+    nodes.push_back(node->Right());
+  }
+
+  indices.resize(nodes.size());
+  for (size_t p = 0; p < nodes.size(); ++p)
+  {
+    indices[p].set_size(nodes[p]->Count());
+    for (size_t i = 0; i < nodes[p]->Count(); ++i)
+      indices[p][i] = oldFromNew[nodes[p]->Begin() + i];
+  }
+}
+
+template<typename SortPolicy>
+template<typename VecType>
+double PartitionedNeighborSearch<SortPolicy>::BestDistance(
+    const VecType& query,
+    const BoundType& bound)
+{
+  const BoundNode node(bound);
+  return SortPolicy::BestPointToNodeDistance(query, &node);
+}
+
+template<typename SortPolicy>
+template<typename VecType>
+size_t PartitionedNeighborSearch<SortPolicy>::BestPartition(
+    const VecType& query,
+    const std::vector<BoundType>& bounds)
+{
+  size_t best = 0;
+  double bestDistance = SortPolicy::WorstDistance();
+  for (size_t p = 0; p < bounds.size(); ++p)
+  {
+    const double distance = BestDistance(query, bounds[p]);
+    if (p == 0 || SortPolicy::IsBetter(distance, bestDistance))
+    {
+      best = p;
+      bestDistance = distance;
+    }
+  }
+
+  return best;
+}
+
+template<typename SortPolicy>
+void PartitionedNeighborSearch<SortPolicy>::BuildPartition(
+    const arma::mat& referenceSet,
+    const size_t partition)
+{
+  arma::uvec columns(indices[partition].n_elem);
+  for (size_t i = 0; i < indices[partition].n_elem; ++i)
+    columns[i] = (arma::uword) indices[partition][i];
+
+  arma::mat points = referenceSet.cols(columns);
+  bounds[partition] |= points;
+  searches[partition] = new LocalSearchType(std::move(points));
+}
+
+template<typename SortPolicy>
+void PartitionedNeighborSearch<SortPolicy>::SearchPartitions(
+    const arma::mat& querySet,
+    const std::vector<std::vector<size_t> >& routes,
+    const size_t k,
+    CandidateList<SortPolicy>& candidates)
+{
+  std::vector<arma::Mat<size_t> > localNeighbors(searches.size());
+  std::vector<arma::mat> localDistances(searches.size());
+  if (parallel)
+  {
+    // Partition p is searched by the thread that built it, with the threads of
+    // its place.
+    parallel::Spread(searches.size(), [&](const size_t p)
+    {
+      searches[p]->Parallel() = true;
+      SearchPartition(p, querySet, routes[p], k, localNeighbors[p],
+          localDistances[p]);
+    });
+  }
+  else
+  {
+    for (size_t p = 0; p < searches.size(); ++p)
+    {
+      searches[p]->Parallel() = false;
+      SearchPartition(p, querySet, routes[p], k, localNeighbors[p],
+          localDistances[p]);
+    }
+  }
+
+  // The candidates of a query point may come from several partitions, so they
+  // are merged once every partition has been searched.
+  for (size_t p = 0; p < searches.size(); ++p)
+  {
+    for (size_t i = 0; i < routes[p].size(); ++i)
+      for (size_t j = 0; j < localNeighbors[p].n_rows; ++j)
+        candidates.Insert(routes[p][i], localNeighbors[p](j, i),
+            localDistances[p](j, i));
+
+    routedQueries += routes[p].size();
+  }
+}
+
+template<typename SortPolicy>
+void PartitionedNeighborSearch<SortPolicy>::SearchPartition(
+    const size_t partition,
+    const arma::mat& querySet,
+    const std::vector<size_t>& queries,
+    const size_t k,
+    arma::Mat<size_t>& neighbors,
+    arma::mat& distances)
+{
+  if (queries.empty())
+    return;
+
+  arma::uvec columns(queries.size());
+  for (size_t i = 0; i < queries.size(); ++i)
+    columns[i] = (arma::uword) queries[i];
+
+  // A partition may have fewer than k points.
+  const arma::Col<size_t>& partitionIndices = indices[partition];
+  const size_t localK = std::min(k, (size_t) partitionIndices.n_elem);
+  const arma::mat routedSet = querySet.cols(columns);
+  searches[partition]->Search(routedSet, localK, neighbors, distances);
+
+  // Map the neighbors to indices of the whole reference set.
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+    neighbors[i] = partitionIndices[neighbors[i]];
+}
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
@@ -0,0 +1,106 @@
+/**
+ * @file search_budget.hpp
+ * @author Ryan Curtin
+ *
+ * A budget on the work done by a tree-based neighbor search, and a record of
+ * which query points it cut short.
+ */
+#ifndef __MLPACK_METHODS_NEIGHBOR_SEARCH_SEARCH_BUDGET_HPP
+#define __MLPACK_METHODS_NEIGHBOR_SEARCH_SEARCH_BUDGET_HPP
+
+#include <mlpack/core.hpp>
+#include <chrono>
+
+namespace mlpack {
+namespace neighbor {
+
+/**
+ * A budget for a tree traversal, given as a maximum number of base cases
+ * and/or a maximum time.  The rules of a traversal check the budget whenever
+ * they would recurse into a node; once the budget is spent, every remaining
+ * node is pruned (except while a query point still has fewer than k
+ * candidates), so the traversal finishes quickly and each query point keeps
+ * the best candidates found so far.  The query points that had a node pruned
+ * this way are marked as truncated: their results may not be the ones the
+ * search would otherwise have given.
+ *
+ * The clock starts when the budget is constructed.  The budget is not
+ * thread-safe, so it can only be used by one traversal at a time.
+ */
+class SearchBudget
+{
+ public:
+  /**
+   * Create the budget and start its clock.  A limit of 0 means there is no
+   * limit of that kind.
+   *
+   * @param maxBaseCases Maximum number of base cases.
+   * @param maxTime Maximum time, in seconds.
+   * @param numQueries Number of query points in the search.
+   */
+  SearchBudget(const size_t maxBaseCases,
+               const double maxTime,
+               const size_t numQueries) :
+      maxBaseCases(maxBaseCases),
+      maxTime(maxTime),
+      start(std::chrono::steady_clock::now()),
+      checks(0),
+      exhausted(false),
+      truncated(numQueries, false) { /* Nothing to do. */ }
+
+  /**
+   * Return whether the budget is spent, given the number of base cases the
+   * traversal has performed so far.  Reading the clock is not free, so the time
+   * is only checked on every 64th call.
+   *
+   * @param baseCases Number of base cases performed so far.
+   */
+  bool Exhausted(const size_t baseCases)
+  {
+    if (exhausted)
+      return true;
+
+    if (maxBaseCases > 0 && baseCases >= maxBaseCases)
+      exhausted = true;
+    else if (maxTime > 0.0 && (checks++ % 64) == 0)
+      exhausted = (std::chrono::duration<double>(
+          std::chrono::steady_clock::now() - start).count() >= maxTime);
+
+    return exhausted;
+  }
+
+  //! Mark the given query point as truncated.
+  void Truncate(const size_t queryIndex) { truncated[queryIndex] = true; }
+
+  //! Mark every descendant point of the given query node as truncated.
+  template<typename TreeType>
+  void Truncate(const TreeType& queryNode)
+  {
+    for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
+      truncated[queryNode.Descendant(i)] = true;
+  }
+
+  //! Get whether or not each query point was truncated.
+  const std::vector<bool>& Truncated() const { return truncated; }
+  //! Modify whether or not each query point was truncated.
+  std::vector<bool>& Truncated() { return truncated; }
+
+ private:
+  //! The maximum number of base cases (0 for no limit).
+  size_t maxBaseCases;
+  //! The maximum time in seconds (0 for no limit).
+  double maxTime;
+  //! The time the budget was created.
+  std::chrono::steady_clock::time_point start;
+  //! The number of times the time limit has been considered.
+  size_t checks;
+  //! Whether the budget has been spent.
+  bool exhausted;
+  //! Whether each query point was truncated.
+  std::vector<bool> truncated;
+};
+
+}; // namespace neighbor
+}; // namespace mlpack
+
+#endif
@@ -112,6 +112,14 @@ class FurthestNeighborSort
                                         const TreeType* referenceNode,
                                         const double pointToCenterDistance);
 
+  /**
+   * Return the index of the child of the given node that is most likely to hold
+   * the furthest neighbors of the given point; this is used by defeatist
+   * traversals.  TreeType::GetFurthestChild() must be implemented to use this.
+   */
+  template<typename VecType, typename TreeType>
+  static size_t GetBestChild(const VecType& queryPoint, TreeType& node);
+
   /**
    * Return what should represent the worst possible distance with this
    * particular sort policy.  In our case, this should be the minimum possible
@@ -145,6 +153,23 @@ class FurthestNeighborSort
    */
   static inline double CombineWorst(const double a, const double b)
   { return std::max(a - b, 0.0); }
+
+  /**
+   * Relax the given pruning bound for (1 + epsilon)-approximate search.  A
+   * node is pruned when the best distance it could hold is no better than the
+   * relaxed bound; for furthest neighbor search, this is the bound multiplied
+   * by (1 + epsilon), so any neighbor returned has a distance of at least the
+   * true neighbor's distance divided by (1 + epsilon).
+   *
+   * @param value Bound to relax.
+   * @param epsilon Relative error tolerance (must be nonnegative).
+   */
+  static inline double Relax(const double value, const double epsilon)
+  {
+    if (value == DBL_MAX)
+      return DBL_MAX;
+    return value * (1.0 + epsilon);
+  }
 };
 
 }; // namespace neighbor
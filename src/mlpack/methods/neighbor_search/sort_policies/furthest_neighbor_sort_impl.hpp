@@ -60,6 +60,13 @@ inline double FurthestNeighborSort::BestPointToNodeDistance(
   return referenceNode->MaxDistance(point, pointToCenterDistance);
 }
 
+template<typename VecType, typename TreeType>
+inline size_t FurthestNeighborSort::GetBestChild(const VecType& queryPoint,
+    TreeType& node)
+{
+  return node.GetFurthestChild(queryPoint);
+}
+
 }; // namespace neighbor
 }; // namespace mlpack
 
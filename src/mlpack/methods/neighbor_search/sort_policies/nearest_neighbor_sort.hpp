@@ -115,6 +115,14 @@ class NearestNeighborSort
                                         const TreeType* referenceNode,
                                         const double pointToCenterDistance);
 
+  /**
+   * Return the index of the child of the given node that is most likely to hold
+   * the nearest neighbors of the given point; this is used by defeatist
+   * traversals.  TreeType::GetNearestChild() must be implemented to use this.
+   */
+  template<typename VecType, typename TreeType>
+  static size_t GetBestChild(const VecType& queryPoint, TreeType& node);
+
   /**
    * Return what should represent the worst possible distance with this
    * particular sort policy.  In our case, this should be the maximum possible
@@ -150,6 +158,23 @@ class NearestNeighborSort
       return DBL_MAX;
     return a + b;
   }
+
+  /**
+   * Relax the given pruning bound for (1 + epsilon)-approximate search.  A
+   * node is pruned when the best distance it could hold is no better than the
+   * relaxed bound; for nearest neighbor search, this is the bound divided by
+   * (1 + epsilon), so any neighbor returned is within a factor of (1 + epsilon)
+   * of the true neighbor's distance.
+   *
+   * @param value Bound to relax.
+   * @param epsilon Relative error tolerance (must be nonnegative).
+   */
+  static inline double Relax(const double value, const double epsilon)
+  {
+    if (value == DBL_MAX)
+      return DBL_MAX;
+    return value / (1.0 + epsilon);
+  }
 };
 
 }; // namespace neighbor
@@ -60,6 +60,13 @@ inline double NearestNeighborSort::BestPointToNodeDistance(
   return referenceNode->MinDistance(point, pointToCenterDistance);
 }
 
+template<typename VecType, typename TreeType>
+inline size_t NearestNeighborSort::GetBestChild(const VecType& queryPoint,
+    TreeType& node)
+{
+  return node.GetNearestChild(queryPoint);
+}
+
 }; // namespace neighbor
 }; // namespace mlpack
 
@@ -32,9 +32,11 @@ void Unmap(const arma::Mat<size_t>& neighbors,
     else
       distancesOut.col(queryMap[i]) = distances.col(i);
 
-    // Map indices of neighbors.
+    // Map indices of neighbors.  Neighbors that were not found (size_t() - 1)
+    // are left as they are.
     for (size_t j = 0; j < distances.n_rows; ++j)
-      neighborsOut(j, queryMap[i]) = referenceMap[neighbors(j, i)];
+      neighborsOut(j, queryMap[i]) = (neighbors(j, i) == size_t() - 1) ?
+          size_t() - 1 : referenceMap[neighbors(j, i)];
   }
 }
 
@@ -55,9 +57,11 @@ void Unmap(const arma::Mat<size_t>& neighbors,
   else
     distancesOut = distances;
 
-  // Map neighbors back to original locations.
+  // Map neighbors back to original locations.  Neighbors that were not found
+  // (size_t() - 1) are left as they are.
   for (size_t j = 0; j < neighbors.n_elem; ++j)
-    neighborsOut[j] = referenceMap[neighbors[j]];
+    neighborsOut[j] = (neighbors[j] == size_t() - 1) ? size_t() - 1 :
+        referenceMap[neighbors[j]];
 }
 
 }; // namespace neighbor
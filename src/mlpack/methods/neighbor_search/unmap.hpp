@@ -17,7 +17,7 @@ namespace neighbor {
  * queryMap (such as during kd-tree construction), unmap the columns of the
  * distances and neighbors matrices into neighborsOut and distancesOut, and also
  * unmap the entries in each row of neighbors.  This is useful for the dual-tree
- * case.
+ * case.  Neighbors that were not found (size_t() - 1) are left as they are.
  *
  * @param neighbors Matrix of neighbors resulting from neighbor search.
  * @param distances Matrix of distances resulting from neighbor search.
@@ -40,6 +40,7 @@ void Unmap(const arma::Mat<size_t>& neighbors,
  * during kd-tree construction), unmap the columns of the distances and
  * neighbors matrices into neighborsOut and distancesOut, and also unmap the
  * entries in each row of neighbors.  This is useful for the single-tree case.
+ * Neighbors that were not found (size_t() - 1) are left as they are.
  *
  * @param neighbors Matrix of neighbors resulting from neighbor search.
  * @param distances Matrix of distances resulting from neighbor search.
@@ -0,0 +1,108 @@
+/**
+ * @file kmeans_plus_plus_selection.hpp
+ * @author Ryan Curtin
+ *
+ * Select points for the Nystroem method with the seeding of k-means++, without
+ * running k-means itself.
+ */
+#ifndef __MLPACK_METHODS_NYSTROEM_METHOD_KMEANS_PLUS_PLUS_SELECTION_HPP
+#define __MLPACK_METHODS_NYSTROEM_METHOD_KMEANS_PLUS_PLUS_SELECTION_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/lmetric.hpp>
+
+namespace mlpack {
+namespace kernel {
+
+/**
+ * Select points with the seeding of k-means++: the first point is chosen
+ * uniformly at random, and each next point is chosen with probability
+ * proportional to its squared distance to the closest point already chosen.
+ * This spreads the points over the dataset like the centroids of K-Means do,
+ * but it takes only one sweep over the data per point (the same as one
+ * iteration of K-Means), and no point is selected twice unless the dataset
+ * holds fewer than m distinct points.  If mlpack is compiled with OpenMP, the
+ * distances are updated in parallel.
+ *
+ * For more information, see the following paper:
+ *
+ * @code
+ * @inproceedings{arthur2007k,
+ *   title={k-means++: The advantages of careful seeding},
+ *   author={Arthur, D. and Vassilvitskii, S.},
+ *   booktitle={Proceedings of the Eighteenth Annual ACM-SIAM Symposium on
+ *       Discrete Algorithms (SODA '07)},
+ *   pages={1027--1035},
+ *   year={2007}
+ * }
+ * @endcode
+ */
+class KMeansPlusPlusSelection
+{
+ public:
+  /**
+   * Select the specified number of points in the dataset with the seeding of
+   * k-means++.
+   *
+   * @param data Dataset to sample from.
+   * @param m Number of points to select.
+   * @return Indices of selected points from the dataset.
+   */
+  const static arma::Col<size_t> Select(const arma::mat& data, const size_t m)
+  {
+    arma::Col<size_t> selectedPoints(m);
+    if (m == 0)
+      return selectedPoints;
+
+    // The squared distance of each point to the closest selected point.
+    arma::vec distances(data.n_cols);
+    distances.fill(DBL_MAX);
+
+    selectedPoints[0] = math::RandInt(0, data.n_cols);
+    for (size_t i = 1; i < m; ++i)
+    {
+      const size_t last = selectedPoints[i - 1];
+      double total = 0.0;
+
+      #pragma omp parallel for schedule(static) reduction(+:total)
+      for (size_t j = 0; j < data.n_cols; ++j)
+      {
+        const double distance = metric::SquaredEuclideanDistance::Evaluate(
+            data.unsafe_col(j), data.unsafe_col(last));
+        if (distance < distances[j])
+          distances[j] = distance;
+        total += distances[j];
+      }
+
+      // If every point is already selected, fall back to a random point.
+      if (total == 0.0)
+      {
+        selectedPoints[i] = math::RandInt(0, data.n_cols);
+        continue;
+      }
+
+      // Sample the next point in proportion to the squared distances.
+      const double target = math::Random() * total;
+      double cumulative = 0.0;
+      size_t chosen = data.n_cols - 1;
+      for (size_t j = 0; j < data.n_cols; ++j)
+      {
+        cumulative += distances[j];
+        if (cumulative > target)
+        {
+          chosen = j;
+          break;
+        }
+      }
+
+      selectedPoints[i] = chosen;
+    }
+
+    return selectedPoints;
+  }
+};
+
+}; // namespace kernel
+}; // namespace mlpack
+
+#endif
@@ -31,17 +31,11 @@ void NystroemMethod<KernelType, PointSelectionPolicy>::GetKernelMatrix(
     arma::mat& semiKernel)
 {
   // Assemble mini-kernel matrix.
-  for (size_t i = 0; i < rank; ++i)
-    for (size_t j = 0; j < rank; ++j)
-      miniKernel(i, j) = kernel.Evaluate(selectedData->col(i),
-                                         selectedData->col(j));
+  KernelMatrix(kernel, *selectedData, miniKernel);
 
   // Construct semi-kernel matrix with interactions between selected data and
   // all points.
-  for (size_t i = 0; i < data.n_cols; ++i)
-    for (size_t j = 0; j < rank; ++j)
-      semiKernel(i, j) = kernel.Evaluate(data.col(i),
-                                         selectedData->col(j));
+  KernelMatrix(kernel, data, *selectedData, semiKernel);
   // Clean the memory.
   delete selectedData;
 }
@@ -52,18 +46,18 @@ void NystroemMethod<KernelType, PointSelectionPolicy>::GetKernelMatrix(
     arma::mat& miniKernel,
     arma::mat& semiKernel)
 {
+  // Collect the selected points, so that both matrices can be built with
+  // batch kernel evaluations.
+  arma::mat selectedData(data.n_rows, selectedPoints.n_elem);
+  for (size_t i = 0; i < selectedPoints.n_elem; ++i)
+    selectedData.col(i) = data.col(selectedPoints(i));
+
   // Assemble mini-kernel matrix.
-  for (size_t i = 0; i < rank; ++i)
-    for (size_t j = 0; j < rank; ++j)
-      miniKernel(i, j) = kernel.Evaluate(data.col(selectedPoints(i)),
-                                         data.col(selectedPoints(j)));
+  KernelMatrix(kernel, selectedData, miniKernel);
 
   // Construct semi-kernel matrix with interactions between selected points and
   // all points.
-  for (size_t i = 0; i < data.n_cols; ++i)
-    for (size_t j = 0; j < rank; ++j)
-      semiKernel(i, j) = kernel.Evaluate(data.col(i),
-                                         data.col(selectedPoints(j)));
+  KernelMatrix(kernel, data, selectedData, semiKernel);
 }
 
 template<typename KernelType, typename PointSelectionPolicy>
@@ -0,0 +1,112 @@
+/**
+ * @file incremental_pca.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the IncrementalPCA class.
+ */
+#include "incremental_pca.hpp"
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::pca;
+
+IncrementalPCA::IncrementalPCA(const size_t rank) :
+    rank(rank),
+    numPoints(0),
+    sumSquares(0.0)
+{
+  if (rank == 0)
+    Log::Fatal << "IncrementalPCA::IncrementalPCA(): rank cannot be zero!"
+        << endl;
+}
+
+void IncrementalPCA::Update(const arma::mat& chunk)
+{
+  if (chunk.n_cols == 0)
+    return; // Nothing to do.
+
+  if (numPoints != 0 && chunk.n_rows != mean.n_elem)
+    Log::Fatal << "IncrementalPCA::Update(): dimensionality of chunk ("
+        << chunk.n_rows << ") does not match dimensionality of previous "
+        << "points (" << mean.n_elem << ")!" << endl;
+
+  const size_t m = chunk.n_cols;
+  const arma::vec chunkMean = arma::mean(chunk, 1);
+
+  arma::mat centered = chunk;
+  centered.each_col() -= chunkMean;
+  const double chunkSumSquares = arma::accu(centered % centered);
+
+  // The matrix to decompose: the current components scaled by their singular
+  // values, the centered chunk, and the correction for the shift of the mean.
+  arma::mat augmented;
+  double meanShiftSquared = 0.0;
+  if (numPoints == 0)
+  {
+    augmented = centered;
+  }
+  else
+  {
+    const size_t k = components.n_cols;
+    const double weight = std::sqrt(double(numPoints) * m / (numPoints + m));
+    const arma::vec meanShift = chunkMean - mean;
+    meanShiftSquared = weight * weight * arma::dot(meanShift, meanShift);
+
+    augmented.set_size(chunk.n_rows, k + m + 1);
+    augmented.cols(0, k - 1) = components * arma::diagmat(singularValues);
+    augmented.cols(k, k + m - 1) = centered;
+    augmented.col(k + m) = weight * meanShift;
+  }
+
+  arma::mat u, v;
+  arma::vec s;
+  arma::svd_econ(u, s, v, augmented, 'l');
+
+  const size_t keep = std::min(rank, (size_t) s.n_elem);
+  components = u.cols(0, keep - 1);
+  singularValues = s.subvec(0, keep - 1);
+
+  sumSquares += chunkSumSquares + meanShiftSquared;
+  if (numPoints == 0)
+    mean = chunkMean;
+  else
+    mean = (double(numPoints) * mean + double(m) * chunkMean) /
+        double(numPoints + m);
+  numPoints += m;
+}
+
+void IncrementalPCA::Transform(const arma::mat& data,
+                               arma::mat& transformedData) const
+{
+  arma::mat centered = data;
+  centered.each_col() -= mean;
+  transformedData = arma::trans(components) * centered;
+}
+
+arma::vec IncrementalPCA::EigenValues() const
+{
+  // The covariance matrix is X * X' / (N - 1), as for PCA.
+  if (numPoints < 2)
+    return arma::zeros<arma::vec>(singularValues.n_elem);
+
+  return arma::square(singularValues) / (numPoints - 1);
+}
+
+double IncrementalPCA::VarianceRetained() const
+{
+  if (sumSquares == 0.0)
+    return 1.0;
+
+  return arma::accu(arma::square(singularValues)) / sumSquares;
+}
+
+// Return a string of this object.
+std::string IncrementalPCA::ToString() const
+{
+  std::ostringstream convert;
+  convert << "Incremental Principal Component Analysis  [" << this << "]"
+      << std::endl;
+  convert << "  Rank: " << rank << std::endl;
+  convert << "  Points seen: " << numPoints << std::endl;
+  return convert.str();
+}
@@ -0,0 +1,116 @@
+/**
+ * @file incremental_pca.hpp
+ * @author Ryan Curtin
+ *
+ * Defines the IncrementalPCA class, which performs principal components
+ * analysis on data given one chunk at a time.
+ */
+#ifndef __MLPACK_METHODS_PCA_INCREMENTAL_PCA_HPP
+#define __MLPACK_METHODS_PCA_INCREMENTAL_PCA_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace pca {
+
+/**
+ * This class implements incremental principal components analysis: the top
+ * principal components of a dataset are updated one chunk of points at a time,
+ * so the whole dataset never has to be in memory.  After each chunk, the
+ * current components (scaled by their singular values), the centered chunk and
+ * a correction for the change of the mean are decomposed together, as in the
+ * following paper:
+ *
+ * @code
+ * @article{ross2008incremental,
+ *   title={Incremental learning for robust visual tracking},
+ *   author={Ross, D.A. and Lim, J. and Lin, R.S. and Yang, M.H.},
+ *   journal={International Journal of Computer Vision},
+ *   volume={77},
+ *   number={1--3},
+ *   pages={125--141},
+ *   year={2008}
+ * }
+ * @endcode
+ *
+ * The memory used is O(d (rank + chunk size)), for d-dimensional data.  The
+ * result is exact if the rank is at least the rank of the data, and otherwise
+ * it is a close approximation of the top components of the full PCA.
+ *
+ * An example of how to use the class is shown below:
+ *
+ * @code
+ * IncrementalPCA p(20); // Keep the top 20 components.
+ * for (...)
+ *   p.Update(chunk); // Each chunk is a matrix of points (one per column).
+ *
+ * arma::mat transformed;
+ * p.Transform(data, transformed);
+ * @endcode
+ */
+class IncrementalPCA
+{
+ public:
+  /**
+   * Create the IncrementalPCA object, which will keep the given number of
+   * components.
+   *
+   * @param rank Number of components to keep.
+   */
+  IncrementalPCA(const size_t rank);
+
+  /**
+   * Update the decomposition with the given points.  The first chunk sets the
+   * dimensionality of the data.
+   *
+   * @param chunk Points to add (one per column).
+   */
+  void Update(const arma::mat& chunk);
+
+  /**
+   * Project the given points onto the current components.  It is safe to pass
+   * the same matrix reference for both data and transformedData.
+   *
+   * @param data Points to transform.
+   * @param transformedData Matrix to store the projections in.
+   */
+  void Transform(const arma::mat& data, arma::mat& transformedData) const;
+
+  //! Get the current components (eigenvectors), one per column.
+  const arma::mat& EigenVectors() const { return components; }
+  //! Get the eigenvalues of the current components.
+  arma::vec EigenValues() const;
+  //! Get the mean of the points seen so far.
+  const arma::vec& Mean() const { return mean; }
+  //! Get the number of points seen so far.
+  size_t NumPoints() const { return numPoints; }
+  //! Get the number of components to keep.
+  size_t Rank() const { return rank; }
+
+  //! Get the amount of the variance of the points seen so far that is retained
+  //! by the current components (between 0 and 1).
+  double VarianceRetained() const;
+
+  // Returns a string representation of this object.
+  std::string ToString() const;
+
+ private:
+  //! Number of components to keep.
+  size_t rank;
+  //! Number of points seen so far.
+  size_t numPoints;
+  //! Mean of the points seen so far.
+  arma::vec mean;
+  //! Current components, one per column.
+  arma::mat components;
+  //! Singular values of the centered points seen so far, for each component.
+  arma::vec singularValues;
+  //! Sum of the squared distances of the points seen so far to their mean.
+  double sumSquares;
+
+}; // class IncrementalPCA
+
+}; // namespace pca
+}; // namespace mlpack
+
+#endif
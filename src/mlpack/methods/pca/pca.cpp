@@ -12,8 +12,14 @@ using namespace std;
 using namespace mlpack;
 using namespace mlpack::pca;
 
-PCA::PCA(const bool scaleData) :
-    scaleData(scaleData)
+PCA::PCA(const bool scaleData,
+         const bool randomized,
+         const size_t oversampling,
+         const size_t powerIterations) :
+    scaleData(scaleData),
+    randomized(randomized),
+    oversampling(oversampling),
+    powerIterations(powerIterations)
 { }
 
 /**
@@ -91,6 +97,193 @@ void PCA::Apply(const arma::mat& data,
   Apply(data, transformedData, eigVal, coeffs);
 }
 
+/**
+ * Apply Principal Component Analysis to the provided data set, keeping only the
+ * given number of components.
+ *
+ * @param data - Data matrix
+ * @param rank - Number of components to keep
+ * @param transformedData - Data with PCA applied
+ * @param eigVal - contains the largest eigen values in a column vector
+ * @param coeff - PCA Loadings/Coeffs/EigenVectors of those eigen values
+ */
+void PCA::Apply(const arma::mat& data,
+                const size_t rank,
+                arma::mat& transformedData,
+                arma::vec& eigVal,
+                arma::mat& coeff) const
+{
+  if (rank == 0 || rank > data.n_rows)
+    Log::Fatal << "PCA::Apply(): rank (" << rank << ") must be between 1 and "
+        << "the dimensionality of the data (" << data.n_rows << ")!" << endl;
+
+  if (randomized)
+  {
+    RandomizedApply(data, rank, transformedData, eigVal, coeff);
+    return;
+  }
+
+  Apply(data, transformedData, eigVal, coeff);
+
+  // Drop the components we do not need.  There are no more eigenvalues than
+  // points.
+  const size_t keep = std::min(rank, (size_t) eigVal.n_elem);
+  if (keep < coeff.n_cols)
+    coeff.shed_cols(keep, coeff.n_cols - 1);
+  if (keep < eigVal.n_elem)
+    eigVal.shed_rows(keep, eigVal.n_elem - 1);
+  if (keep < transformedData.n_rows)
+    transformedData.shed_rows(keep, transformedData.n_rows - 1);
+}
+
+/**
+ * Apply Principal Component Analysis to the provided sparse data set, keeping
+ * only the given number of components, with the randomized decomposition.
+ *
+ * @param data - Sparse data matrix
+ * @param rank - Number of components to keep
+ * @param transformedData - Data with PCA applied
+ * @param eigVal - contains the largest eigen values in a column vector
+ * @param coeff - PCA Loadings/Coeffs/EigenVectors of those eigen values
+ */
+void PCA::Apply(const arma::sp_mat& data,
+                const size_t rank,
+                arma::mat& transformedData,
+                arma::vec& eigVal,
+                arma::mat& coeff) const
+{
+  if (rank == 0 || rank > data.n_rows)
+    Log::Fatal << "PCA::Apply(): rank (" << rank << ") must be between 1 and "
+        << "the dimensionality of the data (" << data.n_rows << ")!" << endl;
+
+  RandomizedApply(data, rank, transformedData, eigVal, coeff);
+}
+
+/**
+ * Compute the mean and the variance of each dimension of the given dense data.
+ */
+static void Moments(const arma::mat& data, arma::vec& mean, arma::vec& variance)
+{
+  mean = arma::mean(data, 1);
+  variance = arma::var(data, 0, 1);
+}
+
+/**
+ * Compute the mean and the variance of each dimension of the given sparse data,
+ * in one pass over its nonzero elements.
+ */
+static void Moments(const arma::sp_mat& data,
+                    arma::vec& mean,
+                    arma::vec& variance)
+{
+  mean.zeros(data.n_rows);
+  variance.zeros(data.n_rows);
+  for (arma::sp_mat::const_iterator it = data.begin(); it != data.end(); ++it)
+  {
+    mean[it.row()] += (*it);
+    variance[it.row()] += (*it) * (*it);
+  }
+
+  // The zeros contribute only to the count of points.
+  mean /= data.n_cols;
+  if (data.n_cols > 1)
+    variance = (variance - data.n_cols * arma::square(mean)) /
+        (data.n_cols - 1);
+  else
+    variance.zeros();
+
+  // Rounding may make a variance of zero slightly negative.
+  for (size_t i = 0; i < variance.n_elem; ++i)
+    if (variance[i] < 0)
+      variance[i] = 0;
+}
+
+/**
+ * Multiply the implicitly centered and scaled data, diag(invScale) (X - mean),
+ * by the given matrix.  The data may be dense or sparse.
+ */
+template<typename MatType>
+static arma::mat CenteredTimes(const MatType& data,
+                               const arma::vec& mean,
+                               const arma::vec& invScale,
+                               const arma::mat& m)
+{
+  arma::mat result = data * m;
+  result -= mean * arma::sum(m, 0);
+  return arma::diagmat(invScale) * result;
+}
+
+/**
+ * Multiply the transpose of the implicitly centered and scaled data,
+ * (X - mean)^T diag(invScale), by the given matrix.  The product is computed
+ * as (m^T diag(invScale) X)^T, so the transpose of the (possibly sparse) data
+ * is never formed.
+ */
+template<typename MatType>
+static arma::mat CenteredTransTimes(const MatType& data,
+                                    const arma::vec& mean,
+                                    const arma::vec& invScale,
+                                    const arma::mat& m)
+{
+  const arma::mat scaled = arma::trans(arma::diagmat(invScale) * m);
+  arma::mat result = scaled * data;
+  result.each_col() -= scaled * mean;
+  return arma::trans(result);
+}
+
+template<typename MatType>
+void PCA::RandomizedApply(const MatType& data,
+                          const size_t rank,
+                          arma::mat& transformedData,
+                          arma::vec& eigVal,
+                          arma::mat& coeff) const
+{
+  Timer::Start("pca");
+
+  // The data is centered (and scaled) implicitly, in the products below.
+  arma::vec mean, variance;
+  Moments(data, mean, variance);
+  arma::vec invScale = arma::ones<arma::vec>(data.n_rows);
+  if (scaleData)
+  {
+    // Dimensions without any variance stay zero.
+    for (size_t i = 0; i < variance.n_elem; ++i)
+      invScale[i] = (variance[i] == 0) ? 0 : 1.0 / std::sqrt(variance[i]);
+  }
+
+  // Find an orthonormal basis of the range of the data, with oversampling and
+  // power iterations (each product is re-orthonormalized, for stability).
+  const size_t l = std::min(rank + oversampling,
+      (size_t) std::min(data.n_rows, data.n_cols));
+  arma::mat q, r;
+  arma::qr_econ(q, r, CenteredTimes(data, mean, invScale,
+      arma::randn<arma::mat>(data.n_cols, l)));
+  for (size_t i = 0; i < powerIterations; ++i)
+  {
+    arma::qr_econ(q, r, CenteredTransTimes(data, mean, invScale, q));
+    arma::qr_econ(q, r, CenteredTimes(data, mean, invScale, q));
+  }
+
+  // Take the SVD of the data in that basis, B = Q^T X.  We decompose B^T,
+  // whose right singular vectors are the left singular vectors of B.
+  arma::mat u, v;
+  arma::vec s;
+  arma::svd_econ(v, s, u, CenteredTransTimes(data, mean, invScale, q));
+
+  const size_t keep = std::min(rank, (size_t) s.n_elem);
+  coeff = q * u.cols(0, keep - 1);
+
+  // The projection of the data onto the components is U^T Q^T X = U^T B.
+  transformedData = arma::diagmat(s.subvec(0, keep - 1)) *
+      arma::trans(v.cols(0, keep - 1));
+
+  // Square the singular values to get the eigenvalues, as in the full
+  // decomposition.
+  eigVal = arma::square(s.subvec(0, keep - 1)) / (data.n_cols - 1);
+
+  Timer::Stop("pca");
+}
+
 /**
  * Use PCA for dimensionality reduction on the given dataset.  This will save
  * the newDimension largest principal components of the data and remove the
@@ -116,6 +309,20 @@ double PCA::Apply(arma::mat& data, const size_t newDimension) const
   arma::mat coeffs;
   arma::vec eigVal;
 
+  if (randomized)
+  {
+    // Only the largest eigenvalues are computed, so the total variance of the
+    // data is found from the variance of each dimension.
+    const arma::vec variances = arma::var(data, 0, 1);
+    double totalVariance = 0.0;
+    for (size_t i = 0; i < variances.n_elem; ++i)
+      if (variances[i] > 0)
+        totalVariance += (scaleData ? 1.0 : variances[i]);
+
+    Apply(data, newDimension, data, eigVal, coeffs);
+    return arma::sum(eigVal) / totalVariance;
+  }
+
   Apply(data, data, eigVal, coeffs);
 
   if (newDimension < coeffs.n_rows)
@@ -172,6 +379,44 @@ double PCA::Apply(arma::mat& data, const double varRetained) const
   return varSum;
 }
 
+/**
+ * Use PCA for dimensionality reduction on the given sparse dataset, with the
+ * randomized decomposition, storing the (dense) reduced data in
+ * transformedData.
+ *
+ * @param data Sparse data matrix.
+ * @param newDimension New dimension of the data.
+ * @param transformedData Matrix to store the reduced data in.
+ * @return Amount of the variance of the data retained (between 0 and 1).
+ */
+double PCA::Apply(const arma::sp_mat& data,
+                  const size_t newDimension,
+                  arma::mat& transformedData) const
+{
+  // Parameter validation.
+  if (newDimension == 0)
+    Log::Fatal << "PCA::Apply(): newDimension (" << newDimension << ") cannot "
+        << "be zero!" << endl;
+  if (newDimension > data.n_rows)
+    Log::Fatal << "PCA::Apply(): newDimension (" << newDimension << ") cannot "
+        << "be greater than the existing dimensionality of the data ("
+        << data.n_rows << ")!" << endl;
+
+  // Only the largest eigenvalues are computed, so the total variance of the
+  // data is found from the variance of each dimension.
+  arma::vec mean, variances;
+  Moments(data, mean, variances);
+  double totalVariance = 0.0;
+  for (size_t i = 0; i < variances.n_elem; ++i)
+    if (variances[i] > 0)
+      totalVariance += (scaleData ? 1.0 : variances[i]);
+
+  arma::mat coeffs;
+  arma::vec eigVal;
+  Apply(data, newDimension, transformedData, eigVal, coeffs);
+  return arma::sum(eigVal) / totalVariance;
+}
+
 // return a string of this object.
 std::string PCA::ToString() const
 {
@@ -179,5 +424,8 @@ std::string PCA::ToString() const
   convert << "Principal Component Analysis  [" << this << "]" << std::endl;
   if (scaleData)
     convert << "  Scaling Data: TRUE" << std::endl;
+  if (randomized)
+    convert << "  Randomized: TRUE (oversampling " << oversampling << ", "
+        << powerIterations << " power iterations)" << std::endl;
   return convert.str();
 }
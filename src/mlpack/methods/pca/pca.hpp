@@ -19,17 +19,61 @@ namespace pca {
  * or transforming data into a better basis.  Further information on PCA can be
  * found in almost any statistics or machine learning textbook, and all over the
  * internet.
+ *
+ * By default, a full singular value decomposition of the centered data is
+ * computed.  When only the top k components are needed, the randomized range
+ * finder of the following paper can be used instead:
+ *
+ * @code
+ * @article{halko2011finding,
+ *   title={Finding structure with randomness: Probabilistic algorithms for
+ *       constructing approximate matrix decompositions},
+ *   author={Halko, N. and Martinsson, P.G. and Tropp, J.A.},
+ *   journal={SIAM Review},
+ *   volume={53},
+ *   number={2},
+ *   pages={217--288},
+ *   year={2011}
+ * }
+ * @endcode
+ *
+ * The data is multiplied by a random Gaussian matrix with k + oversampling
+ * columns, followed by a few power iterations, and the SVD is computed in
+ * the subspace of the result; the data is centered (and scaled) implicitly,
+ * so no centered copy is made.  The cost is O(d n (k + oversampling)) per power
+ * iteration, instead of the cost of the full SVD.  The randomized decomposition
+ * is used by the Apply() overloads that are given the number of components; the
+ * others always compute the full decomposition, since they need all of the
+ * eigenvalues.
+ *
+ * Sparse data (arma::sp_mat) is only decomposed in this way, since centering
+ * it would make it dense: the products with the centered data, (X - mu 1^T) v,
+ * are computed as X v - mu (1^T v), so only the sparse data and a few dense
+ * matrices with k + oversampling columns are held in memory.
+ *
+ * For data that arrives in chunks, or does not fit in memory, see
+ * IncrementalPCA.
  */
 class PCA
 {
  public:
   /**
    * Create the PCA object, specifying if the data should be scaled in each
-   * dimension by standard deviation when PCA is performed.
+   * dimension by standard deviation when PCA is performed, and whether the
+   * randomized decomposition should be used when the number of components is
+   * given.
    *
    * @param scaleData Whether or not to scale the data.
+   * @param randomized Whether or not to use the randomized decomposition.
+   * @param oversampling Number of extra random directions of the randomized
+   *     decomposition.
+   * @param powerIterations Number of power iterations of the randomized
+   *     decomposition.
    */
-  PCA(const bool scaleData = false);
+  PCA(const bool scaleData = false,
+      const bool randomized = false,
+      const size_t oversampling = 10,
+      const size_t powerIterations = 2);
 
   /**
    * Apply Principal Component Analysis to the provided data set.  It is safe to
@@ -57,6 +101,43 @@ class PCA
              arma::mat& transformedData,
              arma::vec& eigVal) const;
 
+  /**
+   * Apply Principal Component Analysis to the provided data set, keeping only
+   * the given number of components.  If the randomized decomposition is
+   * enabled, only those components are computed; otherwise, the full
+   * decomposition is truncated.  It is safe to pass the same matrix reference
+   * for both data and transformedData.
+   *
+   * @param data Data matrix.
+   * @param rank Number of components to keep.
+   * @param transformedData Matrix to put results of PCA into.
+   * @param eigVal Vector to put the largest eigenvalues into.
+   * @param eigvec Matrix to put the corresponding eigenvectors into.
+   */
+  void Apply(const arma::mat& data,
+             const size_t rank,
+             arma::mat& transformedData,
+             arma::vec& eigVal,
+             arma::mat& eigvec) const;
+
+  /**
+   * Apply Principal Component Analysis to the provided sparse data set, keeping
+   * only the given number of components.  The randomized decomposition is
+   * always used (whatever Randomized() is), and the data is centered (and
+   * scaled) implicitly, so it is never made dense.
+   *
+   * @param data Sparse data matrix.
+   * @param rank Number of components to keep.
+   * @param transformedData Matrix to put results of PCA into.
+   * @param eigVal Vector to put the largest eigenvalues into.
+   * @param eigvec Matrix to put the corresponding eigenvectors into.
+   */
+  void Apply(const arma::sp_mat& data,
+             const size_t rank,
+             arma::mat& transformedData,
+             arma::vec& eigVal,
+             arma::mat& eigvec) const;
+
   /**
    * Use PCA for dimensionality reduction on the given dataset.  This will save
    * the newDimension largest principal components of the data and remove the
@@ -93,6 +174,21 @@ class PCA
    */
   double Apply(arma::mat& data, const double varRetained) const;
 
+  /**
+   * Use PCA for dimensionality reduction on the given sparse dataset, with the
+   * randomized decomposition.  The reduced data is dense, so it is stored in
+   * transformedData.  The parameter returned is the amount of variance of the
+   * data that is retained (between 0 and 1).
+   *
+   * @param data Sparse data matrix.
+   * @param newDimension New dimension of the data.
+   * @param transformedData Matrix to store the reduced data in.
+   * @return Amount of the variance of the data retained (between 0 and 1).
+   */
+  double Apply(const arma::sp_mat& data,
+               const size_t newDimension,
+               arma::mat& transformedData) const;
+
   //! Get whether or not this PCA object will scale (by standard deviation) the
   //! data when PCA is performed.
   bool ScaleData() const { return scaleData; }
@@ -100,6 +196,23 @@ class PCA
   //! the data when PCA is performed.
   bool& ScaleData() { return scaleData; }
 
+  //! Get whether or not the randomized decomposition is used when the number
+  //! of components is given.
+  bool Randomized() const { return randomized; }
+  //! Modify whether or not the randomized decomposition is used when the
+  //! number of components is given.
+  bool& Randomized() { return randomized; }
+
+  //! Get the oversampling of the randomized decomposition.
+  size_t Oversampling() const { return oversampling; }
+  //! Modify the oversampling of the randomized decomposition.
+  size_t& Oversampling() { return oversampling; }
+
+  //! Get the number of power iterations of the randomized decomposition.
+  size_t PowerIterations() const { return powerIterations; }
+  //! Modify the number of power iterations of the randomized decomposition.
+  size_t& PowerIterations() { return powerIterations; }
+
   // Returns a string representation of this object.
   std::string ToString() const;
 
@@ -107,6 +220,22 @@ class PCA
   //! Whether or not the data will be scaled by standard deviation when PCA is
   //! performed.
   bool scaleData;
+  //! Whether or not the randomized decomposition is used when the number of
+  //! components is given.
+  bool randomized;
+  //! Number of extra random directions of the randomized decomposition.
+  size_t oversampling;
+  //! Number of power iterations of the randomized decomposition.
+  size_t powerIterations;
+
+  //! Compute the given number of components with the randomized range finder,
+  //! for dense or sparse data.
+  template<typename MatType>
+  void RandomizedApply(const MatType& data,
+                       const size_t rank,
+                       arma::mat& transformedData,
+                       arma::vec& eigVal,
+                       arma::mat& coeff) const;
 
 }; // class PCA
 
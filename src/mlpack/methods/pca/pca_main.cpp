@@ -7,6 +7,7 @@
 #include <mlpack/core.hpp>
 
 #include "pca.hpp"
+#include "incremental_pca.hpp"
 
 using namespace mlpack;
 using namespace mlpack::pca;
@@ -17,7 +18,22 @@ PROGRAM_INFO("Principal Components Analysis", "This program performs principal "
     "components analysis on the given dataset.  It will transform the data "
     "onto its principal components, optionally performing dimensionality "
     "reduction by ignoring the principal components with the smallest "
-    "eigenvalues.");
+    "eigenvalues."
+    "\n\n"
+    "When the new dimensionality is given, the --randomized (-r) option finds "
+    "only the top principal components, with a randomized SVD, which is much "
+    "faster than the full decomposition when few components are needed.  The "
+    "--incremental (-I) option updates the components one chunk of points at a "
+    "time (of size --chunk_size), instead of decomposing the whole dataset at "
+    "once; it does not support scaling or --var_to_retain."
+    "\n\n"
+    "The --sparse (-S) option loads the dataset as a sparse matrix (a "
+    "coordinate list, denoted by .csv, .tsv, or .txt, with one \"point "
+    "dimension value\" entry per line; a Matrix Market file, .mtx; or a "
+    "LibSVM file, .svm or .libsvm) and finds the top principal components "
+    "with the randomized SVD, without ever centering the dataset explicitly; "
+    "so the dataset is never made dense, and only the transformed dataset is.  "
+    "It does not support --var_to_retain or --incremental.");
 
 // Parameters for program.
 PARAM_STRING_REQ("input_file", "Input dataset to perform PCA on.", "i");
@@ -30,11 +46,72 @@ PARAM_DOUBLE("var_to_retain", "Amount of variance to retain; should be between "
 PARAM_FLAG("scale", "If set, the data will be scaled before running PCA, such "
     "that the variance of each feature is 1.", "s");
 
+PARAM_FLAG("randomized", "If set, the top principal components are found with "
+    "a randomized SVD.", "r");
+PARAM_INT("oversampling", "Number of extra random directions for the "
+    "randomized SVD.", "O", 10);
+PARAM_INT("power_iterations", "Number of power iterations for the randomized "
+    "SVD.", "P", 2);
+PARAM_FLAG("incremental", "If set, the principal components are updated one "
+    "chunk of points at a time.", "I");
+PARAM_INT("chunk_size", "Number of points in each chunk for incremental PCA.",
+    "c", 1000);
+PARAM_FLAG("sparse", "If set, the dataset is loaded as a sparse matrix, and "
+    "the top principal components are found with a randomized SVD.", "S");
+
 int main(int argc, char** argv)
 {
   // Parse commandline.
   CLI::ParseCommandLine(argc, argv);
 
+  // Sparse datasets have their own path, since they are never made dense.
+  if (CLI::HasParam("sparse"))
+  {
+    if (CLI::HasParam("incremental"))
+      Log::Fatal << "Sparse PCA (-S) does not support --incremental (-I)!"
+          << endl;
+    if (CLI::GetParam<double>("var_to_retain") != 0)
+      Log::Fatal << "Sparse PCA (-S) does not support --var_to_retain (-V)!"
+          << endl;
+    if (CLI::GetParam<int>("new_dimensionality") < 0)
+      Log::Fatal << "New dimensionality ("
+          << CLI::GetParam<int>("new_dimensionality") << ") cannot be "
+          << "negative!" << endl;
+    if (CLI::GetParam<int>("oversampling") < 0)
+      Log::Fatal << "Oversampling (" << CLI::GetParam<int>("oversampling")
+          << ") cannot be negative!" << endl;
+    if (CLI::GetParam<int>("power_iterations") < 0)
+      Log::Fatal << "Number of power iterations ("
+          << CLI::GetParam<int>("power_iterations") << ") cannot be negative!"
+          << endl;
+
+    // As for dense datasets, each row of the file matrix is a point.
+    arma::sp_mat dataset;
+    data::Load(CLI::GetParam<string>("input_file"), dataset, true);
+
+    size_t newDimension = dataset.n_rows;
+    if (CLI::GetParam<int>("new_dimensionality") != 0)
+      newDimension = (size_t) CLI::GetParam<int>("new_dimensionality");
+    if (newDimension > dataset.n_rows)
+      Log::Fatal << "New dimensionality (" << newDimension
+          << ") cannot be greater than existing dimensionality ("
+          << dataset.n_rows << ")!" << endl;
+
+    PCA p(CLI::HasParam("scale"), true,
+        (size_t) CLI::GetParam<int>("oversampling"),
+        (size_t) CLI::GetParam<int>("power_iterations"));
+    Log::Info << "Performing sparse PCA on dataset..." << endl;
+    arma::mat transformedData;
+    const double varRetained = p.Apply(dataset, newDimension, transformedData);
+
+    Log::Info << (varRetained * 100) << "% of variance retained (" <<
+        transformedData.n_rows << " dimensions)." << endl;
+
+    // Now save the results.
+    data::Save(CLI::GetParam<string>("output_file"), transformedData);
+    return 0;
+  }
+
   // Load input dataset.
   string inputFile = CLI::GetParam<string>("input_file");
   arma::mat dataset;
@@ -56,17 +133,70 @@ int main(int argc, char** argv)
 
   // Get the options for running PCA.
   const size_t scale = CLI::HasParam("scale");
+  const bool randomized = CLI::HasParam("randomized");
+  const bool incremental = CLI::HasParam("incremental");
+
+  if (randomized && incremental)
+    Log::Fatal << "Only one of --randomized (-r) and --incremental (-I) may be "
+        << "specified!" << endl;
+
+  if (CLI::GetParam<int>("oversampling") < 0)
+    Log::Fatal << "Oversampling (" << CLI::GetParam<int>("oversampling")
+        << ") cannot be negative!" << endl;
+  if (CLI::GetParam<int>("power_iterations") < 0)
+    Log::Fatal << "Number of power iterations ("
+        << CLI::GetParam<int>("power_iterations") << ") cannot be negative!"
+        << endl;
+
+  double varRetained;
+  if (incremental)
+  {
+    if (scale)
+      Log::Fatal << "Incremental PCA (-I) does not support scaling (-s)!"
+          << endl;
+    if (CLI::GetParam<double>("var_to_retain") != 0)
+      Log::Fatal << "Incremental PCA (-I) does not support --var_to_retain "
+          << "(-V)!" << endl;
+    if (CLI::GetParam<int>("chunk_size") <= 0)
+      Log::Fatal << "Chunk size (" << CLI::GetParam<int>("chunk_size")
+          << ") must be positive!" << endl;
+
+    const size_t chunkSize = (size_t) CLI::GetParam<int>("chunk_size");
+
+    IncrementalPCA p(newDimension);
+    Log::Info << "Performing incremental PCA on dataset..." << endl;
+    for (size_t begin = 0; begin < dataset.n_cols; begin += chunkSize)
+    {
+      const size_t end = std::min(begin + chunkSize, (size_t) dataset.n_cols);
+      p.Update(dataset.cols(begin, end - 1));
+    }
+
+    p.Transform(dataset, dataset);
+    varRetained = p.VarianceRetained();
+
+    Log::Info << (varRetained * 100) << "% of variance retained (" <<
+        dataset.n_rows << " dimensions)." << endl;
+
+    // Now save the results.
+    string outputFile = CLI::GetParam<string>("output_file");
+    data::Save(outputFile, dataset);
+    return 0;
+  }
 
   // Perform PCA.
-  PCA p(scale);
+  PCA p(scale, randomized, (size_t) CLI::GetParam<int>("oversampling"),
+      (size_t) CLI::GetParam<int>("power_iterations"));
   Log::Info << "Performing PCA on dataset..." << endl;
-  double varRetained;
   if (CLI::GetParam<double>("var_to_retain") != 0)
   {
     if (CLI::GetParam<int>("new_dimensionality") != 0)
       Log::Warn << "New dimensionality (-d) ignored because -V was specified."
           << endl;
 
+    if (randomized)
+      Log::Warn << "Randomized SVD (-r) ignored because -V was specified."
+          << endl;
+
     varRetained = p.Apply(dataset, CLI::GetParam<double>("var_to_retain"));
   }
   else
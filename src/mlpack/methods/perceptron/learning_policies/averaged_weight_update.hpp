@@ -0,0 +1,102 @@
+/**
+ * @file averaged_weight_update.hpp
+ * @author Ryan Curtin
+ *
+ * The averaged perceptron update rule.
+ */
+#ifndef _MLPACK_METHODS_PERCEPTRON_LEARNING_POLICIES_AVERAGED_WEIGHT_UPDATE_HPP
+#define _MLPACK_METHODS_PERCEPTRON_LEARNING_POLICIES_AVERAGED_WEIGHT_UPDATE_HPP
+
+#include <mlpack/core.hpp>
+#include "simple_weight_update.hpp"
+
+namespace mlpack {
+namespace perceptron {
+
+/**
+ * The averaged perceptron: the weights are updated with the simple rule of
+ * Rosenblatt (see SimpleWeightUpdate), but the final weights are the average of
+ * the weights after each training point, not the weights after the last point.
+ * This makes the perceptron much less sensitive to the order of the points and
+ * to the last few mistakes, and it generalizes about as well as the voted
+ * perceptron of Freund and Schapire (1999).
+ *
+ * The average is not computed by summing the weights at each step, which would
+ * take O(d) time per point; instead, each update at step c is also accumulated
+ * with a weight of c, and the average is recovered from the weights and the
+ * accumulated updates once training is done.  So each update still takes the
+ * time of the simple update (O(nnz) for sparse points).
+ */
+class AveragedWeightUpdate
+{
+ public:
+  //! Create the update rule; the first step is step 1.
+  AveragedWeightUpdate() : step(1) { }
+
+  /**
+   * Update the weights for a misclassified point, and record the update for
+   * the average.
+   *
+   * @tparam VecType Type of vector (should be an Armadillo vector like
+   *      arma::vec, or a column of an arma::sp_mat).
+   * @param trainingPoint Point that was misclassified.
+   * @param weights Matrix of weights.
+   * @param biases Vector of biases.
+   * @param incorrectClass Index of class that the point was incorrectly
+   *      classified as.
+   * @param correctClass Index of the true class of the point.
+   * @param instanceWeight Weight to be given to this particular point during
+   *      training (this is useful for boosting).
+   */
+  template<typename VecType>
+  void UpdateWeights(const VecType& trainingPoint,
+                     arma::mat& weights,
+                     arma::vec& biases,
+                     const size_t incorrectClass,
+                     const size_t correctClass,
+                     const double instanceWeight = 1.0)
+  {
+    if (weightUpdates.n_rows != weights.n_rows ||
+        weightUpdates.n_cols != weights.n_cols)
+    {
+      weightUpdates.zeros(weights.n_rows, weights.n_cols);
+      biasUpdates.zeros(biases.n_elem);
+    }
+
+    update.UpdateWeights(trainingPoint, weights, biases, incorrectClass,
+        correctClass, instanceWeight);
+    update.UpdateWeights(trainingPoint, weightUpdates, biasUpdates,
+        incorrectClass, correctClass, step * instanceWeight);
+  }
+
+  //! Move to the next training point.
+  void Step() { ++step; }
+
+  /**
+   * Replace the weights and biases with their average over all of the steps.
+   */
+  void Finish(arma::mat& weights, arma::vec& biases)
+  {
+    // If there was never a mistake, the weights never changed.
+    if (weightUpdates.n_elem == 0)
+      return;
+
+    weights -= weightUpdates / step;
+    biases -= biasUpdates / step;
+  }
+
+ private:
+  //! The simple update rule, used for the weights and the accumulated updates.
+  SimpleWeightUpdate update;
+  //! The current step (one more than the number of points seen).
+  size_t step;
+  //! The updates to the weights, each weighted by the step it was made at.
+  arma::mat weightUpdates;
+  //! The updates to the biases, each weighted by the step it was made at.
+  arma::vec biasUpdates;
+};
+
+} // namespace perceptron
+} // namespace mlpack
+
+#endif
@@ -55,6 +55,51 @@ class SimpleWeightUpdate
     weights.col(correctClass) += instanceWeight * trainingPoint;
     biases(correctClass) += instanceWeight;
   }
+
+  /**
+   * Update the weights for a sparse point (a column of an arma::sp_mat).  Only
+   * the weights of the nonzero dimensions of the point are touched, so this
+   * takes O(nnz) time instead of O(d).
+   *
+   * @param trainingPoint Point that was misclassified.
+   * @param weights Matrix of weights.
+   * @param biases Vector of biases.
+   * @param incorrectClass Index of class that the point was incorrectly
+   *      classified as.
+   * @param correctClass Index of the true class of the point.
+   * @param instanceWeight Weight to be given to this particular point during
+   *      training (this is useful for boosting).
+   */
+  template<typename eT>
+  void UpdateWeights(const arma::SpSubview<eT>& trainingPoint,
+                     arma::mat& weights,
+                     arma::vec& biases,
+                     const size_t incorrectClass,
+                     const size_t correctClass,
+                     const double instanceWeight = 1.0)
+  {
+    for (typename arma::SpSubview<eT>::const_iterator it =
+        trainingPoint.begin(); it != trainingPoint.end(); ++it)
+    {
+      weights(it.row(), incorrectClass) -= instanceWeight * (*it);
+      weights(it.row(), correctClass) += instanceWeight * (*it);
+    }
+
+    biases(incorrectClass) -= instanceWeight;
+    biases(correctClass) += instanceWeight;
+  }
+
+  /**
+   * This is called after each training point has been seen, whether or not it
+   * was classified correctly.  The simple update rule does not need it.
+   */
+  void Step() { }
+
+  /**
+   * This is called once training is done, to give the final weights and
+   * biases.  The simple update rule leaves them as they are.
+   */
+  void Finish(arma::mat& /* weights */, arma::vec& /* biases */) { }
 };
 
 } // namespace perceptron
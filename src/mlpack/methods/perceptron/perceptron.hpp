@@ -12,6 +12,7 @@
 #include "initialization_methods/zero_init.hpp"
 #include "initialization_methods/random_init.hpp"
 #include "learning_policies/simple_weight_update.hpp"
+#include "learning_policies/averaged_weight_update.hpp"
 
 namespace mlpack {
 namespace perceptron {
@@ -21,9 +22,19 @@ namespace perceptron {
  * network).  It converges if the supplied training dataset is linearly
  * separable.
  *
- * @tparam LearnPolicy Options of SimpleWeightUpdate and GradientDescent.
+ * The data may be dense (arma::mat) or sparse (arma::sp_mat); with sparse data,
+ * the scores and the weight updates for each point take time proportional to
+ * the number of nonzero elements of the point, not to the dimensionality.
+ *
+ * A learning policy must implement UpdateWeights() (see SimpleWeightUpdate),
+ * which is called for each misclassified point, Step(), which is called after
+ * each point, and Finish(), which is called with the weights once training is
+ * done.
+ *
+ * @tparam LearnPolicy Options of SimpleWeightUpdate and AveragedWeightUpdate.
  * @tparam WeightInitializationPolicy Option of ZeroInitialization and
  *      RandomInitialization.
+ * @tparam MatType Type of data (arma::mat or arma::sp_mat).
  */
 template<typename LearnPolicy = SimpleWeightUpdate,
          typename WeightInitializationPolicy = ZeroInitialization,
@@ -97,6 +108,46 @@ class Perceptron
              const arma::Row<size_t>& labels,
              const arma::rowvec& instanceWeights = arma::rowvec());
 
+  /**
+   * Train the perceptron in parallel with iterative parameter mixing, for up to
+   * the maximum number of iterations.  The dataset is split into numShards
+   * contiguous shards; in each iteration, a copy of the model is trained on
+   * each shard for one pass independently (in parallel, if mlpack is compiled
+   * with OpenMP), and then the model is set to the average of the copies,
+   * weighted by the number of points in each shard.  Training stops when no
+   * shard makes a mistake in an iteration.  As with the serial perceptron, this
+   * converges if the dataset is linearly separable.  For more information, see
+   * the following paper:
+   *
+   * @code
+   * @inproceedings{mcdonald2010distributed,
+   *   title={Distributed training strategies for the structured perceptron},
+   *   author={McDonald, R. and Hall, K. and Mann, G.},
+   *   booktitle={Human Language Technologies: The 2010 Annual Conference of
+   *       the North American Chapter of the Association for Computational
+   *       Linguistics},
+   *   pages={456--464},
+   *   year={2010}
+   * }
+   * @endcode
+   *
+   * The learning policy is applied on each shard separately, so with the
+   * AveragedWeightUpdate policy each copy is averaged over its pass before the
+   * copies are mixed.  Shuffle the data first if it is ordered by class, since
+   * a shard holding only one class learns little.
+   *
+   * @param data Dataset on which training should be performed.
+   * @param labels Labels of the dataset.
+   * @param instanceWeights Cost matrix. Stores the cost of mispredicting
+   *      instances.  This is useful for boosting.
+   * @param numShards Number of shards to split the data into; if 0, the number
+   *      of OpenMP threads is used.
+   */
+  void ParallelTrain(const MatType& data,
+                     const arma::Row<size_t>& labels,
+                     const arma::rowvec& instanceWeights = arma::rowvec(),
+                     const size_t numShards = 0);
+
   /**
    * Classification function. After training, use the weights matrix to
    * classify test, and put the predicted classes in predictedLabels.
@@ -145,6 +196,36 @@ private:
 
   //! The biases for each class.
   arma::vec biases;
+
+  /**
+   * Make one pass over the given range of points with the given weights and
+   * biases, updating them with the learning policy for each misclassified
+   * point.  Returns true if no point was misclassified.
+   */
+  static bool TrainPass(const MatType& data,
+                        const arma::Row<size_t>& labels,
+                        const arma::rowvec& instanceWeights,
+                        const size_t begin,
+                        const size_t end,
+                        arma::mat& passWeights,
+                        arma::vec& passBiases,
+                        LearnPolicy& learnPolicy);
+
+  //! Compute the score of each class for a dense point.
+  template<typename eT>
+  static void ClassScores(const arma::Mat<eT>& data,
+                          const size_t point,
+                          const arma::mat& weights,
+                          const arma::vec& biases,
+                          arma::vec& scores);
+
+  //! Compute the score of each class for a sparse point, in O(nnz) time.
+  template<typename eT>
+  static void ClassScores(const arma::SpMat<eT>& data,
+                          const size_t point,
+                          const arma::mat& weights,
+                          const arma::vec& biases,
+                          arma::vec& scores);
 };
 
 } // namespace perceptron
@@ -9,6 +9,10 @@
 
 #include "perceptron.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 namespace mlpack {
 namespace perceptron {
 
@@ -107,14 +111,13 @@ void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Classify(
     const MatType& test,
     arma::Row<size_t>& predictedLabels)
 {
-  arma::vec tempLabelMat;
+  arma::vec scores;
   arma::uword maxIndex;
 
-  // Could probably be faster if done in batch.
   for (size_t i = 0; i < test.n_cols; i++)
   {
-    tempLabelMat = weights.t() * test.col(i) + biases;
-    tempLabelMat.max(maxIndex);
+    ClassScores(test, i, weights, biases, scores);
+    scores.max(maxIndex);
     predictedLabels(0, i) = maxIndex;
   }
 }
@@ -138,50 +141,190 @@ void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::Train(
     const arma::Row<size_t>& labels,
     const arma::rowvec& instanceWeights)
 {
-  size_t j, i = 0;
+  size_t i = 0;
   bool converged = false;
-  size_t tempLabel;
-  arma::uword maxIndexRow, maxIndexCol;
-  arma::mat tempLabelMat;
 
   LearnPolicy LP;
 
-  const bool hasWeights = (instanceWeights.n_elem > 0);
-
   while ((i < maxIterations) && (!converged))
   {
     // This outer loop is for each iteration, and we use the 'converged'
     // variable for noting whether or not convergence has been reached.
+    i++;
+    converged = TrainPass(data, labels, instanceWeights, 0, data.n_cols,
+        weights, biases, LP);
+  }
+
+  LP.Finish(weights, biases);
+}
+
+/**
+ * Parallel training function, with iterative parameter mixing.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::
+ParallelTrain(const MatType& data,
+              const arma::Row<size_t>& labels,
+              const arma::rowvec& instanceWeights,
+              const size_t numShards)
+{
+  if (data.n_cols == 0)
+    return; // Nothing to do.
+
+#ifdef _OPENMP
+  size_t shards = (numShards == 0) ? (size_t) omp_get_max_threads() :
+      numShards;
+#else
+  size_t shards = (numShards == 0) ? 1 : numShards;
+#endif
+  shards = std::max((size_t) 1, std::min(shards, (size_t) data.n_cols));
+
+  size_t i = 0;
+  bool converged = false;
+
+  while ((i < maxIterations) && (!converged))
+  {
     i++;
     converged = true;
 
-    // Now this inner loop is for going through the dataset in each iteration.
-    for (j = 0; j < data.n_cols; j++)
+    arma::mat mixedWeights(arma::zeros<arma::mat>(weights.n_rows,
+        weights.n_cols));
+    arma::vec mixedBiases(arma::zeros<arma::vec>(biases.n_elem));
+
+    // Each shard starts from the current model.  The copies are mixed in the
+    // order of the shards so that the result does not depend on the schedule.
+    std::vector<arma::mat> shardWeights(shards, weights);
+    std::vector<arma::vec> shardBiases(shards, biases);
+    std::vector<char> shardConverged(shards);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (size_t s = 0; s < shards; ++s)
     {
-      // Multiply for each variable and check whether the current weight vector
-      // correctly classifies this.
-      tempLabelMat = weights.t() * data.col(j) + biases;
+      const size_t begin = (s * data.n_cols) / shards;
+      const size_t end = ((s + 1) * data.n_cols) / shards;
 
-      tempLabelMat.max(maxIndexRow, maxIndexCol);
+      LearnPolicy LP;
+      shardConverged[s] = TrainPass(data, labels, instanceWeights, begin, end,
+          shardWeights[s], shardBiases[s], LP);
+      LP.Finish(shardWeights[s], shardBiases[s]);
+    }
 
-      // Check whether prediction is correct.
-      if (maxIndexRow != labels(0, j))
-      {
-        // Due to incorrect prediction, convergence set to false.
+    for (size_t s = 0; s < shards; ++s)
+    {
+      const double fraction = double(((s + 1) * data.n_cols) / shards -
+          (s * data.n_cols) / shards) / data.n_cols;
+      mixedWeights += fraction * shardWeights[s];
+      mixedBiases += fraction * shardBiases[s];
+      if (!shardConverged[s])
         converged = false;
-        tempLabel = labels(0, j);
-
-        // Send maxIndexRow for knowing which weight to update, send j to know
-        // the value of the vector to update it with.  Send tempLabel to know
-        // the correct class.
-        if (hasWeights)
-          LP.UpdateWeights(data.col(j), weights, biases, maxIndexRow, tempLabel,
-              instanceWeights(j));
-        else
-          LP.UpdateWeights(data.col(j), weights, biases, maxIndexRow,
-              tempLabel);
-      }
     }
+
+    // If no shard made a mistake, every copy is the same as the current model.
+    if (!converged)
+    {
+      weights = mixedWeights;
+      biases = mixedBiases;
+    }
+  }
+}
+
+/**
+ * Make one pass over the points [begin, end) of the dataset.
+ */
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+bool Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::TrainPass(
+    const MatType& data,
+    const arma::Row<size_t>& labels,
+    const arma::rowvec& instanceWeights,
+    const size_t begin,
+    const size_t end,
+    arma::mat& passWeights,
+    arma::vec& passBiases,
+    LearnPolicy& learnPolicy)
+{
+  bool converged = true;
+  size_t tempLabel;
+  arma::uword maxIndexRow;
+  arma::vec scores;
+
+  const bool hasWeights = (instanceWeights.n_elem > 0);
+
+  for (size_t j = begin; j < end; j++)
+  {
+    // Multiply for each variable and check whether the current weight vector
+    // correctly classifies this.
+    ClassScores(data, j, passWeights, passBiases, scores);
+    scores.max(maxIndexRow);
+
+    // Check whether prediction is correct.
+    if (maxIndexRow != labels(0, j))
+    {
+      // Due to incorrect prediction, convergence set to false.
+      converged = false;
+      tempLabel = labels(0, j);
+
+      // Send maxIndexRow for knowing which weight to update, send j to know
+      // the value of the vector to update it with.  Send tempLabel to know the
+      // correct class.
+      if (hasWeights)
+        learnPolicy.UpdateWeights(data.col(j), passWeights, passBiases,
+            maxIndexRow, tempLabel, instanceWeights(j));
+      else
+        learnPolicy.UpdateWeights(data.col(j), passWeights, passBiases,
+            maxIndexRow, tempLabel);
+    }
+
+    learnPolicy.Step();
+  }
+
+  return converged;
+}
+
+//! Compute the class scores of a dense point.
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+template<typename eT>
+void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::ClassScores(
+    const arma::Mat<eT>& data,
+    const size_t point,
+    const arma::mat& weights,
+    const arma::vec& biases,
+    arma::vec& scores)
+{
+  scores = weights.t() * data.col(point) + biases;
+}
+
+//! Compute the class scores of a sparse point, using only its nonzeros.
+template<
+    typename LearnPolicy,
+    typename WeightInitializationPolicy,
+    typename MatType
+>
+template<typename eT>
+void Perceptron<LearnPolicy, WeightInitializationPolicy, MatType>::ClassScores(
+    const arma::SpMat<eT>& data,
+    const size_t point,
+    const arma::mat& weights,
+    const arma::vec& biases,
+    arma::vec& scores)
+{
+  scores = biases;
+  for (typename arma::SpMat<eT>::const_iterator it = data.begin_col(point);
+      it != data.end_col(point); ++it)
+  {
+    for (size_t c = 0; c < weights.n_cols; ++c)
+      scores[c] += (*it) * weights(it.row(), c);
   }
 }
 
@@ -0,0 +1,99 @@
+/**
+ * @file matrix_store.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the MatrixStore class.
+ */
+#include "matrix_store.hpp"
+
+#include <mlpack/core/data/extension.hpp>
+
+using namespace mlpack;
+using namespace mlpack::pipeline;
+
+bool MatrixStore::IsFile(const std::string& name)
+{
+  return !data::Extension(name).empty();
+}
+
+// Get the matrix with the given name from the given map, loading it if it is
+// a file; otherMap holds the matrices of the other kind.
+template<typename MatType, typename OtherMatType>
+static const MatType& Get(std::map<std::string, MatType>& map,
+                          const std::map<std::string, OtherMatType>& otherMap,
+                          const std::string& name,
+                          const std::string& function)
+{
+  typename std::map<std::string, MatType>::iterator it = map.find(name);
+  if (it != map.end())
+    return it->second;
+
+  if (MatrixStore::IsFile(name))
+  {
+    MatType matrix;
+    if (!data::Load(name, matrix))
+    {
+      std::ostringstream oss;
+      oss << "MatrixStore::" << function << "(): cannot load '" << name << "'";
+      throw std::runtime_error(oss.str());
+    }
+
+    MatType& stored = map[name];
+    stored = std::move(matrix);
+    return stored;
+  }
+
+  std::ostringstream oss;
+  oss << "MatrixStore::" << function << "(): ";
+  if (otherMap.count(name) != 0)
+    oss << "'" << name << "' holds a matrix of the other kind";
+  else
+    oss << "there is no matrix '" << name << "'";
+  throw std::invalid_argument(oss.str());
+}
+
+// Store the given matrix in the given map, saving it if the name is a file,
+// and remove any matrix of the other kind with the same name.
+template<typename MatType, typename OtherMatType>
+static void Put(std::map<std::string, MatType>& map,
+                std::map<std::string, OtherMatType>& otherMap,
+                const std::string& name,
+                MatType&& matrix)
+{
+  if (MatrixStore::IsFile(name) && !data::Save(name, matrix))
+  {
+    std::ostringstream oss;
+    oss << "MatrixStore::Store(): cannot save '" << name << "'";
+    throw std::runtime_error(oss.str());
+  }
+
+  otherMap.erase(name);
+  map[name] = std::move(matrix);
+}
+
+const arma::mat& MatrixStore::Matrix(const std::string& name)
+{
+  return Get(matrices, indices, name, "Matrix");
+}
+
+const arma::Mat<size_t>& MatrixStore::Indices(const std::string& name)
+{
+  return Get(indices, matrices, name, "Indices");
+}
+
+void MatrixStore::Store(const std::string& name, arma::mat&& matrix)
+{
+  Put(matrices, indices, name, std::move(matrix));
+}
+
+void MatrixStore::Store(const std::string& name, arma::Mat<size_t>&& matrix)
+{
+  Put(indices, matrices, name, std::move(matrix));
+}
+
+void MatrixStore::Clear()
+{
+  matrices.clear();
+  indices.clear();
+  models.clear();
+}
@@ -0,0 +1,186 @@
+/**
+ * @file matrix_store.hpp
+ * @author Ryan Curtin
+ *
+ * Definition of the MatrixStore class, which holds the matrices and models
+ * that the stages of a pipeline pass to each other, by name.
+ */
+#ifndef __MLPACK_METHODS_PIPELINE_MATRIX_STORE_HPP
+#define __MLPACK_METHODS_PIPELINE_MATRIX_STORE_HPP
+
+#include <mlpack/core.hpp>
+#include <boost/any.hpp>
+
+#include <memory>
+
+namespace mlpack {
+namespace pipeline /** Pipelines of mlpack programs run in one process. */ {
+
+/**
+ * A store of named matrices and models, which the stages of a pipeline (see
+ * RunPipeline()) read their inputs from and write their results to.  A name
+ * with an extension (such as "data.csv") is a file: the matrix is loaded from
+ * it the first time it is read (with data::Load(), so one point per row of
+ * the file) and kept in the store, and a matrix written to it is saved to it
+ * (with data::Save()).  Any other name (such as "reduced") is only held in
+ * memory, so passing a matrix from one stage to the next takes no parsing or
+ * formatting at all.
+ *
+ * Real-valued matrices (datasets, centroids, distances) and index matrices
+ * (assignments, neighbors) are held separately; a name may only be read as
+ * the kind of matrix it holds.  Models are held by shared pointer, and can
+ * only be in memory.
+ *
+ * @code
+ * MatrixStore store;
+ * const arma::mat& dataset = store.Matrix("dataset.csv"); // Loaded.
+ * arma::mat centered = dataset.each_col() - arma::mean(dataset, 1);
+ * store.Store("centered", std::move(centered)); // Only in memory.
+ * store.Store("centered.csv", arma::mat(store.Matrix("centered"))); // Saved.
+ * @endcode
+ */
+class MatrixStore
+{
+ public:
+  //! Create an empty store.
+  MatrixStore() { }
+
+  //! Return whether the given name is a file (that is, it has an extension).
+  static bool IsFile(const std::string& name);
+
+  /**
+   * Get the real-valued matrix with the given name; if the name is a file that
+   * has not been read yet, it is loaded.  The reference is valid until a
+   * matrix with the same name is stored, or the store is destroyed.
+   *
+   * @param name Name of the matrix.
+   * @throw std::invalid_argument if there is no such matrix.
+   * @throw std::runtime_error if the file cannot be loaded.
+   */
+  const arma::mat& Matrix(const std::string& name);
+
+  /**
+   * Get the index matrix with the given name; if the name is a file that has
+   * not been read yet, it is loaded.  The reference is valid until a matrix
+   * with the same name is stored, or the store is destroyed.
+   *
+   * @param name Name of the matrix.
+   * @throw std::invalid_argument if there is no such matrix.
+   * @throw std::runtime_error if the file cannot be loaded.
+   */
+  const arma::Mat<size_t>& Indices(const std::string& name);
+
+  /**
+   * Store the given real-valued matrix with the given name, and save it if the
+   * name is a file.  The matrix is moved into the store.
+   *
+   * @param name Name of the matrix.
+   * @param matrix Matrix to store.
+   * @throw std::runtime_error if the file cannot be saved.
+   */
+  void Store(const std::string& name, arma::mat&& matrix);
+
+  /**
+   * Store the given index matrix with the given name, and save it if the name
+   * is a file.  The matrix is moved into the store.
+   *
+   * @param name Name of the matrix.
+   * @param matrix Matrix to store.
+   * @throw std::runtime_error if the file cannot be saved.
+   */
+  void Store(const std::string& name, arma::Mat<size_t>&& matrix);
+
+  //! Return whether a real-valued matrix with the given name is held.
+  bool HasMatrix(const std::string& name) const
+  {
+    return (matrices.count(name) != 0);
+  }
+
+  //! Return whether an index matrix with the given name is held.
+  bool HasIndices(const std::string& name) const
+  {
+    return (indices.count(name) != 0);
+  }
+
+  /**
+   * Get the model with the given name.
+   *
+   * @tparam ModelType Type of the model.
+   * @param name Name of the model.
+   * @throw std::invalid_argument if there is no such model, or it has another
+   *     type.
+   */
+  template<typename ModelType>
+  ModelType& Model(const std::string& name);
+
+  /**
+   * Store the given model with the given name.  Models are only held in
+   * memory, so the name must not be a file.
+   *
+   * @param name Name of the model.
+   * @param model Model to store.
+   * @throw std::invalid_argument if the name is a file.
+   */
+  template<typename ModelType>
+  void StoreModel(const std::string& name, std::shared_ptr<ModelType> model);
+
+  //! Return whether a model with the given name is held.
+  bool HasModel(const std::string& name) const
+  {
+    return (models.count(name) != 0);
+  }
+
+  //! Remove every matrix and model from the store.
+  void Clear();
+
+ private:
+  //! The real-valued matrices, by name.
+  std::map<std::string, arma::mat> matrices;
+  //! The index matrices, by name.
+  std::map<std::string, arma::Mat<size_t>> indices;
+  //! The models (each a std::shared_ptr to the model), by name.
+  std::map<std::string, boost::any> models;
+};
+
+template<typename ModelType>
+ModelType& MatrixStore::Model(const std::string& name)
+{
+  std::map<std::string, boost::any>::iterator it = models.find(name);
+  if (it == models.end())
+  {
+    std::ostringstream oss;
+    oss << "MatrixStore::Model(): there is no model '" << name << "'";
+    throw std::invalid_argument(oss.str());
+  }
+
+  std::shared_ptr<ModelType>* model =
+      boost::any_cast<std::shared_ptr<ModelType>>(&it->second);
+  if (model == NULL)
+  {
+    std::ostringstream oss;
+    oss << "MatrixStore::Model(): model '" << name << "' has another type";
+    throw std::invalid_argument(oss.str());
+  }
+
+  return **model;
+}
+
+template<typename ModelType>
+void MatrixStore::StoreModel(const std::string& name,
+                             std::shared_ptr<ModelType> model)
+{
+  if (IsFile(name))
+  {
+    std::ostringstream oss;
+    oss << "MatrixStore::StoreModel(): models are only held in memory, so "
+        << "'" << name << "' cannot be a file";
+    throw std::invalid_argument(oss.str());
+  }
+
+  models[name] = model;
+}
+
+} // namespace pipeline
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,277 @@
+/**
+ * @file pipeline.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the stages of a pipeline.
+ */
+#include "pipeline.hpp"
+
+#include <mlpack/methods/pca/pca.hpp>
+#include <mlpack/methods/kmeans/kmeans.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <boost/program_options.hpp>
+
+using namespace mlpack;
+using namespace mlpack::pipeline;
+
+namespace po = boost::program_options;
+
+// Parse the options of the given stage.
+static po::variables_map ParseStage(const std::vector<std::string>& args,
+                                    const po::options_description& options)
+{
+  po::variables_map vm;
+  try
+  {
+    const std::vector<std::string> stageArgs(args.begin() + 1, args.end());
+    po::store(po::command_line_parser(stageArgs).options(options).run(), vm);
+    po::notify(vm);
+  }
+  catch (po::error& e)
+  {
+    std::ostringstream oss;
+    oss << "RunStage(): " << args[0] << ": " << e.what();
+    throw std::invalid_argument(oss.str());
+  }
+
+  return vm;
+}
+
+// Throw an error for the given stage.
+static void StageError(const std::string& stage, const std::string& message)
+{
+  std::ostringstream oss;
+  oss << "RunStage(): " << stage << ": " << message;
+  throw std::invalid_argument(oss.str());
+}
+
+static void PCAStage(const std::vector<std::string>& args, MatrixStore& store)
+{
+  po::options_description options("pca");
+  options.add_options()
+      ("input,i", po::value<std::string>()->required(), "Input dataset.")
+      ("output,o", po::value<std::string>()->required(), "Output dataset.")
+      ("new_dimensionality,d", po::value<int>()->default_value(0),
+          "Desired dimensionality (0 means no reduction).")
+      ("var_to_retain,V", po::value<double>()->default_value(0.0),
+          "Amount of variance to retain; overrides -d.")
+      ("scale,s", po::bool_switch(), "Scale the data first.")
+      ("randomized,r", po::bool_switch(), "Use a randomized SVD.");
+  const po::variables_map vm = ParseStage(args, options);
+
+  arma::mat dataset(store.Matrix(vm["input"].as<std::string>()));
+
+  const int newDimensionality = vm["new_dimensionality"].as<int>();
+  const double varToRetain = vm["var_to_retain"].as<double>();
+  if (newDimensionality < 0 || (size_t) newDimensionality > dataset.n_rows)
+  {
+    std::ostringstream oss;
+    oss << "new dimensionality (" << newDimensionality << ") must be between "
+        << "0 and the dimensionality of the dataset (" << dataset.n_rows << ")";
+    StageError(args[0], oss.str());
+  }
+  if (varToRetain < 0.0 || varToRetain > 1.0)
+    StageError(args[0], "variance to retain must be between 0 and 1");
+
+  Timer::Start("pca");
+  pca::PCA p(vm["scale"].as<bool>(), vm["randomized"].as<bool>());
+  double varRetained;
+  if (varToRetain != 0.0)
+    varRetained = p.Apply(dataset, varToRetain);
+  else if (newDimensionality != 0)
+    varRetained = p.Apply(dataset, (size_t) newDimensionality);
+  else
+    varRetained = p.Apply(dataset, (size_t) dataset.n_rows);
+  Timer::Stop("pca");
+
+  Log::Info << "pca: " << (varRetained * 100) << "% of variance retained ("
+      << dataset.n_rows << " dimensions)." << std::endl;
+
+  store.Store(vm["output"].as<std::string>(), std::move(dataset));
+}
+
+static void KMeansStage(const std::vector<std::string>& args,
+                        MatrixStore& store)
+{
+  po::options_description options("kmeans");
+  options.add_options()
+      ("input,i", po::value<std::string>()->required(), "Input dataset.")
+      ("clusters,c", po::value<int>()->required(), "Number of clusters.")
+      ("output,o", po::value<std::string>(), "Cluster assignments.")
+      ("centroids,C", po::value<std::string>(), "Centroids.")
+      ("max_iterations,m", po::value<int>()->default_value(1000),
+          "Maximum number of iterations (0 means no limit).");
+  const po::variables_map vm = ParseStage(args, options);
+
+  if (!vm.count("output") && !vm.count("centroids"))
+    StageError(args[0], "at least one of --output and --centroids must be "
+        "given");
+
+  const arma::mat& dataset = store.Matrix(vm["input"].as<std::string>());
+  const int clusters = vm["clusters"].as<int>();
+  if (clusters < 1 || (size_t) clusters > dataset.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "number of clusters (" << clusters << ") must be between 1 and "
+        << "the number of points (" << dataset.n_cols << ")";
+    StageError(args[0], oss.str());
+  }
+  if (vm["max_iterations"].as<int>() < 0)
+    StageError(args[0], "maximum number of iterations must not be negative");
+
+  Timer::Start("kmeans");
+  kmeans::KMeans<> k((size_t) vm["max_iterations"].as<int>());
+  arma::Col<size_t> assignments;
+  arma::mat centroids;
+  k.Cluster(dataset, (size_t) clusters, assignments, centroids);
+  Timer::Stop("kmeans");
+
+  if (vm.count("output"))
+  {
+    arma::Mat<size_t> output = arma::trans(assignments);
+    store.Store(vm["output"].as<std::string>(), std::move(output));
+  }
+  if (vm.count("centroids"))
+    store.Store(vm["centroids"].as<std::string>(), std::move(centroids));
+}
+
+static void AllkNNStage(const std::vector<std::string>& args,
+                        MatrixStore& store)
+{
+  po::options_description options("allknn");
+  options.add_options()
+      ("reference,r", po::value<std::string>(), "Reference dataset.")
+      ("input_model,m", po::value<std::string>(), "Model to search with.")
+      ("query,q", po::value<std::string>(), "Query dataset.")
+      ("k,k", po::value<int>()->required(), "Number of nearest neighbors.")
+      ("neighbors,n", po::value<std::string>(), "Neighbors.")
+      ("distances,d", po::value<std::string>(), "Distances.")
+      ("naive,N", po::bool_switch(), "Use brute-force search.")
+      ("single_mode,S", po::bool_switch(), "Use single-tree search.")
+      ("output_model,M", po::value<std::string>(), "Model to store.");
+  const po::variables_map vm = ParseStage(args, options);
+
+  if (vm.count("reference") == vm.count("input_model"))
+    StageError(args[0], "exactly one of --reference and --input_model must be "
+        "given");
+  if (vm.count("input_model") && vm.count("output_model"))
+    StageError(args[0], "--output_model cannot be given with --input_model");
+
+  // A model given with --input_model is already in the store; otherwise a new
+  // one is built.
+  typedef neighbor::AllkNN ModelType;
+  std::shared_ptr<ModelType> built;
+  ModelType* model;
+  if (vm.count("input_model"))
+  {
+    model = &store.Model<ModelType>(vm["input_model"].as<std::string>());
+  }
+  else
+  {
+    // The model gets its own copy of the reference set; in naive mode it would
+    // otherwise point at the store's matrix, which a later stage may replace.
+    Timer::Start("tree_building");
+    built = std::make_shared<ModelType>(arma::mat(store.Matrix(
+        vm["reference"].as<std::string>())), vm["naive"].as<bool>(),
+        vm["single_mode"].as<bool>());
+    Timer::Stop("tree_building");
+    model = built.get();
+  }
+
+  const int k = vm["k"].as<int>();
+  if (k < 1 || (size_t) k > model->ReferenceSet().n_cols)
+  {
+    std::ostringstream oss;
+    oss << "k (" << k << ") must be between 1 and the number of reference "
+        << "points (" << model->ReferenceSet().n_cols << ")";
+    StageError(args[0], oss.str());
+  }
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  Timer::Start("computing_neighbors");
+  if (vm.count("query"))
+  {
+    model->Search(store.Matrix(vm["query"].as<std::string>()), (size_t) k,
+        neighbors, distances);
+  }
+  else
+  {
+    model->Search((size_t) k, neighbors, distances);
+  }
+  Timer::Stop("computing_neighbors");
+
+  if (vm.count("neighbors"))
+    store.Store(vm["neighbors"].as<std::string>(), std::move(neighbors));
+  if (vm.count("distances"))
+    store.Store(vm["distances"].as<std::string>(), std::move(distances));
+
+  if (vm.count("output_model"))
+    store.StoreModel(vm["output_model"].as<std::string>(), built);
+}
+
+static void SaveStage(const std::vector<std::string>& args, MatrixStore& store)
+{
+  po::options_description options("save");
+  options.add_options()
+      ("input,i", po::value<std::string>()->required(), "Matrix to copy.")
+      ("output,o", po::value<std::string>()->required(), "Copy.");
+  const po::variables_map vm = ParseStage(args, options);
+
+  const std::string input = vm["input"].as<std::string>();
+  const std::string output = vm["output"].as<std::string>();
+  if (store.HasIndices(input))
+    store.Store(output, arma::Mat<size_t>(store.Indices(input)));
+  else
+    store.Store(output, arma::mat(store.Matrix(input)));
+}
+
+void mlpack::pipeline::RunStage(const std::vector<std::string>& args,
+                                MatrixStore& store)
+{
+  if (args.empty())
+    throw std::invalid_argument("RunStage(): no stage given");
+
+  if (args[0] == "pca")
+    PCAStage(args, store);
+  else if (args[0] == "kmeans")
+    KMeansStage(args, store);
+  else if (args[0] == "allknn")
+    AllkNNStage(args, store);
+  else if (args[0] == "save")
+    SaveStage(args, store);
+  else
+    StageError(args[0], "unknown stage (must be 'pca', 'kmeans', 'allknn', or "
+        "'save')");
+}
+
+void mlpack::pipeline::RunPipeline(std::istream& stream, MatrixStore& store)
+{
+  std::string line;
+  size_t lineNumber = 0;
+  while (std::getline(stream, line))
+  {
+    ++lineNumber;
+
+    std::istringstream lineStream(line);
+    std::vector<std::string> args;
+    std::string arg;
+    while (lineStream >> arg)
+      args.push_back(arg);
+    if (args.empty() || args[0][0] == '#')
+      continue;
+
+    Log::Info << "Running stage on line " << lineNumber << " (" << args[0]
+        << ")." << std::endl;
+    try
+    {
+      RunStage(args, store);
+    }
+    catch (std::exception& e)
+    {
+      std::ostringstream oss;
+      oss << "RunPipeline(): line " << lineNumber << ": " << e.what();
+      throw std::runtime_error(oss.str());
+    }
+  }
+}
@@ -0,0 +1,65 @@
+/**
+ * @file pipeline.hpp
+ * @author Ryan Curtin
+ *
+ * RunStage() and RunPipeline(), which run several mlpack stages (PCA, k-means,
+ * k-nearest-neighbor search) one after the other in one process, passing
+ * their results to each other through a MatrixStore.
+ */
+#ifndef __MLPACK_METHODS_PIPELINE_PIPELINE_HPP
+#define __MLPACK_METHODS_PIPELINE_PIPELINE_HPP
+
+#include <mlpack/core.hpp>
+#include "matrix_store.hpp"
+
+namespace mlpack {
+namespace pipeline {
+
+/**
+ * Run one stage of a pipeline.  The first argument is the name of the stage,
+ * and the others are its options, given as on the command line of the
+ * program of the same name (for instance { "pca", "-i", "dataset.csv",
+ * "-o", "reduced", "-d", "2" }).  The matrices and models the stage reads and
+ * writes are named by its options, and are taken from and put into the
+ * store; see MatrixStore for which names are files.  The stages are:
+ *
+ *  - pca: --input (-i), --output (-o), --new_dimensionality (-d),
+ *    --var_to_retain (-V), --scale (-s), --randomized (-r).
+ *  - kmeans: --input (-i), --clusters (-c), --output (-o; the assignments, as
+ *    a row of indices), --centroids (-C), --max_iterations (-m).
+ *  - allknn: --reference (-r) or --input_model (-m), --query (-q), --k (-k),
+ *    --neighbors (-n), --distances (-d), --naive (-N), --single_mode (-S),
+ *    --output_model (-M).  A model holds the reference tree, so later
+ *    searches of the same reference set do not build it again.
+ *  - save: --input (-i), --output (-o); copy a matrix, for instance from
+ *    memory to a file.
+ *
+ * @param args Name and options of the stage.
+ * @param store Store of the matrices and models of the pipeline.
+ * @throw std::invalid_argument if the stage or its options are invalid.
+ */
+void RunStage(const std::vector<std::string>& args, MatrixStore& store);
+
+/**
+ * Run the stages of the given pipeline, one after the other, with
+ * RunStage().  Each line of the stream is one stage: the name of the stage
+ * and its options, separated by whitespace.  Empty lines and lines starting
+ * with '#' are skipped.
+ *
+ * @code
+ * # pipeline.txt: reduce, cluster, and find the neighbors of the centroids.
+ * pca -i dataset.csv -o reduced -d 2
+ * kmeans -i reduced -c 10 -o assignments.csv -C centroids
+ * allknn -r reduced -q centroids -k 5 -n neighbors.csv
+ * @endcode
+ *
+ * @param stream Stream to read the stages from.
+ * @param store Store of the matrices and models of the pipeline.
+ * @throw std::runtime_error if a stage fails; the message gives the line.
+ */
+void RunPipeline(std::istream& stream, MatrixStore& store);
+
+} // namespace pipeline
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * @file pipeline_main.cpp
+ * @author Ryan Curtin
+ *
+ * Run several mlpack stages (PCA, k-means, k-nearest-neighbor search) in one
+ * process, passing the matrices between them in memory.
+ */
+#include <mlpack/core.hpp>
+#include "pipeline.hpp"
+
+#include <algorithm>
+
+using namespace mlpack;
+using namespace mlpack::pipeline;
+using namespace std;
+
+PROGRAM_INFO("Pipeline", "This program runs several stages, one after the "
+    "other, in one process: 'pca', 'kmeans', 'allknn', and 'save'.  Each stage "
+    "takes options like those of the program of the same name, and its inputs "
+    "and outputs are named by those options.  A name with an extension (like "
+    "'dataset.csv') is a file, which is loaded when it is first read and saved "
+    "when it is written; any other name (like 'reduced') is a matrix held in "
+    "memory, so passing it to the next stage takes no saving or loading at "
+    "all.  A k-nearest-neighbor model (with its tree) can also be held in "
+    "memory, with --output_model, and searched again by a later stage, with "
+    "--input_model."
+    "\n\n"
+    "The stages are given either in a file (--pipeline_file), one stage per "
+    "line (lines starting with '#' are skipped), or on the command line "
+    "(--pipeline), separated by ';'.  For instance:"
+    "\n\n"
+    "  pipeline -P \"pca -i dataset.csv -o reduced -d 2; kmeans -i reduced "
+    "-c 10 -C centroids; allknn -r reduced -q centroids -k 5 -n "
+    "neighbors.csv\""
+    "\n\n"
+    "The options of the stages are:"
+    "\n\n"
+    "  pca: --input (-i), --output (-o), --new_dimensionality (-d), "
+    "--var_to_retain (-V), --scale (-s), --randomized (-r)\n"
+    "  kmeans: --input (-i), --clusters (-c), --output (-o; the assignments), "
+    "--centroids (-C), --max_iterations (-m)\n"
+    "  allknn: --reference (-r) or --input_model (-m), --query (-q), --k (-k), "
+    "--neighbors (-n), --distances (-d), --naive (-N), --single_mode (-S), "
+    "--output_model (-M)\n"
+    "  save: --input (-i), --output (-o)");
+
+PARAM_STRING("pipeline_file", "File containing the stages, one per line.", "p",
+    "");
+PARAM_STRING("pipeline", "Stages, separated by ';'.", "P", "");
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  const string pipelineFile = CLI::GetParam<string>("pipeline_file");
+  string pipeline = CLI::GetParam<string>("pipeline");
+  if (pipelineFile.empty() == pipeline.empty())
+    Log::Fatal << "Exactly one of --pipeline_file (-p) and --pipeline (-P) "
+        << "must be specified!" << endl;
+
+  MatrixStore store;
+  try
+  {
+    if (!pipelineFile.empty())
+    {
+      ifstream stream(pipelineFile.c_str());
+      if (!stream.is_open())
+        Log::Fatal << "Cannot open pipeline file '" << pipelineFile << "'!"
+            << endl;
+      RunPipeline(stream, store);
+    }
+    else
+    {
+      replace(pipeline.begin(), pipeline.end(), ';', '\n');
+      istringstream stream(pipeline);
+      RunPipeline(stream, store);
+    }
+  }
+  catch (std::exception& e)
+  {
+    Log::Fatal << e.what() << endl;
+  }
+}
@@ -44,8 +44,15 @@ namespace svd {
  * // Get the factorization in the constructor.
  * QUIC_SVD(data, u, v, sigma, epsilon, delta);
  * @endcode
+ *
+ * Any dense Armadillo matrix type can be factorized; for instance,
+ * QUIC_SVDType<arma::fmat> factorizes float data, without converting it to
+ * double.
+ *
+ * @tparam MatType Type of matrix to be factorized.
  */
-class QUIC_SVD
+template<typename MatType = arma::mat>
+class QUIC_SVDType
 {
  public:
   /**
@@ -62,12 +69,12 @@ class QUIC_SVD
    * @param epsilon Error tolerance fraction for calculated subspace.
    * @param delta Cumulative probability for Monte Carlo error lower bound.
    */
-  QUIC_SVD(const arma::mat& dataset,
-           arma::mat& u,
-           arma::mat& v,
-           arma::mat& sigma,
-           const double epsilon = 0.03,
-           const double delta = 0.1);
+  QUIC_SVDType(const MatType& dataset,
+               MatType& u,
+               MatType& v,
+               MatType& sigma,
+               const double epsilon = 0.03,
+               const double delta = 0.1);
 
   /**
    * This function uses the vector subspace created using a cosine tree to
@@ -77,17 +84,20 @@ class QUIC_SVD
    * @param v Second unitary matrix.
    * @param sigma Diagonal matrix of singular values.
    */
-  void ExtractSVD(arma::mat& u,
-                  arma::mat& v,
-                  arma::mat& sigma);
+  void ExtractSVD(MatType& u,
+                  MatType& v,
+                  MatType& sigma);
 
  private:
   //! Matrix for which cosine tree is constructed.
-  const arma::mat& dataset;
+  const MatType& dataset;
   //! Subspace basis of the input dataset.
-  arma::mat basis;
+  MatType basis;
 };
 
+//! QUIC-SVD on double data.
+typedef QUIC_SVDType<arma::mat> QUIC_SVD;
+
 }; // namespace svd
 }; // namespace mlpack
 
@@ -15,47 +15,50 @@ using namespace mlpack::tree;
 namespace mlpack {
 namespace svd {
 
-QUIC_SVD::QUIC_SVD(const arma::mat& dataset,
-                   arma::mat& u,
-                   arma::mat& v,
-                   arma::mat& sigma,
-                   const double epsilon,
-                   const double delta) :
+template<typename MatType>
+QUIC_SVDType<MatType>::QUIC_SVDType(const MatType& dataset,
+                                    MatType& u,
+                                    MatType& v,
+                                    MatType& sigma,
+                                    const double epsilon,
+                                    const double delta) :
     dataset(dataset)
 {
   // Since columns are sample in the implementation, the matrix is transposed if
   // necessary for maximum speedup.
-  CosineTree* ctree;
+  CosineTreeType<MatType>* ctree;
   if (dataset.n_cols > dataset.n_rows)
-    ctree = new CosineTree(dataset, epsilon, delta);
+    ctree = new CosineTreeType<MatType>(dataset, epsilon, delta);
   else
-    ctree = new CosineTree(dataset.t(), epsilon, delta);
+    ctree = new CosineTreeType<MatType>(dataset.t(), epsilon, delta);
 
   // Get subspace basis by creating the cosine tree.
   ctree->GetFinalBasis(basis);
+  delete ctree;
 
   // Use the ExtractSVD algorithm mentioned in the paper to extract the SVD of
   // the original dataset in the obtained subspace.
   ExtractSVD(u, v, sigma);
 }
 
-void QUIC_SVD::ExtractSVD(arma::mat& u,
-                          arma::mat& v,
-                          arma::mat& sigma)
+template<typename MatType>
+void QUIC_SVDType<MatType>::ExtractSVD(MatType& u,
+                                       MatType& v,
+                                       MatType& sigma)
 {
   // Calculate A * V_hat, necessary for further calculations.
-  arma::mat projectedMat;
+  MatType projectedMat;
   if (dataset.n_cols > dataset.n_rows)
     projectedMat = dataset.t() * basis;
   else
     projectedMat = dataset * basis;
 
   // Calculate the squared projected matrix.
-  arma::mat projectedMatSquared = projectedMat.t() * projectedMat;
+  MatType projectedMatSquared = projectedMat.t() * projectedMat;
 
   // Calculate the SVD of the above matrix.
-  arma::mat uBar, vBar;
-  arma::vec sigmaBar;
+  MatType uBar, vBar;
+  arma::Col<typename MatType::elem_type> sigmaBar;
   arma::svd(uBar, sigmaBar, vBar, projectedMatSquared);
 
   // Calculate the approximate SVD of the original matrix, using the SVD of the
@@ -68,7 +71,7 @@ void QUIC_SVD::ExtractSVD(arma::mat& u,
   // the transposed matrix is not passed.
   if (dataset.n_cols > dataset.n_rows)
   {
-    arma::mat tempMat = u;
+    MatType tempMat = u;
     u = v;
     v = tempMat;
   }
@@ -38,7 +38,8 @@ void Radical::CopyAndPerturb(mat& xNew, const mat& x) const
 
 double Radical::Vasicek(vec& z) const
 {
-  z = sort(z);
+  // Sort in place, so that no temporary is needed.
+  std::sort(z.begin(), z.end());
 
   // Apparently slower.
   /*
@@ -63,26 +64,33 @@ double Radical::DoRadical2D(const mat& matX)
 {
   CopyAndPerturb(perturbed, matX);
 
-  mat::fixed<2, 2> matJacobi;
+  return SearchAngle(perturbed.unsafe_col(0), perturbed.unsafe_col(1));
+}
 
+double Radical::SearchAngle(const vec& x1, const vec& x2) const
+{
   vec values(angles);
 
-  for (size_t i = 0; i < angles; i++)
+  // The angles are independent, so they are searched in parallel; each thread
+  // rotates the points into its own pair of vectors.
+  #pragma omp parallel
   {
-    const double theta = (i / (double) angles) * M_PI / 2.0;
-    const double cosTheta = cos(theta);
-    const double sinTheta = sin(theta);
+    vec candidateY1(x1.n_elem);
+    vec candidateY2(x1.n_elem);
 
-    matJacobi(0, 0) = cosTheta;
-    matJacobi(1, 0) = -sinTheta;
-    matJacobi(0, 1) = sinTheta;
-    matJacobi(1, 1) = cosTheta;
+    #pragma omp for schedule(static)
+    for (size_t i = 0; i < angles; i++)
+    {
+      const double theta = (i / (double) angles) * M_PI / 2.0;
+      const double cosTheta = cos(theta);
+      const double sinTheta = sin(theta);
 
-    candidate = perturbed * matJacobi;
-    vec candidateY1 = candidate.unsafe_col(0);
-    vec candidateY2 = candidate.unsafe_col(1);
+      // This is the product of the points with the Jacobi rotation matrix.
+      candidateY1 = cosTheta * x1 - sinTheta * x2;
+      candidateY2 = sinTheta * x1 + cosTheta * x2;
 
-    values(i) = Vasicek(candidateY1) + Vasicek(candidateY2);
+      values(i) = Vasicek(candidateY1) + Vasicek(candidateY2);
+    }
   }
 
   uword indOpt;
@@ -125,42 +133,60 @@ void Radical::DoRadical(const mat& matXT, mat& matY, mat& matW)
   Timer::Start("radical_do_radical");
   matW = matWhitening;
 
-  mat matYSubspace(nPoints, 2);
-
-  mat matJ = eye(nDims, nDims);
+  // The pairs of dimensions are scheduled as a round-robin tournament: each
+  // round is a set of disjoint pairs, whose rotations touch different columns
+  // of matY and can therefore be found and applied in parallel.  If the number
+  // of dimensions is odd, one dimension sits out of each round.
+  const size_t nPlayers = nDims + (nDims % 2);
+  std::vector<std::pair<size_t, size_t> > pairs;
 
   for (size_t sweepNum = 0; sweepNum < sweeps; sweepNum++)
   {
     Log::Info << "RADICAL: sweep " << sweepNum << "." << std::endl;
 
-    for (size_t i = 0; i < nDims - 1; i++)
+    // The noise for the replicates is generated once per sweep.
+    Timer::Start("radical_copy_and_perturb");
+    const mat noise = noiseStdDev * randn(replicates * nPoints, nDims);
+    Timer::Stop("radical_copy_and_perturb");
+
+    for (size_t round = 0; round + 1 < nPlayers; round++)
     {
-      for (size_t j = i + 1; j < nDims; j++)
+      pairs.clear();
+      for (size_t k = 0; k < nPlayers / 2; k++)
       {
-        Log::Debug << "RADICAL 2D on dimensions " << i << " and " << j << "."
-            << std::endl;
+        const size_t a = (k == 0) ? nPlayers - 1 :
+            (round + k) % (nPlayers - 1);
+        const size_t b = (round + nPlayers - 1 - k) % (nPlayers - 1);
+        if (a < nDims && b < nDims)
+          pairs.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+      }
+
+      // With a single pair, the angle search is parallelized instead.
+      #pragma omp parallel for schedule(dynamic, 1) if (pairs.size() > 1)
+      for (size_t p = 0; p < pairs.size(); p++)
+      {
+        const size_t i = pairs[p].first;
+        const size_t j = pairs[p].second;
 
-        matYSubspace.col(0) = matY.col(i);
-        matYSubspace.col(1) = matY.col(j);
+        const vec x1 = repmat(matY.col(i), replicates, 1) + noise.col(i);
+        const vec x2 = repmat(matY.col(j), replicates, 1) + noise.col(j);
 
-        const double thetaOpt = DoRadical2D(matYSubspace);
+        const double thetaOpt = SearchAngle(x1, x2);
 
         const double cosThetaOpt = cos(thetaOpt);
         const double sinThetaOpt = sin(thetaOpt);
 
-        // Set elements of transformation matrix.
-        matJ(i, i) = cosThetaOpt;
-        matJ(j, i) = -sinThetaOpt;
-        matJ(i, j) = sinThetaOpt;
-        matJ(j, j) = cosThetaOpt;
-
-        matY *= matJ;
-
-        // Unset elements of transformation matrix, so matJ = eye() again.
-        matJ(i, i) = 1;
-        matJ(j, i) = 0;
-        matJ(i, j) = 0;
-        matJ(j, j) = 1;
+        // Apply the Jacobi rotation to dimensions i and j of matY, and
+        // accumulate it into the unmixing matrix.
+        const vec yI = matY.col(i);
+        const vec yJ = matY.col(j);
+        matY.col(i) = cosThetaOpt * yI - sinThetaOpt * yJ;
+        matY.col(j) = sinThetaOpt * yI + cosThetaOpt * yJ;
+
+        const vec wI = matW.col(i);
+        const vec wJ = matW.col(j);
+        matW.col(i) = cosThetaOpt * wI - sinThetaOpt * wJ;
+        matW.col(j) = sinThetaOpt * wI + cosThetaOpt * wJ;
       }
     }
   }
@@ -83,7 +83,11 @@ class Radical
    */
   void CopyAndPerturb(arma::mat& xNew, const arma::mat& x) const;
 
-  //! Two-dimensional version of RADICAL.
+  /**
+   * Two-dimensional version of RADICAL: perturb the given two-dimensional
+   * points and return the rotation angle that minimizes the entropy of the
+   * result.
+   */
   double DoRadical2D(const arma::mat& matX);
 
   //! Get the standard deviation of the additive Gaussian noise.
@@ -129,8 +133,17 @@ class Radical
 
   //! Internal matrix, held as member variable to prevent memory reallocations.
   arma::mat perturbed;
-  //! Internal matrix, held as member variable to prevent memory reallocations.
-  arma::mat candidate;
+
+  /**
+   * Find the rotation angle of the two-dimensional (perturbed) points with
+   * the given coordinates that minimizes the sum of the entropies of the
+   * rotated coordinates.  The angles are searched in parallel if mlpack is
+   * compiled with OpenMP.
+   *
+   * @param x1 First coordinate of each point.
+   * @param x2 Second coordinate of each point.
+   */
+  double SearchAngle(const arma::vec& x1, const arma::vec& x2) const;
 };
 
 void WhitenFeatureMajorMatrix(const arma::mat& matX,
@@ -0,0 +1,157 @@
+/**
+ * @file random_fourier_features.hpp
+ * @author Ryan Curtin
+ *
+ * Random Fourier features: an explicit, low-dimensional feature map whose inner
+ * products approximate a shift-invariant kernel.
+ */
+#ifndef __MLPACK_METHODS_RANDOM_FOURIER_FEATURES_HPP
+#define __MLPACK_METHODS_RANDOM_FOURIER_FEATURES_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/kernels/laplacian_kernel.hpp>
+
+namespace mlpack {
+namespace kernel {
+
+/**
+ * The spectral distribution of a shift-invariant kernel: the distribution whose
+ * Fourier transform is the kernel.  Random Fourier features can be used with
+ * any kernel this class is specialized for; a specialization must provide
+ *
+ * @code
+ * static void Sample(const KernelType& kernel,
+ *                    const size_t numFeatures,
+ *                    const size_t dimensionality,
+ *                    arma::mat& frequencies);
+ * @endcode
+ *
+ * which fills frequencies with numFeatures samples (one per row) of dimension
+ * dimensionality.
+ */
+template<typename KernelType>
+struct SpectralDistribution;
+
+/**
+ * The spectral distribution of the Gaussian kernel with bandwidth
+ * @f$ \mu @f$ is a normal distribution with covariance @f$ \mu^{-2} I @f$.
+ */
+template<>
+struct SpectralDistribution<GaussianKernel>
+{
+  static void Sample(const GaussianKernel& kernel,
+                     const size_t numFeatures,
+                     const size_t dimensionality,
+                     arma::mat& frequencies)
+  {
+    frequencies.randn(numFeatures, dimensionality);
+    frequencies /= kernel.Bandwidth();
+  }
+};
+
+/**
+ * The spectral distribution of the Laplacian kernel with bandwidth
+ * @f$ \mu @f$ is a multivariate Cauchy distribution with scale
+ * @f$ \mu^{-1} @f$; each sample is a normal sample divided by the absolute
+ * value of an independent standard normal sample.
+ */
+template<>
+struct SpectralDistribution<LaplacianKernel>
+{
+  static void Sample(const LaplacianKernel& kernel,
+                     const size_t numFeatures,
+                     const size_t dimensionality,
+                     arma::mat& frequencies)
+  {
+    frequencies.randn(numFeatures, dimensionality);
+    const arma::vec scales = arma::randn<arma::vec>(numFeatures);
+    for (size_t i = 0; i < numFeatures; ++i)
+      frequencies.row(i) /= kernel.Bandwidth() * std::abs(scales[i]);
+  }
+};
+
+/**
+ * An implementation of random Fourier features, as introduced in the following
+ * paper:
+ *
+ * @code
+ * @inproceedings{rahimi2007random,
+ *   title={Random features for large-scale kernel machines},
+ *   author={Rahimi, A. and Recht, B.},
+ *   booktitle={Advances in Neural Information Processing Systems},
+ *   pages={1177--1184},
+ *   year={2007}
+ * }
+ * @endcode
+ *
+ * Each point x is mapped to the numFeatures-dimensional vector
+ *
+ * @f[
+ * z(x) = \sqrt{2 / D} \cos(W x + b),
+ * @f]
+ *
+ * where each row of W is drawn from the spectral distribution of the kernel
+ * and each element of b is drawn uniformly from [0, 2 pi).  Then z(x)^T z(y)
+ * approximates K(x, y), with an error of O(1 / sqrt(D)).  Since the map is
+ * explicit, any linear method (such as LinearRegression or
+ * LogisticRegression) can be run on the mapped points to give a fast
+ * approximate kernel method, and the points can be mapped in chunks.
+ *
+ * The kernel must be shift-invariant and SpectralDistribution must be
+ * specialized for it; GaussianKernel and LaplacianKernel are supported.
+ *
+ * @tparam KernelType Shift-invariant kernel to approximate.
+ */
+template<typename KernelType>
+class RandomFourierFeatures
+{
+ public:
+  /**
+   * Draw a random feature map for the given kernel.
+   *
+   * @param dimensionality Dimensionality of the points to be mapped.
+   * @param numFeatures Number of features to map each point to.
+   * @param kernel Kernel to approximate.
+   */
+  RandomFourierFeatures(const size_t dimensionality,
+                        const size_t numFeatures,
+                        const KernelType& kernel = KernelType());
+
+  /**
+   * Map the given points to their features.  It is safe to pass the same
+   * matrix reference for both data and features.
+   *
+   * @param data Points to map (one per column).
+   * @param features Matrix to store the features in (numFeatures x
+   *     data.n_cols).
+   */
+  void Transform(const arma::mat& data, arma::mat& features) const;
+
+  //! Get the dimensionality of the points to be mapped.
+  size_t Dimensionality() const { return frequencies.n_cols; }
+  //! Get the number of features each point is mapped to.
+  size_t NumFeatures() const { return frequencies.n_rows; }
+
+  //! Get the frequencies (W), one feature per row.
+  const arma::mat& Frequencies() const { return frequencies; }
+  //! Get the phase offsets (b), one per feature.
+  const arma::vec& Offsets() const { return offsets; }
+
+  // Returns a string representation of this object.
+  std::string ToString() const;
+
+ private:
+  //! The frequencies of the features, one per row.
+  arma::mat frequencies;
+  //! The phase offsets of the features.
+  arma::vec offsets;
+};
+
+}; // namespace kernel
+}; // namespace mlpack
+
+// Include implementation.
+#include "random_fourier_features_impl.hpp"
+
+#endif
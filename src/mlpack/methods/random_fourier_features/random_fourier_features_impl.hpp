@@ -0,0 +1,68 @@
+/**
+ * @file random_fourier_features_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of the RandomFourierFeatures class.
+ */
+#ifndef __MLPACK_METHODS_RANDOM_FOURIER_FEATURES_IMPL_HPP
+#define __MLPACK_METHODS_RANDOM_FOURIER_FEATURES_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "random_fourier_features.hpp"
+
+namespace mlpack {
+namespace kernel {
+
+template<typename KernelType>
+RandomFourierFeatures<KernelType>::RandomFourierFeatures(
+    const size_t dimensionality,
+    const size_t numFeatures,
+    const KernelType& kernel)
+{
+  if (numFeatures == 0)
+  {
+    std::ostringstream oss;
+    oss << "RandomFourierFeatures::RandomFourierFeatures(): the number of "
+        << "features must be positive!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  SpectralDistribution<KernelType>::Sample(kernel, numFeatures,
+      dimensionality, frequencies);
+  offsets = 2.0 * M_PI * arma::randu<arma::vec>(numFeatures);
+}
+
+template<typename KernelType>
+void RandomFourierFeatures<KernelType>::Transform(const arma::mat& data,
+                                                  arma::mat& features) const
+{
+  if (data.n_rows != frequencies.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "RandomFourierFeatures::Transform(): dimensionality of points ("
+        << data.n_rows << ") does not match dimensionality of feature map ("
+        << frequencies.n_cols << ")!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  // All of the projections are one matrix multiplication.
+  arma::mat projections = frequencies * data;
+  projections.each_col() += offsets;
+  features = std::sqrt(2.0 / frequencies.n_rows) * arma::cos(projections);
+}
+
+// Return a string of this object.
+template<typename KernelType>
+std::string RandomFourierFeatures<KernelType>::ToString() const
+{
+  std::ostringstream convert;
+  convert << "RandomFourierFeatures [" << this << "]" << std::endl;
+  convert << "  Dimensionality: " << Dimensionality() << std::endl;
+  convert << "  Number of features: " << NumFeatures() << std::endl;
+  return convert.str();
+}
+
+}; // namespace kernel
+}; // namespace mlpack
+
+#endif
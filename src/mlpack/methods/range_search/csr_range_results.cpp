@@ -0,0 +1,229 @@
+/**
+ * @file csr_range_results.cpp
+ * @author Ryan Curtin
+ *
+ * Implementation of CSRRangeResults, a compressed sparse row container for
+ * range search results.
+ */
+#include "csr_range_results.hpp"
+
+#include <cstring>
+#include <fstream>
+
+using namespace std;
+using namespace mlpack;
+using namespace mlpack::range;
+
+CSRRangeResults::CSRRangeResults() :
+    offsets(1, 0),
+    ordered(true),
+    lastQuery(0)
+{
+  // Nothing to do.
+}
+
+void CSRRangeResults::Reset(const size_t numQueries)
+{
+  offsets.assign(numQueries + 1, 0);
+  neighbors.clear();
+  distances.clear();
+  queries.clear();
+  ordered = true;
+  lastQuery = 0;
+}
+
+void CSRRangeResults::Add(const CSRRangeResults& other)
+{
+  if (other.ordered)
+  {
+    // The query indices are given by the counts.
+    size_t result = 0;
+    for (size_t q = 0; q + 1 < other.offsets.size(); ++q)
+      for (size_t i = 0; i < other.offsets[q + 1]; ++i, ++result)
+        Add(q, other.neighbors[result], other.distances[result]);
+  }
+  else
+  {
+    for (size_t i = 0; i < other.neighbors.size(); ++i)
+      Add(other.queries[i], other.neighbors[i], other.distances[i]);
+  }
+}
+
+void CSRRangeResults::Unorder()
+{
+  queries.reserve(neighbors.capacity());
+  for (size_t q = 0; q <= lastQuery; ++q)
+    queries.insert(queries.end(), offsets[q + 1], q);
+  ordered = false;
+}
+
+void CSRRangeResults::Finalize()
+{
+  // Turn the counts into offsets.
+  for (size_t q = 1; q < offsets.size(); ++q)
+    offsets[q] += offsets[q - 1];
+
+  if (!ordered)
+  {
+    // Scatter the results into their rows, keeping the order within each row.
+    vector<size_t> position(offsets.begin(), offsets.end() - 1);
+    vector<size_t> sortedNeighbors(neighbors.size());
+    vector<double> sortedDistances(distances.size());
+    for (size_t i = 0; i < neighbors.size(); ++i)
+    {
+      const size_t p = position[queries[i]]++;
+      sortedNeighbors[p] = neighbors[i];
+      sortedDistances[p] = distances[i];
+    }
+
+    neighbors.swap(sortedNeighbors);
+    distances.swap(sortedDistances);
+    vector<size_t>().swap(queries);
+    ordered = true;
+  }
+}
+
+void CSRRangeResults::MapQueries(const vector<size_t>& oldFromNew)
+{
+  vector<size_t> mappedOffsets(offsets.size(), 0);
+  for (size_t i = 0; i < NumQueries(); ++i)
+    mappedOffsets[oldFromNew[i] + 1] = NumResults(i);
+  for (size_t q = 1; q < mappedOffsets.size(); ++q)
+    mappedOffsets[q] += mappedOffsets[q - 1];
+
+  vector<size_t> mappedNeighbors(neighbors.size());
+  vector<double> mappedDistances(distances.size());
+  for (size_t i = 0; i < NumQueries(); ++i)
+  {
+    std::copy(neighbors.begin() + offsets[i], neighbors.begin() +
+        offsets[i + 1], mappedNeighbors.begin() + mappedOffsets[oldFromNew[i]]);
+    std::copy(distances.begin() + offsets[i], distances.begin() +
+        offsets[i + 1], mappedDistances.begin() + mappedOffsets[oldFromNew[i]]);
+  }
+
+  offsets.swap(mappedOffsets);
+  neighbors.swap(mappedNeighbors);
+  distances.swap(mappedDistances);
+}
+
+void CSRRangeResults::MapReferences(const vector<size_t>& oldFromNew)
+{
+  for (size_t i = 0; i < neighbors.size(); ++i)
+    neighbors[i] = oldFromNew[neighbors[i]];
+}
+
+void CSRRangeResults::Unpack(vector<vector<size_t>>& neighborsOut,
+                             vector<vector<double>>& distancesOut) const
+{
+  neighborsOut.clear();
+  neighborsOut.resize(NumQueries());
+  distancesOut.clear();
+  distancesOut.resize(NumQueries());
+
+  for (size_t i = 0; i < NumQueries(); ++i)
+  {
+    neighborsOut[i].assign(neighbors.begin() + offsets[i],
+        neighbors.begin() + offsets[i + 1]);
+    distancesOut[i].assign(distances.begin() + offsets[i],
+        distances.begin() + offsets[i + 1]);
+  }
+}
+
+//! The first eight bytes of a file written by Save().
+static const char csrMagic[8] = { 'M', 'L', 'P', 'K', 'C', 'S', 'R', '1' };
+
+bool CSRRangeResults::Save(const string& filename, const bool fatal) const
+{
+  ofstream stream(filename.c_str(), ios::out | ios::binary);
+  if (!stream.is_open())
+  {
+    if (fatal)
+      Log::Fatal << "Cannot open file '" << filename << "' for writing."
+          << endl;
+    Log::Warn << "Cannot open file '" << filename << "' for writing; save "
+        << "failed." << endl;
+    return false;
+  }
+
+  const uint64_t header[2] = { (uint64_t) NumQueries(),
+                               (uint64_t) NumResults() };
+  stream.write(csrMagic, sizeof(csrMagic));
+  stream.write((const char*) header, sizeof(header));
+
+  // Write in chunks, so that size_t does not need to be 64 bits wide.
+  vector<uint64_t> buffer;
+  const vector<size_t>* arrays[2] = { &offsets, &neighbors };
+  for (size_t a = 0; a < 2; ++a)
+  {
+    buffer.assign(arrays[a]->begin(), arrays[a]->end());
+    stream.write((const char*) buffer.data(), buffer.size() *
+        sizeof(uint64_t));
+  }
+  stream.write((const char*) distances.data(), distances.size() *
+      sizeof(double));
+
+  if (!stream.good())
+  {
+    if (fatal)
+      Log::Fatal << "Error writing to file '" << filename << "'." << endl;
+    Log::Warn << "Error writing to file '" << filename << "'; save failed."
+        << endl;
+    return false;
+  }
+
+  return true;
+}
+
+bool CSRRangeResults::Load(const string& filename, const bool fatal)
+{
+  ifstream stream(filename.c_str(), ios::in | ios::binary);
+  if (!stream.is_open())
+  {
+    if (fatal)
+      Log::Fatal << "Cannot open file '" << filename << "'." << endl;
+    Log::Warn << "Cannot open file '" << filename << "'; load failed." << endl;
+    return false;
+  }
+
+  char magic[8];
+  uint64_t header[2];
+  stream.read(magic, sizeof(magic));
+  stream.read((char*) header, sizeof(header));
+  if (!stream.good() || memcmp(magic, csrMagic, sizeof(magic)) != 0)
+  {
+    if (fatal)
+      Log::Fatal << "File '" << filename << "' does not hold range search "
+          << "results." << endl;
+    Log::Warn << "File '" << filename << "' does not hold range search "
+        << "results; load failed." << endl;
+    return false;
+  }
+
+  vector<uint64_t> buffer(header[0] + 1);
+  stream.read((char*) buffer.data(), buffer.size() * sizeof(uint64_t));
+  offsets.assign(buffer.begin(), buffer.end());
+
+  buffer.resize(header[1]);
+  stream.read((char*) buffer.data(), buffer.size() * sizeof(uint64_t));
+  neighbors.assign(buffer.begin(), buffer.end());
+
+  distances.resize(header[1]);
+  stream.read((char*) distances.data(), distances.size() * sizeof(double));
+
+  queries.clear();
+  ordered = true;
+  lastQuery = 0;
+
+  if (!stream.good() || offsets.back() != neighbors.size())
+  {
+    if (fatal)
+      Log::Fatal << "File '" << filename << "' is truncated or corrupt."
+          << endl;
+    Log::Warn << "File '" << filename << "' is truncated or corrupt; load "
+        << "failed." << endl;
+    Reset(0);
+    return false;
+  }
+
+  return true;
+}
@@ -0,0 +1,174 @@
+/**
+ * @file csr_range_results.hpp
+ * @author Ryan Curtin
+ *
+ * A compact container for the results of range search, which stores the
+ * neighbors of all query points in compressed sparse row (CSR) form.
+ */
+#ifndef __MLPACK_METHODS_RANGE_SEARCH_CSR_RANGE_RESULTS_HPP
+#define __MLPACK_METHODS_RANGE_SEARCH_CSR_RANGE_RESULTS_HPP
+
+#include <mlpack/core.hpp>
+
+namespace mlpack {
+namespace range {
+
+/**
+ * The results of a range search, stored in compressed sparse row form: the
+ * neighbors of query point i (and their distances) are held contiguously in
+ * Neighbors() and Distances(), from index Offsets()[i] up to (but not
+ * including) Offsets()[i + 1].  Unlike nested std::vector<>s, this takes three
+ * allocations no matter how many query points there are, which matters when
+ * there are many query points or many results.
+ *
+ * RangeSearchRules fill this object directly during search with Add().  If the
+ * results arrive in order of query point (as they do for naive search and
+ * serial single-tree search), nothing but the results and one array of offsets
+ * is stored.  Otherwise (as for dual-tree search), the query index of each
+ * result is kept until Finalize() groups the results by query point.
+ *
+ * The results can be saved to and loaded from a simple binary format with
+ * Save() and Load(); see Save() for the layout.
+ */
+class CSRRangeResults
+{
+ public:
+  //! Create an empty set of results.
+  CSRRangeResults();
+
+  /**
+   * Clear the results and prepare to receive results for the given number of
+   * query points.
+   *
+   * @param numQueries Number of query points.
+   */
+  void Reset(const size_t numQueries);
+
+  /**
+   * Add a result: the given reference point is at the given distance from the
+   * given query point, which is within the range.  After Finalize() is called,
+   * no more results may be added.
+   *
+   * @param queryIndex Index of the query point.
+   * @param referenceIndex Index of the reference point.
+   * @param distance Distance between the query point and the reference point.
+   */
+  void Add(const size_t queryIndex,
+           const size_t referenceIndex,
+           const double distance)
+  {
+    if (ordered && queryIndex < lastQuery)
+      Unorder();
+    if (!ordered)
+      queries.push_back(queryIndex);
+
+    lastQuery = queryIndex;
+    ++offsets[queryIndex + 1];
+    neighbors.push_back(referenceIndex);
+    distances.push_back(distance);
+  }
+
+  /**
+   * Add all of the results held by another (not finalized) set of results for
+   * the same query points.  This is used to combine the results of several
+   * threads.
+   *
+   * @param other Results to add.
+   */
+  void Add(const CSRRangeResults& other);
+
+  /**
+   * Group the results by query point and compute the offsets.  This must be
+   * called once all results have been added, before the results are accessed.
+   */
+  void Finalize();
+
+  /**
+   * Map the query indices of the (finalized) results: the results of query
+   * point i become the results of query point oldFromNew[i].
+   *
+   * @param oldFromNew Mapping from new query indices to old query indices.
+   */
+  void MapQueries(const std::vector<size_t>& oldFromNew);
+
+  /**
+   * Map the reference indices of the results: each neighbor i is replaced with
+   * oldFromNew[i].
+   *
+   * @param oldFromNew Mapping from new reference indices to old reference
+   *     indices.
+   */
+  void MapReferences(const std::vector<size_t>& oldFromNew);
+
+  /**
+   * Convert the (finalized) results to the nested vector format returned by
+   * RangeSearch::Search().
+   *
+   * @param neighborsOut Vector to store the neighbors of each query point in.
+   * @param distancesOut Vector to store the distances of each neighbor in.
+   */
+  void Unpack(std::vector<std::vector<size_t>>& neighborsOut,
+              std::vector<std::vector<double>>& distancesOut) const;
+
+  /**
+   * Save the (finalized) results to a binary file.  The file holds, in native
+   * byte order: the eight characters "MLPKCSR1"; the number of query points
+   * and the number of results, as 64-bit unsigned integers; the offsets
+   * (number of query points + 1 of them) and the neighbors, as 64-bit unsigned
+   * integers; and the distances, as doubles.
+   *
+   * @param filename Name of the file to save to.
+   * @param fatal If an error should be reported as fatal (default false).
+   * @return Whether or not the results were saved.
+   */
+  bool Save(const std::string& filename, const bool fatal = false) const;
+
+  /**
+   * Load results saved with Save().
+   *
+   * @param filename Name of the file to load from.
+   * @param fatal If an error should be reported as fatal (default false).
+   * @return Whether or not the results were loaded.
+   */
+  bool Load(const std::string& filename, const bool fatal = false);
+
+  //! Get the number of query points.
+  size_t NumQueries() const { return offsets.size() - 1; }
+  //! Get the total number of results.
+  size_t NumResults() const { return neighbors.size(); }
+  //! Get the number of results of the given query point.
+  size_t NumResults(const size_t queryIndex) const
+  { return offsets[queryIndex + 1] - offsets[queryIndex]; }
+
+  //! Get the offsets of the results of each query point.
+  const std::vector<size_t>& Offsets() const { return offsets; }
+  //! Get the neighbors of all query points.
+  const std::vector<size_t>& Neighbors() const { return neighbors; }
+  //! Get the distances of all neighbors.
+  const std::vector<double>& Distances() const { return distances; }
+
+ private:
+  //! The offsets of the results of each query point (before Finalize(), entry
+  //! i + 1 holds the number of results of query point i).
+  std::vector<size_t> offsets;
+  //! The neighbors, grouped by query point.
+  std::vector<size_t> neighbors;
+  //! The distances of the neighbors.
+  std::vector<double> distances;
+  //! The query index of each result, if they did not arrive in order.
+  std::vector<size_t> queries;
+
+  //! Whether or not the results so far arrived in order of query point.
+  bool ordered;
+  //! The query index of the last result.
+  size_t lastQuery;
+
+  //! Start keeping the query index of each result, because a result arrived
+  //! out of order.
+  void Unorder();
+};
+
+} // namespace range
+} // namespace mlpack
+
+#endif
@@ -0,0 +1,121 @@
+/**
+ * @file mahalanobis_range_search.hpp
+ * @author Ryan Curtin
+ *
+ * Definition of MahalanobisRangeSearch, which answers range searches with the
+ * Mahalanobis distance by transforming the data and using the Euclidean
+ * distance, so that any tree type can be used.
+ */
+#ifndef __MLPACK_METHODS_RANGE_SEARCH_MAHALANOBIS_RANGE_SEARCH_HPP
+#define __MLPACK_METHODS_RANGE_SEARCH_MAHALANOBIS_RANGE_SEARCH_HPP
+
+#include <mlpack/core.hpp>
+#include <mlpack/core/metrics/mahalanobis_distance.hpp>
+#include "range_search.hpp"
+
+namespace mlpack {
+namespace range {
+
+/**
+ * Range search with the Mahalanobis distance.  As with
+ * neighbor::MahalanobisNeighborSearch, the reference set (and each query set)
+ * is transformed once by the matrix given by
+ * MahalanobisDistance::Transformation(), and RangeSearch is run with the
+ * Euclidean distance on the transformed points.  The ranges and the returned
+ * distances are in terms of the Mahalanobis distance (squared if TakeRoot is
+ * false for the given metric).
+ *
+ * @code
+ * MahalanobisDistance<> metric(covariance);
+ * MahalanobisRangeSearch<> rs(referenceSet, metric);
+ * rs.Search(querySet, math::Range(0.0, 2.0), neighbors, distances);
+ * @endcode
+ *
+ * @tparam TreeType The tree type to use; any tree that works with the Euclidean
+ *      distance can be used.
+ */
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType = tree::KDTree>
+class MahalanobisRangeSearch
+{
+ public:
+  //! The type of the search on the transformed points.
+  typedef RangeSearch<metric::EuclideanDistance, arma::mat, TreeType>
+      RangeSearchType;
+
+  /**
+   * Transform the reference set and build the tree on it.
+   *
+   * @param referenceSet Set of reference points.
+   * @param metric The Mahalanobis distance to search with.
+   * @param naive If true, O(n^2) naive search will be used.
+   * @param singleMode If true, single-tree search will be used.
+   */
+  template<bool TakeRoot>
+  MahalanobisRangeSearch(const arma::mat& referenceSet,
+                         const metric::MahalanobisDistance<TakeRoot>& metric,
+                         const bool naive = false,
+                         const bool singleMode = false);
+
+  /**
+   * Find the reference points within the given range of each point in the
+   * query set.  The query set is transformed first.
+   *
+   * @param querySet Set of query points.
+   * @param range Range of distances in which to search.
+   * @param neighbors Object which will hold the list of neighbors for each
+   *      query point.
+   * @param distances Object which will hold the list of distances for each
+   *      query point.
+   */
+  void Search(const arma::mat& querySet,
+              const math::Range& range,
+              std::vector<std::vector<size_t>>& neighbors,
+              std::vector<std::vector<double>>& distances);
+
+  /**
+   * Find the reference points within the given range of each point in the
+   * reference set (not counting the point itself).
+   *
+   * @param range Range of distances in which to search.
+   * @param neighbors Object which will hold the list of neighbors for each
+   *      point.
+   * @param distances Object which will hold the list of distances for each
+   *      point.
+   */
+  void Search(const math::Range& range,
+              std::vector<std::vector<size_t>>& neighbors,
+              std::vector<std::vector<double>>& distances);
+
+  //! Get the matrix the points are transformed by.
+  const arma::mat& Transformation() const { return transformation; }
+  //! Get whether the distances are Mahalanobis distances (or their squares).
+  bool TakeRoot() const { return takeRoot; }
+
+  //! Get the search on the transformed points.
+  const RangeSearchType& Searcher() const { return searcher; }
+  //! Modify the search on the transformed points.
+  RangeSearchType& Searcher() { return searcher; }
+
+ private:
+  //! Get the range of Euclidean distances for the given range.
+  math::Range EuclideanRange(const math::Range& range) const;
+  //! Square the distances, if takeRoot is false.
+  void AdjustDistances(std::vector<std::vector<double>>& distances) const;
+
+  //! The matrix the points are transformed by.
+  arma::mat transformation;
+  //! If false, the ranges and distances are squared.
+  bool takeRoot;
+  //! The search on the transformed points.
+  RangeSearchType searcher;
+};
+
+}; // namespace range
+}; // namespace mlpack
+
+// Include implementation.
+#include "mahalanobis_range_search_impl.hpp"
+
+#endif
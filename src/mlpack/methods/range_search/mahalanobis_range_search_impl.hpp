@@ -0,0 +1,88 @@
+/**
+ * @file mahalanobis_range_search_impl.hpp
+ * @author Ryan Curtin
+ *
+ * Implementation of MahalanobisRangeSearch.
+ */
+#ifndef __MLPACK_METHODS_RANGE_SEARCH_MAHALANOBIS_RANGE_SEARCH_IMPL_HPP
+#define __MLPACK_METHODS_RANGE_SEARCH_MAHALANOBIS_RANGE_SEARCH_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "mahalanobis_range_search.hpp"
+
+namespace mlpack {
+namespace range {
+
+template<template<typename, typename, typename> class TreeType>
+template<bool TakeRoot>
+MahalanobisRangeSearch<TreeType>::MahalanobisRangeSearch(
+    const arma::mat& referenceSet,
+    const metric::MahalanobisDistance<TakeRoot>& metric,
+    const bool naive,
+    const bool singleMode) :
+    transformation(metric.Transformation()),
+    takeRoot(TakeRoot),
+    searcher(arma::mat(transformation * referenceSet), naive, singleMode)
+{
+  // Nothing to do.
+}
+
+template<template<typename, typename, typename> class TreeType>
+void MahalanobisRangeSearch<TreeType>::Search(
+    const arma::mat& querySet,
+    const math::Range& range,
+    std::vector<std::vector<size_t>>& neighbors,
+    std::vector<std::vector<double>>& distances)
+{
+  if (querySet.n_rows != transformation.n_cols)
+  {
+    std::ostringstream oss;
+    oss << "MahalanobisRangeSearch::Search(): dimensionality of query set ("
+        << querySet.n_rows << ") is not equal to the dimensionality of the "
+        << "covariance matrix (" << transformation.n_cols << ")";
+    throw std::invalid_argument(oss.str());
+  }
+
+  searcher.Search(arma::mat(transformation * querySet), EuclideanRange(range),
+      neighbors, distances);
+  AdjustDistances(distances);
+}
+
+template<template<typename, typename, typename> class TreeType>
+void MahalanobisRangeSearch<TreeType>::Search(
+    const math::Range& range,
+    std::vector<std::vector<size_t>>& neighbors,
+    std::vector<std::vector<double>>& distances)
+{
+  searcher.Search(EuclideanRange(range), neighbors, distances);
+  AdjustDistances(distances);
+}
+
+template<template<typename, typename, typename> class TreeType>
+math::Range MahalanobisRangeSearch<TreeType>::EuclideanRange(
+    const math::Range& range) const
+{
+  if (takeRoot)
+    return range;
+
+  // The range is of squared distances; negative bounds are taken to be 0.
+  return math::Range(std::sqrt(std::max(range.Lo(), 0.0)),
+      std::sqrt(std::max(range.Hi(), 0.0)));
+}
+
+template<template<typename, typename, typename> class TreeType>
+void MahalanobisRangeSearch<TreeType>::AdjustDistances(
+    std::vector<std::vector<double>>& distances) const
+{
+  if (takeRoot)
+    return;
+
+  for (size_t i = 0; i < distances.size(); ++i)
+    for (size_t j = 0; j < distances[i].size(); ++j)
+      distances[i][j] *= distances[i][j];
+}
+
+}; // namespace range
+}; // namespace mlpack
+
+#endif
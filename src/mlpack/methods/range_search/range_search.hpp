@@ -11,7 +11,10 @@
 #include <mlpack/core.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/query_order.hpp>
+#include <mlpack/core/tree/subtree_frontier.hpp>
 #include "range_search_stat.hpp"
+#include "csr_range_results.hpp"
 
 namespace mlpack {
 namespace range /** Range-search routines. */ {
@@ -265,6 +268,134 @@ class RangeSearch
               std::vector<std::vector<size_t>>& neighbors,
               std::vector<std::vector<double>>& distances);
 
+  /**
+   * Search for all reference points in the given range for each point in the
+   * query set, storing the results in compressed sparse row form (see
+   * CSRRangeResults).  The results are the same as those of the overload of
+   * Search() that returns nested vectors, but they take far fewer allocations.
+   *
+   * @param querySet Set of query points to search with.
+   * @param range Range of distances in which to search.
+   * @param results Object which will hold the results (it is reset first).
+   */
+  void Search(const MatType& querySet,
+              const math::Range& range,
+              CSRRangeResults& results);
+
+  /**
+   * Given a pre-built query tree, search for all reference points in the given
+   * range for each point in the query set, storing the results in compressed
+   * sparse row form (see CSRRangeResults).  The query indices of the results
+   * are those of the query tree's dataset.  If either naive or singleMode are
+   * set to true, this will throw an invalid_argument exception.
+   *
+   * @param queryTree Tree built on query points.
+   * @param range Range of distances in which to search.
+   * @param results Object which will hold the results (it is reset first).
+   */
+  void Search(Tree* queryTree,
+              const math::Range& range,
+              CSRRangeResults& results);
+
+  /**
+   * Search for all points in the given range for each point in the reference
+   * set, storing the results in compressed sparse row form (see
+   * CSRRangeResults).  The query set and the reference set are the same.
+   *
+   * @param range Range of distances in which to search.
+   * @param results Object which will hold the results (it is reset first).
+   */
+  void Search(const math::Range& range, CSRRangeResults& results);
+
+  /**
+   * Search for all reference points in the given range for each point in the
+   * query set, handing each result to the given callback as soon as it is
+   * found instead of storing it.  The callback is called as
+   *
+   * @code
+   * callback(queryIndex, referenceIndex, distance);
+   * @endcode
+   *
+   * exactly once for each pair of points in the range, with the original
+   * indices of the points, and in no particular order (though single-tree
+   * search gives all the results of each query point together, in order of
+   * query points).  This allows the results to be written out or aggregated
+   * without materializing them all.  The callback is always called from a
+   * single thread, so the search is serial even if Parallel() is set.
+   *
+   * @param querySet Set of query points to search with.
+   * @param range Range of distances in which to search.
+   * @param callback Callback to call with each result.
+   */
+  template<typename CallbackType>
+  void Search(const MatType& querySet,
+              const math::Range& range,
+              CallbackType& callback);
+
+  /**
+   * Search for all points in the given range for each point in the reference
+   * set, handing each result to the given callback as soon as it is found
+   * instead of storing it; see the other overload of Search() with a callback.
+   * The query set and the reference set are the same.
+   *
+   * @param range Range of distances in which to search.
+   * @param callback Callback to call with each result.
+   */
+  template<typename CallbackType>
+  void Search(const math::Range& range, CallbackType& callback);
+
+  /**
+   * Count the reference points in the given range of each point in the query
+   * set, without storing the points themselves.  Reference nodes that lie
+   * entirely in the range are counted at once, without computing the distance
+   * to each of their points.
+   *
+   * @param querySet Set of query points to search with.
+   * @param range Range of distances in which to search.
+   * @param counts Vector which will hold the number of reference points in the
+   *      range of each query point.
+   */
+  void Count(const MatType& querySet,
+             const math::Range& range,
+             arma::Col<size_t>& counts);
+
+  /**
+   * Count the points in the given range of each point in the reference set,
+   * not counting each point itself.  The query set and the reference set are
+   * the same.
+   *
+   * @param range Range of distances in which to search.
+   * @param counts Vector which will hold the number of points in the range of
+   *      each point.
+   */
+  void Count(const math::Range& range, arma::Col<size_t>& counts);
+
+  /**
+   * Determine, for each point in the query set, whether or not any reference
+   * point is in the given range.  The search for each query point stops at its
+   * first hit, so single-tree search is used even if dual-tree search is
+   * selected (naive search is still used if it is selected).
+   *
+   * @param querySet Set of query points to search with.
+   * @param range Range of distances in which to search.
+   * @param exists Vector which will hold, for each query point, whether or not
+   *      a reference point lies in the range.
+   */
+  void Exists(const MatType& querySet,
+              const math::Range& range,
+              std::vector<bool>& exists);
+
+  /**
+   * Determine, for each point in the reference set, whether or not any other
+   * point of the reference set is in the given range.  The search for each
+   * point stops at its first hit, as with the other overload of Exists().
+   *
+   * @param range Range of distances in which to search.
+   * @param exists Vector which will hold, for each point, whether or not
+   *      another point lies in the range.
+   */
+  void Exists(const math::Range& range, std::vector<bool>& exists);
+
   //! Get whether single-tree search is being used.
   bool SingleMode() const { return singleMode; }
   //! Modify whether single-tree search is being used.
@@ -275,6 +406,25 @@ class RangeSearch
   //! Modify whether naive search is being used.
   bool& Naive() { return naive; }
 
+  //! Get whether tree-based search is split across multiple threads.
+  bool Parallel() const { return parallel; }
+  //! Modify whether tree-based search is split across multiple threads.
+  //! Single-tree search splits the query points between threads, and dual-tree
+  //! search splits the query tree into subtrees that are traversed
+  //! concurrently.  This has no effect if mlpack was not compiled with OpenMP
+  //! support.
+  bool& Parallel() { return parallel; }
+
+  //! Get whether single-tree search processes the query points in a spatial
+  //! order.
+  bool ReorderQueries() const { return reorderQueries; }
+  //! Modify whether single-tree search processes the query points in a spatial
+  //! order (see tree::QueryOrder()), so that consecutive query points visit
+  //! mostly the same reference nodes.  The results are the same.  Searches that
+  //! give their results in order of query point (to a CSRRangeResults object or
+  //! a callback) always process the query points in order.
+  bool& ReorderQueries() { return reorderQueries; }
+
   //! Get the number of base cases during the last search.
   size_t BaseCases() const { return baseCases; }
   //! Get the number of scores during the last search.
@@ -311,6 +461,11 @@ class RangeSearch
   bool naive;
   //! If true, single-tree computation is used.
   bool singleMode;
+  //! If true, tree-based search is split across multiple threads.
+  bool parallel;
+  //! If true, single-tree search processes the query points in a spatial
+  //! order.
+  bool reorderQueries;
 
   //! Instantiated distance metric.
   MetricType metric;
@@ -320,6 +475,137 @@ class RangeSearch
   //! The total number of scores during the last search.
   size_t scores;
 
+  /**
+   * Perform a single-tree traversal for each point in the given query set,
+   * storing results in the given (already sized) vectors.  If parallel search
+   * is enabled, the query points are split into chunks across threads, each
+   * with its own RangeSearchRules object and traverser.  Trees with
+   * self-children (i.e. cover trees) are always searched serially, because
+   * their rules cache distances in the reference tree.
+   *
+   * @param querySet Set of query points.
+   * @param range Range of distances in which to search.
+   * @param neighbors Object which will hold the neighbors of each query point.
+   * @param distances Object which will hold the distances of each neighbor.
+   * @param sameSet Whether or not the query set is the reference set.
+   */
+  void SingleTreeSearch(const MatType& querySet,
+                        const math::Range& range,
+                        std::vector<std::vector<size_t>>& neighbors,
+                        std::vector<std::vector<double>>& distances,
+                        const bool sameSet);
+
+  /**
+   * Perform a single-tree traversal for each point in the given query set,
+   * storing results in the given (already reset) compressed sparse row
+   * results.  If parallel search is enabled, each thread collects its results
+   * separately, and they are combined at the end.  The results are not
+   * finalized.
+   *
+   * @param querySet Set of query points.
+   * @param range Range of distances in which to search.
+   * @param results Object which will hold the results.
+   * @param sameSet Whether or not the query set is the reference set.
+   */
+  void SingleTreeSearch(const MatType& querySet,
+                        const math::Range& range,
+                        CSRRangeResults& results,
+                        const bool sameSet);
+
+  /**
+   * A callback that maps the indices of each result back to the original
+   * indices of the points before handing it to another callback.
+   */
+  template<typename CallbackType>
+  class MappedCallback
+  {
+   public:
+    //! Wrap the given callback; a NULL mapping leaves those indices unmapped.
+    MappedCallback(CallbackType& callback,
+                   const std::vector<size_t>* oldFromNewQueries,
+                   const std::vector<size_t>* oldFromNewReferences) :
+        callback(callback),
+        oldFromNewQueries(oldFromNewQueries),
+        oldFromNewReferences(oldFromNewReferences)
+    { }
+
+    //! Map the given result and hand it to the callback.
+    void operator()(const size_t queryIndex,
+                    const size_t referenceIndex,
+                    const double distance)
+    {
+      callback(oldFromNewQueries ? (*oldFromNewQueries)[queryIndex] :
+          queryIndex, oldFromNewReferences ?
+          (*oldFromNewReferences)[referenceIndex] : referenceIndex, distance);
+    }
+
+   private:
+    //! The callback to hand the results to.
+    CallbackType& callback;
+    //! Mappings to the original query indices (or NULL).
+    const std::vector<size_t>* oldFromNewQueries;
+    //! Mappings to the original reference indices (or NULL).
+    const std::vector<size_t>* oldFromNewReferences;
+  };
+
+  /**
+   * Search for the reference points in the given range of each query point,
+   * with naive, single-tree, or dual-tree search, and hand each result to the
+   * given callback with its original indices.
+   *
+   * @param querySet Set of query points.
+   * @param range Range of distances in which to search.
+   * @param callback Callback to call with each result.
+   * @param sameSet Whether or not the query set is the reference set.
+   */
+  template<typename CallbackType>
+  void CallbackSearch(const MatType& querySet,
+                      const math::Range& range,
+                      CallbackType& callback,
+                      const bool sameSet);
+
+  /**
+   * Perform a dual-tree traversal of the given query tree against the
+   * reference tree, storing results in the given object: the (already sized)
+   * vectors of a VectorRangeResults, (already reset) compressed sparse row
+   * results, which are not finalized, or a (zeroed) vector of counts.  If
+   * parallel search is enabled, the query tree is split into subtrees, which
+   * are traversed against the reference tree concurrently; each query point
+   * belongs to exactly one subtree, so results that are held per query point
+   * are written directly, and compressed sparse row results are collected by
+   * each thread and combined at the end (see RangeSearchTask).  Trees with
+   * self-children (i.e. cover trees) are always searched serially.
+   *
+   * @param queryTree Query tree (this may be the reference tree).
+   * @param range Range of distances in which to search.
+   * @param results Object which will hold the results.
+   * @param sameSet Whether or not the query set is the reference set.
+   */
+  template<typename ResultsType>
+  void DualTreeSearch(Tree& queryTree,
+                      const math::Range& range,
+                      ResultsType& results,
+                      const bool sameSet);
+
+  /**
+   * Count the reference points in the given range of each query point, with
+   * naive, single-tree, or dual-tree search, and map the counts back to the
+   * original query indices.  If existence is true, the search for each query
+   * point stops at its first hit (and dual-tree search is not used).
+   *
+   * @param querySet Set of query points.
+   * @param range Range of distances in which to search.
+   * @param counts Vector which will hold the number of points in the range of
+   *      each query point.
+   * @param sameSet Whether or not the query set is the reference set.
+   * @param existence Whether or not only the existence of a hit matters.
+   */
+  void CountResults(const MatType& querySet,
+                    const math::Range& range,
+                    arma::Col<size_t>& counts,
+                    const bool sameSet,
+                    const bool existence);
+
   //! For access to mappings when building models.
   friend RSModel;
 };
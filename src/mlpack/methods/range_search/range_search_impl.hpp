@@ -10,8 +10,13 @@
 // Just in case it hasn't been included.
 #include "range_search.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 // The rules for traversal.
 #include "range_search_rules.hpp"
+#include "range_search_task.hpp"
 
 namespace mlpack {
 namespace range {
@@ -78,6 +83,8 @@ RangeSearch<MetricType, MatType, TreeType>::RangeSearch(
     setOwner(false),
     naive(naive),
     singleMode(!naive && singleMode), // Naive overrides single mode.
+    parallel(false),
+    reorderQueries(false),
     metric(metric),
     baseCases(0),
     scores(0)
@@ -104,6 +111,8 @@ RangeSearch<MetricType, MatType, TreeType>::RangeSearch(
     setOwner(naive),
     naive(naive),
     singleMode(!naive && singleMode),
+    parallel(false),
+    reorderQueries(false),
     metric(metric),
     baseCases(0),
     scores(0)
@@ -126,6 +135,8 @@ RangeSearch<MetricType, MatType, TreeType>::RangeSearch(
     setOwner(false),
     naive(false),
     singleMode(singleMode),
+    parallel(false),
+    reorderQueries(false),
     metric(metric),
     baseCases(0),
     scores(0)
@@ -148,6 +159,8 @@ RangeSearch<MetricType, MatType, TreeType>::RangeSearch(
     setOwner(true),
     naive(naive),
     singleMode(singleMode),
+    parallel(false),
+    reorderQueries(false),
     metric(metric),
     baseCases(0),
     scores(0)
@@ -348,17 +361,7 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
   }
   else if (singleMode)
   {
-    // Create the traverser.
-    RuleType rules(*referenceSet, querySet, range, *neighborPtr, *distancePtr,
-        metric);
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < querySet.n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
-
-    baseCases += rules.BaseCases();
-    scores += rules.Scores();
+    SingleTreeSearch(querySet, range, *neighborPtr, *distancePtr, false);
   }
   else // Dual-tree recursion.
   {
@@ -370,15 +373,8 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
     Timer::Stop("range_search/tree_building");
     Timer::Start("range_search/computing_neighbors");
 
-    // Create the traverser.
-    RuleType rules(*referenceSet, queryTree->Dataset(), range, *neighborPtr,
-        *distancePtr, metric);
-    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
-
-    traverser.Traverse(*queryTree, *referenceTree);
-
-    baseCases += rules.BaseCases();
-    scores += rules.Scores();
+    VectorRangeResults results(*neighborPtr, *distancePtr);
+    DualTreeSearch(*queryTree, range, results, false);
 
     // Clean up tree memory.
     delete queryTree;
@@ -486,21 +482,13 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
   distances.clear();
   distances.resize(querySet.n_cols);
 
-  // Create the helper object for the traversal.
-  typedef RangeSearchRules<MetricType, Tree> RuleType;
-  RuleType rules(*referenceSet, queryTree->Dataset(), range, *neighborPtr,
-      distances, metric);
-
-  // Create the traverser.
-  typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
-
-  traverser.Traverse(*queryTree, *referenceTree);
+  baseCases = 0;
+  scores = 0;
+  VectorRangeResults results(*neighborPtr, distances);
+  DualTreeSearch(*queryTree, range, results, false);
 
   Timer::Stop("range_search/computing_neighbors");
 
-  baseCases = rules.BaseCases();
-  scores = rules.Scores();
-
   // Do we need to map indices?
   if (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset)
   {
@@ -566,25 +554,16 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
   }
   else if (singleMode)
   {
-    // Create the traverser.
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
-
-    baseCases = rules.BaseCases();
-    scores = rules.Scores();
+    baseCases = 0;
+    scores = 0;
+    SingleTreeSearch(*referenceSet, range, *neighborPtr, *distancePtr, true);
   }
   else // Dual-tree recursion.
   {
-    // Create the traverser.
-    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
-
-    traverser.Traverse(*referenceTree, *referenceTree);
-
-    baseCases = rules.BaseCases();
-    scores = rules.Scores();
+    baseCases = 0;
+    scores = 0;
+    VectorRangeResults results(*neighborPtr, *distancePtr);
+    DualTreeSearch(*referenceTree, range, results, true);
   }
 
   Timer::Stop("range_search/computing_neighbors");
@@ -617,6 +596,722 @@ void RangeSearch<MetricType, MatType, TreeType>::Search(
   }
 }
 
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::SingleTreeSearch(
+    const MatType& querySet,
+    const math::Range& range,
+    std::vector<std::vector<size_t>>& neighbors,
+    std::vector<std::vector<double>>& distances,
+    const bool sameSet)
+{
+  typedef RangeSearchRules<MetricType, Tree> RuleType;
+  typedef typename Tree::template SingleTreeTraverser<RuleType> TraverserType;
+
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+
+  // Each query point only writes to its own results, so they can be searched
+  // in any order.
+  std::vector<size_t> queryOrder;
+  tree::QueryOrder(querySet, queryOrder, reorderQueries);
+
+  // Trees with self-children cache the last point-to-node distance in the
+  // statistic of each reference node during single-tree search, so threads
+  // cannot share the reference tree.
+  if (!parallel || numThreads == 1 || tree::TreeTraits<Tree>::HasSelfChildren)
+  {
+    // Create the traverser.
+    RuleType rules(*referenceSet, querySet, range, neighbors, distances, metric,
+        sameSet);
+    TraverserType traverser(rules);
+
+    // Now have it traverse for each point.
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+      traverser.Traverse(queryOrder[i], *referenceTree);
+
+    baseCases += rules.BaseCases();
+    scores += rules.Scores();
+    return;
+  }
+
+  size_t totalBaseCases = 0;
+  size_t totalScores = 0;
+
+  #pragma omp parallel reduction(+:totalBaseCases, totalScores)
+  {
+    // Each thread has its own rules, traverser, and metric; the results for
+    // each query point are only ever touched by the thread that searches it.
+    MetricType threadMetric(metric);
+    RuleType rules(*referenceSet, querySet, range, neighbors, distances,
+        threadMetric, sameSet);
+    TraverserType traverser(rules);
+
+    #pragma omp for schedule(dynamic, 64)
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+      traverser.Traverse(queryOrder[i], *referenceTree);
+
+    totalBaseCases += rules.BaseCases();
+    totalScores += rules.Scores();
+  }
+
+  baseCases += totalBaseCases;
+  scores += totalScores;
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    const MatType& querySet,
+    const math::Range& range,
+    CSRRangeResults& results)
+{
+  if (querySet.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "RangeSearch::Search(): dimensionalities of query set ("
+        << querySet.n_rows << ") and reference set (" << referenceSet->n_rows
+        << ") do not match!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  Timer::Start("range_search/computing_neighbors");
+
+  // This will hold mappings for query points, if necessary.
+  std::vector<size_t> oldFromNewQueries;
+
+  results.Reset(querySet.n_cols);
+
+  typedef RangeSearchRules<MetricType, Tree> RuleType;
+
+  // Reset counts.
+  baseCases = 0;
+  scores = 0;
+
+  if (naive)
+  {
+    RuleType rules(*referenceSet, querySet, range, results, metric);
+
+    // The naive brute-force solution.
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+      for (size_t j = 0; j < referenceSet->n_cols; ++j)
+        rules.BaseCase(i, j);
+
+    baseCases += (querySet.n_cols * referenceSet->n_cols);
+  }
+  else if (singleMode)
+  {
+    SingleTreeSearch(querySet, range, results, false);
+  }
+  else // Dual-tree recursion.
+  {
+    // Build the query tree.
+    Timer::Stop("range_search/computing_neighbors");
+    Timer::Start("range_search/tree_building");
+    Tree* queryTree = BuildTree<Tree>(const_cast<MatType&>(querySet),
+        oldFromNewQueries);
+    Timer::Stop("range_search/tree_building");
+    Timer::Start("range_search/computing_neighbors");
+
+    DualTreeSearch(*queryTree, range, results, false);
+
+    // Clean up tree memory.
+    delete queryTree;
+  }
+
+  results.Finalize();
+
+  Timer::Stop("range_search/computing_neighbors");
+
+  // Map points back to original indices, if necessary.
+  if (tree::TreeTraits<Tree>::RearrangesDataset)
+  {
+    if (!singleMode && !naive)
+      results.MapQueries(oldFromNewQueries);
+    if (treeOwner)
+      results.MapReferences(oldFromNewReferences);
+  }
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    Tree* queryTree,
+    const math::Range& range,
+    CSRRangeResults& results)
+{
+  Timer::Start("range_search/computing_neighbors");
+
+  // Make sure we are in dual-tree mode.
+  if (singleMode || naive)
+    throw std::invalid_argument("cannot call RangeSearch::Search() with a "
+        "query tree when naive or singleMode are set to true");
+
+  results.Reset(queryTree->Dataset().n_cols);
+
+  baseCases = 0;
+  scores = 0;
+  DualTreeSearch(*queryTree, range, results, false);
+
+  results.Finalize();
+
+  Timer::Stop("range_search/computing_neighbors");
+
+  // We must map reference indices only.
+  if (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset)
+    results.MapReferences(oldFromNewReferences);
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    const math::Range& range,
+    CSRRangeResults& results)
+{
+  Timer::Start("range_search/computing_neighbors");
+
+  results.Reset(referenceSet->n_cols);
+
+  // Create the helper object for the traversal.
+  typedef RangeSearchRules<MetricType, Tree> RuleType;
+  RuleType rules(*referenceSet, *referenceSet, range, results, metric,
+      true /* don't return the query in the results */);
+
+  if (naive)
+  {
+    // The naive brute-force solution.
+    for (size_t i = 0; i < referenceSet->n_cols; ++i)
+      for (size_t j = 0; j < referenceSet->n_cols; ++j)
+        rules.BaseCase(i, j);
+
+    baseCases = (referenceSet->n_cols * referenceSet->n_cols);
+    scores = 0;
+  }
+  else if (singleMode)
+  {
+    baseCases = 0;
+    scores = 0;
+    SingleTreeSearch(*referenceSet, range, results, true);
+  }
+  else // Dual-tree recursion.
+  {
+    baseCases = 0;
+    scores = 0;
+    DualTreeSearch(*referenceTree, range, results, true);
+  }
+
+  results.Finalize();
+
+  Timer::Stop("range_search/computing_neighbors");
+
+  // Do we need to map the query and reference indices?
+  if (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset)
+  {
+    results.MapQueries(oldFromNewReferences);
+    results.MapReferences(oldFromNewReferences);
+  }
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::SingleTreeSearch(
+    const MatType& querySet,
+    const math::Range& range,
+    CSRRangeResults& results,
+    const bool sameSet)
+{
+  typedef RangeSearchRules<MetricType, Tree> RuleType;
+  typedef typename Tree::template SingleTreeTraverser<RuleType> TraverserType;
+
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+
+  // Trees with self-children cache the last point-to-node distance in the
+  // statistic of each reference node during single-tree search, so threads
+  // cannot share the reference tree.
+  if (!parallel || numThreads == 1 || tree::TreeTraits<Tree>::HasSelfChildren)
+  {
+    // Create the traverser.
+    RuleType rules(*referenceSet, querySet, range, results, metric, sameSet);
+    TraverserType traverser(rules);
+
+    // Now have it traverse for each point.  The results arrive in order, so
+    // nothing but the results themselves is stored.
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+      traverser.Traverse(i, *referenceTree);
+
+    baseCases += rules.BaseCases();
+    scores += rules.Scores();
+    return;
+  }
+
+  size_t totalBaseCases = 0;
+  size_t totalScores = 0;
+
+  #pragma omp parallel reduction(+:totalBaseCases, totalScores)
+  {
+    // Each thread has its own rules, traverser, metric, and results, and the
+    // results of all threads are combined at the end.
+    MetricType threadMetric(metric);
+    CSRRangeResults threadResults;
+    threadResults.Reset(querySet.n_cols);
+    RuleType rules(*referenceSet, querySet, range, threadResults, threadMetric,
+        sameSet);
+    TraverserType traverser(rules);
+
+    #pragma omp for schedule(dynamic, 64)
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+      traverser.Traverse(i, *referenceTree);
+
+    #pragma omp critical
+    results.Add(threadResults);
+
+    totalBaseCases += rules.BaseCases();
+    totalScores += rules.Scores();
+  }
+
+  baseCases += totalBaseCases;
+  scores += totalScores;
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename CallbackType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    const MatType& querySet,
+    const math::Range& range,
+    CallbackType& callback)
+{
+  if (querySet.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "RangeSearch::Search(): dimensionalities of query set ("
+        << querySet.n_rows << ") and reference set (" << referenceSet->n_rows
+        << ") do not match!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  CallbackSearch(querySet, range, callback, false);
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename CallbackType>
+void RangeSearch<MetricType, MatType, TreeType>::Search(
+    const math::Range& range,
+    CallbackType& callback)
+{
+  CallbackSearch(*referenceSet, range, callback, true);
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename CallbackType>
+void RangeSearch<MetricType, MatType, TreeType>::CallbackSearch(
+    const MatType& querySet,
+    const math::Range& range,
+    CallbackType& callback,
+    const bool sameSet)
+{
+  Timer::Start("range_search/computing_neighbors");
+
+  // This will hold mappings for query points, if necessary.
+  std::vector<size_t> oldFromNewQueries;
+
+  // The results are mapped as they are found, since they are never stored.
+  const std::vector<size_t>* referenceMap = NULL;
+  if (treeOwner && tree::TreeTraits<Tree>::RearrangesDataset)
+    referenceMap = &oldFromNewReferences;
+
+  typedef MappedCallback<CallbackType> MappedCallbackType;
+  typedef RangeSearchRules<MetricType, Tree, MappedCallbackType> RuleType;
+
+  // Reset counts.
+  baseCases = 0;
+  scores = 0;
+
+  if (naive)
+  {
+    // Nothing is rearranged in naive mode.
+    MappedCallbackType mappedCallback(callback, NULL, NULL);
+    RuleType rules(*referenceSet, querySet, range, mappedCallback, metric,
+        sameSet);
+
+    // The naive brute-force solution.
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+      for (size_t j = 0; j < referenceSet->n_cols; ++j)
+        rules.BaseCase(i, j);
+
+    baseCases = rules.BaseCases();
+  }
+  else if (singleMode)
+  {
+    // In the monochromatic setting, the query points are the rearranged
+    // reference points.
+    MappedCallbackType mappedCallback(callback, sameSet ? referenceMap : NULL,
+        referenceMap);
+    RuleType rules(*referenceSet, querySet, range, mappedCallback, metric,
+        sameSet);
+    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
+
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+      traverser.Traverse(i, *referenceTree);
+
+    baseCases = rules.BaseCases();
+    scores = rules.Scores();
+  }
+  else if (sameSet)
+  {
+    MappedCallbackType mappedCallback(callback, referenceMap, referenceMap);
+    RuleType rules(*referenceSet, *referenceSet, range, mappedCallback, metric,
+        true);
+    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+
+    traverser.Traverse(*referenceTree, *referenceTree);
+
+    baseCases = rules.BaseCases();
+    scores = rules.Scores();
+  }
+  else // Dual-tree recursion.
+  {
+    // Build the query tree.
+    Timer::Stop("range_search/computing_neighbors");
+    Timer::Start("range_search/tree_building");
+    Tree* queryTree = BuildTree<Tree>(const_cast<MatType&>(querySet),
+        oldFromNewQueries);
+    Timer::Stop("range_search/tree_building");
+    Timer::Start("range_search/computing_neighbors");
+
+    MappedCallbackType mappedCallback(callback,
+        tree::TreeTraits<Tree>::RearrangesDataset ? &oldFromNewQueries : NULL,
+        referenceMap);
+    RuleType rules(*referenceSet, queryTree->Dataset(), range, mappedCallback,
+        metric);
+    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+
+    traverser.Traverse(*queryTree, *referenceTree);
+
+    baseCases = rules.BaseCases();
+    scores = rules.Scores();
+
+    delete queryTree;
+  }
+
+  Timer::Stop("range_search/computing_neighbors");
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::Count(
+    const MatType& querySet,
+    const math::Range& range,
+    arma::Col<size_t>& counts)
+{
+  if (querySet.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "RangeSearch::Count(): dimensionalities of query set ("
+        << querySet.n_rows << ") and reference set (" << referenceSet->n_rows
+        << ") do not match!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  CountResults(querySet, range, counts, false, false);
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::Count(
+    const math::Range& range,
+    arma::Col<size_t>& counts)
+{
+  CountResults(*referenceSet, range, counts, true, false);
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::Exists(
+    const MatType& querySet,
+    const math::Range& range,
+    std::vector<bool>& exists)
+{
+  if (querySet.n_rows != referenceSet->n_rows)
+  {
+    std::ostringstream oss;
+    oss << "RangeSearch::Exists(): dimensionalities of query set ("
+        << querySet.n_rows << ") and reference set (" << referenceSet->n_rows
+        << ") do not match!";
+    throw std::invalid_argument(oss.str());
+  }
+
+  arma::Col<size_t> counts;
+  CountResults(querySet, range, counts, false, true);
+
+  exists.resize(counts.n_elem);
+  for (size_t i = 0; i < counts.n_elem; ++i)
+    exists[i] = (counts[i] > 0);
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::Exists(
+    const math::Range& range,
+    std::vector<bool>& exists)
+{
+  arma::Col<size_t> counts;
+  CountResults(*referenceSet, range, counts, true, true);
+
+  exists.resize(counts.n_elem);
+  for (size_t i = 0; i < counts.n_elem; ++i)
+    exists[i] = (counts[i] > 0);
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RangeSearch<MetricType, MatType, TreeType>::CountResults(
+    const MatType& querySet,
+    const math::Range& range,
+    arma::Col<size_t>& counts,
+    const bool sameSet,
+    const bool existence)
+{
+  Timer::Start("range_search/computing_neighbors");
+
+  // This will hold mappings for query points, if necessary.
+  std::vector<size_t> oldFromNewQueries;
+
+  counts.zeros(querySet.n_cols);
+
+  typedef RangeSearchRules<MetricType, Tree> RuleType;
+  typedef typename Tree::template SingleTreeTraverser<RuleType> TraverserType;
+
+  // Reset counts.
+  baseCases = 0;
+  scores = 0;
+
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+
+  if (naive)
+  {
+    RuleType rules(*referenceSet, querySet, range, counts, metric, sameSet,
+        existence);
+
+    // The naive brute-force solution, which can stop at the first hit if only
+    // its existence matters.
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+    {
+      for (size_t j = 0; j < referenceSet->n_cols; ++j)
+      {
+        rules.BaseCase(i, j);
+        if (existence && counts[i] > 0)
+          break;
+      }
+    }
+
+    baseCases = rules.BaseCases();
+  }
+  else if (singleMode || existence)
+  {
+    // Dual-tree search can't stop for a single query point, so single-tree
+    // search is used to find whether hits exist.
+    std::vector<size_t> queryOrder;
+    tree::QueryOrder(querySet, queryOrder, reorderQueries);
+    if (!parallel || numThreads == 1 ||
+        tree::TreeTraits<Tree>::HasSelfChildren)
+    {
+      RuleType rules(*referenceSet, querySet, range, counts, metric, sameSet,
+          existence);
+      TraverserType traverser(rules);
+
+      for (size_t i = 0; i < querySet.n_cols; ++i)
+        traverser.Traverse(queryOrder[i], *referenceTree);
+
+      baseCases = rules.BaseCases();
+      scores = rules.Scores();
+    }
+    else
+    {
+      size_t totalBaseCases = 0;
+      size_t totalScores = 0;
+
+      #pragma omp parallel reduction(+:totalBaseCases, totalScores)
+      {
+        // The count for each query point is only ever touched by the thread
+        // that searches it.
+        MetricType threadMetric(metric);
+        RuleType rules(*referenceSet, querySet, range, counts, threadMetric,
+            sameSet, existence);
+        TraverserType traverser(rules);
+
+        #pragma omp for schedule(dynamic, 64)
+        for (size_t i = 0; i < querySet.n_cols; ++i)
+          traverser.Traverse(queryOrder[i], *referenceTree);
+
+        totalBaseCases += rules.BaseCases();
+        totalScores += rules.Scores();
+      }
+
+      baseCases = totalBaseCases;
+      scores = totalScores;
+    }
+  }
+  else if (sameSet)
+  {
+    DualTreeSearch(*referenceTree, range, counts, true);
+  }
+  else // Dual-tree recursion.
+  {
+    // Build the query tree.
+    Timer::Stop("range_search/computing_neighbors");
+    Timer::Start("range_search/tree_building");
+    Tree* queryTree = BuildTree<Tree>(const_cast<MatType&>(querySet),
+        oldFromNewQueries);
+    Timer::Stop("range_search/tree_building");
+    Timer::Start("range_search/computing_neighbors");
+
+    DualTreeSearch(*queryTree, range, counts, false);
+
+    delete queryTree;
+  }
+
+  Timer::Stop("range_search/computing_neighbors");
+
+  // Only the query indices need to be mapped, since no reference indices are
+  // stored.
+  if (tree::TreeTraits<Tree>::RearrangesDataset)
+  {
+    const std::vector<size_t>* oldFromNew = NULL;
+    if (sameSet && treeOwner)
+      oldFromNew = &oldFromNewReferences;
+    else if (!sameSet && !singleMode && !naive && !existence)
+      oldFromNew = &oldFromNewQueries;
+
+    if (oldFromNew)
+    {
+      arma::Col<size_t> mappedCounts(counts.n_elem);
+      for (size_t i = 0; i < counts.n_elem; ++i)
+        mappedCounts[(*oldFromNew)[i]] = counts[i];
+      counts = mappedCounts;
+    }
+  }
+}
+
+template<typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+template<typename ResultsType>
+void RangeSearch<MetricType, MatType, TreeType>::DualTreeSearch(
+    Tree& queryTree,
+    const math::Range& range,
+    ResultsType& results,
+    const bool sameSet)
+{
+  typedef RangeSearchRules<MetricType, Tree> RuleType;
+  typedef typename Tree::template DualTreeTraverser<RuleType> TraverserType;
+  typedef RangeSearchTask<RuleType, ResultsType> TaskType;
+
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+
+  // Trees with self-children evaluate base cases for the first point of each
+  // node while scoring, so a query subtree can't be searched on its own.
+  if (!parallel || numThreads == 1 || tree::TreeTraits<Tree>::HasSelfChildren)
+  {
+    TaskType task(*referenceSet, queryTree.Dataset(), range, results, metric,
+        sameSet, false);
+    TraverserType traverser(task.Rules());
+
+    traverser.Traverse(queryTree, *referenceTree);
+    task.Finish();
+
+    baseCases += task.Rules().BaseCases();
+    scores += task.Rules().Scores();
+    return;
+  }
+
+  std::vector<Tree*> subtrees;
+  tree::SubtreeFrontier(queryTree, 4 * numThreads, subtrees);
+
+  size_t totalBaseCases = 0;
+  size_t totalScores = 0;
+
+  #pragma omp parallel reduction(+:totalBaseCases, totalScores)
+  {
+    // The task decides whether this thread writes its results directly or
+    // collects them to be combined at the end.
+    MetricType threadMetric(metric);
+    TaskType task(*referenceSet, queryTree.Dataset(), range, results,
+        threadMetric, sameSet, true);
+    TraverserType traverser(task.Rules());
+
+    #pragma omp for schedule(dynamic, 1)
+    for (size_t i = 0; i < subtrees.size(); ++i)
+      traverser.Traverse(*subtrees[i], *referenceTree);
+
+    task.Finish();
+
+    totalBaseCases += task.Rules().BaseCases();
+    totalScores += task.Rules().Scores();
+  }
+
+  baseCases += totalBaseCases;
+  scores += totalScores;
+}
+
 template<typename MetricType,
          typename MatType,
          template<typename TreeMetricType,
@@ -47,13 +47,24 @@ PROGRAM_INFO("Range Search",
     " resultant CSV-like files may not be loadable by many programs.  However, "
     "at this time a better way to store this non-square result is not known.  "
     "As a result, any output files will be written as CSVs in this manner, "
-    "regardless of the given extension.");
+    "regardless of the given extension."
+    "\n\n"
+    "For large results, the --binary_output_file option writes the neighbors "
+    "and distances to a single binary file in compressed sparse row form, "
+    "which is much faster to write and read.  The file holds the eight "
+    "characters 'MLPKCSR1', then the number of query points Q and the number of results N "
+    "(as 64-bit unsigned integers), then Q + 1 offsets and N neighbor indices "
+    "(as 64-bit unsigned integers), then N distances (as doubles), all in "
+    "native byte order.  The results for query point i are held from offset i "
+    "up to (but not including) offset i + 1.");
 
 // Define our input parameters that this program will take.
 PARAM_STRING("reference_file", "File containing the reference dataset.", "r",
     "");
 PARAM_STRING("distances_file", "File to output distances into.", "d", "");
 PARAM_STRING("neighbors_file", "File to output neighbors into.", "n", "");
+PARAM_STRING("binary_output_file", "File to output neighbors and distances "
+    "into, in a binary compressed sparse row format.", "B", "");
 
 // The option exists to load or save models.
 PARAM_STRING("input_model_file", "File containing pre-trained range search "
@@ -70,7 +81,7 @@ PARAM_DOUBLE("min", "Lower bound in range.", "L", 0.0);
 // The user may specify the type of tree to use, and a few parameters for tree
 // building.
 PARAM_STRING("tree_type", "Type of tree to use: 'kd', 'cover', 'r', 'r-star', "
-    "'ball'.", "t", "kd");
+    "'ball', 'vp'.", "t", "kd");
 PARAM_INT("leaf_size", "Leaf size for tree building.", "l", 20);
 PARAM_FLAG("random_basis", "Before tree-building, project the data onto a "
     "random orthogonal basis.", "R");
@@ -80,6 +91,10 @@ PARAM_INT("seed", "Random seed (if 0, std::time(NULL) is used).", "s", 0);
 PARAM_FLAG("naive", "If true, O(n^2) naive mode is used for computation.", "N");
 PARAM_FLAG("single_mode", "If true, single-tree search is used (as opposed to "
     "dual-tree search).", "s");
+PARAM_FLAG("parallel", "If true, tree-based search is split across multiple "
+    "threads: single-tree search splits the query points, and dual-tree search "
+    "splits the query tree (only available if mlpack was compiled with "
+    "OpenMP).", "P");
 
 typedef RangeSearch<> RSType;
 typedef CoverTree<EuclideanDistance, RangeSearchStat> CoverTreeType;
@@ -131,17 +146,20 @@ int main(int argc, char *argv[])
 
   // If the user specifies a range but not output files, they should be warned.
   if ((CLI::HasParam("min") || CLI::HasParam("max")) &&
-      !(CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file")))
-    Log::Warn << "Neither --neighbors_file nor --distances_file is specified, "
-        << "so the range search results will not be saved!" << endl;
+      !(CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file") ||
+      CLI::HasParam("binary_output_file")))
+    Log::Warn << "Neither --neighbors_file, --distances_file, nor "
+        << "--binary_output_file is specified, so the range search results "
+        << "will not be saved!" << endl;
 
   // If the user specifies output files but no range, they should be warned.
-  if ((CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file")) &&
+  if ((CLI::HasParam("neighbors_file") || CLI::HasParam("distances_file") ||
+      CLI::HasParam("binary_output_file")) &&
       !(CLI::HasParam("min") || CLI::HasParam("max")))
-    Log::Warn << "An output file for range search is given (--neighbors_file "
-        << "or --distances_file), but range search is not being performed "
-        << "because neither --min nor --max are specified!  No results will be "
-        << "saved." << endl;
+    Log::Warn << "An output file for range search is given (--neighbors_file, "
+        << "--distances_file, or --binary_output_file), but range search is "
+        << "not being performed because neither --min nor --max are specified!"
+        << "  No results will be saved." << endl;
 
   // Sanity check on leaf size.
   int lsInt = CLI::GetParam<int>("leaf_size");
@@ -171,9 +189,11 @@ int main(int argc, char *argv[])
       tree = RSModel::R_STAR_TREE;
     else if (treeType == "ball")
       tree = RSModel::BALL_TREE;
+    else if (treeType == "vp")
+      tree = RSModel::VP_TREE;
     else
       Log::Fatal << "Unknown tree type '" << treeType << "; valid choices are "
-          << "'kd', 'cover', 'r', 'r-star', and 'ball'." << endl;
+          << "'kd', 'cover', 'r', 'r-star', 'ball', and 'vp'." << endl;
 
     rs.TreeType() = tree;
     rs.RandomBasis() = randomBasis;
@@ -204,6 +224,9 @@ int main(int argc, char *argv[])
     rs.LeafSize() = size_t(lsInt);
   }
 
+  // Set whether or not the search should be parallelized.
+  rs.Parallel() = CLI::HasParam("parallel");
+
   // Perform search, if desired.
   if (CLI::HasParam("min") || CLI::HasParam("max"))
   {
@@ -226,16 +249,17 @@ int main(int argc, char *argv[])
     if (singleMode && naive)
       Log::Warn << "--single_mode ignored because --naive is present." << endl;
 
-    // Now run the search.
-    vector<vector<size_t>> neighbors;
-    vector<vector<double>> distances;
+    // Now run the search.  The results are held in compressed sparse row
+    // form, which takes far less memory than a vector for each query point.
+    CSRRangeResults results;
 
     if (CLI::HasParam("query_file"))
-      rs.Search(std::move(queryData), r, neighbors, distances);
+      rs.Search(std::move(queryData), r, results);
     else
-      rs.Search(r, neighbors, distances);
+      rs.Search(r, results);
 
-    Log::Info << "Search complete." << endl;
+    Log::Info << "Search complete (" << results.NumResults() << " results)."
+        << endl;
 
     // Save output, if desired.  We have to do this by hand.
     if (CLI::HasParam("distances_file"))
@@ -250,15 +274,17 @@ int main(int argc, char *argv[])
       else
       {
         // Loop over each point.
-        for (size_t i = 0; i < distances.size(); ++i)
+        const vector<size_t>& offsets = results.Offsets();
+        const vector<double>& distances = results.Distances();
+        for (size_t i = 0; i < results.NumQueries(); ++i)
         {
           // Store the distances of each point.  We may have 0 points to store,
           // so we must account for that possibility.
-          for (size_t j = 0; j + 1 < distances[i].size(); ++j)
-            distancesStr << distances[i][j] << ", ";
+          for (size_t j = offsets[i]; j + 1 < offsets[i + 1]; ++j)
+            distancesStr << distances[j] << ", ";
 
-          if (distances[i].size() > 0)
-            distancesStr << distances[i][distances[i].size() - 1];
+          if (offsets[i + 1] > offsets[i])
+            distancesStr << distances[offsets[i + 1] - 1];
 
           distancesStr << endl;
         }
@@ -279,15 +305,17 @@ int main(int argc, char *argv[])
       else
       {
         // Loop over each point.
-        for (size_t i = 0; i < neighbors.size(); ++i)
+        const vector<size_t>& offsets = results.Offsets();
+        const vector<size_t>& neighbors = results.Neighbors();
+        for (size_t i = 0; i < results.NumQueries(); ++i)
         {
           // Store the neighbors of each point.  We may have 0 points to store,
           // so we must account for that possibility.
-          for (size_t j = 0; j + 1 < neighbors[i].size(); ++j)
-            neighborsStr << neighbors[i][j] << ", ";
+          for (size_t j = offsets[i]; j + 1 < offsets[i + 1]; ++j)
+            neighborsStr << neighbors[j] << ", ";
 
-          if (neighbors[i].size() > 0)
-            neighborsStr << neighbors[i][neighbors[i].size() - 1];
+          if (offsets[i + 1] > offsets[i])
+            neighborsStr << neighbors[offsets[i + 1] - 1];
 
           neighborsStr << endl;
         }
@@ -295,6 +323,9 @@ int main(int argc, char *argv[])
         neighborsStr.close();
       }
     }
+
+    if (CLI::HasParam("binary_output_file"))
+      results.Save(CLI::GetParam<string>("binary_output_file"));
   }
 
   // Save the output model, if desired.
@@ -8,12 +8,38 @@
 #define __MLPACK_METHODS_RANGE_SEARCH_RANGE_SEARCH_RULES_HPP
 
 #include "../neighbor_search/ns_traversal_info.hpp"
+#include "csr_range_results.hpp"
 
 namespace mlpack {
 namespace range {
 
+/**
+ * A callback that ignores every result; this is the default callback type of
+ * RangeSearchRules, for when results are stored instead.
+ */
+struct NullRangeCallback
+{
+  //! Ignore the given result.
+  void operator()(const size_t /* queryIndex */,
+                  const size_t /* referenceIndex */,
+                  const double /* distance */) { }
+};
 
-template<typename MetricType, typename TreeType>
+/**
+ * The rules for range search.  Results can be stored in nested vectors or in a
+ * CSRRangeResults object, only counted, or handed one at a time to a callback
+ * of type CallbackType as soon as they are found, so that they never have to be
+ * held in memory.  A callback must be callable as
+ *
+ * @code
+ * callback(queryIndex, referenceIndex, distance);
+ * @endcode
+ *
+ * and it is called exactly once for each pair of points in the range.
+ */
+template<typename MetricType,
+         typename TreeType,
+         typename CallbackType = NullRangeCallback>
 class RangeSearchRules
 {
  public:
@@ -30,14 +56,81 @@ class RangeSearchRules
    * @param sameSet If true, the query and reference set are taken to be the
    *      same, and a query point will not return itself in the results.
    */
-  RangeSearchRules(const arma::mat& referenceSet,
-                   const arma::mat& querySet,
+  RangeSearchRules(const typename TreeType::Mat& referenceSet,
+                   const typename TreeType::Mat& querySet,
                    const math::Range& range,
                    std::vector<std::vector<size_t> >& neighbors,
                    std::vector<std::vector<double> >& distances,
                    MetricType& metric,
                    const bool sameSet = false);
 
+  /**
+   * Construct the RangeSearchRules object so that the results are stored in
+   * compressed sparse row form.  The results object must already have been
+   * reset for the number of query points; it is not finalized.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param range Range to search for.
+   * @param results Object to store the results in.
+   * @param metric Instantiated metric.
+   * @param sameSet If true, the query and reference set are taken to be the
+   *      same, and a query point will not return itself in the results.
+   */
+  RangeSearchRules(const typename TreeType::Mat& referenceSet,
+                   const typename TreeType::Mat& querySet,
+                   const math::Range& range,
+                   CSRRangeResults& results,
+                   MetricType& metric,
+                   const bool sameSet = false);
+
+  /**
+   * Construct the RangeSearchRules object so that each result is handed to the
+   * given callback as soon as it is found, instead of being stored.
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param range Range to search for.
+   * @param callback Callback to call with each result.
+   * @param metric Instantiated metric.
+   * @param sameSet If true, the query and reference set are taken to be the
+   *      same, and a query point will not return itself in the results.
+   */
+  RangeSearchRules(const typename TreeType::Mat& referenceSet,
+                   const typename TreeType::Mat& querySet,
+                   const math::Range& range,
+                   CallbackType& callback,
+                   MetricType& metric,
+                   const bool sameSet = false);
+
+  /**
+   * Construct the RangeSearchRules object so that only the number of points in
+   * the range is stored for each query point.  A reference node whose whole
+   * bound is in the range adds its number of descendants at once, without
+   * computing any distances.  If existence is true, only whether or not there
+   * is a point in the range matters, so in single-tree search the traversal
+   * for a query point stops as soon as its count is nonzero (the count is then
+   * not meaningful beyond being nonzero).
+   *
+   * @param referenceSet Set of reference data.
+   * @param querySet Set of query data.
+   * @param range Range to search for.
+   * @param counts Vector to count the points in the range of each query point
+   *      in (it must be filled with zeros).
+   * @param metric Instantiated metric.
+   * @param sameSet If true, the query and reference set are taken to be the
+   *      same, and a query point will not be counted in its own range.
+   * @param existence If true, single-tree search for a query point stops after
+   *      the first point in the range is found.
+   */
+  RangeSearchRules(const typename TreeType::Mat& referenceSet,
+                   const typename TreeType::Mat& querySet,
+                   const math::Range& range,
+                   arma::Col<size_t>& counts,
+                   MetricType& metric,
+                   const bool sameSet = false,
+                   const bool existence = false);
+
   /**
    * Compute the base case between the given query point and reference point.
    *
@@ -108,19 +201,35 @@ class RangeSearchRules
 
  private:
   //! The reference set.
-  const arma::mat& referenceSet;
+  const typename TreeType::Mat& referenceSet;
 
   //! The query set.
-  const arma::mat& querySet;
+  const typename TreeType::Mat& querySet;
 
   //! The range of distances for which we are searching.
   const math::Range& range;
 
-  //! The vector the resultant neighbor indices should be stored in.
-  std::vector<std::vector<size_t> >& neighbors;
+  //! The vector the resultant neighbor indices should be stored in (NULL if
+  //! the results are stored in compressed sparse row form).
+  std::vector<std::vector<size_t> >* neighbors;
+
+  //! The vector the resultant neighbor distances should be stored in (NULL if
+  //! the results are stored in compressed sparse row form).
+  std::vector<std::vector<double> >* distances;
+
+  //! The compressed sparse row results (NULL if the results are stored in
+  //! vectors).
+  CSRRangeResults* results;
+
+  //! The number of points in the range of each query point (NULL if the
+  //! results themselves are stored).
+  arma::Col<size_t>* counts;
+
+  //! If true, single-tree search stops for a query point once it has a result.
+  bool existence;
 
-  //! The vector the resultant neighbor distances should be stored in.
-  std::vector<std::vector<double> >& distances;
+  //! The callback to hand each result to (NULL if the results are stored).
+  CallbackType* callback;
 
   //! The instantiated metric.
   MetricType& metric;
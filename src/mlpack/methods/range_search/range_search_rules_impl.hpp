@@ -13,10 +13,10 @@
 namespace mlpack {
 namespace range {
 
-template<typename MetricType, typename TreeType>
-RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
-    const arma::mat& referenceSet,
-    const arma::mat& querySet,
+template<typename MetricType, typename TreeType, typename CallbackType>
+RangeSearchRules<MetricType, TreeType, CallbackType>::RangeSearchRules(
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
     const math::Range& range,
     std::vector<std::vector<size_t> >& neighbors,
     std::vector<std::vector<double> >& distances,
@@ -25,8 +25,94 @@ RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
     referenceSet(referenceSet),
     querySet(querySet),
     range(range),
-    neighbors(neighbors),
-    distances(distances),
+    neighbors(&neighbors),
+    distances(&distances),
+    results(NULL),
+    counts(NULL),
+    existence(false),
+    callback(NULL),
+    metric(metric),
+    sameSet(sameSet),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols),
+    baseCases(0),
+    scores(0)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename TreeType, typename CallbackType>
+RangeSearchRules<MetricType, TreeType, CallbackType>::RangeSearchRules(
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
+    const math::Range& range,
+    CSRRangeResults& results,
+    MetricType& metric,
+    const bool sameSet) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    range(range),
+    neighbors(NULL),
+    distances(NULL),
+    results(&results),
+    counts(NULL),
+    existence(false),
+    callback(NULL),
+    metric(metric),
+    sameSet(sameSet),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols),
+    baseCases(0),
+    scores(0)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename TreeType, typename CallbackType>
+RangeSearchRules<MetricType, TreeType, CallbackType>::RangeSearchRules(
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
+    const math::Range& range,
+    arma::Col<size_t>& counts,
+    MetricType& metric,
+    const bool sameSet,
+    const bool existence) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    range(range),
+    neighbors(NULL),
+    distances(NULL),
+    results(NULL),
+    counts(&counts),
+    existence(existence),
+    callback(NULL),
+    metric(metric),
+    sameSet(sameSet),
+    lastQueryIndex(querySet.n_cols),
+    lastReferenceIndex(referenceSet.n_cols),
+    baseCases(0),
+    scores(0)
+{
+  // Nothing to do.
+}
+
+template<typename MetricType, typename TreeType, typename CallbackType>
+RangeSearchRules<MetricType, TreeType, CallbackType>::RangeSearchRules(
+    const typename TreeType::Mat& referenceSet,
+    const typename TreeType::Mat& querySet,
+    const math::Range& range,
+    CallbackType& callback,
+    MetricType& metric,
+    const bool sameSet) :
+    referenceSet(referenceSet),
+    querySet(querySet),
+    range(range),
+    neighbors(NULL),
+    distances(NULL),
+    results(NULL),
+    counts(NULL),
+    existence(false),
+    callback(&callback),
     metric(metric),
     sameSet(sameSet),
     lastQueryIndex(querySet.n_cols),
@@ -39,9 +125,9 @@ RangeSearchRules<MetricType, TreeType>::RangeSearchRules(
 
 //! The base case.  Evaluate the distance between the two points and add to the
 //! results if necessary.
-template<typename MetricType, typename TreeType>
+template<typename MetricType, typename TreeType, typename CallbackType>
 inline force_inline
-double RangeSearchRules<MetricType, TreeType>::BaseCase(
+double RangeSearchRules<MetricType, TreeType, CallbackType>::BaseCase(
     const size_t queryIndex,
     const size_t referenceIndex)
 {
@@ -53,8 +139,8 @@ double RangeSearchRules<MetricType, TreeType>::BaseCase(
   if ((lastQueryIndex == queryIndex) && (lastReferenceIndex == referenceIndex))
     return 0.0; // No value to return... this shouldn't do anything bad.
 
-  const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
-      referenceSet.unsafe_col(referenceIndex));
+  const double distance = metric.Evaluate(querySet.col(queryIndex),
+      referenceSet.col(referenceIndex));
   ++baseCases;
 
   // Update last indices, so we don't accidentally perform a base case twice.
@@ -63,18 +149,39 @@ double RangeSearchRules<MetricType, TreeType>::BaseCase(
 
   if (range.Contains(distance))
   {
-    neighbors[queryIndex].push_back(referenceIndex);
-    distances[queryIndex].push_back(distance);
+    if (callback)
+    {
+      (*callback)(queryIndex, referenceIndex, distance);
+    }
+    else if (counts)
+    {
+      ++(*counts)[queryIndex];
+    }
+    else if (results)
+    {
+      results->Add(queryIndex, referenceIndex, distance);
+    }
+    else
+    {
+      (*neighbors)[queryIndex].push_back(referenceIndex);
+      (*distances)[queryIndex].push_back(distance);
+    }
   }
 
   return distance;
 }
 
 //! Single-tree scoring function.
-template<typename MetricType, typename TreeType>
-double RangeSearchRules<MetricType, TreeType>::Score(const size_t queryIndex,
-                                                     TreeType& referenceNode)
+template<typename MetricType, typename TreeType, typename CallbackType>
+double RangeSearchRules<MetricType, TreeType, CallbackType>::Score(
+    const size_t queryIndex,
+    TreeType& referenceNode)
 {
+  // If only the existence of a result matters, a query point that has one is
+  // done.
+  if (existence && (*counts)[queryIndex] > 0)
+    return DBL_MAX;
+
   // We must get the minimum and maximum distances and store them in this
   // object.
   math::Range distances;
@@ -109,7 +216,7 @@ double RangeSearchRules<MetricType, TreeType>::Score(const size_t queryIndex,
   }
   else
   {
-    distances = referenceNode.RangeDistance(querySet.unsafe_col(queryIndex));
+    distances = referenceNode.RangeDistance(querySet.col(queryIndex));
     ++scores;
   }
 
@@ -131,20 +238,26 @@ double RangeSearchRules<MetricType, TreeType>::Score(const size_t queryIndex,
 }
 
 //! Single-tree rescoring function.
-template<typename MetricType, typename TreeType>
-double RangeSearchRules<MetricType, TreeType>::Rescore(
-    const size_t /* queryIndex */,
+template<typename MetricType, typename TreeType, typename CallbackType>
+double RangeSearchRules<MetricType, TreeType, CallbackType>::Rescore(
+    const size_t queryIndex,
     TreeType& /* referenceNode */,
     const double oldScore) const
 {
+  // If only the existence of a result matters, a query point that has one is
+  // done.
+  if (existence && (*counts)[queryIndex] > 0)
+    return DBL_MAX;
+
   // If it wasn't pruned before, it isn't pruned now.
   return oldScore;
 }
 
 //! Dual-tree scoring function.
-template<typename MetricType, typename TreeType>
-double RangeSearchRules<MetricType, TreeType>::Score(TreeType& queryNode,
-                                                     TreeType& referenceNode)
+template<typename MetricType, typename TreeType, typename CallbackType>
+double RangeSearchRules<MetricType, TreeType, CallbackType>::Score(
+    TreeType& queryNode,
+    TreeType& referenceNode)
 {
   math::Range distances;
   if (tree::TreeTraits<TreeType>::FirstPointIsCentroid)
@@ -204,8 +317,8 @@ double RangeSearchRules<MetricType, TreeType>::Score(TreeType& queryNode,
 }
 
 //! Dual-tree rescoring function.
-template<typename MetricType, typename TreeType>
-double RangeSearchRules<MetricType, TreeType>::Rescore(
+template<typename MetricType, typename TreeType, typename CallbackType>
+double RangeSearchRules<MetricType, TreeType, CallbackType>::Rescore(
     TreeType& /* queryNode */,
     TreeType& /* referenceNode */,
     const double oldScore) const
@@ -216,9 +329,10 @@ double RangeSearchRules<MetricType, TreeType>::Rescore(
 
 //! Add all the points in the given node to the results for the given query
 //! point.
-template<typename MetricType, typename TreeType>
-void RangeSearchRules<MetricType, TreeType>::AddResult(const size_t queryIndex,
-                                                       TreeType& referenceNode)
+template<typename MetricType, typename TreeType, typename CallbackType>
+void RangeSearchRules<MetricType, TreeType, CallbackType>::AddResult(
+    const size_t queryIndex,
+    TreeType& referenceNode)
 {
   // Some types of trees calculate the base case evaluation before Score() is
   // called, so if the base case has already been calculated, then we must avoid
@@ -231,14 +345,37 @@ void RangeSearchRules<MetricType, TreeType>::AddResult(const size_t queryIndex,
     baseCaseMod = 1;
   }
 
+  // If we are only counting, no distances need to be computed.
+  if (counts)
+  {
+    size_t count = referenceNode.NumDescendants() - baseCaseMod;
+    if (&referenceSet == &querySet)
+    {
+      for (size_t i = baseCaseMod; i < referenceNode.NumDescendants(); ++i)
+      {
+        if (queryIndex == referenceNode.Descendant(i))
+        {
+          --count;
+          break;
+        }
+      }
+    }
+
+    (*counts)[queryIndex] += count;
+    return;
+  }
+
   // Resize distances and neighbors vectors appropriately.  We have to use
   // reserve() and not resize(), because we don't know if we will encounter the
   // case where the datasets and points are the same (and we skip in that case).
-  const size_t oldSize = neighbors[queryIndex].size();
-  neighbors[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
-      baseCaseMod);
-  distances[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
-      baseCaseMod);
+  if (neighbors)
+  {
+    const size_t oldSize = (*neighbors)[queryIndex].size();
+    (*neighbors)[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
+        baseCaseMod);
+    (*distances)[queryIndex].reserve(oldSize + referenceNode.NumDescendants() -
+        baseCaseMod);
+  }
 
   for (size_t i = baseCaseMod; i < referenceNode.NumDescendants(); ++i)
   {
@@ -246,11 +383,22 @@ void RangeSearchRules<MetricType, TreeType>::AddResult(const size_t queryIndex,
         (queryIndex == referenceNode.Descendant(i)))
       continue;
 
-    const double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
-        referenceNode.Dataset().unsafe_col(referenceNode.Descendant(i)));
+    const double distance = metric.Evaluate(querySet.col(queryIndex),
+        referenceNode.Dataset().col(referenceNode.Descendant(i)));
 
-    neighbors[queryIndex].push_back(referenceNode.Descendant(i));
-    distances[queryIndex].push_back(distance);
+    if (callback)
+    {
+      (*callback)(queryIndex, referenceNode.Descendant(i), distance);
+    }
+    else if (results)
+    {
+      results->Add(queryIndex, referenceNode.Descendant(i), distance);
+    }
+    else
+    {
+      (*neighbors)[queryIndex].push_back(referenceNode.Descendant(i));
+      (*distances)[queryIndex].push_back(distance);
+    }
   }
 }
 
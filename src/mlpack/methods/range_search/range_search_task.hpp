@@ -0,0 +1,167 @@
+/**
+ * @file range_search_task.hpp
+ * @author Ryan Curtin
+ *
+ * RangeSearchTask, which holds the rules that one thread of a dual-tree range
+ * search uses, for each of the ways that the results can be stored.
+ */
+#ifndef __MLPACK_METHODS_RANGE_SEARCH_RANGE_SEARCH_TASK_HPP
+#define __MLPACK_METHODS_RANGE_SEARCH_RANGE_SEARCH_TASK_HPP
+
+#include <mlpack/core.hpp>
+#include "csr_range_results.hpp"
+
+namespace mlpack {
+namespace range {
+
+/**
+ * The neighbors and distances of each query point, held together so that they
+ * can be given to RangeSearchTask as a single results object.
+ */
+struct VectorRangeResults
+{
+  //! Hold references to the given neighbors and distances.
+  VectorRangeResults(std::vector<std::vector<size_t>>& neighbors,
+                     std::vector<std::vector<double>>& distances) :
+      neighbors(neighbors), distances(distances) { }
+
+  //! The neighbors of each query point.
+  std::vector<std::vector<size_t>>& neighbors;
+  //! The distances of each neighbor.
+  std::vector<std::vector<double>>& distances;
+};
+
+/**
+ * The rules for one thread of a dual-tree range search (or for the whole
+ * search, if it is serial), which store results in the given object.  Each
+ * query point belongs to exactly one query subtree, so results that are held
+ * per query point (counts, as here, and vectors of neighbors and distances)
+ * are written directly by every thread, and Finish() does nothing.
+ *
+ * @tparam RuleType Type of RangeSearchRules to use.
+ * @tparam ResultsType Type of the results: arma::Col<size_t> for counts,
+ *     VectorRangeResults, or CSRRangeResults.
+ */
+template<typename RuleType, typename ResultsType>
+class RangeSearchTask
+{
+ public:
+  /**
+   * Construct the rules for the given search.
+   *
+   * @param referenceSet Set of reference points.
+   * @param querySet Set of query points.
+   * @param range Range of distances in which to search.
+   * @param results Object which will hold the results.
+   * @param metric Instantiated metric for this task.
+   * @param sameSet Whether or not the query set is the reference set.
+   * @param parallel Whether or not other tasks write to the same results.
+   */
+  template<typename MatType, typename MetricType>
+  RangeSearchTask(const MatType& referenceSet,
+                  const MatType& querySet,
+                  const math::Range& range,
+                  ResultsType& results,
+                  MetricType& metric,
+                  const bool sameSet,
+                  const bool /* parallel */) :
+      rules(referenceSet, querySet, range, results, metric, sameSet) { }
+
+  //! Get the rules.
+  RuleType& Rules() { return rules; }
+
+  //! Finish the task; the results were written directly.
+  void Finish() { }
+
+ private:
+  //! The rules of this task.
+  RuleType rules;
+};
+
+/**
+ * The rules for one thread of a dual-tree range search that stores vectors of
+ * neighbors and distances.
+ */
+template<typename RuleType>
+class RangeSearchTask<RuleType, VectorRangeResults>
+{
+ public:
+  //! Construct the rules for the given search.
+  template<typename MatType, typename MetricType>
+  RangeSearchTask(const MatType& referenceSet,
+                  const MatType& querySet,
+                  const math::Range& range,
+                  VectorRangeResults& results,
+                  MetricType& metric,
+                  const bool sameSet,
+                  const bool /* parallel */) :
+      rules(referenceSet, querySet, range, results.neighbors,
+          results.distances, metric, sameSet) { }
+
+  //! Get the rules.
+  RuleType& Rules() { return rules; }
+
+  //! Finish the task; the results were written directly.
+  void Finish() { }
+
+ private:
+  //! The rules of this task.
+  RuleType rules;
+};
+
+/**
+ * The rules for one thread of a dual-tree range search that stores compressed
+ * sparse row results.  Those results are appended to, so if the search is
+ * parallel, each thread collects its own results, and Finish() adds them to
+ * the results of the search.
+ */
+template<typename RuleType>
+class RangeSearchTask<RuleType, CSRRangeResults>
+{
+ public:
+  //! Construct the rules for the given search.
+  template<typename MatType, typename MetricType>
+  RangeSearchTask(const MatType& referenceSet,
+                  const MatType& querySet,
+                  const math::Range& range,
+                  CSRRangeResults& results,
+                  MetricType& metric,
+                  const bool sameSet,
+                  const bool parallel) :
+      results(results),
+      parallel(parallel),
+      rules(referenceSet, querySet, range, parallel ? threadResults : results,
+          metric, sameSet)
+  {
+    if (parallel)
+      threadResults.Reset(results.NumQueries());
+  }
+
+  //! Get the rules.
+  RuleType& Rules() { return rules; }
+
+  //! Add the results of this thread to the results of the search.
+  void Finish()
+  {
+    if (parallel)
+    {
+      #pragma omp critical
+      results.Add(threadResults);
+    }
+  }
+
+ private:
+  //! The results of the search.
+  CSRRangeResults& results;
+  //! Whether or not this task collects its own results.
+  bool parallel;
+  //! The results of this thread, if the search is parallel.
+  CSRRangeResults threadResults;
+  //! The rules of this task.
+  RuleType rules;
+};
+
+} // namespace range
+} // namespace mlpack
+
+#endif
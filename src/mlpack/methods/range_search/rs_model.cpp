@@ -21,7 +21,8 @@ RSModel::RSModel(int treeType, bool randomBasis) :
     coverTreeRS(NULL),
     rTreeRS(NULL),
     rStarTreeRS(NULL),
-    ballTreeRS(NULL)
+    ballTreeRS(NULL),
+    vpTreeRS(NULL)
 {
   // Nothing to do.
 }
@@ -49,7 +50,7 @@ void RSModel::BuildModel(arma::mat&& referenceSet,
 
   // Do we need to modify the reference set?
   if (randomBasis)
-    referenceSet = q * referenceSet;
+    math::TransformInPlace(q, referenceSet);
 
   if (!naive)
   {
@@ -116,6 +117,28 @@ void RSModel::BuildModel(arma::mat&& referenceSet,
         ballTreeRS->oldFromNewReferences = move(oldFromNewReferences);
       }
 
+      break;
+
+    case VP_TREE:
+      // If necessary, build the vantage-point tree.
+      if (naive)
+      {
+        vpTreeRS = new RSType<tree::VPTree>(move(referenceSet), naive,
+            singleMode);
+      }
+      else
+      {
+        vector<size_t> oldFromNewReferences;
+        typename RSType<tree::VPTree>::Tree* vpTree =
+            new typename RSType<tree::VPTree>::Tree(move(referenceSet),
+            oldFromNewReferences, leafSize);
+        vpTreeRS = new RSType<tree::VPTree>(vpTree, singleMode);
+
+        // Give the model ownership of the tree and the mappings.
+        vpTreeRS->treeOwner = true;
+        vpTreeRS->oldFromNewReferences = move(oldFromNewReferences);
+      }
+
       break;
   }
 
@@ -134,7 +157,7 @@ void RSModel::Search(arma::mat&& querySet,
 {
   // We may need to map the query set randomly.
   if (randomBasis)
-    querySet = q * querySet;
+    math::TransformInPlace(q, querySet);
 
   Log::Info << "Search for points in the range [" << range.Lo() << ", "
       << range.Hi() << "] with ";
@@ -222,6 +245,38 @@ void RSModel::Search(arma::mat&& querySet,
         ballTreeRS->Search(querySet, range, neighbors, distances);
       }
       break;
+
+    case VP_TREE:
+      if (!vpTreeRS->Naive() && !vpTreeRS->SingleMode())
+      {
+        // Build a second tree and search.
+        Timer::Start("tree_building");
+        Log::Info << "Building query tree..." << endl;
+        vector<size_t> oldFromNewQueries;
+        typename RSType<tree::VPTree>::Tree queryTree(move(querySet),
+            oldFromNewQueries, leafSize);
+        Log::Info << "Tree built." << endl;
+        Timer::Stop("tree_building");
+
+        vector<vector<size_t>> neighborsOut;
+        vector<vector<double>> distancesOut;
+        vpTreeRS->Search(&queryTree, range, neighborsOut, distancesOut);
+
+        // Remap the query points.
+        neighbors.resize(queryTree.Dataset().n_cols);
+        distances.resize(queryTree.Dataset().n_cols);
+        for (size_t i = 0; i < queryTree.Dataset().n_cols; ++i)
+        {
+          neighbors[oldFromNewQueries[i]] = neighborsOut[i];
+          distances[oldFromNewQueries[i]] = distancesOut[i];
+        }
+      }
+      else
+      {
+        // Search without building a second tree.
+        vpTreeRS->Search(querySet, range, neighbors, distances);
+      }
+      break;
   }
 }
 
@@ -260,6 +315,97 @@ void RSModel::Search(const math::Range& range,
     case BALL_TREE:
       ballTreeRS->Search(range, neighbors, distances);
       break;
+
+    case VP_TREE:
+      vpTreeRS->Search(range, neighbors, distances);
+      break;
+  }
+}
+
+// Perform range search, storing the results in compressed sparse row form.
+void RSModel::Search(arma::mat&& querySet,
+                     const math::Range& range,
+                     CSRRangeResults& results)
+{
+  // We may need to map the query set randomly.
+  if (randomBasis)
+    math::TransformInPlace(q, querySet);
+
+  Log::Info << "Search for points in the range [" << range.Lo() << ", "
+      << range.Hi() << "] with ";
+  if (!Naive() && !SingleMode())
+    Log::Info << "dual-tree " << TreeName() << " search..." << endl;
+  else if (!Naive())
+    Log::Info << "single-tree " << TreeName() << " search..." << endl;
+  else
+    Log::Info << "brute-force (naive) search..." << endl;
+
+  switch (treeType)
+  {
+    case KD_TREE:
+      SearchWithQueryTree(kdTreeRS, move(querySet), range, results);
+      break;
+
+    case COVER_TREE:
+      coverTreeRS->Search(querySet, range, results);
+      break;
+
+    case R_TREE:
+      rTreeRS->Search(querySet, range, results);
+      break;
+
+    case R_STAR_TREE:
+      rStarTreeRS->Search(querySet, range, results);
+      break;
+
+    case BALL_TREE:
+      SearchWithQueryTree(ballTreeRS, move(querySet), range, results);
+      break;
+
+    case VP_TREE:
+      SearchWithQueryTree(vpTreeRS, move(querySet), range, results);
+      break;
+  }
+}
+
+// Perform range search (monochromatic case), storing the results in compressed
+// sparse row form.
+void RSModel::Search(const math::Range& range, CSRRangeResults& results)
+{
+  Log::Info << "Search for points in the range [" << range.Lo() << ", "
+      << range.Hi() << "] with ";
+  if (!Naive() && !SingleMode())
+    Log::Info << "dual-tree " << TreeName() << " search..." << endl;
+  else if (!Naive())
+    Log::Info << "single-tree " << TreeName() << " search..." << endl;
+  else
+    Log::Info << "brute-force (naive) search..." << endl;
+
+  switch (treeType)
+  {
+    case KD_TREE:
+      kdTreeRS->Search(range, results);
+      break;
+
+    case COVER_TREE:
+      coverTreeRS->Search(range, results);
+      break;
+
+    case R_TREE:
+      rTreeRS->Search(range, results);
+      break;
+
+    case R_STAR_TREE:
+      rStarTreeRS->Search(range, results);
+      break;
+
+    case BALL_TREE:
+      ballTreeRS->Search(range, results);
+      break;
+
+    case VP_TREE:
+      vpTreeRS->Search(range, results);
+      break;
   }
 }
 
@@ -278,6 +424,8 @@ std::string RSModel::TreeName() const
       return "R* tree";
     case BALL_TREE:
       return "ball tree";
+    case VP_TREE:
+      return "vantage-point tree";
     default:
       return "unknown tree";
   }
@@ -296,10 +444,13 @@ void RSModel::CleanMemory()
     delete rStarTreeRS;
   if (ballTreeRS)
     delete ballTreeRS;
+  if (vpTreeRS)
+    delete vpTreeRS;
 
   kdTreeRS = NULL;
   coverTreeRS = NULL;
   rTreeRS = NULL;
   rStarTreeRS = NULL;
   ballTreeRS = NULL;
+  vpTreeRS = NULL;
 }
@@ -28,7 +28,8 @@ class RSModel
     COVER_TREE,
     R_TREE,
     R_STAR_TREE,
-    BALL_TREE
+    BALL_TREE,
+    VP_TREE
   };
 
  private:
@@ -57,6 +58,8 @@ class RSModel
   RSType<tree::RStarTree>* rStarTreeRS;
   //! Ball tree based range search object (NULL if not in use).
   RSType<tree::BallTree>* ballTreeRS;
+  //! Vantage-point tree based range search object (NULL if not in use).
+  RSType<tree::VPTree>* vpTreeRS;
 
  public:
   /**
@@ -91,6 +94,11 @@ class RSModel
   //! Modify whether the model is in naive search mode.
   bool& Naive();
 
+  //! Get whether the model splits tree-based search across threads.
+  bool Parallel() const;
+  //! Modify whether the model splits tree-based search across threads.
+  bool& Parallel();
+
   //! Get the leaf size (applicable to everything but the cover tree).
   size_t LeafSize() const { return leafSize; }
   //! Modify the leaf size (applicable to everything but the cover tree).
@@ -149,7 +157,53 @@ class RSModel
               std::vector<std::vector<size_t>>& neighbors,
               std::vector<std::vector<double>>& distances);
 
+  /**
+   * Perform range search, storing the results in compressed sparse row form.
+   * This takes possession of the query set, so the query set will not be
+   * usable after the search.  For more information on the output format, see
+   * CSRRangeResults.
+   *
+   * @param querySet Set of query points.
+   * @param range Range to search for.
+   * @param results Output: neighbors falling within the desired range, and
+   *      their distances.
+   */
+  void Search(arma::mat&& querySet,
+              const math::Range& range,
+              CSRRangeResults& results);
+
+  /**
+   * Perform monochromatic range search, with the reference set as the query
+   * set, storing the results in compressed sparse row form.  For more
+   * information on the output format, see CSRRangeResults.
+   *
+   * @param range Range to search for.
+   * @param results Output: neighbors falling within the desired range, and
+   *      their distances.
+   */
+  void Search(const math::Range& range, CSRRangeResults& results);
+
  private:
+  /**
+   * Perform range search with the given range search object (whose tree type
+   * rearranges the dataset), storing the results in compressed sparse row
+   * form.  For dual-tree search, the query tree is built with the leaf size of
+   * the model.
+   *
+   * @param rs Range search object to search with.
+   * @param querySet Set of query points.
+   * @param range Range to search for.
+   * @param results Output: neighbors falling within the desired range, and
+   *      their distances.
+   */
+  template<template<typename TreeMetricType,
+                    typename TreeStatType,
+                    typename TreeMatType> class TreeType>
+  void SearchWithQueryTree(RSType<TreeType>* rs,
+                           arma::mat&& querySet,
+                           const math::Range& range,
+                           CSRRangeResults& results);
+
   /**
    * Return a string representing the name of the tree.  This is used for
    * logging output.
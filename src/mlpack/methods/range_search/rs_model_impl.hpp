@@ -49,6 +49,10 @@ void RSModel::Serialize(Archive& ar, const unsigned int /* version */)
     case BALL_TREE:
       ar & CreateNVP(ballTreeRS, "range_search_model");
       break;
+
+    case VP_TREE:
+      ar & CreateNVP(vpTreeRS, "range_search_model");
+      break;
   }
 }
 
@@ -64,6 +68,8 @@ inline const arma::mat& RSModel::Dataset() const
     return rStarTreeRS->ReferenceSet();
   else if (ballTreeRS)
     return ballTreeRS->ReferenceSet();
+  else if (vpTreeRS)
+    return vpTreeRS->ReferenceSet();
 
   throw std::runtime_error("no range search model initialized");
 }
@@ -80,6 +86,8 @@ inline bool RSModel::SingleMode() const
     return rStarTreeRS->SingleMode();
   else if (ballTreeRS)
     return ballTreeRS->SingleMode();
+  else if (vpTreeRS)
+    return vpTreeRS->SingleMode();
 
   throw std::runtime_error("no range search model initialized");
 }
@@ -96,6 +104,8 @@ inline bool& RSModel::SingleMode()
     return rStarTreeRS->SingleMode();
   else if (ballTreeRS)
     return ballTreeRS->SingleMode();
+  else if (vpTreeRS)
+    return vpTreeRS->SingleMode();
 
   throw std::runtime_error("no range search model initialized");
 }
@@ -112,6 +122,8 @@ inline bool RSModel::Naive() const
     return rStarTreeRS->Naive();
   else if (ballTreeRS)
     return ballTreeRS->Naive();
+  else if (vpTreeRS)
+    return vpTreeRS->Naive();
 
   throw std::runtime_error("no range search model initialized");
 }
@@ -128,10 +140,78 @@ inline bool& RSModel::Naive()
     return rStarTreeRS->Naive();
   else if (ballTreeRS)
     return ballTreeRS->Naive();
+  else if (vpTreeRS)
+    return vpTreeRS->Naive();
+
+  throw std::runtime_error("no range search model initialized");
+}
+
+inline bool RSModel::Parallel() const
+{
+  if (kdTreeRS)
+    return kdTreeRS->Parallel();
+  else if (coverTreeRS)
+    return coverTreeRS->Parallel();
+  else if (rTreeRS)
+    return rTreeRS->Parallel();
+  else if (rStarTreeRS)
+    return rStarTreeRS->Parallel();
+  else if (ballTreeRS)
+    return ballTreeRS->Parallel();
+  else if (vpTreeRS)
+    return vpTreeRS->Parallel();
+
+  throw std::runtime_error("no range search model initialized");
+}
+
+inline bool& RSModel::Parallel()
+{
+  if (kdTreeRS)
+    return kdTreeRS->Parallel();
+  else if (coverTreeRS)
+    return coverTreeRS->Parallel();
+  else if (rTreeRS)
+    return rTreeRS->Parallel();
+  else if (rStarTreeRS)
+    return rStarTreeRS->Parallel();
+  else if (ballTreeRS)
+    return ballTreeRS->Parallel();
+  else if (vpTreeRS)
+    return vpTreeRS->Parallel();
 
   throw std::runtime_error("no range search model initialized");
 }
 
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RSModel::SearchWithQueryTree(RSType<TreeType>* rs,
+                                  arma::mat&& querySet,
+                                  const math::Range& range,
+                                  CSRRangeResults& results)
+{
+  if (rs->Naive() || rs->SingleMode())
+  {
+    // Search without building a second tree.
+    rs->Search(querySet, range, results);
+    return;
+  }
+
+  // Build a second tree and search.
+  Timer::Start("tree_building");
+  Log::Info << "Building query tree..." << std::endl;
+  std::vector<size_t> oldFromNewQueries;
+  typename RSType<TreeType>::Tree queryTree(std::move(querySet),
+      oldFromNewQueries, leafSize);
+  Log::Info << "Tree built." << std::endl;
+  Timer::Stop("tree_building");
+
+  rs->Search(&queryTree, range, results);
+
+  // Remap the query points.
+  results.MapQueries(oldFromNewQueries);
+}
+
 } // namespace range
 } // namespace mlpack
 
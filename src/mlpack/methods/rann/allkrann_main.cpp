@@ -75,6 +75,8 @@ PARAM_FLAG("first_leaf_exact", "The flag to trigger sampling only after "
            "exactly exploring the first leaf.", "X");
 PARAM_INT("single_sample_limit", "The limit on the maximum number of "
     "samples (and hence the largest node you can approximate).", "S", 20);
+PARAM_FLAG("parallel", "If true, tree-based search is split across multiple "
+           "threads (if mlpack was compiled with OpenMP support).", "p");
 
 int main(int argc, char *argv[])
 {
@@ -185,6 +187,7 @@ int main(int argc, char *argv[])
     // Because we may construct it differently, we need a pointer.
     AllkRANN allkrann(&refTree, singleMode, tau, alpha, sampleAtLeaves,
         firstLeafExact, singleSampleLimit);
+    allkrann.Parallel() = CLI::HasParam("parallel");
 
     if (CLI::HasParam("query_file") && !singleMode)
     {
@@ -21,6 +21,7 @@
 #include <mlpack/core.hpp>
 
 #include <mlpack/core/tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/subtree_frontier.hpp>
 
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/methods/neighbor_search/sort_policies/nearest_neighbor_sort.hpp>
@@ -287,6 +288,48 @@ class RASearch
   //! Modify the limit on the size of a node that can be approximation.
   size_t& SingleSampleLimit() { return singleSampleLimit; }
 
+  //! Get whether tree-based search is split across multiple threads.
+  bool Parallel() const { return parallel; }
+  //! Modify whether tree-based search is split across multiple threads.
+  //! Single-tree search splits the query points into blocks, and dual-tree
+  //! search splits the query tree into subtrees.  Each block or subtree is
+  //! sampled with its own random number generator, whose seed is drawn from
+  //! the global generator (so math::RandomSeed() makes the search
+  //! reproducible).  The results only depend on the seed and, for dual-tree
+  //! search, on the number of threads.  This has no effect for naive search or
+  //! if mlpack was not compiled with OpenMP support.
+  bool& Parallel() { return parallel; }
+
+  //! Get the maximum number of base cases tree-based search may perform.
+  size_t BaseCaseBudget() const { return baseCaseBudget; }
+  /**
+   * Modify the maximum number of base cases tree-based search may perform (0
+   * means there is no limit).  Once the budget is spent, every remaining node
+   * that would be recursed into is pruned, and each query point gets the best
+   * candidates found so far; see Truncated() for the query points that were cut
+   * short.  A budgeted search is always serial.  This has no effect on naive
+   * search.
+   */
+  size_t& BaseCaseBudget() { return baseCaseBudget; }
+
+  //! Get the maximum time (in seconds) tree-based search may take.
+  double TimeBudget() const { return timeBudget; }
+  /**
+   * Modify the maximum time (in seconds) tree-based search may take (0 means
+   * there is no limit).  This works like BaseCaseBudget(); the time is only
+   * checked every so often while nodes are scored, so a search may run a little
+   * over its budget.
+   */
+  double& TimeBudget() { return timeBudget; }
+
+  /**
+   * Get whether the search of each query point was cut short by the base case
+   * or time budget in the last call to Search() (in the order of the query
+   * points given to Search()).  The rank-approximation guarantee does not hold
+   * for truncated query points.
+   */
+  const std::vector<bool>& Truncated() const { return truncated; }
+
   //! Returns a string representation of this object.
   std::string ToString() const;
 
@@ -324,8 +367,58 @@ class RASearch
   //! approximated by sampling.
   size_t singleSampleLimit;
 
+  //! If true, tree-based search is split across multiple threads.
+  bool parallel;
+  //! The maximum number of base cases for tree-based search (0 for no limit).
+  size_t baseCaseBudget;
+  //! The maximum time for tree-based search, in seconds (0 for no limit).
+  double timeBudget;
+  //! Whether each query point was truncated by the budget in the last search.
+  std::vector<bool> truncated;
+
   //! Instantiation of kernel.
   MetricType metric;
+
+  //! Whether or not tree-based search should be split across threads.
+  bool UseParallelSearch() const;
+
+  //! Whether or not tree-based search has a base case or time budget.
+  bool Budgeted() const { return baseCaseBudget > 0 || timeBudget > 0.0; }
+
+  /**
+   * Perform a single-tree traversal for each point in the given query set
+   * across multiple threads.  The query points are split into blocks, and
+   * each block is sampled with its own random number generator, seeded from
+   * the index of the block, so the results do not depend on which thread
+   * searches which block.
+   *
+   * @param querySet Set of query points.
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *      point.
+   * @param sameSet Whether or not the query set is the reference set.
+   */
+  void ParallelSingleTreeSearch(const MatType& querySet,
+                                arma::Mat<size_t>& neighbors,
+                                arma::mat& distances,
+                                const bool sameSet);
+
+  /**
+   * Perform a dual-tree traversal of the given query tree against the
+   * reference tree across multiple threads.  The query tree is split into
+   * disjoint subtrees, and each subtree is sampled with a random number
+   * generator seeded from the index of the subtree.
+   *
+   * @param queryTree Query tree (this may be the reference tree).
+   * @param neighbors Matrix storing lists of neighbors for each query point.
+   * @param distances Matrix storing distances of neighbors for each query
+   *      point.
+   * @param sameSet Whether or not the query set is the reference set.
+   */
+  void ParallelDualTreeSearch(Tree& queryTree,
+                              arma::Mat<size_t>& neighbors,
+                              arma::mat& distances,
+                              const bool sameSet);
 }; // class RASearch
 
 } // namespace neighbor
@@ -10,6 +10,10 @@
 
 #include <mlpack/core.hpp>
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 #include "ra_search_rules.hpp"
 
 namespace mlpack {
@@ -72,6 +76,9 @@ RASearch(const MatType& referenceSetIn,
     sampleAtLeaves(sampleAtLeaves),
     firstLeafExact(firstLeafExact),
     singleSampleLimit(singleSampleLimit),
+    parallel(false),
+    baseCaseBudget(0),
+    timeBudget(0.0),
     metric(metric)
 {
   // Nothing to do.
@@ -104,6 +111,9 @@ RASearch(Tree* referenceTree,
     sampleAtLeaves(sampleAtLeaves),
     firstLeafExact(firstLeafExact),
     singleSampleLimit(singleSampleLimit),
+    parallel(false),
+    baseCaseBudget(0),
+    timeBudget(0.0),
     metric(metric)
 // Nothing else to initialize.
 {  }
@@ -145,6 +155,8 @@ Search(const MatType& querySet,
 {
   Timer::Start("computing_neighbors");
 
+  truncated.assign(querySet.n_cols, false);
+
   // This will hold mappings for query points, if necessary.
   std::vector<size_t> oldFromNewQueries;
 
@@ -196,11 +208,18 @@ Search(const MatType& querySet,
       for (size_t j = 0; j < distinctSamples.n_elem; ++j)
         rules.BaseCase(i, (size_t) distinctSamples[j]);
   }
+  else if (singleMode && UseParallelSearch())
+  {
+    ParallelSingleTreeSearch(querySet, *neighborPtr, *distancePtr, false);
+  }
   else if (singleMode)
   {
     RuleType rules(*referenceSet, querySet, *neighborPtr, *distancePtr, metric,
                    tau, alpha, naive, sampleAtLeaves, firstLeafExact,
                    singleSampleLimit, false);
+    SearchBudget budget(baseCaseBudget, timeBudget, querySet.n_cols);
+    if (Budgeted())
+      rules.Budget() = &budget;
 
     // If the reference root node is a leaf, then the sampling has already been
     // done in the RASearchRules constructor.  This happens when naive = true.
@@ -220,6 +239,9 @@ Search(const MatType& querySet,
           << (rules.NumDistComputations() / querySet.n_cols) << "."
           << std::endl;
     }
+
+    if (Budgeted())
+      truncated = budget.Truncated();
   }
   else // Dual-tree recursion.
   {
@@ -233,23 +255,40 @@ Search(const MatType& querySet,
     Timer::Stop("tree_building");
     Timer::Start("computing_neighbors");
 
-    RuleType rules(*referenceSet, queryTree->Dataset(), *neighborPtr,
-                   *distancePtr, metric, tau, alpha, naive, sampleAtLeaves,
-                   firstLeafExact, singleSampleLimit, false);
-    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+    if (UseParallelSearch())
+    {
+      ParallelDualTreeSearch(*queryTree, *neighborPtr, *distancePtr, false);
+    }
+    else
+    {
+      RuleType rules(*referenceSet, queryTree->Dataset(), *neighborPtr,
+                     *distancePtr, metric, tau, alpha, naive, sampleAtLeaves,
+                     firstLeafExact, singleSampleLimit, false);
+      SearchBudget budget(baseCaseBudget, timeBudget, querySet.n_cols);
+      if (Budgeted())
+        rules.Budget() = &budget;
+      typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
 
-    Log::Info << "Query statistic pre-search: "
-        << queryTree->Stat().NumSamplesMade() << std::endl;
+      Log::Info << "Query statistic pre-search: "
+          << queryTree->Stat().NumSamplesMade() << std::endl;
 
-    traverser.Traverse(*queryTree, *referenceTree);
+      traverser.Traverse(*queryTree, *referenceTree);
 
-    Log::Info << "Dual-tree traversal complete." << std::endl;
-    Log::Info << "Average number of distance calculations per query point: "
-        << (rules.NumDistComputations() / querySet.n_cols) << "." << std::endl;
+      Log::Info << "Dual-tree traversal complete." << std::endl;
+      Log::Info << "Average number of distance calculations per query point: "
+          << (rules.NumDistComputations() / querySet.n_cols) << "."
+          << std::endl;
+
+      if (Budgeted())
+        truncated = budget.Truncated();
+    }
 
     delete queryTree;
   }
 
+  // For large k, the candidate lists were kept as heaps; sort them.
+  CandidateList<SortPolicy>::Sort(*neighborPtr, *distancePtr);
+
   Timer::Stop("computing_neighbors");
 
   // Map points back to original indices, if necessary.
@@ -274,6 +313,11 @@ Search(const MatType& querySet,
         }
       }
 
+      // Map the truncation flags.
+      const std::vector<bool> newTruncated(truncated);
+      for (size_t i = 0; i < newTruncated.size(); ++i)
+        truncated[oldFromNewQueries[i]] = newTruncated[i];
+
       // Finished with temporary matrices.
       delete neighborPtr;
       delete distancePtr;
@@ -292,6 +336,11 @@ Search(const MatType& querySet,
         neighbors.col(queryMapping) = neighborPtr->col(i);
       }
 
+      // Map the truncation flags.
+      const std::vector<bool> newTruncated(truncated);
+      for (size_t i = 0; i < newTruncated.size(); ++i)
+        truncated[oldFromNewQueries[i]] = newTruncated[i];
+
       // Finished with temporary matrices.
       delete neighborPtr;
       delete distancePtr;
@@ -328,6 +377,7 @@ void RASearch<SortPolicy, MetricType, MatType, TreeType>::Search(
 
   // Get a reference to the query set.
   const MatType& querySet = queryTree->Dataset();
+  truncated.assign(querySet.n_cols, false);
 
   // Make sure we are in dual-tree mode.
   if (singleMode || naive)
@@ -345,15 +395,31 @@ void RASearch<SortPolicy, MetricType, MatType, TreeType>::Search(
   distances.set_size(k, querySet.n_cols);
   distances.fill(SortPolicy::WorstDistance());
 
-  // Create the helper object for the tree traversal.
-  typedef RASearchRules<SortPolicy, MetricType, Tree> RuleType;
-  RuleType rules(*referenceSet, queryTree->Dataset(), *neighborPtr, distances,
-                 metric, tau, alpha, naive, sampleAtLeaves, firstLeafExact,
-                 singleSampleLimit, false);
+  if (UseParallelSearch())
+  {
+    ParallelDualTreeSearch(*queryTree, *neighborPtr, distances, false);
+  }
+  else
+  {
+    // Create the helper object for the tree traversal.
+    typedef RASearchRules<SortPolicy, MetricType, Tree> RuleType;
+    RuleType rules(*referenceSet, queryTree->Dataset(), *neighborPtr,
+                   distances, metric, tau, alpha, naive, sampleAtLeaves,
+                   firstLeafExact, singleSampleLimit, false);
+    SearchBudget budget(baseCaseBudget, timeBudget, querySet.n_cols);
+    if (Budgeted())
+      rules.Budget() = &budget;
+
+    // Create the traverser.
+    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+    traverser.Traverse(*queryTree, *referenceTree);
 
-  // Create the traverser.
-  typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
-  traverser.Traverse(*queryTree, *referenceTree);
+    if (Budgeted())
+      truncated = budget.Truncated();
+  }
+
+  // For large k, the candidate lists were kept as heaps; sort them.
+  CandidateList<SortPolicy>::Sort(*neighborPtr, distances);
 
   Timer::Stop("computing_neighbors");
 
@@ -386,6 +452,8 @@ void RASearch<SortPolicy, MetricType, MatType, TreeType>::Search(
 {
   Timer::Start("computing_neighbors");
 
+  truncated.assign(referenceSet->n_cols, false);
+
   arma::Mat<size_t>* neighborPtr = &neighbors;
   arma::mat* distancePtr = &distances;
 
@@ -402,44 +470,63 @@ void RASearch<SortPolicy, MetricType, MatType, TreeType>::Search(
   distancePtr->set_size(k, referenceSet->n_cols);
   distancePtr->fill(SortPolicy::WorstDistance());
 
-  // Create the helper object for the tree traversal.
-  typedef RASearchRules<SortPolicy, MetricType, Tree> RuleType;
-  RuleType rules(*referenceSet, *referenceSet, *neighborPtr, *distancePtr,
-                 metric, tau, alpha, naive, sampleAtLeaves, firstLeafExact,
-                 singleSampleLimit, true /* sets are the same */);
-
-  if (naive)
-  {
-    // Find how many samples from the reference set we need and sample uniformly
-    // from the reference set without replacement.
-    const size_t numSamples = RAUtil::MinimumSamplesReqd(referenceSet->n_cols,
-        k, tau, alpha);
-    arma::uvec distinctSamples;
-    RAUtil::ObtainDistinctSamples(numSamples, referenceSet->n_cols,
-        distinctSamples);
-
-    // The naive brute-force solution.
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      for (size_t j = 0; j < referenceSet->n_cols; ++j)
-        rules.BaseCase(i, j);
-  }
-  else if (singleMode)
+  if (!naive && UseParallelSearch())
   {
-    // Create the traverser.
-    typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
-
-    // Now have it traverse for each point.
-    for (size_t i = 0; i < referenceSet->n_cols; ++i)
-      traverser.Traverse(i, *referenceTree);
+    if (singleMode)
+      ParallelSingleTreeSearch(*referenceSet, *neighborPtr, *distancePtr, true);
+    else
+      ParallelDualTreeSearch(*referenceTree, *neighborPtr, *distancePtr, true);
   }
   else
   {
-    // Create the traverser.
-    typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
+    // Create the helper object for the tree traversal.
+    typedef RASearchRules<SortPolicy, MetricType, Tree> RuleType;
+    RuleType rules(*referenceSet, *referenceSet, *neighborPtr, *distancePtr,
+                   metric, tau, alpha, naive, sampleAtLeaves, firstLeafExact,
+                   singleSampleLimit, true /* sets are the same */);
+    SearchBudget budget(baseCaseBudget, timeBudget, referenceSet->n_cols);
+    if (Budgeted() && !naive)
+      rules.Budget() = &budget;
+
+    if (naive)
+    {
+      // Find how many samples from the reference set we need and sample
+      // uniformly from the reference set without replacement.
+      const size_t numSamples = RAUtil::MinimumSamplesReqd(
+          referenceSet->n_cols, k, tau, alpha);
+      arma::uvec distinctSamples;
+      RAUtil::ObtainDistinctSamples(numSamples, referenceSet->n_cols,
+          distinctSamples);
+
+      // The naive brute-force solution.
+      for (size_t i = 0; i < referenceSet->n_cols; ++i)
+        for (size_t j = 0; j < referenceSet->n_cols; ++j)
+          rules.BaseCase(i, j);
+    }
+    else if (singleMode)
+    {
+      // Create the traverser.
+      typename Tree::template SingleTreeTraverser<RuleType> traverser(rules);
+
+      // Now have it traverse for each point.
+      for (size_t i = 0; i < referenceSet->n_cols; ++i)
+        traverser.Traverse(i, *referenceTree);
+    }
+    else
+    {
+      // Create the traverser.
+      typename Tree::template DualTreeTraverser<RuleType> traverser(rules);
 
-    traverser.Traverse(*referenceTree, *referenceTree);
+      traverser.Traverse(*referenceTree, *referenceTree);
+    }
+
+    if (Budgeted() && !naive)
+      truncated = budget.Truncated();
   }
 
+  // For large k, the candidate lists were kept as heaps; sort them.
+  CandidateList<SortPolicy>::Sort(*neighborPtr, *distancePtr);
+
   Timer::Stop("computing_neighbors");
 
   // Do we need to map the reference indices?
@@ -459,12 +546,176 @@ void RASearch<SortPolicy, MetricType, MatType, TreeType>::Search(
         neighbors(j, refMapping) = oldFromNewReferences[(*neighborPtr)(j, i)];
     }
 
+    // Map the truncation flags.
+    const std::vector<bool> newTruncated(truncated);
+    for (size_t i = 0; i < newTruncated.size(); ++i)
+      truncated[oldFromNewReferences[i]] = newTruncated[i];
+
     // Finished with temporary matrices.
     delete neighborPtr;
     delete distancePtr;
   }
 }
 
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+bool RASearch<SortPolicy, MetricType, MatType, TreeType>::UseParallelSearch()
+    const
+{
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+
+  // Trees with self-children evaluate base cases for the first point of each
+  // node while scoring, so a query subtree can't be searched on its own.  A
+  // budget can't be shared by threads, so a budgeted search is serial.
+  return parallel && !naive && !Budgeted() && numThreads > 1 &&
+      !tree::TreeTraits<Tree>::HasSelfChildren;
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RASearch<SortPolicy, MetricType, MatType, TreeType>::
+ParallelSingleTreeSearch(const MatType& querySet,
+                         arma::Mat<size_t>& neighbors,
+                         arma::mat& distances,
+                         const bool sameSet)
+{
+  typedef RASearchRules<SortPolicy, MetricType, Tree> RuleType;
+  typedef typename Tree::template SingleTreeTraverser<RuleType> TraverserType;
+
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+
+  // The rules print and time things when they are created, so each thread's
+  // rules are built here instead of inside the parallel region.
+  std::vector<MetricType> metrics(numThreads, metric);
+  std::vector<RuleType*> rules(numThreads);
+  for (size_t t = 0; t < numThreads; ++t)
+    rules[t] = new RuleType(*referenceSet, querySet, neighbors, distances,
+        metrics[t], tau, alpha, naive, sampleAtLeaves, firstLeafExact,
+        singleSampleLimit, sameSet);
+
+  // Every block of queries gets its own random number generator, so the
+  // samples taken for a query don't depend on the schedule.
+  const size_t blockSize = 64;
+  const size_t numBlocks = (querySet.n_cols + blockSize - 1) / blockSize;
+  const size_t baseSeed = (size_t) math::RandInt(
+      std::numeric_limits<int>::max());
+
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t b = 0; b < numBlocks; ++b)
+  {
+#ifdef _OPENMP
+    RuleType& threadRules = *rules[omp_get_thread_num()];
+#else
+    RuleType& threadRules = *rules[0];
+#endif
+
+    std::mt19937 rng(baseSeed + b);
+    threadRules.RandomGenerator() = &rng;
+
+    TraverserType traverser(threadRules);
+    const size_t end = std::min((size_t) (b + 1) * blockSize,
+        (size_t) querySet.n_cols);
+    for (size_t i = b * blockSize; i < end; ++i)
+      traverser.Traverse(i, *referenceTree);
+
+    threadRules.RandomGenerator() = NULL;
+  }
+
+  size_t numDistComputations = 0;
+  for (size_t t = 0; t < numThreads; ++t)
+  {
+    numDistComputations += rules[t]->NumDistComputations();
+    delete rules[t];
+  }
+
+  Log::Info << "Single-tree traversal complete." << std::endl;
+  Log::Info << "Average number of distance calculations per query point: "
+      << (numDistComputations / querySet.n_cols) << "." << std::endl;
+}
+
+template<typename SortPolicy,
+         typename MetricType,
+         typename MatType,
+         template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void RASearch<SortPolicy, MetricType, MatType, TreeType>::
+ParallelDualTreeSearch(Tree& queryTree,
+                       arma::Mat<size_t>& neighbors,
+                       arma::mat& distances,
+                       const bool sameSet)
+{
+  typedef RASearchRules<SortPolicy, MetricType, Tree> RuleType;
+  typedef typename Tree::template DualTreeTraverser<RuleType> TraverserType;
+
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+
+  std::vector<MetricType> metrics(numThreads, metric);
+  std::vector<RuleType*> rules(numThreads);
+  for (size_t t = 0; t < numThreads; ++t)
+    rules[t] = new RuleType(*referenceSet, queryTree.Dataset(), neighbors,
+        distances, metrics[t], tau, alpha, naive, sampleAtLeaves,
+        firstLeafExact, singleSampleLimit, sameSet);
+
+  // Each query point belongs to exactly one subtree, so its results and the
+  // statistics of its query nodes are only touched by one thread.  Every
+  // subtree gets its own random number generator.
+  std::vector<Tree*> subtrees;
+  tree::SubtreeFrontier(queryTree, 4 * numThreads, subtrees);
+  const size_t baseSeed = (size_t) math::RandInt(
+      std::numeric_limits<int>::max());
+
+  #pragma omp parallel for schedule(dynamic, 1)
+  for (size_t i = 0; i < subtrees.size(); ++i)
+  {
+#ifdef _OPENMP
+    RuleType& threadRules = *rules[omp_get_thread_num()];
+#else
+    RuleType& threadRules = *rules[0];
+#endif
+
+    std::mt19937 rng(baseSeed + i);
+    threadRules.RandomGenerator() = &rng;
+
+    TraverserType traverser(threadRules);
+    traverser.Traverse(*subtrees[i], *referenceTree);
+
+    threadRules.RandomGenerator() = NULL;
+  }
+
+  size_t numDistComputations = 0;
+  for (size_t t = 0; t < numThreads; ++t)
+  {
+    numDistComputations += rules[t]->NumDistComputations();
+    delete rules[t];
+  }
+
+  Log::Info << "Dual-tree traversal complete." << std::endl;
+  Log::Info << "Average number of distance calculations per query point: "
+      << (numDistComputations / queryTree.Dataset().n_cols) << "."
+      << std::endl;
+}
+
 template<typename SortPolicy,
          typename MetricType,
          typename MatType,
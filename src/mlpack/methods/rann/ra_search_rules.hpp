@@ -9,7 +9,9 @@
 #ifndef __MLPACK_METHODS_RANN_RA_SEARCH_RULES_HPP
 #define __MLPACK_METHODS_RANN_RA_SEARCH_RULES_HPP
 
+#include "../neighbor_search/candidate_list.hpp"
 #include "../neighbor_search/ns_traversal_info.hpp"
+#include "../neighbor_search/search_budget.hpp"
 
 namespace mlpack {
 namespace neighbor {
@@ -185,6 +187,22 @@ class RASearchRules
       return arma::sum(numSamplesMade);
   }
 
+  //! Get the random number generator used for sampling (NULL means the
+  //! global generator of math::RandInt() is used).
+  std::mt19937* RandomGenerator() const { return rng; }
+  //! Modify the random number generator used for sampling (NULL means the
+  //! global generator of math::RandInt() is used).
+  std::mt19937*& RandomGenerator() { return rng; }
+
+  //! Get the budget of the traversal (NULL if there is no budget).
+  SearchBudget* Budget() const { return budget; }
+  //! Modify the budget of the traversal.  Once the budget is spent, every node
+  //! that would be recursed into (and not approximated by sampling) is pruned
+  //! instead, unless a query point still has fewer than k candidates; the
+  //! query points it would have been recursed into for are marked as truncated
+  //! in the budget.
+  SearchBudget*& Budget() { return budget; }
+
   typedef neighbor::NeighborSearchTraversalInfo<TreeType> TraversalInfoType;
 
   const TraversalInfoType& TraversalInfo() const { return traversalInfo; }
@@ -203,6 +221,9 @@ class RASearchRules
   //! The matrix the resultant neighbor distances should be stored in.
   arma::mat& distances;
 
+  //! The candidate lists of the query points, held in neighbors and distances.
+  CandidateList<SortPolicy> candidates;
+
   //! The instantiated metric.
   MetricType& metric;
 
@@ -230,21 +251,41 @@ class RASearchRules
   //! If the query and reference set are identical, this is true.
   bool sameSet;
 
+  //! The random number generator used for sampling (or NULL for the global
+  //! one).
+  std::mt19937* rng;
+
+  //! The budget of the traversal, if any.
+  SearchBudget* budget;
+
   TraversalInfoType traversalInfo;
 
   /**
-   * Insert a point into the neighbors and distances matrices; this is a helper
-   * function.
+   * Sample the given number of points (with replacement) from [0,
+   * rangeUpperBound), returning the distinct samples; this uses the random
+   * number generator of the rules, if there is one.
    *
-   * @param queryIndex Index of point whose neighbors we are inserting into.
-   * @param pos Position in list to insert into.
-   * @param neighbor Index of reference point which is being inserted.
-   * @param distance Distance from query point to reference point.
+   * @param numSamples Number of random samples.
+   * @param rangeUpperBound The upper bound on the range of integers.
+   * @param distinctSamples The list of the distinct samples.
+   */
+  void ObtainDistinctSamples(const size_t numSamples,
+                             const size_t rangeUpperBound,
+                             arma::uvec& distinctSamples);
+
+  /**
+   * If the budget has been spent, prune a node that would otherwise be recursed
+   * into (that is, one with a score other than DBL_MAX) and mark the query
+   * point as truncated.  Otherwise, return the score unchanged.
+   */
+  double CheckBudget(const size_t queryIndex, const double score);
+
+  /**
+   * If the budget has been spent, prune a node combination that would otherwise
+   * be recursed into and mark all the descendants of the query node as
+   * truncated.  Otherwise, return the score unchanged.
    */
-  void InsertNeighbor(const size_t queryIndex,
-                      const size_t pos,
-                      const size_t neighbor,
-                      const double distance);
+  double CheckBudget(TreeType& queryNode, const double score);
 
   /**
    * Perform actual scoring for single-tree case.
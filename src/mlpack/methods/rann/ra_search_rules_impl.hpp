@@ -31,11 +31,14 @@ RASearchRules(const arma::mat& referenceSet,
     querySet(querySet),
     neighbors(neighbors),
     distances(distances),
+    candidates(neighbors, distances),
     metric(metric),
     sampleAtLeaves(sampleAtLeaves),
     firstLeafExact(firstLeafExact),
     singleSampleLimit(singleSampleLimit),
-    sameSet(sameSet)
+    sameSet(sameSet),
+    rng(NULL),
+    budget(NULL)
 {
   // Validate tau to make sure that the rank approximation is greater than the
   // number of neighbors requested.
@@ -74,7 +77,7 @@ RASearchRules(const arma::mat& referenceSet,
     for (size_t i = 0; i < querySet.n_cols; ++i)
     {
       arma::uvec distinctSamples;
-      RAUtil::ObtainDistinctSamples(numSamplesReqd, n, distinctSamples);
+      ObtainDistinctSamples(numSamplesReqd, n, distinctSamples);
       for (size_t j = 0; j < distinctSamples.n_elem; j++)
         BaseCase(i, (size_t) distinctSamples[j]);
     }
@@ -95,16 +98,8 @@ double RASearchRules<SortPolicy, MetricType, TreeType>::BaseCase(
   double distance = metric.Evaluate(querySet.unsafe_col(queryIndex),
                                     referenceSet.unsafe_col(referenceIndex));
 
-  // If this distance is better than any of the current candidates, the
-  // SortDistance() function will give us the position to insert it into.
-  arma::vec queryDist = distances.unsafe_col(queryIndex);
-  arma::Col<size_t> queryIndices = neighbors.unsafe_col(queryIndex);
-  size_t insertPosition = SortPolicy::SortDistance(queryDist, queryIndices,
-      distance);
-
-  // SortDistance() returns (size_t() - 1) if we shouldn't add it.
-  if (insertPosition != (size_t() - 1))
-    InsertNeighbor(queryIndex, insertPosition, referenceIndex, distance);
+  // Insert the point if it is better than any of the current candidates.
+  candidates.Insert(queryIndex, referenceIndex, distance);
 
   numSamplesMade[queryIndex]++;
 
@@ -122,9 +117,10 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
   const arma::vec queryPoint = querySet.unsafe_col(queryIndex);
   const double distance = SortPolicy::BestPointToNodeDistance(queryPoint,
       &referenceNode);
-  const double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  const double bestDistance = candidates.Worst(queryIndex);
 
-  return Score(queryIndex, referenceNode, distance, bestDistance);
+  return CheckBudget(queryIndex,
+      Score(queryIndex, referenceNode, distance, bestDistance));
 }
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
@@ -136,9 +132,10 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
   const arma::vec queryPoint = querySet.unsafe_col(queryIndex);
   const double distance = SortPolicy::BestPointToNodeDistance(queryPoint,
       &referenceNode, baseCaseResult);
-  const double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  const double bestDistance = candidates.Worst(queryIndex);
 
-  return Score(queryIndex, referenceNode, distance, bestDistance);
+  return CheckBudget(queryIndex,
+      Score(queryIndex, referenceNode, distance, bestDistance));
 }
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
@@ -178,9 +175,8 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
           // Then samplesReqd <= singleSampleLimit.
           // Hence, approximate the node by sampling enough number of points.
           arma::uvec distinctSamples;
-          RAUtil::ObtainDistinctSamples(samplesReqd,
-              referenceNode.NumDescendants(),
-                                distinctSamples);
+          ObtainDistinctSamples(samplesReqd,
+              referenceNode.NumDescendants(), distinctSamples);
           for (size_t i = 0; i < distinctSamples.n_elem; i++)
             // The counting of the samples are done in the 'BaseCase' function
             // so no book-keeping is required here.
@@ -195,9 +191,8 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
           {
             // Approximate node by sampling enough number of points.
             arma::uvec distinctSamples;
-            RAUtil::ObtainDistinctSamples(samplesReqd,
-                referenceNode.NumDescendants(),
-                                  distinctSamples);
+            ObtainDistinctSamples(samplesReqd,
+                referenceNode.NumDescendants(), distinctSamples);
             for (size_t i = 0; i < distinctSamples.n_elem; i++)
               // The counting of the samples are done in the 'BaseCase' function
               // so no book-keeping is required here.
@@ -250,7 +245,7 @@ Rescore(const size_t queryIndex,
     return oldScore;
 
   // Just check the score again against the distances.
-  const double bestDistance = distances(distances.n_rows - 1, queryIndex);
+  const double bestDistance = candidates.Worst(queryIndex);
 
   // If this is better than the best distance we've seen so far,
   // maybe there will be something down this node.
@@ -275,7 +270,7 @@ Rescore(const size_t queryIndex,
     {
       // If too many samples are required and we are not at a leaf, then we
       // can't prune.
-      return oldScore;
+      return CheckBudget(queryIndex, oldScore);
     }
     else
     {
@@ -284,7 +279,7 @@ Rescore(const size_t queryIndex,
         // Then, samplesReqd <= singleSampleLimit.  Hence, approximate the node
         // by sampling enough number of points.
         arma::uvec distinctSamples;
-        RAUtil::ObtainDistinctSamples(samplesReqd,
+        ObtainDistinctSamples(samplesReqd,
             referenceNode.NumDescendants(), distinctSamples);
         for (size_t i = 0; i < distinctSamples.n_elem; i++)
           // The counting of the samples are done in the 'BaseCase' function so
@@ -300,7 +295,7 @@ Rescore(const size_t queryIndex,
         {
           // Approximate node by sampling enough points.
           arma::uvec distinctSamples;
-          RAUtil::ObtainDistinctSamples(samplesReqd,
+          ObtainDistinctSamples(samplesReqd,
               referenceNode.NumDescendants(), distinctSamples);
           for (size_t i = 0; i < distinctSamples.n_elem; i++)
             // The counting of the samples are done in the 'BaseCase' function
@@ -313,7 +308,7 @@ Rescore(const size_t queryIndex,
         else
         {
           // We cannot sample from leaves, so we cannot prune.
-          return oldScore;
+          return CheckBudget(queryIndex, oldScore);
         }
       }
     }
@@ -350,7 +345,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
 
   for (size_t i = 0; i < queryNode.NumPoints(); i++)
   {
-    const double bound = distances(distances.n_rows - 1, queryNode.Point(i))
+    const double bound = candidates.Worst(queryNode.Point(i))
         + maxDescendantDistance;
     if (bound < pointBound)
       pointBound = bound;
@@ -367,7 +362,8 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
   queryNode.Stat().Bound() = std::min(pointBound, childBound);
   const double bestDistance = queryNode.Stat().Bound();
 
-  return Score(queryNode, referenceNode, distance, bestDistance);
+  return CheckBudget(queryNode,
+      Score(queryNode, referenceNode, distance, bestDistance));
 }
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
@@ -389,7 +385,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
 
   for (size_t i = 0; i < queryNode.NumPoints(); i++)
   {
-    const double bound = distances(distances.n_rows - 1, queryNode.Point(i))
+    const double bound = candidates.Worst(queryNode.Point(i))
         + maxDescendantDistance;
     if (bound < pointBound)
       pointBound = bound;
@@ -406,7 +402,8 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
   queryNode.Stat().Bound() = std::min(pointBound, childBound);
   const double bestDistance = queryNode.Stat().Bound();
 
-  return Score(queryNode, referenceNode, distance, bestDistance);
+  return CheckBudget(queryNode,
+      Score(queryNode, referenceNode, distance, bestDistance));
 }
 
 template<typename SortPolicy, typename MetricType, typename TreeType>
@@ -487,7 +484,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
           {
             const size_t queryIndex = queryNode.Descendant(i);
             arma::uvec distinctSamples;
-            RAUtil::ObtainDistinctSamples(samplesReqd,
+            ObtainDistinctSamples(samplesReqd,
                 referenceNode.NumDescendants(), distinctSamples);
             for (size_t j = 0; j < distinctSamples.n_elem; j++)
               // The counting of the samples are done in the 'BaseCase' function
@@ -517,7 +514,7 @@ inline double RASearchRules<SortPolicy, MetricType, TreeType>::Score(
             {
               const size_t queryIndex = queryNode.Descendant(i);
               arma::uvec distinctSamples;
-              RAUtil::ObtainDistinctSamples(samplesReqd,
+              ObtainDistinctSamples(samplesReqd,
                   referenceNode.NumDescendants(), distinctSamples);
               for (size_t j = 0; j < distinctSamples.n_elem; j++)
                 // The counting of the samples are done in the 'BaseCase'
@@ -603,7 +600,7 @@ Rescore(TreeType& queryNode,
 
   for (size_t i = 0; i < queryNode.NumPoints(); i++)
   {
-    const double bound = distances(distances.n_rows - 1, queryNode.Point(i))
+    const double bound = candidates.Worst(queryNode.Point(i))
         + maxDescendantDistance;
     if (bound < pointBound)
       pointBound = bound;
@@ -680,7 +677,7 @@ Rescore(TreeType& queryNode,
             queryNode.Stat().NumSamplesMade(),
             queryNode.Child(i).Stat().NumSamplesMade());
 
-      return oldScore;
+      return CheckBudget(queryNode, oldScore);
     }
     else
     {
@@ -692,7 +689,7 @@ Rescore(TreeType& queryNode,
         {
           const size_t queryIndex = queryNode.Descendant(i);
           arma::uvec distinctSamples;
-          RAUtil::ObtainDistinctSamples(samplesReqd,
+          ObtainDistinctSamples(samplesReqd,
               referenceNode.NumDescendants(), distinctSamples);
           for (size_t j = 0; j < distinctSamples.n_elem; j++)
             // The counting of the samples are done in the 'BaseCase'
@@ -721,7 +718,7 @@ Rescore(TreeType& queryNode,
           {
             const size_t queryIndex = queryNode.Descendant(i);
             arma::uvec distinctSamples;
-            RAUtil::ObtainDistinctSamples(samplesReqd,
+            ObtainDistinctSamples(samplesReqd,
                 referenceNode.NumDescendants(), distinctSamples);
             for (size_t j = 0; j < distinctSamples.n_elem; j++)
               // The counting of the samples are done in BaseCase() so no
@@ -750,7 +747,7 @@ Rescore(TreeType& queryNode,
                 queryNode.Stat().NumSamplesMade(),
                 queryNode.Child(i).Stat().NumSamplesMade());
 
-          return oldScore;
+          return CheckBudget(queryNode, oldScore);
         }
       }
     }
@@ -774,36 +771,54 @@ Rescore(TreeType& queryNode,
   }
 } // Rescore(node, node, oldScore)
 
-/**
- * Helper function to insert a point into the neighbors and distances matrices.
- *
- * @param queryIndex Index of point whose neighbors we are inserting into.
- * @param pos Position in list to insert into.
- * @param neighbor Index of reference point which is being inserted.
- * @param distance Distance from query point to reference point.
- */
 template<typename SortPolicy, typename MetricType, typename TreeType>
-void RASearchRules<SortPolicy, MetricType, TreeType>::InsertNeighbor(
+void RASearchRules<SortPolicy, MetricType, TreeType>::ObtainDistinctSamples(
+    const size_t numSamples,
+    const size_t rangeUpperBound,
+    arma::uvec& distinctSamples)
+{
+  if (rng)
+    RAUtil::ObtainDistinctSamples(numSamples, rangeUpperBound,
+        distinctSamples, *rng);
+  else
+    RAUtil::ObtainDistinctSamples(numSamples, rangeUpperBound,
+        distinctSamples);
+}
+
+template<typename SortPolicy, typename MetricType, typename TreeType>
+inline double RASearchRules<SortPolicy, MetricType, TreeType>::CheckBudget(
     const size_t queryIndex,
-    const size_t pos,
-    const size_t neighbor,
-    const double distance)
+    const double score)
 {
-  // We only memmove() if there is actually a need to shift something.
-  if (pos < (distances.n_rows - 1))
-  {
-    int len = (distances.n_rows - 1) - pos;
-    memmove(distances.colptr(queryIndex) + (pos + 1),
-        distances.colptr(queryIndex) + pos,
-        sizeof(double) * len);
-    memmove(neighbors.colptr(queryIndex) + (pos + 1),
-        neighbors.colptr(queryIndex) + pos,
-        sizeof(size_t) * len);
-  }
+  // A query point is searched until it has k candidates, even after the budget
+  // is spent, so that it gets some results.
+  if (budget == NULL || score == DBL_MAX ||
+      candidates.Worst(queryIndex) == SortPolicy::WorstDistance() ||
+      !budget->Exhausted(numDistComputations))
+    return score;
+
+  budget->Truncate(queryIndex);
+  return DBL_MAX;
+}
 
-  // Now put the new information in the right index.
-  distances(pos, queryIndex) = distance;
-  neighbors(pos, queryIndex) = neighbor;
+template<typename SortPolicy, typename MetricType, typename TreeType>
+inline double RASearchRules<SortPolicy, MetricType, TreeType>::CheckBudget(
+    TreeType& queryNode,
+    const double score)
+{
+  if (budget == NULL || score == DBL_MAX ||
+      !budget->Exhausted(numDistComputations))
+    return score;
+
+  // If some descendant has fewer than k candidates, the node is searched
+  // further, so that every query point gets some results.
+  for (size_t i = 0; i < queryNode.NumDescendants(); ++i)
+    if (candidates.Worst(queryNode.Descendant(i)) ==
+        SortPolicy::WorstDistance())
+      return score;
+
+  budget->Truncate(queryNode);
+  return DBL_MAX;
 }
 
 }; // namespace neighbor
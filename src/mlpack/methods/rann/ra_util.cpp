@@ -180,3 +180,22 @@ void mlpack::neighbor::RAUtil::ObtainDistinctSamples(
   distinctSamples = arma::find(sampledPoints > 0);
   return;
 }
+
+void mlpack::neighbor::RAUtil::ObtainDistinctSamples(
+    const size_t numSamples,
+    const size_t rangeUpperBound,
+    arma::uvec& distinctSamples,
+    std::mt19937& rng)
+{
+  // Keep track of the points that are sampled.
+  arma::Col<size_t> sampledPoints;
+  sampledPoints.zeros(rangeUpperBound);
+
+  // This draws integers the same way as math::RandInt().
+  std::uniform_real_distribution<> uniform;
+  for (size_t i = 0; i < numSamples; i++)
+    sampledPoints[(size_t) std::floor((double) rangeUpperBound *
+        uniform(rng))]++;
+
+  distinctSamples = arma::find(sampledPoints > 0);
+}
@@ -61,7 +61,10 @@ class RegularizedSVD
    * Constructor for Regularized SVD. Obtains the user and item matrices after
    * training on the passed data. The constructor initiates an object of class
    * RegularizedSVDFunction for optimization. It uses the SGD optimizer by
-   * default. The optimizer uses a template specialization of Optimize().
+   * default, which uses a template specialization of Optimize(); ParallelSGD
+   * also has a specialization, which updates the parameters in place. Any other
+   * OptimizerType must take the function, the learning rate and the maximum
+   * number of iterations in its constructor, as ParallelSGD does.
    *
    * @param iterations Number of optimization iterations.
    * @param alpha Learning rate for the SGD optimizer.
@@ -84,7 +87,32 @@ class RegularizedSVD
              arma::mat& u,
              arma::mat& v);
 
+  /**
+   * Obtains the user and item matrices using the provided sparse rating matrix
+   * (items x users, where zero entries are missing ratings) and rank.  Users
+   * and items without ratings are kept, so u has a row for each row of data
+   * and v has a column for each column of data.
+   *
+   * @param data Sparse rating matrix.
+   * @param rank Rank parameter to be used for optimization.
+   * @param u Item matrix obtained on decomposition.
+   * @param v User matrix obtained on decomposition.
+   */
+  void Apply(const arma::sp_mat& data,
+             const size_t rank,
+             arma::mat& u,
+             arma::mat& v);
+
  private:
+  /**
+   * Optimize the given function and extract the user and item matrices.
+   *
+   * @param rSVDFunc Function to optimize.
+   * @param u Item matrix obtained on decomposition.
+   * @param v User matrix obtained on decomposition.
+   */
+  void Optimize(RegularizedSVDFunction& rSVDFunc, arma::mat& u, arma::mat& v);
+
   //! Number of optimization iterations.
   size_t iterations;
   //! Learning rate for the SGD optimizer.
@@ -25,6 +25,39 @@ RegularizedSVDFunction::RegularizedSVDFunction(const arma::mat& data,
   initialPoint.randu(rank, numUsers + numItems);
 }
 
+RegularizedSVDFunction::RegularizedSVDFunction(const arma::sp_mat& data,
+                                               const size_t rank,
+                                               const double lambda) :
+    coordinates(CoordinateList(data)),
+    data(coordinates),
+    rank(rank),
+    lambda(lambda),
+    numUsers(data.n_cols),
+    numItems(data.n_rows)
+{
+  // Initialize the parameters.
+  initialPoint.randu(rank, numUsers + numItems);
+}
+
+arma::mat RegularizedSVDFunction::CoordinateList(const arma::sp_mat& data)
+{
+  // Each column of the coordinate list is (user, item, rating); the columns of
+  // the sparse matrix are the users.
+  arma::mat list(3, data.n_nonzero);
+  size_t k = 0;
+  for (size_t user = 0; user < data.n_cols; ++user)
+  {
+    for (size_t j = data.col_ptrs[user]; j < data.col_ptrs[user + 1]; ++j, ++k)
+    {
+      list(0, k) = user;
+      list(1, k) = data.row_indices[j];
+      list(2, k) = data.values[j];
+    }
+  }
+
+  return list;
+}
+
 double RegularizedSVDFunction::Evaluate(const arma::mat& parameters) const
 {
   // The cost for the optimization is as follows:
@@ -116,6 +149,76 @@ void RegularizedSVDFunction::Gradient(const arma::mat& parameters,
   }
 }
 
+double RegularizedSVDFunction::EvaluateWithGradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  // This is Evaluate() and Gradient() in one pass over the training examples.
+  double cost = 0.0;
+  gradient.zeros(rank, numUsers + numItems);
+
+  for(size_t i = 0; i < data.n_cols; i++)
+  {
+    // Indices for accessing the the correct parameter columns.
+    const size_t user = data(0, i);
+    const size_t item = data(1, i) + numUsers;
+
+    // Prediction error for the example.
+    const double rating = data(2, i);
+    const double ratingError = rating - arma::dot(parameters.col(user),
+                                                  parameters.col(item));
+
+    // Squared error and regularization penalty of the example.
+    const double userVecNorm = arma::norm(parameters.col(user), 2);
+    const double itemVecNorm = arma::norm(parameters.col(item), 2);
+    cost += ratingError * ratingError + lambda * (userVecNorm * userVecNorm +
+        itemVecNorm * itemVecNorm);
+
+    // Gradient is non-zero only for the parameter columns corresponding to the
+    // example.
+    gradient.col(user) += 2 * (lambda * parameters.col(user) -
+                               ratingError * parameters.col(item));
+    gradient.col(item) += 2 * (lambda * parameters.col(item) -
+                               ratingError * parameters.col(user));
+  }
+
+  return cost;
+}
+
+void RegularizedSVDFunction::Gradient(const arma::mat& parameters,
+                                      const size_t i,
+                                      arma::sp_mat& gradient) const
+{
+  // Indices for accessing the the correct parameter columns.
+  const size_t user = data(0, i);
+  const size_t item = data(1, i) + numUsers;
+
+  // Prediction error for the example.
+  const double rating = data(2, i);
+  const double ratingError = rating - arma::dot(parameters.col(user),
+                                                parameters.col(item));
+
+  // The gradient is the same as the contribution of this example to the full
+  // gradient.  The user column comes before the item column, so the locations
+  // are already in column-major order.
+  arma::umat locations(2, 2 * rank);
+  arma::vec values(2 * rank);
+  for (size_t j = 0; j < rank; ++j)
+  {
+    locations(0, j) = j;
+    locations(1, j) = user;
+    values[j] = 2 * (lambda * parameters(j, user) -
+                     ratingError * parameters(j, item));
+
+    locations(0, rank + j) = j;
+    locations(1, rank + j) = item;
+    values[rank + j] = 2 * (lambda * parameters(j, item) -
+                            ratingError * parameters(j, user));
+  }
+
+  gradient = arma::sp_mat(locations, values, rank, numUsers + numItems);
+}
+
 }; // namespace svd
 }; // namespace mlpack
 
@@ -137,7 +240,9 @@ double SGD<mlpack::svd::RegularizedSVDFunction>::Optimize(arma::mat& parameters)
   for(size_t i = 0; i < numFunctions; i++)
     overallObjective += function.Evaluate(parameters, i);
 
-  const arma::mat data = function.Dataset();
+  const arma::mat& data = function.Dataset();
+  const size_t numUsers = function.NumUsers();
+  const double lambda = function.Lambda();
 
   // Now iterate!
   for(size_t i = 1; i != maxIterations; i++, currentFunction++)
@@ -150,8 +255,6 @@ double SGD<mlpack::svd::RegularizedSVDFunction>::Optimize(arma::mat& parameters)
       currentFunction = 0;
     }
 
-    const size_t numUsers = function.NumUsers();
-
     // Indices for accessing the the correct parameter columns.
     const size_t user = data(0, currentFunction);
     const size_t item = data(1, currentFunction) + numUsers;
@@ -161,14 +264,13 @@ double SGD<mlpack::svd::RegularizedSVDFunction>::Optimize(arma::mat& parameters)
     double ratingError = rating - arma::dot(parameters.col(user),
                                             parameters.col(item));
 
-    double lambda = function.Lambda();
-
     // Gradient is non-zero only for the parameter columns corresponding to the
-    // example.
-    parameters.col(user) -= stepSize * (lambda * parameters.col(user) -
+    // example.  Both columns are stepped from their values before the step.
+    const arma::vec userVec = parameters.col(user);
+    parameters.col(user) -= stepSize * (lambda * userVec -
                                         ratingError * parameters.col(item));
     parameters.col(item) -= stepSize * (lambda * parameters.col(item) -
-                                        ratingError * parameters.col(user));
+                                        ratingError * userVec);
 
     // Now add that to the overall objective function.
     overallObjective += function.Evaluate(parameters, currentFunction);
@@ -177,5 +279,111 @@ double SGD<mlpack::svd::RegularizedSVDFunction>::Optimize(arma::mat& parameters)
   return overallObjective;
 }
 
+template<>
+double ParallelSGD<mlpack::svd::RegularizedSVDFunction>::Optimize(
+    arma::mat& parameters)
+{
+  // Find the number of functions to use.
+  const size_t numFunctions = function.NumFunctions();
+  if (numFunctions == 0)
+    return 0.0; // Nothing to optimize.
+
+  const arma::mat& data = function.Dataset();
+  const size_t numUsers = function.NumUsers();
+  const size_t rank = parameters.n_rows;
+  const double lambda = function.Lambda();
+
+  // The order of visitation, which is shuffled in place before each pass.
+  arma::Col<size_t> order(numFunctions);
+  for (size_t i = 0; i < numFunctions; ++i)
+    order[i] = i;
+
+  // To keep track of where we are and how things are going.
+  size_t iterations = 0;
+  double currentStepSize = stepSize;
+  double overallObjective = FullEvaluate(parameters);
+  double lastObjective = DBL_MAX;
+
+  for (size_t pass = 0; ; ++pass)
+  {
+    // Output current objective function.
+    Log::Info << "Parallel SGD: pass " << pass << ", objective "
+        << overallObjective << "." << std::endl;
+
+    if (std::isnan(overallObjective) || std::isinf(overallObjective))
+    {
+      Log::Warn << "Parallel SGD: converged to " << overallObjective << "; "
+          << "terminating with failure.  Try a smaller step size?"
+          << std::endl;
+      return overallObjective;
+    }
+
+    if (std::abs(lastObjective - overallObjective) < tolerance)
+    {
+      Log::Info << "Parallel SGD: minimized within tolerance " << tolerance
+          << "; terminating optimization." << std::endl;
+      return overallObjective;
+    }
+
+    if (maxIterations != 0 && iterations >= maxIterations)
+    {
+      Log::Info << "Parallel SGD: maximum iterations (" << maxIterations
+          << ") reached; terminating optimization." << std::endl;
+      return overallObjective;
+    }
+
+    // Determine order of visitation (in place).
+    if (shuffle)
+      std::shuffle(order.begin(), order.end(), math::randGen);
+
+    // The last pass may be cut short by the maximum number of iterations.
+    const size_t passSize = (maxIterations == 0) ? numFunctions :
+        std::min(numFunctions, maxIterations - iterations);
+
+    // Each thread takes blocks of ratings, and steps the two parameter columns
+    // of each rating along its gradient, on the shared parameters and without
+    // locks.
+    #pragma omp parallel
+    {
+      arma::vec userStep(rank), itemStep(rank);
+
+      #pragma omp for schedule(static, 256)
+      for (size_t j = 0; j < passSize; ++j)
+      {
+        const size_t i = order[j];
+        double* userVec = parameters.colptr((size_t) data(0, i));
+        double* itemVec = parameters.colptr((size_t) data(1, i) + numUsers);
+
+        double ratingError = data(2, i);
+        for (size_t k = 0; k < rank; ++k)
+          ratingError -= userVec[k] * itemVec[k];
+
+        // This is the same gradient as the sparse Gradient() gives.
+        for (size_t k = 0; k < rank; ++k)
+        {
+          userStep[k] = 2 * currentStepSize * (lambda * userVec[k] -
+              ratingError * itemVec[k]);
+          itemStep[k] = 2 * currentStepSize * (lambda * itemVec[k] -
+              ratingError * userVec[k]);
+        }
+
+        for (size_t k = 0; k < rank; ++k)
+        {
+          #pragma omp atomic
+          userVec[k] -= userStep[k];
+          #pragma omp atomic
+          itemVec[k] -= itemStep[k];
+        }
+      }
+    }
+
+    iterations += passSize;
+    currentStepSize *= decay;
+
+    lastObjective = overallObjective;
+    overallObjective = FullEvaluate(parameters);
+  }
+}
+
 }; // namespace optimization
 }; // namespace mlpack
@@ -10,6 +10,7 @@
 
 #include <mlpack/core.hpp>
 #include <mlpack/core/optimizers/sgd/sgd.hpp>
+#include <mlpack/core/optimizers/parallel_sgd/parallel_sgd.hpp>
 
 namespace mlpack {
 namespace svd {
@@ -31,6 +32,21 @@ class RegularizedSVDFunction
                          const size_t rank,
                          const double lambda);
 
+  /**
+   * Constructor for RegularizedSVDFunction class, for ratings given as a sparse
+   * items x users matrix (as used by CF), where the zero entries are taken to
+   * be missing.  The nonzero entries are stored as a coordinate list; unlike
+   * the other constructor, the number of users and items is given by the size
+   * of the matrix, so users and items without ratings get parameters too.
+   *
+   * @param data Sparse rating matrix (items x users).
+   * @param rank Rank used for matrix factorization.
+   * @param lambda Regularization parameter used for optimization.
+   */
+  RegularizedSVDFunction(const arma::sp_mat& data,
+                         const size_t rank,
+                         const double lambda);
+
   /**
    * Evaluates the cost function over all examples in the data.
    *
@@ -58,6 +74,32 @@ class RegularizedSVDFunction
   void Gradient(const arma::mat& parameters,
                 arma::mat& gradient) const;
 
+  /**
+   * Evaluates the cost function and its full gradient over all the training
+   * examples at once, so that the prediction error of each example is only
+   * calculated once.
+   *
+   * @param parameters Parameters(user/item matrices) of the decomposition.
+   * @param gradient Calculated gradient for the parameters.
+   * @return Cost at the given parameters.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
+  /**
+   * Evaluates the gradient of the cost function for one training example.  The
+   * gradient is nonzero only in the columns of the user and the item of the
+   * example, so it is returned as a sparse matrix.  This is used by the
+   * ParallelSGD optimizer.
+   *
+   * @param parameters Parameters(user/item matrices) of the decomposition.
+   * @param i Index of the training example to be used.
+   * @param gradient Calculated gradient for the parameters.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t i,
+                arma::sp_mat& gradient) const;
+
   //! Return the initial point for the optimization.
   const arma::mat& GetInitialPoint() const { return initialPoint; }
 
@@ -80,6 +122,12 @@ class RegularizedSVDFunction
   size_t Rank() const { return rank; }
 
  private:
+  //! Convert a sparse items x users rating matrix to a coordinate list.
+  static arma::mat CoordinateList(const arma::sp_mat& data);
+
+  //! Coordinate list built from sparse rating data (empty otherwise).  This
+  //! has to be declared before data, which may refer to it.
+  arma::mat coordinates;
   //! Rating data.
   const arma::mat& data;
   //! Initial parameter point.
@@ -109,6 +157,16 @@ namespace optimization {
   double SGD<mlpack::svd::RegularizedSVDFunction>::Optimize(
       arma::mat& parameters);
 
+  /**
+   * Template specialization for the ParallelSGD optimizer.  Each step updates
+   * the user and item columns of its rating in place, with atomic writes,
+   * instead of building a sparse gradient matrix; the passes, step size decay
+   * and termination are the same as for the generic ParallelSGD.
+   */
+  template<>
+  double ParallelSGD<mlpack::svd::RegularizedSVDFunction>::Optimize(
+      arma::mat& parameters);
+
 }; // namespace optimization
 }; // namespace mlpack
 
@@ -0,0 +1,175 @@
+/**
+ * @file score_main.cpp
+ * @author Ryan Curtin
+ *
+ * Score a large dataset with a trained linear regression, logistic regression,
+ * or softmax regression model, reading the dataset from disk one chunk at a
+ * time.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/data/chunked_reader.hpp>
+#include <mlpack/core/util/batch_predict.hpp>
+#include <mlpack/methods/linear_regression/linear_regression.hpp>
+#include <mlpack/methods/logistic_regression/logistic_regression.hpp>
+#include <mlpack/methods/softmax_regression/softmax_regression.hpp>
+
+#include <memory>
+
+using namespace mlpack;
+using namespace mlpack::regression;
+using namespace std;
+
+PROGRAM_INFO("Batch Scoring",
+    "This program scores a dataset with a model saved by the linear_regression "
+    "(--output_model_file), logistic_regression (--output_model), or "
+    "softmax_regression (--output_model) programs; --model_type gives the kind "
+    "of model ('linear_regression', 'logistic_regression', or "
+    "'softmax_regression').  The dataset (--input_file) is never loaded all at "
+    "once: it is read --chunk_size points at a time (while the previous chunk "
+    "is scored), each chunk is scored in parallel blocks of --block_size "
+    "points, and the predictions are written to --output_file, one per line, "
+    "before the next chunk is scored.\n\n"
+    "The input file is either in arma_binary format ('.bin') with one point "
+    "per column, or a CSV/text file with one point per line.  Linear "
+    "regression predicts a response for each point; logistic and softmax "
+    "regression predict a label.");
+
+PARAM_STRING_REQ("model_type", "Type of the model: 'linear_regression', "
+    "'logistic_regression', or 'softmax_regression'.", "t");
+PARAM_STRING_REQ("input_model_file", "File containing the trained model.",
+    "m");
+PARAM_STRING_REQ("input_file", "File containing the points to score.", "i");
+PARAM_STRING_REQ("output_file", "File to write the predictions to.", "o");
+
+PARAM_INT("chunk_size", "Number of points read from disk at a time.", "c",
+    1000000);
+PARAM_INT("block_size", "Number of points in each block scored by one "
+    "thread.", "b", 8192);
+PARAM_DOUBLE("decision_boundary", "Decision boundary for logistic regression."
+    "  Points whose probability of being in class 1 is at least this are "
+    "labeled 1.", "d", 0.5);
+
+// Read the input file chunk by chunk, score each chunk with the given
+// function, and write the results.
+template<typename OutputType, typename FunctionType>
+void ScoreChunks(data::ChunkedReader& reader,
+                 const size_t dimensionality,
+                 ofstream& output,
+                 FunctionType score)
+{
+  if (reader.Dimensionality() != dimensionality)
+    Log::Fatal << "The model has dimensionality " << dimensionality << ", but "
+        << "the points in '" << reader.Filename() << "' have dimensionality "
+        << reader.Dimensionality() << "!" << endl;
+
+  // The results are allocated once, for a full chunk, and reused.
+  OutputType results(reader.ChunkSize());
+  arma::mat chunk;
+  size_t points = 0;
+  while (reader.NextChunk(chunk))
+  {
+    Timer::Start("scoring");
+    score(chunk, results);
+    Timer::Stop("scoring");
+
+    for (size_t i = 0; i < chunk.n_cols; ++i)
+      output << results[i] << '\n';
+
+    points += chunk.n_cols;
+    Log::Info << "Scored " << points << " of " << reader.NumPoints()
+        << " points." << endl;
+  }
+}
+
+int main(int argc, char** argv)
+{
+  CLI::ParseCommandLine(argc, argv);
+
+  const string modelType = CLI::GetParam<string>("model_type");
+  const string inputModelFile = CLI::GetParam<string>("input_model_file");
+  const string outputFile = CLI::GetParam<string>("output_file");
+  const int chunkSize = CLI::GetParam<int>("chunk_size");
+  const int blockSize = CLI::GetParam<int>("block_size");
+  const double decisionBoundary = CLI::GetParam<double>("decision_boundary");
+
+  if (modelType != "linear_regression" && modelType != "logistic_regression" &&
+      modelType != "softmax_regression")
+    Log::Fatal << "Unknown model type '" << modelType << "'; must be "
+        << "'linear_regression', 'logistic_regression', or "
+        << "'softmax_regression'." << endl;
+  if (chunkSize <= 0)
+    Log::Fatal << "Invalid chunk size (" << chunkSize << ")!  Must be "
+        << "positive." << endl;
+  if (blockSize <= 0)
+    Log::Fatal << "Invalid block size (" << blockSize << ")!  Must be "
+        << "positive." << endl;
+  if (decisionBoundary < 0.0 || decisionBoundary > 1.0)
+    Log::Fatal << "Decision boundary must be between 0.0 and 1.0 (received "
+        << decisionBoundary << ")." << endl;
+
+  // Opening the file reads its header (or counts its lines).
+  unique_ptr<data::ChunkedReader> reader;
+  try
+  {
+    reader.reset(new data::ChunkedReader(CLI::GetParam<string>("input_file"),
+        (size_t) chunkSize));
+  }
+  catch (std::exception& e)
+  {
+    Log::Fatal << e.what() << endl;
+  }
+
+  ofstream output(outputFile.c_str());
+  if (!output.is_open())
+    Log::Fatal << "Cannot open '" << outputFile << "' for writing!" << endl;
+
+  // Write the responses with enough digits that they can be read back exactly.
+  output.precision(numeric_limits<double>::digits10 + 2);
+
+  try
+  {
+    if (modelType == "linear_regression")
+    {
+      LinearRegression lr;
+      data::Load(inputModelFile, "linearRegressionModel", lr, true);
+      const size_t dimensionality = lr.Parameters().n_elem -
+          (lr.Intercept() ? 1 : 0);
+
+      ScoreChunks<arma::vec>(*reader, dimensionality, output,
+          [&](const arma::mat& chunk, arma::vec& predictions)
+      {
+        BatchPredict(lr, chunk, predictions, (size_t) blockSize);
+      });
+    }
+    else if (modelType == "logistic_regression")
+    {
+      LogisticRegression<> lr(0, 0); // Empty model.
+      data::Load(inputModelFile, "logistic_regression_model", lr, true);
+
+      ScoreChunks<arma::Row<size_t>>(*reader, lr.Parameters().n_elem - 1,
+          output, [&](const arma::mat& chunk, arma::Row<size_t>& labels)
+      {
+        BatchApply(chunk, labels, [&](const arma::mat& block,
+                                      arma::Row<size_t>& blockLabels)
+        {
+          lr.Predict(block, blockLabels, decisionBoundary);
+        }, (size_t) blockSize);
+      });
+    }
+    else
+    {
+      SoftmaxRegression<> sm(0, 0, false);
+      data::Load(inputModelFile, "softmax_regression_model", sm, true);
+
+      ScoreChunks<arma::Row<size_t>>(*reader, sm.FeatureSize(), output,
+          [&](const arma::mat& chunk, arma::Row<size_t>& labels)
+      {
+        BatchPredict(sm, chunk, labels, (size_t) blockSize);
+      });
+    }
+  }
+  catch (std::exception& e)
+  {
+    Log::Fatal << e.what() << endl;
+  }
+}
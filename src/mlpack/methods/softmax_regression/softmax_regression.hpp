@@ -42,8 +42,8 @@ namespace regression {
  * const size_t numIterations = 100; // Maximum number of iterations.
  *
  * // Use an instantiated optimizer for the training.
- * SoftmaxRegressionFunction srf(train_data, labels, inputSize, numClasses);
- * L_BFGS<SoftmaxRegressionFunction> optimizer(srf, numBasis, numIterations);
+ * SoftmaxRegressionFunction<> srf(train_data, labels, inputSize, numClasses);
+ * L_BFGS<SoftmaxRegressionFunction<>> optimizer(srf, numBasis, numIterations);
  * SoftmaxRegression<L_BFGS> regressor2(optimizer);
  *
  * arma::mat test_data; // Test data matrix.
@@ -53,9 +53,16 @@ namespace regression {
  * regressor1.Predict(test_data, predictions1);
  * regressor2.Predict(test_data, predictions2);
  * @endcode
+ *
+ * The data can be dense (arma::mat) or sparse (arma::sp_mat), by specifying
+ * the MatType parameter.
+ *
+ * @tparam OptimizerType Type of optimizer to train the model with.
+ * @tparam MatType Type of data matrix.
  */
 template<
-  template<typename> class OptimizerType = mlpack::optimization::L_BFGS
+  template<typename> class OptimizerType = mlpack::optimization::L_BFGS,
+  typename MatType = arma::mat
 >
 class SoftmaxRegression
 {
@@ -86,7 +93,7 @@ class SoftmaxRegression
    * @param lambda L2-regularization constant.
    * @param fitIntercept add intercept term or not.
    */
-  SoftmaxRegression(const arma::mat& data,
+  SoftmaxRegression(const MatType& data,
                     const arma::Row<size_t>& labels,
                     const size_t numClasses,
                     const double lambda = 0.0001,
@@ -101,7 +108,8 @@ class SoftmaxRegression
    *
    * @param optimizer Instantiated optimizer with instantiated error function.
    */
-  SoftmaxRegression(OptimizerType<SoftmaxRegressionFunction>& optimizer);
+  SoftmaxRegression(
+      OptimizerType<SoftmaxRegressionFunction<MatType>>& optimizer);
 
   /**
    * Predict the class labels for the provided feature points. The function
@@ -111,7 +119,7 @@ class SoftmaxRegression
    * @param testData Matrix of data points for which predictions are to be made.
    * @param predictions Vector to store the predictions in.
    */
-  void Predict(const arma::mat& testData, arma::Row<size_t>& predictions) const;
+  void Predict(const MatType& testData, arma::Row<size_t>& predictions) const;
 
   /**
    * Computes accuracy of the learned model given the feature data and the
@@ -121,7 +129,8 @@ class SoftmaxRegression
    * @param testData Matrix of data points using which predictions are made.
    * @param labels Vector of labels associated with the data.
    */
-  double ComputeAccuracy(const arma::mat& testData, const arma::Row<size_t>& labels);
+  double ComputeAccuracy(const MatType& testData,
+                         const arma::Row<size_t>& labels);
 
   /**
    * Train the softmax regression model with the given optimizer.
@@ -131,7 +140,7 @@ class SoftmaxRegression
    * @param optimizer Instantiated optimizer with instantiated error function.
    * @return Objective value of the final point.
    */
-  double Train(OptimizerType<SoftmaxRegressionFunction>& optimizer);
+  double Train(OptimizerType<SoftmaxRegressionFunction<MatType>>& optimizer);
 
   /**
    * Train the softmax regression with the given training data.
@@ -140,7 +149,7 @@ class SoftmaxRegression
    * @param numClasses Number of classes for classification.
    * @return Objective value of the final point.
    */
-  double Train(const arma::mat &data, const arma::Row<size_t>& labels,
+  double Train(const MatType& data, const arma::Row<size_t>& labels,
                const size_t numClasses);
 
   //! Sets the number of classes.
@@ -13,6 +13,21 @@
 namespace mlpack {
 namespace regression {
 
+/**
+ * The objective function of softmax regression, to be optimized by any mlpack
+ * optimizer.
+ *
+ * The data can be dense (arma::mat) or sparse (arma::sp_mat); with a sparse
+ * matrix, the products with the data only visit its nonzero elements.  Both
+ * the full objective (for optimizers like L_BFGS) and the objective over
+ * contiguous batches of points (for optimizers like MiniBatchSGD) are
+ * provided.  The objective over a batch of points is scaled so that the sum
+ * over all of the batches is the full objective; that is, each point
+ * contributes 1 / n of its negative log-likelihood and of the regularization.
+ *
+ * @tparam MatType Type of data matrix.
+ */
+template<typename MatType = arma::mat>
 class SoftmaxRegressionFunction
 {
  public:
@@ -27,7 +42,7 @@ class SoftmaxRegressionFunction
    * @param lambda L2-regularization constant.
    * @param fitIntercept Intercept term flag.
    */
-  SoftmaxRegressionFunction(const arma::mat& data,
+  SoftmaxRegressionFunction(const MatType& data,
                             const arma::Row<size_t>& labels,
                             const size_t numClasses,
                             const double lambda = 0.0001,
@@ -95,6 +110,31 @@ class SoftmaxRegressionFunction
    */
   double Evaluate(const arma::mat& parameters) const;
 
+  /**
+   * Evaluates the objective function of the softmax regression model using the
+   * given parameters, over only the batchSize points starting at begin.  This
+   * is the sum of Evaluate(parameters, i) over those points, and is used by
+   * optimizers such as MiniBatchSGD.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param begin Index of the first point of the batch.
+   * @param batchSize Number of points in the batch.
+   */
+  double Evaluate(const arma::mat& parameters,
+                  const size_t begin,
+                  const size_t batchSize) const;
+
+  /**
+   * Evaluates the objective function of the softmax regression model using the
+   * given parameters, over only the i'th point.  This is useful for optimizers
+   * such as SGD, which require a separable objective function.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param i Index of the point.
+   */
+  double Evaluate(const arma::mat& parameters, const size_t i) const
+  { return Evaluate(parameters, i, 1); }
+
   /**
    * Evaluates the gradient values of the objective function given the current
    * set of parameters. The function calculates the probabilities for each class
@@ -106,9 +146,69 @@ class SoftmaxRegressionFunction
    */
   void Gradient(const arma::mat& parameters, arma::mat& gradient) const;
 
+  /**
+   * Evaluates the gradient of the objective function over only the batchSize
+   * points starting at begin.  This is the sum of Gradient(parameters, i,
+   * gradient) over those points, and is used by optimizers such as
+   * MiniBatchSGD.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param begin Index of the first point of the batch.
+   * @param batchSize Number of points in the batch.
+   * @param gradient Matrix where gradient values will be stored.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                const size_t batchSize,
+                arma::mat& gradient) const;
+
+  /**
+   * Evaluates the gradient of the objective function over only the i'th point.
+   * This is useful for optimizers such as SGD, which require a separable
+   * objective function.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param i Index of the point.
+   * @param gradient Matrix where gradient values will be stored.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t i,
+                arma::mat& gradient) const
+  { Gradient(parameters, i, 1, gradient); }
+
+  /**
+   * Evaluates the objective function and its gradient at once, given the
+   * current set of parameters. This is the same as Evaluate() followed by
+   * Gradient(), but the probabilities matrix is only computed once.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param gradient Matrix where gradient values will be stored.
+   * @return Objective at the given parameters.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
+  /**
+   * Computes the product of the Hessian of the objective function at the
+   * current set of parameters and the given direction, without forming the
+   * Hessian.  This costs about as much as Gradient(), and is used by optimizers
+   * such as TRON.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param v Direction to multiply the Hessian by (of the same size as the
+   *     parameters).
+   * @param hv Matrix where the product will be stored.
+   */
+  void HessianVectorProduct(const arma::mat& parameters,
+                            const arma::mat& v,
+                            arma::mat& hv) const;
+
   //! Return the initial point for the optimization.
   const arma::mat& GetInitialPoint() const { return initialPoint; }
 
+  //! Return the number of separable functions (the number of points).
+  size_t NumFunctions() const { return data.n_cols; }
+
   //! Gets the number of classes.
   size_t NumClasses() const { return numClasses; }
 
@@ -128,8 +228,38 @@ class SoftmaxRegressionFunction
   bool FitIntercept() const { return fitIntercept; }
 
  private:
+  /**
+   * Evaluate the probabilities matrix of the given points, as in
+   * GetProbabilitiesMatrix().
+   *
+   * @param parameters Current values of the model parameters.
+   * @param points Points to compute the probabilities of.
+   * @param probabilities Matrix to store the probabilities in.
+   */
+  void GetProbabilitiesMatrix(const arma::mat& parameters,
+                              const MatType& points,
+                              arma::mat& probabilities) const;
+
+  /**
+   * Compute the gradient of the objective over the given points, from their
+   * probabilities and ground truth.  The data term is divided by the number
+   * of points in the whole dataset, and the regularization term is scaled by
+   * the fraction of the dataset that the points make up.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param points Points to compute the gradient over.
+   * @param truth Ground truth matrix of the points.
+   * @param probabilities Probabilities matrix of the points.
+   * @param gradient Matrix where gradient values will be stored.
+   */
+  void PointsGradient(const arma::mat& parameters,
+                      const MatType& points,
+                      const arma::sp_mat& truth,
+                      const arma::mat& probabilities,
+                      arma::mat& gradient) const;
+
   //! Training data matrix.
-  const arma::mat& data;
+  const MatType& data;
   //! Label matrix for the provided data.
   arma::sp_mat groundTruth;
   //! Initial parameter point.
@@ -145,4 +275,7 @@ class SoftmaxRegressionFunction
 } // namespace regression
 } // namespace mlpack
 
+// Include implementation.
+#include "softmax_regression_function_impl.hpp"
+
 #endif
@@ -0,0 +1,361 @@
+/**
+ * @file softmax_regression_function_impl.hpp
+ * @author Siddharth Agrawal
+ *
+ * Implementation of function to be optimized for softmax regression.
+ */
+#ifndef __MLPACK_METHODS_SOFTMAX_REGRESSION_SOFTMAX_REGRESSION_FUNCTION_IMPL_HPP
+#define __MLPACK_METHODS_SOFTMAX_REGRESSION_SOFTMAX_REGRESSION_FUNCTION_IMPL_HPP
+
+// In case it hasn't been included yet.
+#include "softmax_regression_function.hpp"
+
+namespace mlpack {
+namespace regression {
+
+template<typename MatType>
+SoftmaxRegressionFunction<MatType>::SoftmaxRegressionFunction(
+    const MatType& data,
+    const arma::Row<size_t>& labels,
+    const size_t numClasses,
+    const double lambda,
+    const bool fitIntercept) :
+    data(data),
+    numClasses(numClasses),
+    lambda(lambda),
+    fitIntercept(fitIntercept)
+{
+  // Intialize the parameters to suitable values.
+  initialPoint = InitializeWeights();
+
+  // Calculate the label matrix.
+  GetGroundTruthMatrix(labels, groundTruth);
+}
+
+/**
+ * Initializes parameter weights to random values taken from a scaled standard
+ * normal distribution. The weights cannot be initialized to zero, as that will
+ * lead to each class output being the same.
+ */
+template<typename MatType>
+const arma::mat SoftmaxRegressionFunction<MatType>::InitializeWeights()
+{
+  return InitializeWeights(data.n_rows, numClasses, fitIntercept);
+}
+
+template<typename MatType>
+const arma::mat SoftmaxRegressionFunction<MatType>::InitializeWeights(
+    const size_t featureSize,
+    const size_t numClasses,
+    const bool fitIntercept)
+{
+    arma::mat parameters;
+    InitializeWeights(parameters, featureSize, numClasses, fitIntercept);
+    return parameters;
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::InitializeWeights(
+    arma::mat &weights,
+    const size_t featureSize,
+    const size_t numClasses,
+    const bool fitIntercept)
+{
+  // Initialize values to 0.005 * r. 'r' is a matrix of random values taken from
+  // a Gaussian distribution with mean zero and variance one.
+  // If the fitIntercept flag is true, parameters.col(0) is the intercept.
+  if (fitIntercept)
+    weights.randn(numClasses, featureSize + 1);
+  else
+    weights.randn(numClasses, featureSize);
+  weights *= 0.005;
+}
+
+/**
+ * This is equivalent to applying the indicator function to the training
+ * labels. The output is in the form of a matrix, which leads to simpler
+ * calculations in the Evaluate() and Gradient() methods.
+ */
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::GetGroundTruthMatrix(
+    const arma::Row<size_t>& labels,
+    arma::sp_mat& groundTruth)
+{
+  // Calculate the ground truth matrix according to the labels passed. The
+  // ground truth matrix is a matrix of dimensions 'numClasses * numExamples',
+  // where each column contains a single entry of '1', marking the label
+  // corresponding to that example.
+
+  // Row pointers and column pointers corresponding to the entries.
+  arma::uvec rowPointers(labels.n_elem);
+  arma::uvec colPointers(labels.n_elem + 1);
+  colPointers(0) = 0;
+
+  // Row pointers are the labels of the examples, and column pointers are the
+  // number of cumulative entries made uptil that column.
+  for(size_t i = 0; i < labels.n_elem; i++)
+  {
+    rowPointers(i) = labels(i);
+    colPointers(i+1) = i + 1;
+  }
+
+  // All entries are '1'.
+  arma::vec values;
+  values.ones(labels.n_elem);
+
+  // Calculate the matrix.
+  groundTruth = arma::sp_mat(rowPointers, colPointers, values, numClasses,
+                             labels.n_elem);
+}
+
+/**
+ * Evaluate the probabilities matrix. If fitIntercept flag is true,
+ * it should consider the parameters.cols(0) intercept term.
+ */
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::GetProbabilitiesMatrix(
+    const arma::mat& parameters,
+    arma::mat& probabilities) const
+{
+  GetProbabilitiesMatrix(parameters, data, probabilities);
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::GetProbabilitiesMatrix(
+    const arma::mat& parameters,
+    const MatType& points,
+    arma::mat& probabilities) const
+{
+  arma::mat hypothesis;
+
+  if (fitIntercept)
+  {
+    // In order to add the intercept term, we should compute following matrix:
+    //     [1; data] = arma::join_cols(ones(1, data.n_cols), data)
+    //     hypothesis = arma::exp(parameters * [1; data]).
+    //
+    // Since the cost of join maybe high due to the copy of original data,
+    // split the hypothesis computation to two components.
+    hypothesis = arma::exp(arma::repmat(parameters.col(0), 1, points.n_cols) +
+                           parameters.cols(1, parameters.n_cols - 1) * points);
+  }
+  else
+  {
+    hypothesis = arma::exp(parameters * points);
+  }
+
+  probabilities = hypothesis / arma::repmat(arma::sum(hypothesis, 0),
+                                            numClasses, 1);
+}
+
+/**
+ * Evaluates the objective function given the parameters.
+ */
+template<typename MatType>
+double SoftmaxRegressionFunction<MatType>::Evaluate(
+    const arma::mat& parameters) const
+{
+  // The objective function is the negative log likelihood of the model
+  // calculated over all the training examples. Mathematically it is as follows:
+  // log likelihood = sum(1{y_i = j} * log(probability(j))) / m
+  // The sum is over all 'i's and 'j's, where 'i' points to a training example
+  // and 'j' points to a particular class. 1{x} is an indicator function whose
+  // value is 1 only when 'x' is satisfied, otherwise it is 0.
+  // 'm' is the number of training examples.
+  // The cost also takes into account the regularization to control the
+  // parameter weights.
+
+  // Calculate the class probabilities for each training example. The
+  // probabilities for each of the classes are given by:
+  // p_j = exp(theta_j' * x_i) / sum(exp(theta_k' * x_i))
+  // The sum is calculated over all the classes.
+  // x_i is the input vector for a particular training example.
+  // theta_j is the parameter vector associated with a particular class.
+  arma::mat probabilities;
+  GetProbabilitiesMatrix(parameters, probabilities);
+
+  // Calculate the log likelihood and regularization terms.
+  double logLikelihood, weightDecay, cost;
+
+  logLikelihood = arma::accu(groundTruth % arma::log(probabilities)) /
+                  data.n_cols;
+  weightDecay = 0.5 * lambda * arma::accu(parameters % parameters);
+
+  // The cost is the sum of the negative log likelihood and the regularization
+  // terms.
+  cost = -logLikelihood + weightDecay;
+
+  return cost;
+}
+
+/**
+ * Evaluates the objective function given the parameters, over a batch of
+ * contiguous points.
+ */
+template<typename MatType>
+double SoftmaxRegressionFunction<MatType>::Evaluate(
+    const arma::mat& parameters,
+    const size_t begin,
+    const size_t batchSize) const
+{
+  // The points of the batch and their labels.  For a sparse matrix, this copy
+  // only holds the nonzero elements of the batch.
+  const size_t end = begin + batchSize - 1;
+  const MatType points = data.cols(begin, end);
+  const arma::sp_mat truth = groundTruth.cols(begin, end);
+
+  arma::mat probabilities;
+  GetProbabilitiesMatrix(parameters, points, probabilities);
+
+  // The log likelihood is still divided by the number of points in the whole
+  // dataset, and the regularization is scaled by the size of the batch, so
+  // that the sum over all of the batches is Evaluate(parameters).
+  const double logLikelihood = arma::accu(truth % arma::log(probabilities)) /
+      data.n_cols;
+  const double weightDecay = 0.5 * lambda * (double(batchSize) / data.n_cols) *
+      arma::accu(parameters % parameters);
+
+  return -logLikelihood + weightDecay;
+}
+
+/**
+ * Calculates and stores the gradient values given a set of parameters.
+ */
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::Gradient(const arma::mat& parameters,
+                                                  arma::mat& gradient) const
+{
+  // Calculate the class probabilities for each training example. The
+  // probabilities for each of the classes are given by:
+  // p_j = exp(theta_j' * x_i) / sum(exp(theta_k' * x_i))
+  // The sum is calculated over all the classes.
+  // x_i is the input vector for a particular training example.
+  // theta_j is the parameter vector associated with a particular class.
+  arma::mat probabilities;
+  GetProbabilitiesMatrix(parameters, probabilities);
+
+  PointsGradient(parameters, data, groundTruth, probabilities, gradient);
+}
+
+/**
+ * Calculates and stores the gradient values given a set of parameters, over a
+ * batch of contiguous points.
+ */
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::Gradient(const arma::mat& parameters,
+                                                  const size_t begin,
+                                                  const size_t batchSize,
+                                                  arma::mat& gradient) const
+{
+  const size_t end = begin + batchSize - 1;
+  const MatType points = data.cols(begin, end);
+  const arma::sp_mat truth = groundTruth.cols(begin, end);
+
+  arma::mat probabilities;
+  GetProbabilitiesMatrix(parameters, points, probabilities);
+
+  PointsGradient(parameters, points, truth, probabilities, gradient);
+}
+
+/**
+ * Evaluates the objective function and calculates the gradient values at once,
+ * given a set of parameters.
+ */
+template<typename MatType>
+double SoftmaxRegressionFunction<MatType>::EvaluateWithGradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  // The class probabilities are shared by the objective and the gradient, so
+  // they are only calculated once here.
+  arma::mat probabilities;
+  GetProbabilitiesMatrix(parameters, probabilities);
+
+  // Calculate the log likelihood and regularization terms, as in Evaluate().
+  const double logLikelihood = arma::accu(groundTruth %
+      arma::log(probabilities)) / data.n_cols;
+  const double weightDecay = 0.5 * lambda * arma::accu(parameters %
+      parameters);
+
+  // Calculate the parameter gradients, as in Gradient().
+  PointsGradient(parameters, data, groundTruth, probabilities, gradient);
+
+  return -logLikelihood + weightDecay;
+}
+
+/**
+ * Computes the product of the Hessian and a direction.  If Z holds the
+ * products of the direction and the points, then the derivative of the
+ * probabilities along the direction is P % (Z - 1 sum(P % Z)), where P holds
+ * the probabilities; the product is that times the points, as in the gradient,
+ * plus the weight decay.
+ */
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::HessianVectorProduct(
+    const arma::mat& parameters,
+    const arma::mat& v,
+    arma::mat& hv) const
+{
+  arma::mat probabilities;
+  GetProbabilitiesMatrix(parameters, probabilities);
+
+  arma::mat directions;
+  if (fitIntercept)
+  {
+    directions = arma::repmat(v.col(0), 1, data.n_cols) +
+        v.cols(1, v.n_cols - 1) * data;
+  }
+  else
+  {
+    directions = v * data;
+  }
+
+  const arma::mat inner = probabilities % (directions - arma::repmat(
+      arma::sum(probabilities % directions, 0), numClasses, 1));
+
+  hv.set_size(v.n_rows, v.n_cols);
+  if (fitIntercept)
+  {
+    hv.col(0) = arma::sum(inner, 1) / data.n_cols + lambda * v.col(0);
+    hv.cols(1, v.n_cols - 1) = inner * data.t() / data.n_cols +
+        lambda * v.cols(1, v.n_cols - 1);
+  }
+  else
+  {
+    hv = inner * data.t() / data.n_cols + lambda * v;
+  }
+}
+
+template<typename MatType>
+void SoftmaxRegressionFunction<MatType>::PointsGradient(
+    const arma::mat& parameters,
+    const MatType& points,
+    const arma::sp_mat& truth,
+    const arma::mat& probabilities,
+    arma::mat& gradient) const
+{
+  // The regularization of the points is their share of the dataset.
+  const double regularization = lambda * (double(points.n_cols) / data.n_cols);
+
+  gradient.set_size(parameters.n_rows, parameters.n_cols);
+  const arma::mat inner = probabilities - truth;
+  if (fitIntercept)
+  {
+    // Treating the intercept term parameters.col(0) seperately to avoid
+    // the cost of building matrix [1; data].
+    gradient.col(0) = arma::sum(inner, 1) / data.n_cols +
+        regularization * parameters.col(0);
+    gradient.cols(1, parameters.n_cols - 1) =
+        inner * points.t() / data.n_cols +
+        regularization * parameters.cols(1, parameters.n_cols - 1);
+  }
+  else
+  {
+    gradient = inner * points.t() / data.n_cols + regularization * parameters;
+  }
+}
+
+} // namespace regression
+} // namespace mlpack
+
+#endif
@@ -13,8 +13,8 @@
 namespace mlpack {
 namespace regression {
 
-template<template<typename> class OptimizerType>
-SoftmaxRegression<OptimizerType>::
+template<template<typename> class OptimizerType, typename MatType>
+SoftmaxRegression<OptimizerType, MatType>::
 SoftmaxRegression(const size_t inputSize,
                   const size_t numClasses,
                   const bool fitIntercept) :
@@ -22,32 +22,33 @@ SoftmaxRegression(const size_t inputSize,
     lambda(0.0001),
     fitIntercept(fitIntercept)
 {
-   SoftmaxRegressionFunction::InitializeWeights(parameters,
-                                                inputSize, numClasses,
-                                                fitIntercept);
+   SoftmaxRegressionFunction<MatType>::InitializeWeights(parameters,
+                                                         inputSize, numClasses,
+                                                         fitIntercept);
 }
 
-template<template<typename> class OptimizerType>
-SoftmaxRegression<OptimizerType>::SoftmaxRegression(const arma::mat& data,
-                                                    const arma::Row<size_t>& labels,
-                                                    const size_t numClasses,
-                                                    const double lambda,
-                                                    const bool fitIntercept) :
+template<template<typename> class OptimizerType, typename MatType>
+SoftmaxRegression<OptimizerType, MatType>::SoftmaxRegression(
+    const MatType& data,
+    const arma::Row<size_t>& labels,
+    const size_t numClasses,
+    const double lambda,
+    const bool fitIntercept) :
     numClasses(numClasses),
     lambda(lambda),
     fitIntercept(fitIntercept)
 {
-  SoftmaxRegressionFunction regressor(data, labels, numClasses,
-                                      lambda, fitIntercept);
-  OptimizerType<SoftmaxRegressionFunction> optimizer(regressor);
+  SoftmaxRegressionFunction<MatType> regressor(data, labels, numClasses,
+                                               lambda, fitIntercept);
+  OptimizerType<SoftmaxRegressionFunction<MatType>> optimizer(regressor);
 
   parameters = regressor.GetInitialPoint();
   Train(optimizer);
 }
 
-template<template<typename> class OptimizerType>
-SoftmaxRegression<OptimizerType>::SoftmaxRegression(
-    OptimizerType<SoftmaxRegressionFunction>& optimizer) :
+template<template<typename> class OptimizerType, typename MatType>
+SoftmaxRegression<OptimizerType, MatType>::SoftmaxRegression(
+    OptimizerType<SoftmaxRegressionFunction<MatType>>& optimizer) :
     parameters(optimizer.Function().GetInitialPoint()),
     numClasses(optimizer.Function().NumClasses()),
     lambda(optimizer.Function().Lambda()),
@@ -56,10 +57,10 @@ SoftmaxRegression<OptimizerType>::SoftmaxRegression(
   Train(optimizer);
 }
 
-template<template<typename> class OptimizerType>
-void SoftmaxRegression<OptimizerType>::Predict(const arma::mat& testData,
-                                               arma::Row<size_t>& predictions)
-    const
+template<template<typename> class OptimizerType, typename MatType>
+void SoftmaxRegression<OptimizerType, MatType>::Predict(
+    const MatType& testData,
+    arma::Row<size_t>& predictions) const
 {
   if (testData.n_rows != FeatureSize())
   {
@@ -114,9 +115,9 @@ void SoftmaxRegression<OptimizerType>::Predict(const arma::mat& testData,
   }
 }
 
-template<template<typename> class OptimizerType>
-double SoftmaxRegression<OptimizerType>::ComputeAccuracy(
-    const arma::mat& testData,
+template<template<typename> class OptimizerType, typename MatType>
+double SoftmaxRegression<OptimizerType, MatType>::ComputeAccuracy(
+    const MatType& testData,
     const arma::Row<size_t>& labels)
 {
   arma::Row<size_t> predictions;
@@ -134,9 +135,9 @@ double SoftmaxRegression<OptimizerType>::ComputeAccuracy(
   return (count * 100.0) / predictions.n_elem;
 }
 
-template<template<typename> class OptimizerType>
-double SoftmaxRegression<OptimizerType>::Train(
-    OptimizerType<SoftmaxRegressionFunction>& optimizer)
+template<template<typename> class OptimizerType, typename MatType>
+double SoftmaxRegression<OptimizerType, MatType>::Train(
+    OptimizerType<SoftmaxRegressionFunction<MatType>>& optimizer)
 {
   // Train the model.
   Timer::Start("softmax_regression_optimization");
@@ -149,14 +150,15 @@ double SoftmaxRegression<OptimizerType>::Train(
   return out;
 }
 
-template<template<typename> class OptimizerType>
-double SoftmaxRegression<OptimizerType>::Train(const arma::mat& data,
-                                               const arma::Row<size_t>& labels,
-                                               const size_t numClasses)
+template<template<typename> class OptimizerType, typename MatType>
+double SoftmaxRegression<OptimizerType, MatType>::Train(
+    const MatType& data,
+    const arma::Row<size_t>& labels,
+    const size_t numClasses)
 {
-  SoftmaxRegressionFunction regressor(data, labels, numClasses,
-                                      lambda, fitIntercept);
-  OptimizerType<SoftmaxRegressionFunction> optimizer(regressor);
+  SoftmaxRegressionFunction<MatType> regressor(data, labels, numClasses,
+                                               lambda, fitIntercept);
+  OptimizerType<SoftmaxRegressionFunction<MatType>> optimizer(regressor);
 
   return Train(optimizer);
 }
@@ -241,7 +241,7 @@ std::unique_ptr<Model> TrainSoftmax(const string& trainingFile,
 {
   using namespace mlpack;
 
-  using SRF = regression::SoftmaxRegressionFunction;
+  using SRF = regression::SoftmaxRegressionFunction<>;
 
   std::unique_ptr<Model> sm;
   if (!inputModelFile.empty())
@@ -52,7 +52,9 @@ namespace nn {
  * @endcode
  *
  * This implementation allows the use of arbitrary mlpack optimizers via the
- * OptimizerType template parameter.
+ * OptimizerType template parameter.  For large datasets, MiniBatchSGD is much
+ * faster than L-BFGS, since each step only visits one batch of the points; the
+ * sparsity term is then estimated from the average activations of the batch.
  *
  * @tparam OptimizerType The optimizer to use; by default this is L-BFGS.  Any
  *     mlpack optimizer can be used here.
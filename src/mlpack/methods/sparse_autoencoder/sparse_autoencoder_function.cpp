@@ -6,6 +6,10 @@
  */
 #include "sparse_autoencoder_function.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 using namespace mlpack;
 using namespace mlpack::nn;
 using namespace std;
@@ -69,6 +73,60 @@ const arma::mat SparseAutoencoderFunction::InitializeWeights()
 /** Evaluates the objective function given the parameters.
   */
 double SparseAutoencoderFunction::Evaluate(const arma::mat& parameters) const
+{
+  arma::mat gradient;
+  return Objective(parameters, 0, data.n_cols, false, gradient);
+}
+
+/** Evaluates the objective function given the parameters, over a batch of
+  * contiguous points.
+  */
+double SparseAutoencoderFunction::Evaluate(const arma::mat& parameters,
+                                           const size_t begin,
+                                           const size_t batchSize) const
+{
+  arma::mat gradient;
+  return Objective(parameters, begin, batchSize, false, gradient);
+}
+
+/** Calculates and stores the gradient values given a set of parameters.
+  */
+void SparseAutoencoderFunction::Gradient(const arma::mat& parameters,
+                                         arma::mat& gradient) const
+{
+  Objective(parameters, 0, data.n_cols, true, gradient);
+}
+
+/** Calculates and stores the gradient values given a set of parameters, over a
+  * batch of contiguous points.
+  */
+void SparseAutoencoderFunction::Gradient(const arma::mat& parameters,
+                                         const size_t begin,
+                                         const size_t batchSize,
+                                         arma::mat& gradient) const
+{
+  Objective(parameters, begin, batchSize, true, gradient);
+}
+
+/** Evaluates the objective function and calculates the gradient values at
+  * once, given a set of parameters.
+  */
+double SparseAutoencoderFunction::EvaluateWithGradient(
+    const arma::mat& parameters,
+    arma::mat& gradient) const
+{
+  return Objective(parameters, 0, data.n_cols, true, gradient);
+}
+
+/** Evaluates the objective function (and, if requested, its gradient) over the
+  * points [begin, begin + count), scaled by the share of the dataset they make
+  * up.
+  */
+double SparseAutoencoderFunction::Objective(const arma::mat& parameters,
+                                            const size_t begin,
+                                            const size_t count,
+                                            const bool computeGradient,
+                                            arma::mat& gradient) const
 {
   // The objective function is the average squared reconstruction error of the
   // network. w1 and b1 are the weights and biases associated with the hidden
@@ -83,39 +141,107 @@ double SparseAutoencoderFunction::Evaluate(const arma::mat& parameters) const
   const size_t l2 = visibleSize;
   const size_t l3 = 2 * hiddenSize;
 
-  // w1, w2, b1 and b2 are not extracted separately, 'parameters' is directly
-  // used in their place to avoid copying data. The following representations
-  // are used:
-  // w1 <- parameters.submat(0, 0, l1-1, l2-1)
-  // w2 <- parameters.submat(l1, 0, l3-1, l2-1).t()
-  // b1 <- parameters.submat(0, l2, l1-1, l2)
-  // b2 <- parameters.submat(l3, 0, l3, l2-1).t()
-
-  arma::mat hiddenLayer, outputLayer;
-
-  // Compute activations of the hidden and output layers.
-  Sigmoid(parameters.submat(0, 0, l1 - 1, l2 - 1) * data +
-      arma::repmat(parameters.submat(0, l2, l1 - 1, l2), 1, data.n_cols),
-      hiddenLayer);
-
-  Sigmoid(parameters.submat(l1, 0, l3 - 1, l2 - 1).t() * hiddenLayer +
-      arma::repmat(parameters.submat(l3, 0, l3, l2 - 1).t(), 1, data.n_cols),
-      outputLayer);
-
-  arma::mat rhoCap, diff;
+  // The layers are small compared to the data, so they are extracted once
+  // here.  'w2t' is the transpose of w2, as it is stored in 'parameters'.
+  const arma::mat w1 = parameters.submat(0, 0, l1 - 1, l2 - 1);
+  const arma::mat w2t = parameters.submat(l1, 0, l3 - 1, l2 - 1);
+  const arma::vec b1 = parameters.submat(0, l2, l1 - 1, l2);
+  const arma::vec b2 = parameters.submat(l3, 0, l3, l2 - 1).t();
+
+  // The points are processed in blocks, in parallel if mlpack is compiled with
+  // OpenMP.  Only the hidden layer of all of the points is kept, since the
+  // average activations are needed before the delta values can be computed;
+  // the output layer is only ever held for one block per thread.
+  const size_t blockSize = 1024;
+  const size_t numBlocks = (count + blockSize - 1) / blockSize;
+  arma::mat hiddenLayer(l1, count);
+
+  #pragma omp parallel for schedule(static) if(numBlocks > 1)
+  for (size_t block = 0; block < numBlocks; ++block)
+  {
+    const size_t first = block * blockSize;
+    const size_t last = std::min(first + blockSize, count) - 1;
+
+    arma::mat hiddenBlock;
+    Sigmoid(w1 * data.cols(begin + first, begin + last) +
+        arma::repmat(b1, 1, last - first + 1), hiddenBlock);
+    hiddenLayer.cols(first, last) = hiddenBlock;
+  }
 
   // Average activations of the hidden layer.
-  rhoCap = arma::sum(hiddenLayer, 1) / data.n_cols;
-  // Difference between the reconstructed data and the original data.
-  diff = outputLayer - data;
+  const arma::vec rhoCap = arma::sum(hiddenLayer, 1) / count;
 
-  double wL2SquaredNorm;
+  // The delta vector for the output layer is given by diff * f'(z), where z is
+  // the preactivation and f is the activation function. The derivative of the
+  // sigmoid function turns out to be f(z) * (1 - f(z)). For every other layer
+  // in the neural network which comes before the output layer, the delta values
+  // are given del_n = w_n' * del_(n+1) * f'(z_n). Since our cost function also
+  // includes the KL divergence term, we adjust for that in the formula below.
+  const arma::vec klDivGrad = beta * (-(rho / rhoCap) + (1 - rho) /
+      (1 - rhoCap));
+
+  // Each thread accumulates the squared error and the gradient of its own
+  // blocks; these are added up in the order of the threads.
+#ifdef _OPENMP
+  const size_t numThreads = (size_t) omp_get_max_threads();
+#else
+  const size_t numThreads = 1;
+#endif
+  std::vector<double> threadErrors(numThreads, 0.0);
+  std::vector<arma::mat> threadGradients(numThreads);
+  if (computeGradient)
+    for (size_t t = 0; t < numThreads; ++t)
+      threadGradients[t].zeros(l3 + 1, l2 + 1);
+
+  #pragma omp parallel num_threads(numThreads) if(numBlocks > 1)
+  {
+#ifdef _OPENMP
+    const size_t thread = (size_t) omp_get_thread_num();
+#else
+    const size_t thread = 0;
+#endif
+
+    #pragma omp for schedule(static)
+    for (size_t block = 0; block < numBlocks; ++block)
+    {
+      const size_t first = block * blockSize;
+      const size_t last = std::min(first + blockSize, count) - 1;
+      const size_t points = last - first + 1;
+
+      const arma::mat dataBlock = data.cols(begin + first, begin + last);
+      const arma::mat hiddenBlock = hiddenLayer.cols(first, last);
+
+      arma::mat outputBlock;
+      Sigmoid(w2t.t() * hiddenBlock + arma::repmat(b2, 1, points),
+          outputBlock);
+
+      // Difference between the reconstructed data and the original data.
+      const arma::mat diff = outputBlock - dataBlock;
+      threadErrors[thread] += arma::accu(diff % diff);
+
+      if (!computeGradient)
+        continue;
+
+      const arma::mat delOut = diff % outputBlock % (1 - outputBlock);
+      const arma::mat delHid = (w2t * delOut + arma::repmat(klDivGrad, 1,
+          points)) % hiddenBlock % (1 - hiddenBlock);
+
+      // Accumulate the gradient values from the activations and the delta
+      // values.
+      arma::mat& g = threadGradients[thread];
+      g.submat(0, 0, l1 - 1, l2 - 1) += delHid * dataBlock.t();
+      g.submat(l1, 0, l3 - 1, l2 - 1) += hiddenBlock * delOut.t();
+      g.submat(0, l2, l1 - 1, l2) += arma::sum(delHid, 1);
+      g.submat(l3, 0, l3, l2 - 1) += arma::sum(delOut, 1).t();
+    }
+  }
+
+  double sumOfSquares = 0.0;
+  for (size_t t = 0; t < numThreads; ++t)
+    sumOfSquares += threadErrors[t];
 
   // Calculate squared L2-norms of w1 and w2.
-  wL2SquaredNorm = arma::accu(parameters.submat(0, 0, l3 - 1, l2 - 1) %
-      parameters.submat(0, 0, l3 - 1, l2 - 1));
-
-  double sumOfSquaresError, weightDecay, klDivergence, cost;
+  const double wL2SquaredNorm = arma::accu(w1 % w1) + arma::accu(w2t % w2t);
 
   // Calculate the reconstruction error, the regularization cost and the KL
   // divergence cost terms. 'sumOfSquaresError' is the average squared l2-norm
@@ -123,83 +249,29 @@ double SparseAutoencoderFunction::Evaluate(const arma::mat& parameters) const
   // of the weights w1 and w2. 'klDivergence' is the cost of the hidden layer
   // activations not being low. It is given by the following formula:
   // KL = sum_over_hSize(rho*log(rho/rhoCaq) + (1-rho)*log((1-rho)/(1-rhoCap)))
-  sumOfSquaresError = 0.5 * arma::accu(diff % diff) / data.n_cols;
-  weightDecay = 0.5 * lambda * wL2SquaredNorm;
-  klDivergence = beta * arma::accu(rho * arma::log(rho / rhoCap) + (1 - rho) *
-      arma::log((1 - rho) / (1 - rhoCap)));
+  const double sumOfSquaresError = 0.5 * sumOfSquares / count;
+  const double weightDecay = 0.5 * lambda * wL2SquaredNorm;
+  const double klDivergence = beta * arma::accu(rho * arma::log(rho / rhoCap) +
+      (1 - rho) * arma::log((1 - rho) / (1 - rhoCap)));
 
-  // The cost is the sum of the terms calculated above.
-  cost = sumOfSquaresError + weightDecay + klDivergence;
+  // A batch makes up this share of the objective, so that the batches of a
+  // pass over the data add up to (about) the full objective.
+  const double share = double(count) / data.n_cols;
 
-  return cost;
-}
+  if (computeGradient)
+  {
+    gradient.zeros(l3 + 1, l2 + 1);
+    for (size_t t = 0; t < numThreads; ++t)
+      gradient += threadGradients[t];
+    gradient /= count;
 
-/** Calculates and stores the gradient values given a set of parameters.
-  */
-void SparseAutoencoderFunction::Gradient(const arma::mat& parameters,
-                                         arma::mat& gradient) const
-{
-  // Performs a feedforward pass of the neural network, and computes the
-  // activations of the output layer as in the Evaluate() method. It uses the
-  // Backpropagation algorithm to calculate the delta values at each layer,
-  // except for the input layer. The delta values are then used with input layer
-  // and hidden layer activations to get the parameter gradients.
+    // Account for the regularization terms in the objective function.
+    gradient.submat(0, 0, l1 - 1, l2 - 1) += lambda * w1;
+    gradient.submat(l1, 0, l3 - 1, l2 - 1) += lambda * w2t;
 
-  // Compute the limits for the parameters w1, w2, b1 and b2.
-  const size_t l1 = hiddenSize;
-  const size_t l2 = visibleSize;
-  const size_t l3 = 2 * hiddenSize;
+    gradient *= share;
+  }
 
-  // w1, w2, b1 and b2 are not extracted separately, 'parameters' is directly
-  // used in their place to avoid copying data. The following representations
-  // are used:
-  // w1 <- parameters.submat(0, 0, l1-1, l2-1)
-  // w2 <- parameters.submat(l1, 0, l3-1, l2-1).t()
-  // b1 <- parameters.submat(0, l2, l1-1, l2)
-  // b2 <- parameters.submat(l3, 0, l3, l2-1).t()
-
-  arma::mat hiddenLayer, outputLayer;
-
-  // Compute activations of the hidden and output layers.
-  Sigmoid(parameters.submat(0, 0, l1 - 1, l2 - 1) * data +
-      arma::repmat(parameters.submat(0, l2, l1 - 1, l2), 1, data.n_cols),
-      hiddenLayer);
-
-  Sigmoid(parameters.submat(l1, 0, l3 - 1, l2 - 1).t() * hiddenLayer +
-      arma::repmat(parameters.submat(l3, 0, l3, l2 - 1).t(), 1, data.n_cols),
-      outputLayer);
-
-  arma::mat rhoCap, diff;
-
-  // Average activations of the hidden layer.
-  rhoCap = arma::sum(hiddenLayer, 1) / data.n_cols;
-  // Difference between the reconstructed data and the original data.
-  diff = outputLayer - data;
-
-  arma::mat klDivGrad, delOut, delHid;
-
-  // The delta vector for the output layer is given by diff * f'(z), where z is
-  // the preactivation and f is the activation function. The derivative of the
-  // sigmoid function turns out to be f(z) * (1 - f(z)). For every other layer
-  // in the neural network which comes before the output layer, the delta values
-  // are given del_n = w_n' * del_(n+1) * f'(z_n). Since our cost function also
-  // includes the KL divergence term, we adjust for that in the formula below.
-  klDivGrad = beta * (-(rho / rhoCap) + (1 - rho) / (1 - rhoCap));
-  delOut = diff % outputLayer % (1 - outputLayer);
-  delHid = (parameters.submat(l1, 0, l3 - 1, l2 - 1) * delOut +
-      arma::repmat(klDivGrad, 1, data.n_cols)) % hiddenLayer %
-      (1 - hiddenLayer);
-
-  gradient.zeros(2 * hiddenSize + 1, visibleSize + 1);
-
-  // Compute the gradient values using the activations and the delta values. The
-  // formula also accounts for the regularization terms in the objective.
-  // function.
-  gradient.submat(0, 0, l1 - 1, l2 - 1) = delHid * data.t() / data.n_cols +
-      lambda * parameters.submat(0, 0, l1 - 1, l2 - 1);
-  gradient.submat(l1, 0, l3 - 1, l2 - 1) =
-      (delOut * hiddenLayer.t() / data.n_cols +
-      lambda * parameters.submat(l1, 0, l3 - 1, l2 - 1).t()).t();
-  gradient.submat(0, l2, l1 - 1, l2) = arma::sum(delHid, 1) / data.n_cols;
-  gradient.submat(l3, 0, l3, l2 - 1) = (arma::sum(delOut, 1) / data.n_cols).t();
+  // The cost is the sum of the terms calculated above.
+  return share * (sumOfSquaresError + weightDecay + klDivergence);
 }
@@ -54,6 +54,33 @@ class SparseAutoencoderFunction
    */
   double Evaluate(const arma::mat& parameters) const;
 
+  /**
+   * Evaluates the objective function over only the batchSize points starting
+   * at begin, scaled by the share of the dataset they make up, so that the
+   * batches of a pass over the data add up to about Evaluate(parameters).  The
+   * reconstruction error and the regularization add up exactly; the sparsity
+   * term uses the average activations of the batch, so it is an estimate.
+   * This is used by optimizers such as MiniBatchSGD.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param begin Index of the first point of the batch.
+   * @param batchSize Number of points in the batch.
+   */
+  double Evaluate(const arma::mat& parameters,
+                  const size_t begin,
+                  const size_t batchSize) const;
+
+  /**
+   * Evaluates the objective function over only the i'th point (see the batch
+   * Evaluate() above).  This is useful for optimizers such as SGD, which
+   * require a separable objective function.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param i Index of the point.
+   */
+  double Evaluate(const arma::mat& parameters, const size_t i) const
+  { return Evaluate(parameters, i, 1); }
+
   /**
    * Evaluates the gradient values of the objective function given the current
    * set of parameters. The function performs a feedforward pass and computes
@@ -65,6 +92,46 @@ class SparseAutoencoderFunction
    */
   void Gradient(const arma::mat& parameters, arma::mat& gradient) const;
 
+  /**
+   * Evaluates the gradient of the objective function over only the batchSize
+   * points starting at begin, scaled in the same way as the batch Evaluate().
+   *
+   * @param parameters Current values of the model parameters.
+   * @param begin Index of the first point of the batch.
+   * @param batchSize Number of points in the batch.
+   * @param gradient Matrix where gradient values will be stored.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t begin,
+                const size_t batchSize,
+                arma::mat& gradient) const;
+
+  /**
+   * Evaluates the gradient of the objective function over only the i'th point.
+   * This is useful for optimizers such as SGD, which require a separable
+   * objective function.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param i Index of the point.
+   * @param gradient Matrix where gradient values will be stored.
+   */
+  void Gradient(const arma::mat& parameters,
+                const size_t i,
+                arma::mat& gradient) const
+  { Gradient(parameters, i, 1, gradient); }
+
+  /**
+   * Evaluates the objective function and its gradient at once, given the
+   * current set of parameters. This is the same as Evaluate() followed by
+   * Gradient(), but the feedforward pass is only performed once.
+   *
+   * @param parameters Current values of the model parameters.
+   * @param gradient Matrix where gradient values will be stored.
+   * @return Objective at the given parameters.
+   */
+  double EvaluateWithGradient(const arma::mat& parameters,
+                              arma::mat& gradient) const;
+
   /**
    * Returns the elementwise sigmoid of the passed matrix, where the sigmoid
    * function of a real number 'x' is [1 / (1 + exp(-x))].
@@ -79,6 +146,9 @@ class SparseAutoencoderFunction
   //! Return the initial point for the optimization.
   const arma::mat& GetInitialPoint() const { return initialPoint; }
 
+  //! Return the number of separable functions (the number of points).
+  size_t NumFunctions() const { return data.n_cols; }
+
   //! Sets size of the visible layer.
   void VisibleSize(const size_t visible)
   {
@@ -140,6 +210,19 @@ class SparseAutoencoderFunction
   }
 
  private:
+  /**
+   * Evaluate the objective function over the count points starting at begin,
+   * and its gradient if computeGradient is true, scaled by the share of the
+   * dataset the points make up.  The forward pass is shared by the objective
+   * and the gradient, and the points are processed in blocks, in parallel if
+   * mlpack is compiled with OpenMP.
+   */
+  double Objective(const arma::mat& parameters,
+                   const size_t begin,
+                   const size_t count,
+                   const bool computeGradient,
+                   arma::mat& gradient) const;
+
   //! The matrix of data points.
   const arma::mat& data;
   //! Intial parameter vector.
@@ -184,6 +184,12 @@ class SparseCoding
   std::string ToString() const;
 
  private:
+  /**
+   * Solve A X = B for the symmetric matrix A, with a Cholesky factorization if
+   * A is positive definite (and a general solver otherwise).
+   */
+  static arma::mat SolveSymmetric(const arma::mat& A, const arma::mat& B);
+
   //! Number of atoms.
   size_t atoms;
 
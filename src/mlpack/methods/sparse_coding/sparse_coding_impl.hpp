@@ -98,12 +98,14 @@ void SparseCoding<DictionaryInitializer>::OptimizeCode()
   // lambda2 > 0.
   arma::mat matGram = trans(dictionary) * dictionary;
 
+  Log::Debug << "Coding " << data.n_cols << " points." << std::endl;
+
+  // Each point is coded independently, with its own LARS object; all of them
+  // share the Gram matrix, so the loop over the points can be split across
+  // threads.
+  #pragma omp parallel for schedule(static)
   for (size_t i = 0; i < data.n_cols; ++i)
   {
-    // Report progress.
-    if ((i % 100) == 0)
-      Log::Debug << "Optimization at point " << i << "." << std::endl;
-
     bool useCholesky = true;
     regression::LARS lars(useCholesky, matGram, lambda1, lambda2);
 
@@ -145,83 +147,120 @@ double SparseCoding<DictionaryInitializer>::OptimizeDictionary(
     }
   }
 
-  // Handle the case of inactive atoms (atoms not used in the given coding).
+  // The Gram matrix Z Z^T of the codes and the cross term Z X^T do not change
+  // during the Newton iterations, so they are computed once.  Each thread adds
+  // up the terms of its own blocks of points.  The codes are usually sparse,
+  // so each point only adds the products of its nonzero entries; if they are
+  // not, dense products of each block are faster.
+  const bool sparseCodes = (10 * adjacencies.n_elem < atoms * data.n_cols);
+  // The cross term is summed as X Z^T, so that each atom is a column.
+  typedef std::pair<arma::mat, arma::mat> TermsType;
+  TermsType terms = parallel::BlockReduce(data.n_cols, 1024,
+      TermsType(arma::zeros<arma::mat>(atoms, atoms),
+          arma::zeros<arma::mat>(data.n_rows, atoms)),
+      [&](TermsType& blockTerms, const size_t begin, const size_t end)
+      {
+        arma::mat& gram = blockTerms.first;
+        arma::mat& cross = blockTerms.second;
+        if (!sparseCodes)
+        {
+          gram += codes.cols(begin, end - 1) * trans(codes.cols(begin,
+              end - 1));
+          cross += data.cols(begin, end - 1) * trans(codes.cols(begin,
+              end - 1));
+          return;
+        }
+
+        std::vector<size_t> nonzeros;
+        for (size_t i = begin; i < end; ++i)
+        {
+          nonzeros.clear();
+          for (size_t j = 0; j < atoms; ++j)
+            if (codes(j, i) != 0)
+              nonzeros.push_back(j);
+
+          for (size_t a = 0; a < nonzeros.size(); ++a)
+          {
+            const double code = codes(nonzeros[a], i);
+            for (size_t b = 0; b < nonzeros.size(); ++b)
+              gram(nonzeros[b], nonzeros[a]) += code * codes(nonzeros[b], i);
+            cross.col(nonzeros[a]) += code * data.col(i);
+          }
+        }
+      },
+      [](TermsType& total, const TermsType& blockTerms)
+      {
+        total.first += blockTerms.first;
+        total.second += blockTerms.second;
+      });
+  arma::mat codesZT = std::move(terms.first);
+  const arma::mat dataZT = std::move(terms.second);
+
+  // Handle the case of inactive atoms (atoms not used in the given coding);
+  // the diagonal of the Gram matrix is the squared norm of the codes of each
+  // atom.
   std::vector<size_t> inactiveAtoms;
-
   for (size_t j = 0; j < atoms; ++j)
-  {
-    if (arma::accu(codes.row(j) != 0) == 0)
+    if (codesZT(j, j) == 0)
       inactiveAtoms.push_back(j);
-  }
 
   const size_t nInactiveAtoms = inactiveAtoms.size();
   const size_t nActiveAtoms = atoms - nInactiveAtoms;
 
-  // Efficient construction of Z restricted to active atoms.
-  arma::mat matActiveZ;
-  if (nInactiveAtoms > 0)
-  {
-    math::RemoveRows(codes, inactiveAtoms, matActiveZ);
-  }
-
   if (nInactiveAtoms > 0)
   {
     Log::Warn << "There are " << nInactiveAtoms
         << " inactive atoms. They will be re-initialized randomly.\n";
   }
 
-  Log::Debug << "Solving Dual via Newton's Method.\n";
-
-  // Solve using Newton's method in the dual - note that the final dot
-  // multiplication with inv(A) seems to be unavoidable. Although more
-  // expensive, the code written this way (we use solve()) should be more
-  // numerically stable than just using inv(A) for everything.
-  arma::vec dualVars = arma::zeros<arma::vec>(nActiveAtoms);
-
-  //vec dualVars = 1e-14 * ones<vec>(nActiveAtoms);
-
-  // Method used by feature sign code - fails miserably here.  Perhaps the
-  // MATLAB optimizer fmincon does something clever?
-  //vec dualVars = 10.0 * randu(nActiveAtoms, 1);
-
-  //vec dualVars = diagvec(solve(dictionary, data * trans(codes))
-  //    - codes * trans(codes));
-  //for (size_t i = 0; i < dualVars.n_elem; i++)
-  //  if (dualVars(i) < 0)
-  //    dualVars(i) = 0;
-
-  bool converged = false;
-
-  // If we have any inactive atoms, we must construct these differently.
+  // Restrict Z Z^T and Z X^T to the active atoms (the rows and columns of the
+  // inactive atoms are zero).
   arma::mat codesXT;
-  arma::mat codesZT;
-
   if (inactiveAtoms.empty())
   {
-    codesXT = codes * trans(data);
-    codesZT = codes * trans(codes);
+    codesXT = trans(dataZT);
   }
   else
   {
-    codesXT = matActiveZ * trans(data);
-    codesZT = matActiveZ * trans(matActiveZ);
+    arma::uvec activeAtoms(nActiveAtoms);
+    for (size_t i = 0, j = 0, k = 0; i < atoms; ++i)
+    {
+      if (j < nInactiveAtoms && inactiveAtoms[j] == i)
+        ++j;
+      else
+        activeAtoms[k++] = i;
+    }
+
+    const arma::uvec allDimensions = arma::linspace<arma::uvec>(0,
+        data.n_rows - 1, data.n_rows);
+    codesZT = arma::mat(codesZT.submat(activeAtoms, activeAtoms));
+    codesXT = trans(dataZT.submat(allDimensions, activeAtoms));
   }
 
+  Log::Debug << "Solving Dual via Newton's Method.\n";
+
+  // Solve using Newton's method in the dual.  A = Z Z^T + diag(dualVars) is
+  // symmetric (and positive definite, unless the dual variables are very
+  // negative), so it is factored once per iteration with a Cholesky
+  // factorization, and its inverse gives both inv(A) Z X^T and the Hessian.
+  arma::vec dualVars = arma::zeros<arma::vec>(nActiveAtoms);
+  const arma::mat identity = arma::eye<arma::mat>(nActiveAtoms, nActiveAtoms);
+
+  bool converged = false;
   double normGradient = 0;
   double improvement = 0;
   for (size_t t = 1; (t != maxIterations) && !converged; ++t)
   {
-    arma::mat A = codesZT + diagmat(dualVars);
-
-    arma::mat matAInvZXT = solve(A, codesXT);
+    const arma::mat matAInv = SolveSymmetric(codesZT + diagmat(dualVars),
+        identity);
+    const arma::mat matAInvZXT = matAInv * codesXT;
 
     arma::vec gradient = -arma::sum(arma::square(matAInvZXT), 1);
     gradient += 1;
 
-    arma::mat hessian = -(-2 * (matAInvZXT * trans(matAInvZXT)) % inv(A));
+    const arma::mat hessian = 2 * (matAInvZXT * trans(matAInvZXT)) % matAInv;
 
-    arma::vec searchDirection = -solve(hessian, gradient);
-    //printf("%e\n", norm(searchDirection, 2));
+    arma::vec searchDirection = -SolveSymmetric(hessian, gradient);
 
     // Armijo line search.
     const double c = 1e-4;
@@ -229,16 +268,19 @@ double SparseCoding<DictionaryInitializer>::OptimizeDictionary(
     const double rho = 0.9;
     double sufficientDecrease = c * dot(gradient, searchDirection);
 
+    // The objective is trace(X Z^T inv(A) Z X^T) + sum(dualVars); the trace is
+    // the sum of the elementwise product, which is much cheaper than the
+    // product of the matrices.
+    const double sumDualVars = arma::sum(dualVars);
+    const double fOld = arma::accu(codesXT % matAInvZXT) + sumDualVars;
+
     // A maxIterations parameter for the Armijo line search may be a good idea,
     // but it doesn't seem to be causing any problems for now.
     while (true)
     {
-      // Calculate objective.
-      double sumDualVars = arma::sum(dualVars);
-      double fOld = -(-trace(trans(codesXT) * matAInvZXT) - sumDualVars);
-      double fNew = -(-trace(trans(codesXT) * solve(codesZT +
-          diagmat(dualVars + alpha * searchDirection), codesXT)) -
-          (sumDualVars + alpha * arma::sum(searchDirection)));
+      const double fNew = arma::accu(codesXT % SolveSymmetric(codesZT +
+          diagmat(dualVars + alpha * searchDirection), codesXT)) +
+          (sumDualVars + alpha * arma::sum(searchDirection));
 
       if (fNew <= fOld + alpha * sufficientDecrease)
       {
@@ -265,18 +307,19 @@ double SparseCoding<DictionaryInitializer>::OptimizeDictionary(
   if (inactiveAtoms.empty())
   {
     // Directly update dictionary.
-    dictionary = trans(solve(codesZT + diagmat(dualVars), codesXT));
+    dictionary = trans(SolveSymmetric(codesZT + diagmat(dualVars), codesXT));
   }
   else
   {
-    arma::mat activeDictionary = trans(solve(codesZT +
+    arma::mat activeDictionary = trans(SolveSymmetric(codesZT +
         diagmat(dualVars), codesXT));
 
     // Update all atoms.
     size_t currentInactiveIndex = 0;
     for (size_t i = 0; i < atoms; ++i)
     {
-      if (inactiveAtoms[currentInactiveIndex] == i)
+      if (currentInactiveIndex < nInactiveAtoms &&
+          inactiveAtoms[currentInactiveIndex] == i)
       {
         // This atom is inactive.  Reinitialize it randomly.
         dictionary.col(i) = (data.col(math::RandInt(data.n_cols)) +
@@ -299,6 +342,22 @@ double SparseCoding<DictionaryInitializer>::OptimizeDictionary(
   return normGradient;
 }
 
+// Solve A X = B for the symmetric matrix A.
+template<typename DictionaryInitializer>
+arma::mat SparseCoding<DictionaryInitializer>::SolveSymmetric(
+    const arma::mat& A,
+    const arma::mat& B)
+{
+  // If A is positive definite, two triangular solves with its Cholesky factor
+  // are much cheaper than a general solve.
+  arma::mat matUtriCholFactor;
+  if (arma::chol(matUtriCholFactor, A))
+    return solve(trimatu(matUtriCholFactor),
+        solve(trimatl(trans(matUtriCholFactor)), B));
+
+  return solve(A, B);
+}
+
 // Project each atom of the dictionary back into the unit ball (if necessary).
 template<typename DictionaryInitializer>
 void SparseCoding<DictionaryInitializer>::ProjectDictionary()
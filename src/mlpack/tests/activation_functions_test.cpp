@@ -337,4 +337,72 @@ BOOST_AUTO_TEST_CASE(GradientNumericallyCorrect)
       perturbation, threshold);
 }
 
+/**
+ * Basic test of the tanh and logistic functions with the fast approximation.
+ */
+BOOST_AUTO_TEST_CASE(FastActivationFunctionTest)
+{
+  const arma::colvec desiredTanhActivations("-0.96402758 0.9966824 0.99975321 \
+                                             -1 0.76159416 -0.76159416 \
+                                             0.96402758 0");
+
+  const arma::colvec desiredTanhDerivatives("0.07065082 0.00662419 0.00049352 \
+                                             0 0.41997434 0.41997434 \
+                                             0.07065082 1");
+
+  CheckActivationCorrect<FastTanhFunction>(activationData,
+      desiredTanhActivations);
+  CheckDerivativeCorrect<FastTanhFunction>(desiredTanhActivations,
+      desiredTanhDerivatives);
+  CheckInverseCorrect<FastTanhFunction>(desiredTanhActivations);
+
+  const arma::colvec desiredLogisticActivations("1.19202922e-01 \
+                                                 9.60834277e-01 \
+                                                 9.89013057e-01 3.04574e-44 \
+                                                 7.31058579e-01 \
+                                                 2.68941421e-01 \
+                                                 8.80797078e-01 0.5");
+
+  const arma::colvec desiredLogisticDerivatives("0.10499359 0.03763177 \
+                                                 0.01086623 3.04574e-44 \
+                                                 0.19661193 0.19661193 \
+                                                 0.10499359 0.25");
+
+  CheckActivationCorrect<FastLogisticFunction>(activationData,
+      desiredLogisticActivations);
+  CheckDerivativeCorrect<FastLogisticFunction>(desiredLogisticActivations,
+      desiredLogisticDerivatives);
+  CheckInverseCorrect<FastLogisticFunction>(activationData);
+}
+
+/**
+ * Make sure that the error of the fast approximations stays within the
+ * documented bounds, over a wide range of inputs.
+ */
+BOOST_AUTO_TEST_CASE(FastMathErrorTest)
+{
+  const arma::vec x = arma::linspace<arma::vec>(-700.0, 700.0, 100001);
+  for (size_t i = 0; i < x.n_elem; ++i)
+  {
+    const double exact = std::exp(x[i]);
+    BOOST_REQUIRE_SMALL((FastMath::Exp(x[i]) - exact) / exact, 1e-8);
+  }
+
+  const arma::vec y = arma::linspace<arma::vec>(-20.0, 20.0, 100001);
+  arma::vec fastTanh, fastLogistic;
+  FastTanhFunction::fn(y, fastTanh);
+  FastLogisticFunction::fn(y, fastLogistic);
+  for (size_t i = 0; i < y.n_elem; ++i)
+  {
+    BOOST_REQUIRE_SMALL(fastTanh[i] - std::tanh(y[i]), 1e-8);
+    BOOST_REQUIRE_SMALL(fastLogistic[i] - LogisticFunction::fn(y[i]), 1e-8);
+  }
+
+  // Inputs outside of the range of the exponential are clamped.
+  BOOST_REQUIRE_SMALL(FastLogisticFunction::fn(-1e10), 1e-300);
+  BOOST_REQUIRE_EQUAL(FastLogisticFunction::fn(1e10), 1.0);
+  BOOST_REQUIRE_EQUAL(FastTanhFunction::fn(-1e10), -1.0);
+  BOOST_REQUIRE_EQUAL(FastTanhFunction::fn(1e10), 1.0);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
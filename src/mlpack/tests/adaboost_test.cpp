@@ -752,4 +752,49 @@ BOOST_AUTO_TEST_CASE(ClassifyTest_IRIS)
   BOOST_REQUIRE(lError <= 0.30);
 }
 
+/**
+ * Classifying many points at once (in several blocks) must give the same
+ * result as classifying each point on its own.
+ */
+BOOST_AUTO_TEST_CASE(ClassifyBlocksTest_DS)
+{
+  arma::mat inputData;
+
+  if (!data::Load("vc2.txt", inputData))
+    BOOST_FAIL("Cannot load test dataset vc2.txt!");
+
+  arma::Mat<size_t> labels;
+
+  if (!data::Load("vc2_labels.txt",labels))
+    BOOST_FAIL("Cannot load labels for vc2_labels.txt");
+
+  const size_t numClasses = max(labels.row(0)) + 1;
+  const size_t inpBucketSize = 6;
+
+  decision_stump::DecisionStump<> ds(inputData, labels.row(0), numClasses,
+      inpBucketSize);
+
+  int iterations = 50;
+  double tolerance = 1e-10;
+  AdaBoost<arma::mat, mlpack::decision_stump::DecisionStump<> > a(
+      inputData, labels.row(0), iterations, tolerance, ds);
+
+  // Repeat the dataset so that there are several blocks of points.
+  arma::mat testData = arma::join_rows(arma::join_rows(inputData, inputData),
+      inputData);
+
+  arma::Row<size_t> predictedLabels(testData.n_cols);
+  a.Classify(testData, predictedLabels);
+  BOOST_REQUIRE_EQUAL(predictedLabels.n_elem, testData.n_cols);
+
+  arma::Row<size_t> singleLabel(1);
+  for (size_t i = 0; i < testData.n_cols; i++)
+  {
+    a.Classify(testData.col(i), singleLabel);
+    BOOST_REQUIRE_EQUAL(predictedLabels(i), singleLabel(0));
+    BOOST_REQUIRE_EQUAL(predictedLabels(i),
+        predictedLabels(i % inputData.n_cols));
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -563,4 +563,42 @@ BOOST_AUTO_TEST_CASE(DualBallTreeTest)
   }
 }
 
+/**
+ * Make sure that (1 + epsilon)-approximate furthest neighbor search returns,
+ * for each rank, a neighbor whose distance is at least the true furthest
+ * neighbor distance divided by (1 + epsilon).
+ */
+BOOST_AUTO_TEST_CASE(ApproximateFurthestNeighborTest)
+{
+  arma::mat dataset;
+  data::Load("test_data_3_1000.csv", dataset);
+  const double epsilon = 0.2;
+
+  AllkFN naive(dataset, true);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  naive.Search(5, trueNeighbors, trueDistances);
+
+  AllkFN dualTree(dataset);
+  AllkFN singleTree(dataset, false, true);
+  dualTree.Epsilon() = epsilon;
+  singleTree.Epsilon() = epsilon;
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    if (mode == 0)
+      dualTree.Search(5, neighbors, distances);
+    else
+      singleTree.Search(5, neighbors, distances);
+
+    for (size_t i = 0; i < distances.n_elem; ++i)
+    {
+      BOOST_REQUIRE_LE(distances[i], trueDistances[i] + 1e-10);
+      BOOST_REQUIRE_GE(distances[i], trueDistances[i] / (1 + epsilon) - 1e-10);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
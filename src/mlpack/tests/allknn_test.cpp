@@ -4,11 +4,22 @@
  * Test file for AllkNN class.
  */
 #include <mlpack/core.hpp>
+#include <mlpack/core/data/mapped_matrix.hpp>
 #include <mlpack/methods/neighbor_search/neighbor_search.hpp>
 #include <mlpack/methods/neighbor_search/unmap.hpp>
 #include <mlpack/methods/neighbor_search/ns_model.hpp>
+#include <mlpack/methods/neighbor_search/flat_tree_knn.hpp>
+#include <mlpack/methods/neighbor_search/knn_graph.hpp>
+#include <mlpack/methods/neighbor_search/mahalanobis_neighbor_search.hpp>
+#include <mlpack/methods/neighbor_search/cosine_neighbor_search.hpp>
+#include <mlpack/methods/neighbor_search/partitioned_neighbor_search.hpp>
+#include <mlpack/methods/fastmks/fastmks.hpp>
+#include <mlpack/core/kernels/cosine_distance.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/tree/spill_tree.hpp>
 #include <mlpack/core/tree/example_tree.hpp>
+#include <mlpack/core/tree/traversal_statistics.hpp>
+#include <sstream>
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
 
@@ -18,6 +29,37 @@ using namespace mlpack::tree;
 using namespace mlpack::metric;
 using namespace mlpack::bound;
 
+// A rule type whose traversals always record statistics, for the
+// TraversalStatisticsTest test case.
+typedef KDTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+    arma::mat> StatisticsTreeType;
+class InstrumentedRules : public NeighborSearchRules<NearestNeighborSort,
+    EuclideanDistance, StatisticsTreeType>
+{
+ public:
+  InstrumentedRules(const arma::mat& referenceSet,
+                    const arma::mat& querySet,
+                    arma::Mat<size_t>& neighbors,
+                    arma::mat& distances,
+                    EuclideanDistance& metric) :
+      NeighborSearchRules<NearestNeighborSort, EuclideanDistance,
+          StatisticsTreeType>(referenceSet, querySet, neighbors, distances,
+          metric, true)
+  { }
+};
+
+namespace mlpack {
+namespace tree {
+
+template<>
+struct TraversalStatisticsPolicy<InstrumentedRules>
+{
+  typedef TraversalStatistics Type;
+};
+
+} // namespace tree
+} // namespace mlpack
+
 BOOST_AUTO_TEST_SUITE(AllkNNTest);
 
 /**
@@ -820,6 +862,50 @@ BOOST_AUTO_TEST_CASE(DualCoverTreeTest)
   }
 }
 
+/**
+ * Test nearest neighbor search with a cover tree that reorders the dataset;
+ * the results are unmapped, so they are the same as those of naive search.
+ */
+BOOST_AUTO_TEST_CASE(ReorderedCoverTreeTest)
+{
+  arma::mat dataset;
+  data::Load("test_data_3_1000.csv", dataset);
+  arma::mat queries = dataset.cols(0, 99);
+
+  AllkNN naive(dataset, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+
+  typedef NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat,
+      ReorderedCoverTree> SearchType;
+  arma::Mat<size_t> coverNeighbors;
+  arma::mat coverDistances;
+
+  // Dual-tree and single-tree search, with and without a query set.
+  for (size_t run = 0; run < 4; ++run)
+  {
+    const bool singleMode = (run % 2 == 1);
+    SearchType coverTreeSearch(dataset, false, singleMode);
+    if (run < 2)
+    {
+      naive.Search(5, naiveNeighbors, naiveDistances);
+      coverTreeSearch.Search(5, coverNeighbors, coverDistances);
+    }
+    else
+    {
+      naive.Search(queries, 5, naiveNeighbors, naiveDistances);
+      coverTreeSearch.Search(queries, 5, coverNeighbors, coverDistances);
+    }
+
+    BOOST_REQUIRE_EQUAL(coverNeighbors.n_cols, naiveNeighbors.n_cols);
+    for (size_t i = 0; i < coverNeighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(coverNeighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(coverDistances[i], naiveDistances[i], 1e-5);
+    }
+  }
+}
+
 /**
  * Test the ball tree single-tree nearest-neighbors method against the naive
  * method.  This uses only a random reference dataset.
@@ -888,6 +974,430 @@ BOOST_AUTO_TEST_CASE(DualBallTreeTest)
   }
 }
 
+/**
+ * Test the vantage-point tree single-tree nearest-neighbors method against the
+ * naive method.
+ */
+BOOST_AUTO_TEST_CASE(SingleVPTreeTest)
+{
+  arma::mat data;
+  data.randu(50, 300); // 50 dimensional, 300 points.
+
+  typedef VPTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+  TreeType tree(data);
+
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat, VPTree>
+      vpTreeSearch(&tree, true);
+
+  AllkNN naive(tree.Dataset(), true);
+
+  arma::Mat<size_t> vpTreeNeighbors;
+  arma::mat vpTreeDistances;
+  vpTreeSearch.Search(2, vpTreeNeighbors, vpTreeDistances);
+
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(2, naiveNeighbors, naiveDistances);
+
+  for (size_t i = 0; i < vpTreeNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(vpTreeNeighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(vpTreeDistances[i], naiveDistances[i], 1e-5);
+  }
+}
+
+/**
+ * Test the vantage-point tree dual-tree nearest neighbors method against the
+ * kd-tree.
+ */
+BOOST_AUTO_TEST_CASE(DualVPTreeTest)
+{
+  arma::mat dataset;
+  data::Load("test_data_3_1000.csv", dataset);
+
+  AllkNN tree(dataset);
+
+  arma::Mat<size_t> kdNeighbors;
+  arma::mat kdDistances;
+  tree.Search(5, kdNeighbors, kdDistances);
+
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat, VPTree>
+      vpTreeSearch(dataset);
+
+  arma::Mat<size_t> vpNeighbors;
+  arma::mat vpDistances;
+  vpTreeSearch.Search(5, vpNeighbors, vpDistances);
+
+  for (size_t i = 0; i < vpNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(vpNeighbors(i), kdNeighbors(i));
+    BOOST_REQUIRE_CLOSE(vpDistances(i), kdDistances(i), 1e-5);
+  }
+}
+
+/**
+ * A spill tree that is not allowed to have overlapping nodes is a metric tree,
+ * so search with it is exact.
+ */
+BOOST_AUTO_TEST_CASE(ExactSpillTreeTest)
+{
+  arma::mat data;
+  data.randu(5, 500);
+
+  typedef SpillTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+  TreeType tree(data, 20, 0.05, 0.4);
+
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat, SpillTree>
+      spillTreeSearch(&tree, true);
+
+  AllkNN naive(data, true);
+
+  arma::Mat<size_t> spillNeighbors;
+  arma::mat spillDistances;
+  spillTreeSearch.Search(3, spillNeighbors, spillDistances);
+
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(3, naiveNeighbors, naiveDistances);
+
+  for (size_t i = 0; i < spillNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(spillNeighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(spillDistances[i], naiveDistances[i], 1e-5);
+  }
+}
+
+/**
+ * Defeatist search with a spill tree visits one leaf per query point, so it
+ * finds k real neighbors (no worse than the true ones) with few base cases, and
+ * dual-tree search gives the same results as single-tree search.
+ */
+BOOST_AUTO_TEST_CASE(DefeatistSpillTreeTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(5, 1000);
+  arma::mat queryData;
+  queryData.randu(5, 100);
+
+  typedef SpillTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+  TreeType tree(referenceData, 20, 0.0, 0.7);
+
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat, SpillTree>
+      singleSearch(&tree, true);
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat, SpillTree>
+      dualSearch(&tree, false);
+  AllkNN naive(referenceData, true);
+
+  arma::Mat<size_t> singleNeighbors, dualNeighbors, naiveNeighbors;
+  arma::mat singleDistances, dualDistances, naiveDistances;
+  singleSearch.Search(queryData, 3, singleNeighbors, singleDistances);
+  BOOST_REQUIRE_LE(singleSearch.BaseCases(), 20 * queryData.n_cols);
+  dualSearch.Search(queryData, 3, dualNeighbors, dualDistances);
+  naive.Search(queryData, 3, naiveNeighbors, naiveDistances);
+
+  for (size_t i = 0; i < singleNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_LT(singleNeighbors[i], referenceData.n_cols);
+    BOOST_REQUIRE_GE(singleDistances[i], naiveDistances[i] - 1e-10);
+    BOOST_REQUIRE_EQUAL(dualNeighbors[i], singleNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(dualDistances[i], singleDistances[i], 1e-5);
+  }
+}
+
+/**
+ * The overlapping children of a spill tree hold some of the same points, so
+ * the query tree of a monochromatic search can't be split across threads.
+ * Make sure that parallel dual-tree search still gives the same results as
+ * serial search, and only real neighbors (no better than those of naive
+ * search), each found once.
+ */
+BOOST_AUTO_TEST_CASE(ParallelSpillTreeTest)
+{
+  arma::mat data;
+  data.randu(5, 1000);
+
+  typedef SpillTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+  TreeType tree(data, 20, 0.05, 0.7);
+
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat, SpillTree>
+      serial(&tree, false);
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat, SpillTree>
+      parallel(&tree, false);
+  parallel.Parallel() = true;
+  AllkNN naive(data, true);
+
+  arma::Mat<size_t> serialNeighbors, parallelNeighbors, naiveNeighbors;
+  arma::mat serialDistances, parallelDistances, naiveDistances;
+  serial.Search(3, serialNeighbors, serialDistances);
+  parallel.Search(3, parallelNeighbors, parallelDistances);
+  naive.Search(3, naiveNeighbors, naiveDistances);
+
+  for (size_t i = 0; i < serialNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(parallelNeighbors[i], serialNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(parallelDistances[i], serialDistances[i], 1e-5);
+    BOOST_REQUIRE_LT(parallelNeighbors[i], data.n_cols);
+    BOOST_REQUIRE_GE(parallelDistances[i], naiveDistances[i] - 1e-10);
+  }
+
+  for (size_t i = 0; i < parallelNeighbors.n_cols; ++i)
+  {
+    BOOST_REQUIRE_NE(parallelNeighbors(0, i), parallelNeighbors(1, i));
+    BOOST_REQUIRE_NE(parallelNeighbors(0, i), parallelNeighbors(2, i));
+    BOOST_REQUIRE_NE(parallelNeighbors(1, i), parallelNeighbors(2, i));
+  }
+}
+
+// Check best-first single-tree search on the given tree type against naive
+// search.
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void CheckBestFirstSearch(const arma::mat& referenceData,
+                          const arma::mat& queryData,
+                          const size_t k)
+{
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat, TreeType>
+      bestFirst(referenceData, false, true);
+  bestFirst.BestFirst() = true;
+  AllkNN naive(referenceData, true);
+
+  arma::Mat<size_t> bestFirstNeighbors, naiveNeighbors;
+  arma::mat bestFirstDistances, naiveDistances;
+  bestFirst.Search(queryData, k, bestFirstNeighbors, bestFirstDistances);
+  naive.Search(queryData, k, naiveNeighbors, naiveDistances);
+
+  for (size_t i = 0; i < bestFirstNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(bestFirstNeighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(bestFirstDistances[i], naiveDistances[i], 1e-5);
+  }
+}
+
+/**
+ * Best-first single-tree search without a visit budget is exact, for kd-trees,
+ * cover trees, and R trees.
+ */
+BOOST_AUTO_TEST_CASE(BestFirstSearchTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(8, 1000);
+  arma::mat queryData;
+  queryData.randu(8, 200);
+
+  for (size_t k = 1; k <= 3; k += 2)
+  {
+    CheckBestFirstSearch<KDTree>(referenceData, queryData, k);
+    CheckBestFirstSearch<StandardCoverTree>(referenceData, queryData, k);
+    CheckBestFirstSearch<RTree>(referenceData, queryData, k);
+  }
+}
+
+/**
+ * Best-first search scores both overlapping children of a spill tree, so it
+ * finds the points they share twice; make sure that each neighbor is still
+ * returned once, and that the search is exact.
+ */
+BOOST_AUTO_TEST_CASE(BestFirstSpillTreeTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(5, 1000);
+  arma::mat queryData;
+  queryData.randu(5, 200);
+
+  typedef SpillTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+  TreeType tree(referenceData, 20, 0.05, 0.7);
+
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat, SpillTree>
+      bestFirst(&tree, true);
+  bestFirst.BestFirst() = true;
+  AllkNN naive(referenceData, true);
+
+  arma::Mat<size_t> bestFirstNeighbors, naiveNeighbors;
+  arma::mat bestFirstDistances, naiveDistances;
+  bestFirst.Search(queryData, 3, bestFirstNeighbors, bestFirstDistances);
+  naive.Search(queryData, 3, naiveNeighbors, naiveDistances);
+
+  for (size_t i = 0; i < bestFirstNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(bestFirstNeighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(bestFirstDistances[i], naiveDistances[i], 1e-5);
+  }
+}
+
+// Check dual-tree search with the given tree and traverser types against
+// naive search, both with a query set and monochromatically.
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType,
+         template<typename RuleType> class TraversalType>
+void CheckQueueDualTreeSearch(const arma::mat& referenceData,
+                              const arma::mat& queryData,
+                              const size_t k)
+{
+  NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat, TreeType,
+      TraversalType> search(referenceData);
+  AllkNN naive(referenceData, true);
+
+  arma::Mat<size_t> neighbors, naiveNeighbors;
+  arma::mat distances, naiveDistances;
+  search.Search(queryData, k, neighbors, distances);
+  naive.Search(queryData, k, naiveNeighbors, naiveDistances);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+  }
+
+  search.Search(k, neighbors, distances);
+  naive.Search(k, naiveNeighbors, naiveDistances);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+  }
+}
+
+typedef StandardCoverTree<EuclideanDistance,
+    NeighborSearchStat<NearestNeighborSort>, arma::mat> QueueCoverTreeType;
+typedef RTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+    arma::mat> QueueRTreeType;
+typedef KDTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+    arma::mat> QueueKDTreeType;
+
+/**
+ * Breadth-first and prioritized dual-tree search are exact, for cover trees,
+ * R trees, and kd-trees.
+ */
+BOOST_AUTO_TEST_CASE(QueueDualTreeSearchTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(5, 1000);
+  arma::mat queryData;
+  queryData.randu(5, 300);
+
+  for (size_t k = 1; k <= 5; k += 4)
+  {
+    CheckQueueDualTreeSearch<StandardCoverTree,
+        QueueCoverTreeType::LevelOrderDualTreeTraverser>(referenceData,
+        queryData, k);
+    CheckQueueDualTreeSearch<StandardCoverTree,
+        QueueCoverTreeType::PrioritizedDualTreeTraverser>(referenceData,
+        queryData, k);
+    CheckQueueDualTreeSearch<RTree,
+        QueueRTreeType::LevelOrderDualTreeTraverser>(referenceData,
+        queryData, k);
+    CheckQueueDualTreeSearch<RTree,
+        QueueRTreeType::PrioritizedDualTreeTraverser>(referenceData,
+        queryData, k);
+    CheckQueueDualTreeSearch<KDTree,
+        QueueKDTreeType::PrioritizedDualTreeTraverser>(referenceData,
+        queryData, k);
+  }
+}
+
+/**
+ * When the frontier of a prioritized traversal is capped, the traversal falls
+ * back to depth-first recursion, never holds more combinations than the cap,
+ * and still gives the same results.
+ */
+BOOST_AUTO_TEST_CASE(QueueDualTreeFrontierCapTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(4, 1000);
+  EuclideanDistance metric;
+
+  typedef NeighborSearchRules<NearestNeighborSort, EuclideanDistance,
+      QueueRTreeType> RuleType;
+
+  arma::Mat<size_t> neighbors[2];
+  arma::mat distances[2];
+  size_t peakFrontier[2];
+  const size_t maxFrontier[2] = { 0, 16 };
+  for (size_t i = 0; i < 2; ++i)
+  {
+    neighbors[i].set_size(3, dataset.n_cols);
+    neighbors[i].fill(size_t() - 1);
+    distances[i].set_size(3, dataset.n_cols);
+    distances[i].fill(DBL_MAX);
+
+    // The bounds are held in the tree, so each traversal gets a new tree.
+    QueueRTreeType tree(dataset);
+    RuleType rules(tree.Dataset(), tree.Dataset(), neighbors[i], distances[i],
+        metric, true);
+    QueueRTreeType::PrioritizedDualTreeTraverser<RuleType> traverser(rules,
+        maxFrontier[i]);
+    traverser.Traverse(tree, tree);
+
+    BOOST_REQUIRE_GT(traverser.NumBaseCases(), 0);
+    BOOST_REQUIRE_GT(traverser.NumPrunes(), 0);
+    peakFrontier[i] = traverser.PeakFrontier();
+  }
+
+  BOOST_REQUIRE_GT(peakFrontier[0], 16);
+  BOOST_REQUIRE_LE(peakFrontier[1], 16);
+
+  AllkNN naive(dataset, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(3, naiveNeighbors, naiveDistances);
+  for (size_t i = 0; i < 2; ++i)
+  {
+    for (size_t j = 0; j < naiveNeighbors.n_elem; ++j)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i][j], naiveNeighbors[j]);
+      BOOST_REQUIRE_CLOSE(distances[i][j], naiveDistances[j], 1e-5);
+    }
+  }
+}
+
+/**
+ * With a visit budget, best-first search is approximate: every query point
+ * still gets k real neighbors (no better than the true ones), and fewer base
+ * cases are computed than without a budget.
+ */
+BOOST_AUTO_TEST_CASE(BestFirstVisitBudgetTest)
+{
+  arma::mat referenceData;
+  referenceData.randu(10, 2000);
+  arma::mat queryData;
+  queryData.randu(10, 100);
+
+  AllkNN exact(referenceData, false, true);
+  exact.BestFirst() = true;
+  arma::Mat<size_t> exactNeighbors;
+  arma::mat exactDistances;
+  exact.Search(queryData, 3, exactNeighbors, exactDistances);
+
+  // Enough visits to reach a few leaves of the kd-tree.
+  AllkNN budget(referenceData, false, true);
+  budget.BestFirst() = true;
+  budget.MaxVisits() = 20;
+  arma::Mat<size_t> budgetNeighbors;
+  arma::mat budgetDistances;
+  budget.Search(queryData, 3, budgetNeighbors, budgetDistances);
+
+  BOOST_REQUIRE_LT(budget.BaseCases(), exact.BaseCases());
+  for (size_t i = 0; i < budgetNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_LT(budgetNeighbors[i], referenceData.n_cols);
+    BOOST_REQUIRE_GE(budgetDistances[i], exactDistances[i] - 1e-10);
+  }
+
+  // A budget larger than the number of nodes gives exact results.
+  budget.MaxVisits() = 2 * referenceData.n_cols;
+  budget.Search(queryData, 3, budgetNeighbors, budgetDistances);
+  for (size_t i = 0; i < budgetNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(budgetNeighbors[i], exactNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(budgetDistances[i], exactDistances[i], 1e-5);
+  }
+}
+
 // Make sure sparse nearest neighbors works with kd trees.
 BOOST_AUTO_TEST_CASE(SparseAllkNNKDTreeTest)
 {
@@ -926,33 +1436,33 @@ BOOST_AUTO_TEST_CASE(SparseAllkNNKDTreeTest)
   }
 }
 
-/*
+// Make sure sparse nearest neighbors works with cover trees.
 BOOST_AUTO_TEST_CASE(SparseAllkNNCoverTreeTest)
 {
-  typedef CoverTree<LMetric<2, true>, FirstPointIsRoot,
-      NeighborSearchStat<NearestNeighborSort>, arma::sp_mat> SparseCoverTree;
-
   // The dimensionality of these datasets must be high so that the probability
   // of a completely empty point is very low.  In this case, with dimensionality
-  // 70, the probability of all 70 dimensions being zero is 0.8^70 = 1.65e-7 in
-  // the reference set and 0.9^70 = 6.27e-4 in the query set.
+  // 50, the probability of all 50 dimensions being zero is 0.8^50 = 1.43e-5 in
+  // the query set and 0.9^50 = 5.15e-3 in the reference set.
   arma::sp_mat queryDataset;
-  queryDataset.sprandu(50, 5000, 0.2);
+  queryDataset.sprandu(50, 500, 0.2);
   arma::sp_mat referenceDataset;
-  referenceDataset.sprandu(50, 8000, 0.1);
+  referenceDataset.sprandu(50, 800, 0.1);
   arma::mat denseQuery(queryDataset);
   arma::mat denseReference(referenceDataset);
 
-  typedef NeighborSearch<NearestNeighborSort, EuclideanDistance,
-      SparseCoverTree> SparseAllkNN;
+  typedef NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::sp_mat,
+      StandardCoverTree> SparseAllkNN;
+
+  SparseAllkNN a(referenceDataset);
+  AllkNN naive(denseReference, true);
 
   arma::mat sparseDistances;
   arma::Mat<size_t> sparseNeighbors;
-  a.Search(10, sparseNeighbors, sparseDistances);
+  a.Search(queryDataset, 10, sparseNeighbors, sparseDistances);
 
   arma::mat naiveDistances;
   arma::Mat<size_t> naiveNeighbors;
-  naive.Search(10, naiveNeighbors, naiveDistances);
+  naive.Search(denseQuery, 10, naiveNeighbors, naiveDistances);
 
   for (size_t i = 0; i < naiveNeighbors.n_cols; ++i)
   {
@@ -963,7 +1473,6 @@ BOOST_AUTO_TEST_CASE(SparseAllkNNCoverTreeTest)
     }
   }
 }
-*/
 
 BOOST_AUTO_TEST_CASE(KNNModelTest)
 {
@@ -975,7 +1484,7 @@ BOOST_AUTO_TEST_CASE(KNNModelTest)
   arma::mat referenceData = arma::randu<arma::mat>(10, 200);
 
   // Build all the possible models.
-  KNNModel models[10];
+  KNNModel models[12];
   models[0] = KNNModel(KNNModel::TreeTypes::KD_TREE, true);
   models[1] = KNNModel(KNNModel::TreeTypes::KD_TREE, false);
   models[2] = KNNModel(KNNModel::TreeTypes::COVER_TREE, true);
@@ -986,6 +1495,8 @@ BOOST_AUTO_TEST_CASE(KNNModelTest)
   models[7] = KNNModel(KNNModel::TreeTypes::R_STAR_TREE, false);
   models[8] = KNNModel(KNNModel::TreeTypes::BALL_TREE, true);
   models[9] = KNNModel(KNNModel::TreeTypes::BALL_TREE, false);
+  models[10] = KNNModel(KNNModel::TreeTypes::VP_TREE, true);
+  models[11] = KNNModel(KNNModel::TreeTypes::VP_TREE, false);
 
   for (size_t j = 0; j < 2; ++j)
   {
@@ -995,7 +1506,7 @@ BOOST_AUTO_TEST_CASE(KNNModelTest)
     arma::mat baselineDistances;
     knn.Search(queryData, 3, baselineNeighbors, baselineDistances);
 
-    for (size_t i = 0; i < 10; ++i)
+    for (size_t i = 0; i < 12; ++i)
     {
       // We only have std::move() constructors so make a copy of our data.
       arma::mat referenceCopy(referenceData);
@@ -1030,6 +1541,39 @@ BOOST_AUTO_TEST_CASE(KNNModelTest)
   }
 }
 
+/**
+ * Make sure an NSModel with a spill tree uses the given tau and rho: with a rho
+ * below one half the search is exact.
+ */
+BOOST_AUTO_TEST_CASE(KNNModelSpillTreeTest)
+{
+  typedef NSModel<NearestNeighborSort> KNNModel;
+
+  arma::mat queryData = arma::randu<arma::mat>(10, 50);
+  arma::mat referenceData = arma::randu<arma::mat>(10, 200);
+
+  AllkNN knn(referenceData);
+  arma::Mat<size_t> baselineNeighbors;
+  arma::mat baselineDistances;
+  knn.Search(queryData, 3, baselineNeighbors, baselineDistances);
+
+  KNNModel model(KNNModel::TreeTypes::SPILL_TREE);
+  model.Tau() = 0.1;
+  model.Rho() = 0.4;
+  model.BuildModel(std::move(referenceData), 20, false, true);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  model.Search(std::move(queryData), 3, neighbors, distances);
+
+  BOOST_REQUIRE_EQUAL(neighbors.n_elem, baselineNeighbors.n_elem);
+  for (size_t k = 0; k < distances.n_elem; ++k)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[k], baselineNeighbors[k]);
+    BOOST_REQUIRE_CLOSE(distances[k], baselineDistances[k], 1e-5);
+  }
+}
+
 BOOST_AUTO_TEST_CASE(KNNModelMonochromaticTest)
 {
   // Ensure that we can build an NSModel<NearestNeighborSearch> and get correct
@@ -1039,7 +1583,7 @@ BOOST_AUTO_TEST_CASE(KNNModelMonochromaticTest)
   arma::mat referenceData = arma::randu<arma::mat>(10, 200);
 
   // Build all the possible models.
-  KNNModel models[10];
+  KNNModel models[12];
   models[0] = KNNModel(KNNModel::TreeTypes::KD_TREE, true);
   models[1] = KNNModel(KNNModel::TreeTypes::KD_TREE, false);
   models[2] = KNNModel(KNNModel::TreeTypes::COVER_TREE, true);
@@ -1050,6 +1594,8 @@ BOOST_AUTO_TEST_CASE(KNNModelMonochromaticTest)
   models[7] = KNNModel(KNNModel::TreeTypes::R_STAR_TREE, false);
   models[8] = KNNModel(KNNModel::TreeTypes::BALL_TREE, true);
   models[0] = KNNModel(KNNModel::TreeTypes::BALL_TREE, false);
+  models[10] = KNNModel(KNNModel::TreeTypes::VP_TREE, true);
+  models[11] = KNNModel(KNNModel::TreeTypes::VP_TREE, false);
 
   for (size_t j = 0; j < 2; ++j)
   {
@@ -1059,7 +1605,7 @@ BOOST_AUTO_TEST_CASE(KNNModelMonochromaticTest)
     arma::mat baselineDistances;
     knn.Search(3, baselineNeighbors, baselineDistances);
 
-    for (size_t i = 0; i < 10; ++i)
+    for (size_t i = 0; i < 12; ++i)
     {
       // We only have a std::move() constructor... so copy the data.
       arma::mat referenceCopy(referenceData);
@@ -1142,4 +1688,1436 @@ BOOST_AUTO_TEST_CASE(NeighborPtrDeleteTest)
   BOOST_REQUIRE_EQUAL(distances.n_rows, 3);
 }
 
+/**
+ * Make sure that parallel dual-tree search gives the same results as serial
+ * dual-tree search for kd-trees, cover trees, and R trees, in both the
+ * bichromatic and monochromatic settings.
+ */
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void CheckParallelDualTreeSearch(const arma::mat& referenceData,
+                                 const arma::mat& queryData)
+{
+  typedef NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat,
+      TreeType> KNNType;
+
+  KNNType serial(referenceData);
+  KNNType parallel(referenceData);
+  parallel.Parallel() = true;
+
+  for (size_t mono = 0; mono < 2; ++mono)
+  {
+    arma::Mat<size_t> serialNeighbors, parallelNeighbors;
+    arma::mat serialDistances, parallelDistances;
+
+    if (mono == 0)
+    {
+      serial.Search(queryData, 5, serialNeighbors, serialDistances);
+      parallel.Search(queryData, 5, parallelNeighbors, parallelDistances);
+    }
+    else
+    {
+      serial.Search(5, serialNeighbors, serialDistances);
+      parallel.Search(5, parallelNeighbors, parallelDistances);
+    }
+
+    BOOST_REQUIRE_EQUAL(parallelNeighbors.n_rows, serialNeighbors.n_rows);
+    BOOST_REQUIRE_EQUAL(parallelNeighbors.n_cols, serialNeighbors.n_cols);
+    for (size_t i = 0; i < serialNeighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(parallelNeighbors[i], serialNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(parallelDistances[i], serialDistances[i], 1e-5);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ParallelDualTreeSearchTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(5, 2000);
+  arma::mat queryData = arma::randu<arma::mat>(5, 1500);
+
+  CheckParallelDualTreeSearch<KDTree>(referenceData, queryData);
+  CheckParallelDualTreeSearch<StandardCoverTree>(referenceData, queryData);
+  CheckParallelDualTreeSearch<RTree>(referenceData, queryData);
+}
+
+/**
+ * Make sure that parallel single-tree search gives the same results as serial
+ * single-tree search with kd-trees, in both the bichromatic and monochromatic
+ * settings.
+ */
+BOOST_AUTO_TEST_CASE(ParallelSingleTreeSearchTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(5, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(5, 700);
+
+  AllkNN serial(referenceData, false, true);
+  AllkNN parallel(referenceData, false, true);
+  parallel.Parallel() = true;
+
+  for (size_t mono = 0; mono < 2; ++mono)
+  {
+    arma::Mat<size_t> serialNeighbors, parallelNeighbors;
+    arma::mat serialDistances, parallelDistances;
+
+    if (mono == 0)
+    {
+      serial.Search(queryData, 4, serialNeighbors, serialDistances);
+      parallel.Search(queryData, 4, parallelNeighbors, parallelDistances);
+    }
+    else
+    {
+      serial.Search(4, serialNeighbors, serialDistances);
+      parallel.Search(4, parallelNeighbors, parallelDistances);
+    }
+
+    for (size_t i = 0; i < serialNeighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(parallelNeighbors[i], serialNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(parallelDistances[i], serialDistances[i], 1e-5);
+    }
+
+    // The amount of work done should not change.
+    BOOST_REQUIRE_EQUAL(parallel.BaseCases(), serial.BaseCases());
+    BOOST_REQUIRE_EQUAL(parallel.Scores(), serial.Scores());
+  }
+}
+
+/**
+ * Make sure that the blocked leaf base cases (which are used for the Euclidean
+ * and squared Euclidean distances with kd-trees) give exactly the same results
+ * as the naive method on higher-dimensional data whose norms are large relative
+ * to the distances between points.
+ */
+BOOST_AUTO_TEST_CASE(BlockBaseCaseVsNaiveTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(60, 1200) + 50.0;
+  arma::mat queryData = arma::randu<arma::mat>(60, 400) + 50.0;
+
+  AllkNN allknn(referenceData);
+  AllkNN naive(referenceData, true);
+
+  arma::Mat<size_t> neighborsTree, neighborsNaive;
+  arma::mat distancesTree, distancesNaive;
+
+  allknn.Search(queryData, 7, neighborsTree, distancesTree);
+  naive.Search(queryData, 7, neighborsNaive, distancesNaive);
+
+  for (size_t i = 0; i < neighborsTree.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighborsTree[i], neighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distancesTree[i], distancesNaive[i], 1e-5);
+  }
+
+  allknn.Search(7, neighborsTree, distancesTree);
+  naive.Search(7, neighborsNaive, distancesNaive);
+
+  for (size_t i = 0; i < neighborsTree.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighborsTree[i], neighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distancesTree[i], distancesNaive[i], 1e-5);
+  }
+
+  // Now the squared Euclidean distance.
+  NeighborSearch<NearestNeighborSort, SquaredEuclideanDistance> squared(
+      referenceData);
+  NeighborSearch<NearestNeighborSort, SquaredEuclideanDistance> squaredNaive(
+      referenceData, true);
+
+  squared.Search(queryData, 7, neighborsTree, distancesTree);
+  squaredNaive.Search(queryData, 7, neighborsNaive, distancesNaive);
+
+  for (size_t i = 0; i < neighborsTree.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighborsTree[i], neighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distancesTree[i], distancesNaive[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that NSModel::SearchBatch() gives the same results as Search() for
+ * batches both smaller and larger than the dual-tree threshold, and that it
+ * restores the search mode of the model.
+ */
+BOOST_AUTO_TEST_CASE(KNNModelSearchBatchTest)
+{
+  typedef NSModel<NearestNeighborSort> KNNModel;
+
+  arma::mat referenceData = arma::randu<arma::mat>(5, 500);
+
+  KNNModel model(KNNModel::TreeTypes::KD_TREE, false);
+  arma::mat referenceCopy(referenceData);
+  model.BuildModel(std::move(referenceCopy), 20, false, false);
+
+  AllkNN knn(referenceData);
+
+  // The first batch is searched with single-tree search, and the second with
+  // dual-tree search.
+  const size_t batchSizes[2] = { 10, 200 };
+  for (size_t b = 0; b < 2; ++b)
+  {
+    arma::mat batch = arma::randu<arma::mat>(5, batchSizes[b]);
+
+    arma::Mat<size_t> baselineNeighbors;
+    arma::mat baselineDistances;
+    knn.Search(batch, 4, baselineNeighbors, baselineDistances);
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    model.SearchBatch(std::move(batch), 4, neighbors, distances, 50);
+
+    BOOST_REQUIRE_EQUAL(model.SingleMode(), false);
+    BOOST_REQUIRE_EQUAL(neighbors.n_rows, baselineNeighbors.n_rows);
+    BOOST_REQUIRE_EQUAL(neighbors.n_cols, baselineNeighbors.n_cols);
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], baselineNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], baselineDistances[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure that a memory-mapped reference set can be moved into AllkNN and
+ * gives the same results as a reference set held in memory.
+ */
+BOOST_AUTO_TEST_CASE(MappedReferenceSetTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(4, 300);
+  BOOST_REQUIRE(data::Save("mapped_reference.bin", referenceData, false,
+      false));
+
+  arma::Mat<size_t> neighbors, mappedNeighbors;
+  arma::mat distances, mappedDistances;
+
+  AllkNN knn(referenceData);
+  knn.Search(5, neighbors, distances);
+
+  {
+    data::MappedMatrix mapped("mapped_reference.bin");
+    AllkNN mappedKnn(std::move(mapped.Matrix()));
+    mappedKnn.Search(5, mappedNeighbors, mappedDistances);
+  }
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(mappedNeighbors[i], neighbors[i]);
+    BOOST_REQUIRE_CLOSE(mappedDistances[i], distances[i], 1e-5);
+  }
+
+  remove("mapped_reference.bin");
+}
+
+/**
+ * Make sure that single-precision search with kd-trees gives the same results
+ * as single-precision naive search, in both dual-tree and single-tree mode.
+ */
+BOOST_AUTO_TEST_CASE(FloatKDTreeTest)
+{
+  typedef NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::fmat,
+      KDTree> FloatKNN;
+
+  arma::fmat referenceData = arma::randu<arma::fmat>(20, 800);
+  arma::fmat queryData = arma::randu<arma::fmat>(20, 200);
+
+  FloatKNN naive(referenceData, true);
+  arma::Mat<size_t> neighborsNaive;
+  arma::mat distancesNaive;
+  naive.Search(queryData, 5, neighborsNaive, distancesNaive);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    FloatKNN knn(referenceData, false, (mode == 1));
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    knn.Search(queryData, 5, neighbors, distances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], neighborsNaive[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], distancesNaive[i], 1e-3);
+    }
+  }
+}
+
+/**
+ * Make sure that searching a flat kd-tree gives the same results as naive
+ * search.
+ */
+BOOST_AUTO_TEST_CASE(FlatTreeKNNTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(4, 1500);
+  arma::mat queryData = arma::randu<arma::mat>(4, 300);
+
+  AllkNN naive(referenceData, true);
+  arma::Mat<size_t> neighborsNaive;
+  arma::mat distancesNaive;
+  naive.Search(queryData, 7, neighborsNaive, distancesNaive);
+
+  std::vector<size_t> oldFromNew;
+  KDTree<EuclideanDistance, EmptyStatistic, arma::mat> tree(referenceData,
+      oldFromNew);
+  FlatBinarySpaceTree flatTree(tree, oldFromNew);
+
+  FlatTreeKNN<> knn(flatTree);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  knn.Search(queryData, 7, neighbors, distances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], neighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], distancesNaive[i], 1e-5);
+  }
+
+  BOOST_REQUIRE_THROW(knn.Search(queryData, 1501, neighbors, distances),
+      std::invalid_argument);
+}
+
+/**
+ * Make sure that points inserted into an R tree one at a time give the same
+ * results as a model built on the whole dataset.
+ */
+BOOST_AUTO_TEST_CASE(RTreeInsertTest)
+{
+  typedef NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat,
+      RTree> RTreeKNN;
+
+  arma::mat dataset = arma::randu<arma::mat>(3, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 100);
+
+  arma::mat initialData = dataset.cols(0, 799);
+  RTreeKNN knn(initialData);
+  for (size_t i = 800; i < 1000; ++i)
+    knn.Insert(dataset.col(i));
+
+  BOOST_REQUIRE_EQUAL(knn.ReferenceSet().n_cols, 1000);
+
+  AllkNN naive(dataset, true);
+
+  arma::Mat<size_t> neighbors, neighborsNaive;
+  arma::mat distances, distancesNaive;
+  knn.Search(queryData, 5, neighbors, distances);
+  naive.Search(queryData, 5, neighborsNaive, distancesNaive);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], neighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], distancesNaive[i], 1e-5);
+  }
+
+  // Inserting a point of the wrong dimensionality should fail.
+  BOOST_REQUIRE_THROW(knn.Insert(arma::vec(4)), std::invalid_argument);
+}
+
+/**
+ * Make sure that points removed from an R* tree are no longer returned as
+ * neighbors, and that the other results are unaffected.
+ */
+BOOST_AUTO_TEST_CASE(RStarTreeRemoveTest)
+{
+  typedef NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat,
+      RStarTree> RStarTreeKNN;
+
+  arma::mat dataset = arma::randu<arma::mat>(3, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 100);
+
+  RStarTreeKNN knn(dataset);
+  for (size_t i = 0; i < 100; ++i)
+    knn.Remove(i);
+
+  // Removing a point twice should fail.
+  BOOST_REQUIRE_THROW(knn.Remove(0), std::invalid_argument);
+
+  arma::mat remainingData = dataset.cols(100, 999);
+  AllkNN naive(remainingData, true);
+
+  arma::Mat<size_t> neighbors, neighborsNaive;
+  arma::mat distances, distancesNaive;
+  knn.Search(queryData, 5, neighbors, distances);
+  naive.Search(queryData, 5, neighborsNaive, distancesNaive);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], neighborsNaive[i] + 100);
+    BOOST_REQUIRE_CLOSE(distances[i], distancesNaive[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that after points are removed from an R* tree, k can be as large as
+ * the number of remaining points, and the removed points are neither returned
+ * nor searched for.
+ */
+BOOST_AUTO_TEST_CASE(RStarTreeRemoveLiveCountTest)
+{
+  typedef NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat,
+      RStarTree> RStarTreeKNN;
+
+  arma::mat dataset = arma::randu<arma::mat>(3, 100);
+  arma::mat queryData = arma::randu<arma::mat>(3, 20);
+
+  RStarTreeKNN knn(dataset);
+  for (size_t i = 0; i < 70; ++i)
+    knn.Remove(i);
+
+  // Only 30 points remain.
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  BOOST_REQUIRE_THROW(knn.Search(queryData, 31, neighbors, distances),
+      std::invalid_argument);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    knn.SingleMode() = (mode == 1);
+    knn.Search(queryData, 30, neighbors, distances);
+
+    BOOST_REQUIRE_EQUAL(neighbors.n_rows, 30);
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_GE(neighbors[i], 70);
+      BOOST_REQUIRE_LT(neighbors[i], 100);
+    }
+
+    // Each remaining point has 29 other remaining points.
+    BOOST_REQUIRE_THROW(knn.Search(30, neighbors, distances),
+        std::invalid_argument);
+    knn.Search(29, neighbors, distances);
+
+    BOOST_REQUIRE_EQUAL(neighbors.n_cols, 100);
+    for (size_t i = 0; i < 70; ++i)
+      for (size_t j = 0; j < 29; ++j)
+        BOOST_REQUIRE_EQUAL(neighbors(j, i), size_t() - 1);
+    for (size_t i = 70; i < 100; ++i)
+    {
+      for (size_t j = 0; j < 29; ++j)
+      {
+        BOOST_REQUIRE_GE(neighbors(j, i), 70);
+        BOOST_REQUIRE_LT(neighbors(j, i), 100);
+        BOOST_REQUIRE_NE(neighbors(j, i), i);
+      }
+    }
+  }
+}
+
+/**
+ * Make sure that NSModel only allows insertion for R trees and R* trees.
+ */
+BOOST_AUTO_TEST_CASE(KNNModelInsertTest)
+{
+  typedef NSModel<NearestNeighborSort> KNNModel;
+
+  arma::mat dataset = arma::randu<arma::mat>(3, 200);
+
+  KNNModel rTreeModel(KNNModel::TreeTypes::R_TREE, false);
+  arma::mat datasetCopy(dataset);
+  rTreeModel.BuildModel(std::move(datasetCopy), 20, false, false);
+  rTreeModel.Insert(arma::randu<arma::vec>(3));
+  BOOST_REQUIRE_EQUAL(rTreeModel.Dataset().n_cols, 201);
+  rTreeModel.Remove(200);
+
+  KNNModel kdTreeModel(KNNModel::TreeTypes::KD_TREE, false);
+  datasetCopy = dataset;
+  kdTreeModel.BuildModel(std::move(datasetCopy), 20, false, false);
+  BOOST_REQUIRE_THROW(kdTreeModel.Insert(arma::randu<arma::vec>(3)),
+      std::invalid_argument);
+  BOOST_REQUIRE_THROW(kdTreeModel.Remove(0), std::invalid_argument);
+}
+
+/**
+ * Make sure that (1 + epsilon)-approximate search with kd-trees and cover trees
+ * returns, for each rank, a neighbor whose distance is within a factor of
+ * (1 + epsilon) of the true neighbor distance.
+ */
+BOOST_AUTO_TEST_CASE(ApproximateSearchTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(6, 2000);
+  arma::mat queryData = arma::randu<arma::mat>(6, 500);
+  const double epsilon = 0.5;
+
+  AllkNN naive(referenceData, true);
+  arma::Mat<size_t> trueNeighbors;
+  arma::mat trueDistances;
+  naive.Search(queryData, 5, trueNeighbors, trueDistances);
+
+  AllkNN exact(referenceData);
+  arma::Mat<size_t> exactNeighbors;
+  arma::mat exactDistances;
+  exact.Search(queryData, 5, exactNeighbors, exactDistances);
+
+  AllkNN dualTree(referenceData);
+  AllkNN singleTree(referenceData, false, true);
+  NeighborSearch<NearestNeighborSort, LMetric<2, true>, arma::mat,
+      StandardCoverTree> coverTree(referenceData);
+  dualTree.Epsilon() = epsilon;
+  singleTree.Epsilon() = epsilon;
+  coverTree.Epsilon() = epsilon;
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    if (mode == 0)
+      dualTree.Search(queryData, 5, neighbors, distances);
+    else if (mode == 1)
+      singleTree.Search(queryData, 5, neighbors, distances);
+    else
+      coverTree.Search(queryData, 5, neighbors, distances);
+
+    for (size_t i = 0; i < distances.n_elem; ++i)
+    {
+      BOOST_REQUIRE_GE(distances[i], trueDistances[i] - 1e-10);
+      BOOST_REQUIRE_LE(distances[i], (1 + epsilon) * trueDistances[i] + 1e-10);
+    }
+  }
+
+  // With this much slack, approximate search should prune more.
+  BOOST_REQUIRE_LT(dualTree.BaseCases(), exact.BaseCases());
+}
+
+/**
+ * Make sure that the traversal statistics recorded during a dual-tree
+ * traversal are consistent with the counts held by the traverser, that they
+ * are added to the global statistics, and that the traversal still gives the
+ * correct results.
+ */
+BOOST_AUTO_TEST_CASE(TraversalStatisticsTest)
+{
+#ifndef MLPACK_TRAVERSAL_STATISTICS
+  // By default, nothing is recorded.
+  typedef NeighborSearchRules<NearestNeighborSort, EuclideanDistance,
+      StatisticsTreeType> RuleType;
+  BOOST_REQUIRE((std::is_same<StatisticsTreeType::DualTreeTraverser<
+      RuleType>::TraversalStatisticsType, NullTraversalStatistics>::value));
+#endif
+
+  arma::mat dataset = arma::randu<arma::mat>(3, 1000);
+  StatisticsTreeType tree(dataset, 10);
+
+  arma::Mat<size_t> neighbors(3, dataset.n_cols);
+  neighbors.fill(size_t() - 1);
+  arma::mat distances(3, dataset.n_cols);
+  distances.fill(DBL_MAX);
+  EuclideanDistance metric;
+
+  TraversalStatistics::Global().Reset();
+  size_t baseCases = 0;
+  {
+    InstrumentedRules rules(tree.Dataset(), tree.Dataset(), neighbors,
+        distances, metric);
+    StatisticsTreeType::DualTreeTraverser<InstrumentedRules> traverser(rules);
+    traverser.Traverse(tree, tree);
+
+    const TraversalStatistics& statistics = traverser.Statistics();
+    baseCases = traverser.NumBaseCases();
+    BOOST_REQUIRE_GT(baseCases, 0);
+    BOOST_REQUIRE_EQUAL(statistics.Total().baseCases, baseCases);
+    BOOST_REQUIRE_GE(statistics.Total().scores, traverser.NumScores());
+    BOOST_REQUIRE_GT(statistics.Total().prunes, 0);
+    BOOST_REQUIRE_LE(statistics.Total().rescoreSuccesses,
+        statistics.Total().rescores);
+
+    // Every event is recorded once in each table.
+    TraversalStatistics::Counters queryTotal, referenceTotal, sizeTotal;
+    for (size_t i = 0; i < statistics.QueryDepths().size(); ++i)
+      queryTotal.Merge(statistics.QueryDepths()[i]);
+    for (size_t i = 0; i < statistics.ReferenceDepths().size(); ++i)
+      referenceTotal.Merge(statistics.ReferenceDepths()[i]);
+    std::map<std::pair<size_t, size_t>,
+        TraversalStatistics::Counters>::const_iterator it;
+    for (it = statistics.NodeSizes().begin();
+         it != statistics.NodeSizes().end(); ++it)
+      sizeTotal.Merge(it->second);
+
+    BOOST_REQUIRE_EQUAL(queryTotal.scores, statistics.Total().scores);
+    BOOST_REQUIRE_EQUAL(referenceTotal.scores, statistics.Total().scores);
+    BOOST_REQUIRE_EQUAL(sizeTotal.scores, statistics.Total().scores);
+    BOOST_REQUIRE_EQUAL(queryTotal.baseCases, baseCases);
+    BOOST_REQUIRE_EQUAL(referenceTotal.baseCases, baseCases);
+    BOOST_REQUIRE_EQUAL(sizeTotal.baseCases, baseCases);
+
+    // The root is at depth 0, and the tree is deeper than that.
+    BOOST_REQUIRE_GT(statistics.QueryDepths().size(), 1);
+  }
+
+  // The statistics should have been added to the global statistics when the
+  // traverser was destroyed.
+  BOOST_REQUIRE_EQUAL(TraversalStatistics::Global().Total().baseCases,
+      baseCases);
+  std::ostringstream json;
+  TraversalStatistics::Global().ToJSON(json);
+  std::ostringstream expected;
+  expected << "\"base_cases\": " << baseCases;
+  BOOST_REQUIRE(json.str().find(expected.str()) != std::string::npos);
+  TraversalStatistics::Global().Reset();
+
+  // The results should be correct.
+  AllkNN naive(tree.Dataset(), true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(3, naiveNeighbors, naiveDistances);
+  for (size_t i = 0; i < distances.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+}
+
+//! A callback that stores the results it is given, in the order of the calls.
+struct StoreNeighborsCallback
+{
+  std::vector<size_t> queries;
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+
+  void operator()(const size_t queryIndex,
+                  const arma::Col<size_t>& queryNeighbors,
+                  const arma::vec& queryDistances)
+  {
+    queries.push_back(queryIndex);
+    neighbors.insert_cols(neighbors.n_cols, queryNeighbors);
+    distances.insert_cols(distances.n_cols, queryDistances);
+  }
+};
+
+/**
+ * Searching in blocks with a callback gives the results of each query point, in
+ * order, and they are the same as the results of a regular search.
+ */
+BOOST_AUTO_TEST_CASE(CallbackSearchTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 500);
+  arma::mat queryData = arma::randu<arma::mat>(3, 230);
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    AllkNN knn(referenceData, mode == 0, mode == 1);
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    knn.Search(queryData, 5, neighbors, distances);
+
+    StoreNeighborsCallback callback;
+    knn.Search(queryData, 5, callback, 64);
+
+    BOOST_REQUIRE_EQUAL(callback.queries.size(), queryData.n_cols);
+    for (size_t i = 0; i < queryData.n_cols; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(callback.queries[i], i);
+      for (size_t j = 0; j < 5; ++j)
+      {
+        BOOST_REQUIRE_EQUAL(callback.neighbors(j, i), neighbors(j, i));
+        BOOST_REQUIRE_CLOSE(callback.distances(j, i), distances(j, i), 1e-5);
+      }
+    }
+
+    // Now the monochromatic case (there are no ties in random data).
+    knn.Search(5, neighbors, distances);
+
+    StoreNeighborsCallback monoCallback;
+    knn.Search(5, monoCallback, 64);
+
+    BOOST_REQUIRE_EQUAL(monoCallback.queries.size(), referenceData.n_cols);
+    for (size_t i = 0; i < referenceData.n_cols; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(monoCallback.queries[i], i);
+      for (size_t j = 0; j < 5; ++j)
+      {
+        BOOST_REQUIRE_EQUAL(monoCallback.neighbors(j, i), neighbors(j, i));
+        BOOST_REQUIRE_CLOSE(monoCallback.distances(j, i), distances(j, i),
+            1e-5);
+      }
+    }
+  }
+}
+
+/**
+ * With a base case budget, the query points that were not truncated get their
+ * exact neighbors, and the truncated ones still get k candidates.  A large
+ * enough budget changes nothing.
+ */
+BOOST_AUTO_TEST_CASE(BaseCaseBudgetTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 2000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 500);
+
+  AllkNN naive(referenceData, true);
+  arma::Mat<size_t> naiveNeighbors, monoNaiveNeighbors;
+  arma::mat naiveDistances, monoNaiveDistances;
+  naive.Search(queryData, 3, naiveNeighbors, naiveDistances);
+  naive.Search(3, monoNaiveNeighbors, monoNaiveDistances);
+
+  for (size_t mode = 0; mode < 4; ++mode)
+  {
+    const bool singleMode = (mode % 2 == 0);
+    const bool mono = (mode >= 2);
+    const arma::Mat<size_t>& trueNeighbors = (mono) ? monoNaiveNeighbors :
+        naiveNeighbors;
+    const arma::mat& trueDistances = (mono) ? monoNaiveDistances :
+        naiveDistances;
+
+    AllkNN knn(referenceData, false, singleMode);
+    knn.BaseCaseBudget() = 5000;
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    if (mono)
+      knn.Search(3, neighbors, distances);
+    else
+      knn.Search(queryData, 3, neighbors, distances);
+
+    BOOST_REQUIRE_EQUAL(knn.Truncated().size(), neighbors.n_cols);
+
+    size_t numTruncated = 0;
+    for (size_t i = 0; i < neighbors.n_cols; ++i)
+    {
+      for (size_t j = 0; j < 3; ++j)
+        BOOST_REQUIRE_LT(neighbors(j, i), referenceData.n_cols);
+
+      if (knn.Truncated()[i])
+      {
+        ++numTruncated;
+        continue;
+      }
+
+      for (size_t j = 0; j < 3; ++j)
+      {
+        BOOST_REQUIRE_EQUAL(neighbors(j, i), trueNeighbors(j, i));
+        BOOST_REQUIRE_CLOSE(distances(j, i), trueDistances(j, i), 1e-5);
+      }
+    }
+
+    // Single-tree search finishes the first query points before the budget is
+    // spent.
+    BOOST_REQUIRE_GT(numTruncated, 0);
+    if (singleMode)
+      BOOST_REQUIRE_LT(numTruncated, neighbors.n_cols);
+
+    // Without a limit that matters, the search is exact.
+    knn.BaseCaseBudget() = 100000000;
+    if (mono)
+      knn.Search(3, neighbors, distances);
+    else
+      knn.Search(queryData, 3, neighbors, distances);
+
+    for (size_t i = 0; i < neighbors.n_cols; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(knn.Truncated()[i], false);
+      for (size_t j = 0; j < 3; ++j)
+      {
+        BOOST_REQUIRE_EQUAL(neighbors(j, i), trueNeighbors(j, i));
+        BOOST_REQUIRE_CLOSE(distances(j, i), trueDistances(j, i), 1e-5);
+      }
+    }
+  }
+}
+
+/**
+ * A time budget that is spent right away still gives every query point k
+ * candidates.
+ */
+BOOST_AUTO_TEST_CASE(TimeBudgetTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 2000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 500);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    AllkNN knn(referenceData, false, mode == 0);
+    knn.TimeBudget() = 1e-9;
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    knn.Search(queryData, 3, neighbors, distances);
+
+    size_t numTruncated = 0;
+    for (size_t i = 0; i < neighbors.n_cols; ++i)
+    {
+      if (knn.Truncated()[i])
+        ++numTruncated;
+      for (size_t j = 0; j < 3; ++j)
+        BOOST_REQUIRE_LT(neighbors(j, i), referenceData.n_cols);
+    }
+
+    BOOST_REQUIRE_GT(numTruncated, 0);
+  }
+}
+
+/**
+ * Make sure the k-nearest-neighbor graph holds exactly the pairs where one
+ * point is a k-nearest neighbor of the other, and that it is the same when
+ * built in parallel.
+ */
+BOOST_AUTO_TEST_CASE(KNNGraphTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 500);
+  const size_t k = 5;
+
+  AllkNN naive(dataset, true);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  naive.Search(k, neighbors, distances);
+
+  arma::mat expected(dataset.n_cols, dataset.n_cols);
+  expected.fill(-1.0);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    for (size_t j = 0; j < k; ++j)
+    {
+      expected(neighbors(j, i), i) = distances(j, i);
+      expected(i, neighbors(j, i)) = distances(j, i);
+    }
+  }
+
+  for (size_t p = 0; p < 2; ++p)
+  {
+    KNNGraph<> graph(dataset, k, (p == 1));
+
+    BOOST_REQUIRE_EQUAL(graph.NumPoints(), dataset.n_cols);
+    BOOST_REQUIRE_EQUAL(graph.K(), k);
+
+    size_t numEntries = 0;
+    for (size_t i = 0; i < dataset.n_cols; ++i)
+    {
+      BOOST_REQUIRE_CLOSE(graph.KthDistances()[i], distances(k - 1, i), 1e-5);
+
+      for (size_t e = graph.Offsets()[i]; e < graph.Offsets()[i + 1]; ++e)
+      {
+        const size_t j = graph.Neighbors()[e];
+        if (e > graph.Offsets()[i])
+          BOOST_REQUIRE_GT(j, graph.Neighbors()[e - 1]);
+
+        BOOST_REQUIRE_GE(expected(j, i), 0.0);
+        BOOST_REQUIRE_CLOSE(graph.Distances()[e], expected(j, i), 1e-5);
+      }
+
+      numEntries += graph.Offsets()[i + 1] - graph.Offsets()[i];
+    }
+
+    BOOST_REQUIRE_EQUAL(numEntries,
+        (size_t) arma::accu(expected >= 0.0));
+    BOOST_REQUIRE_EQUAL(2 * graph.NumEdges(), numEntries);
+  }
+}
+
+/**
+ * Make sure that MahalanobisNeighborSearch finds the same neighbors as a
+ * brute-force search with the Mahalanobis distance, with and without a query
+ * set and for both settings of TakeRoot.
+ */
+BOOST_AUTO_TEST_CASE(MahalanobisNeighborSearchTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(4, 200);
+  arma::mat querySet = arma::randu<arma::mat>(4, 50);
+  arma::mat r = arma::randu<arma::mat>(4, 4);
+  const arma::mat covariance = r * trans(r) + 0.1 * arma::eye<arma::mat>(4, 4);
+
+  MahalanobisDistance<> md(covariance);
+  MahalanobisDistance<false> squaredMD(covariance);
+  const size_t k = 5;
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    const bool monochromatic = (mode != 1);
+    const arma::mat& queries = monochromatic ? dataset : querySet;
+
+    arma::Mat<size_t> neighbors, squaredNeighbors;
+    arma::mat distances, squaredDistances;
+    MahalanobisNeighborSearch<> knn(dataset, md, false, (mode == 2));
+    MahalanobisNeighborSearch<NearestNeighborSort, BallTree> squaredKNN(
+        dataset, squaredMD);
+    if (monochromatic)
+    {
+      knn.Search(k, neighbors, distances);
+      squaredKNN.Search(k, squaredNeighbors, squaredDistances);
+    }
+    else
+    {
+      knn.Search(querySet, k, neighbors, distances);
+      squaredKNN.Search(querySet, k, squaredNeighbors, squaredDistances);
+    }
+
+    for (size_t i = 0; i < queries.n_cols; ++i)
+    {
+      std::vector<double> trueDistances;
+      for (size_t j = 0; j < dataset.n_cols; ++j)
+        if (!monochromatic || i != j)
+          trueDistances.push_back(md.Evaluate(queries.col(i),
+              dataset.col(j)));
+      std::sort(trueDistances.begin(), trueDistances.end());
+
+      for (size_t j = 0; j < k; ++j)
+      {
+        BOOST_REQUIRE_CLOSE(distances(j, i), trueDistances[j], 1e-5);
+        BOOST_REQUIRE_CLOSE(md.Evaluate(queries.col(i),
+            dataset.col(neighbors(j, i))), trueDistances[j], 1e-5);
+        BOOST_REQUIRE_CLOSE(squaredDistances(j, i),
+            trueDistances[j] * trueDistances[j], 1e-5);
+      }
+    }
+  }
+}
+
+/**
+ * Make sure that CosineNeighborSearch finds the same similarities as naive
+ * FastMKS with the cosine distance.
+ */
+BOOST_AUTO_TEST_CASE(CosineNeighborSearchTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(6, 300) - 0.5;
+  arma::mat querySet = arma::randn<arma::mat>(6, 50);
+  querySet.col(7).zeros();
+  const size_t k = 5;
+
+  fastmks::FastMKS<kernel::CosineDistance> fastmks(dataset, false, true);
+  arma::Mat<size_t> trueIndices, trueQueryIndices;
+  arma::mat trueSimilarities, trueQuerySimilarities;
+  fastmks.Search(k, trueIndices, trueSimilarities);
+  fastmks.Search(querySet, k, trueQueryIndices, trueQuerySimilarities);
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    CosineNeighborSearch<> search(dataset, (mode == 0), (mode == 1));
+    arma::Mat<size_t> indices, queryIndices;
+    arma::mat similarities, querySimilarities;
+    search.Search(k, indices, similarities);
+    search.Search(querySet, k, queryIndices, querySimilarities);
+
+    BOOST_REQUIRE_EQUAL(similarities.n_rows, k);
+    BOOST_REQUIRE_EQUAL(similarities.n_cols, dataset.n_cols);
+    for (size_t i = 0; i < similarities.n_elem; ++i)
+      BOOST_REQUIRE_SMALL(similarities[i] - trueSimilarities[i], 1e-8);
+
+    BOOST_REQUIRE_EQUAL(querySimilarities.n_cols, querySet.n_cols);
+    for (size_t i = 0; i < querySimilarities.n_elem; ++i)
+      BOOST_REQUIRE_SMALL(querySimilarities[i] - trueQuerySimilarities[i],
+          1e-8);
+  }
+
+  // A reference point with norm 0 has no direction.
+  dataset.col(10).zeros();
+  BOOST_REQUIRE_THROW(CosineNeighborSearch<> search(dataset),
+      std::invalid_argument);
+}
+
+/**
+ * Make sure that the candidate lists are sorted correctly when k is large
+ * enough that they are kept as heaps, for both nearest and furthest neighbor
+ * search, in dual-tree and single-tree mode.
+ */
+BOOST_AUTO_TEST_CASE(LargeKHeapTest)
+{
+  const size_t k = 2 * CandidateList<NearestNeighborSort>::HeapThreshold;
+  arma::mat referenceData = arma::randu<arma::mat>(3, 600);
+  arma::mat queryData = arma::randu<arma::mat>(3, 100);
+
+  AllkNN naiveKNN(referenceData, true);
+  arma::Mat<size_t> neighborsNaive;
+  arma::mat distancesNaive;
+  naiveKNN.Search(queryData, k, neighborsNaive, distancesNaive);
+
+  AllkFN naiveKFN(referenceData, true);
+  arma::Mat<size_t> furthestNaive;
+  arma::mat furthestDistancesNaive;
+  naiveKFN.Search(queryData, k, furthestNaive, furthestDistancesNaive);
+
+  for (size_t i = 0; i < distancesNaive.n_cols; ++i)
+  {
+    for (size_t j = 1; j < k; ++j)
+    {
+      BOOST_REQUIRE_LE(distancesNaive(j - 1, i), distancesNaive(j, i));
+      BOOST_REQUIRE_GE(furthestDistancesNaive(j - 1, i),
+          furthestDistancesNaive(j, i));
+    }
+  }
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    AllkNN knn(referenceData, false, (mode == 1));
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    knn.Search(queryData, k, neighbors, distances);
+
+    AllkFN kfn(referenceData, false, (mode == 1));
+    arma::Mat<size_t> furthest;
+    arma::mat furthestDistances;
+    kfn.Search(queryData, k, furthest, furthestDistances);
+
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], neighborsNaive[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], distancesNaive[i], 1e-5);
+      BOOST_REQUIRE_EQUAL(furthest[i], furthestNaive[i]);
+      BOOST_REQUIRE_CLOSE(furthestDistances[i], furthestDistancesNaive[i],
+          1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure that search over a partitioned reference set gives the same
+ * results as naive search, for nearest and furthest neighbors, and that not
+ * every query point is searched in every partition.
+ */
+BOOST_AUTO_TEST_CASE(PartitionedSearchTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 2000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 300);
+  const size_t k = 5;
+
+  std::vector<arma::Col<size_t> > indices;
+  PartitionedNeighborSearch<>::Partition(referenceData, 8, indices);
+  BOOST_REQUIRE_EQUAL(indices.size(), 8);
+  std::vector<bool> seen(referenceData.n_cols, false);
+  for (size_t p = 0; p < indices.size(); ++p)
+  {
+    for (size_t i = 0; i < indices[p].n_elem; ++i)
+    {
+      BOOST_REQUIRE(!seen[indices[p][i]]);
+      seen[indices[p][i]] = true;
+    }
+  }
+  for (size_t i = 0; i < seen.size(); ++i)
+    BOOST_REQUIRE(seen[i]);
+
+  AllkNN naiveKNN(referenceData, true);
+  arma::Mat<size_t> neighborsNaive;
+  arma::mat distancesNaive;
+  naiveKNN.Search(queryData, k, neighborsNaive, distancesNaive);
+
+  PartitionedNeighborSearch<> knn(referenceData, 8);
+  BOOST_REQUIRE_EQUAL(knn.Partitions(), 8);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  knn.Search(queryData, k, neighbors, distances);
+
+  BOOST_REQUIRE_GE(knn.RoutedQueries(), queryData.n_cols);
+  BOOST_REQUIRE_LT(knn.RoutedQueries(), 8 * queryData.n_cols);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], neighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], distancesNaive[i], 1e-5);
+  }
+
+  AllkFN naiveKFN(referenceData, true);
+  naiveKFN.Search(queryData, k, neighborsNaive, distancesNaive);
+
+  PartitionedNeighborSearch<FurthestNeighborSort> kfn(referenceData, 8);
+  kfn.Search(queryData, k, neighbors, distances);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], neighborsNaive[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], distancesNaive[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that partitions built and searched in parallel, each by threads of
+ * its own place, give the same results as naive search, and that parallel mode
+ * can be turned off afterwards.
+ */
+BOOST_AUTO_TEST_CASE(ParallelPartitionedSearchTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 2000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 300);
+  const size_t k = 5;
+
+  AllkNN naive(referenceData, true);
+  arma::Mat<size_t> neighborsNaive;
+  arma::mat distancesNaive;
+  naive.Search(queryData, k, neighborsNaive, distancesNaive);
+
+  PartitionedNeighborSearch<> knn(referenceData, 4, true);
+  BOOST_REQUIRE(knn.Parallel());
+  BOOST_REQUIRE_EQUAL(knn.Partitions(), 4);
+
+  for (size_t run = 0; run < 2; ++run)
+  {
+    knn.Parallel() = (run == 0);
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    knn.Search(queryData, k, neighbors, distances);
+
+    BOOST_REQUIRE_GE(knn.RoutedQueries(), queryData.n_cols);
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], neighborsNaive[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], distancesNaive[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure that extending earlier results with a warm start gives the same
+ * results as a new search, for a larger k (in both candidate list modes) and
+ * for a smaller k, which needs no base cases at all.  This also checks that a
+ * query tree can be searched several times.
+ */
+BOOST_AUTO_TEST_CASE(WarmStartSearchTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 800);
+  arma::mat queryData = arma::randu<arma::mat>(3, 150);
+
+  AllkNN knn(referenceData);
+  AllkNN::Tree queryTree(queryData);
+
+  const size_t k = CandidateList<NearestNeighborSort>::HeapThreshold + 16;
+  arma::Mat<size_t> baselineNeighbors, baselineSmallNeighbors;
+  arma::mat baselineDistances, baselineSmallDistances;
+  knn.Search(&queryTree, k, baselineNeighbors, baselineDistances);
+  knn.Search(&queryTree, 3, baselineSmallNeighbors, baselineSmallDistances);
+
+  // The query tree is reused by those searches, so compare with a fresh one.
+  AllkNN::Tree freshQueryTree(queryData);
+  arma::Mat<size_t> freshNeighbors;
+  arma::mat freshDistances;
+  knn.Search(&freshQueryTree, k, freshNeighbors, freshDistances);
+  for (size_t i = 0; i < baselineNeighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(baselineNeighbors[i], freshNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(baselineDistances[i], freshDistances[i], 1e-5);
+  }
+
+  const size_t firstK[2] = { 3, 10 };
+  const size_t secondK[2] = { 10, k };
+  for (size_t t = 0; t < 2; ++t)
+  {
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    knn.Search(&queryTree, firstK[t], neighbors, distances);
+    knn.Search(&queryTree, secondK[t], neighbors, distances, true);
+
+    BOOST_REQUIRE_EQUAL(neighbors.n_rows, secondK[t]);
+    BOOST_REQUIRE_EQUAL(neighbors.n_cols, queryData.n_cols);
+    for (size_t i = 0; i < neighbors.n_cols; ++i)
+    {
+      for (size_t j = 0; j < secondK[t]; ++j)
+      {
+        BOOST_REQUIRE_EQUAL(neighbors(j, i), baselineNeighbors(j, i));
+        BOOST_REQUIRE_CLOSE(distances(j, i), baselineDistances(j, i), 1e-5);
+      }
+    }
+  }
+
+  // Truncating the results needs no search.
+  arma::Mat<size_t> neighbors(baselineNeighbors);
+  arma::mat distances(baselineDistances);
+  knn.Search(&queryTree, 3, neighbors, distances, true);
+  BOOST_REQUIRE_EQUAL(knn.BaseCases(), 0);
+  BOOST_REQUIRE_EQUAL(neighbors.n_rows, 3);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], baselineSmallNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], baselineSmallDistances[i], 1e-5);
+  }
+
+  // Earlier results of the wrong size are rejected.
+  arma::Mat<size_t> wrongNeighbors(3, 10);
+  arma::mat wrongDistances(3, 10);
+  BOOST_REQUIRE_THROW(knn.Search(&queryTree, 5, wrongNeighbors,
+      wrongDistances, true), std::invalid_argument);
+}
+
+/**
+ * Make sure that an NSModel that caches its query tree gives the same results
+ * as a new search when the same query set is searched again with a larger or
+ * smaller k, and when a different query set is searched.
+ */
+BOOST_AUTO_TEST_CASE(KNNModelCachedQueryTreeTest)
+{
+  typedef NSModel<NearestNeighborSort> KNNModel;
+
+  arma::mat referenceData = arma::randu<arma::mat>(4, 600);
+  arma::mat queryData = arma::randu<arma::mat>(4, 100);
+  arma::mat otherQueryData = arma::randu<arma::mat>(4, 100);
+
+  AllkNN knn(referenceData);
+
+  const int treeTypes[3] = { KNNModel::TreeTypes::KD_TREE,
+      KNNModel::TreeTypes::BALL_TREE, KNNModel::TreeTypes::VP_TREE };
+  for (size_t t = 0; t < 3; ++t)
+  {
+    KNNModel model(treeTypes[t], false);
+    arma::mat referenceCopy(referenceData);
+    model.BuildModel(std::move(referenceCopy), 20, false, false);
+    model.CacheQueryTree() = true;
+
+    const size_t ks[4] = { 2, 7, 4, 5 };
+    for (size_t s = 0; s < 4; ++s)
+    {
+      arma::mat querySet((s == 3) ? otherQueryData : queryData);
+
+      arma::Mat<size_t> baselineNeighbors;
+      arma::mat baselineDistances;
+      knn.Search(querySet, ks[s], baselineNeighbors, baselineDistances);
+
+      arma::Mat<size_t> neighbors;
+      arma::mat distances;
+      model.Search(std::move(querySet), ks[s], neighbors, distances);
+
+      BOOST_REQUIRE_EQUAL(neighbors.n_rows, ks[s]);
+      BOOST_REQUIRE_EQUAL(neighbors.n_cols, baselineNeighbors.n_cols);
+      for (size_t i = 0; i < neighbors.n_elem; ++i)
+      {
+        BOOST_REQUIRE_EQUAL(neighbors[i], baselineNeighbors[i]);
+        BOOST_REQUIRE_CLOSE(distances[i], baselineDistances[i], 1e-5);
+      }
+    }
+  }
+}
+
+/**
+ * Make sure that the cached results of an approximate search are not reused
+ * when the same query set is searched again exactly.
+ */
+BOOST_AUTO_TEST_CASE(KNNModelCachedQueryTreeEpsilonTest)
+{
+  typedef NSModel<NearestNeighborSort> KNNModel;
+
+  arma::mat referenceData = arma::randu<arma::mat>(4, 600);
+  arma::mat queryData = arma::randu<arma::mat>(4, 100);
+
+  AllkNN knn(referenceData);
+  arma::Mat<size_t> baselineNeighbors;
+  arma::mat baselineDistances;
+  knn.Search(queryData, 5, baselineNeighbors, baselineDistances);
+
+  KNNModel model(KNNModel::TreeTypes::KD_TREE, false);
+  arma::mat referenceCopy(referenceData);
+  model.BuildModel(std::move(referenceCopy), 20, false, false);
+  model.CacheQueryTree() = true;
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  model.Epsilon() = 0.5;
+  arma::mat querySet(queryData);
+  model.Search(std::move(querySet), 5, neighbors, distances);
+
+  model.Epsilon() = 0.0;
+  querySet = queryData;
+  model.Search(std::move(querySet), 5, neighbors, distances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], baselineNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], baselineDistances[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that NSModel::SelectTree() chooses an exact tree type and one of
+ * the candidate leaf sizes, that the resulting model gives exact results, and
+ * that the choice is saved with the model.
+ */
+BOOST_AUTO_TEST_CASE(KNNModelSelectTreeTest)
+{
+  typedef NSModel<NearestNeighborSort> KNNModel;
+
+  arma::mat referenceData = arma::randu<arma::mat>(3, 1500);
+  arma::mat queryData = arma::randu<arma::mat>(3, 300);
+
+  AllkNN naive(referenceData, true);
+  arma::Mat<size_t> naiveNeighbors;
+  arma::mat naiveDistances;
+  naive.Search(queryData, 5, naiveNeighbors, naiveDistances);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    KNNModel model;
+    model.SelectTree(referenceData, (mode == 0) ? &queryData : NULL, 5,
+        false, 400);
+
+    BOOST_REQUIRE_NE(model.TreeType(), KNNModel::TreeTypes::SPILL_TREE);
+    if (model.TreeType() != KNNModel::TreeTypes::COVER_TREE)
+    {
+      BOOST_REQUIRE(model.LeafSize() == 5 || model.LeafSize() == 10 ||
+          model.LeafSize() == 20 || model.LeafSize() == 40 ||
+          model.LeafSize() == 80);
+    }
+
+    arma::mat referenceCopy(referenceData);
+    model.BuildModel(std::move(referenceCopy), model.LeafSize(), false,
+        false);
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    arma::mat queryCopy(queryData);
+    model.Search(std::move(queryCopy), 5, neighbors, distances);
+    for (size_t i = 0; i < neighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors[i], naiveNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(distances[i], naiveDistances[i], 1e-5);
+    }
+
+    data::Save("test-knn-select-tree.xml", "knn_model", model);
+    KNNModel loadedModel;
+    data::Load("test-knn-select-tree.xml", "knn_model", loadedModel);
+    remove("test-knn-select-tree.xml");
+
+    BOOST_REQUIRE_EQUAL(loadedModel.TreeType(), model.TreeType());
+    BOOST_REQUIRE_EQUAL(loadedModel.LeafSize(), model.LeafSize());
+  }
+
+  // There must be something to sample.
+  KNNModel model;
+  arma::mat tiny = arma::randu<arma::mat>(3, 1);
+  BOOST_REQUIRE_THROW(model.SelectTree(tiny, NULL, 1, false),
+      std::invalid_argument);
+  BOOST_REQUIRE_THROW(model.SelectTree(referenceData, NULL, 0, false),
+      std::invalid_argument);
+}
+
+/**
+ * Make sure that the blocked naive search (which computes the distances of
+ * each block of query and reference points with one matrix multiplication)
+ * gives the exact neighbors when the sets span several blocks.
+ */
+BOOST_AUTO_TEST_CASE(NaiveBlockSearchTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(40, 2500) + 20.0;
+  arma::mat queryData = arma::randu<arma::mat>(40, 1300) + 20.0;
+  const size_t k = 5;
+
+  AllkNN naive(referenceData, true);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+
+  // Check the bichromatic search, and then the monochromatic search.
+  for (size_t mono = 0; mono < 2; ++mono)
+  {
+    const arma::mat& querySet = (mono == 1) ? referenceData : queryData;
+    if (mono == 1)
+      naive.Search(k, neighbors, distances);
+    else
+      naive.Search(querySet, k, neighbors, distances);
+
+    BOOST_REQUIRE_EQUAL(neighbors.n_cols, querySet.n_cols);
+    for (size_t i = 0; i < querySet.n_cols; ++i)
+    {
+      arma::vec exact(referenceData.n_cols);
+      for (size_t j = 0; j < referenceData.n_cols; ++j)
+        exact[j] = metric::EuclideanDistance::Evaluate(querySet.col(i),
+            referenceData.col(j));
+      if (mono == 1)
+        exact[i] = DBL_MAX;
+
+      const arma::uvec order = arma::sort_index(exact);
+      for (size_t j = 0; j < k; ++j)
+      {
+        BOOST_REQUIRE_EQUAL(neighbors(j, i), order[j]);
+        BOOST_REQUIRE_CLOSE(distances(j, i), exact[order[j]], 1e-10);
+      }
+    }
+  }
+}
+
+/**
+ * Single-tree search with the query points in a spatial order gives the same
+ * results as single-tree search in the order of the columns, serially and in
+ * parallel.
+ */
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void CheckReorderedQueries(const arma::mat& referenceData,
+                           const arma::mat& queryData)
+{
+  typedef NeighborSearch<NearestNeighborSort, EuclideanDistance, arma::mat,
+      TreeType> KNNType;
+
+  KNNType ordered(referenceData, false, true);
+  KNNType reordered(referenceData, false, true);
+  reordered.ReorderQueries() = true;
+
+  for (size_t run = 0; run < 4; ++run)
+  {
+    reordered.Parallel() = (run >= 2);
+
+    arma::Mat<size_t> orderedNeighbors, reorderedNeighbors;
+    arma::mat orderedDistances, reorderedDistances;
+    if (run % 2 == 0)
+    {
+      ordered.Search(queryData, 3, orderedNeighbors, orderedDistances);
+      reordered.Search(queryData, 3, reorderedNeighbors, reorderedDistances);
+    }
+    else
+    {
+      ordered.Search(3, orderedNeighbors, orderedDistances);
+      reordered.Search(3, reorderedNeighbors, reorderedDistances);
+    }
+
+    BOOST_REQUIRE_EQUAL(reorderedNeighbors.n_cols, orderedNeighbors.n_cols);
+    for (size_t i = 0; i < orderedNeighbors.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(reorderedNeighbors[i], orderedNeighbors[i]);
+      BOOST_REQUIRE_CLOSE(reorderedDistances[i], orderedDistances[i], 1e-5);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ReorderQueriesTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(4, 1500);
+  arma::mat queryData = arma::randu<arma::mat>(4, 700);
+
+  CheckReorderedQueries<KDTree>(referenceData, queryData);
+  CheckReorderedQueries<StandardCoverTree>(referenceData, queryData);
+  CheckReorderedQueries<RTree>(referenceData, queryData);
+}
+
+/**
+ * Make sure that scoring all the children of a node at once with
+ * ScoreChildren() gives the same scores as scoring each child with Score().
+ */
+BOOST_AUTO_TEST_CASE(BatchedScoreChildrenTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 500);
+  typedef KDTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+  TreeType tree(dataset);
+  EuclideanDistance metric;
+
+  typedef NeighborSearchRules<NearestNeighborSort, EuclideanDistance,
+      TreeType> RuleType;
+  arma::Mat<size_t> neighbors(3, dataset.n_cols);
+  neighbors.fill(size_t() - 1);
+  arma::mat distances(3, dataset.n_cols);
+  distances.fill(DBL_MAX);
+  RuleType rules(tree.Dataset(), tree.Dataset(), neighbors, distances, metric,
+      true);
+
+  // Give some query points a finite k'th distance, so that some children are
+  // pruned.
+  for (size_t i = 0; i < 50; ++i)
+    for (size_t j = 0; j < dataset.n_cols; j += 7)
+      rules.BaseCase(i, j);
+
+  std::vector<TreeType*> stack(1, &tree);
+  size_t internalNodes = 0;
+  while (!stack.empty())
+  {
+    TreeType* node = stack.back();
+    stack.pop_back();
+    if (node->IsLeaf())
+      continue;
+
+    ++internalNodes;
+    for (size_t q = 0; q < 100; q += 3)
+    {
+      double childScores[2];
+      const size_t scores = rules.Scores();
+      rules.ScoreChildren(q, *node, childScores);
+      BOOST_REQUIRE_EQUAL(rules.Scores(), scores + 2);
+
+      BOOST_REQUIRE_EQUAL(childScores[0], rules.Score(q, *node->Left()));
+      BOOST_REQUIRE_EQUAL(childScores[1], rules.Score(q, *node->Right()));
+    }
+
+    stack.push_back(node->Left());
+    stack.push_back(node->Right());
+  }
+
+  BOOST_REQUIRE_GT(internalNodes, 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -393,6 +393,67 @@ BOOST_AUTO_TEST_CASE(DualCoverTreeTest)
   BOOST_REQUIRE_LT(numQueriesFail, maxNumQueriesFail);
 }
 
+// Test single-tree rank-approximate search with vantage-point trees.
+BOOST_AUTO_TEST_CASE(SingleVPTreeTest)
+{
+  arma::mat refData;
+  arma::mat queryData;
+
+  data::Load("rann_test_r_3_900.csv", refData, true);
+  data::Load("rann_test_q_3_100.csv", queryData, true);
+
+  // Search for 1 rank-approximate nearest-neighbors in the top 30% of the point
+  // (rank error of 3).
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+
+  typedef RASearch<NearestNeighborSort, EuclideanDistance, arma::mat,
+      VPTree> RAVPTreeSearch;
+
+  RAVPTreeSearch tssRann(refData, false, true, 1.0, 0.95, false, false, 5);
+
+  // The relative ranks for the given query reference pair.
+  arma::Mat<size_t> qrRanks;
+  data::Load("rann_test_qr_ranks.csv", qrRanks, true, false); // No transpose.
+
+  size_t numRounds = 1000;
+  arma::Col<size_t> numSuccessRounds(queryData.n_cols);
+  numSuccessRounds.fill(0);
+
+  // 1% of 900 is 9, so the rank is expected to be less than 10.
+  size_t expectedRankErrorUB = 10;
+
+  for (size_t rounds = 0; rounds < numRounds; rounds++)
+  {
+    tssRann.Search(queryData, 1, neighbors, distances);
+
+    for (size_t i = 0; i < queryData.n_cols; i++)
+      if (qrRanks(i, neighbors(0, i)) < expectedRankErrorUB)
+        numSuccessRounds[i]++;
+
+    neighbors.reset();
+    distances.reset();
+  }
+
+  // Find the 95%-tile threshold so that 95% of the queries should pass this
+  // threshold.
+  size_t threshold = floor(numRounds *
+      (0.95 - (1.96 * sqrt(0.95 * 0.05 / numRounds))));
+  size_t numQueriesFail = 0;
+  for (size_t i = 0; i < queryData.n_cols; i++)
+    if (numSuccessRounds[i] < threshold)
+      numQueriesFail++;
+
+  Log::Warn << "RANN-TSS (vantage-point tree): RANN guarantee fails on "
+      << numQueriesFail << " queries." << endl;
+
+  // Assert that at most 5% of the queries fall out of this threshold.
+  // 5% of 100 queries is 5.
+  size_t maxNumQueriesFail = 6;
+
+  BOOST_REQUIRE_LT(numQueriesFail, maxNumQueriesFail);
+}
+
 // Test single-tree rank-approximate search with ball trees.
 // This is known to not work right now.
 /*
@@ -553,4 +614,91 @@ BOOST_AUTO_TEST_CASE(NeighborPtrDeleteTest)
   BOOST_REQUIRE_EQUAL(distances.n_rows, 3);
 }
 
+/**
+ * Make sure that parallel rank-approximate search gives the same results every
+ * time it is run with the same random seed, in both single-tree and dual-tree
+ * mode, and that it returns valid neighbors.
+ */
+BOOST_AUTO_TEST_CASE(ParallelSearchTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 1000);
+  arma::mat queryset = arma::randu<arma::mat>(3, 300);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    const bool singleMode = (mode == 0);
+
+    arma::Mat<size_t> neighbors[2], monoNeighbors[2];
+    arma::mat distances[2], monoDistances[2];
+    for (size_t run = 0; run < 2; ++run)
+    {
+      RASearch<> allkrann(dataset, false, singleMode);
+      allkrann.Parallel() = true;
+
+      math::RandomSeed(10);
+      allkrann.Search(queryset, 3, neighbors[run], distances[run]);
+      allkrann.Search(3, monoNeighbors[run], monoDistances[run]);
+    }
+
+    BOOST_REQUIRE_EQUAL(neighbors[0].n_rows, 3);
+    BOOST_REQUIRE_EQUAL(neighbors[0].n_cols, 300);
+    BOOST_REQUIRE_EQUAL(monoNeighbors[0].n_rows, 3);
+    BOOST_REQUIRE_EQUAL(monoNeighbors[0].n_cols, 1000);
+
+    for (size_t i = 0; i < neighbors[0].n_elem; ++i)
+    {
+      BOOST_REQUIRE_LT(neighbors[0][i], dataset.n_cols);
+      BOOST_REQUIRE_EQUAL(neighbors[0][i], neighbors[1][i]);
+      BOOST_REQUIRE_CLOSE(distances[0][i], distances[1][i], 1e-5);
+    }
+
+    for (size_t i = 0; i < monoNeighbors[0].n_elem; ++i)
+    {
+      BOOST_REQUIRE_LT(monoNeighbors[0][i], dataset.n_cols);
+      BOOST_REQUIRE_NE(monoNeighbors[0][i], i / 3);
+      BOOST_REQUIRE_EQUAL(monoNeighbors[0][i], monoNeighbors[1][i]);
+      BOOST_REQUIRE_CLOSE(monoDistances[0][i], monoDistances[1][i], 1e-5);
+    }
+  }
+}
+
+/**
+ * With a base case budget, rank-approximate search marks some query points as
+ * truncated, and every query point still gets k valid candidates.
+ */
+BOOST_AUTO_TEST_CASE(BaseCaseBudgetTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 2000);
+  arma::mat queryset = arma::randu<arma::mat>(3, 500);
+
+  for (size_t mode = 0; mode < 2; ++mode)
+  {
+    RASearch<> allkrann(dataset, false, mode == 0);
+    allkrann.BaseCaseBudget() = 2000;
+
+    arma::Mat<size_t> neighbors;
+    arma::mat distances;
+    allkrann.Search(queryset, 3, neighbors, distances);
+
+    BOOST_REQUIRE_EQUAL(allkrann.Truncated().size(), queryset.n_cols);
+
+    size_t numTruncated = 0;
+    for (size_t i = 0; i < neighbors.n_cols; ++i)
+    {
+      if (allkrann.Truncated()[i])
+        ++numTruncated;
+      for (size_t j = 0; j < 3; ++j)
+        BOOST_REQUIRE_LT(neighbors(j, i), dataset.n_cols);
+    }
+
+    BOOST_REQUIRE_GT(numTruncated, 0);
+
+    // Without a budget, nothing is truncated.
+    allkrann.BaseCaseBudget() = 0;
+    allkrann.Search(queryset, 3, neighbors, distances);
+    for (size_t i = 0; i < queryset.n_cols; ++i)
+      BOOST_REQUIRE_EQUAL(allkrann.Truncated()[i], false);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -260,4 +260,30 @@ BOOST_AUTO_TEST_CASE(SpRowColIteratorTest)
 
 #endif
 
+/**
+ * Make sure that reorder_cols() moves whole columns of a sparse matrix and
+ * leaves the other columns alone.
+ */
+BOOST_AUTO_TEST_CASE(SpMatReorderColsTest)
+{
+  sp_mat X;
+  X.sprandu(20, 30, 0.3);
+  const mat original(X);
+
+  Col<uword> order(10);
+  for (size_t i = 0; i < 10; ++i)
+    order[i] = (7 * i + 3) % 10;
+
+  X.reorder_cols(5, order);
+
+  BOOST_REQUIRE_EQUAL(X.n_nonzero, accu(original != 0));
+  const mat reordered(X);
+  for (size_t c = 0; c < 30; ++c)
+  {
+    const size_t old = (c >= 5 && c < 15) ? 5 + order[c - 5] : c;
+    for (size_t r = 0; r < 20; ++r)
+      BOOST_REQUIRE_EQUAL(reordered(r, c), original(r, old));
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,152 @@
+/**
+ * @file batch_predict_test.cpp
+ * @author Ryan Curtin
+ *
+ * Tests for BatchPredict() and BatchClassify().
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/batch_predict.hpp>
+#include <mlpack/methods/gmm/gmm.hpp>
+#include <mlpack/methods/linear_regression/linear_regression.hpp>
+#include <mlpack/methods/logistic_regression/logistic_regression.hpp>
+#include <mlpack/methods/naive_bayes/naive_bayes_classifier.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::gmm;
+using namespace mlpack::naive_bayes;
+using namespace mlpack::regression;
+
+BOOST_AUTO_TEST_SUITE(BatchPredictTest);
+
+/**
+ * Batch predictions of linear regression should be the same as those of
+ * Predict(), for dense double, dense float, and sparse points, and for block
+ * sizes that do not divide the number of points.
+ */
+BOOST_AUTO_TEST_CASE(BatchPredictLinearRegressionTest)
+{
+  arma::mat predictors = arma::randu<arma::mat>(4, 200);
+  arma::vec responses = arma::trans(predictors) * arma::randu<arma::vec>(4) +
+      1.0;
+  LinearRegression lr(predictors, responses);
+
+  arma::sp_mat sparsePoints = arma::sprandu<arma::sp_mat>(4, 1001, 0.3);
+  arma::mat points(sparsePoints);
+  arma::vec expected;
+  lr.Predict(points, expected);
+
+  const size_t blockSizes[] = { 1, 7, 1000, 5000 };
+  for (size_t b = 0; b < 4; ++b)
+  {
+    arma::vec predictions;
+    BatchPredict(lr, points, predictions, blockSizes[b]);
+    BOOST_REQUIRE_EQUAL(predictions.n_elem, points.n_cols);
+    for (size_t i = 0; i < predictions.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(predictions[i], expected[i], 1e-5);
+
+    BatchPredict(lr, sparsePoints, predictions, blockSizes[b]);
+    BOOST_REQUIRE_EQUAL(predictions.n_elem, points.n_cols);
+    for (size_t i = 0; i < predictions.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(predictions[i], expected[i], 1e-5);
+
+    const arma::fmat floatPoints = arma::conv_to<arma::fmat>::from(points);
+    BatchPredict(lr, floatPoints, predictions, blockSizes[b]);
+    BOOST_REQUIRE_EQUAL(predictions.n_elem, points.n_cols);
+    for (size_t i = 0; i < predictions.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(predictions[i], expected[i], 1e-3);
+  }
+}
+
+/**
+ * Batch predictions should be written into the given vector when it already
+ * has the right size, without allocating a new one.
+ */
+BOOST_AUTO_TEST_CASE(BatchPredictPreallocatedTest)
+{
+  arma::mat predictors = arma::randu<arma::mat>(3, 100);
+  arma::vec responses = arma::randu<arma::vec>(100);
+  LinearRegression lr(predictors, responses);
+
+  arma::vec predictions(100);
+  const double* memory = predictions.memptr();
+  BatchPredict(lr, predictors, predictions, 16);
+  BOOST_REQUIRE_EQUAL(predictions.memptr(), memory);
+
+  arma::vec expected;
+  lr.Predict(predictors, expected);
+  for (size_t i = 0; i < 100; ++i)
+    BOOST_REQUIRE_CLOSE(predictions[i], expected[i], 1e-5);
+
+  BOOST_REQUIRE_THROW(BatchPredict(lr, predictors, predictions, 0),
+      std::invalid_argument);
+}
+
+/**
+ * Batch labels of logistic regression (with BatchPredict() and with a custom
+ * decision boundary through BatchApply()) should be the same as those of
+ * Predict().
+ */
+BOOST_AUTO_TEST_CASE(BatchPredictLogisticRegressionTest)
+{
+  arma::mat data(2, 500);
+  arma::Row<size_t> labels(500);
+  for (size_t i = 0; i < 500; ++i)
+  {
+    labels[i] = i % 2;
+    data.col(i) = arma::randu<arma::vec>(2) + 0.5 * labels[i];
+  }
+  LogisticRegression<> lr(data, labels);
+
+  arma::Row<size_t> expected, predictions;
+  lr.Predict(data, expected);
+  BatchPredict(lr, data, predictions, 33);
+  BOOST_REQUIRE_EQUAL(predictions.n_elem, 500);
+  for (size_t i = 0; i < 500; ++i)
+    BOOST_REQUIRE_EQUAL(predictions[i], expected[i]);
+
+  lr.Predict(data, expected, 0.8);
+  BatchApply(data, predictions, [&](const arma::mat& block,
+                                    arma::Row<size_t>& output)
+  {
+    lr.Predict(block, output, 0.8);
+  }, 33);
+  for (size_t i = 0; i < 500; ++i)
+    BOOST_REQUIRE_EQUAL(predictions[i], expected[i]);
+}
+
+/**
+ * Batch labels of the naive Bayes classifier and of a GMM should be the same
+ * as those of Classify().
+ */
+BOOST_AUTO_TEST_CASE(BatchClassifyTest)
+{
+  arma::mat data(3, 600);
+  arma::Row<size_t> labels(600);
+  for (size_t i = 0; i < 600; ++i)
+  {
+    labels[i] = i % 3;
+    data.col(i) = arma::randn<arma::vec>(3) + 3.0 * labels[i];
+  }
+
+  NaiveBayesClassifier<> nbc(data, labels, 3);
+  arma::Row<size_t> nbcExpected, nbcLabels;
+  nbc.Classify(data, nbcExpected);
+  BatchClassify(nbc, data, nbcLabels, 50);
+  BOOST_REQUIRE_EQUAL(nbcLabels.n_elem, 600);
+  for (size_t i = 0; i < 600; ++i)
+    BOOST_REQUIRE_EQUAL(nbcLabels[i], nbcExpected[i]);
+
+  GMM<> gmm(3, 3);
+  gmm.Estimate(data, 1);
+  arma::Col<size_t> gmmExpected, gmmLabels;
+  gmm.Classify(data, gmmExpected);
+  BatchClassify(gmm, data, gmmLabels, 50);
+  BOOST_REQUIRE_EQUAL(gmmLabels.n_elem, 600);
+  for (size_t i = 0; i < 600; ++i)
+    BOOST_REQUIRE_EQUAL(gmmLabels[i], gmmExpected[i]);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -318,4 +318,157 @@ BOOST_AUTO_TEST_CASE(CFBatchPredictTest)
   }
 }
 
+/**
+ * Make sure that the recommendations generated for all users (in blocks) are
+ * un-rated items, in order of decreasing predicted rating.
+ */
+BOOST_AUTO_TEST_CASE(CFBlockedRecommendationsTest)
+{
+  arma::mat dataset;
+  data::Load("GroupLens100k.csv", dataset);
+
+  arma::sp_mat cleanedData;
+  CF<>::CleanData(dataset, cleanedData);
+  CF<> c(cleanedData);
+
+  // There are more users than in one block.
+  arma::Mat<size_t> recommendations;
+  c.GetRecommendations(10, recommendations);
+  BOOST_REQUIRE_EQUAL(recommendations.n_rows, 10);
+  BOOST_REQUIRE_EQUAL(recommendations.n_cols, cleanedData.n_cols);
+
+  for (size_t user = 0; user < cleanedData.n_cols; user += 97)
+  {
+    double lastPrediction = DBL_MAX;
+    for (size_t k = 0; k < 10; ++k)
+    {
+      const size_t item = recommendations(k, user);
+      BOOST_REQUIRE_LT(item, cleanedData.n_rows);
+      BOOST_REQUIRE_EQUAL((double) c.CleanedData()(item, user), 0.0);
+
+      const double prediction = c.Predict(user, item);
+      BOOST_REQUIRE_LE(prediction, lastPrediction + 1e-10);
+      lastPrediction = prediction;
+    }
+  }
+}
+
+/**
+ * Make sure that searching the FastMKS index gives the same recommendations as
+ * scoring every item, and that the LSH index gives valid recommendations.
+ */
+BOOST_AUTO_TEST_CASE(CFIndexedRecommendationsTest)
+{
+  arma::mat dataset;
+  data::Load("GroupLens100k.csv", dataset);
+
+  arma::sp_mat cleanedData;
+  CF<>::CleanData(dataset, cleanedData);
+  CF<> c(cleanedData);
+
+  arma::Col<size_t> users(50);
+  for (size_t i = 0; i < users.n_elem; ++i)
+    users[i] = 7 * i;
+
+  arma::Mat<size_t> recommendations, mksRecommendations, lshRecommendations;
+  c.GetRecommendations(10, recommendations, users);
+
+  c.SearchType() = FASTMKS_SEARCH;
+  c.GetRecommendations(10, mksRecommendations, users);
+
+  c.SearchType() = LSH_SEARCH;
+  c.GetRecommendations(10, lshRecommendations, users);
+
+  BOOST_REQUIRE_EQUAL(mksRecommendations.n_rows, 10);
+  BOOST_REQUIRE_EQUAL(mksRecommendations.n_cols, users.n_elem);
+  BOOST_REQUIRE_EQUAL(lshRecommendations.n_rows, 10);
+  BOOST_REQUIRE_EQUAL(lshRecommendations.n_cols, users.n_elem);
+
+  for (size_t i = 0; i < users.n_elem; ++i)
+  {
+    for (size_t k = 0; k < 10; ++k)
+    {
+      BOOST_REQUIRE_EQUAL(mksRecommendations(k, i), recommendations(k, i));
+
+      // The LSH search is approximate, so only make sure any item it found is
+      // un-rated.
+      const size_t item = lshRecommendations(k, i);
+      BOOST_REQUIRE_LE(item, cleanedData.n_rows);
+      if (item < cleanedData.n_rows)
+        BOOST_REQUIRE_EQUAL((double) c.CleanedData()(item, users[i]), 0.0);
+    }
+  }
+}
+
+/**
+ * Make sure that users folded into a model get H columns which solve their
+ * regularized least squares problems, and that the model can be used for them
+ * afterwards.
+ */
+BOOST_AUTO_TEST_CASE(CFAddUsersTest)
+{
+  arma::mat dataset;
+  data::Load("GroupLens100k.csv", dataset);
+
+  arma::sp_mat cleanedData;
+  CF<>::CleanData(dataset, cleanedData);
+
+  // Hold back the last 10 users, and fold them in afterwards.
+  const size_t users = cleanedData.n_cols;
+  const arma::sp_mat trainData = cleanedData.cols(0, users - 11);
+  const arma::sp_mat newUsers = cleanedData.cols(users - 10, users - 1);
+  CF<> c(trainData);
+  c.AddUsers(newUsers, 0.01);
+
+  BOOST_REQUIRE_EQUAL(c.H().n_cols, users);
+  BOOST_REQUIRE_EQUAL(c.CleanedData().n_cols, users);
+  BOOST_REQUIRE_EQUAL(c.CleanedData().n_nonzero, cleanedData.n_nonzero);
+
+  // Check the normal equations of each new user.
+  const arma::mat& w = c.W();
+  const size_t r = w.n_cols;
+  for (size_t u = 0; u < 10; ++u)
+  {
+    arma::mat a = arma::zeros<arma::mat>(r, r);
+    arma::vec b = arma::zeros<arma::vec>(r);
+    size_t count = 0;
+    for (size_t i = 0; i < newUsers.n_rows; ++i)
+    {
+      const double rating = newUsers(i, u);
+      if (rating == 0.0)
+        continue;
+
+      a += trans(w.row(i)) * w.row(i);
+      b += rating * trans(w.row(i));
+      ++count;
+    }
+    a += (0.01 * count) * arma::eye<arma::mat>(r, r);
+
+    const arma::vec residual = a * c.H().col(users - 10 + u) - b;
+    BOOST_REQUIRE_SMALL(arma::norm(residual, 2) / arma::norm(b, 2), 1e-8);
+  }
+
+  // Refresh the items the new users rated, and get recommendations for them.
+  const arma::mat denseNewUsers(newUsers);
+  std::vector<size_t> items;
+  for (size_t i = 0; i < denseNewUsers.n_rows; ++i)
+    if (arma::any(denseNewUsers.row(i) != 0.0))
+      items.push_back(i);
+  c.UpdateItems(arma::Col<size_t>(items));
+
+  arma::Col<size_t> queries = arma::linspace<arma::Col<size_t> >(users - 10,
+      users - 1, 10);
+  arma::Mat<size_t> recommendations;
+  c.GetRecommendations(5, recommendations, queries);
+  for (size_t u = 0; u < 10; ++u)
+  {
+    for (size_t k = 0; k < 5; ++k)
+    {
+      const size_t item = recommendations(k, u);
+      BOOST_REQUIRE_LT(item, cleanedData.n_rows);
+      BOOST_REQUIRE_EQUAL((double) cleanedData(item, users - 10 + u), 0.0);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
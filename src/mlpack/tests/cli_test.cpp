@@ -221,6 +221,92 @@ BOOST_AUTO_TEST_CASE(TestPrefixedOutStreamModifiers)
       "I have a precise number which is 000156");
 }
 
+//! Count the number of times the argument of a log statement is evaluated.
+static size_t LogArgument(size_t& evaluations)
+{
+  return ++evaluations;
+}
+
+/**
+ * Test that muted streams print nothing, and that the lazy log macros don't
+ * evaluate their arguments when the stream is muted.
+ */
+BOOST_AUTO_TEST_CASE(TestLazyLogging)
+{
+  std::stringstream ss;
+  PrefixedOutStream pss(ss, BASH_GREEN "[INFO ] " BASH_CLEAR, true);
+  BOOST_REQUIRE(!pss.Enabled());
+
+  pss << "hidden " << 7 << std::endl;
+  BOOST_REQUIRE_EQUAL(ss.str(), "");
+
+  pss.ignoreInput = false;
+  BOOST_REQUIRE(pss.Enabled());
+  pss << "shown" << std::endl;
+  BOOST_REQUIRE_EQUAL(ss.str(), BASH_GREEN "[INFO ] " BASH_CLEAR "shown\n");
+
+  // A fatal stream is always enabled.
+  PrefixedOutStream fatal(ss, BASH_RED "[FATAL] " BASH_CLEAR, true, true);
+  BOOST_REQUIRE(fatal.Enabled());
+
+  const bool ignoring = Log::Warn.ignoreInput;
+  size_t evaluations = 0;
+
+  Log::Warn.ignoreInput = true;
+  MLPACK_LOG_WARN << LogArgument(evaluations);
+  BOOST_REQUIRE_EQUAL(evaluations, 0);
+
+  // The macro must be usable as the body of an if with an else.
+  if (evaluations == 0)
+    MLPACK_LOG_WARN << LogArgument(evaluations);
+  else
+    evaluations = 10;
+  BOOST_REQUIRE_EQUAL(evaluations, 0);
+
+  Log::Warn.ignoreInput = false;
+  std::streambuf* buffer = Log::Warn.destination.rdbuf(ss.rdbuf());
+  MLPACK_LOG_WARN << LogArgument(evaluations) << std::endl;
+  Log::Warn.destination.rdbuf(buffer);
+  Log::Warn.ignoreInput = ignoring;
+  BOOST_REQUIRE_EQUAL(evaluations, 1);
+
+#ifndef DEBUG
+  MLPACK_LOG_DEBUG << LogArgument(evaluations);
+  BOOST_REQUIRE_EQUAL(evaluations, 1);
+#endif
+}
+
+/**
+ * Test that ScopedLogCapture keeps what the thread writes to a stream without
+ * prefixes, and that ScopedLogMute restores the stream when it is destroyed.
+ */
+BOOST_AUTO_TEST_CASE(TestScopedLogCapture)
+{
+  std::stringstream ss, captured;
+  PrefixedOutStream pss(ss, BASH_GREEN "[INFO ] " BASH_CLEAR);
+
+  {
+    ScopedLogCapture capture(pss, captured);
+    pss << "first" << std::endl << "second " << 2 << std::endl;
+  }
+  BOOST_REQUIRE_EQUAL(ss.str(), "");
+  BOOST_REQUIRE_EQUAL(captured.str(), "first\nsecond 2\n");
+
+  // Written to the stream, the captured output gets its prefixes.
+  pss << captured.str();
+  BOOST_REQUIRE_EQUAL(ss.str(), BASH_GREEN "[INFO ] " BASH_CLEAR "first\n"
+      BASH_GREEN "[INFO ] " BASH_CLEAR "second 2\n");
+
+  try
+  {
+    ScopedLogMute mute(pss);
+    BOOST_REQUIRE(!pss.Enabled());
+    throw std::runtime_error("error");
+  }
+  catch (std::runtime_error&) { }
+  BOOST_REQUIRE(pss.Enabled());
+}
+
 /**
  * We should be able to start and then stop a timer multiple times and it should
  * save the value.
@@ -283,4 +369,119 @@ BOOST_AUTO_TEST_CASE(TwiceStopTimerTest)
   BOOST_REQUIRE_THROW(Timer::Stop("test_timer"), std::runtime_error);
 }
 
+/**
+ * A scoped timer should run until it goes out of scope.
+ */
+BOOST_AUTO_TEST_CASE(ScopedTimerTest)
+{
+  {
+    ScopedTimer t("scoped_timer");
+
+    #ifdef _WIN32
+    Sleep(10);
+    #else
+    usleep(10000);
+    #endif
+  }
+
+  BOOST_REQUIRE_GE(Timer::Get("scoped_timer").tv_usec, 10000);
+
+  // The timer is stopped, so it can be started again.
+  Timer::Start("scoped_timer");
+  Timer::Stop("scoped_timer");
+}
+
+/**
+ * Several threads should be able to run the same timer at once, and its value
+ * should be the total over all of them.
+ */
+BOOST_AUTO_TEST_CASE(ThreadedTimerTest)
+{
+  #pragma omp parallel for
+  for (int i = 0; i < 4; ++i)
+  {
+    Timer::Start("threaded_timer");
+
+    #ifdef _WIN32
+    Sleep(10);
+    #else
+    usleep(10000);
+    #endif
+
+    Timer::Stop("threaded_timer");
+  }
+
+  const timeval t = Timer::Get("threaded_timer");
+  BOOST_REQUIRE_GE(t.tv_sec * 1000000 + t.tv_usec, 40000);
+}
+
+/**
+ * Make sure that nested timers are nested in the JSON export, and that each
+ * run is a trace event.
+ */
+BOOST_AUTO_TEST_CASE(TimersJSONTest)
+{
+  Timers timers;
+  timers.RecordEvents(true);
+
+  timers.StartTimer("outer");
+  for (size_t i = 0; i < 3; ++i)
+  {
+    timers.StartTimer("inner");
+    timers.StopTimer("inner");
+  }
+  timers.StopTimer("outer");
+  timers.StartTimer("inner");
+  timers.StopTimer("inner");
+
+  std::ostringstream stream;
+  timers.ToJSON(stream);
+  const std::string json = stream.str();
+
+  // The inner timer is in two places: on its own, with one run, and in the
+  // outer timer, with three runs.  The timers are sorted by name.
+  const size_t inner = json.find("\"name\": \"inner\"");
+  const size_t outer = json.find("\"name\": \"outer\"");
+  const size_t nested = json.find("\"name\": \"inner\"", outer);
+  const size_t events = json.find("\"traceEvents\"");
+  BOOST_REQUIRE_LT(inner, outer);
+  BOOST_REQUIRE_LT(nested, events);
+  BOOST_REQUIRE_LT(json.find("\"runs\": 1", inner), outer);
+  BOOST_REQUIRE_LT(json.find("\"runs\": 3", nested), events);
+
+  // There is one event per run.
+  size_t count = 0;
+  for (size_t pos = json.find("\"ph\": \"X\"", events);
+       pos != std::string::npos; pos = json.find("\"ph\": \"X\"", pos + 1))
+    ++count;
+  BOOST_REQUIRE_EQUAL(count, 5);
+}
+
+/**
+ * Make sure that the memory used during a timer is recorded, and that memory
+ * reports are kept.
+ */
+BOOST_AUTO_TEST_CASE(MemoryTest)
+{
+  Timers timers;
+  timers.RecordMemory(true);
+
+  timers.StartTimer("allocate");
+  arma::mat m(1000, 1000);
+  m.fill(1.0);
+  timers.StopTimer("allocate");
+
+  std::ostringstream stream;
+  timers.ToJSON(stream);
+  BOOST_REQUIRE_NE(stream.str().find("\"peak_rss\": "), std::string::npos);
+
+  BOOST_REQUIRE_EQUAL(MemoryUsage(m), sizeof(arma::mat) + 8000000);
+  Memory::Report("test_matrix", MemoryUsage(m));
+  BOOST_REQUIRE_EQUAL(Memory::Reports()["test_matrix"], MemoryUsage(m));
+
+  BOOST_REQUIRE_EQUAL(Memory::Format(512), "512 B");
+  BOOST_REQUIRE_EQUAL(Memory::Format(1536), "1.50 KB");
+  BOOST_REQUIRE_EQUAL(Memory::Format(3 * 1024 * 1024), "3.00 MB");
+}
+
 BOOST_AUTO_TEST_SUITE_END();
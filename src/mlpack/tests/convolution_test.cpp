@@ -11,10 +11,19 @@
 #include <mlpack/methods/ann/convolution_rules/naive_convolution.hpp>
 #include <mlpack/methods/ann/convolution_rules/fft_convolution.hpp>
 #include <mlpack/methods/ann/convolution_rules/svd_convolution.hpp>
+#include <mlpack/methods/ann/convolution_rules/im2col_convolution.hpp>
+#include <mlpack/methods/ann/layer/conv_layer.hpp>
+#include <mlpack/methods/ann/layer/pooling_layer.hpp>
+#include <mlpack/methods/ann/pooling_rules/max_pooling.hpp>
+#include <mlpack/methods/ann/init_rules/random_init.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 using namespace mlpack;
 using namespace mlpack::ann;
 
@@ -148,6 +157,10 @@ BOOST_AUTO_TEST_CASE(ValidConvolution2DTest)
   // speeded up the computation.
   Convolution2DMethodTest<SVDConvolution<ValidConvolution> >(input, filter,
       output);
+
+  // Perform the convolution by lowering the input to a matrix.
+  Convolution2DMethodTest<Im2colConvolution<ValidConvolution> >(input, filter,
+      output);
 }
 
 /**
@@ -185,6 +198,10 @@ BOOST_AUTO_TEST_CASE(FullConvolution2DTest)
   // speeded up the computation.
   Convolution2DMethodTest<SVDConvolution<FullConvolution> >(input, filter,
       output);
+
+  // Perform the convolution by lowering the input to a matrix.
+  Convolution2DMethodTest<Im2colConvolution<FullConvolution> >(input, filter,
+      output);
 }
 
 /**
@@ -230,6 +247,10 @@ BOOST_AUTO_TEST_CASE(ValidConvolution3DTest)
   // speeded up the computation.
   Convolution3DMethodTest<SVDConvolution<ValidConvolution> >(inputCube,
       filterCube, outputCube);
+
+  // Perform the convolution by lowering the input to a matrix.
+  Convolution3DMethodTest<Im2colConvolution<ValidConvolution> >(inputCube,
+      filterCube, outputCube);
 }
 
 /**
@@ -279,6 +300,10 @@ BOOST_AUTO_TEST_CASE(FullConvolution3DTest)
   // speeded up the computation.
   Convolution3DMethodTest<SVDConvolution<FullConvolution> >(inputCube,
       filterCube, outputCube);
+
+  // Perform the convolution by lowering the input to a matrix.
+  Convolution3DMethodTest<Im2colConvolution<FullConvolution> >(inputCube,
+      filterCube, outputCube);
 }
 
 /**
@@ -321,6 +346,10 @@ BOOST_AUTO_TEST_CASE(ValidConvolutionBatchTest)
   // speeded up the computation.
   ConvolutionMethodBatchTest<SVDConvolution<ValidConvolution> >(input,
       filterCube, outputCube);
+
+  // Perform the convolution by lowering the input to a matrix.
+  ConvolutionMethodBatchTest<Im2colConvolution<ValidConvolution> >(input,
+      filterCube, outputCube);
 }
 
 /**
@@ -367,6 +396,303 @@ BOOST_AUTO_TEST_CASE(FullConvolutionBatchTest)
   // speeded up the computation.
   ConvolutionMethodBatchTest<SVDConvolution<FullConvolution> >(input,
       filterCube, outputCube);
+
+  // Perform the convolution by lowering the input to a matrix.
+  ConvolutionMethodBatchTest<Im2colConvolution<FullConvolution> >(input,
+      filterCube, outputCube);
+}
+
+/**
+ * Make sure a convolution layer gives the same results with the im2col rules
+ * (which handle all of the maps of the layer at once) as with the naive rules
+ * (which handle one pair of maps at a time), for a batch of samples.
+ */
+BOOST_AUTO_TEST_CASE(Im2colConvolutionLayerTest)
+{
+  const size_t inMaps = 3;
+  const size_t outMaps = 4;
+  const size_t batchSize = 2;
+
+  ConvLayer<RMSPROP, RandomInitialization> naiveLayer(inMaps, outMaps, 3, 3);
+  ConvLayer<RMSPROP, RandomInitialization,
+      Im2colConvolution<ValidConvolution>, Im2colConvolution<FullConvolution>,
+      Im2colConvolution<ValidConvolution> > im2colLayer(inMaps, outMaps, 3, 3);
+  im2colLayer.Weights() = naiveLayer.Weights();
+
+  arma::cube input = arma::randu<arma::cube>(7, 6, inMaps * batchSize);
+  naiveLayer.InputParameter() = input;
+  im2colLayer.InputParameter() = input;
+
+  arma::cube naiveOutput, im2colOutput;
+  naiveLayer.Forward(input, naiveOutput);
+  im2colLayer.Forward(input, im2colOutput);
+
+  BOOST_REQUIRE_EQUAL(im2colOutput.n_rows, naiveOutput.n_rows);
+  BOOST_REQUIRE_EQUAL(im2colOutput.n_cols, naiveOutput.n_cols);
+  BOOST_REQUIRE_EQUAL(im2colOutput.n_slices, outMaps * batchSize);
+  BOOST_REQUIRE_EQUAL(im2colOutput.n_slices, naiveOutput.n_slices);
+  for (size_t i = 0; i < naiveOutput.n_elem; i++)
+    BOOST_REQUIRE_CLOSE(im2colOutput[i], naiveOutput[i], 1e-8);
+
+  const arma::cube delta = arma::randu<arma::cube>(naiveOutput.n_rows,
+      naiveOutput.n_cols, naiveOutput.n_slices);
+
+  arma::cube naiveBackward, im2colBackward;
+  naiveLayer.Backward(naiveOutput, delta, naiveBackward);
+  im2colLayer.Backward(im2colOutput, delta, im2colBackward);
+
+  BOOST_REQUIRE_EQUAL(im2colBackward.n_rows, input.n_rows);
+  BOOST_REQUIRE_EQUAL(im2colBackward.n_cols, input.n_cols);
+  BOOST_REQUIRE_EQUAL(im2colBackward.n_slices, input.n_slices);
+  for (size_t i = 0; i < naiveBackward.n_elem; i++)
+    BOOST_REQUIRE_CLOSE(im2colBackward[i], naiveBackward[i], 1e-8);
+
+  arma::cube naiveGradient, im2colGradient;
+  naiveLayer.Gradient(delta, naiveGradient);
+  im2colLayer.Gradient(delta, im2colGradient);
+
+  BOOST_REQUIRE_EQUAL(im2colGradient.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(im2colGradient.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(im2colGradient.n_slices, inMaps * outMaps);
+  for (size_t i = 0; i < naiveGradient.n_elem; i++)
+    BOOST_REQUIRE_CLOSE(im2colGradient[i], naiveGradient[i], 1e-8);
+}
+
+/**
+ * Make sure the full-mode map convolution and map gradient of the im2col rule
+ * match the naive convolution of each pair of maps.
+ */
+BOOST_AUTO_TEST_CASE(Im2colFullMapConvolutionTest)
+{
+  const size_t inMaps = 2;
+  const size_t outMaps = 3;
+  const size_t batchSize = 2;
+
+  const arma::cube input = arma::randu<arma::cube>(5, 4, inMaps * batchSize);
+  const arma::cube filter = arma::randu<arma::cube>(3, 2, inMaps * outMaps);
+
+  arma::cube output;
+  Im2colConvolution<FullConvolution>::MapConvolution(input, filter, outMaps,
+      output);
+  BOOST_REQUIRE_EQUAL(output.n_slices, outMaps * batchSize);
+
+  for (size_t outMap = 0; outMap < outMaps; outMap++)
+  {
+    for (size_t i = 0; i < batchSize; i++)
+    {
+      arma::mat reference, convOutput;
+      for (size_t inMap = 0; inMap < inMaps; inMap++)
+      {
+        NaiveConvolution<FullConvolution>::Convolution(
+            input.slice(inMap * batchSize + i),
+            filter.slice(inMap * outMaps + outMap), convOutput);
+        if (inMap == 0)
+          reference = convOutput;
+        else
+          reference += convOutput;
+      }
+
+      BOOST_REQUIRE_EQUAL(output.n_rows, reference.n_rows);
+      BOOST_REQUIRE_EQUAL(output.n_cols, reference.n_cols);
+      for (size_t j = 0; j < reference.n_elem; j++)
+        BOOST_REQUIRE_CLOSE(output.slice(outMap * batchSize + i)[j],
+            reference[j], 1e-8);
+    }
+  }
+
+  // Now use the output as the delta for the gradient.
+  arma::cube gradient;
+  Im2colConvolution<FullConvolution>::MapGradient(input, output, outMaps,
+      gradient);
+  BOOST_REQUIRE_EQUAL(gradient.n_slices, inMaps * outMaps);
+
+  for (size_t inMap = 0; inMap < inMaps; inMap++)
+  {
+    for (size_t outMap = 0; outMap < outMaps; outMap++)
+    {
+      arma::mat reference, convOutput;
+      for (size_t i = 0; i < batchSize; i++)
+      {
+        NaiveConvolution<FullConvolution>::Convolution(
+            input.slice(inMap * batchSize + i),
+            output.slice(outMap * batchSize + i), convOutput);
+        if (i == 0)
+          reference = convOutput;
+        else
+          reference += convOutput;
+      }
+
+      BOOST_REQUIRE_EQUAL(gradient.n_rows, reference.n_rows);
+      BOOST_REQUIRE_EQUAL(gradient.n_cols, reference.n_cols);
+      for (size_t j = 0; j < reference.n_elem; j++)
+        BOOST_REQUIRE_CLOSE(gradient.slice(inMap * outMaps + outMap)[j],
+            reference[j], 1e-8);
+    }
+  }
+}
+
+/**
+ * Make sure the map convolution and map gradient of the fft rule match the
+ * fft convolution of each pair of maps, for the given border mode.
+ */
+template<typename BorderMode>
+void FFTMapConvolutionTest()
+{
+  const size_t inMaps = 2;
+  const size_t outMaps = 3;
+  const size_t batchSize = 2;
+
+  const arma::cube input = arma::randu<arma::cube>(8, 6, inMaps * batchSize);
+  const arma::cube filter = arma::randu<arma::cube>(3, 2, inMaps * outMaps);
+
+  arma::cube output;
+  FFTConvolution<BorderMode>::MapConvolution(input, filter, outMaps, output);
+  BOOST_REQUIRE_EQUAL(output.n_slices, outMaps * batchSize);
+
+  for (size_t outMap = 0; outMap < outMaps; outMap++)
+  {
+    for (size_t i = 0; i < batchSize; i++)
+    {
+      arma::mat reference, convOutput;
+      for (size_t inMap = 0; inMap < inMaps; inMap++)
+      {
+        FFTConvolution<BorderMode>::Convolution(
+            arma::mat(input.slice(inMap * batchSize + i)),
+            arma::mat(filter.slice(inMap * outMaps + outMap)), convOutput);
+        if (inMap == 0)
+          reference = convOutput;
+        else
+          reference += convOutput;
+      }
+
+      BOOST_REQUIRE_EQUAL(output.n_rows, reference.n_rows);
+      BOOST_REQUIRE_EQUAL(output.n_cols, reference.n_cols);
+      for (size_t j = 0; j < reference.n_elem; j++)
+        BOOST_REQUIRE_CLOSE(output.slice(outMap * batchSize + i)[j],
+            reference[j], 1e-8);
+    }
+  }
+
+  // Now use a random delta of the size of the valid convolution of the input
+  // with a 3x2 filter for the gradient.
+  const arma::cube delta = arma::randu<arma::cube>(6, 5, outMaps * batchSize);
+  arma::cube gradient;
+  FFTConvolution<BorderMode>::MapGradient(input, delta, outMaps, gradient);
+  BOOST_REQUIRE_EQUAL(gradient.n_slices, inMaps * outMaps);
+
+  for (size_t inMap = 0; inMap < inMaps; inMap++)
+  {
+    for (size_t outMap = 0; outMap < outMaps; outMap++)
+    {
+      arma::mat reference, convOutput;
+      for (size_t i = 0; i < batchSize; i++)
+      {
+        FFTConvolution<BorderMode>::Convolution(
+            arma::mat(input.slice(inMap * batchSize + i)),
+            arma::mat(delta.slice(outMap * batchSize + i)), convOutput);
+        if (i == 0)
+          reference = convOutput;
+        else
+          reference += convOutput;
+      }
+
+      BOOST_REQUIRE_EQUAL(gradient.n_rows, reference.n_rows);
+      BOOST_REQUIRE_EQUAL(gradient.n_cols, reference.n_cols);
+      for (size_t j = 0; j < reference.n_elem; j++)
+        BOOST_REQUIRE_CLOSE(gradient.slice(inMap * outMaps + outMap)[j],
+            reference[j], 1e-8);
+    }
+  }
+}
+
+/**
+ * Test the map convolution and map gradient of the fft rule in valid mode.
+ */
+BOOST_AUTO_TEST_CASE(FFTValidMapConvolutionTest)
+{
+  FFTMapConvolutionTest<ValidConvolution>();
+}
+
+/**
+ * Test the map convolution and map gradient of the fft rule in full mode.
+ */
+BOOST_AUTO_TEST_CASE(FFTFullMapConvolutionTest)
+{
+  FFTMapConvolutionTest<FullConvolution>();
+}
+
+/**
+ * Run the passes of a convolution layer and a pooling layer on a batch.
+ */
+template<typename ConvLayerType, typename PoolingLayerType>
+void RunConvPoolingPasses(ConvLayerType& convLayer,
+                          PoolingLayerType& poolingLayer,
+                          const arma::cube& input,
+                          arma::cube& convOutput,
+                          arma::cube& convBackward,
+                          arma::cube& convGradient,
+                          arma::cube& poolingOutput,
+                          arma::cube& poolingBackward)
+{
+  convLayer.InputParameter() = input;
+  convLayer.Forward(input, convOutput);
+
+  poolingLayer.InputParameter() = convOutput;
+  poolingLayer.Forward(convOutput, poolingOutput);
+  poolingLayer.Backward(poolingOutput, poolingOutput, poolingBackward);
+
+  convLayer.Backward(convOutput, poolingBackward, convBackward);
+  convLayer.Gradient(poolingBackward, convGradient);
+}
+
+/**
+ * Make sure the convolution and pooling layers give exactly the same results
+ * with many threads as with a single thread, since every output slice is
+ * computed in the same order either way.  Without OpenMP, both runs are
+ * serial.
+ */
+BOOST_AUTO_TEST_CASE(ConvPoolingLayerThreadsTest)
+{
+  ConvLayer<RMSPROP, RandomInitialization> convLayer(3, 4, 3, 3);
+  PoolingLayer<MaxPooling> poolingLayer(2);
+
+  const arma::cube input = arma::randu<arma::cube>(10, 10, 3 * 5);
+
+  arma::cube serialOutput, serialBackward, serialGradient;
+  arma::cube serialPooling, serialUnpooling;
+#ifdef _OPENMP
+  const int threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  RunConvPoolingPasses(convLayer, poolingLayer, input, serialOutput,
+      serialBackward, serialGradient, serialPooling, serialUnpooling);
+
+  arma::cube parallelOutput, parallelBackward, parallelGradient;
+  arma::cube parallelPooling, parallelUnpooling;
+#ifdef _OPENMP
+  omp_set_num_threads(std::max(threads, 4));
+#endif
+  RunConvPoolingPasses(convLayer, poolingLayer, input, parallelOutput,
+      parallelBackward, parallelGradient, parallelPooling, parallelUnpooling);
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif
+
+  BOOST_REQUIRE_EQUAL(serialOutput.n_slices, 4 * 5);
+  BOOST_REQUIRE_EQUAL(serialPooling.n_slices, 4 * 5);
+  BOOST_REQUIRE_EQUAL(serialBackward.n_slices, 3 * 5);
+  BOOST_REQUIRE_EQUAL(serialGradient.n_slices, 3 * 4);
+
+  BOOST_REQUIRE_EQUAL(arma::accu(arma::abs(serialOutput - parallelOutput)),
+      0.0);
+  BOOST_REQUIRE_EQUAL(arma::accu(arma::abs(serialPooling - parallelPooling)),
+      0.0);
+  BOOST_REQUIRE_EQUAL(arma::accu(arma::abs(serialUnpooling -
+      parallelUnpooling)), 0.0);
+  BOOST_REQUIRE_EQUAL(arma::accu(arma::abs(serialBackward - parallelBackward)),
+      0.0);
+  BOOST_REQUIRE_EQUAL(arma::accu(arma::abs(serialGradient - parallelGradient)),
+      0.0);
 }
 
 BOOST_AUTO_TEST_SUITE_END();
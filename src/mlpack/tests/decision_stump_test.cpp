@@ -307,4 +307,52 @@ BOOST_AUTO_TEST_CASE(DimensionSelectionTest)
   }
 }
 
+/**
+ * Make sure a weighted stump gives the same result whether the sorting
+ * permutations of the stump it is built from match the data or not.
+ */
+BOOST_AUTO_TEST_CASE(ReusedSortedIndicesTest)
+{
+  const size_t numClasses = 3;
+  const size_t inpBucketSize = 5;
+
+  arma::mat dataA = arma::randu<arma::mat>(4, 200);
+  arma::mat dataB = arma::randu<arma::mat>(4, 200);
+  // Make one attribute constant, and one with many ties.
+  dataB.row(2).fill(0.5);
+  dataB.row(3) = arma::floor(4.0 * dataB.row(3));
+
+  arma::Row<size_t> labelsA(200), labelsB(200);
+  for (size_t i = 0; i < 200; ++i)
+  {
+    labelsA[i] = i % numClasses;
+    labelsB[i] = (dataB(0, i) < 0.3) ? 0 : ((dataB(0, i) < 0.7) ? 1 : 2);
+  }
+
+  const arma::rowvec weights = arma::randu<arma::rowvec>(200);
+
+  // This stump's permutations are those of dataA.
+  DecisionStump<> dsA(dataA, labelsA, numClasses, inpBucketSize);
+  // This stump's permutations are those of dataB.
+  DecisionStump<> dsB(dataB, labelsB, numClasses, inpBucketSize);
+
+  // Train twice from dsA, so the second time the repaired permutations are
+  // reused.
+  DecisionStump<> fromA(dsA, dataB, labelsB, weights);
+  DecisionStump<> fromAAgain(dsA, dataB, labelsB, weights);
+  DecisionStump<> fromB(dsB, dataB, labelsB, weights);
+
+  BOOST_REQUIRE_EQUAL(fromA.SplitAttribute(), fromB.SplitAttribute());
+  BOOST_REQUIRE_EQUAL(fromAAgain.SplitAttribute(), fromB.SplitAttribute());
+  BOOST_REQUIRE_EQUAL(fromA.Split().n_elem, fromB.Split().n_elem);
+  BOOST_REQUIRE_EQUAL(fromAAgain.Split().n_elem, fromB.Split().n_elem);
+  for (size_t i = 0; i < fromB.Split().n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(fromA.Split()[i], fromB.Split()[i]);
+    BOOST_REQUIRE_EQUAL(fromAAgain.Split()[i], fromB.Split()[i]);
+    BOOST_REQUIRE_EQUAL(fromA.BinLabels()[i], fromB.BinLabels()[i]);
+    BOOST_REQUIRE_EQUAL(fromAAgain.BinLabels()[i], fromB.BinLabels()[i]);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
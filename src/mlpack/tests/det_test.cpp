@@ -24,6 +24,8 @@
   #undef private
 #endif
 
+#include <mlpack/methods/det/flat_dtree.hpp>
+
 using namespace mlpack;
 using namespace mlpack::det;
 using namespace std;
@@ -212,6 +214,59 @@ BOOST_AUTO_TEST_CASE(TestGrow)
   BOOST_REQUIRE_CLOSE(alpha, min(rootAlpha, rAlpha), 1e-10);
 }
 
+// Check that every point of each leaf of the tree is inside its bounding box,
+// and count the leaves.
+void CheckLeafBounds(const DTree& node, const arma::mat& data, size_t& leaves)
+{
+  if (node.Left() == NULL)
+  {
+    for (size_t i = node.Start(); i < node.End(); ++i)
+    {
+      for (size_t d = 0; d < data.n_rows; ++d)
+      {
+        BOOST_REQUIRE_GE(data(d, i), node.MinVals()[d]);
+        BOOST_REQUIRE_LE(data(d, i), node.MaxVals()[d]);
+      }
+    }
+
+    ++leaves;
+    return;
+  }
+
+  BOOST_REQUIRE_EQUAL(node.Left()->End(), node.Right()->Start());
+  CheckLeafBounds(*node.Left(), data, leaves);
+  CheckLeafBounds(*node.Right(), data, leaves);
+}
+
+/**
+ * Grow a tree that is large enough for its nodes to be split in parallel (if
+ * OpenMP is available), and make sure that the points are partitioned
+ * correctly.
+ */
+BOOST_AUTO_TEST_CASE(TestGrowLargeTree)
+{
+  arma::mat data(3, 25000);
+  data.randu();
+  const arma::mat originalData(data);
+
+  arma::Col<size_t> oldFromNew(data.n_cols);
+  for (size_t i = 0; i < oldFromNew.n_elem; ++i)
+    oldFromNew[i] = i;
+
+  DTree tree(data);
+  tree.Grow(data, oldFromNew, false, 200, 50);
+
+  // The points are only reordered.
+  for (size_t i = 0; i < data.n_cols; ++i)
+    for (size_t d = 0; d < data.n_rows; ++d)
+      BOOST_REQUIRE_EQUAL(data(d, i), originalData(d, oldFromNew[i]));
+
+  size_t leaves = 0;
+  CheckLeafBounds(tree, data, leaves);
+  BOOST_REQUIRE_GT(leaves, 1);
+  BOOST_REQUIRE_EQUAL(leaves, tree.SubtreeLeaves());
+}
+
 BOOST_AUTO_TEST_CASE(TestPruneAndUpdate)
 {
   arma::mat testData(3, 5);
@@ -277,6 +332,55 @@ BOOST_AUTO_TEST_CASE(TestComputeValue)
   BOOST_REQUIRE_CLOSE(0.0, testDTree.ComputeValue(q4), 1e-10);
 }
 
+/**
+ * Make sure that the flattened tree gives the same density estimates as the
+ * tree it was made from, both before and after pruning.
+ */
+BOOST_AUTO_TEST_CASE(TestFlatDTreeComputeValue)
+{
+  arma::mat data(4, 2000);
+  data.randn();
+
+  arma::Col<size_t> oldFromNew(data.n_cols);
+  for (size_t i = 0; i < oldFromNew.n_elem; ++i)
+    oldFromNew[i] = i;
+
+  DTree tree(data);
+  double alpha = tree.Grow(data, oldFromNew, false, 10, 5);
+
+  // Some of these are outside the bounding box of the tree.
+  arma::mat queries(4, 500);
+  queries.randn();
+  queries *= 1.5;
+
+  for (size_t pass = 0; pass < 3; ++pass)
+  {
+    FlatDTree flatTree(tree);
+    BOOST_REQUIRE_EQUAL(flatTree.NumLeaves(), tree.SubtreeLeaves());
+    BOOST_REQUIRE_EQUAL(flatTree.NumInternalNodes(), tree.SubtreeLeaves() - 1);
+
+    arma::vec values;
+    flatTree.ComputeValue(queries, values);
+    BOOST_REQUIRE_EQUAL(values.n_elem, queries.n_cols);
+
+    for (size_t i = 0; i < queries.n_cols; ++i)
+    {
+      const double value = tree.ComputeValue(queries.unsafe_col(i));
+      BOOST_REQUIRE_EQUAL(values[i], value);
+      BOOST_REQUIRE_EQUAL(flatTree.ComputeValue(queries.unsafe_col(i)), value);
+    }
+
+    alpha = tree.PruneAndUpdate(alpha, data.n_cols, false);
+  }
+
+  // An empty tree gives zero density everywhere.
+  FlatDTree emptyTree;
+  arma::vec values;
+  emptyTree.ComputeValue(queries, values);
+  BOOST_REQUIRE_EQUAL(values.n_elem, queries.n_cols);
+  BOOST_REQUIRE_EQUAL(arma::accu(values), 0.0);
+}
+
 BOOST_AUTO_TEST_CASE(TestVariableImportance)
 {
   arma::mat testData(3, 5);
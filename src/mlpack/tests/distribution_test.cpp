@@ -307,6 +307,39 @@ BOOST_AUTO_TEST_CASE(GaussianMultipointMultivariateProbabilityTest)
   BOOST_REQUIRE_CLOSE(phis(5), -14.900192463287908, 1e-5);
 }
 
+/**
+ * Make sure the batch LogProbability() gives the same results as evaluating
+ * each point on its own, and as the density written with the explicit inverse,
+ * for a higher-dimensional full covariance.
+ */
+BOOST_AUTO_TEST_CASE(GaussianBatchLogProbabilityTest)
+{
+  arma::mat factor = arma::randu<arma::mat>(10, 10);
+  arma::mat cov = factor * trans(factor);
+  cov.diag() += 0.5;
+  arma::vec mean = arma::randu<arma::vec>(10);
+
+  GaussianDistribution g(mean, cov);
+
+  arma::mat points = 3.0 * arma::randn<arma::mat>(10, 200);
+  arma::vec logProbs;
+  g.LogProbability(points, logProbs);
+
+  BOOST_REQUIRE_EQUAL(logProbs.n_elem, 200);
+
+  const arma::mat invCov = arma::inv(cov);
+  const double logDet = log(arma::det(cov));
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    const arma::vec diff = points.col(i) - mean;
+    const double expected = -5.0 * log(2.0 * M_PI) - 0.5 * logDet -
+        0.5 * arma::dot(diff, invCov * diff);
+
+    BOOST_REQUIRE_CLOSE(logProbs[i], expected, 1e-5);
+    BOOST_REQUIRE_CLOSE(g.LogProbability(points.col(i)), expected, 1e-5);
+  }
+}
+
 /**
  * Make sure random observations follow the probability distribution correctly.
  */
@@ -373,4 +406,93 @@ BOOST_AUTO_TEST_CASE(GaussianDistributionEstimateTest)
       BOOST_REQUIRE_SMALL(d.Covariance()(i, j) - actualCov(i, j), 1e-5);
 }
 
+/**
+ * Make sure DiagonalGaussianDistribution gives the same probabilities as a
+ * GaussianDistribution with the same diagonal covariance matrix.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalGaussianDistributionProbabilityTest)
+{
+  arma::vec mean("1.0 -2.0 0.5 3.0");
+  arma::vec cov("0.5 2.0 1.0 4.0");
+
+  DiagonalGaussianDistribution d(mean, cov);
+  GaussianDistribution g(mean, arma::diagmat(cov));
+
+  arma::mat points(4, 100);
+  points.randn();
+  points *= 2.0;
+
+  arma::vec dProbs, gProbs;
+  d.Probability(points, dProbs);
+  g.Probability(points, gProbs);
+
+  BOOST_REQUIRE_EQUAL(dProbs.n_elem, 100);
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(dProbs[i], gProbs[i], 1e-5);
+    BOOST_REQUIRE_CLOSE(d.Probability(points.col(i)), gProbs[i], 1e-5);
+  }
+
+  // A covariance that is not positive should be rejected.
+  BOOST_REQUIRE_THROW(d.Covariance(arma::vec("1.0 0.0 1.0 1.0")),
+      std::invalid_argument);
+}
+
+/**
+ * Make sure the batch probabilities of a discrete distribution match the
+ * probabilities of each observation, both when a table of log probabilities is
+ * built and when it isn't.
+ */
+BOOST_AUTO_TEST_CASE(DiscreteDistributionBatchProbabilityTest)
+{
+  DiscreteDistribution d(5);
+  d.Probabilities() = "0.2 0.4 0.1 0.1 0.2";
+
+  // Fewer observations than possible observations, and then more.
+  for (size_t n = 3; n <= 300; n *= 10)
+  {
+    arma::mat observations(1, n);
+    for (size_t i = 0; i < n; ++i)
+      observations(0, i) = (7 * i) % 5;
+
+    arma::vec probabilities, logProbabilities;
+    d.Probability(observations, probabilities);
+    d.LogProbability(observations, logProbabilities);
+
+    BOOST_REQUIRE_EQUAL(probabilities.n_elem, n);
+    BOOST_REQUIRE_EQUAL(logProbabilities.n_elem, n);
+    for (size_t i = 0; i < n; ++i)
+    {
+      const arma::vec observation = observations.col(i);
+      BOOST_REQUIRE_CLOSE(probabilities[i], d.Probability(observation), 1e-5);
+      BOOST_REQUIRE_CLOSE(logProbabilities[i], d.LogProbability(observation),
+          1e-5);
+    }
+  }
+}
+
+/**
+ * Make sure the batch probabilities of a Laplace distribution match the
+ * probabilities of each observation.
+ */
+BOOST_AUTO_TEST_CASE(LaplaceDistributionBatchProbabilityTest)
+{
+  LaplaceDistribution l(arma::randu<arma::vec>(4), 1.5);
+
+  arma::mat observations = arma::randn<arma::mat>(4, 100);
+  arma::vec probabilities, logProbabilities;
+  l.Probability(observations, probabilities);
+  l.LogProbability(observations, logProbabilities);
+
+  BOOST_REQUIRE_EQUAL(probabilities.n_elem, 100);
+  BOOST_REQUIRE_EQUAL(logProbabilities.n_elem, 100);
+  for (size_t i = 0; i < observations.n_cols; ++i)
+  {
+    const arma::vec observation = observations.col(i);
+    BOOST_REQUIRE_CLOSE(probabilities[i], l.Probability(observation), 1e-5);
+    BOOST_REQUIRE_CLOSE(logProbabilities[i], l.LogProbability(observation),
+        1e-5);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -216,6 +216,43 @@ BOOST_AUTO_TEST_CASE(DualTreeVsNaive)
   }
 }
 
+/**
+ * Make sure that splitting each iteration across threads gives the same tree,
+ * in dual-tree and in naive mode.
+ */
+BOOST_AUTO_TEST_CASE(ParallelVsSerial)
+{
+  arma::mat inputData;
+  if (!data::Load("test_data_3_1000.csv", inputData))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  for (size_t naive = 0; naive < 2; ++naive)
+  {
+    // Tree building modifies the dataset, so each object gets its own copy.
+    arma::mat serialData = inputData;
+    arma::mat parallelData = inputData;
+
+    DualTreeBoruvka<> serial(serialData, (naive == 1));
+    arma::mat serialResults;
+    serial.ComputeMST(serialResults);
+
+    DualTreeBoruvka<> parallel(parallelData, (naive == 1));
+    parallel.Parallel() = true;
+    arma::mat parallelResults;
+    parallel.ComputeMST(parallelResults);
+
+    BOOST_REQUIRE_EQUAL(parallelResults.n_cols, serialResults.n_cols);
+    BOOST_REQUIRE_EQUAL(parallelResults.n_rows, serialResults.n_rows);
+
+    for (size_t i = 0; i < serialResults.n_cols; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(parallelResults(0, i), serialResults(0, i));
+      BOOST_REQUIRE_EQUAL(parallelResults(1, i), serialResults(1, i));
+      BOOST_REQUIRE_CLOSE(parallelResults(2, i), serialResults(2, i), 1e-5);
+    }
+  }
+}
+
 /**
  * Make sure the cover tree works fine.
  */
@@ -275,4 +312,52 @@ BOOST_AUTO_TEST_CASE(BallTreeTest)
 
 }
 
+/**
+ * Make sure that adding the edges of the k-nearest-neighbor graph first gives
+ * the same tree, for several k, in dual-tree and naive mode, and when the
+ * graph is not connected (two clusters far apart), so that the dual-tree
+ * Boruvka iterations have to add the rest.
+ */
+BOOST_AUTO_TEST_CASE(NeighborGraphTest)
+{
+  arma::mat inputData;
+  if (!data::Load("test_data_3_1000.csv", inputData))
+    BOOST_FAIL("Cannot load test dataset test_data_3_1000.csv!");
+
+  arma::mat clusters = arma::randu<arma::mat>(3, 400);
+  clusters.cols(200, 399) += 100.0;
+
+  const size_t ks[] = { 1, 3, 10 };
+  for (size_t d = 0; d < 2; ++d)
+  {
+    const arma::mat& dataset = (d == 0) ? inputData : clusters;
+
+    arma::mat dataCopy = dataset;
+    DualTreeBoruvka<> dtb(dataCopy);
+    arma::mat results;
+    dtb.ComputeMST(results);
+
+    for (size_t naive = 0; naive < 2; ++naive)
+    {
+      for (size_t i = 0; i < 3; ++i)
+      {
+        arma::mat graphData = dataset;
+        DualTreeBoruvka<> graphDtb(graphData, (naive == 1));
+        graphDtb.Neighbors() = ks[i];
+        arma::mat graphResults;
+        graphDtb.ComputeMST(graphResults);
+
+        BOOST_REQUIRE_EQUAL(graphResults.n_cols, results.n_cols);
+        BOOST_REQUIRE_EQUAL(graphResults.n_rows, results.n_rows);
+        for (size_t j = 0; j < results.n_cols; ++j)
+        {
+          BOOST_REQUIRE_EQUAL(graphResults(0, j), results(0, j));
+          BOOST_REQUIRE_EQUAL(graphResults(1, j), results(1, j));
+          BOOST_REQUIRE_CLOSE(graphResults(2, j), results(2, j), 1e-5);
+        }
+      }
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -55,6 +55,38 @@ BOOST_AUTO_TEST_CASE(SingleTreeVsNaive)
   }
 }
 
+/**
+ * Compare single-tree and naive with the polynomial kernel, whose base cases at
+ * the leaves are computed as blocks.
+ */
+BOOST_AUTO_TEST_CASE(SingleTreeVsNaivePolynomial)
+{
+  arma::mat data;
+  data.randn(5, 1000);
+  PolynomialKernel pk(2.0, 1.0);
+
+  FastMKS<PolynomialKernel> naive(data, pk, false, true);
+
+  arma::Mat<size_t> naiveIndices;
+  arma::mat naiveProducts;
+  naive.Search(10, naiveIndices, naiveProducts);
+
+  FastMKS<PolynomialKernel> single(data, pk, true);
+
+  arma::Mat<size_t> singleIndices;
+  arma::mat singleProducts;
+  single.Search(10, singleIndices, singleProducts);
+
+  for (size_t q = 0; q < singleIndices.n_cols; ++q)
+  {
+    for (size_t r = 0; r < singleIndices.n_rows; ++r)
+    {
+      BOOST_REQUIRE_EQUAL(singleIndices(r, q), naiveIndices(r, q));
+      BOOST_REQUIRE_CLOSE(singleProducts(r, q), naiveProducts(r, q), 1e-5);
+    }
+  }
+}
+
 /**
  * Compare dual-tree and naive.
  */
@@ -89,6 +121,84 @@ BOOST_AUTO_TEST_CASE(DualTreeVsNaive)
   }
 }
 
+/**
+ * Compare naive search with search on a cover tree that reorders the dataset;
+ * the results must be mapped back to the original points.
+ */
+BOOST_AUTO_TEST_CASE(ReorderedCoverTreeVsNaive)
+{
+  arma::mat data;
+  data.randn(5, 1000);
+  arma::mat queries;
+  queries.randn(5, 200);
+  LinearKernel lk;
+
+  FastMKS<LinearKernel> naive(data, lk, false, true);
+  arma::Mat<size_t> naiveIndices;
+  arma::mat naiveProducts;
+
+  arma::Mat<size_t> treeIndices;
+  arma::mat treeProducts;
+
+  // Dual-tree and single-tree search, with and without a query set.
+  for (size_t run = 0; run < 4; ++run)
+  {
+    const bool singleMode = (run % 2 == 1);
+    FastMKS<LinearKernel, arma::mat, ReorderedCoverTree> tree(data, lk,
+        singleMode);
+    if (run < 2)
+    {
+      naive.Search(10, naiveIndices, naiveProducts);
+      tree.Search(10, treeIndices, treeProducts);
+    }
+    else
+    {
+      naive.Search(queries, 10, naiveIndices, naiveProducts);
+      tree.Search(queries, 10, treeIndices, treeProducts);
+    }
+
+    BOOST_REQUIRE_EQUAL(treeIndices.n_cols, naiveIndices.n_cols);
+    for (size_t i = 0; i < treeIndices.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(treeIndices[i], naiveIndices[i]);
+      BOOST_REQUIRE_CLOSE(treeProducts[i], naiveProducts[i], 1e-5);
+    }
+  }
+}
+
+/**
+ * Compare dual-tree and naive when k is large enough that the candidate lists
+ * are kept as heaps.
+ */
+BOOST_AUTO_TEST_CASE(LargeKDualTreeVsNaive)
+{
+  arma::mat data;
+  data.randn(5, 1000);
+  LinearKernel lk;
+  const size_t k = 2 * KernelCandidateList::HeapThreshold;
+
+  FastMKS<LinearKernel> naive(data, lk, false, true);
+  arma::Mat<size_t> naiveIndices;
+  arma::mat naiveProducts;
+  naive.Search(k, naiveIndices, naiveProducts);
+
+  FastMKS<LinearKernel> tree(data, lk);
+  arma::Mat<size_t> treeIndices;
+  arma::mat treeProducts;
+  tree.Search(k, treeIndices, treeProducts);
+
+  for (size_t q = 0; q < treeIndices.n_cols; ++q)
+  {
+    for (size_t r = 0; r < treeIndices.n_rows; ++r)
+    {
+      if (r > 0)
+        BOOST_REQUIRE_GE(naiveProducts(r - 1, q), naiveProducts(r, q));
+      BOOST_REQUIRE_EQUAL(treeIndices(r, q), naiveIndices(r, q));
+      BOOST_REQUIRE_CLOSE(treeProducts(r, q), naiveProducts(r, q), 1e-5);
+    }
+  }
+}
+
 /**
  * Compare dual-tree and single-tree on a larger dataset.
  */
@@ -122,6 +232,50 @@ BOOST_AUTO_TEST_CASE(DualTreeVsSingleTree)
   }
 }
 
+/**
+ * Make sure that parallel search gives the same results as serial search in
+ * naive, single-tree, and dual-tree mode, with and without a query set.
+ */
+BOOST_AUTO_TEST_CASE(ParallelVsSerial)
+{
+  arma::mat referenceData;
+  referenceData.randu(6, 2000);
+  arma::mat queryData;
+  queryData.randu(6, 500);
+  PolynomialKernel pk(2.0, 1.0);
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    const bool single = (mode == 1);
+    const bool naive = (mode == 2);
+
+    FastMKS<PolynomialKernel> serial(referenceData, pk, single, naive);
+    FastMKS<PolynomialKernel> parallel(referenceData, pk, single, naive);
+    parallel.Parallel() = true;
+
+    arma::Mat<size_t> serialIndices, parallelIndices;
+    arma::mat serialProducts, parallelProducts;
+
+    serial.Search(queryData, 5, serialIndices, serialProducts);
+    parallel.Search(queryData, 5, parallelIndices, parallelProducts);
+
+    for (size_t i = 0; i < serialIndices.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(parallelIndices[i], serialIndices[i]);
+      BOOST_REQUIRE_CLOSE(parallelProducts[i], serialProducts[i], 1e-5);
+    }
+
+    serial.Search(5, serialIndices, serialProducts);
+    parallel.Search(5, parallelIndices, parallelProducts);
+
+    for (size_t i = 0; i < serialIndices.n_elem; ++i)
+    {
+      BOOST_REQUIRE_EQUAL(parallelIndices[i], serialIndices[i]);
+      BOOST_REQUIRE_CLOSE(parallelProducts[i], serialProducts[i], 1e-5);
+    }
+  }
+}
+
 /**
  * Test sparse FastMKS (how useful is this, I'm not sure).
  */
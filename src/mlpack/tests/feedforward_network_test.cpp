@@ -10,17 +10,24 @@
 #include <mlpack/methods/ann/activation_functions/tanh_function.hpp>
 
 #include <mlpack/methods/ann/init_rules/random_init.hpp>
+#include <mlpack/methods/ann/init_rules/nguyen_widrow_init.hpp>
 
 #include <mlpack/methods/ann/layer/bias_layer.hpp>
 #include <mlpack/methods/ann/layer/linear_layer.hpp>
 #include <mlpack/methods/ann/layer/base_layer.hpp>
 #include <mlpack/methods/ann/layer/dropout_layer.hpp>
+#include <mlpack/methods/ann/layer/embedding_layer.hpp>
 #include <mlpack/methods/ann/layer/binary_classification_layer.hpp>
 
 #include <mlpack/methods/ann/trainer/trainer.hpp>
 #include <mlpack/methods/ann/ffn.hpp>
+#include <mlpack/methods/ann/flat_parameters.hpp>
 #include <mlpack/methods/ann/performance_functions/mse_function.hpp>
 #include <mlpack/methods/ann/optimizer/rmsprop.hpp>
+#include <mlpack/methods/ann/optimizer/adam.hpp>
+
+#include <boost/archive/xml_iarchive.hpp>
+#include <boost/archive/xml_oarchive.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -71,13 +78,17 @@ void BuildVanillaNetwork(MatType& trainData,
    * +-----+       +-----+
    */
 
-  LinearLayer<> inputLayer(trainData.n_rows, hiddenLayerSize);
-  BiasLayer<> inputBiasLayer(hiddenLayerSize);
-  BaseLayer<PerformanceFunction> inputBaseLayer;
+  LinearLayer<RMSPROP, NguyenWidrowInitialization, MatType, MatType>
+      inputLayer(trainData.n_rows, hiddenLayerSize);
+  BiasLayer<RMSPROP, NguyenWidrowInitialization, MatType, MatType>
+      inputBiasLayer(hiddenLayerSize);
+  BaseLayer<PerformanceFunction, MatType, MatType> inputBaseLayer;
 
-  LinearLayer<> hiddenLayer1(hiddenLayerSize, trainLabels.n_rows);
-  BiasLayer<> hiddenBiasLayer1(trainLabels.n_rows);
-  BaseLayer<PerformanceFunction> outputLayer;
+  LinearLayer<RMSPROP, NguyenWidrowInitialization, MatType, MatType>
+      hiddenLayer1(hiddenLayerSize, trainLabels.n_rows);
+  BiasLayer<RMSPROP, NguyenWidrowInitialization, MatType, MatType>
+      hiddenBiasLayer1(trainLabels.n_rows);
+  BaseLayer<PerformanceFunction, MatType, MatType> outputLayer;
 
   OutputLayerType classOutputLayer;
 
@@ -87,7 +98,7 @@ void BuildVanillaNetwork(MatType& trainData,
   FFN<decltype(modules), decltype(classOutputLayer), PerformanceFunctionType>
       net(modules, classOutputLayer);
 
-  Trainer<decltype(net)> trainer(net, maxEpochs, 1, 0.01);
+  Trainer<decltype(net), MatType> trainer(net, maxEpochs, 1, 0.01);
   trainer.Train(trainData, trainLabels, testData, testLabels);
 
   MatType prediction;
@@ -238,6 +249,67 @@ void BuildDropoutNetwork(MatType& trainData,
   BOOST_REQUIRE_LE(trainer.ValidationError(), ValidationErrorThreshold);
 }
 
+/**
+ * The dropout layer should zero about the given ratio of the elements, scale
+ * the others, and apply the same mask in the backward pass.
+ */
+BOOST_AUTO_TEST_CASE(DropoutLayerMaskTest)
+{
+  DropoutLayer<> dropoutLayer(0.3);
+  dropoutLayer.Deterministic() = false;
+
+  const arma::mat input = arma::randu<arma::mat>(100, 70) + 1.0;
+  arma::mat output;
+  dropoutLayer.Forward(input, output);
+
+  const arma::mat gy = arma::randu<arma::mat>(100, 70);
+  arma::mat g;
+  dropoutLayer.Backward(input, gy, g);
+
+  BOOST_REQUIRE_EQUAL(output.n_rows, input.n_rows);
+  BOOST_REQUIRE_EQUAL(output.n_cols, input.n_cols);
+  BOOST_REQUIRE_EQUAL(g.n_elem, gy.n_elem);
+
+  size_t dropped = 0;
+  for (size_t i = 0; i < input.n_elem; ++i)
+  {
+    if (output[i] == 0.0)
+    {
+      ++dropped;
+      BOOST_REQUIRE_EQUAL(g[i], 0.0);
+    }
+    else
+    {
+      BOOST_REQUIRE_CLOSE(output[i], input[i] / 0.7, 1e-10);
+      BOOST_REQUIRE_CLOSE(g[i], gy[i] / 0.7, 1e-10);
+    }
+  }
+  BOOST_REQUIRE_CLOSE((double) dropped / input.n_elem, 0.3, 10.0);
+
+  // A new mask is drawn for each forward pass.
+  arma::mat secondOutput;
+  dropoutLayer.Forward(input, secondOutput);
+  BOOST_REQUIRE_GT(arma::accu(arma::abs(secondOutput - output)), 0.0);
+
+  // The same holds for 3rd order tensors.
+  DropoutLayer2D<> dropoutLayer2D(0.3);
+  dropoutLayer2D.Deterministic() = false;
+  const arma::cube inputCube = arma::randu<arma::cube>(10, 10, 20) + 1.0;
+  arma::cube outputCube;
+  dropoutLayer2D.Forward(inputCube, outputCube);
+  BOOST_REQUIRE_EQUAL(outputCube.n_slices, 20);
+
+  dropped = 0;
+  for (size_t i = 0; i < inputCube.n_elem; ++i)
+  {
+    if (outputCube[i] == 0.0)
+      ++dropped;
+    else
+      BOOST_REQUIRE_CLOSE(outputCube[i], inputCube[i] / 0.7, 1e-10);
+  }
+  BOOST_REQUIRE_CLOSE((double) dropped / inputCube.n_elem, 0.3, 10.0);
+}
+
 /**
  * Train the dropout network on a larger dataset.
  */
@@ -332,6 +404,33 @@ BOOST_AUTO_TEST_CASE(VanillaNetworkConvergenceTest)
       (input, labels, input, labels, 4, 5000, 0, 0.01);
 }
 
+/**
+ * Train the network in single precision until the validation error converge.
+ * The weights, gradients and optimizer state are all single precision.
+ */
+BOOST_AUTO_TEST_CASE(SinglePrecisionNetworkConvergenceTest)
+{
+  arma::fmat input;
+  arma::fmat labels;
+
+  // Test on a non-linearly separable dataset (XOR).
+  input << 0 << 1 << 1 << 0 << arma::endr
+        << 1 << 0 << 1 << 0 << arma::endr;
+  labels << 0 << 0 << 1 << 1;
+
+  // Vanilla neural net with logistic activation function.
+  BuildVanillaNetwork<LogisticFunction,
+                      BinaryClassificationLayer,
+                      MeanSquaredErrorFunction>
+      (input, labels, input, labels, 4, 5000, 0, 0.01);
+
+  // Vanilla neural net with tanh activation function.
+  BuildVanillaNetwork<TanhFunction,
+                      BinaryClassificationLayer,
+                      MeanSquaredErrorFunction>
+      (input, labels, input, labels, 4, 5000, 0, 0.01);
+}
+
 /**
  * Train a vanilla network with the specified structure step by step and
  * evaluate the network.
@@ -431,4 +530,706 @@ BOOST_AUTO_TEST_CASE(NetworkDecreasingErrorTest)
       (dataset, labels, dataset, labels, 20, 15);
 }
 
+/**
+ * Feeding a batch of samples through the network at once should give the sum
+ * of the errors and the mean of the gradients of the individual samples.
+ */
+BOOST_AUTO_TEST_CASE(NetworkBatchGradientTest)
+{
+  arma::mat data = arma::randu<arma::mat>(6, 10);
+  arma::mat labels = arma::zeros<arma::mat>(2, 10);
+  for (size_t i = 0; i < 10; ++i)
+    labels(i % 2, i) = 1;
+
+  LinearLayer<> inputLayer(6, 4);
+  BiasLayer<> inputBiasLayer(4);
+  BaseLayer<LogisticFunction> inputBaseLayer;
+
+  LinearLayer<> hiddenLayer1(4, 2);
+  BiasLayer<> hiddenBiasLayer1(2);
+  BaseLayer<LogisticFunction> outputLayer;
+
+  BinaryClassificationLayer classOutputLayer;
+
+  auto modules = std::tie(inputLayer, inputBiasLayer, inputBaseLayer,
+                          hiddenLayer1, hiddenBiasLayer1, outputLayer);
+
+  FFN<decltype(modules), decltype(classOutputLayer), MeanSquaredErrorFunction>
+      net(modules, classOutputLayer);
+
+  // Run each sample on its own, and average the gradients.
+  arma::mat error;
+  double pointErrors = 0;
+  arma::mat inputGradient = arma::zeros<arma::mat>(4, 6);
+  arma::mat inputBiasGradient = arma::zeros<arma::mat>(4, 1);
+  arma::mat hiddenGradient = arma::zeros<arma::mat>(2, 4);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    const arma::mat point = data.col(i);
+    const arma::mat target = labels.col(i);
+    pointErrors += net.Evaluate(point, target, error);
+    net.FeedBackward(point, error);
+
+    inputGradient += inputLayer.Gradient() / data.n_cols;
+    inputBiasGradient += inputBiasLayer.Gradient() / data.n_cols;
+    hiddenGradient += hiddenLayer1.Gradient() / data.n_cols;
+  }
+
+  // Now run the whole batch at once.
+  BOOST_REQUIRE_CLOSE(net.Evaluate(data, labels, error), pointErrors, 1e-8);
+  net.FeedBackward(data, error);
+
+  for (size_t j = 0; j < inputGradient.n_elem; ++j)
+    BOOST_REQUIRE_SMALL(inputLayer.Gradient()[j] - inputGradient[j], 1e-10);
+  for (size_t j = 0; j < inputBiasGradient.n_elem; ++j)
+    BOOST_REQUIRE_SMALL(inputBiasLayer.Gradient()[j] - inputBiasGradient[j],
+        1e-10);
+  for (size_t j = 0; j < hiddenGradient.n_elem; ++j)
+    BOOST_REQUIRE_SMALL(hiddenLayer1.Gradient()[j] - hiddenGradient[j], 1e-10);
+
+  // The predictions of the batch should be those of the individual samples.
+  arma::mat prediction, pointPrediction;
+  net.Predict(data, prediction);
+  BOOST_REQUIRE_EQUAL(prediction.n_cols, data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    const arma::mat point = data.col(i);
+    net.Predict(point, pointPrediction);
+    for (size_t j = 0; j < pointPrediction.n_elem; ++j)
+      BOOST_REQUIRE_EQUAL(prediction(j, i), pointPrediction[j]);
+  }
+}
+
+/**
+ * The layers keep their activation, delta, and gradient buffers between
+ * iterations, so a second batch of the same size should not need any new
+ * memory for them.
+ */
+BOOST_AUTO_TEST_CASE(NetworkBufferReuseTest)
+{
+  arma::mat labels = arma::zeros<arma::mat>(2, 20);
+  for (size_t i = 0; i < 20; ++i)
+    labels(i % 2, i) = 1;
+
+  LinearLayer<> inputLayer(6, 8);
+  BiasLayer<> inputBiasLayer(8);
+  BaseLayer<LogisticFunction> inputBaseLayer;
+
+  LinearLayer<> hiddenLayer1(8, 2);
+  BiasLayer<> hiddenBiasLayer1(2);
+  BaseLayer<LogisticFunction> outputLayer;
+
+  BinaryClassificationLayer classOutputLayer;
+
+  auto modules = std::tie(inputLayer, inputBiasLayer, inputBaseLayer,
+                          hiddenLayer1, hiddenBiasLayer1, outputLayer);
+
+  FFN<decltype(modules), decltype(classOutputLayer), MeanSquaredErrorFunction>
+      net(modules, classOutputLayer);
+
+  arma::mat error;
+  arma::mat data = arma::randu<arma::mat>(6, 20);
+  net.Evaluate(data, labels, error);
+  net.FeedBackward(data, error);
+
+  const double* inputOutput = inputLayer.OutputParameter().memptr();
+  const double* inputBiasOutput = inputBiasLayer.OutputParameter().memptr();
+  const double* inputBaseOutput = inputBaseLayer.OutputParameter().memptr();
+  const double* inputBaseDelta = inputBaseLayer.Delta().memptr();
+  const double* inputGradient = inputLayer.Gradient().memptr();
+  const double* hiddenDelta = hiddenLayer1.Delta().memptr();
+  const double* hiddenGradient = hiddenLayer1.Gradient().memptr();
+
+  data.randu();
+  net.Evaluate(data, labels, error);
+  net.FeedBackward(data, error);
+
+  BOOST_REQUIRE_EQUAL(inputLayer.OutputParameter().memptr(), inputOutput);
+  BOOST_REQUIRE_EQUAL(inputBiasLayer.OutputParameter().memptr(),
+      inputBiasOutput);
+  BOOST_REQUIRE_EQUAL(inputBaseLayer.OutputParameter().memptr(),
+      inputBaseOutput);
+  BOOST_REQUIRE_EQUAL(inputBaseLayer.Delta().memptr(), inputBaseDelta);
+  BOOST_REQUIRE_EQUAL(inputLayer.Gradient().memptr(), inputGradient);
+  BOOST_REQUIRE_EQUAL(hiddenLayer1.Delta().memptr(), hiddenDelta);
+  BOOST_REQUIRE_EQUAL(hiddenLayer1.Gradient().memptr(), hiddenGradient);
+}
+
+/**
+ * Training with batches of samples should still decrease the error.
+ */
+BOOST_AUTO_TEST_CASE(NetworkBatchTrainingTest)
+{
+  arma::mat dataset;
+  dataset.load("mnist_first250_training_4s_and_9s.arm");
+
+  // Normalize each point since these are images.
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    dataset.col(i) /= norm(dataset.col(i), 2);
+
+  arma::mat labels = arma::zeros(1, dataset.n_cols);
+  labels.submat(0, labels.n_cols / 2, 0, labels.n_cols - 1) += 1;
+
+  LinearLayer<> inputLayer(dataset.n_rows, 20);
+  BiasLayer<> inputBiasLayer(20);
+  BaseLayer<LogisticFunction> inputBaseLayer;
+
+  LinearLayer<> hiddenLayer1(20, labels.n_rows);
+  BiasLayer<> hiddenBiasLayer1(labels.n_rows);
+  BaseLayer<LogisticFunction> outputLayer;
+
+  BinaryClassificationLayer classOutputLayer;
+
+  auto modules = std::tie(inputLayer, inputBiasLayer, inputBaseLayer,
+                          hiddenLayer1, hiddenBiasLayer1, outputLayer);
+
+  FFN<decltype(modules), decltype(classOutputLayer), MeanSquaredErrorFunction>
+      net(modules, classOutputLayer);
+
+  // The number of samples is not a multiple of the batch size, so the last
+  // batch is smaller.
+  Trainer<decltype(net)> trainer(net, 1, 16, 0, true);
+
+  trainer.Train(dataset, labels, dataset, labels);
+  const double initialError = trainer.ValidationError();
+  for (size_t i = 0; i < 20; ++i)
+    trainer.Train(dataset, labels, dataset, labels);
+
+  BOOST_REQUIRE_LT(trainer.ValidationError(), initialError);
+}
+
+/**
+ * A small feed forward network which owns its layers, so that several
+ * networks of the same type can be built.
+ */
+template<
+    template<typename, typename> class OptimizerType,
+    typename ParameterType
+>
+struct ParameterNetwork
+{
+  typedef std::tuple<LinearLayer<OptimizerType>&, BiasLayer<OptimizerType>&,
+      BaseLayer<LogisticFunction>&, LinearLayer<OptimizerType>&,
+      BiasLayer<OptimizerType>&, BaseLayer<LogisticFunction>&> Modules;
+  typedef FFN<Modules, BinaryClassificationLayer, MeanSquaredErrorFunction,
+      ParameterType> NetworkType;
+
+  ParameterNetwork(const size_t inSize, const size_t outSize) :
+      inputLayer(inSize, 4),
+      inputBiasLayer(4),
+      hiddenLayer1(4, outSize),
+      hiddenBiasLayer1(outSize),
+      net(Modules(inputLayer, inputBiasLayer, inputBaseLayer, hiddenLayer1,
+          hiddenBiasLayer1, outputLayer), classOutputLayer)
+  { }
+
+  LinearLayer<OptimizerType> inputLayer;
+  BiasLayer<OptimizerType> inputBiasLayer;
+  BaseLayer<LogisticFunction> inputBaseLayer;
+  LinearLayer<OptimizerType> hiddenLayer1;
+  BiasLayer<OptimizerType> hiddenBiasLayer1;
+  BaseLayer<LogisticFunction> outputLayer;
+  BinaryClassificationLayer classOutputLayer;
+  NetworkType net;
+};
+
+typedef ParameterNetwork<RMSPROP, LayerParameters> ReplicaNetwork;
+
+/**
+ * Make sure that the given weights are the same.
+ */
+void CheckWeights(const arma::mat& weights, const arma::mat& expected)
+{
+  BOOST_REQUIRE_EQUAL(weights.n_elem, expected.n_elem);
+  for (size_t i = 0; i < weights.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(weights[i] - expected[i], 1e-8);
+}
+
+/**
+ * Training with replicas of the network, which compute the gradients of the
+ * shards of each batch, should take the same steps as training without them.
+ */
+BOOST_AUTO_TEST_CASE(NetworkReplicaTrainingTest)
+{
+  arma::mat data = arma::randu<arma::mat>(6, 50);
+  arma::mat labels = arma::zeros(1, 50);
+  labels.submat(0, 25, 0, 49).ones();
+
+  ReplicaNetwork reference(6, 1), network(6, 1);
+  network.net.CopyWeights(reference.net);
+
+  // Three replicas split a batch of 10 samples into shards of 4, 4 and 2
+  // samples.
+  ReplicaNetwork replica0(6, 1), replica1(6, 1), replica2(6, 1);
+  std::vector<ReplicaNetwork::NetworkType*> replicas;
+  replicas.push_back(&replica0.net);
+  replicas.push_back(&replica1.net);
+  replicas.push_back(&replica2.net);
+
+  Trainer<ReplicaNetwork::NetworkType> referenceTrainer(reference.net, 1, 10,
+      0, false);
+  Trainer<ReplicaNetwork::NetworkType> trainer(network.net, 1, 10, 0, false,
+      0, replicas);
+
+  for (size_t i = 0; i < 5; ++i)
+  {
+    referenceTrainer.Train(data, labels, data, labels);
+    trainer.Train(data, labels, data, labels);
+
+    BOOST_REQUIRE_CLOSE(trainer.TrainingError(),
+        referenceTrainer.TrainingError(), 1e-5);
+  }
+
+  CheckWeights(network.inputLayer.Weights(), reference.inputLayer.Weights());
+  CheckWeights(network.inputBiasLayer.Weights(),
+      reference.inputBiasLayer.Weights());
+  CheckWeights(network.hiddenLayer1.Weights(),
+      reference.hiddenLayer1.Weights());
+  CheckWeights(network.hiddenBiasLayer1.Weights(),
+      reference.hiddenBiasLayer1.Weights());
+}
+
+/**
+ * Training on a dataset read from disk in chunks should take the same steps as
+ * training on the dataset in memory, when the samples are not shuffled and
+ * the batches line up with the chunks.
+ */
+BOOST_AUTO_TEST_CASE(NetworkChunkedTrainingTest)
+{
+  arma::mat data = arma::randu<arma::mat>(6, 50);
+  arma::mat labels = arma::zeros(1, 50);
+  labels.submat(0, 25, 0, 49).ones();
+
+  // The labels are stored as the last dimension of each point.
+  arma::mat dataset = arma::join_cols(data, labels);
+  BOOST_REQUIRE(dataset.save("trainer_chunked_test.bin", arma::arma_binary));
+
+  ReplicaNetwork reference(6, 1), network(6, 1);
+  network.net.CopyWeights(reference.net);
+
+  Trainer<ReplicaNetwork::NetworkType> referenceTrainer(reference.net, 3, 5,
+      0, false);
+  Trainer<ReplicaNetwork::NetworkType> trainer(network.net, 3, 5, 0, false);
+
+  {
+    // Chunks of 20, 20 and 10 samples.
+    data::ChunkedReader reader("trainer_chunked_test.bin", 20);
+
+    // The labels have to leave some dimensions for the input.
+    BOOST_REQUIRE_THROW(trainer.Train(reader, 7, data, labels),
+        std::invalid_argument);
+
+    referenceTrainer.Train(data, labels, data, labels);
+    trainer.Train(reader, 1, data, labels);
+  }
+
+  BOOST_REQUIRE_CLOSE(trainer.TrainingError(),
+      referenceTrainer.TrainingError(), 1e-5);
+  BOOST_REQUIRE_CLOSE(trainer.ValidationError(),
+      referenceTrainer.ValidationError(), 1e-5);
+
+  CheckWeights(network.inputLayer.Weights(), reference.inputLayer.Weights());
+  CheckWeights(network.hiddenLayer1.Weights(),
+      reference.hiddenLayer1.Weights());
+
+  remove("trainer_chunked_test.bin");
+}
+
+/**
+ * Make sure that the weights written by SaveWeights() are restored by
+ * LoadWeights(), and that a file which does not match the network is rejected.
+ */
+BOOST_AUTO_TEST_CASE(NetworkWeightBlobTest)
+{
+  ReplicaNetwork network(6, 1), loaded(6, 1);
+  network.net.SaveWeights("ffn_weights_test.bin");
+  loaded.net.LoadWeights("ffn_weights_test.bin");
+
+  CheckWeights(loaded.inputLayer.Weights(), network.inputLayer.Weights());
+  CheckWeights(loaded.inputBiasLayer.Weights(),
+      network.inputBiasLayer.Weights());
+  CheckWeights(loaded.hiddenLayer1.Weights(), network.hiddenLayer1.Weights());
+  CheckWeights(loaded.hiddenBiasLayer1.Weights(),
+      network.hiddenBiasLayer1.Weights());
+
+  // A network with a different number of inputs can't load the weights.
+  ReplicaNetwork other(5, 1);
+  BOOST_REQUIRE_THROW(other.net.LoadWeights("ffn_weights_test.bin"),
+      std::runtime_error);
+
+  remove("ffn_weights_test.bin");
+}
+
+/**
+ * Make sure that a network can be serialized and loaded into a network with
+ * the same structure.
+ */
+BOOST_AUTO_TEST_CASE(NetworkSerializationTest)
+{
+  ReplicaNetwork network(6, 1), loaded(6, 1);
+
+  {
+    std::ofstream ofs("ffn_serialization_test.xml");
+    boost::archive::xml_oarchive o(ofs);
+    o << data::CreateNVP(network.net, "network");
+  }
+
+  {
+    std::ifstream ifs("ffn_serialization_test.xml");
+    boost::archive::xml_iarchive i(ifs);
+    i >> data::CreateNVP(loaded.net, "network");
+  }
+
+  CheckWeights(loaded.inputLayer.Weights(), network.inputLayer.Weights());
+  CheckWeights(loaded.inputBiasLayer.Weights(),
+      network.inputBiasLayer.Weights());
+  CheckWeights(loaded.hiddenLayer1.Weights(), network.hiddenLayer1.Weights());
+  CheckWeights(loaded.hiddenBiasLayer1.Weights(),
+      network.hiddenBiasLayer1.Weights());
+
+  remove("ffn_serialization_test.xml");
+}
+
+/**
+ * The embedding layer should compute the same output as a linear layer on the
+ * one-hot encoding of each position of its input, and the columns of its
+ * gradient should be the nonzero columns of the gradient of that linear layer.
+ */
+BOOST_AUTO_TEST_CASE(EmbeddingLayerTest)
+{
+  arma::mat ids("2 0 7 2; 5 2 9 0");
+
+  EmbeddingLayer<> embedding(10, 3);
+  embedding.InputParameter() = ids;
+
+  arma::mat output;
+  embedding.Forward(ids, output);
+  BOOST_REQUIRE_EQUAL(output.n_rows, 6);
+  BOOST_REQUIRE_EQUAL(output.n_cols, 4);
+
+  arma::mat delta = arma::randu<arma::mat>(6, 4);
+  embedding.Gradient(delta, embedding.Gradient());
+
+  arma::mat expectedGradient = arma::zeros<arma::mat>(3, 10);
+  for (size_t j = 0; j < ids.n_rows; ++j)
+  {
+    arma::mat oneHot = arma::zeros<arma::mat>(10, ids.n_cols);
+    for (size_t i = 0; i < ids.n_cols; ++i)
+      oneHot((size_t) ids(j, i), i) = 1;
+
+    const arma::mat expected = embedding.Weights() * oneHot;
+    for (size_t i = 0; i < expected.n_elem; ++i)
+    {
+      BOOST_REQUIRE_CLOSE(output.rows(3 * j, 3 * j + 2)[i], expected[i],
+          1e-10);
+    }
+
+    expectedGradient += delta.rows(3 * j, 3 * j + 2) * oneHot.t() /
+        ids.n_cols;
+  }
+
+  // Only the ids 0, 2, 5, 7 and 9 are in the batch.
+  const arma::uvec& indices = embedding.GradientIndices();
+  BOOST_REQUIRE_EQUAL(indices.n_elem, 5);
+  BOOST_REQUIRE_EQUAL(indices[0], 0);
+  BOOST_REQUIRE_EQUAL(indices[1], 2);
+  BOOST_REQUIRE_EQUAL(indices[2], 5);
+  BOOST_REQUIRE_EQUAL(indices[3], 7);
+  BOOST_REQUIRE_EQUAL(indices[4], 9);
+
+  BOOST_REQUIRE_EQUAL(embedding.Gradient().n_cols, 5);
+  for (size_t i = 0; i < indices.n_elem; ++i)
+  {
+    for (size_t k = 0; k < 3; ++k)
+    {
+      BOOST_REQUIRE_CLOSE(embedding.Gradient()(k, i),
+          expectedGradient(k, indices[i]), 1e-10);
+    }
+  }
+
+  // Ids outside the vocabulary are an error.
+  arma::mat badIds("3 10");
+  BOOST_REQUIRE_THROW(embedding.Forward(badIds, output),
+      std::invalid_argument);
+}
+
+/**
+ * With a sparse input, the embedding layer should compute the same output and
+ * gradient as a linear layer.
+ */
+BOOST_AUTO_TEST_CASE(SparseEmbeddingLayerTest)
+{
+  arma::sp_mat data = arma::sprandu<arma::sp_mat>(10, 5, 0.3);
+
+  EmbeddingLayer<RMSPROP, RandomInitialization, arma::sp_mat> embedding(10, 3);
+  embedding.InputParameter() = data;
+
+  arma::mat output;
+  embedding.Forward(data, output);
+
+  const arma::mat expected = embedding.Weights() * arma::mat(data);
+  BOOST_REQUIRE_EQUAL(output.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(output.n_cols, 5);
+  for (size_t i = 0; i < expected.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(output[i] - expected[i], 1e-10);
+
+  arma::mat delta = arma::randu<arma::mat>(3, 5);
+  embedding.Gradient(delta, embedding.Gradient());
+
+  const arma::mat expectedGradient = delta * arma::mat(data).t() / 5;
+  const arma::uvec& indices = embedding.GradientIndices();
+  BOOST_REQUIRE_EQUAL(embedding.Gradient().n_cols, indices.n_elem);
+
+  // The columns of the ids that are not in the batch have zero gradient.
+  size_t column = 0;
+  for (size_t id = 0; id < 10; ++id)
+  {
+    if (column < indices.n_elem && indices[column] == id)
+    {
+      for (size_t k = 0; k < 3; ++k)
+      {
+        BOOST_REQUIRE_SMALL(embedding.Gradient()(k, column) -
+            expectedGradient(k, id), 1e-10);
+      }
+      ++column;
+    }
+    else
+    {
+      for (size_t k = 0; k < 3; ++k)
+        BOOST_REQUIRE_SMALL(expectedGradient(k, id), 1e-10);
+    }
+  }
+  BOOST_REQUIRE_EQUAL(column, indices.n_elem);
+}
+
+/**
+ * Train a network whose first layer is an embedding layer, and the same
+ * network with a linear layer on one-hot encoded inputs, for a few steps of the
+ * given optimizer; the weights should stay the same.  The sparse update leaves
+ * the moments of the ids that are not in the batch alone, so the batch is the
+ * same in every step.
+ */
+template<template<typename, typename> class OptimizerType>
+void CompareEmbeddingNetwork()
+{
+  arma::mat ids("1 4 4 8 0 1");
+  arma::mat oneHot = arma::zeros<arma::mat>(10, ids.n_cols);
+  for (size_t i = 0; i < ids.n_cols; ++i)
+    oneHot((size_t) ids[i], i) = 1;
+  arma::mat labels("0 1 1 0 1 0");
+
+  EmbeddingLayer<OptimizerType> embedding(10, 3);
+  LinearLayer<OptimizerType> hiddenLayer(3, 1);
+  BaseLayer<LogisticFunction> outputLayer;
+  BinaryClassificationLayer classOutputLayer;
+
+  auto modules = std::tie(embedding, hiddenLayer, outputLayer);
+  FFN<decltype(modules), decltype(classOutputLayer), MeanSquaredErrorFunction>
+      net(modules, classOutputLayer);
+
+  LinearLayer<OptimizerType> oneHotLayer(10, 3);
+  LinearLayer<OptimizerType> oneHotHiddenLayer(3, 1);
+  BaseLayer<LogisticFunction> oneHotOutputLayer;
+  BinaryClassificationLayer oneHotClassOutputLayer;
+
+  auto oneHotModules = std::tie(oneHotLayer, oneHotHiddenLayer,
+                                oneHotOutputLayer);
+  FFN<decltype(oneHotModules), decltype(oneHotClassOutputLayer),
+      MeanSquaredErrorFunction> oneHotNet(oneHotModules,
+      oneHotClassOutputLayer);
+
+  oneHotLayer.Weights() = embedding.Weights();
+  oneHotHiddenLayer.Weights() = hiddenLayer.Weights();
+
+  arma::mat error, oneHotError;
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(net.Evaluate(ids, labels, error),
+        oneHotNet.Evaluate(oneHot, labels, oneHotError), 1e-8);
+    net.FeedBackward(ids, error);
+    net.ApplyGradients();
+    oneHotNet.FeedBackward(oneHot, oneHotError);
+    oneHotNet.ApplyGradients();
+
+    CheckWeights(embedding.Weights(), oneHotLayer.Weights());
+    CheckWeights(hiddenLayer.Weights(), oneHotHiddenLayer.Weights());
+  }
+
+  // The vectors of the ids that are not in the batch were not changed.
+  arma::mat original = embedding.Weights();
+  net.Evaluate(ids, labels, error);
+  net.FeedBackward(ids, error);
+  net.ApplyGradients();
+  BOOST_REQUIRE_EQUAL(embedding.Weights().n_cols, 10);
+  for (size_t k = 0; k < 3; ++k)
+    BOOST_REQUIRE_EQUAL(embedding.Weights()(k, 3), original(k, 3));
+}
+
+BOOST_AUTO_TEST_CASE(EmbeddingNetworkTest)
+{
+  CompareEmbeddingNetwork<RMSPROP>();
+  CompareEmbeddingNetwork<Adam>();
+}
+
+/**
+ * Copy the weights of the layers of a ParameterNetwork into another one,
+ * whose parameter policy may be different.
+ */
+template<typename NetworkType, typename OtherNetworkType>
+void CopyLayerWeights(NetworkType& network, const OtherNetworkType& other)
+{
+  network.inputLayer.Weights() = other.inputLayer.Weights();
+  network.inputBiasLayer.Weights() = other.inputBiasLayer.Weights();
+  network.hiddenLayer1.Weights() = other.hiddenLayer1.Weights();
+  network.hiddenBiasLayer1.Weights() = other.hiddenBiasLayer1.Weights();
+}
+
+/**
+ * Make sure that the layers of the two given ParameterNetworks have the same
+ * weights.
+ */
+template<typename NetworkType, typename OtherNetworkType>
+void CheckLayerWeights(const NetworkType& network,
+                       const OtherNetworkType& other)
+{
+  CheckWeights(network.inputLayer.Weights(), other.inputLayer.Weights());
+  CheckWeights(network.inputBiasLayer.Weights(),
+      other.inputBiasLayer.Weights());
+  CheckWeights(network.hiddenLayer1.Weights(), other.hiddenLayer1.Weights());
+  CheckWeights(network.hiddenBiasLayer1.Weights(),
+      other.hiddenBiasLayer1.Weights());
+}
+
+/**
+ * A network whose parameters are kept in one buffer should take the same
+ * steps as the network whose layers are updated by their own optimizers.
+ */
+template<template<typename, typename> class OptimizerType>
+void CompareFlatParameters()
+{
+  arma::mat data = arma::randu<arma::mat>(6, 20);
+  arma::mat labels = arma::zeros(1, 20);
+  labels.submat(0, 10, 0, 19).ones();
+
+  ParameterNetwork<OptimizerType, LayerParameters> reference(6, 1);
+  ParameterNetwork<OptimizerType, FlatParameters<OptimizerType> > flat(6, 1);
+  CopyLayerWeights(flat, reference);
+
+  // The weights of the layers are views into the buffer, each padded to a
+  // multiple of 8 elements: 24 weights of the first layer, 4 of the first bias
+  // layer, and 4 and 1 of the others.
+  const arma::mat& parameters = flat.net.Parameters().Weights();
+  BOOST_REQUIRE_EQUAL(parameters.n_elem, 48);
+  BOOST_REQUIRE_EQUAL(flat.inputLayer.Weights().memptr(),
+      parameters.memptr());
+  BOOST_REQUIRE_EQUAL(flat.inputBiasLayer.Weights().memptr(),
+      parameters.memptr() + 24);
+  BOOST_REQUIRE_EQUAL(flat.hiddenLayer1.Weights().memptr(),
+      parameters.memptr() + 32);
+  BOOST_REQUIRE_EQUAL(flat.hiddenBiasLayer1.Weights().memptr(),
+      parameters.memptr() + 40);
+  BOOST_REQUIRE_EQUAL(flat.inputLayer.Gradient().memptr(),
+      flat.net.Parameters().Gradient().memptr());
+
+  arma::mat error, flatError;
+  for (size_t i = 0; i < 5; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(flat.net.Evaluate(data, labels, flatError),
+        reference.net.Evaluate(data, labels, error), 1e-8);
+    reference.net.FeedBackward(data, error);
+    reference.net.ApplyGradients();
+    flat.net.FeedBackward(data, flatError);
+    flat.net.ApplyGradients();
+
+    CheckLayerWeights(flat, reference);
+  }
+
+  // The padding of the buffer is never changed.
+  for (size_t i = 28; i < 32; ++i)
+    BOOST_REQUIRE_EQUAL(parameters[i], 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(FlatParametersTest)
+{
+  CompareFlatParameters<RMSPROP>();
+  CompareFlatParameters<Adam>();
+}
+
+/**
+ * Training with replicas of a network whose parameters are kept in one buffer
+ * should take the same steps as training the network on its own.
+ */
+BOOST_AUTO_TEST_CASE(FlatParametersReplicaTrainingTest)
+{
+  typedef ParameterNetwork<RMSPROP, FlatParameters<> > FlatNetwork;
+
+  arma::mat data = arma::randu<arma::mat>(6, 50);
+  arma::mat labels = arma::zeros(1, 50);
+  labels.submat(0, 25, 0, 49).ones();
+
+  ReplicaNetwork reference(6, 1);
+  FlatNetwork network(6, 1);
+  CopyLayerWeights(network, reference);
+
+  FlatNetwork replica0(6, 1), replica1(6, 1), replica2(6, 1);
+  std::vector<FlatNetwork::NetworkType*> replicas;
+  replicas.push_back(&replica0.net);
+  replicas.push_back(&replica1.net);
+  replicas.push_back(&replica2.net);
+
+  Trainer<ReplicaNetwork::NetworkType> referenceTrainer(reference.net, 1, 10,
+      0, false);
+  Trainer<FlatNetwork::NetworkType> trainer(network.net, 1, 10, 0, false, 0,
+      replicas);
+
+  for (size_t i = 0; i < 5; ++i)
+  {
+    referenceTrainer.Train(data, labels, data, labels);
+    trainer.Train(data, labels, data, labels);
+
+    BOOST_REQUIRE_CLOSE(trainer.TrainingError(),
+        referenceTrainer.TrainingError(), 1e-5);
+  }
+
+  CheckLayerWeights(network, reference);
+}
+
+/**
+ * When a network with flat parameters is destroyed, its layers should get
+ * their own weights back.
+ */
+BOOST_AUTO_TEST_CASE(FlatParametersReleaseTest)
+{
+  LinearLayer<> inputLayer(6, 4);
+  BiasLayer<> inputBiasLayer(4);
+  BaseLayer<LogisticFunction> outputLayer;
+  BinaryClassificationLayer classOutputLayer;
+
+  arma::mat data = arma::randu<arma::mat>(6, 10);
+  arma::mat labels = arma::randu<arma::mat>(4, 10);
+
+  arma::mat weights, biasWeights;
+  {
+    auto modules = std::tie(inputLayer, inputBiasLayer, outputLayer);
+    FFN<decltype(modules), decltype(classOutputLayer),
+        MeanSquaredErrorFunction, FlatParameters<> > net(modules,
+        classOutputLayer);
+
+    arma::mat error;
+    net.Evaluate(data, labels, error);
+    net.FeedBackward(data, error);
+    net.ApplyGradients();
+
+    weights = inputLayer.Weights();
+    biasWeights = inputBiasLayer.Weights();
+  }
+
+  CheckWeights(inputLayer.Weights(), weights);
+  CheckWeights(inputBiasLayer.Weights(), biasWeights);
+
+  // The weights own their memory again, so they can be resized.
+  inputLayer.Weights().set_size(3, 3);
+  BOOST_REQUIRE_EQUAL(inputLayer.Weights().n_elem, 9);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
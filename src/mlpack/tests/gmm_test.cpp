@@ -13,6 +13,7 @@
 #include <mlpack/methods/gmm/positive_definite_constraint.hpp>
 #include <mlpack/methods/gmm/diagonal_constraint.hpp>
 #include <mlpack/methods/gmm/eigenvalue_ratio_constraint.hpp>
+#include <mlpack/methods/gmm/online_em_fit.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -773,5 +774,275 @@ BOOST_AUTO_TEST_CASE(UseExistingModelTest)
   }
 }
 
+/**
+ * Make sure that one iteration of EMFit (whose E-step and M-step work on
+ * blocks of observations, across threads) gives the same model as the
+ * textbook EM update.
+ */
+BOOST_AUTO_TEST_CASE(EMFitIterationTest)
+{
+  // Use a number of points that is not a multiple of the block size.
+  arma::mat data(3, 2500);
+  data.randn();
+  data.cols(0, 999) += 5.0;
+
+  std::vector<distribution::GaussianDistribution> dists;
+  dists.push_back(distribution::GaussianDistribution(
+      arma::vec("5 5 5"), arma::eye<arma::mat>(3, 3)));
+  dists.push_back(distribution::GaussianDistribution(
+      arma::vec("1 0 -1"), 2.0 * arma::eye<arma::mat>(3, 3)));
+  arma::vec weights("0.5 0.5");
+
+  // Compute the update by hand.
+  arma::mat condProb(data.n_cols, dists.size());
+  for (size_t j = 0; j < data.n_cols; ++j)
+  {
+    for (size_t i = 0; i < dists.size(); ++i)
+      condProb(j, i) = weights[i] * dists[i].Probability(data.col(j));
+    condProb.row(j) /= accu(condProb.row(j));
+  }
+
+  std::vector<arma::vec> means(dists.size());
+  std::vector<arma::mat> covariances(dists.size());
+  arma::vec newWeights(dists.size());
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    const double sum = accu(condProb.col(i));
+    means[i] = data * condProb.col(i) / sum;
+    covariances[i].zeros(3, 3);
+    for (size_t j = 0; j < data.n_cols; ++j)
+      covariances[i] += condProb(j, i) * (data.col(j) - means[i]) *
+          trans(data.col(j) - means[i]);
+    covariances[i] /= sum;
+    newWeights[i] = sum / data.n_cols;
+  }
+
+  // A maximum of two iterations means that one update is done.
+  EMFit<kmeans::KMeans<>, NoConstraint> em(2);
+  em.Estimate(data, dists, weights, true);
+
+  for (size_t i = 0; i < dists.size(); ++i)
+  {
+    BOOST_REQUIRE_CLOSE(weights[i], newWeights[i], 1e-5);
+    for (size_t j = 0; j < 3; ++j)
+    {
+      BOOST_REQUIRE_CLOSE(dists[i].Mean()[j], means[i][j], 1e-5);
+      for (size_t k = 0; k < 3; ++k)
+        BOOST_REQUIRE_CLOSE(dists[i].Covariance()(j, k), covariances[i](j, k),
+            1e-5);
+    }
+  }
+}
+
+/**
+ * Train a DiagonalGMM on data drawn from two well-separated diagonal Gaussians
+ * and make sure the model is recovered.
+ */
+BOOST_AUTO_TEST_CASE(DiagonalGMMTrainTest)
+{
+  arma::mat data(5, 6000);
+  data.randn();
+  const arma::vec stddevs("1.0 2.0 0.5 1.5 1.0");
+  data.each_col() %= stddevs;
+  data.cols(0, 1999) += 15.0;
+
+  DiagonalGMM gmm(2, 5);
+  gmm.Estimate(data);
+
+  // Figure out which component is the shifted one.
+  const size_t shifted = (gmm.Component(0).Mean()[0] > 7.5) ? 0 : 1;
+  const size_t centered = 1 - shifted;
+
+  BOOST_REQUIRE_CLOSE(gmm.Weights()[shifted], 1.0 / 3.0, 5.0);
+  BOOST_REQUIRE_CLOSE(gmm.Weights()[centered], 2.0 / 3.0, 5.0);
+  for (size_t i = 0; i < 5; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(gmm.Component(shifted).Mean()[i], 15.0, 2.0);
+    BOOST_REQUIRE_SMALL(gmm.Component(centered).Mean()[i], 0.2);
+
+    const double variance = stddevs[i] * stddevs[i];
+    BOOST_REQUIRE_CLOSE(gmm.Component(shifted).Covariance()[i], variance,
+        10.0);
+    BOOST_REQUIRE_CLOSE(gmm.Component(centered).Covariance()[i], variance,
+        10.0);
+  }
+}
+
+/**
+ * Train a GMM with online EM on a stream of data, given one chunk at a time,
+ * and make sure the model is recovered and the step count carries over.
+ */
+BOOST_AUTO_TEST_CASE(OnlineEMFitStreamTest)
+{
+  // Two Gaussians, with the points of each mixed through the stream.
+  arma::mat data(2, 20000);
+  data.randn();
+  for (size_t i = 0; i < data.n_cols; i += 4)
+    data.col(i) = 0.5 * data.col(i) + arma::vec("8 8");
+
+  GMM<OnlineEMFit<>> gmm(2, 2);
+  gmm.Fitter().BatchSize() = 500;
+
+  // The first chunk starts the model; the rest carry on from it.
+  for (size_t chunk = 0; chunk < 4; ++chunk)
+  {
+    const arma::mat chunkData = data.cols(chunk * 5000,
+        (chunk + 1) * 5000 - 1);
+    gmm.Estimate(chunkData, 1, chunk > 0);
+  }
+
+  BOOST_REQUIRE_EQUAL(gmm.Fitter().Steps(), 40);
+
+  const size_t shifted = (gmm.Component(0).Mean()[0] > 4.0) ? 0 : 1;
+  const size_t centered = 1 - shifted;
+
+  BOOST_REQUIRE_CLOSE(gmm.Weights()[shifted], 0.25, 5.0);
+  BOOST_REQUIRE_CLOSE(gmm.Weights()[centered], 0.75, 5.0);
+  for (size_t i = 0; i < 2; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(gmm.Component(shifted).Mean()[i], 8.0, 2.0);
+    BOOST_REQUIRE_SMALL(gmm.Component(centered).Mean()[i], 0.1);
+    BOOST_REQUIRE_CLOSE(gmm.Component(shifted).Covariance()(i, i), 0.25,
+        15.0);
+    BOOST_REQUIRE_CLOSE(gmm.Component(centered).Covariance()(i, i), 1.0,
+        15.0);
+  }
+}
+
+/**
+ * Trials run in parallel with their own random streams, so training with
+ * several trials after setting the seed should always give the same model.
+ */
+BOOST_AUTO_TEST_CASE(GMMTrialsReproducibleTest)
+{
+  arma::mat data(2, 1000);
+  data.randn();
+  for (size_t i = 0; i < data.n_cols; i += 2)
+    data.col(i) += arma::vec("5 3");
+
+  math::RandomSeed(17);
+  GMM<> first(3, 2);
+  const double firstLikelihood = first.Estimate(data, 4);
+
+  math::RandomSeed(17);
+  GMM<> second(3, 2);
+  const double secondLikelihood = second.Estimate(data, 4);
+
+  BOOST_REQUIRE_CLOSE(firstLikelihood, secondLikelihood, 1e-8);
+  for (size_t g = 0; g < 3; ++g)
+  {
+    BOOST_REQUIRE_CLOSE(first.Weights()[g], second.Weights()[g], 1e-8);
+    for (size_t d = 0; d < 2; ++d)
+      BOOST_REQUIRE_CLOSE(first.Component(g).Mean()[d],
+          second.Component(g).Mean()[d], 1e-8);
+  }
+
+  math::RandomSeed(std::time(NULL));
+}
+
+/**
+ * A reducer that acts as if there were the given number of processes, each
+ * with the same shard; then the results must be those on one shard.
+ */
+class ScaleReducer : public math::Reducer
+{
+ public:
+  ScaleReducer(const size_t copies) : copies(copies) { }
+
+  void Sum(double* values, const size_t n)
+  {
+    for (size_t i = 0; i < n; ++i)
+      values[i] *= copies;
+  }
+
+  void Broadcast(double* /* values */, const size_t /* n */) { }
+
+ private:
+  size_t copies;
+};
+
+/**
+ * Fit the given model to the data with EM, from the given initial model, with
+ * the given reducer (or none).
+ */
+template<typename FitterType, typename DistributionType>
+void FitFromInitialModel(const arma::mat& data,
+                         math::Reducer* reducer,
+                         std::vector<DistributionType>& dists,
+                         arma::vec& weights)
+{
+  FitterType em(20, 0.0);
+  em.Reducer() = reducer;
+  em.Estimate(data, dists, weights, true);
+}
+
+/**
+ * Make sure that EM with a reducer over identical shards fits the same model
+ * as EM on one shard, for both full and diagonal covariances.
+ */
+BOOST_AUTO_TEST_CASE(EMFitReducerTest)
+{
+  arma::mat data(3, 900);
+  data.randn();
+  data.cols(0, 299) += 5.0;
+
+  // The same initial model is used by every fit.
+  GMM<> initial(2, 3);
+  initial.Estimate(data, 1);
+
+  std::vector<distribution::GaussianDistribution> dists;
+  std::vector<distribution::DiagonalGaussianDistribution> diagonalDists;
+  for (size_t g = 0; g < 2; ++g)
+  {
+    dists.push_back(initial.Component(g));
+    diagonalDists.push_back(distribution::DiagonalGaussianDistribution(
+        initial.Component(g).Mean(),
+        arma::diagvec(initial.Component(g).Covariance())));
+  }
+
+  typedef EMFit<> FullFitter;
+  typedef EMFit<kmeans::KMeans<>, PositiveDefiniteConstraint,
+      distribution::DiagonalGaussianDistribution> DiagonalFitter;
+
+  std::vector<distribution::GaussianDistribution> fullDists = dists;
+  arma::vec fullWeights = initial.Weights();
+  FitFromInitialModel<FullFitter>(data, NULL, fullDists, fullWeights);
+  std::vector<distribution::DiagonalGaussianDistribution> diagonalDistsOne =
+      diagonalDists;
+  arma::vec diagonalWeightsOne = initial.Weights();
+  FitFromInitialModel<DiagonalFitter>(data, NULL, diagonalDistsOne,
+      diagonalWeightsOne);
+
+  ScaleReducer reducer(3);
+  std::vector<distribution::GaussianDistribution> reducedDists = dists;
+  arma::vec reducedWeights = initial.Weights();
+  FitFromInitialModel<FullFitter>(data, &reducer, reducedDists,
+      reducedWeights);
+  std::vector<distribution::DiagonalGaussianDistribution>
+      reducedDiagonalDists = diagonalDists;
+  arma::vec reducedDiagonalWeights = initial.Weights();
+  FitFromInitialModel<DiagonalFitter>(data, &reducer, reducedDiagonalDists,
+      reducedDiagonalWeights);
+
+  for (size_t g = 0; g < 2; ++g)
+  {
+    BOOST_REQUIRE_CLOSE(reducedWeights[g], fullWeights[g], 1e-5);
+    BOOST_REQUIRE_CLOSE(reducedDiagonalWeights[g], diagonalWeightsOne[g],
+        1e-5);
+    for (size_t i = 0; i < 3; ++i)
+    {
+      BOOST_REQUIRE_CLOSE(reducedDists[g].Mean()[i], fullDists[g].Mean()[i],
+          1e-5);
+      BOOST_REQUIRE_CLOSE(reducedDiagonalDists[g].Mean()[i],
+          diagonalDistsOne[g].Mean()[i], 1e-5);
+      BOOST_REQUIRE_CLOSE(reducedDiagonalDists[g].Covariance()[i],
+          diagonalDistsOne[g].Covariance()[i], 1e-5);
+    }
+
+    for (size_t i = 0; i < 9; ++i)
+      BOOST_REQUIRE_CLOSE(reducedDists[g].Covariance()[i],
+          fullDists[g].Covariance()[i], 1e-5);
+  }
+}
 
 BOOST_AUTO_TEST_SUITE_END();
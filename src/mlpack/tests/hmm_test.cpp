@@ -98,6 +98,66 @@ BOOST_AUTO_TEST_CASE(BorodovskyHMMTestViterbi)
   BOOST_REQUIRE_EQUAL(states[8], 2);
 }
 
+/**
+ * Make sure that beam-pruned Viterbi decoding on a left-to-right HMM (whose
+ * transition matrix is sparse) gives the exact answer when the beam holds every
+ * state, and never a more probable sequence than exact decoding otherwise.
+ */
+BOOST_AUTO_TEST_CASE(LeftToRightHMMBeamViterbiTest)
+{
+  // Each state either stays or moves to the next one.
+  const size_t states = 20;
+  HMM<DiscreteDistribution> hmm(states, states);
+  hmm.Initial().zeros();
+  hmm.Initial()[0] = 1.0;
+  hmm.Transition().zeros();
+  for (size_t i = 0; i < states - 1; ++i)
+  {
+    hmm.Transition()(i, i) = 0.8;
+    hmm.Transition()(i + 1, i) = 0.2;
+  }
+  hmm.Transition()(states - 1, states - 1) = 1.0;
+
+  // Each state mostly emits its own symbol.
+  for (size_t i = 0; i < states; ++i)
+  {
+    hmm.Emission()[i].Probabilities().fill(0.1 / (states - 1));
+    hmm.Emission()[i].Probabilities()[i] = 0.9;
+  }
+
+  arma::mat observation;
+  arma::Col<size_t> trueStates;
+  hmm.Generate(150, observation, trueStates);
+
+  arma::Col<size_t> exact, full, pruned;
+  const double exactLogLik = hmm.Predict(observation, exact);
+  const double fullLogLik = hmm.Predict(observation, full, states);
+  const double prunedLogLik = hmm.Predict(observation, pruned, 2);
+
+  BOOST_REQUIRE_CLOSE(exactLogLik, fullLogLik, 1e-5);
+  BOOST_REQUIRE_EQUAL(exact.n_elem, observation.n_cols);
+  BOOST_REQUIRE_EQUAL(full.n_elem, observation.n_cols);
+  BOOST_REQUIRE_EQUAL(pruned.n_elem, observation.n_cols);
+  for (size_t t = 0; t < observation.n_cols; ++t)
+    BOOST_REQUIRE_EQUAL(exact[t], full[t]);
+
+  BOOST_REQUIRE_LE(prunedLogLik, exactLogLik + 1e-8);
+
+  // The decoded sequence can't use impossible transitions.
+  BOOST_REQUIRE_EQUAL(pruned[0], 0);
+  for (size_t t = 1; t < observation.n_cols; ++t)
+    BOOST_REQUIRE((pruned[t] == pruned[t - 1]) ||
+                  (pruned[t] == pruned[t - 1] + 1));
+
+  // Training keeps impossible transitions impossible.
+  std::vector<arma::mat> sequences(1, observation);
+  hmm.Train(sequences);
+  for (size_t j = 0; j < states; ++j)
+    for (size_t i = 0; i < states; ++i)
+      if ((i != j) && (i != j + 1))
+        BOOST_REQUIRE_EQUAL(hmm.Transition()(i, j), 0.0);
+}
+
 /**
  * Ensure that the forward-backward algorithm is correct.
  */
@@ -209,6 +269,49 @@ BOOST_AUTO_TEST_CASE(SimpleBaumWelchDiscreteHMM)
   BOOST_REQUIRE_CLOSE(hmm.Initial()[0], 1.0, 1e-5);
 }
 
+/**
+ * Baum-Welch runs the E-step of each sequence independently, possibly on
+ * different threads, so the order of the sequences should not matter.  Train
+ * on many sequences of different lengths, in order and reversed, and make sure
+ * the models agree.
+ */
+BOOST_AUTO_TEST_CASE(BaumWelchSequenceOrderTest)
+{
+  HMM<DiscreteDistribution> trueHMM(2, 3);
+  trueHMM.Transition() = "0.8 0.3; 0.2 0.7";
+  trueHMM.Emission()[0].Probabilities() = "0.6 0.3 0.1";
+  trueHMM.Emission()[1].Probabilities() = "0.1 0.2 0.7";
+
+  std::vector<arma::mat> observations(200);
+  for (size_t i = 0; i < observations.size(); ++i)
+  {
+    arma::Col<size_t> states;
+    trueHMM.Generate(5 + math::RandInt(50), observations[i], states);
+  }
+  const std::vector<arma::mat> reversed(observations.rbegin(),
+      observations.rend());
+
+  HMM<DiscreteDistribution> hmm(2, 3);
+  hmm.Transition() = "0.6 0.5; 0.4 0.5";
+  hmm.Emission()[0].Probabilities() = "0.4 0.4 0.2";
+  hmm.Emission()[1].Probabilities() = "0.2 0.3 0.5";
+  HMM<DiscreteDistribution> hmmReversed(hmm);
+
+  hmm.Train(observations);
+  hmmReversed.Train(reversed);
+
+  for (size_t i = 0; i < 2; ++i)
+  {
+    for (size_t j = 0; j < 2; ++j)
+      BOOST_REQUIRE_CLOSE(hmm.Transition()(i, j),
+          hmmReversed.Transition()(i, j), 0.1);
+
+    for (size_t j = 0; j < 3; ++j)
+      BOOST_REQUIRE_CLOSE(hmm.Emission()[i].Probabilities()[j],
+          hmmReversed.Emission()[i].Probabilities()[j], 0.1);
+  }
+}
+
 /**
  * Increasing complexity, but still simple; 4 emissions, 2 states; the state can
  * be determined directly by the emission.
@@ -580,6 +683,52 @@ BOOST_AUTO_TEST_CASE(GaussianHMMSimpleTest)
   }
 }
 
+/**
+ * Observations far from every Gaussian have emission probabilities that
+ * underflow to 0; the log-likelihood should still be right, since the forward
+ * algorithm works from the emission log-probabilities.  Compare against the
+ * sum over every state sequence, computed in log space.
+ */
+BOOST_AUTO_TEST_CASE(GaussianHMMOutlierLogLikelihoodTest)
+{
+  std::vector<GaussianDistribution> emission;
+  emission.push_back(GaussianDistribution("0.0", "1.0"));
+  emission.push_back(GaussianDistribution("3.0", "2.0"));
+
+  HMM<GaussianDistribution> hmm(arma::vec("0.6 0.4"),
+      arma::mat("0.9 0.2; 0.1 0.8"), emission);
+
+  const arma::mat observations("60.0 -50.0 2.0 80.0");
+  BOOST_REQUIRE_EQUAL(emission[0].Probability(observations.col(0)), 0.0);
+
+  // Sum over all 16 state sequences.
+  arma::vec pathLogProbs(16);
+  for (size_t path = 0; path < 16; ++path)
+  {
+    size_t state = path & 1;
+    double logProb = log(hmm.Initial()[state]) +
+        emission[state].LogProbability(observations.col(0));
+    for (size_t t = 1; t < 4; ++t)
+    {
+      const size_t next = (path >> t) & 1;
+      logProb += log(hmm.Transition()(next, state)) +
+          emission[next].LogProbability(observations.col(t));
+      state = next;
+    }
+    pathLogProbs[path] = logProb;
+  }
+  const double maxLogProb = pathLogProbs.max();
+  const double expected = maxLogProb +
+      log(accu(arma::exp(pathLogProbs - maxLogProb)));
+
+  BOOST_REQUIRE_CLOSE(hmm.LogLikelihood(observations), expected, 1e-5);
+
+  arma::mat stateProb;
+  BOOST_REQUIRE_CLOSE(hmm.Estimate(observations, stateProb), expected, 1e-5);
+  for (size_t t = 0; t < 4; ++t)
+    BOOST_REQUIRE_CLOSE(accu(stateProb.col(t)), 1.0, 1e-5);
+}
+
 /**
  * Ensure that Gaussian HMMs can be trained properly, for the labeled training
  * case and also for the unlabeled training case.
@@ -833,6 +982,80 @@ BOOST_AUTO_TEST_CASE(GMMHMMPredictTest)
     BOOST_REQUIRE_EQUAL(predictions[i], states[i]);
 }
 
+/**
+ * Make sure that Baum-Welch training of a GMM-based HMM, whose emissions are
+ * estimated in parallel, gives the same model with one thread as with all of
+ * them.
+ */
+BOOST_AUTO_TEST_CASE(GMMHMMParallelTrainTest)
+{
+  // Four states, each a mixture of two Gaussians far from the other states.
+  std::vector<GMM<> > gmms(4, GMM<>(2, 2));
+  for (size_t s = 0; s < 4; ++s)
+  {
+    gmms[s].Weights() = arma::vec("0.5 0.5");
+    const arma::vec shift = arma::vec("10 10") * s;
+    gmms[s].Component(0) = GaussianDistribution(arma::vec("0 0") + shift,
+        arma::eye<arma::mat>(2, 2));
+    gmms[s].Component(1) = GaussianDistribution(arma::vec("3 -3") + shift,
+        arma::eye<arma::mat>(2, 2));
+  }
+
+  arma::mat trans("0.7 0.1 0.1 0.1;"
+                  "0.1 0.7 0.1 0.1;"
+                  "0.1 0.1 0.7 0.1;"
+                  "0.1 0.1 0.1 0.7");
+
+  std::vector<arma::mat> observations(10, arma::mat(2, 200));
+  for (size_t seq = 0; seq < 10; ++seq)
+  {
+    size_t state = (size_t) math::RandInt(4);
+    for (size_t t = 0; t < 200; ++t)
+    {
+      observations[seq].col(t) = gmms[state].Random();
+
+      const double r = math::Random();
+      double sum = 0.0;
+      for (size_t next = 0; next < 4; ++next)
+      {
+        sum += trans(next, state);
+        if (r <= sum || next == 3)
+        {
+          state = next;
+          break;
+        }
+      }
+    }
+  }
+
+  const size_t threads = parallel::Threads();
+  std::vector<HMM<GMM<> > > hmms(2, HMM<GMM<> >(4, GMM<>(2, 2)));
+  for (size_t i = 0; i < 2; ++i)
+  {
+    parallel::SetThreads((i == 0) ? 1 : threads);
+    math::RandomSeed(1234);
+    hmms[i].Train(observations);
+  }
+  parallel::SetThreads(threads);
+
+  for (size_t s = 0; s < 4; ++s)
+  {
+    for (size_t j = 0; j < 4; ++j)
+      BOOST_REQUIRE_CLOSE(hmms[0].Transition()(j, s) + 1.0,
+          hmms[1].Transition()(j, s) + 1.0, 1e-4);
+
+    for (size_t c = 0; c < 2; ++c)
+    {
+      BOOST_REQUIRE_CLOSE(hmms[0].Emission()[s].Weights()[c],
+          hmms[1].Emission()[s].Weights()[c], 1e-4);
+      for (size_t d = 0; d < 2; ++d)
+        BOOST_REQUIRE_CLOSE(hmms[0].Emission()[s].Component(c).Mean()[d] +
+            100.0, hmms[1].Emission()[s].Component(c).Mean()[d] + 100.0,
+            1e-4);
+    }
+  }
+}
+
 /**
  * Test that GMM-based HMMs can train on models correctly using labeled training
  * data.
@@ -0,0 +1,245 @@
+/**
+ * @file ivf_pq_test.cpp
+ * @author Ryan Curtin
+ *
+ * Tests for the IVFPQSearch class.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/lsh/ivf_pq_search.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::neighbor;
+
+BOOST_AUTO_TEST_SUITE(IVFPQTest);
+
+/**
+ * Make sure that every reference point is stored once, in the list of its
+ * nearest centroid, with one code per subspace.
+ */
+BOOST_AUTO_TEST_CASE(IVFPQStructureTest)
+{
+  math::RandomSeed(0);
+  arma::mat dataset = arma::randu<arma::mat>(10, 500);
+
+  IVFPQSearch index(dataset, 8, 3, 16, 100, 200);
+
+  BOOST_REQUIRE_EQUAL(index.ReferencePoints(), 500);
+  BOOST_REQUIRE_EQUAL(index.Dimensionality(), 10);
+  BOOST_REQUIRE_EQUAL(index.Lists(), 8);
+  BOOST_REQUIRE_EQUAL(index.Subspaces(), 3);
+  BOOST_REQUIRE_EQUAL(index.Codes().n_rows, 3);
+  BOOST_REQUIRE_EQUAL(index.Codes().n_cols, 500);
+  BOOST_REQUIRE_EQUAL(index.ListOffsets().n_elem, 9);
+  BOOST_REQUIRE_EQUAL(index.ListOffsets()[0], 0);
+  BOOST_REQUIRE_EQUAL(index.ListOffsets()[8], 500);
+
+  // The subspaces cover the dimensions (10 = 3 + 3 + 4).
+  BOOST_REQUIRE_EQUAL(index.SubspaceBegin(0), 0);
+  BOOST_REQUIRE_EQUAL(index.SubspaceBegin(3), 10);
+  for (size_t m = 0; m < 3; ++m)
+  {
+    BOOST_REQUIRE_EQUAL(index.Codebook(m).n_rows,
+        index.SubspaceBegin(m + 1) - index.SubspaceBegin(m));
+    BOOST_REQUIRE_EQUAL(index.Codebook(m).n_cols, 16);
+  }
+
+  std::vector<bool> found(500, false);
+  for (size_t l = 0; l < index.Lists(); ++l)
+  {
+    for (size_t p = index.ListOffsets()[l]; p < index.ListOffsets()[l + 1];
+        ++p)
+    {
+      const size_t point = index.ListContents()[p];
+      BOOST_REQUIRE_LT(point, 500);
+      BOOST_REQUIRE(!found[point]);
+      found[point] = true;
+
+      for (size_t m = 0; m < 3; ++m)
+        BOOST_REQUIRE_LT(index.Codes()(m, p), 16);
+
+      const double distance = arma::norm(dataset.col(point) -
+          index.Centroids().col(l), 2);
+      for (size_t j = 0; j < index.Lists(); ++j)
+        BOOST_REQUIRE_LE(distance, arma::norm(dataset.col(point) -
+            index.Centroids().col(j), 2) + 1e-10);
+    }
+  }
+}
+
+/**
+ * When every list is probed and every candidate is re-ranked, the results
+ * must be the exact nearest neighbors.
+ */
+BOOST_AUTO_TEST_CASE(IVFPQFullRerankTest)
+{
+  math::RandomSeed(1);
+  arma::mat dataset = arma::randu<arma::mat>(6, 300);
+  arma::mat queries = arma::randu<arma::mat>(6, 40);
+
+  IVFPQSearch index(dataset, 5, 2, 8);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  index.Search(queries, 5, neighbors, distances, 5, &dataset, 300);
+
+  AllkNN knn(dataset, true);
+  arma::Mat<size_t> exactNeighbors;
+  arma::mat exactDistances;
+  knn.Search(queries, 5, exactNeighbors, exactDistances);
+
+  BOOST_REQUIRE_EQUAL(index.CandidatesScored(), 300 * 40);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], exactNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], exactDistances[i], 1e-5);
+  }
+}
+
+/**
+ * The approximate search, with some re-ranking, should find most of the exact
+ * nearest neighbors, and its distances (from the codes) should be close to the
+ * exact ones without re-ranking.
+ */
+BOOST_AUTO_TEST_CASE(IVFPQRecallTest)
+{
+  math::RandomSeed(2);
+  arma::mat dataset = arma::randu<arma::mat>(8, 2000);
+  arma::mat queries = arma::randu<arma::mat>(8, 100);
+
+  IVFPQSearch index(dataset, 16, 4, 64);
+
+  AllkNN knn(dataset);
+  arma::Mat<size_t> exactNeighbors;
+  arma::mat exactDistances;
+  knn.Search(queries, 1, exactNeighbors, exactDistances);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  index.Search(queries, 1, neighbors, distances, 16, &dataset, 50);
+
+  size_t found = 0;
+  for (size_t i = 0; i < queries.n_cols; ++i)
+    if (neighbors(0, i) == exactNeighbors(0, i))
+      ++found;
+  BOOST_REQUIRE_GE(found, 90);
+
+  // Without re-ranking, the distance to the returned neighbor is estimated
+  // from its codes.
+  index.Search(queries, 1, neighbors, distances, 16);
+  double error = 0.0;
+  for (size_t i = 0; i < queries.n_cols; ++i)
+    error += std::abs(distances(0, i) - arma::norm(queries.col(i) -
+        dataset.col(neighbors(0, i)), 2));
+  BOOST_REQUIRE_LT(error / queries.n_cols, 0.2);
+}
+
+/**
+ * If the probed lists hold fewer than k points, the remaining neighbors are
+ * marked as not found.
+ */
+BOOST_AUTO_TEST_CASE(IVFPQFewCandidatesTest)
+{
+  math::RandomSeed(3);
+  arma::mat dataset(2, 20);
+  dataset.cols(0, 9) = arma::randu<arma::mat>(2, 10);
+  dataset.cols(10, 19) = arma::randu<arma::mat>(2, 10) + 100.0;
+
+  IVFPQSearch index(dataset, 2, 1, 4);
+
+  arma::mat query(2, 1);
+  query.fill(0.5);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  index.Search(query, 15, neighbors, distances);
+
+  BOOST_REQUIRE_EQUAL(index.CandidatesScored(), 10);
+  for (size_t j = 0; j < 10; ++j)
+    BOOST_REQUIRE_LT(neighbors(j, 0), 10);
+  for (size_t j = 10; j < 15; ++j)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors(j, 0), size_t() - 1);
+    BOOST_REQUIRE_EQUAL(distances(j, 0), DBL_MAX);
+  }
+}
+
+/**
+ * Make sure that invalid parameters are rejected.
+ */
+BOOST_AUTO_TEST_CASE(IVFPQInvalidTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(4, 100);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+
+  IVFPQSearch index;
+  BOOST_REQUIRE_THROW(index.Search(dataset, 1, neighbors, distances),
+      std::invalid_argument);
+
+  BOOST_REQUIRE_THROW(index.Train(dataset, 0, 2), std::invalid_argument);
+  BOOST_REQUIRE_THROW(index.Train(dataset, 101, 2), std::invalid_argument);
+  BOOST_REQUIRE_THROW(index.Train(dataset, 4, 5), std::invalid_argument);
+  BOOST_REQUIRE_THROW(index.Train(dataset, 4, 2, 257), std::invalid_argument);
+  BOOST_REQUIRE_THROW(index.Train(dataset, 4, 2, 64, 100, 50),
+      std::invalid_argument);
+
+  index.Train(dataset, 4, 2, 16);
+  arma::mat wrongQueries = arma::randu<arma::mat>(3, 10);
+  BOOST_REQUIRE_THROW(index.Search(wrongQueries, 1, neighbors, distances),
+      std::invalid_argument);
+  BOOST_REQUIRE_THROW(index.Search(dataset, 101, neighbors, distances),
+      std::invalid_argument);
+  BOOST_REQUIRE_THROW(index.Search(dataset, 1, neighbors, distances, 0),
+      std::invalid_argument);
+
+  arma::mat wrongData = arma::randu<arma::mat>(4, 99);
+  BOOST_REQUIRE_THROW(index.Search(dataset, 1, neighbors, distances, 1,
+      &wrongData, 10), std::invalid_argument);
+}
+
+/**
+ * Make sure that a saved and loaded index gives the same results.
+ */
+BOOST_AUTO_TEST_CASE(IVFPQSerializationTest)
+{
+  math::RandomSeed(4);
+  arma::mat dataset = arma::randu<arma::mat>(5, 200);
+  arma::mat queries = arma::randu<arma::mat>(5, 20);
+
+  IVFPQSearch index(dataset, 4, 2, 16);
+
+  {
+    std::ofstream ofs("test-ivf-pq-save.xml");
+    boost::archive::xml_oarchive ar(ofs);
+    ar << data::CreateNVP(index, "index");
+  }
+
+  IVFPQSearch index2;
+  {
+    std::ifstream ifs("test-ivf-pq-save.xml");
+    boost::archive::xml_iarchive ar(ifs);
+    ar >> data::CreateNVP(index2, "index");
+  }
+
+  remove("test-ivf-pq-save.xml");
+
+  BOOST_REQUIRE_EQUAL(index2.ReferencePoints(), 200);
+  BOOST_REQUIRE_EQUAL(index2.Lists(), 4);
+  BOOST_REQUIRE_EQUAL(index2.Subspaces(), 2);
+
+  arma::Mat<size_t> neighbors, neighbors2;
+  arma::mat distances, distances2;
+  index.Search(queries, 3, neighbors, distances, 2);
+  index2.Search(queries, 3, neighbors2, distances2, 2);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], neighbors2[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], distances2[i], 1e-5);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
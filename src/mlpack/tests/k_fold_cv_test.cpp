@@ -0,0 +1,185 @@
+/**
+ * @file k_fold_cv_test.cpp
+ * @author Ryan Curtin
+ *
+ * Tests for the KFoldCV cross-validation harness.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/cv/k_fold_cv.hpp>
+#include <mlpack/methods/lars/lars.hpp>
+#include <mlpack/methods/logistic_regression/logistic_regression.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::cv;
+using namespace mlpack::regression;
+
+BOOST_AUTO_TEST_SUITE(KFoldCVTest);
+
+/**
+ * Each point should be in the test set of exactly one fold, and in the
+ * training set of every other fold, with its own response.
+ */
+BOOST_AUTO_TEST_CASE(KFoldCVFoldsTest)
+{
+  arma::mat data = arma::randu<arma::mat>(3, 103);
+  arma::Row<size_t> labels(103);
+  for (size_t i = 0; i < labels.n_elem; ++i)
+    labels[i] = i;
+
+  KFoldCV<> cv(data, labels, 10);
+  BOOST_REQUIRE_EQUAL(cv.K(), 10);
+  BOOST_REQUIRE_EQUAL(cv.NumPoints(), 103);
+
+  arma::Col<size_t> testCounts(103), trainCounts(103);
+  testCounts.zeros();
+  trainCounts.zeros();
+  for (size_t fold = 0; fold < cv.K(); ++fold)
+  {
+    cv.Fold(fold, [&](const arma::mat& trainData,
+                      const arma::Row<size_t>& trainLabels,
+                      const arma::mat& testData,
+                      const arma::Row<size_t>& testLabels)
+    {
+      BOOST_REQUIRE_EQUAL(trainData.n_cols + testData.n_cols, 103);
+      BOOST_REQUIRE_EQUAL(trainLabels.n_elem, trainData.n_cols);
+      BOOST_REQUIRE_EQUAL(testLabels.n_elem, testData.n_cols);
+      BOOST_REQUIRE_GE(testData.n_cols, 10);
+      BOOST_REQUIRE_LE(testData.n_cols, 11);
+
+      for (size_t i = 0; i < testData.n_cols; ++i)
+      {
+        ++testCounts[testLabels[i]];
+        BOOST_REQUIRE_EQUAL(arma::accu(testData.col(i) !=
+            data.col(testLabels[i])), 0);
+      }
+      for (size_t i = 0; i < trainData.n_cols; ++i)
+      {
+        ++trainCounts[trainLabels[i]];
+        BOOST_REQUIRE_EQUAL(arma::accu(trainData.col(i) !=
+            data.col(trainLabels[i])), 0);
+      }
+    });
+  }
+
+  for (size_t i = 0; i < 103; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(testCounts[i], 1);
+    BOOST_REQUIRE_EQUAL(trainCounts[i], 9);
+  }
+
+  // Without shuffling, the folds hold consecutive points.
+  KFoldCV<> ordered(data, labels, 4, false);
+  ordered.Fold(1, [&](const arma::mat& /* trainData */,
+                      const arma::Row<size_t>& trainLabels,
+                      const arma::mat& /* testData */,
+                      const arma::Row<size_t>& testLabels)
+  {
+    BOOST_REQUIRE_EQUAL(testLabels[0], 25);
+    BOOST_REQUIRE_EQUAL(testLabels[testLabels.n_elem - 1], 50);
+    BOOST_REQUIRE_EQUAL(trainLabels[0], 51);
+    BOOST_REQUIRE_EQUAL(trainLabels[trainLabels.n_elem - 1], 24);
+  });
+}
+
+/**
+ * Invalid numbers of folds and mismatched responses should be rejected.
+ */
+BOOST_AUTO_TEST_CASE(KFoldCVInvalidTest)
+{
+  arma::mat data = arma::randu<arma::mat>(3, 10);
+  arma::Row<size_t> labels = arma::zeros<arma::Row<size_t>>(10);
+  arma::Row<size_t> shortLabels = arma::zeros<arma::Row<size_t>>(9);
+
+  BOOST_REQUIRE_THROW(KFoldCV<>(data, labels, 1), std::invalid_argument);
+  BOOST_REQUIRE_THROW(KFoldCV<>(data, labels, 11), std::invalid_argument);
+  BOOST_REQUIRE_THROW(KFoldCV<>(data, shortLabels, 5),
+      std::invalid_argument);
+
+  KFoldCV<> cv(data, labels, 5);
+  BOOST_REQUIRE_THROW(cv.Fold(5, [](const arma::mat&,
+      const arma::Row<size_t>&, const arma::mat&, const arma::Row<size_t>&)
+      { }), std::invalid_argument);
+}
+
+/**
+ * A grid search over the regularization of logistic regression should give
+ * the same scores as training on each fold serially, and should not choose a
+ * huge penalty on separable data.
+ */
+BOOST_AUTO_TEST_CASE(KFoldCVLogisticRegressionTest)
+{
+  arma::mat data(2, 400);
+  arma::Row<size_t> labels(400);
+  for (size_t i = 0; i < 400; ++i)
+  {
+    labels[i] = i % 2;
+    data.col(i) = arma::randu<arma::vec>(2) + 1.5 * labels[i];
+  }
+
+  KFoldCV<> cv(data, labels, 5);
+  const std::vector<double> lambdas = { 0.0, 0.1, 1000.0 };
+  auto accuracy = [](const double lambda,
+                     const arma::mat& trainData,
+                     const arma::Row<size_t>& trainLabels,
+                     const arma::mat& testData,
+                     const arma::Row<size_t>& testLabels)
+  {
+    LogisticRegression<> lr(trainData, trainLabels, lambda);
+    return lr.ComputeAccuracy(testData, testLabels);
+  };
+
+  const arma::mat scores = cv.Evaluate(lambdas, accuracy);
+  BOOST_REQUIRE_EQUAL(scores.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(scores.n_cols, 5);
+
+  for (size_t i = 0; i < lambdas.size(); ++i)
+  {
+    for (size_t fold = 0; fold < cv.K(); ++fold)
+    {
+      cv.Fold(fold, [&](const arma::mat& trainData,
+                        const arma::Row<size_t>& trainLabels,
+                        const arma::mat& testData,
+                        const arma::Row<size_t>& testLabels)
+      {
+        BOOST_REQUIRE_CLOSE(scores(i, fold), accuracy(lambdas[i], trainData,
+            trainLabels, testData, testLabels), 1e-5);
+      });
+    }
+  }
+
+  const size_t best = KFoldCV<>::Best(scores);
+  BOOST_REQUIRE_LT(best, 2);
+  BOOST_REQUIRE_GT(arma::mean(scores.row(best)), 95.0);
+}
+
+/**
+ * A grid search over the L1 penalty of LARS, minimizing the squared error,
+ * should choose a small penalty when the targets are a noiseless linear
+ * function of the data.
+ */
+BOOST_AUTO_TEST_CASE(KFoldCVLARSTest)
+{
+  arma::mat data = arma::randn<arma::mat>(5, 300);
+  const arma::vec beta = arma::randn<arma::vec>(5);
+  const arma::vec targets = arma::trans(data) * beta;
+
+  KFoldCV<arma::mat, arma::vec> cv(data, targets, 6);
+  const std::vector<double> lambdas = { 100.0, 1e-4, 10.0 };
+  const arma::mat scores = cv.Evaluate(lambdas, [](const double lambda,
+      const arma::mat& trainData, const arma::vec& trainTargets,
+      const arma::mat& testData, const arma::vec& testTargets)
+  {
+    LARS lars(false, lambda);
+    arma::vec coefficients, predictions;
+    lars.Regress(trainData, trainTargets, coefficients);
+    lars.Predict(testData, predictions);
+    return -arma::accu(arma::square(predictions - testTargets));
+  });
+
+  BOOST_REQUIRE_EQUAL(KFoldCV<arma::mat, arma::vec>::Best(scores), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
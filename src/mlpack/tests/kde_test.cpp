@@ -0,0 +1,167 @@
+/**
+ * @file kde_test.cpp
+ * @author Ryan Curtin
+ *
+ * Test file for the KDE class.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/kernels/epanechnikov_kernel.hpp>
+#include <mlpack/core/tree/cover_tree.hpp>
+#include <mlpack/core/tree/rectangle_tree.hpp>
+#include <mlpack/methods/kde/kde.hpp>
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::kde;
+using namespace mlpack::kernel;
+using namespace mlpack::tree;
+using namespace mlpack::metric;
+
+BOOST_AUTO_TEST_SUITE(KDETest);
+
+// Compute the density estimations by hand.
+template<typename KernelType>
+void ExactEstimations(const arma::mat& referenceSet,
+                      const arma::mat& querySet,
+                      const KernelType& kernel,
+                      arma::vec& estimations)
+{
+  estimations.zeros(querySet.n_cols);
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+    for (size_t j = 0; j < referenceSet.n_cols; ++j)
+      estimations[i] += kernel.Evaluate(EuclideanDistance::Evaluate(
+          querySet.col(i), referenceSet.col(j)));
+  estimations /= referenceSet.n_cols;
+}
+
+// Make sure that every estimation of the given KDE type is within the error
+// tolerances, in dual-tree and single-tree mode, bichromatic and
+// monochromatic.
+template<typename KDEType, typename KernelType>
+void CheckEstimations(const arma::mat& referenceSet,
+                      const arma::mat& querySet,
+                      const KernelType& kernel,
+                      const double relError,
+                      const double absError)
+{
+  arma::vec exact, exactMonochromatic;
+  ExactEstimations(referenceSet, querySet, kernel, exact);
+  ExactEstimations(referenceSet, referenceSet, kernel, exactMonochromatic);
+
+  for (size_t single = 0; single < 2; ++single)
+  {
+    KDEType kde(relError, absError, kernel, false, (single == 1));
+    kde.Train(referenceSet);
+
+    arma::vec estimations;
+    kde.Evaluate(querySet, estimations);
+    BOOST_REQUIRE_EQUAL(estimations.n_elem, querySet.n_cols);
+    for (size_t i = 0; i < estimations.n_elem; ++i)
+      BOOST_REQUIRE_LE(std::abs(estimations[i] - exact[i]),
+          relError * exact[i] + absError + 1e-12);
+
+    kde.Evaluate(estimations);
+    BOOST_REQUIRE_EQUAL(estimations.n_elem, referenceSet.n_cols);
+    for (size_t i = 0; i < estimations.n_elem; ++i)
+      BOOST_REQUIRE_LE(std::abs(estimations[i] - exactMonochromatic[i]),
+          relError * exactMonochromatic[i] + absError + 1e-12);
+  }
+}
+
+/**
+ * Make sure naive mode gives the exact estimations.
+ */
+BOOST_AUTO_TEST_CASE(KDENaiveTest)
+{
+  arma::mat referenceSet = arma::randu<arma::mat>(3, 200);
+  arma::mat querySet = arma::randu<arma::mat>(3, 50);
+  const GaussianKernel kernel(0.3);
+
+  arma::vec exact;
+  ExactEstimations(referenceSet, querySet, kernel, exact);
+
+  KDE<> kde(0.05, 0.0, kernel, true);
+  kde.Train(referenceSet);
+  arma::vec estimations;
+  kde.Evaluate(querySet, estimations);
+
+  BOOST_REQUIRE_EQUAL(estimations.n_elem, exact.n_elem);
+  for (size_t i = 0; i < exact.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(estimations[i], exact[i], 1e-8);
+}
+
+/**
+ * Make sure the estimations with each tree type are within the tolerances.
+ */
+BOOST_AUTO_TEST_CASE(KDETreeTest)
+{
+  arma::mat referenceSet = arma::randu<arma::mat>(3, 500);
+  referenceSet.cols(0, 199) += 2.0;
+  arma::mat querySet = arma::randu<arma::mat>(3, 100) * 3.0;
+  const GaussianKernel kernel(0.25);
+
+  CheckEstimations<KDE<GaussianKernel, EuclideanDistance, arma::mat,
+      KDTree> >(referenceSet, querySet, kernel, 0.05, 0.0);
+  CheckEstimations<KDE<GaussianKernel, EuclideanDistance, arma::mat,
+      BallTree> >(referenceSet, querySet, kernel, 0.05, 0.0);
+  CheckEstimations<KDE<GaussianKernel, EuclideanDistance, arma::mat,
+      StandardCoverTree> >(referenceSet, querySet, kernel, 0.05, 0.0);
+  CheckEstimations<KDE<GaussianKernel, EuclideanDistance, arma::mat,
+      RTree> >(referenceSet, querySet, kernel, 0.05, 0.0);
+
+  // An absolute tolerance alone.
+  CheckEstimations<KDE<GaussianKernel, EuclideanDistance, arma::mat,
+      KDTree> >(referenceSet, querySet, kernel, 0.0, 1e-3);
+}
+
+/**
+ * With no error tolerance, only nodes that are entirely outside the support of
+ * a compact kernel can be pruned, so the estimations are exact.
+ */
+BOOST_AUTO_TEST_CASE(KDEExactCompactKernelTest)
+{
+  arma::mat referenceSet = arma::randu<arma::mat>(2, 400) * 4.0;
+  arma::mat querySet = arma::randu<arma::mat>(2, 100) * 4.0;
+  const EpanechnikovKernel kernel(0.5);
+
+  CheckEstimations<KDE<EpanechnikovKernel, EuclideanDistance, arma::mat,
+      KDTree> >(referenceSet, querySet, kernel, 0.0, 0.0);
+  CheckEstimations<KDE<EpanechnikovKernel, EuclideanDistance, arma::mat,
+      StandardCoverTree> >(referenceSet, querySet, kernel, 0.0, 0.0);
+
+  // Most of the reference set is outside the support of the kernel for each
+  // query point, so much of it must have been pruned.
+  KDE<EpanechnikovKernel> kde(0.0, 0.0, kernel);
+  kde.Train(referenceSet);
+  arma::vec estimations;
+  kde.Evaluate(querySet, estimations);
+  BOOST_REQUIRE_LT(kde.BaseCases(), referenceSet.n_cols * querySet.n_cols);
+  BOOST_REQUIRE_GT(kde.Approximations(), 0);
+}
+
+/**
+ * Make sure invalid settings and query sets are refused.
+ */
+BOOST_AUTO_TEST_CASE(KDEInvalidTest)
+{
+  arma::mat referenceSet = arma::randu<arma::mat>(3, 100);
+  arma::mat querySet = arma::randu<arma::mat>(4, 10);
+  arma::vec estimations;
+
+  BOOST_REQUIRE_THROW(KDE<>(-0.1), std::invalid_argument);
+
+  KDE<> kde;
+  BOOST_REQUIRE_THROW(kde.Evaluate(querySet, estimations),
+      std::invalid_argument);
+
+  kde.Train(referenceSet);
+  BOOST_REQUIRE_THROW(kde.Evaluate(querySet, estimations),
+      std::invalid_argument);
+
+  kde.AbsoluteError() = -1.0;
+  BOOST_REQUIRE_THROW(kde.Evaluate(estimations), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
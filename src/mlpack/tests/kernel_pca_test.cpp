@@ -6,7 +6,10 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/core/kernels/gaussian_kernel.hpp>
+#include <mlpack/core/kernels/laplacian_kernel.hpp>
 #include <mlpack/methods/kernel_pca/kernel_rules/nystroem_method.hpp>
+#include <mlpack/methods/kernel_pca/kernel_rules/matrix_free_method.hpp>
+#include <mlpack/methods/kernel_pca/kernel_rules/random_fourier_features.hpp>
 #include <mlpack/methods/kernel_pca/kernel_pca.hpp>
 
 #include <boost/test/unit_test.hpp>
@@ -145,4 +148,188 @@ BOOST_AUTO_TEST_CASE(CircleTransformationTestNystroem)
   BOOST_REQUIRE_EQUAL(ranges[1].Contains(ranges[2]), false);
 }
 
+/**
+ * If KernelPCA is working right, then it should turn a circle dataset into a
+ * linearly separable dataset in one dimension (which is easy to check).
+ */
+BOOST_AUTO_TEST_CASE(CircleTransformationTestRandomFourierFeatures)
+{
+  // The dataset, which will have three concentric rings in three dimensions.
+  arma::mat dataset;
+
+  // Now, there are 750 points centered at the origin with unit variance.
+  dataset.randn(3, 750);
+  dataset *= 0.05;
+
+  // Take the second 250 points and spread them away from the origin.
+  for (size_t i = 250; i < 500; ++i)
+  {
+    // Push the point away from the origin by 2.
+    const double pointNorm = norm(dataset.col(i), 2);
+
+    dataset(0, i) += 2.0 * (dataset(0, i) / pointNorm);
+    dataset(1, i) += 2.0 * (dataset(1, i) / pointNorm);
+    dataset(2, i) += 2.0 * (dataset(2, i) / pointNorm);
+  }
+
+  // Take the third 500 points and spread them away from the origin.
+  for (size_t i = 500; i < 750; ++i)
+  {
+    // Push the point away from the origin by 5.
+    const double pointNorm = norm(dataset.col(i), 2);
+
+    dataset(0, i) += 5.0 * (dataset(0, i) / pointNorm);
+    dataset(1, i) += 5.0 * (dataset(1, i) / pointNorm);
+    dataset(2, i) += 5.0 * (dataset(2, i) / pointNorm);
+  }
+
+  // Now we have a dataset; we will use the GaussianKernel to perform KernelPCA
+  // using random Fourier features to take it down to one dimension.
+  KernelPCA<GaussianKernel, RandomFourierFeaturesKernelRule<GaussianKernel> >
+      p;
+  p.Apply(dataset, 1);
+  BOOST_REQUIRE_EQUAL(dataset.n_rows, 1);
+
+  // Get the ranges of each "class".  These are all initialized as empty ranges
+  // containing no points.
+  Range ranges[3];
+  ranges[0] = Range();
+  ranges[1] = Range();
+  ranges[2] = Range();
+
+  // Expand the ranges to hold all of the points in the class.
+  for (size_t i = 0; i < 250; ++i)
+    ranges[0] |= dataset(0, i);
+  for (size_t i = 250; i < 500; ++i)
+    ranges[1] |= dataset(0, i);
+  for (size_t i = 500; i < 750; ++i)
+    ranges[2] |= dataset(0, i);
+
+  // None of these ranges should overlap -- the classes should be linearly
+  // separable.
+  BOOST_REQUIRE_EQUAL(ranges[0].Contains(ranges[1]), false);
+  BOOST_REQUIRE_EQUAL(ranges[0].Contains(ranges[2]), false);
+  BOOST_REQUIRE_EQUAL(ranges[1].Contains(ranges[2]), false);
+}
+
+/**
+ * Make sure the inner products of random Fourier features approximate the
+ * Gaussian and Laplacian kernels.
+ */
+template<typename KernelType>
+void CheckRandomFourierFeatures(const KernelType& kernel)
+{
+  arma::mat dataset = arma::randu<arma::mat>(4, 50);
+
+  RandomFourierFeatures<KernelType> features(4, 20000, kernel);
+  BOOST_REQUIRE_EQUAL(features.Dimensionality(), 4);
+  BOOST_REQUIRE_EQUAL(features.NumFeatures(), 20000);
+
+  arma::mat z;
+  features.Transform(dataset, z);
+  BOOST_REQUIRE_EQUAL(z.n_rows, 20000);
+  BOOST_REQUIRE_EQUAL(z.n_cols, 50);
+
+  const arma::mat approximation = z.t() * z;
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    for (size_t j = 0; j < dataset.n_cols; ++j)
+    {
+      const double k = kernel.Evaluate(dataset.col(i), dataset.col(j));
+      BOOST_REQUIRE_SMALL(approximation(i, j) - k, 0.05);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RandomFourierFeaturesApproximationTest)
+{
+  CheckRandomFourierFeatures(GaussianKernel(0.8));
+  CheckRandomFourierFeatures(LaplacianKernel(1.5));
+}
+
+/**
+ * Make sure that the first k eigenvalues and dimensions of the transformed data
+ * are the same in both results, up to the signs of the dimensions.
+ */
+void CheckTopDimensions(const arma::vec& eigval,
+                        const arma::mat& transformedData,
+                        const arma::vec& partialEigval,
+                        const arma::mat& partialTransformedData,
+                        const size_t k)
+{
+  BOOST_REQUIRE_EQUAL(partialEigval.n_elem, k);
+  BOOST_REQUIRE_EQUAL(partialTransformedData.n_rows, k);
+  BOOST_REQUIRE_EQUAL(partialTransformedData.n_cols, transformedData.n_cols);
+
+  for (size_t i = 0; i < k; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(partialEigval[i], eigval[i], 1e-4);
+
+    const double sign = (arma::dot(transformedData.row(i),
+        partialTransformedData.row(i)) < 0) ? -1.0 : 1.0;
+    for (size_t j = 0; j < transformedData.n_cols; ++j)
+      BOOST_REQUIRE_SMALL(sign * partialTransformedData(i, j) -
+          transformedData(i, j), 1e-4);
+  }
+}
+
+/**
+ * When only a few dimensions are kept, the naive method finds only those
+ * eigenpairs; they should be the same as the top eigenpairs of the full
+ * decomposition.
+ */
+BOOST_AUTO_TEST_CASE(PartialEigenpairsTestNaive)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 400);
+  // Stretch the dimensions differently, so that the top eigenvalues are well
+  // separated.
+  dataset.row(1) *= 2.0;
+  dataset.row(2) *= 4.0;
+  KernelPCA<GaussianKernel> p(GaussianKernel(1.0));
+
+  arma::mat transformedData, eigvec;
+  arma::vec eigval;
+  p.Apply(dataset, transformedData, eigval, eigvec);
+  BOOST_REQUIRE_EQUAL(eigval.n_elem, dataset.n_cols);
+
+  arma::mat partialTransformedData, partialEigvec;
+  arma::vec partialEigval;
+  p.Apply(dataset, partialTransformedData, partialEigval, partialEigvec, 5);
+
+  CheckTopDimensions(eigval, transformedData, partialEigval,
+      partialTransformedData, 5);
+}
+
+/**
+ * The matrix-free method should give the same results as the naive method.
+ */
+BOOST_AUTO_TEST_CASE(MatrixFreeTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 600);
+  // Stretch the dimensions differently, so that the top eigenvalues are well
+  // separated.
+  dataset.row(1) *= 2.0;
+  dataset.row(2) *= 4.0;
+  KernelPCA<GaussianKernel> p(GaussianKernel(1.0));
+  KernelPCA<GaussianKernel, MatrixFreeKernelRule<GaussianKernel> >
+      matrixFree(GaussianKernel(1.0));
+
+  arma::mat transformedData, eigvec;
+  arma::vec eigval;
+  p.Apply(dataset, transformedData, eigval, eigvec);
+
+  arma::mat partialTransformedData, partialEigvec;
+  arma::vec partialEigval;
+  matrixFree.Apply(dataset, partialTransformedData, partialEigval,
+      partialEigvec, 4);
+
+  CheckTopDimensions(eigval, transformedData, partialEigval,
+      partialTransformedData, 4);
+
+  // Reducing the dimensionality in place should give the same dimensions.
+  matrixFree.Apply(dataset, 4);
+  BOOST_REQUIRE_EQUAL(dataset.n_rows, 4);
+  CheckTopDimensions(eigval, transformedData, partialEigval, dataset, 4);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -5,6 +5,7 @@
  *
  * Tests for the various kernel classes.
  */
+#include <mlpack/core/kernels/batch_evaluate.hpp>
 #include <mlpack/core/kernels/cosine_distance.hpp>
 #include <mlpack/core/kernels/epanechnikov_kernel.hpp>
 #include <mlpack/core/kernels/gaussian_kernel.hpp>
@@ -203,6 +204,40 @@ BOOST_AUTO_TEST_CASE(md_full_covariance)
   BOOST_REQUIRE_CLOSE(md.Evaluate(b, a), 15.7, 1e-5);
 }
 
+/**
+ * Make sure that the Euclidean distance between transformed points is the
+ * Mahalanobis distance, for a positive definite covariance matrix and for a
+ * singular one, and that an indefinite covariance matrix is rejected.
+ */
+BOOST_AUTO_TEST_CASE(md_transformation)
+{
+  arma::mat r = arma::randu<arma::mat>(5, 5);
+  MahalanobisDistance<false> md(r * trans(r) + arma::eye<arma::mat>(5, 5));
+
+  // A covariance matrix of rank 1.
+  arma::vec v = arma::randu<arma::vec>(5);
+  MahalanobisDistance<false> singular(v * trans(v));
+
+  const arma::mat w = md.Transformation();
+  const arma::mat singularW = singular.Transformation();
+  for (size_t i = 0; i < 10; ++i)
+  {
+    arma::vec a = arma::randu<arma::vec>(5);
+    arma::vec b = arma::randu<arma::vec>(5);
+
+    BOOST_REQUIRE_CLOSE(std::pow(arma::norm(w * a - w * b, 2), 2.0),
+        md.Evaluate(a, b), 1e-5);
+    // The distance may be nearly 0 here, so check the absolute difference.
+    BOOST_REQUIRE_SMALL(std::pow(arma::norm(singularW * a - singularW * b, 2),
+        2.0) - singular.Evaluate(a, b), 1e-8);
+  }
+
+  arma::mat indefinite = arma::eye<arma::mat>(3, 3);
+  indefinite(1, 1) = -1.0;
+  MahalanobisDistance<> bad(indefinite);
+  BOOST_REQUIRE_THROW(bad.Transformation(), std::invalid_argument);
+}
+
 /**
  * Simple test case for the cosine distance.
  */
@@ -239,6 +274,38 @@ BOOST_AUTO_TEST_CASE(cosine_distance_random_test)
   BOOST_REQUIRE_CLOSE(CosineDistance::Evaluate(b, a), 0.1385349024, 1e-5);
 }
 
+/**
+ * Make sure that the cosine distance with precomputed norms and the cosine
+ * distance between normalized points are the same as the cosine distance.
+ */
+BOOST_AUTO_TEST_CASE(cosine_distance_norms_test)
+{
+  arma::mat dataset = arma::randu<arma::mat>(5, 20) - 0.5;
+  dataset.col(3).zeros();
+
+  const arma::vec norms = CosineDistance::Norms(dataset);
+  arma::mat normalized(dataset);
+  CosineDistance::Normalize(normalized);
+
+  BOOST_REQUIRE_EQUAL(norms.n_elem, dataset.n_cols);
+  BOOST_REQUIRE_SMALL(arma::norm(normalized.col(3), 2), 1e-10);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(norms[i] + 1.0, arma::norm(dataset.col(i), 2) + 1.0,
+        1e-10);
+
+    for (size_t j = 0; j < dataset.n_cols; ++j)
+    {
+      const double distance = CosineDistance::Evaluate(dataset.col(i),
+          dataset.col(j));
+      BOOST_REQUIRE_SMALL(CosineDistance::Evaluate(dataset.col(i),
+          dataset.col(j), norms[i], norms[j]) - distance, 1e-10);
+      BOOST_REQUIRE_SMALL(arma::dot(normalized.col(i), normalized.col(j)) -
+          distance, 1e-10);
+    }
+  }
+}
+
 /**
  * Linear Kernel test.
  */
@@ -356,6 +423,83 @@ BOOST_AUTO_TEST_CASE(polynomial_kernel)
   BOOST_REQUIRE_CLOSE(pk.Evaluate(b, a), 3125.0, 0);
 }
 
+/**
+ * Make sure the batch evaluation of a kernel gives the same values as
+ * evaluating each pair separately, both for kernels with their own batch
+ * evaluation and for the default one.
+ */
+template<typename KernelType>
+void CheckBatchEvaluate(KernelType& kernel)
+{
+  arma::mat a = arma::randu<arma::mat>(4, 7);
+  arma::mat b = arma::randu<arma::mat>(4, 5);
+
+  arma::mat k;
+  BatchEvaluate(kernel, a, b, k);
+
+  BOOST_REQUIRE_EQUAL(k.n_rows, 7);
+  BOOST_REQUIRE_EQUAL(k.n_cols, 5);
+  for (size_t i = 0; i < a.n_cols; ++i)
+    for (size_t j = 0; j < b.n_cols; ++j)
+      BOOST_REQUIRE_CLOSE(k(i, j), kernel.Evaluate(a.col(i), b.col(j)), 1e-5);
+}
+
+BOOST_AUTO_TEST_CASE(BatchEvaluateTest)
+{
+  BOOST_REQUIRE(HasBatchEvaluate<LinearKernel>::value);
+  BOOST_REQUIRE(HasBatchEvaluate<PolynomialKernel>::value);
+  BOOST_REQUIRE(HasBatchEvaluate<GaussianKernel>::value);
+  BOOST_REQUIRE(HasBatchEvaluate<HyperbolicTangentKernel>::value);
+  BOOST_REQUIRE(!HasBatchEvaluate<LaplacianKernel>::value);
+
+  LinearKernel lk;
+  CheckBatchEvaluate(lk);
+  PolynomialKernel pk(3.0, 1.5);
+  CheckBatchEvaluate(pk);
+  GaussianKernel gk(0.7);
+  CheckBatchEvaluate(gk);
+  HyperbolicTangentKernel tk(0.5, 0.2);
+  CheckBatchEvaluate(tk);
+  LaplacianKernel lpk(0.9);
+  CheckBatchEvaluate(lpk);
+}
+
+/**
+ * Make sure the tiled kernel matrices match evaluating each pair separately,
+ * when the sets are larger than one tile.
+ */
+template<typename KernelType>
+void CheckKernelMatrix(KernelType& kernel)
+{
+  arma::mat a = arma::randu<arma::mat>(3, 2 * kernelMatrixTileSize + 17);
+  arma::mat b = arma::randu<arma::mat>(3, kernelMatrixTileSize + 5);
+
+  arma::mat k;
+  KernelMatrix(kernel, a, k);
+  BOOST_REQUIRE_EQUAL(k.n_rows, a.n_cols);
+  BOOST_REQUIRE_EQUAL(k.n_cols, a.n_cols);
+  for (size_t i = 0; i < a.n_cols; ++i)
+    for (size_t j = 0; j < a.n_cols; ++j)
+      BOOST_REQUIRE_CLOSE(k(i, j), kernel.Evaluate(a.col(i), a.col(j)), 1e-5);
+
+  KernelMatrix(kernel, a, b, k);
+  BOOST_REQUIRE_EQUAL(k.n_rows, a.n_cols);
+  BOOST_REQUIRE_EQUAL(k.n_cols, b.n_cols);
+  for (size_t i = 0; i < a.n_cols; ++i)
+    for (size_t j = 0; j < b.n_cols; ++j)
+      BOOST_REQUIRE_CLOSE(k(i, j), kernel.Evaluate(a.col(i), b.col(j)), 1e-5);
+}
+
+BOOST_AUTO_TEST_CASE(KernelMatrixTest)
+{
+  GaussianKernel gk(0.7);
+  CheckKernelMatrix(gk);
+  PolynomialKernel pk(2.0, 1.0);
+  CheckKernelMatrix(pk);
+  LaplacianKernel lpk(0.9);
+  CheckKernelMatrix(lpk);
+}
+
 BOOST_AUTO_TEST_CASE(hyperbolic_tangent_kernel)
 {
   arma::vec a = "0 0 1";
@@ -402,135 +546,135 @@ BOOST_AUTO_TEST_CASE(PSpectrumSubstringExtractionTest)
   PSpectrumStringKernel p(datasets, 3);
 
   // Ensure the sizes are correct.
-  BOOST_REQUIRE_EQUAL(p.Counts().size(), 2);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0].size(), 4);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1].size(), 7);
+  BOOST_REQUIRE_EQUAL(p.NumDatasets(), 2);
+  BOOST_REQUIRE_EQUAL(p.NumStrings(0), 4);
+  BOOST_REQUIRE_EQUAL(p.NumStrings(1), 7);
 
   // herpgle: her, erp, rpg, pgl, gle
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][0].size(), 5);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][0]["her"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][0]["erp"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][0]["rpg"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][0]["pgl"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][0]["gle"], 1);
+  BOOST_REQUIRE_EQUAL(p.SpectrumSize(0, 0), 5);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 0, "her"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 0, "erp"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 0, "rpg"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 0, "pgl"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 0, "gle"), 1);
 
   // herpagkle: her, erp, rpa, pag, agk, gkl, kle
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1].size(), 7);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1]["her"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1]["erp"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1]["rpa"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1]["pag"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1]["agk"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1]["gkl"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][1]["kle"], 1);
+  BOOST_REQUIRE_EQUAL(p.SpectrumSize(0, 1), 7);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "her"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "erp"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "rpa"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "pag"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "agk"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "gkl"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 1, "kle"), 1);
 
   // klunktor: klu, lun, unk, nkt, kto, tor
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][2].size(), 6);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][2]["klu"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][2]["lun"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][2]["unk"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][2]["nkt"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][2]["kto"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][2]["tor"], 1);
+  BOOST_REQUIRE_EQUAL(p.SpectrumSize(0, 2), 6);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 2, "klu"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 2, "lun"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 2, "unk"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 2, "nkt"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 2, "kto"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 2, "tor"), 1);
 
   // flibbynopple: fli lib ibb bby byn yno nop opp ppl ple
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3].size(), 10);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["fli"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["lib"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["ibb"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["bby"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["byn"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["yno"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["nop"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["opp"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["ppl"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[0][3]["ple"], 1);
+  BOOST_REQUIRE_EQUAL(p.SpectrumSize(0, 3), 10);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "fli"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "lib"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "ibb"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "bby"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "byn"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "yno"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "nop"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "opp"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "ppl"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(0, 3, "ple"), 1);
 
   // floggy3245: flo log ogg ggy gy3 y32 324 245
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0].size(), 8);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["flo"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["log"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["ogg"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["ggy"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["gy3"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["y32"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["324"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][0]["245"], 1);
+  BOOST_REQUIRE_EQUAL(p.SpectrumSize(1, 0), 8);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "flo"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "log"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "ogg"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "ggy"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "gy3"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "y32"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "324"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 0, "245"), 1);
 
   // flippydopflip: fli lip ipp ppy pyd ydo dop opf pfl fli lip
   // fli(2) lip(2) ipp ppy pyd ydo dop opf pfl
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1].size(), 9);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["fli"], 2);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["lip"], 2);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["ipp"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["ppy"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["pyd"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["ydo"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["dop"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["opf"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][1]["pfl"], 1);
+  BOOST_REQUIRE_EQUAL(p.SpectrumSize(1, 1), 9);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "fli"), 2);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "lip"), 2);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "ipp"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "ppy"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "pyd"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "ydo"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "dop"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "opf"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 1, "pfl"), 1);
 
   // stupid fricking cat: stu tup upi pid fri ric ick cki kin ing cat
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2].size(), 11);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["stu"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["tup"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["upi"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["pid"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["fri"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["ric"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["ick"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["cki"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["kin"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["ing"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][2]["cat"], 1);
+  BOOST_REQUIRE_EQUAL(p.SpectrumSize(1, 2), 11);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "stu"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "tup"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "upi"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "pid"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "fri"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "ric"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "ick"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "cki"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "kin"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "ing"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "cat"), 1);
 
   // food time isn't until later: foo ood tim ime isn unt nti til lat ate ter
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3].size(), 11);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["foo"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["ood"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["tim"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["ime"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["isn"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["unt"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["nti"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["til"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["lat"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["ate"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][3]["ter"], 1);
+  BOOST_REQUIRE_EQUAL(p.SpectrumSize(1, 3), 11);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "foo"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "ood"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "tim"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "ime"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "isn"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "unt"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "nti"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "til"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "lat"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "ate"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 3, "ter"), 1);
 
   // leave me alone until 6:00: lea eav ave alo lon one unt nti til
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4].size(), 9);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["lea"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["eav"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["ave"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["alo"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["lon"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["one"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["unt"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["nti"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][4]["til"], 1);
+  BOOST_REQUIRE_EQUAL(p.SpectrumSize(1, 4), 9);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "lea"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "eav"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "ave"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "alo"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "lon"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "one"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "unt"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "nti"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 4, "til"), 1);
 
   // only after that do you get any food.:
   // onl nly aft fte ter tha hat you get any foo ood
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5].size(), 12);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["onl"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["nly"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["aft"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["fte"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["ter"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["tha"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["hat"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["you"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["get"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["any"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["foo"], 1);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][5]["ood"], 1);
+  BOOST_REQUIRE_EQUAL(p.SpectrumSize(1, 5), 12);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "onl"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "nly"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "aft"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "fte"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "ter"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "tha"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "hat"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "you"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "get"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "any"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "foo"), 1);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 5, "ood"), 1);
 
   // obloblobloblobloblobloblob: obl(8) blo(8) lob(8)
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][6].size(), 3);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][6]["obl"], 8);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][6]["blo"], 8);
-  BOOST_REQUIRE_EQUAL(p.Counts()[1][6]["lob"], 8);
+  BOOST_REQUIRE_EQUAL(p.SpectrumSize(1, 6), 3);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 6, "obl"), 8);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 6, "blo"), 8);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 6, "lob"), 8);
 }
 
 BOOST_AUTO_TEST_CASE(PSpectrumStringEvaluateTest)
@@ -590,4 +734,59 @@ BOOST_AUTO_TEST_CASE(PSpectrumStringEvaluateTest)
   BOOST_REQUIRE_CLOSE(p.Evaluate(b, a), 11.0, 1e-5);
 }
 
+/**
+ * Make sure the batch evaluation of the p-spectrum kernel (and so the kernel
+ * matrix) matches the kernel evaluated one pair at a time, and that the
+ * substrings are sorted.
+ */
+BOOST_AUTO_TEST_CASE(PSpectrumStringBatchEvaluateTest)
+{
+  std::vector<std::vector<std::string> > datasets(2);
+  datasets[0].push_back("hello");
+  datasets[0].push_back("jello");
+  datasets[0].push_back("mellow jello");
+  datasets[0].push_back("");
+  datasets[1].push_back("obloblobloblob");
+  datasets[1].push_back("yellow bellow");
+  datasets[1].push_back("hello, hello, hello");
+
+  PSpectrumStringKernel p(datasets, 3);
+
+  for (size_t i = 1; i < p.Substrings().size(); ++i)
+    BOOST_REQUIRE_LT(p.Substrings()[i - 1], p.Substrings()[i]);
+  BOOST_REQUIRE_EQUAL(p.SpectrumSize(0, 3), 0);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "hel"), 3);
+  BOOST_REQUIRE_EQUAL(p.Count(1, 2, "zzz"), 0);
+
+  arma::mat strings(2, 7);
+  for (size_t i = 0; i < 7; ++i)
+  {
+    strings(0, i) = (i < 4) ? 0 : 1;
+    strings(1, i) = (i < 4) ? i : i - 4;
+  }
+
+  const arma::mat someStrings = strings.cols(1, 5);
+  arma::mat k;
+  p.Evaluate(strings, someStrings, k);
+  BOOST_REQUIRE_EQUAL(k.n_rows, 7);
+  BOOST_REQUIRE_EQUAL(k.n_cols, 5);
+
+  arma::mat kernelMatrix;
+  KernelMatrix(p, strings, kernelMatrix);
+
+  for (size_t i = 0; i < 7; ++i)
+  {
+    for (size_t j = 0; j < 7; ++j)
+    {
+      const arma::vec a = strings.col(i);
+      const arma::vec b = strings.col(j);
+      const double kernel = p.Evaluate(a, b);
+
+      BOOST_REQUIRE_EQUAL(kernelMatrix(i, j), kernel);
+      if (j >= 1 && j <= 5)
+        BOOST_REQUIRE_EQUAL(k(i, j - 1), kernel);
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -56,4 +56,28 @@ BOOST_AUTO_TEST_CASE(IsNormalizedTest)
       false);
 }
 
+BOOST_AUTO_TEST_CASE(DecreasesWithDistanceTest)
+{
+  // The kernels that KDE can bound from a range of distances.
+  BOOST_REQUIRE_EQUAL((bool) KernelTraits<int>::DecreasesWithDistance, false);
+  BOOST_REQUIRE_EQUAL(
+      (bool) KernelTraits<EpanechnikovKernel>::DecreasesWithDistance, true);
+  BOOST_REQUIRE_EQUAL(
+      (bool) KernelTraits<GaussianKernel>::DecreasesWithDistance, true);
+  BOOST_REQUIRE_EQUAL(
+      (bool) KernelTraits<LaplacianKernel>::DecreasesWithDistance, true);
+  BOOST_REQUIRE_EQUAL(
+      (bool) KernelTraits<SphericalKernel>::DecreasesWithDistance, true);
+  BOOST_REQUIRE_EQUAL(
+      (bool) KernelTraits<TriangularKernel>::DecreasesWithDistance, true);
+
+  // Kernels that do not only depend on the distance.
+  BOOST_REQUIRE_EQUAL(
+      (bool) KernelTraits<CosineDistance>::DecreasesWithDistance, false);
+  BOOST_REQUIRE_EQUAL(
+      (bool) KernelTraits<LinearKernel>::DecreasesWithDistance, false);
+  BOOST_REQUIRE_EQUAL(
+      (bool) KernelTraits<PolynomialKernel>::DecreasesWithDistance, false);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
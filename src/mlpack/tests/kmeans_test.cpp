@@ -7,8 +7,13 @@
 #include <mlpack/methods/kmeans/kmeans.hpp>
 #include <mlpack/methods/kmeans/allow_empty_clusters.hpp>
 #include <mlpack/methods/kmeans/refined_start.hpp>
+#include <mlpack/methods/kmeans/kmeans_plus_plus.hpp>
+#include <mlpack/methods/kmeans/kmeans_parallel.hpp>
 #include <mlpack/methods/kmeans/elkan_kmeans.hpp>
 #include <mlpack/methods/kmeans/hamerly_kmeans.hpp>
+#include <mlpack/methods/kmeans/yinyang_kmeans.hpp>
+#include <mlpack/methods/kmeans/mini_batch_kmeans.hpp>
+#include <mlpack/methods/kmeans/chunked_kmeans.hpp>
 #include <mlpack/methods/kmeans/pelleg_moore_kmeans.hpp>
 #include <mlpack/methods/kmeans/dual_tree_kmeans.hpp>
 
@@ -444,6 +449,86 @@ BOOST_AUTO_TEST_CASE(RefinedStartTest)
   BOOST_REQUIRE_LT(distortion, 14000.0);
 }
 
+/**
+ * Create five well-separated Gaussians of 1000 points each, for the seeding
+ * tests.
+ */
+void SeparatedGaussians(arma::mat& data, arma::Col<size_t>& labels)
+{
+  arma::mat centers(" 0  100 -100    0    0;"
+                    " 0    0    0  100 -100;"
+                    " 0  100  100 -100 -100");
+
+  data.randn(3, 5000);
+  labels.set_size(5000);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    labels[i] = i / 1000;
+    data.col(i) += centers.col(labels[i]);
+  }
+}
+
+/**
+ * Make sure that each Gaussian is given one cluster of its own.
+ */
+void CheckSeparatedGaussians(const arma::Col<size_t>& labels,
+                             const arma::Col<size_t>& assignments)
+{
+  arma::Col<size_t> clusterOf(5);
+  clusterOf.fill(5);
+  std::vector<bool> used(5, false);
+  for (size_t i = 0; i < labels.n_elem; ++i)
+  {
+    BOOST_REQUIRE_LT(assignments[i], (size_t) 5);
+    if (clusterOf[labels[i]] == 5)
+    {
+      BOOST_REQUIRE(!used[assignments[i]]);
+      clusterOf[labels[i]] = assignments[i];
+      used[assignments[i]] = true;
+    }
+
+    BOOST_REQUIRE_EQUAL(assignments[i], clusterOf[labels[i]]);
+  }
+}
+
+/**
+ * Make sure the k-means++ seeding gives one cluster to each of several
+ * well-separated Gaussians.
+ */
+BOOST_AUTO_TEST_CASE(KMeansPlusPlusTest)
+{
+  arma::mat data;
+  arma::Col<size_t> labels;
+  SeparatedGaussians(data, labels);
+
+  arma::Col<size_t> assignments;
+  KMeansPlusPlus::Cluster(data, 5, assignments);
+
+  CheckSeparatedGaussians(labels, assignments);
+}
+
+/**
+ * Make sure the k-means|| seeding gives one cluster to each of several
+ * well-separated Gaussians, and that it works as the partitioner of KMeans.
+ */
+BOOST_AUTO_TEST_CASE(KMeansParallelTest)
+{
+  arma::mat data;
+  arma::Col<size_t> labels;
+  SeparatedGaussians(data, labels);
+
+  KMeansParallel kmp(2.0, 5);
+  arma::Col<size_t> assignments;
+  kmp.Cluster(data, 5, assignments);
+
+  CheckSeparatedGaussians(labels, assignments);
+
+  KMeans<metric::EuclideanDistance, KMeansParallel> kmeans;
+  kmeans.Cluster(data, 5, assignments);
+
+  CheckSeparatedGaussians(labels, assignments);
+}
+
 #ifdef ARMA_HAS_SPMAT
 // Can't do this test on Armadillo 3.4; var(SpBase) is not implemented.
 #if !((ARMA_VERSION_MAJOR == 3) && (ARMA_VERSION_MINOR == 4))
@@ -529,6 +614,123 @@ BOOST_AUTO_TEST_CASE(ElkanTest)
   }
 }
 
+/**
+ * Make sure the Yinyang algorithm gives the same clusters as the naive method,
+ * with enough clusters that the centroids are split into several groups.
+ */
+BOOST_AUTO_TEST_CASE(YinyangTest)
+{
+  const size_t trials = 5;
+
+  for (size_t t = 0; t < trials; ++t)
+  {
+    arma::mat dataset(10, 1000);
+    dataset.randu();
+
+    const size_t k = 20 * (t + 1);
+    arma::mat centroids(10, k);
+    centroids.randu();
+
+    arma::mat naiveCentroids(centroids);
+    KMeans<> km;
+    arma::Col<size_t> assignments;
+    km.Cluster(dataset, k, assignments, naiveCentroids, false, true);
+
+    KMeans<metric::EuclideanDistance, RandomPartition, MaxVarianceNewCluster,
+        YinyangKMeans> yinyang;
+    arma::Col<size_t> yinyangAssignments;
+    arma::mat yinyangCentroids(centroids);
+    yinyang.Cluster(dataset, k, yinyangAssignments, yinyangCentroids, false,
+        true);
+
+    for (size_t i = 0; i < dataset.n_cols; ++i)
+      BOOST_REQUIRE_EQUAL(assignments[i], yinyangAssignments[i]);
+
+    for (size_t i = 0; i < centroids.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(naiveCentroids[i], yinyangCentroids[i], 1e-5);
+  }
+}
+
+/**
+ * Make sure that mini-batch k-means finds well-separated clusters, and that
+ * every point is assigned to the right one.
+ */
+BOOST_AUTO_TEST_CASE(MiniBatchTest)
+{
+  arma::mat centers("0.0 10.0 -10.0;"
+                    "0.0 10.0 10.0;"
+                    "0.0 10.0 -10.0");
+
+  arma::mat dataset(3, 3000);
+  arma::Col<size_t> labels(3000);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    labels[i] = i % 3;
+    dataset.col(i) = centers.col(labels[i]) + arma::randn<arma::vec>(3);
+  }
+
+  arma::mat centroids = centers + 1.0;
+  KMeans<metric::EuclideanDistance, RandomPartition, MaxVarianceNewCluster,
+      MiniBatchKMeans> miniBatch;
+  arma::Col<size_t> assignments;
+  miniBatch.Cluster(dataset, 3, assignments, centroids, false, true);
+
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    BOOST_REQUIRE_EQUAL(assignments[i], labels[i]);
+
+  // Each centroid should be close to the mean of its points.
+  arma::mat means(3, 3);
+  means.zeros();
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    means.col(labels[i]) += dataset.col(i) / 1000.0;
+
+  for (size_t c = 0; c < 3; ++c)
+    BOOST_REQUIRE_SMALL(arma::norm(centroids.col(c) - means.col(c), 2), 0.2);
+}
+
+/**
+ * Make sure that clustering a dataset on disk in chunks gives the same result
+ * as clustering it in memory.
+ */
+BOOST_AUTO_TEST_CASE(ChunkedKMeansTest)
+{
+  arma::mat dataset(5, 1000);
+  dataset.randu();
+  BOOST_REQUIRE(dataset.quiet_save("chunked_kmeans_test.bin",
+      arma::arma_binary));
+
+  arma::mat centroids(5, 8);
+  centroids.randu();
+
+  arma::mat naiveCentroids(centroids);
+  KMeans<> km;
+  arma::Col<size_t> assignments;
+  km.Cluster(dataset, 8, assignments, naiveCentroids, false, true);
+
+  std::ostringstream labels;
+  {
+    data::ChunkedReader reader("chunked_kmeans_test.bin", 150);
+    ChunkedKMeans<> chunked;
+    arma::mat chunkedCentroids(centroids);
+    chunked.Cluster(reader, 8, chunkedCentroids, true);
+
+    for (size_t i = 0; i < centroids.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(chunkedCentroids[i], naiveCentroids[i], 1e-5);
+
+    chunked.Assign(reader, chunkedCentroids, labels);
+  }
+
+  std::istringstream labelStream(labels.str());
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    size_t label;
+    BOOST_REQUIRE(labelStream >> label);
+    BOOST_REQUIRE_EQUAL(label, assignments[i]);
+  }
+
+  remove("chunked_kmeans_test.bin");
+}
+
 BOOST_AUTO_TEST_CASE(HamerlyTest)
 {
   const size_t trials = 5;
@@ -662,4 +864,258 @@ BOOST_AUTO_TEST_CASE(DTNNCoverTreeTest)
   }
 }
 
+/**
+ * Compute one Lloyd iteration by hand, for comparison with NaiveKMeans.
+ */
+template<typename MetricType>
+void ManualIterate(const arma::mat& dataset,
+                   const arma::mat& centroids,
+                   arma::mat& newCentroids,
+                   arma::Col<size_t>& counts)
+{
+  newCentroids.zeros(centroids.n_rows, centroids.n_cols);
+  counts.zeros(centroids.n_cols);
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    size_t closest = 0;
+    for (size_t j = 1; j < centroids.n_cols; ++j)
+      if (MetricType::Evaluate(dataset.col(i), centroids.col(j)) <
+          MetricType::Evaluate(dataset.col(i), centroids.col(closest)))
+        closest = j;
+
+    newCentroids.col(closest) += dataset.col(i);
+    ++counts[closest];
+  }
+
+  for (size_t j = 0; j < centroids.n_cols; ++j)
+    if (counts[j] != 0)
+      newCentroids.col(j) /= counts[j];
+    else
+      newCentroids.col(j).fill(DBL_MAX);
+}
+
+/**
+ * Make sure that a NaiveKMeans iteration (which splits the points into blocks,
+ * and across threads) gives the same result as the simple loop, both when the
+ * distances are computed with matrix multiplication and when they are not, and
+ * that it gives the same result every time.
+ */
+BOOST_AUTO_TEST_CASE(NaiveKMeansIterateTest)
+{
+  arma::mat dataset(10, 1000);
+  dataset.randu();
+  arma::mat centroids(10, 30);
+  centroids.randu();
+
+  arma::mat manualCentroids;
+  arma::Col<size_t> manualCounts;
+
+  // The squared Euclidean distance uses matrix multiplication.
+  metric::SquaredEuclideanDistance sed;
+  NaiveKMeans<metric::SquaredEuclideanDistance, arma::mat> sedKMeans(dataset,
+      sed);
+  arma::mat newCentroids, repeatCentroids;
+  arma::Col<size_t> counts, repeatCounts;
+  sedKMeans.Iterate(centroids, newCentroids, counts);
+  sedKMeans.Iterate(centroids, repeatCentroids, repeatCounts);
+  ManualIterate<metric::SquaredEuclideanDistance>(dataset, centroids,
+      manualCentroids, manualCounts);
+
+  for (size_t j = 0; j < centroids.n_cols; ++j)
+  {
+    BOOST_REQUIRE_EQUAL(counts[j], manualCounts[j]);
+    BOOST_REQUIRE_EQUAL(repeatCounts[j], counts[j]);
+  }
+  for (size_t i = 0; i < newCentroids.n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(newCentroids[i], manualCentroids[i], 1e-5);
+    BOOST_REQUIRE_EQUAL(repeatCentroids[i], newCentroids[i]);
+  }
+
+  // The Manhattan distance does not.
+  metric::ManhattanDistance md;
+  NaiveKMeans<metric::ManhattanDistance, arma::mat> mdKMeans(dataset, md);
+  mdKMeans.Iterate(centroids, newCentroids, counts);
+  ManualIterate<metric::ManhattanDistance>(dataset, centroids,
+      manualCentroids, manualCounts);
+
+  for (size_t j = 0; j < centroids.n_cols; ++j)
+    BOOST_REQUIRE_EQUAL(counts[j], manualCounts[j]);
+  for (size_t i = 0; i < newCentroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(newCentroids[i], manualCentroids[i], 1e-5);
+}
+
+/**
+ * Make sure that dual-tree k-means gives the same iterations as the simple loop
+ * when the centroid tree is kept between iterations, even when the tree is
+ * never rebuilt.
+ */
+BOOST_AUTO_TEST_CASE(DualTreeKMeansTreeReuseTest)
+{
+  arma::mat dataset(5, 2000);
+  dataset.randu();
+
+  const double thresholds[] = { 0.05, 0.5, DBL_MAX };
+  for (size_t t = 0; t < 3; ++t)
+  {
+    metric::EuclideanDistance metric;
+    DefaultDualTreeKMeans<metric::EuclideanDistance, arma::mat> dtkm(dataset,
+        metric);
+    dtkm.RebuildThreshold() = thresholds[t];
+
+    // Start from points of the dataset, so that no cluster is empty at first.
+    arma::mat centroids = dataset.cols(0, 19);
+    arma::mat newCentroids, manualCentroids;
+    arma::Col<size_t> counts, manualCounts;
+    size_t iterations = 0;
+    for (; iterations < 30; ++iterations)
+    {
+      dtkm.Iterate(centroids, newCentroids, counts);
+      ManualIterate<metric::EuclideanDistance>(dataset, centroids,
+          manualCentroids, manualCounts);
+
+      for (size_t j = 0; j < centroids.n_cols; ++j)
+        BOOST_REQUIRE_EQUAL(counts[j], manualCounts[j]);
+      for (size_t i = 0; i < newCentroids.n_elem; ++i)
+        BOOST_REQUIRE_CLOSE(newCentroids[i], manualCentroids[i], 1e-5);
+
+      // Empty clusters would need an empty cluster policy.
+      if (arma::any(counts == 0))
+        break;
+
+      centroids.swap(newCentroids);
+    }
+
+    if (thresholds[t] == DBL_MAX)
+      BOOST_REQUIRE_EQUAL(dtkm.CentroidTreeBuilds(), (size_t) 1);
+    else if (iterations == 30)
+      BOOST_REQUIRE_LT(dtkm.CentroidTreeBuilds(), iterations);
+  }
+}
+
+// Find the sum of the squared distances from each point to its closest
+// centroid.
+double KMeansInertia(const arma::mat& data, const arma::mat& centroids)
+{
+  double inertia = 0.0;
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    double minDistance = DBL_MAX;
+    for (size_t j = 0; j < centroids.n_cols; ++j)
+      minDistance = std::min(minDistance,
+          EuclideanDistance::Evaluate(data.col(i), centroids.col(j)));
+    inertia += minDistance * minDistance;
+  }
+
+  return inertia;
+}
+
+/**
+ * With restarts, k-means should keep the centroids of the restart with the
+ * lowest inertia; each restart draws from its own split of the first random
+ * stream after the seed is set, so the restarts can be run again one by one.
+ */
+BOOST_AUTO_TEST_CASE(KMeansRestartsTest)
+{
+  arma::mat dataset(3, 600);
+  dataset.randn();
+  for (size_t i = 0; i < dataset.n_cols; i += 3)
+    dataset.col(i) += 6.0;
+  for (size_t i = 1; i < dataset.n_cols; i += 3)
+    dataset.col(i) -= 6.0;
+
+  const size_t restarts = 6;
+  math::RandomSeed(42);
+  arma::mat centroids;
+  KMeans<> kmeans(1000, EuclideanDistance(), RandomPartition(),
+      MaxVarianceNewCluster(), restarts);
+  kmeans.Cluster(dataset, 8, centroids);
+
+  // Run each restart by itself.
+  const math::RandomStream stream(42, 0);
+  double bestInertia = DBL_MAX;
+  arma::mat bestCentroids;
+  for (size_t r = 0; r < restarts; ++r)
+  {
+    math::RandomStream restartStream = stream.Split(r);
+    math::ScopedRandomStream scope(restartStream);
+
+    arma::mat restartCentroids;
+    KMeans<> single;
+    single.Cluster(dataset, 8, restartCentroids);
+
+    const double inertia = KMeansInertia(dataset, restartCentroids);
+    if (inertia < bestInertia)
+    {
+      bestInertia = inertia;
+      bestCentroids = restartCentroids;
+    }
+  }
+
+  BOOST_REQUIRE_CLOSE(KMeansInertia(dataset, centroids), bestInertia, 1e-5);
+  BOOST_REQUIRE_EQUAL(centroids.n_cols, bestCentroids.n_cols);
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(centroids[i], bestCentroids[i], 1e-5);
+
+  math::RandomSeed(std::time(NULL));
+}
+
+/**
+ * A reducer that acts as if there were the given number of processes, each
+ * with the same shard; then the results must be those on one shard.
+ */
+class ScaleReducer : public math::Reducer
+{
+ public:
+  ScaleReducer(const size_t copies) : copies(copies) { }
+
+  void Sum(double* values, const size_t n)
+  {
+    for (size_t i = 0; i < n; ++i)
+      values[i] *= copies;
+  }
+
+  void Broadcast(double* /* values */, const size_t /* n */) { }
+
+ private:
+  size_t copies;
+};
+
+/**
+ * Make sure that k-means with a reducer over identical shards gives the same
+ * centroids as k-means on one shard, and that the Lloyd steps that cannot use
+ * a reducer are refused.
+ */
+BOOST_AUTO_TEST_CASE(KMeansReducerTest)
+{
+  arma::mat dataset(3, 600);
+  dataset.randn();
+  for (size_t i = 0; i < dataset.n_cols; i += 3)
+    dataset.col(i) += 6.0;
+  for (size_t i = 1; i < dataset.n_cols; i += 3)
+    dataset.col(i) -= 6.0;
+
+  const arma::mat initialCentroids = dataset.cols(0, 4);
+  arma::mat centroids = initialCentroids;
+  KMeans<> kmeans;
+  kmeans.Cluster(dataset, 5, centroids, true);
+
+  ScaleReducer reducer(4);
+  arma::mat reducedCentroids = initialCentroids;
+  KMeans<> reducedKMeans;
+  reducedKMeans.Reducer() = &reducer;
+  reducedKMeans.Cluster(dataset, 5, reducedCentroids, true);
+
+  BOOST_REQUIRE_EQUAL(reducedCentroids.n_cols, centroids.n_cols);
+  for (size_t i = 0; i < centroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(reducedCentroids[i], centroids[i], 1e-5);
+
+  KMeans<EuclideanDistance, RandomPartition, MaxVarianceNewCluster,
+      ElkanKMeans> elkan;
+  elkan.Reducer() = &reducer;
+  arma::mat elkanCentroids = initialCentroids;
+  BOOST_REQUIRE_THROW(elkan.Cluster(dataset, 5, elkanCentroids, true),
+      std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -225,4 +225,203 @@ BOOST_AUTO_TEST_CASE(PredictRowMajorTest)
   }
 }
 
+// Make sure that two solutions are the same.
+void CheckSameSolution(const arma::vec& a, const arma::vec& b)
+{
+  BOOST_REQUIRE_EQUAL(a.n_elem, b.n_elem);
+  for (size_t i = 0; i < a.n_elem; ++i)
+  {
+    if (std::abs(a[i]) < 1e-8)
+      BOOST_REQUIRE_SMALL(b[i], 1e-8);
+    else
+      BOOST_REQUIRE_CLOSE(a[i], b[i], 1e-5);
+  }
+}
+
+// Make sure that warm starts over a decreasing sequence of lambda1 give the
+// same solutions as solving each problem from scratch.
+BOOST_AUTO_TEST_CASE(WarmStartTest)
+{
+  for (size_t i = 0; i < 2; ++i)
+  {
+    const bool useCholesky = bool(i);
+
+    arma::mat X;
+    arma::vec y;
+    GenerateProblem(X, y, 100, 10);
+
+    const arma::vec sortedAbsCorr = sort(abs(X * y));
+
+    LARS warmLars(useCholesky, sortedAbsCorr(9));
+    for (size_t j = 10; j > 0; --j)
+    {
+      // Use each correlation, and a value between each pair, so that the warm
+      // start sometimes only needs to interpolate again.
+      const double lambda1 = (j % 2 == 0) ? sortedAbsCorr(j - 1) :
+          0.5 * (sortedAbsCorr(j - 1) + sortedAbsCorr(j));
+
+      warmLars.Lambda1() = lambda1;
+      arma::vec warmBeta;
+      warmLars.Regress(X, y, warmBeta, true, true);
+
+      LARS coldLars(useCholesky, lambda1);
+      arma::vec coldBeta;
+      coldLars.Regress(X, y, coldBeta);
+
+      CheckSameSolution(coldBeta, warmBeta);
+    }
+  }
+}
+
+// Make sure that the solutions found from the full path are the same as the
+// solutions of each problem.
+BOOST_AUTO_TEST_CASE(PathSolutionTest)
+{
+  for (size_t i = 0; i < 2; ++i)
+  {
+    const bool useCholesky = bool(i);
+
+    arma::mat X;
+    arma::vec y;
+    GenerateProblem(X, y, 100, 10);
+
+    const arma::vec sortedAbsCorr = sort(abs(X * y));
+
+    // The value of lambda1 given to the constructor is not used by
+    // RegressPath().
+    LARS pathLars(useCholesky, 1.0);
+    pathLars.RegressPath(X, y);
+
+    for (size_t j = 0; j < 10; ++j)
+    {
+      const double lambda1 = 0.9 * sortedAbsCorr(j);
+
+      arma::vec pathBeta;
+      pathLars.PathSolution(lambda1, pathBeta);
+
+      LARS lars(useCholesky, lambda1);
+      arma::vec beta;
+      lars.Regress(X, y, beta);
+
+      CheckSameSolution(beta, pathBeta);
+    }
+  }
+}
+
+// Make sure that solving several responses at once gives the same solutions
+// as solving each one on its own.
+BOOST_AUTO_TEST_CASE(MultipleResponsesTest)
+{
+  for (size_t i = 0; i < 2; ++i)
+  {
+    const bool useCholesky = bool(i);
+
+    arma::mat X = arma::randn(10, 100);
+    arma::mat responses = trans(X) * arma::randn(10, 5);
+
+    LARS lars(useCholesky, 1.0, 0.5);
+    arma::mat beta;
+    lars.Regress(X, responses, beta);
+
+    BOOST_REQUIRE_EQUAL(beta.n_rows, 10);
+    BOOST_REQUIRE_EQUAL(beta.n_cols, 5);
+
+    for (size_t j = 0; j < responses.n_cols; ++j)
+    {
+      LARS singleLars(useCholesky, 1.0, 0.5);
+      arma::vec singleBeta;
+      singleLars.Regress(X, arma::vec(responses.col(j)), singleBeta);
+
+      CheckSameSolution(singleBeta, beta.col(j));
+    }
+  }
+}
+
+// Make sure that LARS on sparse data gives the same solutions and predictions
+// as LARS on the same data stored densely.
+BOOST_AUTO_TEST_CASE(SparseDataTest)
+{
+  for (size_t i = 0; i < 2; ++i)
+  {
+    const bool useCholesky = bool(i);
+
+    arma::mat X = arma::randn(20, 200);
+    X.elem(arma::find(arma::randu<arma::mat>(20, 200) < 0.8)).zeros();
+    const arma::sp_mat sparseX(X);
+    const arma::vec y = trans(X) * arma::randn(20);
+
+    LARS denseLars(useCholesky, 0.5, 0.1);
+    arma::vec denseBeta;
+    denseLars.Regress(X, y, denseBeta);
+
+    LARS sparseLars(useCholesky, 0.5, 0.1);
+    arma::vec sparseBeta;
+    sparseLars.Regress(sparseX, y, sparseBeta);
+    CheckSameSolution(denseBeta, sparseBeta);
+
+    arma::vec densePredictions, sparsePredictions;
+    denseLars.Predict(X, densePredictions);
+    sparseLars.Predict(sparseX, sparsePredictions);
+    CheckSameSolution(densePredictions, sparsePredictions);
+
+    // Several responses, and the whole path.
+    const arma::mat responses = trans(X) * arma::randn(20, 3);
+    arma::mat denseBetas, sparseBetas;
+    denseLars.Regress(X, responses, denseBetas);
+    sparseLars.Regress(sparseX, responses, sparseBetas);
+    for (size_t j = 0; j < responses.n_cols; ++j)
+      CheckSameSolution(denseBetas.col(j), sparseBetas.col(j));
+
+    denseLars.RegressPath(X, y);
+    sparseLars.RegressPath(sparseX, y);
+    BOOST_REQUIRE_EQUAL(denseLars.LambdaPath().size(),
+        sparseLars.LambdaPath().size());
+    for (size_t j = 0; j < denseLars.BetaPath().size(); ++j)
+      CheckSameSolution(denseLars.BetaPath()[j], sparseLars.BetaPath()[j]);
+  }
+}
+
+// Make sure that a Gram matrix given to the constructor is shared by every
+// LARS object (and copy) using it, and gives the same solutions as the one
+// LARS computes.
+BOOST_AUTO_TEST_CASE(SharedGramMatrixTest)
+{
+  for (size_t i = 0; i < 2; ++i)
+  {
+    const bool useCholesky = bool(i);
+
+    arma::mat X = arma::randn(10, 100);
+    const arma::mat responses = trans(X) * arma::randn(10, 4);
+
+    LARS internalLars(useCholesky, 1.0);
+    arma::vec internalBeta;
+    internalLars.Regress(X, arma::vec(responses.col(0)), internalBeta);
+
+    // The Gram matrix of the row-major data.
+    const arma::mat gram = X * trans(X);
+    for (size_t j = 0; j < gram.n_elem; ++j)
+      BOOST_REQUIRE_CLOSE(internalLars.GramMatrix()[j], gram[j], 1e-5);
+
+    std::vector<LARS> lars(responses.n_cols, LARS(useCholesky, gram, 1.0));
+    for (size_t j = 0; j < responses.n_cols; ++j)
+    {
+      BOOST_REQUIRE_EQUAL(&lars[j].GramMatrix(), &gram);
+
+      arma::vec beta;
+      lars[j].Regress(X, arma::vec(responses.col(j)), beta);
+
+      LARS singleLars(useCholesky, 1.0);
+      arma::vec singleBeta;
+      singleLars.Regress(X, arma::vec(responses.col(j)), singleBeta);
+      CheckSameSolution(singleBeta, beta);
+    }
+
+    // A copy of a LARS object that computed its own Gram matrix has its own
+    // copy of it.
+    LARS copy(internalLars);
+    BOOST_REQUIRE_NE(&copy.GramMatrix(), &internalLars.GramMatrix());
+    BOOST_REQUIRE_EQUAL(copy.GramMatrix().n_rows, 10);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -8,6 +8,7 @@
 #include <mlpack/core.hpp>
 #include <mlpack/core/optimizers/lbfgs/lbfgs.hpp>
 #include <mlpack/core/optimizers/lbfgs/test_functions.hpp>
+#include <mlpack/core/optimizers/function/separable_function.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -112,4 +113,61 @@ BOOST_AUTO_TEST_CASE(RosenbrockWoodFunctionTest)
   }
 }
 
+/**
+ * Make sure that the parallel objective and gradient of a SeparableFunction are
+ * the same as the objective and gradient of the function it wraps, for several
+ * block sizes.
+ */
+BOOST_AUTO_TEST_CASE(SeparableFunctionEvaluateGradientTest)
+{
+  GeneralizedRosenbrockFunction f(1000);
+  const arma::mat coordinates = arma::randu<arma::mat>(1000, 1);
+
+  arma::mat gradient;
+  const double objective = f.Evaluate(coordinates);
+  f.Gradient(coordinates, gradient);
+
+  const size_t blockSizes[] = { 1, 7, 256, 5000 };
+  for (size_t b = 0; b < 4; ++b)
+  {
+    SeparableFunction<GeneralizedRosenbrockFunction> sf(f, blockSizes[b]);
+    BOOST_REQUIRE_EQUAL(sf.NumFunctions(), 999);
+
+    arma::mat sfGradient, fusedGradient;
+    sf.Gradient(coordinates, sfGradient);
+    BOOST_REQUIRE_CLOSE(sf.Evaluate(coordinates), objective, 1e-10);
+    BOOST_REQUIRE_CLOSE(sf.EvaluateWithGradient(coordinates, fusedGradient),
+        objective, 1e-10);
+
+    BOOST_REQUIRE_EQUAL(sfGradient.n_elem, 1000);
+    BOOST_REQUIRE_EQUAL(fusedGradient.n_elem, 1000);
+    for (size_t i = 0; i < 1000; ++i)
+    {
+      BOOST_REQUIRE_CLOSE(sfGradient[i], gradient[i], 1e-8);
+      BOOST_REQUIRE_CLOSE(fusedGradient[i], gradient[i], 1e-8);
+    }
+  }
+}
+
+/**
+ * Tests the L-BFGS optimizer on the generalized Rosenbrock function when the
+ * objective and gradient are computed in parallel by a SeparableFunction.
+ */
+BOOST_AUTO_TEST_CASE(SeparableFunctionLBFGSTest)
+{
+  GeneralizedRosenbrockFunction f(64);
+  SeparableFunction<GeneralizedRosenbrockFunction> sf(f, 8);
+  L_BFGS<SeparableFunction<GeneralizedRosenbrockFunction> > lbfgs(sf, 20);
+  lbfgs.MaxIterations() = 10000;
+
+  arma::mat coords = sf.GetInitialPoint();
+  lbfgs.Optimize(coords);
+
+  double finalValue = f.Evaluate(coords);
+
+  BOOST_REQUIRE_SMALL(finalValue, 1e-5);
+  for (size_t j = 0; j < 64; j++)
+    BOOST_REQUIRE_CLOSE(coords[j], 1.0, 1e-5);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -284,4 +284,105 @@ BOOST_AUTO_TEST_CASE(TestSymKronId)
   }
 }
 
+/**
+ * The blocked covariance should match ccov(), whether the observations are
+ * given at once or in chunks; integer weights should count as copies of the
+ * observations.
+ */
+BOOST_AUTO_TEST_CASE(TestCovarianceAccumulator)
+{
+  // Shift the data far from the origin, where the covariance loses precision
+  // if it is not centered.
+  arma::mat data = arma::randn<arma::mat>(5, 3000);
+  data += 1000.0;
+  const arma::mat covariance = ccov(data);
+  const arma::vec mean = arma::mean(data, 1);
+
+  CovarianceAccumulator all;
+  all.Add(data);
+
+  CovarianceAccumulator first, second;
+  first.Add(data.cols(0, 1499));
+  first.Add(data.cols(1500, 2099));
+  second.Add(data.cols(2100, 2999));
+  first.Merge(second);
+
+  BOOST_REQUIRE_EQUAL(all.Weight(), 3000.0);
+  BOOST_REQUIRE_EQUAL(first.Weight(), 3000.0);
+  const arma::mat allCovariance = all.Covariance();
+  const arma::mat chunkedCovariance = first.Covariance();
+  for (size_t i = 0; i < covariance.n_elem; ++i)
+  {
+    BOOST_REQUIRE_SMALL(allCovariance[i] - covariance[i], 1e-5);
+    BOOST_REQUIRE_SMALL(chunkedCovariance[i] - covariance[i], 1e-5);
+  }
+  for (size_t i = 0; i < mean.n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(all.Mean()[i], mean[i], 1e-8);
+    BOOST_REQUIRE_CLOSE(first.Mean()[i], mean[i], 1e-8);
+  }
+
+  // A weight of 2 is the same as adding the observation twice.
+  arma::vec weights(1000);
+  for (size_t i = 0; i < weights.n_elem; ++i)
+    weights[i] = (i % 3 == 0) ? 2.0 : (i % 3 == 1) ? 1.0 : 0.0;
+  arma::mat copies(data.n_rows, 0);
+  for (size_t i = 0; i < weights.n_elem; ++i)
+    for (size_t j = 0; j < (size_t) weights[i]; ++j)
+      copies.insert_cols(copies.n_cols, data.col(i));
+
+  CovarianceAccumulator weighted, copied;
+  weighted.Add(data.cols(0, 999), weights);
+  copied.Add(copies);
+  BOOST_REQUIRE_EQUAL(weighted.Weight(), copied.Weight());
+  const arma::mat weightedCovariance = weighted.Covariance(1);
+  const arma::mat copiedCovariance = copied.Covariance(1);
+  for (size_t i = 0; i < weightedCovariance.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(weightedCovariance[i] - copiedCovariance[i], 1e-8);
+}
+
+/**
+ * Make sure that the in-place Center(), TransformInPlace(), and whitening
+ * functions give the same results as the out-of-place ones, over several
+ * blocks of columns.
+ */
+BOOST_AUTO_TEST_CASE(TestInPlaceTransforms)
+{
+  arma::mat data = arma::randu<arma::mat>(6, 2500);
+  data.row(2) *= 5.0;
+
+  arma::mat centered, inPlace(data);
+  Center(data, centered);
+  Center(inPlace);
+  for (size_t i = 0; i < data.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(inPlace[i] - centered[i], 1e-12);
+
+  arma::mat q;
+  RandomBasis(q, data.n_rows);
+  const arma::mat transformed = q * data;
+  inPlace = data;
+  TransformInPlace(q, inPlace);
+  for (size_t i = 0; i < data.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(inPlace[i] - transformed[i], 1e-10);
+
+  // The transformation must be square with the dimensionality of the data.
+  BOOST_REQUIRE_THROW(TransformInPlace(arma::mat(3, 6), inPlace),
+      std::invalid_argument);
+
+  arma::mat whitened, whiteningMatrix, inPlaceWhiteningMatrix;
+  WhitenUsingSVD(centered, whitened, whiteningMatrix);
+  inPlace = centered;
+  WhitenUsingSVD(inPlace, inPlaceWhiteningMatrix);
+  for (size_t i = 0; i < whiteningMatrix.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(inPlaceWhiteningMatrix[i] - whiteningMatrix[i], 1e-10);
+  for (size_t i = 0; i < whitened.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(inPlace[i] - whitened[i], 1e-10);
+
+  WhitenUsingEig(centered, whitened, whiteningMatrix);
+  inPlace = centered;
+  WhitenUsingEig(inPlace, inPlaceWhiteningMatrix);
+  for (size_t i = 0; i < whitened.n_elem; ++i)
+    BOOST_REQUIRE_SMALL(inPlace[i] - whitened[i], 1e-10);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -194,4 +194,56 @@ BOOST_AUTO_TEST_CASE(LinearRegressionTrainTest)
     BOOST_REQUIRE_CLOSE(lr.Parameters()[i], lrTrain.Parameters()[i], 1e-5);
 }
 
+/**
+ * Test that a model trained from normal equations accumulated over chunks, in
+ * two accumulators which are then merged, is the same as a model trained on
+ * the whole dataset.
+ */
+BOOST_AUTO_TEST_CASE(NormalEquationsTrainTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(5, 5000);
+  arma::vec responses = arma::randu<arma::vec>(5000);
+  arma::vec weights = arma::randu<arma::vec>(5000);
+
+  for (size_t i = 0; i < 4; ++i)
+  {
+    const bool intercept = (i % 2 == 0);
+    const double lambda = (i < 2) ? 0.0 : 0.3;
+
+    LinearRegression lr(dataset, responses, lambda, intercept, weights);
+
+    // Add chunks of different sizes to both accumulators.
+    NormalEquations equations(5, intercept), otherEquations(5, intercept);
+    equations.Add(dataset.cols(0, 1999), responses.subvec(0, 1999),
+        weights.subvec(0, 1999));
+    otherEquations.Add(dataset.cols(2000, 2099), responses.subvec(2000, 2099),
+        weights.subvec(2000, 2099));
+    otherEquations.Add(dataset.cols(2100, 4999), responses.subvec(2100, 4999),
+        weights.subvec(2100, 4999));
+    equations.Merge(otherEquations);
+
+    BOOST_REQUIRE_EQUAL(equations.NumPoints(), 5000);
+
+    LinearRegression lrEquations;
+    lrEquations.Lambda() = lambda;
+    lrEquations.Train(equations);
+
+    BOOST_REQUIRE_EQUAL(lrEquations.Intercept(), intercept);
+    BOOST_REQUIRE_EQUAL(lr.Parameters().n_elem,
+        lrEquations.Parameters().n_elem);
+    for (size_t j = 0; j < lr.Parameters().n_elem; ++j)
+      BOOST_REQUIRE_CLOSE(lr.Parameters()[j], lrEquations.Parameters()[j],
+          1e-5);
+  }
+}
+
+/**
+ * Make sure that accumulators of different dimensionality can't be merged.
+ */
+BOOST_AUTO_TEST_CASE(NormalEquationsMergeDimensionalityTest)
+{
+  NormalEquations equations(5), otherEquations(4);
+  BOOST_REQUIRE_THROW(equations.Merge(otherEquations), std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -7,6 +7,10 @@
 #include <sstream>
 
 #include <mlpack/core.hpp>
+#include <mlpack/core/data/mapped_matrix.hpp>
+#include <mlpack/core/data/chunked_reader.hpp>
+#include <mlpack/core/data/text_loader.hpp>
+#include <mlpack/core/data/text_saver.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -411,6 +415,774 @@ BOOST_AUTO_TEST_CASE(LoadArmaBinaryTest)
   remove("test_file.bin");
 }
 
+/**
+ * Make sure that an arma_binary file can be memory-mapped, and that the mapped
+ * matrix is not transposed.
+ */
+BOOST_AUTO_TEST_CASE(MappedMatrixTest)
+{
+  arma::mat test = arma::randu<arma::mat>(7, 100);
+  BOOST_REQUIRE(data::Save("test_file.bin", test, false, false) == true);
+
+  {
+    data::MappedMatrix mapped("test_file.bin");
+
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_rows, 7);
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_cols, 100);
+    for (size_t i = 0; i < test.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(mapped.Matrix()[i], test[i]);
+
+    // A private mapping should not write modifications back to the file.
+    mapped.Matrix()[0] = -1.0;
+  }
+
+  arma::mat reloaded;
+  BOOST_REQUIRE(reloaded.quiet_load("test_file.bin", arma::arma_binary));
+  BOOST_REQUIRE_EQUAL(reloaded[0], test[0]);
+
+  // Now a shared mapping should write modifications back.
+  {
+    data::MappedMatrix mapped("test_file.bin", true);
+    mapped.Matrix()[0] = -1.0;
+  }
+
+  BOOST_REQUIRE(reloaded.quiet_load("test_file.bin", arma::arma_binary));
+  BOOST_REQUIRE_EQUAL(reloaded[0], -1.0);
+  for (size_t i = 1; i < test.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(reloaded[i], test[i]);
+
+  remove("test_file.bin");
+}
+
+/**
+ * Make sure that a raw_binary file can be memory-mapped when the number of rows
+ * is given, and that a file of the wrong length is rejected.
+ */
+/**
+ * Make sure that an arma_binary file whose header leaves the elements unaligned
+ * is copied (and cannot be written back), and that the padded header written by
+ * data::Save() can still be loaded by Armadillo.
+ */
+BOOST_AUTO_TEST_CASE(MappedMatrixUnalignedTest)
+{
+  arma::mat test = arma::randu<arma::mat>(3, 4);
+
+  // This header is 23 characters long.
+  std::fstream f;
+  f.open("test_file.bin", std::fstream::out | std::fstream::binary);
+  f << "ARMA_MAT_BIN_FN008\n3 4\n";
+  f.write((const char*) test.memptr(), test.n_elem * sizeof(double));
+  f.close();
+
+  {
+    data::MappedMatrix mapped("test_file.bin");
+
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_rows, 3);
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_cols, 4);
+    for (size_t i = 0; i < test.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(mapped.Matrix()[i], test[i]);
+  }
+
+  BOOST_REQUIRE_THROW(data::MappedMatrix("test_file.bin", true),
+      std::runtime_error);
+
+  // The padded header should give the same matrix when Armadillo loads it.
+  BOOST_REQUIRE(data::Save("test_file.bin", test, false, false) == true);
+  arma::mat reloaded;
+  BOOST_REQUIRE(reloaded.quiet_load("test_file.bin", arma::arma_binary));
+  BOOST_REQUIRE_EQUAL(reloaded.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(reloaded.n_cols, 4);
+  for (size_t i = 0; i < test.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(reloaded[i], test[i]);
+
+  remove("test_file.bin");
+}
+
+BOOST_AUTO_TEST_CASE(MappedMatrixRawBinaryTest)
+{
+  arma::mat test = arma::randu<arma::mat>(5, 40);
+  BOOST_REQUIRE(test.quiet_save("test_file.bin", arma::raw_binary) == true);
+
+  {
+    data::MappedMatrix mapped("test_file.bin", false, 5);
+
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_rows, 5);
+    BOOST_REQUIRE_EQUAL(mapped.Matrix().n_cols, 40);
+    for (size_t i = 0; i < test.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(mapped.Matrix()[i], test[i]);
+  }
+
+  // 200 doubles are not a whole number of columns of 7 rows.
+  BOOST_REQUIRE_THROW(data::MappedMatrix("test_file.bin", false, 7),
+      std::runtime_error);
+
+  remove("test_file.bin");
+}
+
+/**
+ * Make sure that mapping a file that is not arma_binary throws an exception.
+ */
+BOOST_AUTO_TEST_CASE(MappedMatrixBadFileTest)
+{
+  std::fstream f;
+  f.open("test_file.bin", std::fstream::out);
+  f << "1 2 3 4" << std::endl;
+  f.close();
+
+  BOOST_REQUIRE_THROW(data::MappedMatrix("test_file.bin"), std::runtime_error);
+  BOOST_REQUIRE_THROW(data::MappedMatrix("nonexistent_file.bin"),
+      std::runtime_error);
+
+  remove("test_file.bin");
+}
+
+/**
+ * Make sure that a ChunkedReader gives the points of an arma_binary file in
+ * order, in chunks of the right size, and that it can start another pass.
+ */
+BOOST_AUTO_TEST_CASE(ChunkedReaderBinaryTest)
+{
+  arma::mat test = arma::randu<arma::mat>(7, 100);
+  BOOST_REQUIRE(test.quiet_save("test_file.bin", arma::arma_binary) == true);
+
+  {
+    data::ChunkedReader reader("test_file.bin", 30);
+    BOOST_REQUIRE_EQUAL(reader.Dimensionality(), 7);
+    BOOST_REQUIRE_EQUAL(reader.NumPoints(), 100);
+
+    for (size_t pass = 0; pass < 2; ++pass)
+    {
+      arma::mat chunk;
+      size_t point = 0;
+      while (reader.NextChunk(chunk))
+      {
+        BOOST_REQUIRE_EQUAL(chunk.n_rows, 7);
+        BOOST_REQUIRE_EQUAL(chunk.n_cols, std::min((size_t) 30, 100 - point));
+        for (size_t i = 0; i < chunk.n_cols; ++i, ++point)
+          for (size_t d = 0; d < 7; ++d)
+            BOOST_REQUIRE_EQUAL(chunk(d, i), test(d, point));
+      }
+
+      BOOST_REQUIRE_EQUAL(point, 100);
+      reader.Reset();
+    }
+  }
+
+  remove("test_file.bin");
+}
+
+/**
+ * Make sure that a ChunkedReader without prefetching gives the same chunks, and
+ * that it can be reset in the middle of a pass.
+ */
+BOOST_AUTO_TEST_CASE(ChunkedReaderNoPrefetchTest)
+{
+  arma::mat test = arma::randu<arma::mat>(4, 50);
+  BOOST_REQUIRE(test.quiet_save("test_file.bin", arma::arma_binary) == true);
+
+  {
+    data::ChunkedReader reader("test_file.bin", 16, false);
+    BOOST_REQUIRE(!reader.Prefetch());
+
+    arma::mat chunk;
+    BOOST_REQUIRE(reader.NextChunk(chunk));
+    BOOST_REQUIRE(reader.NextChunk(chunk));
+    BOOST_REQUIRE_EQUAL(chunk(0, 0), test(0, 16));
+
+    reader.Reset();
+    size_t point = 0;
+    while (reader.NextChunk(chunk))
+    {
+      for (size_t i = 0; i < chunk.n_cols; ++i, ++point)
+        for (size_t d = 0; d < 4; ++d)
+          BOOST_REQUIRE_EQUAL(chunk(d, i), test(d, point));
+    }
+
+    BOOST_REQUIRE_EQUAL(point, 50);
+  }
+
+  remove("test_file.bin");
+}
+
+/**
+ * Make sure that a ChunkedReader reads a CSV file with one point per line, and
+ * that it throws on a line with the wrong number of values.
+ */
+BOOST_AUTO_TEST_CASE(ChunkedReaderTextTest)
+{
+  std::fstream f;
+  f.open("test_file.csv", std::fstream::out);
+  f << "1, 2, 3" << std::endl;
+  f << "4, 5, 6" << std::endl;
+  f << std::endl;
+  f << "7, 8, 9" << std::endl;
+  f.close();
+
+  {
+    data::ChunkedReader reader("test_file.csv", 2);
+    BOOST_REQUIRE_EQUAL(reader.Dimensionality(), 3);
+    BOOST_REQUIRE_EQUAL(reader.NumPoints(), 3);
+
+    arma::mat chunk;
+    BOOST_REQUIRE(reader.NextChunk(chunk));
+    BOOST_REQUIRE_EQUAL(chunk.n_cols, 2);
+    BOOST_REQUIRE_EQUAL(chunk(0, 0), 1.0);
+    BOOST_REQUIRE_EQUAL(chunk(2, 1), 6.0);
+    BOOST_REQUIRE(reader.NextChunk(chunk));
+    BOOST_REQUIRE_EQUAL(chunk.n_cols, 1);
+    BOOST_REQUIRE_EQUAL(chunk(1, 0), 8.0);
+    BOOST_REQUIRE(!reader.NextChunk(chunk));
+  }
+
+  f.open("test_file.csv", std::fstream::out);
+  f << "1, 2, 3" << std::endl;
+  f << "4, 5" << std::endl;
+  f.close();
+
+  {
+    data::ChunkedReader reader("test_file.csv", 2);
+    arma::mat chunk;
+    BOOST_REQUIRE_THROW(reader.NextChunk(chunk), std::runtime_error);
+  }
+
+  BOOST_REQUIRE_THROW(data::ChunkedReader("nonexistent_file.csv", 2),
+      std::runtime_error);
+
+  remove("test_file.csv");
+}
+
+/**
+ * Make sure the parallel text loader reads mixed separators, blank lines, and
+ * carriage returns, in both layouts, and rejects ragged files.
+ */
+BOOST_AUTO_TEST_CASE(LoadTextParallelTest)
+{
+  std::fstream f;
+  f.open("test_file.csv", std::fstream::out);
+  f << "1, -2.5,3e2\r" << std::endl;
+  f << std::endl;
+  f << "  4\t5.25e-1  ,  -6E+1" << std::endl;
+  f << "0.001,1e-30,nan" << std::endl;
+  f.close();
+
+  arma::mat matrix;
+  BOOST_REQUIRE(data::LoadText("test_file.csv", matrix, true));
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(matrix(0, 0), 1.0);
+  BOOST_REQUIRE_EQUAL(matrix(1, 0), -2.5);
+  BOOST_REQUIRE_EQUAL(matrix(2, 0), 300.0);
+  BOOST_REQUIRE_EQUAL(matrix(0, 1), 4.0);
+  BOOST_REQUIRE_EQUAL(matrix(1, 1), 0.525);
+  BOOST_REQUIRE_EQUAL(matrix(2, 1), -60.0);
+  BOOST_REQUIRE_EQUAL(matrix(0, 2), 0.001);
+  BOOST_REQUIRE_EQUAL(matrix(1, 2), 1e-30);
+  BOOST_REQUIRE(std::isnan(matrix(2, 2)));
+
+  BOOST_REQUIRE(data::LoadText("test_file.csv", matrix, false));
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(matrix(1, 0), 4.0);
+  BOOST_REQUIRE_EQUAL(matrix(0, 2), 300.0);
+
+  f.open("test_file.csv", std::fstream::out);
+  f << "1, 2, 3" << std::endl;
+  f << "4, 5" << std::endl;
+  f.close();
+  BOOST_REQUIRE(!data::LoadText("test_file.csv", matrix, true));
+
+  f.open("test_file.csv", std::fstream::out);
+  f << "1, 2a, 3" << std::endl;
+  f.close();
+  BOOST_REQUIRE(!data::LoadText("test_file.csv", matrix, true));
+
+  remove("test_file.csv");
+}
+
+/**
+ * Make sure that a large file, split across threads, is loaded with exactly the
+ * values std::strtod() gives, and the same way data::Load() loads it.
+ */
+BOOST_AUTO_TEST_CASE(LoadTextLargeTest)
+{
+  arma::mat values(7, 50000);
+  values.randn();
+  values.row(3) *= 1e-8;
+  values.row(4) *= 1e12;
+
+  // Write some values with few digits (the fast path) and some with all of
+  // them (which go to strtod()).
+  std::vector<std::string> tokens;
+  std::fstream f;
+  f.open("test_file.csv", std::fstream::out);
+  for (size_t j = 0; j < values.n_cols; ++j)
+  {
+    for (size_t i = 0; i < values.n_rows; ++i)
+    {
+      std::ostringstream oss;
+      oss.precision((i % 2 == 0) ? 6 : 17);
+      oss << values(i, j);
+      tokens.push_back(oss.str());
+      f << oss.str() << ((i == values.n_rows - 1) ? "\n" : ",");
+    }
+  }
+  f.close();
+
+  arma::mat matrix;
+  BOOST_REQUIRE(data::Load("test_file.csv", matrix));
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, values.n_rows);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, values.n_cols);
+  for (size_t k = 0; k < matrix.n_elem; ++k)
+    BOOST_REQUIRE_EQUAL(matrix[k], std::strtod(tokens[k].c_str(), NULL));
+
+  remove("test_file.csv");
+}
+
+/**
+ * Make sure that the parallel text writer writes the numbers as Armadillo
+ * would, in both layouts and for both CSV and raw ASCII files, and that the
+ * files load back.
+ */
+BOOST_AUTO_TEST_CASE(SaveTextParallelTest)
+{
+  arma::mat values(5, 20000);
+  values.randn();
+  values.row(1) *= 1e-100;
+  values.row(2) *= 1e200;
+  values(0, 0) = 0.0;
+  values(3, 7) = std::numeric_limits<double>::infinity();
+  values(4, 9) = -std::numeric_limits<double>::infinity();
+
+  for (size_t transpose = 0; transpose < 2; ++transpose)
+  {
+    for (size_t csv = 0; csv < 2; ++csv)
+    {
+      std::ostringstream parallel;
+      BOOST_REQUIRE(data::SaveText(parallel, values, transpose == 1,
+          csv == 1));
+
+      // Format the values as Armadillo does.
+      std::ostringstream expected;
+      expected.setf(std::ios::scientific);
+      expected.precision(12);
+      const size_t lines = (transpose == 1) ? values.n_cols : values.n_rows;
+      const size_t count = (transpose == 1) ? values.n_rows : values.n_cols;
+      for (size_t i = 0; i < lines; ++i)
+      {
+        for (size_t j = 0; j < count; ++j)
+        {
+          if (csv == 0)
+          {
+            expected.put(' ');
+            expected.width(20);
+          }
+          else if (j > 0)
+          {
+            expected.put(',');
+          }
+
+          const double value = (transpose == 1) ? values(j, i) : values(i, j);
+          if (std::isinf(value))
+            expected << ((value > 0) ? "inf" : "-inf");
+          else
+            expected << value;
+        }
+        expected.put('\n');
+      }
+
+      BOOST_REQUIRE(parallel.str() == expected.str());
+    }
+  }
+
+  // Integers are written without padding.
+  arma::Mat<size_t> labels(3, 2);
+  labels(0, 0) = 0;
+  labels(1, 0) = 12;
+  labels(2, 0) = 345;
+  labels(0, 1) = 6789;
+  labels(1, 1) = 1;
+  labels(2, 1) = std::numeric_limits<size_t>::max();
+  std::ostringstream labelText;
+  BOOST_REQUIRE(data::SaveText(labelText, labels, true, false));
+  std::ostringstream expectedLabels;
+  expectedLabels << " 0 12 345\n 6789 1 " << std::numeric_limits<size_t>::max()
+      << "\n";
+  BOOST_REQUIRE_EQUAL(labelText.str(), expectedLabels.str());
+
+  // Now make sure the results of data::Save() load back.
+  values(3, 7) = 1.0;
+  values(4, 9) = 2.0;
+  BOOST_REQUIRE(data::Save("test_file.csv", values) == true);
+  BOOST_REQUIRE(data::Save("test_file.txt", values) == true);
+
+  arma::mat csvValues, txtValues;
+  BOOST_REQUIRE(data::Load("test_file.csv", csvValues) == true);
+  BOOST_REQUIRE(data::Load("test_file.txt", txtValues) == true);
+
+  BOOST_REQUIRE_EQUAL(csvValues.n_rows, values.n_rows);
+  BOOST_REQUIRE_EQUAL(csvValues.n_cols, values.n_cols);
+  BOOST_REQUIRE_EQUAL(txtValues.n_rows, values.n_rows);
+  BOOST_REQUIRE_EQUAL(txtValues.n_cols, values.n_cols);
+  for (size_t i = 0; i < values.n_elem; ++i)
+  {
+    if (values[i] == 0.0)
+    {
+      BOOST_REQUIRE_SMALL(csvValues[i], 1e-300);
+      BOOST_REQUIRE_SMALL(txtValues[i], 1e-300);
+    }
+    else
+    {
+      BOOST_REQUIRE_CLOSE(csvValues[i], values[i], 1e-9);
+      BOOST_REQUIRE_CLOSE(txtValues[i], values[i], 1e-9);
+    }
+  }
+
+  remove("test_file.csv");
+  remove("test_file.txt");
+}
+
+/**
+ * Make sure a coordinate list loads into a sparse matrix, in both layouts, and
+ * that a repeated location is an error.
+ */
+BOOST_AUTO_TEST_CASE(LoadSparseCoordinateListTest)
+{
+  std::fstream f;
+  f.open("test_file.csv", std::fstream::out);
+  f << "% A comment." << std::endl;
+  f << "3, 0, 1.5" << std::endl;
+  f << "0 2 -2" << std::endl;
+  f << std::endl;
+  f << "1\t1\t4e2" << std::endl;
+  f.close();
+
+  arma::sp_mat matrix;
+  BOOST_REQUIRE(data::Load("test_file.csv", matrix, false, false));
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(matrix.n_nonzero, 3);
+  BOOST_REQUIRE_EQUAL((double) matrix(3, 0), 1.5);
+  BOOST_REQUIRE_EQUAL((double) matrix(0, 2), -2.0);
+  BOOST_REQUIRE_EQUAL((double) matrix(1, 1), 400.0);
+
+  // By default the matrix is transposed, like a dense matrix.
+  BOOST_REQUIRE(data::Load("test_file.csv", matrix));
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, 4);
+  BOOST_REQUIRE_EQUAL((double) matrix(0, 3), 1.5);
+  BOOST_REQUIRE_EQUAL((double) matrix(2, 0), -2.0);
+
+  f.open("test_file.csv", std::fstream::out);
+  f << "1 2 3" << std::endl;
+  f << "1 2 4" << std::endl;
+  f.close();
+  BOOST_REQUIRE(!data::Load("test_file.csv", matrix));
+
+  f.open("test_file.csv", std::fstream::out);
+  f << "1 2" << std::endl;
+  f.close();
+  BOOST_REQUIRE(!data::Load("test_file.csv", matrix));
+
+  remove("test_file.csv");
+}
+
+/**
+ * Make sure a sparse matrix saved by Armadillo as a coordinate list (across
+ * several threads) loads back the same.
+ */
+BOOST_AUTO_TEST_CASE(LoadSparseCoordinateListLargeTest)
+{
+  arma::sp_mat original;
+  original.sprandu(1000, 2000, 0.05);
+  BOOST_REQUIRE(original.save("test_file.txt", arma::coord_ascii));
+
+  arma::sp_mat matrix;
+  BOOST_REQUIRE(data::Load("test_file.txt", matrix, true, false));
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, original.n_rows);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, original.n_cols);
+  BOOST_REQUIRE_EQUAL(matrix.n_nonzero, original.n_nonzero);
+  const arma::mat difference = arma::mat(matrix) - arma::mat(original);
+  BOOST_REQUIRE_SMALL(arma::max(arma::max(arma::abs(difference))), 1e-5);
+
+  remove("test_file.txt");
+}
+
+/**
+ * Make sure symmetric and pattern Matrix Market files load correctly, and that
+ * dense ones are rejected.
+ */
+BOOST_AUTO_TEST_CASE(LoadSparseMatrixMarketTest)
+{
+  std::fstream f;
+  f.open("test_file.mtx", std::fstream::out);
+  f << "%%MatrixMarket matrix coordinate real symmetric" << std::endl;
+  f << "% A comment." << std::endl;
+  f << "3 3 3" << std::endl;
+  f << "1 1 4.0" << std::endl;
+  f << "2 1 -1.0" << std::endl;
+  f << "3 2 2.5" << std::endl;
+  f.close();
+
+  arma::sp_mat matrix;
+  BOOST_REQUIRE(data::Load("test_file.mtx", matrix, false, false));
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(matrix.n_nonzero, 5);
+  BOOST_REQUIRE_EQUAL((double) matrix(0, 0), 4.0);
+  BOOST_REQUIRE_EQUAL((double) matrix(1, 0), -1.0);
+  BOOST_REQUIRE_EQUAL((double) matrix(0, 1), -1.0);
+  BOOST_REQUIRE_EQUAL((double) matrix(2, 1), 2.5);
+  BOOST_REQUIRE_EQUAL((double) matrix(1, 2), 2.5);
+
+  f.open("test_file.mtx", std::fstream::out);
+  f << "%%MatrixMarket matrix coordinate pattern general" << std::endl;
+  f << "2 5 2" << std::endl;
+  f << "1 5" << std::endl;
+  f << "2 1" << std::endl;
+  f.close();
+
+  BOOST_REQUIRE(data::Load("test_file.mtx", matrix, false, false));
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, 5);
+  BOOST_REQUIRE_EQUAL(matrix.n_nonzero, 2);
+  BOOST_REQUIRE_EQUAL((double) matrix(0, 4), 1.0);
+  BOOST_REQUIRE_EQUAL((double) matrix(1, 0), 1.0);
+
+  // An entry outside of the matrix.
+  f.open("test_file.mtx", std::fstream::out);
+  f << "%%MatrixMarket matrix coordinate real general" << std::endl;
+  f << "2 2 1" << std::endl;
+  f << "3 1 1.0" << std::endl;
+  f.close();
+  BOOST_REQUIRE(!data::Load("test_file.mtx", matrix));
+
+  f.open("test_file.mtx", std::fstream::out);
+  f << "%%MatrixMarket matrix array real general" << std::endl;
+  f << "1 1" << std::endl;
+  f << "1.0" << std::endl;
+  f.close();
+  BOOST_REQUIRE(!data::Load("test_file.mtx", matrix));
+
+  remove("test_file.mtx");
+}
+
+/**
+ * Make sure a LibSVM file loads with one point per column and its labels.
+ */
+BOOST_AUTO_TEST_CASE(LoadLibSVMTest)
+{
+  std::fstream f;
+  f.open("test_file.svm", std::fstream::out);
+  f << "+1 1:0.5 4:2 # A comment." << std::endl;
+  f << "-1 qid:3 2:-1.25" << std::endl;
+  f << "0" << std::endl;
+  f.close();
+
+  arma::sp_mat matrix;
+  arma::rowvec labels;
+  BOOST_REQUIRE(data::LoadLibSVM("test_file.svm", matrix, labels));
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, 4);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(matrix.n_nonzero, 3);
+  BOOST_REQUIRE_EQUAL((double) matrix(0, 0), 0.5);
+  BOOST_REQUIRE_EQUAL((double) matrix(3, 0), 2.0);
+  BOOST_REQUIRE_EQUAL((double) matrix(1, 1), -1.25);
+  BOOST_REQUIRE_EQUAL(labels.n_elem, 3);
+  BOOST_REQUIRE_EQUAL(labels[0], 1.0);
+  BOOST_REQUIRE_EQUAL(labels[1], -1.0);
+  BOOST_REQUIRE_EQUAL(labels[2], 0.0);
+
+  // Feature indices start at 1.
+  f.open("test_file.svm", std::fstream::out);
+  f << "1 0:1.0" << std::endl;
+  f.close();
+  BOOST_REQUIRE(!data::LoadLibSVM("test_file.svm", matrix, labels));
+
+  remove("test_file.svm");
+}
+
+#ifdef MLPACK_USE_ZLIB
+
+/**
+ * Make sure gzip-compressed text, binary, and sparse files can be saved and
+ * loaded.
+ */
+BOOST_AUTO_TEST_CASE(LoadSaveGzipTest)
+{
+  arma::mat test;
+  test.randu(5, 2000);
+
+  BOOST_REQUIRE(data::Save("test_file.csv.gz", test));
+  arma::mat matrix;
+  BOOST_REQUIRE(data::Load("test_file.csv.gz", matrix));
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, test.n_rows);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, test.n_cols);
+  for (size_t i = 0; i < matrix.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(matrix[i], test[i], 1e-3);
+
+  BOOST_REQUIRE(data::Save("test_file.bin.gz", test));
+  BOOST_REQUIRE(data::Load("test_file.bin.gz", matrix));
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, test.n_rows);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, test.n_cols);
+  for (size_t i = 0; i < matrix.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(matrix[i], test[i]);
+
+  // A coordinate list, compressed.
+  arma::sp_mat sparse;
+  arma::mat coordinates = "0 0 1;"
+                          "1 1 3;"
+                          "0 2 2;";
+  BOOST_REQUIRE(data::Save("test_file.csv.gz", coordinates, false, false));
+  BOOST_REQUIRE(data::Load("test_file.csv.gz", sparse, false, false));
+  BOOST_REQUIRE_EQUAL(sparse.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(sparse.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(sparse.n_nonzero, 3);
+  BOOST_REQUIRE_EQUAL((double) sparse(1, 1), 3.0);
+  BOOST_REQUIRE_EQUAL((double) sparse(0, 2), 2.0);
+
+  // A file that isn't actually compressed.
+  std::fstream f;
+  f.open("test_file.csv.gz", std::fstream::out);
+  f << "1, 2, 3" << std::endl;
+  f.close();
+  BOOST_REQUIRE(data::Load("test_file.csv.gz", matrix));
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, 1);
+
+  BOOST_REQUIRE(!data::Load("nonexistent_file.csv.gz", matrix));
+
+  remove("test_file.csv.gz");
+  remove("test_file.bin.gz");
+}
+
+#endif
+
+#ifdef MLPACK_USE_ZSTD
+
+/**
+ * Make sure Zstandard-compressed files can be saved and loaded.
+ */
+BOOST_AUTO_TEST_CASE(LoadSaveZstdTest)
+{
+  arma::mat test;
+  test.randu(5, 2000);
+
+  BOOST_REQUIRE(data::Save("test_file.bin.zst", test));
+  arma::mat matrix;
+  BOOST_REQUIRE(data::Load("test_file.bin.zst", matrix));
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, test.n_rows);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, test.n_cols);
+  for (size_t i = 0; i < matrix.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(matrix[i], test[i]);
+
+  BOOST_REQUIRE(data::Save("test_file.txt.zst", test));
+  BOOST_REQUIRE(data::Load("test_file.txt.zst", matrix));
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, test.n_rows);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, test.n_cols);
+  for (size_t i = 0; i < matrix.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(matrix[i], test[i], 1e-3);
+
+  remove("test_file.bin.zst");
+  remove("test_file.txt.zst");
+}
+
+#endif
+
+/**
+ * Check that the given matrix holds the given subset of the dataset.
+ */
+void CheckSubset(const arma::mat& dataset,
+                 const data::Subset& subset,
+                 const size_t numPoints,
+                 const arma::mat& matrix)
+{
+  const size_t dimensions = subset.dimensions.empty() ? dataset.n_rows :
+      subset.dimensions.size();
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, dimensions);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, numPoints);
+
+  for (size_t i = 0; i < numPoints; ++i)
+  {
+    const size_t point = subset.first + i * subset.stride;
+    for (size_t j = 0; j < dimensions; ++j)
+    {
+      const size_t d = subset.dimensions.empty() ? j : subset.dimensions[j];
+      BOOST_REQUIRE_EQUAL(matrix(j, i), dataset(d, point));
+    }
+  }
+}
+
+/**
+ * Make sure that subsets of an Armadillo binary file are loaded correctly.
+ */
+BOOST_AUTO_TEST_CASE(LoadSubsetBinaryTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(7, 1000);
+  BOOST_REQUIRE(data::Save("test_file.bin", dataset) == true);
+
+  // The whole dataset.
+  data::Subset subset;
+  arma::mat matrix;
+  BOOST_REQUIRE(data::Load("test_file.bin", matrix, subset) == true);
+  CheckSubset(dataset, subset, 1000, matrix);
+
+  // A range of points.
+  subset.first = 100;
+  subset.count = 250;
+  BOOST_REQUIRE(data::Load("test_file.bin", matrix, subset) == true);
+  CheckSubset(dataset, subset, 250, matrix);
+
+  // Every third point, with some of the dimensions, out of order.
+  subset.first = 2;
+  subset.count = std::numeric_limits<size_t>::max();
+  subset.stride = 3;
+  subset.dimensions.push_back(6);
+  subset.dimensions.push_back(0);
+  subset.dimensions.push_back(3);
+  BOOST_REQUIRE(data::Load("test_file.bin", matrix, subset) == true);
+  CheckSubset(dataset, subset, 333, matrix);
+
+  // A stride past the end of the dataset gives one point.
+  subset.stride = 5000;
+  BOOST_REQUIRE(data::Load("test_file.bin", matrix, subset) == true);
+  CheckSubset(dataset, subset, 1, matrix);
+
+  // Invalid subsets.
+  Log::Warn.ignoreInput = true;
+  subset.stride = 0;
+  BOOST_REQUIRE(data::Load("test_file.bin", matrix, subset) == false);
+  subset.stride = 1;
+  subset.first = 1001;
+  BOOST_REQUIRE(data::Load("test_file.bin", matrix, subset) == false);
+  subset.first = 0;
+  subset.dimensions.push_back(7);
+  BOOST_REQUIRE(data::Load("test_file.bin", matrix, subset) == false);
+  Log::Warn.ignoreInput = false;
+
+  remove("test_file.bin");
+}
+
+/**
+ * Make sure that subsets of file types that are loaded whole are correct too.
+ */
+BOOST_AUTO_TEST_CASE(LoadSubsetTextTest)
+{
+  arma::mat dataset = arma::floor(10 * arma::randu<arma::mat>(4, 50));
+  BOOST_REQUIRE(data::Save("test_file.csv", dataset) == true);
+
+  data::Subset subset;
+  subset.first = 10;
+  subset.count = 8;
+  subset.stride = 4;
+  subset.dimensions.push_back(2);
+  subset.dimensions.push_back(1);
+
+  arma::mat matrix;
+  BOOST_REQUIRE(data::Load("test_file.csv", matrix, subset) == true);
+  CheckSubset(dataset, subset, 8, matrix);
+
+  remove("test_file.csv");
+}
+
 /**
  * Make sure arma_binary is saved correctly.
  */
@@ -631,6 +1403,62 @@ BOOST_AUTO_TEST_CASE(SaveHDF5Test)
   remove("test_file.hdf5");
   remove("test_file.he5");
 }
+/**
+ * Make sure that a ChunkedReader reads the points of an HDF5 file saved by
+ * data::Save(), with and without prefetching.
+ */
+BOOST_AUTO_TEST_CASE(ChunkedReaderHDF5Test)
+{
+  arma::mat test = arma::randu<arma::mat>(6, 95);
+  BOOST_REQUIRE(data::Save("test_file.h5", test) == true);
+
+  for (size_t prefetch = 0; prefetch < 2; ++prefetch)
+  {
+    data::ChunkedReader reader("test_file.h5", 20, prefetch == 1);
+    BOOST_REQUIRE_EQUAL(reader.Dimensionality(), 6);
+    BOOST_REQUIRE_EQUAL(reader.NumPoints(), 95);
+
+    arma::mat chunk;
+    size_t point = 0;
+    while (reader.NextChunk(chunk))
+    {
+      BOOST_REQUIRE_EQUAL(chunk.n_rows, 6);
+      BOOST_REQUIRE_EQUAL(chunk.n_cols, std::min((size_t) 20, 95 - point));
+      for (size_t i = 0; i < chunk.n_cols; ++i, ++point)
+        for (size_t d = 0; d < 6; ++d)
+          BOOST_REQUIRE_EQUAL(chunk(d, i), test(d, point));
+    }
+
+    BOOST_REQUIRE_EQUAL(point, 95);
+  }
+
+  remove("test_file.h5");
+}
+
+/**
+ * Make sure that subsets of an HDF5 file are loaded with hyperslabs correctly.
+ */
+BOOST_AUTO_TEST_CASE(LoadSubsetHDF5Test)
+{
+  arma::mat dataset = arma::randu<arma::mat>(6, 95);
+  BOOST_REQUIRE(data::Save("test_file.h5", dataset) == true);
+
+  data::Subset subset;
+  arma::mat matrix;
+  BOOST_REQUIRE(data::Load("test_file.h5", matrix, subset) == true);
+  CheckSubset(dataset, subset, 95, matrix);
+
+  subset.first = 5;
+  subset.count = 20;
+  subset.stride = 4;
+  subset.dimensions.push_back(5);
+  subset.dimensions.push_back(1);
+  subset.dimensions.push_back(5);
+  BOOST_REQUIRE(data::Load("test_file.h5", matrix, subset) == true);
+  CheckSubset(dataset, subset, 20, matrix);
+
+  remove("test_file.h5");
+}
 #else
 /**
  * Ensure saving as HDF5 fails.
@@ -704,6 +1532,101 @@ BOOST_AUTO_TEST_CASE(NormalizeLabelTest)
     BOOST_REQUIRE_EQUAL(randLabels[i], revertedLabels[i]);
 }
 
+/**
+ * Test normalization of many distinct labels, and make sure they are numbered
+ * in the order they are first seen.
+ */
+BOOST_AUTO_TEST_CASE(NormalizeLabelLargeTest)
+{
+  arma::Col<size_t> randLabels(200000);
+  for (size_t i = 0; i < randLabels.n_elem; ++i)
+    randLabels[i] = 1024 * math::RandInt(0, 100000);
+
+  arma::Col<size_t> newLabels;
+  arma::Col<size_t> mappings;
+  data::NormalizeLabels(randLabels, newLabels, mappings);
+
+  size_t seen = 0;
+  for (size_t i = 0; i < randLabels.n_elem; ++i)
+  {
+    BOOST_REQUIRE_LE(newLabels[i], seen);
+    if (newLabels[i] == seen)
+      ++seen;
+
+    BOOST_REQUIRE_EQUAL(mappings[newLabels[i]], randLabels[i]);
+  }
+
+  BOOST_REQUIRE_EQUAL(mappings.n_elem, seen);
+}
+
+/**
+ * Make sure that categorical features are mapped to integers when they are
+ * loaded, and that a second file can be loaded with the same mappings.
+ */
+BOOST_AUTO_TEST_CASE(LoadCategoricalTest)
+{
+  std::fstream f;
+  f.open("test_file.csv", std::fstream::out);
+  f << "1.5, red, New York" << std::endl;
+  f << "2, blue, Boston" << std::endl;
+  f << "3, red, New York" << std::endl;
+  f << "4, green, 5" << std::endl;
+  f.close();
+
+  arma::mat matrix;
+  data::DatasetInfo info;
+  BOOST_REQUIRE(data::Load("test_file.csv", matrix, info) == true);
+
+  BOOST_REQUIRE_EQUAL(matrix.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(matrix.n_cols, 4);
+  BOOST_REQUIRE_EQUAL(info.Dimensionality(), 3);
+  BOOST_REQUIRE(info.Type(0) == data::numeric);
+  BOOST_REQUIRE(info.Type(1) == data::categorical);
+  BOOST_REQUIRE(info.Type(2) == data::categorical);
+
+  BOOST_REQUIRE_CLOSE(matrix(0, 0), 1.5, 1e-5);
+  BOOST_REQUIRE_CLOSE(matrix(0, 3), 4.0, 1e-5);
+  BOOST_REQUIRE_EQUAL(info.NumMappings(1), 3);
+  BOOST_REQUIRE_EQUAL(info.NumMappings(2), 3);
+  BOOST_REQUIRE_EQUAL(matrix(1, 0), 0.0);
+  BOOST_REQUIRE_EQUAL(matrix(1, 1), 1.0);
+  BOOST_REQUIRE_EQUAL(matrix(1, 2), 0.0);
+  BOOST_REQUIRE_EQUAL(matrix(1, 3), 2.0);
+  BOOST_REQUIRE_EQUAL(info.UnmapString(0, 2), "New York");
+  BOOST_REQUIRE_EQUAL(info.UnmapString(1, 2), "Boston");
+  BOOST_REQUIRE_EQUAL(info.UnmapString(2, 2), "5");
+  BOOST_REQUIRE_EQUAL(matrix(2, 2), 0.0);
+
+  // Now load a second file with the same information, which is separated by
+  // whitespace; its numbers in the third dimension are still strings.
+  f.open("test_file.txt", std::fstream::out);
+  f << "7 purple 5" << std::endl;
+  f << "8 red 6" << std::endl;
+  f.close();
+
+  arma::mat test;
+  BOOST_REQUIRE(data::Load("test_file.txt", test, info) == true);
+  BOOST_REQUIRE_EQUAL(test.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(test.n_cols, 2);
+  BOOST_REQUIRE_EQUAL(test(1, 0), 3.0);
+  BOOST_REQUIRE_EQUAL(test(1, 1), 0.0);
+  BOOST_REQUIRE_EQUAL(test(2, 0), 2.0);
+  BOOST_REQUIRE_EQUAL(test(2, 1), 3.0);
+  BOOST_REQUIRE_EQUAL(info.UnmapString(3, 1), "purple");
+
+  // A file of the wrong dimensionality cannot be loaded with it.
+  f.open("test_file.txt", std::fstream::out);
+  f << "1 2" << std::endl;
+  f.close();
+
+  Log::Warn.ignoreInput = true;
+  BOOST_REQUIRE(data::Load("test_file.txt", test, info) == false);
+  Log::Warn.ignoreInput = false;
+
+  remove("test_file.csv");
+  remove("test_file.txt");
+}
+
 // Test structures.
 class TestInner
 {
@@ -809,5 +1732,118 @@ BOOST_AUTO_TEST_CASE(LoadTextTest)
   BOOST_REQUIRE_EQUAL(y.inb.s, x.inb.s);
 }
 
+/**
+ * Make sure we can load and save.
+ */
+BOOST_AUTO_TEST_CASE(LoadBlobTest)
+{
+  Test x(10, 12);
+
+  BOOST_REQUIRE_EQUAL(data::Save("test.blob", "x", x, false), true);
+
+  // Now reload.
+  Test y(11, 14);
+
+  BOOST_REQUIRE_EQUAL(data::Load("test.blob", "x", y, false), true);
+
+  BOOST_REQUIRE_EQUAL(y.x, x.x);
+  BOOST_REQUIRE_EQUAL(y.y, x.y);
+  BOOST_REQUIRE_EQUAL(y.ina.c, x.ina.c);
+  BOOST_REQUIRE_EQUAL(y.ina.s, x.ina.s);
+  BOOST_REQUIRE_EQUAL(y.inb.c, x.inb.c);
+  BOOST_REQUIRE_EQUAL(y.inb.s, x.inb.s);
+
+  remove("test.blob");
+}
+
+/**
+ * Make sure that matrices large enough to be stored as blobs, and small ones
+ * that are not, are loaded correctly from the blob format.
+ */
+BOOST_AUTO_TEST_CASE(LoadBlobMatrixTest)
+{
+  arma::mat large(100, 120, arma::fill::randu);
+  arma::mat small(3, 4, arma::fill::randu);
+  arma::sp_mat sparse;
+  sparse.sprandu(200, 300, 0.1);
+
+  BOOST_REQUIRE_EQUAL(data::Save("test.blob", "large", large, false), true);
+  arma::mat largeLoaded;
+  BOOST_REQUIRE_EQUAL(data::Load("test.blob", "large", largeLoaded, false),
+      true);
+
+  BOOST_REQUIRE_EQUAL(largeLoaded.n_rows, large.n_rows);
+  BOOST_REQUIRE_EQUAL(largeLoaded.n_cols, large.n_cols);
+  for (size_t i = 0; i < large.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(largeLoaded[i], large[i]);
+
+  BOOST_REQUIRE_EQUAL(data::Save("test.blob", "small", small, false), true);
+  arma::mat smallLoaded;
+  BOOST_REQUIRE_EQUAL(data::Load("test.blob", "small", smallLoaded, false),
+      true);
+
+  BOOST_REQUIRE_EQUAL(smallLoaded.n_rows, small.n_rows);
+  BOOST_REQUIRE_EQUAL(smallLoaded.n_cols, small.n_cols);
+  for (size_t i = 0; i < small.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(smallLoaded[i], small[i]);
+
+  BOOST_REQUIRE_EQUAL(data::Save("test.blob", "sparse", sparse, false), true);
+  arma::sp_mat sparseLoaded;
+  BOOST_REQUIRE_EQUAL(data::Load("test.blob", "sparse", sparseLoaded, false),
+      true);
+
+  BOOST_REQUIRE_EQUAL(sparseLoaded.n_rows, sparse.n_rows);
+  BOOST_REQUIRE_EQUAL(sparseLoaded.n_cols, sparse.n_cols);
+  BOOST_REQUIRE_EQUAL(sparseLoaded.n_nonzero, sparse.n_nonzero);
+  for (arma::sp_mat::const_iterator it = sparse.begin(); it != sparse.end();
+      ++it)
+    BOOST_REQUIRE_EQUAL((double) sparseLoaded(it.row(), it.col()), *it);
+
+  remove("test.blob");
+}
+
+/**
+ * Make sure that a file that is not in the blob format is not loaded.
+ */
+BOOST_AUTO_TEST_CASE(LoadBadBlobTest)
+{
+  Test x(10, 12);
+
+  BOOST_REQUIRE_EQUAL(data::Save("test.bin", "x", x, false), true);
+
+  Test y(11, 14);
+  BOOST_REQUIRE_EQUAL(data::Load("test.bin", "x", y, false, data::format::blob),
+      false);
+
+  remove("test.bin");
+}
+
+#ifdef MLPACK_USE_ZLIB
+
+/**
+ * Make sure we can load and save compressed models.
+ */
+BOOST_AUTO_TEST_CASE(LoadCompressedXMLTest)
+{
+  Test x(10, 12);
+
+  BOOST_REQUIRE_EQUAL(data::Save("test.xml.gz", "x", x, false), true);
+
+  // Now reload.
+  Test y(11, 14);
+
+  BOOST_REQUIRE_EQUAL(data::Load("test.xml.gz", "x", y, false), true);
+
+  BOOST_REQUIRE_EQUAL(y.x, x.x);
+  BOOST_REQUIRE_EQUAL(y.y, x.y);
+  BOOST_REQUIRE_EQUAL(y.ina.c, x.ina.c);
+  BOOST_REQUIRE_EQUAL(y.ina.s, x.ina.s);
+  BOOST_REQUIRE_EQUAL(y.inb.c, x.inb.c);
+  BOOST_REQUIRE_EQUAL(y.inb.s, x.inb.s);
+
+  remove("test.xml.gz");
+}
+
+#endif
 
 BOOST_AUTO_TEST_SUITE_END();
@@ -7,6 +7,9 @@
 #include <mlpack/core.hpp>
 #include <mlpack/methods/logistic_regression/logistic_regression.hpp>
 #include <mlpack/core/optimizers/sgd/sgd.hpp>
+#include <mlpack/core/optimizers/minibatch_sgd/minibatch_sgd.hpp>
+#include <mlpack/core/optimizers/parallel_sgd/parallel_sgd.hpp>
+#include <mlpack/core/optimizers/tron/tron.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -805,4 +808,308 @@ BOOST_AUTO_TEST_CASE(LogisticRegressionSparseSGDTest)
     BOOST_REQUIRE_CLOSE(lr.Parameters()[i], lrSparse.Parameters()[i], 1e-5);
 }
 
+/**
+ * Make sure that the objective and gradient of a very sparse dataset are the
+ * same whether the dataset is stored as a sparse or a dense matrix, both for
+ * the whole dataset and for each point.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionSparseDenseTest)
+{
+  arma::sp_mat dataset;
+  dataset.sprandu(500, 200, 0.01);
+  arma::mat denseDataset(dataset);
+  arma::Row<size_t> labels(200);
+  for (size_t i = 0; i < 200; ++i)
+    labels[i] = math::RandInt(0, 2);
+
+  const arma::mat parameters = arma::randn<arma::mat>(501, 1);
+  for (size_t l = 0; l < 2; ++l)
+  {
+    const double lambda = (l == 0) ? 0.0 : 0.5;
+    LogisticRegressionFunction<> lrf(denseDataset, labels, lambda);
+    LogisticRegressionFunction<arma::sp_mat> lrfSparse(dataset, labels,
+        lambda);
+
+    BOOST_REQUIRE_CLOSE(lrf.Evaluate(parameters),
+        lrfSparse.Evaluate(parameters), 1e-8);
+
+    arma::mat gradient, sparseGradient;
+    lrf.Gradient(parameters, gradient);
+    lrfSparse.Gradient(parameters, sparseGradient);
+    BOOST_REQUIRE_EQUAL(sparseGradient.n_elem, 501);
+    for (size_t j = 0; j < 501; ++j)
+    {
+      if (std::abs(gradient[j]) < 1e-10)
+        BOOST_REQUIRE_SMALL(sparseGradient[j], 1e-10);
+      else
+        BOOST_REQUIRE_CLOSE(gradient[j], sparseGradient[j], 1e-8);
+    }
+
+    for (size_t i = 0; i < 200; ++i)
+    {
+      BOOST_REQUIRE_CLOSE(lrf.Evaluate(parameters, i),
+          lrfSparse.Evaluate(parameters, i), 1e-8);
+
+      lrf.Gradient(parameters, i, gradient);
+      lrfSparse.Gradient(parameters, i, sparseGradient);
+      BOOST_REQUIRE_EQUAL(sparseGradient.n_elem, 501);
+      for (size_t j = 0; j < 501; ++j)
+      {
+        if (std::abs(gradient[j]) < 1e-10)
+          BOOST_REQUIRE_SMALL(sparseGradient[j], 1e-10);
+        else
+          BOOST_REQUIRE_CLOSE(gradient[j], sparseGradient[j], 1e-8);
+      }
+    }
+  }
+}
+
+/**
+ * Make sure that the batch objective and gradient are the sums of the separable
+ * objectives and gradients over the batch.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionBatchTest)
+{
+  arma::mat dataset(4, 100);
+  dataset.randu();
+  arma::Row<size_t> labels(100);
+  for (size_t i = 0; i < 100; ++i)
+    labels[i] = math::RandInt(0, 2);
+
+  LogisticRegressionFunction<> lrf(dataset, labels, 0.4);
+  const arma::mat parameters = arma::randn<arma::mat>(5, 1);
+
+  const size_t begins[] = { 0, 13, 87, 99 };
+  const size_t sizes[] = { 100, 20, 13, 1 };
+  for (size_t b = 0; b < 4; ++b)
+  {
+    double objective = 0.0;
+    arma::mat gradient = arma::zeros<arma::mat>(5, 1);
+    arma::mat pointGradient;
+    for (size_t i = begins[b]; i < begins[b] + sizes[b]; ++i)
+    {
+      objective += lrf.Evaluate(parameters, i);
+      lrf.Gradient(parameters, i, pointGradient);
+      gradient += pointGradient;
+    }
+
+    BOOST_REQUIRE_CLOSE(lrf.Evaluate(parameters, begins[b], sizes[b]),
+        objective, 1e-8);
+
+    arma::mat batchGradient;
+    lrf.Gradient(parameters, begins[b], sizes[b], batchGradient);
+    BOOST_REQUIRE_EQUAL(batchGradient.n_elem, 5);
+    for (size_t j = 0; j < 5; ++j)
+      BOOST_REQUIRE_CLOSE(batchGradient[j], gradient[j], 1e-6);
+  }
+}
+
+/**
+ * Train logistic regression with mini-batch SGD (with and without momentum) on
+ * an easy dataset, and make sure it classifies the points correctly.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionMiniBatchSGDTest)
+{
+  // Two well-separated Gaussians.
+  arma::mat dataset(3, 1000);
+  arma::Row<size_t> labels(1000);
+  for (size_t i = 0; i < 1000; ++i)
+  {
+    labels[i] = i % 2;
+    dataset.col(i) = arma::randn<arma::vec>(3) +
+        ((i % 2 == 0) ? 3.0 : -3.0);
+  }
+
+  for (size_t m = 0; m < 2; ++m)
+  {
+    LogisticRegressionFunction<> lrf(dataset, labels, 0.001);
+    MiniBatchSGD<LogisticRegressionFunction<>> sgd(lrf, 50, 0.01, 100000,
+        1e-8, true, (m == 0) ? 0.0 : 0.9);
+    LogisticRegression<> lr(sgd);
+
+    BOOST_REQUIRE_GT(lr.ComputeAccuracy(dataset, labels), 99.0);
+  }
+}
+
+/**
+ * Make sure that the sparse gradients of the points add up to the full
+ * gradient, for both sparse and dense datasets, and that they only touch the
+ * nonzero features of each point.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionSparseGradientTest)
+{
+  arma::sp_mat dataset;
+  dataset.sprandu(30, 200, 0.1);
+  arma::mat denseDataset(dataset);
+  arma::Row<size_t> labels(200);
+  for (size_t i = 0; i < 200; ++i)
+    labels[i] = math::RandInt(0, 2);
+
+  const arma::mat parameters = arma::randn<arma::mat>(31, 1);
+  LogisticRegressionFunction<> lrf(denseDataset, labels, 0.5);
+  LogisticRegressionFunction<arma::sp_mat> lrfSparse(dataset, labels, 0.5);
+
+  arma::mat gradient;
+  lrf.Gradient(parameters, gradient);
+
+  arma::mat gradientSum = arma::zeros<arma::mat>(31, 1);
+  arma::mat sparseGradientSum = arma::zeros<arma::mat>(31, 1);
+  arma::sp_mat pointGradient;
+  for (size_t i = 0; i < 200; ++i)
+  {
+    lrf.Gradient(parameters, i, pointGradient);
+    gradientSum += pointGradient;
+
+    lrfSparse.Gradient(parameters, i, pointGradient);
+    BOOST_REQUIRE_EQUAL(pointGradient.n_elem, 31);
+    BOOST_REQUIRE_LE(pointGradient.n_nonzero,
+        dataset.col_ptrs[i + 1] - dataset.col_ptrs[i] + 1);
+    sparseGradientSum += pointGradient;
+  }
+
+  for (size_t j = 0; j < 31; ++j)
+  {
+    BOOST_REQUIRE_CLOSE(gradientSum[j], gradient[j], 1e-6);
+    BOOST_REQUIRE_CLOSE(sparseGradientSum[j], gradient[j], 1e-6);
+  }
+}
+
+/**
+ * Train sparse logistic regression with the parallel SGD optimizer on an easy
+ * dataset, and make sure it classifies the points correctly.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionParallelSGDTest)
+{
+  // Each point has a few active features; the label decides whether they are
+  // taken from the first or the second half of the features.
+  arma::sp_mat dataset(100, 2000);
+  arma::Row<size_t> labels(2000);
+  for (size_t i = 0; i < 2000; ++i)
+  {
+    labels[i] = i % 2;
+    for (size_t k = 0; k < 5; ++k)
+      dataset(math::RandInt(0, 50) + 50 * labels[i], i) = 1.0;
+  }
+
+  LogisticRegressionFunction<arma::sp_mat> lrf(dataset, labels, 0.001);
+  ParallelSGD<LogisticRegressionFunction<arma::sp_mat>> sgd(lrf, 0.1,
+      20 * 2000, 1e-5, true, 0.9);
+  LogisticRegression<arma::sp_mat> lr(sgd);
+
+  BOOST_REQUIRE_GT(lr.ComputeAccuracy(dataset, labels), 99.0);
+}
+
+/**
+ * Make sure that the fused objective and gradient are the same as the separate
+ * ones, both for the whole dataset and for each point.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionEvaluateWithGradientTest)
+{
+  arma::mat dataset(6, 150);
+  dataset.randu();
+  arma::Row<size_t> labels(150);
+  for (size_t i = 0; i < 150; ++i)
+    labels[i] = math::RandInt(0, 2);
+
+  BOOST_REQUIRE(HasEvaluateWithGradient<LogisticRegressionFunction<> >::value);
+  BOOST_REQUIRE(HasSeparableEvaluateWithGradient<
+      LogisticRegressionFunction<> >::value);
+
+  const arma::mat parameters = arma::randn<arma::mat>(7, 1);
+  for (size_t l = 0; l < 2; ++l)
+  {
+    LogisticRegressionFunction<> lrf(dataset, labels, (l == 0) ? 0.0 : 0.7);
+
+    arma::mat gradient, fusedGradient;
+    lrf.Gradient(parameters, gradient);
+    BOOST_REQUIRE_CLOSE(lrf.EvaluateWithGradient(parameters, fusedGradient),
+        lrf.Evaluate(parameters), 1e-10);
+    BOOST_REQUIRE_EQUAL(fusedGradient.n_elem, 7);
+    for (size_t j = 0; j < 7; ++j)
+      BOOST_REQUIRE_CLOSE(fusedGradient[j], gradient[j], 1e-10);
+
+    for (size_t i = 0; i < 150; ++i)
+    {
+      lrf.Gradient(parameters, i, gradient);
+      BOOST_REQUIRE_CLOSE(lrf.EvaluateWithGradient(parameters, i,
+          fusedGradient), lrf.Evaluate(parameters, i), 1e-10);
+      BOOST_REQUIRE_EQUAL(fusedGradient.n_elem, 7);
+      for (size_t j = 0; j < 7; ++j)
+        BOOST_REQUIRE_CLOSE(fusedGradient[j], gradient[j], 1e-10);
+    }
+  }
+}
+
+
+/**
+ * Make sure that the Hessian-vector product is the same as a central difference
+ * of the gradient, with and without regularization.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionFunctionHessianVectorProductTest)
+{
+  arma::mat dataset(6, 150);
+  dataset.randu();
+  arma::Row<size_t> labels(150);
+  for (size_t i = 0; i < 150; ++i)
+    labels[i] = math::RandInt(0, 2);
+
+  BOOST_REQUIRE(HasHessianVectorProduct<LogisticRegressionFunction<> >::value);
+
+  const arma::mat parameters = arma::randn<arma::mat>(7, 1);
+  const arma::mat v = arma::randn<arma::mat>(7, 1);
+  const double h = 1e-5;
+  for (size_t l = 0; l < 2; ++l)
+  {
+    LogisticRegressionFunction<> lrf(dataset, labels, (l == 0) ? 0.0 : 0.7);
+
+    arma::mat hv, forward, backward;
+    lrf.HessianVectorProduct(parameters, v, hv);
+    const arma::mat plus = parameters + h * v;
+    const arma::mat minus = parameters - h * v;
+    lrf.Gradient(plus, forward);
+    lrf.Gradient(minus, backward);
+    const arma::mat difference = (forward - backward) / (2 * h);
+
+    BOOST_REQUIRE_EQUAL(hv.n_elem, 7);
+    for (size_t j = 0; j < 7; ++j)
+      BOOST_REQUIRE_SMALL(hv[j] - difference[j], 1e-5);
+  }
+}
+
+/**
+ * Make sure that TRON finds the same optimum as L-BFGS, in few iterations.
+ */
+BOOST_AUTO_TEST_CASE(LogisticRegressionTRONTest)
+{
+  // Generate a two-Gaussian dataset.
+  GaussianDistribution g1(arma::vec("1.0 1.0 1.0"), arma::eye<arma::mat>(3, 3));
+  GaussianDistribution g2(arma::vec("3.0 3.0 3.0"), arma::eye<arma::mat>(3, 3));
+
+  arma::mat data(3, 1000);
+  arma::Row<size_t> responses(1000);
+  for (size_t i = 0; i < 500; ++i)
+  {
+    data.col(i) = g1.Random();
+    responses[i] = 0;
+  }
+  for (size_t i = 500; i < 1000; ++i)
+  {
+    data.col(i) = g2.Random();
+    responses[i] = 1;
+  }
+
+  LogisticRegressionFunction<> lrf(data, responses, 0.5);
+  L_BFGS<LogisticRegressionFunction<> > lbfgs(lrf);
+  arma::mat lbfgsParameters = lrf.GetInitialPoint();
+  const double lbfgsObjective = lbfgs.Optimize(lbfgsParameters);
+
+  TRON<LogisticRegressionFunction<> > tron(lrf);
+  LogisticRegression<> lr(tron);
+
+  BOOST_REQUIRE_LE(tron.Iterations(), 30);
+  BOOST_REQUIRE_CLOSE(lrf.Evaluate(lr.Parameters()), lbfgsObjective, 1e-5);
+  for (size_t j = 0; j < lbfgsParameters.n_elem; ++j)
+    BOOST_REQUIRE_CLOSE(lr.Parameters()[j], lbfgsParameters[j], 1e-2);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -309,4 +309,81 @@ BOOST_AUTO_TEST_CASE(Keller4LovaszThetaSDP)
   }
 }*/
 
+/**
+ * Make sure that the augmented Lagrangian of an LRSDP, which is computed from
+ * the rows of R without forming R R^T, matches a direct computation with
+ * R R^T.  The problem has MVU-like sparse distance constraints and one dense
+ * constraint.
+ */
+BOOST_AUTO_TEST_CASE(LRSDPAugLagrangianDirectTest)
+{
+  const size_t n = 30;
+  const size_t r = 4;
+  const size_t numSparse = 50;
+
+  SDP<arma::sp_mat> sdp(n, numSparse, 1);
+  sdp.C().eye(n, n);
+  sdp.C() *= -1;
+
+  for (size_t i = 0; i < numSparse; ++i)
+  {
+    const size_t a = math::RandInt(0, n);
+    const size_t b = (a + 1 + math::RandInt(0, n - 1)) % n;
+    sdp.SparseA()[i].zeros(n, n);
+    sdp.SparseA()[i](a, a) = 1;
+    sdp.SparseA()[i](b, b) = 1;
+    sdp.SparseA()[i](a, b) = -1;
+    sdp.SparseA()[i](b, a) = -1;
+    sdp.SparseB()[i] = math::Random();
+  }
+
+  sdp.DenseA()[0].ones(n, n);
+  sdp.DenseB()[0] = 0;
+
+  const arma::mat coordinates = arma::randu<arma::mat>(n, r);
+  LRSDPFunction<SDP<arma::sp_mat>> function(sdp, coordinates);
+  AugLagrangianFunction<LRSDPFunction<SDP<arma::sp_mat>>> augLag(function);
+  augLag.Lambda() = arma::randu<arma::vec>(numSparse + 1);
+  augLag.Sigma() = 3.0;
+
+  // Compute the Lagrangian and its gradient directly.
+  const arma::mat rrt = coordinates * trans(coordinates);
+  double objective = accu(sdp.C() % rrt);
+  arma::mat s(sdp.C());
+  for (size_t i = 0; i < numSparse + 1; ++i)
+  {
+    const double constraint = (i < numSparse) ?
+        accu(sdp.SparseA()[i] % rrt) - sdp.SparseB()[i] :
+        accu(sdp.DenseA()[0] % rrt) - sdp.DenseB()[0];
+    objective -= augLag.Lambda()[i] * constraint;
+    objective += (augLag.Sigma() / 2.) * constraint * constraint;
+
+    const double y = augLag.Lambda()[i] - augLag.Sigma() * constraint;
+    if (i < numSparse)
+      s -= y * arma::mat(sdp.SparseA()[i]);
+    else
+      s -= y * sdp.DenseA()[0];
+  }
+  const arma::mat gradient = 2 * s * coordinates;
+
+  arma::mat augLagGradient, fusedGradient;
+  augLag.Gradient(coordinates, augLagGradient);
+  BOOST_REQUIRE_CLOSE(augLag.Evaluate(coordinates), objective, 1e-8);
+  BOOST_REQUIRE_CLOSE(augLag.EvaluateWithGradient(coordinates, fusedGradient),
+      objective, 1e-8);
+
+  BOOST_REQUIRE_EQUAL(augLagGradient.n_rows, n);
+  BOOST_REQUIRE_EQUAL(augLagGradient.n_cols, r);
+  for (size_t i = 0; i < gradient.n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(augLagGradient[i], gradient[i], 1e-8);
+    BOOST_REQUIRE_CLOSE(fusedGradient[i], gradient[i], 1e-8);
+  }
+
+  // Each constraint on its own should match too.
+  for (size_t i = 0; i < numSparse; ++i)
+    BOOST_REQUIRE_CLOSE(function.EvaluateConstraint(i, coordinates),
+        accu(sdp.SparseA()[i] % rrt) - sdp.SparseB()[i], 1e-8);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -155,4 +155,300 @@ BOOST_AUTO_TEST_CASE(EmptyConstructorTest)
   BOOST_REQUIRE_EQUAL(distances.n_rows, 3);
 }
 
+BOOST_AUTO_TEST_CASE(BucketSizeTest)
+{
+  // With no maximum bucket size, every point should be in one bucket of every
+  // table; with a maximum, no bucket should be bigger than it.
+  arma::mat dataset = arma::randu<arma::mat>(4, 300);
+
+  LSHSearch<> lsh(dataset, 2, 3, 0.0, 101, 0);
+  BOOST_REQUIRE_EQUAL(lsh.BucketOffsets().n_elem, 102);
+  BOOST_REQUIRE_EQUAL(lsh.BucketOffsets()[0], 0);
+  BOOST_REQUIRE_EQUAL(lsh.BucketOffsets()[101], 900);
+  BOOST_REQUIRE_EQUAL(lsh.BucketContents().n_elem, 900);
+
+  arma::Col<size_t> counts(300, arma::fill::zeros);
+  for (size_t i = 0; i < lsh.BucketContents().n_elem; ++i)
+    counts[lsh.BucketContents()[i]]++;
+  for (size_t i = 0; i < counts.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], 3);
+
+  lsh.Train(dataset, 2, 3, 0.0, 101, 5);
+  BOOST_REQUIRE_LT(lsh.BucketContents().n_elem, 900);
+  for (size_t i = 0; i < 101; ++i)
+  {
+    BOOST_REQUIRE_LE(lsh.BucketOffsets()[i], lsh.BucketOffsets()[i + 1]);
+    BOOST_REQUIRE_LE(lsh.BucketOffsets()[i + 1] - lsh.BucketOffsets()[i], 5);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(MultiprobeTest)
+{
+  // Probing more buckets can only add neighbor candidates, so with the same
+  // tables every distance found with multiprobe LSH must be at least as good
+  // as without it, and with one table the extra buckets should find closer
+  // neighbors for some of the queries.
+  arma::mat referenceData = arma::randu<arma::mat>(5, 500);
+  arma::mat queryData = arma::randu<arma::mat>(5, 100);
+
+  LSHSearch<> lsh(referenceData, 4, 1, 0.5, 99901, 500);
+
+  arma::Mat<size_t> neighbors, multiprobeNeighbors;
+  arma::mat distances, multiprobeDistances;
+  lsh.Search(queryData, 3, neighbors, distances);
+  lsh.Search(queryData, 3, multiprobeNeighbors, multiprobeDistances, 0, 10);
+
+  BOOST_REQUIRE_EQUAL(multiprobeNeighbors.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(multiprobeNeighbors.n_cols, 100);
+
+  size_t improved = 0;
+  for (size_t i = 0; i < distances.n_elem; ++i)
+  {
+    BOOST_REQUIRE_LE(multiprobeDistances[i], distances[i]);
+    if (multiprobeDistances[i] < distances[i])
+      ++improved;
+  }
+
+  BOOST_REQUIRE_GT(improved, 0);
+}
+
+BOOST_AUTO_TEST_CASE(MonochromaticSearchTest)
+{
+  // In monochromatic search, the results should be the same as searching for
+  // one more neighbor with the reference set as the query set, since each
+  // point is always a candidate for itself (at distance 0).  The reference set
+  // spans several blocks of queries.
+  arma::mat dataset = arma::randu<arma::mat>(3, 1000);
+
+  LSHSearch<> lsh(dataset, 3, 4);
+
+  arma::Mat<size_t> neighbors, bichromaticNeighbors;
+  arma::mat distances, bichromaticDistances;
+  lsh.Search(3, neighbors, distances);
+  lsh.Search(dataset, 4, bichromaticNeighbors, bichromaticDistances);
+
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(bichromaticNeighbors(0, i), i);
+    for (size_t j = 0; j < 3; ++j)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors(j, i), bichromaticNeighbors(j + 1, i));
+      BOOST_REQUIRE_CLOSE(distances(j, i), bichromaticDistances(j + 1, i),
+          1e-5);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(InsertTest)
+{
+  // Inserting points into a model should give the same results as training the
+  // model on all the points, as long as the tables are the same.
+  arma::mat dataset = arma::randu<arma::mat>(4, 500);
+  arma::mat queries = arma::randu<arma::mat>(4, 50);
+
+  math::RandomSeed(42);
+  LSHSearch<> lsh(dataset, 3, 4, 0.5, 99901, 0);
+
+  math::RandomSeed(42);
+  arma::mat firstPoints = dataset.cols(0, 299);
+  LSHSearch<> insertLsh(firstPoints, 3, 4, 0.5, 99901, 0);
+  insertLsh.Insert(dataset.cols(300, 499));
+
+  BOOST_REQUIRE_EQUAL(insertLsh.ReferenceSet().n_cols, 500);
+  BOOST_REQUIRE_EQUAL(insertLsh.BucketContents().n_elem, 2000);
+  BOOST_REQUIRE_EQUAL(firstPoints.n_cols, 300);
+
+  arma::Mat<size_t> neighbors, insertNeighbors;
+  arma::mat distances, insertDistances;
+  lsh.Search(queries, 3, neighbors, distances);
+  insertLsh.Search(queries, 3, insertNeighbors, insertDistances);
+
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(neighbors[i], insertNeighbors[i]);
+    BOOST_REQUIRE_CLOSE(distances[i], insertDistances[i], 1e-5);
+  }
+
+  // Points with the wrong dimensionality can't be inserted.
+  BOOST_REQUIRE_THROW(insertLsh.Insert(arma::randu<arma::mat>(3, 10)),
+      std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(RemoveTest)
+{
+  // A removed point should never be returned as a neighbor.
+  arma::mat dataset = arma::randu<arma::mat>(4, 500);
+  arma::mat queries = arma::randu<arma::mat>(4, 50);
+
+  LSHSearch<> lsh(dataset, 3, 4);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  lsh.Search(queries, 1, neighbors, distances);
+
+  std::vector<bool> isRemoved(dataset.n_cols, false);
+  for (size_t i = 0; i < neighbors.n_cols; ++i)
+  {
+    if (neighbors(0, i) < dataset.n_cols)
+    {
+      lsh.Remove(neighbors(0, i));
+      isRemoved[neighbors(0, i)] = true;
+    }
+  }
+
+  lsh.Search(queries, 3, neighbors, distances);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+    if (neighbors[i] < dataset.n_cols)
+      BOOST_REQUIRE_EQUAL(isRemoved[neighbors[i]], false);
+
+  BOOST_REQUIRE_THROW(lsh.Remove(dataset.n_cols), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(SimHashSignatureTest)
+{
+  // With SimHash, the signature of a point holds its key bits in every table,
+  // and the negation of a point is on the other side of every hyperplane.
+  arma::mat dataset = arma::randn<arma::mat>(6, 200);
+  dataset.cols(100, 199) = -dataset.cols(0, 99);
+
+  LSHSearch<NearestNeighborSort, SimHash> lsh(dataset, 70, 3);
+
+  const size_t words = lsh.SignatureWords();
+  BOOST_REQUIRE_EQUAL(words, 6); // Two words for each of the three tables.
+  BOOST_REQUIRE_EQUAL(lsh.Signatures().size(), 200 * words);
+
+  const uint64_t* signatures = &lsh.Signatures()[0];
+  for (size_t i = 0; i < 100; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(LSHSearch<>::HammingDistance(signatures + i * words,
+        signatures + i * words, words), 0);
+    BOOST_REQUIRE_EQUAL(LSHSearch<>::HammingDistance(signatures + i * words,
+        signatures + (i + 100) * words, words), 210);
+  }
+
+  // The unused bits of each table are zero.
+  for (size_t i = 0; i < 200; ++i)
+    for (size_t t = 0; t < 3; ++t)
+      BOOST_REQUIRE_EQUAL(signatures[i * words + 2 * t + 1] >> 6, 0);
+
+  // P-stable hashing has no signatures.
+  LSHSearch<> pStableLsh(dataset, 3, 2);
+  BOOST_REQUIRE_EQUAL(pStableLsh.SignatureWords(), 0);
+  BOOST_REQUIRE_EQUAL(pStableLsh.Signatures().size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(HammingFilterTest)
+{
+  // With a maximum Hamming distance of 0, only candidates with the same
+  // signature as the query are kept, and with no limit the results are the
+  // same as without filtering.
+  arma::mat dataset = arma::randn<arma::mat>(4, 500);
+  arma::mat queries = arma::randn<arma::mat>(4, 50);
+
+  LSHSearch<NearestNeighborSort, SimHash> lsh(dataset, 4, 3);
+
+  arma::Mat<size_t> neighbors, filteredNeighbors, unlimitedNeighbors;
+  arma::mat distances, filteredDistances, unlimitedDistances;
+  lsh.Search(queries, 3, neighbors, distances);
+  const size_t evaluations = lsh.DistanceEvaluations();
+  lsh.Search(queries, 3, unlimitedNeighbors, unlimitedDistances, 0, 0,
+      12);
+  lsh.Search(queries, 3, filteredNeighbors, filteredDistances, 0, 0, 0);
+
+  // The exact distance of discarded candidates is not computed.
+  BOOST_REQUIRE_LT(lsh.DistanceEvaluations(), 3 * evaluations);
+
+  // Compute the signatures of the queries by hashing them as new points.
+  LSHSearch<NearestNeighborSort, SimHash> queryLsh(lsh);
+  queryLsh.Insert(queries);
+  const size_t words = lsh.SignatureWords();
+  const uint64_t* signatures = &queryLsh.Signatures()[0];
+
+  for (size_t i = 0; i < queries.n_cols; ++i)
+  {
+    for (size_t j = 0; j < 3; ++j)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors(j, i), unlimitedNeighbors(j, i));
+      BOOST_REQUIRE_GE(filteredDistances(j, i), distances(j, i));
+
+      if (filteredNeighbors(j, i) < dataset.n_cols)
+        BOOST_REQUIRE_EQUAL(LSHSearch<>::HammingDistance(
+            signatures + (dataset.n_cols + i) * words,
+            signatures + filteredNeighbors(j, i) * words, words), 0);
+    }
+  }
+
+  // Filtering needs binary keys.
+  LSHSearch<> pStableLsh(dataset, 3, 2);
+  BOOST_REQUIRE_THROW(pStableLsh.Search(queries, 3, neighbors, distances, 0,
+      0, 5), std::invalid_argument);
+  BOOST_REQUIRE_THROW(pStableLsh.Search(3, neighbors, distances, 0, 0, 5),
+      std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(BitSamplingTest)
+{
+  // For binary points, a copy of a reference point falls into the same bucket
+  // in every table, so it is always found at distance 0, and the Hamming
+  // distance of the signatures of any two points is at most the number of
+  // coordinates they differ in times the number of hash functions.
+  arma::mat dataset = arma::round(arma::randu<arma::mat>(32, 300));
+  arma::mat queries = dataset.cols(100, 119);
+
+  LSHSearch<NearestNeighborSort, BitSamplingHash> lsh(dataset, 8, 4);
+
+  const arma::Col<size_t>& dimensions = lsh.Hash().Dimensions();
+  BOOST_REQUIRE_EQUAL(dimensions.n_elem, 32);
+  for (size_t i = 0; i < dimensions.n_elem; ++i)
+    BOOST_REQUIRE_LT(dimensions[i], 32);
+
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  lsh.Search(queries, 1, neighbors, distances, 0, 0, 0);
+
+  for (size_t i = 0; i < queries.n_cols; ++i)
+  {
+    BOOST_REQUIRE_SMALL(distances(0, i), 1e-5);
+    BOOST_REQUIRE_SMALL(arma::norm(dataset.col(neighbors(0, i)) -
+        queries.col(i), 2), 1e-5);
+  }
+
+  // The sampled bits of a point are its key; check them for one point.
+  const size_t words = lsh.SignatureWords();
+  BOOST_REQUIRE_EQUAL(words, 4);
+  for (size_t t = 0; t < 4; ++t)
+  {
+    for (size_t p = 0; p < 8; ++p)
+    {
+      const uint64_t bit = (lsh.Signatures()[t] >> p) & 1;
+      BOOST_REQUIRE_EQUAL((double) bit, dataset(dimensions[8 * t + p], 0));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SimHashMultiprobeTest)
+{
+  // Multiprobe LSH flips the bits of the query key that are least certain, so
+  // it can only add candidates.
+  arma::mat referenceData = arma::randn<arma::mat>(5, 500);
+  arma::mat queryData = arma::randn<arma::mat>(5, 100);
+
+  LSHSearch<NearestNeighborSort, SimHash> lsh(referenceData, 8, 1);
+
+  arma::Mat<size_t> neighbors, multiprobeNeighbors;
+  arma::mat distances, multiprobeDistances;
+  lsh.Search(queryData, 3, neighbors, distances);
+  lsh.Search(queryData, 3, multiprobeNeighbors, multiprobeDistances, 0, 10);
+
+  size_t improved = 0;
+  for (size_t i = 0; i < distances.n_elem; ++i)
+  {
+    BOOST_REQUIRE_LE(multiprobeDistances[i], distances[i]);
+    if (multiprobeDistances[i] < distances[i])
+      ++improved;
+  }
+
+  BOOST_REQUIRE_GT(improved, 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -7,6 +7,8 @@
 #include <mlpack/core/math/clamp.hpp>
 #include <mlpack/core/math/random.hpp>
 #include <mlpack/core/math/range.hpp>
+#include <ctime>
+#include <vector>
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
 
@@ -578,4 +580,146 @@ BOOST_AUTO_TEST_CASE(RangeContainsRange)
   BOOST_REQUIRE_EQUAL(b.Contains(a), true);
 }
 
+/**
+ * Make sure that RandomStream gives the known answer of Philox4x32-10 for the
+ * zero key and counter.
+ */
+BOOST_AUTO_TEST_CASE(RandomStreamKnownAnswerTest)
+{
+  RandomStream stream(0, 0);
+
+  BOOST_REQUIRE_EQUAL(stream(), 0x6627e8d5U);
+  BOOST_REQUIRE_EQUAL(stream(), 0xe169c58dU);
+  BOOST_REQUIRE_EQUAL(stream(), 0xbc57ac4cU);
+  BOOST_REQUIRE_EQUAL(stream(), 0x9b00dbd8U);
+}
+
+/**
+ * Skipping numbers, splitting, and filling a matrix should all give the same
+ * numbers as drawing them one at a time.
+ */
+BOOST_AUTO_TEST_CASE(RandomStreamDiscardSplitFillTest)
+{
+  RandomStream a(42, 7), b(42, 7);
+  for (size_t i = 0; i < 13; ++i)
+    a();
+  b.discard(13);
+  for (size_t i = 0; i < 20; ++i)
+    BOOST_REQUIRE_EQUAL(a(), b());
+
+  // A split does not depend on what has been drawn.
+  RandomStream split = a.Split(3);
+  a();
+  RandomStream other = a.Split(3);
+  BOOST_REQUIRE_EQUAL(split(), other());
+  BOOST_REQUIRE_NE(a.Split(4)(), a.Split(3)());
+
+  // Each pair of elements comes from one block; this matrix is large enough to
+  // be filled in parallel.
+  RandomStream c(5, 3), d(5, 3);
+  arma::mat m(501, 101);
+  c.Randu(m);
+  for (size_t i = 0; i < m.n_elem; i += 2)
+  {
+    const double first = d.Random();
+    const double second = d.Random();
+    BOOST_REQUIRE_EQUAL(m[i], first);
+    if (i + 1 < m.n_elem)
+      BOOST_REQUIRE_EQUAL(m[i + 1], second);
+  }
+  BOOST_REQUIRE_EQUAL(c(), d());
+
+  arma::mat n(1000, 100);
+  c.Randn(n);
+  BOOST_REQUIRE_SMALL(arma::mean(arma::vectorise(n)), 0.01);
+  BOOST_REQUIRE_CLOSE(arma::var(arma::vectorise(n)), 1.0, 1.0);
+}
+
+/**
+ * The random functions should give the same numbers to each thread of a
+ * parallel loop after the seed is set again, and NewRandomStream() should give
+ * the same streams.
+ */
+BOOST_AUTO_TEST_CASE(ThreadRandomStreamTest)
+{
+  std::vector<double> first(64), second(64);
+
+  RandomSeed(123);
+  const uint64_t stream = NewRandomStream().Stream();
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < 64; ++i)
+    first[i] = Random() + RandNormal() + RandInt(10);
+
+  RandomSeed(123);
+  BOOST_REQUIRE_EQUAL(NewRandomStream().Stream(), stream);
+  #pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < 64; ++i)
+    second[i] = Random() + RandNormal() + RandInt(10);
+
+  for (size_t i = 0; i < 64; ++i)
+    BOOST_REQUIRE_EQUAL(first[i], second[i]);
+
+  RandomSeed(std::time(NULL));
+}
+
+/**
+ * The bits of a Bernoulli mask should be set exactly when the numbers drawn
+ * one at a time are below the threshold, and the stream should continue after
+ * the blocks the mask used.
+ */
+BOOST_AUTO_TEST_CASE(RandomStreamBernoulliTest)
+{
+  RandomStream a(11, 2), b(11, 2);
+  std::vector<uint64_t> bits;
+
+  // The mask is large enough to be drawn in parallel, and does not fill its
+  // last word.
+  const size_t n = 64 * 2000 + 37;
+  a.Bernoulli(n, 0.3, bits);
+  BOOST_REQUIRE_EQUAL(bits.size(), 2001);
+
+  size_t set = 0;
+  const uint64_t threshold = (uint64_t) (0.3 * 4294967296.0);
+  for (size_t i = 0; i < 64 * bits.size(); ++i)
+  {
+    const bool expected = (i < n) && (b() < threshold);
+    const bool bit = ((bits[i / 64] >> (i % 64)) & 1) == 1;
+    BOOST_REQUIRE_EQUAL(bit, expected);
+    if (bit)
+      ++set;
+  }
+  BOOST_REQUIRE_EQUAL(a(), b());
+  BOOST_REQUIRE_CLOSE((double) set / n, 0.3, 2.0);
+
+  // With p = 0 no bit is set, and with p = 1 every bit is.
+  a.Bernoulli(100, 0.0, bits);
+  BOOST_REQUIRE_EQUAL(bits[0], 0);
+  BOOST_REQUIRE_EQUAL(bits[1], 0);
+  a.Bernoulli(100, 1.0, bits);
+  BOOST_REQUIRE_EQUAL(bits[0], ~((uint64_t) 0));
+  BOOST_REQUIRE_EQUAL(bits[1], ((uint64_t) 1 << 36) - 1);
+}
+
+/**
+ * While a ScopedRandomStream lives, the random functions should draw from its
+ * stream, even on the main thread; afterwards they should go back to randGen.
+ */
+BOOST_AUTO_TEST_CASE(ScopedRandomStreamTest)
+{
+  RandomSeed(321);
+  const double first = Random();
+  RandomSeed(321);
+
+  RandomStream stream(9, 4), copy(9, 4);
+  {
+    ScopedRandomStream scope(stream);
+    for (size_t i = 0; i < 10; ++i)
+      BOOST_REQUIRE_EQUAL(Random(), copy.Random());
+    BOOST_REQUIRE_EQUAL(RandInt(100), copy.RandInt(100));
+  }
+
+  BOOST_REQUIRE_EQUAL(Random(), first);
+  RandomSeed(std::time(NULL));
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -6,6 +6,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/matrix_completion/matrix_completion.hpp>
+#include <mlpack/methods/matrix_completion/als_matrix_completion.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -59,4 +60,56 @@ BOOST_AUTO_TEST_CASE(UniformMatrixCompletionSDP)
   }
 }
 
+/**
+ * Make sure that ALSMatrixCompletion recovers a random low rank matrix from a
+ * subset of its entries.
+ */
+BOOST_AUTO_TEST_CASE(LowRankMatrixCompletionALS)
+{
+  const size_t m = 100;
+  const size_t n = 80;
+  const size_t rank = 3;
+
+  const arma::mat xOrig = arma::randu<arma::mat>(m, rank) *
+      arma::randu<arma::mat>(rank, n);
+
+  // Take about 40% of the entries.
+  arma::umat indices(2, m * n);
+  arma::vec values(m * n);
+  size_t p = 0;
+  for (size_t j = 0; j < n; ++j)
+  {
+    for (size_t i = 0; i < m; ++i)
+    {
+      if (math::Random() < 0.4)
+      {
+        indices(0, p) = i;
+        indices(1, p) = j;
+        values[p++] = xOrig(i, j);
+      }
+    }
+  }
+  indices.resize(2, p);
+  values.resize(p);
+
+  ALSMatrixCompletion mc(m, n, indices, values, rank, 1e-8);
+  arma::mat recovered;
+  mc.Recover(recovered);
+
+  BOOST_REQUIRE_EQUAL(recovered.n_rows, m);
+  BOOST_REQUIRE_EQUAL(recovered.n_cols, n);
+
+  const double err = arma::norm(xOrig - recovered, "fro") /
+      arma::norm(xOrig, "fro");
+  BOOST_REQUIRE_SMALL(err, 1e-3);
+
+  // The factors should give the same matrix.
+  arma::mat w, h;
+  mc.Recover(w, h);
+  BOOST_REQUIRE_EQUAL(w.n_cols, rank);
+  BOOST_REQUIRE_EQUAL(h.n_rows, rank);
+  BOOST_REQUIRE_SMALL(arma::norm(xOrig - w * h, "fro") /
+      arma::norm(xOrig, "fro"), 1e-3);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -143,4 +143,69 @@ BOOST_AUTO_TEST_CASE(GaussianClustering)
       BOOST_REQUIRE_NE(minIndices[i], minIndices[j]);
 }
 
+/**
+ * Parallel range searches give the same clustering as serial ones.
+ */
+BOOST_AUTO_TEST_CASE(ParallelMeanShiftTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(2, 500);
+  dataset.cols(250, 499) += 5.0;
+
+  MeanShift<> serial(0.5);
+  MeanShift<> parallel(0.5);
+  parallel.Parallel() = true;
+
+  arma::Col<size_t> serialAssignments, parallelAssignments;
+  arma::mat serialCentroids, parallelCentroids;
+  serial.Cluster(dataset, serialAssignments, serialCentroids);
+  parallel.Cluster(dataset, parallelAssignments, parallelCentroids);
+
+  BOOST_REQUIRE_EQUAL(serialCentroids.n_cols, parallelCentroids.n_cols);
+  for (size_t i = 0; i < serialCentroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(serialCentroids[i], parallelCentroids[i], 1e-5);
+  for (size_t i = 0; i < serialAssignments.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(serialAssignments[i], parallelAssignments[i]);
+}
+
+/**
+ * Parallel centroid updates with a kernel, starting from every point, give the
+ * same clustering as serial ones.
+ */
+BOOST_AUTO_TEST_CASE(ParallelKernelMeanShiftTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(2, 400);
+  dataset.cols(200, 399) += 5.0;
+
+  MeanShift<true> serial(0.75);
+  MeanShift<true> parallel(0.75);
+  parallel.Parallel() = true;
+
+  arma::Col<size_t> serialAssignments, parallelAssignments;
+  arma::mat serialCentroids, parallelCentroids;
+  serial.Cluster(dataset, serialAssignments, serialCentroids, false);
+  parallel.Cluster(dataset, parallelAssignments, parallelCentroids, false);
+
+  BOOST_REQUIRE_EQUAL(serialCentroids.n_cols, parallelCentroids.n_cols);
+  for (size_t i = 0; i < serialCentroids.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(serialCentroids[i], parallelCentroids[i], 1e-5);
+  for (size_t i = 0; i < serialAssignments.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(serialAssignments[i], parallelAssignments[i]);
+}
+
+/**
+ * Make sure the radius estimated from a k-nearest-neighbor graph is the same as
+ * the radius estimated from the data.
+ */
+BOOST_AUTO_TEST_CASE(EstimateRadiusFromGraphTest)
+{
+  arma::mat data;
+  data.randu(2, 200);
+
+  MeanShift<> meanShift;
+  const double radius = meanShift.EstimateRadius(data, 0.1);
+
+  neighbor::KNNGraph<> graph(data, 20);
+  BOOST_REQUIRE_CLOSE(meanShift.EstimateRadius(graph), radius, 1e-5);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
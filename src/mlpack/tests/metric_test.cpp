@@ -82,4 +82,126 @@ BOOST_AUTO_TEST_CASE(LINFMetricTest)
                       lMetric.Evaluate(a2, b2), 1e-5);
 }
 
+/**
+ * Make sure the vectorized L1, L2, and L-infinity distances are the same as
+ * the Armadillo expressions, for float and double vectors of every length up
+ * to 100 (which covers the inline case, the kernels, and their scalar tails),
+ * and for columns of matrices.
+ */
+template<typename MatType>
+void CheckLMetricKernels(const double tolerance)
+{
+  for (size_t n = 1; n <= 100; ++n)
+  {
+    MatType data(n, 2);
+    data.randn();
+
+    const typename MatType::col_type a = data.col(0);
+    const typename MatType::col_type b = data.col(1);
+
+    BOOST_REQUIRE_CLOSE(ManhattanDistance::Evaluate(a, b),
+        (double) arma::accu(arma::abs(a - b)), tolerance);
+    BOOST_REQUIRE_CLOSE(SquaredEuclideanDistance::Evaluate(a, b),
+        (double) arma::accu(arma::square(a - b)), tolerance);
+    BOOST_REQUIRE_CLOSE(EuclideanDistance::Evaluate(a, b),
+        std::sqrt((double) arma::accu(arma::square(a - b))), tolerance);
+    BOOST_REQUIRE_CLOSE(ChebyshevDistance::Evaluate(a, b),
+        (double) arma::as_scalar(arma::max(arma::abs(a - b))), tolerance);
+
+    // Columns of the matrix should give the same results as the copies.
+    BOOST_REQUIRE_EQUAL(ManhattanDistance::Evaluate(data.col(0), data.col(1)),
+        ManhattanDistance::Evaluate(a, b));
+    BOOST_REQUIRE_EQUAL(EuclideanDistance::Evaluate(data.col(0), data.col(1)),
+        EuclideanDistance::Evaluate(a, b));
+    BOOST_REQUIRE_EQUAL(ChebyshevDistance::Evaluate(data.col(0), data.col(1)),
+        ChebyshevDistance::Evaluate(a, b));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(LMetricKernelTest)
+{
+  CheckLMetricKernels<arma::mat>(1e-8);
+  CheckLMetricKernels<arma::fmat>(1e-3);
+}
+
+/**
+ * Make sure that the distance with a bound is either the full distance (if it
+ * is not greater than the bound) or greater than the bound.
+ */
+BOOST_AUTO_TEST_CASE(BoundedLMetricTest)
+{
+  for (size_t n = 1; n <= 1000; n += 37)
+  {
+    arma::mat data(n, 2);
+    data.randu();
+
+    const double l1 = ManhattanDistance::Evaluate(data.col(0), data.col(1));
+    const double l2 = EuclideanDistance::Evaluate(data.col(0), data.col(1));
+    const double lInf = ChebyshevDistance::Evaluate(data.col(0), data.col(1));
+
+    // A loose bound gives the full distance.
+    BOOST_REQUIRE_EQUAL(ManhattanDistance::Evaluate(data.col(0), data.col(1),
+        2 * l1), l1);
+    BOOST_REQUIRE_EQUAL(EuclideanDistance::Evaluate(data.col(0), data.col(1),
+        2 * l2), l2);
+    BOOST_REQUIRE_EQUAL(ChebyshevDistance::Evaluate(data.col(0), data.col(1),
+        2 * lInf), lInf);
+
+    // A tight bound gives something between the bound and the distance.
+    const double l1Bounded = ManhattanDistance::Evaluate(data.col(0),
+        data.col(1), l1 / 4);
+    BOOST_REQUIRE_GT(l1Bounded, l1 / 4);
+    BOOST_REQUIRE_LE(l1Bounded, l1);
+
+    const double l2Bounded = EuclideanDistance::Evaluate(data.col(0),
+        data.col(1), l2 / 4);
+    BOOST_REQUIRE_GT(l2Bounded, l2 / 4);
+    BOOST_REQUIRE_LE(l2Bounded, l2);
+
+    // Metrics that don't stop early give the full distance.
+    LMetric<3, false> l3;
+    BOOST_REQUIRE_EQUAL(BoundedEvaluate(l3, data.col(0), data.col(1), 0.0),
+        l3.Evaluate(data.col(0), data.col(1)));
+  }
+}
+
+/**
+ * Make sure that the distances between sparse vectors, which only visit the
+ * nonzero elements, are the same as between the same vectors stored densely.
+ */
+BOOST_AUTO_TEST_CASE(SparseLMetricTest)
+{
+  for (size_t n = 1; n <= 1000; n += 37)
+  {
+    arma::sp_mat data;
+    data.sprandu(n, 2, 0.1);
+    data(n - 1, 1) = 0.5; // The vectors overlap in at least one dimension.
+    data(n - 1, 0) = 0.25;
+    const arma::mat dense(data);
+
+    BOOST_REQUIRE_CLOSE(ManhattanDistance::Evaluate(data.col(0), data.col(1)),
+        ManhattanDistance::Evaluate(dense.col(0), dense.col(1)), 1e-8);
+    BOOST_REQUIRE_CLOSE(EuclideanDistance::Evaluate(data.col(0), data.col(1)),
+        EuclideanDistance::Evaluate(dense.col(0), dense.col(1)), 1e-8);
+    BOOST_REQUIRE_CLOSE(SquaredEuclideanDistance::Evaluate(data.col(0),
+        data.col(1)), SquaredEuclideanDistance::Evaluate(dense.col(0),
+        dense.col(1)), 1e-8);
+    BOOST_REQUIRE_CLOSE(ChebyshevDistance::Evaluate(data.col(0), data.col(1)),
+        ChebyshevDistance::Evaluate(dense.col(0), dense.col(1)), 1e-8);
+
+    // A tight bound gives something between the bound and the distance.
+    const double l1 = ManhattanDistance::Evaluate(data.col(0), data.col(1));
+    const double l1Bounded = ManhattanDistance::Evaluate(data.col(0),
+        data.col(1), l1 / 4);
+    BOOST_REQUIRE_GT(l1Bounded, l1 / 4);
+    BOOST_REQUIRE_LE(l1Bounded, l1 + 1e-10);
+  }
+
+  // The distance between a vector and itself is 0.
+  arma::sp_mat point;
+  point.sprandu(100, 1, 0.2);
+  BOOST_REQUIRE_SMALL(EuclideanDistance::Evaluate(point.col(0), point.col(0)),
+      1e-10);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -285,4 +285,56 @@ BOOST_AUTO_TEST_CASE(SeparateTrainIndividualIncrementalTest)
   }
 }
 
+/**
+ * Make sure that training on a dataset one batch at a time gives the same
+ * model as training on the whole dataset at once, and that the model can be
+ * used to classify.
+ */
+BOOST_AUTO_TEST_CASE(BatchIncrementalTrainTest)
+{
+  // Three well-separated classes, with different variances.
+  const size_t classes = 3;
+  arma::mat data(4, 3000);
+  arma::Row<size_t> labels(data.n_cols);
+  for (size_t i = 0; i < data.n_cols; ++i)
+  {
+    labels[i] = math::RandInt(classes);
+    data.col(i) = arma::randn<arma::vec>(4) * (labels[i] + 1) +
+        10.0 * labels[i];
+  }
+
+  NaiveBayesClassifier<> nbc(data, labels, classes);
+
+  // Train on batches of different sizes (one of them has only one point).
+  NaiveBayesClassifier<> nbcBatch(data.n_rows, classes);
+  const size_t bounds[] = { 0, 1, 700, 701, 2000, 3000 };
+  for (size_t b = 0; b < 5; ++b)
+  {
+    nbcBatch.Train(data.cols(bounds[b], bounds[b + 1] - 1),
+        labels.subvec(bounds[b], bounds[b + 1] - 1));
+  }
+
+  BOOST_REQUIRE_EQUAL(nbcBatch.TrainingPoints(), data.n_cols);
+  for (size_t i = 0; i < nbc.Means().n_elem; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(nbc.Means()[i], nbcBatch.Means()[i], 1e-5);
+    BOOST_REQUIRE_CLOSE(nbc.Variances()[i], nbcBatch.Variances()[i], 1e-5);
+  }
+  for (size_t i = 0; i < classes; ++i)
+    BOOST_REQUIRE_CLOSE(nbc.Probabilities()[i], nbcBatch.Probabilities()[i],
+        1e-5);
+
+  // The classes are far enough apart that almost every point is classified
+  // correctly.
+  arma::Row<size_t> predictions;
+  nbcBatch.Classify(data, predictions);
+  BOOST_REQUIRE_EQUAL(predictions.n_elem, data.n_cols);
+
+  size_t correct = 0;
+  for (size_t i = 0; i < data.n_cols; ++i)
+    if (predictions[i] == labels[i])
+      ++correct;
+  BOOST_REQUIRE_GT(correct, 0.98 * data.n_cols);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
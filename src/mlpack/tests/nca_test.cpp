@@ -318,4 +318,114 @@ BOOST_AUTO_TEST_CASE(NCALBFGSSimpleDataset)
 
 }
 
+/**
+ * Make sure that the fused objective and gradient of the softmax error function
+ * are the same as the separate ones, both for the whole dataset and for each
+ * point.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxEvaluateWithGradient)
+{
+  arma::mat data;
+  data.randu(3, 40);
+  arma::Col<size_t> labels(40);
+  for (size_t i = 0; i < 40; ++i)
+    labels[i] = (i < 20) ? 0 : 1;
+
+  BOOST_REQUIRE(HasEvaluateWithGradient<
+      SoftmaxErrorFunction<SquaredEuclideanDistance> >::value);
+  BOOST_REQUIRE(HasSeparableEvaluateWithGradient<
+      SoftmaxErrorFunction<SquaredEuclideanDistance> >::value);
+
+  SoftmaxErrorFunction<SquaredEuclideanDistance> sef(data, labels);
+  const arma::mat coordinates = arma::randu<arma::mat>(3, 3);
+
+  arma::mat gradient, fusedGradient;
+  const double objective = sef.Evaluate(coordinates);
+  sef.Gradient(coordinates, gradient);
+  BOOST_REQUIRE_CLOSE(sef.EvaluateWithGradient(coordinates, fusedGradient),
+      objective, 1e-10);
+  for (size_t j = 0; j < gradient.n_elem; ++j)
+    BOOST_REQUIRE_CLOSE(fusedGradient[j], gradient[j], 1e-10);
+
+  for (size_t i = 0; i < 40; ++i)
+  {
+    const double pointObjective = sef.Evaluate(coordinates, i);
+    sef.Gradient(coordinates, i, gradient);
+    BOOST_REQUIRE_CLOSE(sef.EvaluateWithGradient(coordinates, i,
+        fusedGradient), pointObjective, 1e-10);
+    for (size_t j = 0; j < gradient.n_elem; ++j)
+      BOOST_REQUIRE_CLOSE(fusedGradient[j], gradient[j], 1e-10);
+  }
+}
+
+/**
+ * When the softmax is truncated to all of the other points, the truncated
+ * objective and gradients should be the same as the full ones.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxTruncatedAllNeighbors)
+{
+  arma::mat data = arma::randu<arma::mat>(3, 30);
+  arma::Col<size_t> labels(30);
+  for (size_t i = 0; i < 30; ++i)
+    labels[i] = (i < 15) ? 0 : 1;
+
+  SoftmaxErrorFunction<SquaredEuclideanDistance> sef(data, labels);
+  SoftmaxErrorFunction<SquaredEuclideanDistance> truncatedSef(data, labels);
+  truncatedSef.NumNeighbors() = 29;
+
+  const arma::mat coordinates = arma::randu<arma::mat>(3, 3);
+
+  arma::mat gradient, truncatedGradient;
+  BOOST_REQUIRE_CLOSE(truncatedSef.Evaluate(coordinates),
+      sef.Evaluate(coordinates), 1e-8);
+  sef.Gradient(coordinates, gradient);
+  truncatedSef.Gradient(coordinates, truncatedGradient);
+  for (size_t j = 0; j < gradient.n_elem; ++j)
+    BOOST_REQUIRE_SMALL(truncatedGradient[j] - gradient[j], 1e-8);
+
+  for (size_t i = 0; i < 30; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(truncatedSef.Evaluate(coordinates, i),
+        sef.Evaluate(coordinates, i), 1e-8);
+    sef.Gradient(coordinates, i, gradient);
+    truncatedSef.Gradient(coordinates, i, truncatedGradient);
+    for (size_t j = 0; j < gradient.n_elem; ++j)
+      BOOST_REQUIRE_SMALL(truncatedGradient[j] - gradient[j], 1e-8);
+  }
+
+  // There are not 30 other points to truncate to.
+  truncatedSef.NumNeighbors() = 30;
+  BOOST_REQUIRE_THROW(truncatedSef.Evaluate(coordinates),
+      std::invalid_argument);
+}
+
+/**
+ * With a truncated softmax, NCA should still separate the points of a simple
+ * dataset.
+ */
+BOOST_AUTO_TEST_CASE(NCALBFGSTruncatedDataset)
+{
+  // Useful but simple dataset with six points and two classes.
+  arma::mat data           = "-0.1 -0.1 -0.1  0.1  0.1  0.1;"
+                             " 1.0  0.0 -1.0  1.0  0.0 -1.0 ";
+  arma::Col<size_t> labels = " 0    0    0    1    1    1   ";
+
+  NCA<SquaredEuclideanDistance, L_BFGS> nca(data, labels);
+  nca.NumNeighbors() = 3;
+  nca.Optimizer().NumBasis() = 5;
+
+  arma::mat outputMatrix;
+  nca.LearnDistance(outputMatrix);
+
+  // Ensure that the objective function is better now, both with and without
+  // the truncation.
+  SoftmaxErrorFunction<SquaredEuclideanDistance> sef(data, labels);
+  const double initObj = sef.Evaluate(arma::eye<arma::mat>(2, 2));
+  BOOST_REQUIRE_LT(sef.Evaluate(outputMatrix), initObj);
+
+  sef.NumNeighbors() = 3;
+  const double truncatedInitObj = sef.Evaluate(arma::eye<arma::mat>(2, 2));
+  BOOST_REQUIRE_LT(sef.Evaluate(outputMatrix), truncatedInitObj);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
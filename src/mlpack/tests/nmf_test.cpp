@@ -10,6 +10,7 @@
 #include <mlpack/methods/amf/update_rules/nmf_mult_div.hpp>
 #include <mlpack/methods/amf/update_rules/nmf_als.hpp>
 #include <mlpack/methods/amf/update_rules/nmf_mult_dist.hpp>
+#include <mlpack/methods/amf/update_rules/weighted_als.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -211,4 +212,106 @@ BOOST_AUTO_TEST_CASE(SparseNMFALSTest)
       1e-5);
 }
 
+/**
+ * The weighted ALS update rule only fits the observed entries, so it should
+ * recover the missing entries of a low-rank matrix of which only half of the
+ * entries are observed.
+ */
+BOOST_AUTO_TEST_CASE(SparseWeightedALSTest)
+{
+  mat w = randu<mat>(30, 3) + 0.5;
+  mat h = randu<mat>(3, 40) + 0.5;
+  const mat v = w * h;
+
+  // Observe about half of the entries.
+  const mat observed = randu<mat>(30, 40);
+  const size_t numObserved = accu(observed < 0.5);
+  umat locations(2, numObserved);
+  vec values(numObserved);
+  size_t k = 0;
+  for (size_t j = 0; j < v.n_cols; ++j)
+  {
+    for (size_t i = 0; i < v.n_rows; ++i)
+    {
+      if (observed(i, j) < 0.5)
+      {
+        locations(0, k) = i;
+        locations(1, k) = j;
+        values[k++] = v(i, j);
+      }
+    }
+  }
+  const sp_mat sv(locations, values, 30, 40);
+
+  SimpleResidueTermination srt(1e-10, 500);
+  AMF<SimpleResidueTermination, RandomInitialization, WeightedALSUpdate>
+      als(srt, RandomInitialization(), WeightedALSUpdate(1e-6));
+  als.Apply(sv, 3, w, h);
+
+  // Check the reconstruction of the missing entries.
+  const mat wh = w * h;
+  double error = 0.0, norm = 0.0;
+  for (size_t i = 0; i < v.n_elem; ++i)
+  {
+    if (observed[i] >= 0.5)
+    {
+      error += std::pow(v[i] - wh[i], 2.0);
+      norm += std::pow(v[i], 2.0);
+    }
+  }
+
+  BOOST_REQUIRE_SMALL(std::sqrt(error / norm), 0.01);
+}
+
+/**
+ * Check that the sparse versions of the multiplicative update rules, which only
+ * use the nonzero entries of V, take the same steps as the dense versions.
+ */
+BOOST_AUTO_TEST_CASE(SparseMultiplicativeUpdateTest)
+{
+  sp_mat v;
+  v.sprandu(40, 30, 0.2);
+  const mat dv(v);
+  const size_t r = 5;
+
+  const mat w = 0.5 + randu<mat>(40, r);
+  const mat h = 0.5 + randu<mat>(r, 30);
+
+  NMFMultiplicativeDistanceUpdate distance;
+  distance.Initialize(v, r);
+  mat sw(w), dw(w), sh(h), dh(h);
+  distance.WUpdate(v, sw, sh);
+  NMFMultiplicativeDistanceUpdate::WUpdate(dv, dw, dh);
+  distance.HUpdate(v, sw, sh);
+  NMFMultiplicativeDistanceUpdate::HUpdate(dv, dw, dh);
+
+  for (size_t i = 0; i < sw.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(sw[i], dw[i], 1e-8);
+  for (size_t i = 0; i < sh.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(sh[i], dh[i], 1e-8);
+
+  NMFMultiplicativeDivergenceUpdate divergence;
+  divergence.Initialize(v, r);
+  sw = w; dw = w; sh = h; dh = h;
+  divergence.WUpdate(v, sw, sh);
+  NMFMultiplicativeDivergenceUpdate::WUpdate(dv, dw, dh);
+  divergence.HUpdate(v, sw, sh);
+  NMFMultiplicativeDivergenceUpdate::HUpdate(dv, dw, dh);
+
+  for (size_t i = 0; i < sw.n_elem; ++i)
+  {
+    if (std::abs(dw[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(sw[i], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(sw[i], dw[i], 1e-8);
+  }
+  for (size_t i = 0; i < sh.n_elem; ++i)
+  {
+    if (std::abs(dh[i]) < 1e-10)
+      BOOST_REQUIRE_SMALL(sh[i], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(sh[i], dh[i], 1e-8);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
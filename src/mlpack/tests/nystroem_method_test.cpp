@@ -13,6 +13,7 @@
 #include <mlpack/methods/nystroem_method/ordered_selection.hpp>
 #include <mlpack/methods/nystroem_method/random_selection.hpp>
 #include <mlpack/methods/nystroem_method/kmeans_selection.hpp>
+#include <mlpack/methods/nystroem_method/kmeans_plus_plus_selection.hpp>
 #include <mlpack/methods/nystroem_method/nystroem_method.hpp>
 
 using namespace mlpack;
@@ -179,4 +180,40 @@ BOOST_AUTO_TEST_CASE(GermanTest)
   }
 }
 
+/**
+ * Make sure the k-means++ seeding selects distinct points, and that it can
+ * accurately represent a rank-10 matrix.
+ */
+BOOST_AUTO_TEST_CASE(KMeansPlusPlusSelectionTest)
+{
+  arma::mat data;
+  data.randu(20, 300);
+
+  arma::Col<size_t> selected = KMeansPlusPlusSelection::Select(data, 50);
+  BOOST_REQUIRE_EQUAL(selected.n_elem, 50);
+  for (size_t i = 0; i < selected.n_elem; ++i)
+  {
+    BOOST_REQUIRE_LT(selected[i], data.n_cols);
+    for (size_t j = 0; j < i; ++j)
+      BOOST_REQUIRE_NE(selected[i], selected[j]);
+  }
+
+  // Build a rank-10 dataset.
+  arma::mat basis = arma::randu<arma::mat>(100, 10);
+  arma::mat dataMod = basis * arma::randu<arma::mat>(10, 400);
+  dataMod += 1e-5 * arma::randu<arma::mat>(dataMod.n_rows, dataMod.n_cols);
+  arma::mat kernel = dataMod.t() * dataMod;
+
+  LinearKernel lk;
+  NystroemMethod<LinearKernel, KMeansPlusPlusSelection> nm(dataMod, lk, 10);
+
+  arma::mat g;
+  nm.Apply(g);
+  arma::mat approximation = g * g.t();
+
+  const double normalizedFro = arma::norm(kernel - approximation, "fro") /
+      arma::norm(kernel, "fro");
+  BOOST_REQUIRE_SMALL(normalizedFro, 1e-3);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,201 @@
+/**
+ * @file parallel_test.cpp
+ * @author Ryan Curtin
+ *
+ * Tests for the parallel runtime in core/util/parallel.hpp.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/util/parallel.hpp>
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+
+BOOST_AUTO_TEST_SUITE(ParallelTest);
+
+/**
+ * Make sure that parallel::For() calls the function exactly once for every
+ * index, with a static schedule and with a few chunk sizes.
+ */
+BOOST_AUTO_TEST_CASE(ParallelForTest)
+{
+  const size_t chunkSizes[4] = { 0, 1, 7, 1000 };
+  for (size_t c = 0; c < 4; ++c)
+  {
+    std::vector<size_t> calls(1003, 0);
+    parallel::For(3, calls.size(), [&](const size_t i)
+    {
+      ++calls[i];
+    }, chunkSizes[c]);
+
+    for (size_t i = 0; i < 3; ++i)
+      BOOST_REQUIRE_EQUAL(calls[i], 0);
+    for (size_t i = 3; i < calls.size(); ++i)
+      BOOST_REQUIRE_EQUAL(calls[i], 1);
+  }
+
+  // An empty range does nothing.
+  size_t count = 0;
+  parallel::For(5, 5, [&](const size_t) { ++count; });
+  parallel::For(6, 5, [&](const size_t) { ++count; });
+  BOOST_REQUIRE_EQUAL(count, 0);
+}
+
+//! Count the nodes of a complete binary tree of the given depth with tasks.
+size_t CountNodes(const size_t depth)
+{
+  if (depth == 0)
+    return 1;
+
+  size_t left = 0, right = 0;
+  parallel::TaskGroup group;
+  group.Run([&]() { left = CountNodes(depth - 1); }, depth > 4);
+  group.Run([&]() { right = CountNodes(depth - 1); }, depth > 4);
+  group.Wait();
+
+  return left + right + 1;
+}
+
+/**
+ * Make sure that parallel::BlockReduce() sees every index exactly once, in
+ * blocks of the given size, and that its sum is the same every time.
+ */
+BOOST_AUTO_TEST_CASE(BlockReduceTest)
+{
+  const arma::vec values = arma::randu<arma::vec>(10001);
+  std::vector<size_t> calls(values.n_elem, 0);
+
+  typedef std::pair<double, size_t> StateType;
+  StateType sums[2];
+  for (size_t run = 0; run < 2; ++run)
+  {
+    sums[run] = parallel::BlockReduce(values.n_elem, 64, StateType(0.0, 0),
+        [&](StateType& state, const size_t begin, const size_t end)
+        {
+          BOOST_REQUIRE_EQUAL(begin % 64, 0);
+          BOOST_REQUIRE_LE(end - begin, 64);
+          for (size_t i = begin; i < end; ++i)
+          {
+            state.first += values[i];
+            ++calls[i];
+          }
+          state.second += end - begin;
+        },
+        [](StateType& total, const StateType& state)
+        {
+          total.first += state.first;
+          total.second += state.second;
+        });
+  }
+
+  for (size_t i = 0; i < calls.size(); ++i)
+    BOOST_REQUIRE_EQUAL(calls[i], 2);
+  BOOST_REQUIRE_EQUAL(sums[0].second, values.n_elem);
+  BOOST_REQUIRE_EQUAL(sums[0].first, sums[1].first);
+  BOOST_REQUIRE_CLOSE(sums[0].first, arma::accu(values), 1e-10);
+
+  // An empty range gives the initial state.
+  const StateType empty = parallel::BlockReduce(0, 64, StateType(1.0, 2),
+      [](StateType&, const size_t, const size_t) { },
+      [](StateType&, const StateType&) { });
+  BOOST_REQUIRE_EQUAL(empty.first, 1.0);
+  BOOST_REQUIRE_EQUAL(empty.second, 2);
+}
+
+/**
+ * Make sure that recursive task groups give the right result, both inside
+ * RunTasks() and when they are run serially.
+ */
+BOOST_AUTO_TEST_CASE(TaskGroupTest)
+{
+  size_t count = 0;
+  parallel::RunTasks([&]() { count = CountNodes(12); });
+  BOOST_REQUIRE_EQUAL(count, 8191);
+
+  BOOST_REQUIRE_EQUAL(CountNodes(10), 2047);
+}
+
+/**
+ * Make sure that a loop nested in a parallel loop sees one thread (so its work
+ * is not split again), unless nesting is allowed, and that the nesting level is
+ * restored afterwards.
+ */
+BOOST_AUTO_TEST_CASE(NestingTest)
+{
+  BOOST_REQUIRE(!parallel::InParallel());
+  BOOST_REQUIRE_GE(parallel::Threads(), 1);
+
+  // OpenMP implementations may allow nesting by default, so forbid it.
+  std::vector<size_t> innerThreads(8, 0);
+  {
+    parallel::ScopedNesting nesting(1);
+    parallel::For(0, innerThreads.size(), [&](const size_t i)
+    {
+      if (parallel::InParallel())
+        innerThreads[i] = parallel::Threads();
+      else
+        innerThreads[i] = 1;
+    }, 1);
+  }
+
+  for (size_t i = 0; i < innerThreads.size(); ++i)
+    BOOST_REQUIRE_EQUAL(innerThreads[i], 1);
+
+#ifdef _OPENMP
+  const int oldLevels = omp_get_max_active_levels();
+  {
+    parallel::ScopedNesting nesting(2);
+    BOOST_REQUIRE_EQUAL(omp_get_max_active_levels(), 2);
+  }
+  BOOST_REQUIRE_EQUAL(omp_get_max_active_levels(), oldLevels);
+
+  // SetThreads() changes the number of threads of new parallel regions.
+  const size_t oldThreads = parallel::Threads();
+  parallel::SetThreads(2);
+  BOOST_REQUIRE_EQUAL(parallel::Threads(), 2);
+  parallel::SetThreads(oldThreads);
+  BOOST_REQUIRE_EQUAL(parallel::Threads(), oldThreads);
+#endif
+}
+
+/**
+ * Make sure that parallel::Spread() calls the function exactly once for every
+ * task, that each task is given to the same thread every time, and that the
+ * threads are shared out between the tasks.
+ */
+BOOST_AUTO_TEST_CASE(SpreadTest)
+{
+  const size_t threads = parallel::Threads();
+  std::vector<size_t> calls(5, 0);
+  std::vector<size_t> firstThread(5), secondThread(5), taskThreads(5);
+  parallel::Spread(calls.size(), [&](const size_t i)
+  {
+    ++calls[i];
+    firstThread[i] = parallel::ThreadIndex();
+    taskThreads[i] = parallel::Threads();
+  });
+  parallel::Spread(calls.size(), [&](const size_t i)
+  {
+    ++calls[i];
+    secondThread[i] = parallel::ThreadIndex();
+  });
+
+  for (size_t i = 0; i < calls.size(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(calls[i], 2);
+    BOOST_REQUIRE_EQUAL(firstThread[i], secondThread[i]);
+    BOOST_REQUIRE_GE(taskThreads[i], 1);
+    BOOST_REQUIRE_LE(taskThreads[i], threads);
+  }
+
+  // The number of threads and the nesting level are restored.
+  BOOST_REQUIRE_EQUAL(parallel::Threads(), threads);
+  BOOST_REQUIRE(!parallel::InParallel());
+
+  // No tasks means no calls.
+  size_t count = 0;
+  parallel::Spread(0, [&](const size_t) { ++count; });
+  BOOST_REQUIRE_EQUAL(count, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END();
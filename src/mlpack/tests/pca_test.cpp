@@ -6,6 +6,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/pca/pca.hpp>
+#include <mlpack/methods/pca/incremental_pca.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -198,4 +199,150 @@ BOOST_AUTO_TEST_CASE(PCAScalingTest)
 }
 
 
+/**
+ * Make a dataset of the given dimensionality whose variance is mostly in a
+ * low-dimensional subspace, with quickly decaying variances.
+ */
+mat LowRankPCADataset(const size_t dimensions, const size_t points)
+{
+  mat basis, r;
+  qr_econ(basis, r, randn<mat>(dimensions, 5));
+  vec scales("10 6 4 2 1");
+  return basis * diagmat(scales) * randn<mat>(5, points) +
+      0.01 * randn<mat>(dimensions, points);
+}
+
+/**
+ * Make sure that the randomized decomposition finds the same top eigenvalues
+ * and projections as the full decomposition.
+ */
+BOOST_AUTO_TEST_CASE(RandomizedPCATest)
+{
+  const mat data = LowRankPCADataset(60, 300);
+
+  mat coeff, rCoeff, score, rScore;
+  vec eigVal, rEigVal;
+
+  PCA p;
+  p.Apply(data, 3, score, eigVal, coeff);
+  PCA rp(false, true);
+  rp.Apply(data, 3, rScore, rEigVal, rCoeff);
+
+  BOOST_REQUIRE_EQUAL(rEigVal.n_elem, 3);
+  BOOST_REQUIRE_EQUAL(rCoeff.n_rows, 60);
+  BOOST_REQUIRE_EQUAL(rCoeff.n_cols, 3);
+  BOOST_REQUIRE_EQUAL(rScore.n_rows, 3);
+  BOOST_REQUIRE_EQUAL(rScore.n_cols, 300);
+
+  for (size_t i = 0; i < 3; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(rEigVal[i], eigVal[i], 1e-3);
+
+    // The components may point in opposite directions.
+    const double sign = (dot(rCoeff.col(i), coeff.col(i)) < 0) ? -1 : 1;
+    for (size_t j = 0; j < score.n_cols; ++j)
+      BOOST_REQUIRE_SMALL(sign * rScore(i, j) - score(i, j), 1e-3);
+  }
+
+  // The dimensionality reduction should retain the same variance.
+  mat reduced(data), rReduced(data);
+  const double varRetained = p.Apply(reduced, (size_t) 3);
+  const double rVarRetained = rp.Apply(rReduced, (size_t) 3);
+  BOOST_REQUIRE_EQUAL(rReduced.n_rows, 3);
+  BOOST_REQUIRE_CLOSE(rVarRetained, varRetained, 1e-3);
+}
+
+/**
+ * Make sure that sparse PCA, which centers the data implicitly, gives the same
+ * results as the randomized decomposition of the same data held densely (with
+ * the same random seed), with and without scaling.
+ */
+BOOST_AUTO_TEST_CASE(SparsePCATest)
+{
+  sp_mat data = sprandu<sp_mat>(40, 300, 0.1);
+  // Leave one dimension empty, which scaling must handle.
+  data.row(7).zeros();
+  const mat denseData(data);
+
+  for (size_t scale = 0; scale < 2; ++scale)
+  {
+    mat coeff, sCoeff, score, sScore;
+    vec eigVal, sEigVal;
+
+    PCA p(scale == 1, true);
+    math::RandomSeed(42);
+    p.Apply(denseData, 4, score, eigVal, coeff);
+    // The randomized option is not needed for sparse data.
+    PCA sp(scale == 1);
+    math::RandomSeed(42);
+    sp.Apply(data, 4, sScore, sEigVal, sCoeff);
+
+    BOOST_REQUIRE_EQUAL(sEigVal.n_elem, 4);
+    BOOST_REQUIRE_EQUAL(sCoeff.n_rows, 40);
+    BOOST_REQUIRE_EQUAL(sCoeff.n_cols, 4);
+    BOOST_REQUIRE_EQUAL(sScore.n_rows, 4);
+    BOOST_REQUIRE_EQUAL(sScore.n_cols, 300);
+
+    for (size_t i = 0; i < 4; ++i)
+    {
+      BOOST_REQUIRE_CLOSE(sEigVal[i], eigVal[i], 1e-5);
+
+      // The components may point in opposite directions.
+      const double sign = (dot(sCoeff.col(i), coeff.col(i)) < 0) ? -1 : 1;
+      for (size_t j = 0; j < score.n_cols; ++j)
+        BOOST_REQUIRE_SMALL(sign * sScore(i, j) - score(i, j), 1e-5);
+    }
+
+    // The dimensionality reduction should retain the same variance.
+    mat reduced(denseData), sReduced;
+    math::RandomSeed(42);
+    const double varRetained = p.Apply(reduced, (size_t) 4);
+    math::RandomSeed(42);
+    const double sVarRetained = sp.Apply(data, 4, sReduced);
+    BOOST_REQUIRE_EQUAL(sReduced.n_rows, 4);
+    BOOST_REQUIRE_EQUAL(sReduced.n_cols, 300);
+    BOOST_REQUIRE_CLOSE(sVarRetained, varRetained, 1e-5);
+  }
+}
+
+/**
+ * Make sure that incremental PCA, run on chunks of a dataset, finds the same
+ * top eigenvalues and projections as PCA on the whole dataset.
+ */
+BOOST_AUTO_TEST_CASE(IncrementalPCATest)
+{
+  const mat data = LowRankPCADataset(40, 500);
+
+  mat coeff, score;
+  vec eigVal;
+  PCA p;
+  p.Apply(data, 5, score, eigVal, coeff);
+
+  IncrementalPCA ip(10);
+  for (size_t i = 0; i < 500; i += 70)
+    ip.Update(data.cols(i, std::min(i + 69, (size_t) 499)));
+
+  BOOST_REQUIRE_EQUAL(ip.NumPoints(), 500);
+  for (size_t i = 0; i < 40; ++i)
+    BOOST_REQUIRE_CLOSE(ip.Mean()[i], mean(data.row(i)), 1e-5);
+
+  mat iScore;
+  ip.Transform(data, iScore);
+  const vec iEigVal = ip.EigenValues();
+
+  BOOST_REQUIRE_EQUAL(iScore.n_rows, 10);
+  for (size_t i = 0; i < 5; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(iEigVal[i], eigVal[i], 1e-2);
+
+    const double sign = (dot(ip.EigenVectors().col(i), coeff.col(i)) < 0) ?
+        -1 : 1;
+    for (size_t j = 0; j < score.n_cols; ++j)
+      BOOST_REQUIRE_SMALL(sign * iScore(i, j) - score(i, j), 1e-2);
+  }
+
+  BOOST_REQUIRE_GT(ip.VarianceRetained(), 0.99);
+  BOOST_REQUIRE_LE(ip.VarianceRetained(), 1.0 + 1e-10);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
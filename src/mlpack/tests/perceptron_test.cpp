@@ -166,4 +166,107 @@ BOOST_AUTO_TEST_CASE(SecondaryConstructor)
   Perceptron<> p2(p1);
 }
 
+/**
+ * Make sure that training on a sparse matrix gives the same perceptron as
+ * training on the same data as a dense matrix.
+ */
+BOOST_AUTO_TEST_CASE(SparsePerceptronTest)
+{
+  // Sparse data, labelled by a random linear model so that it is separable.
+  sp_mat sparseData;
+  sparseData.sprandu(50, 300, 0.1);
+  const mat denseData(sparseData);
+
+  const vec direction = randn<vec>(50);
+  Row<size_t> labels(300);
+  for (size_t i = 0; i < 300; ++i)
+    labels[i] = (dot(denseData.col(i), direction) > 0.0) ? 1 : 0;
+
+  Perceptron<> dense(denseData, labels, 2, 50);
+  Perceptron<SimpleWeightUpdate, ZeroInitialization, sp_mat> sparse(sparseData,
+      labels, 2, 50);
+
+  for (size_t i = 0; i < dense.Weights().n_elem; ++i)
+    BOOST_REQUIRE_SMALL(dense.Weights()[i] - sparse.Weights()[i], 1e-10);
+  for (size_t i = 0; i < dense.Biases().n_elem; ++i)
+    BOOST_REQUIRE_SMALL(dense.Biases()[i] - sparse.Biases()[i], 1e-10);
+
+  Row<size_t> densePredictions(300), sparsePredictions(300);
+  dense.Classify(denseData, densePredictions);
+  sparse.Classify(sparseData, sparsePredictions);
+  for (size_t i = 0; i < 300; ++i)
+    BOOST_REQUIRE_EQUAL(densePredictions[i], sparsePredictions[i]);
+}
+
+/**
+ * Make sure the averaged update rule gives the average of the weights after
+ * each step.
+ */
+BOOST_AUTO_TEST_CASE(AveragedWeightUpdateTest)
+{
+  mat weights(randu<mat>(5, 3));
+  vec biases(randu<vec>(3));
+  mat weightSum(weights);
+  vec biasSum(biases);
+
+  AveragedWeightUpdate update;
+  for (size_t step = 0; step < 20; ++step)
+  {
+    // Update the weights on every other step.
+    if (step % 2 == 0)
+    {
+      const vec point = randu<vec>(5);
+      update.UpdateWeights(point, weights, biases, step % 3, (step + 1) % 3,
+          0.5);
+    }
+    update.Step();
+
+    weightSum += weights;
+    biasSum += biases;
+  }
+
+  update.Finish(weights, biases);
+  for (size_t i = 0; i < weights.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(weights[i], weightSum[i] / 21.0, 1e-8);
+  for (size_t i = 0; i < biases.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(biases[i], biasSum[i] / 21.0, 1e-8);
+}
+
+/**
+ * Make sure that parallel training with iterative parameter mixing converges
+ * on separable data with three classes, with both update rules.
+ */
+BOOST_AUTO_TEST_CASE(ParallelTrainTest)
+{
+  // Three well-separated clusters, with interleaved classes.
+  mat trainData(randn<mat>(2, 300));
+  Row<size_t> labels(300);
+  for (size_t i = 0; i < 300; ++i)
+  {
+    labels[i] = i % 3;
+    if (labels[i] == 1)
+      trainData(0, i) += 10.0;
+    else if (labels[i] == 2)
+      trainData(1, i) += 10.0;
+  }
+
+  Perceptron<> p(3, 2, 1000);
+  p.ParallelTrain(trainData, labels, rowvec(), 4);
+
+  Row<size_t> predictedLabels(300);
+  p.Classify(trainData, predictedLabels);
+  for (size_t i = 0; i < 300; ++i)
+    BOOST_REQUIRE_EQUAL(predictedLabels[i], labels[i]);
+
+  Perceptron<AveragedWeightUpdate> ap(3, 2, 1000);
+  ap.ParallelTrain(trainData, labels, rowvec(), 4);
+
+  ap.Classify(trainData, predictedLabels);
+  size_t correct = 0;
+  for (size_t i = 0; i < 300; ++i)
+    if (predictedLabels[i] == labels[i])
+      ++correct;
+  BOOST_REQUIRE_GE(correct, 295);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -0,0 +1,179 @@
+/**
+ * @file pipeline_test.cpp
+ * @author Ryan Curtin
+ *
+ * Tests for the MatrixStore class and for pipelines of stages run in one
+ * process.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/methods/pipeline/pipeline.hpp>
+#include <mlpack/methods/pca/pca.hpp>
+#include <mlpack/methods/neighbor_search/neighbor_search.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack;
+using namespace mlpack::pipeline;
+
+BOOST_AUTO_TEST_SUITE(PipelineTest);
+
+/**
+ * Matrices held in memory are given back unchanged, matrices of one kind
+ * cannot be read as the other, and names with an extension are files.
+ */
+BOOST_AUTO_TEST_CASE(MatrixStoreTest)
+{
+  BOOST_REQUIRE(MatrixStore::IsFile("dataset.csv"));
+  BOOST_REQUIRE(!MatrixStore::IsFile("reduced"));
+
+  MatrixStore store;
+  arma::mat dataset = arma::randu<arma::mat>(4, 50);
+  const arma::mat copy(dataset);
+  store.Store("dataset", std::move(dataset));
+  arma::Mat<size_t> labels(1, 50);
+  labels.fill(3);
+  store.Store("labels", std::move(labels));
+
+  BOOST_REQUIRE(store.HasMatrix("dataset"));
+  BOOST_REQUIRE(store.HasIndices("labels"));
+  BOOST_REQUIRE(!store.HasMatrix("labels"));
+  BOOST_REQUIRE_EQUAL(store.Matrix("dataset").n_cols, 50);
+  for (size_t i = 0; i < copy.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(store.Matrix("dataset")[i], copy[i]);
+  BOOST_REQUIRE_EQUAL(store.Indices("labels")[7], 3);
+
+  BOOST_REQUIRE_THROW(store.Matrix("labels"), std::invalid_argument);
+  BOOST_REQUIRE_THROW(store.Indices("dataset"), std::invalid_argument);
+  BOOST_REQUIRE_THROW(store.Matrix("missing"), std::invalid_argument);
+
+  // A matrix stored to a file can be loaded back by another store.
+  store.Store("pipeline_test.csv", arma::mat(copy));
+  {
+    MatrixStore other;
+    const arma::mat& loaded = other.Matrix("pipeline_test.csv");
+    BOOST_REQUIRE_EQUAL(loaded.n_rows, copy.n_rows);
+    BOOST_REQUIRE_EQUAL(loaded.n_cols, copy.n_cols);
+    for (size_t i = 0; i < copy.n_elem; ++i)
+      BOOST_REQUIRE_CLOSE(loaded[i], copy[i], 1e-5);
+  }
+  remove("pipeline_test.csv");
+
+  // Models are only in memory, and are only given back as their own type.
+  std::shared_ptr<arma::vec> model = std::make_shared<arma::vec>(3);
+  store.StoreModel("model", model);
+  BOOST_REQUIRE(store.HasModel("model"));
+  BOOST_REQUIRE_EQUAL(&store.Model<arma::vec>("model"), model.get());
+  BOOST_REQUIRE_THROW(store.Model<arma::mat>("model"), std::invalid_argument);
+  BOOST_REQUIRE_THROW(store.Model<arma::vec>("other"), std::invalid_argument);
+  BOOST_REQUIRE_THROW(store.StoreModel("model.bin", model),
+      std::invalid_argument);
+
+  store.Clear();
+  BOOST_REQUIRE(!store.HasMatrix("dataset"));
+  BOOST_REQUIRE(!store.HasModel("model"));
+}
+
+/**
+ * A pipeline of PCA, k-means, and k-nearest-neighbor search in memory gives
+ * the same results as running each of them directly, and a stored model can
+ * be searched again.
+ */
+BOOST_AUTO_TEST_CASE(PipelineInMemoryTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(5, 300);
+
+  MatrixStore store;
+  store.Store("dataset", arma::mat(dataset));
+
+  std::istringstream pipeline(
+      "# Reduce, cluster, and search.\n"
+      "pca -i dataset -o reduced -d 2\n"
+      "\n"
+      "kmeans -i reduced -c 4 -o assignments -C centroids\n"
+      "allknn -r reduced -q centroids -k 3 -n neighbors -d distances -M knn\n"
+      "allknn -m knn -k 1 -n nearest\n");
+  RunPipeline(pipeline, store);
+
+  // The reduced dataset is the same as that of PCA.
+  arma::mat reduced(dataset);
+  pca::PCA p;
+  p.Apply(reduced, (size_t) 2);
+  const arma::mat& storedReduced = store.Matrix("reduced");
+  BOOST_REQUIRE_EQUAL(storedReduced.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(storedReduced.n_cols, 300);
+  for (size_t i = 0; i < reduced.n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(storedReduced[i], reduced[i], 1e-5);
+
+  // The clustering is sane.
+  const arma::Mat<size_t>& assignments = store.Indices("assignments");
+  BOOST_REQUIRE_EQUAL(assignments.n_rows, 1);
+  BOOST_REQUIRE_EQUAL(assignments.n_cols, 300);
+  BOOST_REQUIRE_LT(arma::max(arma::vectorise(assignments)), 4);
+  const arma::mat& centroids = store.Matrix("centroids");
+  BOOST_REQUIRE_EQUAL(centroids.n_rows, 2);
+  BOOST_REQUIRE_EQUAL(centroids.n_cols, 4);
+
+  // The neighbors of the centroids are those found directly.
+  neighbor::AllkNN knn(reduced);
+  arma::Mat<size_t> neighbors;
+  arma::mat distances;
+  knn.Search(centroids, 3, neighbors, distances);
+  BOOST_REQUIRE_EQUAL(store.Indices("neighbors").n_cols, 4);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(store.Indices("neighbors")[i], neighbors[i]);
+    BOOST_REQUIRE_CLOSE(store.Matrix("distances")[i], distances[i], 1e-5);
+  }
+
+  // The stored model was searched again, monochromatically.
+  BOOST_REQUIRE(store.HasModel("knn"));
+  knn.Search(1, neighbors, distances);
+  BOOST_REQUIRE_EQUAL(store.Indices("nearest").n_cols, 300);
+  for (size_t i = 0; i < neighbors.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(store.Indices("nearest")[i], neighbors[i]);
+}
+
+/**
+ * Invalid stages and options are reported, with the line of the stage.
+ */
+BOOST_AUTO_TEST_CASE(PipelineInvalidTest)
+{
+  MatrixStore store;
+  store.Store("dataset", arma::mat(arma::randu<arma::mat>(3, 20)));
+
+  // Unknown stage, missing option, unknown option, missing matrix, and an
+  // invalid number of clusters.
+  std::vector<std::string> unknown = { "svd", "-i", "dataset" };
+  BOOST_REQUIRE_THROW(RunStage(unknown, store), std::invalid_argument);
+  std::vector<std::string> missing = { "pca", "-i", "dataset" };
+  BOOST_REQUIRE_THROW(RunStage(missing, store), std::invalid_argument);
+  std::vector<std::string> option = { "pca", "-i", "dataset", "-o", "out",
+      "--bogus" };
+  BOOST_REQUIRE_THROW(RunStage(option, store), std::invalid_argument);
+  std::vector<std::string> matrix = { "kmeans", "-i", "other", "-c", "2",
+      "-C", "centroids" };
+  BOOST_REQUIRE_THROW(RunStage(matrix, store), std::invalid_argument);
+  std::vector<std::string> clusters = { "kmeans", "-i", "dataset", "-c",
+      "21", "-C", "centroids" };
+  BOOST_REQUIRE_THROW(RunStage(clusters, store), std::invalid_argument);
+  std::vector<std::string> model = { "allknn", "-m", "knn", "-k", "1" };
+  BOOST_REQUIRE_THROW(RunStage(model, store), std::invalid_argument);
+
+  std::istringstream pipeline("pca -i dataset -o reduced -d 2\n"
+      "svd -i reduced\n");
+  try
+  {
+    RunPipeline(pipeline, store);
+    BOOST_FAIL("RunPipeline() did not throw");
+  }
+  catch (std::runtime_error& e)
+  {
+    BOOST_REQUIRE(std::string(e.what()).find("line 2") != std::string::npos);
+  }
+
+  // The first stage ran.
+  BOOST_REQUIRE(store.HasMatrix("reduced"));
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -39,4 +39,28 @@ BOOST_AUTO_TEST_CASE(QUICSVDReconstructionError)
   BOOST_REQUIRE_SMALL(relativeError, 1e-5);
 }
 
+/**
+ * The reconstruction error of the SVD of float data should be small too.
+ */
+BOOST_AUTO_TEST_CASE(QUICSVDFloatReconstructionError)
+{
+  // Load the dataset, and convert it to float.
+  arma::mat dataset;
+  data::Load("test_data_3_1000.csv", dataset);
+  const arma::fmat fDataset = arma::conv_to<arma::fmat>::from(dataset);
+
+  // Obtain the SVD using default parameters.
+  arma::fmat u, v, sigma;
+  QUIC_SVDType<arma::fmat> quicsvd(fDataset, u, v, sigma);
+
+  // Reconstruct the matrix using the SVD.
+  arma::fmat reconstruct;
+  reconstruct = u * sigma * v.t();
+
+  // The relative reconstruction error should be small, for float precision.
+  double relativeError = arma::norm(fDataset - reconstruct, "frob") /
+                         arma::norm(fDataset, "frob");
+  BOOST_REQUIRE_SMALL(relativeError, 1e-3);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -52,4 +52,27 @@ BOOST_AUTO_TEST_CASE(Radical_Test_Radical3D)
   BOOST_REQUIRE_CLOSE(valBest, valEst, 0.25);
 }
 
+/**
+ * Make sure the unmixing matrix accounts for the rotations of every sweep, so
+ * that the estimated components are the unmixing matrix times the input.
+ */
+BOOST_AUTO_TEST_CASE(Radical_Test_UnmixingMatrix)
+{
+  mat matX;
+  data::Load("data_3d_mixed.txt", matX);
+
+  Radical rad(0.175, 5, 100, matX.n_rows - 1);
+
+  mat matY;
+  mat matW;
+  rad.DoRadical(matX, matY, matW);
+
+  BOOST_REQUIRE_EQUAL(matW.n_rows, matX.n_rows);
+  BOOST_REQUIRE_EQUAL(matW.n_cols, matX.n_rows);
+
+  const mat reconstructed = matW * matX;
+  for (uword i = 0; i < matY.n_elem; i++)
+    BOOST_REQUIRE_SMALL(reconstructed[i] - matY[i], 1e-8);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -8,6 +8,7 @@
 #include <mlpack/methods/range_search/range_search.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
 #include <mlpack/methods/range_search/rs_model.hpp>
+#include <mlpack/methods/range_search/mahalanobis_range_search.hpp>
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
 
@@ -666,6 +667,49 @@ BOOST_AUTO_TEST_CASE(CoverTreeTest)
   }
 }
 
+/**
+ * Ensure that range search with a cover tree that reorders the dataset gives
+ * the same results as the kd-tree, in single-tree and dual-tree mode.
+ */
+BOOST_AUTO_TEST_CASE(ReorderedCoverTreeTest)
+{
+  arma::mat data;
+  data.randu(8, 1000);
+  arma::mat queries;
+  queries.randu(8, 100);
+  const Range range(0.5, 1.5);
+
+  RangeSearch<> kdsearch(data);
+  vector<vector<size_t>> kdNeighbors;
+  vector<vector<double>> kdDistances;
+  kdsearch.Search(queries, range, kdNeighbors, kdDistances);
+  vector<vector<pair<double, size_t>>> kdSorted;
+  SortResults(kdNeighbors, kdDistances, kdSorted);
+
+  for (size_t run = 0; run < 2; ++run)
+  {
+    RangeSearch<EuclideanDistance, arma::mat, ReorderedCoverTree>
+        coversearch(data, false, (run == 1));
+    vector<vector<size_t>> coverNeighbors;
+    vector<vector<double>> coverDistances;
+    coversearch.Search(queries, range, coverNeighbors, coverDistances);
+    vector<vector<pair<double, size_t>>> coverSorted;
+    SortResults(coverNeighbors, coverDistances, coverSorted);
+
+    BOOST_REQUIRE_EQUAL(coverSorted.size(), kdSorted.size());
+    for (size_t i = 0; i < kdSorted.size(); ++i)
+    {
+      BOOST_REQUIRE_EQUAL(coverSorted[i].size(), kdSorted[i].size());
+      for (size_t j = 0; j < kdSorted[i].size(); ++j)
+      {
+        BOOST_REQUIRE_EQUAL(kdSorted[i][j].second, coverSorted[i][j].second);
+        BOOST_REQUIRE_CLOSE(kdSorted[i][j].first, coverSorted[i][j].first,
+            1e-5);
+      }
+    }
+  }
+}
+
 /**
  * Ensure that dual tree range search with cover trees works when using
  * two datasets.
@@ -1251,7 +1295,7 @@ BOOST_AUTO_TEST_CASE(RSModelTest)
   arma::mat referenceData = arma::randu<arma::mat>(10, 200);
 
   // Build all the possible models.
-  RSModel models[10];
+  RSModel models[12];
   models[0] = RSModel(RSModel::TreeTypes::KD_TREE, true);
   models[1] = RSModel(RSModel::TreeTypes::KD_TREE, false);
   models[2] = RSModel(RSModel::TreeTypes::COVER_TREE, true);
@@ -1262,6 +1306,8 @@ BOOST_AUTO_TEST_CASE(RSModelTest)
   models[7] = RSModel(RSModel::TreeTypes::R_STAR_TREE, false);
   models[8] = RSModel(RSModel::TreeTypes::BALL_TREE, true);
   models[9] = RSModel(RSModel::TreeTypes::BALL_TREE, false);
+  models[10] = RSModel(RSModel::TreeTypes::VP_TREE, true);
+  models[11] = RSModel(RSModel::TreeTypes::VP_TREE, false);
 
   for (size_t j = 0; j < 2; ++j)
   {
@@ -1275,7 +1321,7 @@ BOOST_AUTO_TEST_CASE(RSModelTest)
     vector<vector<pair<double, size_t>>> baselineSorted;
     SortResults(baselineNeighbors, baselineDistances, baselineSorted);
 
-    for (size_t i = 0; i < 10; ++i)
+    for (size_t i = 0; i < 12; ++i)
     {
       // We only have std::move() constructors, so make a copy of our data.
       arma::mat referenceCopy(referenceData);
@@ -1319,7 +1365,7 @@ BOOST_AUTO_TEST_CASE(RSModelMonochromaticTest)
   arma::mat referenceData = arma::randu<arma::mat>(10, 200);
 
   // Build all the possible models.
-  RSModel models[10];
+  RSModel models[12];
   models[0] = RSModel(RSModel::TreeTypes::KD_TREE, true);
   models[1] = RSModel(RSModel::TreeTypes::KD_TREE, false);
   models[2] = RSModel(RSModel::TreeTypes::COVER_TREE, true);
@@ -1330,6 +1376,8 @@ BOOST_AUTO_TEST_CASE(RSModelMonochromaticTest)
   models[7] = RSModel(RSModel::TreeTypes::R_STAR_TREE, false);
   models[8] = RSModel(RSModel::TreeTypes::BALL_TREE, true);
   models[9] = RSModel(RSModel::TreeTypes::BALL_TREE, false);
+  models[10] = RSModel(RSModel::TreeTypes::VP_TREE, true);
+  models[11] = RSModel(RSModel::TreeTypes::VP_TREE, false);
 
   for (size_t j = 0; j < 2; ++j)
   {
@@ -1342,7 +1390,7 @@ BOOST_AUTO_TEST_CASE(RSModelMonochromaticTest)
     vector<vector<pair<double, size_t>>> baselineSorted;
     SortResults(baselineNeighbors, baselineDistances, baselineSorted);
 
-    for (size_t i = 0; i < 10; ++i)
+    for (size_t i = 0; i < 12; ++i)
     {
       // We only have std::move() cosntructors, so make a copy of our data.
       arma::mat referenceCopy(referenceData);
@@ -1404,4 +1452,550 @@ BOOST_AUTO_TEST_CASE(NeighborPtrDeleteTest)
 }
 
 
+/**
+ * Make sure that parallel single-tree search returns the same results as serial
+ * single-tree search, both for a separate query set and in the monochromatic
+ * setting.
+ */
+BOOST_AUTO_TEST_CASE(ParallelSingleTreeTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 800);
+
+  RangeSearch<> serial(referenceData, false, true);
+  RangeSearch<> parallel(referenceData, false, true);
+  parallel.Parallel() = true;
+
+  for (size_t mono = 0; mono < 2; ++mono)
+  {
+    vector<vector<size_t>> serialNeighbors, parallelNeighbors;
+    vector<vector<double>> serialDistances, parallelDistances;
+
+    if (mono == 0)
+    {
+      serial.Search(queryData, Range(0.1, 0.3), serialNeighbors,
+          serialDistances);
+      parallel.Search(queryData, Range(0.1, 0.3), parallelNeighbors,
+          parallelDistances);
+    }
+    else
+    {
+      serial.Search(Range(0.1, 0.3), serialNeighbors, serialDistances);
+      parallel.Search(Range(0.1, 0.3), parallelNeighbors, parallelDistances);
+    }
+
+    vector<vector<pair<double, size_t>>> sortedSerial, sortedParallel;
+    SortResults(serialNeighbors, serialDistances, sortedSerial);
+    SortResults(parallelNeighbors, parallelDistances, sortedParallel);
+
+    BOOST_REQUIRE_EQUAL(sortedSerial.size(), sortedParallel.size());
+    for (size_t i = 0; i < sortedSerial.size(); ++i)
+    {
+      BOOST_REQUIRE_EQUAL(sortedSerial[i].size(), sortedParallel[i].size());
+      for (size_t j = 0; j < sortedSerial[i].size(); ++j)
+      {
+        BOOST_REQUIRE_EQUAL(sortedSerial[i][j].second,
+            sortedParallel[i][j].second);
+        BOOST_REQUIRE_CLOSE(sortedSerial[i][j].first,
+            sortedParallel[i][j].first, 1e-5);
+      }
+    }
+
+    BOOST_REQUIRE_EQUAL(serial.BaseCases(), parallel.BaseCases());
+  }
+}
+
+/**
+ * Make sure that parallel dual-tree search returns the same results as serial
+ * dual-tree search, both for a separate query set and in the monochromatic
+ * setting, and both for trees built by RangeSearch and for a given query tree.
+ */
+BOOST_AUTO_TEST_CASE(ParallelDualTreeTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 800);
+
+  RangeSearch<> serial(referenceData);
+  RangeSearch<> parallel(referenceData);
+  parallel.Parallel() = true;
+
+  arma::mat queryCopy(queryData);
+  typedef RangeSearch<>::Tree TreeType;
+  TreeType queryTree(queryCopy, 5);
+
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    vector<vector<size_t>> serialNeighbors, parallelNeighbors;
+    vector<vector<double>> serialDistances, parallelDistances;
+
+    if (mode == 0)
+    {
+      serial.Search(queryData, Range(0.1, 0.3), serialNeighbors,
+          serialDistances);
+      parallel.Search(queryData, Range(0.1, 0.3), parallelNeighbors,
+          parallelDistances);
+    }
+    else if (mode == 1)
+    {
+      serial.Search(Range(0.1, 0.3), serialNeighbors, serialDistances);
+      parallel.Search(Range(0.1, 0.3), parallelNeighbors, parallelDistances);
+    }
+    else
+    {
+      serial.Search(&queryTree, Range(0.1, 0.3), serialNeighbors,
+          serialDistances);
+      parallel.Search(&queryTree, Range(0.1, 0.3), parallelNeighbors,
+          parallelDistances);
+    }
+
+    vector<vector<pair<double, size_t>>> sortedSerial, sortedParallel;
+    SortResults(serialNeighbors, serialDistances, sortedSerial);
+    SortResults(parallelNeighbors, parallelDistances, sortedParallel);
+
+    BOOST_REQUIRE_EQUAL(sortedSerial.size(), sortedParallel.size());
+    for (size_t i = 0; i < sortedSerial.size(); ++i)
+    {
+      BOOST_REQUIRE_EQUAL(sortedSerial[i].size(), sortedParallel[i].size());
+      for (size_t j = 0; j < sortedSerial[i].size(); ++j)
+      {
+        BOOST_REQUIRE_EQUAL(sortedSerial[i][j].second,
+            sortedParallel[i][j].second);
+        BOOST_REQUIRE_CLOSE(sortedSerial[i][j].first,
+            sortedParallel[i][j].first, 1e-5);
+      }
+    }
+  }
+}
+
+// Make sure that the compressed sparse row results hold the same results as
+// the nested vectors.
+void CheckCSRResults(const vector<vector<size_t>>& neighbors,
+                     const vector<vector<double>>& distances,
+                     const CSRRangeResults& results)
+{
+  vector<vector<size_t>> csrNeighbors;
+  vector<vector<double>> csrDistances;
+  results.Unpack(csrNeighbors, csrDistances);
+
+  vector<vector<pair<double, size_t>>> sorted, csrSorted;
+  SortResults(neighbors, distances, sorted);
+  SortResults(csrNeighbors, csrDistances, csrSorted);
+
+  BOOST_REQUIRE_EQUAL(results.NumQueries(), sorted.size());
+  BOOST_REQUIRE_EQUAL(csrSorted.size(), sorted.size());
+  for (size_t i = 0; i < sorted.size(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(results.NumResults(i), sorted[i].size());
+    BOOST_REQUIRE_EQUAL(csrSorted[i].size(), sorted[i].size());
+    for (size_t j = 0; j < sorted[i].size(); ++j)
+    {
+      BOOST_REQUIRE_EQUAL(csrSorted[i][j].second, sorted[i][j].second);
+      BOOST_REQUIRE_CLOSE(csrSorted[i][j].first, sorted[i][j].first, 1e-5);
+    }
+  }
+}
+
+// Check compressed sparse row results against nested vector results for the
+// given tree type, with every search mode.
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void CheckCSRSearch(const arma::mat& referenceData, const arma::mat& queryData)
+{
+  for (size_t mode = 0; mode < 5; ++mode)
+  {
+    RangeSearch<EuclideanDistance, arma::mat, TreeType> rs(referenceData,
+        mode == 0, mode == 1 || mode == 3);
+    rs.Parallel() = (mode >= 3);
+
+    vector<vector<size_t>> neighbors;
+    vector<vector<double>> distances;
+    CSRRangeResults results;
+
+    rs.Search(queryData, Range(0.1, 0.3), neighbors, distances);
+    rs.Search(queryData, Range(0.1, 0.3), results);
+    CheckCSRResults(neighbors, distances, results);
+
+    rs.Search(Range(0.1, 0.3), neighbors, distances);
+    rs.Search(Range(0.1, 0.3), results);
+    CheckCSRResults(neighbors, distances, results);
+  }
+}
+
+/**
+ * Range search into compressed sparse row results gives the same results as
+ * range search into nested vectors, for naive, single-tree, dual-tree, and
+ * parallel single-tree and dual-tree search.
+ */
+BOOST_AUTO_TEST_CASE(CSRResultsTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 500);
+  arma::mat queryData = arma::randu<arma::mat>(3, 300);
+
+  CheckCSRSearch<KDTree>(referenceData, queryData);
+  CheckCSRSearch<StandardCoverTree>(referenceData, queryData);
+  CheckCSRSearch<RTree>(referenceData, queryData);
+}
+
+/**
+ * Results added out of order are grouped by query point, and the results
+ * survive a round trip through the binary format.
+ */
+BOOST_AUTO_TEST_CASE(CSRResultsSaveLoadTest)
+{
+  CSRRangeResults results;
+  results.Reset(4);
+  results.Add(2, 5, 0.5);
+  results.Add(0, 1, 0.1);
+  results.Add(2, 7, 0.7);
+  results.Add(3, 3, 0.3);
+  results.Finalize();
+
+  BOOST_REQUIRE_EQUAL(results.NumQueries(), 4);
+  BOOST_REQUIRE_EQUAL(results.NumResults(), 4);
+  BOOST_REQUIRE_EQUAL(results.NumResults(0), 1);
+  BOOST_REQUIRE_EQUAL(results.NumResults(1), 0);
+  BOOST_REQUIRE_EQUAL(results.NumResults(2), 2);
+  BOOST_REQUIRE_EQUAL(results.NumResults(3), 1);
+
+  const size_t neighbors[] = { 1, 5, 7, 3 };
+  const double distances[] = { 0.1, 0.5, 0.7, 0.3 };
+  for (size_t i = 0; i < 4; ++i)
+  {
+    BOOST_REQUIRE_EQUAL(results.Neighbors()[i], neighbors[i]);
+    BOOST_REQUIRE_EQUAL(results.Distances()[i], distances[i]);
+  }
+
+  BOOST_REQUIRE(results.Save("csr_results_test.bin"));
+
+  CSRRangeResults loaded;
+  BOOST_REQUIRE(loaded.Load("csr_results_test.bin"));
+  BOOST_REQUIRE_EQUAL(loaded.NumQueries(), results.NumQueries());
+  BOOST_REQUIRE_EQUAL(loaded.NumResults(), results.NumResults());
+  for (size_t i = 0; i < results.Offsets().size(); ++i)
+    BOOST_REQUIRE_EQUAL(loaded.Offsets()[i], results.Offsets()[i]);
+  for (size_t i = 0; i < results.NumResults(); ++i)
+  {
+    BOOST_REQUIRE_EQUAL(loaded.Neighbors()[i], results.Neighbors()[i]);
+    BOOST_REQUIRE_EQUAL(loaded.Distances()[i], results.Distances()[i]);
+  }
+
+  // A file that does not hold results is not loaded.
+  std::fstream f("csr_results_test.bin", std::fstream::out);
+  f << "1, 2, 3" << std::endl;
+  f.close();
+  BOOST_REQUIRE(!loaded.Load("csr_results_test.bin"));
+
+  remove("csr_results_test.bin");
+}
+
+/**
+ * RSModel gives the same results in compressed sparse row form as in nested
+ * vectors.
+ */
+BOOST_AUTO_TEST_CASE(RSModelCSRResultsTest)
+{
+  arma::mat queryData = arma::randu<arma::mat>(10, 50);
+  arma::mat referenceData = arma::randu<arma::mat>(10, 200);
+
+  for (int treeType = RSModel::KD_TREE; treeType <= RSModel::VP_TREE;
+       ++treeType)
+  {
+    RSModel model(treeType, false);
+    arma::mat referenceCopy(referenceData);
+    model.BuildModel(std::move(referenceCopy), 5, false, false);
+
+    vector<vector<size_t>> neighbors;
+    vector<vector<double>> distances;
+    arma::mat queryCopy(queryData);
+    model.Search(std::move(queryCopy), Range(0.25, 0.75), neighbors,
+        distances);
+
+    CSRRangeResults results;
+    queryCopy = queryData;
+    model.Search(std::move(queryCopy), Range(0.25, 0.75), results);
+    CheckCSRResults(neighbors, distances, results);
+
+    model.Search(Range(0.25, 0.75), neighbors, distances);
+    model.Search(Range(0.25, 0.75), results);
+    CheckCSRResults(neighbors, distances, results);
+  }
+}
+
+// Check counting and existence search against the number of results of a full
+// search for the given tree type, with every search mode.
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void CheckCountSearch(const arma::mat& referenceData,
+                      const arma::mat& queryData)
+{
+  for (size_t mode = 0; mode < 5; ++mode)
+  {
+    RangeSearch<EuclideanDistance, arma::mat, TreeType> rs(referenceData,
+        mode == 0, mode == 1 || mode == 3);
+    rs.Parallel() = (mode >= 3);
+
+    vector<vector<size_t>> neighbors;
+    vector<vector<double>> distances;
+    arma::Col<size_t> counts;
+    vector<bool> exists;
+
+    rs.Search(queryData, Range(0.1, 0.3), neighbors, distances);
+    rs.Count(queryData, Range(0.1, 0.3), counts);
+    rs.Exists(queryData, Range(0.1, 0.3), exists);
+
+    BOOST_REQUIRE_EQUAL(counts.n_elem, neighbors.size());
+    BOOST_REQUIRE_EQUAL(exists.size(), neighbors.size());
+    for (size_t i = 0; i < neighbors.size(); ++i)
+    {
+      BOOST_REQUIRE_EQUAL(counts[i], neighbors[i].size());
+      BOOST_REQUIRE_EQUAL(exists[i], !neighbors[i].empty());
+    }
+
+    rs.Search(Range(0.0, 0.05), neighbors, distances);
+    rs.Count(Range(0.0, 0.05), counts);
+    rs.Exists(Range(0.0, 0.05), exists);
+
+    BOOST_REQUIRE_EQUAL(counts.n_elem, neighbors.size());
+    BOOST_REQUIRE_EQUAL(exists.size(), neighbors.size());
+    for (size_t i = 0; i < neighbors.size(); ++i)
+    {
+      BOOST_REQUIRE_EQUAL(counts[i], neighbors[i].size());
+      BOOST_REQUIRE_EQUAL(exists[i], !neighbors[i].empty());
+    }
+  }
+}
+
+/**
+ * Counting and existence search agree with the results of a full search, for
+ * naive, single-tree, dual-tree, and parallel single-tree and dual-tree search.
+ */
+BOOST_AUTO_TEST_CASE(CountAndExistsTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 500);
+  arma::mat queryData = arma::randu<arma::mat>(3, 300);
+
+  CheckCountSearch<KDTree>(referenceData, queryData);
+  CheckCountSearch<StandardCoverTree>(referenceData, queryData);
+  CheckCountSearch<BallTree>(referenceData, queryData);
+}
+
+/**
+ * When every point is in the range, whole nodes are counted at once, and
+ * existence search stops each query point at its first hit.
+ */
+BOOST_AUTO_TEST_CASE(CountWholeNodesTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 1000);
+  arma::mat queryData = arma::randu<arma::mat>(3, 200);
+
+  // No two points of the unit cube are further apart than sqrt(3).
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    RangeSearch<> rs(referenceData, mode == 0, mode == 1);
+
+    arma::Col<size_t> counts;
+    rs.Count(queryData, Range(0.0, 2.0), counts);
+    BOOST_REQUIRE_EQUAL(counts.n_elem, queryData.n_cols);
+    for (size_t i = 0; i < counts.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(counts[i], referenceData.n_cols);
+
+    rs.Count(Range(0.0, 2.0), counts);
+    BOOST_REQUIRE_EQUAL(counts.n_elem, referenceData.n_cols);
+    for (size_t i = 0; i < counts.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(counts[i], referenceData.n_cols - 1);
+
+    vector<bool> exists;
+    rs.Exists(queryData, Range(0.0, 2.0), exists);
+    BOOST_REQUIRE_LE(rs.BaseCases(), queryData.n_cols);
+    for (size_t i = 0; i < exists.size(); ++i)
+      BOOST_REQUIRE_EQUAL(exists[i], true);
+  }
+}
+
+//! A callback that stores the results it is given as nested vectors.
+struct StoreRangeCallback
+{
+  vector<vector<size_t>> neighbors;
+  vector<vector<double>> distances;
+
+  StoreRangeCallback(const size_t numQueries) :
+      neighbors(numQueries), distances(numQueries) { }
+
+  void operator()(const size_t queryIndex,
+                  const size_t referenceIndex,
+                  const double distance)
+  {
+    neighbors[queryIndex].push_back(referenceIndex);
+    distances[queryIndex].push_back(distance);
+  }
+};
+
+// Check results given to a callback against nested vector results for the
+// given tree type, with naive, single-tree, and dual-tree search.
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void CheckCallbackSearch(const arma::mat& referenceData,
+                         const arma::mat& queryData)
+{
+  for (size_t mode = 0; mode < 3; ++mode)
+  {
+    RangeSearch<EuclideanDistance, arma::mat, TreeType> rs(referenceData,
+        mode == 0, mode == 1);
+
+    vector<vector<size_t>> neighbors;
+    vector<vector<double>> distances;
+    vector<vector<pair<double, size_t>>> sorted, callbackSorted;
+
+    rs.Search(queryData, Range(0.1, 0.3), neighbors, distances);
+    StoreRangeCallback callback(queryData.n_cols);
+    rs.Search(queryData, Range(0.1, 0.3), callback);
+
+    SortResults(neighbors, distances, sorted);
+    SortResults(callback.neighbors, callback.distances, callbackSorted);
+    BOOST_REQUIRE_EQUAL(callbackSorted.size(), sorted.size());
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+      BOOST_REQUIRE_EQUAL(callbackSorted[i].size(), sorted[i].size());
+      for (size_t j = 0; j < sorted[i].size(); ++j)
+      {
+        BOOST_REQUIRE_EQUAL(callbackSorted[i][j].second, sorted[i][j].second);
+        BOOST_REQUIRE_CLOSE(callbackSorted[i][j].first, sorted[i][j].first,
+            1e-5);
+      }
+    }
+
+    rs.Search(Range(0.1, 0.3), neighbors, distances);
+    StoreRangeCallback monoCallback(referenceData.n_cols);
+    rs.Search(Range(0.1, 0.3), monoCallback);
+
+    SortResults(neighbors, distances, sorted);
+    SortResults(monoCallback.neighbors, monoCallback.distances,
+        callbackSorted);
+    BOOST_REQUIRE_EQUAL(callbackSorted.size(), sorted.size());
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+      BOOST_REQUIRE_EQUAL(callbackSorted[i].size(), sorted[i].size());
+      for (size_t j = 0; j < sorted[i].size(); ++j)
+      {
+        BOOST_REQUIRE_EQUAL(callbackSorted[i][j].second, sorted[i][j].second);
+        BOOST_REQUIRE_CLOSE(callbackSorted[i][j].first, sorted[i][j].first,
+            1e-5);
+      }
+    }
+  }
+}
+
+/**
+ * Range search with a callback hands every result to the callback exactly once,
+ * with the original indices of the points.
+ */
+BOOST_AUTO_TEST_CASE(CallbackSearchTest)
+{
+  arma::mat referenceData = arma::randu<arma::mat>(3, 500);
+  arma::mat queryData = arma::randu<arma::mat>(3, 300);
+
+  CheckCallbackSearch<KDTree>(referenceData, queryData);
+  CheckCallbackSearch<StandardCoverTree>(referenceData, queryData);
+  CheckCallbackSearch<RTree>(referenceData, queryData);
+}
+
+/**
+ * Make sure that MahalanobisRangeSearch finds the same points as a brute-force
+ * search with the Mahalanobis distance, including when the range is of squared
+ * distances.
+ */
+BOOST_AUTO_TEST_CASE(MahalanobisRangeSearchTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(3, 300);
+  arma::mat querySet = arma::randu<arma::mat>(3, 40);
+  arma::mat r = arma::randu<arma::mat>(3, 3);
+  const arma::mat covariance = r * trans(r) + 0.1 * arma::eye<arma::mat>(3, 3);
+  const Range range(0.1, 0.4);
+
+  MahalanobisDistance<> md(covariance);
+  MahalanobisDistance<false> squaredMD(covariance);
+  MahalanobisRangeSearch<> rs(dataset, md);
+  MahalanobisRangeSearch<StandardCoverTree> squaredRS(dataset, squaredMD);
+
+  vector<vector<size_t>> neighbors, squaredNeighbors;
+  vector<vector<double>> distances, squaredDistances;
+  rs.Search(querySet, range, neighbors, distances);
+  squaredRS.Search(querySet, Range(range.Lo() * range.Lo(),
+      range.Hi() * range.Hi()), squaredNeighbors, squaredDistances);
+
+  BOOST_REQUIRE_EQUAL(neighbors.size(), querySet.n_cols);
+  BOOST_REQUIRE_EQUAL(squaredNeighbors.size(), querySet.n_cols);
+  for (size_t i = 0; i < querySet.n_cols; ++i)
+  {
+    vector<size_t> trueNeighbors;
+    for (size_t j = 0; j < dataset.n_cols; ++j)
+      if (range.Contains(md.Evaluate(querySet.col(i), dataset.col(j))))
+        trueNeighbors.push_back(j);
+
+    vector<size_t> found(neighbors[i]);
+    vector<size_t> squaredFound(squaredNeighbors[i]);
+    sort(found.begin(), found.end());
+    sort(squaredFound.begin(), squaredFound.end());
+    BOOST_REQUIRE(found == trueNeighbors);
+    BOOST_REQUIRE(squaredFound == trueNeighbors);
+
+    for (size_t j = 0; j < neighbors[i].size(); ++j)
+      BOOST_REQUIRE_CLOSE(distances[i][j], md.Evaluate(querySet.col(i),
+          dataset.col(neighbors[i][j])), 1e-5);
+    for (size_t j = 0; j < squaredNeighbors[i].size(); ++j)
+      BOOST_REQUIRE_CLOSE(squaredDistances[i][j], squaredMD.Evaluate(
+          querySet.col(i), dataset.col(squaredNeighbors[i][j])), 1e-5);
+  }
+}
+
+/**
+ * Make sure that range search on sparse data, with kd-trees and cover trees,
+ * finds the same points as a naive search on the same data stored densely.
+ */
+template<template<typename TreeMetricType,
+                  typename TreeStatType,
+                  typename TreeMatType> class TreeType>
+void CheckSparseSearch(const arma::sp_mat& referenceData,
+                       const arma::sp_mat& queryData,
+                       const Range& range)
+{
+  RangeSearch<EuclideanDistance, arma::sp_mat, TreeType> rs(referenceData);
+  RangeSearch<> naive(arma::mat(referenceData), true);
+
+  vector<vector<size_t>> neighbors, naiveNeighbors;
+  vector<vector<double>> distances, naiveDistances;
+  rs.Search(queryData, range, neighbors, distances);
+  naive.Search(arma::mat(queryData), range, naiveNeighbors, naiveDistances);
+
+  vector<vector<pair<double, size_t>>> sorted, sortedNaive;
+  SortResults(neighbors, distances, sorted);
+  SortResults(naiveNeighbors, naiveDistances, sortedNaive);
+
+  BOOST_REQUIRE_EQUAL(sorted.size(), sortedNaive.size());
+  for (size_t i = 0; i < sorted.size(); i++)
+  {
+    BOOST_REQUIRE_EQUAL(sorted[i].size(), sortedNaive[i].size());
+    for (size_t j = 0; j < sorted[i].size(); j++)
+    {
+      BOOST_REQUIRE_EQUAL(sorted[i][j].second, sortedNaive[i][j].second);
+      BOOST_REQUIRE_CLOSE(sorted[i][j].first, sortedNaive[i][j].first, 1e-5);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(SparseRangeSearchTest)
+{
+  arma::sp_mat referenceData;
+  referenceData.sprandu(40, 600, 0.1);
+  arma::sp_mat queryData;
+  queryData.sprandu(40, 100, 0.15);
+
+  CheckSparseSearch<KDTree>(referenceData, queryData, Range(0.5, 1.2));
+  CheckSparseSearch<StandardCoverTree>(referenceData, queryData,
+      Range(0.5, 1.2));
+}
+
 BOOST_AUTO_TEST_SUITE_END();
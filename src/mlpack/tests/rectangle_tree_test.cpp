@@ -162,10 +162,10 @@ void CheckExactContainment(const TreeType& tree)
       double max = -1.0 * DBL_MAX;
       for(size_t j = 0; j < tree.Count(); j++)
       {
-        if (tree.LocalDataset().col(j)[i] < min)
-          min = tree.LocalDataset().col(j)[i];
-        if (tree.LocalDataset().col(j)[i] > max)
-          max = tree.LocalDataset().col(j)[i];
+        if (tree.Dataset()(i, tree.Point(j)) < min)
+          min = tree.Dataset()(i, tree.Point(j));
+        if (tree.Dataset()(i, tree.Point(j)) > max)
+          max = tree.Dataset()(i, tree.Point(j));
       }
       BOOST_REQUIRE_EQUAL(max, tree.Bound()[i].Hi());
       BOOST_REQUIRE_EQUAL(min, tree.Bound()[i].Lo());
@@ -223,43 +223,74 @@ BOOST_AUTO_TEST_CASE(RectangleTreeContainmentTest)
 }
 
 /**
- * A function to ensure that the dataset for the tree, and the datasets stored
- * in each leaf node are in sync.
+ * A function to count the number of times each point of the dataset is held by
+ * a leaf, and to check that every node uses the dataset of the root (the
+ * leaves hold only indices of points).
  * @param tree The tree to check.
+ * @param dataset The dataset of the root.
+ * @param counts The number of times each point is held.
  */
 template<typename TreeType>
-void CheckSync(const TreeType& tree)
+void CountLeafPoints(const TreeType& tree,
+                     const arma::mat& dataset,
+                     arma::Col<size_t>& counts)
 {
+  BOOST_REQUIRE_EQUAL(&tree.Dataset(), &dataset);
   if (tree.IsLeaf())
   {
     for (size_t i = 0; i < tree.Count(); i++)
     {
-      for (size_t j = 0; j < tree.LocalDataset().n_rows; j++)
-      {
-        BOOST_REQUIRE_EQUAL(tree.LocalDataset().col(i)[j],
-                            tree.Dataset().col(tree.Points()[i])[j]);
-      }
+      BOOST_REQUIRE_LT(tree.Point(i), counts.n_elem);
+      ++counts[tree.Point(i)];
     }
   }
   else
   {
     for (size_t i = 0; i < tree.NumChildren(); i++)
-      CheckSync(*tree.Children()[i]);
+      CountLeafPoints(*tree.Children()[i], dataset, counts);
   }
 }
 
-// Test to ensure that the dataset used by the whole tree (and the traversers)
-// is in sync with the datasets stored in each leaf node.
-BOOST_AUTO_TEST_CASE(TreeLocalDatasetInSync)
+/**
+ * Check that every point of the dataset is held by exactly one leaf.
+ * @param tree The tree to check.
+ */
+template<typename TreeType>
+void CheckLeafPoints(const TreeType& tree)
+{
+  arma::Col<size_t> counts(tree.Dataset().n_cols);
+  counts.zeros();
+  CountLeafPoints(tree, tree.Dataset(), counts);
+  for (size_t i = 0; i < counts.n_elem; i++)
+    BOOST_REQUIRE_EQUAL(counts[i], 1);
+}
+
+// Test that the leaves hold exactly the points of the dataset, by index, for
+// trees built by insertion, by bulk loading, and copied from other trees.
+BOOST_AUTO_TEST_CASE(TreeLeafPointsInSync)
 {
   arma::mat dataset;
   dataset.randu(8, 1000); // 1000 points in 8 dimensions.
-  
+
   typedef RTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
       arma::mat> TreeType;
+  typedef RStarTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> RStarTreeType;
 
   TreeType tree(dataset, 20, 6, 5, 2, 0);
-  CheckSync(tree);
+  CheckLeafPoints(tree);
+
+  RStarTreeType rStarTree(dataset, 20, 6, 5, 2, 0);
+  CheckLeafPoints(rStarTree);
+
+  TreeType bulkTree(dataset, STRBulkLoad(), 20, 6, 5, 2);
+  CheckLeafPoints(bulkTree);
+
+  // A deep copy has its own dataset, which all of its nodes use.
+  TreeType copy(tree);
+  BOOST_REQUIRE_NE(&copy.Dataset(), &tree.Dataset());
+  CheckLeafPoints(copy);
+  CheckExactContainment(copy);
 }
 
 /**
@@ -835,4 +866,165 @@ BOOST_AUTO_TEST_CASE(RectangleTreeMoveDatasetTest)
   BOOST_REQUIRE_EQUAL(tree.Dataset().n_cols, 1000);
 }
 
+/**
+ * Make sure that trees built with Sort-Tile-Recursive bulk loading are valid
+ * and balanced, and give the same search results as naive search.
+ */
+BOOST_AUTO_TEST_CASE(STRBulkLoadTest)
+{
+  typedef RTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+
+  for (size_t d = 1; d < 10; d += 4)
+  {
+    arma::mat dataset;
+    dataset.randu(d, 1000);
+
+    TreeType tree(dataset, STRBulkLoad(), 20, 6, 5, 2);
+
+    BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 1000);
+    CheckContainment(tree);
+    CheckExactContainment(tree);
+    CheckSync(tree);
+    CheckFills(tree);
+    CheckHierarchy(tree);
+    BOOST_REQUIRE_EQUAL(GetMinLevel(tree), GetMaxLevel(tree));
+
+    // Now compare search results with the results of naive search.
+    arma::Mat<size_t> neighbors1;
+    arma::mat distances1;
+    arma::Mat<size_t> neighbors2;
+    arma::mat distances2;
+
+    NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>, arma::mat,
+        RTree> allknn1(&tree, true);
+    allknn1.Search(5, neighbors1, distances1);
+
+    AllkNN allknn2(dataset, true, true);
+    allknn2.Search(5, neighbors2, distances2);
+
+    for (size_t i = 0; i < neighbors1.size(); i++)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors1[i], neighbors2[i]);
+      BOOST_REQUIRE_EQUAL(distances1[i], distances2[i]);
+    }
+  }
+}
+
+/**
+ * Make sure that points can still be inserted into a bulk-loaded R* tree, and
+ * that a dataset small enough for one leaf gives a leaf.
+ */
+BOOST_AUTO_TEST_CASE(STRBulkLoadInsertTest)
+{
+  typedef RStarTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+
+  arma::mat smallDataset;
+  smallDataset.randu(3, 15);
+  TreeType smallTree(smallDataset, STRBulkLoad());
+  BOOST_REQUIRE(smallTree.IsLeaf());
+  BOOST_REQUIRE_EQUAL(smallTree.Count(), 15);
+  CheckExactContainment(smallTree);
+
+  arma::mat dataset;
+  dataset.randu(3, 1050);
+  arma::mat initialData = dataset.cols(0, 999);
+  TreeType tree(initialData, STRBulkLoad());
+
+  tree.Dataset().reshape(3, 1050);
+  for (size_t i = 1000; i < 1050; ++i)
+  {
+    tree.Dataset().col(i) = dataset.col(i);
+    tree.InsertPoint(i);
+  }
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 1050);
+  CheckContainment(tree);
+  CheckSync(tree);
+  BOOST_REQUIRE_EQUAL(GetMinLevel(tree), GetMaxLevel(tree));
+}
+
+// Sum the volumes of the bounds of the leaves of the given tree.
+template<typename TreeType>
+double SumLeafVolumes(const TreeType& node)
+{
+  if (node.IsLeaf())
+    return node.Bound().Volume();
+
+  double volume = 0.0;
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+    volume += SumLeafVolumes(node.Child(i));
+  return volume;
+}
+
+/**
+ * Make sure that trees built with Hilbert packing are valid and balanced, that
+ * their leaves are compact, and that they give the same search results as naive
+ * search.
+ */
+BOOST_AUTO_TEST_CASE(HilbertBulkLoadTest)
+{
+  typedef RTree<EuclideanDistance, NeighborSearchStat<NearestNeighborSort>,
+      arma::mat> TreeType;
+
+  for (size_t d = 1; d < 10; d += 4)
+  {
+    arma::mat dataset;
+    dataset.randu(d, 1000);
+
+    TreeType tree(dataset, HilbertBulkLoad(), 20, 6, 5, 2);
+
+    BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 1000);
+    CheckContainment(tree);
+    CheckExactContainment(tree);
+    CheckSync(tree);
+    CheckFills(tree);
+    CheckHierarchy(tree);
+    BOOST_REQUIRE_EQUAL(GetMinLevel(tree), GetMaxLevel(tree));
+
+    // Now compare search results with the results of naive search.
+    arma::Mat<size_t> neighbors1;
+    arma::mat distances1;
+    arma::Mat<size_t> neighbors2;
+    arma::mat distances2;
+
+    NeighborSearch<NearestNeighborSort, metric::LMetric<2, true>, arma::mat,
+        RTree> allknn1(&tree, true);
+    allknn1.Search(5, neighbors1, distances1);
+
+    AllkNN allknn2(dataset, true, true);
+    allknn2.Search(5, neighbors2, distances2);
+
+    for (size_t i = 0; i < neighbors1.size(); i++)
+    {
+      BOOST_REQUIRE_EQUAL(neighbors1[i], neighbors2[i]);
+      BOOST_REQUIRE_EQUAL(distances1[i], distances2[i]);
+    }
+  }
+
+  // In two dimensions, the 50 leaves of points that are consecutive along the
+  // curve should cover little more than the unit square; leaves of random
+  // points would each cover most of it.
+  arma::mat dataset;
+  dataset.randu(2, 1000);
+  TreeType tree(dataset, HilbertBulkLoad(), 20, 6, 5, 2);
+  BOOST_REQUIRE_LT(SumLeafVolumes(tree), 5.0);
+
+  // Points can still be inserted afterwards.
+  arma::mat largerDataset = arma::randu<arma::mat>(2, 1050);
+  largerDataset.cols(0, 999) = dataset;
+  tree.Dataset().reshape(2, 1050);
+  for (size_t i = 1000; i < 1050; ++i)
+  {
+    tree.Dataset().col(i) = largerDataset.col(i);
+    tree.InsertPoint(i);
+  }
+
+  BOOST_REQUIRE_EQUAL(tree.NumDescendants(), 1050);
+  CheckContainment(tree);
+  CheckSync(tree);
+  BOOST_REQUIRE_EQUAL(GetMinLevel(tree), GetMaxLevel(tree));
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -586,4 +586,139 @@ BOOST_AUTO_TEST_CASE(DistractedSequenceRecallTest)
   DistractedSequenceRecallTestNetwork(hiddenLayerLSTMPeephole);
 }
 
+/**
+ * In inference mode the LSTM layer only keeps the last two steps of the
+ * sequence, but the outputs should be the same as in training mode.
+ */
+BOOST_AUTO_TEST_CASE(LSTMInferenceModeTest)
+{
+  const size_t outSize = 5;
+  const size_t seqLen = 7;
+
+  LSTMLayer<> trainingLayer(outSize, true);
+  LSTMLayer<> inferenceLayer(outSize, true);
+  inferenceLayer.Weights() = trainingLayer.Weights();
+
+  trainingLayer.SeqLen() = seqLen;
+  inferenceLayer.SeqLen() = seqLen;
+  inferenceLayer.Deterministic() = true;
+
+  // Run two sequences, to make sure the offset wraps around correctly.
+  for (size_t i = 0; i < 2 * seqLen; ++i)
+  {
+    const arma::mat input = arma::randu<arma::mat>(outSize * 4, 1);
+
+    arma::mat trainingOutput, inferenceOutput;
+    trainingLayer.Forward(input, trainingOutput);
+    inferenceLayer.Forward(input, inferenceOutput);
+
+    BOOST_REQUIRE_EQUAL(inferenceOutput.n_elem, outSize);
+    for (size_t j = 0; j < outSize; ++j)
+      BOOST_REQUIRE_CLOSE(inferenceOutput[j], trainingOutput[j], 1e-10);
+  }
+}
+
+/**
+ * Truncated backpropagation through time carries the state over from one
+ * window to the next, so the network error should not depend on the window
+ * size, and with a single window the update should be the same as with full
+ * backpropagation through time.
+ */
+BOOST_AUTO_TEST_CASE(TruncatedBPTTTest)
+{
+  arma::mat input, labels;
+  GenerateNoisySines(input, labels, 10, 1);
+
+  LinearLayer<SteepestDescent, RandomInitialization> linearLayer0(1, 4);
+  RecurrentLayer<SteepestDescent, RandomInitialization> recurrentLayer0(4);
+  BaseLayer<LogisticFunction> inputBaseLayer;
+  LinearLayer<SteepestDescent, RandomInitialization> hiddenLayer(4, 2);
+  BaseLayer<LogisticFunction> hiddenBaseLayer;
+
+  LinearLayer<SteepestDescent, RandomInitialization> windowLinearLayer0(1, 4);
+  RecurrentLayer<SteepestDescent, RandomInitialization>
+      windowRecurrentLayer0(4);
+  BaseLayer<LogisticFunction> windowInputBaseLayer;
+  LinearLayer<SteepestDescent, RandomInitialization> windowHiddenLayer(4, 2);
+  BaseLayer<LogisticFunction> windowHiddenBaseLayer;
+
+  windowLinearLayer0.Weights() = linearLayer0.Weights();
+  windowRecurrentLayer0.Weights() = recurrentLayer0.Weights();
+  windowHiddenLayer.Weights() = hiddenLayer.Weights();
+
+  BinaryClassificationLayer classOutputLayer;
+
+  auto modules = std::tie(linearLayer0, recurrentLayer0, inputBaseLayer,
+                          hiddenLayer, hiddenBaseLayer);
+  auto windowModules = std::tie(windowLinearLayer0, windowRecurrentLayer0,
+      windowInputBaseLayer, windowHiddenLayer, windowHiddenBaseLayer);
+
+  RNN<decltype(modules), BinaryClassificationLayer, MeanSquaredErrorFunction>
+      net(modules, classOutputLayer);
+  RNN<decltype(windowModules), BinaryClassificationLayer,
+      MeanSquaredErrorFunction> windowNet(windowModules, classOutputLayer, 3);
+
+  arma::mat sequence = input.unsafe_col(0);
+  arma::mat target = labels.unsafe_col(0);
+  arma::mat error, windowError;
+
+  // The error does not depend on the windows.
+  for (size_t steps = 1; steps <= 11; steps += 2)
+  {
+    windowNet.BPTTSteps() = steps;
+    BOOST_REQUIRE_CLOSE(windowNet.Evaluate(sequence, target, windowError),
+        net.Evaluate(sequence, target, error), 1e-8);
+  }
+
+  // With one window for the whole sequence, the update is the same.
+  windowNet.BPTTSteps() = 10;
+  net.FeedForward(sequence, target, error);
+  net.FeedBackward(sequence, error);
+  net.ApplyGradients();
+  windowNet.FeedForward(sequence, target, windowError);
+  windowNet.FeedBackward(sequence, windowError);
+  windowNet.ApplyGradients();
+
+  for (size_t i = 0; i < linearLayer0.Weights().n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(windowLinearLayer0.Weights()[i],
+        linearLayer0.Weights()[i], 1e-8);
+  for (size_t i = 0; i < recurrentLayer0.Weights().n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(windowRecurrentLayer0.Weights()[i],
+        recurrentLayer0.Weights()[i], 1e-8);
+  for (size_t i = 0; i < hiddenLayer.Weights().n_elem; ++i)
+    BOOST_REQUIRE_CLOSE(windowHiddenLayer.Weights()[i],
+        hiddenLayer.Weights()[i], 1e-8);
+}
+
+/**
+ * An LSTM layer which carries its state over from one window to the next
+ * should give the same outputs as one that sees the whole sequence at once.
+ */
+BOOST_AUTO_TEST_CASE(LSTMCarryStateTest)
+{
+  const size_t outSize = 5;
+
+  LSTMLayer<> sequenceLayer(outSize, true);
+  LSTMLayer<> windowLayer(outSize, true);
+  windowLayer.Weights() = sequenceLayer.Weights();
+
+  sequenceLayer.SeqLen() = 9;
+  windowLayer.SeqLen() = 3;
+
+  for (size_t i = 0; i < 9; ++i)
+  {
+    // Only the first window starts from a zero state.
+    windowLayer.CarryState() = (i >= 3);
+
+    const arma::mat input = arma::randu<arma::mat>(outSize * 4, 1);
+
+    arma::mat sequenceOutput, windowOutput;
+    sequenceLayer.Forward(input, sequenceOutput);
+    windowLayer.Forward(input, windowOutput);
+
+    for (size_t j = 0; j < outSize; ++j)
+      BOOST_REQUIRE_CLOSE(windowOutput[j], sequenceOutput[j], 1e-10);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -6,6 +6,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/regularized_svd/regularized_svd.hpp>
+#include <mlpack/core/optimizers/parallel_sgd/parallel_sgd.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -244,4 +245,203 @@ BOOST_AUTO_TEST_CASE(RegularizedSVDFunctionOptimize)
   BOOST_REQUIRE_SMALL(relativeError, 1e-2);
 }
 
+/**
+ * Make sure that the sparse gradients of the training examples add up to the
+ * full gradient.
+ */
+BOOST_AUTO_TEST_CASE(RegularizedSVDFunctionSparseGradient)
+{
+  // Define useful constants.
+  const size_t numUsers = 30;
+  const size_t numItems = 40;
+  const size_t numRatings = 200;
+  const size_t maxRating = 5;
+  const size_t rank = 6;
+
+  // Make a random rating dataset.
+  arma::mat data = arma::randu(3, numRatings);
+  data.row(0) = floor(data.row(0) * numUsers);
+  data.row(1) = floor(data.row(1) * numItems);
+  data.row(2) = floor(data.row(2) * maxRating + 0.5);
+
+  // Manually set last row to maximum user and maximum item.
+  data(0, numRatings - 1) = numUsers - 1;
+  data(1, numRatings - 1) = numItems - 1;
+
+  arma::mat parameters = arma::randu(rank, numUsers + numItems);
+  RegularizedSVDFunction rSVDFunc(data, rank, 0.3);
+
+  arma::mat gradient;
+  rSVDFunc.Gradient(parameters, gradient);
+
+  arma::mat gradientSum = arma::zeros<arma::mat>(rank, numUsers + numItems);
+  arma::sp_mat sparseGradient;
+  for (size_t i = 0; i < numRatings; i++)
+  {
+    rSVDFunc.Gradient(parameters, i, sparseGradient);
+    BOOST_REQUIRE_EQUAL(sparseGradient.n_rows, rank);
+    BOOST_REQUIRE_EQUAL(sparseGradient.n_cols, numUsers + numItems);
+    BOOST_REQUIRE_LE(sparseGradient.n_nonzero, 2 * rank);
+    gradientSum += sparseGradient;
+  }
+
+  for (size_t i = 0; i < gradient.n_elem; i++)
+  {
+    if (std::abs(gradient[i]) <= 1e-10)
+      BOOST_REQUIRE_SMALL(gradientSum[i], 1e-10);
+    else
+      BOOST_REQUIRE_CLOSE(gradientSum[i], gradient[i], 1e-8);
+  }
+}
+
+/**
+ * Make sure that RegularizedSVD can recover a low-rank rating matrix when it is
+ * trained with the parallel SGD optimizer.
+ */
+BOOST_AUTO_TEST_CASE(RegularizedSVDParallelSGDOptimize)
+{
+  // Define useful constants.
+  const size_t numUsers = 50;
+  const size_t numItems = 50;
+  const size_t numRatings = 100;
+  const size_t iterations = 100;
+  const size_t rank = 10;
+  const double alpha = 0.005;
+  const double lambda = 0.01;
+
+  // Initiate random parameters.
+  arma::mat parameters = arma::randu(rank, numUsers + numItems);
+
+  // Make a random rating dataset.
+  arma::mat data = arma::randu(3, numRatings);
+  data.row(0) = floor(data.row(0) * numUsers);
+  data.row(1) = floor(data.row(1) * numItems);
+
+  // Manually set last row to maximum user and maximum item.
+  data(0, numRatings - 1) = numUsers - 1;
+  data(1, numRatings - 1) = numItems - 1;
+
+  // Make rating entries based on the parameters.
+  for (size_t i = 0; i < numRatings; i++)
+  {
+    data(2, i) = arma::dot(parameters.col(data(0, i)),
+                           parameters.col(numUsers + data(1, i)));
+  }
+
+  // Train with the parallel optimizer, through RegularizedSVD.
+  RegularizedSVD<mlpack::optimization::ParallelSGD> rSVD(iterations, alpha,
+      lambda);
+  arma::mat u, v;
+  rSVD.Apply(data, rank, u, v);
+
+  // Get predicted ratings from the user and item matrices.
+  arma::mat predictedData(1, numRatings);
+  for (size_t i = 0; i < numRatings; i++)
+  {
+    predictedData(0, i) = arma::dot(v.col(data(0, i)),
+                                    u.row(data(1, i)).t());
+  }
+
+  // Calculate relative error.
+  const double relativeError = arma::norm(data.row(2) - predictedData, "frob") /
+                               arma::norm(data, "frob");
+
+  // Relative error should be small.
+  BOOST_REQUIRE_SMALL(relativeError, 1e-2);
+}
+
+/**
+ * Make sure that the fused cost and gradient are the same as the separate ones.
+ */
+BOOST_AUTO_TEST_CASE(RegularizedSVDFunctionEvaluateWithGradient)
+{
+  // Define useful constants.
+  const size_t numUsers = 20;
+  const size_t numItems = 30;
+  const size_t numRatings = 150;
+  const size_t maxRating = 5;
+  const size_t rank = 4;
+
+  // Make a random rating dataset.
+  arma::mat data = arma::randu(3, numRatings);
+  data.row(0) = floor(data.row(0) * numUsers);
+  data.row(1) = floor(data.row(1) * numItems);
+  data.row(2) = floor(data.row(2) * maxRating + 0.5);
+
+  // Manually set last row to maximum user and maximum item.
+  data(0, numRatings - 1) = numUsers - 1;
+  data(1, numRatings - 1) = numItems - 1;
+
+  BOOST_REQUIRE(mlpack::optimization::HasEvaluateWithGradient<
+      RegularizedSVDFunction>::value);
+
+  arma::mat parameters = arma::randu(rank, numUsers + numItems);
+  RegularizedSVDFunction rSVDFunc(data, rank, 0.25);
+
+  arma::mat gradient, fusedGradient;
+  rSVDFunc.Gradient(parameters, gradient);
+  BOOST_REQUIRE_CLOSE(rSVDFunc.EvaluateWithGradient(parameters, fusedGradient),
+      rSVDFunc.Evaluate(parameters), 1e-10);
+  for (size_t i = 0; i < gradient.n_elem; i++)
+  {
+    if (std::abs(gradient[i]) <= 1e-12)
+      BOOST_REQUIRE_SMALL(fusedGradient[i], 1e-12);
+    else
+      BOOST_REQUIRE_CLOSE(fusedGradient[i], gradient[i], 1e-10);
+  }
+}
+
+/**
+ * Make sure that RegularizedSVD can be trained directly on a sparse rating
+ * matrix with the parallel SGD optimizer, and that users and items without
+ * ratings still get factors.
+ */
+BOOST_AUTO_TEST_CASE(RegularizedSVDSparseParallelSGDOptimize)
+{
+  // Define useful constants.
+  const size_t numUsers = 50;
+  const size_t numItems = 40;
+  const size_t numRatings = 100;
+  const size_t iterations = 100;
+  const size_t rank = 10;
+  const double alpha = 0.005;
+  const double lambda = 0.01;
+
+  // Initiate random parameters.
+  arma::mat parameters = arma::randu(rank, numUsers + numItems);
+
+  // Make a random sparse rating matrix (items x users).  The last user and the
+  // last item have no ratings.
+  arma::sp_mat data(numItems, numUsers);
+  for (size_t i = 0; i < numRatings; i++)
+  {
+    const size_t user = math::RandInt(numUsers - 1);
+    const size_t item = math::RandInt(numItems - 1);
+    data(item, user) = arma::dot(parameters.col(user),
+                                 parameters.col(numUsers + item));
+  }
+
+  RegularizedSVD<mlpack::optimization::ParallelSGD> rSVD(iterations, alpha,
+      lambda);
+  arma::mat u, v;
+  rSVD.Apply(data, rank, u, v);
+
+  BOOST_REQUIRE_EQUAL(u.n_rows, numItems);
+  BOOST_REQUIRE_EQUAL(u.n_cols, rank);
+  BOOST_REQUIRE_EQUAL(v.n_rows, rank);
+  BOOST_REQUIRE_EQUAL(v.n_cols, numUsers);
+
+  // Get predicted ratings from the user and item matrices.
+  double error = 0.0, norm = 0.0;
+  for (arma::sp_mat::const_iterator it = data.begin(); it != data.end(); ++it)
+  {
+    const double prediction = arma::dot(v.col(it.col()), u.row(it.row()).t());
+    error += (*it - prediction) * (*it - prediction);
+    norm += (*it) * (*it);
+  }
+
+  // Relative error should be small.
+  BOOST_REQUIRE_SMALL(std::sqrt(error / norm), 5e-2);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
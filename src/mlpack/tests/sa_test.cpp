@@ -7,6 +7,7 @@
 #include <mlpack/core.hpp>
 #include <mlpack/core/optimizers/sa/sa.hpp>
 #include <mlpack/core/optimizers/sa/exponential_schedule.hpp>
+#include <mlpack/core/optimizers/sa/parallel_tempering_sa.hpp>
 #include <mlpack/core/optimizers/lbfgs/test_functions.hpp>
 
 #include <mlpack/core/metrics/ip_metric.hpp>
@@ -124,4 +125,56 @@ BOOST_AUTO_TEST_CASE(RastrigrinFunctionTest)
   BOOST_REQUIRE_GE(successes, 1);
 }
 
+/**
+ * Parallel tempering should escape the local minima of the Rastrigrin function
+ * too.  The hotter chains cross the barriers between the minima, so this should
+ * work at least once in three trials.
+ */
+BOOST_AUTO_TEST_CASE(ParallelTemperingRastrigrinFunctionTest)
+{
+  size_t successes = 0;
+
+  for (size_t trial = 0; trial < 3; ++trial)
+  {
+    RastrigrinFunction f;
+    ExponentialSchedule schedule(3e-6);
+    ParallelTemperingSA<RastrigrinFunction> sa(f, schedule, 20000000, 100, 50,
+        1000, 1e-12, 2, 0.2, 0.01, 0.1, 4, 3.0, 100);
+    arma::mat coordinates = f.GetInitialPoint();
+
+    const double result = sa.Optimize(coordinates);
+
+    // The returned point must be the one the returned objective belongs to.
+    BOOST_REQUIRE_CLOSE(f.Evaluate(coordinates), result, 1e-10);
+
+    if ((std::abs(result) < 1e-3) &&
+        (std::abs(coordinates[0]) < 1e-3) &&
+        (std::abs(coordinates[1]) < 1e-3))
+      ++successes;
+  }
+
+  BOOST_REQUIRE_GE(successes, 1);
+}
+
+/**
+ * Make sure that invalid parallel tempering parameters are rejected.
+ */
+BOOST_AUTO_TEST_CASE(ParallelTemperingInvalidParametersTest)
+{
+  RastrigrinFunction f;
+  ExponentialSchedule schedule;
+
+  // No chains.
+  BOOST_REQUIRE_THROW(ParallelTemperingSA<RastrigrinFunction>(f, schedule,
+      1000, 100, 50, 1000, 1e-12, 2, 0.2, 0.01, 0.1, 0), std::invalid_argument);
+  // Hotter chains colder than the coldest chain.
+  BOOST_REQUIRE_THROW(ParallelTemperingSA<RastrigrinFunction>(f, schedule,
+      1000, 100, 50, 1000, 1e-12, 2, 0.2, 0.01, 0.1, 4, 0.5),
+      std::invalid_argument);
+  // No moves between exchanges.
+  BOOST_REQUIRE_THROW(ParallelTemperingSA<RastrigrinFunction>(f, schedule,
+      1000, 100, 50, 1000, 1e-12, 2, 0.2, 0.01, 0.1, 4, 2.0, 0),
+      std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
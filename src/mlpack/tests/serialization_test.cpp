@@ -23,6 +23,8 @@
 #include <mlpack/core/tree/binary_space_tree.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
 #include <mlpack/core/tree/rectangle_tree.hpp>
+#include <mlpack/core/tree/spill_tree.hpp>
+#include <mlpack/core/tree/tree_memory_usage.hpp>
 
 #include <mlpack/methods/perceptron/perceptron.hpp>
 #include <mlpack/methods/logistic_regression/logistic_regression.hpp>
@@ -32,6 +34,7 @@
 #include <mlpack/methods/naive_bayes/naive_bayes_classifier.hpp>
 #include <mlpack/methods/rann/ra_search.hpp>
 #include <mlpack/methods/lsh/lsh_search.hpp>
+#include <mlpack/methods/cf/cf.hpp>
 
 using namespace mlpack;
 using namespace mlpack::distribution;
@@ -732,6 +735,26 @@ BOOST_AUTO_TEST_CASE(BinarySpaceTreeOverwriteTest)
   CheckTrees(tree, xmlTree, textTree, binaryTree);
 }
 
+BOOST_AUTO_TEST_CASE(SpillTreeTest)
+{
+  arma::mat data;
+  data.randu(3, 100);
+  typedef SpillTree<EuclideanDistance> TreeType;
+  TreeType tree(data, 10, 0.05);
+
+  TreeType* xmlTree;
+  TreeType* textTree;
+  TreeType* binaryTree;
+
+  SerializePointerObjectAll(&tree, xmlTree, textTree, binaryTree);
+
+  CheckTrees(tree, *xmlTree, *textTree, *binaryTree);
+
+  delete xmlTree;
+  delete textTree;
+  delete binaryTree;
+}
+
 BOOST_AUTO_TEST_CASE(CoverTreeTest)
 {
   arma::mat data;
@@ -787,6 +810,34 @@ BOOST_AUTO_TEST_CASE(CoverTreeTest)
   delete binaryTree;
 }
 
+/**
+ * A cover tree loaded while a NodeArena::Scope is alive takes its nodes from
+ * the arena.
+ */
+BOOST_AUTO_TEST_CASE(CoverTreeNodeArenaTest)
+{
+  arma::mat data;
+  data.randu(3, 100);
+  typedef StandardCoverTree<EuclideanDistance, EmptyStatistic, arma::mat>
+      TreeType;
+  TreeType tree(data);
+
+  NodeArena::Scope scope;
+  TreeType* xmlTree;
+  TreeType* textTree;
+  TreeType* binaryTree;
+
+  SerializePointerObjectAll(&tree, xmlTree, textTree, binaryTree);
+  BOOST_REQUIRE_EQUAL(scope.Arena().Nodes(), 3 * NumNodes(tree));
+
+  CheckTrees(tree, *xmlTree, *textTree, *binaryTree);
+
+  delete xmlTree;
+  delete textTree;
+  delete binaryTree;
+  BOOST_REQUIRE_EQUAL(scope.Arena().Nodes(), 0);
+}
+
 BOOST_AUTO_TEST_CASE(CoverTreeOverwriteTest)
 {
   arma::mat data;
@@ -1425,8 +1476,58 @@ BOOST_AUTO_TEST_CASE(LSHTest)
   BOOST_REQUIRE_EQUAL(lsh.BucketSize(), textLsh.BucketSize());
   BOOST_REQUIRE_EQUAL(lsh.BucketSize(), binaryLsh.BucketSize());
 
-  CheckMatrices(lsh.SecondHashTable(), xmlLsh.SecondHashTable(),
-      textLsh.SecondHashTable(), binaryLsh.SecondHashTable());
+  CheckMatrices(lsh.BucketOffsets(), xmlLsh.BucketOffsets(),
+      textLsh.BucketOffsets(), binaryLsh.BucketOffsets());
+  CheckMatrices(arma::conv_to<arma::Col<size_t>>::from(lsh.BucketContents()),
+      arma::conv_to<arma::Col<size_t>>::from(xmlLsh.BucketContents()),
+      arma::conv_to<arma::Col<size_t>>::from(textLsh.BucketContents()),
+      arma::conv_to<arma::Col<size_t>>::from(binaryLsh.BucketContents()));
+}
+
+// Make sure a CF model (with its neighbor search tree) gives the same
+// predictions after it is serialized.
+BOOST_AUTO_TEST_CASE(CFTest)
+{
+  // Build a random (user, item, rating) table, with each user rating about a
+  // third of the items.
+  std::vector<double> entries;
+  for (size_t user = 0; user < 20; ++user)
+  {
+    for (size_t item = 0; item < 30; ++item)
+    {
+      if (math::Random() < 0.3 || user == item)
+      {
+        entries.push_back(user);
+        entries.push_back(item);
+        entries.push_back(math::RandInt(1, 6));
+      }
+    }
+  }
+  arma::mat dataset(&entries[0], 3, entries.size() / 3);
+
+  cf::CF<> c(dataset, amf::NMFALSFactorizer(), 3, 4);
+  cf::CF<> xmlC, textC, binaryC;
+
+  SerializeObjectAll(c, xmlC, textC, binaryC);
+
+  CheckMatrices(c.W(), xmlC.W(), textC.W(), binaryC.W());
+  CheckMatrices(c.H(), xmlC.H(), textC.H(), binaryC.H());
+
+  arma::Mat<size_t> combinations(2, 10);
+  for (size_t i = 0; i < 10; ++i)
+  {
+    combinations(0, i) = math::RandInt(20);
+    combinations(1, i) = math::RandInt(30);
+  }
+
+  arma::vec predictions, xmlPredictions, textPredictions, binaryPredictions;
+  c.Predict(combinations, predictions);
+  xmlC.Predict(combinations, xmlPredictions);
+  textC.Predict(combinations, textPredictions);
+  binaryC.Predict(combinations, binaryPredictions);
+
+  CheckMatrices(predictions, xmlPredictions, textPredictions,
+      binaryPredictions);
 }
 
 BOOST_AUTO_TEST_SUITE_END();
@@ -6,6 +6,8 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/core/optimizers/sgd/sgd.hpp>
+#include <mlpack/core/optimizers/minibatch_sgd/minibatch_sgd.hpp>
+#include <mlpack/core/optimizers/parallel_sgd/parallel_sgd.hpp>
 #include <mlpack/core/optimizers/lbfgs/test_functions.hpp>
 #include <mlpack/core/optimizers/sgd/test_function.hpp>
 
@@ -58,4 +60,66 @@ BOOST_AUTO_TEST_CASE(GeneralizedRosenbrockTest)
   }
 }
 
+/**
+ * Run mini-batch SGD on the simple test function with a few batch sizes (the
+ * last batch of an epoch is smaller when the batch size does not divide the
+ * number of functions), with and without momentum.
+ */
+BOOST_AUTO_TEST_CASE(SimpleMiniBatchSGDTestFunction)
+{
+  const size_t batchSizes[] = { 1, 2, 3 };
+  for (size_t b = 0; b < 3; ++b)
+  {
+    for (size_t m = 0; m < 2; ++m)
+    {
+      SGDTestFunction f;
+      // The step is taken along the average gradient of the batch, so the step
+      // size is scaled with the batch size.
+      MiniBatchSGD<SGDTestFunction> s(f, batchSizes[b],
+          0.0003 * batchSizes[b], 5000000, 1e-9, true, (m == 0) ? 0.0 : 0.5);
+
+      arma::mat coordinates = f.GetInitialPoint();
+      double result = s.Optimize(coordinates);
+
+      BOOST_REQUIRE_CLOSE(result, -1.0, 0.05);
+      BOOST_REQUIRE_SMALL(coordinates[0], 1e-3);
+      BOOST_REQUIRE_SMALL(coordinates[1], 1e-7);
+      BOOST_REQUIRE_SMALL(coordinates[2], 1e-7);
+    }
+  }
+}
+
+/**
+ * Make sure that invalid parameters for mini-batch SGD are rejected.
+ */
+BOOST_AUTO_TEST_CASE(MiniBatchSGDInvalidParametersTest)
+{
+  SGDTestFunction f;
+  BOOST_REQUIRE_THROW(MiniBatchSGD<SGDTestFunction>(f, 0),
+      std::invalid_argument);
+  BOOST_REQUIRE_THROW(MiniBatchSGD<SGDTestFunction>(f, 2, 0.01, 100, 1e-5,
+      true, 1.0), std::invalid_argument);
+  BOOST_REQUIRE_THROW(MiniBatchSGD<SGDTestFunction>(f, 2, 0.01, 100, 1e-5,
+      true, -0.1), std::invalid_argument);
+}
+
+/**
+ * Run parallel SGD on the simple test function.  Each separable function
+ * touches a different coordinate, so the threads never write to the same
+ * coordinates.
+ */
+BOOST_AUTO_TEST_CASE(SimpleParallelSGDTestFunction)
+{
+  SGDTestFunction f;
+  ParallelSGD<SGDTestFunction> s(f, 0.0003, 5000000, 1e-9, true);
+
+  arma::mat coordinates = f.GetInitialPoint();
+  double result = s.Optimize(coordinates);
+
+  BOOST_REQUIRE_CLOSE(result, -1.0, 0.05);
+  BOOST_REQUIRE_SMALL(coordinates[0], 1e-3);
+  BOOST_REQUIRE_SMALL(coordinates[1], 1e-7);
+  BOOST_REQUIRE_SMALL(coordinates[2], 1e-7);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
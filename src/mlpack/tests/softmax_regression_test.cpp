@@ -6,6 +6,8 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/softmax_regression/softmax_regression.hpp>
+#include <mlpack/core/optimizers/minibatch_sgd/minibatch_sgd.hpp>
+#include <mlpack/core/optimizers/tron/tron.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -34,7 +36,7 @@ BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionEvaluate)
     labels(i) = math::RandInt(0, numClasses);
 
   // Create a SoftmaxRegressionFunction. Regularization term ignored.
-  SoftmaxRegressionFunction srf(data, labels, numClasses, 0);
+  SoftmaxRegressionFunction<> srf(data, labels, numClasses, 0);
 
   // Run a number of trials.
   for(size_t i = 0; i < trials; i++)
@@ -79,9 +81,9 @@ BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionRegularizationEvaluate)
     labels(i) = math::RandInt(0, numClasses);
 
   // 3 objects for comparing regularization costs.
-  SoftmaxRegressionFunction srfNoReg(data, labels, numClasses, 0);
-  SoftmaxRegressionFunction srfSmallReg(data, labels, numClasses, 1);
-  SoftmaxRegressionFunction srfBigReg(data, labels, numClasses, 20);
+  SoftmaxRegressionFunction<> srfNoReg(data, labels, numClasses, 0);
+  SoftmaxRegressionFunction<> srfSmallReg(data, labels, numClasses, 1);
+  SoftmaxRegressionFunction<> srfBigReg(data, labels, numClasses, 20);
 
   // Run a number of trials.
   for (size_t i = 0; i < trials; i++)
@@ -121,8 +123,8 @@ BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionGradient)
 
   // 2 objects for 2 terms in the cost function. Each term contributes towards
   // the gradient and thus need to be checked independently.
-  SoftmaxRegressionFunction srf1(data, labels, numClasses, 0);
-  SoftmaxRegressionFunction srf2(data, labels, numClasses, 20);
+  SoftmaxRegressionFunction<> srf1(data, labels, numClasses, 0);
+  SoftmaxRegressionFunction<> srf2(data, labels, numClasses, 20);
 
   // Create a random set of parameters.
   arma::mat parameters;
@@ -357,8 +359,8 @@ BOOST_AUTO_TEST_CASE(SoftmaxRegressionTrainTest)
 
   // This should be the same as the default parameters given by
   // SoftmaxRegression.
-  SoftmaxRegressionFunction srf(dataset, labels, 2, 0.0001, false);
-  L_BFGS<SoftmaxRegressionFunction> lbfgs(srf);
+  SoftmaxRegressionFunction<> srf(dataset, labels, 2, 0.0001, false);
+  L_BFGS<SoftmaxRegressionFunction<>> lbfgs(srf);
   SoftmaxRegression<> sr(lbfgs);
 
   SoftmaxRegression<> sr2(dataset.n_rows, 2);
@@ -387,12 +389,12 @@ BOOST_AUTO_TEST_CASE(SoftmaxRegressionOptimizerTrainTest)
   for (size_t i = 500; i < 1000; ++i)
     labels[i] = size_t(1.0);
 
-  SoftmaxRegressionFunction srf(dataset, labels, 2, 0.01, true);
-  L_BFGS<SoftmaxRegressionFunction> lbfgs(srf);
+  SoftmaxRegressionFunction<> srf(dataset, labels, 2, 0.01, true);
+  L_BFGS<SoftmaxRegressionFunction<>> lbfgs(srf);
   SoftmaxRegression<> sr(lbfgs);
 
   SoftmaxRegression<> sr2(dataset.n_rows, 2, true);
-  L_BFGS<SoftmaxRegressionFunction> lbfgs2(srf);
+  L_BFGS<SoftmaxRegressionFunction<>> lbfgs2(srf);
   sr2.Parameters() = srf.GetInitialPoint();
   sr2.Train(lbfgs2);
 
@@ -408,4 +410,200 @@ BOOST_AUTO_TEST_CASE(SoftmaxRegressionOptimizerTrainTest)
   }
 }
 
+/**
+ * Make sure that the fused objective and gradient are the same as the separate
+ * ones, with and without the intercept.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionEvaluateWithGradient)
+{
+  const size_t points = 500;
+  const size_t inputSize = 8;
+  const size_t numClasses = 4;
+
+  arma::mat data;
+  data.randu(inputSize, points);
+  arma::Row<size_t> labels(points);
+  for (size_t i = 0; i < points; i++)
+    labels(i) = math::RandInt(0, numClasses);
+
+  BOOST_REQUIRE(HasEvaluateWithGradient<SoftmaxRegressionFunction<>>::value);
+
+  for (size_t f = 0; f < 2; f++)
+  {
+    SoftmaxRegressionFunction<> srf(data, labels, numClasses, 0.5, (f == 1));
+    const arma::mat parameters = arma::randu<arma::mat>(numClasses,
+        inputSize + f);
+
+    arma::mat gradient, fusedGradient;
+    srf.Gradient(parameters, gradient);
+    BOOST_REQUIRE_CLOSE(srf.EvaluateWithGradient(parameters, fusedGradient),
+        srf.Evaluate(parameters), 1e-10);
+    BOOST_REQUIRE_EQUAL(fusedGradient.n_rows, gradient.n_rows);
+    BOOST_REQUIRE_EQUAL(fusedGradient.n_cols, gradient.n_cols);
+    for (size_t j = 0; j < gradient.n_elem; j++)
+      BOOST_REQUIRE_CLOSE(fusedGradient[j], gradient[j], 1e-10);
+  }
+}
+
+/**
+ * Make sure that the objective and gradient on a sparse dataset are the same
+ * as on the same dataset stored as a dense matrix.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionSparseTest)
+{
+  const size_t points = 500;
+  const size_t inputSize = 20;
+  const size_t numClasses = 4;
+
+  arma::sp_mat sparseData;
+  sparseData.sprandu(inputSize, points, 0.1);
+  const arma::mat data(sparseData);
+  arma::Row<size_t> labels(points);
+  for (size_t i = 0; i < points; i++)
+    labels(i) = math::RandInt(0, numClasses);
+
+  for (size_t f = 0; f < 2; f++)
+  {
+    SoftmaxRegressionFunction<> srf(data, labels, numClasses, 0.5, (f == 1));
+    SoftmaxRegressionFunction<arma::sp_mat> sparseSrf(sparseData, labels,
+        numClasses, 0.5, (f == 1));
+    const arma::mat parameters = arma::randu<arma::mat>(numClasses,
+        inputSize + f);
+
+    BOOST_REQUIRE_CLOSE(sparseSrf.Evaluate(parameters),
+        srf.Evaluate(parameters), 1e-10);
+
+    arma::mat gradient, sparseGradient;
+    srf.Gradient(parameters, gradient);
+    sparseSrf.Gradient(parameters, sparseGradient);
+    BOOST_REQUIRE_EQUAL(sparseGradient.n_rows, gradient.n_rows);
+    BOOST_REQUIRE_EQUAL(sparseGradient.n_cols, gradient.n_cols);
+    for (size_t j = 0; j < gradient.n_elem; j++)
+      BOOST_REQUIRE_CLOSE(sparseGradient[j], gradient[j], 1e-8);
+  }
+}
+
+/**
+ * Make sure that the objectives and gradients of the batches add up to the
+ * full objective and gradient.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionBatchTest)
+{
+  const size_t points = 500;
+  const size_t inputSize = 8;
+  const size_t numClasses = 4;
+
+  arma::mat data;
+  data.randu(inputSize, points);
+  arma::Row<size_t> labels(points);
+  for (size_t i = 0; i < points; i++)
+    labels(i) = math::RandInt(0, numClasses);
+
+  BOOST_REQUIRE(HasBatchGradient<SoftmaxRegressionFunction<>>::value);
+  BOOST_REQUIRE(HasBatchGradient<
+      SoftmaxRegressionFunction<arma::sp_mat>>::value);
+
+  for (size_t f = 0; f < 2; f++)
+  {
+    SoftmaxRegressionFunction<> srf(data, labels, numClasses, 0.5, (f == 1));
+    const arma::mat parameters = arma::randu<arma::mat>(numClasses,
+        inputSize + f);
+
+    BOOST_REQUIRE_EQUAL(srf.NumFunctions(), points);
+
+    // Batches of 128 points, with a smaller last batch.
+    double objective = 0.0;
+    arma::mat gradient = arma::zeros<arma::mat>(parameters.n_rows,
+        parameters.n_cols);
+    for (size_t begin = 0; begin < points; begin += 128)
+    {
+      const size_t batchSize = std::min((size_t) 128, points - begin);
+      objective += srf.Evaluate(parameters, begin, batchSize);
+
+      arma::mat batchGradient;
+      srf.Gradient(parameters, begin, batchSize, batchGradient);
+      gradient += batchGradient;
+    }
+
+    BOOST_REQUIRE_CLOSE(objective, srf.Evaluate(parameters), 1e-8);
+
+    arma::mat fullGradient;
+    srf.Gradient(parameters, fullGradient);
+    for (size_t j = 0; j < fullGradient.n_elem; j++)
+      BOOST_REQUIRE_CLOSE(gradient[j], fullGradient[j], 1e-8);
+  }
+}
+
+
+/**
+ * Make sure that the Hessian-vector product is the same as a central difference
+ * of the gradient, with and without the intercept.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionFunctionHessianVectorProduct)
+{
+  const size_t points = 500;
+  const size_t inputSize = 8;
+  const size_t numClasses = 4;
+
+  arma::mat data;
+  data.randu(inputSize, points);
+  arma::Row<size_t> labels(points);
+  for (size_t i = 0; i < points; i++)
+    labels(i) = math::RandInt(0, numClasses);
+
+  BOOST_REQUIRE(HasHessianVectorProduct<SoftmaxRegressionFunction<>>::value);
+
+  const double h = 1e-5;
+  for (size_t f = 0; f < 2; f++)
+  {
+    SoftmaxRegressionFunction<> srf(data, labels, numClasses, 0.5, (f == 1));
+    const arma::mat parameters = arma::randu<arma::mat>(numClasses,
+        inputSize + f);
+    const arma::mat v = arma::randn<arma::mat>(numClasses, inputSize + f);
+
+    arma::mat hv, forward, backward;
+    srf.HessianVectorProduct(parameters, v, hv);
+    const arma::mat plus = parameters + h * v;
+    const arma::mat minus = parameters - h * v;
+    srf.Gradient(plus, forward);
+    srf.Gradient(minus, backward);
+    const arma::mat difference = (forward - backward) / (2 * h);
+
+    BOOST_REQUIRE_EQUAL(hv.n_rows, numClasses);
+    BOOST_REQUIRE_EQUAL(hv.n_cols, inputSize + f);
+    for (size_t j = 0; j < hv.n_elem; j++)
+      BOOST_REQUIRE_SMALL(hv[j] - difference[j], 1e-6);
+  }
+}
+
+/**
+ * Make sure that training with TRON gives the same model as training with
+ * L-BFGS.
+ */
+BOOST_AUTO_TEST_CASE(SoftmaxRegressionTRONTest)
+{
+  const size_t points = 1000;
+  const size_t inputSize = 5;
+  const size_t numClasses = 3;
+
+  arma::mat data;
+  data.randu(inputSize, points);
+  arma::Row<size_t> labels(points);
+  for (size_t i = 0; i < points; i++)
+    labels(i) = math::RandInt(0, numClasses);
+
+  SoftmaxRegressionFunction<> srf(data, labels, numClasses, 0.01, true);
+  L_BFGS<SoftmaxRegressionFunction<>> lbfgs(srf);
+  arma::mat lbfgsParameters = srf.GetInitialPoint();
+  const double lbfgsObjective = lbfgs.Optimize(lbfgsParameters);
+
+  TRON<SoftmaxRegressionFunction<>> tron(srf);
+  SoftmaxRegression<TRON> sr(tron);
+
+  BOOST_REQUIRE_LE(tron.Iterations(), 30);
+  BOOST_REQUIRE_CLOSE(srf.Evaluate(sr.Parameters()), lbfgsObjective, 1e-5);
+  for (size_t j = 0; j < lbfgsParameters.n_elem; j++)
+    BOOST_REQUIRE_SMALL(sr.Parameters()[j] - lbfgsParameters[j], 1e-3);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
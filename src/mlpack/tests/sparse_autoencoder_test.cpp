@@ -6,6 +6,7 @@
  */
 #include <mlpack/core.hpp>
 #include <mlpack/methods/sparse_autoencoder/sparse_autoencoder.hpp>
+#include <mlpack/core/optimizers/minibatch_sgd/batch_function.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -263,4 +264,87 @@ BOOST_AUTO_TEST_CASE(SparseAutoencoderFunctionGradient)
   }
 }
 
+/**
+ * Make sure that the fused objective and gradient are the same as the separate
+ * ones.
+ */
+BOOST_AUTO_TEST_CASE(SparseAutoencoderFunctionEvaluateWithGradient)
+{
+  const size_t points = 200;
+  const size_t vSize = 12;
+  const size_t hSize = 6;
+
+  arma::mat data;
+  data.randu(vSize, points);
+
+  BOOST_REQUIRE(optimization::HasEvaluateWithGradient<
+      SparseAutoencoderFunction>::value);
+
+  SparseAutoencoderFunction saf(data, vSize, hSize, 2, 3);
+  const arma::mat parameters = saf.GetInitialPoint();
+
+  arma::mat gradient, fusedGradient;
+  saf.Gradient(parameters, gradient);
+  BOOST_REQUIRE_CLOSE(saf.EvaluateWithGradient(parameters, fusedGradient),
+      saf.Evaluate(parameters), 1e-10);
+  BOOST_REQUIRE_EQUAL(fusedGradient.n_rows, gradient.n_rows);
+  BOOST_REQUIRE_EQUAL(fusedGradient.n_cols, gradient.n_cols);
+  for (size_t j = 0; j < gradient.n_elem; j++)
+  {
+    if (std::abs(gradient[j]) < 1e-12)
+      BOOST_REQUIRE_SMALL(fusedGradient[j], 1e-12);
+    else
+      BOOST_REQUIRE_CLOSE(fusedGradient[j], gradient[j], 1e-10);
+  }
+}
+
+/**
+ * Make sure that the batch objectives and gradients add up to the full ones
+ * when there is no sparsity term, and that one batch of all of the points is
+ * the full objective when there is.
+ */
+BOOST_AUTO_TEST_CASE(SparseAutoencoderFunctionBatchEvaluate)
+{
+  const size_t points = 2500;
+  const size_t vSize = 10;
+  const size_t hSize = 5;
+
+  arma::mat data;
+  data.randu(vSize, points);
+
+  BOOST_REQUIRE(optimization::HasBatchGradient<
+      SparseAutoencoderFunction>::value);
+
+  SparseAutoencoderFunction saf(data, vSize, hSize, 2, 0);
+  BOOST_REQUIRE_EQUAL(saf.NumFunctions(), points);
+  const arma::mat parameters = saf.GetInitialPoint();
+
+  arma::mat gradient, batchGradient;
+  saf.Gradient(parameters, gradient);
+  arma::mat gradientSum(arma::zeros<arma::mat>(gradient.n_rows,
+      gradient.n_cols));
+  double objectiveSum = 0.0;
+  for (size_t begin = 0; begin < points; begin += 300)
+  {
+    const size_t batchSize = std::min((size_t) 300, points - begin);
+    objectiveSum += saf.Evaluate(parameters, begin, batchSize);
+    saf.Gradient(parameters, begin, batchSize, batchGradient);
+    gradientSum += batchGradient;
+  }
+
+  BOOST_REQUIRE_CLOSE(objectiveSum, saf.Evaluate(parameters), 1e-8);
+  for (size_t j = 0; j < gradient.n_elem; j++)
+  {
+    if (std::abs(gradient[j]) < 1e-12)
+      BOOST_REQUIRE_SMALL(gradientSum[j], 1e-12);
+    else
+      BOOST_REQUIRE_CLOSE(gradientSum[j], gradient[j], 1e-8);
+  }
+
+  // With the sparsity term, only a batch of every point matches exactly.
+  SparseAutoencoderFunction sparseSaf(data, vSize, hSize, 2, 3);
+  BOOST_REQUIRE_CLOSE(sparseSaf.Evaluate(parameters, 0, points),
+      sparseSaf.Evaluate(parameters), 1e-10);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
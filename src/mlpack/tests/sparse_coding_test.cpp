@@ -129,4 +129,38 @@ BOOST_AUTO_TEST_CASE(SparseCodingTestDictionaryStep)
 }
 
 
+/**
+ * The dictionary step still converges when some atoms are not used by any
+ * code; those atoms are reinitialized, and the others are on the unit sphere.
+ */
+BOOST_AUTO_TEST_CASE(SparseCodingTestDictionaryStepInactiveAtoms)
+{
+  const double tol = 1e-6;
+
+  double lambda1 = 0.1;
+  uword nAtoms = 25;
+
+  mat X;
+  X.load("mnist_first250_training_4s_and_9s.arm");
+  uword nPoints = X.n_cols;
+
+  // Normalize each point since these are images.
+  for (uword i = 0; i < nPoints; ++i)
+    X.col(i) /= norm(X.col(i), 2);
+
+  SparseCoding<> sc(X, nAtoms, lambda1);
+  sc.OptimizeCode();
+
+  // Make two of the atoms inactive.
+  sc.Codes().row(0).zeros();
+  sc.Codes().row(7).zeros();
+
+  uvec adjacencies = find(sc.Codes());
+  double normGradient = sc.OptimizeDictionary(adjacencies, 1e-15);
+
+  BOOST_REQUIRE_SMALL(normGradient, tol);
+  for (uword j = 0; j < nAtoms; ++j)
+    BOOST_REQUIRE_CLOSE(norm(sc.Dictionary().col(j), 2), 1.0, 1e-3);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -181,4 +181,43 @@ BOOST_AUTO_TEST_CASE(SVDBatchNegativeElementTest)
   BOOST_REQUIRE_CLOSE(arma::norm(test, "fro"), arma::norm(result, "fro"), 5.0);
 }
 
+/**
+ * Make sure the residue of SimpleToleranceTermination on a sparse matrix, which
+ * only looks at the nonzero entries, is the same as on the dense matrix.
+ */
+BOOST_AUTO_TEST_CASE(SimpleToleranceSparseResidueTest)
+{
+  sp_mat sparseData;
+  sparseData.sprandu(200, 150, 0.1);
+  const mat denseData(sparseData);
+
+  mat w = randu<mat>(200, 3);
+  mat h = randu<mat>(3, 150);
+
+  // Compute the residue by hand.
+  const mat wh = w * h;
+  double sum = 0.0;
+  size_t count = 0;
+  for (size_t i = 0; i < denseData.n_elem; ++i)
+  {
+    if (denseData[i] != 0)
+    {
+      sum += (denseData[i] - wh[i]) * (denseData[i] - wh[i]);
+      ++count;
+    }
+  }
+  const double residue = sqrt(sum / count);
+
+  SimpleToleranceTermination<sp_mat> sparseTermination;
+  sparseTermination.Initialize(sparseData);
+  sparseTermination.IsConverged(w, h);
+
+  SimpleToleranceTermination<mat> denseTermination;
+  denseTermination.Initialize(denseData);
+  denseTermination.IsConverged(w, h);
+
+  BOOST_REQUIRE_CLOSE(sparseTermination.Index(), residue, 1e-8);
+  BOOST_REQUIRE_CLOSE(denseTermination.Index(), residue, 1e-8);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
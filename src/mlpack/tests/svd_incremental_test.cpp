@@ -2,9 +2,11 @@
 #include <mlpack/methods/amf/amf.hpp>
 #include <mlpack/methods/amf/update_rules/svd_incomplete_incremental_learning.hpp>
 #include <mlpack/methods/amf/update_rules/svd_complete_incremental_learning.hpp>
+#include <mlpack/methods/amf/update_rules/svd_parallel_incremental_learning.hpp>
 #include <mlpack/methods/amf/init_rules/random_init.hpp>
 #include <mlpack/methods/amf/termination_policies/incomplete_incremental_termination.hpp>
 #include <mlpack/methods/amf/termination_policies/complete_incremental_termination.hpp>
+#include <mlpack/methods/amf/termination_policies/max_iteration_termination.hpp>
 #include <mlpack/methods/amf/termination_policies/simple_tolerance_termination.hpp>
 #include <mlpack/methods/amf/termination_policies/validation_RMSE_termination.hpp>
 
@@ -134,4 +136,56 @@ BOOST_AUTO_TEST_CASE(SVDIncompleteIncrementalRegularizationTest)
   BOOST_REQUIRE_LT(regularizedRMSE, regularRMSE + 0.075);
 }
 
+//! Compute the RMSE of the factorization on the nonzero entries of V.
+double ObservedRMSE(const sp_mat& v, const mat& w, const mat& h)
+{
+  double error = 0.0;
+  for (sp_mat::const_iterator it = v.begin(); it != v.end(); ++it)
+    error += std::pow(*it - dot(w.row(it.row()), h.col(it.col())), 2.0);
+
+  return std::sqrt(error / v.n_nonzero);
+}
+
+/**
+ * Make sure that the parallel incremental learning rule, with complete and
+ * incomplete updates, fits a low-rank matrix, and that the result for a given
+ * number of strata is always the same.
+ */
+BOOST_AUTO_TEST_CASE(SVDParallelIncrementalTest)
+{
+  const mat v = (randu<mat>(100, 3) + 0.5) * (randu<mat>(3, 120) + 0.5);
+  const mat observed = randu<mat>(100, 120);
+  sp_mat data(100, 120);
+  for (size_t i = 0; i < v.n_elem; ++i)
+    if (observed[i] < 0.3)
+      data(i % 100, i / 100) = v[i];
+
+  SpecificRandomInitialization sri(100, 3, 120);
+  mat initialW, initialH;
+  sri.Initialize(data, 3, initialW, initialH);
+  const double initialRMSE = ObservedRMSE(data, initialW, initialH);
+
+  for (size_t c = 0; c < 2; ++c)
+  {
+    const bool complete = (c == 0);
+    mat w1, h1, w2, h2;
+
+    SVDParallelIncrementalLearning svd(0.01, 0, 0, complete, 4);
+    AMF<MaxIterationTermination, SpecificRandomInitialization,
+        SVDParallelIncrementalLearning> amf(MaxIterationTermination(300), sri,
+        svd);
+    amf.Apply(data, 3, w1, h1);
+    BOOST_REQUIRE_EQUAL(amf.Update().NumStrata(), 4);
+    amf.Apply(data, 3, w2, h2);
+
+    BOOST_REQUIRE_LT(ObservedRMSE(data, w1, h1), 0.1 * initialRMSE);
+
+    // The sweeps are deterministic.
+    for (size_t i = 0; i < w1.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(w1[i], w2[i]);
+    for (size_t i = 0; i < h1.n_elem; ++i)
+      BOOST_REQUIRE_EQUAL(h1[i], h2[i]);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END();
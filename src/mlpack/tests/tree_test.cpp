@@ -6,9 +6,13 @@
 #include <mlpack/core.hpp>
 #include <mlpack/core/tree/bounds.hpp>
 #include <mlpack/core/tree/binary_space_tree/binary_space_tree.hpp>
+#include <mlpack/core/tree/binary_space_tree/flat_binary_space_tree.hpp>
 #include <mlpack/core/metrics/lmetric.hpp>
 #include <mlpack/core/tree/cover_tree/cover_tree.hpp>
+#include <mlpack/core/tree/query_order.hpp>
 #include <mlpack/core/tree/rectangle_tree.hpp>
+#include <mlpack/core/tree/spill_tree.hpp>
+#include <mlpack/core/tree/tree_memory_usage.hpp>
 
 #include <queue>
 #include <stack>
@@ -16,6 +20,10 @@
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
 
+#ifdef _OPENMP
+  #include <omp.h>
+#endif
+
 using namespace mlpack;
 using namespace mlpack::math;
 using namespace mlpack::tree;
@@ -701,6 +709,60 @@ BOOST_AUTO_TEST_CASE(BallBoundMoveConstructor)
   BOOST_REQUIRE_SMALL(b1.MinWidth(), 1e-5);
 }
 
+/**
+ * Test the distance calculations of a hollow ball bound, with and without a
+ * shell.
+ */
+BOOST_AUTO_TEST_CASE(HollowBallBoundTest)
+{
+  // The center is the first point, (3, 0), so the radius is 1, and the points
+  // are between 3 and 4 away from the origin.
+  HollowBallBound<> b1(2);
+  b1.SetShell(arma::vec("0 0"));
+  b1 |= arma::mat("3 4 3; 0 0 1");
+
+  BOOST_REQUIRE_CLOSE(b1.Center()[0], 3.0, 1e-5);
+  BOOST_REQUIRE_SMALL(b1.Center()[1], 1e-5);
+  BOOST_REQUIRE_CLOSE(b1.Radius(), 1.0, 1e-5);
+  BOOST_REQUIRE(b1.HasShell());
+  BOOST_REQUIRE_CLOSE(b1.Shell().Lo(), 3.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(b1.Shell().Hi(), 4.0, 1e-5);
+  BOOST_REQUIRE_SMALL(b1.MinWidth(), 1e-5);
+
+  // This point is in the ball, but inside the hollow.
+  BOOST_REQUIRE(b1.Contains(arma::vec("3 0")));
+  BOOST_REQUIRE(!b1.Contains(arma::vec("2.5 0")));
+
+  // The shell is further from the origin than the ball.
+  BOOST_REQUIRE_CLOSE(b1.MinDistance(arma::vec("0 0")), 3.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(b1.MaxDistance(arma::vec("0 0")), 4.0, 1e-5);
+  // The ball is further from this point than the shell.
+  BOOST_REQUIRE_CLOSE(b1.MinDistance(arma::vec("3 -3")), 2.0, 1e-5);
+  BOOST_REQUIRE_SMALL(b1.MinDistance(arma::vec("3.5 0")), 1e-5);
+
+  // The center is (1, 0), so the radius is sqrt(2), and both points are 1 away
+  // from the origin.
+  HollowBallBound<> b2(2);
+  b2.SetShell(arma::vec("0 0"));
+  b2 |= arma::mat("1 0; 0 1");
+
+  // The balls overlap, but the shells are 2 apart.
+  BOOST_REQUIRE_CLOSE(b1.MinDistance(b2), 2.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(b2.MinDistance(b1), 2.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(b1.MaxDistance(b2), 3.0 + std::sqrt(2.0), 1e-5);
+  BOOST_REQUIRE_CLOSE(b1.RangeDistance(b2).Lo(), 2.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(b1.RangeDistance(b2).Hi(), 3.0 + std::sqrt(2.0), 1e-5);
+
+  // Without a shell, the bound is an ordinary ball.
+  HollowBallBound<> b3(2);
+  b3 |= arma::mat("3 4 3; 0 0 1");
+  BOOST_REQUIRE(!b3.HasShell());
+  BOOST_REQUIRE_CLOSE(b3.MinWidth(), 2.0, 1e-5);
+  BOOST_REQUIRE(b3.Contains(arma::vec("2.5 0")));
+  BOOST_REQUIRE_CLOSE(b3.MinDistance(arma::vec("0 0")), 2.0, 1e-5);
+  BOOST_REQUIRE_CLOSE(b3.MaxDistance(arma::vec("0 0")), 4.0, 1e-5);
+}
+
 /**
  * Ensure that we calculate the correct minimum distance between a point and a
  * bound.
@@ -1036,6 +1098,73 @@ BOOST_AUTO_TEST_CASE(HRectBoundDiameter)
   BOOST_REQUIRE_SMALL(d.Diameter(), 1e-5);
 }
 
+/**
+ * Low-dimensional bounds (whose ranges are held in the bound itself, and whose
+ * distances have unrolled loops) give the same distances as a direct
+ * calculation, and are copied, assigned, and moved correctly to and from
+ * higher-dimensional bounds.
+ */
+BOOST_AUTO_TEST_CASE(HRectBoundInlineDimensionTest)
+{
+  for (size_t dim = 1; dim <= HRectBound<EuclideanDistance>::MaxInlineDim + 2;
+       ++dim)
+  {
+    HRectBound<EuclideanDistance> a(dim), b(dim);
+    a |= arma::mat(arma::randu<arma::mat>(dim, 5));
+    b |= arma::mat(arma::randu<arma::mat>(dim, 5) + 0.5);
+    const arma::vec point = 2.0 * arma::randu<arma::vec>(dim);
+
+    double minBound = 0, maxBound = 0, minPoint = 0, maxPoint = 0;
+    for (size_t d = 0; d < dim; ++d)
+    {
+      const double gap = std::max(0.0, std::max(b[d].Lo() - a[d].Hi(),
+          a[d].Lo() - b[d].Hi()));
+      minBound += gap * gap;
+      const double far = std::max(b[d].Hi() - a[d].Lo(),
+          a[d].Hi() - b[d].Lo());
+      maxBound += far * far;
+
+      const double pointGap = std::max(0.0, std::max(a[d].Lo() - point[d],
+          point[d] - a[d].Hi()));
+      minPoint += pointGap * pointGap;
+      const double pointFar = std::max(std::abs(point[d] - a[d].Lo()),
+          std::abs(a[d].Hi() - point[d]));
+      maxPoint += pointFar * pointFar;
+    }
+
+    BOOST_REQUIRE_CLOSE(a.MinDistance(b) + 1.0, std::sqrt(minBound) + 1.0,
+        1e-5);
+    BOOST_REQUIRE_CLOSE(a.MaxDistance(b), std::sqrt(maxBound), 1e-5);
+    BOOST_REQUIRE_CLOSE(a.RangeDistance(b).Lo() + 1.0,
+        std::sqrt(minBound) + 1.0, 1e-5);
+    BOOST_REQUIRE_CLOSE(a.RangeDistance(b).Hi(), std::sqrt(maxBound), 1e-5);
+    BOOST_REQUIRE_CLOSE(a.MinDistance(point) + 1.0, std::sqrt(minPoint) + 1.0,
+        1e-5);
+    BOOST_REQUIRE_CLOSE(a.MaxDistance(point), std::sqrt(maxPoint), 1e-5);
+    BOOST_REQUIRE_CLOSE(a.RangeDistance(point).Lo() + 1.0,
+        std::sqrt(minPoint) + 1.0, 1e-5);
+    BOOST_REQUIRE_CLOSE(a.RangeDistance(point).Hi(), std::sqrt(maxPoint),
+        1e-5);
+
+    // Copies, assignments (from a bound of another dimensionality), and moves
+    // hold the same ranges, in their own memory.
+    HRectBound<EuclideanDistance> copy(a);
+    HRectBound<EuclideanDistance> assigned(dim + 3);
+    assigned = a;
+    HRectBound<EuclideanDistance> moved(std::move(copy));
+    BOOST_REQUIRE_EQUAL(copy.Dim(), 0);
+    BOOST_REQUIRE_EQUAL(assigned.Dim(), dim);
+    BOOST_REQUIRE_EQUAL(moved.Dim(), dim);
+    a.Clear();
+    for (size_t d = 0; d < dim; ++d)
+    {
+      BOOST_REQUIRE_EQUAL(assigned[d].Lo(), moved[d].Lo());
+      BOOST_REQUIRE_EQUAL(assigned[d].Hi(), moved[d].Hi());
+      BOOST_REQUIRE_LE(moved[d].Lo(), moved[d].Hi());
+    }
+  }
+}
+
 /**
  * It seems as though Bill has stumbled across a bug where
  * BinarySpaceTree<>::count() returns something different than
@@ -1567,6 +1696,340 @@ BOOST_AUTO_TEST_CASE(BinarySpaceTreeMoveConstructorTest)
   BOOST_REQUIRE_EQUAL(tree2.NumChildren(), 2);
 }
 
+// Make sure two trees have the same structure and bounds.
+template<typename TreeType>
+void CheckTreesEqual(const TreeType& a, const TreeType& b)
+{
+  BOOST_REQUIRE_EQUAL(a.Begin(), b.Begin());
+  BOOST_REQUIRE_EQUAL(a.Count(), b.Count());
+  BOOST_REQUIRE_EQUAL(a.NumChildren(), b.NumChildren());
+  BOOST_REQUIRE_CLOSE(a.FurthestDescendantDistance(),
+      b.FurthestDescendantDistance(), 1e-10);
+
+  for (size_t i = 0; i < a.NumChildren(); ++i)
+    CheckTreesEqual(a.Child(i), b.Child(i));
+}
+
+/**
+ * Ensure that a tree built with many threads is the same as one built with a
+ * single thread.  Without OpenMP, both trees are built serially.
+ */
+template<typename TreeType>
+void CheckParallelConstruction()
+{
+  arma::mat dataset(4, 60000);
+  dataset.randu();
+
+#ifdef _OPENMP
+  const int threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  std::vector<size_t> serialOldFromNew;
+  TreeType serialTree(dataset, serialOldFromNew);
+  TreeType serialTreeNoMapping(dataset);
+
+#ifdef _OPENMP
+  omp_set_num_threads(std::max(threads, 4));
+#endif
+  std::vector<size_t> parallelOldFromNew;
+  TreeType parallelTree(dataset, parallelOldFromNew);
+  TreeType parallelTreeNoMapping(dataset);
+
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif
+
+  BOOST_REQUIRE_EQUAL(serialOldFromNew.size(), parallelOldFromNew.size());
+  for (size_t i = 0; i < serialOldFromNew.size(); ++i)
+    BOOST_REQUIRE_EQUAL(serialOldFromNew[i], parallelOldFromNew[i]);
+
+  // The points must be rearranged in exactly the same way.
+  BOOST_REQUIRE_EQUAL(arma::accu(serialTree.Dataset() !=
+      parallelTree.Dataset()), 0);
+  BOOST_REQUIRE_EQUAL(arma::accu(serialTreeNoMapping.Dataset() !=
+      parallelTreeNoMapping.Dataset()), 0);
+
+  CheckTreesEqual(serialTree, parallelTree);
+  CheckTreesEqual(serialTreeNoMapping, parallelTreeNoMapping);
+}
+
+BOOST_AUTO_TEST_CASE(ParallelKdTreeConstructionTest)
+{
+  CheckParallelConstruction<KDTree<EuclideanDistance, EmptyStatistic,
+      arma::mat> >();
+}
+
+BOOST_AUTO_TEST_CASE(ParallelBallTreeConstructionTest)
+{
+  CheckParallelConstruction<BallTree<EuclideanDistance, EmptyStatistic,
+      arma::mat> >();
+}
+
+// Make sure each node of a vantage-point tree is split around the center of its
+// bound, and that the shells of the children are around that center.
+template<typename TreeType>
+void CheckVPTreeShells(const TreeType& node)
+{
+  // The center of the bound is the first point of the node.
+  BOOST_REQUIRE_EQUAL(arma::accu(node.Bound().Center() !=
+      node.Dataset().col(node.Begin())), 0);
+
+  if (node.NumChildren() == 0)
+    return;
+
+  const TreeType& left = node.Child(0);
+  const TreeType& right = node.Child(1);
+  BOOST_REQUIRE(left.Bound().HasShell());
+  BOOST_REQUIRE(right.Bound().HasShell());
+  BOOST_REQUIRE_EQUAL(arma::accu(left.Bound().HollowCenter() !=
+      node.Bound().Center()), 0);
+  BOOST_REQUIRE_EQUAL(arma::accu(right.Bound().HollowCenter() !=
+      node.Bound().Center()), 0);
+
+  // The left child holds the points closer to the vantage point.
+  BOOST_REQUIRE_LE(left.Bound().Shell().Hi(), right.Bound().Shell().Lo());
+
+  CheckVPTreeShells(left);
+  CheckVPTreeShells(right);
+}
+
+/**
+ * Exhaustive vantage-point tree test.
+ *
+ * - Generate a random dataset of a random size.
+ * - Build a tree on that dataset.
+ * - Ensure all the permutation indices map back to the correct points.
+ * - Verify that each point is contained inside all of the bounds of its parent
+ *     nodes.
+ * - Verify that each node is split around its vantage point.
+ */
+BOOST_AUTO_TEST_CASE(VPTreeTest)
+{
+  typedef VPTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+
+  for (size_t run = 0; run < 5; run++)
+  {
+    const size_t dimensions = 2 * run + 2;
+    const size_t size = (run + 1) * 1000;
+
+    arma::mat dataset = arma::randu<arma::mat>(dimensions, size);
+
+    std::vector<size_t> newToOld;
+    std::vector<size_t> oldToNew;
+    TreeType root(dataset, newToOld, oldToNew);
+    const arma::mat& treeset = root.Dataset();
+
+    BOOST_REQUIRE_EQUAL(root.NumDescendants(), size);
+    BOOST_REQUIRE(!root.Bound().HasShell());
+
+    for (size_t i = 0; i < size; i++)
+    {
+      for (size_t j = 0; j < dimensions; j++)
+      {
+        BOOST_REQUIRE_EQUAL(treeset(j, i), dataset(j, newToOld[i]));
+        BOOST_REQUIRE_EQUAL(treeset(j, oldToNew[i]), dataset(j, i));
+      }
+    }
+
+    BOOST_REQUIRE(CheckPointBounds(root));
+    CheckVPTreeShells(root);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ParallelVPTreeConstructionTest)
+{
+  CheckParallelConstruction<VPTree<EuclideanDistance, EmptyStatistic,
+      arma::mat> >();
+}
+
+// Check the structure of a spill tree: each child only holds points on its side
+// of the splitting hyperplane (or within tau of it, for overlapping nodes), and
+// each leaf holds at least half of the maximum leaf size.
+template<typename TreeType>
+void CheckSpillTree(const TreeType& node,
+                    const size_t maxLeafSize,
+                    const double tau,
+                    const double rho,
+                    arma::Col<size_t>& counts,
+                    size_t& overlappingNodes)
+{
+  for (size_t i = 0; i < node.NumDescendants(); ++i)
+    BOOST_REQUIRE(node.Bound().Contains(
+        node.Dataset().col(node.Descendant(i))));
+
+  if (node.IsLeaf())
+  {
+    BOOST_REQUIRE_GE(node.NumPoints(), (maxLeafSize + 1) / 2);
+    BOOST_REQUIRE_LE(node.NumPoints(), maxLeafSize);
+    for (size_t i = 0; i < node.NumPoints(); ++i)
+      ++counts[node.Point(i)];
+    return;
+  }
+
+  BOOST_REQUIRE_CLOSE(arma::norm(node.ProjectionVector(), 2), 1.0, 1e-5);
+  BOOST_REQUIRE_EQUAL(node.NumDescendants(), node.Child(0).NumDescendants() +
+      node.Child(1).NumDescendants());
+
+  const double buffer = node.Overlap() ? tau : 0.0;
+  for (size_t i = 0; i < node.Child(0).NumDescendants(); ++i)
+    BOOST_REQUIRE_LE(arma::dot(node.ProjectionVector(), node.Dataset().col(
+        node.Child(0).Descendant(i))), node.SplitValue() + buffer + 1e-10);
+  for (size_t i = 0; i < node.Child(1).NumDescendants(); ++i)
+    BOOST_REQUIRE_GE(arma::dot(node.ProjectionVector(), node.Dataset().col(
+        node.Child(1).Descendant(i))), node.SplitValue() - buffer - 1e-10);
+
+  if (node.Overlap())
+  {
+    ++overlappingNodes;
+    BOOST_REQUIRE_LE(node.Child(0).NumDescendants(),
+        rho * node.NumDescendants());
+    BOOST_REQUIRE_LE(node.Child(1).NumDescendants(),
+        rho * node.NumDescendants());
+  }
+
+  CheckSpillTree(node.Child(0), maxLeafSize, tau, rho, counts,
+      overlappingNodes);
+  CheckSpillTree(node.Child(1), maxLeafSize, tau, rho, counts,
+      overlappingNodes);
+}
+
+BOOST_AUTO_TEST_CASE(SpillTreeTest)
+{
+  typedef SpillTree<EuclideanDistance> TreeType;
+
+  arma::mat dataset;
+  dataset.randu(5, 2000);
+
+  // Without a buffer no point is spilled, so every point is in exactly one
+  // leaf.
+  TreeType exactTree(dataset, 20, 0.0, 0.7);
+  arma::Col<size_t> counts(dataset.n_cols, arma::fill::zeros);
+  size_t overlappingNodes = 0;
+  CheckSpillTree(exactTree, 20, 0.0, 0.7, counts, overlappingNodes);
+  BOOST_REQUIRE_EQUAL(exactTree.NumDescendants(), dataset.n_cols);
+  for (size_t i = 0; i < counts.n_elem; ++i)
+    BOOST_REQUIRE_EQUAL(counts[i], 1);
+
+  // With a buffer the points near the hyperplane of the root go to both
+  // children, but every point is still in some leaf.
+  TreeType spillTree(dataset, 20, 0.02, 0.7);
+  counts.zeros();
+  overlappingNodes = 0;
+  CheckSpillTree(spillTree, 20, 0.02, 0.7, counts, overlappingNodes);
+  BOOST_REQUIRE(spillTree.Overlap());
+  BOOST_REQUIRE_GT(overlappingNodes, 0);
+  BOOST_REQUIRE_GT(spillTree.NumDescendants(), dataset.n_cols);
+  for (size_t i = 0; i < counts.n_elem; ++i)
+    BOOST_REQUIRE_GE(counts[i], 1);
+
+  // If rho is less than one half, no node can overlap.
+  TreeType metricTree(dataset, 20, 0.02, 0.4);
+  counts.zeros();
+  overlappingNodes = 0;
+  CheckSpillTree(metricTree, 20, 0.02, 0.4, counts, overlappingNodes);
+  BOOST_REQUIRE_EQUAL(overlappingNodes, 0);
+  BOOST_REQUIRE_EQUAL(metricTree.NumDescendants(), dataset.n_cols);
+}
+
+BOOST_AUTO_TEST_CASE(SpillTreeInvalidParametersTest)
+{
+  typedef SpillTree<EuclideanDistance> TreeType;
+
+  arma::mat dataset;
+  dataset.randu(3, 100);
+
+  BOOST_REQUIRE_THROW(TreeType(dataset, 20, -0.1, 0.7), std::invalid_argument);
+  BOOST_REQUIRE_THROW(TreeType(dataset, 20, 0.1, 0.0), std::invalid_argument);
+  BOOST_REQUIRE_THROW(TreeType(dataset, 20, 0.1, 1.0), std::invalid_argument);
+}
+
+// Make sure a flat tree holds the same nodes as the tree it was built from.
+template<typename TreeType>
+void CheckFlatTree(const TreeType& node,
+                   const FlatBinarySpaceTree& flatTree,
+                   size_t& flatNode)
+{
+  const size_t index = flatNode++;
+
+  BOOST_REQUIRE_EQUAL(flatTree.Begin(index), node.Begin());
+  BOOST_REQUIRE_EQUAL(flatTree.Count(index), node.Count());
+  BOOST_REQUIRE_EQUAL(flatTree.IsLeaf(index), node.NumChildren() == 0);
+  BOOST_REQUIRE_EQUAL(flatTree.ParentDistance(index), node.ParentDistance());
+  BOOST_REQUIRE_EQUAL(flatTree.FurthestDescendantDistance(index),
+      node.FurthestDescendantDistance());
+  for (size_t d = 0; d < node.Bound().Dim(); ++d)
+  {
+    BOOST_REQUIRE_EQUAL(flatTree.LowerBounds()(d, index), node.Bound()[d].Lo());
+    BOOST_REQUIRE_EQUAL(flatTree.UpperBounds()(d, index), node.Bound()[d].Hi());
+  }
+
+  if (node.NumChildren() == 0)
+    return;
+
+  BOOST_REQUIRE_EQUAL(flatTree.Parent(flatTree.Left(index)), index);
+  CheckFlatTree(node.Child(0), flatTree, flatNode);
+  BOOST_REQUIRE_EQUAL(flatTree.Right(index), flatNode);
+  BOOST_REQUIRE_EQUAL(flatTree.Parent(flatTree.Right(index)), index);
+  CheckFlatTree(node.Child(1), flatTree, flatNode);
+}
+
+/**
+ * Ensure that a flat tree has the same structure as the kd-tree it is built
+ * from, and that it is the same after being saved and loaded (or mapped).
+ */
+BOOST_AUTO_TEST_CASE(FlatBinarySpaceTreeTest)
+{
+  typedef KDTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+
+  arma::mat dataset(3, 1000);
+  dataset.randu();
+
+  std::vector<size_t> oldFromNew;
+  TreeType tree(dataset, oldFromNew);
+  FlatBinarySpaceTree flatTree(tree, oldFromNew);
+
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    BOOST_REQUIRE_EQUAL(flatTree.OldFromNew(i), oldFromNew[i]);
+  BOOST_REQUIRE_EQUAL(arma::accu(flatTree.Dataset() != tree.Dataset()), 0);
+
+  size_t flatNode = 0;
+  CheckFlatTree(tree, flatTree, flatNode);
+  BOOST_REQUIRE_EQUAL(flatNode, flatTree.NumNodes());
+
+  flatTree.Save("flat_tree.bin");
+  for (size_t mapFile = 0; mapFile < 2; ++mapFile)
+  {
+    FlatBinarySpaceTree loadedTree("flat_tree.bin", mapFile == 1);
+
+    BOOST_REQUIRE_EQUAL(loadedTree.NumNodes(), flatTree.NumNodes());
+    for (size_t i = 0; i < oldFromNew.size(); ++i)
+      BOOST_REQUIRE_EQUAL(loadedTree.OldFromNew(i), oldFromNew[i]);
+    BOOST_REQUIRE_EQUAL(arma::accu(loadedTree.Dataset() != tree.Dataset()), 0);
+
+    flatNode = 0;
+    CheckFlatTree(tree, loadedTree, flatNode);
+  }
+
+  remove("flat_tree.bin");
+}
+
+/**
+ * Make sure that files that were not written by FlatBinarySpaceTree::Save()
+ * are rejected.
+ */
+BOOST_AUTO_TEST_CASE(FlatBinarySpaceTreeBadFileTest)
+{
+  arma::mat dataset(3, 10);
+  dataset.randu();
+  BOOST_REQUIRE(dataset.quiet_save("flat_tree.bin", arma::arma_binary));
+
+  BOOST_REQUIRE_THROW(FlatBinarySpaceTree("flat_tree.bin"), std::runtime_error);
+  BOOST_REQUIRE_THROW(FlatBinarySpaceTree("flat_tree.bin", true),
+      std::runtime_error);
+
+  remove("flat_tree.bin");
+}
+
 template<typename TreeType>
 void RecurseTreeCountLeaves(const TreeType& node, arma::vec& counts)
 {
@@ -1771,6 +2234,98 @@ BOOST_AUTO_TEST_CASE(CoverTreeConstructionTest)
   CheckSeparation<TreeType, LMetric<2, true> >(tree, tree);
 }
 
+// Make sure that no node of the cover tree is implicit (a node whose only child
+// is its self-child), that each child is at a lower scale than its parent, and
+// count the nodes.
+template<typename TreeType>
+size_t CheckExplicitNodes(const TreeType& node)
+{
+  if (node.NumChildren() == 0)
+  {
+    BOOST_REQUIRE_EQUAL(node.Scale(), INT_MIN);
+    return 1;
+  }
+
+  BOOST_REQUIRE_GT(node.NumChildren(), 1);
+  size_t nodes = 1;
+  for (size_t i = 0; i < node.NumChildren(); ++i)
+  {
+    BOOST_REQUIRE_LT(node.Child(i).Scale(), node.Scale());
+    nodes += CheckExplicitNodes(node.Child(i));
+  }
+
+  return nodes;
+}
+
+/**
+ * On data of low intrinsic dimension, where a point is its own child at many
+ * consecutive scales, the cover tree should hold only the explicit nodes, so
+ * that it has fewer than two nodes per point.
+ */
+BOOST_AUTO_TEST_CASE(CoverTreeImplicitNodeTest)
+{
+  // Points on a line in 10-dimensional space, spread over many scales.
+  arma::mat dataset(10, 1000);
+  const arma::vec direction = arma::normalise(arma::randu<arma::vec>(10));
+  for (size_t i = 0; i < dataset.n_cols; ++i)
+    dataset.col(i) = std::pow(1.05, (double) i) * direction;
+
+  typedef StandardCoverTree<EuclideanDistance, EmptyStatistic, arma::mat>
+      TreeType;
+  TreeType tree(dataset);
+
+  const size_t nodes = CheckExplicitNodes(tree);
+  BOOST_REQUIRE_LT(nodes, 2 * dataset.n_cols);
+  CheckSelfChild<TreeType>(tree);
+}
+
+// Make sure two cover trees have exactly the same structure.
+template<typename TreeType>
+void CheckCoverTreesEqual(const TreeType& a, const TreeType& b)
+{
+  BOOST_REQUIRE_EQUAL(a.Point(), b.Point());
+  BOOST_REQUIRE_EQUAL(a.Scale(), b.Scale());
+  BOOST_REQUIRE_EQUAL(a.NumChildren(), b.NumChildren());
+  BOOST_REQUIRE_EQUAL(a.NumDescendants(), b.NumDescendants());
+  BOOST_REQUIRE_EQUAL(a.ParentDistance(), b.ParentDistance());
+  BOOST_REQUIRE_EQUAL(a.FurthestDescendantDistance(),
+      b.FurthestDescendantDistance());
+
+  for (size_t i = 0; i < a.NumChildren(); ++i)
+    CheckCoverTreesEqual(a.Child(i), b.Child(i));
+}
+
+/**
+ * Ensure that a cover tree built with many threads is the same as one built
+ * with a single thread.  Without OpenMP, both trees are built serially.
+ */
+BOOST_AUTO_TEST_CASE(ParallelCoverTreeConstructionTest)
+{
+  arma::mat dataset;
+  dataset.randu(5, 10000);
+
+  typedef StandardCoverTree<EuclideanDistance, EmptyStatistic, arma::mat>
+      TreeType;
+
+#ifdef _OPENMP
+  const int threads = omp_get_max_threads();
+  omp_set_num_threads(1);
+#endif
+  TreeType serialTree(dataset);
+
+#ifdef _OPENMP
+  omp_set_num_threads(std::max(threads, 4));
+#endif
+  TreeType parallelTree(dataset);
+
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif
+
+  BOOST_REQUIRE_EQUAL(serialTree.DistanceComps(), parallelTree.DistanceComps());
+  CheckCoverTreesEqual(serialTree, parallelTree);
+}
+
 /**
  * Create a cover tree on sparse data and make sure it's accurate.
  */
@@ -2093,4 +2648,278 @@ BOOST_AUTO_TEST_CASE(CoverTreeDescendantTest)
   CheckDescendants(&tree);
 }
 
+/**
+ * A cover tree built with a mapping reorders its dataset into depth-first
+ * order: the mapping is a permutation, the columns are those of the original
+ * dataset, and the descendants of each node are contiguous columns that start
+ * at the point of the node.
+ */
+BOOST_AUTO_TEST_CASE(ReorderedCoverTreeTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 500);
+
+  typedef ReorderedCoverTree<EuclideanDistance, EmptyStatistic, arma::mat>
+      TreeType;
+  std::vector<size_t> oldFromNew;
+  TreeType tree(dataset, oldFromNew);
+
+  BOOST_REQUIRE(TreeTraits<TreeType>::RearrangesDataset);
+  BOOST_REQUIRE_EQUAL(oldFromNew.size(), dataset.n_cols);
+  std::vector<bool> seen(dataset.n_cols, false);
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+  {
+    BOOST_REQUIRE_LT(oldFromNew[i], dataset.n_cols);
+    BOOST_REQUIRE(!seen[oldFromNew[i]]);
+    seen[oldFromNew[i]] = true;
+
+    for (size_t d = 0; d < dataset.n_rows; ++d)
+      BOOST_REQUIRE_EQUAL(tree.Dataset()(d, i), dataset(d, oldFromNew[i]));
+  }
+
+  std::vector<TreeType*> stack(1, &tree);
+  while (!stack.empty())
+  {
+    TreeType* node = stack.back();
+    stack.pop_back();
+
+    BOOST_REQUIRE_EQUAL(&node->Dataset(), &tree.Dataset());
+    for (size_t i = 0; i < node->NumDescendants(); ++i)
+      BOOST_REQUIRE_EQUAL(node->Descendant(i), node->Point() + i);
+
+    for (size_t i = 0; i < node->NumChildren(); ++i)
+      stack.push_back(&node->Child(i));
+  }
+
+  // The tree is the same as the one built on the original dataset.
+  StandardCoverTree<EuclideanDistance, EmptyStatistic, arma::mat>
+      standardTree(dataset);
+  BOOST_REQUIRE_EQUAL(NumNodes(tree), NumNodes(standardTree));
+  BOOST_REQUIRE_EQUAL(oldFromNew[tree.Point()], standardTree.Point());
+  BOOST_REQUIRE_EQUAL(tree.Scale(), standardTree.Scale());
+
+  // A tree that takes ownership of the dataset reorders it the same way.
+  std::vector<size_t> movedOldFromNew;
+  TreeType movedTree(arma::mat(dataset), movedOldFromNew);
+  BOOST_REQUIRE_EQUAL(movedOldFromNew.size(), oldFromNew.size());
+  for (size_t i = 0; i < oldFromNew.size(); ++i)
+    BOOST_REQUIRE_EQUAL(movedOldFromNew[i], oldFromNew[i]);
+}
+
+/**
+ * A kd-tree with a leaf size of 1 has one leaf for each (distinct) point, so it
+ * has 2n - 1 nodes; make sure those are the nodes that are counted.
+ */
+BOOST_AUTO_TEST_CASE(TreeMemoryUsageTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 100);
+  typedef KDTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+  TreeType tree(dataset, 1);
+
+  BOOST_REQUIRE_EQUAL(NumNodes(tree), 199);
+  BOOST_REQUIRE_EQUAL(TreeMemoryUsage(tree), 199 * sizeof(TreeType));
+}
+
+/**
+ * A cover tree built while a NodeArena::Scope is alive takes all its nodes
+ * from the arena, is the same as one built on the heap, and frees the arena
+ * when it is deleted.
+ */
+BOOST_AUTO_TEST_CASE(CoverTreeNodeArenaTest)
+{
+  arma::mat dataset;
+  dataset.randu(5, 1000);
+  typedef StandardCoverTree<EuclideanDistance, EmptyStatistic, arma::mat>
+      TreeType;
+  TreeType heapTree(dataset);
+
+  TreeType* arenaTree;
+  {
+    NodeArena::Scope scope(4096);
+    arenaTree = new TreeType(dataset);
+
+    // The implicit nodes removed during construction are not counted.
+    BOOST_REQUIRE_EQUAL(scope.Arena().Nodes(), NumNodes(*arenaTree));
+    BOOST_REQUIRE_GT(scope.Arena().Blocks(), 1);
+    BOOST_REQUIRE_GE(scope.Arena().BytesUsed(),
+        NumNodes(*arenaTree) * sizeof(TreeType));
+    BOOST_REQUIRE_GE(scope.Arena().BytesReserved(),
+        scope.Arena().BytesUsed());
+  }
+
+  std::stack<TreeType*> heapStack, arenaStack;
+  heapStack.push(&heapTree);
+  arenaStack.push(arenaTree);
+  while (!heapStack.empty())
+  {
+    TreeType* heapNode = heapStack.top();
+    TreeType* arenaNode = arenaStack.top();
+    heapStack.pop();
+    arenaStack.pop();
+
+    BOOST_REQUIRE_EQUAL(heapNode->Point(), arenaNode->Point());
+    BOOST_REQUIRE_EQUAL(heapNode->Scale(), arenaNode->Scale());
+    BOOST_REQUIRE_EQUAL(heapNode->NumDescendants(),
+        arenaNode->NumDescendants());
+    BOOST_REQUIRE_EQUAL(heapNode->NumChildren(), arenaNode->NumChildren());
+    for (size_t i = 0; i < heapNode->NumChildren(); ++i)
+    {
+      BOOST_REQUIRE_EQUAL(&arenaNode->Child(i).Parent(), arenaNode);
+      heapStack.push(&heapNode->Child(i));
+      arenaStack.push(&arenaNode->Child(i));
+    }
+  }
+
+  // A copy made after the scope ends comes from the heap.
+  TreeType copy(*arenaTree);
+  delete arenaTree;
+  CheckDescendants(&copy);
+}
+
+/**
+ * An R tree whose nodes come from an arena is the same as one built on the
+ * heap, even when more points are inserted (onto the heap) after the scope
+ * ends.
+ */
+BOOST_AUTO_TEST_CASE(RectangleTreeNodeArenaTest)
+{
+  arma::mat dataset;
+  dataset.randu(3, 1000);
+  typedef RTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+  TreeType heapTree(dataset, 10, 3, 5, 2);
+
+  TreeType* arenaTree;
+  {
+    NodeArena::Scope scope;
+    arenaTree = new TreeType(dataset, 10, 3, 5, 2);
+
+    // The nodes replaced by splits are not counted.
+    BOOST_REQUIRE_EQUAL(scope.Arena().Nodes(), NumNodes(*arenaTree));
+  }
+
+  // Each tree holds a copy of the dataset, so both copies get the new points.
+  arma::mat points;
+  points.randu(3, 100);
+  heapTree.Dataset().reshape(3, 1100);
+  arenaTree->Dataset().reshape(3, 1100);
+  for (size_t i = 0; i < points.n_cols; ++i)
+  {
+    heapTree.Dataset().col(1000 + i) = points.col(i);
+    arenaTree->Dataset().col(1000 + i) = points.col(i);
+    heapTree.InsertPoint(1000 + i);
+    arenaTree->InsertPoint(1000 + i);
+  }
+
+  std::stack<TreeType*> heapStack, arenaStack;
+  heapStack.push(&heapTree);
+  arenaStack.push(arenaTree);
+  while (!heapStack.empty())
+  {
+    TreeType* heapNode = heapStack.top();
+    TreeType* arenaNode = arenaStack.top();
+    heapStack.pop();
+    arenaStack.pop();
+
+    BOOST_REQUIRE_EQUAL(heapNode->NumDescendants(),
+        arenaNode->NumDescendants());
+    BOOST_REQUIRE_EQUAL(heapNode->NumPoints(), arenaNode->NumPoints());
+    for (size_t i = 0; i < heapNode->NumPoints(); ++i)
+      BOOST_REQUIRE_EQUAL(heapNode->Point(i), arenaNode->Point(i));
+    BOOST_REQUIRE_EQUAL(heapNode->NumChildren(), arenaNode->NumChildren());
+    for (size_t i = 0; i < heapNode->NumChildren(); ++i)
+    {
+      heapStack.push(&heapNode->Child(i));
+      arenaStack.push(&arenaNode->Child(i));
+    }
+  }
+
+  delete arenaTree;
+}
+
+/**
+ * Make sure that an HRectBound built from sparse columns is the same as one
+ * built from the same columns stored densely, and that the distances to sparse
+ * points are the same as to dense points.
+ */
+BOOST_AUTO_TEST_CASE(SparseHRectBoundTest)
+{
+  arma::sp_mat data;
+  data.sprandu(50, 100, 0.1);
+  data.row(3).zeros(); // No column has a nonzero element in this dimension.
+  const arma::mat dense(data);
+
+  HRectBound<EuclideanDistance> sparseBound(50);
+  HRectBound<EuclideanDistance> denseBound(50);
+  sparseBound |= data.cols(0, 79);
+  denseBound |= dense.cols(0, 79);
+
+  for (size_t d = 0; d < 50; ++d)
+  {
+    BOOST_REQUIRE_EQUAL(sparseBound[d].Lo(), denseBound[d].Lo());
+    BOOST_REQUIRE_EQUAL(sparseBound[d].Hi(), denseBound[d].Hi());
+  }
+  BOOST_REQUIRE_EQUAL(sparseBound[3].Width(), 0.0);
+  BOOST_REQUIRE_EQUAL(sparseBound.MinWidth(), denseBound.MinWidth());
+
+  for (size_t i = 80; i < 100; ++i)
+  {
+    BOOST_REQUIRE_CLOSE(denseBound.MinDistance(data.col(i)),
+        denseBound.MinDistance(dense.col(i)), 1e-8);
+    BOOST_REQUIRE_CLOSE(denseBound.MaxDistance(data.col(i)),
+        denseBound.MaxDistance(dense.col(i)), 1e-8);
+
+    const Range sparseRange = denseBound.RangeDistance(data.col(i));
+    const Range denseRange = denseBound.RangeDistance(dense.col(i));
+    BOOST_REQUIRE_CLOSE(sparseRange.Lo(), denseRange.Lo(), 1e-8);
+    BOOST_REQUIRE_CLOSE(sparseRange.Hi(), denseRange.Hi(), 1e-8);
+  }
+}
+
+/**
+ * The order given by QueryOrder() is a permutation of the points, it is the
+ * identity if spatial ordering is off, and consecutive points in it are much
+ * closer to each other than consecutive columns of a random dataset.
+ */
+BOOST_AUTO_TEST_CASE(QueryOrderTest)
+{
+  arma::mat dataset = arma::randu<arma::mat>(2, 2000);
+
+  std::vector<size_t> order;
+  QueryOrder(dataset, order, false);
+  BOOST_REQUIRE_EQUAL(order.size(), 2000);
+  for (size_t i = 0; i < order.size(); ++i)
+    BOOST_REQUIRE_EQUAL(order[i], i);
+
+  QueryOrder(dataset, order);
+  BOOST_REQUIRE_EQUAL(order.size(), 2000);
+  std::vector<bool> seen(dataset.n_cols, false);
+  for (size_t i = 0; i < order.size(); ++i)
+  {
+    BOOST_REQUIRE_LT(order[i], dataset.n_cols);
+    BOOST_REQUIRE(!seen[order[i]]);
+    seen[order[i]] = true;
+  }
+
+  double orderedLength = 0.0;
+  double columnLength = 0.0;
+  for (size_t i = 1; i < order.size(); ++i)
+  {
+    orderedLength += metric::EuclideanDistance::Evaluate(
+        dataset.col(order[i - 1]), dataset.col(order[i]));
+    columnLength += metric::EuclideanDistance::Evaluate(dataset.col(i - 1),
+        dataset.col(i));
+  }
+  BOOST_REQUIRE_LT(orderedLength, 0.5 * columnLength);
+
+  // Identical points and empty datasets are handled.
+  arma::mat same(3, 50);
+  same.fill(1.0);
+  QueryOrder(same, order);
+  BOOST_REQUIRE_EQUAL(order.size(), 50);
+  arma::mat empty(3, 0);
+  QueryOrder(empty, order);
+  BOOST_REQUIRE_EQUAL(order.size(), 0);
+}
+
 BOOST_AUTO_TEST_SUITE_END();
@@ -13,6 +13,7 @@
 #include <mlpack/core/tree/binary_space_tree.hpp>
 #include <mlpack/core/tree/cover_tree.hpp>
 #include <mlpack/core/tree/rectangle_tree.hpp>
+#include <mlpack/core/tree/spill_tree.hpp>
 
 #include <boost/test/unit_test.hpp>
 #include "old_boost_test_definitions.hpp"
@@ -70,6 +71,58 @@ BOOST_AUTO_TEST_CASE(BinarySpaceTreeTraitsTest)
   BOOST_REQUIRE_EQUAL(b, true);
 }
 
+// Test the traits of the vantage-point tree.
+BOOST_AUTO_TEST_CASE(VPTreeTraitsTest)
+{
+  typedef VPTree<EuclideanDistance, EmptyStatistic, arma::mat> TreeType;
+
+  // The bounds of children may overlap.
+  bool b = TreeTraits<TreeType>::HasOverlappingChildren;
+  BOOST_REQUIRE_EQUAL(b, true);
+
+  // Points are not contained at multiple levels.
+  b = TreeTraits<TreeType>::HasSelfChildren;
+  BOOST_REQUIRE_EQUAL(b, false);
+
+  // The first point is not the centroid.
+  b = TreeTraits<TreeType>::FirstPointIsCentroid;
+  BOOST_REQUIRE_EQUAL(b, false);
+
+  // The dataset gets rearranged at build time.
+  b = TreeTraits<TreeType>::RearrangesDataset;
+  BOOST_REQUIRE_EQUAL(b, true);
+
+  // It is a binary tree.
+  b = TreeTraits<TreeType>::BinaryTree;
+  BOOST_REQUIRE_EQUAL(b, true);
+}
+
+// Test the traits of the spill tree.
+BOOST_AUTO_TEST_CASE(SpillTreeTraitsTest)
+{
+  typedef SpillTree<EuclideanDistance> TreeType;
+
+  // The children of overlapping nodes share points.
+  bool b = TreeTraits<TreeType>::HasOverlappingChildren;
+  BOOST_REQUIRE_EQUAL(b, true);
+
+  // Points are not contained at multiple levels.
+  b = TreeTraits<TreeType>::HasSelfChildren;
+  BOOST_REQUIRE_EQUAL(b, false);
+
+  // The first point is not the centroid.
+  b = TreeTraits<TreeType>::FirstPointIsCentroid;
+  BOOST_REQUIRE_EQUAL(b, false);
+
+  // The dataset is not rearranged at build time.
+  b = TreeTraits<TreeType>::RearrangesDataset;
+  BOOST_REQUIRE_EQUAL(b, false);
+
+  // It is a binary tree.
+  b = TreeTraits<TreeType>::BinaryTree;
+  BOOST_REQUIRE_EQUAL(b, true);
+}
+
 // Test the cover tree traits.
 BOOST_AUTO_TEST_CASE(CoverTreeTraitsTest)
 {
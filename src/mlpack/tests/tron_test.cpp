@@ -0,0 +1,102 @@
+/**
+ * @file tron_test.cpp
+ * @author Ryan Curtin
+ *
+ * Tests the TRON optimizer on a couple test functions, which do not provide
+ * Hessian-vector products.
+ */
+#include <mlpack/core.hpp>
+#include <mlpack/core/optimizers/tron/tron.hpp>
+#include <mlpack/core/optimizers/lbfgs/test_functions.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include "old_boost_test_definitions.hpp"
+
+using namespace mlpack::optimization;
+using namespace mlpack::optimization::test;
+
+BOOST_AUTO_TEST_SUITE(TRONTest);
+
+/**
+ * Make sure that the finite difference Hessian-vector product of a function
+ * without one is close to the exact product.
+ */
+BOOST_AUTO_TEST_CASE(FiniteDifferenceHessianVectorProductTest)
+{
+  BOOST_REQUIRE(!HasHessianVectorProduct<RosenbrockFunction>::value);
+
+  RosenbrockFunction f;
+  arma::mat coordinates("0.5; -0.3");
+  arma::mat v("0.7; 1.1");
+
+  arma::mat gradient, hv;
+  f.Gradient(coordinates, gradient);
+  HessianVectorProduct(f, coordinates, gradient, v, hv);
+
+  // The Hessian of the Rosenbrock function.
+  const double x = coordinates[0], y = coordinates[1];
+  arma::mat hessian(2, 2);
+  hessian(0, 0) = 1200 * x * x - 400 * y + 2;
+  hessian(0, 1) = -400 * x;
+  hessian(1, 0) = -400 * x;
+  hessian(1, 1) = 200;
+  const arma::mat exact = hessian * v;
+
+  BOOST_REQUIRE_EQUAL(hv.n_elem, 2);
+  BOOST_REQUIRE_CLOSE(hv[0], exact[0], 1e-3);
+  BOOST_REQUIRE_CLOSE(hv[1], exact[1], 1e-3);
+}
+
+/**
+ * Tests the TRON optimizer using the Rosenbrock Function.
+ */
+BOOST_AUTO_TEST_CASE(TRONRosenbrockFunctionTest)
+{
+  RosenbrockFunction f;
+  TRON<RosenbrockFunction> tron(f, 1000, 1e-10);
+
+  arma::mat coords = f.GetInitialPoint();
+  const double finalValue = tron.Optimize(coords);
+
+  BOOST_REQUIRE_SMALL(finalValue, 1e-5);
+  BOOST_REQUIRE_CLOSE(coords[0], 1.0, 1e-3);
+  BOOST_REQUIRE_CLOSE(coords[1], 1.0, 1e-3);
+}
+
+/**
+ * Tests the TRON optimizer using the Wood Function.
+ */
+BOOST_AUTO_TEST_CASE(TRONWoodFunctionTest)
+{
+  WoodFunction f;
+  TRON<WoodFunction> tron(f, 1000, 1e-10);
+
+  arma::mat coords = f.GetInitialPoint();
+  const double finalValue = tron.Optimize(coords);
+
+  BOOST_REQUIRE_SMALL(finalValue, 1e-5);
+  for (size_t i = 0; i < 4; ++i)
+    BOOST_REQUIRE_CLOSE(coords[i], 1.0, 1e-3);
+}
+
+/**
+ * Tests the TRON optimizer using the generalized Rosenbrock function, in
+ * several dimensions.
+ */
+BOOST_AUTO_TEST_CASE(TRONGeneralizedRosenbrockFunctionTest)
+{
+  for (size_t dim = 10; dim <= 100; dim += 30)
+  {
+    GeneralizedRosenbrockFunction f(dim);
+    TRON<GeneralizedRosenbrockFunction> tron(f, 1000, 1e-10);
+
+    arma::mat coords = f.GetInitialPoint();
+    const double finalValue = tron.Optimize(coords);
+
+    BOOST_REQUIRE_SMALL(finalValue, 1e-5);
+    for (size_t j = 0; j < dim; ++j)
+      BOOST_REQUIRE_CLOSE(coords[j], 1.0, 1e-3);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END();
@@ -46,4 +46,25 @@ BOOST_AUTO_TEST_CASE(TestUnion)
   BOOST_REQUIRE(testUnionFind_.Find(6) == testUnionFind_.Find(3));
 }
 
+/**
+ * Union pairs of elements from several threads at once, and make sure the
+ * components are right afterwards.
+ */
+BOOST_AUTO_TEST_CASE(TestConcurrentUnion)
+{
+  static const size_t testSize_ = 10000;
+  UnionFind testUnionFind_(testSize_);
+
+  // Join every element to the element ten places ahead of it, so that the
+  // components are the residues modulo 10.
+  #pragma omp parallel for
+  for (size_t i = 0; i < testSize_ - 10; ++i)
+    testUnionFind_.Union(i, i + 10);
+
+  for (size_t i = 0; i < testSize_; ++i)
+    BOOST_REQUIRE(testUnionFind_.Find(i) == testUnionFind_.Find(i % 10));
+  for (size_t i = 1; i < 10; ++i)
+    BOOST_REQUIRE(testUnionFind_.Find(i) != testUnionFind_.Find(0));
+}
+
 BOOST_AUTO_TEST_SUITE_END();